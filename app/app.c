@@ -7,11 +7,168 @@
 
 #include "app.h"
 #include "sensor_sampling.h"
+#include "sensor_array.h"
+#include "sensor_vote.h"
+#include "host_fifo.h"
+#include "host_command.h"
+#include "config.h"
+#include "sample_stats.h"
+#include "derived.h"
+#include "tracker.h"
+#include "event_detect.h"
+#include "output_sched.h"
+#include "job_sched.h"
+#include "event_flags.h"
+#include "sample_bus.h"
+#include "latency.h"
+#include "time_sync.h"
+#include "perf_bank.h"
+#include "board_config.h"
+#include "board_init.h"   /* For board_stack_poll() */
 #include "hal_config.h"
+#include "hal_atomic.h"
 #include "i2c_slave.h"
 #include "dac.h"
+#include "prof.h"
+#include "trace.h"
+#include "probe.h"
+#include "fault.h"
+#include "warm_restart.h"
+#include "bus_tune.h"
+#include "self_test.h"
+#include "clock_trim.h"
+#include "energy.h"
+#include "conv_tune.h"
+#include "wave.h"
+#include "timebase.h"
+#if BOARD_USB_STREAM_ENABLE
+#include "usb_stream.h"
+#endif
+#if BOARD_UART_STREAM_ENABLE
+#include "uart_stream.h"
+#endif
+#if BOARD_SD_LOG_ENABLE
+#include "sd_log.h"
+#endif
+#if BOARD_EEPROM_LOG_ENABLE
+#include "eeprom_log.h"
+#endif
+#if BOARD_FLASH_LOG_ENABLE
+#include "flash_log.h"
+#endif
+#if BOARD_FW_UPDATE_ENABLE
+#include "fw_update.h"
+#endif
+#if BOARD_BURST_ENABLE
+#include "burst.h"
+#endif
+#if BOARD_BENCH_ENABLE
+#include "bench.h"
+#endif
+#if BOARD_PWM_OUT_ENABLE
+#include "pwm_out.h"
+#endif
+#if BOARD_POLL_ALIGN_ENABLE
+#include "poll_align.h"
+#endif
 /* #include <stdio.h>  For printf - commented out as printf statements are disabled */
 
+/* Main loop events (event_flags.h, raised from interrupt context):
+ * dispatched lowest bit first */
+#define APP_EVENT_SENSOR     (1UL << 0)  /* New sample, sampler status change or poll work */
+#define APP_EVENT_I2C_RX     (1UL << 1)  /* Command queued by the I2C master (or the UART stream) */
+#define APP_EVENT_ALARM      (1UL << 2)  /* Analog watchdog tripped (COMP2) */
+#define APP_EVENT_LOG        (1UL << 3)  /* RTC wakeup: take the next logged sample */
+#define APP_EVENT_JOB        (1UL << 4)  /* Periodic job release due */
+
+/* Main loop jobs (job_sched.h), one per event plus the periodic work */
+enum {
+    APP_JOB_SAMPLES = 0,  /* Sample out to the slave, DAC and logs */
+    APP_JOB_COMMANDS,     /* Master commands */
+    APP_JOB_ALARM,        /* Analog watchdog report */
+    APP_JOB_LOG,          /* RTC wakeup sample */
+    APP_JOB_BACKGROUND,   /* ADC scan, EEPROM log, calibration cache, update */
+    APP_JOB_PERF,         /* Performance bank refresh */
+    APP_JOB_STALE,        /* Stale sample check */
+    APP_JOBS
+};
+
+#if APP_JOBS > JOB_SCHED_SLOTS
+#error "More main loop jobs than JOB_SCHED_SLOTS"
+#endif
+
+#if BOARD_INTR_MCU_WATERMARK > HOST_FIFO_DEPTH
+#error "BOARD_INTR_MCU_WATERMARK exceeds HOST_FIFO_DEPTH"
+#endif
+
+#if BOARD_DAC_FOLLOW_RATE_HZ != 0 && !BOARD_DAC_STREAM_ENABLE
+#error "BOARD_DAC_FOLLOW_RATE_HZ requires BOARD_DAC_STREAM_ENABLE"
+#endif
+
+#if BOARD_LOG_PERIOD_S != 0 && (!BOARD_I2C1_WAKEUP_STOP || BOARD_SENSOR_MUX_CHANNELS != 0)
+#error "BOARD_LOG_PERIOD_S requires BOARD_I2C1_WAKEUP_STOP and a single sensor"
+#endif
+
+#if (BOARD_VDDA_TRACK_ENABLE || BOARD_DAC_VERIFY_ENABLE) && BOARD_ADC_SCAN_PERIOD_MS == 0
+#error "BOARD_VDDA_TRACK_ENABLE and BOARD_DAC_VERIFY_ENABLE require BOARD_ADC_SCAN_PERIOD_MS"
+#endif
+
+/* Pressure at the top of a pressure output (HOST_CMD_SET_DAC_MAP), mbar */
+#define APP_DAC_PRESSURE_SPAN_MAX      30000UL
+
+#define APP_DAC_OUTPUTS                2U
+
+#if APP_DAC_OUTPUTS != CONFIG_DAC_MAPS
+#error "The configuration block holds one DAC mapping per output"
+#endif
+
+#if BOARD_COMP_ALARM_ENABLE && BOARD_COMP_ALARM_DAC_OUT >= APP_DAC_OUTPUTS
+#error "BOARD_COMP_ALARM_DAC_OUT is not a DAC output"
+#endif
+
+#if APP_OUTPUTS > OUTPUT_SCHED_SLOTS
+#error "Every app_output_t needs a scheduler slot"
+#endif
+
+/* Statistics window on the 32-bit us sample timestamps */
+#if BOARD_EEPROM_LOG_ENABLE && (BOARD_EEPROM_LOG_STATS_PERIOD_S == 0 || BOARD_EEPROM_LOG_STATS_PERIOD_S > 4000U)
+#error "BOARD_EEPROM_LOG_STATS_PERIOD_S must be 1..4000"
+#endif
+
+/**
+ * @brief Mapping as applied per sample
+ * 
+ * code = clip((clamp(x - in_min) * slope + offset) >> 32), Q32, channel
+ * calibration folded into slope and offset.
+ */
+typedef struct {
+    app_dac_source_t source;
+    int32_t in_min;
+    int64_t dx_min;  /* Input clamp, relative to in_min */
+    int64_t dx_max;
+    int64_t slope;   /* Raw codes per sensor unit, Q32 */
+    int64_t offset;  /* Raw code at in_min, Q32, rounding included */
+} app_dac_map_fast_t;
+
+/* Follower targets (BOARD_DAC_DITHER_BITS): code to fine code, half a code
+ * in fine steps, and the whole-code rounding of a folded offset less that
+ * of a fine step */
+#define APP_DAC_FINE(code)             ((uint16_t)((uint32_t)(code) << BOARD_DAC_DITHER_BITS))
+#define APP_DAC_FINE_HALF              ((1U << BOARD_DAC_DITHER_BITS) >> 1)
+#define APP_DAC_FINE_ROUND             ((1LL << 31) - (1LL << (31U - BOARD_DAC_DITHER_BITS)))
+
+/* Test stimulus (HOST_CMD_DAC_STREAM): triangle, codes per sample */
+#define APP_DAC_STIMULUS_STEP          32U
+
+/* DAC readback: the output buffer does not swing closer than ~0.2 V to
+ * either rail, so expected codes are limited to what the pin can show */
+#define APP_DAC_VERIFY_RAIL_CODES      248U
+
+/* Calibration points (HOST_CMD_DAC_CAL): 10% and 90% of full scale, clear
+ * of the output buffer's rail limits */
+#define APP_DAC_CAL_CODE_LOW           410U
+#define APP_DAC_CAL_CODE_HIGH          3686U
+
 /* ============================================================================
  * PRIVATE VARIABLES
  * ============================================================================ */
@@ -19,6 +176,110 @@
 static bool app_initialized = false;
 static sensor_data_t latest_sensor_data = {0};
 static uint32_t reading_count = 0;
+#if BOARD_IWDG_ENABLE
+/* Sequence of the sample that last refreshed the watchdog */
+static uint32_t iwdg_sequence = 0;
+#endif
+static app_boot_times_t boot_times = {0};
+static timebase_deadline_t job_wake;  /* Next periodic job release */
+/* Performance bank: the last refresh, for the rates over the period */
+static uint32_t perf_last_us = 0;
+static uint32_t perf_last_sequence = 0;
+static uint32_t perf_last_idle_us = 0;
+static uint32_t perf_uptime_s = 0;
+static uint32_t perf_uptime_rem_us = 0;
+/* Indexed by dac_channel_t; the fast copies are rebuilt by app_dac_map_update() */
+static const app_dac_map_t dac_map_defaults[APP_DAC_OUTPUTS] = {
+    BOARD_DAC_OUT1_MAP,
+    BOARD_DAC_OUT2_MAP,
+};
+static app_dac_map_t dac_maps[APP_DAC_OUTPUTS] = {
+    BOARD_DAC_OUT1_MAP,
+    BOARD_DAC_OUT2_MAP,
+};
+static app_dac_map_fast_t dac_maps_fast[APP_DAC_OUTPUTS];
+#if BOARD_PWM_OUT_ENABLE
+#define APP_PWM_OUT_ROW_MAP(timer, channel, port, pin, af, map)  map,
+/* Fixed at build time; folded with the DAC maps by app_dac_map_update() */
+static const app_dac_map_t pwm_maps[PWM_OUT_COUNT] = {
+    BOARD_PWM_OUTPUTS(APP_PWM_OUT_ROW_MAP)
+};
+static app_dac_map_fast_t pwm_maps_fast[PWM_OUT_COUNT];
+#endif
+static uint16_t dac_codes[APP_DAC_OUTPUTS];  /* Last codes sent by app_dac_output() */
+static uint32_t dac_timestamp_us = 0;        /* Timestamp of the sample they are for (playout) */
+static uint16_t dac_stale_code = BOARD_DAC_STALE_CODE;  /* BOARD_DAC_STALE_HOLD: keep the codes */
+static bool sample_stale = false;            /* Stale reported (APP_JOB_STALE) */
+static volatile bool dac_setpoint_active = false;  /* HOST_CMD_DAC_SETPOINT: the master owns the codes */
+#if BOARD_COMP_ALARM_ENABLE
+static uint32_t alarm_threshold_mv = BOARD_COMP_ALARM_MV;  /* 0 = disarmed */
+static uint16_t alarm_threshold_code = (uint16_t)BOARD_DAC_MAX_CODE;  /* Read by the stimulus refill */
+static volatile bool alarm_tripped = false;  /* Latched until re-armed */
+static volatile uint32_t alarm_count = 0;
+static volatile uint32_t alarm_time_us = 0;  /* Timestamp of the last trip */
+#endif
+#if BOARD_LOG_PERIOD_S != 0
+static uint32_t log_burst_us = 0;  /* Wall-clock timestamp of the last RTC wakeup */
+#endif
+#if BOARD_PROF_ENABLE
+static prof_site_t prof_site = PROF_SITE_SAMPLING_TICK;  /* Shown in the APP_REG_PROF_* window */
+#endif
+#if BOARD_LATENCY_ENABLE
+static latency_stage_t latency_stage = LATENCY_STAGE_COMPENSATED;  /* APP_REG_LAT_* window */
+static uint8_t latency_bucket = 0;
+#endif
+#if BOARD_ADC_SCAN_PERIOD_MS != 0
+#if !BOARD_ADC_SCAN_TIM22
+static uint32_t adc_scan_last_us = 0;   /* Start of the last ADC scan */
+#endif
+static hal_adc_scan_t adc_scan_last;    /* Newest scan, for the perf bank (vdda_mv 0: none yet) */
+#endif
+#if BOARD_VDDA_TRACK_ENABLE
+static uint32_t vdda_filtered_x8 = 0;   /* VDDA average (1/8 weight), mV * 8; 0 = none yet */
+#endif
+#if BOARD_DAC_VERIFY_ENABLE
+static uint8_t dac_verify_run[APP_DAC_OUTPUTS];  /* Scans in a row against the fault state */
+static uint8_t dac_faults = 0;          /* bit = dac_channel_t */
+static uint16_t dac_readback[APP_DAC_OUTPUTS];
+#endif
+static uint8_t dac_cal_step = APP_DAC_CAL_END;  /* HOST_CMD_DAC_CAL sequence */
+static uint32_t dac_cal_mv[2][2];  /* [channel][low, high] */
+static uint8_t dac_cal_measured;   /* bit 2 * channel + point */
+static uint16_t stimulus_code = 0;  /* DMA interrupt only while streaming */
+static bool stimulus_rising = true;
+static uint8_t app_regs[APP_REG_BLOCK_SIZE];  /* Application block of the slave registers */
+#if BOARD_SENSOR_MUX_CHANNELS != 0 && !BOARD_SENSOR_VOTE_ENABLE
+static uint32_t probe_sequence = 0;  /* Sequence of the last probe sample used */
+static bool probe_seen = false;
+#endif
+#if BOARD_EEPROM_LOG_ENABLE
+static int32_t elog_min = 0;        /* Pressure over the statistics window */
+static int32_t elog_max = 0;
+static int64_t elog_sum = 0;
+static uint32_t elog_count = 0;     /* Samples in the window, 0 = not started */
+static uint32_t elog_window_us = 0; /* Timestamp of its first sample */
+static uint32_t elog_errors[EEPROM_LOG_DATA_WORDS];  /* Counters in the last APP_ELOG_ERRORS */
+static eeprom_log_record_t elog_shown = {0};  /* APP_REG_ELOG_* window, seq 0 = none */
+#endif
+
+static sample_stats_t stats_shown = {0};  /* APP_REG_STATS_*, windows 0 = none yet */
+static tracker_output_t track_shown = {0};  /* APP_REG_TRACK_* */
+static bool event_raised = false;  /* Event queued: INTR_MCU with the next update */
+#if BOARD_SLAVE_DIRECT_ENABLE
+/* Published by the bottom half over the sample registers */
+#define APP_SLAVE_LIVE_SIZE  (APP_REG_SEQUENCE + 4U - APP_REG_PRESSURE)
+static bool slave_live_on = false;  /* Shown while the sensor runs */
+#endif
+static app_pressure_unit_t pressure_unit = APP_UNIT_OFF;  /* APP_REG_PRESSURE_UNIT */
+
+/* Pa to each app_pressure_unit_t, Q16 */
+static const uint32_t pressure_unit_q16[APP_UNITS] = {
+    [APP_UNIT_OFF]     = 0,
+    [APP_UNIT_PA]      = 65536UL,
+    [APP_UNIT_PSI_E4]  = 95052UL,    /* 10^4 / 6894.757 */
+    [APP_UNIT_INHG_E3] = 19353UL,    /* 10^3 / 3386.389 */
+    [APP_UNIT_MMHG_E3] = 491560UL,   /* 10^3 / 133.3224 */
+};
 
 /* ============================================================================
  * CONSTANTS - Sensor Value Ranges (from MS5837-30BA datasheet)
@@ -33,195 +294,2503 @@ static uint32_t reading_count = 0;
 #define TEMPERATURE_MAX_RAW  (100000L)    /* 1000°C (safety margin) */
 #define READING_COUNT_MAX   (UINT32_MAX - 1)  /* Prevent overflow */
 
+/* I2C slave TX value until the first valid sample (INT32_MIN: outside the
+ * clamped pressure range, so the master can tell it apart) */
+#define APP_SLAVE_TX_WARMING_UP  0x80000000UL
+
 /* ============================================================================
  * PRIVATE FUNCTIONS
  * ============================================================================ */
 
 /**
- * @brief I2C slave receive callback
+ * @brief Sampler event callback (interrupt context)
+ */
+static void app_on_sensor_event(void)
+{
+    event_flags_set(APP_EVENT_SENSOR);
+}
+
+#if BOARD_EEPROM_LOG_ENABLE
+/**
+ * @brief Add a sample to the statistics window
+ */
+static void app_elog_add(const sensor_data_t *sample)
+{
+    if (elog_count == 0U) {
+        elog_min = sample->pressure;
+        elog_max = sample->pressure;
+        elog_sum = 0;
+        elog_window_us = sample->timestamp_us;
+    } else if (sample->pressure < elog_min) {
+        elog_min = sample->pressure;
+    } else if (sample->pressure > elog_max) {
+        elog_max = sample->pressure;
+    }
+    elog_sum += sample->pressure;
+    elog_count++;
+}
+
+/**
+ * @brief Close the statistics window once it spans the period
  * 
- * Called automatically when a 32-bit value is received from I2C master.
- * This runs in interrupt context, so keep it short!
+ * Queues the pressure statistics, and the error counters if any moved
+ * since they were last recorded.
  * 
- * @param received_value The 32-bit value received from master
- */
-static void app_i2c_slave_rx_callback(uint32_t received_value)
-{
-    /* Print received value - commented out but retained for debugging */
-    /* Uncomment to enable printf output (requires UART/USB setup) */
-    /*
-    printf("[I2C Slave] Received 32-bit value: 0x%08lX (%lu)\r\n", 
-           (unsigned long)received_value, 
-           (unsigned long)received_value);
-    printf("  Hex: 0x%08lX\r\n", (unsigned long)received_value);
-    printf("  Decimal: %lu\r\n", (unsigned long)received_value);
-    printf("  Bytes: 0x%02X 0x%02X 0x%02X 0x%02X\r\n",
-           (uint8_t)(received_value & 0xFF),
-           (uint8_t)((received_value >> 8) & 0xFF),
-           (uint8_t)((received_value >> 16) & 0xFF),
-           (uint8_t)((received_value >> 24) & 0xFF));
-    printf("\r\n");
-    */
+ * @param timestamp_us Timestamp of the newest sample
+ */
+static void app_elog_window_poll(uint32_t timestamp_us)
+{
+    uint32_t errors[EEPROM_LOG_DATA_WORDS] = {0};
+    i2c_slave_stats_t slave;
+    bool changed = false;
+#if BOARD_SENSOR_MUX_CHANNELS == 0
+    sensor_error_stats_t sampler;
+#endif
     
-    /* NOTE: This callback runs in interrupt context!
-     * Keep processing minimal here. For heavy processing,
-     * store the value and process it in app_main_loop() */
+    if (elog_count == 0U ||
+        timestamp_us - elog_window_us < BOARD_EEPROM_LOG_STATS_PERIOD_S * 1000000UL) {
+        return;
+    }
+    
+    (void)eeprom_log_append(APP_ELOG_STATS, (uint32_t)elog_min, (uint32_t)elog_max,
+                            (uint32_t)(int32_t)(elog_sum / (int64_t)elog_count));
+    elog_count = 0;
+    
+#if BOARD_SENSOR_MUX_CHANNELS == 0
+    sensor_sampling_get_error_stats(&sampler);
+    errors[0] = sampler.errors;
+    errors[1] = sampler.timeouts;
+#endif
+    if (i2c_slave_get_stats(&slave)) {
+        errors[2] = slave.errors;
+    }
+    for (uint32_t i = 0; i < EEPROM_LOG_DATA_WORDS; i++) {
+        changed = changed || errors[i] != elog_errors[i];
+        elog_errors[i] = errors[i];
+    }
+    if (changed) {
+        (void)eeprom_log_append(APP_ELOG_ERRORS, errors[0], errors[1], errors[2]);
+    }
+}
+#endif
+
+#if BOARD_FAULT_CAPTURE_ENABLE
+/**
+ * @brief Report a fault that ended the previous boot
+ * 
+ * The whole record stays readable at APP_REG_FAULT; the EEPROM log keeps
+ * where it happened across power cycles.
+ */
+static void app_fault_report(void)
+{
+    const fault_record_t *fault = fault_get_last();
+    uint32_t where;
+    
+    if (fault->kind == FAULT_KIND_NONE) {
+        return;
+    }
+    where = (fault->kind == FAULT_KIND_ERROR) ? fault->code : fault->regs[FAULT_REG_PC];
+    TRACE(TRACE_FAULT, fault->kind, where);
+#if BOARD_EEPROM_LOG_ENABLE
+    (void)eeprom_log_append(APP_ELOG_FAULT,
+                            where,
+                            (fault->kind == FAULT_KIND_ERROR) ? fault->where : fault->regs[FAULT_REG_LR],
+                            ((uint32_t)fault->kind << 24) | ((uint32_t)fault->sensor_state << 16) |
+                            (fault->regs[FAULT_REG_XPSR] & 0x3FU));
+#endif
+}
+#endif
+
+/**
+ * @brief Run the event detectors on one sample
+ * 
+ * The rate is the tracker's newest (it runs ahead in the bottom half).
+ */
+static void app_event_check(const sensor_data_t *sample)
+{
+    tracker_output_t track;
+    int32_t values[EVENT_SOURCES];
+    
+    (void)tracker_get(&track);
+    values[EVENT_SOURCE_PRESSURE] = sample->pressure;
+    values[EVENT_SOURCE_TEMPERATURE] = sample->temperature;
+    values[EVENT_SOURCE_RATE] = track.rate;
+    values[EVENT_SOURCE_DERIVED] = derived_from_pressure(sample->pressure);
+    if (event_detect_run(values, sample->sequence)) {
+        event_raised = true;
+    }
 }
 
 /* ============================================================================
- * PUBLIC FUNCTIONS
+ * SAMPLE BUS SUBSCRIBERS (every sample, in subscription order)
  * ============================================================================ */
 
-bool app_init(void)
+#if BOARD_BURST_ENABLE
+/**
+ * @brief RAM burst capture (subscribed first: it owns the FIFO until drained)
+ */
+static void app_sub_burst(const sample_bus_block_t *block)
 {
-    /* Initialize sensor sampling */
-    if (!sensor_sampling_init()) {
-        return false;
+    for (uint32_t i = 0; i < block->count; i++) {
+        burst_push(&block->samples[i]);
+    }
+}
+#endif
+
+/**
+ * @brief Master's burst FIFO
+ */
+static void app_sub_fifo(const sample_bus_block_t *block)
+{
+#if BOARD_BURST_ENABLE
+    /* Live samples wait until the captured ones are queued */
+    if (burst_owns_fifo()) {
+        return;
+    }
+#endif
+    for (uint32_t i = 0; i < block->count; i++) {
+        host_fifo_push(&block->samples[i]);
+    }
+}
+
+#if BOARD_USB_STREAM_ENABLE
+static void app_sub_usb(const sample_bus_block_t *block)
+{
+    for (uint32_t i = 0; i < block->count; i++) {
+        usb_stream_push(&block->samples[i]);
+    }
+}
+#endif
+
+#if BOARD_UART_STREAM_ENABLE
+static void app_sub_uart(const sample_bus_block_t *block)
+{
+    for (uint32_t i = 0; i < block->count; i++) {
+        uart_stream_push(&block->samples[i]);
+    }
+}
+#endif
+
+#if BOARD_SD_LOG_ENABLE
+static void app_sub_sd_log(const sample_bus_block_t *block)
+{
+    for (uint32_t i = 0; i < block->count; i++) {
+        sd_log_push(&block->samples[i]);
+    }
+}
+#endif
+
+#if BOARD_FLASH_LOG_ENABLE
+static void app_sub_flash_log(const sample_bus_block_t *block)
+{
+    for (uint32_t i = 0; i < block->count; i++) {
+        flash_log_push(&block->samples[i]);
+    }
+}
+#endif
+
+#if BOARD_EEPROM_LOG_ENABLE
+static void app_sub_elog(const sample_bus_block_t *block)
+{
+    for (uint32_t i = 0; i < block->count; i++) {
+        app_elog_add(&block->samples[i]);
+    }
+}
+#endif
+
+/**
+ * @brief Event detectors (subscribed last: an edge is raised with every
+ *        other consumer already fed)
+ */
+static void app_sub_events(const sample_bus_block_t *block)
+{
+    for (uint32_t i = 0; i < block->count; i++) {
+#if BOARD_BURST_ENABLE
+        /* A detector turning active triggers the pre-trigger ring */
+        if (burst_get_state() == BURST_ARMED) {
+            uint8_t active = event_detect_get_active();
+            
+            app_event_check(&block->samples[i]);
+            if ((event_detect_get_active() & (uint8_t)~active) != 0U) {
+                burst_trigger(block->samples[i].sequence);
+            }
+            continue;
+        }
+#endif
+        app_event_check(&block->samples[i]);
     }
+}
+
+/**
+ * @brief Subscribe every per-sample consumer to the sample bus
+ */
+static bool app_sample_bus_init(void)
+{
+    bool ok = sample_bus_init();
     
-    /* I2C slave is initialized in main_init_drivers() */
-    /* I2C slave is started in main_init_app() */
+#if BOARD_BURST_ENABLE
+    ok = burst_init() && ok;
+    ok = sample_bus_subscribe(app_sub_burst) && ok;
+#endif
+    ok = sample_bus_subscribe(app_sub_fifo) && ok;
+#if BOARD_USB_STREAM_ENABLE
+    ok = sample_bus_subscribe(app_sub_usb) && ok;
+#endif
+#if BOARD_UART_STREAM_ENABLE
+    ok = sample_bus_subscribe(app_sub_uart) && ok;
+#endif
+#if BOARD_SD_LOG_ENABLE
+    ok = sample_bus_subscribe(app_sub_sd_log) && ok;
+#endif
+#if BOARD_FLASH_LOG_ENABLE
+    ok = sample_bus_subscribe(app_sub_flash_log) && ok;
+#endif
+#if BOARD_EEPROM_LOG_ENABLE
+    ok = sample_bus_subscribe(app_sub_elog) && ok;
+#endif
+    ok = sample_bus_subscribe(app_sub_events) && ok;
+    return ok;
+}
+
+/**
+ * @brief Read the sensor that feeds the I2C slave and DAC outputs
+ * 
+ * Samples are published on the sample bus, one block per drain.
+ * Single sensor: drains the sampler ring and returns the newest sample.
+ * Mux rig: the probe on the lowest active channel (other probes are read
+ * via sensor_array_get_data()), or with BOARD_SENSOR_VOTE_ENABLE one fused
+ * sample per new probe sample (sensor_vote.h).
+ * 
+ * @param data Receives the newest sample
+ * @return Number of new samples (0 if none)
+ */
+static uint32_t app_read_sensor(sensor_data_t *data)
+{
+#if BOARD_SENSOR_VOTE_ENABLE
+    uint32_t total = 0;
+    sample_bus_block_t *block;
     
-    /* Register I2C slave RX callback to print received values */
-    i2c_slave_register_rx_callback(app_i2c_slave_rx_callback);
+    /* Fused samples go to every subscriber like a single sensor's */
+    while ((block = sample_bus_acquire()) != NULL) {
+        block->count = sensor_vote_poll(block->samples, SAMPLE_BUS_BLOCK_SAMPLES);
+        if (block->count == 0U) {
+            sample_bus_publish(block);
+            break;
+        }
+        *data = block->samples[block->count - 1U];
+        total += block->count;
+        sample_bus_publish(block);
+    }
+#if BOARD_SD_LOG_ENABLE
+    sd_log_poll();
+#endif
+#if BOARD_FLASH_LOG_ENABLE
+    flash_log_poll();
+#endif
+    return total;
+#elif BOARD_SENSOR_MUX_CHANNELS != 0
+    uint16_t mask = sensor_array_get_active_mask();
     
-    /* DAC driver is initialized in main_init_drivers() */
-    /* DAC is ready to use */
+    for (uint8_t ch = 0; ch < SENSOR_ARRAY_MAX_CHANNELS; ch++) {
+        if (mask & (1U << ch)) {
+            sensor_data_t probe;
+            
+            sample_bus_block_t *block;
+            
+            /* Only a sample not processed yet counts as new (and only once
+             * there is a block to publish it in) */
+            if (!sensor_array_get_data(ch, &probe) ||
+                (probe_seen && probe.sequence == probe_sequence) ||
+                (block = sample_bus_acquire()) == NULL) {
+                return 0;
+            }
+            probe_seen = true;
+            probe_sequence = probe.sequence;
+            block->samples[0] = probe;
+            block->count = 1;
+            sample_bus_publish(block);
+#if BOARD_SD_LOG_ENABLE
+            sd_log_poll();
+#endif
+#if BOARD_FLASH_LOG_ENABLE
+            flash_log_poll();
+#endif
+            *data = probe;
+            return 1;
+        }
+    }
+    return 0;
+#else
+    uint32_t total = 0;
+    sample_bus_block_t *block;
     
-    app_initialized = true;
-    return true;
+    /* Outputs only need the newest value, but every sample goes to every
+     * subscriber (the master's burst FIFO, the USB stream, the logs). With
+     * every block held, the rest waits in the sampler ring */
+    while ((block = sample_bus_acquire()) != NULL) {
+        block->count = sensor_sampling_read_batch(block->samples, SAMPLE_BUS_BLOCK_SAMPLES);
+        if (block->count == 0U) {
+            sample_bus_publish(block);
+            break;
+        }
+        *data = block->samples[block->count - 1U];
+        total += block->count;
+        sample_bus_publish(block);
+    }
+#if BOARD_SD_LOG_ENABLE
+    /* Next full sector to the card (or the last one's busy polled) */
+    sd_log_poll();
+#endif
+#if BOARD_FLASH_LOG_ENABLE
+    /* Raw pairs of a raw trace (none unless one runs), then one erase or
+     * half-page program */
+    {
+        sensor_raw_record_t raw[SAMPLE_BUS_BLOCK_SAMPLES];
+        uint32_t count;
+        
+        while ((count = sensor_sampling_read_raw(raw, SAMPLE_BUS_BLOCK_SAMPLES)) != 0U) {
+            for (uint32_t i = 0; i < count; i++) {
+                flash_log_push_raw(&raw[i]);
+            }
+        }
+    }
+    flash_log_poll();
+#endif
+    return total;
+#endif
 }
 
-void app_main_loop(void)
+/**
+ * @brief Clip a folded DAC code to 0..BOARD_DAC_MAX_CODE
+ */
+static uint16_t app_dac_clip(int64_t code)
 {
-    /* Main application loop - most work is done in interrupt handlers */
-    /* This function can be used for non-critical tasks, logging, etc. */
+    if (code <= 0) {
+        return 0;
+    }
+    return code >= (int64_t)BOARD_DAC_MAX_CODE ? (uint16_t)BOARD_DAC_MAX_CODE : (uint16_t)code;
+}
+
+/**
+ * @brief Folded code of a sample through one mapping, Q32
+ */
+static inline int64_t app_dac_map_q32(const app_dac_map_fast_t *map, const int32_t *inputs)
+{
+    int64_t dx = (int64_t)inputs[map->source] - map->in_min;
     
-    if (!app_initialized) {
-        return;
+    if (dx < map->dx_min) {
+        dx = map->dx_min;
+    } else if (dx > map->dx_max) {
+        dx = map->dx_max;
     }
     
-    /* ========================================================================
-     * READ AND PROCESS SENSOR DATA
-     * ======================================================================== */
+    /* One 64-bit multiply-add: scale, rounding and calibration together */
+    return dx * map->slope + map->offset;
+}
+
+/**
+ * @brief DAC code of a sample through one mapping
+ */
+static uint16_t app_dac_map_apply(const app_dac_map_fast_t *map, const int32_t *inputs)
+{
+    return app_dac_clip(app_dac_map_q32(map, inputs) >> 32);
+}
+
+/**
+ * @brief Follower target of a sample through one mapping: the code with
+ *        BOARD_DAC_DITHER_BITS fraction bits (the code itself without)
+ */
+static uint16_t app_dac_map_apply_fine(const app_dac_map_fast_t *map, const int32_t *inputs)
+{
+    /* The folded offset rounds to a whole code: to the fine step instead */
+    int64_t fine = (app_dac_map_q32(map, inputs) - APP_DAC_FINE_ROUND) >> (32U - BOARD_DAC_DITHER_BITS);
     
-    /* Attempt to read latest sensor data */
-    if (sensor_sampling_get_data(&latest_sensor_data)) {
-        /* Data is valid and ready */
-        
-        /* Overflow protection: Prevent reading_count from wrapping */
-        if (reading_count < READING_COUNT_MAX) {
-            reading_count++;
-        }
-        /* else: Count has reached maximum, keep at max to prevent overflow */
+    if (fine <= 0) {
+        return 0;
+    }
+    return fine >= (int64_t)DAC_FINE_MAX ? (uint16_t)DAC_FINE_MAX : (uint16_t)fine;
+}
+
+#if BOARD_PWM_OUT_ENABLE
+/**
+ * @brief Send a sample to the PWM outputs, one preloaded store each
+ */
+static void app_pwm_output(const int32_t *inputs)
+{
+    for (uint32_t out = 0; out < PWM_OUT_COUNT; out++) {
+        pwm_out_write_fast(out, app_dac_map_apply(&pwm_maps_fast[out], inputs));
+    }
+}
+#endif
+
+/**
+ * @brief Send a code pair to the DAC outputs
+ * 
+ * Codes with BOARD_DAC_DITHER_BITS fraction bits (APP_DAC_FINE()). The
+ * follower takes them as they are while it runs; the playout buffer or a
+ * dual write take the rounded codes. The alarm threshold replaces the
+ * code of its output.
+ */
+static void app_dac_output(uint16_t out1_fine, uint16_t out2_fine)
+{
+    uint16_t fine[APP_DAC_OUTPUTS] = { out1_fine, out2_fine };
+    
+#if BOARD_COMP_ALARM_ENABLE
+    fine[BOARD_COMP_ALARM_DAC_OUT] = APP_DAC_FINE(alarm_threshold_code);
+#endif
+    for (uint32_t ch = 0; ch < APP_DAC_OUTPUTS; ch++) {
+        dac_codes[ch] = (uint16_t)((fine[ch] + APP_DAC_FINE_HALF) >> BOARD_DAC_DITHER_BITS);
+    }
+    
+    if (dac_playout_is_active()) {
+        (void)dac_playout_push(dac_timestamp_us, dac_codes[DAC_CHANNEL_OUT1], dac_codes[DAC_CHANNEL_OUT2]);
+    } else if (!dac_follow_set_fine(fine[DAC_CHANNEL_OUT1], fine[DAC_CHANNEL_OUT2])) {
+        dac_set_dual(dac_codes[DAC_CHANNEL_OUT1], dac_codes[DAC_CHANNEL_OUT2]);
+    }
+}
+
+#if BOARD_COMP_ALARM_ENABLE
+/**
+ * @brief Drive the alarm threshold output and (re)arm the comparator
+ * 
+ * Threshold through the channel transfer (calibration, VDDA), so the trip
+ * point is in volts at the alarm input. Disarmed: full scale, the
+ * comparator output stays low.
+ * 
+ * @param rearm true to clear the latch and take the next crossing
+ */
+static void app_alarm_update(bool rearm)
+{
+    alarm_threshold_code = (alarm_threshold_mv == 0U) ? (uint16_t)BOARD_DAC_MAX_CODE :
+                           dac_calibrated_code((dac_channel_t)BOARD_COMP_ALARM_DAC_OUT,
+                                               dac_millivolts_to_code(alarm_threshold_mv));
+    
+    /* Outside the mapping, the threshold is written now: a stalled sensor
+     * does not hold up the watchdog (the other output loses its dither
+     * fraction until the next sample) */
+    if (dac_cal_step == APP_DAC_CAL_END) {
+        uint32_t masked = hal_irq_mask(HAL_IRQ_LINES_I2C1);  /* Against a setpoint write */
         
-        /* Overflow protection: Clamp sensor values to expected ranges */
-        int32_t pressure_clamped = latest_sensor_data.pressure;
-        int32_t temperature_clamped = latest_sensor_data.temperature;
+        app_dac_output(APP_DAC_FINE(dac_codes[DAC_CHANNEL_OUT1]), APP_DAC_FINE(dac_codes[DAC_CHANNEL_OUT2]));
+        hal_irq_unmask(masked);
+    }
+    
+    /* A refold keeps the interrupt as it is: no crossing lost meanwhile */
+    if (!rearm) {
+        return;
+    }
+    hal_comp_alarm_disarm();
+    alarm_tripped = false;
+    if (alarm_threshold_mv != 0U) {
+        hal_comp_alarm_arm();
+    }
+}
+
+/**
+ * @brief Alarm status byte (APP_REG_ALARM)
+ */
+static uint8_t app_alarm_status(void)
+{
+    return (uint8_t)((alarm_threshold_mv != 0U ? APP_ALARM_ARMED : 0U) |
+                     (alarm_tripped ? APP_ALARM_TRIPPED : 0U) |
+                     (hal_comp_alarm_get_output() ? APP_ALARM_ABOVE : 0U));
+}
+#endif
+
+/**
+ * @brief Fold one mapping and an output transfer into a slope/offset pair
+ */
+static void app_dac_map_fold(const app_dac_map_t *map, const dac_calibration_t *cal,
+                             app_dac_map_fast_t *fast)
+{
+    int64_t span = (int64_t)map->in_max - map->in_min;
+    int64_t slope;
+    
+    /* Ideal slope, then the calibration gain; both fit in 64 bits for
+     * a span of one unit and 4095 codes */
+    slope = ((int64_t)((int32_t)map->code_max - (int32_t)map->code_min) << 32) / span;
+    fast->slope = (slope * (int64_t)cal->gain_q16) / 65536;
+    fast->offset = (((int64_t)map->code_min * cal->gain_q16 + cal->offset_q16) << 16) + (1LL << 31);
+    fast->source = map->source;
+    fast->in_min = map->in_min;
+    if (map->clamp == APP_DAC_CLAMP_INPUT) {
+        fast->dx_min = 0;
+        fast->dx_max = span;
+    } else {
+        /* Far enough past either end to reach the rails, bounded so the
+         * product cannot overflow */
+        fast->dx_min = -span * (int64_t)(BOARD_DAC_MAX_CODE + 1U);
+        fast->dx_max = span * (int64_t)(BOARD_DAC_MAX_CODE + 2U);
+    }
+}
+
+/**
+ * @brief Fold the mappings and the DAC channel transfers (calibration at
+ *        the actual VDDA) into the per-sample slope/offset pairs
+ * 
+ * Main loop only (init and command dispatch), same context as the DAC
+ * update. The PWM outputs (BOARD_PWM_OUT_ENABLE) fold their VDD scale.
+ */
+static void app_dac_map_update(void)
+{
+    app_dac_map_fast_t folded[APP_DAC_OUTPUTS];
+#if BOARD_PWM_OUT_ENABLE
+    app_dac_map_fast_t pwm_folded[PWM_OUT_COUNT];
+    dac_calibration_t pwm_cal;
+#endif
+    uint32_t primask;
+    
+    for (uint32_t ch = 0; ch < APP_DAC_OUTPUTS; ch++) {
+        dac_calibration_t cal;
         
-        if (pressure_clamped < PRESSURE_MIN_RAW) {
-            pressure_clamped = PRESSURE_MIN_RAW;
-        } else if (pressure_clamped > PRESSURE_MAX_RAW) {
-            pressure_clamped = PRESSURE_MAX_RAW;
-        }
+        (void)dac_get_transfer((dac_channel_t)ch, &cal);
+        app_dac_map_fold(&dac_maps[ch], &cal, &folded[ch]);
+    }
+#if BOARD_PWM_OUT_ENABLE
+    (void)pwm_out_get_transfer(&pwm_cal);
+    for (uint32_t out = 0; out < PWM_OUT_COUNT; out++) {
+        app_dac_map_fold(&pwm_maps[out], &pwm_cal, &pwm_folded[out]);
+    }
+#endif
+    
+    /* The direct path reads them from the bottom half: all in one step */
+    primask = hal_crit_enter();
+    for (uint32_t ch = 0; ch < APP_DAC_OUTPUTS; ch++) {
+        dac_maps_fast[ch] = folded[ch];
+    }
+#if BOARD_PWM_OUT_ENABLE
+    for (uint32_t out = 0; out < PWM_OUT_COUNT; out++) {
+        pwm_maps_fast[out] = pwm_folded[out];
+    }
+#endif
+    hal_crit_exit(primask);
+    
+#if BOARD_COMP_ALARM_ENABLE
+    /* Same transfer for the threshold; the latch is kept */
+    app_alarm_update(false);
+#endif
+}
+
+#if BOARD_VDDA_TRACK_ENABLE
+/**
+ * @brief Fold a VDDA measurement into the DAC scales
+ * 
+ * Averaged (1/8 weight); a changed average refolds the scales, so the
+ * per-sample path keeps its one multiply.
+ */
+static void app_vdda_update(uint32_t vdda)
+{
+    uint32_t average;
+    
+    if (vdda_filtered_x8 == 0U) {
+        vdda_filtered_x8 = vdda * 8U;
+    } else {
+        vdda_filtered_x8 += vdda - (vdda_filtered_x8 + 4U) / 8U;
+    }
+    
+    average = (vdda_filtered_x8 + 4U) / 8U;
+    if (average != dac_get_vdda_mv() && dac_set_vdda_mv(average)) {
+        app_dac_map_update();
+    }
+}
+#endif
+
+static bool app_jobs_init(void);
+
+#if BOARD_DAC_VERIFY_ENABLE
+static void app_regs_publish(void);
+
+/**
+ * @brief Compare the DAC pins with the codes they are converting
+ * 
+ * Both are ratiometric to VDDA, so raw ADC and DAC codes compare directly.
+ * The scan ran on its own trigger up to a poll before: a channel changes
+ * fault state after BOARD_DAC_VERIFY_COUNT scans in a row say so, and one
+ * scan catching a follower ramp or a step does not.
+ */
+static void app_dac_verify(const hal_adc_scan_t *scan)
+{
+    uint8_t faults = dac_faults;
+    
+    for (uint32_t ch = 0; ch < APP_DAC_OUTPUTS; ch++) {
+        uint32_t expected = dac_get_output_code((dac_channel_t)ch);
+        uint32_t measured = scan->dac_out[ch];
+        uint32_t error;
+        bool bad;
         
-        if (temperature_clamped < TEMPERATURE_MIN_RAW) {
-            temperature_clamped = TEMPERATURE_MIN_RAW;
-        } else if (temperature_clamped > TEMPERATURE_MAX_RAW) {
-            temperature_clamped = TEMPERATURE_MAX_RAW;
+        if (expected < APP_DAC_VERIFY_RAIL_CODES) {
+            expected = APP_DAC_VERIFY_RAIL_CODES;
+        } else if (expected > BOARD_DAC_MAX_CODE - APP_DAC_VERIFY_RAIL_CODES) {
+            expected = BOARD_DAC_MAX_CODE - APP_DAC_VERIFY_RAIL_CODES;
         }
         
-        /* Convert raw values to engineering units for display */
-        /* Pressure: sensor returns in 0.01 mbar, convert to mbar */
-        /* Use clamped values to prevent overflow in float conversion */
-        float pressure_mbar = (float)pressure_clamped / 100.0f;
-        
-        /* Temperature: sensor returns in 0.01°C, convert to °C */
-        float temperature_c = (float)temperature_clamped / 100.0f;
-        
-        /* Optional: Convert pressure to other units */
-        /* Overflow protection: Check if multiplication would overflow float range */
-        float pressure_psi = pressure_mbar * 0.0145038f;  /* 1 mbar ≈ 0.0145 PSI */
-        float pressure_pa = pressure_mbar * 100.0f;        /* 1 mbar = 100 Pa */
-        
-        /* Clamp float values to prevent infinity/NaN */
-        if (pressure_pa > 1e6f) pressure_pa = 1e6f;  /* Max 1 MPa */
-        if (pressure_pa < -1e6f) pressure_pa = -1e6f;
-        if (pressure_psi > 150.0f) pressure_psi = 150.0f;  /* Max ~150 PSI */
-        if (pressure_psi < -150.0f) pressure_psi = -150.0f;
-        
-
-        /* Uncomment these lines to enable printf output (requires UART/USB setup) */
-        /*
-        printf("[Sensor Reading #%lu]\r\n", (unsigned long)reading_count);
-        printf("  Pressure:   %ld (0.01 mbar) = %.2f mbar = %.2f PSI = %.2f Pa\r\n",
-               pressure_clamped,  // Use clamped value for safety 
-               pressure_mbar,
-               pressure_psi,
-               pressure_pa);
-        printf("  Temperature: %ld (0.01°C) = %.2f°C\r\n",
-               temperature_clamped,  // Use clamped value for safety
-               temperature_c);
-        printf("  Valid:       %s\r\n", latest_sensor_data.valid ? "Yes" : "No");
-        if (pressure_clamped != latest_sensor_data.pressure || 
-            temperature_clamped != latest_sensor_data.temperature) {
-            printf("  WARNING: Values clamped to prevent overflow!\r\n");
+        dac_readback[ch] = (uint16_t)measured;
+        error = (measured > expected) ? measured - expected : expected - measured;
+        bad = error > BOARD_DAC_VERIFY_TOLERANCE;
+        if (bad == ((faults >> ch) & 1U)) {
+            dac_verify_run[ch] = 0;
+        } else if (++dac_verify_run[ch] >= BOARD_DAC_VERIFY_COUNT) {
+            faults ^= (uint8_t)(1U << ch);
+            dac_verify_run[ch] = 0;
         }
-        printf("\r\n");
-        */
-        
-        /* Store latest reading for other application modules */
-        /* This data can be used by I2C slave, DAC control, etc. */
-        
-        /* Update I2C slave TX value with latest pressure reading */
-        /* When master reads, it will get the latest pressure value */
-        i2c_slave_set_tx_value((uint32_t)pressure_clamped);
-        
-        /* TODO: Process received I2C slave data if needed */
-        uint32_t received_value;
-        if (i2c_slave_get_received_value(&received_value)) {
-             // Process received value from master
-             //printf("Received I2C slave value: %lu\r\n", (unsigned long)received_value);
-        }
-         
-        
-        /* Example: Update DAC outputs based on sensor data */
-        /* DAC Channel 1: Set to pressure (scaled to 0-3.3V range) */
-        /* Map pressure to 0-3.3V: Sensor range is 0-3000 mbar (0-30 bar) */
-        /* Clamp pressure to valid sensor range before scaling */
-        float pressure_for_dac = pressure_mbar;
-        if (pressure_for_dac < 0.0f) {
-            pressure_for_dac = 0.0f;  /* Sensor minimum is 0 mbar */
-        } else if (pressure_for_dac > 3000.0f) {
-            pressure_for_dac = 3000.0f;  /* Sensor maximum is 3000 mbar */
-        }
-        float dac1_voltage = (pressure_for_dac / 3000.0f) * 3.3f;  /* Scale 0-3000 mbar to 0-3.3V */
-        dac_set_voltage_ch1(dac1_voltage);
-        
-        /* DAC Channel 2: Set to temperature (scaled to 0-3.3V range) */
-        /* Map temperature to 0-3.3V: Sensor range is -20°C to +85°C */
-        /* Clamp temperature to valid sensor range before scaling */
-        float temp_for_dac = temperature_c;
-        if (temp_for_dac < -20.0f) {
-            temp_for_dac = -20.0f;  /* Sensor minimum is -20°C */
-        } else if (temp_for_dac > 85.0f) {
-            temp_for_dac = 85.0f;  /* Sensor maximum is +85°C */
-        }
-        float dac2_voltage = ((temp_for_dac + 20.0f) / 105.0f) * 3.3f;  /* Scale -20°C to +85°C to 0-3.3V */
-        /* Note: dac_set_voltage_ch2() already clips to 0-3.3V, but explicit clamping ensures correct scaling */
-        dac_set_voltage_ch2(dac2_voltage);
-        
     }
-    /* else: No new data available yet, sensor still reading or error occurred */
     
-    /* The sensor sampling is handled entirely in interrupt context */
-    /* This function just reads and processes the results */
+    if (faults != dac_faults) {
+        TRACE(TRACE_DAC_FAULT, faults, dac_faults);
+        dac_faults = faults;
+        app_regs_publish();
+    }
 }
+#endif
 
-/* ============================================================================
- * HELPER FUNCTIONS
+#if BOARD_ADC_SCAN_PERIOD_MS != 0
+/**
+ * @brief Collect the ADC background scans
+ * 
+ * TIM22 starts a scan every BOARD_ADC_SCAN_PERIOD_MS and the DMA moves it
+ * (BOARD_ADC_SCAN_TIM22; without it this pass starts them): the main loop
+ * only takes each finished one, and the DAC update path never waits.
+ */
+static void app_adc_poll(void)
+{
+    hal_adc_scan_t scan;
+#if !BOARD_ADC_SCAN_TIM22
+    uint32_t now = hal_tim2_get_timestamp_us();
+    
+    if (now - adc_scan_last_us >= BOARD_ADC_SCAN_PERIOD_MS * 1000U && hal_adc_scan_start()) {
+        adc_scan_last_us = now;
+    }
+#endif
+    
+    if (!hal_adc_scan_read(&scan)) {
+        return;
+    }
+    adc_scan_last = scan;
+    
+#if BOARD_VDDA_TRACK_ENABLE
+    app_vdda_update(scan.vdda_mv);
+#endif
+#if BOARD_DAC_VERIFY_ENABLE
+    /* A stimulus or waveform moves too fast between the conversion and this read */
+    if (!dac_stream_is_running() || dac_follow_is_active() || dac_playout_is_active()) {
+        app_dac_verify(&scan);
+    }
+#endif
+}
+#endif
+
+/**
+ * @brief Give the DAC outputs back to the sensor mapping
+ * 
+ * Through the playout buffer when BOARD_DAC_PLAYOUT_DELAY_US is set, the
+ * follower when BOARD_DAC_FOLLOW_RATE_HZ is, else by one write per sample.
+ * Not in setpoint mode: the outputs stay with the master.
+ */
+static void app_dac_output_resume(void)
+{
+    if (dac_setpoint_active) {
+        return;
+    }
+#if BOARD_DAC_PLAYOUT_DELAY_US != 0
+    (void)dac_playout_start(BOARD_DAC_FOLLOW_RATE_HZ, BOARD_DAC_PLAYOUT_DELAY_US,
+                            BOARD_DAC_PLAYOUT_EXTRAPOLATE != 0);
+#elif BOARD_DAC_FOLLOW_RATE_HZ != 0
+    (void)dac_follow_start(BOARD_DAC_FOLLOW_RATE_HZ, BOARD_DAC_FOLLOW_MAX_STEP);
+#endif
+}
+
+/**
+ * @brief DAC stream refill: triangle on OUT1, its mirror on OUT2
+ * 
+ * DMA interrupt context. The alarm threshold output keeps its threshold.
+ */
+static void app_dac_stimulus_refill(uint32_t *samples, uint32_t count)
+{
+    uint16_t codes[APP_DAC_OUTPUTS];
+    uint32_t i;
+    
+    for (i = 0; i < count; i++) {
+        codes[DAC_CHANNEL_OUT1] = stimulus_code;
+        codes[DAC_CHANNEL_OUT2] = (uint16_t)(BOARD_DAC_MAX_CODE - stimulus_code);
+#if BOARD_COMP_ALARM_ENABLE
+        codes[BOARD_COMP_ALARM_DAC_OUT] = alarm_threshold_code;
+#endif
+        samples[i] = dac_stream_sample(codes[DAC_CHANNEL_OUT1], codes[DAC_CHANNEL_OUT2]);
+        
+        if (stimulus_rising) {
+            if (stimulus_code + APP_DAC_STIMULUS_STEP >= BOARD_DAC_MAX_CODE) {
+                stimulus_code = (uint16_t)BOARD_DAC_MAX_CODE;
+                stimulus_rising = false;
+            } else {
+                stimulus_code += APP_DAC_STIMULUS_STEP;
+            }
+        } else {
+            if (stimulus_code <= APP_DAC_STIMULUS_STEP) {
+                stimulus_code = 0;
+                stimulus_rising = true;
+            } else {
+                stimulus_code -= APP_DAC_STIMULUS_STEP;
+            }
+        }
+    }
+}
+
+#if BOARD_DAC_WAVE_ENABLE
+/**
+ * @brief DAC stream refill: the active waveform table, looping
+ * 
+ * DMA interrupt context. The alarm threshold output keeps its threshold.
+ */
+static void app_dac_wave_refill(uint32_t *samples, uint32_t count)
+{
+    uint16_t codes[APP_DAC_OUTPUTS];
+    
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t pair = wave_next();
+        
+        codes[DAC_CHANNEL_OUT1] = (uint16_t)pair;
+        codes[DAC_CHANNEL_OUT2] = (uint16_t)(pair >> 16);
+#if BOARD_COMP_ALARM_ENABLE
+        codes[BOARD_COMP_ALARM_DAC_OUT] = alarm_threshold_code;
+#endif
+        samples[i] = dac_stream_sample(codes[DAC_CHANNEL_OUT1], codes[DAC_CHANNEL_OUT2]);
+    }
+}
+#endif
+
+/**
+ * @brief Store a 32-bit value in the register block (little-endian)
+ */
+static void app_regs_put_u32(uint8_t reg, uint32_t value)
+{
+    app_regs[reg] = (uint8_t)(value & 0xFF);
+    app_regs[reg + 1U] = (uint8_t)((value >> 8) & 0xFF);
+    app_regs[reg + 2U] = (uint8_t)((value >> 16) & 0xFF);
+    app_regs[reg + 3U] = (uint8_t)((value >> 24) & 0xFF);
+}
+
+/**
+ * @brief Publish the register block to the I2C slave
+ * 
+ * One update for all fields, so a master reading the block gets values
+ * of the same sample.
+ */
+static void app_regs_publish(void)
+{
+    i2c_slave_stats_t stats;
+    sensor_tick_stats_t tick;
+    sensor_jitter_stats_t jitter;
+    uint32_t rate_hz = hal_tim2_get_rate_hz();
+    uint32_t stack_peak;
+#if BOARD_PROF_ENABLE
+    prof_stats_t prof;
+#endif
+#if BOARD_LATENCY_ENABLE
+    latency_hist_t hist;
+#endif
+    
+    app_regs[APP_REG_FIFO_LEVEL] = host_fifo_get_level();
+    app_regs[APP_REG_SYNC_STATE] = (uint8_t)time_sync_get_state();
+    app_regs[APP_REG_CMD_STATUS] = (uint8_t)host_command_get_last_result();
+    app_regs_put_u32(APP_REG_FIFO_OVERFLOWS, host_fifo_get_overflows());
+#if BOARD_BURST_ENABLE
+    app_regs[APP_REG_BURST_STATE] = (uint8_t)burst_get_state();
+    app_regs[APP_REG_BURST_COUNT] = (uint8_t)(burst_get_count() & 0xFF);
+    app_regs[APP_REG_BURST_COUNT + 1U] = (uint8_t)(burst_get_count() >> 8);
+#endif
+#if BOARD_DAC_VERIFY_ENABLE
+    app_regs[APP_REG_DAC_FAULT] = dac_faults;
+    app_regs_put_u32(APP_REG_DAC_READBACK, (uint32_t)dac_readback[DAC_CHANNEL_OUT1] |
+                                           ((uint32_t)dac_readback[DAC_CHANNEL_OUT2] << 16));
+#endif
+#if BOARD_COMP_ALARM_ENABLE
+    app_regs[APP_REG_ALARM] = app_alarm_status();
+    app_regs_put_u32(APP_REG_ALARM_COUNT, alarm_count);
+    app_regs_put_u32(APP_REG_ALARM_TIME, alarm_time_us);
+#endif
+#if BOARD_PROF_ENABLE
+    if (prof_get_stats(prof_site, &prof)) {
+        app_regs[APP_REG_PROF_SITE] = (uint8_t)prof_site;
+        app_regs_put_u32(APP_REG_PROF_COUNT, prof.count);
+        app_regs_put_u32(APP_REG_PROF_MIN, prof.min);
+        app_regs_put_u32(APP_REG_PROF_MAX, prof.max);
+        app_regs_put_u32(APP_REG_PROF_MEAN, prof.mean);
+    }
+#endif
+#if BOARD_LATENCY_ENABLE
+    if (latency_get(latency_stage, &hist)) {
+        app_regs[APP_REG_LAT_STAGE] = (uint8_t)latency_stage;
+        app_regs[APP_REG_LAT_BUCKET] = latency_bucket;
+        app_regs[APP_REG_LAT_P50] = latency_percentile(&hist, 50U);
+        app_regs[APP_REG_LAT_P99] = latency_percentile(&hist, 99U);
+        app_regs_put_u32(APP_REG_LAT_COUNT, hist.count[latency_bucket]);
+        app_regs_put_u32(APP_REG_LAT_TOTAL, hist.total);
+    }
+#endif
+#if BOARD_I2C_TUNE_ENABLE
+    app_regs[APP_REG_I2C2_SPEED] = bus_tune_get_report(BUS_TUNE_I2C2);
+    app_regs[APP_REG_I2C3_SPEED] = bus_tune_get_report(BUS_TUNE_I2C3);
+#endif
+    app_regs_put_u32(APP_REG_BOOT_BOARD, boot_times.board_us);
+    app_regs_put_u32(APP_REG_BOOT_DRIVERS, boot_times.drivers_us);
+    app_regs_put_u32(APP_REG_BOOT_APP, boot_times.app_us);
+    app_regs_put_u32(APP_REG_BOOT_SAMPLE, boot_times.first_sample_us);
+    sensor_sampling_get_tick_stats(&tick);
+    app_regs_put_u32(APP_REG_TICK_OVERRUNS, tick.overruns);
+    app_regs_put_u32(APP_REG_TICK_MAX, tick.max_us);
+    app_regs[APP_REG_TICK_MAX_STATE] = tick.max_state;
+    sensor_sampling_get_jitter_stats(&jitter);
+    app_regs[APP_REG_JITTER_PEAK] = (jitter.peak_us > 0xFFU) ? 0xFFU : (uint8_t)jitter.peak_us;
+    jitter.stddev_ns = (jitter.stddev_ns + 50U) / 100U;  /* 0.1 us */
+    if (jitter.stddev_ns > 0xFFFFU) {
+        jitter.stddev_ns = 0xFFFFU;
+    }
+    app_regs[APP_REG_JITTER_STDDEV] = (uint8_t)(jitter.stddev_ns & 0xFF);
+    app_regs[APP_REG_JITTER_STDDEV + 1U] = (uint8_t)(jitter.stddev_ns >> 8);
+    app_regs_put_u32(APP_REG_TICK_PERIOD, (rate_hz != 0U) ? 1000000UL / rate_hz : 0U);
+#if BOARD_EEPROM_LOG_ENABLE
+    app_regs_put_u32(APP_REG_ELOG_NEWEST, eeprom_log_get_newest());
+    app_regs_put_u32(APP_REG_ELOG_SEQ, elog_shown.seq);
+    app_regs[APP_REG_ELOG_TYPE] = (uint8_t)elog_shown.type;
+    for (uint32_t i = 0; i < EEPROM_LOG_DATA_WORDS; i++) {
+        app_regs_put_u32((uint8_t)(APP_REG_ELOG_DATA + 4U * i), elog_shown.data[i]);
+    }
+#endif
+    app_regs_put_u32(APP_REG_STATS_WINDOW, sample_stats_get_window());
+    app_regs_put_u32(APP_REG_STATS_SEQ, stats_shown.windows);
+    app_regs_put_u32(APP_REG_STATS_END, stats_shown.end_timestamp_us);
+    app_regs_put_u32(APP_REG_STATS_P_MIN, (uint32_t)stats_shown.pressure.min);
+    app_regs_put_u32(APP_REG_STATS_P_MAX, (uint32_t)stats_shown.pressure.max);
+    app_regs_put_u32(APP_REG_STATS_P_MEAN, (uint32_t)stats_shown.pressure.mean);
+    app_regs_put_u32(APP_REG_STATS_P_VAR, stats_shown.pressure.variance);
+    app_regs_put_u32(APP_REG_STATS_T_MIN, (uint32_t)stats_shown.temperature.min);
+    app_regs_put_u32(APP_REG_STATS_T_MAX, (uint32_t)stats_shown.temperature.max);
+    app_regs_put_u32(APP_REG_STATS_T_MEAN, (uint32_t)stats_shown.temperature.mean);
+    app_regs_put_u32(APP_REG_STATS_T_VAR, stats_shown.temperature.variance);
+    app_regs_put_u32(APP_REG_TRACK_PRESSURE, (uint32_t)track_shown.pressure);
+    app_regs_put_u32(APP_REG_TRACK_RATE, (uint32_t)track_shown.rate);
+    {
+        event_record_t oldest = {0};
+        uint32_t dropped = event_detect_get_dropped();
+        
+        app_regs[APP_REG_EVENT_ACTIVE] = event_detect_get_active();
+        app_regs[APP_REG_EVENT_PENDING] = (uint8_t)event_detect_get_pending();
+        app_regs[APP_REG_EVENT_DROPPED] = (dropped > 0xFFU) ? 0xFFU : (uint8_t)dropped;
+        if (event_detect_peek(&oldest)) {
+            app_regs[APP_REG_EVENT_OLDEST] = (uint8_t)(oldest.detector | (oldest.active ? 0x80U : 0U));
+        } else {
+            app_regs[APP_REG_EVENT_OLDEST] = 0;
+        }
+        app_regs_put_u32(APP_REG_EVENT_SEQ, oldest.sequence);
+    }
+    stack_peak = board_stack_poll();
+    app_regs_put_u32(APP_REG_STACK_PEAK, stack_peak);
+    app_regs_put_u32(APP_REG_STACK_FREE, board_stack_get_size() - stack_peak);
+    if (i2c_slave_get_stats(&stats)) {
+        app_regs_put_u32(APP_REG_I2C_READS, stats.reads);
+        app_regs_put_u32(APP_REG_I2C_WRITES, stats.writes);
+        app_regs_put_u32(APP_REG_I2C_NACKS, stats.nacks);
+        app_regs_put_u32(APP_REG_I2C_ERRORS, stats.errors);
+        app_regs_put_u32(APP_REG_I2C_OVERRUNS, stats.overruns);
+        app_regs_put_u32(APP_REG_I2C_REARMS, stats.rearms);
+        app_regs[APP_REG_I2C_RESETS] = (stats.bus_resets > 0xFFU) ? 0xFFU : (uint8_t)stats.bus_resets;
+        app_regs_put_u32(APP_REG_I2C_LAT_MIN, stats.latency_min_us);
+        app_regs_put_u32(APP_REG_I2C_LAT_MAX, stats.latency_max_us);
+        app_regs_put_u32(APP_REG_I2C_LAT_MEAN, stats.latency_mean_us);
+    }
+    i2c_slave_write_regs(APP_REG_PRESSURE, app_regs, sizeof(app_regs));
+}
+
+/**
+ * @brief Publish a sample to the I2C slave registers
+ */
+static void app_regs_put_sample(int32_t pressure, const sensor_data_t *data)
+{
+    int64_t converted = 0;
+    
+    /* Only the selected unit, only when one is */
+    if (pressure_unit != APP_UNIT_OFF) {
+        converted = ((int64_t)pressure * pressure_unit_q16[pressure_unit] + 0x8000) >> 16;
+    }
+    app_regs_put_u32(APP_REG_PRESSURE_UNIT, (uint32_t)(int32_t)converted);
+    app_regs_put_u32(APP_REG_PRESSURE, (uint32_t)pressure);
+    app_regs_put_u32(APP_REG_TEMPERATURE, (uint32_t)data->temperature);
+    app_regs_put_u32(APP_REG_TIMESTAMP, time_sync_to_master(data->timestamp_us));
+    app_regs_put_u32(APP_REG_SEQUENCE, data->sequence);
+    app_regs[APP_REG_QUALITY] = data->quality;
+    app_regs[APP_REG_ERROR_COUNT] = (uint8_t)data->error_count;
+    app_regs[APP_REG_ERROR_COUNT + 1U] = (uint8_t)(data->error_count >> 8);
+    app_regs[APP_REG_STATUS] = (uint8_t)SENSOR_STATUS_RUNNING;
+    app_regs_publish();
+#if BOARD_SLAVE_DIRECT_ENABLE
+    /* A newer sample from the bottom half may be out already */
+    if (!slave_live_on) {
+        slave_live_on = i2c_slave_set_live(APP_REG_PRESSURE, APP_SLAVE_LIVE_SIZE);
+    }
+#endif
+}
+
+/**
+ * @brief Report the sensor status in the I2C slave registers
+ * 
+ * Anything but RUNNING also replaces the pressure with the warming-up
+ * value, so a master reading only the legacy register sees it.
+ */
+static void app_regs_put_status(sensor_status_t status)
+{
+    if (status != SENSOR_STATUS_RUNNING) {
+        app_regs_put_u32(APP_REG_PRESSURE, APP_SLAVE_TX_WARMING_UP);
+#if BOARD_SLAVE_DIRECT_ENABLE
+        /* The last live sample would hide the warming-up value */
+        if (slave_live_on) {
+            (void)i2c_slave_set_live(APP_REG_PRESSURE, 0);
+            slave_live_on = false;
+        }
+#endif
+    }
+    if (app_regs[APP_REG_STATUS] != (uint8_t)status) {
+        TRACE(TRACE_SENSOR_STATUS, status, app_regs[APP_REG_STATUS]);
+    }
+    app_regs[APP_REG_STATUS] = (uint8_t)status;
+    app_regs_publish();
+}
+
+/**
+ * @brief Assert INTR_MCU once there is data for the master
+ * 
+ * Called after the update is published, so the master never reads ahead of
+ * the line. Watermark 0: every new sample; otherwise once the FIFO burst
+ * holds BOARD_INTR_MCU_WATERMARK samples.
+ */
+static void app_data_ready_update(void)
+{
+#if BOARD_INTR_MCU_WATERMARK == 0
+    hal_intr_mcu_set(true);
+#else
+    if (host_fifo_get_level() >= BOARD_INTR_MCU_WATERMARK) {
+        hal_intr_mcu_set(true);
+    }
+#endif
+}
+
+/**
+ * @brief I2C slave read callback: the master is fetching the data
+ * 
+ * A FIFO burst takes every sample; a read into the sample fields takes
+ * the newest one. A read racing an update may leave the line raised for a
+ * sample already read (same sequence number).
+ * 
+ * @param reg Register the read starts at
+ */
+static void app_i2c_slave_tx_callback(uint8_t reg)
+{
+    if (reg == APP_REG_FIFO || (BOARD_INTR_MCU_WATERMARK == 0 && reg < APP_REG_STATUS)) {
+        hal_intr_mcu_set(false);
+    }
+}
+
+/**
+ * @brief I2C general call: BOARD_I2C1_GC_SYNC_CODE aligns the sampling tick
+ * 
+ * Every board on the bus receives the byte in the same bus cycle, so all
+ * of them tick together from one period later. Other codes (the I2C
+ * spec's reset among them) are ignored.
+ * 
+ * @param code First byte after the general call address
+ */
+static void app_i2c_slave_gc_callback(uint8_t code)
+{
+    if (code == BOARD_I2C1_GC_SYNC_CODE) {
+        (void)sensor_sampling_align_tick();
+    }
+}
+
+#if BOARD_DAC_SETPOINT_ENABLE
+/**
+ * @brief Master DAC setpoint write (I2C1 interrupt)
+ * 
+ * A write reaching the last byte of APP_REG_DAC_SET_OUT2 applies both
+ * codes in one DHR12RD store; one stopping short only stages its bytes
+ * (dual-hold). Ignored outside setpoint mode. The alarm threshold output
+ * keeps its threshold.
+ */
+static void app_dac_setpoint_write(uint8_t reg, uint8_t len)
+{
+    uint8_t bytes[APP_REG_DAC_SET_SIZE];
+    
+    if (!dac_setpoint_active || (uint32_t)reg + len < APP_REG_DAC_SET_OUT1 + APP_REG_DAC_SET_SIZE ||
+        !i2c_slave_read_regs(APP_REG_DAC_SET_OUT1, bytes, sizeof(bytes))) {
+        return;
+    }
+    
+    dac_codes[DAC_CHANNEL_OUT1] = app_dac_clip((int64_t)(bytes[0] | (bytes[1] << 8)));
+    dac_codes[DAC_CHANNEL_OUT2] = app_dac_clip((int64_t)(bytes[2] | (bytes[3] << 8)));
+#if BOARD_COMP_ALARM_ENABLE
+    dac_codes[BOARD_COMP_ALARM_DAC_OUT] = alarm_threshold_code;
+#endif
+    (void)dac_write_dual_fast(dac_codes[DAC_CHANNEL_OUT1], dac_codes[DAC_CHANNEL_OUT2]);
+}
+#endif
+
+/**
+ * @brief I2C slave receive callback
+ * 
+ * Called automatically when the master has written registers.
+ * This runs in interrupt context, so keep it short!
+ * 
+ * @param reg First register written
+ * @param len Number of registers written
+ */
+static void app_i2c_slave_rx_callback(uint8_t reg, uint8_t len)
+{
+    uint8_t bytes[APP_REG_CMD_SIZE];
+    
+#if BOARD_DAC_SETPOINT_ENABLE
+    if (reg >= APP_REG_DAC_SET_OUT1) {
+        app_dac_setpoint_write(reg, len);
+        return;
+    }
+#endif
+    
+    /* Only the command window is writable; a write that does not reach
+     * its last byte (the opcode, or the CRC) just stages the argument */
+    if ((uint32_t)reg + len < APP_REG_CMD_ARG + APP_REG_CMD_SIZE) {
+        return;
+    }
+    
+    if (i2c_slave_read_regs(APP_REG_CMD_ARG, bytes, sizeof(bytes))) {
+        uint32_t argument = (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) |
+                            ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+#if BOARD_CRC_FRAMING_ENABLE
+        uint16_t crc = (uint16_t)(bytes[APP_REG_CMD_CRC - APP_REG_CMD_ARG] |
+                                  (bytes[APP_REG_CMD_CRC + 1U - APP_REG_CMD_ARG] << 8));
+#else
+        uint16_t crc = 0;
+#endif
+        
+        host_command_push(bytes[APP_REG_CMD_OPCODE - APP_REG_CMD_ARG], argument, crc,
+                          i2c_slave_get_write_time_us());
+    }
+    event_flags_set(APP_EVENT_I2C_RX);
+    
+    /* NOTE: This callback runs in interrupt context!
+     * Keep processing minimal here. Commands are queued and run
+     * in app_main_loop() */
+}
+
+#if BOARD_UART_STREAM_ENABLE
+/**
+ * @brief UART stream command frame received (interrupt context)
+ */
+static void app_uart_rx_callback(void)
+{
+    event_flags_set(APP_EVENT_I2C_RX);
+}
+
+/**
+ * @brief Queue the commands received over the UART stream
+ * 
+ * Behind the I2C ones, with the I2C1 lines masked: the command queue has
+ * a single producer.
+ * 
+ * @return Commands queued
+ */
+static uint32_t app_uart_commands(void)
+{
+    uart_stream_command_t command;
+    uint32_t count = 0;
+    
+    while (uart_stream_get_command(&command)) {
+        uint32_t masked = hal_irq_mask(HAL_IRQ_LINES_I2C1);
+        
+        (void)host_command_push(command.opcode, command.argument, command.crc, command.timestamp_us);
+        hal_irq_unmask(masked);
+        count++;
+    }
+    return count;
+}
+#endif
+
+/**
+ * @brief Slave output: publish the newest sample, raise INTR_MCU
+ */
+static void app_output_slave(const output_sched_input_t *input)
+{
+    /* Window completed in the bottom half: goes out with the sample */
+    (void)sample_stats_get(&stats_shown);
+    (void)tracker_get(&track_shown);
+    
+    /* Update I2C slave registers with latest reading */
+    /* When master reads, it will get the latest pressure value */
+    app_regs_put_u32(APP_REG_DERIVED, (uint32_t)input->derived);
+    app_regs_put_sample(input->pressure, input->sample);
+    LATENCY_RECORD(LATENCY_STAGE_SLAVE, input->sample->timestamp_us);
+#if BOARD_POLL_ALIGN_ENABLE
+    poll_align_published(input->sample->timestamp_us);
+#endif
+    app_data_ready_update();
+    
+    /* Event edge: the line goes up with the update that shows it,
+     * whatever the watermark */
+    if (event_raised) {
+        event_raised = false;
+        hal_intr_mcu_set(true);
+    }
+}
+
+#if !BOARD_DAC_DIRECT_ENABLE
+/**
+ * @brief DAC output: both mappings on the newest sample
+ * 
+ * Default: OUT1 pressure 0-3000 mbar, span set with HOST_CMD_SET_DAC_MAP;
+ * OUT2 temperature -20-85 degC; both to 0-3.3V; the alarm threshold output
+ * keeps its threshold. One write: both outputs change on the same cycle.
+ * Ignored while a stream (HOST_CMD_DAC_STREAM) owns the outputs, held
+ * during a calibration (HOST_CMD_DAC_CAL). The PWM outputs
+ * (BOARD_PWM_OUTPUTS) step with the same sample.
+ */
+static void app_output_dac(const output_sched_input_t *input)
+{
+    const int32_t inputs[APP_DAC_SOURCES] = {
+        [APP_DAC_SOURCE_PRESSURE] = input->pressure,
+        [APP_DAC_SOURCE_TEMPERATURE] = input->temperature,
+        [APP_DAC_SOURCE_DERIVED] = input->derived,
+    };
+    
+#if BOARD_PWM_OUT_ENABLE
+    app_pwm_output(inputs);
+#endif
+    if (dac_cal_step != APP_DAC_CAL_END || dac_setpoint_active) {
+        return;
+    }
+    
+    /* Playout shows it after its delay, the follower ramps to it at the
+     * stream rate; else step now */
+    dac_timestamp_us = input->sample->timestamp_us;
+    app_dac_output(app_dac_map_apply_fine(&dac_maps_fast[DAC_CHANNEL_OUT1], inputs),
+                   app_dac_map_apply_fine(&dac_maps_fast[DAC_CHANNEL_OUT2], inputs));
+    if (dac_playout_is_active()) {
+        LATENCY_ADD(LATENCY_STAGE_DAC, BOARD_DAC_PLAYOUT_DELAY_US);
+        return;
+    }
+#if BOARD_DAC_LATCH_ENABLE
+    /* Latched: the outputs change at the next tick, not now */
+    if (!dac_stream_is_running()) {
+        LATENCY_ADD(LATENCY_STAGE_DAC, hal_tim2_get_next_tick_us() - input->sample->timestamp_us);
+        return;
+    }
+#endif
+    LATENCY_RECORD(LATENCY_STAGE_DAC, input->sample->timestamp_us);
+}
+#endif
+
+#if BOARD_DAC_DIRECT_ENABLE
+/**
+ * @brief Direct DAC output: the sample straight from the compensation
+ * 
+ * Bottom half, interrupts masked (sensor_sampling_register_direct_callback()):
+ * clamp, two folded mappings and one DHR12RD store. Same mappings, hold
+ * and alarm threshold as app_output_dac(); the DAC fast path skips the
+ * store while a stream owns the outputs.
+ */
+static void app_dac_direct(const sensor_data_t *sample)
+{
+    int32_t inputs[APP_DAC_SOURCES];
+    int32_t pressure = sample->pressure;
+    int32_t temperature = sample->temperature;
+    
+    /* Same clamps as the main loop */
+    if (pressure < PRESSURE_MIN_RAW) {
+        pressure = PRESSURE_MIN_RAW;
+    } else if (pressure > PRESSURE_MAX_RAW) {
+        pressure = PRESSURE_MAX_RAW;
+    }
+    if (temperature < TEMPERATURE_MIN_RAW) {
+        temperature = TEMPERATURE_MIN_RAW;
+    } else if (temperature > TEMPERATURE_MAX_RAW) {
+        temperature = TEMPERATURE_MAX_RAW;
+    }
+    inputs[APP_DAC_SOURCE_PRESSURE] = pressure;
+    inputs[APP_DAC_SOURCE_TEMPERATURE] = temperature;
+    inputs[APP_DAC_SOURCE_DERIVED] = derived_from_pressure(pressure);  /* One table lookup */
+    
+#if BOARD_PWM_OUT_ENABLE
+    app_pwm_output(inputs);
+#endif
+    if (dac_cal_step != APP_DAC_CAL_END || dac_setpoint_active) {
+        return;
+    }
+    dac_codes[DAC_CHANNEL_OUT1] = app_dac_map_apply(&dac_maps_fast[DAC_CHANNEL_OUT1], inputs);
+    dac_codes[DAC_CHANNEL_OUT2] = app_dac_map_apply(&dac_maps_fast[DAC_CHANNEL_OUT2], inputs);
+#if BOARD_COMP_ALARM_ENABLE
+    dac_codes[BOARD_COMP_ALARM_DAC_OUT] = alarm_threshold_code;
+#endif
+    (void)dac_write_dual_fast(dac_codes[DAC_CHANNEL_OUT1], dac_codes[DAC_CHANNEL_OUT2]);
+    LATENCY_RECORD(LATENCY_STAGE_DAC, sample->timestamp_us);
+}
+#endif
+
+#if BOARD_SLAVE_DIRECT_ENABLE
+/**
+ * @brief Direct slave output: the published sample from the bottom half
+ * 
+ * sensor_sampling_register_publish_callback(): the same clamps and master
+ * timestamp as app_output_slave(), into the live block at
+ * APP_REG_PRESSURE. INTR_MCU and the other registers stay with the main
+ * loop.
+ */
+static void app_slave_direct(const sensor_data_t *sample)
+{
+    uint8_t live[APP_SLAVE_LIVE_SIZE];
+    int32_t pressure = sample->pressure;
+    int32_t temperature = sample->temperature;
+    uint32_t fields[4];
+    
+    if (pressure < PRESSURE_MIN_RAW) {
+        pressure = PRESSURE_MIN_RAW;
+    } else if (pressure > PRESSURE_MAX_RAW) {
+        pressure = PRESSURE_MAX_RAW;
+    }
+    if (temperature < TEMPERATURE_MIN_RAW) {
+        temperature = TEMPERATURE_MIN_RAW;
+    } else if (temperature > TEMPERATURE_MAX_RAW) {
+        temperature = TEMPERATURE_MAX_RAW;
+    }
+    
+    /* Register order, little-endian */
+    fields[0] = (uint32_t)pressure;
+    fields[1] = (uint32_t)temperature;
+    fields[2] = time_sync_to_master(sample->timestamp_us);
+    fields[3] = sample->sequence;
+    for (uint32_t i = 0; i < APP_SLAVE_LIVE_SIZE; i++) {
+        live[i] = (uint8_t)(fields[i / 4U] >> (8U * (i % 4U)));
+    }
+    (void)i2c_slave_write_live(live, sizeof(live));
+}
+#endif
+
+#if BOARD_EEPROM_LOG_ENABLE
+/**
+ * @brief EEPROM output: statistics record once per window (written in the
+ *        background)
+ */
+static void app_output_elog(const output_sched_input_t *input)
+{
+    app_elog_window_poll(input->sample->timestamp_us);
+}
+#endif
+
+/**
+ * @brief Apply a configuration (config.h) over the built-in one
+ * 
+ * The stored one is read in place from the EEPROM. Every setting goes
+ * through its setter: one out of range here (stored by another build)
+ * keeps its default.
+ * 
+ * @param config Settings to apply (NULL: the built-in ones stay)
+ */
+static void app_config_apply(const config_block_t *config)
+{
+    if (config == NULL) {
+        return;
+    }
+    
+#if BOARD_SENSOR_MUX_CHANNELS == 0
+    (void)sensor_sampling_set_profile((sensor_osr_t)config->pressure_osr,
+                                      (sensor_osr_t)config->temperature_osr);
+    (void)sensor_sampling_set_median((uint8_t)((config->filter >> 24) & 0x0FU));
+    (void)sensor_sampling_set_filter((sensor_filter_mode_t)(config->filter & 0xFFU),
+                                     (uint8_t)((config->filter >> 8) & 0xFFU),
+                                     (uint8_t)((config->filter >> 16) & 0xFFU));
+#endif
+    (void)sensor_sampling_set_rate_hz(config->rate_hz);
+    if (config->derived != 0U) {
+        (void)derived_set((derived_quantity_t)(config->derived >> 24),
+                          (int32_t)(config->derived & DERIVED_REFERENCE_MAX));
+    }
+    
+    for (uint32_t ch = 0; ch < APP_DAC_OUTPUTS; ch++) {
+        const config_dac_map_t *stored = &config->dac_maps[ch];
+        app_dac_map_t map;
+        
+        map.source = (app_dac_source_t)stored->source;
+        map.in_min = stored->in_min;
+        map.in_max = stored->in_max;
+        map.code_min = stored->code_min;
+        map.code_max = stored->code_max;
+        map.clamp = (app_dac_clamp_t)stored->clamp;
+        (void)app_set_dac_map((dac_channel_t)ch, &map);
+    }
+}
+
+/**
+ * @brief Fill a configuration block with the settings now running
+ * 
+ * @param block Receives them (magic, version, generation and CRC zero)
+ * @param slave_addr Slave address to put in (0: the stored one, or the
+ *                   built-in one)
+ */
+static void app_config_capture(config_block_t *block, uint8_t slave_addr)
+{
+    const config_block_t *stored = config_get();
+    config_block_t config = {0};
+    
+    if (slave_addr != 0U) {
+        config.slave_addr = slave_addr;
+    } else {
+        config.slave_addr = (stored != NULL) ? stored->slave_addr : (uint8_t)BOARD_I2C1_SLAVE_ADDR;
+    }
+    
+#if BOARD_SENSOR_MUX_CHANNELS == 0
+    {
+        sensor_osr_t pressure_osr;
+        sensor_osr_t temperature_osr;
+        
+        sensor_sampling_get_profile(&pressure_osr, &temperature_osr);
+        config.pressure_osr = (uint8_t)pressure_osr;
+        config.temperature_osr = (uint8_t)temperature_osr;
+        config.filter = sensor_sampling_get_filter();
+    }
+#endif
+    config.rate_hz = sensor_sampling_get_rate_hz();
+    config.derived = ((uint32_t)derived_get_quantity() << 24) | (uint32_t)derived_get_reference();
+    
+    for (uint32_t ch = 0; ch < APP_DAC_OUTPUTS; ch++) {
+        config.dac_maps[ch].source = (uint8_t)dac_maps[ch].source;
+        config.dac_maps[ch].clamp = (uint8_t)dac_maps[ch].clamp;
+        config.dac_maps[ch].code_min = dac_maps[ch].code_min;
+        config.dac_maps[ch].code_max = dac_maps[ch].code_max;
+        config.dac_maps[ch].in_min = dac_maps[ch].in_min;
+        config.dac_maps[ch].in_max = dac_maps[ch].in_max;
+    }
+    
+    *block = config;
+}
+
+#if BOARD_WARM_RESTART_ENABLE
+/**
+ * @brief Record the running settings for a warm boot (warm_restart.h)
+ */
+static void app_warm_save(void)
+{
+    config_block_t config;
+    
+    app_config_capture(&config, 0U);
+    warm_restart_save_settings(&config);
+}
+#endif
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+bool app_init(void)
+{
+    /* Initialize sensor sampling (single sensor: non-blocking, bring-up
+     * runs in the sampling state machine) */
+#if BOARD_SENSOR_MUX_CHANNELS != 0
+    /* Probes that do not answer are dropped; run with whatever is left */
+    sensor_array_init(BOARD_SENSOR_MUX_CHANNELS | (BOARD_I2C3_MUX_CHANNELS << 8));
+    if (sensor_array_get_active_mask() == 0) {
+        return false;
+    }
+#if BOARD_SENSOR_VOTE_ENABLE
+    sensor_vote_init();
+#endif
+#else
+    if (!sensor_sampling_init()) {
+        return false;
+    }
+#endif
+    
+    /* Stored settings over the built-in ones (the slave address was taken
+     * in main_init_drivers()) */
+    (void)derived_set((derived_quantity_t)BOARD_DERIVED_QUANTITY, BOARD_DERIVED_REFERENCE);
+#if BOARD_WARM_RESTART_ENABLE
+    /* Warm boot: the settings the master left running, stored or not */
+    if (warm_restart_get_settings() != NULL) {
+        app_config_apply(warm_restart_get_settings());
+    } else {
+        app_config_apply(config_get());
+    }
+    app_warm_save();
+#else
+    app_config_apply(config_get());
+#endif
+    
+    /* I2C slave is initialized in main_init_drivers() */
+    /* I2C slave is started in main_init_app() */
+    
+    /* Summary statistics from the first published sample on */
+    sample_stats_init(BOARD_SAMPLE_STATS_WINDOW);
+    
+    /* Main loop work, earliest deadline first */
+    if (!app_jobs_init()) {
+        return false;
+    }
+    
+    /* Consumers of the newest sample, each at its own rate */
+    (void)output_sched_register(APP_OUTPUT_SLAVE, app_output_slave, BOARD_OUTPUT_SLAVE_DECIMATION);
+#if BOARD_DAC_DIRECT_ENABLE
+    /* Every sample from the bottom half instead of the main loop */
+    sensor_sampling_register_direct_callback(app_dac_direct);
+#else
+    (void)output_sched_register(APP_OUTPUT_DAC, app_output_dac, BOARD_OUTPUT_DAC_DECIMATION);
+#endif
+#if BOARD_SLAVE_DIRECT_ENABLE
+    /* Sample registers from the bottom half, ahead of the main loop */
+    sensor_sampling_register_publish_callback(app_slave_direct);
+#endif
+#if BOARD_EEPROM_LOG_ENABLE
+    (void)output_sched_register(APP_OUTPUT_ELOG, app_output_elog, BOARD_OUTPUT_ELOG_DECIMATION);
+#endif
+    
+    /* Reported until the first valid sample */
+    app_regs_put_status(SENSOR_STATUS_WARMING_UP);
+    
+    /* Master may write the command registers only */
+    host_command_init();
+    i2c_slave_set_write_window(0, APP_REG_CMD_ARG, APP_REG_CMD_SIZE);
+#if BOARD_DAC_SETPOINT_ENABLE
+    /* And the DAC setpoint, applied from the RX interrupt in setpoint mode */
+    i2c_slave_set_write_window(1, APP_REG_DAC_SET_OUT1, APP_REG_DAC_SET_SIZE);
+#endif
+    
+    /* Every sample is kept for the master's next FIFO burst */
+    host_fifo_init();
+    i2c_slave_set_stream(APP_REG_FIFO, host_fifo_take_frame);
+    
+    /* Telemetry, refreshed by APP_JOB_PERF */
+    i2c_slave_set_stream(APP_REG_PERF, perf_bank_take);
+#if BOARD_DAC_WAVE_ENABLE
+    /* Waveform chunks, written at the same register (HOST_CMD_DAC_WAVE) */
+    (void)i2c_slave_set_sink(APP_REG_WAVE, wave_sink);
+#endif
+    
+#if BOARD_PROBE_ENABLE
+    /* Probe ring, frozen and resumed by HOST_CMD_PROBE */
+    i2c_slave_set_stream(APP_REG_PROBE, probe_dump);
+#endif
+#if BOARD_BENCH_ENABLE
+    /* Benchmark table, filled by HOST_CMD_BENCH (same register as the probe) */
+    i2c_slave_set_stream(APP_REG_BENCH, bench_take);
+#endif
+#if BOARD_FAULT_CAPTURE_ENABLE
+    /* What ended the previous boot, taken over by fault_init() */
+    i2c_slave_set_stream(APP_REG_FAULT, fault_take_frame);
+#endif
+    
+    /* Second address (BOARD_I2C1_SLAVE_ADDR2): the latest sample, no pointer write */
+    i2c_slave_set_alias(APP_REG_PRESSURE);
+    
+    /* Per-sample consumers share each drained block */
+    if (!app_sample_bus_init()) {
+        return false;
+    }
+    
+    /* Register I2C slave RX callback: raises the RX event */
+    i2c_slave_register_rx_callback(app_i2c_slave_rx_callback);
+    /* Read callback: clears the data-ready line */
+    i2c_slave_register_tx_callback(app_i2c_slave_tx_callback);
+    /* General call (BOARD_I2C1_GENERAL_CALL builds): synchronized sampling */
+    i2c_slave_register_gc_callback(app_i2c_slave_gc_callback);
+#if BOARD_UART_STREAM_ENABLE
+    uart_stream_register_rx_callback(app_uart_rx_callback);
+#endif
+    
+    /* Sampler wakes the main loop only when there is something to do */
+#if BOARD_SENSOR_MUX_CHANNELS != 0
+    sensor_array_register_event_callback(app_on_sensor_event);
+#else
+    sensor_sampling_register_event_callback(app_on_sensor_event);
+#endif
+    
+    /* DAC driver is initialized in main_init_drivers(): its calibration
+     * is loaded, fold it into the sensor mapping */
+    app_dac_map_update();
+    app_dac_output_resume();
+    
+#if BOARD_COMP_ALARM_ENABLE
+    /* COMP2 is initialized (disarmed) in main_init_drivers() */
+    app_alarm_update(true);
+#endif
+    
+#if BOARD_EEPROM_LOG_ENABLE
+    /* Ring head found in main_init_drivers(): record why we booted */
+#if BOARD_WARM_RESTART_ENABLE
+    (void)eeprom_log_append(APP_ELOG_BOOT, warm_restart_get_reset_flags(), 0U, 0U);
+#else
+    (void)eeprom_log_append(APP_ELOG_BOOT, RCC->CSR & 0xFF000000UL, 0U, 0U);
+    __HAL_RCC_CLEAR_RESET_FLAGS();
+#endif
+#endif
+    
+#if BOARD_FAULT_CAPTURE_ENABLE
+    app_fault_report();
+#endif
+    
+#if BOARD_POLL_ALIGN_ENABLE
+    /* Polls measured from now, the tick left alone until HOST_CMD_POLL_ALIGN */
+    poll_align_init();
+#endif
+    
+    app_initialized = true;
+    return true;
+}
+
+#if BOARD_LOG_PERIOD_S != 0
+/**
+ * @brief Start the sample of an RTC wakeup
+ * 
+ * The timebase was stopped since the last sample: move the timestamp on to
+ * the wakeup first, so logged samples keep wall-clock time.
+ */
+static void app_log_burst_start(void)
+{
+    uint32_t now_us;
+    
+    log_burst_us += BOARD_LOG_PERIOD_S * 1000000UL;
+    
+    /* Last sample still in progress (bring-up, bus recovery): its timebase
+     * kept counting, let it finish */
+    if (hal_tim2_is_running()) {
+        return;
+    }
+    
+    now_us = hal_tim2_get_timestamp_us();
+    if ((int32_t)(log_burst_us - now_us) > 0) {
+        (void)hal_tim2_advance_us(log_burst_us - now_us);
+    }
+    
+    if (sensor_sampling_start_single()) {
+        (void)hal_tim2_start();
+    }
+}
+#endif
+
+/* ============================================================================
+ * MAIN LOOP JOBS
+ * ============================================================================ */
+
+/**
+ * @brief Commands queued by the master (APP_EVENT_I2C_RX)
+ */
+static void app_job_commands(void)
+{
+    uint32_t count;
+#if BOARD_UART_STREAM_ENABLE
+    uint32_t uart_count = app_uart_commands();
+#endif
+    
+    /* Run queued commands in arrival order, then report the result */
+    count = host_command_dispatch();
+    if (count > 0) {
+        app_regs_publish();
+#if BOARD_WARM_RESTART_ENABLE
+        app_warm_save();  /* Settings a warm boot resumes with */
+#endif
+    }
+#if BOARD_UART_STREAM_ENABLE
+    /* The UART master has no registers to read it from */
+    if (uart_count > 0U) {
+        (void)uart_stream_send_result((uint8_t)host_command_get_last_result(),
+                                      (uint8_t)((count > UINT8_MAX) ? UINT8_MAX : count));
+    }
+#endif
+}
+
+#if BOARD_COMP_ALARM_ENABLE
+/**
+ * @brief Analog watchdog trip (APP_EVENT_ALARM)
+ */
+static void app_job_alarm(void)
+{
+    /* Latched in the interrupt; report it and raise the data-ready line */
+    app_regs_publish();
+    hal_intr_mcu_set(true);
+#if BOARD_EEPROM_LOG_ENABLE
+    (void)eeprom_log_append(APP_ELOG_ALARM, alarm_count, alarm_time_us, alarm_threshold_mv);
+#endif
+}
+#endif
+
+/**
+ * @brief New samples or a sampler status change (APP_EVENT_SENSOR)
+ */
+static void app_job_samples(void)
+{
+#if BOARD_SENSOR_MUX_CHANNELS == 0
+    /* Sensor still warming up: tell the master instead of sending stale data */
+    if (sensor_sampling_get_status() != SENSOR_STATUS_RUNNING) {
+        app_regs_put_status(sensor_sampling_get_status());
+    }
+#endif
+    
+    /* Attempt to read latest sensor data */
+    uint32_t new_samples = app_read_sensor(&latest_sensor_data);
+    if (new_samples > 0) {
+        /* Data is valid and ready */
+        
+        /* Overflow protection: Prevent reading_count from wrapping */
+        if (new_samples < READING_COUNT_MAX - reading_count) {
+            reading_count += new_samples;
+        } else {
+            reading_count = READING_COUNT_MAX;
+        }
+        /* else: Count has reached maximum, keep at max to prevent overflow */
+        
+        /* Overflow protection: Clamp sensor values to expected ranges */
+        int32_t pressure_clamped = latest_sensor_data.pressure;
+        int32_t temperature_clamped = latest_sensor_data.temperature;
+        output_sched_input_t output;
+        
+        if (pressure_clamped < PRESSURE_MIN_RAW) {
+            pressure_clamped = PRESSURE_MIN_RAW;
+        } else if (pressure_clamped > PRESSURE_MAX_RAW) {
+            pressure_clamped = PRESSURE_MAX_RAW;
+        }
+        
+        if (temperature_clamped < TEMPERATURE_MIN_RAW) {
+            temperature_clamped = TEMPERATURE_MIN_RAW;
+        } else if (temperature_clamped > TEMPERATURE_MAX_RAW) {
+            temperature_clamped = TEMPERATURE_MAX_RAW;
+        }
+        if (pressure_clamped != latest_sensor_data.pressure ||
+            temperature_clamped != latest_sensor_data.temperature) {
+            latest_sensor_data.quality |= SENSOR_QUALITY_CLAMPED;
+        }
+        
+        /* Values stay in sensor units (0.01 mbar, 0.01 degC) all the way to
+         * the DAC codes: no soft-float on the per-sample path */
+        
+        /* Store latest reading for other application modules */
+        /* This data can be used by I2C slave, DAC control, etc. */
+        
+        /* Boot report: the timebase started with sampling, at app_us */
+        if (boot_times.first_sample_us == 0U && boot_times.app_us != 0U) {
+            boot_times.first_sample_us = boot_times.app_us + hal_tim2_get_timestamp_us();
+        }
+        
+        /* Slave registers, DAC outputs and the EEPROM statistics, each at
+         * its own rate (output_sched.h); an event edge goes out now */
+        output.sample = &latest_sensor_data;
+        output.pressure = pressure_clamped;
+        output.temperature = temperature_clamped;
+        output.derived = derived_from_pressure(pressure_clamped);  /* One table lookup */
+        if (event_raised) {
+            output_sched_trigger(APP_OUTPUT_SLAVE);
+        }
+#if BOARD_BURST_ENABLE
+        /* A capture keeps the main loop to draining the sampler ring */
+        if (burst_get_state() != BURST_CAPTURING) {
+            output_sched_run(&output, new_samples);
+        }
+#else
+        output_sched_run(&output, new_samples);
+#endif
+        
+#if BOARD_IWDG_ENABLE
+        /* Sampler and main loop both made progress: the published sample
+         * is newer than the one of the last refresh */
+        if (latest_sensor_data.sequence != iwdg_sequence) {
+            iwdg_sequence = latest_sensor_data.sequence;
+            hal_iwdg_refresh();
+        }
+#endif
+    }
+    /* else: No new data available yet, sensor still reading or error occurred */
+    
+#if BOARD_BURST_ENABLE
+    /* Captured samples into the FIFO frames the master has emptied */
+    burst_poll();
+#endif
+    
+#if BOARD_LOG_PERIOD_S != 0
+    /* Sample published: nothing to tick until the next RTC wakeup, so the
+     * main loop may enter STOP */
+    if (sensor_sampling_is_idle() && hal_tim2_is_running()) {
+        (void)hal_tim2_stop();
+    }
+#endif
+}
+
+#if !BOARD_RTOS_ENABLE
+/**
+ * @brief Background work, periodic (the RTOS build runs it in a task of
+ *        its own)
+ */
+static void app_job_background(void)
+{
+    app_background_poll();
+}
+#endif
+
+/**
+ * @brief Stale sample check, periodic
+ * 
+ * A sampler that stops without an error raises no event: the newest
+ * sample is judged here against the stale limit. Stale, the slave reads
+ * SENSOR_STATUS_STALE and OUT1/OUT2 go to the stale code (outside a
+ * calibration); the next fresh sample puts both back.
+ */
+static void app_job_stale(void)
+{
+    bool stale = latest_sensor_data.valid && sensor_sampling_is_stale(&latest_sensor_data);
+    
+    if (stale == sample_stale) {
+        return;
+    }
+    sample_stale = stale;
+    if (!stale) {
+        return;  /* The fresh sample is out already */
+    }
+    
+    app_regs_put_status(SENSOR_STATUS_STALE);
+    if (dac_stale_code != BOARD_DAC_STALE_HOLD && dac_cal_step == APP_DAC_CAL_END && !dac_setpoint_active) {
+        app_dac_output(APP_DAC_FINE(dac_stale_code), APP_DAC_FINE(dac_stale_code));
+    }
+}
+
+/**
+ * @brief Performance bank refresh, periodic (perf_bank.h)
+ * 
+ * Rates over the time since the last refresh; the counters as they stand.
+ */
+static void app_job_perf(void)
+{
+    perf_bank_values_t values = {0};
+    uint32_t now_us = timebase_now_us();
+    uint32_t span_us = now_us - perf_last_us;
+    i2c_slave_stats_t slave;
+    sensor_error_stats_t errors;
+    sensor_tick_stats_t tick;
+    dac_playout_stats_t playout;
+#if BOARD_SELF_TEST_ENABLE
+    const self_test_report_t *caps;
+#endif
+#if BOARD_CLOCK_TRIM_ENABLE
+    clock_trim_status_t clock;
+#endif
+#if BOARD_SENSOR_VOTE_ENABLE
+    sensor_vote_health_t vote;
+#endif
+#if BOARD_ENERGY_ENABLE
+    energy_stats_t energy;
+#endif
+#if BOARD_CONV_TUNE_ENABLE
+    const conv_tune_report_t *conv;
+#endif
+#if BOARD_PERF_ENABLE
+    perf_stats_t perf;
+#endif
+#if BOARD_POLL_ALIGN_ENABLE
+    poll_align_status_t poll;
+#endif
+    
+    if (span_us == 0U) {
+        return;
+    }
+    
+    /* Carried a second at a time: span_us is about one job period */
+    perf_uptime_rem_us += span_us;
+    while (perf_uptime_rem_us >= 1000000UL) {
+        perf_uptime_rem_us -= 1000000UL;
+        perf_uptime_s++;
+    }
+    values.uptime_s = perf_uptime_s;
+    
+    values.samples = latest_sensor_data.sequence;
+    values.sample_rate_centihz =
+        (uint32_t)((uint64_t)(values.samples - perf_last_sequence) * 100000000ULL / span_us);
+    values.fifo_dropped = host_fifo_get_overflows();
+    values.ring_dropped = sensor_sampling_get_overruns();
+    values.fifo_high_water = host_fifo_get_high_water();
+    sensor_sampling_get_tick_stats(&tick);
+    values.tick_overruns = tick.overruns;
+    values.stack_peak = board_stack_poll();
+    if (i2c_slave_get_stats(&slave)) {
+        values.slave_errors = slave.errors;
+        values.slave_overruns = slave.overruns;
+        values.slave_load_centipct = slave.load_centipct;
+        values.slave_load_peak_centipct = slave.load_peak_centipct;
+        values.slave_throttles = slave.throttles;
+        values.slave_throttled_us = slave.throttled_us;
+    }
+    sensor_sampling_get_error_stats(&errors);
+    values.sensor_errors = errors.errors;
+    values.sensor_timeouts = errors.timeouts;
+    values.sensor_recoveries = errors.bus_recoveries;
+    dac_playout_get_stats(&playout);
+    values.dac_underruns = playout.underruns;
+    values.dac_overflows = playout.overflows;
+#if BOARD_ADC_SCAN_PERIOD_MS != 0
+    values.vdda_mv = (uint16_t)adc_scan_last.vdda_mv;
+    values.temp_centi = (int16_t)adc_scan_last.temp_centi;
+    values.supply_mv = (uint16_t)adc_scan_last.supply_mv;
+#endif
+#if BOARD_SELF_TEST_ENABLE
+    caps = self_test_get_report();
+    values.caps_present = caps->present;
+    values.caps_prom_ok = caps->prom_ok;
+    values.caps_speed[0] = caps->speed[0];
+    values.caps_speed[1] = caps->speed[1];
+    values.caps_word_us[0] = caps->word_us[0];
+    values.caps_word_us[1] = caps->word_us[1];
+    values.caps_compensate_ns = caps->compensate_ns;
+    values.caps_osr_levels = caps->osr_levels;
+    values.caps_flags = caps->flags;
+#endif
+#if BOARD_CLOCK_TRIM_ENABLE
+    clock_trim_poll();
+    clock_trim_get_status(&clock);
+    values.clock_error_ppb = clock.error_ppb;
+    values.clock_trim = clock.trim;
+    values.clock_source = clock.source;
+    values.clock_flags = clock.flags;
+    values.clock_trims = (clock.trims > UINT8_MAX) ? UINT8_MAX : (uint8_t)clock.trims;
+#endif
+#if BOARD_SENSOR_VOTE_ENABLE
+    sensor_vote_get_health(&vote);
+    values.vote_voted = vote.voted;
+    values.vote_agreed = vote.agreed;
+    values.vote_fused = vote.fused;
+    for (uint32_t i = 0; i < SENSOR_ARRAY_MAX_CHANNELS; i++) {
+        values.vote_outvoted[i] = vote.outvoted[i];
+    }
+#endif
+#if BOARD_ENERGY_ENABLE
+    energy_update();
+    energy_get_stats(&energy);
+    values.energy_run_ms = energy.run_ms;
+    values.energy_sleep_ms = energy.sleep_ms;
+    values.energy_stop_ms = energy.stop_ms;
+    values.energy_stops = energy.stops;
+    values.energy_bus_ms = energy.bus_ms;
+    values.energy_dac_ms = energy.dac_ms;
+    values.energy_current_deci_ua = energy.current_deci_ua;
+#endif
+#if BOARD_CONV_TUNE_ENABLE
+    conv = conv_tune_get_report();
+    for (uint32_t i = 0; i < PERF_BANK_CONV_LEVELS && i < CONV_TUNE_LEVELS; i++) {
+        values.conv_us[i] = conv->conv_us[i];
+    }
+    values.conv_measured = conv->measured;
+    values.conv_flags = conv->flags;
+#endif
+#if BOARD_POLL_ALIGN_ENABLE
+    poll_align_get_status(&poll);
+    values.poll_period_us = poll.period_us;
+    values.poll_error_us = poll.error_us;
+    values.poll_age_us = poll.age_us;
+    values.poll_shifts = poll.shifts;
+    values.poll_state = (uint8_t)poll.state;
+    values.poll_enabled = poll.enabled ? 1U : 0U;
+#endif
+    
+#if BOARD_PERF_ENABLE
+    perf_get_stats(&perf);
+    values.idle_centipct = (uint16_t)((uint64_t)(perf.idle_us - perf_last_idle_us) * 10000U / span_us);
+    if (values.idle_centipct > 10000U) {
+        values.idle_centipct = 10000U;
+    }
+    for (uint32_t i = 0; i < PERF_ISR_COUNT; i++) {
+        values.wcet_us[i] = perf.wcet_us[i];
+    }
+    values.wake_min_us = perf.wake_min_us;
+    values.wake_max_us = perf.wake_max_us;
+    values.wakes = perf.wakes;
+    perf_last_idle_us = perf.idle_us;
+#else
+    values.idle_centipct = PERF_BANK_IDLE_NONE;
+#endif
+    
+    perf_bank_publish(&values);
+    perf_last_us = now_us;
+    perf_last_sequence = values.samples;
+    
+#if BOARD_BENCH_ENABLE
+    bench_poll(now_us);
+#endif
+}
+
+/**
+ * @brief Periodic release due: back to the main loop (timebase interrupt)
+ */
+static void app_on_job_wake(void *context)
+{
+    (void)context;
+    event_flags_set(APP_EVENT_JOB);
+}
+
+/* Event handlers: each releases the job of its event */
+static void app_on_samples_flag(void)
+{
+    job_sched_release(APP_JOB_SAMPLES);
+}
+
+static void app_on_commands_flag(void)
+{
+    job_sched_release(APP_JOB_COMMANDS);
+}
+
+#if BOARD_COMP_ALARM_ENABLE
+static void app_on_alarm_flag(void)
+{
+    job_sched_release(APP_JOB_ALARM);
+}
+#endif
+
+#if BOARD_LOG_PERIOD_S != 0
+static void app_on_log_flag(void)
+{
+    job_sched_release(APP_JOB_LOG);
+}
+#endif
+
+/**
+ * @brief Put the main loop work in the job scheduler, behind the event
+ *        flags that release it
+ */
+static bool app_jobs_init(void)
+{
+    static const job_sched_desc_t jobs[APP_JOBS] = {
+        [APP_JOB_SAMPLES] = { app_job_samples, 0U, BOARD_JOB_SAMPLE_DEADLINE_US },
+        [APP_JOB_COMMANDS] = { app_job_commands, 0U, BOARD_JOB_COMMAND_DEADLINE_US },
+#if BOARD_COMP_ALARM_ENABLE
+        [APP_JOB_ALARM] = { app_job_alarm, 0U, BOARD_JOB_ALARM_DEADLINE_US },
+#endif
+#if BOARD_LOG_PERIOD_S != 0
+        [APP_JOB_LOG] = { app_log_burst_start, 0U, BOARD_JOB_LOG_DEADLINE_US },
+#endif
+#if !BOARD_RTOS_ENABLE
+        [APP_JOB_BACKGROUND] = { app_job_background, BOARD_JOB_BACKGROUND_PERIOD_US,
+                                 BOARD_JOB_BACKGROUND_PERIOD_US },
+#endif
+        [APP_JOB_PERF] = { app_job_perf, BOARD_PERF_PERIOD_US, BOARD_PERF_PERIOD_US },
+        [APP_JOB_STALE] = { app_job_stale, BOARD_JOB_STALE_PERIOD_US, BOARD_JOB_STALE_PERIOD_US },
+    };
+    
+    for (uint8_t i = 0; i < APP_JOBS; i++) {
+        if (!job_sched_register(i, (jobs[i].run != NULL) ? &jobs[i] : NULL)) {
+            return false;
+        }
+    }
+    
+    /* APP_EVENT_JOB has no handler: it only wakes the loop */
+    (void)event_flags_register(APP_EVENT_SENSOR, app_on_samples_flag);
+    (void)event_flags_register(APP_EVENT_I2C_RX, app_on_commands_flag);
+#if BOARD_COMP_ALARM_ENABLE
+    (void)event_flags_register(APP_EVENT_ALARM, app_on_alarm_flag);
+#endif
+#if BOARD_LOG_PERIOD_S != 0
+    (void)event_flags_register(APP_EVENT_LOG, app_on_log_flag);
+#endif
+    return true;
+}
+
+void app_main_loop(void)
+{
+    /* Main application loop - most work is done in interrupt handlers */
+    /* This function can be used for non-critical tasks, logging, etc. */
+    uint32_t wake_us;
+    
+    if (!app_initialized) {
+        return;
+    }
+    
+    /* Only the handlers of the flags raised since the last pass: each
+     * releases its job. A periodic release the scheduler sees by itself */
+    (void)event_flags_dispatch();
+    
+    /* Earliest deadline first, each to completion */
+    (void)job_sched_run();
+    
+    /* Sleep no further than the next periodic release */
+    if (job_sched_next_release(&wake_us)) {
+        (void)timebase_deadline_at(&job_wake, wake_us, app_on_job_wake, NULL);
+    }
+}
+
+/* ============================================================================
+ * HELPER FUNCTIONS
  * ============================================================================ */
 
+bool app_set_stale(uint16_t limit_ms, uint16_t dac_code)
+{
+    if (dac_code != BOARD_DAC_STALE_HOLD && dac_code > BOARD_DAC_MAX_CODE) {
+        return false;
+    }
+    
+    dac_stale_code = dac_code;
+    sensor_sampling_set_stale_limit_ms(limit_ms);
+    return true;
+}
+
+bool app_set_dac_pressure_span(uint32_t span_mbar)
+{
+    app_dac_map_t maps[APP_DAC_OUTPUTS];
+    
+    if (span_mbar > APP_DAC_PRESSURE_SPAN_MAX) {
+        return false;
+    }
+    
+    /* Checked for every output before any is changed */
+    for (uint32_t ch = 0; ch < APP_DAC_OUTPUTS; ch++) {
+        maps[ch] = dac_maps[ch];
+        if (maps[ch].source == APP_DAC_SOURCE_PRESSURE) {
+            maps[ch].in_max = (span_mbar == 0U) ? dac_map_defaults[ch].in_max :
+                                                  (int32_t)(span_mbar * 100U);
+            if (maps[ch].in_max <= maps[ch].in_min) {
+                return false;
+            }
+        }
+    }
+    
+    for (uint32_t ch = 0; ch < APP_DAC_OUTPUTS; ch++) {
+        dac_maps[ch] = maps[ch];
+    }
+    app_dac_map_update();
+    return true;
+}
+
+bool app_set_dac_map(dac_channel_t channel, const app_dac_map_t *map)
+{
+    if (map == NULL || (uint32_t)channel >= APP_DAC_OUTPUTS ||
+        (uint32_t)map->source >= APP_DAC_SOURCES ||
+        (map->clamp != APP_DAC_CLAMP_INPUT && map->clamp != APP_DAC_CLAMP_RAILS) ||
+        map->in_max <= map->in_min ||
+        map->code_min > BOARD_DAC_MAX_CODE || map->code_max > BOARD_DAC_MAX_CODE) {
+        return false;
+    }
+    
+    dac_maps[channel] = *map;
+    app_dac_map_update();
+    return true;
+}
+
+bool app_get_dac_map(dac_channel_t channel, app_dac_map_t *map)
+{
+    if (map == NULL || (uint32_t)channel >= APP_DAC_OUTPUTS) {
+        return false;
+    }
+    
+    *map = dac_maps[channel];
+    return true;
+}
+
+bool app_save_config(uint8_t slave_addr)
+{
+    config_block_t config;
+    
+    app_config_capture(&config, slave_addr);
+    return config_save(&config);
+}
+
+bool app_set_event(uint32_t argument)
+{
+    uint8_t detector = (uint8_t)(argument >> 28);
+    uint8_t field = (uint8_t)((argument >> 24) & 0x0FU);
+    int32_t value = (int32_t)(argument << 8) >> 8;  /* Signed 24-bit */
+    event_detector_config_t config;
+    
+    if (!event_detect_get_config(detector, &config)) {
+        return false;
+    }
+    
+    switch (field) {
+    case 0:
+        config.condition = (event_condition_t)(argument & 0xFFU);
+        config.source = (event_source_t)((argument >> 8) & 0xFFU);
+        config.debounce = (uint8_t)(argument >> 16);
+        break;
+    case 1:
+        config.low = value;
+        break;
+    case 2:
+        config.high = value;
+        break;
+    case 3:
+        config.hysteresis = value;
+        break;
+    default:
+        return false;
+    }
+    return event_detect_configure(detector, &config);
+}
+
+bool app_set_pressure_unit(app_pressure_unit_t unit)
+{
+    if ((uint32_t)unit >= APP_UNITS) {
+        return false;
+    }
+    
+    pressure_unit = unit;
+    return true;
+}
+
+bool app_set_output_rate(uint32_t argument)
+{
+    uint32_t output = argument >> 24;
+    
+    if (output >= APP_OUTPUTS || (argument & 0x00FF0000UL) != 0U) {
+        return false;
+    }
+    return output_sched_set_decimation((uint8_t)output, argument & 0xFFFFU);
+}
+
+bool app_set_derived(uint32_t argument)
+{
+    int32_t reference = (int32_t)(argument & DERIVED_REFERENCE_MAX);
+    
+    if ((argument >> 28) != 0U) {
+        return false;
+    }
+    if (reference == 0) {
+        if (!latest_sensor_data.valid) {
+            return false;
+        }
+        reference = latest_sensor_data.pressure;
+    }
+    return derived_set((derived_quantity_t)((argument >> 24) & 0x0FU), reference);
+}
+
+bool app_dac_calibrate(uint32_t argument)
+{
+    uint8_t step = (uint8_t)(argument & 0xFF);
+    uint8_t channel = (uint8_t)((argument >> 8) & 0x1);
+    uint32_t mv = argument >> 16;
+    uint8_t point;
+    
+    switch (step) {
+    case APP_DAC_CAL_END:
+        if (dac_cal_step != APP_DAC_CAL_END) {
+            dac_cal_step = APP_DAC_CAL_END;
+            app_dac_output_resume();
+        }
+        return true;
+    
+    case APP_DAC_CAL_DRIVE_LOW:
+    case APP_DAC_CAL_DRIVE_HIGH:
+        /* Raw codes: the measurement is of the uncalibrated transfer */
+        dac_stream_stop();
+        dac_cal_step = step;
+        if (step == APP_DAC_CAL_DRIVE_LOW) {
+            dac_cal_measured = 0;
+            return dac_set_dual(APP_DAC_CAL_CODE_LOW, APP_DAC_CAL_CODE_LOW);
+        }
+        return dac_set_dual(APP_DAC_CAL_CODE_HIGH, APP_DAC_CAL_CODE_HIGH);
+    
+    case APP_DAC_CAL_MEASURED:
+        if (dac_cal_step != APP_DAC_CAL_DRIVE_LOW && dac_cal_step != APP_DAC_CAL_DRIVE_HIGH) {
+            return false;
+        }
+        point = (dac_cal_step == APP_DAC_CAL_DRIVE_HIGH) ? 1U : 0U;
+        dac_cal_mv[channel][point] = mv;
+        dac_cal_measured |= (uint8_t)(1U << (2U * channel + point));
+        return true;
+    
+    case APP_DAC_CAL_SAVE:
+        /* Both points of the channel recorded in this sequence */
+        if (dac_cal_step == APP_DAC_CAL_END ||
+            ((dac_cal_measured >> (2U * channel)) & 0x3U) != 0x3U ||
+            !dac_calibrate_from_points((dac_channel_t)channel,
+                                       APP_DAC_CAL_CODE_LOW, dac_cal_mv[channel][0],
+                                       APP_DAC_CAL_CODE_HIGH, dac_cal_mv[channel][1])) {
+            return false;
+        }
+        app_dac_map_update();
+        return dac_calibration_save();
+    
+    case APP_DAC_CAL_RESET: {
+        const dac_calibration_t unity = { DAC_CAL_GAIN_UNITY, 0 };
+        
+        (void)dac_set_calibration((dac_channel_t)channel, &unity);
+        app_dac_map_update();
+        return dac_calibration_save();
+    }
+    
+    default:
+        return false;
+    }
+}
+
+bool app_dac_stimulus(uint32_t rate_hz)
+{
+    dac_stream_stop();
+    if (rate_hz == 0U) {
+        app_dac_output_resume();
+        return true;
+    }
+    
+    /* Stream stopped: the refill state is not in use */
+    stimulus_code = 0;
+    stimulus_rising = true;
+    return dac_stream_start(rate_hz, app_dac_stimulus_refill);
+}
+
+bool app_set_dac_setpoint(uint32_t argument)
+{
+#if BOARD_DAC_SETPOINT_ENABLE
+    if (argument > 1U || dac_cal_step != APP_DAC_CAL_END) {
+        return false;
+    }
+    
+    /* The RX interrupt writes the data register: nothing may stream */
+    dac_stream_stop();
+    dac_setpoint_active = (argument == 1U);
+    if (!dac_setpoint_active) {
+        app_dac_output_resume();
+    }
+    return true;
+#else
+    (void)argument;
+    return false;
+#endif
+}
+
+bool app_dac_wave(uint32_t argument)
+{
+#if BOARD_DAC_WAVE_ENABLE
+    bool playing = dac_stream_get_refill() == app_dac_wave_refill;
+    uint32_t rate_hz = argument & 0xFFFFFFUL;
+    
+    switch ((app_dac_wave_op_t)(argument >> 24)) {
+    case APP_DAC_WAVE_ABORT:
+        wave_abort();
+        return true;
+    case APP_DAC_WAVE_BEGIN:
+        return wave_begin(argument & 0xFFFFU, playing);
+    case APP_DAC_WAVE_COMMIT:
+        return wave_commit((uint16_t)argument, playing);
+    case APP_DAC_WAVE_PLAY:
+        if (rate_hz == 0U) {
+            if (playing) {
+                dac_stream_stop();
+                app_dac_output_resume();
+            }
+            return true;
+        }
+        if (dac_setpoint_active || dac_cal_step != APP_DAC_CAL_END) {
+            return false;
+        }
+        /* Stream stopped first: the player state is not in use */
+        dac_stream_stop();
+        if (!wave_rewind() || !dac_stream_start(rate_hz, app_dac_wave_refill)) {
+            app_dac_output_resume();
+            return false;
+        }
+        return true;
+    default:
+        return false;
+    }
+#else
+    (void)argument;
+    return false;
+#endif
+}
+
+bool app_set_poll_align(uint32_t argument)
+{
+#if BOARD_POLL_ALIGN_ENABLE
+    if (argument > 1U) {
+        return false;
+    }
+    poll_align_enable(argument == 1U);
+    return true;
+#else
+    (void)argument;
+    return false;
+#endif
+}
+
+bool app_set_alarm(uint32_t threshold_mv)
+{
+#if BOARD_COMP_ALARM_ENABLE
+    if (threshold_mv > BOARD_DAC_VREF_MV) {
+        return false;
+    }
+    
+    alarm_threshold_mv = threshold_mv;
+    app_alarm_update(true);
+    app_regs_publish();
+    return true;
+#else
+    (void)threshold_mv;
+    return false;
+#endif
+}
+
+bool app_set_prof_site(uint32_t argument)
+{
+#if BOARD_PROF_ENABLE
+    uint32_t site = argument & 0xFFU;
+    
+    if (site >= PROF_SITE_COUNT) {
+        return false;
+    }
+    
+    if ((argument & 0x100U) != 0U) {
+        prof_reset();
+    }
+    prof_site = (prof_site_t)site;
+    app_regs_publish();
+    return true;
+#else
+    (void)argument;
+    return false;
+#endif
+}
+
+bool app_set_latency_view(uint32_t argument)
+{
+#if BOARD_LATENCY_ENABLE
+    uint32_t stage = argument & 0xFFU;
+    uint32_t bucket = (argument >> 8) & 0xFFU;
+    
+    if (stage >= LATENCY_STAGES || bucket >= LATENCY_BUCKETS) {
+        return false;
+    }
+    
+    if ((argument & 0x10000UL) != 0U) {
+        latency_reset();
+        sensor_sampling_reset_jitter();
+    }
+    latency_stage = (latency_stage_t)stage;
+    latency_bucket = (uint8_t)bucket;
+    app_regs_publish();
+    return true;
+#else
+    (void)argument;
+    return false;
+#endif
+}
+
+bool app_show_event(uint32_t seq)
+{
+#if BOARD_EEPROM_LOG_ENABLE
+    eeprom_log_record_t record;
+    
+    if (seq == 0U) {
+        seq = eeprom_log_get_newest();
+    }
+    if (!eeprom_log_read(seq, &record)) {
+        return false;
+    }
+    elog_shown = record;
+    app_regs_publish();
+    return true;
+#else
+    (void)seq;
+    return false;
+#endif
+}
+
+void app_set_boot_times(const app_boot_times_t *times)
+{
+    if (times == NULL) {
+        return;
+    }
+    
+    boot_times.board_us = times->board_us;
+    boot_times.drivers_us = times->drivers_us;
+    boot_times.app_us = times->app_us;
+    app_regs_publish();
+}
+
+void app_log_wakeup_isr(void)
+{
+#if BOARD_LOG_PERIOD_S != 0
+    event_flags_set(APP_EVENT_LOG);
+#endif
+}
+
+void app_alarm_isr(void)
+{
+#if BOARD_COMP_ALARM_ENABLE
+    /* No hysteresis: one interrupt per crossing, re-armed by the master */
+    hal_comp_alarm_disarm();
+    alarm_time_us = hal_tim2_get_timestamp_us();
+    alarm_count++;
+    alarm_tripped = true;
+    event_flags_set(APP_EVENT_ALARM);
+#endif
+}
+
+void app_power_fail_isr(void)
+{
+#if BOARD_PVD_SAVE_ENABLE
+    uint32_t words[FLASH_LOG_SNAPSHOT_WORDS] = {0};
+    uint32_t edge_us = hal_tim2_get_timestamp_us();
+    i2c_slave_stats_t slave;
+#if BOARD_SENSOR_MUX_CHANNELS == 0
+    sensor_error_stats_t sampler;
+#endif
+    
+    (void)flash_log_emergency_flush(BOARD_PVD_SAVE_HALVES);
+    words[0] = edge_us;
+    words[1] = hal_tim2_get_timestamp_us() - edge_us;
+    
+    /* As of the last main loop pass */
+    words[2] = latest_sensor_data.sequence;
+    words[3] = (uint32_t)latest_sensor_data.pressure;
+    words[4] = (uint32_t)latest_sensor_data.temperature;
+#if BOARD_EEPROM_LOG_ENABLE
+    if (elog_count != 0U) {
+        words[5] = (uint32_t)elog_min;
+        words[6] = (uint32_t)elog_max;
+        words[7] = (uint32_t)(int32_t)(elog_sum / (int64_t)elog_count);
+        words[8] = elog_count;
+    }
+#endif
+#if BOARD_SENSOR_MUX_CHANNELS == 0
+    sensor_sampling_get_error_stats(&sampler);
+    words[9] = sampler.errors;
+    words[10] = sampler.timeouts;
+#endif
+    if (i2c_slave_get_stats(&slave)) {
+        words[11] = slave.errors;
+    }
+    (void)flash_log_emergency_snapshot(words);
+#endif
+}
+
+bool app_events_pending(void)
+{
+    return event_flags_pending();
+}
+
+void app_background_poll(void)
+{
+    if (!app_initialized) {
+        return;
+    }
+    
+#if BOARD_ADC_SCAN_PERIOD_MS != 0
+    /* DAC scale follows the measured VDDA, pins checked against the codes */
+    app_adc_poll();
+#endif
+    
+#if BOARD_SENSOR_MUX_CHANNELS == 0
+    /* Sampler background work (calibration cache write after bring-up) */
+    sensor_sampling_poll();
+#endif
+    
+#if BOARD_EEPROM_LOG_ENABLE
+    /* Next word of a queued record (one EEPROM write per pass) */
+    eeprom_log_poll();
+#endif
+    
+#if BOARD_FW_UPDATE_ENABLE
+    /* Erase or program of the page of the image due (one per pass) */
+    fw_update_poll();
+#endif
+    
+#if BOARD_POLL_ALIGN_ENABLE
+    /* Master polls since the last pass, and the tick moved towards them */
+    poll_align_poll();
+#endif
+}
+
 uint32_t app_get_reading_count(void)
 {
     return reading_count;
@@ -234,6 +2803,10 @@ bool app_get_latest_sensor_data(sensor_data_t *data)
     }
     
     /* Get data directly from sensor sampling module */
+#if BOARD_SENSOR_MUX_CHANNELS != 0
+    return app_read_sensor(data) > 0;
+#else
     return sensor_sampling_get_data(data);
+#endif
 }
 
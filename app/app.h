@@ -11,12 +11,211 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "board_config.h"
 #include "sensor_sampling.h"  /* For sensor_data_t type */
+#include "dac.h"              /* For dac_channel_t type */
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* ============================================================================
+ * I2C SLAVE REGISTER MAP
+ * ============================================================================ */
+
+/* Byte offsets in the I2C slave register image; multi-byte fields are
+ * little-endian. A read from 0x00 of 4 bytes is the legacy 32-bit value */
+#define APP_REG_PRESSURE      0x00U  /* int32, 0.01 mbar (0x80000000 while warming up) */
+#define APP_REG_TEMPERATURE   0x04U  /* int32, 0.01 degC */
+#define APP_REG_TIMESTAMP     0x08U  /* uint32, us timestamp of the sample */
+#define APP_REG_SEQUENCE      0x0CU  /* uint32, sample sequence number */
+#define APP_REG_STATUS        0x10U  /* uint8, sensor_status_t */
+#define APP_REG_FIFO_LEVEL    0x11U  /* uint8, samples waiting for the next FIFO burst */
+#define APP_REG_CMD_STATUS    0x12U  /* uint8, host_command_result_t of the last command */
+#define APP_REG_ALARM         0x13U  /* uint8, APP_ALARM_* flags (0 if not built) */
+#define APP_REG_FIFO_OVERFLOWS 0x14U /* uint32, samples dropped on a full FIFO */
+#define APP_REG_DAC_FAULT     0x18U  /* uint8, bit n = DAC output n fails readback (dac_channel_t) */
+#define APP_REG_BURST_STATE   0x19U  /* uint8, burst_state_t (0 if not built) */
+#define APP_REG_BURST_COUNT   0x1AU  /* uint16, samples in the capture ring, or left to drain */
+#define APP_REG_DAC_READBACK  0x1CU  /* uint16 x2, last readback of OUT1, OUT2 (raw ADC codes) */
+#define APP_REG_CMD_ARG       0x20U  /* uint32, command argument (written by the master) */
+#define APP_REG_CMD_OPCODE    0x24U  /* uint8, command opcode: writing it queues the command */
+#if BOARD_CRC_FRAMING_ENABLE
+/* With CRC framing the command ends in a check instead: writing its last
+ * byte queues the command, run only if the CRC matches */
+#define APP_REG_CMD_CRC       0x25U  /* uint16, CRC-16 (crc.h) of the 5 bytes at APP_REG_CMD_ARG */
+#define APP_REG_CMD_SIZE      7U     /* Master-writable bytes at APP_REG_CMD_ARG */
+#else
+#define APP_REG_CMD_SIZE      5U     /* Master-writable bytes at APP_REG_CMD_ARG */
+#endif
+#define APP_REG_SYNC_STATE    0x27U  /* uint8, time_sync_state_t (0x08 and FIFO timestamps in master time unless 0) */
+#define APP_REG_EVENT_ACTIVE  0x28U  /* uint8, bit n = event detector n active (event_detect.h) */
+#define APP_REG_EVENT_PENDING 0x29U  /* uint8, event records waiting */
+#define APP_REG_EVENT_OLDEST  0x2AU  /* uint8, oldest record: [3:0] detector, bit 7 entered */
+#define APP_REG_EVENT_DROPPED 0x2BU  /* uint8, records lost on a full queue (saturated) */
+#define APP_REG_EVENT_SEQ     0x2CU  /* uint32, sample sequence number of the oldest record */
+#define APP_REG_FIFO          0x30U  /* Stream: FIFO burst (host_fifo.h) */
+#define APP_REG_PERF          0x31U  /* Stream: performance counter bank (perf_bank.h) */
+#define APP_REG_WAVE          0x31U  /* Sink: waveform table chunks (wave.h), written; BOARD_DAC_WAVE_ENABLE only */
+#define APP_REG_PROBE         0x32U  /* Stream: probe ring (probe.h), BOARD_PROBE_ENABLE only */
+#define APP_REG_BENCH         0x32U  /* Stream: benchmark table (bench.h), BOARD_BENCH_ENABLE only */
+#define APP_REG_FAULT         0x33U  /* Stream: fault record of the previous boot (fault.h) */
+/* Latency window (latency.h), stage and bucket selected by HOST_CMD_LATENCY;
+ * read from 0x34 (reads from 0x30 to 0x33 are streams); 0 if not built */
+#define APP_REG_LAT_STAGE     0x34U  /* uint8, latency_stage_t shown */
+#define APP_REG_LAT_BUCKET    0x35U  /* uint8, bucket shown */
+#define APP_REG_LAT_P50       0x36U  /* uint8, bucket of the stage's median */
+#define APP_REG_LAT_P99       0x37U  /* uint8, bucket of its 99th percentile */
+#define APP_REG_LAT_COUNT     0x38U  /* uint32, samples in the bucket shown */
+#define APP_REG_LAT_TOTAL     0x3CU  /* uint32, samples through the stage */
+/* I2C slave statistics (i2c_slave_stats_t order), uint32 each */
+#define APP_REG_I2C_READS     0x40U
+#define APP_REG_I2C_WRITES    0x44U
+#define APP_REG_I2C_NACKS     0x48U
+#define APP_REG_I2C_ERRORS    0x4CU
+#define APP_REG_I2C_OVERRUNS  0x50U
+#define APP_REG_I2C_REARMS    0x54U
+#define APP_REG_I2C_LAT_MIN   0x58U  /* us, address match to end of transaction */
+#define APP_REG_I2C_LAT_MAX   0x5CU
+#define APP_REG_I2C_LAT_MEAN  0x60U
+#define APP_REG_ALARM_COUNT   0x64U  /* uint32, analog watchdog trips */
+#define APP_REG_ALARM_TIME    0x68U  /* uint32, us timestamp of the last trip */
+/* Profiling window (prof.h), site selected by HOST_CMD_PROF; 0 if not built */
+#define APP_REG_PROF_SITE     0x6CU  /* uint8, prof_site_t shown below */
+/* Sensor bus speeds (bus_tune.h): [1:0] hal_i2c_speed_t, [6] lowered after
+ * bus errors, [7] tuned; 0 if not built */
+#define APP_REG_I2C2_SPEED    0x6DU
+#define APP_REG_I2C3_SPEED    0x6EU
+#define APP_REG_I2C_RESETS    0x6FU  /* uint8, slave bus resets after an SCL-low timeout (saturated) */
+#define APP_REG_PROF_COUNT    0x70U  /* uint32, passes */
+#define APP_REG_PROF_MIN      0x74U  /* uint32, SYSCLK cycles */
+#define APP_REG_PROF_MAX      0x78U
+#define APP_REG_PROF_MEAN     0x7CU
+/* Boot report, us since the clock was configured (app_boot_times_t order) */
+#define APP_REG_BOOT_BOARD    0x80U  /* board_init() done */
+#define APP_REG_BOOT_DRIVERS  0x84U  /* Peripherals and drivers initialized */
+#define APP_REG_BOOT_APP      0x88U  /* Application initialized, sampling started */
+#define APP_REG_BOOT_SAMPLE   0x8CU  /* First valid sample published (0 until then) */
+/* Sampling tick deadline (sensor_tick_stats_t) */
+#define APP_REG_TICK_OVERRUNS 0x90U  /* uint32, ticks still running when the next was due */
+#define APP_REG_TICK_MAX      0x94U  /* uint32, us, longest tick handler */
+#define APP_REG_TICK_MAX_STATE 0x98U /* uint8, sampler state of that tick */
+/* Sampling cadence (sensor_jitter_stats_t) */
+#define APP_REG_JITTER_PEAK   0x99U  /* uint8, us, largest |interval - mean| (saturated) */
+#define APP_REG_JITTER_STDDEV 0x9AU  /* uint16, 0.1 us, running interval deviation (saturated) */
+#define APP_REG_TICK_PERIOD   0x9CU  /* uint32, us, current tick period (the deadline) */
+/* Stack high-water mark (board_stack_poll()) */
+#define APP_REG_STACK_PEAK    0xA0U  /* uint32, bytes, deepest stack use seen */
+#define APP_REG_STACK_FREE    0xA4U  /* uint32, bytes, painted stack never touched */
+/* EEPROM record ring (eeprom_log.h): the record picked by HOST_CMD_EVENT_LOG */
+#define APP_REG_ELOG_NEWEST   0xA8U  /* uint32, sequence number of the newest record (0 = none) */
+#define APP_REG_ELOG_SEQ      0xACU  /* uint32, sequence number of the record shown (0 = none) */
+#define APP_REG_ELOG_TYPE     0xB0U  /* uint8, APP_ELOG_* */
+/* Quality of the sample at APP_REG_PRESSURE (sensor_data_t) */
+#define APP_REG_QUALITY       0xB1U  /* uint8, SENSOR_QUALITY_* */
+#define APP_REG_ERROR_COUNT   0xB2U  /* uint16, aborted cycles since boot (wraps) */
+#define APP_REG_ELOG_DATA     0xB4U  /* uint32 x3, per APP_ELOG_* */
+/* Summary statistics of the last completed window (sample_stats.h) */
+#define APP_REG_STATS_WINDOW  0xC0U  /* uint32, samples per window (0 = off) */
+#define APP_REG_STATS_SEQ     0xC4U  /* uint32, windows completed (0 = none yet) */
+#define APP_REG_STATS_END     0xC8U  /* uint32, us timestamp of the window's last sample */
+#define APP_REG_STATS_P_MIN   0xCCU  /* int32, 0.01 mbar */
+#define APP_REG_STATS_P_MAX   0xD0U
+#define APP_REG_STATS_P_MEAN  0xD4U
+#define APP_REG_STATS_P_VAR   0xD8U  /* uint32, (0.01 mbar)^2, saturated */
+#define APP_REG_STATS_T_MIN   0xDCU  /* int32, 0.01 degC */
+#define APP_REG_STATS_T_MAX   0xE0U
+#define APP_REG_STATS_T_MEAN  0xE4U
+#define APP_REG_STATS_T_VAR   0xE8U  /* uint32, (0.01 degC)^2, saturated */
+#define APP_REG_DERIVED       0xECU  /* int32, mm over the reference (derived.h) */
+#define APP_REG_TRACK_PRESSURE 0xF0U /* int32, 0.01 mbar, alpha-beta tracked (tracker.h) */
+#define APP_REG_TRACK_RATE    0xF4U  /* int32, 0.01 Pa/s */
+#define APP_REG_PRESSURE_UNIT 0xF8U  /* int32, pressure in the app_pressure_unit_t selected */
+/* Bytes 0x00.. published by the application in one update; the driver keeps
+ * the master-written command bytes inside it */
+#define APP_REG_BLOCK_SIZE    0xFCU
+/* Master DAC setpoint (BOARD_DAC_SETPOINT_ENABLE, HOST_CMD_DAC_SETPOINT 1),
+ * written by the master and read back as written */
+#define APP_REG_DAC_SET_OUT1  0xFCU  /* uint16, OUT1 code */
+#define APP_REG_DAC_SET_OUT2  0xFEU  /* uint16, OUT2 code; a write reaching 0xFF applies both */
+#define APP_REG_DAC_SET_SIZE  4U
+
+/* APP_REG_ALARM flags */
+#define APP_ALARM_ARMED       0x01U  /* Threshold set */
+#define APP_ALARM_TRIPPED     0x02U  /* Crossed since armed (latched) */
+#define APP_ALARM_ABOVE       0x04U  /* Input above the threshold now */
+
+/* EEPROM record types (APP_REG_ELOG_TYPE) and their data words */
+#define APP_ELOG_BOOT         1U  /* RCC_CSR reset flags [31:24], -, - */
+#define APP_ELOG_STATS        2U  /* Pressure min, max, mean over the window (int32, 0.01 mbar) */
+#define APP_ELOG_ERRORS       3U  /* Sampler errors, sampler timeouts, I2C slave bus errors (since boot) */
+#define APP_ELOG_ALARM        4U  /* Trip count, trip timestamp (us), threshold (mV) */
+#define APP_ELOG_FAULT        5U  /* Fault before this boot: pc (error code), lr (caller),
+                                   * [31:24] kind, [23:16] sampler state, [5:0] exception number */
+
+/* ============================================================================
+ * TYPES
+ * ============================================================================ */
+
+/**
+ * @brief Sensor quantity driving a DAC output
+ */
+typedef enum {
+    APP_DAC_SOURCE_PRESSURE = 0,     /* 0.01 mbar */
+    APP_DAC_SOURCE_TEMPERATURE = 1,  /* 0.01 degC */
+    APP_DAC_SOURCE_DERIVED = 2,      /* mm, depth or altitude (derived.h) */
+    APP_DAC_SOURCES
+} app_dac_source_t;
+
+/**
+ * @brief Unit of APP_REG_PRESSURE_UNIT (HOST_CMD_PRESSURE_UNIT)
+ * 
+ * Converted from the canonical 0.01 mbar (= Pa) only while selected, with
+ * one Q16 multiply per update.
+ */
+typedef enum {
+    APP_UNIT_OFF = 0,   /* Not converted, reads 0 */
+    APP_UNIT_PA,        /* Pa */
+    APP_UNIT_PSI_E4,    /* 0.0001 psi */
+    APP_UNIT_INHG_E3,   /* 0.001 inHg */
+    APP_UNIT_MMHG_E3,   /* 0.001 mmHg (Torr) */
+    APP_UNITS
+} app_pressure_unit_t;
+
+/**
+ * @brief Consumer of the newest sample, one scheduler slot each
+ *        (HOST_CMD_OUTPUT_RATE)
+ */
+typedef enum {
+    APP_OUTPUT_SLAVE = 0,  /* Sample registers and INTR_MCU */
+    APP_OUTPUT_DAC,        /* DAC mappings */
+    APP_OUTPUT_ELOG,       /* EEPROM statistics record (EEPROM log builds) */
+    APP_OUTPUTS
+} app_output_t;
+
+/**
+ * @brief Behaviour outside the input range of a mapping
+ */
+typedef enum {
+    APP_DAC_CLAMP_INPUT = 0,  /* Hold the code of the nearest range end */
+    APP_DAC_CLAMP_RAILS = 1   /* Keep the slope up to the DAC rails */
+} app_dac_clamp_t;
+
+/**
+ * @brief Mapping of one DAC output: in_min..in_max to code_min..code_max
+ * 
+ * Codes are of the ideal transfer; the channel calibration is applied on
+ * top. Defaults: BOARD_DAC_OUT1_MAP, BOARD_DAC_OUT2_MAP.
+ */
+typedef struct {
+    app_dac_source_t source;
+    int32_t in_min;     /* Sensor units */
+    int32_t in_max;     /* Above in_min */
+    uint16_t code_min;  /* Code at in_min (0..BOARD_DAC_MAX_CODE) */
+    uint16_t code_max;  /* Code at in_max; below code_min inverts the output */
+    app_dac_clamp_t clamp;
+} app_dac_map_t;
+
 /**
  * @brief Initialize application layer
  * 
@@ -32,10 +231,326 @@ bool app_init(void);
  * 
  * This function is called from the main loop to process application logic.
  * Most work is done in interrupt handlers, but this can handle non-critical
- * tasks and coordination.
+ * tasks and coordination. Only the work flagged by events (new sample,
+ * sampler status, I2C slave RX) is done; a wakeup without events returns
+ * at once.
  */
 void app_main_loop(void);
 
+/**
+ * @brief Check whether app_main_loop() has work pending
+ * 
+ * Call with interrupts masked right before sleeping: an event raised after
+ * the check still wakes the following WFI.
+ * 
+ * @return true if an event was raised since the last app_main_loop()
+ */
+bool app_events_pending(void);
+
+/**
+ * @brief Slow background work (ADC scan, calibration cache and EEPROM ring
+ *        writes)
+ * 
+ * BOARD_RTOS_ENABLE builds: called periodically by the lowest-priority
+ * task, and app_main_loop() leaves this work out. Otherwise
+ * app_main_loop() does it on each sensor event.
+ */
+void app_background_poll(void);
+
+/**
+ * @brief Set the pressure mapped to the top of each pressure output
+ * 
+ * Moves in_max of every APP_DAC_SOURCE_PRESSURE mapping to span_mbar
+ * (in_min and the code range unchanged).
+ * 
+ * @param span_mbar Pressure at code_max in mbar (1..30000, above in_min), 0
+ *                  for the board default
+ * @return true if set, false if out of range
+ */
+bool app_set_dac_pressure_span(uint32_t span_mbar);
+
+/**
+ * @brief Set the stale sample policy
+ * 
+ * A sample older than limit_ms is stale (sensor_sampling_is_stale()): the
+ * slave reports SENSOR_STATUS_STALE and OUT1/OUT2 go to dac_code until
+ * the next fresh sample.
+ * 
+ * @param limit_ms Stale limit in ms, 0 = off
+ * @param dac_code Code for both outputs, BOARD_DAC_STALE_HOLD to keep the
+ *                 last codes
+ * @return true if set, false if the code is out of range
+ */
+bool app_set_stale(uint16_t limit_ms, uint16_t dac_code);
+
+/**
+ * @brief Replace the mapping of a DAC output
+ * 
+ * Slope and offset are precomputed here (calibration folded in); the
+ * per-sample cost does not depend on the mapping. Main loop only.
+ * 
+ * @param channel DAC output
+ * @param map New mapping
+ * @return true if set, false if invalid
+ */
+bool app_set_dac_map(dac_channel_t channel, const app_dac_map_t *map);
+
+/**
+ * @brief Get the mapping of a DAC output
+ * 
+ * @param channel DAC output
+ * @param map Receives the mapping
+ * @return true if successful, false otherwise
+ */
+bool app_get_dac_map(dac_channel_t channel, app_dac_map_t *map);
+
+/**
+ * @brief DAC calibration steps (HOST_CMD_DAC_CAL arg[7:0])
+ */
+typedef enum {
+    APP_DAC_CAL_END = 0,         /* Leave calibration: sensor mapping resumes */
+    APP_DAC_CAL_DRIVE_LOW = 1,   /* Both outputs at the 10% code, uncalibrated */
+    APP_DAC_CAL_DRIVE_HIGH = 2,  /* Both outputs at the 90% code, uncalibrated */
+    APP_DAC_CAL_MEASURED = 3,    /* Voltage measured at the driven point */
+    APP_DAC_CAL_SAVE = 4,        /* Compute gain/offset, apply and store in EEPROM */
+    APP_DAC_CAL_RESET = 5        /* Back to the ideal transfer, stored */
+} app_dac_cal_step_t;
+
+/**
+ * @brief HOST_CMD_DAC_WAVE operations, arg[31:24]
+ */
+typedef enum {
+    APP_DAC_WAVE_ABORT = 0,   /* Drop the upload in progress */
+    APP_DAC_WAVE_BEGIN = 1,   /* Open an upload */
+    APP_DAC_WAVE_COMMIT = 2,  /* Check it and hand it to the player */
+    APP_DAC_WAVE_PLAY = 3     /* Play the active table, or stop */
+} app_dac_wave_op_t;
+
+/**
+ * @brief Boot phase times (APP_REG_BOOT_*)
+ * 
+ * Microseconds since board_init_clock() (board_get_uptime_us()); reset
+ * and the clock switch itself are not covered.
+ */
+typedef struct {
+    uint32_t board_us;         /* board_init() done */
+    uint32_t drivers_us;       /* Peripherals and drivers initialized */
+    uint32_t app_us;           /* Application initialized, sampling started */
+    uint32_t first_sample_us;  /* First valid sample published, 0 until then */
+} app_boot_times_t;
+
+/**
+ * @brief Run one step of the master-driven DAC calibration
+ * 
+ * Sequence per board: DRIVE_LOW, MEASURED for each channel, DRIVE_HIGH,
+ * MEASURED for each channel, SAVE for each channel, END. The sensor mapping
+ * is held from the first DRIVE until END.
+ * 
+ * @param argument arg[7:0] app_dac_cal_step_t, arg[8] channel
+ *                 (dac_channel_t), arg[31:16] measured mV (MEASURED)
+ * @return true if done, false if out of order or out of range
+ */
+bool app_dac_calibrate(uint32_t argument);
+
+/**
+ * @brief Store the running settings as the boot configuration (config.h)
+ * 
+ * Sampling profile, tick rate, filter and DAC mappings as they are now;
+ * they apply from the next reset on, like the slave address (blocking,
+ * up to ~50 ms).
+ * 
+ * @param slave_addr New 7-bit slave address, 0 to keep the stored (or
+ *                   built-in) one
+ * @return true if stored
+ */
+bool app_save_config(uint8_t slave_addr);
+
+/**
+ * @brief Change one setting of an event detector (HOST_CMD_EVENT_SET)
+ * 
+ * The detector restarts inactive. Field 0 holds the condition, so a
+ * detector is typically set up with fields 1..3 first and armed with 0.
+ * 
+ * @param argument arg[31:28] detector, arg[27:24] field, arg[23:0] value:
+ *                 field 0 = [7:0] event_condition_t, [15:8] event_source_t,
+ *                 [23:16] debounce samples; 1 = low threshold, 2 = window high,
+ *                 3 = hysteresis (signed 24-bit, source units)
+ * @return true if set, false if out of range
+ */
+bool app_set_event(uint32_t argument);
+
+/**
+ * @brief Select the unit shown at APP_REG_PRESSURE_UNIT
+ * 
+ * @param unit Unit, APP_UNIT_OFF for none
+ * @return true if set, false if out of range
+ */
+bool app_set_pressure_unit(app_pressure_unit_t unit);
+
+/**
+ * @brief Set how often a consumer of the newest sample runs
+ * 
+ * An event edge still reaches the slave registers and INTR_MCU with the
+ * sample that caused it.
+ * 
+ * @param argument arg[31:24] app_output_t, arg[15:0] samples per run (1..65535)
+ * @return true if set, false if out of range or not in this build
+ */
+bool app_set_output_rate(uint32_t argument);
+
+/**
+ * @brief Select the derived quantity (HOST_CMD_DERIVED)
+ * 
+ * @param argument arg[23:0] reference pressure in 0.01 mbar, 0 for the
+ *                 pressure now (tare: the depth or altitude reads 0 here);
+ *                 arg[27:24] derived_quantity_t
+ * @return true if set, false if out of range or no sample to tare on
+ */
+bool app_set_derived(uint32_t argument);
+
+/**
+ * @brief Replace the DAC outputs with a streamed test stimulus
+ * 
+ * Triangle sweeping 0 to full scale on channel 1 and the mirror image on
+ * channel 2, played by TIM6 + DMA at a fixed rate. The sensor mapping
+ * resumes once stopped.
+ * 
+ * @param rate_hz Samples per second (up to BOARD_DAC_STREAM_MAX_HZ), 0 to stop
+ * @return true if started or stopped, false if out of range or streaming is
+ *         not built in
+ */
+bool app_dac_stimulus(uint32_t rate_hz);
+
+/**
+ * @brief Give the DAC outputs to the master's setpoint registers
+ * 
+ * On: the stream (follower, playout or stimulus) stops, the outputs hold
+ * until the master writes APP_REG_DAC_SET_*, and each write is applied
+ * from the slave RX interrupt. Off: the sensor mapping resumes. The alarm
+ * threshold output keeps its threshold either way.
+ * 
+ * @param argument 1 on, 0 off
+ * @return true if set, false if out of range, during a calibration or not
+ *         built in (BOARD_DAC_SETPOINT_ENABLE)
+ */
+bool app_set_dac_setpoint(uint32_t argument);
+
+/**
+ * @brief Upload and play a DAC waveform table (wave.h)
+ * 
+ * Begin opens an upload into the table not playing; the master then writes
+ * the chunks at APP_REG_WAVE and commits them with their CRC-16. Play
+ * loops the table on the DAC stream, switching to a committed one at the
+ * end of a period; stopping it gives the outputs back to the sensor
+ * mapping. The alarm threshold output keeps its threshold.
+ * 
+ * @param argument arg[31:24] app_dac_wave_op_t, then per op:
+ *                 begin arg[15:0] samples (1..BOARD_DAC_WAVE_SAMPLES),
+ *                 commit arg[15:0] CRC-16 of the sample bytes,
+ *                 play arg[23:0] samples per second (up to
+ *                 BOARD_DAC_STREAM_MAX_HZ, 0 to stop)
+ * @return true if done, false if out of range, refused (see wave_begin(),
+ *         wave_commit()), no table to play, in setpoint mode or during a
+ *         calibration, or not built in (BOARD_DAC_WAVE_ENABLE)
+ */
+bool app_dac_wave(uint32_t argument);
+
+/**
+ * @brief Turn the sampling tick alignment to the master's polls on or off
+ * 
+ * The poll period and phase are measured either way (poll_align.h); on,
+ * the tick is moved so that a sample is published just ahead of each
+ * predicted read. Only in exact mode on the local tick.
+ * 
+ * @param argument 1 on, 0 off
+ * @return true if set, false if out of range or not built in
+ *         (BOARD_POLL_ALIGN_ENABLE)
+ */
+bool app_set_poll_align(uint32_t argument);
+
+/**
+ * @brief Set the analog watchdog threshold and re-arm it
+ * 
+ * COMP2 compares the alarm input with the DAC output
+ * BOARD_COMP_ALARM_DAC_OUT, driven at the threshold (channel calibration
+ * and VDDA applied). The first rising crossing latches the alarm in
+ * interrupt context and raises INTR_MCU; no further interrupt until the
+ * next call. An input already above when armed shows as APP_ALARM_ABOVE,
+ * not as a trip.
+ * 
+ * @param threshold_mv Threshold at the alarm input in mV (up to
+ *                     BOARD_DAC_VREF_MV), 0 to disarm
+ * @return true if set, false if out of range or the alarm is not built in
+ */
+bool app_set_alarm(uint32_t threshold_mv);
+
+/**
+ * @brief Analog watchdog crossing (call from HAL_COMP_TriggerCallback())
+ * 
+ * Interrupt context: latches and disarms, the main loop reports it.
+ */
+void app_alarm_isr(void);
+
+/**
+ * @brief Brown-out save (call from the PVD vector, BOARD_PVD_SAVE_ENABLE)
+ * 
+ * Flushes the flash log within BOARD_PVD_SAVE_HALVES programs, then writes
+ * the snapshot page: edge timestamp, time the flush took (us), newest
+ * sample (sequence, pressure, temperature), EEPROM statistics window (min,
+ * max, mean, count) and sampler errors, timeouts and slave errors. Blocks
+ * for up to the budget in board_config.h; the main loop must not resume.
+ */
+void app_power_fail_isr(void);
+
+/**
+ * @brief Publish the boot report
+ * 
+ * Call once sampling is started, with the phases up to then; the first
+ * valid sample adds its own time here.
+ * 
+ * @param times Boot phase times (first_sample_us ignored)
+ */
+void app_set_boot_times(const app_boot_times_t *times);
+
+/**
+ * @brief RTC wakeup of the low-rate logging mode (call from
+ *        HAL_RTCEx_WakeUpTimerEventCallback())
+ * 
+ * Interrupt context: the main loop restarts the timebase and takes one
+ * sample, then stops it again. No-op unless BOARD_LOG_PERIOD_S is set.
+ */
+void app_log_wakeup_isr(void);
+
+/**
+ * @brief Select the site shown in the profiling window
+ * 
+ * @param argument arg[7:0] prof_site_t, arg[8] set to clear the statistics
+ *                 of every site first
+ * @return true if selected, false if the site is out of range or profiling
+ *         is not built in (BOARD_PROF_ENABLE)
+ */
+bool app_set_prof_site(uint32_t argument);
+
+/**
+ * @brief Select the latency histogram bucket shown in the latency window
+ * 
+ * @param argument arg[7:0] latency_stage_t, arg[15:8] bucket, arg[16] set
+ *                 to clear every histogram and the jitter statistics first
+ * @return true if selected, false if out of range or the histograms are
+ *         not built in (BOARD_LATENCY_ENABLE)
+ */
+bool app_set_latency_view(uint32_t argument);
+
+/**
+ * @brief Show a record of the EEPROM ring in the APP_REG_ELOG_* window
+ * 
+ * @param seq Sequence number, 0 for the newest
+ * @return true if shown, false if the ring does not hold it (not written,
+ *         overwritten by a later lap, damaged) or is not built in
+ *         (BOARD_EEPROM_LOG_ENABLE)
+ */
+bool app_show_event(uint32_t seq);
+
 /**
  * @brief Get latest sensor reading count
  * 
@@ -0,0 +1,316 @@
+/**
+ * @file bench.c
+ * @brief On-target benchmark implementation
+ *
+ * Steps run OSR fastest, then mode, then bus speed, so I2C2 is re-inited
+ * only twice (and once more to restore it). The re-init waits for a
+ * moment with no transfer in flight, with the tick and I2C2 lines masked
+ * so none starts meanwhile. Like a burst (burst.c), the settings in force
+ * before are saved whole and set again in reverse order, the adaptive
+ * controller last.
+ */
+
+#include "bench.h"
+
+#if BOARD_BENCH_ENABLE
+
+#include "stm32l0xx_hal.h"
+#include "hal_config.h"
+#include "perf.h"
+#include "sensor_sampling.h"
+#include "trace.h"
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+/**
+ * @brief Where a step is
+ */
+typedef enum {
+    BENCH_PHASE_APPLY = 0,  /* Settings of the step not in force yet */
+    BENCH_PHASE_SETTLE,     /* Running, not measured */
+    BENCH_PHASE_MEASURE,    /* Window open */
+    BENCH_PHASE_RESTORE     /* Sweep over, I2C2 speed not back yet */
+} bench_phase_t;
+
+/**
+ * @brief Sampler settings the sweep overrides
+ */
+typedef struct {
+    uint32_t rate_hz;
+    sensor_sampling_mode_t mode;
+    sensor_osr_t pressure_osr;
+    sensor_osr_t temperature_osr;
+    sensor_adaptive_osr_t adaptive;
+    hal_i2c_speed_t speed;
+} bench_settings_t;
+
+/**
+ * @brief Counters at the start of a window
+ */
+typedef struct {
+    uint32_t time_us;
+    uint32_t sequence;
+    uint32_t idle_us;
+    uint32_t errors;
+    uint32_t overruns;
+} bench_snapshot_t;
+
+/**
+ * @brief Stream frame
+ */
+typedef struct {
+    bench_header_t header;
+    bench_row_t rows[BENCH_STEPS];
+} bench_frame_t;
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static bench_frame_t frame;
+static volatile uint8_t rows_done = 0;
+static volatile bench_state_t state = BENCH_IDLE;
+static bench_phase_t phase = BENCH_PHASE_APPLY;
+static bench_state_t end_state = BENCH_DONE;  /* Once restored */
+static uint32_t step = 0;
+static uint32_t step_start_us = 0;
+static bench_snapshot_t window;
+static bench_settings_t saved;
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static void bench_restore(void)
+{
+    (void)sensor_sampling_set_rate_hz(saved.rate_hz);
+    (void)sensor_sampling_set_mode(saved.mode);
+    (void)sensor_sampling_set_profile(saved.pressure_osr, saved.temperature_osr);
+    (void)sensor_sampling_set_adaptive_osr(&saved.adaptive);
+}
+
+/**
+ * @brief Re-init I2C2 at a speed between two transfers
+ *
+ * @param ok Receives false if the re-init failed (left as is otherwise)
+ * @return true once done, false while a transfer is in flight
+ */
+static bool bench_set_speed(hal_i2c_speed_t speed, bool *ok)
+{
+    uint32_t masked;
+    bool idle;
+
+    if (hal_i2c2_get_speed() == speed) {
+        return true;
+    }
+
+    masked = hal_irq_mask(HAL_IRQ_LINES_TIMEBASE | (1UL << I2C2_IRQn));
+    idle = hal_i2c2_is_idle();
+    if (idle) {
+        hal_i2c2_set_speed(speed);
+        if (!hal_i2c2_init()) {
+            *ok = false;
+        }
+    }
+    hal_irq_unmask(masked);
+    return idle;
+}
+
+static void bench_snapshot(bench_snapshot_t *snap, uint32_t now_us)
+{
+    sensor_data_t data;
+    sensor_error_stats_t errors;
+    sensor_tick_stats_t tick;
+    perf_stats_t perf;
+
+    (void)sensor_sampling_get_data(&data);
+    sensor_sampling_get_error_stats(&errors);
+    sensor_sampling_get_tick_stats(&tick);
+    perf_get_stats(&perf);
+
+    snap->time_us = now_us;
+    snap->sequence = data.sequence;
+    snap->idle_us = perf.idle_us;
+    snap->errors = errors.errors;
+    snap->overruns = tick.overruns;
+}
+
+static uint16_t bench_saturate(uint32_t value)
+{
+    return (value > UINT16_MAX) ? UINT16_MAX : (uint16_t)value;
+}
+
+/**
+ * @brief Append the row of the current step
+ *
+ * @param refused true if its settings could not be applied
+ */
+static void bench_finish_step(uint32_t now_us, bool refused)
+{
+    bench_row_t *row = &frame.rows[step];
+    bench_snapshot_t end;
+    perf_stats_t perf;
+    uint32_t span_us;
+
+    row->osr = (uint8_t)(step % BENCH_OSRS);
+    row->mode = (uint8_t)((step / BENCH_OSRS) % BENCH_MODES);
+    row->speed = (uint8_t)(step / (BENCH_OSRS * BENCH_MODES));
+    row->flags = refused ? BENCH_ROW_REFUSED : 0U;
+    row->rate_centihz = 0;
+    row->idle_centipct = 0;
+    row->wcet_tick_us = 0;
+    row->wcet_bus_us = 0;
+    row->wcet_bottom_us = 0;
+    row->errors = 0;
+    row->overruns = 0;
+
+    span_us = now_us - window.time_us;
+    if (!refused && span_us != 0U) {
+        bench_snapshot(&end, now_us);
+        perf_get_stats(&perf);
+        row->rate_centihz = (uint32_t)((uint64_t)(end.sequence - window.sequence) * 100000000ULL /
+                                       span_us);
+        row->idle_centipct = bench_saturate((uint32_t)((uint64_t)(end.idle_us - window.idle_us) *
+                                                       10000U / span_us));
+        if (row->idle_centipct > 10000U) {
+            row->idle_centipct = 10000U;
+        }
+        row->wcet_tick_us = perf.wcet_us[PERF_ISR_TICK];
+        row->wcet_bus_us = perf.wcet_us[PERF_ISR_SENSOR_BUS];
+        row->wcet_bottom_us = perf.wcet_us[PERF_ISR_BOTTOM];
+        row->errors = bench_saturate(end.errors - window.errors);
+        row->overruns = bench_saturate(end.overruns - window.overruns);
+    }
+
+    __DMB();  /* Row complete before the stream can count it */
+    rows_done = (uint8_t)(step + 1U);
+    TRACE(TRACE_BENCH_ROW, step, row->rate_centihz);
+
+    step++;
+    phase = BENCH_PHASE_APPLY;
+    if (step == BENCH_STEPS) {
+        bench_restore();
+        end_state = BENCH_DONE;
+        phase = BENCH_PHASE_RESTORE;
+    }
+}
+
+/**
+ * @brief Put the settings of the current step in force
+ */
+static void bench_apply_step(uint32_t now_us)
+{
+    sensor_osr_t osr = (sensor_osr_t)(step % BENCH_OSRS);
+    sensor_sampling_mode_t mode = (sensor_sampling_mode_t)((step / BENCH_OSRS) % BENCH_MODES);
+    hal_i2c_speed_t speed = (hal_i2c_speed_t)(step / (BENCH_OSRS * BENCH_MODES));
+    bool ok = true;
+
+    if (!bench_set_speed(speed, &ok)) {
+        return;  /* A transfer in flight: next poll */
+    }
+    ok = ok && sensor_sampling_set_mode(mode) && sensor_sampling_set_profile(osr, osr);
+    if (!ok) {
+        window.time_us = now_us;
+        bench_finish_step(now_us, true);
+        return;
+    }
+
+    step_start_us = now_us;
+    phase = BENCH_PHASE_SETTLE;
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+bool bench_start(void)
+{
+    if (state == BENCH_RUNNING || sensor_sampling_get_sync_input()) {
+        return false;
+    }
+
+    saved.rate_hz = sensor_sampling_get_rate_hz();
+    saved.mode = sensor_sampling_get_mode();
+    sensor_sampling_get_profile(&saved.pressure_osr, &saved.temperature_osr);
+    sensor_sampling_get_adaptive_osr(&saved.adaptive);
+    saved.speed = hal_i2c2_get_speed();
+
+    (void)sensor_sampling_set_adaptive_osr(NULL);
+    if (!sensor_sampling_set_rate_hz(BOARD_TIM2_FREQ_HZ)) {
+        bench_restore();
+        return false;
+    }
+
+    rows_done = 0;
+    step = 0;
+    phase = BENCH_PHASE_APPLY;
+    state = BENCH_RUNNING;
+    return true;
+}
+
+void bench_stop(void)
+{
+    if (state != BENCH_RUNNING || phase == BENCH_PHASE_RESTORE) {
+        return;
+    }
+    bench_restore();
+    end_state = BENCH_STOPPED;
+    phase = BENCH_PHASE_RESTORE;
+}
+
+void bench_poll(uint32_t now_us)
+{
+    bool ok = true;
+
+    if (state != BENCH_RUNNING) {
+        return;
+    }
+
+    switch (phase) {
+    case BENCH_PHASE_APPLY:
+        bench_apply_step(now_us);
+        break;
+    case BENCH_PHASE_SETTLE:
+        if (now_us - step_start_us >= BOARD_BENCH_SETTLE_MS * 1000UL) {
+            bench_snapshot(&window, now_us);
+            perf_clear_wcet();
+            phase = BENCH_PHASE_MEASURE;
+        }
+        break;
+    case BENCH_PHASE_MEASURE:
+        if (now_us - window.time_us >= BOARD_BENCH_DWELL_MS * 1000UL) {
+            bench_finish_step(now_us, false);
+        }
+        break;
+    case BENCH_PHASE_RESTORE:
+        if (bench_set_speed(saved.speed, &ok)) {
+            state = end_state;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+bench_state_t bench_get_state(void)
+{
+    return state;
+}
+
+const uint8_t *bench_take(uint16_t *len)
+{
+    uint8_t rows = rows_done;
+
+    __DMB();  /* The rows counted are complete */
+    frame.header.version = BENCH_VERSION;
+    frame.header.state = (uint8_t)state;
+    frame.header.rows = rows;
+    frame.header.steps = (uint8_t)BENCH_STEPS;
+    frame.header.dwell_ms = BOARD_BENCH_DWELL_MS;
+    *len = (uint16_t)(sizeof(bench_header_t) + rows * sizeof(bench_row_t));
+    return (const uint8_t *)&frame;
+}
+
+#endif /* BOARD_BENCH_ENABLE */
@@ -0,0 +1,143 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+/**
+ * @file bench.h
+ * @brief On-target benchmark: throughput over OSR, bus speed and mode
+ *
+ * HOST_CMD_BENCH sweeps every sampler combination the hardware offers:
+ * OSR 256..8192 (pressure and temperature alike), each I2C2 speed profile
+ * (hal_i2c_speed_t) and each sampling mode (sequential, pipelined, exact),
+ * 54 steps in all, at the highest tick rate (BOARD_TIM2_FREQ_HZ) with
+ * adaptive control off. Each step settles for BOARD_BENCH_SETTLE_MS and is
+ * then measured over BOARD_BENCH_DWELL_MS:
+ *   - samples per second achieved (sequence numbers, drops included)
+ *   - CPU idle (perf.h)
+ *   - longest tick, sensor bus and bottom half handlers (perf.h, cleared
+ *     at the start of each window)
+ *   - aborted cycles and tick overruns
+ * The settings in force before come back when the sweep ends or is
+ * stopped. Leave the sampler settings alone meanwhile: a command changing
+ * them only lasts to the next step.
+ *
+ * The table reads as one stream frame at APP_REG_BENCH (bench_take()), a
+ * bench_header_t and the rows done so far, oldest first; with
+ * BOARD_TRACE_ENABLE each row also goes out as a TRACE_BENCH_ROW record.
+ *
+ * Main loop only. BOARD_BENCH_ENABLE builds (with BOARD_PERF_ENABLE),
+ * single sensor.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+#define BENCH_OSRS    6U   /* sensor_osr_t */
+#define BENCH_SPEEDS  3U   /* hal_i2c_speed_t */
+#define BENCH_MODES   3U   /* sensor_sampling_mode_t */
+#define BENCH_STEPS   (BENCH_OSRS * BENCH_SPEEDS * BENCH_MODES)
+
+#define BENCH_VERSION  1U
+
+/* bench_row_t flags */
+#define BENCH_ROW_REFUSED  0x01U  /* The sampler or bus refused the combination: not measured */
+
+/**
+ * @brief Sweep state
+ */
+typedef enum {
+    BENCH_IDLE = 0,
+    BENCH_RUNNING,
+    BENCH_DONE,      /* Every step measured, settings restored */
+    BENCH_STOPPED    /* Stopped before the end, settings restored */
+} bench_state_t;
+
+/**
+ * @brief Frame header (little-endian, packed by layout)
+ */
+typedef struct {
+    uint8_t version;     /* BENCH_VERSION */
+    uint8_t state;       /* bench_state_t */
+    uint8_t rows;        /* Rows that follow */
+    uint8_t steps;       /* BENCH_STEPS */
+    uint32_t dwell_ms;   /* Measuring window per step */
+} bench_header_t;
+
+/**
+ * @brief Result of one step (20 bytes)
+ */
+typedef struct {
+    uint8_t osr;             /* sensor_osr_t, D1 and D2 */
+    uint8_t speed;           /* hal_i2c_speed_t of I2C2 */
+    uint8_t mode;            /* sensor_sampling_mode_t */
+    uint8_t flags;           /* BENCH_ROW_* */
+    uint32_t rate_centihz;   /* Samples per second x 100 */
+    uint16_t idle_centipct;  /* CPU idle, 0.01 % */
+    uint16_t wcet_tick_us;   /* Longest sampling tick handler */
+    uint16_t wcet_bus_us;    /* Longest sensor bus handler */
+    uint16_t wcet_bottom_us; /* Longest bottom half */
+    uint16_t errors;         /* Aborted cycles (saturated) */
+    uint16_t overruns;       /* Tick overruns (saturated) */
+} bench_row_t;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Start the sweep
+ *
+ * The previous table is dropped.
+ *
+ * @return true if started, false while one runs or with the sync input on
+ */
+bool bench_start(void);
+
+/**
+ * @brief Stop the sweep, keeping the rows done
+ *
+ * Restores the sampler settings; nothing to do when none runs.
+ */
+void bench_stop(void);
+
+/**
+ * @brief Advance the sweep
+ *
+ * Call periodically from the main loop; step times are only as fine as
+ * the calls.
+ *
+ * @param now_us timebase_now_us()
+ */
+void bench_poll(uint32_t now_us);
+
+/**
+ * @brief Get the sweep state
+ *
+ * @return State
+ */
+bench_state_t bench_get_state(void);
+
+/**
+ * @brief Stream source of the table (i2c_slave_set_stream())
+ *
+ * Interrupt context. Rows are only appended, each before it is counted:
+ * a read during the sweep takes the rows complete so far.
+ *
+ * @param len Receives the frame length
+ * @return Header and rows
+ */
+const uint8_t *bench_take(uint16_t *len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BENCH_H */
@@ -0,0 +1,298 @@
+/**
+ * @file burst.c
+ * @brief Master-triggered burst and pre-trigger capture into RAM implementation
+ *
+ * Both captures write one ring of pre + post samples over the pool blocks
+ * taken when they start (a burst is a ring with no pre-trigger part,
+ * triggered at once). The write position wraps by compare, and the block
+ * size is a power of two, so a sample costs a few stores. Once frozen, the
+ * ring drains oldest first and its blocks go back to the pool with the
+ * last sample.
+ *
+ * The sampler settings in force before a burst are saved whole and set
+ * again in reverse order, the adaptive controller last (it starts over at
+ * its fast OSR and rate).
+ */
+
+#include "burst.h"
+
+#if BOARD_BURST_ENABLE
+
+#include <stddef.h>
+#include "host_fifo.h"
+#include "pool.h"
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#if BOARD_BURST_BLOCKS == 0 || BURST_MAX_SAMPLES > 0xFFFFU
+#error "BOARD_BURST_BLOCKS must be 1..2047"
+#endif
+
+/**
+ * @brief Captured samples
+ */
+typedef struct {
+    int32_t pressure[BURST_BLOCK_SAMPLES];
+    int32_t temperature[BURST_BLOCK_SAMPLES];
+    uint32_t timestamp_us[BURST_BLOCK_SAMPLES];
+    uint32_t sequence[BURST_BLOCK_SAMPLES];
+} burst_block_t;
+
+/**
+ * @brief Sampler settings a burst overrides
+ */
+typedef struct {
+    uint32_t rate_hz;
+    sensor_sampling_mode_t mode;
+    sensor_osr_t pressure_osr;
+    sensor_osr_t temperature_osr;
+    uint16_t temp_decimation;
+    sensor_adaptive_osr_t adaptive;
+} burst_settings_t;
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+POOL_STORAGE(block_storage, sizeof(burst_block_t), BOARD_BURST_BLOCKS);
+static pool_t block_pool;
+static burst_block_t *blocks[BOARD_BURST_BLOCKS];
+static burst_settings_t saved;
+static burst_state_t state = BURST_IDLE;
+static uint32_t ring_len = 0;    /* pre + post */
+static uint32_t post = 0;        /* Samples kept from the trigger on */
+static uint32_t post_left = 0;   /* Still to capture once triggered */
+static uint32_t write_pos = 0;
+static uint32_t filled = 0;      /* Samples in the ring, up to ring_len */
+static uint32_t last_sequence = 0;
+static uint32_t read_pos = 0;
+static uint32_t drain_left = 0;  /* Frozen samples not queued to the FIFO yet */
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static void burst_restore(void)
+{
+    (void)sensor_sampling_set_rate_hz(saved.rate_hz);
+    (void)sensor_sampling_set_mode(saved.mode);
+    (void)sensor_sampling_set_temperature_decimation(saved.temp_decimation);
+    (void)sensor_sampling_set_profile(saved.pressure_osr, saved.temperature_osr);
+    (void)sensor_sampling_set_adaptive_osr(&saved.adaptive);
+}
+
+static bool burst_apply(void)
+{
+    (void)sensor_sampling_set_adaptive_osr(NULL);
+    return sensor_sampling_set_profile(SENSOR_OSR_256, saved.temperature_osr) &&
+           sensor_sampling_set_temperature_decimation(UINT16_MAX) &&
+           sensor_sampling_set_mode(SENSOR_MODE_EXACT) &&
+           sensor_sampling_set_rate_hz(BOARD_TIM2_FREQ_HZ);
+}
+
+/**
+ * @brief Return every block held
+ */
+static void burst_free_blocks(void)
+{
+    for (uint32_t i = 0; i < BOARD_BURST_BLOCKS; i++) {
+        if (blocks[i] != NULL) {
+            (void)pool_free(&block_pool, blocks[i]);
+            blocks[i] = NULL;
+        }
+    }
+}
+
+/**
+ * @brief Take the blocks of an empty pre + post ring
+ */
+static bool burst_ring_setup(uint32_t pre_samples, uint32_t post_samples)
+{
+    uint32_t length = pre_samples + post_samples;
+
+    if (post_samples == 0U || length > BURST_MAX_SAMPLES || state != BURST_IDLE) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < (length + BURST_BLOCK_SAMPLES - 1U) / BURST_BLOCK_SAMPLES; i++) {
+        blocks[i] = (burst_block_t *)pool_alloc(&block_pool);
+        if (blocks[i] == NULL) {
+            burst_free_blocks();
+            return false;
+        }
+    }
+    ring_len = length;
+    post = post_samples;
+    write_pos = 0;
+    filled = 0;
+    return true;
+}
+
+/**
+ * @brief Stop writing; drain from the oldest sample
+ */
+static void burst_freeze(void)
+{
+    if (state == BURST_CAPTURING) {
+        burst_restore();
+    }
+    read_pos = (filled == ring_len) ? write_pos : 0U;
+    drain_left = filled;
+    state = BURST_DRAINING;
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+bool burst_init(void)
+{
+    for (uint32_t i = 0; i < BOARD_BURST_BLOCKS; i++) {
+        blocks[i] = NULL;
+    }
+    state = BURST_IDLE;
+    return pool_init(&block_pool, block_storage, sizeof(burst_block_t), BOARD_BURST_BLOCKS);
+}
+
+bool burst_start(uint32_t samples)
+{
+    if (samples == 0U) {
+        if (state == BURST_CAPTURING) {
+            burst_restore();
+        }
+        burst_free_blocks();
+        state = BURST_IDLE;
+        return true;
+    }
+    if (!burst_ring_setup(0, samples)) {
+        return false;
+    }
+
+    saved.rate_hz = sensor_sampling_get_rate_hz();
+    saved.mode = sensor_sampling_get_mode();
+    sensor_sampling_get_profile(&saved.pressure_osr, &saved.temperature_osr);
+    saved.temp_decimation = sensor_sampling_get_temperature_decimation();
+    sensor_sampling_get_adaptive_osr(&saved.adaptive);
+
+    if (!burst_apply()) {
+        burst_restore();
+        burst_free_blocks();
+        return false;
+    }
+
+    post_left = samples;
+    state = BURST_CAPTURING;
+    return true;
+}
+
+bool burst_arm(uint32_t pre_samples, uint32_t post_samples)
+{
+    if (!burst_ring_setup(pre_samples, post_samples)) {
+        return false;
+    }
+    state = BURST_ARMED;
+    return true;
+}
+
+void burst_trigger(uint32_t sequence)
+{
+    uint32_t after;
+
+    if (state != BURST_ARMED) {
+        return;
+    }
+
+    /* The trigger sample and the ones after it may be in the ring already */
+    after = last_sequence - sequence + 1U;
+    if (after >= post) {
+        burst_freeze();
+        return;
+    }
+    post_left = post - after;
+    state = BURST_TRIGGERED;
+}
+
+void burst_push(const sensor_data_t *sample)
+{
+    burst_block_t *b;
+    uint32_t slot;
+
+    if (state == BURST_IDLE || state == BURST_DRAINING) {
+        return;
+    }
+
+    b = blocks[write_pos / BURST_BLOCK_SAMPLES];
+    slot = write_pos % BURST_BLOCK_SAMPLES;
+    b->pressure[slot] = sample->pressure;
+    b->temperature[slot] = sample->temperature;
+    b->timestamp_us[slot] = sample->timestamp_us;
+    b->sequence[slot] = sample->sequence;
+    last_sequence = sample->sequence;
+    if (++write_pos == ring_len) {
+        write_pos = 0;
+    }
+    if (filled < ring_len) {
+        filled++;
+    }
+
+    if (state != BURST_ARMED && --post_left == 0U) {
+        burst_freeze();
+    }
+}
+
+void burst_poll(void)
+{
+    sensor_data_t data;
+
+    if (state != BURST_DRAINING) {
+        return;
+    }
+
+    data.valid = true;
+    data.quality = SENSOR_QUALITY_CRC_OK;  /* The block keeps no quality */
+    data.error_count = 0;
+    while (drain_left > 0U && host_fifo_has_room()) {
+        const burst_block_t *b = blocks[read_pos / BURST_BLOCK_SAMPLES];
+        uint32_t slot = read_pos % BURST_BLOCK_SAMPLES;
+
+        data.pressure = b->pressure[slot];
+        data.temperature = b->temperature[slot];
+        data.timestamp_us = b->timestamp_us[slot];
+        data.sequence = b->sequence[slot];
+        (void)host_fifo_push(&data);
+        drain_left--;
+        if (++read_pos == ring_len) {
+            read_pos = 0;
+        }
+    }
+    if (drain_left == 0U) {
+        burst_free_blocks();
+        state = BURST_IDLE;
+    }
+}
+
+burst_state_t burst_get_state(void)
+{
+    return state;
+}
+
+bool burst_owns_fifo(void)
+{
+    return state == BURST_CAPTURING || state == BURST_DRAINING;
+}
+
+uint32_t burst_get_count(void)
+{
+    switch (state) {
+    case BURST_IDLE:
+        return 0;
+    case BURST_DRAINING:
+        return drain_left;
+    default:
+        return filled;
+    }
+}
+
+#endif /* BOARD_BURST_ENABLE */
@@ -0,0 +1,131 @@
+#ifndef BURST_H
+#define BURST_H
+
+/**
+ * @file burst.h
+ * @brief Master-triggered burst and pre-trigger capture into RAM
+ *
+ * HOST_CMD_BURST switches the sampler to its fastest pressure-only
+ * setting (BOARD_TIM2_FREQ_HZ ticks, exact-timed mode, OSR 256, no
+ * temperature conversion, adaptive control off) and stores the next N
+ * samples in blocks taken from a dedicated pool. The sampler settings come
+ * back once N samples are in, and the capture then drains through the FIFO
+ * register: each master read takes a full frame (one DMA transfer), and
+ * live samples stay out of the FIFO until the last captured one is queued.
+ * Slave register and DAC updates pause for the capture.
+ *
+ * HOST_CMD_BURST_ARM instead keeps a ring of the last pre + post samples
+ * at the running settings (oscilloscope mode): while armed, a sample costs
+ * one ring write and the FIFO and outputs carry on as usual. The first
+ * event detector to turn active (event_detect.h) triggers it; post samples
+ * later, from the trigger sample on, the ring freezes with up to pre
+ * samples before the trigger and drains the same way.
+ *
+ * The filter stage is left as configured.
+ *
+ * Main loop only. BOARD_BURST_ENABLE builds, single sensor.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board_config.h"
+#include "sensor_sampling.h"  /* For sensor_data_t type */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+#define BURST_BLOCK_SAMPLES   32U
+#define BURST_MAX_SAMPLES     (BURST_BLOCK_SAMPLES * BOARD_BURST_BLOCKS)
+
+/**
+ * @brief Capture state (APP_REG_BURST_STATE)
+ */
+typedef enum {
+    BURST_IDLE = 0,
+    BURST_CAPTURING,   /* Sampler at the burst settings, samples going to RAM */
+    BURST_DRAINING,    /* Settings restored, captured samples going to the FIFO */
+    BURST_ARMED,       /* Pre-trigger ring running, waiting for an event */
+    BURST_TRIGGERED    /* Capturing the post-trigger samples */
+} burst_state_t;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Set up the block pool (idle)
+ *
+ * @return true if successful
+ */
+bool burst_init(void);
+
+/**
+ * @brief Start a capture, or abort one
+ *
+ * An abort restores the sampler settings and drops the samples not yet
+ * queued to the FIFO.
+ *
+ * @param samples Samples to capture (1..BURST_MAX_SAMPLES), 0 = abort
+ * @return true if started (or aborted), false if out of range, a capture
+ *         is already running or armed, or the sampler refused the burst
+ *         settings
+ */
+bool burst_start(uint32_t samples);
+
+/**
+ * @brief Arm the pre-trigger ring
+ *
+ * HOST_CMD_BURST 0 disarms it, or drops a frozen ring not drained yet.
+ *
+ * @param pre_samples Samples kept before the trigger
+ * @param post_samples Samples kept from the trigger on, at least 1
+ *                     (pre + post up to BURST_MAX_SAMPLES)
+ * @return true if armed, false if out of range or a capture is running
+ */
+bool burst_arm(uint32_t pre_samples, uint32_t post_samples);
+
+/**
+ * @brief Trigger an armed ring at a sample (ignored otherwise)
+ *
+ * @param sequence Sequence number of the trigger sample, pushed already
+ */
+void burst_trigger(uint32_t sequence);
+
+/**
+ * @brief Capture one sample (every published sample, in order)
+ *
+ * Freezes the ring with the last one.
+ */
+void burst_push(const sensor_data_t *sample);
+
+/**
+ * @brief Queue captured samples to the FIFO while it has room
+ */
+void burst_poll(void);
+
+/**
+ * @brief Current state
+ */
+burst_state_t burst_get_state(void);
+
+/**
+ * @brief Whether live samples are kept out of the FIFO (burst capture,
+ *        draining)
+ */
+bool burst_owns_fifo(void);
+
+/**
+ * @brief Samples in the ring, or still to queue (draining)
+ */
+uint32_t burst_get_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BURST_H */
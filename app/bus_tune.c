@@ -0,0 +1,257 @@
+/**
+ * @file bus_tune.c
+ * @brief Sensor bus speed tuning implementation
+ *
+ * Runs on the blocking transport, before the sampling tick and the async
+ * transfers start. A round fails on a NACK, a bus error, a bad CRC-4, or
+ * words differing from the first round: a PROM of all zeros passes the
+ * CRC, so the words must also be the same every time.
+ */
+
+#include "bus_tune.h"
+
+#if BOARD_I2C_TUNE_ENABLE
+
+#include "stm32l0xx_hal.h"
+#include "hal_config.h"
+#include "ms58.h"
+#include "ms58_hal_wrapper.h"
+#include "timebase.h"
+#include "warm_restart.h"
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define BUS_TUNE_PROM_WORDS  7U
+
+#if BOARD_I2C3_MUX_CHANNELS != 0
+#define BUS_TUNE_BUSES       2U
+#else
+#define BUS_TUNE_BUSES       1U
+#endif
+
+/**
+ * @brief One sensor bus
+ */
+typedef struct {
+    I2C_HandleTypeDef *hi2c;
+    uint8_t sensor_addr;
+    uint8_t mux_addr;
+    uint8_t channels;                          /* Populated mux channels, 0: no mux */
+    hal_i2c_speed_t fallback;                  /* BOARD_I2Cx_SPEED */
+    void (*set_speed)(hal_i2c_speed_t speed);
+    bool (*init)(void);
+} bus_tune_def_t;
+
+/**
+ * @brief Speeds kept for a warm boot
+ */
+typedef struct {
+    uint8_t report[BUS_TUNE_BUSES];
+    uint8_t check;                             /* Complement of the report sum */
+} bus_tune_warm_t;
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static const bus_tune_def_t bus_defs[BUS_TUNE_BUSES] = {
+    { &hi2c2, BOARD_I2C2_SENSOR_ADDR, BOARD_I2C2_MUX_ADDR, BOARD_SENSOR_MUX_CHANNELS,
+      BOARD_I2C2_SPEED, hal_i2c2_set_speed, hal_i2c2_init },
+#if BUS_TUNE_BUSES > 1U
+    { &hi2c3, BOARD_I2C3_SENSOR_ADDR, BOARD_I2C3_MUX_ADDR, BOARD_I2C3_MUX_CHANNELS,
+      BOARD_I2C3_SPEED, hal_i2c3_set_speed, hal_i2c3_init },
+#endif
+};
+
+static uint8_t reports[BUS_TUNE_BUSES];
+
+#if BOARD_WARM_RESTART_ENABLE
+static bus_tune_warm_t bus_tune_warm NOINIT;
+#endif
+
+/* I2C2 bus recoveries in the current window (sampling tick only) */
+static uint8_t error_count = 0;
+static uint32_t error_window_start_us = 0;
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+#if BOARD_WARM_RESTART_ENABLE
+static uint8_t bus_tune_warm_check(const bus_tune_warm_t *warm)
+{
+    uint8_t sum = 0;
+
+    for (uint32_t i = 0; i < BUS_TUNE_BUSES; i++) {
+        sum = (uint8_t)(sum + warm->report[i]);
+    }
+    return (uint8_t)~sum;
+}
+
+static void bus_tune_warm_save(void)
+{
+    for (uint32_t i = 0; i < BUS_TUNE_BUSES; i++) {
+        bus_tune_warm.report[i] = reports[i];
+    }
+    bus_tune_warm.check = bus_tune_warm_check(&bus_tune_warm);
+}
+#endif
+
+/**
+ * @brief Switch a bus to a profile, freeing I2C2 first if a try left it stuck
+ */
+static bool bus_tune_apply(const bus_tune_def_t *def, hal_i2c_speed_t speed)
+{
+    def->set_speed(speed);
+    if (def->hi2c == &hi2c2 && hal_i2c2_bus_fault()) {
+        return hal_i2c2_recover();  /* Re-inits at the new speed */
+    }
+    return def->init();
+}
+
+/**
+ * @brief BOARD_I2C_TUNE_ROUNDS good, identical PROM reads from one probe
+ */
+static bool bus_tune_probe_ok(const ms583730ba01_h *handle)
+{
+    uint16_t first[BUS_TUNE_PROM_WORDS];
+    uint16_t words[BUS_TUNE_PROM_WORDS];
+
+    for (uint32_t round = 0; round < BOARD_I2C_TUNE_ROUNDS; round++) {
+        uint16_t *dst = (round == 0U) ? first : words;
+
+        if (ms5837_read_prom(handle, dst) != E_MS58370BA01_SUCCESS) {
+            return false;
+        }
+        for (uint32_t i = 0; round != 0U && i < BUS_TUNE_PROM_WORDS; i++) {
+            if (words[i] != first[i]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Every probe of a bus passes at the speed in effect
+ */
+static bool bus_tune_bus_ok(const bus_tune_def_t *def)
+{
+    ms58_hal_dev_t dev;
+    ms583730ba01_h handle = ms58_get_hal_handle(&dev, def->hi2c, def->sensor_addr);
+    bool ok = true;
+
+    if (handle.write_cmd == NULL) {
+        return false;
+    }
+    if (def->channels == 0U) {
+        return bus_tune_probe_ok(&handle);
+    }
+
+    for (uint32_t ch = 0; ok && ch < 8U; ch++) {
+        if ((def->channels & (1U << ch)) != 0U) {
+            ok = ms58_hal_mux_select(def->hi2c, def->mux_addr, (uint8_t)(1U << ch)) ==
+                     E_MS58370BA01_SUCCESS &&
+                 bus_tune_probe_ok(&handle);
+        }
+    }
+    (void)ms58_hal_mux_select(def->hi2c, def->mux_addr, 0);
+    return ok;
+}
+
+/**
+ * @brief Step one bus down from BOARD_I2C_TUNE_TOP, settle with the margin
+ *
+ * @return Report byte
+ */
+static uint8_t bus_tune_bus(const bus_tune_def_t *def)
+{
+    int32_t speed;
+    uint8_t report;
+
+    for (speed = (int32_t)BOARD_I2C_TUNE_TOP; speed >= (int32_t)HAL_I2C_SPEED_STANDARD; speed--) {
+        if (bus_tune_apply(def, (hal_i2c_speed_t)speed) && bus_tune_bus_ok(def)) {
+            break;
+        }
+    }
+
+    if (speed < (int32_t)HAL_I2C_SPEED_STANDARD) {
+        speed = (int32_t)def->fallback;
+        report = 0;
+    } else {
+        speed -= (int32_t)BOARD_I2C_TUNE_MARGIN;
+        if (speed < (int32_t)HAL_I2C_SPEED_STANDARD) {
+            speed = (int32_t)HAL_I2C_SPEED_STANDARD;
+        }
+        report = BUS_TUNE_TUNED;
+    }
+
+    (void)bus_tune_apply(def, (hal_i2c_speed_t)speed);
+    return (uint8_t)(report | (uint8_t)speed);
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+bool bus_tune_init(void)
+{
+    bool all_ok = true;
+
+#if BOARD_WARM_RESTART_ENABLE
+    if (warm_restart_is_warm() && bus_tune_warm.check == bus_tune_warm_check(&bus_tune_warm)) {
+        for (uint32_t i = 0; i < BUS_TUNE_BUSES; i++) {
+            reports[i] = bus_tune_warm.report[i];
+            (void)bus_tune_apply(&bus_defs[i], (hal_i2c_speed_t)(reports[i] & BUS_TUNE_SPEED_MASK));
+            all_ok = all_ok && (reports[i] & BUS_TUNE_TUNED) != 0U;
+        }
+        return all_ok;
+    }
+#endif
+
+    for (uint32_t i = 0; i < BUS_TUNE_BUSES; i++) {
+        reports[i] = bus_tune_bus(&bus_defs[i]);
+        all_ok = all_ok && (reports[i] & BUS_TUNE_TUNED) != 0U;
+    }
+
+#if BOARD_WARM_RESTART_ENABLE
+    bus_tune_warm_save();
+#endif
+    return all_ok;
+}
+
+void bus_tune_on_bus_error(void)
+{
+    uint32_t now_us = timebase_now_us();
+    hal_i2c_speed_t speed = hal_i2c2_get_speed();
+
+    if (error_count == 0U ||
+        now_us - error_window_start_us > BOARD_I2C_TUNE_WINDOW_MS * 1000UL) {
+        error_count = 0;
+        error_window_start_us = now_us;
+    }
+    if (++error_count < BOARD_I2C_TUNE_ERRORS) {
+        return;
+    }
+    error_count = 0;
+
+    if (speed > HAL_I2C_SPEED_STANDARD) {
+        speed = (hal_i2c_speed_t)(speed - 1);
+        hal_i2c2_set_speed(speed);
+        (void)hal_i2c2_init();
+        reports[BUS_TUNE_I2C2] = (uint8_t)((reports[BUS_TUNE_I2C2] & BUS_TUNE_TUNED) |
+                                           BUS_TUNE_LOWERED | (uint8_t)speed);
+#if BOARD_WARM_RESTART_ENABLE
+        bus_tune_warm_save();
+#endif
+    }
+}
+
+uint8_t bus_tune_get_report(bus_tune_bus_t bus)
+{
+    return ((uint32_t)bus < BUS_TUNE_BUSES) ? reports[bus] : 0U;
+}
+
+#endif /* BOARD_I2C_TUNE_ENABLE */
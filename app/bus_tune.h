@@ -0,0 +1,95 @@
+#ifndef BUS_TUNE_H
+#define BUS_TUNE_H
+
+/**
+ * @file bus_tune.h
+ * @brief Sensor bus speed tuning at boot and after bus errors
+ *
+ * Cable length sets how fast a sensor bus can run, so no one speed fits
+ * every installation. At boot each sensor bus (I2C2, and I2C3 with
+ * BOARD_I2C3_MUX_CHANNELS) is tried from BOARD_I2C_TUNE_TOP downwards: a
+ * profile passes when every probe on the bus (each populated mux channel,
+ * or the single sensor) returns BOARD_I2C_TUNE_ROUNDS PROM reads in a row
+ * with a good CRC-4. PROM reads change nothing in the sensor, and seven
+ * words of known checksum catch a bit slipped anywhere in 112. The bus
+ * then runs BOARD_I2C_TUNE_MARGIN profiles below the fastest that passed
+ * (never below standard), since a bus that only just passes at boot does
+ * not when the cable warms up. If none passes, BOARD_I2Cx_SPEED stays and
+ * bring-up reports the sensor as before.
+ *
+ * In service, BOARD_I2C_TUNE_ERRORS bus recoveries (sensor_sampling.c)
+ * within BOARD_I2C_TUNE_WINDOW_MS lower I2C2 by one more profile; speeds
+ * only go back up at the next cold boot. A warm boot (warm_restart.h)
+ * keeps the speeds of the previous one without a new scan: the sensor may
+ * still be converting.
+ *
+ * Chosen speeds are reported at APP_REG_I2C2_SPEED / APP_REG_I2C3_SPEED:
+ *   [1:0] hal_i2c_speed_t in effect
+ *   [6]   lowered after bus errors since the tuning
+ *   [7]   tuned (0: BOARD_I2Cx_SPEED, tuning off or no profile passed)
+ * Built only with BOARD_I2C_TUNE_ENABLE.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+#define BUS_TUNE_SPEED_MASK  0x03U
+#define BUS_TUNE_LOWERED     0x40U
+#define BUS_TUNE_TUNED       0x80U
+
+/**
+ * @brief Sensor buses
+ */
+typedef enum {
+    BUS_TUNE_I2C2 = 0,
+    BUS_TUNE_I2C3,      /* BOARD_I2C3_MUX_CHANNELS */
+    BUS_TUNE_BUS_COUNT
+} bus_tune_bus_t;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Tune every sensor bus (blocking)
+ *
+ * Call once, after hal_i2c2_init() / hal_i2c3_init() and before anything
+ * talks to the sensors; leaves each bus initialized at its chosen speed
+ * and the muxes with no channel selected. Worst case, all three profiles
+ * tried on a full I2C2 mux: some 60 ms.
+ *
+ * @return true if every bus passed at some profile
+ */
+bool bus_tune_init(void);
+
+/**
+ * @brief Count a bus recovery of I2C2, lowering its speed when due
+ *
+ * Called after each hal_i2c2_recover() that freed the bus (retries of a
+ * line still held low are not counted); re-inits I2C2 when the speed
+ * changes. Same context as the recovery (sampling tick).
+ */
+void bus_tune_on_bus_error(void);
+
+/**
+ * @brief Speed report of a bus
+ *
+ * @param bus Sensor bus
+ * @return Report byte (bit layout above), 0 for a bus not built
+ */
+uint8_t bus_tune_get_report(bus_tune_bus_t bus);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BUS_TUNE_H */
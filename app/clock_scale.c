@@ -0,0 +1,98 @@
+/**
+ * @file clock_scale.c
+ * @brief Clock scaling policy implementation
+ *
+ * The state lives in the HAL (board_get_sysclk_freq()): the flag here is
+ * its copy for the one-load boost, both changed with interrupts masked.
+ * The divided spans are timed on the microsecond timebase, which the
+ * switch keeps counting.
+ */
+
+#include "clock_scale.h"
+
+#if BOARD_CLOCK_SCALE_ENABLE
+
+#include <stddef.h>
+#include "hal_config.h"
+#include "hal_atomic.h"
+#include "timebase.h"
+#include "i2c_slave.h"
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static volatile bool scaled = false;
+static uint32_t low_since_us = 0;
+static uint32_t low_us = 0;
+static uint64_t low_total_us = 0;
+static clock_scale_stats_t stats;
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+void clock_scale_idle(void)
+{
+    uint32_t primask;
+
+    if (scaled) {
+        return;
+    }
+
+    primask = hal_crit_enter();
+    if (!scaled && i2c_slave_is_idle() &&
+#if BOARD_ADC_SCAN_PERIOD_MS != 0
+        !hal_adc_scan_is_busy() &&
+#endif
+        hal_tim2_get_idle_us() >= BOARD_CLOCK_SCALE_MIN_IDLE_US) {
+        if (hal_clock_scale_set(true)) {
+            scaled = true;
+            low_since_us = timebase_now_us();
+            stats.drops++;
+        } else {
+            stats.refused++;
+        }
+    }
+    hal_crit_exit(primask);
+}
+
+void clock_scale_boost(void)
+{
+    uint32_t primask;
+    uint32_t span;
+
+    if (!scaled) {
+        return;
+    }
+
+    primask = hal_crit_enter();
+    if (scaled && hal_clock_scale_set(false)) {
+        scaled = false;
+        span = timebase_now_us() - low_since_us;
+        low_us += span;
+        low_total_us += span;
+    }
+    hal_crit_exit(primask);
+}
+
+uint32_t clock_scale_get_low_us(void)
+{
+    return low_us;
+}
+
+void clock_scale_get_stats(clock_scale_stats_t *stats_out)
+{
+    uint32_t primask;
+
+    if (stats_out == NULL) {
+        return;
+    }
+
+    primask = hal_crit_enter();
+    *stats_out = stats;
+    stats_out->low_ms = (uint32_t)(low_total_us / 1000U);
+    hal_crit_exit(primask);
+}
+
+#endif /* BOARD_CLOCK_SCALE_ENABLE */
@@ -0,0 +1,88 @@
+#ifndef CLOCK_SCALE_H
+#define CLOCK_SCALE_H
+
+/**
+ * @file clock_scale.h
+ * @brief Clock scaling policy: the divided clock while only a wait is left
+ *
+ * Drops to BOARD_SYSCLK_FREQ_HZ / BOARD_CLOCK_SCALE_DIV
+ * (hal_clock_scale_set()) where the sampler has armed the conversion
+ * compare and where the main loop goes to sleep, when the next TIM2
+ * interrupt is at least BOARD_CLOCK_SCALE_MIN_IDLE_US away and nothing
+ * else needs the core meanwhile: no sensor transfer or DAC stream (the
+ * HAL refuses), no slave transfer, no ADC scan conversion.
+ *
+ * Back to the profile clock at the TIM2 and I2C1 interrupts and before
+ * each pass of the main loop, so transfers, compensation, filtering and
+ * the slave registers run at it. Every peripheral timing holds at both
+ * clocks: an interrupt served at the divided one (UART, DMA, the sync
+ * input) is only slower.
+ *
+ * Any context. BOARD_CLOCK_SCALE_ENABLE builds.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * TYPES
+ * ============================================================================ */
+
+/**
+ * @brief Switches since boot
+ */
+typedef struct {
+    uint32_t drops;    /* To the divided clock */
+    uint32_t refused;  /* Drops the HAL refused (bus held, preload, DAC stream) */
+    uint32_t low_ms;   /* At the divided clock, finished spans */
+} clock_scale_stats_t;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Drop to the divided clock if nothing is left but a long wait
+ */
+void clock_scale_idle(void);
+
+/**
+ * @brief Back to the profile clock
+ *
+ * One load when already there. Retried by the next call if the HAL
+ * refuses.
+ */
+void clock_scale_boost(void);
+
+/**
+ * @brief Time at the divided clock, finished spans
+ *
+ * @return Microseconds, wrapping like the timebase
+ */
+uint32_t clock_scale_get_low_us(void);
+
+/**
+ * @brief Get the switch counts
+ *
+ * @param stats Receives them
+ */
+void clock_scale_get_stats(clock_scale_stats_t *stats);
+
+#if BOARD_CLOCK_SCALE_ENABLE
+#define CLOCK_SCALE_IDLE()   clock_scale_idle()
+#define CLOCK_SCALE_BOOST()  clock_scale_boost()
+#else
+#define CLOCK_SCALE_IDLE()   ((void)0)
+#define CLOCK_SCALE_BOOST()  ((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLOCK_SCALE_H */
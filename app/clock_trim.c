@@ -0,0 +1,228 @@
+/**
+ * @file clock_trim.c
+ * @brief HSI trimming implementation
+ *
+ * The LSE count is extended to 32 bits on every poll; only the two ends
+ * of a span wait for an LSE edge, with interrupts masked for at most one
+ * LSE period (31 us), so the sampling timebase is read within a few
+ * cycles of it. The error of a span is then exact to the timebase
+ * resolution: 1 us over BOARD_CLOCK_TRIM_SPAN_MS.
+ */
+
+#include "clock_trim.h"
+
+#if BOARD_CLOCK_TRIM_ENABLE
+
+#include <stddef.h>
+#include "stm32l0xx_hal.h"
+#include "hal_atomic.h"
+#include "hal_config.h"
+#include "board_init.h"
+#include "time_sync.h"
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+/* Estimates within half a step need none */
+#define CLOCK_TRIM_DEADBAND_PPB  ((int32_t)BOARD_HSI_TRIM_STEP_PPM * 500)
+
+#define CLOCK_TRIM_SPAN_TICKS    ((uint32_t)((uint64_t)BOARD_CLOCK_TRIM_SPAN_MS * BOARD_LSE_FREQ_HZ / 1000U))
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static clock_trim_status_t status;
+static int32_t left_trim = -1;           /* Code the last step left, -1: none */
+static int32_t left_error_ppb = 0;       /* Its error */
+static uint32_t sync_exchanges = 0;      /* Time-sync exchanges last seen */
+static uint32_t sync_wait = 0;           /* Exchanges still to skip after a step */
+
+#if BOARD_LSE_FITTED
+static uint16_t lse_last = 0;            /* Count at the last poll */
+static uint32_t lse_ticks = 0;           /* Since the span start */
+static uint32_t span_start_us = 0;       /* Sampling timebase at the span start */
+#endif
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static int32_t clock_trim_abs(int32_t value)
+{
+    return (value < 0) ? -value : value;
+}
+
+#if BOARD_LSE_FITTED
+/**
+ * @brief Wait for the next LSE edge and read the sampling timebase on it
+ *
+ * @param now_us Receives hal_tim2_get_timestamp_us() at the edge
+ * @return LSE count after the edge
+ */
+static uint16_t clock_trim_lse_edge(uint32_t *now_us)
+{
+    uint32_t primask;
+    uint16_t start;
+    uint16_t count;
+
+    primask = hal_crit_enter();
+    start = hal_lse_count();
+    do {
+        count = hal_lse_count();
+    } while (count == start);
+    *now_us = hal_tim2_get_timestamp_us();
+    hal_crit_exit(primask);
+    return count;
+}
+
+static void clock_trim_span_start(void)
+{
+    lse_last = clock_trim_lse_edge(&span_start_us);
+    lse_ticks = 0;
+}
+#endif
+
+/**
+ * @brief Take one estimate, stepping the trim if it is due
+ *
+ * @param error_ppb HSI error, positive: fast
+ * @param source CLOCK_TRIM_SOURCE_*
+ */
+static void clock_trim_apply(int32_t error_ppb, uint8_t source)
+{
+    int32_t trim = board_get_hsi_trim();
+    int32_t next;
+
+    status.error_ppb = error_ppb;
+    status.source = source;
+    status.trim = (uint8_t)trim;
+    status.flags = (uint8_t)((status.flags & CLOCK_TRIM_LSE_RUNNING) | CLOCK_TRIM_MEASURED);
+
+    if (clock_trim_abs(error_ppb) <= CLOCK_TRIM_DEADBAND_PPB) {
+        status.flags |= CLOCK_TRIM_SETTLED;
+        return;
+    }
+
+    /* A higher code runs HSI faster */
+    next = (error_ppb > 0) ? trim - 1 : trim + 1;
+    if (next < 0 || next > (int32_t)BOARD_HSI_TRIM_MAX) {
+        status.flags |= CLOCK_TRIM_LIMIT;
+        return;
+    }
+    if (next == left_trim && clock_trim_abs(left_error_ppb) >= clock_trim_abs(error_ppb)) {
+        status.flags |= CLOCK_TRIM_SETTLED;  /* Been there, and no closer */
+        return;
+    }
+
+    left_trim = trim;
+    left_error_ppb = error_ppb;
+    board_set_hsi_trim((uint8_t)next);
+    time_sync_rate_changed(hal_tim2_get_timestamp_us());
+    status.trim = (uint8_t)next;
+    if (status.trims != UINT16_MAX) {
+        status.trims++;
+    }
+
+    /* The next estimate from the new rate only */
+    sync_wait = BOARD_CLOCK_TRIM_EXCHANGES;
+#if BOARD_LSE_FITTED
+    if ((status.flags & CLOCK_TRIM_LSE_RUNNING) != 0U) {
+        clock_trim_span_start();
+    }
+#endif
+}
+
+#if BOARD_LSE_FITTED
+/**
+ * @brief Extend the LSE count; estimate at the end of a span
+ */
+static void clock_trim_poll_lse(void)
+{
+    uint32_t now_us;
+    uint16_t count;
+    int64_t error;
+
+    count = hal_lse_count();
+    lse_ticks += (uint16_t)(count - lse_last);
+    lse_last = count;
+    if (lse_ticks < CLOCK_TRIM_SPAN_TICKS) {
+        return;
+    }
+
+    count = clock_trim_lse_edge(&now_us);
+    lse_ticks += (uint16_t)(count - lse_last);
+
+    /* HSI us against LSE us: (us * f - ticks * 10^6) / (ticks * 10^6), in ppb */
+    error = ((int64_t)(now_us - span_start_us) * BOARD_LSE_FREQ_HZ - (int64_t)lse_ticks * 1000000) *
+            1000 / (int64_t)lse_ticks;
+
+    span_start_us = now_us;
+    lse_last = count;
+    lse_ticks = 0;
+    clock_trim_apply((int32_t)error, CLOCK_TRIM_SOURCE_LSE);
+}
+#endif
+
+/**
+ * @brief Estimate from each new time-sync exchange while locked
+ */
+static void clock_trim_poll_sync(void)
+{
+    time_sync_status_t sync;
+
+    time_sync_get_status(&sync);
+    if (sync.exchanges == sync_exchanges) {
+        return;
+    }
+    sync_exchanges = sync.exchanges;
+    if (sync.state != TIME_SYNC_LOCKED) {
+        return;
+    }
+    if (sync_wait != 0U) {
+        sync_wait--;
+        return;
+    }
+
+    /* skew = master / local - 1: a fast local clock runs it negative */
+    clock_trim_apply((int32_t)(-((int64_t)sync.skew_q32 * 1000000000LL) >> 32),
+                     CLOCK_TRIM_SOURCE_SYNC);
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+void clock_trim_init(void)
+{
+    status.trim = board_get_hsi_trim();
+#if BOARD_LSE_FITTED
+    hal_lse_enable();
+#endif
+}
+
+void clock_trim_poll(void)
+{
+#if BOARD_LSE_FITTED
+    if ((status.flags & CLOCK_TRIM_LSE_RUNNING) == 0U && hal_lse_counter_init()) {
+        status.flags |= CLOCK_TRIM_LSE_RUNNING;
+        clock_trim_span_start();
+        return;
+    }
+    if ((status.flags & CLOCK_TRIM_LSE_RUNNING) != 0U) {
+        clock_trim_poll_lse();
+        return;
+    }
+#endif
+    clock_trim_poll_sync();
+}
+
+void clock_trim_get_status(clock_trim_status_t *status_out)
+{
+    if (status_out != NULL) {
+        *status_out = status;
+    }
+}
+
+#endif /* BOARD_CLOCK_TRIM_ENABLE */
@@ -0,0 +1,93 @@
+#ifndef CLOCK_TRIM_H
+#define CLOCK_TRIM_H
+
+/**
+ * @file clock_trim.h
+ * @brief HSI trimming against LSE or the master's clock
+ *
+ * With no crystal, every clock on the board comes from HSI16, which is
+ * off by up to 1 % and drifts with temperature; the sample period drifts
+ * with it. Its error is measured against one reference:
+ *   - LSE, with BOARD_LSE_FITTED, once the crystal has started: LSE
+ *     cycles counted on LPTIM1 against the sampling timebase over
+ *     BOARD_CLOCK_TRIM_SPAN_MS, both ends taken on an LSE edge
+ *   - otherwise the master's clock, from the drift the time-sync
+ *     exchanges estimate (time_sync.h), once locked
+ * An estimate off by more than half a step (BOARD_HSI_TRIM_STEP_PPM)
+ * moves HSITRIM one code towards it, and the next estimate starts from
+ * the new rate: BOARD_CLOCK_TRIM_EXCHANGES exchanges later for the time
+ * sync, a whole span later for LSE. A step is not taken back to the code
+ * just left unless that one measured closer, so an uneven step (across a
+ * multiple of 16) cannot swing the trim between two codes.
+ *
+ * One HSITRIM code is far coarser than a ppm: what is left after the trim
+ * is the error reported (clock_trim_get_status(), performance bank
+ * version 5). With the time sync locked, the timestamps the master reads
+ * are in its clock to well under a ppm regardless.
+ *
+ * Main loop only (clock_trim_poll() at least every second).
+ * BOARD_CLOCK_TRIM_ENABLE builds.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+/* clock_trim_status_t source */
+#define CLOCK_TRIM_SOURCE_NONE   0U
+#define CLOCK_TRIM_SOURCE_LSE    1U
+#define CLOCK_TRIM_SOURCE_SYNC   2U  /* Time-sync drift estimate */
+
+/* clock_trim_status_t flags */
+#define CLOCK_TRIM_MEASURED      0x01U  /* error_ppb holds an estimate */
+#define CLOCK_TRIM_SETTLED       0x02U  /* No step due at the last estimate */
+#define CLOCK_TRIM_LSE_RUNNING   0x04U  /* LSE started and counted */
+#define CLOCK_TRIM_LIMIT         0x08U  /* Step due past the end of the trim range */
+
+/**
+ * @brief Trim state
+ */
+typedef struct {
+    int32_t error_ppb;  /* HSI error at the last estimate, ppb (positive: fast) */
+    uint8_t trim;       /* HSITRIM code in effect */
+    uint8_t source;     /* CLOCK_TRIM_SOURCE_* of the last estimate */
+    uint8_t flags;      /* CLOCK_TRIM_* */
+    uint16_t trims;     /* Steps taken since boot (saturated) */
+} clock_trim_status_t;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Start the reference (LSE oscillator when fitted)
+ *
+ * Call once, after the sampling timebase is running.
+ */
+void clock_trim_init(void);
+
+/**
+ * @brief Take an estimate when one is due, and step the trim
+ */
+void clock_trim_poll(void);
+
+/**
+ * @brief Get the trim state
+ *
+ * @param status Receives it
+ */
+void clock_trim_get_status(clock_trim_status_t *status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLOCK_TRIM_H */
@@ -0,0 +1,119 @@
+/**
+ * @file config.c
+ * @brief Runtime configuration block in the data EEPROM implementation
+ *
+ * Copies are only ever read through the memory-mapped EEPROM. A save
+ * writes the block in word order with the CRC word last, so until the
+ * save completes the copy being written fails its check and the other one
+ * stays in use.
+ */
+
+#include "config.h"
+
+#include <stddef.h>
+#include "board_config.h"
+#include "eeprom.h"
+#include "crc.h"
+#include "stm32l0xx_hal.h"  /* For DATA_EEPROM_BASE */
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define CONFIG_BLOCK_WORDS  (sizeof(config_block_t) / 4U)
+
+#if (BOARD_EEPROM_CONFIG_A_OFFSET & 0x3U) != 0U || (BOARD_EEPROM_CONFIG_B_OFFSET & 0x3U) != 0U || \
+    BOARD_EEPROM_CONFIG_B_OFFSET < BOARD_EEPROM_CONFIG_A_OFFSET + CONFIG_BLOCK_BYTES || \
+    BOARD_EEPROM_LOG_OFFSET < BOARD_EEPROM_CONFIG_B_OFFSET + CONFIG_BLOCK_BYTES
+#error "Configuration copies must be word aligned, CONFIG_BLOCK_BYTES each, before the record ring"
+#endif
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static const config_block_t *stored = NULL;  /* Newest valid copy, NULL = none */
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static const config_block_t *config_copy(uint32_t offset)
+{
+    return (const config_block_t *)(DATA_EEPROM_BASE + offset);
+}
+
+static uint32_t config_crc(const config_block_t *block)
+{
+    return crc16_update(CRC16_INIT, block, offsetof(config_block_t, crc));
+}
+
+/**
+ * @brief Copy complete and written by this layout
+ */
+static bool config_is_valid(const config_block_t *block)
+{
+    return block->magic == CONFIG_MAGIC && block->version == CONFIG_VERSION &&
+           block->size == sizeof(config_block_t) && block->crc == config_crc(block);
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+void config_init(void)
+{
+    const config_block_t *a = config_copy(BOARD_EEPROM_CONFIG_A_OFFSET);
+    const config_block_t *b = config_copy(BOARD_EEPROM_CONFIG_B_OFFSET);
+    bool a_valid = config_is_valid(a);
+    bool b_valid = config_is_valid(b);
+    
+    if (a_valid && b_valid) {
+        /* Generations count up from 1 and may wrap */
+        stored = ((int32_t)(b->generation - a->generation) > 0) ? b : a;
+    } else if (a_valid) {
+        stored = a;
+    } else {
+        stored = b_valid ? b : NULL;
+    }
+}
+
+const config_block_t *config_get(void)
+{
+    return stored;
+}
+
+bool config_save(const config_block_t *block)
+{
+    config_block_t image = *block;
+    uint32_t offset = (stored == config_copy(BOARD_EEPROM_CONFIG_A_OFFSET)) ?
+                      BOARD_EEPROM_CONFIG_B_OFFSET : BOARD_EEPROM_CONFIG_A_OFFSET;
+    
+    image.magic = CONFIG_MAGIC;
+    image.version = CONFIG_VERSION;
+    image.size = (uint16_t)sizeof(config_block_t);
+    image.generation = (stored != NULL) ? stored->generation + 1U : 1U;
+    image.crc = config_crc(&image);
+    
+    /* The copy in use is left alone: a reset before the CRC word is
+     * written keeps it */
+    if (!eeprom_write_words(offset, (const uint32_t *)&image, CONFIG_BLOCK_WORDS) ||
+        !config_is_valid(config_copy(offset))) {
+        return false;
+    }
+    
+    stored = config_copy(offset);
+    return true;
+}
+
+bool config_clear(void)
+{
+    const uint32_t none = 0;
+    bool cleared;
+    
+    cleared = eeprom_write_words(BOARD_EEPROM_CONFIG_A_OFFSET, &none, 1U);
+    cleared = eeprom_write_words(BOARD_EEPROM_CONFIG_B_OFFSET, &none, 1U) && cleared;
+    
+    stored = NULL;
+    return cleared;
+}
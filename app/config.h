@@ -0,0 +1,125 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+/**
+ * @file config.h
+ * @brief Runtime configuration block in the data EEPROM
+ *
+ * The settings a master can change at runtime (sampling profile, tick
+ * rate, filter, DAC mapping, derived quantity) and the I2C slave address,
+ * kept across resets in two copies, A at BOARD_EEPROM_CONFIG_A_OFFSET and
+ * B at BOARD_EEPROM_CONFIG_B_OFFSET. At boot the copies are checked in place
+ * (the EEPROM is memory-mapped: two CRC-16 over 60 bytes, no parsing) and
+ * the valid one with the higher generation is used straight from the
+ * EEPROM. A save writes the other copy with the next generation, so a
+ * reset in the middle of a save leaves the previous copy in use.
+ *
+ * Block (little-endian, config_block_t):
+ *   0   magic       uint32, CONFIG_MAGIC
+ *   4   version     uint16, CONFIG_VERSION
+ *   6   size        uint16, sizeof(config_block_t)
+ *   8   generation  uint32, higher of two valid copies wins
+ *   12  slave_addr, pressure_osr, temperature_osr, reserved (uint8 each)
+ *   16  rate_hz     uint32, tick rate
+ *   20  filter      uint32, HOST_CMD_SET_FILTER argument
+ *   24  dac_maps    2 x 16 bytes (config_dac_map_t), OUT1 then OUT2
+ *   56  derived     uint32, HOST_CMD_DERIVED argument (reference resolved)
+ *   60  crc         uint32, CRC-16 (crc.h) of bytes 0..59 in the low half
+ *
+ * No valid copy: the built-in (BOARD_*) settings. Main loop only (the
+ * host task in RTOS builds).
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+#define CONFIG_MAGIC        0x47464E43UL  /* "CNFG" */
+#define CONFIG_VERSION      2U
+#define CONFIG_DAC_MAPS     2U
+#define CONFIG_BLOCK_BYTES  64U           /* EEPROM reserved per copy */
+
+/**
+ * @brief One DAC output mapping (app_dac_map_t, fixed layout)
+ */
+typedef struct {
+    uint8_t source;      /* app_dac_source_t */
+    uint8_t clamp;       /* app_dac_clamp_t */
+    uint16_t code_min;
+    uint16_t code_max;
+    uint16_t reserved;
+    int32_t in_min;
+    int32_t in_max;
+} config_dac_map_t;
+
+/**
+ * @brief Configuration block, as stored
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;
+    uint32_t generation;
+    uint8_t slave_addr;       /* 7-bit I2C1 slave address */
+    uint8_t pressure_osr;     /* sensor_osr_t */
+    uint8_t temperature_osr;  /* sensor_osr_t */
+    uint8_t reserved;
+    uint32_t rate_hz;
+    uint32_t filter;          /* Mode [7:0], pressure log2 [15:8], temperature log2 [23:16],
+                               * median window [27:24] */
+    config_dac_map_t dac_maps[CONFIG_DAC_MAPS];
+    uint32_t derived;         /* Quantity [27:24], reference pressure [23:0]; 0 = built-in */
+    uint32_t crc;
+} config_block_t;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Pick the configuration copy to use
+ *
+ * Needs the CRC unit (crc_init()).
+ */
+void config_init(void);
+
+/**
+ * @brief Stored configuration: the one applied at boot, or the last saved
+ *
+ * @return The newest valid copy in the EEPROM (read it in place), or NULL
+ *         when none is stored: the built-in settings apply
+ */
+const config_block_t *config_get(void);
+
+/**
+ * @brief Store a configuration in the other copy (blocking, ~3.2 ms per
+ *        changed word)
+ *
+ * Fills in magic, version, size, generation and crc; from the next reset
+ * on the stored settings apply.
+ *
+ * @param block Settings to store
+ * @return true if the copy was written and reads back valid
+ */
+bool config_save(const config_block_t *block);
+
+/**
+ * @brief Invalidate both copies (blocking): the built-in settings apply
+ *        from the next reset
+ *
+ * @return true if both copies were cleared
+ */
+bool config_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONFIG_H */
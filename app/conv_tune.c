@@ -0,0 +1,203 @@
+/**
+ * @file conv_tune.c
+ * @brief Conversion time calibration implementation
+ *
+ * Runs on the blocking transport, like the bus tuning and the self-test,
+ * before the sampling tick and the async transfers start. The delay of a
+ * trial runs from the end of the conversion command to the start of the
+ * ADC read, as the sampler's waits do. A read that came too early leaves
+ * the conversion uncertain, so a failed trial waits out the datasheet
+ * time and reads once more before the next command. An interrupt during a
+ * trial only lengthens its delay: a unit passing just so is what the
+ * margin is for.
+ */
+
+#include "conv_tune.h"
+
+#if BOARD_CONV_TUNE_ENABLE
+
+#include "stm32l0xx_hal.h"
+#include "hal_config.h"
+#include "ms58.h"
+#include "ms58_regs.h"
+#include "ms58_hal_wrapper.h"
+#include "conv_sensor.h"
+#include "timebase.h"
+#include "warm_restart.h"
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+/**
+ * @brief Report kept for a warm boot
+ */
+typedef struct {
+    conv_tune_report_t report;
+    uint32_t check;                            /* Over the report bytes */
+} conv_tune_warm_t;
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static conv_tune_report_t report = {
+    { MS5837_CONV_TIME_US_256, MS5837_CONV_TIME_US_512, MS5837_CONV_TIME_US_1024,
+      MS5837_CONV_TIME_US_2048, MS5837_CONV_TIME_US_4096, MS5837_CONV_TIME_US_8192 },
+    0, 0
+};
+
+#if BOARD_WARM_RESTART_ENABLE
+static conv_tune_warm_t conv_tune_warm NOINIT;
+#endif
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+#if BOARD_WARM_RESTART_ENABLE
+static uint32_t conv_tune_warm_check(const conv_tune_warm_t *warm)
+{
+    const uint8_t *byte = (const uint8_t *)&warm->report;
+    uint32_t check = 0;
+
+    for (uint32_t i = 0; i < sizeof(warm->report); i++) {
+        check = ((check << 5) | (check >> 27)) ^ byte[i];
+    }
+    return ~check;
+}
+#endif
+
+/**
+ * @brief Datasheet (maximum) conversion time of a level
+ */
+static uint32_t conv_tune_datasheet_us(uint32_t osr)
+{
+    return ms5837_conv_sensor.conv_time_us[osr];
+}
+
+/**
+ * @brief BOARD_CONV_TUNE_ROUNDS conversions at one delay, all non-zero
+ */
+static bool conv_tune_passes(const ms583730ba01_h *handle, uint32_t osr, uint32_t delay_us)
+{
+    for (uint32_t round = 0; round < BOARD_CONV_TUNE_ROUNDS; round++) {
+        uint8_t cmd = ((round & 1U) == 0U) ? MS5837_CONVERT_D1_256 : MS5837_CONVERT_D2_256;
+        uint32_t adc = 0;
+
+        if (ms5837_start_conversion(handle, (uint8_t)(cmd + 2U * osr)) != E_MS58370BA01_SUCCESS) {
+            return false;
+        }
+        timebase_delay_us(delay_us);
+        if (ms5837_read_adc(handle, &adc) != E_MS58370BA01_SUCCESS || adc == 0U) {
+            /* Let a conversion still running finish before the next one */
+            timebase_delay_us(conv_tune_datasheet_us(osr));
+            (void)ms5837_read_adc(handle, &adc);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Shortest passing delay of a level, to BOARD_CONV_TUNE_STEP_US
+ *
+ * @return Delay, us (0: fails at the datasheet time)
+ */
+static uint32_t conv_tune_search(const ms583730ba01_h *handle, uint32_t osr)
+{
+    uint32_t hi = conv_tune_datasheet_us(osr);
+    uint32_t lo = hi / 2U;  /* Taken as failing: no unit is that fast */
+
+    if (!conv_tune_passes(handle, osr, hi)) {
+        return 0;
+    }
+    while (hi - lo > BOARD_CONV_TUNE_STEP_US) {
+        uint32_t mid = lo + (hi - lo) / 2U;
+
+        if (conv_tune_passes(handle, osr, mid)) {
+            hi = mid;
+        } else {
+            lo = mid;
+        }
+    }
+    return hi;
+}
+
+/**
+ * @brief Time in use for a measured (or scaled) delay: margin, then capped
+ */
+static uint16_t conv_tune_with_margin(uint32_t osr, uint32_t found_us)
+{
+    uint32_t us = found_us + (found_us * BOARD_CONV_TUNE_MARGIN_PCT + 99U) / 100U;
+    uint32_t datasheet_us = conv_tune_datasheet_us(osr);
+
+    return (uint16_t)((us < datasheet_us) ? us : datasheet_us);
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+bool conv_tune_init(void)
+{
+    ms58_hal_dev_t dev;
+    ms583730ba01_h handle = ms58_get_hal_handle(&dev, &hi2c2, BOARD_I2C2_SENSOR_ADDR);
+    uint32_t levels = ms5837_conv_sensor.osr_count;
+    uint32_t top_found_us = 0;
+    uint32_t top = 0;
+
+#if BOARD_WARM_RESTART_ENABLE
+    if (warm_restart_is_warm() && conv_tune_warm.check == conv_tune_warm_check(&conv_tune_warm)) {
+        report = conv_tune_warm.report;
+        report.flags |= CONV_TUNE_KEPT;
+        return (report.flags & CONV_TUNE_FALLBACK) == 0U;
+    }
+#endif
+
+    if (levels > CONV_TUNE_LEVELS) {
+        levels = CONV_TUNE_LEVELS;
+    }
+    report.flags = CONV_TUNE_RAN;
+    /* ms5837_reset() waits out the reload */
+    if (handle.write_cmd == NULL || ms5837_reset(&handle) != E_MS58370BA01_SUCCESS) {
+        report.flags |= CONV_TUNE_FALLBACK;
+        return false;
+    }
+
+    for (uint32_t osr = 0; osr < levels; osr++) {
+        uint32_t found_us;
+
+        if (osr <= BOARD_CONV_TUNE_TOP_OSR) {
+            found_us = conv_tune_search(&handle, osr);
+            if (found_us == 0U) {
+                report.flags |= CONV_TUNE_FALLBACK;
+                break;  /* This level and those above keep the datasheet times */
+            }
+            report.measured |= (uint8_t)(1U << osr);
+            top_found_us = found_us;
+            top = osr;
+        } else {
+            found_us = conv_tune_datasheet_us(osr) * top_found_us / conv_tune_datasheet_us(top);
+        }
+        report.conv_us[osr] = conv_tune_with_margin(osr, found_us);
+    }
+
+#if BOARD_WARM_RESTART_ENABLE
+    conv_tune_warm.report = report;
+    conv_tune_warm.check = conv_tune_warm_check(&conv_tune_warm);
+#endif
+    return (report.flags & CONV_TUNE_FALLBACK) == 0U;
+}
+
+uint16_t conv_tune_get_us(uint8_t osr)
+{
+    return (osr < CONV_TUNE_LEVELS) ? report.conv_us[osr] : 0U;
+}
+
+const conv_tune_report_t *conv_tune_get_report(void)
+{
+    return &report;
+}
+
+#endif /* BOARD_CONV_TUNE_ENABLE */
@@ -0,0 +1,96 @@
+#ifndef CONV_TUNE_H
+#define CONV_TUNE_H
+
+/**
+ * @file conv_tune.h
+ * @brief Conversion time calibration of the sensor at boot
+ *
+ * The sampler waits out the datasheet maximum conversion time of each OSR
+ * before reading the ADC, and a read that comes too early returns 0. The
+ * actual time is set by the oscillator of each sensor, and most units
+ * finish well before the maximum. At a cold boot, after the self-test
+ * (self_test.h) and before bring-up, the single sensor is reset and for
+ * each OSR up to BOARD_CONV_TUNE_TOP_OSR the shortest delay is found by
+ * binary search between half the datasheet time and the datasheet time,
+ * to BOARD_CONV_TUNE_STEP_US: a delay passes when BOARD_CONV_TUNE_ROUNDS
+ * conversions in a row (D1 and D2 in turn) all read non-zero. The level
+ * then runs at that delay plus BOARD_CONV_TUNE_MARGIN_PCT, never above
+ * the datasheet time. Levels above BOARD_CONV_TUNE_TOP_OSR take the ratio
+ * measured at the top one (the same oscillator times every level) rather
+ * than tens of milliseconds of trials each.
+ *
+ * If a level fails even at its datasheet time, that level and those above
+ * it keep the datasheet times. A warm boot (warm_restart.h) keeps the
+ * times of the previous one without a new search: the sensor may still be
+ * converting. sensor_sampling_init() takes the times from here.
+ *
+ * The report is appended to the performance bank (perf_bank.h version 9).
+ * Built only with BOARD_CONV_TUNE_ENABLE (single sensor, not the mux rig).
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+#define CONV_TUNE_LEVELS    6U     /* MS5837 OSR 256 .. 8192 */
+
+/* conv_tune_report_t flags */
+#define CONV_TUNE_RAN       0x01U  /* Searched at this boot or the cold boot before */
+#define CONV_TUNE_KEPT      0x02U  /* Warm boot: times of the previous boot */
+#define CONV_TUNE_FALLBACK  0x04U  /* A level failed at its datasheet time */
+
+/**
+ * @brief Calibration report
+ */
+typedef struct {
+    uint16_t conv_us[CONV_TUNE_LEVELS];  /* Conversion time in use per OSR, us */
+    uint8_t measured;                    /* Bit n: level n searched (others scaled or datasheet) */
+    uint8_t flags;                       /* CONV_TUNE_* */
+} conv_tune_report_t;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Calibrate the conversion times (blocking)
+ *
+ * Call once, after self_test_init() and before anything else talks to the
+ * sensor; resets the sensor first. Worst case at the default settings
+ * (three levels searched, every trial failing late) some 150 ms.
+ *
+ * @return true if every level has a calibrated time
+ */
+bool conv_tune_init(void);
+
+/**
+ * @brief Conversion time of one OSR
+ *
+ * Read by the sampler at init; a level whose reads keep answering 0 is put
+ * back on the datasheet time there (BOARD_SENSOR_LATE_WIDEN_AFTER).
+ *
+ * @param osr OSR index, 0 (256) .. 5 (8192)
+ * @return Time to wait, us (the datasheet time before conv_tune_init())
+ */
+uint16_t conv_tune_get_us(uint8_t osr);
+
+/**
+ * @brief Get the calibration report
+ *
+ * @return Report (datasheet times, no flags, before conv_tune_init())
+ */
+const conv_tune_report_t *conv_tune_get_report(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONV_TUNE_H */
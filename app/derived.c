@@ -0,0 +1,135 @@
+/**
+ * @file derived.c
+ * @brief Depth or altitude from the pressure, by table lookup
+ *
+ * Tables from tools/derived_lut.py: entry i is the height in mm at the
+ * absolute pressure base + i * 2^shift (0.01 mbar). The water tables are
+ * straight lines (fixed density, no compressibility), kept in the same
+ * form so that every quantity takes the same path.
+ */
+
+#include "derived.h"
+
+#include <stddef.h>
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+typedef struct {
+    int32_t base;     /* Pressure of entry 0, 0.01 mbar */
+    uint8_t shift;    /* log2 of the entry spacing */
+    uint16_t count;   /* Entries, at least 2 */
+    const int32_t *mm;
+} derived_table_t;
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static const int32_t derived_fresh_mm[] = { 0, 53623 };
+static const int32_t derived_sea_mm[] = { 0, 52159 };
+
+/* ISA altitude, 300 .. 1201 mbar every 5.12 mbar */
+static const int32_t derived_air_mm[] = {
+    9163953, 9050542, 8938661, 8828266, 8719313, 8611760,
+    8505568, 8400699, 8297116, 8194786, 8093674, 7993749,
+    7894980, 7797337, 7700792, 7605319, 7510890, 7417481,
+    7325067, 7233624, 7143132, 7053566, 6964908, 6877136,
+    6790230, 6704172, 6618944, 6534528, 6450907, 6368064,
+    6285984, 6204650, 6124048, 6044163, 5964981, 5886489,
+    5808673, 5731521, 5655019, 5579155, 5503919, 5429298,
+    5355281, 5281858, 5209017, 5136750, 5065044, 4993892,
+    4923284, 4853209, 4783661, 4714629, 4646105, 4578080,
+    4510548, 4443500, 4376928, 4310825, 4245183, 4179995,
+    4115255, 4050955, 3987089, 3923651, 3860634, 3798031,
+    3735838, 3674047, 3612653, 3551651, 3491035, 3430799,
+    3370938, 3311448, 3252322, 3193556, 3135146, 3077086,
+    3019371, 2961998, 2904961, 2848257, 2791880, 2735828,
+    2680095, 2624677, 2569571, 2514773, 2460279, 2406085,
+    2352188, 2298583, 2245268, 2192239, 2139492, 2087024,
+    2034832, 1982913, 1931264, 1879881, 1828761, 1777901,
+    1727299, 1676952, 1626856, 1577009, 1527408, 1478050,
+    1428933, 1380055, 1331412, 1283002, 1234822, 1186871,
+    1139146, 1091644, 1044362, 997300, 950455, 903823,
+    857404, 811195, 765193, 719397, 673806, 628416,
+    583225, 538233, 493436, 448833, 404423, 360202,
+    316170, 272325, 228665, 185188, 141892, 98776,
+    55838, 13077, -29509, -71922, -114164, -156235,
+    -198137, -239873, -281442, -322848, -364091, -405172,
+    -446094, -486857, -527462, -567912, -608208, -648350,
+    -688340, -728180, -767871, -807413, -846808, -886058,
+    -925163, -964125, -1002945, -1041624, -1080163, -1118564,
+    -1156826, -1194953, -1232944, -1270800, -1308524, -1346115,
+    -1383575, -1420904, -1458105
+};
+
+static const derived_table_t derived_tables[DERIVED_COUNT] = {
+    [DERIVED_DEPTH_FRESH] = { 0, 19U, 2U, derived_fresh_mm },
+    [DERIVED_DEPTH_SEA]   = { 0, 19U, 2U, derived_sea_mm },
+    [DERIVED_ALTITUDE]    = { 30000, 9U, (uint16_t)(sizeof(derived_air_mm) / sizeof(derived_air_mm[0])),
+                              derived_air_mm },
+};
+
+static derived_quantity_t quantity = DERIVED_DEPTH_FRESH;
+static int32_t reference = 0;
+static int32_t reference_mm = 0;  /* table(reference) */
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Table height at a pressure (linear between entries, ends held)
+ */
+static int32_t derived_lookup(const derived_table_t *table, int32_t pressure)
+{
+    int32_t top = (int32_t)(((uint32_t)table->count - 1U) << table->shift) - 1;
+    int32_t offset = pressure - table->base;
+    uint32_t i;
+    int32_t frac;
+    int32_t y0;
+    
+    if (offset < 0) {
+        offset = 0;
+    } else if (offset > top) {
+        offset = top;
+    }
+    
+    i = (uint32_t)offset >> table->shift;
+    frac = offset & (int32_t)((1UL << table->shift) - 1U);
+    y0 = table->mm[i];
+    return y0 + (int32_t)(((int64_t)(table->mm[i + 1U] - y0) * frac) >> table->shift);
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+bool derived_set(derived_quantity_t new_quantity, int32_t new_reference)
+{
+    if ((uint32_t)new_quantity >= DERIVED_COUNT ||
+        new_reference <= 0 || new_reference > DERIVED_REFERENCE_MAX) {
+        return false;
+    }
+    
+    quantity = new_quantity;
+    reference = new_reference;
+    reference_mm = derived_lookup(&derived_tables[quantity], reference);
+    return true;
+}
+
+derived_quantity_t derived_get_quantity(void)
+{
+    return quantity;
+}
+
+int32_t derived_get_reference(void)
+{
+    return reference;
+}
+
+int32_t derived_from_pressure(int32_t pressure)
+{
+    return derived_lookup(&derived_tables[quantity], pressure) - reference_mm;
+}
@@ -0,0 +1,89 @@
+#ifndef DERIVED_H
+#define DERIVED_H
+
+/**
+ * @file derived.h
+ * @brief Depth or altitude from the pressure, by table lookup
+ *
+ * The height in mm over a reference pressure: water depth (hydrostatic,
+ * fresh or sea water) or altitude (ISA barometric formula). Each quantity
+ * is a piecewise-linear table of height against absolute pressure in
+ * flash, sampled every 2^n units (tools/derived_lut.py), so one sample
+ * costs a shift, a mask and a 64-bit multiply-add: no soft-float pow(),
+ * no division. The result is table(p) - table(reference), exact to
+ * ~2 mm in water and 0.2 m in air at 300 mbar (less near sea level).
+ *
+ * Shown at APP_REG_DERIVED and usable as a DAC mapping source
+ * (APP_DAC_SOURCE_DERIVED). Main loop only, except derived_from_pressure()
+ * from the direct DAC path (BOARD_DAC_DIRECT_ENABLE), which reads the
+ * selection: the sample that crosses a derived_set() may see the old one.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+/**
+ * @brief Derived quantity
+ */
+typedef enum {
+    DERIVED_DEPTH_FRESH = 0,  /* mm below the reference, 997 kg/m^3 */
+    DERIVED_DEPTH_SEA,        /* mm below the reference, 1025 kg/m^3 */
+    DERIVED_ALTITUDE,         /* mm above the reference, ISA */
+    DERIVED_COUNT
+} derived_quantity_t;
+
+/* Highest reference pressure, 0.01 mbar (24-bit command field) */
+#define DERIVED_REFERENCE_MAX  0xFFFFFFL
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Select the quantity and its reference
+ *
+ * app_init() sets BOARD_DERIVED_QUANTITY and BOARD_DERIVED_REFERENCE, then
+ * the stored configuration.
+ *
+ * @param quantity Derived quantity
+ * @param reference Reference pressure, 0.01 mbar (1..DERIVED_REFERENCE_MAX):
+ *                  the surface for a depth, the zero altitude (101325 for
+ *                  ISA sea level, or the pressure at a known point)
+ * @return true if set, false if out of range
+ */
+bool derived_set(derived_quantity_t quantity, int32_t reference);
+
+/**
+ * @brief Current quantity
+ */
+derived_quantity_t derived_get_quantity(void);
+
+/**
+ * @brief Current reference pressure, 0.01 mbar
+ */
+int32_t derived_get_reference(void);
+
+/**
+ * @brief Height of a pressure over the reference
+ *
+ * Pressures outside the table (below 300 mbar or above 1201 mbar in air,
+ * 5242 mbar in water) read as its nearest end.
+ *
+ * @param pressure Pressure, 0.01 mbar
+ * @return mm (positive: deeper in water, higher in air)
+ */
+int32_t derived_from_pressure(int32_t pressure);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DERIVED_H */
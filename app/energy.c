@@ -0,0 +1,150 @@
+/**
+ * @file energy.c
+ * @brief Power-mode residency and average current estimate implementation
+ *
+ * The driver counters are 32-bit microseconds that wrap: each update takes
+ * their differences and adds them to 64-bit totals. The charge of an
+ * update is in uA x us, 64 bits; both divisions run once per update, in
+ * the main loop.
+ */
+
+#include "energy.h"
+
+#if BOARD_ENERGY_ENABLE
+
+#include <stddef.h>
+#include "hal_config.h"
+#include "timebase.h"
+#include "perf.h"
+#include "ms58_hal_wrapper.h"
+#include "dac.h"
+#include "clock_scale.h"
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+/**
+ * @brief Driver counters at one instant
+ */
+typedef struct {
+    uint32_t now_us;
+    uint32_t sleep_us;
+    uint32_t stop_us;
+    uint32_t bus_us;
+    uint32_t dac_us;
+    uint32_t low_us;
+} energy_counts_t;
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static energy_counts_t last;
+static uint64_t run_us = 0;
+static uint64_t sleep_us = 0;
+static uint64_t stop_us = 0;
+static uint64_t bus_us = 0;
+static uint64_t dac_us = 0;
+static uint32_t stops = 0;
+static uint32_t current_deci_ua = 0;
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static void energy_read(energy_counts_t *counts)
+{
+    perf_stats_t perf;
+
+    perf_get_stats(&perf);
+    counts->now_us = timebase_now_us();
+    counts->sleep_us = perf.idle_us;
+    counts->stop_us = perf.stop_us;
+    counts->bus_us = ms58_hal_get_active_us(&hi2c2);
+#if BOARD_I2C3_MUX_CHANNELS != 0
+    counts->bus_us += ms58_hal_get_active_us(&hi2c3);
+#endif
+    counts->dac_us = dac_stream_get_active_us();
+#if BOARD_CLOCK_SCALE_ENABLE
+    counts->low_us = clock_scale_get_low_us();
+#else
+    counts->low_us = 0;
+#endif
+    stops = perf.stops;
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+void energy_init(void)
+{
+    energy_read(&last);
+}
+
+void energy_update(void)
+{
+    energy_counts_t now;
+    uint32_t awake;
+    uint32_t sleep;
+    uint32_t stop;
+    uint32_t bus;
+    uint32_t dac;
+    uint32_t low;
+    uint32_t run;
+    uint64_t total;
+    uint64_t charge;
+
+    energy_read(&now);
+    awake = now.now_us - last.now_us;
+    sleep = now.sleep_us - last.sleep_us;
+    stop = now.stop_us - last.stop_us;
+    bus = now.bus_us - last.bus_us;
+    dac = now.dac_us - last.dac_us;
+    low = now.low_us - last.low_us;
+    last = now;
+
+    /* A sleep span is added when it ends, all of it: one that started
+     * before the last update can outlast the time since */
+    run = (sleep < awake) ? awake - sleep : 0U;
+    run_us += run;
+    sleep_us += sleep;
+    stop_us += stop;
+    bus_us += bus;
+    dac_us += dac;
+
+    total = (uint64_t)run + sleep + stop;
+    if (total == 0U) {
+        return;
+    }
+    /* The clock drops just before the core sleeps: a divided span is
+     * taken as sleep at the divided clock */
+    if (low > sleep) {
+        low = sleep;
+    }
+    charge = (uint64_t)run * BOARD_CURRENT_RUN_UA +
+             (uint64_t)(sleep - low) * BOARD_CURRENT_SLEEP_UA +
+             (uint64_t)low * BOARD_CURRENT_SLEEP_SCALED_UA +
+             (uint64_t)stop * BOARD_CURRENT_STOP_UA +
+             (uint64_t)bus * BOARD_CURRENT_I2C_UA +
+             (uint64_t)dac * BOARD_CURRENT_DAC_STREAM_UA;
+    current_deci_ua = (uint32_t)((charge * 10U + total / 2U) / total);
+}
+
+void energy_get_stats(energy_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+
+    stats->run_ms = (uint32_t)(run_us / 1000U);
+    stats->sleep_ms = (uint32_t)(sleep_us / 1000U);
+    stats->stop_ms = (uint32_t)(stop_us / 1000U);
+    stats->stops = stops;
+    stats->bus_ms = (uint32_t)(bus_us / 1000U);
+    stats->dac_ms = (uint32_t)(dac_us / 1000U);
+    stats->current_deci_ua = current_deci_ua;
+}
+
+#endif /* BOARD_ENERGY_ENABLE */
@@ -0,0 +1,85 @@
+#ifndef ENERGY_H
+#define ENERGY_H
+
+/**
+ * @file energy.h
+ * @brief Power-mode residency and average current estimate
+ *
+ * Where the time goes, from the counters the drivers keep at every mode
+ * transition:
+ *   - sleep: the sleep spans of perf.h (PERF_SLEEP() to the first handler)
+ *   - STOP: the STOP spans of perf.h, timed with the LPTIM1 timebase
+ *     running (main_enter_stop()); others are counted but not timed, like
+ *     the uptime, which halts there too
+ *   - run: the rest of the microsecond timebase
+ *   - sensor buses: asynchronous transfers on the wire, I2C2 and I2C3
+ *     added up (ms58_hal_get_active_us())
+ *   - DAC stream: TIM6 and its DMA running (dac_stream_get_active_us());
+ *     the outputs themselves are on from boot, part of the mode currents
+ *   - divided clock (BOARD_CLOCK_SCALE_ENABLE): clock_scale_get_low_us(),
+ *     charged as sleep at BOARD_CURRENT_SLEEP_SCALED_UA, the clock dropping
+ *     only as the core goes to sleep
+ * Each span is weighted by the current of the board table
+ * (BOARD_CURRENT_*_UA, board_config.h): a mode current plus, for the
+ * peripherals, what they add on top. The charge over the time since the
+ * last update, divided by that time, is the estimated average current.
+ * Performance bank version 8.
+ *
+ * Main loop only. BOARD_ENERGY_ENABLE builds.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * TYPES
+ * ============================================================================ */
+
+/**
+ * @brief Residency since boot and the newest estimate
+ */
+typedef struct {
+    uint32_t run_ms;
+    uint32_t sleep_ms;
+    uint32_t stop_ms;        /* Timed STOP only */
+    uint32_t stops;          /* STOP entries */
+    uint32_t bus_ms;         /* Sensor buses transferring (both added up) */
+    uint32_t dac_ms;         /* DAC stream running */
+    uint32_t current_deci_ua;  /* Average over the last update, 0.1 uA */
+} energy_stats_t;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Start counting from now
+ *
+ * Call once the drivers are up.
+ */
+void energy_init(void);
+
+/**
+ * @brief Add up the time since the last update and estimate its current
+ *
+ * Call at least once per wrap of the microsecond counters (71 min).
+ */
+void energy_update(void);
+
+/**
+ * @brief Get the residency and the newest estimate
+ *
+ * @param stats Receives them
+ */
+void energy_get_stats(energy_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ENERGY_H */
@@ -0,0 +1,184 @@
+/**
+ * @file event_detect.c
+ * @brief Threshold events with hysteresis and debounce implementation
+ *
+ * Per detector and sample: is the value past the edge that would toggle
+ * it (entering while inactive, leaving while active)? Consecutive samples
+ * that are count up to the debounce count, any other sample starts the
+ * count again. Thresholds are compared in 64 bits, so a hysteresis band
+ * reaching past the int32 range needs no special case.
+ */
+
+#include "event_detect.h"
+
+#include <stddef.h>
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define EVENT_QUEUE_MASK  (EVENT_QUEUE_DEPTH - 1U)
+
+#if (EVENT_QUEUE_DEPTH & EVENT_QUEUE_MASK) != 0U || EVENT_DETECTORS > 8U
+#error "EVENT_QUEUE_DEPTH must be a power of 2 and EVENT_DETECTORS at most 8"
+#endif
+
+typedef struct {
+    event_detector_config_t config;
+    bool active;
+    uint8_t count;  /* Consecutive samples past the toggling edge */
+} event_detector_t;
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static event_detector_t detectors[EVENT_DETECTORS];
+static event_record_t queue[EVENT_QUEUE_DEPTH];
+static uint32_t queue_head = 0;
+static uint32_t queue_tail = 0;
+static uint32_t dropped = 0;
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Condition entered (inactive detector) or left (active one)
+ */
+static bool event_detect_toggles(const event_detector_t *d, int32_t value)
+{
+    const event_detector_config_t *c = &d->config;
+    int64_t v = value;
+    int64_t low = c->low;
+    int64_t high = c->high;
+    int64_t h = c->hysteresis;
+    
+    switch (c->condition) {
+    case EVENT_ABOVE:
+        return d->active ? (v < low - h) : (v > low);
+    case EVENT_BELOW:
+        return d->active ? (v > low + h) : (v < low);
+    case EVENT_OUTSIDE:
+        return d->active ? (v >= low + h && v <= high - h) : (v < low || v > high);
+    case EVENT_INSIDE:
+        return d->active ? (v < low - h || v > high + h) : (v >= low && v <= high);
+    default:
+        return false;
+    }
+}
+
+static void event_detect_queue(uint8_t detector, bool active, int32_t value, uint32_t sequence)
+{
+    event_record_t *record;
+    
+    if (queue_head - queue_tail >= EVENT_QUEUE_DEPTH) {
+        if (dropped != UINT32_MAX) {
+            dropped++;
+        }
+        return;
+    }
+    
+    record = &queue[queue_head & EVENT_QUEUE_MASK];
+    record->detector = detector;
+    record->active = active;
+    record->value = value;
+    record->sequence = sequence;
+    queue_head++;
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+bool event_detect_configure(uint8_t detector, const event_detector_config_t *config)
+{
+    if (detector >= EVENT_DETECTORS || config == NULL ||
+        (uint32_t)config->condition >= EVENT_CONDITIONS ||
+        (uint32_t)config->source >= EVENT_SOURCES || config->hysteresis < 0 ||
+        ((config->condition == EVENT_OUTSIDE || config->condition == EVENT_INSIDE) &&
+         config->high < config->low)) {
+        return false;
+    }
+    
+    detectors[detector].config = *config;
+    detectors[detector].active = false;
+    detectors[detector].count = 0;
+    return true;
+}
+
+bool event_detect_get_config(uint8_t detector, event_detector_config_t *config)
+{
+    if (detector >= EVENT_DETECTORS || config == NULL) {
+        return false;
+    }
+    
+    *config = detectors[detector].config;
+    return true;
+}
+
+bool event_detect_run(const int32_t values[EVENT_SOURCES], uint32_t sequence)
+{
+    bool queued = false;
+    
+    for (uint8_t i = 0; i < EVENT_DETECTORS; i++) {
+        event_detector_t *d = &detectors[i];
+        int32_t value = values[d->config.source];
+        
+        if (!event_detect_toggles(d, value)) {
+            d->count = 0;
+            continue;
+        }
+        if (++d->count < d->config.debounce) {
+            continue;
+        }
+        
+        d->active = !d->active;
+        d->count = 0;
+        event_detect_queue(i, d->active, value, sequence);
+        queued = true;
+    }
+    return queued;
+}
+
+uint8_t event_detect_get_active(void)
+{
+    uint8_t mask = 0;
+    
+    for (uint8_t i = 0; i < EVENT_DETECTORS; i++) {
+        if (detectors[i].active) {
+            mask |= (uint8_t)(1U << i);
+        }
+    }
+    return mask;
+}
+
+uint32_t event_detect_get_pending(void)
+{
+    return queue_head - queue_tail;
+}
+
+uint32_t event_detect_get_dropped(void)
+{
+    return dropped;
+}
+
+bool event_detect_peek(event_record_t *record)
+{
+    if (record == NULL || queue_head == queue_tail) {
+        return false;
+    }
+    
+    *record = queue[queue_tail & EVENT_QUEUE_MASK];
+    return true;
+}
+
+bool event_detect_pop(void)
+{
+    if (queue_head == queue_tail) {
+        return false;
+    }
+    
+    queue_tail++;
+    return true;
+}
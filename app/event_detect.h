@@ -0,0 +1,144 @@
+#ifndef EVENT_DETECT_H
+#define EVENT_DETECT_H
+
+/**
+ * @file event_detect.h
+ * @brief Threshold events with hysteresis and debounce on every sample
+ *
+ * EVENT_DETECTORS independent detectors, each watching one quantity
+ * (pressure, temperature, tracked pressure rate or the derived depth or
+ * altitude) for a condition: above or below a threshold, outside or inside
+ * a window. A detector turns active once the condition holds for its
+ * debounce count of consecutive samples, and inactive again once the value
+ * is back past the threshold by the hysteresis for as many samples. Both
+ * edges queue an event record for the master (APP_REG_EVENT_*) and raise
+ * INTR_MCU with the sample, so the master can stay idle until then.
+ *
+ * Main loop only (run on every sample the main loop takes).
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+#define EVENT_DETECTORS     4U
+#define EVENT_QUEUE_DEPTH   8U  /* Records waiting for the master */
+
+/**
+ * @brief Condition of a detector
+ */
+typedef enum {
+    EVENT_OFF = 0,
+    EVENT_ABOVE,    /* value > low; clears below low - hysteresis */
+    EVENT_BELOW,    /* value < low; clears above low + hysteresis */
+    EVENT_OUTSIDE,  /* value < low or > high; clears inside the window narrowed by hysteresis */
+    EVENT_INSIDE,   /* low <= value <= high; clears outside the window widened by hysteresis */
+    EVENT_CONDITIONS
+} event_condition_t;
+
+/**
+ * @brief Quantity watched by a detector
+ */
+typedef enum {
+    EVENT_SOURCE_PRESSURE = 0,  /* 0.01 mbar */
+    EVENT_SOURCE_TEMPERATURE,   /* 0.01 degC */
+    EVENT_SOURCE_RATE,          /* 0.01 Pa/s (tracker.h) */
+    EVENT_SOURCE_DERIVED,       /* mm (derived.h) */
+    EVENT_SOURCES
+} event_source_t;
+
+/**
+ * @brief Detector settings
+ */
+typedef struct {
+    event_condition_t condition;
+    event_source_t source;
+    int32_t low;         /* Threshold, or window low end */
+    int32_t high;        /* Window high end (OUTSIDE, INSIDE), at least low */
+    int32_t hysteresis;  /* Source units, 0 or more */
+    uint8_t debounce;    /* Consecutive samples per edge (0 counts as 1) */
+} event_detector_config_t;
+
+/**
+ * @brief Queued event
+ */
+typedef struct {
+    uint8_t detector;
+    bool active;        /* true: condition entered; false: left */
+    int32_t value;      /* Source value of the sample */
+    uint32_t sequence;  /* Sequence number of the sample */
+} event_record_t;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Set up (or switch off) a detector; it starts inactive
+ *
+ * @param detector 0..EVENT_DETECTORS-1
+ * @param config Settings
+ * @return true if set, false if out of range
+ */
+bool event_detect_configure(uint8_t detector, const event_detector_config_t *config);
+
+/**
+ * @brief Get the settings of a detector
+ *
+ * @return true if successful, false if out of range
+ */
+bool event_detect_get_config(uint8_t detector, event_detector_config_t *config);
+
+/**
+ * @brief Run every detector on one sample
+ *
+ * @param values Sample value per event_source_t
+ * @param sequence Sequence number of the sample
+ * @return true if an event was queued (or dropped on a full queue)
+ */
+bool event_detect_run(const int32_t values[EVENT_SOURCES], uint32_t sequence);
+
+/**
+ * @brief Active detectors
+ *
+ * @return Bit n set while detector n is active
+ */
+uint8_t event_detect_get_active(void);
+
+/**
+ * @brief Records waiting
+ */
+uint32_t event_detect_get_pending(void);
+
+/**
+ * @brief Records lost on a full queue since boot (saturating)
+ */
+uint32_t event_detect_get_dropped(void);
+
+/**
+ * @brief Oldest record waiting
+ *
+ * @param record Receives it
+ * @return true if there is one
+ */
+bool event_detect_peek(event_record_t *record);
+
+/**
+ * @brief Drop the oldest record (the master has read it)
+ *
+ * @return true if there was one
+ */
+bool event_detect_pop(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EVENT_DETECT_H */
@@ -0,0 +1,82 @@
+/**
+ * @file event_flags.c
+ * @brief Event flags raised from interrupts, dispatched by the main loop
+ *        implementation
+ *
+ * The Cortex-M0+ has no exclusive access instructions, so the
+ * read-modify-write of the mask is made atomic by masking interrupts: set
+ * and take are each a handful of instructions.
+ *
+ * With BOARD_PURE_ISR the main loop is the BOARD_APP_IRQn handler, and
+ * raising a flag pends it instead of cancelling sleep-on-exit.
+ */
+
+#include "event_flags.h"
+#include "board_config.h"
+#include "stm32l0xx_hal.h"  /* For HAL_PWR_DisableSleepOnExit() */
+#include "hal_atomic.h"
+#if BOARD_RTOS_ENABLE
+#include "rtos_tasks.h"
+#endif
+
+#include <stddef.h>
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static volatile uint32_t flags_set = 0;
+static event_flags_handler_t handlers[EVENT_FLAGS_BITS];
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+bool event_flags_register(uint32_t flag, event_flags_handler_t handler)
+{
+    if (flag == 0U || (flag & (flag - 1U)) != 0U) {
+        return false;
+    }
+    
+    for (uint32_t bit = 0; bit < EVENT_FLAGS_BITS; bit++) {
+        if (flag == (1UL << bit)) {
+            handlers[bit] = handler;
+            break;
+        }
+    }
+    return true;
+}
+
+void event_flags_set(uint32_t flags)
+{
+    uint32_t primask = hal_crit_enter();
+    
+    flags_set |= flags;
+#if BOARD_PURE_ISR
+    NVIC_SetPendingIRQ(BOARD_APP_IRQn);  /* The main loop is this vector */
+#else
+    HAL_PWR_DisableSleepOnExit();
+#endif
+    hal_crit_exit(primask);
+#if BOARD_RTOS_ENABLE
+    rtos_host_notify();
+#endif
+}
+
+bool event_flags_pending(void)
+{
+    return flags_set != 0U;
+}
+
+uint32_t event_flags_dispatch(void)
+{
+    uint32_t taken = hal_atomic_take(&flags_set);
+    uint32_t left = taken;
+    
+    for (uint32_t bit = 0; left != 0U; bit++, left >>= 1) {
+        if ((left & 1U) != 0U && handlers[bit] != NULL) {
+            handlers[bit]();
+        }
+    }
+    return taken;
+}
@@ -0,0 +1,80 @@
+#ifndef EVENT_FLAGS_H
+#define EVENT_FLAGS_H
+
+/**
+ * @file event_flags.h
+ * @brief Event flags raised from interrupts, dispatched by the main loop
+ *
+ * One 32-bit mask. Drivers and callbacks set bits from any context
+ * (event_flags_set(), a few instructions with interrupts masked); the main
+ * loop takes the whole mask at once and calls the handler of each bit that
+ * was set, lowest bit first, so the bit order is the priority order. A bit
+ * set again before its handler ran is one event: handlers catch up on all
+ * the work behind it (rings, queues). The main loop sleeps in WFI while no
+ * bit is set, so its cost follows the events, not a polling rate.
+ *
+ * Setting a bit also cancels sleep-on-exit, so the core returns to the
+ * main loop when the current handler finishes (pends BOARD_APP_IRQn with
+ * BOARD_PURE_ISR), and notifies the host task in the RTOS build.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+#define EVENT_FLAGS_BITS  32U
+
+/**
+ * @brief Handler of one flag (main loop)
+ */
+typedef void (*event_flags_handler_t)(void);
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Set the handler of a flag
+ *
+ * A flag with no handler only wakes the main loop.
+ *
+ * @param flag The flag, one bit
+ * @param handler Function to call (NULL: none)
+ * @return true if set, false if flag is not a single bit
+ */
+bool event_flags_register(uint32_t flag, event_flags_handler_t handler);
+
+/**
+ * @brief Raise flags (any context)
+ */
+void event_flags_set(uint32_t flags);
+
+/**
+ * @brief Whether any flag is set
+ *
+ * Checked with interrupts masked before WFI: a flag set after the check
+ * still wakes it.
+ */
+bool event_flags_pending(void);
+
+/**
+ * @brief Take the flags set and run their handlers, lowest bit first
+ *
+ * Main loop only. Flags raised by the handlers stay for the next call.
+ *
+ * @return The flags taken
+ */
+uint32_t event_flags_dispatch(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EVENT_FLAGS_H */
@@ -0,0 +1,563 @@
+/**
+ * @file host_command.c
+ * @brief Command channel from the I2C master
+ *
+ * Single-producer / single-consumer ring: the I2C1 interrupt advances head,
+ * the main loop advances tail, so neither side needs a critical section.
+ * Handlers run in the main loop and may call any sampler or DAC API.
+ */
+
+#include "host_command.h"
+#include "app.h"
+#include "config.h"
+#include "event_detect.h"
+#include "sample_stats.h"
+#include "sensor_sampling.h"
+#include "time_sync.h"
+#include "hal_config.h"
+#include "board_config.h"
+#include "trace.h"
+#if BOARD_SD_LOG_ENABLE
+#include "sd_log.h"
+#endif
+#if BOARD_FLASH_LOG_ENABLE
+#include "flash_log.h"
+#endif
+#if BOARD_CRC_FRAMING_ENABLE
+#include "crc.h"
+#endif
+#if BOARD_BURST_ENABLE
+#include "burst.h"
+#endif
+#if BOARD_FW_UPDATE_ENABLE
+#include "fw_update.h"
+#endif
+#if BOARD_WARM_RESTART_ENABLE
+#include "warm_restart.h"
+#endif
+#if BOARD_PROBE_ENABLE
+#include "probe.h"
+#endif
+#if BOARD_BENCH_ENABLE
+#include "bench.h"
+#endif
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define HOST_COMMAND_QUEUE_MASK  (HOST_COMMAND_QUEUE_SIZE - 1U)
+
+/**
+ * @brief Command handler
+ *
+ * @param argument Command argument
+ * @return Result reported to the master
+ */
+typedef host_command_result_t (*host_command_handler_t)(uint32_t argument);
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static host_command_t queue[HOST_COMMAND_QUEUE_SIZE];
+static volatile uint32_t queue_head = 0;  /* Written by the I2C1 interrupt */
+static volatile uint32_t queue_tail = 0;  /* Written by the main loop */
+static volatile uint32_t dropped = 0;
+static host_command_result_t last_result = HOST_CMD_RESULT_NONE;
+static uint32_t dispatch_timestamp_us = 0;  /* Of the command being dispatched */
+
+/* ============================================================================
+ * COMMAND HANDLERS
+ * ============================================================================ */
+
+static host_command_result_t host_command_nop(uint32_t argument)
+{
+    (void)argument;
+    return HOST_CMD_RESULT_OK;
+}
+
+static host_command_result_t host_command_set_rate(uint32_t argument)
+{
+    return sensor_sampling_set_rate_hz(argument) ? HOST_CMD_RESULT_OK : HOST_CMD_RESULT_BAD_ARGUMENT;
+}
+
+static host_command_result_t host_command_set_dac_map(uint32_t argument)
+{
+    return app_set_dac_pressure_span(argument) ? HOST_CMD_RESULT_OK : HOST_CMD_RESULT_BAD_ARGUMENT;
+}
+
+static host_command_result_t host_command_dac_stream(uint32_t argument)
+{
+    return app_dac_stimulus(argument) ? HOST_CMD_RESULT_OK : HOST_CMD_RESULT_BAD_ARGUMENT;
+}
+
+#if BOARD_DAC_SETPOINT_ENABLE
+static host_command_result_t host_command_dac_setpoint(uint32_t argument)
+{
+    return app_set_dac_setpoint(argument) ? HOST_CMD_RESULT_OK : HOST_CMD_RESULT_BAD_ARGUMENT;
+}
+#endif
+
+#if BOARD_DAC_WAVE_ENABLE
+static host_command_result_t host_command_dac_wave(uint32_t argument)
+{
+    app_dac_wave_op_t op = (app_dac_wave_op_t)(argument >> 24);
+    uint32_t value = argument & 0xFFFFFFUL;
+
+    if (op > APP_DAC_WAVE_PLAY ||
+        (op == APP_DAC_WAVE_BEGIN && (value == 0U || value > BOARD_DAC_WAVE_SAMPLES)) ||
+        (op == APP_DAC_WAVE_COMMIT && value > 0xFFFFU) ||
+        (op == APP_DAC_WAVE_PLAY && value > BOARD_DAC_STREAM_MAX_HZ)) {
+        return HOST_CMD_RESULT_BAD_ARGUMENT;
+    }
+    return app_dac_wave(argument) ? HOST_CMD_RESULT_OK : HOST_CMD_RESULT_FAILED;
+}
+#endif
+
+#if BOARD_POLL_ALIGN_ENABLE
+static host_command_result_t host_command_poll_align(uint32_t argument)
+{
+    return app_set_poll_align(argument) ? HOST_CMD_RESULT_OK : HOST_CMD_RESULT_BAD_ARGUMENT;
+}
+#endif
+
+static host_command_result_t host_command_dac_cal(uint32_t argument)
+{
+    return app_dac_calibrate(argument) ? HOST_CMD_RESULT_OK : HOST_CMD_RESULT_BAD_ARGUMENT;
+}
+
+#if BOARD_COMP_ALARM_ENABLE
+static host_command_result_t host_command_set_alarm(uint32_t argument)
+{
+    return app_set_alarm(argument) ? HOST_CMD_RESULT_OK : HOST_CMD_RESULT_BAD_ARGUMENT;
+}
+#endif
+
+#if BOARD_PROF_ENABLE
+static host_command_result_t host_command_prof(uint32_t argument)
+{
+    return app_set_prof_site(argument) ? HOST_CMD_RESULT_OK : HOST_CMD_RESULT_BAD_ARGUMENT;
+}
+#endif
+
+#if BOARD_LATENCY_ENABLE
+static host_command_result_t host_command_latency(uint32_t argument)
+{
+    return app_set_latency_view(argument) ? HOST_CMD_RESULT_OK : HOST_CMD_RESULT_BAD_ARGUMENT;
+}
+#endif
+
+#if BOARD_BURST_ENABLE
+static host_command_result_t host_command_burst(uint32_t argument)
+{
+    if (argument > BURST_MAX_SAMPLES) {
+        return HOST_CMD_RESULT_BAD_ARGUMENT;
+    }
+    return burst_start(argument) ? HOST_CMD_RESULT_OK : HOST_CMD_RESULT_FAILED;
+}
+
+static host_command_result_t host_command_burst_arm(uint32_t argument)
+{
+    uint32_t pre = argument & 0xFFFFU;
+    uint32_t post = argument >> 16;
+
+    if (post == 0U || pre + post > BURST_MAX_SAMPLES) {
+        return HOST_CMD_RESULT_BAD_ARGUMENT;
+    }
+    return burst_arm(pre, post) ? HOST_CMD_RESULT_OK : HOST_CMD_RESULT_FAILED;
+}
+#endif
+
+#if BOARD_SD_LOG_ENABLE
+static host_command_result_t host_command_sd_log(uint32_t argument)
+{
+    bool ok;
+
+    if (argument > 1U) {
+        return HOST_CMD_RESULT_BAD_ARGUMENT;
+    }
+    ok = (argument != 0U) ? sd_log_start() : sd_log_stop();
+    return ok ? HOST_CMD_RESULT_OK : HOST_CMD_RESULT_FAILED;
+}
+#endif
+
+#if BOARD_FLASH_LOG_ENABLE
+static host_command_result_t host_command_flash_capture(uint32_t argument)
+{
+    uint16_t prom[7];
+    bool ok;
+
+    if (argument > 2U) {
+        return HOST_CMD_RESULT_BAD_ARGUMENT;
+    }
+    if (argument == 2U) {
+        /* Raw trace: the ADC pairs and the coefficients they need */
+        ok = sensor_sampling_get_prom(prom) && flash_log_start_raw(prom) &&
+             sensor_sampling_set_raw_capture(true);
+    } else if (argument == 1U) {
+        ok = flash_log_start();
+    } else {
+        (void)sensor_sampling_set_raw_capture(false);
+        ok = flash_log_stop();
+    }
+    return ok ? HOST_CMD_RESULT_OK : HOST_CMD_RESULT_FAILED;
+}
+#endif
+
+#if BOARD_EEPROM_LOG_ENABLE
+static host_command_result_t host_command_event_log(uint32_t argument)
+{
+    return app_show_event(argument) ? HOST_CMD_RESULT_OK : HOST_CMD_RESULT_BAD_ARGUMENT;
+}
+#endif
+
+static host_command_result_t host_command_config(uint32_t argument)
+{
+    uint8_t action = (uint8_t)(argument & 0xFF);
+    uint8_t slave_addr = (uint8_t)((argument >> 8) & 0xFF);
+    bool ok;
+
+    /* 7-bit addresses outside the reserved 0x00-0x07 and 0x78-0x7F */
+    if (action > 1U || argument > 0xFFFFU ||
+        (slave_addr != 0U && (slave_addr < 0x08U || slave_addr > 0x77U)) ||
+        (action == 1U && slave_addr != 0U)) {
+        return HOST_CMD_RESULT_BAD_ARGUMENT;
+    }
+    ok = (action == 0U) ? app_save_config(slave_addr) : config_clear();
+    return ok ? HOST_CMD_RESULT_OK : HOST_CMD_RESULT_FAILED;
+}
+
+static host_command_result_t host_command_derived(uint32_t argument)
+{
+    return app_set_derived(argument) ? HOST_CMD_RESULT_OK : HOST_CMD_RESULT_BAD_ARGUMENT;
+}
+
+static host_command_result_t host_command_pressure_unit(uint32_t argument)
+{
+    return app_set_pressure_unit((app_pressure_unit_t)argument) ?
+           HOST_CMD_RESULT_OK : HOST_CMD_RESULT_BAD_ARGUMENT;
+}
+
+static host_command_result_t host_command_output_rate(uint32_t argument)
+{
+    return app_set_output_rate(argument) ? HOST_CMD_RESULT_OK : HOST_CMD_RESULT_BAD_ARGUMENT;
+}
+
+static host_command_result_t host_command_stale(uint32_t argument)
+{
+    return app_set_stale((uint16_t)argument, (uint16_t)(argument >> 16)) ? HOST_CMD_RESULT_OK :
+                                                                            HOST_CMD_RESULT_BAD_ARGUMENT;
+}
+
+static host_command_result_t host_command_event_set(uint32_t argument)
+{
+    return app_set_event(argument) ? HOST_CMD_RESULT_OK : HOST_CMD_RESULT_BAD_ARGUMENT;
+}
+
+static host_command_result_t host_command_time_sync(uint32_t argument)
+{
+    time_sync_update(host_command_get_timestamp_us(), argument);
+    return HOST_CMD_RESULT_OK;
+}
+
+#if BOARD_SYNC_IN_ENABLE
+static host_command_result_t host_command_sync_in(uint32_t argument)
+{
+    if (argument > 1U) {
+        return HOST_CMD_RESULT_BAD_ARGUMENT;
+    }
+    return sensor_sampling_set_sync_input(argument == 1U) ? HOST_CMD_RESULT_OK : HOST_CMD_RESULT_FAILED;
+}
+#endif
+
+#if BOARD_FW_UPDATE_ENABLE
+static host_command_result_t host_command_fw_update(uint32_t argument)
+{
+    bool ok;
+
+    switch (argument >> 24) {
+    case 0U:
+        fw_update_abort();
+        return HOST_CMD_RESULT_OK;
+    case 1U:
+        return fw_update_begin(argument & 0xFFFFFFU) ? HOST_CMD_RESULT_OK
+                                                      : HOST_CMD_RESULT_BAD_ARGUMENT;
+    case 2U:
+        ok = fw_update_verify();
+        break;
+    case 3U:
+#if BOARD_WARM_RESTART_ENABLE
+        warm_restart_invalidate();  /* The new image boots cold */
+#endif
+        ok = fw_update_swap();  /* Resets on success */
+        break;
+    default:
+        return HOST_CMD_RESULT_BAD_ARGUMENT;
+    }
+    return ok ? HOST_CMD_RESULT_OK : HOST_CMD_RESULT_FAILED;
+}
+
+static host_command_result_t host_command_fw_data(uint32_t argument)
+{
+    return fw_update_push(argument) ? HOST_CMD_RESULT_OK : HOST_CMD_RESULT_FAILED;
+}
+#endif
+
+#if BOARD_PROBE_ENABLE
+static host_command_result_t host_command_probe(uint32_t argument)
+{
+    if (argument > 1U) {
+        return HOST_CMD_RESULT_BAD_ARGUMENT;
+    }
+    if (argument == 1U) {
+        probe_freeze();
+    } else {
+        probe_resume();
+    }
+    return HOST_CMD_RESULT_OK;
+}
+#endif
+
+#if BOARD_BENCH_ENABLE
+static host_command_result_t host_command_bench(uint32_t argument)
+{
+    if (argument > 1U) {
+        return HOST_CMD_RESULT_BAD_ARGUMENT;
+    }
+    if (argument == 0U) {
+        bench_stop();
+        return HOST_CMD_RESULT_OK;
+    }
+    return bench_start() ? HOST_CMD_RESULT_OK : HOST_CMD_RESULT_FAILED;
+}
+#endif
+
+static host_command_result_t host_command_event_ack(uint32_t argument)
+{
+    if (argument > 1U) {
+        return HOST_CMD_RESULT_BAD_ARGUMENT;
+    }
+    if (argument == 0U) {
+        (void)event_detect_pop();
+    } else {
+        while (event_detect_pop()) {
+        }
+    }
+    return HOST_CMD_RESULT_OK;
+}
+
+#if BOARD_SENSOR_MUX_CHANNELS == 0
+static host_command_result_t host_command_set_osr(uint32_t argument)
+{
+    sensor_osr_t pressure_osr = (sensor_osr_t)(argument & 0xFF);
+    sensor_osr_t temperature_osr = (sensor_osr_t)((argument >> 8) & 0xFF);
+
+    return sensor_sampling_set_profile(pressure_osr, temperature_osr) ?
+           HOST_CMD_RESULT_OK : HOST_CMD_RESULT_BAD_ARGUMENT;
+}
+
+static host_command_result_t host_command_stats_window(uint32_t argument)
+{
+    return sample_stats_set_window(argument) ? HOST_CMD_RESULT_OK : HOST_CMD_RESULT_BAD_ARGUMENT;
+}
+
+static host_command_result_t host_command_set_filter(uint32_t argument)
+{
+    sensor_filter_mode_t mode = (sensor_filter_mode_t)(argument & 0xFF);
+
+    if ((argument >> 28) != 0U ||
+        !sensor_sampling_set_median((uint8_t)((argument >> 24) & 0x0F))) {
+        return HOST_CMD_RESULT_BAD_ARGUMENT;
+    }
+    return sensor_sampling_set_filter(mode, (uint8_t)((argument >> 8) & 0xFF),
+                                      (uint8_t)((argument >> 16) & 0xFF)) ?
+           HOST_CMD_RESULT_OK : HOST_CMD_RESULT_BAD_ARGUMENT;
+}
+#endif
+
+/* Indexed by host_command_opcode_t; NULL = not available in this build
+ * (the mux rig samples with a fixed profile and no filter stage, the alarm
+ * needs BOARD_COMP_ALARM_ENABLE, profiling BOARD_PROF_ENABLE, the SD card
+ * log BOARD_SD_LOG_ENABLE, the EEPROM record window BOARD_EEPROM_LOG_ENABLE,
+ * the flash capture BOARD_FLASH_LOG_ENABLE, the RAM burst BOARD_BURST_ENABLE,
+ * the sync input BOARD_SYNC_IN_ENABLE, the firmware update
+ * BOARD_FW_UPDATE_ENABLE, the benchmark BOARD_BENCH_ENABLE, the master DAC
+ * setpoint BOARD_DAC_SETPOINT_ENABLE, the waveform tables
+ * BOARD_DAC_WAVE_ENABLE, the poll alignment BOARD_POLL_ALIGN_ENABLE) */
+static const host_command_handler_t handlers[] = {
+    [HOST_CMD_NOP]         = host_command_nop,
+#if BOARD_SENSOR_MUX_CHANNELS == 0
+    [HOST_CMD_SET_OSR]     = host_command_set_osr,
+    [HOST_CMD_SET_FILTER]  = host_command_set_filter,
+#endif
+    [HOST_CMD_SET_RATE]    = host_command_set_rate,
+    [HOST_CMD_SET_DAC_MAP] = host_command_set_dac_map,
+    [HOST_CMD_DAC_STREAM]  = host_command_dac_stream,
+    [HOST_CMD_DAC_CAL]     = host_command_dac_cal,
+#if BOARD_COMP_ALARM_ENABLE
+    [HOST_CMD_SET_ALARM]   = host_command_set_alarm,
+#endif
+#if BOARD_PROF_ENABLE
+    [HOST_CMD_PROF]        = host_command_prof,
+#endif
+#if BOARD_SD_LOG_ENABLE
+    [HOST_CMD_SD_LOG]      = host_command_sd_log,
+#endif
+#if BOARD_EEPROM_LOG_ENABLE
+    [HOST_CMD_EVENT_LOG]   = host_command_event_log,
+#endif
+#if BOARD_FLASH_LOG_ENABLE
+    [HOST_CMD_FLASH_CAPTURE] = host_command_flash_capture,
+#endif
+    [HOST_CMD_CONFIG]      = host_command_config,
+#if BOARD_SENSOR_MUX_CHANNELS == 0
+    [HOST_CMD_STATS_WINDOW] = host_command_stats_window,
+#endif
+    [HOST_CMD_DERIVED]     = host_command_derived,
+    [HOST_CMD_EVENT_SET]   = host_command_event_set,
+    [HOST_CMD_EVENT_ACK]   = host_command_event_ack,
+    [HOST_CMD_PRESSURE_UNIT] = host_command_pressure_unit,
+    [HOST_CMD_OUTPUT_RATE] = host_command_output_rate,
+    [HOST_CMD_TIME_SYNC]   = host_command_time_sync,
+#if BOARD_LATENCY_ENABLE
+    [HOST_CMD_LATENCY]     = host_command_latency,
+#endif
+#if BOARD_BURST_ENABLE
+    [HOST_CMD_BURST]       = host_command_burst,
+    [HOST_CMD_BURST_ARM]   = host_command_burst_arm,
+#endif
+#if BOARD_SYNC_IN_ENABLE
+    [HOST_CMD_SYNC_IN]     = host_command_sync_in,
+#endif
+#if BOARD_FW_UPDATE_ENABLE
+    [HOST_CMD_FW_UPDATE]   = host_command_fw_update,
+    [HOST_CMD_FW_DATA]     = host_command_fw_data,
+#endif
+#if BOARD_PROBE_ENABLE
+    [HOST_CMD_PROBE]       = host_command_probe,
+#endif
+    [HOST_CMD_STALE]       = host_command_stale,
+#if BOARD_BENCH_ENABLE
+    [HOST_CMD_BENCH]       = host_command_bench,
+#endif
+#if BOARD_DAC_SETPOINT_ENABLE
+    [HOST_CMD_DAC_SETPOINT] = host_command_dac_setpoint,
+#endif
+#if BOARD_DAC_WAVE_ENABLE
+    [HOST_CMD_DAC_WAVE]    = host_command_dac_wave,
+#endif
+#if BOARD_POLL_ALIGN_ENABLE
+    [HOST_CMD_POLL_ALIGN]  = host_command_poll_align,
+#endif
+};
+
+#define HOST_COMMAND_HANDLER_COUNT  (sizeof(handlers) / sizeof(handlers[0]))
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+#if BOARD_CRC_FRAMING_ENABLE
+/**
+ * @brief Check a command against its CRC-16
+ *
+ * Over the bytes as the master wrote them: argument (little-endian), opcode.
+ */
+static bool host_command_crc_ok(const host_command_t *cmd)
+{
+    uint8_t bytes[5];
+
+    bytes[0] = (uint8_t)(cmd->argument & 0xFF);
+    bytes[1] = (uint8_t)((cmd->argument >> 8) & 0xFF);
+    bytes[2] = (uint8_t)((cmd->argument >> 16) & 0xFF);
+    bytes[3] = (uint8_t)((cmd->argument >> 24) & 0xFF);
+    bytes[4] = cmd->opcode;
+    return crc16_update(CRC16_INIT, bytes, sizeof(bytes)) == cmd->crc;
+}
+#endif
+
+/**
+ * @brief Run one queued command
+ *
+ * @return Result reported to the master
+ */
+static host_command_result_t host_command_run(const host_command_t *cmd)
+{
+#if BOARD_CRC_FRAMING_ENABLE
+    if (!host_command_crc_ok(cmd)) {
+        return HOST_CMD_RESULT_BAD_CRC;
+    }
+#endif
+    if (cmd->opcode < HOST_COMMAND_HANDLER_COUNT && handlers[cmd->opcode] != NULL) {
+        return handlers[cmd->opcode](cmd->argument);
+    }
+    return HOST_CMD_RESULT_BAD_OPCODE;
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+void host_command_init(void)
+{
+    queue_head = 0;
+    queue_tail = 0;
+    dropped = 0;
+    last_result = HOST_CMD_RESULT_NONE;
+}
+
+bool host_command_push(uint8_t opcode, uint32_t argument, uint16_t crc, uint32_t timestamp_us)
+{
+    uint32_t head = queue_head;
+
+    if (head - queue_tail >= HOST_COMMAND_QUEUE_SIZE) {
+        dropped++;
+        return false;
+    }
+
+    queue[head & HOST_COMMAND_QUEUE_MASK].opcode = opcode;
+    queue[head & HOST_COMMAND_QUEUE_MASK].argument = argument;
+    queue[head & HOST_COMMAND_QUEUE_MASK].timestamp_us = timestamp_us;
+#if BOARD_CRC_FRAMING_ENABLE
+    queue[head & HOST_COMMAND_QUEUE_MASK].crc = crc;
+#else
+    (void)crc;
+#endif
+    queue_head = head + 1U;  /* Publish once the entry is complete */
+
+    return true;
+}
+
+uint32_t host_command_dispatch(void)
+{
+    uint32_t count = 0;
+
+    while (queue_tail != queue_head) {
+        const host_command_t *cmd = &queue[queue_tail & HOST_COMMAND_QUEUE_MASK];
+
+        dispatch_timestamp_us = cmd->timestamp_us;
+        last_result = host_command_run(cmd);
+        TRACE(TRACE_HOST_COMMAND, cmd->opcode, last_result);
+
+        queue_tail++;
+        count++;
+    }
+
+    return count;
+}
+
+uint32_t host_command_get_timestamp_us(void)
+{
+    return dispatch_timestamp_us;
+}
+
+host_command_result_t host_command_get_last_result(void)
+{
+    return last_result;
+}
+
+uint32_t host_command_get_dropped(void)
+{
+    return dropped;
+}
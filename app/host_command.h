@@ -0,0 +1,163 @@
+#ifndef HOST_COMMAND_H
+#define HOST_COMMAND_H
+
+/**
+ * @file host_command.h
+ * @brief Command channel from the I2C master
+ *
+ * The master writes a 32-bit argument and an opcode into the command
+ * registers (APP_REG_CMD_*). The I2C slave RX callback queues the command
+ * with its arrival time; the main loop drains the queue and runs each handler
+ * in order. Commands arriving faster than the loop runs are kept, not
+ * overwritten.
+ *
+ * With BOARD_CRC_FRAMING_ENABLE the master also writes a CRC-16 of the
+ * argument and opcode (APP_REG_CMD_CRC); the main loop checks it before
+ * dispatch and answers HOST_CMD_RESULT_BAD_CRC to a command that does not
+ * match, without running it.
+ *
+ * Commands framed on the UART stream (uart_stream.h) carry the same bytes
+ * and join the queue from the main loop, with the I2C1 lines masked.
+ *
+ * Producer: I2C1 interrupt (host_command_push()). Consumer: main loop
+ * (host_command_dispatch()).
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define HOST_COMMAND_QUEUE_SIZE  8U  /* Power of two */
+
+/* ============================================================================
+ * TYPES
+ * ============================================================================ */
+
+/**
+ * @brief Command opcodes
+ */
+typedef enum {
+    HOST_CMD_NOP = 0x00,
+    HOST_CMD_SET_OSR = 0x01,      /* arg[7:0] pressure OSR, arg[15:8] temperature OSR (sensor_osr_t) */
+    HOST_CMD_SET_RATE = 0x02,     /* arg = tick rate in Hz (up to BOARD_TIM2_FREQ_HZ) */
+    HOST_CMD_SET_FILTER = 0x03,   /* arg[7:0] sensor_filter_mode_t, arg[15:8] pressure log2,
+                                   * arg[23:16] temperature log2 */
+    HOST_CMD_SET_DAC_MAP = 0x04,  /* arg = pressure at the top of the pressure outputs, mbar (0 = default) */
+    HOST_CMD_DAC_STREAM = 0x05,   /* arg = test stimulus sample rate in Hz (0 = stop) */
+    HOST_CMD_DAC_CAL = 0x06,      /* arg[7:0] app_dac_cal_step_t, arg[8] channel, arg[31:16] mV */
+    HOST_CMD_SET_ALARM = 0x07,    /* arg = analog watchdog threshold in mV (0 = disarm), re-arms */
+    HOST_CMD_PROF = 0x08,         /* arg[7:0] profiled site (prof_site_t), arg[8] clear all first */
+    HOST_CMD_SD_LOG = 0x09,       /* arg = 1 start a new log file, 0 stop and close it */
+    HOST_CMD_EVENT_LOG = 0x0A,    /* arg = EEPROM record to show at APP_REG_ELOG_* (0 = newest) */
+    HOST_CMD_FLASH_CAPTURE = 0x0B, /* arg = 1 start a flash capture, 2 a raw trace, 0 stop */
+    HOST_CMD_CONFIG = 0x0C,       /* arg[7:0] 0 store the running settings for boot, 1 clear them;
+                                     arg[15:8] new slave address with 0 (0 = keep) */
+    HOST_CMD_STATS_WINDOW = 0x0D, /* arg = samples per statistics window (0 = off, up to 65535) */
+    HOST_CMD_DERIVED = 0x0E,      /* arg[23:0] reference pressure, 0.01 mbar (0 = tare now),
+                                   * arg[27:24] derived_quantity_t */
+    HOST_CMD_EVENT_SET = 0x0F,    /* arg[31:28] detector, arg[27:24] field, arg[23:0] value */
+    HOST_CMD_EVENT_ACK = 0x10,    /* arg = 0 drop the oldest event record, 1 drop them all */
+    HOST_CMD_PRESSURE_UNIT = 0x11, /* arg = app_pressure_unit_t shown at APP_REG_PRESSURE_UNIT (0 = off) */
+    HOST_CMD_OUTPUT_RATE = 0x12,  /* arg[31:24] app_output_t, arg[15:0] samples per update */
+    HOST_CMD_LATENCY = 0x13,      /* arg[7:0] latency_stage_t, arg[15:8] bucket shown, arg[16] clear first */
+    HOST_CMD_BURST = 0x14,        /* arg = samples to capture into RAM (burst.h), 0 = abort */
+    HOST_CMD_BURST_ARM = 0x15,    /* arg[15:0] pre-trigger samples, arg[31:16] post-trigger samples */
+    HOST_CMD_TIME_SYNC = 0x16,    /* arg = master clock at the START of this write, us (time_sync.h) */
+    HOST_CMD_SYNC_IN = 0x17,      /* arg = 1 start cycles on the sync input edge (exact mode), 0 on the tick */
+    HOST_CMD_FW_UPDATE = 0x18,    /* arg[31:24] 0 abort, 1 begin (arg[23:0] image bytes), 2 verify, 3 swap */
+    HOST_CMD_FW_DATA = 0x19,      /* arg = next image word, then its CRC-32 (fw_update.h) */
+    HOST_CMD_PROBE = 0x1A,        /* arg = 1 freeze the probe ring for a read at APP_REG_PROBE, 0 resume */
+    HOST_CMD_STALE = 0x1B,        /* arg[15:0] stale limit, ms (0 = off), arg[31:16] stale DAC code
+                                   * (0xFFFF = hold) */
+    HOST_CMD_BENCH = 0x1C,        /* arg = 1 start the benchmark sweep (bench.h), 0 stop it */
+    HOST_CMD_DAC_SETPOINT = 0x1D, /* arg = 1 DAC codes from APP_REG_DAC_SET_*, 0 from the sensor mapping */
+    HOST_CMD_DAC_WAVE = 0x1E,     /* arg[31:24] app_dac_wave_op_t: 0 abort, 1 begin (arg[15:0] samples),
+                                   * 2 commit (arg[15:0] CRC-16), 3 play (arg[23:0] Hz, 0 = stop) */
+    HOST_CMD_POLL_ALIGN = 0x1F    /* arg = 1 align the tick to the master's polls (poll_align.h), 0 off */
+} host_command_opcode_t;
+
+/**
+ * @brief Result of the last dispatched command (APP_REG_CMD_STATUS)
+ */
+typedef enum {
+    HOST_CMD_RESULT_OK = 0,
+    HOST_CMD_RESULT_BAD_OPCODE,   /* Unknown, or not available in this build */
+    HOST_CMD_RESULT_BAD_ARGUMENT,
+    HOST_CMD_RESULT_FAILED,       /* Valid, but the device could not do it (no card, no space) */
+    HOST_CMD_RESULT_BAD_CRC,      /* CRC framing: the command check did not match, not run */
+    HOST_CMD_RESULT_NONE = 0xFF   /* No command dispatched yet */
+} host_command_result_t;
+
+/**
+ * @brief Queued command
+ */
+typedef struct {
+    uint8_t opcode;
+    uint32_t argument;
+    uint32_t timestamp_us;  /* hal_tim2_get_timestamp_us() at address match of its write */
+#if BOARD_CRC_FRAMING_ENABLE
+    uint16_t crc;           /* As written by the master */
+#endif
+} host_command_t;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Initialize (empty) the queue
+ */
+void host_command_init(void);
+
+/**
+ * @brief Queue a command
+ *
+ * Called from the I2C slave RX callback (interrupt context).
+ *
+ * @param opcode Command opcode
+ * @param argument Command argument
+ * @param crc CRC-16 written with it (BOARD_CRC_FRAMING_ENABLE), else ignored
+ * @param timestamp_us Address match time of the write
+ *                     (i2c_slave_get_write_time_us())
+ * @return true if queued, false if the queue is full (command dropped and
+ *         counted)
+ */
+bool host_command_push(uint8_t opcode, uint32_t argument, uint16_t crc, uint32_t timestamp_us);
+
+/**
+ * @brief Run every queued command
+ *
+ * Call from the main loop.
+ *
+ * @return Number of commands dispatched
+ */
+uint32_t host_command_dispatch(void);
+
+/**
+ * @brief Arrival time of the command being dispatched (for its handler)
+ */
+uint32_t host_command_get_timestamp_us(void);
+
+/**
+ * @brief Result of the last dispatched command
+ */
+host_command_result_t host_command_get_last_result(void);
+
+/**
+ * @brief Commands dropped on a full queue (since boot)
+ */
+uint32_t host_command_get_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_COMMAND_H */
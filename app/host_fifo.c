@@ -0,0 +1,293 @@
+/**
+ * @file host_fifo.c
+ * @brief Sample FIFO drained by the I2C master in one burst
+ *
+ * Two frames alternate: the main loop appends to the fill frame, the I2C1
+ * address callback takes it and makes the other one the fill frame. The frame
+ * just taken is being sent (by DMA) until the next take, and the other one was
+ * fully sent by the previous transaction, so it can be reset at once.
+ *
+ * An append masks I2C1 only (16 bytes), so a take never sees a half-written
+ * sample or a count that does not match the bytes; higher and lower
+ * priority handlers keep running.
+ *
+ * With BOARD_SAMPLE_CODEC_ENABLE the frame holds encoded samples instead
+ * (sample_codec.h), starting with a keyframe: a frame lost to a failed
+ * read does not break the next. It is full once the next sample might
+ * not fit.
+ *
+ * With BOARD_CRC_FRAMING_ENABLE a frame with samples ends in a CRC-16
+ * (crc.h) over its payload and then its header. The append keeps it
+ * current: the payload CRC grows by the new bytes, and the trailer is that
+ * CRC carried over the header the frame would go out with. The take, in
+ * the address callback, only writes the header: the CRC unit belongs to
+ * the main loop.
+ */
+
+#include "host_fifo.h"
+#include <string.h>
+#include "hal_config.h"    /* For hal_irq_mask() */
+#include "time_sync.h"
+#include "board_config.h"
+#if BOARD_WARM_RESTART_ENABLE
+#include "warm_restart.h"
+#endif
+#if BOARD_SAMPLE_CODEC_ENABLE
+#include "sample_codec.h"
+#endif
+#if BOARD_CRC_FRAMING_ENABLE
+#include "crc.h"
+#endif
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define HOST_FIFO_FRAME_SIZE  (HOST_FIFO_HEADER_SIZE + HOST_FIFO_DEPTH * HOST_FIFO_SAMPLE_SIZE)
+
+/**
+ * @brief Burst frame
+ */
+typedef struct {
+    uint8_t bytes[HOST_FIFO_FRAME_SIZE + HOST_FIFO_CRC_SIZE];
+    uint8_t count;  /* Samples stored after the header */
+    uint16_t used;  /* Their bytes */
+#if BOARD_CRC_FRAMING_ENABLE
+    uint16_t crc;   /* CRC-16 of those bytes */
+#endif
+} host_fifo_frame_t;
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+#if BOARD_WARM_RESTART_ENABLE
+/* Kept across a warm reset: the fill frame is resumed (warm_restart.h),
+ * with the encoder that continues it */
+static host_fifo_frame_t frames[2] NOINIT;
+static volatile uint8_t fill_frame NOINIT;
+#if BOARD_SAMPLE_CODEC_ENABLE
+static sample_codec_t codec NOINIT;
+#endif
+#else
+static host_fifo_frame_t frames[2];
+static volatile uint8_t fill_frame = 0;
+#if BOARD_SAMPLE_CODEC_ENABLE
+static sample_codec_t codec;  /* Fill frame's encoder */
+#endif
+#endif
+static volatile uint32_t overflows = 0;
+static uint8_t high_water = 0;  /* Main loop only */
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Write the header of a frame as it stands
+ */
+static void host_fifo_put_header(host_fifo_frame_t *frame)
+{
+    frame->bytes[0] = frame->count;
+#if BOARD_SAMPLE_CODEC_ENABLE
+    /* Length not implied by the count: it replaces the overflows (0x14) */
+    frame->bytes[1] = HOST_FIFO_FORMAT_CODEC;
+    frame->bytes[2] = (uint8_t)(frame->used & 0xFF);
+    frame->bytes[3] = (uint8_t)((frame->used >> 8) & 0xFF);
+#else
+    {
+        uint32_t ovf = overflows;
+        
+        frame->bytes[1] = HOST_FIFO_FORMAT_RECORD;
+        frame->bytes[2] = (uint8_t)(ovf & 0xFF);
+        frame->bytes[3] = (uint8_t)((ovf >> 8) & 0xFF);
+    }
+#endif
+}
+
+#if BOARD_WARM_RESTART_ENABLE
+/**
+ * @brief Whether the kept fill frame can be resumed
+ * 
+ * A reset can land between the bytes of an append and its count: a raw
+ * frame whose length does not match its count is dropped.
+ */
+static bool host_fifo_resumable(void)
+{
+    const host_fifo_frame_t *frame;
+    
+    if (!warm_restart_is_warm() || fill_frame > 1U) {
+        return false;
+    }
+    frame = &frames[fill_frame];
+#if BOARD_SAMPLE_CODEC_ENABLE
+    return frame->used <= HOST_FIFO_FRAME_SIZE - HOST_FIFO_HEADER_SIZE &&
+           (frame->count == 0U) == (frame->used == 0U);
+#else
+    return frame->count <= HOST_FIFO_DEPTH && frame->used == frame->count * HOST_FIFO_SAMPLE_SIZE;
+#endif
+}
+#endif
+
+#if BOARD_CRC_FRAMING_ENABLE
+/**
+ * @brief Bring the header and CRC trailer of the fill frame up to date
+ *        (I2C1 masked)
+ */
+static void host_fifo_seal(host_fifo_frame_t *frame)
+{
+    uint16_t crc;
+    
+    host_fifo_put_header(frame);
+    crc = crc16_update(frame->crc, frame->bytes, HOST_FIFO_HEADER_SIZE);
+    frame->bytes[HOST_FIFO_HEADER_SIZE + frame->used] = (uint8_t)(crc & 0xFF);
+    frame->bytes[HOST_FIFO_HEADER_SIZE + frame->used + 1U] = (uint8_t)((crc >> 8) & 0xFF);
+}
+#endif
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+void host_fifo_init(void)
+{
+    uint32_t masked = hal_irq_mask(HAL_IRQ_LINES_I2C1);
+    
+#if BOARD_WARM_RESTART_ENABLE
+    /* Warm boot: samples the master has not taken survive the reset (the
+     * frame it was reading does not) */
+    if (host_fifo_resumable()) {
+        frames[fill_frame ^ 1U].count = 0;
+        frames[fill_frame ^ 1U].used = 0;
+        high_water = frames[fill_frame].count;
+        overflows = 0;
+        hal_irq_unmask(masked);
+        return;
+    }
+#endif
+    frames[0].count = 0;
+    frames[0].used = 0;
+    frames[1].count = 0;
+    frames[1].used = 0;
+    fill_frame = 0;
+    overflows = 0;
+    high_water = 0;
+    hal_irq_unmask(masked);
+}
+
+bool host_fifo_push(const sensor_data_t *sample)
+{
+    host_fifo_frame_t *frame;
+    sensor_data_t mapped;
+    const sensor_data_t *data = &mapped;
+    uint8_t *dst;
+    uint32_t masked;
+    bool stored = false;
+
+    if (sample == NULL) {
+        return false;
+    }
+    
+    /* The master reads its own clock once synchronized */
+    mapped = *sample;
+    mapped.timestamp_us = time_sync_to_master(sample->timestamp_us);
+
+    masked = hal_irq_mask(HAL_IRQ_LINES_I2C1);
+    frame = &frames[fill_frame];
+    dst = &frame->bytes[HOST_FIFO_HEADER_SIZE + frame->used];
+#if BOARD_SAMPLE_CODEC_ENABLE
+    if (HOST_FIFO_FRAME_SIZE - HOST_FIFO_HEADER_SIZE - frame->used >= SAMPLE_CODEC_MAX_BYTES &&
+        frame->count < UINT8_MAX) {
+        uint32_t n;
+        
+        if (frame->count == 0U) {
+            sample_codec_reset(&codec);
+        }
+        n = sample_codec_encode(&codec, data, dst);
+#if BOARD_CRC_FRAMING_ENABLE
+        frame->crc = crc16_update((frame->count == 0U) ? CRC16_INIT : frame->crc, dst, n);
+#endif
+        frame->used += (uint16_t)n;
+        frame->count++;
+        stored = true;
+    } else {
+        overflows++;
+    }
+#else
+    if (frame->count < HOST_FIFO_DEPTH) {
+        memcpy(dst, data, SENSOR_RECORD_BYTES);  /* The record, as the sampler wrote it */
+#if BOARD_CRC_FRAMING_ENABLE
+        frame->crc = crc16_update((frame->count == 0U) ? CRC16_INIT : frame->crc, dst,
+                                  HOST_FIFO_SAMPLE_SIZE);
+#endif
+        frame->used += HOST_FIFO_SAMPLE_SIZE;
+        frame->count++;
+        stored = true;
+    } else {
+        overflows++;
+    }
+#endif
+    if (frame->count > high_water) {
+        high_water = frame->count;
+    }
+#if BOARD_CRC_FRAMING_ENABLE
+    /* New sample, or a new overflow count in the header */
+    if (frame->count != 0U) {
+        host_fifo_seal(frame);
+    }
+#endif
+    hal_irq_unmask(masked);
+
+    return stored;
+}
+
+bool host_fifo_has_room(void)
+{
+    uint32_t masked = hal_irq_mask(HAL_IRQ_LINES_I2C1);
+    const host_fifo_frame_t *frame = &frames[fill_frame];
+    bool room;
+    
+#if BOARD_SAMPLE_CODEC_ENABLE
+    room = HOST_FIFO_FRAME_SIZE - HOST_FIFO_HEADER_SIZE - frame->used >= SAMPLE_CODEC_MAX_BYTES &&
+           frame->count < UINT8_MAX;
+#else
+    room = frame->count < HOST_FIFO_DEPTH;
+#endif
+    hal_irq_unmask(masked);
+    
+    return room;
+}
+
+const uint8_t *host_fifo_take_frame(uint16_t *len)
+{
+    host_fifo_frame_t *frame = &frames[fill_frame];
+
+    /* Same header as the last append sealed (appends mask I2C1) */
+    host_fifo_put_header(frame);
+    *len = (uint16_t)(HOST_FIFO_HEADER_SIZE + frame->used);
+    if (frame->count != 0U) {
+        *len += HOST_FIFO_CRC_SIZE;
+    }
+
+    /* Other frame was sent by the previous transaction: reuse it */
+    fill_frame ^= 1U;
+    frames[fill_frame].count = 0;
+    frames[fill_frame].used = 0;
+
+    return frame->bytes;
+}
+
+uint8_t host_fifo_get_level(void)
+{
+    return frames[fill_frame].count;
+}
+
+uint32_t host_fifo_get_overflows(void)
+{
+    return overflows;
+}
+
+uint8_t host_fifo_get_high_water(void)
+{
+    return high_water;
+}
@@ -0,0 +1,119 @@
+#ifndef HOST_FIFO_H
+#define HOST_FIFO_H
+
+/**
+ * @file host_fifo.h
+ * @brief Sample FIFO drained by the I2C master in one burst
+ *
+ * Every sample processed by the main loop is packed into the current burst
+ * frame. A master read of the FIFO register takes the whole frame at address
+ * match and sends it in one transaction:
+ * count (1 byte), format (1 byte), overflows (2 bytes), then count packed
+ * samples: 16-byte sample records (HOST_FIFO_FORMAT_RECORD, the layout of
+ * sensor_sampling.h shared with the other transports), or encoded by
+ * sample_codec.h (HOST_FIFO_FORMAT_CODEC, BOARD_SAMPLE_CODEC_ENABLE builds:
+ * the frame holds ~4x the samples, and bytes 2-3 carry their length). The
+ * next samples go into the other frame, so the master sees every sample as
+ * long as it polls before a frame fills up.
+ * With BOARD_CRC_FRAMING_ENABLE a frame with samples is followed by a
+ * CRC-16 (crc.h, little-endian) of its payload bytes then its 4 header
+ * bytes.
+ *
+ * Producer: main loop (host_fifo_push()). Consumer: I2C1 address callback
+ * (host_fifo_take_frame()).
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board_config.h"
+#include "sensor_sampling.h"  /* For sensor_data_t type */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#if BOARD_I2C1_SMBUS
+#define HOST_FIFO_DEPTH         15U  /* A frame is one SMBus block: 255 bytes at most */
+#else
+#define HOST_FIFO_DEPTH         32U  /* Samples per burst frame (raw; codec frames hold more) */
+#endif
+#define HOST_FIFO_HEADER_SIZE   4U   /* count, format, overflows (uint16) */
+#define HOST_FIFO_SAMPLE_SIZE   SENSOR_RECORD_BYTES
+#if BOARD_CRC_FRAMING_ENABLE
+#define HOST_FIFO_CRC_SIZE      2U   /* CRC-16 trailer (frames with samples) */
+#else
+#define HOST_FIFO_CRC_SIZE      0U
+#endif
+
+/* Header byte 1 (0x00 was the register order: pressure, temperature,
+ * timestamp, sequence) */
+#define HOST_FIFO_FORMAT_CODEC  0x01U
+#define HOST_FIFO_FORMAT_RECORD 0x02U
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Initialize (empty) the FIFO
+ *
+ * On a warm boot (warm_restart.h) the frame the master had not taken yet
+ * is kept instead, samples and all.
+ */
+void host_fifo_init(void);
+
+/**
+ * @brief Append a sample to the current burst frame
+ *
+ * Packed little-endian: int32 pressure (0.01 mbar), int32 temperature
+ * (0.01 degC), uint32 timestamp_us (in master time once synchronized,
+ * time_sync.h), uint32 sequence; or encoded in codec builds.
+ *
+ * @param sample Sample to append
+ * @return true if stored, false if the frame is full (sample dropped and
+ *         counted as an overflow)
+ */
+bool host_fifo_push(const sensor_data_t *sample);
+
+/**
+ * @brief Whether host_fifo_push() would store a sample now
+ *
+ * A master read of the FIFO register makes room again.
+ */
+bool host_fifo_has_room(void);
+
+/**
+ * @brief Take the current burst frame for transmission
+ *
+ * Called from the I2C slave address callback (interrupt context). The
+ * returned frame stays untouched until the next call.
+ *
+ * @param len Receives the frame length in bytes (header and CRC included)
+ * @return Frame bytes
+ */
+const uint8_t *host_fifo_take_frame(uint16_t *len);
+
+/**
+ * @brief Number of samples waiting for the next burst
+ */
+uint8_t host_fifo_get_level(void);
+
+/**
+ * @brief Samples dropped on a full frame (since boot)
+ */
+uint32_t host_fifo_get_overflows(void);
+
+/**
+ * @brief Most samples a frame has held (since boot)
+ */
+uint8_t host_fifo_get_high_water(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_FIFO_H */
@@ -0,0 +1,199 @@
+/**
+ * @file job_sched.c
+ * @brief Cooperative earliest-deadline-first job scheduler implementation
+ *
+ * Times compare by wrapped difference, so everything stays valid across
+ * the timebase wrap as long as deadlines and periods are under 2^31 us.
+ * With a handful of slots the dispatch is a linear pick per job run.
+ * A periodic job that fell more than a period behind skips the releases
+ * it missed rather than running them back to back.
+ */
+
+#include "job_sched.h"
+#include "timebase.h"
+
+#include <stddef.h>
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+typedef struct {
+    job_sched_desc_t desc;   /* desc.run NULL = free */
+    bool released;
+    uint32_t deadline_at;    /* Absolute, while released */
+    uint32_t release_at;     /* Next periodic release */
+    job_sched_stats_t stats;
+} job_sched_slot_t;
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static job_sched_slot_t slots[JOB_SCHED_SLOTS];
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static void job_sched_release_at(job_sched_slot_t *s, uint32_t now)
+{
+    if (!s->released) {
+        s->released = true;
+        s->deadline_at = now + s->desc.deadline_us;
+    }
+}
+
+/**
+ * @brief Release the periodic jobs that are due
+ */
+static void job_sched_release_due(uint32_t now)
+{
+    for (uint8_t i = 0; i < JOB_SCHED_SLOTS; i++) {
+        job_sched_slot_t *s = &slots[i];
+        
+        if (s->desc.run == NULL || s->desc.period_us == 0U ||
+            (int32_t)(now - s->release_at) < 0) {
+            continue;
+        }
+        
+        job_sched_release_at(s, s->release_at);
+        s->release_at += s->desc.period_us;
+        if ((int32_t)(now - s->release_at) >= 0) {
+            s->release_at = now + s->desc.period_us;
+        }
+    }
+}
+
+/**
+ * @brief Released job with the nearest deadline (NULL if none)
+ */
+static job_sched_slot_t *job_sched_pick(void)
+{
+    job_sched_slot_t *best = NULL;
+    
+    for (uint8_t i = 0; i < JOB_SCHED_SLOTS; i++) {
+        job_sched_slot_t *s = &slots[i];
+        
+        if (s->desc.run != NULL && s->released &&
+            (best == NULL || (int32_t)(s->deadline_at - best->deadline_at) < 0)) {
+            best = s;
+        }
+    }
+    return best;
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+bool job_sched_register(uint8_t slot, const job_sched_desc_t *desc)
+{
+    job_sched_slot_t *s;
+    
+    if (slot >= JOB_SCHED_SLOTS) {
+        return false;
+    }
+    s = &slots[slot];
+    if (desc == NULL || desc->run == NULL) {
+        s->desc.run = NULL;
+        s->released = false;
+        return true;
+    }
+    if (desc->deadline_us == 0U || desc->deadline_us > (uint32_t)INT32_MAX ||
+        desc->period_us > (uint32_t)INT32_MAX) {
+        return false;
+    }
+    
+    s->desc = *desc;
+    s->released = false;
+    s->release_at = timebase_now_us();
+    s->stats = (job_sched_stats_t){0};
+    return true;
+}
+
+void job_sched_release(uint8_t slot)
+{
+    if (slot < JOB_SCHED_SLOTS && slots[slot].desc.run != NULL) {
+        job_sched_release_at(&slots[slot], timebase_now_us());
+    }
+}
+
+uint32_t job_sched_run(void)
+{
+    uint32_t count = 0;
+    
+    for (;;) {
+        uint32_t start = timebase_now_us();
+        job_sched_slot_t *s;
+        uint32_t end;
+        int32_t late;
+        
+        job_sched_release_due(start);
+        s = job_sched_pick();
+        if (s == NULL) {
+            break;
+        }
+        
+        s->released = false;  /* A release from inside the job runs it again */
+        s->desc.run();
+        end = timebase_now_us();
+        
+        s->stats.runs++;
+        s->stats.last_us = end - start;
+        if (s->stats.last_us > s->stats.max_us) {
+            s->stats.max_us = s->stats.last_us;
+        }
+        late = (int32_t)(end - s->deadline_at);
+        if (late > 0) {
+            s->stats.misses++;
+            if ((uint32_t)late > s->stats.max_late_us) {
+                s->stats.max_late_us = (uint32_t)late;
+            }
+        }
+        count++;
+    }
+    return count;
+}
+
+bool job_sched_next_release(uint32_t *at_us)
+{
+    uint32_t now = timebase_now_us();
+    bool found = false;
+    uint32_t next = 0;
+    
+    for (uint8_t i = 0; i < JOB_SCHED_SLOTS; i++) {
+        const job_sched_slot_t *s = &slots[i];
+        
+        if (s->desc.run == NULL || s->desc.period_us == 0U) {
+            continue;
+        }
+        if (!found || (int32_t)(s->release_at - next) < 0) {
+            next = s->release_at;
+            found = true;
+        }
+    }
+    
+    if (found && at_us != NULL) {
+        /* One already due goes now */
+        *at_us = ((int32_t)(next - now) < 0) ? now : next;
+    }
+    return found;
+}
+
+bool job_sched_get_stats(uint8_t slot, job_sched_stats_t *stats)
+{
+    if (slot >= JOB_SCHED_SLOTS || stats == NULL) {
+        return false;
+    }
+    
+    *stats = slots[slot].stats;
+    return true;
+}
+
+void job_sched_reset_stats(void)
+{
+    for (uint8_t i = 0; i < JOB_SCHED_SLOTS; i++) {
+        slots[i].stats = (job_sched_stats_t){0};
+    }
+}
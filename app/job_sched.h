@@ -0,0 +1,120 @@
+#ifndef JOB_SCHED_H
+#define JOB_SCHED_H
+
+/**
+ * @file job_sched.h
+ * @brief Cooperative earliest-deadline-first job scheduler of the main loop
+ *
+ * Each piece of main loop work is a run-to-completion job in a slot, with a
+ * descriptor: the function, a period, and a deadline relative to each
+ * release. A periodic job releases itself every period; one with period 0
+ * is released by job_sched_release() (from the events the interrupts
+ * raise). job_sched_run() runs the released jobs one at a time, always the
+ * one whose deadline is nearest, so a sample to publish never waits behind
+ * statistics, logging or EEPROM work released earlier with a later
+ * deadline. A job is not preempted: the longest one bounds how late a more
+ * urgent job can be.
+ *
+ * Times are on the microsecond timebase (timebase.h), which halts in STOP
+ * with any periodic release. Each slot counts its runs, the deadlines it
+ * missed (finished after the deadline) and its execution time.
+ *
+ * Main loop only.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+#define JOB_SCHED_SLOTS  8U
+
+/**
+ * @brief Job function
+ */
+typedef void (*job_sched_fn_t)(void);
+
+/**
+ * @brief Job descriptor
+ */
+typedef struct {
+    job_sched_fn_t run;
+    uint32_t period_us;    /* Released every period_us (0: by job_sched_release() only) */
+    uint32_t deadline_us;  /* Finish within this of the release, 1..2^31-1 */
+} job_sched_desc_t;
+
+/**
+ * @brief Per-job statistics
+ */
+typedef struct {
+    uint32_t runs;
+    uint32_t misses;       /* Runs finished after their deadline */
+    uint32_t last_us;      /* Execution time of the last run */
+    uint32_t max_us;       /* Longest execution time */
+    uint32_t max_late_us;  /* Worst finish past the deadline */
+} job_sched_stats_t;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Put a job in a slot
+ *
+ * A periodic job is released at once.
+ *
+ * @param slot 0..JOB_SCHED_SLOTS-1
+ * @param desc Descriptor, copied (NULL frees the slot)
+ * @return true if set, false if out of range
+ */
+bool job_sched_register(uint8_t slot, const job_sched_desc_t *desc);
+
+/**
+ * @brief Release a job now (ignored if already released)
+ *
+ * A job released again before it has run keeps its earlier deadline.
+ */
+void job_sched_release(uint8_t slot);
+
+/**
+ * @brief Run the released jobs, earliest deadline first, until none is left
+ *
+ * @return Number of jobs run
+ */
+uint32_t job_sched_run(void);
+
+/**
+ * @brief When the next periodic release is due
+ *
+ * For the main loop to sleep until then.
+ *
+ * @param at_us Receives the release time (timebase_now_us() time)
+ * @return true if a periodic job is waiting for its release, false if none
+ */
+bool job_sched_next_release(uint32_t *at_us);
+
+/**
+ * @brief Statistics of a slot
+ *
+ * @param slot 0..JOB_SCHED_SLOTS-1
+ * @param stats Receives them
+ * @return true on success, false if out of range or stats is NULL
+ */
+bool job_sched_get_stats(uint8_t slot, job_sched_stats_t *stats);
+
+/**
+ * @brief Clear the statistics of every slot
+ */
+void job_sched_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JOB_SCHED_H */
@@ -0,0 +1,135 @@
+/**
+ * @file latency.c
+ * @brief Sample-to-output latency histograms implementation
+ *
+ * Stages record from the bottom half and the main loop, so a record is
+ * masked (a bucket pick and two increments) like prof_record(). The bucket
+ * is found by halving, as the Cortex-M0+ has no CLZ.
+ */
+
+#include "latency.h"
+
+#if BOARD_LATENCY_ENABLE
+
+#include <stddef.h>
+#include "hal_config.h"  /* For hal_tim2_get_timestamp_us() */
+#include "hal_atomic.h"
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static latency_hist_t hists[LATENCY_STAGES];
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief floor(log2(us)), 0 for 0 and 1, capped at the last bucket
+ */
+static uint32_t latency_bucket(uint32_t us)
+{
+    uint32_t bucket = 0;
+    
+    if (us >= (1UL << (LATENCY_BUCKETS - 1U))) {
+        return LATENCY_BUCKETS - 1U;
+    }
+    if (us >= (1UL << 8)) {
+        us >>= 8;
+        bucket += 8U;
+    }
+    if (us >= (1UL << 4)) {
+        us >>= 4;
+        bucket += 4U;
+    }
+    if (us >= (1UL << 2)) {
+        us >>= 2;
+        bucket += 2U;
+    }
+    if (us >= (1UL << 1)) {
+        bucket += 1U;
+    }
+    return bucket;
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+void latency_record(latency_stage_t stage, uint32_t timestamp_us)
+{
+    latency_add(stage, hal_tim2_get_timestamp_us() - timestamp_us);
+}
+
+void latency_add(latency_stage_t stage, uint32_t us)
+{
+    uint32_t bucket = latency_bucket(us);
+    latency_hist_t *hist;
+    uint32_t primask;
+    
+    if ((uint32_t)stage >= LATENCY_STAGES) {
+        return;
+    }
+    
+    hist = &hists[stage];
+    
+    primask = hal_crit_enter();
+    if (hist->total != UINT32_MAX) {
+        hist->total++;
+    }
+    if (hist->count[bucket] != UINT32_MAX) {
+        hist->count[bucket]++;
+    }
+    hal_crit_exit(primask);
+}
+
+bool latency_get(latency_stage_t stage, latency_hist_t *hist)
+{
+    uint32_t primask;
+    
+    if ((uint32_t)stage >= LATENCY_STAGES || hist == NULL) {
+        return false;
+    }
+    
+    primask = hal_crit_enter();
+    *hist = hists[stage];
+    hal_crit_exit(primask);
+    
+    return true;
+}
+
+uint8_t latency_percentile(const latency_hist_t *hist, uint32_t percent)
+{
+    uint64_t target;
+    uint64_t sum = 0;
+    
+    if (hist == NULL || hist->total == 0U) {
+        return 0;
+    }
+    
+    /* Compared in 64 bits: total * 100 does not fit 32 */
+    target = (uint64_t)hist->total * percent;
+    for (uint32_t i = 0; i < LATENCY_BUCKETS; i++) {
+        sum += hist->count[i];
+        if (sum * 100U >= target) {
+            return (uint8_t)i;
+        }
+    }
+    return (uint8_t)(LATENCY_BUCKETS - 1U);
+}
+
+void latency_reset(void)
+{
+    uint32_t primask = hal_crit_enter();
+    
+    for (uint32_t i = 0; i < LATENCY_STAGES; i++) {
+        hists[i].total = 0;
+        for (uint32_t b = 0; b < LATENCY_BUCKETS; b++) {
+            hists[i].count[b] = 0;
+        }
+    }
+    hal_crit_exit(primask);
+}
+
+#endif /* BOARD_LATENCY_ENABLE */
@@ -0,0 +1,128 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+/**
+ * @file latency.h
+ * @brief Sample-to-output latency histograms
+ *
+ * Each pipeline stage records, per sample it passes on, the time since the
+ * sample's conversion started (its TIM2 us timestamp) in a log2 histogram:
+ * bucket 0 holds 0..1 us, bucket k (1..LATENCY_BUCKETS-2) 2^k..2^(k+1)-1 us,
+ * the last one everything longer. Distributions rather than means, so a
+ * tail that grows shows as a percentile bucket that moves.
+ *
+ * Stages: compensated (bottom half, the sample enters the ring), published
+ * to the slave registers, written to the DAC (main loop, newest sample of
+ * each update). A fourth histogram holds the sampling jitter instead: how
+ * far each interval between conversion starts is off the running mean
+ * (sensor_sampling_get_jitter_stats()), and a fifth the time from an
+ * external sync edge to the conversion command it starts. The master reads
+ * one bucket at a time through the APP_REG_LAT_* window, selected by
+ * HOST_CMD_LATENCY, next to the 50th and 99th percentile buckets of the
+ * stage.
+ *
+ * Built only with BOARD_LATENCY_ENABLE: otherwise LATENCY_RECORD() expands
+ * to nothing.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+#define LATENCY_BUCKETS  16U  /* Last bucket: 2^15 us (~33 ms) and more */
+
+/**
+ * @brief Pipeline stage (HOST_CMD_LATENCY selector)
+ */
+typedef enum {
+    LATENCY_STAGE_COMPENSATED = 0,  /* Compensated and filtered, in the sample ring */
+    LATENCY_STAGE_SLAVE,            /* Published to the I2C slave registers */
+    LATENCY_STAGE_DAC,              /* Written to the DAC outputs */
+    LATENCY_STAGE_JITTER,           /* |conversion start interval - mean interval| */
+    LATENCY_STAGE_SYNC_IN,          /* Sync input edge (vector entry) to conversion command */
+    LATENCY_STAGES
+} latency_stage_t;
+
+/**
+ * @brief Histogram of one stage
+ */
+typedef struct {
+    uint32_t total;                    /* Samples recorded (saturating) */
+    uint32_t count[LATENCY_BUCKETS];   /* Samples per bucket (saturating) */
+} latency_hist_t;
+
+/* ============================================================================
+ * MACROS
+ * ============================================================================ */
+
+#if BOARD_LATENCY_ENABLE
+/** Record a sample leaving a stage now */
+#define LATENCY_RECORD(stage, timestamp_us)  latency_record((stage), (timestamp_us))
+/** Add a time already measured to a histogram */
+#define LATENCY_ADD(stage, us)               latency_add((stage), (us))
+#else
+#define LATENCY_RECORD(stage, timestamp_us)  ((void)0)
+#define LATENCY_ADD(stage, us)               ((void)0)
+#endif
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Record a sample leaving a stage (LATENCY_RECORD())
+ *
+ * Safe from any context.
+ *
+ * @param stage Pipeline stage
+ * @param timestamp_us Timestamp of the sample (conversion start)
+ */
+void latency_record(latency_stage_t stage, uint32_t timestamp_us);
+
+/**
+ * @brief Add a time to a histogram (LATENCY_ADD())
+ *
+ * Safe from any context.
+ *
+ * @param stage Histogram
+ * @param us Time, us
+ */
+void latency_add(latency_stage_t stage, uint32_t us);
+
+/**
+ * @brief Get the histogram of a stage
+ *
+ * @param stage Pipeline stage
+ * @param hist Receives the histogram (one consistent snapshot)
+ * @return true on success, false if the stage is out of range
+ */
+bool latency_get(latency_stage_t stage, latency_hist_t *hist);
+
+/**
+ * @brief Bucket holding a percentile of a histogram
+ *
+ * @param hist Histogram
+ * @param percent 1..100
+ * @return Lowest bucket with percent of the samples at or below it (0 if
+ *         the histogram is empty)
+ */
+uint8_t latency_percentile(const latency_hist_t *hist, uint32_t percent);
+
+/**
+ * @brief Clear every histogram
+ */
+void latency_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LATENCY_H */
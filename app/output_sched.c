@@ -0,0 +1,98 @@
+/**
+ * @file output_sched.c
+ * @brief Multi-rate output scheduler implementation
+ *
+ * A slot counts samples up to its decimation; the count saturates there,
+ * so a long batch runs the consumer once, with the newest sample.
+ */
+
+#include "output_sched.h"
+
+#include <stddef.h>
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+typedef struct {
+    output_sched_callback_t callback;
+    uint16_t decimation;  /* 0 = free */
+    uint16_t count;       /* Samples since the last run */
+    bool triggered;
+} output_sched_slot_t;
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static output_sched_slot_t slots[OUTPUT_SCHED_SLOTS];
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+bool output_sched_register(uint8_t slot, output_sched_callback_t callback, uint32_t decimation)
+{
+    if (slot >= OUTPUT_SCHED_SLOTS) {
+        return false;
+    }
+    if (callback == NULL) {
+        slots[slot].callback = NULL;
+        slots[slot].decimation = 0;
+        return true;
+    }
+    if (decimation == 0U || decimation > OUTPUT_SCHED_DECIMATION_MAX) {
+        return false;
+    }
+    
+    slots[slot].callback = callback;
+    slots[slot].decimation = (uint16_t)decimation;
+    slots[slot].count = 0;
+    slots[slot].triggered = true;
+    return true;
+}
+
+bool output_sched_set_decimation(uint8_t slot, uint32_t decimation)
+{
+    if (slot >= OUTPUT_SCHED_SLOTS || slots[slot].callback == NULL ||
+        decimation == 0U || decimation > OUTPUT_SCHED_DECIMATION_MAX) {
+        return false;
+    }
+    
+    slots[slot].decimation = (uint16_t)decimation;
+    return true;
+}
+
+uint32_t output_sched_get_decimation(uint8_t slot)
+{
+    return (slot < OUTPUT_SCHED_SLOTS) ? slots[slot].decimation : 0U;
+}
+
+void output_sched_trigger(uint8_t slot)
+{
+    if (slot < OUTPUT_SCHED_SLOTS) {
+        slots[slot].triggered = true;
+    }
+}
+
+void output_sched_run(const output_sched_input_t *input, uint32_t samples)
+{
+    for (uint8_t i = 0; i < OUTPUT_SCHED_SLOTS; i++) {
+        output_sched_slot_t *s = &slots[i];
+        uint32_t count;
+        
+        if (s->callback == NULL) {
+            continue;
+        }
+        
+        count = (uint32_t)s->count + samples;
+        if (count < s->decimation && !s->triggered) {
+            s->count = (uint16_t)count;
+            continue;
+        }
+        
+        s->count = 0;
+        s->triggered = false;
+        s->callback(input);
+    }
+}
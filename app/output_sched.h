@@ -0,0 +1,95 @@
+#ifndef OUTPUT_SCHED_H
+#define OUTPUT_SCHED_H
+
+/**
+ * @file output_sched.h
+ * @brief Multi-rate output scheduler of the main loop
+ *
+ * Each consumer of the newest sample (DAC outputs, slave registers, the
+ * EEPROM statistics record) sits in a slot with a callback and a decimation:
+ * it runs once every that many samples, counted over every sample the main
+ * loop takes (a loop that drains a batch counts the whole batch). Fast
+ * outputs stay at the sample rate while slow ones cost nothing in between.
+ *
+ * Main loop only.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sensor_sampling.h"  /* For sensor_data_t type */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+#define OUTPUT_SCHED_SLOTS           4U
+#define OUTPUT_SCHED_DECIMATION_MAX  65535U
+
+/**
+ * @brief Newest sample as handed to the consumers
+ */
+typedef struct {
+    const sensor_data_t *sample;  /* Newest sample */
+    int32_t pressure;             /* Clamped, 0.01 mbar */
+    int32_t temperature;          /* Clamped, 0.01 degC */
+    int32_t derived;              /* Depth or altitude, mm (derived.h) */
+} output_sched_input_t;
+
+/**
+ * @brief Consumer callback
+ */
+typedef void (*output_sched_callback_t)(const output_sched_input_t *input);
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Put a consumer in a slot; it runs at the next sample
+ *
+ * @param slot 0..OUTPUT_SCHED_SLOTS-1
+ * @param callback Consumer (NULL frees the slot)
+ * @param decimation Samples per run (1..OUTPUT_SCHED_DECIMATION_MAX)
+ * @return true if set, false if out of range
+ */
+bool output_sched_register(uint8_t slot, output_sched_callback_t callback, uint32_t decimation);
+
+/**
+ * @brief Change the decimation of a slot
+ *
+ * Samples already counted towards the next run are kept, so a consumer
+ * sped up runs at the next sample that reaches the new count.
+ *
+ * @return true if set, false if out of range
+ */
+bool output_sched_set_decimation(uint8_t slot, uint32_t decimation);
+
+/**
+ * @brief Decimation of a slot (0 = no consumer)
+ */
+uint32_t output_sched_get_decimation(uint8_t slot);
+
+/**
+ * @brief Run a slot at the next output_sched_run(), whatever its count
+ */
+void output_sched_trigger(uint8_t slot);
+
+/**
+ * @brief Count new samples and run every consumer that is due
+ *
+ * Slots run in slot order.
+ *
+ * @param input Newest sample
+ * @param samples Samples taken since the last call (at least 1)
+ */
+void output_sched_run(const output_sched_input_t *input, uint32_t samples);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OUTPUT_SCHED_H */
@@ -0,0 +1,170 @@
+/**
+ * @file perf_bank.c
+ * @brief Read-only performance counter bank implementation
+ *
+ * Three copies: the one being sent (taken at the last address match), the
+ * newest complete one, and the one the main loop writes next, which is
+ * always neither of the others. A new copy is switched in with one store
+ * once written whole, so the address callback never sees half of one and
+ * takes no lock.
+ */
+
+#include "perf_bank.h"
+#include "stm32l0xx_hal.h"  /* For __DMB() */
+
+#include <stddef.h>
+#if BOARD_CRC_FRAMING_ENABLE
+#include "crc.h"
+#endif
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#if BOARD_CRC_FRAMING_ENABLE
+#define PERF_BANK_CRC_SIZE  2U
+#else
+#define PERF_BANK_CRC_SIZE  0U
+#endif
+
+#define PERF_BANK_COPIES    3U
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static uint8_t banks[PERF_BANK_COPIES][PERF_BANK_SIZE + PERF_BANK_CRC_SIZE];
+static volatile uint8_t newest = 0;
+static volatile uint8_t sending = 0;
+static volatile bool published = false;
+static uint16_t snapshots = 0;
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static void perf_bank_put_u16(uint8_t *dst, uint16_t value)
+{
+    dst[0] = (uint8_t)(value & 0xFF);
+    dst[1] = (uint8_t)(value >> 8);
+}
+
+static void perf_bank_put_u32(uint8_t *dst, uint32_t value)
+{
+    dst[0] = (uint8_t)(value & 0xFF);
+    dst[1] = (uint8_t)((value >> 8) & 0xFF);
+    dst[2] = (uint8_t)((value >> 16) & 0xFF);
+    dst[3] = (uint8_t)((value >> 24) & 0xFF);
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+void perf_bank_publish(const perf_bank_values_t *values)
+{
+    uint8_t next = 0;
+    uint8_t *b;
+
+    if (values == NULL) {
+        return;
+    }
+
+    /* A copy taken meanwhile is the newest one, never this one */
+    while (next == newest || next == sending) {
+        next++;
+    }
+    b = banks[next];
+
+    b[0x00] = PERF_BANK_VERSION;
+    b[0x01] = (uint8_t)PERF_BANK_SIZE;
+    perf_bank_put_u16(&b[0x02], ++snapshots);
+    perf_bank_put_u32(&b[0x04], values->uptime_s);
+    perf_bank_put_u32(&b[0x08], values->sample_rate_centihz);
+    perf_bank_put_u32(&b[0x0C], values->samples);
+    perf_bank_put_u32(&b[0x10], values->fifo_dropped);
+    perf_bank_put_u32(&b[0x14], values->ring_dropped);
+    perf_bank_put_u32(&b[0x18], values->tick_overruns);
+    perf_bank_put_u16(&b[0x1C], values->idle_centipct);
+    b[0x1E] = values->fifo_high_water;
+    b[0x1F] = (uint8_t)PERF_ISR_COUNT;
+    perf_bank_put_u32(&b[0x20], values->stack_peak);
+    perf_bank_put_u32(&b[0x24], values->slave_errors);
+    perf_bank_put_u32(&b[0x28], values->slave_overruns);
+    perf_bank_put_u32(&b[0x2C], values->sensor_errors);
+    perf_bank_put_u32(&b[0x30], values->sensor_timeouts);
+    perf_bank_put_u32(&b[0x34], values->sensor_recoveries);
+    for (uint32_t i = 0; i < PERF_ISR_COUNT; i++) {
+        perf_bank_put_u16(&b[PERF_BANK_WCET + 2U * i], values->wcet_us[i]);
+    }
+    perf_bank_put_u32(&b[PERF_BANK_DAC], values->dac_underruns);
+    perf_bank_put_u32(&b[PERF_BANK_DAC + 4U], values->dac_overflows);
+    perf_bank_put_u16(&b[PERF_BANK_HEALTH], values->vdda_mv);
+    perf_bank_put_u16(&b[PERF_BANK_HEALTH + 2U], (uint16_t)values->temp_centi);
+    perf_bank_put_u16(&b[PERF_BANK_HEALTH + 4U], values->supply_mv);
+    perf_bank_put_u16(&b[PERF_BANK_CAPS], values->caps_present);
+    perf_bank_put_u16(&b[PERF_BANK_CAPS + 2U], values->caps_prom_ok);
+    b[PERF_BANK_CAPS + 4U] = values->caps_speed[0];
+    b[PERF_BANK_CAPS + 5U] = values->caps_speed[1];
+    perf_bank_put_u16(&b[PERF_BANK_CAPS + 6U], values->caps_word_us[0]);
+    perf_bank_put_u16(&b[PERF_BANK_CAPS + 8U], values->caps_word_us[1]);
+    perf_bank_put_u16(&b[PERF_BANK_CAPS + 10U], values->caps_compensate_ns);
+    b[PERF_BANK_CAPS + 12U] = values->caps_osr_levels;
+    b[PERF_BANK_CAPS + 13U] = values->caps_flags;
+    perf_bank_put_u32(&b[PERF_BANK_CLOCK], (uint32_t)values->clock_error_ppb);
+    b[PERF_BANK_CLOCK + 4U] = values->clock_trim;
+    b[PERF_BANK_CLOCK + 5U] = values->clock_source;
+    b[PERF_BANK_CLOCK + 6U] = values->clock_flags;
+    b[PERF_BANK_CLOCK + 7U] = values->clock_trims;
+    perf_bank_put_u16(&b[PERF_BANK_VOTE], values->vote_voted);
+    perf_bank_put_u16(&b[PERF_BANK_VOTE + 2U], values->vote_agreed);
+    perf_bank_put_u32(&b[PERF_BANK_VOTE + 4U], values->vote_fused);
+    for (uint32_t i = 0; i < PERF_BANK_VOTE_PROBES; i++) {
+        b[PERF_BANK_VOTE + 8U + i] = values->vote_outvoted[i];
+    }
+    perf_bank_put_u16(&b[PERF_BANK_POWER], values->wake_min_us);
+    perf_bank_put_u16(&b[PERF_BANK_POWER + 2U], values->wake_max_us);
+    perf_bank_put_u32(&b[PERF_BANK_POWER + 4U], values->wakes);
+    b[PERF_BANK_POWER + 8U] = (uint8_t)BOARD_POWER_PROFILE;
+    perf_bank_put_u32(&b[PERF_BANK_ENERGY], values->energy_run_ms);
+    perf_bank_put_u32(&b[PERF_BANK_ENERGY + 4U], values->energy_sleep_ms);
+    perf_bank_put_u32(&b[PERF_BANK_ENERGY + 8U], values->energy_stop_ms);
+    perf_bank_put_u32(&b[PERF_BANK_ENERGY + 12U], values->energy_stops);
+    perf_bank_put_u32(&b[PERF_BANK_ENERGY + 16U], values->energy_bus_ms);
+    perf_bank_put_u32(&b[PERF_BANK_ENERGY + 20U], values->energy_dac_ms);
+    perf_bank_put_u32(&b[PERF_BANK_ENERGY + 24U], values->energy_current_deci_ua);
+    for (uint32_t i = 0; i < PERF_BANK_CONV_LEVELS; i++) {
+        perf_bank_put_u16(&b[PERF_BANK_CONV + 2U * i], values->conv_us[i]);
+    }
+    b[PERF_BANK_CONV + 2U * PERF_BANK_CONV_LEVELS] = values->conv_measured;
+    b[PERF_BANK_CONV + 2U * PERF_BANK_CONV_LEVELS + 1U] = values->conv_flags;
+    perf_bank_put_u16(&b[PERF_BANK_SLAVE], values->slave_load_centipct);
+    perf_bank_put_u16(&b[PERF_BANK_SLAVE + 2U], values->slave_load_peak_centipct);
+    perf_bank_put_u32(&b[PERF_BANK_SLAVE + 4U], values->slave_throttles);
+    perf_bank_put_u32(&b[PERF_BANK_SLAVE + 8U], values->slave_throttled_us);
+    perf_bank_put_u32(&b[PERF_BANK_POLL], values->poll_period_us);
+    perf_bank_put_u32(&b[PERF_BANK_POLL + 4U], (uint32_t)values->poll_error_us);
+    perf_bank_put_u32(&b[PERF_BANK_POLL + 8U], values->poll_age_us);
+    perf_bank_put_u32(&b[PERF_BANK_POLL + 12U], values->poll_shifts);
+    b[PERF_BANK_POLL + 16U] = values->poll_state;
+    b[PERF_BANK_POLL + 17U] = values->poll_enabled;
+#if BOARD_CRC_FRAMING_ENABLE
+    perf_bank_put_u16(&b[PERF_BANK_SIZE], crc16_update(CRC16_INIT, b, PERF_BANK_SIZE));
+#endif
+
+    /* Whole copy written before the address callback can take it */
+    __DMB();
+    newest = next;
+    published = true;
+}
+
+const uint8_t *perf_bank_take(uint16_t *len)
+{
+    if (!published) {
+        return NULL;
+    }
+
+    sending = newest;
+    *len = (uint16_t)(PERF_BANK_SIZE + PERF_BANK_CRC_SIZE);
+    return banks[sending];
+}
@@ -0,0 +1,233 @@
+#ifndef PERF_BANK_H
+#define PERF_BANK_H
+
+/**
+ * @file perf_bank.h
+ * @brief Read-only performance counter bank at APP_REG_PERF
+ *
+ * One versioned frame with the runtime telemetry, read from APP_REG_PERF
+ * in one transaction (stream register, like the FIFO burst). The main
+ * loop builds a fresh copy every BOARD_PERF_PERIOD_US; address match only
+ * takes the newest complete one, so a read costs the I2C1 interrupt two
+ * stores and every field of a frame comes from the same instant.
+ *
+ * Frame, little-endian (PERF_BANK_VERSION 10):
+ *   0x00 uint8   version
+ *   0x01 uint8   length, bytes before the CRC
+ *   0x02 uint16  snapshot number (wraps)
+ *   0x04 uint32  uptime, s (the timebase: STOP not counted)
+ *   0x08 uint32  sample rate over the last period, 0.01 samples/s
+ *   0x0C uint32  samples published (sequence number of the newest)
+ *   0x10 uint32  samples dropped on a full FIFO frame
+ *   0x14 uint32  samples and raw pairs dropped on a full sampler ring
+ *   0x18 uint32  sampling ticks overrun
+ *   0x1C uint16  CPU idle over the last period, 0.01 % (0xFFFF: not built)
+ *   0x1E uint8   FIFO high-water, samples in a frame
+ *   0x1F uint8   interrupt sources below (PERF_ISR_COUNT)
+ *   0x20 uint32  stack high-water, bytes
+ *   0x24 uint32  slave bus errors
+ *   0x28 uint32  slave overruns
+ *   0x2C uint32  sensor bus errors (cycles aborted)
+ *   0x30 uint32  sensor bus timeouts
+ *   0x34 uint32  sensor bus recoveries
+ *   0x38 uint16  longest handler per perf_isr_t source, us (0: not built)
+ * version 2, after those (PERF_BANK_DAC):
+ *   +0   uint32  DAC playout underruns (dac_playout_get_stats())
+ *   +4   uint32  DAC playout overflows
+ * version 3, after those (PERF_BANK_HEALTH), from the newest ADC scan:
+ *   +0   uint16  VDDA, mV (0: no scan yet, or BOARD_ADC_SCAN_PERIOD_MS 0)
+ *   +2   int16   MCU temperature, 0.01 degC
+ *   +4   uint16  supply input, mV (0: BOARD_ADC_SUPPLY_ENABLE off)
+ * version 4, after those (PERF_BANK_CAPS), the boot self-test
+ * (self_test.h, 0 with BOARD_SELF_TEST_ENABLE off); probe masks are
+ * bits 7:0 I2C2 mux channels (bit 0 alone: single sensor), 15:8 I2C3:
+ *   +0   uint16  probes that answered
+ *   +2   uint16  probes with a good PROM CRC-4
+ *   +4   uint8   I2C2 speed at boot (APP_REG_I2C2_SPEED layout)
+ *   +5   uint8   I2C3 speed at boot
+ *   +6   uint16  I2C2 PROM word transaction, us (0: no probe)
+ *   +8   uint16  I2C3 PROM word transaction, us
+ *   +10  uint16  one compensation, ns (0: no good PROM)
+ *   +12  uint8   oversampling levels of the sensor
+ *   +13  uint8   self-test flags (SELF_TEST_*)
+ * version 5, after those (PERF_BANK_CLOCK), the HSI trimming
+ * (clock_trim.h, 0 with BOARD_CLOCK_TRIM_ENABLE off):
+ *   +0   int32   HSI error at the last estimate, ppb (positive: fast)
+ *   +4   uint8   HSITRIM code in effect
+ *   +5   uint8   reference of the estimate (CLOCK_TRIM_SOURCE_*)
+ *   +6   uint8   trim flags (CLOCK_TRIM_*)
+ *   +7   uint8   trim steps since boot (saturated)
+ * version 6, after those (PERF_BANK_VOTE), the probe voting
+ * (sensor_vote.h, 0 with BOARD_SENSOR_VOTE_ENABLE off); probe masks are
+ * bit n = array channel n:
+ *   +0   uint16  probes in the last vote
+ *   +2   uint16  of those, within the tolerances
+ *   +4   uint32  fused samples published
+ *   +8   uint8   votes lost per array channel 0..15 (saturated), x16
+ * version 7, after those (PERF_BANK_POWER), the sampling tick wake-up
+ * latency (perf.h, 0 with BOARD_PERF_ENABLE off), since boot or the last
+ * benchmark start:
+ *   +0   uint16  shortest, us (0: none measured)
+ *   +2   uint16  longest, us
+ *   +4   uint32  wake-ups measured
+ *   +8   uint8   BOARD_POWER_PROFILE
+ * version 8, after those (PERF_BANK_ENERGY), the power-mode residency
+ * since boot and the current estimate (energy.h, 0 with
+ * BOARD_ENERGY_ENABLE off):
+ *   +0   uint32  run, ms
+ *   +4   uint32  sleep, ms
+ *   +8   uint32  STOP, ms (timed spans only)
+ *   +12  uint32  STOP entries
+ *   +16  uint32  sensor buses transferring, ms (I2C2 and I2C3 added up)
+ *   +20  uint32  DAC stream running, ms
+ *   +24  uint32  average supply current over the last period, 0.1 uA
+ * version 9, after those (PERF_BANK_CONV), the conversion time
+ * calibration (conv_tune.h, 0 with BOARD_CONV_TUNE_ENABLE off):
+ *   +0   uint16  conversion time in use per OSR 256 .. 8192, us, x6
+ *   +12  uint8   levels searched (bit n: OSR index n)
+ *   +13  uint8   calibration flags (CONV_TUNE_*)
+ * version 10, after those (PERF_BANK_SLAVE), the slave load limit
+ * (i2c_slave.h, 0 with BOARD_I2C1_LOAD_BUDGET_PCT 0):
+ *   +0   uint16  I2C1 handler time over the last full window, 0.01 %
+ *   +2   uint16  highest window since boot, 0.01 %
+ *   +4   uint32  windows that passed the budget (addresses turned off)
+ *   +8   uint32  time the addresses were off, us (wraps)
+ * version 11, after those (PERF_BANK_POLL), the master poll alignment
+ * (poll_align.h, 0 with BOARD_POLL_ALIGN_ENABLE off):
+ *   +0   uint32  master poll period, us (0: not measured)
+ *   +4   int32   prediction error at the last poll, us
+ *   +8   uint32  sample age at the polls, averaged, us
+ *   +12  uint32  tick phase moves since boot
+ *   +16  uint8   estimate state (POLL_ALIGN_*)
+ *   +17  uint8   alignment on
+ * then, with BOARD_CRC_FRAMING_ENABLE, a CRC-16 (crc.h) of those bytes.
+ * Later versions only append fields: a reader takes the length from
+ * byte 1 and the fields it knows.
+ *
+ * Producer: main loop (perf_bank_publish()). Consumer: I2C1 address
+ * callback (perf_bank_take()).
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board_config.h"
+#include "perf.h"  /* For PERF_ISR_COUNT */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+#define PERF_BANK_VERSION    11U
+#define PERF_BANK_WCET       0x38U  /* Offset of the handler times */
+#define PERF_BANK_DAC        (PERF_BANK_WCET + 2U * PERF_ISR_COUNT)
+#define PERF_BANK_HEALTH     (PERF_BANK_DAC + 8U)
+#define PERF_BANK_CAPS       (PERF_BANK_HEALTH + 6U)
+#define PERF_BANK_CLOCK      (PERF_BANK_CAPS + 14U)
+#define PERF_BANK_VOTE       (PERF_BANK_CLOCK + 8U)
+#define PERF_BANK_VOTE_PROBES 16U
+#define PERF_BANK_POWER      (PERF_BANK_VOTE + 8U + PERF_BANK_VOTE_PROBES)
+#define PERF_BANK_ENERGY     (PERF_BANK_POWER + 9U)
+#define PERF_BANK_CONV       (PERF_BANK_ENERGY + 28U)
+#define PERF_BANK_CONV_LEVELS 6U
+#define PERF_BANK_SLAVE      (PERF_BANK_CONV + 2U * PERF_BANK_CONV_LEVELS + 2U)
+#define PERF_BANK_POLL       (PERF_BANK_SLAVE + 12U)
+#define PERF_BANK_SIZE       (PERF_BANK_POLL + 18U)
+
+#define PERF_BANK_IDLE_NONE  0xFFFFU
+
+/**
+ * @brief Bank contents
+ */
+typedef struct {
+    uint32_t uptime_s;
+    uint32_t sample_rate_centihz;
+    uint32_t samples;
+    uint32_t fifo_dropped;
+    uint32_t ring_dropped;
+    uint32_t tick_overruns;
+    uint16_t idle_centipct;
+    uint8_t fifo_high_water;
+    uint32_t stack_peak;
+    uint32_t slave_errors;
+    uint32_t slave_overruns;
+    uint32_t sensor_errors;
+    uint32_t sensor_timeouts;
+    uint32_t sensor_recoveries;
+    uint16_t wcet_us[PERF_ISR_COUNT];
+    uint32_t dac_underruns;
+    uint32_t dac_overflows;
+    uint16_t vdda_mv;
+    int16_t temp_centi;
+    uint16_t supply_mv;
+    uint16_t caps_present;
+    uint16_t caps_prom_ok;
+    uint8_t caps_speed[2];
+    uint16_t caps_word_us[2];
+    uint16_t caps_compensate_ns;
+    uint8_t caps_osr_levels;
+    uint8_t caps_flags;
+    int32_t clock_error_ppb;
+    uint8_t clock_trim;
+    uint8_t clock_source;
+    uint8_t clock_flags;
+    uint8_t clock_trims;
+    uint16_t vote_voted;
+    uint16_t vote_agreed;
+    uint32_t vote_fused;
+    uint8_t vote_outvoted[PERF_BANK_VOTE_PROBES];
+    uint16_t wake_min_us;
+    uint16_t wake_max_us;
+    uint32_t wakes;
+    uint32_t energy_run_ms;
+    uint32_t energy_sleep_ms;
+    uint32_t energy_stop_ms;
+    uint32_t energy_stops;
+    uint32_t energy_bus_ms;
+    uint32_t energy_dac_ms;
+    uint32_t energy_current_deci_ua;
+    uint16_t conv_us[PERF_BANK_CONV_LEVELS];
+    uint8_t conv_measured;
+    uint8_t conv_flags;
+    uint16_t slave_load_centipct;
+    uint16_t slave_load_peak_centipct;
+    uint32_t slave_throttles;
+    uint32_t slave_throttled_us;
+    uint32_t poll_period_us;
+    int32_t poll_error_us;
+    uint32_t poll_age_us;
+    uint32_t poll_shifts;
+    uint8_t poll_state;
+    uint8_t poll_enabled;
+} perf_bank_values_t;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Publish a new copy of the bank (the next read takes it)
+ *
+ * @param values Contents
+ */
+void perf_bank_publish(const perf_bank_values_t *values);
+
+/**
+ * @brief Take the newest copy for transmission
+ *
+ * Called from the I2C slave address callback (interrupt context). The
+ * returned frame stays untouched until the next call.
+ *
+ * @param len Receives the frame length in bytes (CRC included)
+ * @return Frame bytes, NULL before the first publish (register image)
+ */
+const uint8_t *perf_bank_take(uint16_t *len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERF_BANK_H */
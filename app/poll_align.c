@@ -0,0 +1,246 @@
+/**
+ * @file poll_align.c
+ * @brief Sampling tick aligned to the master's polling period implementation
+ *
+ * The period is kept in 1/16 us, so the e / 16 of the loop is e itself and
+ * a 10 s period still fits an int32. Times are 32-bit wrapping timebase
+ * microseconds, compared signed.
+ *
+ * The tick target is the predicted poll less the lead and the margin,
+ * taken modulo the tick period against the next tick, and the tick moved
+ * the shorter way round.
+ */
+
+#include "poll_align.h"
+
+#if BOARD_POLL_ALIGN_ENABLE
+
+#include <stddef.h>
+#include "i2c_slave.h"
+#include "sensor_sampling.h"
+#include "hal_config.h"  /* For hal_tim2_get_timestamp_us(), hal_tim2_get_next_tick_us() */
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define POLL_ALIGN_PUBLISHED     4U   /* Samples kept to find the one a poll read */
+#define POLL_ALIGN_MAX_MISSED    16U  /* More polls unseen at once: start over */
+#define POLL_ALIGN_MAX_LEAD_US   1000000UL
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static poll_align_status_t status;
+static uint32_t seen_polls = 0;
+static uint32_t last_poll_us = 0;
+static uint32_t predicted_us = 0;  /* Next poll */
+static int32_t period_q4 = 0;      /* 1/16 us, 0 = not measured */
+static uint32_t locked_polls = 0;
+
+/* Newest samples in the slave registers: publication and conversion start */
+static uint32_t published_us[POLL_ALIGN_PUBLISHED];
+static uint32_t published_ts[POLL_ALIGN_PUBLISHED];
+static uint32_t published_count = 0;
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static int32_t poll_align_abs(int32_t value)
+{
+    return (value < 0) ? -value : value;
+}
+
+/**
+ * @brief Start the estimate over from the poll at t
+ *
+ * @param interval Time since the poll before, taken as the period if it
+ *                 was the one just before and in range
+ */
+static void poll_align_restart(uint32_t t, uint32_t interval, bool consecutive)
+{
+    if (consecutive && interval >= POLL_ALIGN_MIN_PERIOD_US && interval <= POLL_ALIGN_MAX_PERIOD_US) {
+        period_q4 = (int32_t)(interval * 16U);
+        predicted_us = t + interval;
+    } else {
+        period_q4 = 0;
+    }
+    locked_polls = 0;
+    status.state = POLL_ALIGN_ACQUIRING;
+    status.period_us = (uint32_t)period_q4 / 16U;
+}
+
+/**
+ * @brief One step of the loop for the poll at t, missed - 1 polls after the last
+ */
+static void poll_align_track(uint32_t t, uint32_t missed)
+{
+    uint32_t interval = t - last_poll_us;
+    int32_t period;
+    int32_t e;
+
+    last_poll_us = t;
+    if (status.state == POLL_ALIGN_NONE) {
+        status.state = POLL_ALIGN_ACQUIRING;
+        return;
+    }
+    if (period_q4 == 0 || missed > POLL_ALIGN_MAX_MISSED) {
+        poll_align_restart(t, interval, missed == 1U);
+        return;
+    }
+
+    /* Polls the main loop did not see: whole periods */
+    period = period_q4 / 16;
+    predicted_us += (missed - 1U) * (uint32_t)period;
+    e = (int32_t)(t - predicted_us);
+    status.error_us = e;
+    if (poll_align_abs(e) > period / 4) {
+        poll_align_restart(t, interval, missed == 1U);
+        return;
+    }
+
+    period_q4 += e;
+    if (period_q4 < (int32_t)(POLL_ALIGN_MIN_PERIOD_US * 16U) ||
+        period_q4 > (int32_t)(POLL_ALIGN_MAX_PERIOD_US * 16U)) {
+        poll_align_restart(t, interval, false);
+        return;
+    }
+    predicted_us += (uint32_t)(period_q4 / 16 + e / 2);
+    status.period_us = (uint32_t)period_q4 / 16U;
+
+    if (poll_align_abs(e) > period / (int32_t)POLL_ALIGN_LOCK_DIV) {
+        locked_polls = 0;
+        status.state = POLL_ALIGN_ACQUIRING;
+    } else if (locked_polls < POLL_ALIGN_LOCK_POLLS && ++locked_polls == POLL_ALIGN_LOCK_POLLS) {
+        status.state = POLL_ALIGN_LOCKED;
+    }
+}
+
+/**
+ * @brief Age of the sample the poll at t read: the newest published by then
+ */
+static void poll_align_age(uint32_t t)
+{
+    uint32_t n = (published_count < POLL_ALIGN_PUBLISHED) ? published_count : POLL_ALIGN_PUBLISHED;
+    int32_t age;
+
+    for (uint32_t i = 1; i <= n; i++) {
+        uint32_t slot = (published_count - i) % POLL_ALIGN_PUBLISHED;
+
+        if ((int32_t)(t - published_us[slot]) >= 0) {
+            age = (int32_t)(t - published_ts[slot]);
+            status.age_us = (status.age_us == 0U) ? (uint32_t)age
+                                                  : (uint32_t)((int32_t)status.age_us + (age - (int32_t)status.age_us) / 8);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Move the tick so that the cycle before the predicted poll ends
+ *        BOARD_POLL_ALIGN_MARGIN_US ahead of it
+ */
+static void poll_align_shift(void)
+{
+    uint32_t rate_hz = sensor_sampling_get_rate_hz();
+    int32_t tick;
+    int32_t multiple;
+    int32_t phase;
+
+    if (rate_hz == 0U) {
+        return;
+    }
+    tick = (int32_t)(1000000UL / rate_hz);
+
+    /* Master period a whole number of ticks, or the phase runs away */
+    multiple = ((int32_t)status.period_us + tick / 2) / tick;
+    if (multiple == 0 ||
+        poll_align_abs((int32_t)status.period_us - multiple * tick) > tick / (int32_t)POLL_ALIGN_MULTIPLE_DIV) {
+        return;
+    }
+
+    phase = (int32_t)(predicted_us - status.lead_us - BOARD_POLL_ALIGN_MARGIN_US - hal_tim2_get_next_tick_us()) % tick;
+    if (phase < 0) {
+        phase += tick;
+    }
+    if (phase > tick / 2) {
+        phase -= tick;
+    }
+    if (poll_align_abs(phase) < POLL_ALIGN_DEADBAND_US) {
+        return;
+    }
+    if (phase > tick / 8) {
+        phase = tick / 8;
+    } else if (phase < -tick / 8) {
+        phase = -tick / 8;
+    }
+    if (sensor_sampling_shift_tick_us(phase)) {
+        status.shifts++;
+    }
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+void poll_align_init(void)
+{
+    status = (poll_align_status_t){0};
+    seen_polls = i2c_slave_get_read_poll(NULL);
+    period_q4 = 0;
+    locked_polls = 0;
+    published_count = 0;
+}
+
+void poll_align_enable(bool on)
+{
+    status.enabled = on;
+}
+
+void poll_align_published(uint32_t timestamp_us)
+{
+    uint32_t now_us = hal_tim2_get_timestamp_us();
+    uint32_t lead = now_us - timestamp_us;
+    uint32_t slot = published_count % POLL_ALIGN_PUBLISHED;
+
+    published_us[slot] = now_us;
+    published_ts[slot] = timestamp_us;
+    published_count++;
+
+    /* A sample held back (output rate, burst) says nothing of the cycle */
+    if (lead > POLL_ALIGN_MAX_LEAD_US) {
+        return;
+    }
+    status.lead_us = (lead >= status.lead_us) ? lead : status.lead_us - (status.lead_us - lead) / 16U;
+}
+
+void poll_align_poll(void)
+{
+    uint32_t start_us;
+    uint32_t count = i2c_slave_get_read_poll(&start_us);
+    uint32_t missed = count - seen_polls;
+
+    if (missed == 0U) {
+        return;
+    }
+    seen_polls = count;
+
+    poll_align_age(start_us);
+    poll_align_track(start_us, missed);
+    if (status.enabled && status.state == POLL_ALIGN_LOCKED) {
+        poll_align_shift();
+    }
+}
+
+void poll_align_get_status(poll_align_status_t *status_out)
+{
+    if (status_out == NULL) {
+        return;
+    }
+
+    *status_out = status;
+}
+
+#endif /* BOARD_POLL_ALIGN_ENABLE */
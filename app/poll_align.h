@@ -0,0 +1,121 @@
+#ifndef POLL_ALIGN_H
+#define POLL_ALIGN_H
+
+/**
+ * @file poll_align.h
+ * @brief Sampling tick aligned to the master's polling period
+ *
+ * The master polls at its own period: a sample it reads is on average half
+ * a sample period old. The slave learns the period and phase of the polls
+ * from their address match times (i2c_slave_get_read_poll()) with a
+ * second-order loop, on each poll of time t predicted at p:
+ *   e = t - p,  period += e / 16,  p = p + period + e / 2
+ * and calls the estimate locked after POLL_ALIGN_LOCK_POLLS polls within
+ * POLL_ALIGN_LOCK_DIV of a period. A poll more than a quarter period off
+ * (the master stopped, changed its rate, or a poll was missed across a
+ * long gap) starts over. Polls the main loop did not see one by one are
+ * accounted for as whole periods.
+ *
+ * With the alignment on (HOST_CMD_POLL_ALIGN 1) and the estimate locked,
+ * each poll also places the next tick so that its cycle publishes the
+ * sample BOARD_POLL_ALIGN_MARGIN_US before the predicted read: the lead
+ * from a conversion start to its sample in the slave registers is taken
+ * from the samples published (decaying peak), and the tick is moved by
+ * sensor_sampling_shift_tick_us(), an eighth of a period at most per
+ * poll and not inside POLL_ALIGN_DEADBAND_US. No bus traffic is added.
+ * The tick is only moved in SENSOR_MODE_EXACT on the local tick (one
+ * cycle per tick), and only while the master period is within
+ * POLL_ALIGN_MULTIPLE_DIV of a tick period of a whole multiple of the
+ * tick period: otherwise the phase would run away faster than one trim
+ * per poll follows.
+ *
+ * The age of the sample at each poll (its conversion start to the poll)
+ * is averaged for the perf bank, aligned or not.
+ *
+ * Main loop only. Built only with BOARD_POLL_ALIGN_ENABLE.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+#define POLL_ALIGN_MIN_PERIOD_US   1000UL      /* Shorter intervals are not polls */
+#define POLL_ALIGN_MAX_PERIOD_US   10000000UL  /* 10 s */
+#define POLL_ALIGN_LOCK_POLLS      8U
+#define POLL_ALIGN_LOCK_DIV        16U         /* Lock tolerance, period / 16 */
+#define POLL_ALIGN_MULTIPLE_DIV    16U         /* Master period off a tick multiple, tick / 16 */
+#define POLL_ALIGN_DEADBAND_US     20          /* Smaller phase errors leave the tick alone */
+
+/**
+ * @brief Estimate state
+ */
+typedef enum {
+    POLL_ALIGN_NONE = 0,    /* No poll seen yet */
+    POLL_ALIGN_ACQUIRING,   /* Period measured, not yet stable */
+    POLL_ALIGN_LOCKED       /* Period and phase tracked */
+} poll_align_state_t;
+
+/**
+ * @brief Estimate and alignment (diagnostics)
+ */
+typedef struct {
+    poll_align_state_t state;
+    bool enabled;          /* Tick alignment on (HOST_CMD_POLL_ALIGN) */
+    uint32_t period_us;    /* Master poll period, 0 = not measured */
+    int32_t error_us;      /* Prediction error at the last poll */
+    uint32_t age_us;       /* Sample age at the master's polls, averaged */
+    uint32_t lead_us;      /* Conversion start to publication, decaying peak */
+    uint32_t shifts;       /* Tick phase moves since boot */
+} poll_align_status_t;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Start with no estimate and the alignment off
+ */
+void poll_align_init(void);
+
+/**
+ * @brief Turn the tick alignment on or off
+ *
+ * Off, the period and age are still measured; the tick keeps the phase
+ * it was moved to.
+ *
+ * @param on true to align the tick to the polls
+ */
+void poll_align_enable(bool on);
+
+/**
+ * @brief Note a sample put in the slave registers
+ *
+ * @param timestamp_us Its conversion start (sensor_data_t.timestamp_us)
+ */
+void poll_align_published(uint32_t timestamp_us);
+
+/**
+ * @brief Take the polls since the last call, and move the tick if due
+ */
+void poll_align_poll(void);
+
+/**
+ * @brief Read the estimate
+ *
+ * @param status Filled with the current state
+ */
+void poll_align_get_status(poll_align_status_t *status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* POLL_ALIGN_H */
@@ -0,0 +1,108 @@
+/**
+ * @file sample_bus.c
+ * @brief Publish/subscribe fan-out of sample blocks implementation
+ *
+ * Reference counts change under PRIMASK, so a subscriber may release from
+ * an interrupt handler (a transfer-complete callback, say).
+ */
+
+#include "sample_bus.h"
+
+#include <stddef.h>
+#include "hal_atomic.h"
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+POOL_STORAGE(block_storage, sizeof(sample_bus_block_t), SAMPLE_BUS_BLOCKS);
+static pool_t block_pool;
+static sample_bus_callback_t subscribers[SAMPLE_BUS_SUBSCRIBERS];
+static uint32_t subscriber_count = 0;
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+bool sample_bus_init(void)
+{
+    subscriber_count = 0;
+    return pool_init(&block_pool, block_storage, sizeof(sample_bus_block_t), SAMPLE_BUS_BLOCKS);
+}
+
+bool sample_bus_subscribe(sample_bus_callback_t callback)
+{
+    if (callback == NULL || subscriber_count >= SAMPLE_BUS_SUBSCRIBERS) {
+        return false;
+    }
+    
+    subscribers[subscriber_count++] = callback;
+    return true;
+}
+
+sample_bus_block_t *sample_bus_acquire(void)
+{
+    sample_bus_block_t *block = (sample_bus_block_t *)pool_alloc(&block_pool);
+    
+    if (block != NULL) {
+        block->count = 0;
+        block->refs = 1;
+    }
+    return block;
+}
+
+void sample_bus_publish(sample_bus_block_t *block)
+{
+    if (block == NULL) {
+        return;
+    }
+    
+    if (block->count > 0U) {
+        for (uint32_t i = 0; i < subscriber_count; i++) {
+            subscribers[i](block);
+        }
+    }
+    sample_bus_release(block);
+}
+
+void sample_bus_retain(const sample_bus_block_t *block)
+{
+    sample_bus_block_t *b = (sample_bus_block_t *)block;
+    uint32_t primask;
+    
+    if (b == NULL) {
+        return;
+    }
+    
+    primask = hal_crit_enter();
+    b->refs++;
+    hal_crit_exit(primask);
+}
+
+void sample_bus_release(const sample_bus_block_t *block)
+{
+    sample_bus_block_t *b = (sample_bus_block_t *)block;
+    uint32_t primask;
+    bool last;
+    
+    if (b == NULL) {
+        return;
+    }
+    
+    /* A block already back in the pool has no reference left to drop */
+    primask = hal_crit_enter();
+    last = (b->refs == 1U);
+    if (b->refs > 0U) {
+        b->refs--;
+    }
+    hal_crit_exit(primask);
+    
+    if (last) {
+        (void)pool_free(&block_pool, b);
+    }
+}
+
+bool sample_bus_get_stats(pool_stats_t *stats)
+{
+    return pool_get_stats(&block_pool, stats);
+}
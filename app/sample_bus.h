@@ -0,0 +1,111 @@
+#ifndef SAMPLE_BUS_H
+#define SAMPLE_BUS_H
+
+/**
+ * @file sample_bus.h
+ * @brief Publish/subscribe fan-out of sample blocks, zero-copy
+ *
+ * The main loop drains the sampler ring into a block taken from a fixed
+ * pool (pool.h) and publishes it: every subscriber (burst FIFO, USB stream,
+ * SD and flash logs, EEPROM statistics, event detectors) is handed the same
+ * block in subscription order, by pointer. A subscriber that needs the
+ * samples after its callback returns takes a reference and releases it when
+ * done; the block goes back to the pool with its last reference. Adding a
+ * subscriber costs no copy, and memory stays bounded by SAMPLE_BUS_BLOCKS:
+ * with every block held, samples wait in the sampler ring instead.
+ *
+ * Publish and subscribe: main loop only. Retain and release: any context.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sensor_sampling.h"  /* For sensor_data_t type */
+#include "pool.h"             /* For pool_stats_t type */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+#define SAMPLE_BUS_BLOCK_SAMPLES  8U  /* Samples drained from the sampler ring per block */
+#define SAMPLE_BUS_BLOCKS         2U  /* One being published, one held by a subscriber */
+#define SAMPLE_BUS_SUBSCRIBERS    8U
+
+/**
+ * @brief Block of consecutive samples
+ */
+typedef struct {
+    uint32_t count;  /* Samples in the block, oldest first */
+    sensor_data_t samples[SAMPLE_BUS_BLOCK_SAMPLES];
+    uint32_t refs;   /* Private: references held */
+} sample_bus_block_t;
+
+/**
+ * @brief Subscriber callback
+ *
+ * The block is valid until the callback returns, or until
+ * sample_bus_release() after a sample_bus_retain() in it.
+ */
+typedef void (*sample_bus_callback_t)(const sample_bus_block_t *block);
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Set up the block pool, with no subscriber
+ *
+ * @return true if successful
+ */
+bool sample_bus_init(void);
+
+/**
+ * @brief Add a subscriber; it is called after the ones added before it
+ *
+ * @param callback Subscriber
+ * @return true if added, false if NULL or the table is full
+ */
+bool sample_bus_subscribe(sample_bus_callback_t callback);
+
+/**
+ * @brief Take an empty block to fill (count 0, one reference)
+ *
+ * @return Block, or NULL while subscribers hold every block
+ */
+sample_bus_block_t *sample_bus_acquire(void);
+
+/**
+ * @brief Hand a filled block to every subscriber, then drop the
+ *        publisher's reference
+ *
+ * A block with no samples goes straight back to the pool.
+ *
+ * @param block Block from sample_bus_acquire()
+ */
+void sample_bus_publish(sample_bus_block_t *block);
+
+/**
+ * @brief Keep a published block past the subscriber callback
+ */
+void sample_bus_retain(const sample_bus_block_t *block);
+
+/**
+ * @brief Drop a reference; the last one returns the block to the pool
+ */
+void sample_bus_release(const sample_bus_block_t *block);
+
+/**
+ * @brief Block pool statistics (high water, failed acquires)
+ *
+ * @return true if successful
+ */
+bool sample_bus_get_stats(pool_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SAMPLE_BUS_H */
@@ -0,0 +1,187 @@
+/**
+ * @file sample_stats.c
+ * @brief Windowed min, max, mean and variance of the published samples
+ *
+ * The bottom half fills the current window and, once it holds the window
+ * length, copies it to the completed one under a sequence count (odd while
+ * it is written), as sensor_sampling_get_data() does for the latest sample.
+ * A window length set from the main loop is only a request: the bottom half
+ * picks it up at the next sample and starts a new window, so the two sides
+ * never write the same state.
+ *
+ * Per channel, with d = x - origin (origin = first sample of the window):
+ *   S = sum(d), Q = sum(d^2), m = S / n truncated, r = S - n m
+ *   sum((d - m)^2)  = Q - m (2 S - n m)       exact in integers
+ *   sum((x - mean)^2) = sum((d - m)^2) - r^2 / n
+ */
+
+#include "sample_stats.h"
+
+#include "hal_atomic.h"     /* For hal_seq_*() */
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+/* One channel of a window in progress */
+typedef struct {
+    int32_t origin;
+    int32_t min;
+    int32_t max;
+    int64_t sum;      /* Of x - origin */
+    uint64_t sum_sq;  /* Of (x - origin)^2 */
+} sample_stats_acc_t;
+
+typedef struct {
+    uint32_t count;
+    uint32_t end_timestamp_us;
+    sample_stats_acc_t pressure;
+    sample_stats_acc_t temperature;
+} sample_stats_window_t;
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static volatile uint32_t window_request = 0;  /* Written by the main loop */
+static uint32_t window_length = 0;            /* Bottom half: length of current */
+static sample_stats_window_t current;         /* Bottom half only */
+
+static sample_stats_window_t completed;       /* Last full window, under completed_seq */
+static volatile uint32_t completed_seq = 0;   /* Odd while completed is written */
+static uint32_t taken_seq = 0;                /* Main loop: completed_seq last taken */
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static void sample_stats_acc_add(sample_stats_acc_t *acc, int32_t x, bool first)
+{
+    int32_t d;
+    
+    if (first) {
+        acc->origin = x;
+        acc->min = x;
+        acc->max = x;
+        acc->sum = 0;
+        acc->sum_sq = 0;
+        return;
+    }
+    
+    if (x < acc->min) {
+        acc->min = x;
+    } else if (x > acc->max) {
+        acc->max = x;
+    }
+    d = x - acc->origin;
+    acc->sum += d;
+    acc->sum_sq += (uint64_t)((int64_t)d * d);
+}
+
+/**
+ * @brief Mean and variance of one channel (main loop: 64-bit divisions)
+ */
+static void sample_stats_channel(const sample_stats_acc_t *acc, uint32_t n,
+                                 sample_stats_channel_t *out)
+{
+    int64_t count = (int64_t)n;
+    int64_t m = acc->sum / count;
+    int64_t r = acc->sum - m * count;
+    uint64_t dev = acc->sum_sq - (uint64_t)(m * (2 * acc->sum - m * count));
+    uint64_t variance;
+    
+    dev -= (uint64_t)((r * r) / count);
+    variance = dev / n;
+    
+    /* Nearest: m is truncated towards zero, r has the sign of the sum */
+    if (2 * r >= count) {
+        m++;
+    } else if (-2 * r >= count) {
+        m--;
+    }
+    
+    out->min = acc->min;
+    out->max = acc->max;
+    out->mean = (int32_t)(acc->origin + m);
+    out->variance = (variance > UINT32_MAX) ? UINT32_MAX : (uint32_t)variance;
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+void sample_stats_init(uint32_t window)
+{
+    window_request = (window <= SAMPLE_STATS_WINDOW_MAX) ? window : 0U;
+    window_length = window_request;
+    current.count = 0;
+    completed_seq = 0;
+    taken_seq = 0;
+}
+
+bool sample_stats_set_window(uint32_t window)
+{
+    if (window > SAMPLE_STATS_WINDOW_MAX) {
+        return false;
+    }
+    
+    window_request = window;
+    return true;
+}
+
+uint32_t sample_stats_get_window(void)
+{
+    return window_request;
+}
+
+void sample_stats_add(const sensor_data_t *sample)
+{
+    uint32_t request = window_request;
+    bool first;
+    
+    if (request != window_length) {
+        window_length = request;
+        current.count = 0;
+    }
+    if (window_length == 0U) {
+        return;
+    }
+    
+    first = (current.count == 0U);
+    sample_stats_acc_add(&current.pressure, sample->pressure, first);
+    sample_stats_acc_add(&current.temperature, sample->temperature, first);
+    current.end_timestamp_us = sample->timestamp_us;
+    
+    if (++current.count < window_length) {
+        return;
+    }
+    
+    hal_seq_write_begin(&completed_seq);
+    completed = current;
+    hal_seq_write_end(&completed_seq);
+    current.count = 0;
+}
+
+bool sample_stats_get(sample_stats_t *stats)
+{
+    sample_stats_window_t window;
+    uint32_t seq;
+    
+    /* The bottom half may complete another window meanwhile: retry */
+    do {
+        seq = hal_seq_read_begin(&completed_seq);
+        window = completed;
+    } while (hal_seq_read_retry(&completed_seq, seq));
+    
+    if (seq == taken_seq) {
+        return false;
+    }
+    taken_seq = seq;
+    
+    stats->windows = seq / 2U;
+    stats->count = window.count;
+    stats->end_timestamp_us = window.end_timestamp_us;
+    sample_stats_channel(&window.pressure, window.count, &stats->pressure);
+    sample_stats_channel(&window.temperature, window.count, &stats->temperature);
+    return true;
+}
@@ -0,0 +1,107 @@
+#ifndef SAMPLE_STATS_H
+#define SAMPLE_STATS_H
+
+/**
+ * @file sample_stats.h
+ * @brief Windowed min, max, mean and variance of the published samples
+ *
+ * Every published sample (after the filter stage) is added in the bottom
+ * half, per channel: min and max, and the sum and sum of squares of its
+ * offset from the first sample of the window. Shifted sums stay exact in
+ * 64-bit integers (no cancellation as with raw sums of squares) and cost
+ * an add and a multiply per sample, with no division: the Cortex-M0+ has
+ * no divider, so the mean and variance are worked out in the main loop,
+ * once per window, by sample_stats_get().
+ *
+ * Windows are back to back, sample_stats_set_window() samples each (up to
+ * 65535, which with the sensor's full-scale range keeps the sums inside 64
+ * bits). Single-sensor builds only.
+ *
+ * Producer: bottom half (sample_stats_add()). Consumer: main loop.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sensor_sampling.h"  /* For sensor_data_t type */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+#define SAMPLE_STATS_WINDOW_MAX  65535U
+
+/**
+ * @brief Statistics of one channel over a window
+ */
+typedef struct {
+    int32_t min;
+    int32_t max;
+    int32_t mean;        /* Rounded to the nearest unit */
+    uint32_t variance;   /* Population variance, units squared (saturated) */
+} sample_stats_channel_t;
+
+/**
+ * @brief Statistics of the last completed window
+ */
+typedef struct {
+    uint32_t windows;           /* Windows completed since sample_stats_init() */
+    uint32_t count;             /* Samples in the window */
+    uint32_t end_timestamp_us;  /* Timestamp of its last sample */
+    sample_stats_channel_t pressure;     /* 0.01 mbar */
+    sample_stats_channel_t temperature;  /* 0.01 degC */
+} sample_stats_t;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Start over with no window completed
+ *
+ * @param window Samples per window (0 = off)
+ */
+void sample_stats_init(uint32_t window);
+
+/**
+ * @brief Set the window length
+ *
+ * The window in progress is dropped; the next one starts with the next
+ * sample.
+ *
+ * @param window Samples per window (1..SAMPLE_STATS_WINDOW_MAX, 0 = off)
+ * @return true if set, false if out of range
+ */
+bool sample_stats_set_window(uint32_t window);
+
+/**
+ * @brief Current window length
+ *
+ * @return Samples per window (0 = off)
+ */
+uint32_t sample_stats_get_window(void);
+
+/**
+ * @brief Add a published sample (bottom half only)
+ *
+ * @param sample Sample as published
+ */
+void sample_stats_add(const sensor_data_t *sample);
+
+/**
+ * @brief Take the statistics of a newly completed window
+ *
+ * @param stats Filled with the last completed window
+ * @return true if a window completed since the last call, false otherwise
+ *         (stats untouched)
+ */
+bool sample_stats_get(sample_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SAMPLE_STATS_H */
@@ -0,0 +1,273 @@
+/**
+ * @file self_test.c
+ * @brief Boot self-test implementation
+ *
+ * Runs on the blocking transport, like the bus tuning, before the sampling
+ * tick and the async transfers start. A PROM read is the only transaction
+ * that changes nothing in the sensor, so it serves both as the presence
+ * check and as the timed transaction. Times come from the microsecond
+ * timebase; the kernel batches are long enough for its resolution, and
+ * the shortest batch leaves out any interrupt that landed in the others.
+ */
+
+#include "self_test.h"
+
+#if BOARD_SELF_TEST_ENABLE
+
+#include <string.h>
+#include "stm32l0xx_hal.h"
+#include "hal_config.h"
+#include "ms58.h"
+#include "ms58_hal_wrapper.h"
+#include "conv_sensor.h"
+#include "timebase.h"
+#include "bus_tune.h"
+#include "warm_restart.h"
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define SELF_TEST_PROM_WORDS     7U
+#define SELF_TEST_BATCHES        4U
+
+/* Datasheet example conversion (MS5837-30BA): mid-range inputs */
+#define SELF_TEST_D1             4311550UL
+#define SELF_TEST_D2             8077636UL
+
+#if BOARD_I2C3_MUX_CHANNELS != 0
+#define SELF_TEST_BUSES          2U
+#else
+#define SELF_TEST_BUSES          1U
+#endif
+
+/**
+ * @brief One sensor bus
+ */
+typedef struct {
+    I2C_HandleTypeDef *hi2c;
+    uint8_t sensor_addr;
+    uint8_t mux_addr;
+    uint8_t channels;                          /* Populated mux channels, 0: no mux */
+    hal_i2c_speed_t (*get_speed)(void);
+} self_test_bus_t;
+
+/**
+ * @brief Report kept for a warm boot
+ */
+typedef struct {
+    self_test_report_t report;
+    uint32_t check;                            /* Over the report bytes */
+} self_test_warm_t;
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static const self_test_bus_t buses[SELF_TEST_BUSES] = {
+    { &hi2c2, BOARD_I2C2_SENSOR_ADDR, BOARD_I2C2_MUX_ADDR, BOARD_SENSOR_MUX_CHANNELS,
+      hal_i2c2_get_speed },
+#if SELF_TEST_BUSES > 1U
+    { &hi2c3, BOARD_I2C3_SENSOR_ADDR, BOARD_I2C3_MUX_ADDR, BOARD_I2C3_MUX_CHANNELS,
+      hal_i2c3_get_speed },
+#endif
+};
+
+static self_test_report_t report;
+
+#if BOARD_WARM_RESTART_ENABLE
+static self_test_warm_t self_test_warm NOINIT;
+#endif
+
+/* Kernel outputs, kept so the timed calls are not optimized away */
+static volatile int32_t kernel_sink;
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+#if BOARD_WARM_RESTART_ENABLE
+static uint32_t self_test_warm_check(const self_test_warm_t *warm)
+{
+    const uint8_t *byte = (const uint8_t *)&warm->report;
+    uint32_t check = 0;
+
+    for (uint32_t i = 0; i < sizeof(warm->report); i++) {
+        check = ((check << 5) | (check >> 27)) ^ byte[i];
+    }
+    return ~check;
+}
+#endif
+
+/**
+ * @brief BOARD_SELF_TEST_ROUNDS PROM reads from the selected probe
+ *
+ * @param calib Receives the coefficients on a good PROM
+ * @param elapsed_us Receives the time of the acknowledged reads
+ * @param reads Receives the number of acknowledged reads
+ * @return true if every read held a good CRC-4
+ */
+static bool self_test_probe(const ms583730ba01_h *handle, ms5837_calib_t *calib,
+                            uint32_t *elapsed_us, uint32_t *reads)
+{
+    uint16_t words[SELF_TEST_PROM_WORDS];
+    bool good = true;
+
+    *elapsed_us = 0;
+    *reads = 0;
+    for (uint32_t round = 0; round < BOARD_SELF_TEST_ROUNDS; round++) {
+        uint32_t start_us = timebase_now_us();
+        ms583730ba01_err_t result = ms5837_read_prom(handle, words);
+        uint32_t span_us = timebase_now_us() - start_us;
+
+        if (result != E_MS58370BA01_SUCCESS && result != E_MS58370BA01_CRC_ERR) {
+            return false;  /* Not acknowledged: the reads so far still count */
+        }
+        *elapsed_us += span_us;
+        (*reads)++;
+        good = good && result == E_MS58370BA01_SUCCESS;
+    }
+    return good && ms5837_calib_prepare(words, calib) == E_MS58370BA01_SUCCESS;
+}
+
+/**
+ * @brief Probe every position of one bus
+ *
+ * @param calib Receives the coefficients of the first good probe
+ * @param have_calib true once a good probe has filled calib
+ */
+static void self_test_bus(uint32_t index, ms5837_calib_t *calib, bool *have_calib)
+{
+    const self_test_bus_t *bus = &buses[index];
+    ms58_hal_dev_t dev;
+    ms583730ba01_h handle = ms58_get_hal_handle(&dev, bus->hi2c, bus->sensor_addr);
+    uint8_t positions = (bus->channels != 0U) ? bus->channels : 0x01U;
+    uint32_t total_us = 0;
+    uint32_t total_reads = 0;
+
+    if (handle.write_cmd == NULL) {
+        return;
+    }
+
+    for (uint32_t ch = 0; ch < 8U; ch++) {
+        ms5837_calib_t probe_calib;
+        uint32_t elapsed_us;
+        uint32_t reads;
+        bool good;
+
+        if ((positions & (1U << ch)) == 0U) {
+            continue;
+        }
+        if (bus->channels != 0U &&
+            ms58_hal_mux_select(bus->hi2c, bus->mux_addr, (uint8_t)(1U << ch)) !=
+                E_MS58370BA01_SUCCESS) {
+            continue;
+        }
+
+        good = self_test_probe(&handle, &probe_calib, &elapsed_us, &reads);
+        if (reads != 0U) {
+            report.present |= (uint16_t)(1U << (ch + 8U * index));
+            total_us += elapsed_us;
+            total_reads += reads;
+        }
+        if (good) {
+            report.prom_ok |= (uint16_t)(1U << (ch + 8U * index));
+            if (!*have_calib) {
+                *calib = probe_calib;
+                *have_calib = true;
+            }
+        }
+    }
+    if (bus->channels != 0U) {
+        (void)ms58_hal_mux_select(bus->hi2c, bus->mux_addr, 0);
+    }
+
+    if (total_reads != 0U) {
+        uint32_t word_us = total_us / (total_reads * SELF_TEST_PROM_WORDS);
+
+        report.word_us[index] = (word_us > UINT16_MAX) ? UINT16_MAX : (uint16_t)word_us;
+    }
+}
+
+/**
+ * @brief Time the compensation kernel, best of SELF_TEST_BATCHES
+ *
+ * @return ns per call
+ */
+static uint16_t self_test_kernel(ms5837_calib_t *calib)
+{
+    uint32_t best_us = UINT32_MAX;
+    uint32_t ns;
+
+    ms5837_calib_set_second_order(calib, true);
+    for (uint32_t batch = 0; batch < SELF_TEST_BATCHES; batch++) {
+        uint32_t start_us = timebase_now_us();
+        uint32_t span_us;
+
+        for (uint32_t i = 0; i < BOARD_SELF_TEST_KERNEL_RUNS; i++) {
+            int32_t pressure;
+            int32_t temperature;
+
+            ms5837_compensate(calib, SELF_TEST_D1 + i, SELF_TEST_D2, &pressure, &temperature);
+            kernel_sink = pressure ^ temperature;
+        }
+        span_us = timebase_now_us() - start_us;
+        if (span_us < best_us) {
+            best_us = span_us;
+        }
+    }
+
+    ns = (uint32_t)((uint64_t)best_us * 1000U / BOARD_SELF_TEST_KERNEL_RUNS);
+    return (ns > UINT16_MAX) ? UINT16_MAX : (ns == 0U) ? 1U : (uint16_t)ns;
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+void self_test_init(void)
+{
+    uint16_t configured = (uint16_t)((BOARD_SENSOR_MUX_CHANNELS != 0) ?
+                                     (BOARD_SENSOR_MUX_CHANNELS | (BOARD_I2C3_MUX_CHANNELS << 8)) :
+                                     0x01U);
+    ms5837_calib_t calib;
+    bool have_calib = false;
+
+#if BOARD_WARM_RESTART_ENABLE
+    if (warm_restart_is_warm() && self_test_warm.check == self_test_warm_check(&self_test_warm)) {
+        report = self_test_warm.report;
+        report.flags |= SELF_TEST_KEPT;
+        return;
+    }
+#endif
+
+    memset(&report, 0, sizeof(report));
+    for (uint32_t i = 0; i < SELF_TEST_BUSES; i++) {
+#if BOARD_I2C_TUNE_ENABLE
+        report.speed[i] = bus_tune_get_report((bus_tune_bus_t)i);
+#else
+        report.speed[i] = (uint8_t)buses[i].get_speed();
+#endif
+        self_test_bus(i, &calib, &have_calib);
+    }
+    if (have_calib) {
+        report.compensate_ns = self_test_kernel(&calib);
+    }
+    report.osr_levels = ms5837_conv_sensor.osr_count;
+    report.flags = SELF_TEST_RAN;
+    if ((report.prom_ok & configured) == configured) {
+        report.flags |= SELF_TEST_ALL_OK;
+    }
+
+#if BOARD_WARM_RESTART_ENABLE
+    self_test_warm.report = report;
+    self_test_warm.check = self_test_warm_check(&self_test_warm);
+#endif
+}
+
+const self_test_report_t *self_test_get_report(void)
+{
+    return &report;
+}
+
+#endif /* BOARD_SELF_TEST_ENABLE */
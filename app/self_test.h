@@ -0,0 +1,86 @@
+#ifndef SELF_TEST_H
+#define SELF_TEST_H
+
+/**
+ * @file self_test.h
+ * @brief Boot self-test and capability report
+ *
+ * Boards differ in which probes answer, which bus speeds hold and what the
+ * compensation costs, and finding out by trial over the slave bus is slow.
+ * At boot, after the bus tuning (bus_tune.h) and before the sensors are
+ * brought up, each sensor bus is probed once:
+ *   - every probe position (each configured mux channel, or the single
+ *     sensor) gets BOARD_SELF_TEST_ROUNDS PROM reads: a probe answers if
+ *     the reads are acknowledged, and has a good PROM if their CRC-4 holds
+ *   - the reads are timed, giving the cost of one PROM word transaction
+ *     (command, repeated START, two bytes) at the speed in effect
+ *   - the compensation kernel (ms5837_compensate(), second order on) is
+ *     timed over BOARD_SELF_TEST_KERNEL_RUNS calls with the coefficients
+ *     of the first good probe, best of four batches
+ * The report is appended to the performance bank (perf_bank.h version 4),
+ * so the master has it in the same read as the rates it is tuning. A warm
+ * boot (warm_restart.h) keeps the report of the previous one without a
+ * new probe: the sensor may still be converting.
+ *
+ * Built only with BOARD_SELF_TEST_ENABLE; the bank fields read 0
+ * otherwise.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+/* self_test_report_t flags */
+#define SELF_TEST_RAN       0x01U  /* Probed at this boot or the cold boot before */
+#define SELF_TEST_KEPT      0x02U  /* Warm boot: report of the previous boot */
+#define SELF_TEST_ALL_OK    0x04U  /* Every configured probe gave a good PROM */
+
+/**
+ * @brief Capability report
+ *
+ * Probe masks: bits 7:0 I2C2 mux channels (bit 0 alone for a single
+ * sensor), bits 15:8 I2C3 mux channels.
+ */
+typedef struct {
+    uint16_t present;        /* Probes that acknowledged */
+    uint16_t prom_ok;        /* Probes with a good PROM CRC-4 */
+    uint8_t speed[2];        /* I2C2, I2C3: hal_i2c_speed_t at boot (bus_tune.h report layout) */
+    uint16_t word_us[2];     /* I2C2, I2C3: one PROM word transaction, us (0: no probe) */
+    uint16_t compensate_ns;  /* One compensation, ns (0: no good PROM) */
+    uint8_t osr_levels;      /* Oversampling levels of the sensor (sensor_osr_t) */
+    uint8_t flags;           /* SELF_TEST_* */
+} self_test_report_t;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Run the self-test (blocking)
+ *
+ * Call once, after bus_tune_init() and before anything talks to the
+ * sensors; leaves the muxes with no channel selected. Some 1 ms per probe
+ * and round at fast mode.
+ */
+void self_test_init(void);
+
+/**
+ * @brief Get the capability report
+ *
+ * @return Report (all zeros before self_test_init())
+ */
+const self_test_report_t *self_test_get_report(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SELF_TEST_H */
@@ -0,0 +1,647 @@
+/**
+ * @file sensor_array.c
+ * @brief Multi-probe MS5837 sampling through the TCA9548 I2C mux
+ *
+ * Each TIM2 tick starts one scan over the populated mux channels. Per
+ * channel the scan queues one chain of transfers on the bus
+ * (ms58_hal_submit()), run back to back by the bus interrupt:
+ * Select mux channel → Read ADC of the conversion started last scan
+ * → Start the next conversion (D1 and D2 alternate)
+ * with a single completion at its end. Two channel chains are queued at a
+ * time, so the bus goes straight on to the next channel while the
+ * completion of the last one is handled.
+ *
+ * Timeline with 3 probes (A, B, C), one tick per scan:
+ * Tick	Bus activity
+ * 1	A: start D1	B: start D1	C: start D1
+ * 2	A: read D1, start D2	B: read D1, start D2	C: read D1, start D2
+ * 3	A: read D2, calc, start D1	B: ...	C: ...
+ * While A is being read, B and C are converting, so conversions overlap
+ * and the scan length is set by bus time only. A probe is read one tick
+ * after its conversion started, minus its own slot on the bus, so it waits
+ * at least ~1ms even at 100kHz (OSR=256 needs 0.56ms).
+ *
+ * Probes alternate in phase by their rank in the scan: the even ones
+ * start D1 on even scans, the odd ones on odd scans, so half the pairs
+ * complete on each scan instead of all of them on every other one. A
+ * probe with no conversion running (at start, after a failure) waits for
+ * its phase with a D2 whose result is dropped.
+ *
+ * A probe that fails a transfer loses the rest of its chain and restarts with a fresh conversion on the next one, so one bad probe does
+ * not stall the others. If a scan overruns the tick, the next scan starts
+ * on the first tick after it finished.
+ *
+ * The mux channel last selected is cached per bus, and a chain for the
+ * channel already selected starts with the ADC read: within a scan
+ * every chain changes channel, but a bus left with one probe (the others
+ * failed bring-up) sends no select at all. The cache is set when a chain
+ * is queued, since the chains run in queue order, and dropped on any
+ * failed chain, after which the mux state is unknown. A chain queued
+ * behind a failing one is always for another channel and selects anyway.
+ *
+ * Bring-up reuses the queue: one chain per probe reads its PROM (select,
+ * seven word reads), and its completion checks the CRC-4, prepares the
+ * coefficients and queues the next probe's chain, so the bus never waits
+ * for the CPU. The resets before it are sent back to back and waited out
+ * once.
+ *
+ * Each bus (I2C2, and I2C3 with BOARD_I2C3_MUX_CHANNELS) has a scan of its
+ * own, driven by its own completions. The transport callbacks carry no
+ * context, so every bus has a small completion thunk naming its state.
+ */
+
+#include "sensor_array.h"
+#include "ms58.h"
+#include "ms58_regs.h"
+#include "ms58_hal_wrapper.h"
+#include "hal_config.h"
+#include "timebase.h"
+#include "board_config.h"
+#if BOARD_RAM_VECTORS_ENABLE
+#include "main.h"
+#endif
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+/* Conversion commands of the sampling profile OSRs (commands step by 2) */
+#define SENSOR_ARRAY_OSR_D1         (MS5837_CONVERT_D1_256 + 2 * BOARD_SAMPLING_P_OSR)
+#define SENSOR_ARRAY_OSR_D2         (MS5837_CONVERT_D2_256 + 2 * BOARD_SAMPLING_T_OSR)
+
+/* Ticks between scan starts */
+#define SENSOR_ARRAY_SCAN_TICKS     1
+
+/* A conversion started on one scan is read on the next: the longer of
+ * the two must end within a scan period */
+#define SENSOR_ARRAY_SCAN_US        (1000000UL * SENSOR_ARRAY_SCAN_TICKS / BOARD_TIM2_FREQ_HZ)
+#if BOARD_SENSOR_MUX_CHANNELS != 0 && \
+    (MS5837_CONV_TIME_US(BOARD_SAMPLING_P_OSR) > SENSOR_ARRAY_SCAN_US || \
+     MS5837_CONV_TIME_US(BOARD_SAMPLING_T_OSR) > SENSOR_ARRAY_SCAN_US)
+#error "Sampling profile: the probe conversions at these OSRs outlast a scan"
+#endif
+
+#define SENSOR_ARRAY_NO_CHANNEL     SENSOR_ARRAY_MAX_CHANNELS
+
+/* Channel chains queued per bus at a time (select, ADC read, convert) */
+#define SENSOR_ARRAY_CHAINS         2U
+#define SENSOR_ARRAY_CHAIN_XFERS    3U
+
+#if SENSOR_ARRAY_CHAINS * SENSOR_ARRAY_CHAIN_XFERS > MS58_HAL_QUEUE_DEPTH
+#error "SENSOR_ARRAY_CHAINS channel chains must fit the bus queue"
+#endif
+
+/* Bring-up chain: select, then the PROM words one read each */
+#define SENSOR_ARRAY_PROM_WORDS     7U
+#define SENSOR_ARRAY_PROM_XFERS     (1U + SENSOR_ARRAY_PROM_WORDS)
+
+#if SENSOR_ARRAY_PROM_XFERS > MS58_HAL_QUEUE_DEPTH
+#error "A PROM chain must fit the bus queue"
+#endif
+
+/* Far past 8 PROM chains at 100 kHz (~1 ms each) */
+#define SENSOR_ARRAY_BRINGUP_TIMEOUT_US  50000UL
+
+#if BOARD_I2C3_MUX_CHANNELS != 0
+#define SENSOR_ARRAY_BUSES          2
+#else
+#define SENSOR_ARRAY_BUSES          1
+#endif
+
+/**
+ * @brief Per-probe state
+ */
+typedef struct {
+    ms5837_calib_t calibration;
+    uint32_t pressure_adc;
+    uint32_t temperature_adc;
+    bool converting;           /* A conversion was started on the last scan */
+    bool converting_pressure;  /* That conversion is D1 (else D2) */
+    bool starting_pressure;    /* Conversion of the queued chain is D1 */
+    bool reading;              /* The queued chain reads the ADC */
+    bool have_pressure;        /* pressure_adc holds a result for this pair */
+    bool odd_phase;            /* Starts D1 on odd scans */
+    uint8_t error_count;       /* Failed transfers (saturating) */
+    uint8_t errors_published;  /* error_count at the last sample */
+    uint32_t pressure_timestamp_us;  /* Start of the D1 conversion of this pair */
+    uint32_t sequence;         /* Next sample sequence number */
+    sensor_data_t data;
+    uint8_t adc_bytes[MS5837_ADC_BYTES];
+} sensor_probe_t;
+
+/**
+ * @brief Per-bus scan state
+ */
+typedef struct {
+    I2C_HandleTypeDef *hi2c;
+    IRQn_Type irqn;                   /* Its interrupt line */
+    uint8_t sensor_addr;
+    uint8_t mux_addr;
+    uint8_t first;                    /* First channel of the bus */
+    ms58_hal_dev_t dev;               /* Handle context: bus, sensor address */
+    ms583730ba01_h handle;
+    volatile bool scan_active;
+    uint32_t ticks_since_scan;
+    uint8_t scan_channel;             /* Chain that completes next */
+    uint8_t queued_channel;           /* Chain queued behind it */
+    uint8_t next_channel;             /* First channel not queued yet */
+    uint8_t chains;                   /* Chains queued (0..SENSOR_ARRAY_CHAINS) */
+    uint8_t selected;                 /* Mux channel once the queued chains ran, or NO_CHANNEL */
+    bool odd_scan;                    /* Scan number of the one in flight is odd */
+    uint16_t bringup_mask;            /* Probes reset, PROM chain not queued yet */
+    volatile uint16_t bringup_ok;     /* Probes with a good PROM */
+    volatile bool bringup_active;     /* PROM chains still to complete */
+    uint8_t prom_channel;             /* Channel of the PROM chain in flight */
+    uint8_t prom_bytes[2U * SENSOR_ARRAY_PROM_WORDS];
+} array_bus_t;
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static array_bus_t buses[SENSOR_ARRAY_BUSES] = {
+    { .hi2c = &hi2c2, .irqn = I2C2_IRQn, .sensor_addr = BOARD_I2C2_SENSOR_ADDR, .mux_addr = BOARD_I2C2_MUX_ADDR,
+      .first = 0 },
+#if SENSOR_ARRAY_BUSES > 1
+    { .hi2c = &hi2c3, .irqn = I2C3_IRQn, .sensor_addr = BOARD_I2C3_SENSOR_ADDR, .mux_addr = BOARD_I2C3_MUX_ADDR,
+      .first = SENSOR_ARRAY_BUS_CHANNELS },
+#endif
+};
+static sensor_probe_t probes[SENSOR_ARRAY_MAX_CHANNELS];
+
+static void array_on_transfer_done(void *ctx, ms583730ba01_err_t result);
+static void array_on_prom_done(void *ctx, ms583730ba01_err_t result);
+static uint16_t active_mask = 0;
+static volatile bool running = false;
+static volatile sensor_sampling_event_cb_t event_callback = NULL;
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Find the next active channel of a bus
+ *
+ * @param bus Bus to search
+ * @param from First channel to consider
+ * @return Channel number, or SENSOR_ARRAY_NO_CHANNEL if none is left
+ */
+static uint8_t array_next_channel(const array_bus_t *bus, uint8_t from)
+{
+    for (uint8_t ch = from; ch < bus->first + SENSOR_ARRAY_BUS_CHANNELS; ch++) {
+        if (active_mask & (1U << ch)) {
+            return ch;
+        }
+    }
+
+    return SENSOR_ARRAY_NO_CHANNEL;
+}
+
+/**
+ * @brief Count a failed chain against its probe
+ */
+static void array_probe_failed(array_bus_t *bus, sensor_probe_t *probe)
+{
+    /* The chain may have stopped before or after its select */
+    bus->selected = SENSOR_ARRAY_NO_CHANNEL;
+
+    /* Result of the running conversion is lost: start over next scan */
+    probe->converting = false;
+    probe->have_pressure = false;
+    if (probe->error_count < UINT8_MAX) {
+        probe->error_count++;
+    }
+}
+
+/**
+ * @brief Store the ADC result read by the chain of a channel
+ */
+static void array_store_result(uint8_t ch)
+{
+    sensor_probe_t *probe = &probes[ch];
+    uint32_t adc = ms5837_adc_from_bytes(probe->adc_bytes);
+
+    if (probe->converting_pressure) {
+        probe->pressure_adc = adc;
+        probe->have_pressure = true;
+        return;
+    }
+
+    probe->temperature_adc = adc;
+
+    if (!probe->have_pressure) {
+        return;  /* Temperature without a preceding pressure result */
+    }
+
+    ms5837_compensate(&probe->calibration, probe->pressure_adc, probe->temperature_adc,
+                      &probe->data.pressure, &probe->data.temperature);
+    probe->data.timestamp_us = probe->pressure_timestamp_us;
+    probe->data.sequence = probe->sequence++;
+    probe->data.valid = true;
+    probe->data.quality = SENSOR_QUALITY_CRC_OK;  /* ms5837_read_prom() checks it */
+    if (probe->error_count != probe->errors_published) {
+        probe->errors_published = probe->error_count;
+        probe->data.quality |= SENSOR_QUALITY_RETRIED;
+    }
+    probe->data.error_count = probe->error_count;
+    probe->have_pressure = false;
+    
+    if (event_callback != NULL) {
+        event_callback();
+    }
+}
+
+/**
+ * @brief Queue the chain of one channel: select (unless cached), ADC read,
+ *        next conversion
+ */
+static bool array_queue_channel(array_bus_t *bus, uint8_t ch)
+{
+    sensor_probe_t *probe = &probes[ch];
+    ms58_hal_xfer_t chain[SENSOR_ARRAY_CHAIN_XFERS];
+    uint32_t n = 0;
+
+    if (bus->selected != ch) {
+        chain[n++] = (ms58_hal_xfer_t){ .addr = bus->mux_addr,
+                                        .cmd = (uint8_t)(1U << (ch - bus->first)) };
+    }
+
+    /* D1 and D2 alternate; a probe without a conversion starts with D1 on a
+     * scan of its phase */
+    probe->starting_pressure = probe->converting ? !probe->converting_pressure
+                                                 : probe->odd_phase == bus->odd_scan;
+    probe->reading = probe->converting;
+
+    if (probe->reading) {
+        chain[n++] = (ms58_hal_xfer_t){ .addr = bus->sensor_addr, .cmd = MS5837_ADC_READ,
+                                        .cmd_first = true, .buf = probe->adc_bytes,
+                                        .n = MS5837_ADC_BYTES };
+    }
+    chain[n++] = (ms58_hal_xfer_t){ .addr = bus->sensor_addr,
+                                    .cmd = probe->starting_pressure ? SENSOR_ARRAY_OSR_D1
+                                                                    : SENSOR_ARRAY_OSR_D2,
+                                    .done = array_on_transfer_done, .done_ctx = bus };
+
+    if (ms58_hal_submit(bus->hi2c, chain, n, false) != E_MS58370BA01_SUCCESS) {
+        return false;
+    }
+    bus->selected = ch;
+    return true;
+}
+
+/**
+ * @brief Keep SENSOR_ARRAY_CHAINS chains queued, or finish the scan
+ */
+static void array_fill(array_bus_t *bus)
+{
+    while (running && bus->chains < SENSOR_ARRAY_CHAINS) {
+        uint8_t ch = array_next_channel(bus, bus->next_channel);
+
+        if (ch == SENSOR_ARRAY_NO_CHANNEL) {
+            break;
+        }
+        bus->next_channel = (uint8_t)(ch + 1U);
+
+        if (!array_queue_channel(bus, ch)) {
+            array_probe_failed(bus, &probes[ch]);
+            continue;
+        }
+        if (bus->chains == 0U) {
+            bus->scan_channel = ch;
+        } else {
+            bus->queued_channel = ch;
+        }
+        bus->chains++;
+    }
+
+    if (bus->chains == 0U) {
+        bus->scan_channel = SENSOR_ARRAY_NO_CHANNEL;
+        bus->scan_active = false;
+    }
+}
+
+/**
+ * @brief Completion of the chain of the oldest queued channel
+ *
+ * Called from the bus interrupt context, with the bus as ctx.
+ */
+static void array_on_transfer_done(void *ctx, ms583730ba01_err_t result)
+{
+    array_bus_t *bus = (array_bus_t *)ctx;
+    sensor_probe_t *probe = &probes[bus->scan_channel];
+
+    if (result != E_MS58370BA01_SUCCESS) {
+        array_probe_failed(bus, probe);
+    } else {
+        if (probe->reading) {
+            array_store_result(bus->scan_channel);
+        }
+        /* The conversion command is the last transfer: it has just started */
+        probe->converting_pressure = probe->starting_pressure;
+        if (probe->converting_pressure) {
+            probe->pressure_timestamp_us = hal_tim2_get_timestamp_us();
+        }
+        probe->converting = true;
+    }
+
+    bus->chains--;
+    bus->scan_channel = bus->queued_channel;
+    array_fill(bus);
+}
+
+/**
+ * @brief Queue the PROM chain of the next probe left, or end the bring-up
+ *
+ * Called from the init, then from the bus interrupt context.
+ */
+static void array_queue_prom(array_bus_t *bus)
+{
+    ms58_hal_xfer_t chain[SENSOR_ARRAY_PROM_XFERS];
+
+    while (bus->bringup_mask != 0U) {
+        uint8_t ch = bus->first;
+        uint32_t n = 0;
+
+        while ((bus->bringup_mask & (1U << ch)) == 0U) {
+            ch++;
+        }
+        bus->bringup_mask &= (uint16_t)~(1U << ch);
+
+        if (bus->selected != ch) {
+            chain[n++] = (ms58_hal_xfer_t){ .addr = bus->mux_addr,
+                                            .cmd = (uint8_t)(1U << (ch - bus->first)) };
+        }
+        for (uint32_t i = 0; i < SENSOR_ARRAY_PROM_WORDS; i++) {
+            chain[n++] = (ms58_hal_xfer_t){ .addr = bus->sensor_addr,
+                                            .cmd = (uint8_t)(MS5837_PROM_READ_BASE + 2U * i),
+                                            .cmd_first = true, .buf = &bus->prom_bytes[2U * i],
+                                            .n = 2 };
+        }
+        chain[n - 1U].done = array_on_prom_done;
+        chain[n - 1U].done_ctx = bus;
+
+        if (ms58_hal_submit(bus->hi2c, chain, n, false) == E_MS58370BA01_SUCCESS) {
+            bus->selected = ch;
+            bus->prom_channel = ch;
+            return;
+        }
+        bus->selected = SENSOR_ARRAY_NO_CHANNEL;
+    }
+
+    bus->bringup_active = false;
+}
+
+/**
+ * @brief Completion of a PROM chain: check it at once, go on to the next
+ *
+ * Called from the bus interrupt context, while nothing else is queued,
+ * with the bus as ctx.
+ */
+static void array_on_prom_done(void *ctx, ms583730ba01_err_t result)
+{
+    array_bus_t *bus = (array_bus_t *)ctx;
+    uint8_t ch = bus->prom_channel;
+    uint16_t words[SENSOR_ARRAY_PROM_WORDS];
+
+    if (result == E_MS58370BA01_SUCCESS) {
+        for (uint32_t i = 0; i < SENSOR_ARRAY_PROM_WORDS; i++) {
+            words[i] = (uint16_t)((bus->prom_bytes[2U * i] << 8) | bus->prom_bytes[2U * i + 1U]);
+        }
+        if (ms5837_prom_crc_ok(words) &&
+            ms5837_calib_prepare(words, &probes[ch].calibration) == E_MS58370BA01_SUCCESS) {
+            bus->bringup_ok |= (uint16_t)(1U << ch);
+        }
+    } else {
+        bus->selected = SENSOR_ARRAY_NO_CHANNEL;
+    }
+
+    array_queue_prom(bus);
+}
+
+/**
+ * @brief Drop a bring-up that never completed (stuck bus)
+ */
+static void array_abort_bringup(array_bus_t *bus)
+{
+    uint32_t masked = hal_irq_mask(1UL << bus->irqn);
+
+    ms58_hal_abort(bus->hi2c);
+    bus->bringup_mask = 0;
+    bus->bringup_active = false;
+    bus->selected = SENSOR_ARRAY_NO_CHANNEL;
+    hal_irq_unmask(masked);
+}
+
+/**
+ * @brief Start a scan on a bus that is free and due
+ */
+static void array_scan_bus(array_bus_t *bus)
+{
+    if (bus->ticks_since_scan < SENSOR_ARRAY_SCAN_TICKS) {
+        bus->ticks_since_scan++;
+    }
+
+    /* Previous scan still on the bus - start as soon as it is done */
+    if (bus->scan_active || bus->ticks_since_scan < SENSOR_ARRAY_SCAN_TICKS) {
+        return;
+    }
+
+    if (array_next_channel(bus, bus->first) == SENSOR_ARRAY_NO_CHANNEL) {
+        return;
+    }
+
+    bus->ticks_since_scan = 0;
+    bus->scan_active = true;
+    bus->odd_scan = !bus->odd_scan;
+    bus->next_channel = bus->first;
+    bus->chains = 0;
+    array_fill(bus);
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+bool sensor_array_init(uint16_t channel_mask)
+{
+    bool all_ok = true;
+    bool odd_phase = false;
+    bool reset = false;
+    uint32_t start_us;
+
+    running = false;
+    active_mask = 0;
+#if BOARD_RAM_VECTORS_ENABLE
+    main_route_vectors();
+#endif
+
+    /* Every probe reset first: the reset times overlap */
+    for (uint8_t b = 0; b < SENSOR_ARRAY_BUSES; b++) {
+        array_bus_t *bus = &buses[b];
+
+        bus->scan_active = false;
+        bus->scan_channel = SENSOR_ARRAY_NO_CHANNEL;
+        bus->chains = 0;
+        bus->selected = SENSOR_ARRAY_NO_CHANNEL;
+        bus->bringup_mask = 0;
+        bus->bringup_ok = 0;
+        bus->bringup_active = false;
+        if (((channel_mask >> bus->first) & 0xFFU) == 0U) {
+            continue;
+        }
+
+        bus->handle = ms58_get_hal_handle(&bus->dev, bus->hi2c, bus->sensor_addr);
+        if (bus->handle.write_cmd == NULL) {
+            all_ok = false;
+            continue;
+        }
+
+        for (uint8_t ch = bus->first; ch < bus->first + SENSOR_ARRAY_BUS_CHANNELS; ch++) {
+            sensor_probe_t *probe = &probes[ch];
+            uint8_t select = (uint8_t)(1U << (ch - bus->first));
+
+            if (!(channel_mask & (1U << ch))) {
+                continue;
+            }
+
+            probe->converting = false;
+            probe->have_pressure = false;
+            probe->error_count = 0;
+            probe->errors_published = 0;
+            probe->sequence = 0;
+            probe->data.valid = false;
+
+            bus->selected = SENSOR_ARRAY_NO_CHANNEL;
+            if (ms58_hal_mux_select(bus->hi2c, bus->mux_addr, select) != E_MS58370BA01_SUCCESS) {
+                all_ok = false;
+                continue;
+            }
+            bus->selected = ch;
+            if (bus->handle.write_cmd(bus->handle.ctx, MS5837_RESET) != E_MS58370BA01_SUCCESS) {
+                all_ok = false;
+                continue;
+            }
+            bus->bringup_mask |= (uint16_t)(1U << ch);
+            reset = true;
+        }
+    }
+    if (!reset) {
+        return all_ok;
+    }
+
+    start_us = timebase_now_us();
+    while (timebase_now_us() - start_us < MS5837_RESET_TIME_US) {
+    }
+
+    /* Then one PROM chain per probe, both buses at once */
+    for (uint8_t b = 0; b < SENSOR_ARRAY_BUSES; b++) {
+        if (buses[b].bringup_mask != 0U) {
+            buses[b].bringup_active = true;
+            array_queue_prom(&buses[b]);
+        }
+    }
+    start_us = timebase_now_us();
+    for (uint8_t b = 0; b < SENSOR_ARRAY_BUSES; b++) {
+        array_bus_t *bus = &buses[b];
+
+        while (bus->bringup_active &&
+               timebase_now_us() - start_us < SENSOR_ARRAY_BRINGUP_TIMEOUT_US) {
+        }
+        if (bus->bringup_active) {
+            array_abort_bringup(bus);
+        }
+    }
+
+    for (uint8_t b = 0; b < SENSOR_ARRAY_BUSES; b++) {
+        for (uint8_t ch = buses[b].first; ch < buses[b].first + SENSOR_ARRAY_BUS_CHANNELS; ch++) {
+            if (!(channel_mask & (1U << ch))) {
+                continue;
+            }
+            if (!(buses[b].bringup_ok & (1U << ch))) {
+                all_ok = false;
+                continue;
+            }
+            active_mask |= (uint16_t)(1U << ch);
+            probes[ch].odd_phase = odd_phase;
+            odd_phase = !odd_phase;
+        }
+    }
+
+    return all_ok;
+}
+
+bool sensor_array_start(void)
+{
+    if (active_mask == 0) {
+        return false;
+    }
+
+    for (uint8_t b = 0; b < SENSOR_ARRAY_BUSES; b++) {
+        buses[b].ticks_since_scan = SENSOR_ARRAY_SCAN_TICKS;  /* First tick starts a scan */
+    }
+    running = true;
+#if BOARD_RAM_VECTORS_ENABLE
+    main_route_vectors();
+#endif
+    return true;
+}
+
+bool sensor_array_stop(void)
+{
+    running = false;
+#if BOARD_RAM_VECTORS_ENABLE
+    main_route_vectors();
+#endif
+    return true;
+}
+
+bool sensor_array_is_running(void)
+{
+    return running;
+}
+
+bool sensor_array_get_data(uint8_t channel, sensor_data_t *data)
+{
+    if (data == NULL || channel >= SENSOR_ARRAY_MAX_CHANNELS) {
+        return false;
+    }
+
+    if (probes[channel].data.valid) {
+        *data = probes[channel].data;
+        return true;
+    }
+
+    return false;
+}
+
+void sensor_array_set_second_order(bool enable)
+{
+    for (uint8_t ch = 0; ch < SENSOR_ARRAY_MAX_CHANNELS; ch++) {
+        ms5837_calib_set_second_order(&probes[ch].calibration, enable);
+    }
+}
+
+void sensor_array_register_event_callback(sensor_sampling_event_cb_t callback)
+{
+    event_callback = callback;
+}
+
+uint16_t sensor_array_get_active_mask(void)
+{
+    return active_mask;
+}
+
+void sensor_array_timer_isr(void)
+{
+#if !BOARD_RAM_VECTORS_ENABLE
+    if (!running) {
+        return;
+    }
+#endif
+
+    /* Both scans overlap: their completions share one priority level and
+     * never preempt each other */
+    for (uint8_t b = 0; b < SENSOR_ARRAY_BUSES; b++) {
+        array_scan_bus(&buses[b]);
+    }
+}
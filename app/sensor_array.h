@@ -0,0 +1,133 @@
+#ifndef SENSOR_ARRAY_H
+#define SENSOR_ARRAY_H
+
+/**
+ * @file sensor_array.h
+ * @brief Multi-probe MS5837 sampling through the TCA9548 I2C mux
+ *
+ * All probes share the MS5837 address, so each one sits behind its own mux
+ * channel. A round-robin scan visits every populated channel per cycle: it
+ * reads the result of the conversion started on the previous scan and
+ * immediately starts the next one, so every probe converts while the others
+ * are being read. Per-probe rate stays at one P/T pair per two scans as the
+ * probe count grows, until the bus itself is saturated.
+ *
+ * Uses the same I2C2 bus, async transport and TIM2 tick as sensor_sampling:
+ * run either this module or sensor_sampling, not both at once. With
+ * BOARD_I2C3_MUX_CHANNELS a second mux on I2C3 carries channels 8..15; each
+ * bus runs its own scan on the same tick, so the two overlap on the wire.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sensor_sampling.h"  /* For sensor_data_t type */
+#include "board_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define SENSOR_ARRAY_BUS_CHANNELS   8  /* TCA9548 channel count */
+
+/* Channels 0..7 on I2C2, 8..15 on I2C3 */
+#if BOARD_I2C3_MUX_CHANNELS != 0
+#define SENSOR_ARRAY_MAX_CHANNELS   (2 * SENSOR_ARRAY_BUS_CHANNELS)
+#else
+#define SENSOR_ARRAY_MAX_CHANNELS   SENSOR_ARRAY_BUS_CHANNELS
+#endif
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Initialize the probe array
+ *
+ * Resets every populated probe in turn, waits out one reset time for all
+ * of them, then reads the PROM of each as one chain on the bus queue
+ * (mux select and seven word reads, both buses at once), checked from the
+ * bus interrupt as soon as its last word lands while the next chain runs.
+ * Blocking (bus-limited, some 1 ms per probe at 100 kHz); needs the bus
+ * interrupts, so call after the bus init and before sensor_array_start().
+ *
+ * @param channel_mask Bit n = probe on channel n (bits 8..15: I2C3 mux)
+ * @return true if every probe answered, false otherwise (probes that
+ *         failed are dropped from the scan)
+ */
+bool sensor_array_init(uint16_t channel_mask);
+
+/**
+ * @brief Start round-robin sampling
+ *
+ * @return true if at least one probe is active
+ */
+bool sensor_array_start(void);
+
+/**
+ * @brief Stop sampling
+ *
+ * The scan in flight (if any) finishes the channel chains already queued
+ * and stops.
+ *
+ * @return true
+ */
+bool sensor_array_stop(void);
+
+/**
+ * @brief Get latest data of one probe
+ *
+ * @param channel Channel (0..SENSOR_ARRAY_MAX_CHANNELS-1)
+ * @param data Pointer to sensor_data_t structure to fill
+ * @return true if data is valid, false otherwise
+ */
+bool sensor_array_get_data(uint8_t channel, sensor_data_t *data);
+
+/**
+ * @brief Enable accurate (second-order) temperature compensation on all probes
+ *
+ * @param enable true to apply the second-order correction
+ */
+void sensor_array_set_second_order(bool enable);
+
+/**
+ * @brief Register the event callback
+ * 
+ * Called from I2C2 (or I2C3) interrupt context each time a probe completes
+ * a new P/T pair.
+ * 
+ * @param callback Function to call (NULL to disable)
+ */
+void sensor_array_register_event_callback(sensor_sampling_event_cb_t callback);
+
+/**
+ * @brief Get the mask of probes taking part in the scan
+ *
+ * @return Bit n set if the probe on channel n is active
+ */
+uint16_t sensor_array_get_active_mask(void);
+
+/**
+ * @brief Whether the scan runs (sensor_array_start() .. sensor_array_stop())
+ *
+ * @return true while running
+ */
+bool sensor_array_is_running(void);
+
+/**
+ * @brief Timer interrupt handler for array sampling
+ *
+ * Must be called from the TIM2 update interrupt. Does nothing unless
+ * sensor_array_start() was called (with BOARD_RAM_VECTORS_ENABLE not
+ * called otherwise: the TIM2 handler without the scan is installed).
+ */
+void sensor_array_timer_isr(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SENSOR_ARRAY_H */
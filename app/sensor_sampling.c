@@ -24,15 +24,73 @@
  * 7	12ms	CALCULATE	Calculate P & T, mark data valid
  * Result: new readings available approximately every 12ms (6 interrupts), even though the timer fires every 2ms.
  
+ * Pipelined mode (SENSOR_MODE_PIPELINED, default): the read of one ADC result
+ * immediately starts the next conversion from the same completion, and the
+ * calculation is folded into the read-D2 completion:
+ * Interrupt	Time	State	What Happens
+ * 1	0ms	START_PRESSURE_CONV	Send pressure conversion command (first cycle only)
+ * 2	2ms	READ_PRESSURE_ADC	Read pressure ADC, start temperature conversion
+ * 3	4ms	READ_TEMP_ADC	Read temperature ADC, calculate, start pressure conversion
+ * 4	6ms	READ_PRESSURE_ADC	...
+ * Result: a new reading every 4ms (2 interrupts) in steady state.
+ 
+ * Exact-timed mode (SENSOR_MODE_EXACT): the tick only starts a cycle. Each
+ * conversion arms a TIM2 CH1 one-shot for the datasheet conversion time of
+ * the active OSR, and the compare interrupt (sensor_sampling_conversion_isr())
+ * reads the result right when it is ready:
+ * Time	Event	What Happens
+ * 0ms	Tick	Send pressure conversion command
+ * ~0.6ms	CH1 compare	Read pressure ADC, start temperature conversion
+ * ~1.2ms	CH1 compare	Read temperature ADC, calculate
+ * Result: one reading per tick (every 2ms), ~1.5ms after the cycle started.
+ * With the external sync input (sensor_sampling_set_sync_input()) an
+ * edge on the sync pin takes the place of the tick: the EXTI vector runs
+ * the same step, and the timebase ticks leave the sampler alone.
+ 
+ * Bus transfers are asynchronous: a tick only starts the I2C2 transfer for its
+ * step and returns. The completion callback (I2C2 interrupt, same priority as
+ * TIM2) advances the state; the ADC read chains "send ADC read command" and
+ * "receive 3 bytes" back to back from interrupt context. A tick that arrives
+ * while a transfer is still in flight is skipped.
+ 
+ * Bottom half: CALCULATE only captures the raw D1/D2 pair into a small ring
+ * and pends PendSV. sensor_sampling_bottom_half() (PendSV, lowest priority)
+ * runs compensation and the optional filter stage, publishes the sample and
+ * adapts the OSR, so the TIM2/I2C2 handlers stay short and the I2C1 slave is
+ * never held off by math. A direct consumer (the DAC fast path) runs right
+ * after the compensation with interrupts masked, for its few stores.
  */
 
 #include "sensor_sampling.h"
 #include "ms58.h"
 #include "ms58_regs.h"
 #include "ms58_hal_wrapper.h"
+#include "conv_sensor.h"
 #include "board_config.h"
 #include "board_init.h"
+#include "hal_config.h"
+#include "eeprom.h"
+#include "sample_stats.h"
+#include "tracker.h"
+#include "fixmath.h"
+#include "prof.h"
+#include "latency.h"
+#include "probe.h"
+#include "warm_restart.h"
+#include "bus_tune.h"
+#include "conv_tune.h"
+#include "clock_scale.h"
+#if BOARD_FLASH_LOG_REPLAY
+#include "flash_log.h"
+#endif
 #include "stm32l0xx_hal.h"
+#include "hal_atomic.h"
+#if BOARD_RTOS_ENABLE
+#include "rtos_tasks.h"
+#endif
+#if BOARD_RAM_VECTORS_ENABLE
+#include "main.h"
+#endif
 
 /* ============================================================================
  * PRIVATE DEFINITIONS
@@ -41,6 +99,9 @@
 /* Sensor reading state machine */
 typedef enum {
     SENSOR_STATE_IDLE,
+    SENSOR_STATE_RESET,             /* Bring-up: send reset command */
+    SENSOR_STATE_WAIT_RESET,        /* Bring-up: wait for PROM reload */
+    SENSOR_STATE_READ_PROM,         /* Bring-up: PROM words chained from I2C2 completions */
     SENSOR_STATE_START_PRESSURE_CONV,
     SENSOR_STATE_WAIT_PRESSURE_CONV,
     SENSOR_STATE_READ_PRESSURE_ADC,
@@ -48,220 +109,2331 @@ typedef enum {
     SENSOR_STATE_WAIT_TEMP_CONV,
     SENSOR_STATE_READ_TEMP_ADC,
     SENSOR_STATE_CALCULATE,
-    SENSOR_STATE_ERROR
+    SENSOR_STATE_ERROR              /* Last: order is the sensor_tick_stats_t.wcet_us index */
 } sensor_state_t;
 
-/* OSR (Oversampling Ratio) settings - using minimum for 2ms sampling */
-#define SENSOR_OSR_D1    MS5837_CONVERT_D1_256  /* Pressure conversion OSR=256 */
-#define SENSOR_OSR_D2    MS5837_CONVERT_D2_256  /* Temperature conversion OSR=256 */
-/* Delay in timer interrupts (each interrupt = 2ms)
- * OSR=256 requires ~0.6ms, but we wait 1 interrupt (2ms) to be safe */
-#define SENSOR_DELAY_D1_INTERRUPTS  1  /* 1 interrupt = 2ms for pressure conversion */
-#define SENSOR_DELAY_D2_INTERRUPTS  1  /* 1 interrupt = 2ms for temperature conversion */
+/* Boot OSR (Oversampling Ratio) settings, from the sampling profile */
+#define SENSOR_DEFAULT_OSR_D1       ((sensor_osr_t)BOARD_SAMPLING_P_OSR)  /* Pressure conversion */
+#define SENSOR_DEFAULT_OSR_D2       ((sensor_osr_t)BOARD_SAMPLING_T_OSR)  /* Temperature conversion */
+
+/* Tick period in microseconds and conversion time rounded up to whole ticks */
+#define SENSOR_TICK_US              (1000000UL / BOARD_TIM2_FREQ_HZ)
+#define SENSOR_TICKS(us)            (((us) + SENSOR_TICK_US - 1) / SENSOR_TICK_US)
+
+/* Sampling profile checks (board_config.h). Bus time around a conversion:
+ * its ADC read (address, command, address, 3 bytes) and the next command
+ * at 400 kHz, with the handler entries */
+#define SENSOR_PROFILE_XFER_US      250U
+
+#if BOARD_SAMPLING_MODE > 2 || BOARD_SAMPLING_P_OSR > 5 || BOARD_SAMPLING_T_OSR > 5
+#error "Sampling profile: mode must be 0..2 and the OSRs 0..5"
+#endif
+#if BOARD_SAMPLING_T_DECIMATION == 0 || BOARD_SAMPLING_T_DECIMATION > 65535
+#error "Sampling profile: temperature decimation must be 1..65535"
+#endif
+#if BOARD_SAMPLING_RING < 2 || (BOARD_SAMPLING_RING & (BOARD_SAMPLING_RING - 1)) != 0 || \
+    BOARD_SAMPLING_RAW_RING < 2 || (BOARD_SAMPLING_RAW_RING & (BOARD_SAMPLING_RAW_RING - 1)) != 0
+#error "Sampling profile: ring sizes must be powers of two, 2 at least"
+#endif
+#if SENSOR_TICKS(MS5837_CONV_TIME_US(5)) > 255
+#error "Sampling profile: the OSR 8192 conversion must be under 256 ticks"
+#endif
+/* Exact-timed: a cycle with both conversions inside one tick. Pipelined:
+ * each conversion and its read inside one (a longer one waits whole extra
+ * ticks, not what a profile asks for) */
+#if BOARD_SAMPLING_MODE == 2 && \
+    MS5837_CONV_TIME_US(BOARD_SAMPLING_P_OSR) + MS5837_CONV_TIME_US(BOARD_SAMPLING_T_OSR) + \
+    2 * SENSOR_PROFILE_XFER_US > SENSOR_TICK_US
+#error "Sampling profile: the exact-timed cycle at these OSRs does not fit the tick"
+#endif
+#if BOARD_SAMPLING_MODE == 1 && \
+    (MS5837_CONV_TIME_US(BOARD_SAMPLING_P_OSR) + SENSOR_PROFILE_XFER_US > SENSOR_TICK_US || \
+     MS5837_CONV_TIME_US(BOARD_SAMPLING_T_OSR) + SENSOR_PROFILE_XFER_US > SENSOR_TICK_US)
+#error "Sampling profile: a pipelined conversion at these OSRs does not fit the tick"
+#endif
+
+/* Ticks after the reset command: the command completes mid-tick, so one
+ * extra tick guarantees the full reload time has passed */
+#define SENSOR_RESET_TICKS          (SENSOR_TICKS(MS5837_RESET_TIME_US) + 1U)
+
+/* Reload time counted from before an early reset command: its transfer
+ * included */
+#define SENSOR_EARLY_RESET_WAIT_US  (MS5837_RESET_TIME_US + 200U)
+
+/* Temperature conversion every N cycles (1 = every cycle) */
+#define SENSOR_DEFAULT_TEMP_DECIMATION  BOARD_SAMPLING_T_DECIMATION
+
+/* Sample ring capacity (power of two so free-running indices wrap cleanly) */
+#define SENSOR_RING_SIZE            BOARD_SAMPLING_RING
+#define SENSOR_RING_MASK            (SENSOR_RING_SIZE - 1U)
+
+/* Raw capture ring between the sampling ISRs and the PendSV bottom half */
+#define SENSOR_RAW_RING_SIZE        BOARD_SAMPLING_RAW_RING
+#define SENSOR_RAW_RING_MASK        (SENSOR_RAW_RING_SIZE - 1U)
+
+/* Raw ADC pair captured in interrupt context, compensated in the bottom half */
+typedef sensor_raw_record_t sensor_raw_t;
+
+/* Raw pairs for a raw trace, bottom half to main loop */
+#define SENSOR_RAW_CAPTURE_SIZE     16U
+#define SENSOR_RAW_CAPTURE_MASK     (SENSOR_RAW_CAPTURE_SIZE - 1U)
+
+/* Filter history per channel, and the packed filter configuration word */
+#define SENSOR_FILTER_MAX_LEN       (1U << SENSOR_FILTER_MAX_LOG2)
+#define SENSOR_FILTER_CONFIG(mode, p_log2, t_log2) \
+    ((uint32_t)(mode) | ((uint32_t)(p_log2) << 8) | ((uint32_t)(t_log2) << 16))
+#define SENSOR_FILTER_MEDIAN        0x0F000000UL  /* Median window field */
+#define SENSOR_FILTER_CUSTOM_GEN    0xF0000000UL  /* Bumped per custom IIR section */
+#define SENSOR_FILTER_MEDIAN_SHIFT  24U
+#define SENSOR_FILTER_GEN_STEP      0x10000000UL
+
+/* Compare-exchange: a <= b afterwards */
+#define SENSOR_SORT2(a, b) do { if ((a) > (b)) { int32_t t_ = (a); (a) = (b); (b) = t_; } } while (0)
+#define SENSOR_IIR_INPUT_MAX        0x7FFFFFL     /* Inputs saturate to 24 bits */
+#define SENSOR_QUALITY_IIR_SETTLE   32U           /* IIR inputs flagged WARMUP after a prime */
+
+/* One filtered channel: last 2^log2 inputs and their running sum */
+typedef struct {
+    int32_t history[SENSOR_FILTER_MAX_LEN];
+    int64_t sum;
+    uint8_t log2;
+} sensor_filter_channel_t;
+
+/* One IIR channel: its section and the last two inputs and outputs, Q8 */
+typedef struct {
+    sensor_iir_coeffs_t coeffs;
+    int32_t x1;
+    int32_t x2;
+    int32_t y1;
+    int32_t y2;
+} sensor_iir_channel_t;
+
+/* Calibration cache record in data EEPROM:
+ * [0] magic, [1..4] PROM C0..C6 packed two per word, [5] ~sum of [0..4] */
+#define SENSOR_CALIB_CACHE_MAGIC    0x4D534331UL  /* "MSC1" */
+#define SENSOR_CALIB_CACHE_WORDS    6U
+
+/* Ticks a transfer (or the PROM chain) may stay in flight before it is
+ * treated as a stuck bus. The longest chain, 7 PROM words, takes ~4ms */
+#define SENSOR_TRANSFER_TIMEOUT_TICKS   5U
+
+/* Sampling mode used after sensor_sampling_init() (sampling profile) */
+#define SENSOR_DEFAULT_MODE         ((sensor_sampling_mode_t)BOARD_SAMPLING_MODE)
+
+/* Acquisition state of the sensor: transport, calibration, state machine,
+ * cycle in progress and newest sample. The transport completions get it as
+ * their ctx (handle.done_ctx) */
+typedef struct {
+#if !BOARD_FLASH_LOG_REPLAY
+    ms58_hal_dev_t dev;                /* Handle context: I2C2, sensor address */
+#endif
+    ms583730ba01_h handle;
+    ms5837_calib_t calibration;        /* Precomputed terms for the ISR kernel */
+    volatile bool calibration_loaded;
+    /* Asynchronous bring-up: PROM words as read, and the word in flight */
+    uint16_t prom_words[7];
+    uint8_t prom_index;
+    uint8_t prom_bytes[2];
+    volatile sensor_state_t state;
+    sensor_data_t latest;
+    volatile uint32_t latest_seq;      /* Odd while latest is being written (torn copies) */
+    uint32_t pressure_adc;
+    uint32_t temperature_adc;
+    uint32_t wait_counter;
+    volatile bool compare_armed;       /* Exact mode: the compare ends the conversion in flight */
+    uint32_t pressure_timestamp_us;    /* Start of the current D1 conversion */
+    uint32_t sequence;
+    volatile bool transfer_pending;
+    uint8_t pending_ticks;             /* Ticks the current transfer chain has been in flight */
+    uint8_t adc_bytes[CONV_SENSOR_MAX_RESULT_BYTES];
+    uint8_t read_retries_left;            /* For the ADC read in flight */
+    bool late_retry_left;                 /* Read of 0 may wait and read again */
+    sensor_osr_t conv_osr;                /* OSR of the conversion in flight */
+    volatile bool single_shot;            /* IDLE after the next sample */
+    uint16_t temp_skip_count;             /* Cycles since temperature_adc was converted */
+    bool temperature_adc_valid;
+} sensor_sampler_t;
 
 /* ============================================================================
  * PRIVATE VARIABLES
  * ============================================================================ */
 
-static ms583730ba01_h sensor_handle;
-static uint16_t calibration_data[7];
-static bool calibration_loaded = false;
-static sensor_state_t sensor_state = SENSOR_STATE_IDLE;
-static sensor_data_t latest_data = {0};
-static uint32_t pressure_adc = 0;
-static uint32_t temperature_adc = 0;
-static uint32_t wait_counter = 0;
+/* The sensor on I2C2, and the operations of its type */
+static sensor_sampler_t sampler = {
+    .read_retries_left = BOARD_SENSOR_READ_RETRIES,
+    .conv_osr = SENSOR_DEFAULT_OSR_D1,
+};
+static const conv_sensor_t *const conv_sensor = &ms5837_conv_sensor;
+
+#if BOARD_PROBE_ENABLE && (BOARD_PROBE_GROUPS & PROBE_GROUP_STATE)
+/* Last state recorded by a sampling step (probe.h) */
+static sensor_state_t probe_last_state = SENSOR_TICK_STATE_COUNT;
+#endif
+
+/* Conversion time per OSR (exact-timed mode) and in ticks (tick-based
+ * modes), at init from the sensor's datasheet times or the boot
+ * calibration (conv_tune.h): OSR=256 needs ~0.6ms but waits 1 interrupt */
+static uint16_t osr_conv_us[SENSOR_OSR_COUNT];
+static uint8_t osr_delay_ticks[SENSOR_OSR_COUNT];
+static uint8_t osr_late_reads[SENSOR_OSR_COUNT];  /* Reads of 0, to BOARD_SENSOR_LATE_WIDEN_AFTER */
+
+static volatile bool calib_cache_store_pending = false;
+
+#if BOARD_WARM_RESTART_ENABLE
+/**
+ * @brief Kept across a warm reset (warm_restart.h)
+ */
+typedef struct {
+    uint16_t prom[7];     /* PROM words of the running sensor */
+    uint16_t prom_check;  /* Sum complement of prom, 0 until bring-up */
+    uint32_t sequence;    /* The sampler's sequence */
+} sensor_warm_t;
+
+static sensor_warm_t sensor_warm NOINIT;
+#define SENSOR_WARM_KEEP_SEQUENCE(s)  (sensor_warm.sequence = (s)->sequence)
+#else
+#define SENSOR_WARM_KEEP_SEQUENCE(s)  ((void)(s))
+#endif
+static bool bus_recovery_needed = false;
+static sensor_error_stats_t error_stats = {0};
+static uint32_t fail_streak = 0;    /* Failed cycles since the last captured pair */
+static uint32_t backoff_ticks = 0;  /* Ticks to wait before the next recovery attempt */
+static sensor_tick_stats_t tick_stats = {0};
+
+/* Sampling jitter, bottom half only; published under jitter_seq. Means
+ * are Q8 us, the variance Q16 us^2 */
+static volatile uint32_t jitter_reset_gen = 0;  /* Bumped by the reset */
+static uint32_t jitter_reset_applied = 0;
+static bool jitter_have_last = false;
+static uint32_t jitter_last_us = 0;
+static uint32_t jitter_last_seq = 0;
+static uint32_t jitter_intervals = 0;
+static uint32_t jitter_min_us = 0;
+static uint32_t jitter_max_us = 0;
+static uint32_t jitter_peak_us = 0;
+static int64_t jitter_mean_q8 = 0;
+static int64_t jitter_var_q16 = 0;
+static sensor_jitter_stats_t jitter_shown = {0};  /* Under jitter_seq, stddev_ns unused */
+static uint64_t jitter_shown_var_q16 = 0;
+static volatile uint32_t jitter_seq = 0;          /* Odd while jitter_shown is written */
+static volatile sensor_sampling_event_cb_t event_callback = NULL;
+static volatile sensor_sampling_direct_cb_t direct_callback = NULL;
+static volatile sensor_sampling_publish_cb_t publish_callback = NULL;
+static volatile sensor_sampling_mode_t sampling_mode = SENSOR_DEFAULT_MODE;
+static volatile bool sync_external = false;  /* Cycles started by the sync input, not the tick */
+static uint32_t sync_edge_us = 0;            /* Vector entry of the last sync edge */
+
+/* Reset sent ahead of sampling (sensor_sampling_reset_early()) */
+typedef enum {
+    SENSOR_EARLY_RESET_NONE = 0,
+    SENSOR_EARLY_RESET_SENT,
+    SENSOR_EARLY_RESET_DONE
+} sensor_early_reset_t;
+
+static volatile sensor_early_reset_t early_reset = SENSOR_EARLY_RESET_NONE;
+static uint32_t early_reset_us = 0;  /* board_get_uptime_us() before the command */
+
+/* Requested OSR per conversion, latched into the sampler's conv_osr when a
+ * conversion starts so its delay always matches the command that was sent */
+static volatile sensor_osr_t osr_d1 = SENSOR_DEFAULT_OSR_D1;
+static volatile sensor_osr_t osr_d2 = SENSOR_DEFAULT_OSR_D2;
+
+/* Single-producer (sampler ISR) / single-consumer (main loop) sample ring.
+ * Indices are free-running: the producer only writes ring_head, the consumer
+ * only writes ring_tail, so no interrupt masking is needed */
+static sensor_data_t ring[SENSOR_RING_SIZE];
+static volatile uint32_t ring_head = 0;
+static volatile uint32_t ring_tail = 0;
+static volatile uint32_t ring_overruns = 0;
+
+/* Raw captures: produced by the sampling ISRs (priority 2), consumed by
+ * PendSV (priority 3, the lowest), which cannot preempt the producer */
+static sensor_raw_t raw_ring[SENSOR_RAW_RING_SIZE];
+static volatile uint32_t raw_head = 0;
+static volatile uint32_t raw_tail = 0;
+static volatile uint32_t raw_overruns = 0;
+
+/* Invalidation of the sampler's latest asked by the sampling ISRs, done by the
+ * bottom half (the seqlock writer) once it reaches the raw entry at
+ * invalidate_head: samples captured before the error still go out first */
+static volatile uint32_t invalidate_requests = 0;
+static volatile uint32_t invalidate_head = 0;
+static uint32_t invalidate_done = 0;
+
+#if BOARD_FLASH_LOG_ENABLE
+static sensor_raw_t raw_capture[SENSOR_RAW_CAPTURE_SIZE];
+static volatile uint32_t raw_capture_head = 0;
+static volatile uint32_t raw_capture_tail = 0;
+static volatile bool raw_capture_enabled = false;
+#endif
+
+/* Filter stage, owned by the bottom half. The setter only writes the packed
+ * configuration word (single store), which the bottom half picks up */
+static volatile uint32_t filter_config = SENSOR_FILTER_CONFIG(SENSOR_FILTER_NONE, 0, 0);
+static uint32_t filter_applied = SENSOR_FILTER_CONFIG(SENSOR_FILTER_NONE, 0, 0);
+static sensor_filter_channel_t filter_pressure;
+static sensor_filter_channel_t filter_temperature;
+static uint32_t filter_count = 0;  /* Inputs since the filter was primed */
+static bool filter_primed = false;
+static uint8_t median_len = 0;     /* Applied median window, 0 = off */
+static uint8_t median_index = 0;   /* Next history slot */
+static bool median_primed = false;
+static int32_t median_pressure[SENSOR_MEDIAN_MAX];
+static int32_t median_temperature[SENSOR_MEDIAN_MAX];
+static sensor_iir_channel_t iir_pressure;
+static sensor_iir_channel_t iir_temperature;
+
+/* Sample quality (SENSOR_QUALITY_*), bottom half */
+static bool quality_clamped = false;   /* sensor_iir_input() clamped since the last output */
+static uint32_t quality_settle = 0;    /* Inputs left until the median and filter settle */
+static uint32_t quality_errors = 0;    /* error_stats.errors at the last output */
+
+/* Stale limit, single store from the main loop */
+static volatile uint32_t stale_limit_us = BOARD_SAMPLE_STALE_MS * 1000UL;
+
+/* Custom section: written by the main loop before it bumps the
+ * SENSOR_FILTER_CUSTOM_GEN field, copied by the bottom half on the change */
+static sensor_iir_coeffs_t iir_custom = { SENSOR_IIR_ONE, 0, 0, 0, 0 };
+
+/* Built-in sections (SENSOR_IIR_*), from tools/iir_coeffs.py --presets */
+static const sensor_iir_coeffs_t sensor_iir_presets[SENSOR_IIR_PRESETS] = {
+    { 314491699, 628983398, 314491699, 0, 184224972 },             /* Order 2, fc = fs / 4 */
+    { 104830566, 209661133, 104830566, -1012333500, 357913941 },   /* Order 2, fc = fs / 8 */
+    { 32163488, 64326975, 32163488, -1561482161, 616394288 },      /* Order 2, fc = fs / 16 */
+    { 9065273, 18130544, 9065273, -1850890572, 813409838 },        /* Order 2, fc = fs / 32 */
+    { 2417618, 4835238, 2417618, -1998621313, 934549963 },         /* Order 2, fc = fs / 64 */
+    { 624999, 1250000, 624999, -2072972867, 1001731041 },          /* Order 2, fc = fs / 128 */
+    { 536870912, 536870912, 0, 0, 0 },                             /* Order 1, fc = fs / 4 */
+    { 314491699, 314491699, 0, -444758426, 0 },                    /* Order 1, fc = fs / 8 */
+    { 178145237, 178145238, 0, -717451349, 0 },                    /* Order 1, fc = fs / 16 */
+    { 96272341, 96272341, 0, -881197142, 0 },                      /* Order 1, fc = fs / 32 */
+    { 50279481, 50279481, 0, -973182862, 0 },                      /* Order 1, fc = fs / 64 */
+    { 25727312, 25727312, 0, -1022287200, 0 },                     /* Order 1, fc = fs / 128 */
+};
+
+/* Temperature decimation: cycles in between reuse the sampler's cached temperature_adc */
+static volatile uint16_t temp_decimation = SENSOR_DEFAULT_TEMP_DECIMATION;
+
+/* Adaptive pressure OSR */
+static sensor_adaptive_osr_t adaptive = {0};
+static int32_t adaptive_last_pressure = 0;
+static uint16_t adaptive_quiet_count = 0;
+static uint32_t adaptive_rate_hz = 0;  /* Rate set by the controller, 0 = not adapted */
 
 /* ============================================================================
  * PRIVATE FUNCTIONS
  * ============================================================================ */
 
 /**
- * @brief Load calibration data from sensor PROM
+ * @brief OSR level the sampler and the sensor both have
  */
-static bool sensor_load_calibration(void)
+static bool sensor_osr_supported(sensor_osr_t osr)
 {
-    ms583730ba01_err_t result;
+    return (uint32_t)osr < SENSOR_OSR_COUNT && (uint32_t)osr < conv_sensor->osr_count;
+}
+
+/**
+ * @brief Transport of the sensor: I2C2, or the raw trace being replayed;
+ *        its completions get the sampler
+ */
+static ms583730ba01_h sensor_get_handle(sensor_sampler_t *s)
+{
+#if BOARD_FLASH_LOG_REPLAY
+    ms583730ba01_h handle = flash_log_replay_handle();
+#else
+    ms583730ba01_h handle = ms58_get_hal_handle(&s->dev, &hi2c2, BOARD_I2C2_SENSOR_ADDR);
+#endif
+    
+    handle.done_ctx = s;
+    return handle;
+}
+
+/**
+ * @brief Checksum word of a calibration cache record
+ */
+static uint32_t sensor_calib_cache_sum(const uint32_t *record)
+{
+    uint32_t sum = 0;
     
-    if (calibration_loaded) {
-        return true;  /* Already loaded */
+    for (uint32_t i = 0; i < SENSOR_CALIB_CACHE_WORDS - 1U; i++) {
+        sum += record[i];
     }
     
-    /* Reset sensor */
-    result = ms5837_reset(&sensor_handle);
-    if (result != E_MS58370BA01_SUCCESS) {
+    return ~sum;
+}
+
+/**
+ * @brief Get the PROM coefficients cached in data EEPROM
+ * 
+ * The cache is only used if the record is intact, its CRC-4 still matches
+ * and its C0 equals the sensor's C0 (identity word: catches a swapped probe).
+ * 
+ * @param identity C0 read from the sensor
+ * @param prom Receives C0..C6
+ * @return true if a valid cached copy was found
+ */
+static bool sensor_calib_cache_load(uint16_t identity, uint16_t *prom)
+{
+    uint32_t record[SENSOR_CALIB_CACHE_WORDS];
+    uint16_t cached[7];
+    
+    if (!eeprom_read_words(BOARD_EEPROM_SENSOR_CALIB_OFFSET, record, SENSOR_CALIB_CACHE_WORDS) ||
+        record[0] != SENSOR_CALIB_CACHE_MAGIC ||
+        record[SENSOR_CALIB_CACHE_WORDS - 1U] != sensor_calib_cache_sum(record)) {
         return false;
     }
     
-    /* Read calibration data from PROM */
-    result = ms5837_read_prom(&sensor_handle, calibration_data);
-    if (result != E_MS58370BA01_SUCCESS) {
+    for (uint32_t i = 0; i < 7U; i++) {
+        uint32_t word = record[1U + (i >> 1)];
+        cached[i] = (uint16_t)((i & 1U) ? (word >> 16) : word);
+    }
+    
+    if (cached[0] != identity || !ms5837_prom_crc_ok(cached)) {
         return false;
     }
     
-    calibration_loaded = true;
+    for (uint32_t i = 0; i < 7U; i++) {
+        prom[i] = cached[i];
+    }
     return true;
 }
 
-/* ============================================================================
- * PUBLIC FUNCTIONS
- * ============================================================================ */
+/**
+ * @brief Store validated PROM coefficients in data EEPROM
+ */
+static void sensor_calib_cache_store(const uint16_t *prom)
+{
+    uint32_t record[SENSOR_CALIB_CACHE_WORDS];
+    
+    record[0] = SENSOR_CALIB_CACHE_MAGIC;
+    for (uint32_t w = 0; w < 4U; w++) {
+        uint32_t hi = (2U * w + 1U < 7U) ? prom[2U * w + 1U] : 0U;
+        record[1U + w] = prom[2U * w] | (hi << 16);
+    }
+    record[SENSOR_CALIB_CACHE_WORDS - 1U] = sensor_calib_cache_sum(record);
+    
+    /* Unchanged words are skipped, so a warm boot with the same probe costs nothing */
+    (void)eeprom_write_async(BOARD_EEPROM_SENSOR_CALIB_OFFSET, record, SENSOR_CALIB_CACHE_WORDS);
+}
 
-bool sensor_sampling_init(void)
+/**
+ * @brief Tell the main loop it has work (new sample, status change, poll)
+ */
+static void sensor_notify(void)
 {
-    /* Get HAL handle for sensor */
-    sensor_handle = ms58_get_hal_handle();
+    sensor_sampling_event_cb_t callback = event_callback;
     
-    /* Load calibration data */
-    if (!sensor_load_calibration()) {
-        return false;
+    if (callback != NULL) {
+        callback();
+    }
+}
+
+/**
+ * @brief Abort the current cycle; the next tick recovers from ERROR
+ * 
+ * Past BOARD_SENSOR_BACKOFF_AFTER failures in a row the recovery waits,
+ * doubling each time: a sensor gone for good costs few bus transfers.
+ */
+static void sensor_fail(sensor_sampler_t *s)
+{
+    error_stats.errors++;
+    s->read_retries_left = BOARD_SENSOR_READ_RETRIES;
+    if (fail_streak < UINT32_MAX) {
+        fail_streak++;
+    }
+    if (fail_streak > BOARD_SENSOR_BACKOFF_AFTER) {
+        uint32_t shift = fail_streak - BOARD_SENSOR_BACKOFF_AFTER - 1U;
+        
+        backoff_ticks = (shift < 31U && (1UL << shift) < BOARD_SENSOR_BACKOFF_MAX_TICKS) ?
+                        (1UL << shift) : BOARD_SENSOR_BACKOFF_MAX_TICKS;
+        error_stats.backoffs++;
+    }
+    s->state = SENSOR_STATE_ERROR;
+    sensor_notify();  /* Status is no longer RUNNING */
+}
+
+/**
+ * @brief Completion never arrived: drop the transfer and recover the bus
+ * 
+ * Called from the tick, at I2C2 priority, so the completion cannot race it.
+ */
+static void sensor_transfer_timeout(sensor_sampler_t *s)
+{
+    error_stats.timeouts++;
+    ms58_hal_abort(&hi2c2);
+    bus_recovery_needed = true;
+    s->transfer_pending = false;
+    s->pending_ticks = 0;
+    sensor_fail(s);
+}
+
+#if BOARD_WARM_RESTART_ENABLE
+/**
+ * @brief Check word of the kept PROM words
+ */
+static uint16_t sensor_warm_prom_check(const uint16_t *prom)
+{
+    uint16_t sum = 0;
+    
+    for (uint32_t i = 0; i < 7U; i++) {
+        sum = (uint16_t)(sum + prom[i]);
+    }
+    return (uint16_t)~sum;
+}
+
+/**
+ * @brief Warm boot with the PROM words of the previous one intact
+ */
+static bool sensor_warm_valid(void)
+{
+    return warm_restart_is_warm() && sensor_warm.prom_check != 0U &&
+           sensor_warm.prom_check == sensor_warm_prom_check(sensor_warm.prom) &&
+           ms5837_prom_crc_ok(sensor_warm.prom);
+}
+#endif
+
+/**
+ * @brief Abort bring-up; the ERROR state retries from the reset
+ */
+static void sensor_bringup_failed(sensor_sampler_t *s)
+{
+    s->transfer_pending = false;
+    sensor_fail(s);
+}
+
+/**
+ * @brief Finish bring-up with the PROM words in s->prom_words
+ * 
+ * @param from_sensor true if the words were read from the sensor (cache
+ *                    must be refreshed), false if they came from the cache
+ */
+static void sensor_bringup_done(sensor_sampler_t *s, bool from_sensor)
+{
+    /* Keep the accuracy setting, which may be chosen before bring-up ends */
+    bool second_order = s->calibration.second_order;
+    
+    /* Shifted terms are computed once here instead of on every sample */
+    if (ms5837_calib_prepare(s->prom_words, &s->calibration) != E_MS58370BA01_SUCCESS) {
+        sensor_bringup_failed(s);
+        return;
     }
+    ms5837_calib_set_second_order(&s->calibration, second_order);
     
-    /* Initialize state */
-    sensor_state = SENSOR_STATE_IDLE;
-    latest_data.valid = false;
+    /* EEPROM writes take milliseconds: left to sensor_sampling_poll() */
+    if (from_sensor) {
+        calib_cache_store_pending = true;
+        sensor_notify();
+    }
     
-    return true;
+#if BOARD_WARM_RESTART_ENABLE
+    for (uint32_t i = 0; i < 7U; i++) {
+        sensor_warm.prom[i] = s->prom_words[i];
+    }
+    sensor_warm.prom_check = sensor_warm_prom_check(sensor_warm.prom);
+#endif
+    
+    s->calibration_loaded = true;
+    s->transfer_pending = false;
+    s->state = SENSOR_STATE_START_PRESSURE_CONV;
 }
 
-bool sensor_sampling_start(void)
+static void sensor_start_prom_read(sensor_sampler_t *s);
+
+/**
+ * @brief Completion of a PROM word transfer
+ * 
+ * Called from I2C2 interrupt context. Warm boot: C0 matches the EEPROM cache
+ * and bring-up ends after one word. Otherwise all words are read, chained
+ * from here, and CRC-4 checked.
+ */
+static void sensor_on_prom_received(void *ctx, ms583730ba01_err_t result)
 {
-    /* Reset state machine to start sampling */
-    sensor_state = SENSOR_STATE_START_PRESSURE_CONV;
-    wait_counter = 0;
+    sensor_sampler_t *s = (sensor_sampler_t *)ctx;
     
-    return true;
+    if (result != E_MS58370BA01_SUCCESS) {
+        sensor_bringup_failed(s);
+        return;
+    }
+    
+    s->prom_words[s->prom_index] = (uint16_t)((s->prom_bytes[0] << 8) | s->prom_bytes[1]);
+    
+    if (s->prom_index == 0 && sensor_calib_cache_load(s->prom_words[0], s->prom_words)) {
+        sensor_bringup_done(s, false);
+        return;
+    }
+    
+    if (++s->prom_index < 7U) {
+        sensor_start_prom_read(s);
+        return;
+    }
+    
+    /* Corrupted coefficients are rejected: retry from reset */
+    if (!ms5837_prom_crc_ok(s->prom_words)) {
+        sensor_bringup_failed(s);
+        return;
+    }
+    
+    sensor_bringup_done(s, true);
 }
 
-bool sensor_sampling_stop(void)
+/**
+ * @brief Start reading PROM word s->prom_index
+ */
+static void sensor_start_prom_read(sensor_sampler_t *s)
 {
-    sensor_state = SENSOR_STATE_IDLE;
-    return true;
+    s->transfer_pending = true;
+    if (ms5837_read_prom_async(&s->handle, s->prom_index, s->prom_bytes,
+                               sensor_on_prom_received) != E_MS58370BA01_SUCCESS) {
+        sensor_bringup_failed(s);
+    }
 }
 
-bool sensor_sampling_get_data(sensor_data_t *data)
+/**
+ * @brief Completion of the reset command
+ * 
+ * Called from I2C2 interrupt context.
+ */
+static void sensor_on_reset_sent(void *ctx, ms583730ba01_err_t result)
 {
-    if (data == NULL) {
-        return false;
+    sensor_sampler_t *s = (sensor_sampler_t *)ctx;
+    
+    s->transfer_pending = false;
+    
+    if (result != E_MS58370BA01_SUCCESS) {
+        sensor_fail(s);
+        return;
     }
     
-    if (latest_data.valid) {
-        *data = latest_data;
-        return true;
+    s->wait_counter = SENSOR_RESET_TICKS;
+    s->state = SENSOR_STATE_WAIT_RESET;
+}
+
+/**
+ * @brief Completion of the early reset command
+ * 
+ * Called from I2C2 interrupt context.
+ */
+static void sensor_on_early_reset_sent(void *ctx, ms583730ba01_err_t result)
+{
+    sensor_sampler_t *s = (sensor_sampler_t *)ctx;
+    
+    s->transfer_pending = false;
+    early_reset = (result == E_MS58370BA01_SUCCESS) ? SENSOR_EARLY_RESET_DONE
+                                                    : SENSOR_EARLY_RESET_NONE;
+}
+
+/**
+ * @brief Send the reset command (first bring-up step)
+ */
+static void sensor_start_reset(sensor_sampler_t *s)
+{
+    s->transfer_pending = true;
+    if (ms5837_reset_async(&s->handle, sensor_on_reset_sent) != E_MS58370BA01_SUCCESS) {
+        sensor_bringup_failed(s);
+    }
+}
+
+/**
+ * @brief Publish a new sample to the sampler's latest and the ring
+ * 
+ * Producer side, called from the PendSV bottom half only. When the ring is
+ * full the new sample is dropped and counted (the consumer owns ring_tail).
+ */
+static void sensor_publish(const sensor_data_t *sample)
+{
+    sensor_sampler_t *s = &sampler;
+    uint32_t head = ring_head;
+    sensor_sampling_publish_cb_t published = publish_callback;
+    
+    hal_seq_write_begin(&s->latest_seq);
+    s->latest = *sample;
+    hal_seq_write_end(&s->latest_seq);
+    
+    if (published != NULL) {
+        published(sample);
     }
     
-    return false;
+    if (head - ring_tail >= SENSOR_RING_SIZE) {
+        ring_overruns++;
+        sensor_notify();  /* The latest sample still changed */
+        return;
+    }
+    
+    ring[head & SENSOR_RING_MASK] = *sample;
+    __DMB();  /* Entry must be complete before the consumer can see it */
+    ring_head = head + 1U;
+    
+    sensor_notify();
 }
 
-void sensor_sampling_timer_isr(void)
+static void sensor_jitter_publish(void)
 {
-    ms583730ba01_err_t result;
+    hal_seq_write_begin(&jitter_seq);
+    jitter_shown.intervals = jitter_intervals;
+    jitter_shown.min_us = jitter_min_us;
+    jitter_shown.max_us = jitter_max_us;
+    jitter_shown.mean_us = (uint32_t)((jitter_mean_q8 + 128) >> 8);
+    jitter_shown.peak_us = jitter_peak_us;
+    jitter_shown_var_q16 = (uint64_t)jitter_var_q16;
+    hal_seq_write_end(&jitter_seq);
+}
+
+/**
+ * @brief Fold the interval since the last conversion start into the
+ *        jitter statistics (bottom half)
+ * 
+ * Deviations are held to +-2^15 us for the variance, so its square stays
+ * well inside 64 bits; min, max and peak keep the full value.
+ */
+static void sensor_jitter_update(uint32_t timestamp_us, uint32_t sequence)
+{
+    uint32_t gen = jitter_reset_gen;
+    uint32_t interval;
+    int64_t d_q8;
+    uint32_t peak;
     
-    /* State machine for sensor reading */
-    // switch method could be further replaced and optimised for performace improvements
-    switch (sensor_state) {
-        case SENSOR_STATE_IDLE:
-            /* Do nothing, waiting for start */
-            break;
-            
-        case SENSOR_STATE_START_PRESSURE_CONV:
-            /* Start pressure conversion */
-            result = ms5837_start_conversion(&sensor_handle, SENSOR_OSR_D1);
-            if (result == E_MS58370BA01_SUCCESS) {
-                sensor_state = SENSOR_STATE_WAIT_PRESSURE_CONV;
-                wait_counter = SENSOR_DELAY_D1_INTERRUPTS;  /* Wait 1 interrupt (2ms) */
-            } else {
-                sensor_state = SENSOR_STATE_ERROR;
-            }
-            break;
-            
-        case SENSOR_STATE_WAIT_PRESSURE_CONV:
-            /* Wait for pressure conversion to complete */
-            if (wait_counter > 0) {
-                wait_counter--;
-            }
-            if (wait_counter == 0) {
-                sensor_state = SENSOR_STATE_READ_PRESSURE_ADC;
-            }
-            break;
-            
-        case SENSOR_STATE_READ_PRESSURE_ADC:
-            /* Read pressure ADC value */
-            result = ms5837_read_adc(&sensor_handle, &pressure_adc);
-            if (result == E_MS58370BA01_SUCCESS) {
-                sensor_state = SENSOR_STATE_START_TEMP_CONV;
-            } else {
-                sensor_state = SENSOR_STATE_ERROR;
-            }
-            break;
-            
-        case SENSOR_STATE_START_TEMP_CONV:
-            /* Start temperature conversion */
-            result = ms5837_start_conversion(&sensor_handle, SENSOR_OSR_D2);
-            if (result == E_MS58370BA01_SUCCESS) {
-                sensor_state = SENSOR_STATE_WAIT_TEMP_CONV;
-                wait_counter = SENSOR_DELAY_D2_INTERRUPTS;  /* Wait 1 interrupt (2ms) */
-            } else {
-                sensor_state = SENSOR_STATE_ERROR;
-            }
-            break;
-            
-        case SENSOR_STATE_WAIT_TEMP_CONV:
-            /* Wait for temperature conversion to complete */
-            if (wait_counter > 0) {
-                wait_counter--;
-            }
-            if (wait_counter == 0) {
-                sensor_state = SENSOR_STATE_READ_TEMP_ADC;
-            }
-            break;
-            
-        case SENSOR_STATE_READ_TEMP_ADC:
-            /* Read temperature ADC value */
-            result = ms5837_read_adc(&sensor_handle, &temperature_adc);
-            if (result == E_MS58370BA01_SUCCESS) {
-                sensor_state = SENSOR_STATE_CALCULATE;
-            } else {
-                sensor_state = SENSOR_STATE_ERROR;
-            }
-            break;
-            
-        case SENSOR_STATE_CALCULATE:
-            /* Calculate pressure and temperature from ADC values */
-            result = ms5837_calculate_pressure_temperature(
-                calibration_data,
-                pressure_adc,
-                temperature_adc,
-                &latest_data.pressure,
-                &latest_data.temperature
-            );
-            
-            if (result == E_MS58370BA01_SUCCESS) {
-                latest_data.valid = true;
-                /* Start next sampling cycle */
-                sensor_state = SENSOR_STATE_START_PRESSURE_CONV;
-            } else {
-                sensor_state = SENSOR_STATE_ERROR;
-            }
-            break;
-            
-        case SENSOR_STATE_ERROR:
-            /* Error state - try to recover by resetting */
-            latest_data.valid = false;
-            /* Wait a few cycles before retrying */
-            /* Overflow protection: Prevent wait_counter from wrapping */
-            if (wait_counter < UINT32_MAX) {
-                wait_counter++;
-            }
-            if (wait_counter > 10) {
-                wait_counter = 0;
-                sensor_state = SENSOR_STATE_START_PRESSURE_CONV;
-            }
-            break;
+    if (gen != jitter_reset_applied) {
+        jitter_reset_applied = gen;
+        jitter_have_last = false;
+        jitter_intervals = 0;
+        jitter_min_us = 0;
+        jitter_max_us = 0;
+        jitter_peak_us = 0;
+        jitter_mean_q8 = 0;
+        jitter_var_q16 = 0;
+        sensor_jitter_publish();
+    }
+    
+    interval = timestamp_us - jitter_last_us;
+    if (!jitter_have_last || sequence != jitter_last_seq + 1U) {
+        jitter_have_last = true;
+        jitter_last_us = timestamp_us;
+        jitter_last_seq = sequence;
+        return;
+    }
+    jitter_last_us = timestamp_us;
+    jitter_last_seq = sequence;
+    
+    if (jitter_intervals == 0U) {
+        jitter_min_us = interval;
+        jitter_max_us = interval;
+        jitter_peak_us = 0;
+        jitter_mean_q8 = (int64_t)interval << 8;
+        jitter_var_q16 = 0;
+    } else if (interval < jitter_min_us) {
+        jitter_min_us = interval;
+    } else if (interval > jitter_max_us) {
+        jitter_max_us = interval;
+    }
+    if (jitter_intervals != UINT32_MAX) {
+        jitter_intervals++;
+    }
+    
+    d_q8 = ((int64_t)interval << 8) - jitter_mean_q8;
+    peak = (uint32_t)(((d_q8 < 0) ? -d_q8 : d_q8) >> 8);
+    if (peak > jitter_peak_us) {
+        jitter_peak_us = peak;
+    }
+    LATENCY_ADD(LATENCY_STAGE_JITTER, peak);
+    
+    jitter_mean_q8 += d_q8 >> 6;
+    if (d_q8 > (1LL << 23)) {
+        d_q8 = 1LL << 23;
+    } else if (d_q8 < -(1LL << 23)) {
+        d_q8 = -(1LL << 23);
+    }
+    jitter_var_q16 += (fixmath_smull((int32_t)d_q8, (int32_t)d_q8) - jitter_var_q16) >> 6;
+    
+    sensor_jitter_publish();
+}
+
+/**
+ * @brief Switch the tick rate for the activity controller
+ */
+static void sensor_adapt_rate(uint32_t rate_hz)
+{
+    if (sensor_sampling_set_rate_hz(rate_hz)) {
+        adaptive_rate_hz = rate_hz;
+    }
+}
+
+/**
+ * @brief Adapt pressure OSR and tick rate to signal activity
+ * 
+ * A change larger than the threshold drops straight to the fast OSR and
+ * rate; each run of settle_samples quiet samples steps one OSR up towards
+ * quiet_osr, then halves the rate towards quiet_rate_hz.
+ */
+static void sensor_adapt_osr(int32_t pressure)
+{
+    int32_t delta = pressure - adaptive_last_pressure;
+    bool osr_left = osr_d1 < adaptive.quiet_osr;
+    bool rate_left = adaptive_rate_hz > adaptive.quiet_rate_hz;
+    
+    adaptive_last_pressure = pressure;
+    
+    if (delta < 0) {
+        delta = -delta;
+    }
+    
+    if (delta > adaptive.threshold) {
+        osr_d1 = adaptive.fast_osr;
+        adaptive_quiet_count = 0;
+        if (adaptive_rate_hz != adaptive.fast_rate_hz) {
+            sensor_adapt_rate(adaptive.fast_rate_hz);
+        }
+    } else if ((osr_left || rate_left) &&
+               ++adaptive_quiet_count >= adaptive.settle_samples) {
+        adaptive_quiet_count = 0;
+        if (osr_left) {
+            osr_d1 = (sensor_osr_t)(osr_d1 + 1);
+        } else {
+            uint32_t rate = adaptive_rate_hz >> 1;
             
-        default:
-            sensor_state = SENSOR_STATE_IDLE;
-            break;
+            sensor_adapt_rate((rate > adaptive.quiet_rate_hz) ? rate : adaptive.quiet_rate_hz);
+        }
+    }
+}
+
+/**
+ * @brief Hand the captured ADC pair to the bottom half
+ * 
+ * Runs in TIM2/I2C2 interrupt context: only copies the raw words into the
+ * capture ring and pends PendSV, so compensation never delays the next
+ * bus step. When the ring is full the pair is dropped and counted.
+ * 
+ */
+static void sensor_bottom_half_pend(void)
+{
+#if BOARD_RTOS_ENABLE
+    rtos_sampler_notify();
+#else
+    hal_pendsv_trigger();
+#endif
+}
+
+static void sensor_capture(sensor_sampler_t *s)
+{
+    uint32_t head = raw_head;
+    sensor_raw_t *raw;
+    
+    fail_streak = 0;
+    
+    if (head - raw_tail >= SENSOR_RAW_RING_SIZE) {
+        raw_overruns++;
+        s->sequence++;  /* Keep the gap visible to ring consumers */
+        SENSOR_WARM_KEEP_SEQUENCE(s);
+        return;
+    }
+    
+    raw = &raw_ring[head & SENSOR_RAW_RING_MASK];
+    raw->pressure_adc = s->pressure_adc;
+    raw->temperature_adc = s->temperature_adc;
+    raw->timestamp_us = s->pressure_timestamp_us;
+    raw->sequence = s->sequence++;
+    SENSOR_WARM_KEEP_SEQUENCE(s);
+    __DMB();  /* Entry must be complete before the bottom half can see it */
+    raw_head = head + 1U;
+    
+    sensor_bottom_half_pend();
+}
+
+/**
+ * @brief Have the bottom half mark the latest sample invalid (sampling ISRs)
+ *
+ * After the raw entries already queued, through the same seqlock as every
+ * publish: a reader never copies a half-written sample.
+ */
+static void sensor_invalidate(void)
+{
+    if (invalidate_requests != invalidate_done && invalidate_head == raw_head) {
+        return;  /* Asked already at this point of the ring */
+    }
+    invalidate_head = raw_head;
+    invalidate_requests++;
+    sensor_bottom_half_pend();
+}
+
+/**
+ * @brief Fill a filter channel with one value (no start-up transient)
+ */
+static void sensor_filter_prime(sensor_filter_channel_t *ch, int32_t value)
+{
+    uint32_t len = 1UL << ch->log2;
+    
+    for (uint32_t i = 0; i < len; i++) {
+        ch->history[i] = value;
+    }
+    ch->sum = (int64_t)value << ch->log2;
+}
+
+/**
+ * @brief Push one input into a filter channel
+ * 
+ * @return Mean of the last 2^log2 inputs, rounded to nearest
+ */
+static int32_t sensor_filter_push(sensor_filter_channel_t *ch, uint32_t index, int32_t value)
+{
+    int32_t *slot = &ch->history[index & ((1UL << ch->log2) - 1U)];
+    
+    ch->sum += (int64_t)value - *slot;
+    *slot = value;
+    
+    if (ch->log2 == 0) {
+        return value;
+    }
+    /* log2 is not a constant: fixmath_asr64() instead of __aeabi_lasr */
+    return (int32_t)fixmath_asr64(ch->sum + (int64_t)(1UL << (ch->log2 - 1U)), ch->log2);
+}
+
+/**
+ * @brief Median of a 3- or 5-entry history (order of the entries is free)
+ */
+static int32_t sensor_median_of(const int32_t *history, uint8_t len)
+{
+    int32_t p0 = history[0];
+    int32_t p1 = history[1];
+    int32_t p2 = history[2];
+    int32_t p3;
+    int32_t p4;
+    
+    if (len == 3U) {
+        SENSOR_SORT2(p0, p1);
+        SENSOR_SORT2(p1, p2);
+        SENSOR_SORT2(p0, p1);
+        return p1;
+    }
+    
+    /* Seven exchanges leave the middle value in p2 */
+    p3 = history[3];
+    p4 = history[4];
+    SENSOR_SORT2(p0, p1);
+    SENSOR_SORT2(p3, p4);
+    SENSOR_SORT2(p0, p3);
+    SENSOR_SORT2(p1, p4);
+    SENSOR_SORT2(p1, p2);
+    SENSOR_SORT2(p2, p3);
+    SENSOR_SORT2(p1, p2);
+    return p2;
+}
+
+/**
+ * @brief Flag the next inputs SENSOR_QUALITY_WARMUP after a stage restarts
+ */
+static void sensor_quality_settle(uint32_t inputs)
+{
+    if (inputs > quality_settle) {
+        quality_settle = inputs;
+    }
+}
+
+/**
+ * @brief Add the quality bits known after the filter stage
+ * 
+ * Bottom half, once per filter input: a clamp anywhere in a decimation
+ * block marks its output, and so do the cycles aborted since the last
+ * output.
+ * 
+ * @param sample Filter output
+ * @param published true if it is about to be published
+ */
+static void sensor_quality_update(sensor_data_t *sample, bool published)
+{
+    uint32_t errors = error_stats.errors;
+    
+    if (quality_settle != 0U) {
+        quality_settle--;
+        sample->quality |= SENSOR_QUALITY_WARMUP;
+    }
+    if (!published) {
+        return;
+    }
+    if (quality_clamped) {
+        quality_clamped = false;
+        sample->quality |= SENSOR_QUALITY_CLAMPED;
+    }
+    if (errors != quality_errors) {
+        quality_errors = errors;
+        sample->quality |= SENSOR_QUALITY_RETRIED;
+    }
+    sample->error_count = (uint16_t)errors;
+}
+
+/**
+ * @brief Replace a compensated sample by the median of the last values
+ * 
+ * Bottom half only, ahead of adaptive OSR and the filter stage.
+ */
+static void sensor_median(sensor_data_t *sample)
+{
+    uint8_t len = (uint8_t)((filter_config & SENSOR_FILTER_MEDIAN) >> SENSOR_FILTER_MEDIAN_SHIFT);
+    
+    if (len != median_len) {
+        median_len = len;
+        median_primed = false;
+    }
+    if (median_len < 3U) {
+        return;
+    }
+    
+    if (!median_primed) {
+        for (uint32_t i = 0; i < SENSOR_MEDIAN_MAX; i++) {
+            median_pressure[i] = sample->pressure;
+            median_temperature[i] = sample->temperature;
+        }
+        median_index = 0;
+        median_primed = true;
+        sensor_quality_settle(median_len);
+    }
+    
+    median_pressure[median_index] = sample->pressure;
+    median_temperature[median_index] = sample->temperature;
+    if (++median_index >= median_len) {
+        median_index = 0;
+    }
+    
+    sample->pressure = sensor_median_of(median_pressure, median_len);
+    sample->temperature = sensor_median_of(median_temperature, median_len);
+}
+
+/**
+ * @brief Load an IIR section into a channel
+ */
+static void sensor_iir_select(sensor_iir_channel_t *ch, uint8_t section)
+{
+    ch->coeffs = (section < SENSOR_IIR_PRESETS) ? sensor_iir_presets[section] : iir_custom;
+}
+
+static int32_t sensor_iir_input(int32_t value)
+{
+    if (value > SENSOR_IIR_INPUT_MAX) {
+        value = SENSOR_IIR_INPUT_MAX;
+        quality_clamped = true;
+    } else if (value < -SENSOR_IIR_INPUT_MAX) {
+        value = -SENSOR_IIR_INPUT_MAX;
+        quality_clamped = true;
+    }
+    return value * 256;
+}
+
+/**
+ * @brief Settle an IIR channel on one value (no start-up transient: the
+ *        sections have unity DC gain)
+ */
+static void sensor_iir_prime(sensor_iir_channel_t *ch, int32_t value)
+{
+    int32_t x = sensor_iir_input(value);
+    
+    ch->x1 = x;
+    ch->x2 = x;
+    ch->y1 = x;
+    ch->y2 = x;
+}
+
+/**
+ * @brief Push one input through an IIR channel
+ * 
+ * Coefficients are Q2.30 and the state Q8: the products sum to Q38 in 64
+ * bits (|b| <= 1 and a stable section bound them below 2^63).
+ * 
+ * @return Output, rounded to nearest and saturated
+ */
+static int32_t sensor_iir_push(sensor_iir_channel_t *ch, int32_t value)
+{
+    const sensor_iir_coeffs_t *c = &ch->coeffs;
+    int32_t x = sensor_iir_input(value);
+    int64_t acc;
+    int64_t y;
+    PROF_BEGIN(PROF_SITE_IIR);
+    
+    acc = fixmath_smull(c->b0, x);
+    acc = fixmath_smlal(acc, c->b1, ch->x1);
+    acc = fixmath_smlal(acc, c->b2, ch->x2);
+    acc = fixmath_smlsl(acc, c->a1, ch->y1);
+    acc = fixmath_smlsl(acc, c->a2, ch->y2);
+    y = (acc + (1LL << 29)) >> 30;
+    if (y > INT32_MAX) {
+        y = INT32_MAX;
+    } else if (y < INT32_MIN) {
+        y = INT32_MIN;
+    }
+    
+    ch->x2 = ch->x1;
+    ch->x1 = x;
+    ch->y2 = ch->y1;
+    ch->y1 = (int32_t)y;
+    PROF_END(PROF_SITE_IIR);
+    return (int32_t)((y + 128) >> 8);
+}
+
+/**
+ * @brief Run the filter stage on a compensated sample
+ * 
+ * Bottom half only.
+ * 
+ * @param sample Compensated sample, replaced by the filter output
+ * @return true if the sample is to be published
+ */
+static bool sensor_filter(sensor_data_t *sample)
+{
+    uint32_t config = filter_config;
+    sensor_filter_mode_t mode = (sensor_filter_mode_t)(config & 0xFFU);
+    
+    if (config != filter_applied) {
+        filter_applied = config;
+        if (mode == SENSOR_FILTER_IIR) {
+            sensor_iir_select(&iir_pressure, (uint8_t)(config >> 8));
+            sensor_iir_select(&iir_temperature, (uint8_t)(config >> 16));
+        } else {
+            filter_pressure.log2 = (uint8_t)(config >> 8);
+            filter_temperature.log2 = (uint8_t)(config >> 16);
+        }
+        filter_primed = false;
+    }
+    
+    if (mode == SENSOR_FILTER_NONE) {
+        return true;
+    }
+    
+    if (mode == SENSOR_FILTER_IIR) {
+        if (!filter_primed) {
+            sensor_iir_prime(&iir_pressure, sample->pressure);
+            sensor_iir_prime(&iir_temperature, sample->temperature);
+            filter_primed = true;
+            sensor_quality_settle(SENSOR_QUALITY_IIR_SETTLE);
+        }
+        sample->pressure = sensor_iir_push(&iir_pressure, sample->pressure);
+        sample->temperature = sensor_iir_push(&iir_temperature, sample->temperature);
+        return true;
+    }
+    
+    if (!filter_primed) {
+        sensor_filter_prime(&filter_pressure, sample->pressure);
+        sensor_filter_prime(&filter_temperature, sample->temperature);
+        filter_count = 0;
+        filter_primed = true;
+        sensor_quality_settle(1UL << filter_pressure.log2);
+    }
+    
+    sample->pressure = sensor_filter_push(&filter_pressure, filter_count, sample->pressure);
+    sample->temperature = sensor_filter_push(&filter_temperature, filter_count, sample->temperature);
+    filter_count++;
+    
+    if (mode == SENSOR_FILTER_DECIMATE) {
+        /* Block boundary: every input of the block is in the sum */
+        return (filter_count & ((1UL << filter_pressure.log2) - 1U)) == 0U;
+    }
+    return true;
+}
+
+/**
+ * @brief Decide whether this cycle needs a temperature conversion
+ * 
+ * @return true to convert D2, false to reuse the cached s->temperature_adc
+ */
+static bool sensor_temperature_due(sensor_sampler_t *s)
+{
+    if (!s->temperature_adc_valid || s->temp_skip_count + 1U >= temp_decimation) {
+        s->temp_skip_count = 0;
+        return true;
+    }
+    
+    s->temp_skip_count++;
+    return false;
+}
+
+static void sensor_start_conversion(sensor_sampler_t *s, bool pressure);
+static void sensor_start_adc_read(sensor_sampler_t *s);
+
+/**
+ * @brief Repeat an ADC read the sensor NACKed, from its completion
+ * 
+ * A NACK with the bus intact is the sensor missing one transfer: the
+ * result stays until it is read, so reading again costs a transfer and
+ * not the cycle. Bus faults go to the recovery instead.
+ * 
+ * @return true if the read was started again
+ */
+static bool sensor_retry_read(sensor_sampler_t *s)
+{
+    if (s->read_retries_left == 0U || !hal_i2c2_nacked()) {
+        return false;
+    }
+    s->read_retries_left--;
+    error_stats.read_retries++;
+    sensor_start_adc_read(s);
+    return true;
+}
+
+/**
+ * @brief A conversion read too early: past BOARD_SENSOR_LATE_WIDEN_AFTER
+ *        of them, its OSR waits the datasheet time from the next one on
+ */
+static void sensor_conv_late(sensor_osr_t osr)
+{
+    uint16_t datasheet_us = conv_sensor->conv_time_us[osr];
+    
+    if (osr_conv_us[osr] >= datasheet_us ||
+        ++osr_late_reads[osr] < BOARD_SENSOR_LATE_WIDEN_AFTER) {
+        return;
+    }
+    osr_conv_us[osr] = datasheet_us;
+    osr_delay_ticks[osr] = (uint8_t)SENSOR_TICKS(datasheet_us);
+    error_stats.conv_widened++;
+}
+
+/**
+ * @brief Read the ADC once more after a read of 0, from its completion
+ * 
+ * The sensor answers 0 while the conversion runs, so the read came
+ * early: the calibrated time was too short for this conversion, or the
+ * part is slower than its datasheet. The wait is a quarter of the
+ * datasheet time, timed as the conversion was (compare or ticks).
+ * 
+ * @return true if the read was rescheduled
+ */
+static bool sensor_retry_late(sensor_sampler_t *s)
+{
+    uint32_t wait_us = (conv_sensor->conv_time_us[s->conv_osr] + 3U) / 4U;
+    bool pressure = (s->state == SENSOR_STATE_READ_PRESSURE_ADC);
+    
+    sensor_conv_late(s->conv_osr);
+    if (!s->late_retry_left) {
+        return false;
+    }
+    s->late_retry_left = false;
+    error_stats.late_reads++;
+    s->state = pressure ? SENSOR_STATE_WAIT_PRESSURE_CONV : SENSOR_STATE_WAIT_TEMP_CONV;
+    
+    if (sampling_mode == SENSOR_MODE_EXACT) {
+        if (!hal_tim2_schedule_us(wait_us)) {
+            return false;
+        }
+        s->compare_armed = true;
+        CLOCK_SCALE_IDLE();
+        return true;
+    }
+    s->compare_armed = false;
+    s->wait_counter = SENSOR_TICKS(wait_us);
+    return true;
+}
+
+/**
+ * @brief State after a sample was captured
+ */
+static sensor_state_t sensor_cycle_end_state(sensor_sampler_t *s)
+{
+    return s->single_shot ? SENSOR_STATE_IDLE : SENSOR_STATE_START_PRESSURE_CONV;
+}
+
+/**
+ * @brief Completion of a conversion start command
+ * 
+ * Called from I2C2 interrupt context.
+ */
+static void sensor_on_conversion_started(void *ctx, ms583730ba01_err_t result)
+{
+    sensor_sampler_t *s = (sensor_sampler_t *)ctx;
+    
+    s->transfer_pending = false;
+    if (s->state == SENSOR_STATE_IDLE) {
+        return;  /* Stopped meanwhile: the cycle ends with this transfer */
+    }
+    
+    if (result != E_MS58370BA01_SUCCESS) {
+        sensor_fail(s);
+        return;
+    }
+    
+    bool pressure = (s->state == SENSOR_STATE_START_PRESSURE_CONV);
+    
+    /* Conversion starts when the command is acknowledged: stamp it now */
+    if (pressure) {
+        s->pressure_timestamp_us = hal_tim2_get_timestamp_us();
+        if (sync_external) {
+            LATENCY_ADD(LATENCY_STAGE_SYNC_IN, s->pressure_timestamp_us - sync_edge_us);
+        }
+    }
+    
+    if (sampling_mode == SENSOR_MODE_EXACT) {
+        /* Conversion runs from the end of the command: wake exactly when done */
+        s->state = pressure ? SENSOR_STATE_WAIT_PRESSURE_CONV : SENSOR_STATE_WAIT_TEMP_CONV;
+        if (!hal_tim2_schedule_us(osr_conv_us[s->conv_osr])) {
+            sensor_fail(s);
+            return;
+        }
+        s->compare_armed = true;
+        CLOCK_SCALE_IDLE();  /* Back at the compare (TIM2 interrupt) */
+        return;
+    }
+    
+    s->compare_armed = false;
+    if (sampling_mode == SENSOR_MODE_PIPELINED) {
+        /* The conversion started inside a tick, so the next tick already
+         * counts as the first one of the delay: skip WAIT when it is 1 */
+        s->wait_counter = osr_delay_ticks[s->conv_osr] - 1U;
+        if (s->wait_counter == 0) {
+            s->state = pressure ? SENSOR_STATE_READ_PRESSURE_ADC : SENSOR_STATE_READ_TEMP_ADC;
+            return;
+        }
+    } else {
+        s->wait_counter = osr_delay_ticks[s->conv_osr];
+    }
+    
+    s->state = pressure ? SENSOR_STATE_WAIT_PRESSURE_CONV : SENSOR_STATE_WAIT_TEMP_CONV;
+}
+
+/**
+ * @brief Completion of the ADC result bytes transfer
+ * 
+ * Called from I2C2 interrupt context.
+ */
+static void sensor_on_adc_received(void *ctx, ms583730ba01_err_t result)
+{
+    sensor_sampler_t *s = (sensor_sampler_t *)ctx;
+    uint32_t adc;
+    
+    s->transfer_pending = false;
+    if (s->state == SENSOR_STATE_IDLE) {
+        return;  /* Stopped meanwhile */
+    }
+    
+    if (result != E_MS58370BA01_SUCCESS) {
+        if (!sensor_retry_read(s)) {
+            sensor_fail(s);
+        }
+        return;
+    }
+    
+    /* 0 is no result: the conversion is still running, or a repeated read
+     * came after the sensor did give it. Never published as a sample */
+    adc = conv_sensor->decode(s->adc_bytes);
+    if (adc == 0U) {
+        if (!sensor_retry_late(s)) {
+            sensor_fail(s);
+        }
+        return;
+    }
+    s->read_retries_left = BOARD_SENSOR_READ_RETRIES;
+    
+    if (s->state == SENSOR_STATE_READ_PRESSURE_ADC) {
+        s->pressure_adc = adc;
+        /* Pressure-only cycle goes straight to CALCULATE with the cached D2 */
+        s->state = sensor_temperature_due(s) ? SENSOR_STATE_START_TEMP_CONV
+                                                : SENSOR_STATE_CALCULATE;
+    } else {
+        s->temperature_adc = adc;
+        s->temperature_adc_valid = true;
+        s->state = SENSOR_STATE_CALCULATE;
+    }
+    
+    if (sampling_mode == SENSOR_MODE_SEQUENTIAL) {
+        return;  /* Next tick performs the next step */
+    }
+    
+    /* Pipelined / exact: fold the next step into this completion */
+    if (s->state == SENSOR_STATE_START_TEMP_CONV) {
+        sensor_start_conversion(s, false);
+    } else {
+        sensor_capture(s);
+        s->state = sensor_cycle_end_state(s);
+        if (sampling_mode == SENSOR_MODE_PIPELINED &&
+            s->state == SENSOR_STATE_START_PRESSURE_CONV) {
+            sensor_start_conversion(s, true);
+        }
+        /* Exact mode: the next tick starts the next cycle */
+    }
+}
+
+/**
+ * @brief Completion of the ADC read command
+ * 
+ * Called from I2C2 interrupt context. Chains the result bytes read.
+ */
+static void sensor_on_adc_requested(void *ctx, ms583730ba01_err_t result)
+{
+    sensor_sampler_t *s = (sensor_sampler_t *)ctx;
+    
+    if (result == E_MS58370BA01_SUCCESS) {
+        result = conv_sensor->fetch(&s->handle, s->adc_bytes, sensor_on_adc_received);
+    }
+    
+    if (result != E_MS58370BA01_SUCCESS) {
+        s->transfer_pending = false;
+        if (!sensor_retry_read(s)) {
+            sensor_fail(s);
+        }
+    }
+}
+
+/**
+ * @brief Start the conversion command for the current state
+ * 
+ * @param pressure true for D1 (pressure), false for D2 (temperature)
+ */
+static void sensor_start_conversion(sensor_sampler_t *s, bool pressure)
+{
+    /* Latch the OSR so profile changes only apply to the next conversion */
+    s->conv_osr = pressure ? osr_d1 : osr_d2;
+    s->late_retry_left = true;
+    
+    s->transfer_pending = true;
+    if (conv_sensor->start(&s->handle, pressure, (uint8_t)s->conv_osr,
+                           sensor_on_conversion_started) != E_MS58370BA01_SUCCESS) {
+        s->transfer_pending = false;
+        sensor_fail(s);
+    }
+}
+
+/**
+ * @brief Start the ADC read for the current state
+ */
+static void sensor_start_adc_read(sensor_sampler_t *s)
+{
+    ms583730ba01_err_t result;
+    
+    s->transfer_pending = true;
+    result = (conv_sensor->request != NULL)
+             ? conv_sensor->request(&s->handle, sensor_on_adc_requested)
+             : conv_sensor->fetch(&s->handle, s->adc_bytes, sensor_on_adc_received);
+    if (result != E_MS58370BA01_SUCCESS) {
+        s->transfer_pending = false;
+        sensor_fail(s);
+    }
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+bool sensor_sampling_reset_early(void)
+{
+    sensor_sampler_t *s = &sampler;
+    
+#if BOARD_WARM_RESTART_ENABLE
+    if (sensor_warm_valid()) {
+        return true;  /* Warm boot: the sensor still has its PROM loaded */
+    }
+#endif
+    
+    s->handle = sensor_get_handle(s);
+    if (s->handle.write_cmd == NULL || s->transfer_pending) {
+        return false;
+    }
+    
+    early_reset_us = board_get_uptime_us();
+    early_reset = SENSOR_EARLY_RESET_SENT;
+    s->transfer_pending = true;
+    if (ms5837_reset_async(&s->handle, sensor_on_early_reset_sent) != E_MS58370BA01_SUCCESS) {
+        s->transfer_pending = false;
+        early_reset = SENSOR_EARLY_RESET_NONE;
+        return false;
+    }
+    
+    return true;
+}
+
+bool sensor_sampling_init(void)
+{
+    sensor_sampler_t *s = &sampler;
+    
+    /* Get HAL handle for sensor */
+    s->handle = sensor_get_handle(s);
+    if (s->handle.write_cmd == NULL) {
+        return false;
+    }
+    
+    if (conv_sensor->result_bytes > CONV_SENSOR_MAX_RESULT_BYTES) {
+        return false;
+    }
+    for (uint32_t i = 0; i < SENSOR_OSR_COUNT && i < conv_sensor->osr_count; i++) {
+#if BOARD_CONV_TUNE_ENABLE
+        osr_conv_us[i] = conv_tune_get_us((uint8_t)i);
+#else
+        osr_conv_us[i] = conv_sensor->conv_time_us[i];
+#endif
+        osr_delay_ticks[i] = (uint8_t)SENSOR_TICKS(osr_conv_us[i]);
+        osr_late_reads[i] = 0;
+    }
+    
+    /* Reset and PROM load run later as the first states of the state
+     * machine, so nothing blocks here */
+    
+    /* Initialize state */
+    s->state = SENSOR_STATE_IDLE;
+    s->latest.valid = false;
+    ring_tail = ring_head;
+    ring_overruns = 0;
+    raw_tail = raw_head;
+    raw_overruns = 0;
+    
+#if BOARD_WARM_RESTART_ENABLE
+    /* Warm boot: calibrated from the kept PROM words, bring-up skipped,
+     * numbering carried on */
+    if (sensor_warm_valid()) {
+        bool second_order = s->calibration.second_order;
+        
+        for (uint32_t i = 0; i < 7U; i++) {
+            s->prom_words[i] = sensor_warm.prom[i];
+        }
+        if (ms5837_calib_prepare(s->prom_words, &s->calibration) == E_MS58370BA01_SUCCESS) {
+            ms5837_calib_set_second_order(&s->calibration, second_order);
+            s->calibration_loaded = true;
+        }
+        s->sequence = sensor_warm.sequence;
+    } else {
+        sensor_warm.prom_check = 0;
+        sensor_warm.sequence = 0;
+    }
+#endif
+    
+    return true;
+}
+
+bool sensor_sampling_start(void)
+{
+    sensor_sampler_t *s = &sampler;
+    
+    /* Reset state machine to start sampling (bring-up first if needed) */
+    s->state = s->calibration_loaded ? SENSOR_STATE_START_PRESSURE_CONV : SENSOR_STATE_RESET;
+    s->wait_counter = 0;
+    fail_streak = 0;
+    backoff_ticks = 0;
+    
+    /* Reset already sent: wait out what is left of the reload (often
+     * nothing, the other inits ran meanwhile), then read the PROM */
+    if (!s->calibration_loaded && early_reset == SENSOR_EARLY_RESET_DONE) {
+        uint32_t elapsed_us = board_get_uptime_us() - early_reset_us;
+        
+        s->state = SENSOR_STATE_WAIT_RESET;
+        if (elapsed_us < SENSOR_EARLY_RESET_WAIT_US) {
+            s->wait_counter = SENSOR_TICKS(SENSOR_EARLY_RESET_WAIT_US - elapsed_us) + 1U;
+        }
+    }
+    early_reset = SENSOR_EARLY_RESET_NONE;
+    
+    /* First cycle always converts temperature */
+    s->temperature_adc_valid = false;
+    s->temp_skip_count = 0;
+    s->single_shot = false;
+    
+    return true;
+}
+
+bool sensor_sampling_start_single(void)
+{
+    sensor_sampler_t *s = &sampler;
+    
+    if (s->state != SENSOR_STATE_IDLE || s->transfer_pending) {
+        return false;
+    }
+    
+    (void)sensor_sampling_start();
+    s->single_shot = true;
+    return true;
+}
+
+bool sensor_sampling_is_idle(void)
+{
+    return sampler.state == SENSOR_STATE_IDLE && !sampler.transfer_pending;
+}
+
+bool sensor_sampling_stop(void)
+{
+    sampler.state = SENSOR_STATE_IDLE;
+    return true;
+}
+
+void sensor_sampling_conversion_isr(void)
+{
+    sensor_sampler_t *s = &sampler;
+    
+    s->compare_armed = false;
+    if (s->transfer_pending) {
+        return;
+    }
+    
+    if (s->state == SENSOR_STATE_WAIT_PRESSURE_CONV) {
+        s->state = SENSOR_STATE_READ_PRESSURE_ADC;
+        sensor_start_adc_read(s);
+    } else if (s->state == SENSOR_STATE_WAIT_TEMP_CONV) {
+        s->state = SENSOR_STATE_READ_TEMP_ADC;
+        sensor_start_adc_read(s);
+    }
+}
+
+bool sensor_sampling_set_mode(sensor_sampling_mode_t mode)
+{
+    if (mode != SENSOR_MODE_SEQUENTIAL && mode != SENSOR_MODE_PIPELINED &&
+        mode != SENSOR_MODE_EXACT) {
+        return false;
+    }
+    
+    /* The sync input only starts cycles: the rest is timed by the compare */
+    if (sync_external && mode != SENSOR_MODE_EXACT) {
+        return false;
+    }
+    
+    /* All modes share the same states. Leaving exact mode mid-wait is safe:
+     * the pending compare still advances the cycle, and the WAIT states fall
+     * through to READ on the next tick. Entering it mid-cycle is too: no
+     * compare is armed for that cycle, so the ticks finish it */
+    sampling_mode = mode;
+    return true;
+}
+
+sensor_sampling_mode_t sensor_sampling_get_mode(void)
+{
+    return sampling_mode;
+}
+
+bool sensor_sampling_set_profile(sensor_osr_t pressure_osr, sensor_osr_t temperature_osr)
+{
+    if (!sensor_osr_supported(pressure_osr) || !sensor_osr_supported(temperature_osr)) {
+        return false;
+    }
+    
+    /* Picked up by the next conversion start; the one in flight keeps its delay */
+    osr_d1 = pressure_osr;
+    osr_d2 = temperature_osr;
+    adaptive_quiet_count = 0;
+    return true;
+}
+
+void sensor_sampling_get_profile(sensor_osr_t *pressure_osr, sensor_osr_t *temperature_osr)
+{
+    if (pressure_osr != NULL) {
+        *pressure_osr = osr_d1;
+    }
+    if (temperature_osr != NULL) {
+        *temperature_osr = osr_d2;
+    }
+}
+
+bool sensor_sampling_set_adaptive_osr(const sensor_adaptive_osr_t *config)
+{
+    if (config == NULL || !config->enabled) {
+        adaptive.enabled = false;
+        return true;
+    }
+    
+    if (!sensor_osr_supported(config->fast_osr) || !sensor_osr_supported(config->quiet_osr) ||
+        config->fast_osr > config->quiet_osr || config->threshold < 0 ||
+        (config->fast_rate_hz == 0U) != (config->quiet_rate_hz == 0U) ||
+        config->quiet_rate_hz > config->fast_rate_hz) {
+        return false;
+    }
+    
+    adaptive.enabled = false;  /* Not evaluated while the config is updated */
+    
+    /* Both rates must be reachable; the controller starts at the fast one */
+    if (config->fast_rate_hz != 0U) {
+        uint32_t previous = sensor_sampling_get_rate_hz();
+        
+        if (!sensor_sampling_set_rate_hz(config->quiet_rate_hz) ||
+            !sensor_sampling_set_rate_hz(config->fast_rate_hz)) {
+            (void)sensor_sampling_set_rate_hz(previous);
+            return false;
+        }
+    }
+    adaptive.fast_rate_hz = config->fast_rate_hz;
+    adaptive.quiet_rate_hz = config->quiet_rate_hz;
+    adaptive_rate_hz = config->fast_rate_hz;
+    adaptive.fast_osr = config->fast_osr;
+    adaptive.quiet_osr = config->quiet_osr;
+    adaptive.threshold = config->threshold;
+    adaptive.settle_samples = config->settle_samples;
+    adaptive_quiet_count = 0;
+    adaptive_last_pressure = sampler.latest.pressure;
+    osr_d1 = config->fast_osr;
+    adaptive.enabled = true;
+    
+    return true;
+}
+
+void sensor_sampling_get_adaptive_osr(sensor_adaptive_osr_t *config)
+{
+    if (config != NULL) {
+        *config = adaptive;
+    }
+}
+
+sensor_status_t sensor_sampling_get_status(void)
+{
+    sensor_sampler_t *s = &sampler;
+    sensor_state_t state = s->state;
+    
+    if (state == SENSOR_STATE_IDLE) {
+        return SENSOR_STATUS_IDLE;
+    }
+    if (s->latest.valid) {
+        return sensor_sampling_is_stale(&s->latest) ? SENSOR_STATUS_STALE :
+                                                           SENSOR_STATUS_RUNNING;
+    }
+    if (state == SENSOR_STATE_ERROR) {
+        return SENSOR_STATUS_ERROR;
+    }
+    return SENSOR_STATUS_WARMING_UP;
+}
+
+void sensor_sampling_set_stale_limit_ms(uint16_t limit_ms)
+{
+    stale_limit_us = (uint32_t)limit_ms * 1000UL;
+}
+
+uint16_t sensor_sampling_get_stale_limit_ms(void)
+{
+    return (uint16_t)(stale_limit_us / 1000UL);
+}
+
+uint32_t sensor_sampling_get_age_us(const sensor_data_t *sample)
+{
+    return hal_tim2_get_timestamp_us() - sample->timestamp_us;
+}
+
+bool sensor_sampling_is_stale(const sensor_data_t *sample)
+{
+    uint32_t limit_us = stale_limit_us;
+    
+    if (!sample->valid) {
+        return true;
+    }
+    return limit_us != 0U && sensor_sampling_get_age_us(sample) > limit_us;
+}
+
+uint8_t sensor_sampling_get_state(void)
+{
+    return (uint8_t)sampler.state;
+}
+
+void sensor_sampling_register_event_callback(sensor_sampling_event_cb_t callback)
+{
+    event_callback = callback;
+}
+
+void sensor_sampling_register_direct_callback(sensor_sampling_direct_cb_t callback)
+{
+    direct_callback = callback;
+}
+
+void sensor_sampling_register_publish_callback(sensor_sampling_publish_cb_t callback)
+{
+    publish_callback = callback;
+}
+
+void sensor_sampling_poll(void)
+{
+    sensor_sampler_t *s = &sampler;
+    
+    /* Calibration read from the sensor during bring-up: cache it for the
+     * next boot (blocking EEPROM writes, main loop only) */
+    if (calib_cache_store_pending && s->calibration_loaded) {
+        calib_cache_store_pending = false;
+        sensor_calib_cache_store(s->prom_words);
+    }
+}
+
+void sensor_sampling_set_second_order(bool enable)
+{
+    /* Single flag read by the kernel: takes effect on the next sample */
+    ms5837_calib_set_second_order(&sampler.calibration, enable);
+}
+
+bool sensor_sampling_set_rate_hz(uint32_t rate_hz)
+{
+    if (!hal_tim2_set_rate_hz(rate_hz)) {
+        return false;
+    }
+    
+    /* Intervals at the old rate say nothing about the new one */
+    sensor_sampling_reset_jitter();
+    return true;
+}
+
+uint32_t sensor_sampling_get_rate_hz(void)
+{
+    return hal_tim2_get_rate_hz();
+}
+
+bool sensor_sampling_align_tick(void)
+{
+    return hal_tim2_restart_period();
+}
+
+bool sensor_sampling_shift_tick_us(int32_t us)
+{
+    uint32_t rate_hz = hal_tim2_get_rate_hz();
+    int32_t limit = (rate_hz != 0U) ? (int32_t)(1000000UL / rate_hz / 8U) : 0;
+    
+    if (sampling_mode != SENSOR_MODE_EXACT || sync_external || us > limit || us < -limit) {
+        return false;
+    }
+    return hal_tim2_trim_period(us * (int32_t)(BOARD_TIM2_COUNTER_HZ / 1000000UL));
+}
+
+bool sensor_sampling_set_sync_input(bool external)
+{
+#if BOARD_SYNC_IN_ENABLE
+    if (external) {
+        sampling_mode = SENSOR_MODE_EXACT;
+    }
+    sync_external = external;
+#if BOARD_RAM_VECTORS_ENABLE
+    main_route_vectors();  /* Before the first edge can come in */
+#endif
+    hal_sync_in_enable(external);
+    
+    /* Intervals are now the source's, not the timebase's */
+    sensor_sampling_reset_jitter();
+    return true;
+#else
+    return !external;
+#endif
+}
+
+bool sensor_sampling_get_sync_input(void)
+{
+    return sync_external;
+}
+
+bool sensor_sampling_set_temperature_decimation(uint16_t every_n)
+{
+    if (every_n == 0) {
+        return false;
+    }
+    
+    temp_decimation = every_n;
+    return true;
+}
+
+uint16_t sensor_sampling_get_temperature_decimation(void)
+{
+    return temp_decimation;
+}
+
+bool sensor_sampling_set_filter(sensor_filter_mode_t mode, uint8_t pressure_log2,
+                                uint8_t temperature_log2)
+{
+    uint8_t max = (mode == SENSOR_FILTER_IIR) ? SENSOR_IIR_CUSTOM : SENSOR_FILTER_MAX_LOG2;
+    
+    if (mode >= SENSOR_FILTER_COUNT || pressure_log2 > max || temperature_log2 > max) {
+        return false;
+    }
+    
+    filter_config = SENSOR_FILTER_CONFIG(mode, pressure_log2, temperature_log2) |
+                    (filter_config & (SENSOR_FILTER_MEDIAN | SENSOR_FILTER_CUSTOM_GEN));
+    return true;
+}
+
+bool sensor_sampling_set_median(uint8_t window)
+{
+    if (window == 1U) {
+        window = 0;
+    }
+    if (window != 0U && window != 3U && window != SENSOR_MEDIAN_MAX) {
+        return false;
+    }
+    
+    filter_config = (filter_config & ~SENSOR_FILTER_MEDIAN) |
+                    ((uint32_t)window << SENSOR_FILTER_MEDIAN_SHIFT);
+    return true;
+}
+
+uint32_t sensor_sampling_get_filter(void)
+{
+    return filter_config & ~SENSOR_FILTER_CUSTOM_GEN;
+}
+
+bool sensor_sampling_set_iir_coeffs(const sensor_iir_coeffs_t *coeffs)
+{
+    int64_t a1;
+    int64_t a2;
+    uint32_t config;
+    
+    if (coeffs == NULL) {
+        return false;
+    }
+    
+    /* Stability triangle: |a2| < 1, |a1| < 1 + a2 */
+    a1 = coeffs->a1;
+    a2 = coeffs->a2;
+    if (coeffs->b0 > SENSOR_IIR_ONE || coeffs->b0 < -SENSOR_IIR_ONE ||
+        coeffs->b1 > SENSOR_IIR_ONE || coeffs->b1 < -SENSOR_IIR_ONE ||
+        coeffs->b2 > SENSOR_IIR_ONE || coeffs->b2 < -SENSOR_IIR_ONE ||
+        a2 >= SENSOR_IIR_ONE || a2 <= -SENSOR_IIR_ONE ||
+        a1 >= SENSOR_IIR_ONE + a2 || -a1 >= SENSOR_IIR_ONE + a2) {
+        return false;
+    }
+    
+    /* The bottom half only preempts this and copies the section when the
+     * configuration word changes, which comes last */
+    iir_custom = *coeffs;
+    __DMB();
+    config = filter_config;
+    filter_config = (config & ~SENSOR_FILTER_CUSTOM_GEN) |
+                    ((config + SENSOR_FILTER_GEN_STEP) & SENSOR_FILTER_CUSTOM_GEN);
+    return true;
+}
+
+bool sensor_sampling_get_data(sensor_data_t *data)
+{
+    sensor_sampler_t *s = &sampler;
+    uint32_t seq;
+    
+    if (data == NULL) {
+        return false;
+    }
+    
+    /* Retry if the sampler ISR published while we were copying */
+    do {
+        seq = hal_seq_read_begin(&s->latest_seq);
+        *data = s->latest;
+    } while (hal_seq_read_retry(&s->latest_seq, seq));
+    
+    return !sensor_sampling_is_stale(data);
+}
+
+uint32_t sensor_sampling_read_batch(sensor_data_t *out, uint32_t max_samples)
+{
+    uint32_t tail = ring_tail;
+    uint32_t count;
+    
+    if (out == NULL) {
+        return 0;
+    }
+    
+    count = ring_head - tail;
+    __DMB();  /* Read entries only after seeing the head that covers them */
+    if (count > max_samples) {
+        count = max_samples;
+    }
+    
+    for (uint32_t i = 0; i < count; i++) {
+        out[i] = ring[(tail + i) & SENSOR_RING_MASK];
+    }
+    
+    __DMB();  /* Entries copied before the slots are handed back */
+    ring_tail = tail + count;
+    return count;
+}
+
+uint32_t sensor_sampling_available(void)
+{
+    return ring_head - ring_tail;
+}
+
+uint32_t sensor_sampling_get_overruns(void)
+{
+    /* Separate counters: each one has a single writer */
+    return ring_overruns + raw_overruns;
+}
+
+void sensor_sampling_get_error_stats(sensor_error_stats_t *stats)
+{
+    if (stats != NULL) {
+        *stats = error_stats;
+    }
+}
+
+void sensor_sampling_get_tick_stats(sensor_tick_stats_t *stats)
+{
+    uint32_t masked;
+    
+    if (stats == NULL) {
+        return;
+    }
+    
+    /* Timebase masked: written by the tick handler */
+    masked = hal_irq_mask(HAL_IRQ_LINES_TIMEBASE);
+    *stats = tick_stats;
+    hal_irq_unmask(masked);
+}
+
+void sensor_sampling_get_jitter_stats(sensor_jitter_stats_t *stats)
+{
+    uint64_t var_q16;
+    uint64_t root = 0;
+    uint32_t seq;
+    
+    if (stats == NULL) {
+        return;
+    }
+    
+    do {
+        seq = hal_seq_read_begin(&jitter_seq);
+        *stats = jitter_shown;
+        var_q16 = jitter_shown_var_q16;
+    } while (hal_seq_read_retry(&jitter_seq, seq));
+    
+    /* Bitwise square root (no divider): the variance is below 2^46, so
+     * the root in Q8 us fits 23 bits */
+    for (uint64_t bit = 1ULL << 46; bit != 0U; bit >>= 2) {
+        if (var_q16 >= root + bit) {
+            var_q16 -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+    }
+    stats->stddev_ns = (uint32_t)((root * 1000U + 128U) >> 8);
+}
+
+void sensor_sampling_reset_jitter(void)
+{
+    jitter_reset_gen++;
+}
+
+bool sensor_sampling_set_raw_capture(bool enable)
+{
+#if BOARD_FLASH_LOG_ENABLE
+    raw_capture_enabled = enable;
+    return true;
+#else
+    (void)enable;
+    return false;
+#endif
+}
+
+uint32_t sensor_sampling_read_raw(sensor_raw_record_t *out, uint32_t max_records)
+{
+#if BOARD_FLASH_LOG_ENABLE
+    uint32_t tail = raw_capture_tail;
+    uint32_t count = raw_capture_head - tail;
+    
+    if (out == NULL) {
+        return 0;
+    }
+    if (count > max_records) {
+        count = max_records;
+    }
+    
+    __DMB();  /* Entries read only after seeing the head that covers them */
+    for (uint32_t i = 0; i < count; i++) {
+        out[i] = raw_capture[(tail + i) & SENSOR_RAW_CAPTURE_MASK];
+    }
+    __DMB();
+    raw_capture_tail = tail + count;
+    return count;
+#else
+    (void)out;
+    (void)max_records;
+    return 0;
+#endif
+}
+
+bool sensor_sampling_get_prom(uint16_t *words)
+{
+    sensor_sampler_t *s = &sampler;
+    sensor_status_t status = sensor_sampling_get_status();
+    
+    if (words == NULL || (status != SENSOR_STATUS_RUNNING && status != SENSOR_STATUS_STALE)) {
+        return false;
+    }
+    
+    for (uint32_t i = 0; i < 7U; i++) {
+        words[i] = s->prom_words[i];
+    }
+    return true;
+}
+
+/**
+ * @brief Invalidation asked for the raw entry at tail (bottom half only)
+ */
+static void sensor_invalidate_due(uint32_t tail)
+{
+    sensor_sampler_t *s = &sampler;
+    uint32_t requests = invalidate_requests;
+    
+    if (requests == invalidate_done || invalidate_head != tail) {
+        return;
+    }
+    invalidate_done = requests;
+    
+    hal_seq_write_begin(&s->latest_seq);
+    s->latest.valid = false;
+    hal_seq_write_end(&s->latest_seq);
+    sensor_notify();  /* Status changed */
+}
+
+void sensor_sampling_bottom_half(void)
+{
+    sensor_sampler_t *s = &sampler;
+    uint32_t tail = raw_tail;
+    
+    /* The ISRs may queue more while this runs: loop until caught up */
+    sensor_invalidate_due(tail);
+    while (tail != raw_head) {
+        const sensor_raw_t *raw = &raw_ring[tail & SENSOR_RAW_RING_MASK];
+        sensor_data_t sample;
+        sensor_sampling_direct_cb_t direct = direct_callback;
+        int32_t pressure;
+        bool published;
+        
+        __DMB();  /* Read the entry only after seeing the head that covers it */
+        
+        sensor_jitter_update(raw->timestamp_us, raw->sequence);
+#if BOARD_FLASH_LOG_ENABLE
+        if (raw_capture_enabled && raw_capture_head - raw_capture_tail < SENSOR_RAW_CAPTURE_SIZE) {
+            raw_capture[raw_capture_head & SENSOR_RAW_CAPTURE_MASK] = *raw;
+            __DMB();
+            raw_capture_head++;
+        }
+#endif
+        
+        /* Shift-only kernel: fixed cost, no 64-bit division helpers */
+        PROF_BEGIN(PROF_SITE_COMPENSATE);
+        conv_sensor->compensate(&s->calibration, raw->pressure_adc, raw->temperature_adc,
+                                &sample.pressure, &sample.temperature);
+        PROF_END(PROF_SITE_COMPENSATE);
+        sample.timestamp_us = raw->timestamp_us;
+        sample.sequence = raw->sequence;
+        sample.valid = true;
+        sample.quality = SENSOR_QUALITY_CRC_OK;  /* Every way into s->calibration checks it */
+        sample.error_count = (uint16_t)error_stats.errors;
+        
+        /* Direct consumer first, masked: no handler lands between the
+         * compensation and its output */
+        if (direct != NULL) {
+            uint32_t primask = hal_crit_enter();
+            
+            {
+                PROF_BEGIN(PROF_SITE_DAC_DIRECT);
+                direct(&sample);
+                PROF_END(PROF_SITE_DAC_DIRECT);
+            }
+            hal_crit_exit(primask);
+        }
+        
+        __DMB();  /* Entry consumed before the slot is handed back */
+        raw_tail = ++tail;
+        
+        /* Activity and rate are judged on the despiked, unfiltered pressure */
+        pressure = sample.pressure;
+        sensor_median(&sample);
+        if (sample.pressure != pressure) {
+            sample.quality |= SENSOR_QUALITY_DESPIKED;
+        }
+        if (adaptive.enabled) {
+            sensor_adapt_osr(sample.pressure);
+        }
+        tracker_update(&sample);
+        
+        published = sensor_filter(&sample);
+        sensor_quality_update(&sample, published);
+        if (published) {
+            sample_stats_add(&sample);
+            sensor_publish(&sample);
+            LATENCY_RECORD(LATENCY_STAGE_COMPENSATED, sample.timestamp_us);
+        }
+        sensor_invalidate_due(tail);
+    }
+}
+
+/**
+ * @brief WAIT_RESET over: read the PROM, chained from I2C2 completions
+ */
+static void sensor_tick_read_prom(sensor_sampler_t *s)
+{
+    s->prom_index = 0;
+    sensor_start_prom_read(s);
+}
+
+static void sensor_tick_start_pressure(sensor_sampler_t *s)
+{
+    sensor_start_conversion(s, true);
+}
+
+static void sensor_tick_start_temperature(sensor_sampler_t *s)
+{
+    sensor_start_conversion(s, false);
+}
+
+/**
+ * @brief Sequential mode: capture the pair, start the next cycle
+ */
+static void sensor_tick_calculate(sensor_sampler_t *s)
+{
+    sensor_capture(s);
+    s->state = sensor_cycle_end_state(s);
+}
+
+/**
+ * @brief Recover from an error and resume on this same tick
+ */
+static void sensor_tick_recover(sensor_sampler_t *s)
+{
+    sensor_invalidate();
+    
+    /* Repeated failures: wait out the backoff first */
+    if (backoff_ticks != 0U) {
+        backoff_ticks--;
+        return;
+    }
+    
+    /* Bus-level fault (stuck line, arbitration loss, timeout):
+     * free the bus and re-init I2C2 before touching the sensor */
+    if (bus_recovery_needed || hal_i2c2_bus_fault()) {
+        error_stats.bus_recoveries++;
+        if (!hal_i2c2_recover()) {
+            error_stats.recovery_failures++;
+            bus_recovery_needed = true;  /* Try again next tick */
+            return;
+        }
+        bus_recovery_needed = false;
+#if BOARD_I2C_TUNE_ENABLE
+        bus_tune_on_bus_error();  /* Repeated faults: one profile slower */
+#endif
+    }
+    
+    /* Bring-up failures restart from the sensor reset */
+    s->wait_counter = 0;
+    s->state = s->calibration_loaded ? SENSOR_STATE_START_PRESSURE_CONV
+                                      : SENSOR_STATE_RESET;
+    if (s->state == SENSOR_STATE_START_PRESSURE_CONV) {
+        sensor_start_conversion(s, true);
+    } else {
+        sensor_start_reset(s);
+    }
+}
+
+/**
+ * @brief What a tick does in each state
+ * 
+ * Wait states count the sampler's wait_counter down (loaded by the
+ * completion that entered them, from the OSR or the reset time) and then
+ * move to after_wait and run the action; other states run the action on every
+ * tick. Transfer completions make the remaining transitions, and any
+ * failure goes to SENSOR_STATE_ERROR (sensor_fail()). A new sequence is a
+ * new state and row, not a new case: every tick costs the same lookup.
+ */
+typedef struct {
+    void (*action)(sensor_sampler_t *s);  /* NULL: nothing to do on the tick */
+    sensor_state_t after_wait;  /* State once the wait is over */
+    bool wait;                  /* Counts the wait_counter down first */
+    bool exact_tick;            /* Still driven by ticks in exact mode */
+} sensor_tick_entry_t;
+
+static const sensor_tick_entry_t sensor_tick_table[SENSOR_TICK_STATE_COUNT] = {
+    [SENSOR_STATE_IDLE]                = { NULL,                          SENSOR_STATE_IDLE,                false, true  },
+    [SENSOR_STATE_RESET]               = { sensor_start_reset,            SENSOR_STATE_RESET,               false, true  },
+    [SENSOR_STATE_WAIT_RESET]          = { sensor_tick_read_prom,         SENSOR_STATE_READ_PROM,           true,  true  },
+    [SENSOR_STATE_READ_PROM]           = { NULL,                          SENSOR_STATE_READ_PROM,           false, true  },
+    [SENSOR_STATE_START_PRESSURE_CONV] = { sensor_tick_start_pressure,    SENSOR_STATE_START_PRESSURE_CONV, false, true  },
+    [SENSOR_STATE_WAIT_PRESSURE_CONV]  = { NULL,                          SENSOR_STATE_READ_PRESSURE_ADC,   true,  false },
+    [SENSOR_STATE_READ_PRESSURE_ADC]   = { sensor_start_adc_read,         SENSOR_STATE_READ_PRESSURE_ADC,   false, false },
+    [SENSOR_STATE_START_TEMP_CONV]     = { sensor_tick_start_temperature, SENSOR_STATE_START_TEMP_CONV,     false, false },
+    [SENSOR_STATE_WAIT_TEMP_CONV]      = { NULL,                          SENSOR_STATE_READ_TEMP_ADC,       true,  false },
+    [SENSOR_STATE_READ_TEMP_ADC]       = { sensor_start_adc_read,         SENSOR_STATE_READ_TEMP_ADC,       false, false },
+    [SENSOR_STATE_CALCULATE]           = { sensor_tick_calculate,         SENSOR_STATE_CALCULATE,           false, false },
+    [SENSOR_STATE_ERROR]               = { sensor_tick_recover,           SENSOR_STATE_ERROR,               false, true  },
+};
+
+/**
+ * @brief One sampling step of the tick (sensor_sampling_timer_isr())
+ */
+static RAMFUNC void sensor_tick_step(sensor_sampler_t *s)
+{
+    const sensor_tick_entry_t *entry;
+    
+    /* Previous step's bus transfer still in flight - skip this tick,
+     * unless it has been stuck long enough to give up on it */
+    if (s->transfer_pending) {
+        if (++s->pending_ticks < SENSOR_TRANSFER_TIMEOUT_TICKS) {
+            return;
+        }
+        sensor_transfer_timeout(s);
+    }
+    s->pending_ticks = 0;
+    
+#if BOARD_PROBE_ENABLE && (BOARD_PROBE_GROUPS & PROBE_GROUP_STATE)
+    if (s->state != probe_last_state) {
+        probe_last_state = s->state;
+        PROBE_STATE((uint32_t)PROBE_ID_SENSOR_STATE + (uint32_t)s->state);
+    }
+#endif
+    
+    if ((uint32_t)s->state >= SENSOR_TICK_STATE_COUNT) {
+        s->state = SENSOR_STATE_IDLE;
+        return;
+    }
+    entry = &sensor_tick_table[s->state];
+    
+    /* Exact mode: ticks only start cycles (and drive bring-up), compare
+     * events do the rest - unless the cycle began in another mode */
+    if (sampling_mode == SENSOR_MODE_EXACT && !entry->exact_tick && s->compare_armed) {
+        return;
+    }
+    
+    if (entry->wait) {
+        if (s->wait_counter > 0) {
+            s->wait_counter--;
+        }
+        if (s->wait_counter != 0) {
+            return;
+        }
+        s->state = entry->after_wait;
+    }
+    if (entry->action != NULL) {
+        entry->action(s);
+    }
+}
+
+RAMFUNC void sensor_sampling_timer_isr(void)
+{
+    sensor_sampler_t *s = &sampler;
+    sensor_state_t state = s->state;
+    uint32_t start_us;
+    uint32_t elapsed_us;
+    
+#if !BOARD_RAM_VECTORS_ENABLE
+    if (sync_external) {
+        return;  /* Steps come from sensor_sampling_sync_isr() */
+    }
+#endif
+    
+    start_us = hal_tim2_get_timestamp_us();
+    sensor_tick_step(s);
+    
+    /* High-water marks by the state the tick found */
+    elapsed_us = hal_tim2_get_timestamp_us() - start_us;
+    tick_stats.ticks++;
+    if ((uint32_t)state < SENSOR_TICK_STATE_COUNT && elapsed_us > tick_stats.wcet_us[state]) {
+        tick_stats.wcet_us[state] = elapsed_us;
+    }
+    if (elapsed_us > tick_stats.max_us) {
+        tick_stats.max_us = elapsed_us;
+        tick_stats.max_state = (uint8_t)state;
+    }
+    
+    /* Next tick already due: this one missed its deadline (a second one
+     * meanwhile would be lost, and the timestamp base with it) */
+    if (hal_tim2_tick_pending()) {
+        tick_stats.overruns++;
+    }
+}
+
+RAMFUNC void sensor_sampling_sync_isr(uint32_t edge_us)
+{
+    sensor_sampler_t *s = &sampler;
+    sensor_state_t state = s->state;
+    bool busy = s->transfer_pending;
+    
+#if !BOARD_RAM_VECTORS_ENABLE
+    if (!sync_external) {
+        return;
+    }
+#endif
+    
+    sync_edge_us = edge_us;
+    sensor_tick_step(s);
+    tick_stats.ticks++;
+    
+    /* An edge that found the cycle still running started nothing */
+    if (state != SENSOR_STATE_START_PRESSURE_CONV && state != SENSOR_STATE_IDLE &&
+        state != SENSOR_STATE_READ_PROM && state != SENSOR_STATE_ERROR) {
+        tick_stats.overruns++;
+    } else if (busy) {
+        tick_stats.overruns++;
     }
 }
 
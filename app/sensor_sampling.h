@@ -7,6 +7,10 @@
  * 
  * This module handles timer-based sampling of the MS5837 pressure sensor.
  * Sampling is triggered by hardware timer interrupts at approximately 2ms intervals.
+ *
+ * One sampler: the sensor on I2C2 (BOARD_I2C2_SENSOR_ADDR), ticked by
+ * TIM2, the only sampling timebase. More probes are sampled through the
+ * muxes of sensor_array.c instead.
  */
 
 #include <stdint.h>
@@ -20,15 +24,223 @@ extern "C" {
  * TYPES
  * ============================================================================ */
 
+/* sensor_data_t quality bits */
+#define SENSOR_QUALITY_CRC_OK    0x01U  /* Coefficients from a PROM that passed its CRC-4 */
+#define SENSOR_QUALITY_RETRIED   0x02U  /* Cycles aborted since the previous sample */
+#define SENSOR_QUALITY_CLAMPED   0x04U  /* A value hit an input or output range clamp */
+#define SENSOR_QUALITY_DESPIKED  0x08U  /* The median replaced the pressure */
+#define SENSOR_QUALITY_WARMUP    0x10U  /* Median or filter still settling after a restart */
+#define SENSOR_QUALITY_OUTVOTED  0x20U  /* Fused: a probe was off the others (sensor_vote.h) */
+#define SENSOR_QUALITY_FEW_VOTES 0x40U  /* Fused: fewer probes than BOARD_SENSOR_VOTE_QUORUM */
+
+/* Sample record: the first SENSOR_RECORD_BYTES of a sensor_data_t, as the
+ * sampler wrote it, are the record every transport sends (FIFO burst, USB
+ * and UART streams, SD and flash logs, codec keyframes): uint32
+ * timestamp_us, uint32 sequence, int32 pressure, int32 temperature,
+ * little-endian like the core. Transports copy it from the sample, so
+ * they stay bit-identical; the fields below must keep this order, and a
+ * change to it needs new sync, magic or format values in every header */
+#define SENSOR_RECORD_BYTES      16U
+
 /**
  * @brief Sensor data structure
  */
 typedef struct {
+    uint32_t timestamp_us; /* hal_tim2_get_timestamp_us() at pressure conversion start */
+    uint32_t sequence;   /* Increments by 1 per sample: gaps mean dropped samples */
     int32_t pressure;      /* Pressure in 0.01 mbar (from sensor calculation) */
     int32_t temperature; /* Temperature in 0.01°C (from sensor calculation) */
     bool valid;          /* True if data is valid and ready */
+    uint8_t quality;     /* SENSOR_QUALITY_* */
+    uint16_t error_count; /* Aborted cycles since boot (wraps): compare two samples */
 } sensor_data_t;
 
+/**
+ * @brief Sampling mode
+ */
+typedef enum {
+    SENSOR_MODE_SEQUENTIAL = 0,  /* One step per tick: 6 ticks per P/T pair */
+    SENSOR_MODE_PIPELINED  = 1,  /* ADC read chains next conversion: 2 ticks per pair */
+    SENSOR_MODE_EXACT      = 2   /* Tick starts a cycle, TIM2 CH1 compare fires when
+                                  * each conversion is done: 1 tick per pair */
+} sensor_sampling_mode_t;
+
+/**
+ * @brief Sampler status
+ */
+typedef enum {
+    SENSOR_STATUS_IDLE = 0,      /* Not started */
+    SENSOR_STATUS_WARMING_UP,    /* Bring-up (reset, PROM) or first cycle in progress */
+    SENSOR_STATUS_RUNNING,       /* Valid samples available */
+    SENSOR_STATUS_ERROR,         /* No valid sample yet, recovering from an error */
+    SENSOR_STATUS_STALE          /* Latest sample older than the stale limit */
+} sensor_status_t;
+
+/**
+ * @brief Sampler error counters (since boot)
+ */
+typedef struct {
+    uint32_t errors;             /* Cycles aborted by a failed transfer or bring-up step */
+    uint32_t timeouts;           /* Transfers whose completion never arrived */
+    uint32_t bus_recoveries;     /* I2C2 bus recoveries (9 clocks + STOP + re-init) */
+    uint32_t recovery_failures;  /* Recoveries that left a line held low */
+    uint32_t read_retries;       /* NACKed ADC reads repeated at once (cycle kept) */
+    uint32_t backoffs;           /* Recovery attempts delayed after repeated failures */
+    uint32_t late_reads;         /* ADC reads of 0 (conversion not done) read again later */
+    uint32_t conv_widened;       /* OSR levels put back on the datasheet time by late reads */
+} sensor_error_stats_t;
+
+/* Sampler states in sensor_tick_stats_t.wcet_us: idle, reset, wait reset,
+ * PROM, start P, wait P, read P, start T, wait T, read T, calculate, error */
+#define SENSOR_TICK_STATE_COUNT  12U
+
+/**
+ * @brief Sampling tick deadline counters (since boot)
+ * 
+ * Handler times are sensor_sampling_timer_isr() only, measured on the
+ * timebase (1 us on TIM2, one LSI period on LPTIM1).
+ */
+typedef struct {
+    uint32_t ticks;              /* Tick handlers run */
+    uint32_t overruns;           /* Ticks whose handler was still running at the next tick */
+    uint32_t max_us;             /* Longest handler */
+    uint8_t max_state;           /* State it ran in (wcet_us index) */
+    uint32_t wcet_us[SENSOR_TICK_STATE_COUNT];  /* Longest handler per state entered */
+} sensor_tick_stats_t;
+
+/**
+ * @brief Raw conversion pair of one sample (raw capture, flash_log.h)
+ */
+typedef struct {
+    uint32_t pressure_adc;     /* D1 */
+    uint32_t temperature_adc;  /* D2 (the cached one on pressure-only cycles) */
+    uint32_t timestamp_us;     /* Start of the D1 conversion */
+    uint32_t sequence;
+} sensor_raw_record_t;
+
+/**
+ * @brief Sampling cadence: intervals between consecutive conversion starts
+ * 
+ * Measured in the bottom half on the sample timestamps, since the last
+ * reset or rate change. An interval across a dropped sample is skipped.
+ * Mean and deviation follow the last ~64 intervals (1/64 weight), so a
+ * loaded stretch shows up and clears again; min and max are kept.
+ */
+typedef struct {
+    uint32_t intervals;     /* Intervals measured */
+    uint32_t min_us;        /* Shortest interval */
+    uint32_t max_us;        /* Longest interval */
+    uint32_t mean_us;       /* Running mean interval (rounded) */
+    uint32_t stddev_ns;     /* Running standard deviation, ns */
+    uint32_t peak_us;       /* Largest |interval - running mean| */
+} sensor_jitter_stats_t;
+
+/**
+ * @brief Oversampling ratio
+ * 
+ * Higher OSR lowers noise but lengthens the conversion
+ * (0.56ms at 256 up to 17.2ms at 8192).
+ */
+typedef enum {
+    SENSOR_OSR_256 = 0,
+    SENSOR_OSR_512,
+    SENSOR_OSR_1024,
+    SENSOR_OSR_2048,
+    SENSOR_OSR_4096,
+    SENSOR_OSR_8192,
+    SENSOR_OSR_COUNT
+} sensor_osr_t;
+
+/**
+ * @brief Adaptive pressure OSR (and tick rate) configuration
+ * 
+ * While pressure changes by more than `threshold` per sample, the pressure
+ * conversion uses `fast_osr` (high rate). After `settle_samples` quiet
+ * samples the OSR steps up by one, until `quiet_osr` (low noise) is reached.
+ * 
+ * With the rates set, each further run of quiet samples then halves the
+ * tick rate, down to `quiet_rate_hz`, and a change above the threshold
+ * restores `fast_rate_hz` from the next tick on. The controller owns the
+ * tick rate while it adapts it.
+ */
+typedef struct {
+    bool enabled;
+    sensor_osr_t fast_osr;     /* OSR used while the signal is active */
+    sensor_osr_t quiet_osr;    /* OSR reached when the signal is steady */
+    int32_t threshold;         /* Activity threshold in 0.01 mbar per sample */
+    uint16_t settle_samples;   /* Quiet samples per OSR or rate step */
+    uint32_t fast_rate_hz;     /* Tick rate while active (0: rate not adapted) */
+    uint32_t quiet_rate_hz;    /* Lowest tick rate, 1..fast_rate_hz (0: not adapted) */
+} sensor_adaptive_osr_t;
+
+/**
+ * @brief Sampler event callback
+ * 
+ * Called from interrupt context (TIM2/I2C2 or the PendSV bottom half)
+ * when the main loop has something to do: a sample was published, the
+ * sampler hit an error, or background work is pending. Keep it short.
+ */
+typedef void (*sensor_sampling_event_cb_t)(void);
+
+/**
+ * @brief Direct sample consumer
+ * 
+ * Called from the PendSV bottom half with each sample as it leaves the
+ * compensation, before the median and filter stages, with interrupts
+ * masked: a few stores at most (the DAC fast path).
+ */
+typedef void (*sensor_sampling_direct_cb_t)(const sensor_data_t *sample);
+
+/**
+ * @brief Published sample consumer
+ * 
+ * Called from the PendSV bottom half with each sample as it is published
+ * (after the filter stage), before the main loop is told: a few stores at
+ * most (the slave live block).
+ */
+typedef void (*sensor_sampling_publish_cb_t)(const sensor_data_t *sample);
+
+/* Longest filter: 2^SENSOR_FILTER_MAX_LOG2 samples */
+#define SENSOR_FILTER_MAX_LOG2     5U
+
+/**
+ * @brief Filter stage between compensation and the published samples
+ */
+typedef enum {
+    SENSOR_FILTER_NONE = 0,        /* Every compensated sample is published */
+    SENSOR_FILTER_MOVING_AVERAGE,  /* Sliding mean, one output per sample */
+    SENSOR_FILTER_DECIMATE,        /* Block mean (1-stage CIC): one output per
+                                    * 2^pressure_log2 samples */
+    SENSOR_FILTER_IIR,             /* Low-pass biquad, one output per sample:
+                                    * the log2 fields pick SENSOR_IIR_* sections */
+    SENSOR_FILTER_COUNT
+} sensor_filter_mode_t;
+
+/* Spike rejection ahead of the filter stage: median of the last 3 or 5 */
+#define SENSOR_MEDIAN_MAX          5U
+
+/* SENSOR_FILTER_IIR sections per channel: presets 0..5 are second-order
+ * Butterworth with fc = fs / 2^(n+2) (fs / 4 .. fs / 128), 6..11 first order
+ * with the same cutoffs, SENSOR_IIR_CUSTOM the sensor_sampling_set_iir_coeffs()
+ * one (tools/iir_coeffs.py) */
+#define SENSOR_IIR_PRESETS         12U
+#define SENSOR_IIR_CUSTOM          12U
+#define SENSOR_IIR_ONE             (1L << 30)  /* 1.0 in Q2.30 */
+
+/**
+ * @brief Biquad section, Q2.30:
+ *        y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]
+ *
+ * A first-order section has b2 = a2 = 0.
+ */
+typedef struct {
+    int32_t b0;
+    int32_t b1;
+    int32_t b2;
+    int32_t a1;
+    int32_t a2;
+} sensor_iir_coeffs_t;
+
 /* ============================================================================
  * FUNCTIONS
  * ============================================================================ */
@@ -36,13 +248,28 @@ typedef struct {
 /**
  * @brief Initialize sensor sampling module
  * 
- * Initializes the pressure sensor and prepares for interrupt-based sampling.
- * This should be called after I2C2 and TIM2 are initialized.
+ * Prepares for interrupt-based sampling without touching the bus: sensor
+ * reset and PROM load run as the first states of the state machine once
+ * sampling is started. This should be called after I2C2 and TIM2 are
+ * initialized.
  * 
  * @return true if initialization successful, false otherwise
  */
 bool sensor_sampling_init(void);
 
+/**
+ * @brief Send the sensor reset ahead of sampling (fast start)
+ * 
+ * Call right after I2C2 is initialized: the 2.8 ms reload then runs while
+ * the other peripherals are set up, and sensor_sampling_start() goes
+ * straight to the PROM read once it has passed. Thread context, before
+ * sampling starts.
+ * 
+ * @return true if sent, false if the bus is busy or the transfer could not
+ *         start (sampling then resets the sensor itself)
+ */
+bool sensor_sampling_reset_early(void);
+
 /**
  * @brief Start sensor sampling
  * 
@@ -52,6 +279,17 @@ bool sensor_sampling_init(void);
  */
 bool sensor_sampling_start(void);
 
+/**
+ * @brief Take one sample, then go idle
+ * 
+ * One full cycle (bring-up first if needed, temperature always converted)
+ * at the current profile; the sampler is idle, with no transfer in flight,
+ * once the sample is published. The timebase must be running meanwhile.
+ * 
+ * @return true if started, false if a cycle is still running
+ */
+bool sensor_sampling_start_single(void);
+
 /**
  * @brief Stop sensor sampling
  * 
@@ -61,17 +299,441 @@ bool sensor_sampling_start(void);
  */
 bool sensor_sampling_stop(void);
 
+/**
+ * @brief Sampler idle with no sensor transfer in flight
+ * 
+ * True after a single sample (sensor_sampling_start_single()) completed or
+ * after sensor_sampling_stop() once its transfer ended.
+ */
+bool sensor_sampling_is_idle(void);
+
+/**
+ * @brief Set the sampling tick rate
+ * 
+ * The timer period nearest to the rate is derived from the clock profile
+ * and takes effect at the next tick, so no tick is cut short and
+ * timestamps stay continuous. Can be changed while sampling.
+ * 
+ * @param rate_hz Tick rate (TIM2: 16 up to BOARD_TIM2_FREQ_HZ; LPTIM1: LSI
+ *                / 65536 up to BOARD_TIM2_FREQ_HZ)
+ * @return true if set, false if out of range
+ */
+bool sensor_sampling_set_rate_hz(uint32_t rate_hz);
+
+/**
+ * @brief Get the sampling tick rate (pending change included)
+ * 
+ * @return Rate in Hz
+ */
+uint32_t sensor_sampling_get_rate_hz(void);
+
+/**
+ * @brief Put the tick phase at now: the next tick one period later
+ * 
+ * Boards given the same event (an I2C general call) tick together from
+ * then on, to within their interrupt latency and clock drift. In
+ * SENSOR_MODE_EXACT every tick starts a cycle, so their conversions start
+ * together too; the other modes step a multi-tick cycle and only the ticks
+ * line up. The cut period shows as one long interval in the jitter
+ * statistics. Callable from interrupt context.
+ * 
+ * @return true if done, false if the timebase cannot be rephased (stopped,
+ *         LPTIM1)
+ */
+bool sensor_sampling_align_tick(void);
+
+/**
+ * @brief Move the tick phase by a few microseconds (poll_align.h)
+ * 
+ * The period after the next tick is trimmed once, so that tick and every
+ * later one come us later (negative: earlier). Only where a tick starts
+ * a cycle and nothing else sets the phase: SENSOR_MODE_EXACT on the
+ * local tick. The trimmed period shows as one interval off the mean in
+ * the jitter statistics.
+ * 
+ * @param us Shift, within an eighth of the tick period either way
+ * @return true if set, false if refused (mode, sync input, range, a rate
+ *         change or trim pending, LPTIM1)
+ */
+bool sensor_sampling_shift_tick_us(int32_t us);
+
+/**
+ * @brief Start cycles from the external sync input, or from the tick
+ * 
+ * External: each edge on BOARD_SYNC_IN_PIN starts a cycle in
+ * SENSOR_MODE_EXACT (set here; other modes are refused meanwhile), and
+ * the timebase ticks no longer step the sampler. The timebase still
+ * stamps the samples and times the conversions, so edges may come at up
+ * to the cycle rate of the profile; an edge that finds a cycle running is
+ * counted as a tick overrun. Edge to conversion start goes to
+ * LATENCY_STAGE_SYNC_IN.
+ * 
+ * @param external true for the sync input, false for the tick
+ * @return true if set, false if external and not built (BOARD_SYNC_IN_ENABLE)
+ */
+bool sensor_sampling_set_sync_input(bool external);
+
+/**
+ * @brief Whether cycles start from the external sync input
+ */
+bool sensor_sampling_get_sync_input(void);
+
+/**
+ * @brief Select the sampling mode
+ * 
+ * In pipelined mode the completion of each ADC read immediately starts the
+ * next conversion, and the calculation runs in the read-D2 completion, so a
+ * full pressure/temperature pair takes 2 ticks instead of 6.
+ * Can be changed while sampling is running.
+ * 
+ * In exact-timed mode each conversion is read as soon as its datasheet
+ * conversion time has elapsed (TIM2 CH1 compare), so a full pair completes
+ * within one tick.
+ * 
+ * @param mode SENSOR_MODE_SEQUENTIAL, SENSOR_MODE_PIPELINED or SENSOR_MODE_EXACT
+ * @return true if mode is valid, false otherwise
+ */
+bool sensor_sampling_set_mode(sensor_sampling_mode_t mode);
+
+/**
+ * @brief Get the current sampling mode
+ * 
+ * @return Current sampling mode
+ */
+sensor_sampling_mode_t sensor_sampling_get_mode(void);
+
+/**
+ * @brief Select the OSR profile
+ * 
+ * Each OSR is paired with its conversion delay (ticks, or exact time in
+ * SENSOR_MODE_EXACT). Can be changed while sampling: the conversion in
+ * flight completes with its original delay and the next one uses the new
+ * profile, so no samples are dropped.
+ * 
+ * @param pressure_osr OSR for the pressure (D1) conversion
+ * @param temperature_osr OSR for the temperature (D2) conversion
+ * @return true if both OSR values are valid, false otherwise
+ */
+bool sensor_sampling_set_profile(sensor_osr_t pressure_osr, sensor_osr_t temperature_osr);
+
+/**
+ * @brief Get the current OSR profile
+ * 
+ * @param pressure_osr Receives the pressure OSR (may be NULL)
+ * @param temperature_osr Receives the temperature OSR (may be NULL)
+ */
+void sensor_sampling_get_profile(sensor_osr_t *pressure_osr, sensor_osr_t *temperature_osr);
+
+/**
+ * @brief Configure adaptive pressure OSR and tick rate
+ * 
+ * Starts at fast_osr (and fast_rate_hz).
+ * 
+ * @param config Adaptive configuration, or NULL / enabled=false to disable
+ *               (the current OSR and rate are then kept)
+ * @return true if configuration is valid, false otherwise (rates outside
+ *         the sensor_sampling_set_rate_hz() range included)
+ */
+bool sensor_sampling_set_adaptive_osr(const sensor_adaptive_osr_t *config);
+
+/**
+ * @brief Get the adaptive configuration (enabled false when off)
+ * 
+ * @param config Receives the configuration
+ */
+void sensor_sampling_get_adaptive_osr(sensor_adaptive_osr_t *config);
+
+/**
+ * @brief Convert temperature only every N cycles
+ * 
+ * Temperature changes far more slowly than pressure. Cycles in between
+ * skip the D2 conversion and compensate with the last temperature ADC
+ * value, nearly doubling the pressure rate and halving I2C2 traffic.
+ * The first cycle after sensor_sampling_start() always converts D2.
+ * 
+ * @param every_n Temperature conversion period in cycles (1 = every cycle)
+ * @return true if set, false if every_n is 0
+ */
+bool sensor_sampling_set_temperature_decimation(uint16_t every_n);
+
+/**
+ * @brief Get the temperature conversion period in cycles
+ */
+uint16_t sensor_sampling_get_temperature_decimation(void);
+
+/**
+ * @brief Configure the integer filter stage
+ * 
+ * Runs in the bottom half on compensated samples. Each channel averages its
+ * last 2^n samples (running sum, rounded shift); in SENSOR_FILTER_DECIMATE
+ * only every 2^pressure_log2-th result is published, so the master reads
+ * fewer, quieter samples. Averaging 2^n samples gives roughly the noise of
+ * an n-step higher OSR at a fraction of the conversion time.
+ * 
+ * SENSOR_FILTER_IIR runs one biquad section per channel instead, chosen by
+ * the two log2 arguments (0..SENSOR_IIR_CUSTOM): a sharper low-pass for the
+ * same lag, at five 32x32-bit multiplies per channel and sample. The state
+ * keeps 8 fractional bits, the output saturates to the int32 range.
+ * 
+ * Published samples carry the timestamp and sequence of their newest input
+ * (a decimated stream advances sequence by 2^pressure_log2). The filter
+ * restarts, primed with the next sample, whenever it is reconfigured.
+ * 
+ * @param mode Filter mode
+ * @param pressure_log2 Pressure length as log2 (0..SENSOR_FILTER_MAX_LOG2),
+ *                      or IIR section
+ * @param temperature_log2 Temperature length as log2 (0..SENSOR_FILTER_MAX_LOG2),
+ *                         or IIR section
+ * @return true if set, false if an argument is out of range
+ */
+bool sensor_sampling_set_filter(sensor_filter_mode_t mode, uint8_t pressure_log2,
+                                uint8_t temperature_log2);
+
+/**
+ * @brief Set the spike-rejection median ahead of the filter stage
+ * 
+ * Each channel of a compensated sample is replaced by the median of its
+ * last 3 or 5 values (a fixed compare-exchange network, no sorting loop),
+ * so a single wild conversion, such as a glitched I2C2 ADC read, never
+ * reaches the filter, adaptive OSR or the outputs. Costs (window - 1) / 2
+ * samples of delay. Restarts the filter stage.
+ * 
+ * @param window 3 or 5 samples, 0 or 1 = off
+ * @return true if set, false if out of range
+ */
+bool sensor_sampling_set_median(uint8_t window);
+
+/**
+ * @brief Get the filter configuration
+ * 
+ * @return Mode [7:0], pressure log2 [15:8], temperature log2 [23:16],
+ *         median window [27:24] (the HOST_CMD_SET_FILTER argument)
+ */
+uint32_t sensor_sampling_get_filter(void);
+
+/**
+ * @brief Set the SENSOR_IIR_CUSTOM section
+ * 
+ * Channels running it restart with the new coefficients at the next
+ * sample. Not stored in the configuration block: until set, the section
+ * passes samples through unchanged.
+ * 
+ * @param coeffs Section, |b0|, |b1|, |b2| <= SENSOR_IIR_ONE
+ * @return true if set, false if NULL, out of range or unstable
+ */
+bool sensor_sampling_set_iir_coeffs(const sensor_iir_coeffs_t *coeffs);
+
+/**
+ * @brief Get sampler status
+ * 
+ * Reports SENSOR_STATUS_WARMING_UP from sensor_sampling_start() until the
+ * first valid sample (bring-up runs asynchronously in the state machine),
+ * and SENSOR_STATUS_STALE while the latest sample is still valid but older
+ * than the stale limit: a sampler that stops without an error keeps its
+ * last sample valid.
+ * 
+ * @return Current status
+ */
+sensor_status_t sensor_sampling_get_status(void);
+
+/**
+ * @brief Set the stale limit
+ * 
+ * Default BOARD_SAMPLE_STALE_MS. Set it well above the sample period
+ * (decimation included); 0 turns stale detection off.
+ * 
+ * @param limit_ms Largest sample age still served as fresh, ms
+ */
+void sensor_sampling_set_stale_limit_ms(uint16_t limit_ms);
+
+/**
+ * @brief Get the stale limit
+ * 
+ * @return Limit in ms, 0 = off
+ */
+uint16_t sensor_sampling_get_stale_limit_ms(void);
+
+/**
+ * @brief Age of a sample
+ * 
+ * @param sample Sample with a hal_tim2_get_timestamp_us() timestamp
+ * @return Microseconds since its pressure conversion started
+ */
+uint32_t sensor_sampling_get_age_us(const sensor_data_t *sample);
+
+/**
+ * @brief Judge a sample against the stale limit
+ * 
+ * Cheap enough for every consumer: one timer read and a compare.
+ * 
+ * @param sample Sample to judge
+ * @return true if invalid, or older than the limit (limit set)
+ */
+bool sensor_sampling_is_stale(const sensor_data_t *sample);
+
+/**
+ * @brief Get the state machine state, for diagnostics (fault.h)
+ * 
+ * @return State, as numbered in sensor_sampling.c (tools/probe_decode.py
+ *         reads the names from there)
+ */
+uint8_t sensor_sampling_get_state(void);
+
+/**
+ * @brief Get the sampler error counters
+ * 
+ * After an error the next tick recovers: a bus-level fault (bus error,
+ * arbitration loss, timeout, line held low) first frees the bus and
+ * re-initializes I2C2, then sampling resumes on that same tick.
+ * 
+ * @param stats Receives a copy of the counters
+ */
+void sensor_sampling_get_error_stats(sensor_error_stats_t *stats);
+
+/**
+ * @brief Get the sampling tick deadline counters
+ * 
+ * An overrun is a tick whose handler returned after the next tick was due
+ * (hal_tim2_tick_pending()); with none, every tick met its deadline.
+ * 
+ * @param stats Receives a copy of the counters
+ */
+void sensor_sampling_get_tick_stats(sensor_tick_stats_t *stats);
+
+/**
+ * @brief Get the sampling jitter statistics
+ * 
+ * @param stats Receives one consistent snapshot
+ */
+void sensor_sampling_get_jitter_stats(sensor_jitter_stats_t *stats);
+
+/**
+ * @brief Start the jitter statistics over from the next sample
+ * 
+ * Also done by sensor_sampling_set_rate_hz().
+ */
+void sensor_sampling_reset_jitter(void);
+
+/**
+ * @brief Copy every raw pair passing the bottom half to the raw capture ring
+ * 
+ * For a raw trace (flash_log_start_raw()); flash log builds only.
+ * 
+ * @param enable true to start copying, false to stop
+ * @return true if set, false if not built in (BOARD_FLASH_LOG_ENABLE)
+ */
+bool sensor_sampling_set_raw_capture(bool enable);
+
+/**
+ * @brief Drain the raw capture ring
+ * 
+ * A pair that finds the ring full is dropped (a gap in the sequence).
+ * 
+ * @param out Destination array, oldest pair first
+ * @param max_records Capacity of `out`
+ * @return Number of pairs copied
+ */
+uint32_t sensor_sampling_read_raw(sensor_raw_record_t *out, uint32_t max_records);
+
+/**
+ * @brief PROM coefficients C0..C6 in use
+ * 
+ * @param words Receives 7 words
+ * @return true if the sensor is running (coefficients loaded)
+ */
+bool sensor_sampling_get_prom(uint16_t *words);
+
+/**
+ * @brief Register the sampler event callback
+ * 
+ * Lets the main loop sleep until there is work instead of polling after
+ * every wakeup.
+ * 
+ * @param callback Function to call (NULL to disable)
+ */
+void sensor_sampling_register_event_callback(sensor_sampling_event_cb_t callback);
+
+/**
+ * @brief Register the direct sample consumer
+ * 
+ * Runs ahead of everything else the bottom half does with a sample; its
+ * path from the compensation is timed at PROF_SITE_DAC_DIRECT.
+ * 
+ * @param callback Function to call (NULL to disable)
+ */
+void sensor_sampling_register_direct_callback(sensor_sampling_direct_cb_t callback);
+
+/**
+ * @brief Register the published sample consumer
+ * 
+ * Also gets the samples the ring has no room for.
+ * 
+ * @param callback Function to call (NULL to disable)
+ */
+void sensor_sampling_register_publish_callback(sensor_sampling_publish_cb_t callback);
+
+/**
+ * @brief Background work of the sampler
+ * 
+ * Must be called from the main loop. Writes the calibration cache to data
+ * EEPROM after a cold bring-up (blocking, a few ms once).
+ */
+void sensor_sampling_poll(void);
+
+/**
+ * @brief Enable accurate (second-order) temperature compensation
+ * 
+ * Corrects the drift of first-order compensation below 20°C. Integer-only
+ * and branch-free, so per-sample cost barely changes. Off by default.
+ * 
+ * @param enable true to apply the second-order correction
+ */
+void sensor_sampling_set_second_order(bool enable);
+
 /**
  * @brief Get latest sensor data
  * 
  * Retrieves the most recently sampled pressure and temperature values.
- * This function is safe to call from the main application loop.
+ * This function is safe to call from the main application loop: the copy
+ * is retried if the sampler publishes a new sample meanwhile, so the
+ * pressure/temperature pair is never torn.
  * 
  * @param data Pointer to sensor_data_t structure to fill
- * @return true if data is valid, false if no valid data available
+ * @return true if data is valid and not stale, false if no valid data
+ *         available (`data->valid` still tells a stale sample)
  */
 bool sensor_sampling_get_data(sensor_data_t *data);
 
+/**
+ * @brief Drain samples from the sample ring
+ * 
+ * Every sample is queued in a fixed-capacity single-producer /
+ * single-consumer ring, so none are lost while the main loop sleeps or
+ * runs slow (up to the ring capacity). Lock-free: does not disable
+ * interrupts. Call from one consumer context only.
+ * 
+ * @param out Destination array, oldest sample first
+ * @param max_samples Capacity of `out`
+ * @return Number of samples copied
+ */
+uint32_t sensor_sampling_read_batch(sensor_data_t *out, uint32_t max_samples);
+
+/**
+ * @brief Get the number of samples waiting in the ring
+ * 
+ * @return Samples available to sensor_sampling_read_batch()
+ */
+uint32_t sensor_sampling_available(void);
+
+/**
+ * @brief Get the number of samples dropped because the ring was full
+ * 
+ * Includes raw pairs dropped when the bottom half fell behind.
+ * 
+ * @return Overrun count since sensor_sampling_init()
+ */
+uint32_t sensor_sampling_get_overruns(void);
+
 /**
  * @brief Timer interrupt handler
  * 
@@ -82,6 +744,38 @@ bool sensor_sampling_get_data(sensor_data_t *data);
  */
 void sensor_sampling_timer_isr(void);
 
+/**
+ * @brief External sync edge: one sampling step in place of the tick
+ * 
+ * Called from the EXTI vector (timebase priority); ignored unless the sync
+ * input is selected (with BOARD_RAM_VECTORS_ENABLE only installed then).
+ * 
+ * @param edge_us Timestamp taken on entry to the vector
+ */
+void sensor_sampling_sync_isr(uint32_t edge_us);
+
+/**
+ * @brief Conversion-complete interrupt handler
+ * 
+ * This function should be called from the TIM2 CH1 output compare callback
+ * scheduled by the sampler in SENSOR_MODE_EXACT. It reads the finished
+ * conversion.
+ * 
+ * NOTE: This function must be called from interrupt context.
+ */
+void sensor_sampling_conversion_isr(void);
+
+/**
+ * @brief Bottom half: compensate and publish captured samples
+ * 
+ * This function should be called from PendSV_Handler(), which the sampling
+ * interrupts pend after capturing a raw D1/D2 pair. Runs compensation,
+ * updates the latest sample and the ring, and steps the adaptive OSR.
+ * 
+ * NOTE: This function must run at a lower priority than the sampling ISRs.
+ */
+void sensor_sampling_bottom_half(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,232 @@
+/**
+ * @file sensor_vote.c
+ * @brief Redundant-probe voting implementation
+ *
+ * At most one vote per new probe sample, over at most
+ * SENSOR_ARRAY_MAX_CHANNELS values: the medians come from an insertion
+ * sort, and the mean from the deviations off the median, which the
+ * tolerances bound, times a Q16 reciprocal of the count, all in 32 bits.
+ */
+
+#include "sensor_vote.h"
+
+#if BOARD_SENSOR_VOTE_ENABLE
+
+#include <stddef.h>
+#include <string.h>
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+/* A probe sample this far from the one voted on sits the vote out */
+#define SENSOR_VOTE_STALE_US  ((int32_t)(1000000UL * BOARD_SENSOR_VOTE_STALE_TICKS / BOARD_TIM2_FREQ_HZ))
+
+#define SENSOR_VOTE_RECIP_COUNT  (2U * SENSOR_ARRAY_BUS_CHANNELS + 1U)
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+/* 2^16 / n, rounded */
+static const uint32_t recip_q16[SENSOR_VOTE_RECIP_COUNT] = {
+    0, 65536, 32768, 21845, 16384, 13107, 10923, 9362, 8192,
+    7282, 6554, 5958, 5461, 5041, 4681, 4369, 4096
+};
+
+static sensor_data_t latest[SENSOR_ARRAY_MAX_CHANNELS];  /* Newest sample voted on, per probe */
+static uint16_t latest_mask = 0;                         /* Probes with one */
+static sensor_vote_health_t health;
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static int32_t sensor_vote_abs(int32_t value)
+{
+    return (value < 0) ? -value : value;
+}
+
+/**
+ * @brief Median of n values (n >= 1), sorting them
+ *
+ * An even count gives the mean of the middle two, rounded down.
+ */
+static int32_t sensor_vote_median(int32_t *values, uint32_t n)
+{
+    for (uint32_t i = 1; i < n; i++) {
+        int32_t value = values[i];
+        uint32_t j = i;
+
+        while (j > 0U && values[j - 1U] > value) {
+            values[j] = values[j - 1U];
+            j--;
+        }
+        values[j] = value;
+    }
+
+    if ((n & 1U) != 0U) {
+        return values[n / 2U];
+    }
+    return (int32_t)(((int64_t)values[n / 2U - 1U] + values[n / 2U]) >> 1);
+}
+
+#if BOARD_SENSOR_VOTE_MODE == BOARD_SENSOR_VOTE_MEAN
+/**
+ * @brief Mean of the values within tolerance of the median
+ *
+ * 16 deviations of up to 2000 (the tolerance limit) times 2^16 stay
+ * below 2^31.
+ *
+ * @return The median if none is
+ */
+static int32_t sensor_vote_mean(const int32_t *values, uint32_t n, int32_t median,
+                                int32_t tolerance)
+{
+    int32_t sum = 0;
+    uint32_t count = 0;
+
+    for (uint32_t i = 0; i < n; i++) {
+        int32_t deviation = values[i] - median;
+
+        if (sensor_vote_abs(deviation) <= tolerance) {
+            sum += deviation;
+            count++;
+        }
+    }
+    if (count == 0U) {
+        return median;
+    }
+    return median + ((sum * (int32_t)recip_q16[count] + 0x8000) >> 16);
+}
+#endif
+
+/**
+ * @brief Vote on the newest sample of every probe
+ *
+ * @param trigger Probe sample that started the vote (already in latest)
+ * @param fused Receives the fused sample
+ */
+static void sensor_vote_fuse(const sensor_data_t *trigger, sensor_data_t *fused)
+{
+    int32_t pressure[SENSOR_ARRAY_MAX_CHANNELS];
+    int32_t temperature[SENSOR_ARRAY_MAX_CHANNELS];
+    uint8_t channel[SENSOR_ARRAY_MAX_CHANNELS];
+    uint32_t n = 0;
+    uint16_t error_count = 0;
+    uint8_t quality = SENSOR_QUALITY_CRC_OK | (trigger->quality & SENSOR_QUALITY_RETRIED);
+    int32_t p_median;
+    int32_t t_median;
+
+    for (uint8_t ch = 0; ch < SENSOR_ARRAY_MAX_CHANNELS; ch++) {
+        const sensor_data_t *probe = &latest[ch];
+
+        if ((latest_mask & (1U << ch)) == 0U) {
+            continue;
+        }
+        error_count = (uint16_t)(error_count + probe->error_count);
+        if (sensor_vote_abs((int32_t)(trigger->timestamp_us - probe->timestamp_us)) >=
+            SENSOR_VOTE_STALE_US) {
+            continue;
+        }
+        if ((probe->quality & SENSOR_QUALITY_CRC_OK) == 0U) {
+            quality &= (uint8_t)~SENSOR_QUALITY_CRC_OK;
+        }
+        pressure[n] = probe->pressure;
+        temperature[n] = probe->temperature;
+        channel[n] = ch;
+        n++;
+    }
+
+    /* Sorting the copies: the voters' own values are in latest */
+    p_median = sensor_vote_median(pressure, n);
+    t_median = sensor_vote_median(temperature, n);
+
+    health.voted = 0;
+    health.agreed = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        const sensor_data_t *probe = &latest[channel[i]];
+        uint16_t bit = (uint16_t)(1U << channel[i]);
+
+        health.voted |= bit;
+        if (sensor_vote_abs(probe->pressure - p_median) <= BOARD_SENSOR_VOTE_P_TOLERANCE &&
+            sensor_vote_abs(probe->temperature - t_median) <= BOARD_SENSOR_VOTE_T_TOLERANCE) {
+            health.agreed |= bit;
+        } else if (n >= 3U) {
+            /* Two could not tell which one is off */
+            quality |= SENSOR_QUALITY_OUTVOTED;
+            if (health.outvoted[channel[i]] < UINT8_MAX) {
+                health.outvoted[channel[i]]++;
+            }
+        }
+    }
+    if (n < BOARD_SENSOR_VOTE_QUORUM) {
+        quality |= SENSOR_QUALITY_FEW_VOTES;
+    }
+
+    fused->timestamp_us = trigger->timestamp_us;
+    fused->sequence = health.fused++;
+#if BOARD_SENSOR_VOTE_MODE == BOARD_SENSOR_VOTE_MEAN
+    fused->pressure = sensor_vote_mean(pressure, n, p_median, BOARD_SENSOR_VOTE_P_TOLERANCE);
+    fused->temperature = sensor_vote_mean(temperature, n, t_median, BOARD_SENSOR_VOTE_T_TOLERANCE);
+#else
+    fused->pressure = p_median;
+    fused->temperature = t_median;
+#endif
+    fused->valid = true;
+    fused->quality = quality;
+    fused->error_count = error_count;
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+void sensor_vote_init(void)
+{
+    latest_mask = 0;
+    memset(&health, 0, sizeof(health));
+}
+
+uint32_t sensor_vote_poll(sensor_data_t *fused, uint32_t max)
+{
+    sensor_data_t pending[SENSOR_ARRAY_MAX_CHANNELS];
+    uint8_t pending_channel[SENSOR_ARRAY_MAX_CHANNELS];
+    uint16_t mask = sensor_array_get_active_mask();
+    uint32_t n = 0;
+    uint32_t count = 0;
+
+    /* New samples, in timestamp order */
+    for (uint8_t ch = 0; ch < SENSOR_ARRAY_MAX_CHANNELS; ch++) {
+        sensor_data_t sample;
+        uint32_t i;
+
+        if ((mask & (1U << ch)) == 0U || !sensor_array_get_data(ch, &sample) ||
+            ((latest_mask & (1U << ch)) != 0U && sample.sequence == latest[ch].sequence)) {
+            continue;
+        }
+        for (i = n; i > 0U && (int32_t)(sample.timestamp_us - pending[i - 1U].timestamp_us) < 0; i--) {
+            pending[i] = pending[i - 1U];
+            pending_channel[i] = pending_channel[i - 1U];
+        }
+        pending[i] = sample;
+        pending_channel[i] = ch;
+        n++;
+    }
+
+    for (uint32_t i = 0; i < n && count < max; i++) {
+        latest[pending_channel[i]] = pending[i];
+        latest_mask |= (uint16_t)(1U << pending_channel[i]);
+        sensor_vote_fuse(&pending[i], &fused[count++]);
+    }
+    return count;
+}
+
+void sensor_vote_get_health(sensor_vote_health_t *health_out)
+{
+    if (health_out != NULL) {
+        *health_out = health;
+    }
+}
+
+#endif /* BOARD_SENSOR_VOTE_ENABLE */
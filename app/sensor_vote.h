@@ -0,0 +1,89 @@
+#ifndef SENSOR_VOTE_H
+#define SENSOR_VOTE_H
+
+/**
+ * @file sensor_vote.h
+ * @brief Redundant-probe voting over the multi-probe array
+ *
+ * On a rig whose probes all measure the same pressure, the array samples
+ * are merged here into one channel, so the master reads one sample stream
+ * instead of merging several. Every new probe sample starts a vote over
+ * the newest sample of each probe, taken in timestamp order:
+ *   - probes whose newest sample is BOARD_SENSOR_VOTE_STALE_TICKS or more
+ *     sampling ticks away from the one voted on sit it out
+ *   - pressure and temperature each take the median of the rest
+ *     (BOARD_SENSOR_VOTE_MEDIAN), or the mean of the probes within
+ *     BOARD_SENSOR_VOTE_P_TOLERANCE / _T_TOLERANCE of it
+ *     (BOARD_SENSOR_VOTE_MEAN)
+ *   - with three or more voting, a probe off the median by more than the
+ *     tolerance is outvoted, and counted in its health
+ * The fused sample carries the timestamp of the probe sample that started
+ * the vote. The array runs its probes in two interleaved phases
+ * (sensor_array.c), so the fused channel has the aggregate rate of all
+ * probes, evenly spread. Its quality is the AND of the voters' CRC bits,
+ * the OR of their retry bits, SENSOR_QUALITY_OUTVOTED when a probe was
+ * outvoted and SENSOR_QUALITY_FEW_VOTES below BOARD_SENSOR_VOTE_QUORUM.
+ * Health is in the performance bank (perf_bank.h version 6).
+ *
+ * Main loop only. BOARD_SENSOR_VOTE_ENABLE builds.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sensor_array.h"  /* For SENSOR_ARRAY_MAX_CHANNELS */
+#include "board_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * TYPES
+ * ============================================================================ */
+
+/**
+ * @brief Voting health
+ *
+ * Probe masks: bit n = probe on array channel n.
+ */
+typedef struct {
+    uint16_t voted;                                /* Probes in the last vote */
+    uint16_t agreed;                               /* Of those, within the tolerances */
+    uint32_t fused;                                /* Fused samples published */
+    uint8_t outvoted[SENSOR_ARRAY_MAX_CHANNELS];   /* Votes each probe lost (saturated) */
+} sensor_vote_health_t;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Forget every probe sample and the health counts
+ *
+ * Call after sensor_array_init().
+ */
+void sensor_vote_init(void);
+
+/**
+ * @brief Vote on the probe samples not voted on yet
+ *
+ * Samples left over once the output is full stay for the next call.
+ *
+ * @param fused Receives one fused sample per vote, oldest first
+ * @param max Room in fused
+ * @return Fused samples written (0 if no new probe sample)
+ */
+uint32_t sensor_vote_poll(sensor_data_t *fused, uint32_t max);
+
+/**
+ * @brief Get the voting health
+ *
+ * @param health Receives it
+ */
+void sensor_vote_get_health(sensor_vote_health_t *health);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SENSOR_VOTE_H */
@@ -0,0 +1,143 @@
+/**
+ * @file time_sync.c
+ * @brief Mapping of the local timebase onto the master's clock implementation
+ *
+ * The mapping in 32-bit wrapping arithmetic: dl is taken signed, so
+ * samples from before the last exchange map as well as later ones, for
+ * about 35 minutes either side. The drift correction divides in 64 bits
+ * once per exchange; a mapping is one 32x32 multiply.
+ *
+ * The update works on locals and stores the new mapping with interrupts
+ * masked, so an interrupt mapping a timestamp never sees half of one.
+ */
+
+#include "time_sync.h"
+#include "hal_atomic.h"
+
+#include <stddef.h>
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static time_sync_state_t state = TIME_SYNC_NONE;
+static uint32_t ref_local = 0;
+static uint32_t ref_master = 0;
+static uint32_t last_local = 0;   /* Exchange the drift was last measured from */
+static uint32_t last_master = 0;
+static int32_t skew = 0;          /* Parts per 2^32 */
+static int32_t residual = 0;
+static uint32_t exchanges = 0;
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static int32_t time_sync_clamp(int64_t value)
+{
+    if (value > TIME_SYNC_SKEW_MAX) {
+        return TIME_SYNC_SKEW_MAX;
+    }
+    return (value < -TIME_SYNC_SKEW_MAX) ? -TIME_SYNC_SKEW_MAX : (int32_t)value;
+}
+
+/**
+ * @brief Store the mapping time_sync_to_master() uses, all at once
+ */
+static void time_sync_commit(uint32_t local_us, uint32_t master_us, int32_t new_skew,
+                             time_sync_state_t new_state)
+{
+    uint32_t primask = hal_crit_enter();
+
+    ref_local = local_us;
+    ref_master = master_us;
+    skew = new_skew;
+    state = new_state;
+    hal_crit_exit(primask);
+}
+
+static void time_sync_restart(uint32_t local_us, uint32_t master_us)
+{
+    last_local = local_us;
+    last_master = master_us;
+    residual = 0;
+    exchanges = 1;
+    time_sync_commit(local_us, master_us, 0, TIME_SYNC_OFFSET);
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+void time_sync_update(uint32_t local_us, uint32_t master_us)
+{
+    int32_t dl;
+    int64_t error;
+    int32_t new_skew;
+
+    if (state == TIME_SYNC_NONE) {
+        time_sync_restart(local_us, master_us);
+        return;
+    }
+
+    residual = (int32_t)(master_us - time_sync_to_master(local_us));
+    if (residual > TIME_SYNC_MAX_RESIDUAL_US || residual < -TIME_SYNC_MAX_RESIDUAL_US) {
+        time_sync_restart(local_us, master_us);
+        return;
+    }
+    if (exchanges != UINT32_MAX) {
+        exchanges++;
+    }
+
+    /* Drift over the span since the last measurement, against the estimate:
+     * taken whole the first time, a quarter of it after that */
+    dl = (int32_t)(local_us - last_local);
+    if (dl < (int32_t)TIME_SYNC_MIN_INTERVAL_US) {
+        time_sync_commit(local_us, master_us, skew, state);
+        return;
+    }
+    error = (int64_t)(int32_t)((master_us - last_master) - (uint32_t)dl) * 4294967296LL / dl - skew;
+    new_skew = time_sync_clamp((state == TIME_SYNC_LOCKED) ? skew + error / 4 : skew + error);
+    last_local = local_us;
+    last_master = master_us;
+    time_sync_commit(local_us, master_us, new_skew, TIME_SYNC_LOCKED);
+}
+
+void time_sync_rate_changed(uint32_t local_us)
+{
+    if (state == TIME_SYNC_NONE) {
+        return;
+    }
+
+    last_master = time_sync_to_master(local_us);
+    last_local = local_us;
+    time_sync_commit(local_us, last_master, skew, TIME_SYNC_OFFSET);
+}
+
+uint32_t time_sync_to_master(uint32_t local_us)
+{
+    int32_t dl = (int32_t)(local_us - ref_local);
+
+    if (state == TIME_SYNC_NONE) {
+        return local_us;
+    }
+    return ref_master + (uint32_t)dl + (uint32_t)(int32_t)(((int64_t)dl * skew) >> 32);
+}
+
+time_sync_state_t time_sync_get_state(void)
+{
+    return state;
+}
+
+void time_sync_get_status(time_sync_status_t *status)
+{
+    if (status == NULL) {
+        return;
+    }
+
+    status->state = state;
+    status->offset_us = ref_master - ref_local;
+    status->skew_q32 = skew;
+    status->residual_us = residual;
+    status->exchanges = exchanges;
+}
@@ -0,0 +1,107 @@
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+/**
+ * @file time_sync.h
+ * @brief Mapping of the local timebase onto the master's clock
+ *
+ * The master writes HOST_CMD_TIME_SYNC with its own clock (us, low 32 bits)
+ * read as it issues the START; the slave pairs it with its timebase taken
+ * at address match of the same write (i2c_slave_get_write_time_us()). Each
+ * pair re-phases the mapping; pairs at least TIME_SYNC_MIN_INTERVAL_US
+ * apart also correct the drift estimate by a quarter of the drift they
+ * measure, so a few exchanges settle it to well under a ppm:
+ *   master = ref_master + dl + (dl * skew) / 2^32,  dl = local - ref_local
+ * The constant delay from START to address match (about 10 bit times)
+ * lands in the offset: the master subtracts it, or leaves it, as it likes.
+ *
+ * Once synchronized, the timestamps the master reads (APP_REG_TIMESTAMP and
+ * the FIFO frames) are in its clock, so the samples of several boards line
+ * up. Logs, statistics and the diagnostic registers keep the local
+ * timebase. The sampling tick itself is not slewed: its period is whole
+ * timer counts, far coarser than the drift.
+ *
+ * Main loop only, except time_sync_to_master(), which an interrupt may
+ * call too (the slave live block, BOARD_SLAVE_DIRECT_ENABLE).
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+#define TIME_SYNC_MIN_INTERVAL_US  100000UL   /* Shorter spacing only re-phases */
+#define TIME_SYNC_MAX_RESIDUAL_US  1000000L   /* A larger error starts over (clock stepped) */
+#define TIME_SYNC_SKEW_MAX         4294967L   /* 1000 ppm, parts per 2^32 */
+
+/**
+ * @brief Synchronization state (APP_REG_SYNC_STATE)
+ */
+typedef enum {
+    TIME_SYNC_NONE = 0,   /* Local timebase only */
+    TIME_SYNC_OFFSET,     /* One exchange: offset known, drift not yet */
+    TIME_SYNC_LOCKED      /* Offset and drift tracked */
+} time_sync_state_t;
+
+/**
+ * @brief Estimate (diagnostics)
+ */
+typedef struct {
+    time_sync_state_t state;
+    uint32_t offset_us;    /* master - local at the last exchange (mod 2^32) */
+    int32_t skew_q32;      /* Master rate / local rate - 1, parts per 2^32 */
+    int32_t residual_us;   /* Error of the prediction at the last exchange */
+    uint32_t exchanges;    /* Since the last start over */
+} time_sync_status_t;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Take one exchange
+ *
+ * @param local_us Local timebase at address match of the write
+ * @param master_us Master clock written with it
+ */
+void time_sync_update(uint32_t local_us, uint32_t master_us);
+
+/**
+ * @brief The local clock changed rate (HSI trim, clock_trim.h)
+ *
+ * Keeps the mapping continuous at local_us and takes the drift measured
+ * by the next exchange whole, from this point on, instead of a quarter
+ * of it against an estimate that no longer holds.
+ *
+ * @param local_us Local timebase at the change
+ */
+void time_sync_rate_changed(uint32_t local_us);
+
+/**
+ * @brief Local timestamp in master time (unchanged while not synchronized)
+ */
+uint32_t time_sync_to_master(uint32_t local_us);
+
+/**
+ * @brief Current state
+ */
+time_sync_state_t time_sync_get_state(void);
+
+/**
+ * @brief Current estimate
+ *
+ * @param status Receives it
+ */
+void time_sync_get_status(time_sync_status_t *status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIME_SYNC_H */
@@ -0,0 +1,167 @@
+/**
+ * @file tracker.c
+ * @brief Alpha-beta tracker of pressure and pressure rate
+ *
+ * Units (all in 64 bits, Q16): pressure in Pa (0.01 mbar), rate in Pa per
+ * 2^20 us, so the prediction is a multiply and a shift. With inv ~ 2^32 / dt
+ * (dt in us), the rate correction beta r / dt is (beta r inv) >> 12.
+ * Intervals are held to TRACKER_DT_MIN_US .. TRACKER_DT_MAX_US and the
+ * residual and rate are saturated, which keeps every product below 2^63.
+ * The products are 64 x 32 bits: fixmath.h, not a 64 x 64 __aeabi_lmul.
+ */
+
+#include "tracker.h"
+
+#include <stddef.h>
+#include "board_config.h"
+#include "fixmath.h"
+#include "prof.h"
+#include "hal_atomic.h"     /* For hal_seq_*(), __DMB() */
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define TRACKER_DT_MIN_US    128U          /* Shorter intervals count as this */
+#define TRACKER_DT_MAX_US    (1UL << 24)   /* Longer gaps restart the tracker */
+#define TRACKER_RESIDUAL_MAX (1LL << 37)   /* 2^21 Pa, Q16 */
+#define TRACKER_RATE_MAX     (1LL << 38)   /* 2^22 Pa per 2^20 us, Q16 */
+
+#if BOARD_TRACKER_ALPHA_Q16 == 0 || BOARD_TRACKER_ALPHA_Q16 >= 65536 || \
+    BOARD_TRACKER_BETA_Q24 == 0 || BOARD_TRACKER_BETA_Q24 > BOARD_TRACKER_ALPHA_Q16 * 256
+#error "BOARD_TRACKER_ALPHA_Q16 must be 1..65535 and BOARD_TRACKER_BETA_Q24 1..alpha"
+#endif
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+/* Written by the main loop before it bumps gains_gen; the bottom half
+ * copies them when gains_gen changes */
+static uint32_t alpha_request = BOARD_TRACKER_ALPHA_Q16;
+static uint32_t beta_request = BOARD_TRACKER_BETA_Q24;
+static volatile uint32_t gains_gen = 0;
+
+/* Bottom half only */
+static uint32_t gains_applied = 0xFFFFFFFFUL;  /* gains_gen copied */
+static uint32_t alpha = 0;       /* Q16 */
+static uint32_t beta = 0;        /* Q24 */
+static int64_t x = 0;            /* Pressure, Q16 */
+static int64_t v = 0;            /* Rate, Q16 */
+static uint32_t inv_dt = 0;      /* ~2^32 / dt, 0 = not known yet */
+static uint32_t last_us = 0;
+static bool running = false;
+
+static tracker_output_t output;               /* Under output_seq */
+static volatile uint32_t output_seq = 0;      /* Odd while output is written */
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static int64_t tracker_clamp(int64_t value, int64_t limit)
+{
+    if (value > limit) {
+        return limit;
+    }
+    return (value < -limit) ? -limit : value;
+}
+
+/**
+ * @brief Bring inv_dt to 2^32 / dt
+ *
+ * A Newton step squares the relative error: from within 1/8 the estimate
+ * is exact to 2^-6 after one sample and to the last bit after three. Only
+ * a jump in the interval costs a division.
+ */
+static void tracker_reciprocal(uint32_t dt)
+{
+    uint64_t e = fixmath_umull(dt, inv_dt);  /* 2^32 when exact */
+    
+    if (e < 0xE0000000ULL || e > 0x120000000ULL) {
+        inv_dt = 0xFFFFFFFFUL / dt;
+        return;
+    }
+    inv_dt = (uint32_t)(fixmath_mul_u64_u32((1ULL << 33) - e, inv_dt) >> 32);
+}
+
+static void tracker_publish(uint32_t timestamp_us)
+{
+    hal_seq_write_begin(&output_seq);
+    output.pressure = (int32_t)((x + (1LL << 15)) >> 16);
+    output.rate = (int32_t)(fixmath_mul_s64_u32(v, 1562500UL) >> 30);  /* x 10^8 / 2^36: 0.01 Pa/s */
+    output.timestamp_us = timestamp_us;
+    output.valid = true;
+    hal_seq_write_end(&output_seq);
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+bool tracker_set_gains(uint32_t alpha_q16, uint32_t beta_q24)
+{
+    if (alpha_q16 == 0U || alpha_q16 >= TRACKER_GAIN_ONE ||
+        beta_q24 == 0U || beta_q24 > alpha_q16 * 256U) {
+        return false;
+    }
+    
+    alpha_request = alpha_q16;
+    beta_request = beta_q24;
+    __DMB();
+    gains_gen++;
+    return true;
+}
+
+void tracker_update(const sensor_data_t *sample)
+{
+    uint32_t gen = gains_gen;
+    uint32_t dt = sample->timestamp_us - last_us;
+    int64_t z = (int64_t)sample->pressure * 65536;
+    int64_t r;
+    PROF_BEGIN(PROF_SITE_TRACKER);
+    
+    last_us = sample->timestamp_us;
+    
+    if (!running || gen != gains_applied || dt == 0U || dt > TRACKER_DT_MAX_US) {
+        gains_applied = gen;
+        alpha = alpha_request;
+        beta = beta_request;
+        x = z;
+        v = 0;
+        inv_dt = 0;
+        running = true;
+        tracker_publish(sample->timestamp_us);
+        PROF_END(PROF_SITE_TRACKER);
+        return;
+    }
+    if (dt < TRACKER_DT_MIN_US) {
+        dt = TRACKER_DT_MIN_US;
+    }
+    tracker_reciprocal(dt);
+    
+    x += fixmath_mul_s64_u32(v, dt) >> 20;
+    r = tracker_clamp(z - x, TRACKER_RESIDUAL_MAX);
+    x += fixmath_mul_s64_u32(r, alpha) >> 16;
+    r = fixmath_mul_s64_u32(r, beta) >> 24;
+    v = tracker_clamp(v + (fixmath_mul_s64_u32(r, inv_dt) >> 12), TRACKER_RATE_MAX);
+    
+    tracker_publish(sample->timestamp_us);
+    PROF_END(PROF_SITE_TRACKER);
+}
+
+bool tracker_get(tracker_output_t *out)
+{
+    uint32_t seq;
+    
+    if (out == NULL) {
+        return false;
+    }
+    
+    do {
+        seq = hal_seq_read_begin(&output_seq);
+        *out = output;
+    } while (hal_seq_read_retry(&output_seq, seq));
+    
+    return out->valid;
+}
@@ -0,0 +1,83 @@
+#ifndef TRACKER_H
+#define TRACKER_H
+
+/**
+ * @file tracker.h
+ * @brief Alpha-beta tracker of pressure and pressure rate
+ *
+ * A two-state (pressure, rate) tracker run on every compensated sample in
+ * the bottom half, after spike rejection and before the filter stage, with
+ * the interval taken from the sample timestamps:
+ *   predict  x' = x + v dt
+ *   correct  r = z - x',  x = x' + alpha r,  v = v + beta r / dt
+ * The steady-state Kalman filter of a constant-rate model has this form,
+ * with beta = alpha^2 / (2 - alpha). Fixed point throughout: pressure and
+ * rate are Q16 in 64 bits, and 1 / dt is kept as a Q32 reciprocal refined
+ * by one Newton step per sample (two multiplies), so the Cortex-M0+ only
+ * divides when the interval jumps by more than 1/8 (a rate change).
+ *
+ * Producer: bottom half (tracker_update()). Consumer: main loop.
+ * Single-sensor builds only.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sensor_sampling.h"  /* For sensor_data_t type */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+#define TRACKER_GAIN_ONE  65536U  /* 1.0 in Q16 (alpha) */
+
+/**
+ * @brief Tracker output for one sample
+ */
+typedef struct {
+    int32_t pressure;       /* Tracked pressure, 0.01 mbar */
+    int32_t rate;           /* Pressure rate, 0.01 Pa/s (0.0001 mbar/s) */
+    uint32_t timestamp_us;  /* Timestamp of the sample */
+    bool valid;             /* False until the first sample */
+} tracker_output_t;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Set the gains; the tracker restarts at the next sample
+ *
+ * @param alpha_q16 Pressure gain, Q16 (1..TRACKER_GAIN_ONE - 1)
+ * @param beta_q24 Rate gain, Q24 (1..alpha; alpha^2 / (2 - alpha) for the
+ *                 Kalman steady state)
+ * @return true if set, false if out of range
+ */
+bool tracker_set_gains(uint32_t alpha_q16, uint32_t beta_q24);
+
+/**
+ * @brief Track one compensated sample (bottom half only)
+ *
+ * Restarts on the sample after a gap over ~16 s or a timestamp that does
+ * not advance.
+ *
+ * @param sample Compensated sample
+ */
+void tracker_update(const sensor_data_t *sample);
+
+/**
+ * @brief Latest tracker output
+ *
+ * @param out Receives the output of the newest sample
+ * @return out->valid
+ */
+bool tracker_get(tracker_output_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRACKER_H */
@@ -0,0 +1,138 @@
+/**
+ * @file warm_restart.c
+ * @brief Sampling state kept across a reset implementation
+ *
+ * The record is rewritten at every boot: cold, it is opened with no
+ * settings; warm, the settings are copied out first. Each write ends with
+ * the check word, so a reset in the middle of a write leaves a record that
+ * fails it, and the boot after is cold.
+ */
+
+#include "warm_restart.h"
+
+#if BOARD_WARM_RESTART_ENABLE
+
+#include <stddef.h>
+#include <string.h>
+#include "stm32l0xx_hal.h"
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define WARM_RESTART_MAGIC  0x4D524157UL  /* "WARM" */
+
+/* Any of these: SRAM lost or not to be trusted */
+#define WARM_RESTART_COLD_FLAGS  (RCC_CSR_PORRSTF | RCC_CSR_OBLRSTF | RCC_CSR_LPWRRSTF | \
+                                  RCC_CSR_FWRSTF)
+
+/**
+ * @brief Record kept in .noinit
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;
+    uint32_t image;              /* Load address of .data: differs between images */
+    uint32_t settings_valid;
+    config_block_t settings;
+    uint32_t check;
+} warm_restart_record_t;
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static warm_restart_record_t warm_record NOINIT;
+
+static config_block_t warm_settings;  /* Previous boot's, copied out */
+static bool warm_boot = false;
+static bool warm_have_settings = false;
+static uint32_t reset_flags = 0;
+
+extern uint32_t _sidata[];
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Check word of the record
+ */
+static uint32_t warm_restart_check(const warm_restart_record_t *record)
+{
+    const uint32_t *word = (const uint32_t *)record;
+    uint32_t check = 0;
+
+    for (uint32_t i = 0; i < offsetof(warm_restart_record_t, check) / sizeof(uint32_t); i++) {
+        check = ((check << 5) | (check >> 27)) ^ word[i];
+    }
+    return ~check;
+}
+
+/**
+ * @brief Seal the record after a change
+ */
+static void warm_restart_seal(void)
+{
+    warm_record.check = warm_restart_check(&warm_record);
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+void warm_restart_init(void)
+{
+    reset_flags = RCC->CSR & 0xFF000000UL;
+    __HAL_RCC_CLEAR_RESET_FLAGS();
+
+    warm_boot = (reset_flags & WARM_RESTART_COLD_FLAGS) == 0U &&
+                warm_record.magic == WARM_RESTART_MAGIC &&
+                warm_record.version == WARM_RESTART_VERSION &&
+                warm_record.size == sizeof(warm_restart_record_t) &&
+                warm_record.image == (uint32_t)_sidata &&
+                warm_record.check == warm_restart_check(&warm_record);
+    warm_have_settings = warm_boot && warm_record.settings_valid != 0U;
+    if (warm_have_settings) {
+        warm_settings = warm_record.settings;
+    }
+
+    /* Open the record for this boot: settings follow once set */
+    memset(&warm_record, 0, sizeof(warm_record));
+    warm_record.magic = WARM_RESTART_MAGIC;
+    warm_record.version = WARM_RESTART_VERSION;
+    warm_record.size = (uint16_t)sizeof(warm_restart_record_t);
+    warm_record.image = (uint32_t)_sidata;
+    warm_restart_seal();
+}
+
+bool warm_restart_is_warm(void)
+{
+    return warm_boot;
+}
+
+uint32_t warm_restart_get_reset_flags(void)
+{
+    return reset_flags;
+}
+
+const config_block_t *warm_restart_get_settings(void)
+{
+    return warm_have_settings ? &warm_settings : NULL;
+}
+
+void warm_restart_save_settings(const config_block_t *settings)
+{
+    warm_record.check = 0;  /* Invalid while the copy is half done */
+    warm_record.settings = *settings;
+    warm_record.settings_valid = 1U;
+    warm_restart_seal();
+}
+
+void warm_restart_invalidate(void)
+{
+    warm_record.magic = 0;
+}
+
+#endif /* BOARD_WARM_RESTART_ENABLE */
@@ -0,0 +1,98 @@
+#ifndef WARM_RESTART_H
+#define WARM_RESTART_H
+
+/**
+ * @file warm_restart.h
+ * @brief Sampling state kept across a watchdog, fault or software reset
+ *
+ * SRAM keeps its contents through every reset but a power-on or brownout
+ * one, and .noinit (linker.ld) is left alone by Reset_Handler. A warm
+ * boot takes over from there instead of starting cold:
+ *   - the running settings, as the last command left them (config.h
+ *     layout), in place of the stored ones
+ *   - the sensor's PROM coefficients, so bring-up sends no reset and
+ *     reads no PROM: the first conversion starts on the first tick
+ *     (sensor_sampling_resume())
+ *   - the sample sequence counter, so the master sees the gap the reset
+ *     left and no restart from 0
+ *   - the FIFO frame the master has not taken yet (host_fifo_resume())
+ * The settings live here, checked by a word over this module's record;
+ * the owners keep the rest in their own NOINIT variables with their own
+ * checks. A boot is warm when the reset flags show no power-on, brownout,
+ * option byte or low-power reset, and the record is intact and was
+ * written by this same image (its load address of .data and its size),
+ * since another image lays .noinit out differently. A firmware swap
+ * invalidates it first anyway.
+ *
+ * Timestamps restart with the timebase: a resumed FIFO frame holds
+ * samples from before the reset, in the timebase (or master time) of
+ * then. Built only with BOARD_WARM_RESTART_ENABLE; main loop only.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board_config.h"
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+#define WARM_RESTART_VERSION  1U
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Decide between a warm and a cold boot
+ *
+ * Reads and clears the reset flags (RCC_CSR). Call once, early in main(),
+ * before anything keeps state in .noinit.
+ */
+void warm_restart_init(void);
+
+/**
+ * @brief This boot resumes the previous one
+ *
+ * @return true if warm_restart_init() found the state of the previous
+ *         boot intact
+ */
+bool warm_restart_is_warm(void);
+
+/**
+ * @brief Reset flags of this boot
+ *
+ * @return RCC_CSR reset flags [31:24] as warm_restart_init() found them
+ */
+uint32_t warm_restart_get_reset_flags(void);
+
+/**
+ * @brief Running settings of the previous boot
+ *
+ * @return The settings (config_block_t layout, no magic or CRC), or NULL
+ *         on a cold boot or when the previous boot recorded none
+ */
+const config_block_t *warm_restart_get_settings(void);
+
+/**
+ * @brief Record the running settings, for the next warm boot
+ *
+ * @param settings Settings now in effect
+ */
+void warm_restart_save_settings(const config_block_t *settings);
+
+/**
+ * @brief Make the next boot cold (before a firmware swap)
+ */
+void warm_restart_invalidate(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WARM_RESTART_H */
@@ -0,0 +1,195 @@
+/**
+ * @file wave.c
+ * @brief Double-buffered DAC waveform tables implementation
+ *
+ * The player owns the active index: the main loop only changes it while
+ * nothing plays, and otherwise leaves a swap pending for the DMA interrupt
+ * to take at the end of a period. The upload table is the other one, and
+ * an upload is not opened while a swap is pending, so the player and the
+ * sink never touch the same table. Sink and main loop share the upload
+ * state; the main loop changes it with the I2C1 interrupt masked.
+ */
+
+#include "wave.h"
+
+#if BOARD_DAC_WAVE_ENABLE
+
+#include <string.h>
+#include "crc.h"
+#include "hal_config.h"  /* For hal_irq_mask() */
+#include "i2c_slave.h"   /* For I2C_SLAVE_SINK_MAX */
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#if 2U + 4U * WAVE_CHUNK_SAMPLES > I2C_SLAVE_SINK_MAX
+#error "WAVE_CHUNK_SAMPLES does not fit a sink write"
+#endif
+
+#define WAVE_CHUNK_HEADER  2U  /* Sequence */
+#define WAVE_SAMPLE_BYTES  4U
+
+typedef enum {
+    WAVE_UPLOAD_IDLE = 0,
+    WAVE_UPLOAD_RECEIVING,
+    WAVE_UPLOAD_FAILED
+} wave_upload_state_t;
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+/* Samples as received: [15:0] OUT1, [31:16] OUT2 (little-endian pairs) */
+static uint32_t tables[2][BOARD_DAC_WAVE_SAMPLES];
+static uint16_t lengths[2];              /* 0: no table */
+static volatile uint8_t active = 0;      /* Played; the DMA interrupt swaps while playing */
+static volatile bool swap_pending = false;
+static uint32_t play_index = 0;          /* DMA interrupt only while playing */
+
+static volatile uint8_t upload_state = WAVE_UPLOAD_IDLE;
+static uint8_t upload_table = 1;
+static uint32_t upload_samples = 0;
+static uint32_t upload_filled = 0;
+static uint16_t upload_seq = 0;          /* Next chunk expected */
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Take a pending swap now (nothing plays)
+ */
+static void wave_settle(bool playing)
+{
+    if (swap_pending && !playing) {
+        active ^= 1U;
+        swap_pending = false;
+    }
+}
+
+static uint16_t wave_clip(uint32_t code)
+{
+    return (uint16_t)((code > BOARD_DAC_MAX_CODE) ? BOARD_DAC_MAX_CODE : code);
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+bool wave_begin(uint32_t samples, bool playing)
+{
+    uint32_t masked;
+
+    if (samples == 0U || samples > BOARD_DAC_WAVE_SAMPLES) {
+        return false;
+    }
+    wave_settle(playing);
+    if (swap_pending) {
+        return false;  /* The other table plays from the end of this period */
+    }
+
+    masked = hal_irq_mask(HAL_IRQ_LINES_I2C1);
+    upload_table = (uint8_t)(active ^ 1U);
+    lengths[upload_table] = 0;
+    upload_samples = samples;
+    upload_filled = 0;
+    upload_seq = 0;
+    upload_state = WAVE_UPLOAD_RECEIVING;
+    hal_irq_unmask(masked);
+    return true;
+}
+
+void wave_abort(void)
+{
+    uint32_t masked = hal_irq_mask(HAL_IRQ_LINES_I2C1);
+
+    upload_state = WAVE_UPLOAD_IDLE;
+    hal_irq_unmask(masked);
+}
+
+void wave_sink(const uint8_t *data, uint32_t len)
+{
+    uint32_t count;
+    uint16_t seq;
+
+    if (upload_state != WAVE_UPLOAD_RECEIVING) {
+        return;
+    }
+    if (len < WAVE_CHUNK_HEADER) {
+        upload_state = WAVE_UPLOAD_FAILED;
+        return;
+    }
+
+    seq = (uint16_t)(data[0] | (data[1] << 8));
+    count = (len - WAVE_CHUNK_HEADER) / WAVE_SAMPLE_BYTES;
+    if (upload_seq != 0U && seq == (uint16_t)(upload_seq - 1U)) {
+        return;  /* Sent again: already in */
+    }
+    if (seq != upload_seq || count == 0U ||
+        len != WAVE_CHUNK_HEADER + count * WAVE_SAMPLE_BYTES ||
+        count > upload_samples - upload_filled) {
+        upload_state = WAVE_UPLOAD_FAILED;
+        return;
+    }
+
+    memcpy(&tables[upload_table][upload_filled], &data[WAVE_CHUNK_HEADER], count * WAVE_SAMPLE_BYTES);
+    upload_filled += count;
+    upload_seq++;
+}
+
+bool wave_commit(uint16_t crc, bool playing)
+{
+    uint32_t *table = tables[upload_table];
+    bool ok;
+    uint32_t masked;
+
+    /* Complete: the sink takes no more chunks for it, only fails it */
+    ok = upload_state == WAVE_UPLOAD_RECEIVING && upload_filled == upload_samples &&
+         crc16_update(CRC16_INIT, table, upload_samples * WAVE_SAMPLE_BYTES) == crc;
+
+    masked = hal_irq_mask(HAL_IRQ_LINES_I2C1);
+    ok = ok && upload_state == WAVE_UPLOAD_RECEIVING;
+    upload_state = WAVE_UPLOAD_IDLE;
+    hal_irq_unmask(masked);
+    if (!ok) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < upload_samples; i++) {
+        table[i] = wave_clip(table[i] & 0xFFFFU) | ((uint32_t)wave_clip(table[i] >> 16) << 16);
+    }
+    lengths[upload_table] = (uint16_t)upload_samples;
+
+    /* Table written before the player can take it */
+    __DMB();
+    if (playing) {
+        swap_pending = true;
+    } else {
+        active = upload_table;
+    }
+    return true;
+}
+
+bool wave_rewind(void)
+{
+    wave_settle(false);
+    play_index = 0;
+    return lengths[active] != 0U;
+}
+
+uint32_t wave_next(void)
+{
+    uint32_t sample = tables[active][play_index];
+
+    if (++play_index >= lengths[active]) {
+        play_index = 0;
+        if (swap_pending) {
+            active ^= 1U;
+            swap_pending = false;
+        }
+    }
+    return sample;
+}
+
+#endif /* BOARD_DAC_WAVE_ENABLE */
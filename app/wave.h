@@ -0,0 +1,105 @@
+#ifndef WAVE_H
+#define WAVE_H
+
+/**
+ * @file wave.h
+ * @brief Double-buffered DAC waveform tables uploaded by the master
+ *
+ * Two tables of up to BOARD_DAC_WAVE_SAMPLES code pairs: one is active
+ * (played by the DAC stream, looping), the master uploads into the other.
+ * An upload is opened with its length, then sent in chunks written at
+ * the slave's sink register (i2c_slave_set_sink()): each one goes by DMA
+ * into the receive buffer and is copied into the table at its STOP,
+ * without a command per word or map space. Chunk bytes, little-endian:
+ *   0x00 uint16  chunk sequence, 0 for the first one after wave_begin()
+ *   0x02 uint16  OUT1 code, then uint16 OUT2 code, per sample, up to
+ *                WAVE_CHUNK_SAMPLES samples
+ * A chunk out of sequence, of a partial sample or past the length fails
+ * the upload; the same chunk again (the master did not see it arrive) is
+ * ignored. wave_commit() takes the CRC-16 (crc.h) of all the sample bytes
+ * in order: once it checks, the table takes over from the active one at
+ * the end of its period (the last sample of the active table played), or
+ * at once if nothing plays it. Codes are raw, clipped to
+ * BOARD_DAC_MAX_CODE at the commit.
+ *
+ * Sink: I2C1 interrupt. Player: DAC stream refill (DMA interrupt).
+ * Everything else main loop. Built only with BOARD_DAC_WAVE_ENABLE.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+#define WAVE_CHUNK_SAMPLES  63U  /* (I2C_SLAVE_SINK_MAX - 2) / 4 */
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Open an upload into the table not playing (drops one in progress)
+ *
+ * @param samples Table length, 1..BOARD_DAC_WAVE_SAMPLES
+ * @param playing true if the stream plays the active table
+ * @return true if opened, false if out of range or the other table is
+ *         still waiting for the end of a period
+ */
+bool wave_begin(uint32_t samples, bool playing);
+
+/**
+ * @brief Drop the upload in progress (the active table plays on)
+ */
+void wave_abort(void);
+
+/**
+ * @brief Take a chunk (i2c_slave_sink_cb_t, I2C1 interrupt)
+ *
+ * @param data Chunk bytes
+ * @param len Their number
+ */
+void wave_sink(const uint8_t *data, uint32_t len);
+
+/**
+ * @brief Check the upload and hand it to the player
+ *
+ * @param crc CRC-16 of the sample bytes, as sent
+ * @param playing true if the stream plays the active table: the new one
+ *                takes over at the end of its period
+ * @return true if committed, false if a chunk failed or is missing or the
+ *         CRC does not match (the upload is then dropped)
+ */
+bool wave_commit(uint16_t crc, bool playing);
+
+/**
+ * @brief Play from the first sample of the active table
+ *
+ * Call before the stream starts. A table waiting for the end of a period
+ * becomes active first.
+ *
+ * @return true if there is a table, false if none was committed
+ */
+bool wave_rewind(void);
+
+/**
+ * @brief Next sample of the active table (stream refill)
+ *
+ * At the end of the table it starts over, from the table waiting for the
+ * end of a period if there is one.
+ *
+ * @return [15:0] OUT1 code, [31:16] OUT2 code
+ */
+uint32_t wave_next(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WAVE_H */
@@ -25,6 +25,33 @@
 #define BOARD_I2C2_SDA_PIN         11
 #define BOARD_I2C2_SDA_AF           4  /* AF4 for I2C2_SDA on PB11 */
 
+/* MCU package: 48 (STM32L072CBT6, this board) or 64 (STM32L072RB) */
+#define BOARD_MCU_PACKAGE          48
+
+/* I2C3 - Second probe bus (multi-probe rigs, BOARD_I2C3_MUX_CHANNELS).
+ * LQFP48 only has I2C3 on PA8/PB4, the INTR_MCU and comparator input pins:
+ * with I2C3 in use, move INTR_MCU (or disable it) and leave the comparator
+ * alarm off (checked in hal_config.c). LQFP64 has it on the free PC0/PC1 */
+#if BOARD_MCU_PACKAGE == 64
+#define BOARD_I2C3_SCL_PORT        GPIOC
+#define BOARD_I2C3_SCL_PIN         0
+#define BOARD_I2C3_SCL_AF           7  /* AF7 for I2C3_SCL on PC0 */
+
+#define BOARD_I2C3_SDA_PORT        GPIOC
+#define BOARD_I2C3_SDA_PIN         1
+#define BOARD_I2C3_SDA_AF           7  /* AF7 for I2C3_SDA on PC1 */
+#elif BOARD_MCU_PACKAGE == 48
+#define BOARD_I2C3_SCL_PORT        GPIOA
+#define BOARD_I2C3_SCL_PIN         8
+#define BOARD_I2C3_SCL_AF           7  /* AF7 for I2C3_SCL on PA8 */
+
+#define BOARD_I2C3_SDA_PORT        GPIOB
+#define BOARD_I2C3_SDA_PIN         4
+#define BOARD_I2C3_SDA_AF           7  /* AF7 for I2C3_SDA on PB4 */
+#else
+#error "BOARD_MCU_PACKAGE must be 48 or 64"
+#endif
+
 /* I2C1 - I2C Slave Communication */
 #define BOARD_I2C1_SCL_PORT        GPIOA
 #define BOARD_I2C1_SCL_PIN         9
@@ -43,40 +70,1054 @@
 #define BOARD_DAC1_OUT2_PIN        5
 #define BOARD_DAC1_OUT2_CHANNEL    DAC_CHANNEL_2  /* STM32 HAL define */
 
+/* Analog alarm input (COMP2 non-inverting input IO2) and comparator
+ * output (AF7 COMP2_OUT) */
+#define BOARD_COMP_ALARM_IN_PORT   GPIOB
+#define BOARD_COMP_ALARM_IN_PIN    4
+#define BOARD_COMP_ALARM_OUT_PORT  GPIOA
+#define BOARD_COMP_ALARM_OUT_PIN   7
+#define BOARD_COMP_ALARM_OUT_AF    7  /* AF7 for COMP2_OUT on PA7 */
+
+/* INTR_MCU - Data-ready line to the I2C master (routed to the connector; not
+ * tied to an MCU GPIO in the parsed netlist, wire it to this pin) */
+#define BOARD_INTR_MCU_PORT        GPIOA
+#define BOARD_INTR_MCU_PIN         8
+
 /* ============================================================================
  * PERIPHERAL CONFIGURATIONS
  * ============================================================================ */
 
+/* Interrupt hot paths: 1 runs the TIM2 tick, the I2C2 sensor transfers and
+ * the I2C1 slave on register-level (stm32l0xx_ll_*) handlers, 0 on the HAL
+ * IRQ handlers and callbacks. Initialization is HAL either way, and the DAC
+ * outputs are written straight to DHR12RD in both. make USE_LL_HOTPATH=0/1
+ * overrides it */
+#ifndef BOARD_LL_HOTPATH
+#define BOARD_LL_HOTPATH            1
+#endif
+
+/* Sampling profiles, one row per product variant (make SAMPLING_PROFILE=):
+ *   X(tick_hz, mode, p_osr, t_osr, t_decim, ring, raw_ring, mux)
+ *   tick_hz   Tick rate at boot and the highest accepted (BOARD_TIM2_FREQ_HZ)
+ *   mode      Sampling mode at boot: 0 sequential, 1 pipelined, 2 exact-timed
+ *   p_osr     Pressure and temperature OSR at boot: 0 (256) .. 5 (8192)
+ *   t_osr
+ *   t_decim   Temperature conversion every N cycles, 1..65535
+ *   ring      Published sample ring and raw capture ring, powers of two
+ *   raw_ring
+ *   mux       Populated mux channels (BOARD_SENSOR_MUX_CHANNELS)
+ * A row is every build-time constant of the sampler: its boot settings,
+ * its RAM, the TIM2 period and the conversion commands of the probe scan.
+ * sensor_sampling.c and sensor_array.c do not build a row whose boot
+ * conversions miss its tick */
+#define BOARD_SAMPLING_PROFILE_DEFAULT(X)    X(500U,  1, 0, 0,  1U, 32U,  8U, 0x00)  /* 2 ms tick, 250 samples/s */
+#define BOARD_SAMPLING_PROFILE_HIGH_RATE(X)  X(1000U, 1, 0, 0, 16U, 64U, 16U, 0x00)  /* ~940 pressure samples/s */
+#define BOARD_SAMPLING_PROFILE_LOW_POWER(X)  X(50U,   1, 4, 3,  8U, 16U,  4U, 0x00)  /* OSR 4096/2048, ~25 samples/s */
+#define BOARD_SAMPLING_PROFILE_MULTI(X)      X(500U,  1, 0, 0,  1U, 32U,  8U, 0x0F)  /* Four probes behind the mux */
+#ifndef BOARD_SAMPLING_PROFILE
+#define BOARD_SAMPLING_PROFILE      BOARD_SAMPLING_PROFILE_DEFAULT
+#endif
+
+/* Field of the selected row (usable in #if) */
+#define BOARD_SAMPLING_FIELD(f)     BOARD_SAMPLING_PROFILE(BOARD_SAMPLING_F_##f)
+#define BOARD_SAMPLING_F_TICK_HZ(hz, m, po, to, td, r, rr, mux)  hz
+#define BOARD_SAMPLING_F_MODE(hz, m, po, to, td, r, rr, mux)     m
+#define BOARD_SAMPLING_F_P_OSR(hz, m, po, to, td, r, rr, mux)    po
+#define BOARD_SAMPLING_F_T_OSR(hz, m, po, to, td, r, rr, mux)    to
+#define BOARD_SAMPLING_F_T_DECIM(hz, m, po, to, td, r, rr, mux)  td
+#define BOARD_SAMPLING_F_RING(hz, m, po, to, td, r, rr, mux)     r
+#define BOARD_SAMPLING_F_RAW_RING(hz, m, po, to, td, r, rr, mux) rr
+#define BOARD_SAMPLING_F_MUX(hz, m, po, to, td, r, rr, mux)      mux
+
+#define BOARD_SAMPLING_MODE         BOARD_SAMPLING_FIELD(MODE)
+#define BOARD_SAMPLING_P_OSR        BOARD_SAMPLING_FIELD(P_OSR)
+#define BOARD_SAMPLING_T_OSR        BOARD_SAMPLING_FIELD(T_OSR)
+#define BOARD_SAMPLING_T_DECIMATION BOARD_SAMPLING_FIELD(T_DECIM)
+#define BOARD_SAMPLING_RING         BOARD_SAMPLING_FIELD(RING)
+#define BOARD_SAMPLING_RAW_RING     BOARD_SAMPLING_FIELD(RAW_RING)
+
 /* I2C2 - Pressure Sensor Configuration */
 #define BOARD_I2C2_PERIPH          I2C2
 #define BOARD_I2C2_SENSOR_ADDR     0x76  /* MS583730BA01-50 I2C address */
+#define BOARD_I2C2_MUX_ADDR        0x74  /* TCA9548 I2C mux address (multi-probe rigs) */
+#define BOARD_I2C2_SPEED           HAL_I2C_SPEED_FAST  /* MS5837 and TCA9548 max 400 kHz */
+/* Populated mux channels, bit n = probe on channel n (0 = single sensor,
+ * no mux): from the sampling profile */
+#define BOARD_SENSOR_MUX_CHANNELS  BOARD_SAMPLING_FIELD(MUX)
+#define BOARD_SENSOR_EARLY_RESET   1  /* 1: reset sent after I2C2 init, reload overlaps the other inits */
+/* Sensor variant: picks the compensation kernel at build time (ms58.c),
+ * every shift a constant. A probe whose PROM word 0 names the other
+ * variant fails its calibration. Output units are the same for both */
+#define BOARD_SENSOR_VARIANT_30BA  0  /* 0..30 bar, 0.1 mbar native */
+#define BOARD_SENSOR_VARIANT_02BA  1  /* 0..2 bar, 0.01 mbar native */
+#ifndef BOARD_SENSOR_VARIANT
+#define BOARD_SENSOR_VARIANT       BOARD_SENSOR_VARIANT_30BA
+#endif
+#if BOARD_SENSOR_VARIANT != BOARD_SENSOR_VARIANT_30BA && BOARD_SENSOR_VARIANT != BOARD_SENSOR_VARIANT_02BA
+#error "BOARD_SENSOR_VARIANT must be BOARD_SENSOR_VARIANT_30BA or BOARD_SENSOR_VARIANT_02BA"
+#endif
+/* Sampler failures: an ADC read the sensor NACKs is repeated at once, up
+ * to BOARD_SENSOR_READ_RETRIES times; a bus fault goes through the bus
+ * recovery on the next tick. After BOARD_SENSOR_BACKOFF_AFTER failed
+ * cycles in a row the recovery waits 1, 2, 4 ... ticks between attempts,
+ * up to BOARD_SENSOR_BACKOFF_MAX_TICKS. An ADC read of 0 is a conversion
+ * not finished yet: read once more a quarter of the datasheet time later,
+ * and after BOARD_SENSOR_LATE_WIDEN_AFTER of them at an OSR whose time
+ * was calibrated shorter (conv_tune.h), that OSR waits the datasheet time */
+#define BOARD_SENSOR_READ_RETRIES      1U
+#define BOARD_SENSOR_LATE_WIDEN_AFTER  4U
+#define BOARD_SENSOR_BACKOFF_AFTER     3U
+#define BOARD_SENSOR_BACKOFF_MAX_TICKS 256U
+/* Sensor bus clock gating: the I2C2 (and I2C3) clock is turned off when
+ * the asynchronous transfer queue runs dry, at the STOP of the last
+ * transfer of a group, and back on when the next one is queued, a few
+ * cycles before its START (PROF_SITE_BUS_UNGATE). The registers keep
+ * their contents. Worth it at low rates, where the bus idles between
+ * samples for far longer than it runs. The pins stay in open-drain
+ * alternate function: an idle bus is high and its pull-ups draw nothing */
+#define BOARD_SENSOR_BUS_CLOCK_GATE    (BOARD_LOG_PERIOD_S != 0U)
+
+/* I2C3 - Second probe bus: probes behind a second TCA9548, scanned at the
+ * same time as the I2C2 ones (sensor_array channels 8..15), so the bus
+ * time per scan does not grow with them */
+#define BOARD_I2C3_PERIPH          I2C3
+#define BOARD_I2C3_SENSOR_ADDR     0x76
+#define BOARD_I2C3_MUX_ADDR        0x74
+#define BOARD_I2C3_SPEED           HAL_I2C_SPEED_FAST
+/* Populated I2C3 mux channels, bit n = probe on channel n (0 = I2C3 unused) */
+#define BOARD_I2C3_MUX_CHANNELS    0x00
+#if BOARD_I2C3_MUX_CHANNELS != 0 && BOARD_SENSOR_MUX_CHANNELS == 0
+#error "BOARD_I2C3_MUX_CHANNELS needs the multi-probe rig (BOARD_SENSOR_MUX_CHANNELS)"
+#endif
+
+/* Redundant probes (app/sensor_vote.h): every probe of the rig measures
+ * the same pressure, and the outputs, the sample bus and the master see
+ * one fused channel, voted again on each new probe sample. Probes whose
+ * newest sample is more than BOARD_SENSOR_VOTE_STALE_TICKS sampling ticks
+ * older than the one voted on sit the vote out. Mode 0 publishes the
+ * median; mode 1 the mean of the probes within the tolerances of it. A vote
+ * with fewer than BOARD_SENSOR_VOTE_QUORUM probes flags its sample */
+#define BOARD_SENSOR_VOTE_ENABLE       0
+#define BOARD_SENSOR_VOTE_MEDIAN       0
+#define BOARD_SENSOR_VOTE_MEAN         1
+#define BOARD_SENSOR_VOTE_MODE         BOARD_SENSOR_VOTE_MEAN
+#define BOARD_SENSOR_VOTE_P_TOLERANCE  50    /* 0.01 mbar off the median */
+#define BOARD_SENSOR_VOTE_T_TOLERANCE  100   /* 0.01 degC off the median */
+#define BOARD_SENSOR_VOTE_STALE_TICKS  4U    /* Two pairs: one missed */
+#define BOARD_SENSOR_VOTE_QUORUM       3U
+#if BOARD_SENSOR_VOTE_ENABLE && BOARD_SENSOR_MUX_CHANNELS == 0
+#error "BOARD_SENSOR_VOTE_ENABLE needs the multi-probe rig (BOARD_SENSOR_MUX_CHANNELS)"
+#endif
+#if BOARD_SENSOR_VOTE_MODE != BOARD_SENSOR_VOTE_MEDIAN && BOARD_SENSOR_VOTE_MODE != BOARD_SENSOR_VOTE_MEAN
+#error "BOARD_SENSOR_VOTE_MODE must be BOARD_SENSOR_VOTE_MEDIAN or BOARD_SENSOR_VOTE_MEAN"
+#endif
+#if BOARD_SENSOR_VOTE_P_TOLERANCE < 0 || BOARD_SENSOR_VOTE_P_TOLERANCE > 2000 || \
+    BOARD_SENSOR_VOTE_T_TOLERANCE < 0 || BOARD_SENSOR_VOTE_T_TOLERANCE > 2000
+#error "BOARD_SENSOR_VOTE_P_TOLERANCE and BOARD_SENSOR_VOTE_T_TOLERANCE must be 0 .. 2000"
+#endif
+#if BOARD_SENSOR_VOTE_STALE_TICKS < 2U || BOARD_SENSOR_VOTE_QUORUM < 1U
+#error "BOARD_SENSOR_VOTE_STALE_TICKS must be 2 or more, BOARD_SENSOR_VOTE_QUORUM 1 or more"
+#endif
+
+/* Sensor bus speed tuning (app/bus_tune.h): at boot each sensor bus steps
+ * down from BOARD_I2C_TUNE_TOP until every probe on it gives
+ * BOARD_I2C_TUNE_ROUNDS CRC-checked PROM reads in a row, then runs
+ * BOARD_I2C_TUNE_MARGIN profiles below that one; BOARD_I2Cx_SPEED is
+ * only the fallback. BOARD_I2C_TUNE_ERRORS bus recoveries within
+ * BOARD_I2C_TUNE_WINDOW_MS step I2C2 down once more. FAST_PLUS is past
+ * the MS5837/TCA9548 400 kHz rating: only good with the margin */
+#define BOARD_I2C_TUNE_ENABLE      1
+#define BOARD_I2C_TUNE_TOP         HAL_I2C_SPEED_FAST_PLUS
+#define BOARD_I2C_TUNE_ROUNDS      4U
+#define BOARD_I2C_TUNE_MARGIN      1U   /* Profiles below the fastest that passed */
+#define BOARD_I2C_TUNE_ERRORS      3U
+#define BOARD_I2C_TUNE_WINDOW_MS   10000U
+#if BOARD_I2C_TUNE_ENABLE && (BOARD_I2C_TUNE_ROUNDS == 0U || BOARD_I2C_TUNE_ERRORS == 0U)
+#error "BOARD_I2C_TUNE_ROUNDS and BOARD_I2C_TUNE_ERRORS must be at least 1"
+#endif
+
+/* Boot self-test (app/self_test.h): after the tuning, which probes answer
+ * with a good PROM, the time of a PROM word transaction per bus and of
+ * one compensation, reported in the performance bank (version 4) */
+#define BOARD_SELF_TEST_ENABLE      1
+#define BOARD_SELF_TEST_ROUNDS      2U   /* PROM reads per probe */
+#define BOARD_SELF_TEST_KERNEL_RUNS 64U  /* Compensations per timed batch */
+#if BOARD_SELF_TEST_ENABLE && (BOARD_SELF_TEST_ROUNDS == 0U || BOARD_SELF_TEST_KERNEL_RUNS == 0U)
+#error "BOARD_SELF_TEST_ROUNDS and BOARD_SELF_TEST_KERNEL_RUNS must be at least 1"
+#endif
+
+/* Conversion time calibration (app/conv_tune.h): at a cold boot the
+ * shortest delay at which BOARD_CONV_TUNE_ROUNDS conversions in a row read
+ * non-zero is searched per OSR up to BOARD_CONV_TUNE_TOP_OSR, to
+ * BOARD_CONV_TUNE_STEP_US, and run with BOARD_CONV_TUNE_MARGIN_PCT on top
+ * (never above the datasheet time); higher levels are scaled from the top
+ * one. Single sensor only: the mux rig keeps the datasheet times */
+#ifndef BOARD_CONV_TUNE_ENABLE
+#define BOARD_CONV_TUNE_ENABLE      (BOARD_SENSOR_MUX_CHANNELS == 0)
+#endif
+#define BOARD_CONV_TUNE_TOP_OSR     2U   /* 1024: about 100 ms of trials in all */
+#define BOARD_CONV_TUNE_ROUNDS      4U
+#define BOARD_CONV_TUNE_STEP_US     16U
+#define BOARD_CONV_TUNE_MARGIN_PCT  10U
+#if BOARD_CONV_TUNE_ENABLE && BOARD_SENSOR_MUX_CHANNELS != 0
+#error "BOARD_CONV_TUNE_ENABLE calibrates the single sensor: not with BOARD_SENSOR_MUX_CHANNELS"
+#endif
+#if BOARD_CONV_TUNE_ENABLE && (BOARD_CONV_TUNE_ROUNDS == 0U || BOARD_CONV_TUNE_STEP_US == 0U || \
+                               BOARD_CONV_TUNE_TOP_OSR > 5U)
+#error "BOARD_CONV_TUNE_ROUNDS and BOARD_CONV_TUNE_STEP_US must be at least 1, BOARD_CONV_TUNE_TOP_OSR 0 .. 5"
+#endif
 
 /* I2C1 - I2C Slave Configuration */
 #define BOARD_I2C1_PERIPH           I2C1
 #define BOARD_I2C1_SLAVE_ADDR       0x10  /* Configurable slave address */
+#define BOARD_I2C1_SLAVE_ADDR2      0x00  /* Second address, reads the latest sample with no pointer write (0: off) */
+#define BOARD_I2C1_SLAVE_ADDR2_MASK I2C_OA2_NOMASK  /* Low address bits ignored in the match (I2C_OA2_MASKnn) */
+#define BOARD_I2C1_SPEED            HAL_I2C_SPEED_FAST  /* FAST_PLUS needs Fm+ pull-ups on the master bus */
+#define BOARD_I2C1_SLAVE_DMA        1   /* 1: slave frames by DMA, 0: one interrupt per byte */
+#define BOARD_I2C1_SLAVE_LL         BOARD_LL_HOTPATH  /* 1: register-level slave ISR, 0: HAL slave state machine */
+#define BOARD_I2C1_SLAVE_NOSTRETCH  0   /* 1: never hold SCL, reads preloaded (needs LL + DMA) */
+#define BOARD_I2C1_WAKEUP_STOP      0   /* 1: STOP when idle, woken by address match (HSI kernel clock) */
+#define BOARD_I2C1_GENERAL_CALL     0   /* 1: accept general call (0x00) writes, first byte to the GC callback (LL, stretching) */
+#define BOARD_I2C1_GC_SYNC_CODE     0x0AU  /* General call byte that aligns the sampling tick (not 0x04/0x06 of the I2C spec) */
+#define BOARD_I2C1_SMBUS            0   /* 1: SMBus block read/write, hardware PEC, SCL-low timeout (LL, stretching) */
+#define BOARD_I2C1_SMBUS_BLOCK_MAX  32U /* Register block read length (SMBus 2.0; stream frames go whole, up to 255) */
+#define BOARD_I2C1_SMBUS_TIMEOUT_MS 25U /* SCL held low this long resets the slave (SMBus tTIMEOUT 25..35 ms) */
+#define BOARD_I2C1_TIMEOUT_MS       25U /* Same for plain I2C: a master stalled with SCL low (0: off) */
+#if BOARD_I2C1_SMBUS
+#define BOARD_I2C1_SCL_TIMEOUT_MS   BOARD_I2C1_SMBUS_TIMEOUT_MS
+#else
+#define BOARD_I2C1_SCL_TIMEOUT_MS   BOARD_I2C1_TIMEOUT_MS
+#endif
+/* Slave interrupt load limit: the time in the I2C1 handler is summed over
+ * windows of BOARD_I2C1_LOAD_WINDOW_US, and a window that passes
+ * BOARD_I2C1_LOAD_BUDGET_PCT of it turns the own addresses off until it
+ * ends, so the master's next transactions are address-NACKed instead of
+ * preempting the sampling tick (i2c_slave.h) */
+#define BOARD_I2C1_LOAD_BUDGET_PCT  20U     /* Handler share of a window (0: no limit) */
+#define BOARD_I2C1_LOAD_WINDOW_US   10000UL
+
+#if BOARD_I2C1_LOAD_BUDGET_PCT >= 100U
+#error "BOARD_I2C1_LOAD_BUDGET_PCT must stay below 100"
+#endif
+#if BOARD_I2C1_LOAD_WINDOW_US < 1000UL || BOARD_I2C1_LOAD_WINDOW_US > 60000UL
+#error "BOARD_I2C1_LOAD_WINDOW_US must be 1000..60000"
+#endif
+#define BOARD_I2C1_DMA_TX_CHANNEL   DMA1_Channel2
+#define BOARD_I2C1_DMA_RX_CHANNEL   DMA1_Channel3
+#define BOARD_I2C1_DMA_REQUEST      DMA_REQUEST_6  /* I2C1 on DMA1 channels 2/3 (RM0377 CSELR) */
+#define BOARD_I2C1_DMA_IRQn         DMA1_Channel2_3_IRQn
+
+/* INTR_MCU - Data-ready output (push-pull) */
+#define BOARD_INTR_MCU_ENABLE       1   /* 0: pin left unconfigured */
+#define BOARD_INTR_MCU_ACTIVE_LOW   1   /* 1: low while data is ready */
+#define BOARD_INTR_MCU_WATERMARK    0   /* FIFO samples to assert at, 0: every new sample */
+
+/* Delta/varint sample codec (sample_codec.h) on the FIFO burst, USB stream
+ * and SD log: ~4 bytes per sample instead of 16. Off keeps the fixed
+ * 16-byte layouts */
+#ifndef BOARD_SAMPLE_CODEC_ENABLE
+#define BOARD_SAMPLE_CODEC_ENABLE            0
+#endif
+#define BOARD_SAMPLE_CODEC_KEYFRAME_INTERVAL 64U  /* Samples per keyframe, at most */
+
+/* CRC framing (crc.h): FIFO bursts and USB blocks end in a CRC-16, SD
+ * sectors in a CRC-32, and master commands must carry a CRC-16, all on the
+ * hardware CRC unit. CRC-32 jobs are fed by a memory-to-memory DMA channel.
+ * Off keeps the frames as they were */
+#ifndef BOARD_CRC_FRAMING_ENABLE
+#define BOARD_CRC_FRAMING_ENABLE    0
+#endif
+#define BOARD_CRC_DMA_CHANNEL       DMA1_Channel6  /* Memory to CRC_DR, no request line */
+
+/* Memory-to-memory copies (dma_copy.h): bulk moves run on a DMA channel
+ * while the core works on, completed in its interrupt. Copies shorter
+ * than BOARD_DMA_COPY_MIN_BYTES, or from flash (the flash interface is
+ * gated in sleep), are done at once by memcpy(). Every DMA1 channel has
+ * an owner: this one shares the CRC-32 feed's */
+#define BOARD_DMA_COPY_ENABLE       0
+#define BOARD_DMA_COPY_CHANNEL      DMA1_Channel6  /* No request line */
+#define BOARD_DMA_COPY_IRQn         DMA1_Channel4_5_6_7_IRQn
+#define BOARD_DMA_COPY_MIN_BYTES    64U   /* Shorter: memcpy() beats setting up the channel */
+#define BOARD_DMA_COPY_QUEUE        4U    /* Copies waiting behind the running one (power of 2) */
+#if BOARD_DMA_COPY_ENABLE && BOARD_CRC_FRAMING_ENABLE
+#error "BOARD_DMA_COPY_ENABLE shares DMA1 channel 6 with the CRC-32 feed (BOARD_CRC_FRAMING_ENABLE)"
+#endif
 
 /* Timer Configuration */
 #define BOARD_TIM2_PERIPH           TIM2
-#define BOARD_TIM2_FREQ_HZ          500   /* 500 Hz = 2 ms period */
-#define BOARD_TIM2_PRESCALER        1600  /* Adjust based on system clock */
-#define BOARD_TIM2_PERIOD           1000  /* Adjust based on prescaler */
+#define BOARD_TIM2_FREQ_HZ          BOARD_SAMPLING_FIELD(TICK_HZ)  /* Rate at boot and the highest accepted */
+#define BOARD_TIM2_COUNTER_HZ       1000000UL  /* 1 MHz counter: compare values in us */
+
+/* Sampling timebase behind hal_tim2_*(): TIM2 (1 us resolution, halts in
+ * STOP) or LPTIM1 on LSI (~27 us resolution, counts through STOP, so a
+ * BOARD_I2C1_WAKEUP_STOP build stops between sampling steps) */
+#define BOARD_TIMEBASE_TIM2         0
+#define BOARD_TIMEBASE_LPTIM1       1
+#define BOARD_TIMEBASE              BOARD_TIMEBASE_TIM2
+#define BOARD_LPTIM1_FREQ_HZ        10U      /* Tick rate at start on LPTIM1 (up to BOARD_TIM2_FREQ_HZ) */
+#define BOARD_LPTIM1_LSI_CAL_MS     32U      /* LSI measured against HSI over this window at init */
+#define BOARD_LSI_MIN_HZ            26000UL  /* LSI spread (datasheet): a measurement outside fails init */
+#define BOARD_LSI_MAX_HZ            56000UL
+
+/* Vector table in RAM (hal_vectors_init()): a mode change installs the
+ * handler built for the new mode instead of every interrupt testing the
+ * mode. Switched so: the TIM2 tick (sampler step, mux array scan, or with
+ * the external sync input neither) and the sync input EXTI. 192 bytes of
+ * RAM. Needs the LL hot path on TIM2: the HAL path dispatches through
+ * HAL_TIM_IRQHandler() whatever the vector */
+#ifndef BOARD_RAM_VECTORS_ENABLE
+#define BOARD_RAM_VECTORS_ENABLE    (BOARD_LL_HOTPATH && BOARD_TIMEBASE == BOARD_TIMEBASE_TIM2)
+#endif
+#if BOARD_RAM_VECTORS_ENABLE && (!BOARD_LL_HOTPATH || BOARD_TIMEBASE != BOARD_TIMEBASE_TIM2)
+#error "BOARD_RAM_VECTORS_ENABLE needs BOARD_LL_HOTPATH and BOARD_TIMEBASE_TIM2"
+#endif
+
+/* Low-rate logging: the RTC wakeup timer (LSI, counts through STOP) starts
+ * one P/T sample every BOARD_LOG_PERIOD_S seconds; the timebase is stopped
+ * and the core in STOP in between. Needs BOARD_I2C1_WAKEUP_STOP and a
+ * single sensor. 0: sample continuously at the tick rate */
+#define BOARD_LOG_PERIOD_S          0U       /* 1 .. 3600 s */
+#define BOARD_LOG_LSI_CAL_MS        32U      /* LSI measured against HSI over this window at init */
+
+/* Independent watchdog (hal_iwdg_*()): started after board_init() and
+ * refreshed by the main loop only when it has published a sample newer
+ * than the last refresh, so a stalled sampler (a hung sensor bus wait) or
+ * main loop resets the MCU. Runs on LSI through STOP, held while a debugger
+ * halts the core. At least BOARD_IWDG_TIMEOUT_MS at BOARD_LSI_MAX_HZ, up to
+ * ~2x that on a slow LSI; keep it above the slowest sample interval (tick
+ * rate, filter decimation) and any blocking main-loop call (SD log start).
+ * Not with low-rate logging: STOP between samples is longer than any
+ * timeout. 0: no watchdog */
+#ifndef BOARD_IWDG_ENABLE
+#define BOARD_IWDG_ENABLE           (BOARD_LOG_PERIOD_S == 0U)
+#endif
+#define BOARD_IWDG_TIMEOUT_MS       8000U    /* Up to ~18700 (/256, 12-bit reload) */
+
+/* Profiling (prof.h): PROF_BEGIN/END sites time in SYSCLK cycles on TIM22
+ * (low half, PCLK2 undivided) chained into TIM3 (high half, counts TIM22
+ * updates). 0: the macros compile away and both timers stay off */
+#ifndef BOARD_PROF_ENABLE
+#define BOARD_PROF_ENABLE           0
+#endif
+#define BOARD_PROF_TIM3_ITR         TIM_TS_ITR2  /* TIM3 trigger input wired to TIM22 TRGO (RM0377) */
+
+/* Interrupt times and CPU idle (perf.h) for the performance bank at
+ * APP_REG_PERF: every handler is timed on the microsecond timebase, a few
+ * cycles per pass. 0: the bank reports no handler times and no idle */
+#define BOARD_PERF_ENABLE           1
+
+/* Latency histograms (latency.h): time from conversion start to the sample
+ * ring, the slave registers and the DAC, log2 us buckets at APP_REG_LAT_*.
+ * 0: LATENCY_RECORD() compiles away */
+#define BOARD_LATENCY_ENABLE        1
+
+/* Binary trace (trace.h): TRACE() sites push an ID, the timestamp and two
+ * integer arguments into a ring that DMA drains over LPUART1 TX; the host
+ * decodes it with tools/trace_decode.py. 0: the macro compiles away and
+ * LPUART1 and its DMA channel stay off */
+#define BOARD_TRACE_ENABLE          0
+#define BOARD_TRACE_TX_PORT         GPIOA
+#define BOARD_TRACE_TX_PIN          2
+#define BOARD_TRACE_TX_AF           6  /* AF6 for LPUART1_TX on PA2 */
+#define BOARD_TRACE_BAUD            1000000UL  /* From HSI16: up to 5.3 Mbaud */
+#define BOARD_TRACE_RING_RECORDS    32U  /* Power of two, 16 bytes per record */
+#define BOARD_TRACE_DMA_CHANNEL     DMA1_Channel7
+#define BOARD_TRACE_DMA_REQUEST     DMA_REQUEST_5  /* LPUART1_TX on DMA1 channel 7, clear of the DAC stream */
+#define BOARD_TRACE_DMA_IRQn        DMA1_Channel4_5_6_7_IRQn
+
+/* Fault capture (fault.h): a HardFault or main_error_handler() saves the
+ * stacked registers, the sampler state and the newest trace records into
+ * .noinit RAM and resets at once; the next boot reports them at
+ * APP_REG_FAULT and in the EEPROM log. 0: HardFault_Handler stays the
+ * startup file's loop */
+#define BOARD_FAULT_CAPTURE_ENABLE  1
+#define BOARD_FAULT_TRACE_RECORDS   4U  /* 0 .. 8, BOARD_TRACE_ENABLE builds */
+
+/* Warm restart (warm_restart.h): after a watchdog, fault or software reset
+ * the boot resumes from .noinit RAM with the running settings, the sensor
+ * PROM (no sensor reset or PROM read), the sequence counter and the FIFO
+ * frame not yet read. 0: every boot is cold */
+#define BOARD_WARM_RESTART_ENABLE   1
+
+/* Timing probes (probe.h): handler entry/exit, sampler state and bus
+ * transfer points as (ID, timestamp) words in a RAM ring, read whole at
+ * APP_REG_PROBE after HOST_CMD_PROBE freezes it; optionally two spare pins
+ * for a scope, one BSRR store per edge. 0: every point compiles away */
+#ifndef BOARD_PROBE_ENABLE
+#define BOARD_PROBE_ENABLE          0
+#endif
+#define BOARD_PROBE_GROUPS          0x07U  /* PROBE_GROUP_ISR | _STATE | _BUS */
+#define BOARD_PROBE_RING_LOG2       8U     /* 256 records, 1 KB */
+#ifndef BOARD_PROBE_PINS
+#define BOARD_PROBE_PINS            1      /* 0: ring only */
+#endif
+#define BOARD_PROBE_PORT            GPIOB
+#define BOARD_PROBE_PORT_CLK_ENABLE()  __HAL_RCC_GPIOB_CLK_ENABLE()
+#define BOARD_PROBE_PIN0            8      /* PB8: high inside the BOARD_PROBE_PIN0_ISR handlers */
+#define BOARD_PROBE_PIN1            9      /* PB9: high while a sensor bus transfer is in flight */
+#define BOARD_PROBE_PIN0_ISR        0      /* perf_isr_t: PERF_ISR_TICK */
+
+/* UART sample stream (uart_stream.h): every sample also goes out as
+ * COBS-framed, CRC-16 checked blocks on USART2 for deployments without
+ * USB, and the same frames carry master commands back in. TX by DMA
+ * straight from pool blocks, RX by circular DMA drained on IDLE line and
+ * half/full buffer. PA2/PA3 (AF4) and the TX channel are the trace
+ * output's, the RX channel the SD card's: not with either */
+#ifndef BOARD_UART_STREAM_ENABLE
+#define BOARD_UART_STREAM_ENABLE    0
+#endif
+#define BOARD_UART_STREAM_PORT      GPIOA
+#define BOARD_UART_STREAM_TX_PIN    2
+#define BOARD_UART_STREAM_RX_PIN    3
+#define BOARD_UART_STREAM_AF        4  /* AF4 for USART2 on PA2/PA3 */
+#define BOARD_UART_STREAM_BAUD      2000000UL  /* From HSI16, oversampling 8: up to 2 Mbaud */
+#define BOARD_UART_STREAM_BLOCK_SAMPLES  15U  /* Per frame: 246 bytes, one COBS run */
+#define BOARD_UART_STREAM_BLOCKS    4U    /* One on the wire, one filling, two queued */
+#define BOARD_UART_STREAM_RX_BYTES  64U   /* Circular RX buffer */
+#define BOARD_UART_STREAM_TX_DMA_CHANNEL  DMA1_Channel7
+#define BOARD_UART_STREAM_RX_DMA_CHANNEL  DMA1_Channel5
+#define BOARD_UART_STREAM_DMA_REQUEST     DMA_REQUEST_4  /* USART2 on DMA1 channels 5 (RX) and 7 (TX) */
+#define BOARD_UART_STREAM_DMA_IRQn        DMA1_Channel4_5_6_7_IRQn
+
+/* USB CDC sample stream (usb_stream.h): every sample also goes to a PC as
+ * blocks on a virtual COM port, no I2C master needed. Set by make
+ * USE_USB_STREAM=1, which links the USB device library; USB runs from
+ * HSI48 trimmed by CRS on the host SOF. The test VID/PID of ST's VCP
+ * example: replace for a product */
+#ifndef BOARD_USB_STREAM_ENABLE
+#define BOARD_USB_STREAM_ENABLE     0
+#endif
+#define BOARD_USB_STREAM_BLOCK_BYTES  256U  /* Pool block: 4-byte header + 15 samples */
+#define BOARD_USB_STREAM_BLOCKS     4U    /* One on the wire, one filling, two queued */
+
+/* USB function: CDC blocks on bulk endpoints (every sample, throughput
+ * first), a vendor HID report on a 1 ms interrupt endpoint (the latest
+ * sample, one poll interval old at most, no host driver), or a read-only
+ * mass-storage disk holding the flash log as LOG.BIN (usb_disk.h, needs
+ * BOARD_FLASH_LOG_ENABLE). Set by make USB_CLASS=CDC, HID or MSC. Each
+ * class has the PID of ST's example for it, so a host never binds the
+ * driver of another */
+#define BOARD_USB_CLASS_CDC         0
+#define BOARD_USB_CLASS_HID         1
+#define BOARD_USB_CLASS_MSC         2
+#ifndef BOARD_USB_STREAM_CLASS
+#define BOARD_USB_STREAM_CLASS      BOARD_USB_CLASS_CDC
+#endif
+#if BOARD_USB_STREAM_CLASS != BOARD_USB_CLASS_CDC && BOARD_USB_STREAM_CLASS != BOARD_USB_CLASS_HID && \
+    BOARD_USB_STREAM_CLASS != BOARD_USB_CLASS_MSC
+#error "BOARD_USB_STREAM_CLASS must be BOARD_USB_CLASS_CDC, BOARD_USB_CLASS_HID or BOARD_USB_CLASS_MSC"
+#endif
+#define BOARD_USB_DISK_LOG_BYTES    65536U  /* FLASH_LOG region of linker.ld */
+#define BOARD_USB_VID               0x0483U
+#if BOARD_USB_STREAM_CLASS == BOARD_USB_CLASS_HID
+#define BOARD_USB_PID               0x5750U
+#elif BOARD_USB_STREAM_CLASS == BOARD_USB_CLASS_MSC
+#define BOARD_USB_PID               0x5720U
+#else
+#define BOARD_USB_PID               0x5740U
+#endif
+
+/* SD card logger (sd_log.h): every sample also goes into a pre-allocated
+ * (contiguous) FatFs file on an SPI SD card, written as raw sectors by one
+ * open multi-block write. Set by make USE_SD_LOG=1, which links FatFs.
+ * SPI2 on PB13/PB14/PB15 (AF0), chip select on PB12; TX by DMA, the card
+ * busy (and the rest of the protocol) polled from the main loop */
+#ifndef BOARD_SD_LOG_ENABLE
+#define BOARD_SD_LOG_ENABLE         0
+#endif
+#define BOARD_SD_SPI                SPI2
+#define BOARD_SD_SPI_PORT           GPIOB
+#define BOARD_SD_SCK_PIN            13
+#define BOARD_SD_MISO_PIN           14
+#define BOARD_SD_MOSI_PIN           15
+#define BOARD_SD_SPI_AF             0  /* AF0 for SPI2 on PB13-PB15 */
+#define BOARD_SD_CS_PORT            GPIOB
+#define BOARD_SD_CS_PIN             12
+#define BOARD_SD_SPI_INIT_HZ        400000UL    /* Identification: at most 400 kHz */
+#define BOARD_SD_SPI_HZ             8000000UL   /* Data transfer: at most PCLK1 / 2 */
+#define BOARD_SD_DMA_TX_CHANNEL     DMA1_Channel5
+#define BOARD_SD_DMA_TX_REQUEST     DMA_REQUEST_2  /* SPI2_TX on DMA1 channel 5 */
+#define BOARD_SD_LOG_FILE_MB        128U   /* Pre-allocated per file: ~2 h at 1 kHz */
+#define BOARD_SD_LOG_AUTOSTART      1      /* Open a file at boot if a card is in */
+
+#if BOARD_UART_STREAM_ENABLE && (BOARD_TRACE_ENABLE || BOARD_SD_LOG_ENABLE)
+#error "BOARD_UART_STREAM_ENABLE shares PA2 and DMA1 channel 7 with the trace, channel 5 with the SD log"
+#endif
+
+/* Stack high-water mark: Reset_Handler fills [_sstack, _estack) with the
+ * pattern (keep in step with the startup file), board_stack_poll() looks
+ * for the lowest overwritten word a few words per call */
+#define BOARD_STACK_PAINT           0xA5A5A5A5UL
+#define BOARD_STACK_SCAN_WORDS      32U      /* Words checked per board_stack_poll() */
+
+/* FreeRTOS execution model (src/rtos_tasks.h): sampler, host and background
+ * tasks instead of PendSV and the super-loop. Set by make USE_RTOS=1, which
+ * links the kernel; SysTick becomes the kernel (and HAL) tick. STOP only
+ * with the LPTIM1 timebase: the idle task stops the tick and sleeps until
+ * the next kernel deadline (BOARD_RTOS_TICKLESS) */
+#ifndef BOARD_RTOS_ENABLE
+#define BOARD_RTOS_ENABLE           0
+#endif
+#define BOARD_RTOS_SAMPLER_STACK_WORDS     128U
+#define BOARD_RTOS_HOST_STACK_WORDS        256U
+#define BOARD_RTOS_BACKGROUND_STACK_WORDS  128U
+#define BOARD_RTOS_BACKGROUND_PERIOD_MS    10U
+
+#define BOARD_RTOS_TICKLESS  (BOARD_RTOS_ENABLE && BOARD_I2C1_WAKEUP_STOP)
+
+#if BOARD_RTOS_ENABLE && BOARD_LOG_PERIOD_S != 0
+#error "BOARD_RTOS_ENABLE does not support low-rate logging (BOARD_LOG_PERIOD_S)"
+#endif
+#if BOARD_IWDG_ENABLE && BOARD_LOG_PERIOD_S != 0
+#error "BOARD_IWDG_ENABLE does not support low-rate logging (BOARD_LOG_PERIOD_S)"
+#endif
+#if BOARD_RTOS_TICKLESS && BOARD_TIMEBASE != BOARD_TIMEBASE_LPTIM1
+#error "BOARD_RTOS_ENABLE with BOARD_I2C1_WAKEUP_STOP needs BOARD_TIMEBASE_LPTIM1 (tickless idle)"
+#endif
+
+/* Data EEPROM Layout (byte offsets from DATA_EEPROM_BASE) */
+#define BOARD_EEPROM_SENSOR_CALIB_OFFSET  0x0000U  /* Cached MS5837 PROM (6 words) */
+#define BOARD_EEPROM_DAC_CALIB_OFFSET     0x0020U  /* DAC gain/offset per channel (6 words) */
+#define BOARD_EEPROM_CONFIG_A_OFFSET      0x0040U  /* Runtime configuration, copy A (config.h) */
+#define BOARD_EEPROM_CONFIG_B_OFFSET      0x0080U  /* Runtime configuration, copy B */
+#define BOARD_EEPROM_LOG_OFFSET           0x00C0U  /* Record ring (eeprom_log.h), to the end */
+#define BOARD_EEPROM_QUEUE_WORDS          32U      /* Word writes waiting for the EEPROM (eeprom.h) */
+
+/* Statistics and events kept across power cycles in the data EEPROM ring
+ * (297 slots): one word written per background poll. At two records an
+ * hour a slot is rewritten every ~150 h, far inside the 100k-cycle
+ * endurance */
+#define BOARD_EEPROM_LOG_ENABLE          1
+#define BOARD_EEPROM_LOG_QUEUE_DEPTH     8U      /* Records waiting for the EEPROM */
+#define BOARD_EEPROM_LOG_STATS_PERIOD_S  3600U   /* Pressure min/max/mean window */
+
+/* Summary statistics (sample_stats.h): min, max, mean and variance of the
+ * published samples per channel over back-to-back windows, shown at
+ * APP_REG_STATS_*; HOST_CMD_STATS_WINDOW changes the length. 0: off at boot */
+#define BOARD_SAMPLE_STATS_WINDOW        500U    /* Samples per window (1 s at 500 Hz), up to 65535 */
+
+/* Derived quantity (derived.h) at APP_REG_DERIVED and for APP_DAC_SOURCE_DERIVED
+ * mappings; HOST_CMD_DERIVED changes both at runtime */
+#define BOARD_DERIVED_QUANTITY           0U      /* derived_quantity_t: 0 fresh water depth,
+                                                  * 1 sea water depth, 2 altitude */
+#define BOARD_DERIVED_REFERENCE          101325L /* Reference pressure, 0.01 mbar (ISA sea level) */
+
+/* Pressure and rate tracker (tracker.h) at APP_REG_TRACK_*: alpha 1/64 with
+ * the Kalman steady-state beta = alpha^2 / (2 - alpha), ~64-sample time constant */
+#define BOARD_TRACKER_ALPHA_Q16          1024U   /* Q16, 1..65535 */
+#define BOARD_TRACKER_BETA_Q24           2066U   /* Q24, up to alpha */
+
+/* Output rates (output_sched.h): each consumer of the newest sample runs
+ * once every this many samples (1..65535); HOST_CMD_OUTPUT_RATE changes them.
+ * The EEPROM statistics record only needs to notice its window is over */
+#define BOARD_OUTPUT_SLAVE_DECIMATION    1U      /* Slave registers, INTR_MCU */
+#define BOARD_OUTPUT_DAC_DECIMATION      1U      /* DAC outputs */
+#define BOARD_OUTPUT_ELOG_DECIMATION     16U     /* EEPROM statistics window check */
+
+/* Stale samples: a sampler that stops without an error keeps its last
+ * sample valid. Once the newest sample is older than BOARD_SAMPLE_STALE_MS
+ * the slave status reads SENSOR_STATUS_STALE (pressure: the warming-up
+ * value) and OUT1/OUT2 go to BOARD_DAC_STALE_CODE (BOARD_DAC_STALE_HOLD:
+ * keep the last codes); checked every BOARD_JOB_STALE_PERIOD_US.
+ * HOST_CMD_STALE changes both. Off (0) with RTC-logged samples, which are
+ * seconds apart */
+#define BOARD_SAMPLE_STALE_MS            ((BOARD_LOG_PERIOD_S == 0U) ? 100U : 0U)  /* 0 = off */
+#define BOARD_DAC_STALE_HOLD             0xFFFFU
+#define BOARD_DAC_STALE_CODE             BOARD_DAC_STALE_HOLD
+
+/* Main loop jobs (job_sched.h), earliest deadline first: deadlines from the
+ * release (the event), us. The sample job goes ahead of the background
+ * work (ADC scan, EEPROM log, calibration cache, firmware update), which
+ * runs every BOARD_JOB_BACKGROUND_PERIOD_US with that as its deadline (the
+ * RTOS build keeps it in its own task) */
+#define BOARD_JOB_SAMPLE_DEADLINE_US     500U
+#define BOARD_JOB_COMMAND_DEADLINE_US    2000U
+#define BOARD_JOB_ALARM_DEADLINE_US      500U
+#define BOARD_JOB_LOG_DEADLINE_US        10000U
+#define BOARD_JOB_BACKGROUND_PERIOD_US   2000U
+#define BOARD_PERF_PERIOD_US             100000U  /* Performance bank refresh (perf_bank.h) */
+#define BOARD_JOB_STALE_PERIOD_US        10000U   /* Stale sample check */
+
+/* Flash capture log (flash_log.h) in the FLASH_LOG region of linker.ld:
+ * burst capture started and stopped by HOST_CMD_FLASH_CAPTURE. Normally
+ * set by the Makefile (make USE_FLASH_LOG=1) */
+#ifndef BOARD_FLASH_LOG_ENABLE
+#define BOARD_FLASH_LOG_ENABLE        0
+#endif
+#define BOARD_FLASH_LOG_HALVES        8U  /* Half-page buffers (64 bytes each) */
+#define BOARD_FLASH_LOG_ERASE_AHEAD   4U  /* Pages erased ahead of the one filling */
+
+/* Replay the newest raw trace of the flash log (HOST_CMD_FLASH_CAPTURE 2)
+ * in place of the sensor: the sampler talks to flash_log_replay_handle()
+ * and compensates the recorded ADC pairs as if they were live */
+#ifndef BOARD_FLASH_LOG_REPLAY
+#define BOARD_FLASH_LOG_REPLAY        0
+#endif
+#if BOARD_FLASH_LOG_REPLAY && (!BOARD_FLASH_LOG_ENABLE || BOARD_SENSOR_MUX_CHANNELS != 0)
+#error "BOARD_FLASH_LOG_REPLAY needs BOARD_FLASH_LOG_ENABLE and a single sensor"
+#endif
+#if BOARD_USB_STREAM_ENABLE && BOARD_USB_STREAM_CLASS == BOARD_USB_CLASS_MSC && !BOARD_FLASH_LOG_ENABLE
+#error "BOARD_USB_CLASS_MSC serves the flash log: it needs BOARD_FLASH_LOG_ENABLE"
+#endif
+
+/* Brown-out save: the PVD interrupt (VDD falling through BOARD_PVD_LEVEL)
+ * programs the queued flash log half pages, the partial one included, and
+ * one snapshot page of the in-RAM statistics (flash_log.h) into pages
+ * erased beforehand, then waits for the supply to go or come back (reset).
+ * 
+ * Hold-up budget, from the PVD edge to the last program done: one erase or
+ * program of the main loop left to finish, BOARD_PVD_SAVE_HALVES half-page
+ * programs and the snapshot, each 3.2 ms typ / 3.94 ms max (datasheet
+ * tprog), interrupts active throughout:
+ *   t_save <= (BOARD_PVD_SAVE_HALVES + 2) x 3.94 ms = 15.8 ms at 2
+ * VDD has to stay above the 1.8 V BOR floor for t_save after crossing
+ * BOARD_PVD_LEVEL (2.9 V), on what the 3V3 rail holds once the buck drops
+ * out: C >= I x t_save / (2.9 V - 1.8 V), ~145 uF at 10 mA. Every save
+ * measures its flush into the snapshot (edge to snapshot start, word 1),
+ * to check the budget on the bench against the real hold-up */
+#define BOARD_PVD_SAVE_ENABLE         0
+#define BOARD_PVD_LEVEL               PWR_PVDLEVEL_5  /* 2.9 V falling threshold */
+#define BOARD_PVD_SAVE_HALVES         2U  /* Half pages programmed at most, rest dropped */
+#if BOARD_PVD_SAVE_ENABLE && (!BOARD_FLASH_LOG_ENABLE || BOARD_FLASH_LOG_REPLAY)
+#error "BOARD_PVD_SAVE_ENABLE needs BOARD_FLASH_LOG_ENABLE without BOARD_FLASH_LOG_REPLAY"
+#endif
+#if BOARD_PVD_SAVE_ENABLE && (BOARD_PVD_SAVE_HALVES == 0U || BOARD_PVD_SAVE_HALVES > BOARD_FLASH_LOG_HALVES)
+#error "BOARD_PVD_SAVE_HALVES must be 1..BOARD_FLASH_LOG_HALVES"
+#endif
+
+/* Firmware update over the I2C1 slave (fw_update.h): HOST_CMD_FW_UPDATE
+ * and HOST_CMD_FW_DATA stream an image into the inactive flash bank and
+ * swap to it. The image must fit one bank (96 KB, checked by linker.ld),
+ * which leaves no room for the flash log; commands need their CRC-16
+ * and the image check uses a CRC-32 job. Normally set by the Makefile
+ * (make USE_FW_UPDATE=1) */
+#ifndef BOARD_FW_UPDATE_ENABLE
+#define BOARD_FW_UPDATE_ENABLE        0
+#endif
+#if BOARD_FW_UPDATE_ENABLE && (BOARD_FLASH_LOG_ENABLE || !BOARD_CRC_FRAMING_ENABLE)
+#error "BOARD_FW_UPDATE_ENABLE needs BOARD_CRC_FRAMING_ENABLE and no flash log (bank 2)"
+#endif
+
+/* RAM burst capture (burst.h): HOST_CMD_BURST takes N pressure-only
+ * samples at the highest rate, HOST_CMD_BURST_ARM keeps a pre-trigger
+ * ring frozen by an event, both in pool blocks of 32 samples (512 bytes
+ * each) drained through the FIFO register. 0: commands not built */
+#define BOARD_BURST_ENABLE            0
+#define BOARD_BURST_BLOCKS            8U  /* 256 samples at most */
+#if BOARD_BURST_ENABLE && BOARD_SENSOR_MUX_CHANNELS != 0
+#error "BOARD_BURST_ENABLE needs a single sensor"
+#endif
+
+/* On-target benchmark (bench.h): HOST_CMD_BENCH sweeps OSR, I2C2 speed
+ * and sampling mode at the highest rate and publishes the throughput
+ * table at APP_REG_BENCH, the stream register of the probe. 54 steps of
+ * settle plus dwell: some two minutes with the defaults. 0: not built */
+#ifndef BOARD_BENCH_ENABLE
+#define BOARD_BENCH_ENABLE            0
+#endif
+#ifndef BOARD_BENCH_SETTLE_MS
+#define BOARD_BENCH_SETTLE_MS         200U   /* Run, not measured, after each change */
+#endif
+#ifndef BOARD_BENCH_DWELL_MS
+#define BOARD_BENCH_DWELL_MS          2000U  /* Measuring window per step */
+#endif
+#if BOARD_BENCH_ENABLE && (!BOARD_PERF_ENABLE || BOARD_SENSOR_MUX_CHANNELS != 0 || \
+                           BOARD_PROBE_ENABLE)
+#error "BOARD_BENCH_ENABLE needs BOARD_PERF_ENABLE, a single sensor and no BOARD_PROBE_ENABLE"
+#endif
 
 /* DAC Configuration */
 #define BOARD_DAC_PERIPH            DAC1
 #define BOARD_DAC_VREF_VOLTS        3.3f  /* Reference voltage in volts */
+#define BOARD_DAC_VREF_MV           3300UL  /* Same, in millivolts (integer path) */
 #define BOARD_DAC_RESOLUTION_BITS   12    /* 12-bit DAC resolution */
 #define BOARD_DAC_MAX_CODE          ((1UL << BOARD_DAC_RESOLUTION_BITS) - 1)
 
+/* DAC streaming: TIM6 TRGO triggers both channels, the DAC channel 2 DMA
+ * request loads DHR12RD (one word = both outputs per sample) */
+#define BOARD_DAC_STREAM_ENABLE      1
+#define BOARD_DAC_STREAM_TIM_PERIPH  TIM6
+#define BOARD_DAC_STREAM_COUNTER_HZ  1000000UL  /* 1 MHz counter: period in us */
+#define BOARD_DAC_STREAM_MAX_HZ      100000UL   /* Refill interrupt every BLOCK samples */
+#define BOARD_DAC_STREAM_BLOCK       32U        /* Samples per half buffer */
+#define BOARD_DAC_STREAM_DMA_CHANNEL DMA1_Channel4
+#define BOARD_DAC_STREAM_DMA_REQUEST DMA_REQUEST_15  /* DAC channel 2 on DMA1 channel 4, clear of I2C1 */
+#define BOARD_DAC_STREAM_DMA_IRQn    DMA1_Channel4_5_6_7_IRQn
+
+/* DAC latch: software writes (dac_set_*(), the sample mapping) only load
+ * the data registers, and the TIM2 update (the sampling tick, TRGO) moves
+ * them to the outputs. Each output then changes at a fixed phase of the
+ * tick, one tick after its cycle started, however late in the period the
+ * main loop wrote it; a write that misses the tick shows a period later.
+ * Streams keep their TIM6 trigger. Needs the TIM2 timebase running, so not
+ * with low-rate logging. 0: writes take effect at once */
+#define BOARD_DAC_LATCH_ENABLE       0
+
+#if BOARD_DAC_LATCH_ENABLE && (BOARD_TIMEBASE != BOARD_TIMEBASE_TIM2 || BOARD_LOG_PERIOD_S != 0)
+#error "BOARD_DAC_LATCH_ENABLE needs BOARD_TIMEBASE_TIM2 and continuous sampling"
+#endif
+
+/* ADC1 background scan: both DAC pins, VREFINT, the temperature sensor
+ * and the supply input in one circular DMA transfer, each channel averaged
+ * by the 16x hardware oversampler (0: ADC unused) */
+#define BOARD_ADC_SCAN_PERIOD_MS     250U
+#define BOARD_ADC_PERIPH             ADC1
+#define BOARD_ADC_DMA_CHANNEL        DMA1_Channel1
+#define BOARD_ADC_DMA_REQUEST        DMA_REQUEST_0  /* ADC on DMA1 channel 1, clear of I2C1 */
+#define BOARD_ADC_DMA_IRQn           DMA1_Channel1_IRQn
+#define BOARD_DAC1_OUT1_ADC_CHANNEL  ADC_CHANNEL_4  /* PA4 */
+#define BOARD_DAC1_OUT2_ADC_CHANNEL  ADC_CHANNEL_5  /* PA5 */
+
+/* Scan trigger: TIM22 TRGO every BOARD_ADC_SCAN_PERIOD_MS, so a scan costs
+ * the CPU one DMA interrupt and nothing per conversion. The profiler owns
+ * TIM22 (BOARD_PROF_ENABLE): the main loop starts the scans then */
+#define BOARD_ADC_SCAN_TIM22         (BOARD_PROF_ENABLE == 0)
+#define BOARD_ADC_SCAN_TIM22_HZ      1000U  /* TIM22 count rate: one count per ms */
+
+/* Supply input (12 V) through a resistor divider into a spare ADC pin
+ * (0: not wired, supply reads 0) */
+#define BOARD_ADC_SUPPLY_ENABLE      0
+#define BOARD_ADC_SUPPLY_PORT        GPIOA
+#define BOARD_ADC_SUPPLY_PIN         0
+#define BOARD_ADC_SUPPLY_CHANNEL     ADC_CHANNEL_0  /* PA0 */
+#define BOARD_ADC_SUPPLY_DIVIDER_X100 1100U  /* Input over pin voltage x100 (100k over 10k: 11.00) */
+
+#if BOARD_ADC_SCAN_PERIOD_MS > 65535U
+#error "BOARD_ADC_SCAN_PERIOD_MS exceeds the 16-bit TIM22 period"
+#endif
+
+/* VDDA tracking: VREFINT measured against the factory calibration, DAC
+ * scale follows the actual VDDA (0: fixed BOARD_DAC_VREF_MV) */
+#define BOARD_VDDA_TRACK_ENABLE      1
+
+/* DAC readback: every scan compares the pins with the codes being converted;
+ * a fault is set (cleared) after COUNT scans in a row out of (within) tolerance */
+#define BOARD_DAC_VERIFY_ENABLE      1
+#define BOARD_DAC_VERIFY_TOLERANCE   100U  /* ADC codes (~80 mV): above the calibration error */
+#define BOARD_DAC_VERIFY_COUNT       3U
+
+/* Analog watchdog: COMP2 compares the alarm input with a DAC output used as
+ * threshold; that output leaves the sensor mapping (0: off, both outputs
+ * mapped) */
+#define BOARD_COMP_ALARM_ENABLE      0
+#define BOARD_COMP_PERIPH            COMP2
+#define BOARD_COMP_ALARM_DAC_OUT     1   /* dac_channel_t of the threshold (DAC_OUT2, PA5) */
+#define BOARD_COMP_ALARM_OUT_ENABLE  1   /* 1: comparator output on the alarm pin, high above threshold */
+#define BOARD_COMP_ALARM_MV          0U  /* Threshold armed at boot, mV (0: disarmed) */
+
+/* External sync input: with HOST_CMD_SYNC_IN an edge on this pin (EXTI)
+ * starts each sampling cycle instead of the timebase tick (exact-timed
+ * mode). The timebase keeps the timestamps and conversion delays */
+#define BOARD_SYNC_IN_ENABLE         0
+#define BOARD_SYNC_IN_PORT           GPIOB
+#define BOARD_SYNC_IN_PIN            0   /* EXTI0_1 vector (main.c): pin 0 or 1 */
+#define BOARD_SYNC_IN_RISING         1   /* 1: rising edge, 0: falling edge */
+#if BOARD_SYNC_IN_ENABLE && (BOARD_SYNC_IN_PIN > 1 || BOARD_SENSOR_MUX_CHANNELS != 0)
+#error "BOARD_SYNC_IN_ENABLE needs a single sensor and BOARD_SYNC_IN_PIN 0 or 1"
+#endif
+
+/* Sensor-to-DAC mapping per output (app_dac_map_t): source (0 pressure,
+ * 1 temperature), input range in sensor units (0.01 mbar, 0.01 degC), ideal
+ * code range (inverted if min > max), clamp (0 hold at the range ends,
+ * 1 extrapolate to the DAC rails) */
+#define BOARD_DAC_OUT1_MAP  { 0, 0L, 300000L, 0U, BOARD_DAC_MAX_CODE, 0 }  /* 0-3000 mbar */
+#define BOARD_DAC_OUT2_MAP  { 1, -2000L, 8500L, 0U, BOARD_DAC_MAX_CODE, 0 }  /* -20-85 degC */
+#if BOARD_DAC_STALE_CODE != BOARD_DAC_STALE_HOLD && BOARD_DAC_STALE_CODE > BOARD_DAC_MAX_CODE
+#error "BOARD_DAC_STALE_CODE must be a DAC code or BOARD_DAC_STALE_HOLD"
+#endif
+
+/* Sensor outputs through the stream: ramp between samples (dac_follow_start()) */
+#define BOARD_DAC_FOLLOW_RATE_HZ     4000U  /* Output updates per second, 0: step per sample */
+#define BOARD_DAC_FOLLOW_MAX_STEP    0U     /* Slew limit, codes per update (0: none) */
+
+/* Noise-shaped dithering: the mappings keep BOARD_DAC_DITHER_BITS below
+ * the DAC LSB and the follower quantizes its ramp with first-order error
+ * feedback, so the output toggles between neighbouring codes with the
+ * fraction as duty and the quantization noise pushed up to the stream
+ * rate. An RC filter well below BOARD_DAC_FOLLOW_RATE_HZ (which should be
+ * some tens of kHz for it) recovers up to 12 + BITS bits. 0: off, codes
+ * truncated as before */
+#define BOARD_DAC_DITHER_BITS        0U     /* 0..4 */
+
+#if BOARD_DAC_DITHER_BITS > 4U
+#error "BOARD_DAC_DITHER_BITS must be 0..4 (a target is 16 bits)"
+#endif
+#if BOARD_DAC_DITHER_BITS != 0 && BOARD_DAC_FOLLOW_RATE_HZ == 0
+#error "BOARD_DAC_DITHER_BITS needs the follower (BOARD_DAC_FOLLOW_RATE_HZ)"
+#endif
+
+/* Playout buffer (dac_playout_start()) in place of the follower: the
+ * stream shows each sample BOARD_DAC_PLAYOUT_DELAY_US after its timestamp,
+ * interpolated between samples, so a late main loop or a burst of samples
+ * no longer bunches the output updates. The delay covers two half buffers
+ * of the stream (16 ms at 4 kHz) plus the sample latency (APP_REG_LAT_*).
+ * On an underrun (no newer sample yet) the last slope carries on for one
+ * sample interval (EXTRAPOLATE 1) or the output holds. 0: follower */
+#define BOARD_DAC_PLAYOUT_DELAY_US   0U
+#define BOARD_DAC_PLAYOUT_EXTRAPOLATE 1
+
+#if BOARD_DAC_PLAYOUT_DELAY_US != 0 && (BOARD_DAC_FOLLOW_RATE_HZ == 0 || \
+    BOARD_DAC_PLAYOUT_DELAY_US <= 2UL * BOARD_DAC_STREAM_BLOCK * 1000000UL / BOARD_DAC_FOLLOW_RATE_HZ)
+#error "BOARD_DAC_PLAYOUT_DELAY_US needs BOARD_DAC_FOLLOW_RATE_HZ and more than two stream half buffers"
+#endif
+#if BOARD_DAC_DITHER_BITS != 0 && BOARD_DAC_PLAYOUT_DELAY_US != 0
+#error "BOARD_DAC_DITHER_BITS shapes the follower, not the playout buffer"
+#endif
+
+/* Direct sample-to-DAC path: the sampler bottom half maps each sample as
+ * it leaves the compensation (before the median and filter stages) and
+ * writes DHR12RD itself, with interrupts masked from there to the store.
+ * Compensation to output is then a fixed instruction path, a few us at
+ * 32 MHz, no longer waiting on the main loop; the profiling build measures
+ * it (PROF_SITE_DAC_DIRECT). The main-loop DAC output is not scheduled.
+ * Needs the outputs stepped (no follower, no latch) and a single sensor */
+#define BOARD_DAC_DIRECT_ENABLE      0
+
+#if BOARD_DAC_DIRECT_ENABLE && (BOARD_DAC_FOLLOW_RATE_HZ != 0 || BOARD_DAC_LATCH_ENABLE || \
+                                BOARD_SENSOR_MUX_CHANNELS != 0)
+#error "BOARD_DAC_DIRECT_ENABLE needs BOARD_DAC_FOLLOW_RATE_HZ 0, no DAC latch and a single sensor"
+#endif
+
+/* PWM analog outputs (pwm_out.h): timer channels RC-filtered on the board,
+ * beyond the two DAC outputs. Counter at SYSCLK, period BOARD_DAC_MAX_CODE
+ * counts (7.8 kHz at 32 MHz), so a duty is a DAC code: 0 low, MAX_CODE
+ * high. The output swings to VDD, folded like the DAC VDDA. One row per
+ * output: X(timer, channel, port, pin, af, map), map an app_dac_map_t
+ * initializer (BOARD_DAC_OUT1_MAP format) taking the published sample.
+ * A timer is enabled with BOARD_PWM_OUT_TIMx below. TIM21 is the
+ * microsecond timebase and is not offered */
+#define BOARD_PWM_OUT_ENABLE         0
+#define BOARD_PWM_OUT_TIM2           0   /* Only with BOARD_TIMEBASE_LPTIM1 (TIM2 samples) */
+#define BOARD_PWM_OUT_TIM3           1   /* Not with BOARD_PROF_ENABLE (cycle counter) */
+#define BOARD_PWM_OUT_TIM22          0   /* Not with BOARD_ADC_SCAN_TIM22 or BOARD_PROF_ENABLE */
+#define BOARD_PWM_OUT3_MAP  { 2, 0L, 100000L, 0U, BOARD_DAC_MAX_CODE, 0 }  /* Derived 0-100 m */
+#define BOARD_PWM_OUT4_MAP  { 0, 80000L, 120000L, 0U, BOARD_DAC_MAX_CODE, 0 }  /* 800-1200 mbar */
+#define BOARD_PWM_OUTPUTS(X) \
+    X(TIM3, 1, GPIOA, 6, GPIO_AF2_TIM3, BOARD_PWM_OUT3_MAP)  /* PA6 */ \
+    X(TIM3, 4, GPIOB, 1, GPIO_AF2_TIM3, BOARD_PWM_OUT4_MAP)  /* PB1 */
+
+#if BOARD_PWM_OUT_ENABLE && BOARD_PWM_OUT_TIM2 && BOARD_TIMEBASE == BOARD_TIMEBASE_TIM2
+#error "BOARD_PWM_OUT_TIM2 needs BOARD_TIMEBASE_LPTIM1: TIM2 is the sampling timebase"
+#endif
+#if BOARD_PWM_OUT_ENABLE && (BOARD_PWM_OUT_TIM3 || BOARD_PWM_OUT_TIM22) && BOARD_PROF_ENABLE
+#error "BOARD_PWM_OUT_TIM3 and BOARD_PWM_OUT_TIM22 conflict with the profiler cycle counter"
+#endif
+#if BOARD_PWM_OUT_ENABLE && BOARD_PWM_OUT_TIM22 && BOARD_ADC_SCAN_PERIOD_MS != 0 && BOARD_ADC_SCAN_TIM22
+#error "BOARD_PWM_OUT_TIM22 conflicts with the ADC scan trigger"
+#endif
+
+/* Master DAC setpoint: after HOST_CMD_DAC_SETPOINT 1 the master drives the
+ * DAC codes itself at APP_REG_DAC_SET_OUT1/OUT2 instead of the sensor
+ * mapping. The slave RX interrupt applies a write reaching the last byte
+ * of OUT2 with one DHR12RD store, no main loop in between; a write of OUT1
+ * alone is held for the next one (dual-hold). With BOARD_DAC_LATCH_ENABLE
+ * the pair converts on the next sampling tick */
+#define BOARD_DAC_SETPOINT_ENABLE    1
+
+/* Waveform tables: the master uploads a table of DAC code pairs in chunks
+ * at APP_REG_WAVE (HOST_CMD_DAC_WAVE 1, then the chunks, then 2 with the
+ * CRC-16) and plays it, looping, on the DAC stream (HOST_CMD_DAC_WAVE 3).
+ * Two tables of BOARD_DAC_WAVE_SAMPLES pairs (8 bytes of SRAM per sample
+ * in all): one plays while the next is uploaded, and a committed one
+ * takes over at the end of a period of the other */
+#define BOARD_DAC_WAVE_ENABLE        0
+#define BOARD_DAC_WAVE_SAMPLES       1024U
+
+#if BOARD_DAC_WAVE_ENABLE && !BOARD_DAC_STREAM_ENABLE
+#error "BOARD_DAC_WAVE_ENABLE needs BOARD_DAC_STREAM_ENABLE"
+#endif
+#if BOARD_DAC_WAVE_ENABLE && (BOARD_DAC_WAVE_SAMPLES == 0 || BOARD_DAC_WAVE_SAMPLES > 0xFFFFU)
+#error "BOARD_DAC_WAVE_SAMPLES must be 1..65535"
+#endif
+
+/* Direct sample-to-slave path: the sampler bottom half publishes pressure,
+ * temperature, timestamp and sequence of every sample it publishes (after
+ * the filter stage) straight into the I2C slave, lock-free
+ * (i2c_slave_write_live()). A master read then returns the newest sample,
+ * not the one of the last main loop pass, whatever
+ * BOARD_OUTPUT_SLAVE_DECIMATION; the rest of the registers still follow
+ * the main loop. Single sensor */
+#define BOARD_SLAVE_DIRECT_ENABLE    0
+
+#if BOARD_SLAVE_DIRECT_ENABLE && BOARD_SENSOR_MUX_CHANNELS != 0
+#error "BOARD_SLAVE_DIRECT_ENABLE needs a single sensor"
+#endif
+
+/* Master poll alignment (poll_align.h): the period and phase of the
+ * master's reads are learned from their address match times, and with
+ * HOST_CMD_POLL_ALIGN 1 the sampling tick (exact mode) is moved so that
+ * the sample published before each read is BOARD_POLL_ALIGN_MARGIN_US
+ * old at most, not half a sample period on average. Single sensor */
+#define BOARD_POLL_ALIGN_ENABLE      0
+#define BOARD_POLL_ALIGN_MARGIN_US   500U  /* Published this far ahead of the predicted read */
+
+#if BOARD_POLL_ALIGN_ENABLE && BOARD_SENSOR_MUX_CHANNELS != 0
+#error "BOARD_POLL_ALIGN_ENABLE needs a single sensor"
+#endif
+
+/* Pure interrupt-driven mode: after init main() sets SLEEPONEXIT and never
+ * runs again. The main loop work (app_main_loop()) runs in an otherwise
+ * unused vector, BOARD_APP_IRQn, pended by event_flags_set() at
+ * BOARD_IRQ_PRIO_APP, so the core goes from the last handler straight back
+ * to sleep with no exception return into thread mode and no thread-mode
+ * pass per wake. The jobs then share the lowest level with the bottom half
+ * instead of being preempted by it: a job longer than the raw ring's span
+ * (BOARD_SAMPLING_RAW_RING ticks) drops samples. Needs no RTOS and no STOP
+ * (the idle choice between Sleep and STOP is made in thread mode) */
+#define BOARD_PURE_ISR               0
+#define BOARD_APP_IRQn               TSC_IRQn  /* No touch sensing on the board */
+
+#if BOARD_PURE_ISR && (BOARD_RTOS_ENABLE || BOARD_I2C1_WAKEUP_STOP)
+#error "BOARD_PURE_ISR needs BOARD_RTOS_ENABLE 0 and BOARD_I2C1_WAKEUP_STOP 0"
+#endif
+
+/* ============================================================================
+ * INTERRUPT PRIORITIES
+ * ============================================================================ */
+
+/* Cortex-M0+: 4 levels, 0 highest, no BASEPRI. Top halves only capture
+ * hardware state and start the next transfer; computation is deferred to
+ * PendSV, publishing and serving to the main loop. Equal levels never
+ * preempt each other, which the sampler relies on (ticks and I2C2
+ * completions advance the same state machine) */
+#define BOARD_IRQ_PRIO_COMP       0U  /* Analog watchdog: a few stores */
+#define BOARD_IRQ_PRIO_PVD        0U  /* Brown-out save: never returns */
+#define BOARD_IRQ_PRIO_I2C1       1U  /* Host slave (and its DMA): master waits on it */
+#define BOARD_IRQ_PRIO_TIMEBASE   2U  /* TIM2 / LPTIM1 tick, RTC wakeup */
+#define BOARD_IRQ_PRIO_I2C2       BOARD_IRQ_PRIO_TIMEBASE  /* Sensor bus completions */
+#define BOARD_IRQ_PRIO_I2C3       BOARD_IRQ_PRIO_TIMEBASE  /* Second probe bus completions */
+#define BOARD_IRQ_PRIO_DAC_DMA    2U  /* DAC stream half/full buffer refill */
+#define BOARD_IRQ_PRIO_TIM21      BOARD_IRQ_PRIO_TIMEBASE  /* Microsecond timebase wrap, deadline callbacks */
+#define BOARD_IRQ_PRIO_TRACE_DMA  BOARD_IRQ_PRIO_DAC_DMA  /* Same DMA1 channel 4-7 vector */
+#define BOARD_IRQ_PRIO_UART_STREAM BOARD_IRQ_PRIO_DAC_DMA  /* USART2 IDLE: same level as its DMA vector */
+#define BOARD_IRQ_PRIO_DMA_COPY   BOARD_IRQ_PRIO_DAC_DMA  /* Same DMA1 channel 4-7 vector */
+#define BOARD_IRQ_PRIO_BOTTOM     3U  /* PendSV bottom half, ADC scan DMA, SysTick */
+#define BOARD_IRQ_PRIO_USB        BOARD_IRQ_PRIO_BOTTOM  /* Enumeration and stream blocks: no deadline */
+#define BOARD_IRQ_PRIO_EEPROM     BOARD_IRQ_PRIO_BOTTOM  /* End of an EEPROM word: start the next */
+#define BOARD_IRQ_PRIO_APP        BOARD_IRQ_PRIO_BOTTOM  /* Main loop work (BOARD_PURE_ISR) */
+
+#if BOARD_IRQ_PRIO_BOTTOM != 3U
+#error "BOARD_IRQ_PRIO_BOTTOM must be the lowest level (TICK_INT_PRIORITY, shared with SysTick)"
+#endif
+#if BOARD_IRQ_PRIO_I2C1 >= BOARD_IRQ_PRIO_TIMEBASE || BOARD_IRQ_PRIO_COMP > BOARD_IRQ_PRIO_I2C1
+#error "Priorities must be COMP <= I2C1 < TIMEBASE"
+#endif
+#if BOARD_IRQ_PRIO_I2C2 != BOARD_IRQ_PRIO_TIMEBASE || BOARD_IRQ_PRIO_I2C3 != BOARD_IRQ_PRIO_TIMEBASE
+#error "I2C2/I2C3 completions and sampling ticks must not preempt each other"
+#endif
+#if BOARD_IRQ_PRIO_DAC_DMA >= BOARD_IRQ_PRIO_BOTTOM
+#error "The DAC stream refill must preempt the bottom half"
+#endif
+
 /* ============================================================================
  * CLOCK CONFIGURATION
  * ============================================================================ */
 
+/* Clock profiles: SYSCLK (HCLK, PCLK1 and PCLK2 undivided) with its
+ * regulator range and flash wait states (RM0377 table 13). Peripheral
+ * timings (I2C TIMINGR, timer prescalers, ADC clock, delays) are derived
+ * from it at init */
+#define BOARD_CLOCK_PROFILE_LOW_POWER    0  /* HSI 16 MHz, range 2 (1.5 V), 1 wait state */
+#define BOARD_CLOCK_PROFILE_PERFORMANCE  1  /* HSI x4 / 2 = 32 MHz, range 1 (1.8 V), 1 wait state */
+#define BOARD_CLOCK_PROFILE         BOARD_CLOCK_PROFILE_LOW_POWER
+
 /* System Clock Configuration */
-#define BOARD_SYSCLK_FREQ_HZ        16000000UL  /* 16 MHz HSI */
 #define BOARD_HSI_FREQ_HZ           16000000UL
+#if BOARD_CLOCK_PROFILE == BOARD_CLOCK_PROFILE_PERFORMANCE
+#define BOARD_SYSCLK_FREQ_HZ        32000000UL  /* PLL from HSI */
+#else
+#define BOARD_SYSCLK_FREQ_HZ        16000000UL  /* 16 MHz HSI */
+#endif
 #define BOARD_APB1_FREQ_HZ          BOARD_SYSCLK_FREQ_HZ
 #define BOARD_APB2_FREQ_HZ          BOARD_SYSCLK_FREQ_HZ
 
+/* HSI trimming (app/clock_trim.h): the sampling timebase error, measured
+ * against LSE when fitted or against the master's time-sync exchanges,
+ * is stepped back into half a HSITRIM step; the residual is reported in
+ * the performance bank (version 5). Needs the TIM2 timebase running
+ * continuously (it halts in STOP) */
+#define BOARD_CLOCK_TRIM_ENABLE     1
+#define BOARD_LSE_FITTED            0        /* 1: 32.768 kHz crystal on PC14/PC15 (counted on LPTIM1) */
+#define BOARD_LSE_FREQ_HZ           32768UL
+#define BOARD_CLOCK_TRIM_SPAN_MS    10000U   /* LSE: span of one estimate (0.1 ppm per us of jitter) */
+#define BOARD_CLOCK_TRIM_EXCHANGES  4U       /* Time sync: exchanges after a trim before an estimate */
+#define BOARD_HSI_TRIM_STEP_PPM     4000U    /* HSITRIM step, datasheet typical 0.4 % */
+#define BOARD_HSI_TRIM_MAX          0x1FU
+#if BOARD_CLOCK_TRIM_ENABLE && (BOARD_TIMEBASE != BOARD_TIMEBASE_TIM2 || \
+                                BOARD_LOG_PERIOD_S != 0 || BOARD_I2C1_WAKEUP_STOP)
+#error "BOARD_CLOCK_TRIM_ENABLE needs BOARD_TIMEBASE_TIM2, continuous sampling and no STOP"
+#endif
+#if BOARD_CLOCK_TRIM_ENABLE && BOARD_LSE_FITTED && \
+    (BOARD_CLOCK_TRIM_SPAN_MS < 1000U || BOARD_CLOCK_TRIM_SPAN_MS > 600000U)
+#error "BOARD_CLOCK_TRIM_SPAN_MS must be 1000 .. 600000"
+#endif
+
+/* Clock scaling (app/clock_scale.h): HCLK, and with it PCLK1 and PCLK2,
+ * divided by BOARD_CLOCK_SCALE_DIV (AHB prescaler) while nothing is left
+ * but the wait for a conversion or the next tick, at least
+ * BOARD_CLOCK_SCALE_MIN_IDLE_US of it; undivided again on the TIM2 and
+ * I2C1 interrupts and in the main loop, so transfers, compensation,
+ * filtering and slave traffic run at the profile clock. Each switch
+ * re-prescales TIM2 and TIM21 to stay at their 1 MHz count (the counters
+ * kept, TIM2 synchronised to one of its counts) and recomputes the
+ * I2C2/I2C3 TIMINGR with hal_i2c_timing(); I2C1 takes HSI16 as kernel
+ * clock, so the slave never sees a switch. The divider rather than MSI:
+ * the MSI ranges are 32.768 kHz times a power of two, which no timer
+ * prescaler brings to a whole microsecond. The prescaler restart costs
+ * TIM2 the cycles from its count edge to the reload, a fraction of a
+ * count at the profile clock, and TIM21 up to a count: hence the minimum
+ * wait, and no clock trim. Regulator range and wait states stay those of
+ * the profile */
+#define BOARD_CLOCK_SCALE_ENABLE    0
+#define BOARD_CLOCK_SCALE_DIV       4U      /* 2, 4, 8 or 16: 4 MHz on HSI16 keeps I2C fast mode */
+#define BOARD_CLOCK_SCALE_MIN_IDLE_US 1000U /* Shorter waits stay at the profile clock */
+#if BOARD_CLOCK_SCALE_ENABLE && (BOARD_TIMEBASE != BOARD_TIMEBASE_TIM2 || BOARD_CLOCK_TRIM_ENABLE || \
+                                 BOARD_LOG_PERIOD_S != 0 || BOARD_I2C1_WAKEUP_STOP || BOARD_RTOS_ENABLE)
+#error "BOARD_CLOCK_SCALE_ENABLE needs BOARD_TIMEBASE_TIM2, no clock trim, no STOP and no RTOS (SysTick on HCLK)"
+#endif
+#if BOARD_CLOCK_SCALE_ENABLE && (BOARD_DAC_LATCH_ENABLE || BOARD_USB_STREAM_ENABLE || BOARD_I2C1_SLAVE_NOSTRETCH)
+#error "BOARD_CLOCK_SCALE_ENABLE: the TIM2 reload is a DAC latch trigger, USB needs HCLK, NOSTRETCH the ISR latency"
+#endif
+
+/* Power profiles: what stays powered while the core waits. ULTRA_LOW
+ * powers the flash down in sleep (FLASH_ACR SLEEP_PD: the flash interface
+ * clock is gated there already and every DMA buffer is in SRAM) and turns
+ * VREFINT off in STOP (PWR_CR ULP), without waiting for it on the way out
+ * (FWU) unless the ADC scan measures it. Every wake from sleep then first
+ * waits for the flash: the latency of the sampling tick is measured
+ * (performance bank version 7) to choose per deployment. The regulator
+ * range follows the clock profile (range 3 tops out at 4.2 MHz, below
+ * HSI16), and the low-power regulator stays a STOP setting: low-power
+ * sleep needs a clock of 131 kHz at most */
+#define BOARD_POWER_PROFILE_DEFAULT    0  /* Flash powered in sleep, VREFINT on in STOP */
+#define BOARD_POWER_PROFILE_ULTRA_LOW  1
+#define BOARD_POWER_PROFILE         BOARD_POWER_PROFILE_DEFAULT
+
+/* Energy estimate (app/energy.h): run, sleep and STOP residency and the
+ * active time of the sensor buses and the DAC stream, weighted by the
+ * current table below, give the average supply current in the performance
+ * bank (version 8). The table holds datasheet typical figures at 3.3 V,
+ * 25 degC: measure the board in each mode and set its own. Needs
+ * BOARD_PERF_ENABLE */
+#define BOARD_ENERGY_ENABLE         1
+#if BOARD_CLOCK_PROFILE == BOARD_CLOCK_PROFILE_PERFORMANCE
+#define BOARD_CURRENT_RUN_UA        6700U  /* Core running from flash */
+#define BOARD_CURRENT_SLEEP_UA      1700U  /* Core asleep, peripherals clocked */
+#else
+#define BOARD_CURRENT_RUN_UA        2300U
+#define BOARD_CURRENT_SLEEP_UA      650U
+#endif
+#define BOARD_CURRENT_SLEEP_SCALED_UA (BOARD_CURRENT_SLEEP_UA / 3U)  /* Asleep at the divided clock (BOARD_CLOCK_SCALE_ENABLE) */
+#define BOARD_CURRENT_STOP_UA       1U     /* STOP, LSI and LPTIM1 on */
+#define BOARD_CURRENT_I2C_UA        800U   /* Added per sensor bus transferring: peripheral and pull-ups */
+#define BOARD_CURRENT_DAC_STREAM_UA 150U   /* Added while the DAC stream runs: TIM6 and DMA */
+#if BOARD_ENERGY_ENABLE && !BOARD_PERF_ENABLE
+#error "BOARD_ENERGY_ENABLE needs BOARD_PERF_ENABLE"
+#endif
+
+/* Delays (board_delay_ms/us()): timebase TIM21 free-running at 1 MHz from PCLK2 (drivers/timebase) */
+#define BOARD_DELAY_SLEEP           1  /* 1: board_delay_ms() waits in WFE until the TIM21 compare */
+
 /* ============================================================================
  * PLATFORM-SPECIFIC TYPES
  * ============================================================================ */
@@ -90,5 +1131,20 @@ typedef uint16_t board_gpio_pin_t;
 /* Peripheral handle type (platform-specific) */
 typedef void* board_periph_handle_t;
 
+/* Hot paths (sampling tick, I2C1 slave ISR, compensation) run from SRAM:
+ * .ramfunc is copied there by Reset_Handler (linker.ld), so they pay no
+ * flash wait states and keep running while flash is being programmed.
+ * Calls out to flash go through linker veneers */
+#define BOARD_RAMFUNC_ENABLE        1
+#if BOARD_RAMFUNC_ENABLE
+#define RAMFUNC  __attribute__((section(".ramfunc"), noinline))
+#else
+#define RAMFUNC
+#endif
+
+/* State kept across a warm reset: .noinit is neither copied nor zeroed by
+ * Reset_Handler (linker.ld), so its owner checks it before use */
+#define NOINIT  __attribute__((section(".noinit")))
+
 #endif /* BOARD_CONFIG_H */
 
@@ -9,6 +9,7 @@
 
 #include "board_init.h"
 #include "board_config.h"
+#include "timebase.h"
 
 /* STM32 HAL includes - adjust paths based on your STM32Cube structure */
 #include "stm32l0xx_hal.h"
@@ -21,41 +22,61 @@ extern I2C_HandleTypeDef hi2c2;
 extern DAC_HandleTypeDef hdac1;
 extern TIM_HandleTypeDef htim2;
 
-/* System clock frequency (updated by clock init) */
+/* HCLK = PCLK1 = PCLK2 (clock init, clock scaling) */
 static uint32_t sysclk_freq = BOARD_SYSCLK_FREQ_HZ;
 
+/* Stack region (linker.ld), painted with BOARD_STACK_PAINT by Reset_Handler */
+extern uint32_t _sstack[];
+extern uint32_t _estack[];
+
+/* High-water scan: lowest overwritten word found, next word of the sweep */
+static const uint32_t *stack_mark = NULL;
+static const uint32_t *stack_scan = NULL;
+
 /* ============================================================================
  * PRIVATE FUNCTIONS
  * ============================================================================ */
 
 /**
- * @brief Configure GPIO pin for I2C alternate function
+ * @brief Gate the clocks the sleeping core does not need
+ *
+ * Everything that runs while the core sleeps (TIM2, TIM6, I2C1/I2C2, DAC,
+ * ADC, COMP, DMA into SRAM) keeps its clock. The GPIO ports and the flash
+ * interface are only used by the core: pins hold their mode, output level
+ * and alternate function without the port clock, and every DMA buffer is in
+ * SRAM. The core gets them back as soon as it wakes.
  */
-static void board_config_i2c_pin(GPIO_TypeDef *port, uint32_t pin, uint32_t af)
+static void board_init_sleep_clocks(void)
 {
-    GPIO_InitTypeDef gpio_init = {0};
-    
-    gpio_init.Pin = pin;
-    gpio_init.Mode = GPIO_MODE_AF_OD;
-    gpio_init.Speed = GPIO_SPEED_FREQ_MEDIUM;
-    gpio_init.Pull = GPIO_PULLUP;
-    gpio_init.Alternate = af;
-    
-    HAL_GPIO_Init(port, &gpio_init);
+    __HAL_RCC_GPIOA_CLK_SLEEP_DISABLE();
+    __HAL_RCC_GPIOB_CLK_SLEEP_DISABLE();
+    __HAL_RCC_GPIOC_CLK_SLEEP_DISABLE();
+    __HAL_RCC_GPIOD_CLK_SLEEP_DISABLE();
+    __HAL_RCC_GPIOE_CLK_SLEEP_DISABLE();
+    __HAL_RCC_GPIOH_CLK_SLEEP_DISABLE();
+    __HAL_RCC_MIF_CLK_SLEEP_DISABLE();
 }
 
 /**
- * @brief Configure GPIO pin for DAC analog output
+ * @brief Power the flash down in sleep, VREFINT in STOP (ultra-low profile)
+ *
+ * Done once: both only take effect on the way into the low-power mode.
+ * HAL_PWREx is not built, so the PWR_CR bits are set directly.
  */
-static void board_config_dac_pin(GPIO_TypeDef *port, uint32_t pin)
+static void board_init_power(void)
 {
-    GPIO_InitTypeDef gpio_init = {0};
-    
-    gpio_init.Pin = pin;
-    gpio_init.Mode = GPIO_MODE_ANALOG;
-    gpio_init.Pull = GPIO_NOPULL;
-    
-    HAL_GPIO_Init(port, &gpio_init);
+#if BOARD_POWER_PROFILE == BOARD_POWER_PROFILE_ULTRA_LOW
+    __HAL_FLASH_SLEEP_POWERDOWN_ENABLE();
+#if BOARD_ADC_SCAN_PERIOD_MS != 0
+    /* The scan measures VREFINT: wait for it after STOP */
+    SET_BIT(PWR->CR, PWR_CR_ULP);
+#else
+    SET_BIT(PWR->CR, PWR_CR_ULP | PWR_CR_FWU);
+#endif
+#else
+    __HAL_FLASH_SLEEP_POWERDOWN_DISABLE();
+    CLEAR_BIT(PWR->CR, PWR_CR_ULP | PWR_CR_FWU);
+#endif
 }
 
 /* ============================================================================
@@ -67,30 +88,58 @@ bool board_init_clock(void)
     RCC_OscInitTypeDef RCC_OscInitStruct = {0};
     RCC_ClkInitTypeDef RCC_ClkInitStruct = {0};
     
-    /* Enable HSI oscillator */
+    /* Regulator range first: the clock must not run ahead of the core
+     * voltage */
+    __HAL_RCC_PWR_CLK_ENABLE();
+#if BOARD_CLOCK_PROFILE == BOARD_CLOCK_PROFILE_PERFORMANCE
+    __HAL_PWR_VOLTAGESCALING_CONFIG(PWR_REGULATOR_VOLTAGE_SCALE1);
+#else
+    __HAL_PWR_VOLTAGESCALING_CONFIG(PWR_REGULATOR_VOLTAGE_SCALE2);
+#endif
+    while (__HAL_PWR_GET_FLAG(PWR_FLAG_VOS) != RESET) {
+        /* Wait for the regulator to settle */
+    }
+    
+    /* Enable HSI oscillator (and the PLL on it for the performance profile) */
     RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_HSI;
     RCC_OscInitStruct.HSIState = RCC_HSI_ON;
     RCC_OscInitStruct.HSICalibrationValue = RCC_HSICALIBRATION_DEFAULT;
+#if BOARD_CLOCK_PROFILE == BOARD_CLOCK_PROFILE_PERFORMANCE
+    RCC_OscInitStruct.PLL.PLLState = RCC_PLL_ON;
+    RCC_OscInitStruct.PLL.PLLSource = RCC_PLLSOURCE_HSI;
+    RCC_OscInitStruct.PLL.PLLMUL = RCC_PLLMUL_4;  /* 64 MHz VCO */
+    RCC_OscInitStruct.PLL.PLLDIV = RCC_PLLDIV_2;
+#else
     RCC_OscInitStruct.PLL.PLLState = RCC_PLL_NONE;
+#endif
     
     if (HAL_RCC_OscConfig(&RCC_OscInitStruct) != HAL_OK) {
         return false;
     }
     
-    /* Configure system clock to use HSI */
+    /* Configure system clock: HSI or PLL, buses undivided */
     RCC_ClkInitStruct.ClockType = RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_SYSCLK | 
                                    RCC_CLOCKTYPE_PCLK1 | RCC_CLOCKTYPE_PCLK2;
+#if BOARD_CLOCK_PROFILE == BOARD_CLOCK_PROFILE_PERFORMANCE
+    RCC_ClkInitStruct.SYSCLKSource = RCC_SYSCLKSOURCE_PLLCLK;
+#else
     RCC_ClkInitStruct.SYSCLKSource = RCC_SYSCLKSOURCE_HSI;
+#endif
     RCC_ClkInitStruct.AHBCLKDivider = RCC_SYSCLK_DIV1;
     RCC_ClkInitStruct.APB1CLKDivider = RCC_HCLK_DIV1;
     RCC_ClkInitStruct.APB2CLKDivider = RCC_HCLK_DIV1;
     
-    if (HAL_RCC_ClockConfig(&RCC_ClkInitStruct, FLASH_LATENCY_0) != HAL_OK) {
+    /* One wait state in both profiles: 16 MHz is the range 2 limit for it,
+     * 32 MHz the range 1 limit */
+    if (HAL_RCC_ClockConfig(&RCC_ClkInitStruct, FLASH_LATENCY_1) != HAL_OK) {
         return false;
     }
     
     /* Update system clock frequency */
-    sysclk_freq = BOARD_HSI_FREQ_HZ;
+    sysclk_freq = BOARD_SYSCLK_FREQ_HZ;
+    
+    /* Delays and the uptime count on a timer clocked from PCLK2 */
+    timebase_init();
     
     /* Update SystemCoreClock variable */
     SystemCoreClockUpdate();
@@ -98,33 +147,15 @@ bool board_init_clock(void)
     return true;
 }
 
-bool board_init_gpio(void)
+bool board_clock_resume(void)
 {
-    /* Enable GPIO clocks */
-    __HAL_RCC_GPIOA_CLK_ENABLE();
-    __HAL_RCC_GPIOB_CLK_ENABLE();
-    
-    /* Configure I2C1 pins (PA9, PA10) for I2C slave */
-    board_config_i2c_pin(BOARD_I2C1_SCL_PORT, 
-                         (1UL << BOARD_I2C1_SCL_PIN), 
-                         BOARD_I2C1_SCL_AF);
-    board_config_i2c_pin(BOARD_I2C1_SDA_PORT, 
-                         (1UL << BOARD_I2C1_SDA_PIN), 
-                         BOARD_I2C1_SDA_AF);
-    
-    /* Configure I2C2 pins (PB10, PB11) for pressure sensor */
-    board_config_i2c_pin(BOARD_I2C2_SCL_PORT, 
-                         (1UL << BOARD_I2C2_SCL_PIN), 
-                         BOARD_I2C2_SCL_AF);
-    board_config_i2c_pin(BOARD_I2C2_SDA_PORT, 
-                         (1UL << BOARD_I2C2_SDA_PIN), 
-                         BOARD_I2C2_SDA_AF);
-    
-    /* Configure DAC pins (PA4, PA5) for analog output */
-    board_config_dac_pin(BOARD_DAC1_OUT1_PORT, (1UL << BOARD_DAC1_OUT1_PIN));
-    board_config_dac_pin(BOARD_DAC1_OUT2_PORT, (1UL << BOARD_DAC1_OUT2_PIN));
-    
+#if BOARD_CLOCK_PROFILE == BOARD_CLOCK_PROFILE_PERFORMANCE
+    /* STOP turns the PLL off and wakes up on HSI: bring the PLL back */
+    return board_init_clock();
+#else
+    /* Woken on HSI, which is the profile clock */
     return true;
+#endif
 }
 
 bool board_init(void)
@@ -134,20 +165,30 @@ bool board_init(void)
         return false;
     }
     
-    /* Initialize GPIO pins */
-    if (!board_init_gpio()) {
-        return false;
-    }
-    
-    /* Enable peripheral clocks */
-    __HAL_RCC_I2C1_CLK_ENABLE();
-    __HAL_RCC_I2C2_CLK_ENABLE();
-    __HAL_RCC_DAC_CLK_ENABLE();
-    __HAL_RCC_TIM2_CLK_ENABLE();
+    /* Pins and peripheral clocks are set up by each HAL MSP callback, with
+     * the driver that owns them; until then every pin stays analog */
+    board_init_sleep_clocks();
+    board_init_power();
     
     return true;
 }
 
+void board_clock_set_hclk(uint32_t hclk_hz)
+{
+    sysclk_freq = hclk_hz;
+    SystemCoreClock = hclk_hz;
+}
+
+void board_set_hsi_trim(uint8_t trim)
+{
+    __HAL_RCC_HSI_CALIBRATIONVALUE_ADJUST((uint32_t)trim & BOARD_HSI_TRIM_MAX);
+}
+
+uint8_t board_get_hsi_trim(void)
+{
+    return (uint8_t)((RCC->ICSCR & RCC_ICSCR_HSITRIM) >> RCC_ICSCR_HSITRIM_Pos);
+}
+
 uint32_t board_get_sysclk_freq(void)
 {
     return sysclk_freq;
@@ -165,21 +206,49 @@ uint32_t board_get_apb2_freq(void)
 
 void board_delay_ms(uint32_t ms)
 {
-    /* Simple blocking delay - should be replaced with HAL_Delay or 
-     * a more accurate implementation based on system clock */
-    volatile uint32_t count = ms * (sysclk_freq / 1000);
-    while (count--) {
-        __NOP();
+    while (ms > 0U) {
+        uint32_t chunk = (ms > 1000U) ? 1000U : ms;  /* Keep us in range */
+        
+#if BOARD_DELAY_SLEEP
+        timebase_sleep_us(chunk * 1000U);
+#else
+        timebase_delay_us(chunk * 1000U);
+#endif
+        ms -= chunk;
     }
 }
 
+uint32_t board_get_uptime_us(void)
+{
+    return timebase_now_us();
+}
+
 void board_delay_us(uint32_t us)
 {
-    /* Simple blocking delay - should be replaced with a more accurate 
-     * implementation based on system clock */
-    volatile uint32_t count = us * (sysclk_freq / 1000000);
-    while (count--) {
-        __NOP();
+    /* Spin: the wake-up from WFE would cost more than short waits last */
+    timebase_delay_us(us);
+}
+
+uint32_t board_stack_poll(void)
+{
+    const uint32_t *mark = (stack_mark != NULL) ? stack_mark : _estack;
+    const uint32_t *p = (stack_scan != NULL) ? stack_scan : _sstack;
+    
+    for (uint32_t n = 0; n < BOARD_STACK_SCAN_WORDS && p < mark; n++, p++) {
+        if (*p != BOARD_STACK_PAINT) {
+            mark = p;  /* Lowest so far: the sweep went up from _sstack */
+            break;
+        }
     }
+    
+    /* Sweep reached the mark (or lowered it): start over from the bottom */
+    stack_mark = mark;
+    stack_scan = (p >= mark) ? _sstack : p;
+    
+    return (uint32_t)((const uint8_t *)_estack - (const uint8_t *)mark);
 }
 
+uint32_t board_stack_get_size(void)
+{
+    return (uint32_t)((const uint8_t *)_estack - (const uint8_t *)_sstack);
+}
@@ -21,9 +21,11 @@ extern "C" {
  * @brief Initialize board hardware (clocks, GPIO, peripherals)
  * 
  * This function performs all platform-specific initialization:
- * - System clock configuration (HSI 16 MHz)
- * - GPIO pin configuration for I2C, DAC, etc.
- * - Peripheral clock enables
+ * - System clock configuration (BOARD_CLOCK_PROFILE: HSI 16 MHz or PLL 32 MHz)
+ * - Delay timer and the clocks gated in SLEEP
+ * 
+ * Pins and peripheral clocks are left to the HAL MSP callbacks of each
+ * peripheral init (hal_config.c), so they are set up once.
  * 
  * @return true if initialization successful, false otherwise
  */
@@ -32,7 +34,10 @@ bool board_init(void);
 /**
  * @brief Initialize system clock
  * 
- * Configures the system clock to use HSI (16 MHz internal oscillator).
+ * Configures the system clock for BOARD_CLOCK_PROFILE: HSI (16 MHz internal
+ * oscillator) or the PLL on it (32 MHz), with the matching regulator range
+ * and flash wait states. Peripherals initialized afterwards take their
+ * timings from board_get_apb1_freq().
  * This is platform-specific and should be updated when retargeting.
  * 
  * @return true if clock initialization successful, false otherwise
@@ -40,16 +45,42 @@ bool board_init(void);
 bool board_init_clock(void);
 
 /**
- * @brief Initialize GPIO pins
+ * @brief Restore the profile clock after STOP
+ * 
+ * The core wakes up on HSI with the PLL off; call before anything that
+ * depends on the system clock runs again.
+ * 
+ * @return true if the clock is back, false otherwise
+ */
+bool board_clock_resume(void);
+
+/**
+ * @brief Note a new HCLK, set through the AHB prescaler
+ * 
+ * For hal_clock_scale_set(), which moves the peripheral timings with it:
+ * board_get_sysclk_freq(), the bus getters and SystemCoreClock follow.
+ * 
+ * @param hclk_hz HCLK (and PCLK1/PCLK2, undivided) in Hz
+ */
+void board_clock_set_hclk(uint32_t hclk_hz);
+
+/**
+ * @brief Set the HSI16 user trim (RCC_ICSCR HSITRIM)
  * 
- * Configures all GPIO pins used by the application:
- * - I2C1 pins (PA9, PA10) for I2C slave
- * - I2C2 pins (PB10, PB11) for pressure sensor
- * - DAC pins (PA4, PA5) for analog outputs
+ * Takes effect at once on every clock derived from HSI: about 0.4 % per
+ * code (datasheet), more across a multiple of 16. The reset value is
+ * RCC_HSICALIBRATION_DEFAULT.
+ * 
+ * @param trim Trim code, 0 .. BOARD_HSI_TRIM_MAX
+ */
+void board_set_hsi_trim(uint8_t trim);
+
+/**
+ * @brief Get the HSI16 user trim
  * 
- * @return true if GPIO initialization successful, false otherwise
+ * @return Trim code in effect
  */
-bool board_init_gpio(void);
+uint8_t board_get_hsi_trim(void);
 
 /**
  * @brief Get system clock frequency in Hz
@@ -75,23 +106,52 @@ uint32_t board_get_apb2_freq(void);
 /**
  * @brief Delay function (milliseconds)
  * 
- * Platform-specific delay implementation. Uses a blocking delay
- * based on the system clock frequency.
+ * Blocking delay on the timebase (1 us resolution, at least ms). With
+ * BOARD_DELAY_SLEEP the core waits in WFE; interrupts are still served
+ * meanwhile. Available once board_init_clock() has run.
  * 
  * @param ms Delay time in milliseconds
  */
 void board_delay_ms(uint32_t ms);
 
+/**
+ * @brief Microseconds since the clock was configured (boot timing)
+ * 
+ * timebase_now_us(): any context, wraps after about 71 minutes; the
+ * timer does not count in STOP.
+ * 
+ * @return Microseconds since board_init_clock() started the timebase
+ */
+uint32_t board_get_uptime_us(void);
+
 /**
  * @brief Delay function (microseconds)
  * 
- * Platform-specific delay implementation. Uses a blocking delay
- * based on the system clock frequency.
+ * Blocking delay on the timebase: waits at least us, at most one microsecond more
+ * plus the call overhead. Spins (no sleep). Available once
+ * board_init_clock() has run.
  * 
  * @param us Delay time in microseconds
  */
 void board_delay_us(uint32_t us);
 
+/**
+ * @brief Advance the stack high-water scan
+ * 
+ * Checks up to BOARD_STACK_SCAN_WORDS painted words, bottom up, and lowers
+ * the mark at the first overwritten one; a full sweep over the stack takes
+ * (_Min_Stack_Size / 4) / BOARD_STACK_SCAN_WORDS calls. Interrupts nest on
+ * the same stack, so the mark includes their frames. Main loop only.
+ * 
+ * @return Deepest stack use seen so far, bytes below _estack
+ */
+uint32_t board_stack_poll(void);
+
+/**
+ * @brief Size of the painted stack region in bytes
+ */
+uint32_t board_stack_get_size(void);
+
 #ifdef __cplusplus
 }
 #endif
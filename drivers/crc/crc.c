@@ -0,0 +1,128 @@
+/**
+ * @file crc.c
+ * @brief Frame checks on the hardware CRC unit implementation
+ * 
+ * The unit is set up again for every computation (control, polynomial,
+ * initial value, then a reset): a few register writes, so CRC-16 calls and
+ * CRC-32 jobs interleave freely. The unit shifts each 32-bit write most
+ * significant bit first:
+ *   CRC-16  words are assembled big-endian from the bytes, the tail is
+ *           written byte by byte; the initial value carries a CRC on
+ *   CRC-32  native (little-endian) words, reversed by the unit on input
+ *           (REV_IN by word) and output (REV_OUT): the reflected CRC of the
+ *           bytes in memory order, which is what the DMA channel feeds
+ */
+
+#include "crc.h"
+
+#include <stddef.h>
+#include "stm32l0xx_hal.h"
+#include "hal_config.h"
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define CRC16_POLY  0x1021UL
+#define CRC32_POLY  0x04C11DB7UL
+#define CRC32_INIT  0xFFFFFFFFUL
+#define CRC32_XOR   0xFFFFFFFFUL
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+#if BOARD_CRC_FRAMING_ENABLE
+static uint32_t *job_result = NULL;  /* CRC-32 job running: its destination */
+#endif
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+#if BOARD_CRC_FRAMING_ENABLE
+/**
+ * @brief Finish the running CRC-32 job, if any
+ */
+static void crc32_wait(void)
+{
+    while (!crc32_poll()) {
+    }
+}
+#endif
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+bool crc_init(void)
+{
+    __HAL_RCC_CRC_CLK_ENABLE();
+#if BOARD_CRC_FRAMING_ENABLE
+    job_result = NULL;
+    return hal_crc_dma_init();
+#else
+    return true;
+#endif
+}
+
+uint16_t crc16_update(uint16_t crc, const void *data, uint32_t len)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    
+#if BOARD_CRC_FRAMING_ENABLE
+    crc32_wait();
+#endif
+    
+    /* 16-bit polynomial, no reversal */
+    CRC->CR = CRC_CR_POLYSIZE_0;
+    CRC->POL = CRC16_POLY;
+    CRC->INIT = crc;
+    CRC->CR |= CRC_CR_RESET;
+    
+    while (len >= 4U) {
+        CRC->DR = ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) |
+                  ((uint32_t)bytes[2] << 8) | (uint32_t)bytes[3];
+        bytes += 4;
+        len -= 4U;
+    }
+    while (len > 0U) {
+        *(__IO uint8_t *)&CRC->DR = *bytes++;
+        len--;
+    }
+    return (uint16_t)CRC->DR;
+}
+
+#if BOARD_CRC_FRAMING_ENABLE
+bool crc32_start(const void *data, uint32_t words, uint32_t *result)
+{
+    if (words == 0U || words > 0xFFFFU || ((uint32_t)data & 3U) != 0U || result == NULL) {
+        return false;
+    }
+    crc32_wait();
+    
+    /* 32-bit polynomial, input reversed by word, output reversed */
+    CRC->CR = CRC_CR_REV_IN_0 | CRC_CR_REV_IN_1 | CRC_CR_REV_OUT;
+    CRC->POL = CRC32_POLY;
+    CRC->INIT = CRC32_INIT;
+    CRC->CR |= CRC_CR_RESET;
+    
+    job_result = result;
+    hal_crc_dma_start(data, words);
+    return true;
+}
+
+bool crc32_poll(void)
+{
+    if (job_result == NULL) {
+        return true;
+    }
+    if (!hal_crc_dma_done()) {
+        return false;
+    }
+    *job_result = CRC->DR ^ CRC32_XOR;
+    job_result = NULL;
+    return true;
+}
+
+#endif /* BOARD_CRC_FRAMING_ENABLE */
@@ -0,0 +1,88 @@
+#ifndef CRC_H
+#define CRC_H
+
+/**
+ * @file crc.h
+ * @brief Frame checks on the hardware CRC unit
+ * 
+ * Two checks, both the common software variants so a host checks them
+ * with its standard library:
+ *   CRC-16  CRC-16/CCITT-FALSE: polynomial 0x1021, initial 0xFFFF, not
+ *           reflected, no final XOR (Python binascii.crc_hqx(data, 0xFFFF))
+ *   CRC-32  CRC-32/ISO-HDLC as in zlib and Ethernet: polynomial 0x04C11DB7,
+ *           initial and final XOR 0xFFFFFFFF, reflected (zlib.crc32(data))
+ * A CRC-16 is computed at once, the CPU feeding the unit a word at a time
+ * (a few cycles per word, any length and alignment). A CRC-32 runs as a
+ * job: a DMA channel feeds the unit in the background and the result is
+ * stored when the job is polled, so a full SD sector costs the main loop
+ * two calls.
+ * 
+ * One unit, one job at a time: main loop only (the host task in RTOS
+ * builds). CRC-16 in every build (the configuration block, config.h);
+ * CRC-32 jobs only with BOARD_CRC_FRAMING_ENABLE.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+#define CRC16_INIT  0xFFFFU  /* CRC-16 of nothing: start value of crc16_update() */
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Clock the CRC unit and set up its DMA channel (CRC-32 jobs)
+ * 
+ * @return true if initialization successful, false otherwise
+ */
+bool crc_init(void);
+
+/**
+ * @brief Extend a CRC-16 over more bytes
+ * 
+ * Waits for a running CRC-32 job first (the unit is shared).
+ * 
+ * @param crc  CRC-16 so far (CRC16_INIT for the first bytes)
+ * @param data Bytes to add
+ * @param len  Number of bytes
+ * @return CRC-16 of everything so far
+ */
+uint16_t crc16_update(uint16_t crc, const void *data, uint32_t len);
+
+#if BOARD_CRC_FRAMING_ENABLE
+
+/**
+ * @brief Start a CRC-32 job on the DMA channel
+ * 
+ * Waits for the previous job first.
+ * 
+ * @param data   Word-aligned, untouched until the job is done
+ * @param words  Number of 32-bit words (1 to 65535)
+ * @param result Receives the CRC-32 when the job is polled done
+ * @return true if started
+ */
+bool crc32_start(const void *data, uint32_t words, uint32_t *result);
+
+/**
+ * @brief Store the result of a finished CRC-32 job
+ * 
+ * @return true if no job is running (the last result is stored)
+ */
+bool crc32_poll(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CRC_H */
@@ -20,18 +20,114 @@
         Automatic clipping: clamps to 0.0V–3.3V range
         Dual channel: supports both DAC channels (PA4 and PA5)
         Helper functions: voltage ↔ code conversion utilities
+        Integer path: dac_set_code() / dac_set_millivolts(), Q16 scale,
+            no float arithmetic; the float API is a wrapper over it
+        Dual update: dac_set_dual() writes both channels in one store
+        Calibration: per-channel gain/offset in data EEPROM, folded into
+            the millivolt scale; two-point dac_calibrate_from_points()
+        VDDA: dac_set_vdda_mv() folds the measured supply into the same
+            scales (dac_get_transfer() for callers that fold their own)
+        Streaming: dac_stream_start() — TIM6 TRGO, circular DMA into
+            DHR12RD, half/full-transfer refill callbacks
+        Follower: dac_follow_start() — stream ramps linearly (optionally
+            slew-limited) between the targets set by dac_follow_set(),
+            noise-shaped to the code with BOARD_DAC_DITHER_BITS
+        Playout: dac_playout_start() — stream plays the samples queued by
+            dac_playout_push() a fixed delay after their timestamps
+        Latch: BOARD_DAC_LATCH_ENABLE — software writes convert on the
+            TIM2 TRGO (sampling tick) instead of at once
  
  */
 #include "dac.h"
 #include "board_config.h"
 #include "hal_config.h"
+#include "eeprom.h"
+#include "prof.h"
+#include "timebase.h"
 #include "stm32l0xx_hal.h"
+#include "hal_atomic.h"
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+/* DAC codes per mV, Q16 (rounded): 4095 / 3300 mV = 81324 / 65536.
+ * 3300 mV * 81324 stays below 2^32 */
+#define DAC_CODE_PER_MV_Q16  (((BOARD_DAC_MAX_CODE << 16) + BOARD_DAC_VREF_MV / 2U) / BOARD_DAC_VREF_MV)
+
+/* DAC codes per volt, folded at compile time. The product rounds
+ * differently from the divide only next to a half code: within
+ * DAC_CODE_NEAR_HALF of one, the divide decides (about 1 input in 4000;
+ * bit-exact with it over every float in 0..VREF) */
+#define DAC_CODE_PER_VOLT    ((float)BOARD_DAC_MAX_CODE / BOARD_DAC_VREF_VOLTS)
+#define DAC_CODE_NEAR_HALF   (1.0f / 1024.0f)
+
+/* Calibration record in data EEPROM:
+ * [0] magic, [1..2] OUT1 gain/offset, [3..4] OUT2 gain/offset, [5] ~sum of [0..4] */
+#define DAC_CALIB_MAGIC     0x44414331UL  /* "DAC1" */
+#define DAC_CALIB_WORDS     6U
+
+#define DAC_CHANNEL_COUNT   2U
 
 /* ============================================================================
  * PRIVATE VARIABLES
  * ============================================================================ */
 
 static bool dac_initialized = false;
+static dac_calibration_t calibration[DAC_CHANNEL_COUNT];  /* As stored, at nominal VDDA */
+static dac_calibration_t transfer[DAC_CHANNEL_COUNT];     /* Calibration at the actual VDDA */
+static uint32_t vdda_mv = BOARD_DAC_VREF_MV;
+/* Millivolt path per channel, calibration folded in: code = (mV * scale + offset) >> 16 */
+static int32_t mv_scale_q16[DAC_CHANNEL_COUNT];
+static int32_t mv_offset_q16[DAC_CHANNEL_COUNT];
+
+#if BOARD_DAC_STREAM_ENABLE
+/* Two halves: the DMA plays one while the refill callback fills the other */
+static uint32_t stream_buffer[2U * BOARD_DAC_STREAM_BLOCK];
+static dac_stream_refill_t stream_refill = NULL;
+static volatile bool stream_running = false;
+static uint32_t stream_since_us;             /* Start of the running stream */
+static uint32_t stream_us = 0;               /* Streams before it (wraps) */
+
+/* Follower (dac_follow_start()): the stream plays a ramp toward the latest
+ * target. Targets are written by the main loop, read by the DMA interrupt */
+static volatile uint32_t follow_target;      /* out1 low half, out2 high half */
+static volatile uint32_t follow_sequence;    /* Bumped after each new target */
+static bool follow_active = false;
+static uint32_t follow_seen;                 /* DMA interrupt only from here */
+static int32_t follow_pos_q16[DAC_CHANNEL_COUNT];
+static int32_t follow_goal_q16[DAC_CHANNEL_COUNT];
+static int32_t follow_step_q16[DAC_CHANNEL_COUNT];
+static uint32_t follow_interval;             /* Samples since the last target */
+static uint32_t follow_interval_max;
+static int32_t follow_max_step_q16;          /* 0: no slew limit */
+#if BOARD_DAC_DITHER_BITS != 0
+static int32_t follow_error_q16[DAC_CHANNEL_COUNT];  /* Left by the last quantization */
+#endif
+
+/* Playout (dac_playout_start()): samples in a ring, pushed by the main loop
+ * (head), released by the DMA interrupt (tail: start of the segment being
+ * played). The segment slope is worked out once, when the output enters it */
+#define DAC_PLAYOUT_MASK  (DAC_PLAYOUT_DEPTH - 1U)
+#if (DAC_PLAYOUT_DEPTH & DAC_PLAYOUT_MASK) != 0U
+#error "DAC_PLAYOUT_DEPTH must be a power of two"
+#endif
+static uint32_t playout_ts[DAC_PLAYOUT_DEPTH];
+static volatile uint32_t playout_codes[DAC_PLAYOUT_DEPTH];  /* out1 low half, out2 high half */
+static volatile uint32_t playout_head;
+static volatile uint32_t playout_tail;
+static bool playout_active = false;
+static bool playout_extrapolate;
+static uint32_t playout_delay_us;
+static uint32_t playout_period_us;
+static uint32_t playout_hold;                /* Shown before the first sample is due */
+static uint32_t playout_seg;                 /* Segment start the slopes are for */
+static bool playout_seg_valid;
+static int32_t playout_slope_q16[DAC_CHANNEL_COUNT];  /* Codes per us */
+static uint32_t playout_seg_us;              /* Segment length */
+static bool playout_starved;                 /* Past the newest sample */
+static dac_playout_stats_t playout_stats;
+#endif
 
 /* External HAL handle - defined in main.c */
 extern DAC_HandleTypeDef hdac1;
@@ -59,20 +155,286 @@ static float dac_clip_voltage(float voltage_volts)
 }
 
 /**
- * @brief Get HAL channel from DAC channel enum
+ * @brief Clip a Q16 code to 0..BOARD_DAC_MAX_CODE
+ */
+static uint16_t dac_clip_code_q16(int64_t code_q16)
+{
+    if (code_q16 <= 0) {
+        return 0;
+    }
+    if (code_q16 >= ((int64_t)BOARD_DAC_MAX_CODE << 16)) {
+        return (uint16_t)BOARD_DAC_MAX_CODE;
+    }
+    return (uint16_t)(code_q16 >> 16);
+}
+
+/**
+ * @brief Fold a channel calibration and the actual VDDA into its scales
+ */
+static void dac_transfer_update(dac_channel_t channel)
+{
+    const dac_calibration_t *cal = &calibration[channel];
+    dac_calibration_t *xfer = &transfer[channel];
+    
+    /* A code gives VDDA / VREF_MV times the nominal voltage: scale it back */
+    xfer->gain_q16 = (uint32_t)(((uint64_t)cal->gain_q16 * BOARD_DAC_VREF_MV + vdda_mv / 2U) / vdda_mv);
+    xfer->offset_q16 = cal->offset_q16;
+    
+    /* 81324 * 2.2 (gain 1.1 at VDDA 1.65 V) * 3300 mV stays below 2^31 */
+    mv_scale_q16[channel] = (int32_t)(((uint64_t)DAC_CODE_PER_MV_Q16 * xfer->gain_q16 +
+                                       0x8000U) >> 16);
+    mv_offset_q16[channel] = xfer->offset_q16 + 0x8000;  /* Rounded */
+}
+
+/**
+ * @brief Set a channel calibration and fold it into its scales
+ */
+static void dac_calibration_apply(dac_channel_t channel, const dac_calibration_t *cal)
+{
+    calibration[channel] = *cal;
+    dac_transfer_update(channel);
+}
+
+/**
+ * @brief Checksum of a calibration record (complement of the word sum)
+ */
+static uint32_t dac_calibration_sum(const uint32_t *record)
+{
+    uint32_t sum = 0;
+    
+    for (uint32_t i = 0; i < DAC_CALIB_WORDS - 1U; i++) {
+        sum += record[i];
+    }
+    return ~sum;
+}
+
+/**
+ * @brief Load both calibrations from data EEPROM (unity if none or invalid)
+ */
+static void dac_calibration_load(void)
+{
+    const dac_calibration_t unity = { DAC_CAL_GAIN_UNITY, 0 };
+    uint32_t record[DAC_CALIB_WORDS];
+    bool valid;
+    
+    valid = eeprom_read_words(BOARD_EEPROM_DAC_CALIB_OFFSET, record, DAC_CALIB_WORDS) &&
+            record[0] == DAC_CALIB_MAGIC &&
+            record[DAC_CALIB_WORDS - 1U] == dac_calibration_sum(record);
+    
+    for (uint32_t ch = 0; ch < DAC_CHANNEL_COUNT; ch++) {
+        dac_calibration_t cal = unity;
+        
+        if (valid) {
+            cal.gain_q16 = record[1U + 2U * ch];
+            cal.offset_q16 = (int32_t)record[2U + 2U * ch];
+        }
+        /* Range-checked: a record out of range falls back to unity */
+        if (!dac_set_calibration((dac_channel_t)ch, &cal)) {
+            dac_calibration_apply((dac_channel_t)ch, &unity);
+        }
+    }
+}
+
+#if BOARD_DAC_STREAM_ENABLE
+/**
+ * @brief Follower per-sample step toward a new target
  * 
- * @param channel DAC channel enum
- * @return HAL DAC channel constant
+ * Spread over the interval since the previous target (the sample period as
+ * seen at the output), then limited to the slew rate.
  */
-static uint32_t dac_get_hal_channel(dac_channel_t channel)
+static int32_t dac_follow_step(int32_t pos_q16, int32_t goal_q16, uint32_t interval)
 {
-    if (channel == DAC_CHANNEL_OUT1) {
-        return BOARD_DAC1_OUT1_CHANNEL;
+    int32_t step = (goal_q16 - pos_q16) / (int32_t)interval;
+    
+    if (step == 0) {
+        step = (goal_q16 > pos_q16) ? 1 : -1;  /* Reach it within the interval */
+    }
+    if (follow_max_step_q16 != 0) {
+        if (step > follow_max_step_q16) {
+            step = follow_max_step_q16;
+        } else if (step < -follow_max_step_q16) {
+            step = -follow_max_step_q16;
+        }
+    }
+    return step;
+}
+
+#if BOARD_DAC_DITHER_BITS != 0
+/**
+ * @brief Noise-shaped code of the follower position (first-order)
+ * 
+ * Rounds position plus carried error and carries the new error, which
+ * stays within half a code: the position is 0..MAX_CODE, so the rounded
+ * code is too and needs no clip.
+ */
+static uint16_t dac_follow_shape(uint32_t ch)
+{
+    int32_t value = follow_pos_q16[ch] + follow_error_q16[ch];
+    int32_t code = (value + 0x8000) >> 16;
+    
+    follow_error_q16[ch] = value - (code << 16);
+    return (uint16_t)code;
+}
+#endif
+
+/**
+ * @brief Stream refill of the follower: linear ramp to the latest target
+ */
+static void dac_follow_refill(uint32_t *samples, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t sequence = follow_sequence;
+        
+        if (sequence != follow_seen) {
+            uint32_t target = follow_target;
+            
+            follow_seen = sequence;
+            follow_goal_q16[0] = (int32_t)((target & 0xFFFFU) << (16U - BOARD_DAC_DITHER_BITS));
+            follow_goal_q16[1] = (int32_t)((target >> 16) << (16U - BOARD_DAC_DITHER_BITS));
+            for (uint32_t ch = 0; ch < DAC_CHANNEL_COUNT; ch++) {
+                follow_step_q16[ch] = dac_follow_step(follow_pos_q16[ch], follow_goal_q16[ch],
+                                                      follow_interval);
+            }
+            follow_interval = 0;
+        }
+        
+        for (uint32_t ch = 0; ch < DAC_CHANNEL_COUNT; ch++) {
+            int32_t pos = follow_pos_q16[ch] + follow_step_q16[ch];
+            
+            /* Stop at the goal instead of overshooting it */
+            if ((follow_step_q16[ch] > 0 && pos >= follow_goal_q16[ch]) ||
+                (follow_step_q16[ch] < 0 && pos <= follow_goal_q16[ch])) {
+                pos = follow_goal_q16[ch];
+                follow_step_q16[ch] = 0;
+            }
+            follow_pos_q16[ch] = pos;
+        }
+        
+        if (follow_interval < follow_interval_max) {
+            follow_interval++;
+        }
+#if BOARD_DAC_DITHER_BITS != 0
+        samples[i] = dac_stream_sample(dac_follow_shape(0), dac_follow_shape(1));
+#else
+        samples[i] = dac_stream_sample((uint16_t)(follow_pos_q16[0] >> 16),
+                                       (uint16_t)(follow_pos_q16[1] >> 16));
+#endif
+    }
+}
+
+/**
+ * @brief Code of one channel of a packed word
+ */
+static int32_t dac_playout_code(uint32_t word, uint32_t ch)
+{
+    return (int32_t)((ch == 0U) ? (word & 0xFFFFU) : (word >> 16));
+}
+
+/**
+ * @brief Output of the playout at one time
+ * 
+ * Releases the samples before the segment around t. Codes are read fresh,
+ * so a replaced newest sample shows at once; only the slopes are cached.
+ */
+static uint32_t dac_playout_at(uint32_t t)
+{
+    uint32_t head = playout_head;
+    uint32_t tail = playout_tail;
+    uint32_t word;
+    uint32_t dt;
+    int32_t out[DAC_CHANNEL_COUNT];
+    
+    while (head - tail > 1U && (int32_t)(playout_ts[(tail + 1U) & DAC_PLAYOUT_MASK] - t) <= 0) {
+        tail++;
+    }
+    playout_tail = tail;
+    
+    /* Nothing due yet: hold */
+    if (head == tail || (int32_t)(t - playout_ts[tail & DAC_PLAYOUT_MASK]) < 0) {
+        return playout_hold;
+    }
+    word = playout_codes[tail & DAC_PLAYOUT_MASK];
+    dt = t - playout_ts[tail & DAC_PLAYOUT_MASK];
+    
+    if (head - tail > 1U) {
+        /* Between two samples */
+        if (!playout_seg_valid || playout_seg != tail) {
+            uint32_t next = playout_codes[(tail + 1U) & DAC_PLAYOUT_MASK];
+            
+            playout_seg_us = playout_ts[(tail + 1U) & DAC_PLAYOUT_MASK] - playout_ts[tail & DAC_PLAYOUT_MASK];
+            if (playout_seg_us == 0U) {
+                playout_seg_us = 1U;
+            }
+            for (uint32_t ch = 0; ch < DAC_CHANNEL_COUNT; ch++) {
+                playout_slope_q16[ch] = (dac_playout_code(next, ch) - dac_playout_code(word, ch)) * 65536 /
+                                        (int32_t)playout_seg_us;
+            }
+            playout_seg = tail;
+            playout_seg_valid = true;
+        }
+        playout_starved = false;
     } else {
-        return BOARD_DAC1_OUT2_CHANNEL;
+        /* Past the newest sample: carry the segment into it on, or hold */
+        if (!playout_starved) {
+            playout_starved = true;
+            playout_stats.underruns++;
+        }
+        if (!playout_extrapolate || !playout_seg_valid || playout_seg != tail - 1U) {
+            playout_hold = word;
+            return word;
+        }
+        if (dt > playout_seg_us) {
+            dt = playout_seg_us;
+        }
+    }
+    
+    /* Slope times at most one segment: within +/-2^28, no overflow */
+    for (uint32_t ch = 0; ch < DAC_CHANNEL_COUNT; ch++) {
+        out[ch] = dac_playout_code(word, ch) * 65536 + playout_slope_q16[ch] * (int32_t)dt + 0x8000;
+        out[ch] = (out[ch] < 0) ? 0 : (out[ch] >> 16);
     }
+    playout_hold = ((uint32_t)out[1] << 16) | (uint32_t)out[0];
+    return playout_hold;
 }
 
+/**
+ * @brief Stream refill of the playout
+ * 
+ * The half being filled plays after the one the DMA has just started:
+ * its first update is BOARD_DAC_STREAM_BLOCK periods from now.
+ */
+static void dac_playout_refill(uint32_t *samples, uint32_t count)
+{
+    uint32_t t = hal_tim2_get_timestamp_us() + BOARD_DAC_STREAM_BLOCK * playout_period_us -
+                 playout_delay_us;
+    
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t word = dac_playout_at(t);
+        
+        samples[i] = dac_stream_sample((uint16_t)(word & 0xFFFFU), (uint16_t)(word >> 16));
+        t += playout_period_us;
+    }
+}
+
+/**
+ * @brief DMA half transfer: first half played
+ */
+static void dac_stream_half_cplt(DMA_HandleTypeDef *hdma)
+{
+    (void)hdma;
+    stream_refill(&stream_buffer[0], BOARD_DAC_STREAM_BLOCK);
+}
+
+/**
+ * @brief DMA transfer complete: second half played, DMA wraps to the first
+ */
+static void dac_stream_cplt(DMA_HandleTypeDef *hdma)
+{
+    (void)hdma;
+    stream_refill(&stream_buffer[BOARD_DAC_STREAM_BLOCK], BOARD_DAC_STREAM_BLOCK);
+}
+#endif
+
 /* ============================================================================
  * PUBLIC FUNCTIONS
  * ============================================================================ */
@@ -93,45 +455,488 @@ bool dac_init(void)
         return false;
     }
     
+    dac_calibration_load();
+    dac_initialized = true;
+    
     /* Initialize both channels to 0V */
-    dac_set_voltage_ch1(0.0f);
-    dac_set_voltage_ch2(0.0f);
+    dac_set_dual(0, 0);
     
-    dac_initialized = true;
     return true;
 }
 
-bool dac_set_voltage_ch1(float voltage_volts)
+bool dac_set_code(dac_channel_t channel, uint16_t code)
 {
-    return dac_set_voltage(DAC_CHANNEL_OUT1, voltage_volts);
+    if (!dac_initialized || dac_stream_is_running()) {
+        return false;
+    }
+    
+    /* Unchanged codes are not rewritten */
+    (void)dac_write_fast(channel, code);
+    return true;
 }
 
-bool dac_set_voltage_ch2(float voltage_volts)
+bool dac_set_dual(uint16_t out1_code, uint16_t out2_code)
 {
-    return dac_set_voltage(DAC_CHANNEL_OUT2, voltage_volts);
+    if (!dac_initialized || dac_stream_is_running()) {
+        return false;
+    }
+    
+    /* One DHR12RD store; skipped if both codes are unchanged */
+    (void)dac_write_dual_fast(out1_code, out2_code);
+    return true;
 }
 
-bool dac_set_voltage(dac_channel_t channel, float voltage_volts)
+uint32_t dac_stream_sample(uint16_t out1_code, uint16_t out2_code)
 {
-    if (!dac_initialized) {
+    if (out1_code > BOARD_DAC_MAX_CODE) {
+        out1_code = BOARD_DAC_MAX_CODE;
+    }
+    if (out2_code > BOARD_DAC_MAX_CODE) {
+        out2_code = BOARD_DAC_MAX_CODE;
+    }
+    
+    /* Same layout as dac_set_dual(): DHR12RD channel 1 low, channel 2 high */
+    if (BOARD_DAC1_OUT1_CHANNEL == DAC_CHANNEL_1) {
+        return ((uint32_t)out2_code << 16) | out1_code;
+    }
+    return ((uint32_t)out1_code << 16) | out2_code;
+}
+
+bool dac_stream_start(uint32_t rate_hz, dac_stream_refill_t refill)
+{
+#if BOARD_DAC_STREAM_ENABLE
+    DMA_HandleTypeDef *hdma = hdac1.DMA_Handle2;
+    
+    if (!dac_initialized || stream_running || refill == NULL || hdma == NULL ||
+        rate_hz == 0U || rate_hz > BOARD_DAC_STREAM_MAX_HZ) {
         return false;
     }
     
-    /* Clip voltage to valid range */
-    float clipped_voltage = dac_clip_voltage(voltage_volts);
+    stream_refill = refill;
+    refill(&stream_buffer[0], BOARD_DAC_STREAM_BLOCK);
+    refill(&stream_buffer[BOARD_DAC_STREAM_BLOCK], BOARD_DAC_STREAM_BLOCK);
+    
+    if (!hal_dac1_set_trigger(true)) {
+        hal_dac1_set_trigger(false);
+        return false;
+    }
+    
+    /* Callbacks set before the start: HAL enables HT only when one is set */
+    hdma->XferHalfCpltCallback = dac_stream_half_cplt;
+    hdma->XferCpltCallback = dac_stream_cplt;
+    if (HAL_DMA_Start_IT(hdma, (uint32_t)stream_buffer, (uint32_t)&hdac1.Instance->DHR12RD,
+                         2U * BOARD_DAC_STREAM_BLOCK) != HAL_OK) {
+        hal_dac1_set_trigger(false);
+        return false;
+    }
     
-    /* Convert voltage to DAC code */
-    uint16_t dac_code = dac_voltage_to_code(clipped_voltage);
+    /* Channel 2 requests on every trigger; the word updates both channels */
+    hdac1.Instance->CR |= DAC_CR_DMAEN2;
+    stream_since_us = timebase_now_us();
+    stream_running = true;
     
-    /* Get HAL channel */
-    uint32_t hal_channel = dac_get_hal_channel(channel);
+    if (!hal_dac1_stream_timer_start(rate_hz)) {
+        dac_stream_stop();
+        return false;
+    }
+    
+    return true;
+#else
+    (void)rate_hz;
+    (void)refill;
+    return false;
+#endif
+}
+
+void dac_stream_stop(void)
+{
+#if BOARD_DAC_STREAM_ENABLE
+    if (!stream_running) {
+        return;
+    }
+    
+    hal_dac1_stream_timer_stop();
+    hdac1.Instance->CR &= ~DAC_CR_DMAEN2;
+    HAL_DMA_Abort(hdac1.DMA_Handle2);
     
-    /* Set DAC value */
-    if (HAL_DAC_SetValue(&hdac1, hal_channel, DAC_ALIGN_12B_R, dac_code) != HAL_OK) {
+    /* Back to software writes; the next dac_set_*() call takes over */
+    hal_dac1_set_trigger(false);
+    stream_us += timebase_now_us() - stream_since_us;
+    stream_running = false;
+    follow_active = false;
+    playout_active = false;
+#endif
+}
+
+bool dac_follow_start(uint32_t rate_hz, uint16_t max_step)
+{
+#if BOARD_DAC_STREAM_ENABLE
+    if (!dac_initialized || stream_running || rate_hz == 0U) {
         return false;
     }
     
+    /* Start from what the outputs show now: no jump */
+    follow_pos_q16[0] = (int32_t)(HAL_DAC_GetValue(&hdac1, BOARD_DAC1_OUT1_CHANNEL) << 16);
+    follow_pos_q16[1] = (int32_t)(HAL_DAC_GetValue(&hdac1, BOARD_DAC1_OUT2_CHANNEL) << 16);
+    for (uint32_t ch = 0; ch < DAC_CHANNEL_COUNT; ch++) {
+        follow_goal_q16[ch] = follow_pos_q16[ch];
+        follow_step_q16[ch] = 0;
+#if BOARD_DAC_DITHER_BITS != 0
+        follow_error_q16[ch] = 0;
+#endif
+    }
+    follow_seen = follow_sequence;
+    follow_interval = 1;
+    /* A first target after a long pause ramps over 100 ms at most */
+    follow_interval_max = (rate_hz >= 10U) ? rate_hz / 10U : 1U;
+    follow_max_step_q16 = (int32_t)((uint32_t)max_step << 16);
+    
+    if (!dac_stream_start(rate_hz, dac_follow_refill)) {
+        return false;
+    }
+    follow_active = true;
     return true;
+#else
+    (void)rate_hz;
+    (void)max_step;
+    return false;
+#endif
+}
+
+bool dac_follow_set(uint16_t out1_code, uint16_t out2_code)
+{
+    if (out1_code > BOARD_DAC_MAX_CODE) {
+        out1_code = BOARD_DAC_MAX_CODE;
+    }
+    if (out2_code > BOARD_DAC_MAX_CODE) {
+        out2_code = BOARD_DAC_MAX_CODE;
+    }
+    return dac_follow_set_fine((uint16_t)(out1_code << BOARD_DAC_DITHER_BITS),
+                               (uint16_t)(out2_code << BOARD_DAC_DITHER_BITS));
+}
+
+bool dac_follow_set_fine(uint16_t out1_fine, uint16_t out2_fine)
+{
+#if BOARD_DAC_STREAM_ENABLE
+    if (!follow_active) {
+        return false;
+    }
+    
+    if (out1_fine > DAC_FINE_MAX) {
+        out1_fine = DAC_FINE_MAX;
+    }
+    if (out2_fine > DAC_FINE_MAX) {
+        out2_fine = DAC_FINE_MAX;
+    }
+    
+    /* One word, then the sequence: the refill never sees half a target */
+    follow_target = ((uint32_t)out2_fine << 16) | out1_fine;
+    follow_sequence++;
+    return true;
+#else
+    (void)out1_fine;
+    (void)out2_fine;
+    return false;
+#endif
+}
+
+bool dac_follow_is_active(void)
+{
+#if BOARD_DAC_STREAM_ENABLE
+    return follow_active;
+#else
+    return false;
+#endif
+}
+
+bool dac_playout_start(uint32_t rate_hz, uint32_t delay_us, bool extrapolate)
+{
+#if BOARD_DAC_STREAM_ENABLE
+    if (!dac_initialized || stream_running || rate_hz == 0U) {
+        return false;
+    }
+    
+    /* Held at what the outputs show now until the first sample is due */
+    playout_hold = ((uint32_t)HAL_DAC_GetValue(&hdac1, BOARD_DAC1_OUT2_CHANNEL) << 16) |
+                   HAL_DAC_GetValue(&hdac1, BOARD_DAC1_OUT1_CHANNEL);
+    playout_head = 0;
+    playout_tail = 0;
+    playout_seg_valid = false;
+    playout_starved = false;
+    playout_stats = (dac_playout_stats_t){0};
+    playout_extrapolate = extrapolate;
+    playout_delay_us = delay_us;
+    playout_period_us = 1000000UL / rate_hz;
+    
+    if (!dac_stream_start(rate_hz, dac_playout_refill)) {
+        return false;
+    }
+    playout_active = true;
+    return true;
+#else
+    (void)rate_hz;
+    (void)delay_us;
+    (void)extrapolate;
+    return false;
+#endif
+}
+
+bool dac_playout_push(uint32_t timestamp_us, uint16_t out1_code, uint16_t out2_code)
+{
+#if BOARD_DAC_STREAM_ENABLE
+    uint32_t head = playout_head;
+    uint32_t word;
+    
+    if (!playout_active) {
+        return false;
+    }
+    
+    if (out1_code > BOARD_DAC_MAX_CODE) {
+        out1_code = BOARD_DAC_MAX_CODE;
+    }
+    if (out2_code > BOARD_DAC_MAX_CODE) {
+        out2_code = BOARD_DAC_MAX_CODE;
+    }
+    word = ((uint32_t)out2_code << 16) | out1_code;
+    
+    if (head != 0U) {
+        int32_t age = (int32_t)(timestamp_us - playout_ts[(head - 1U) & DAC_PLAYOUT_MASK]);
+        
+        if (age == 0) {
+            playout_codes[(head - 1U) & DAC_PLAYOUT_MASK] = word;
+            return true;
+        }
+        if (age < 0) {
+            return false;
+        }
+    }
+    if (head - playout_tail >= DAC_PLAYOUT_DEPTH) {
+        playout_stats.overflows++;
+        return false;
+    }
+    
+    /* Entry first, then the head: the refill never sees half of one */
+    playout_ts[head & DAC_PLAYOUT_MASK] = timestamp_us;
+    playout_codes[head & DAC_PLAYOUT_MASK] = word;
+    __DMB();
+    playout_head = head + 1U;
+    return true;
+#else
+    (void)timestamp_us;
+    (void)out1_code;
+    (void)out2_code;
+    return false;
+#endif
+}
+
+bool dac_playout_is_active(void)
+{
+#if BOARD_DAC_STREAM_ENABLE
+    return playout_active;
+#else
+    return false;
+#endif
+}
+
+void dac_playout_get_stats(dac_playout_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+#if BOARD_DAC_STREAM_ENABLE
+    *stats = playout_stats;
+#else
+    *stats = (dac_playout_stats_t){0};
+#endif
+}
+
+bool dac_stream_is_running(void)
+{
+#if BOARD_DAC_STREAM_ENABLE
+    return stream_running;
+#else
+    return false;
+#endif
+}
+
+dac_stream_refill_t dac_stream_get_refill(void)
+{
+#if BOARD_DAC_STREAM_ENABLE
+    return stream_running ? stream_refill : NULL;
+#else
+    return NULL;
+#endif
+}
+
+uint32_t dac_stream_get_active_us(void)
+{
+#if BOARD_DAC_STREAM_ENABLE
+    uint32_t primask;
+    uint32_t active_us;
+    
+    primask = hal_crit_enter();
+    active_us = stream_us;
+    if (stream_running) {
+        active_us += timebase_now_us() - stream_since_us;
+    }
+    hal_crit_exit(primask);
+    return active_us;
+#else
+    return 0;
+#endif
+}
+
+bool dac_set_millivolts(dac_channel_t channel, uint32_t millivolts)
+{
+    if (millivolts > BOARD_DAC_VREF_MV) {
+        millivolts = BOARD_DAC_VREF_MV;
+    }
+    
+    /* Same cost as the ideal conversion: the calibration is in the scale */
+    return dac_set_code(channel, dac_clip_code_q16((int64_t)((int32_t)millivolts * mv_scale_q16[channel] +
+                                                             mv_offset_q16[channel])));
+}
+
+uint16_t dac_get_output_code(dac_channel_t channel)
+{
+    if (channel == DAC_CHANNEL_OUT1) {
+        return (uint16_t)(BOARD_DAC_PERIPH->DOR1 & DAC_DOR1_DACC1DOR);
+    }
+    if (channel == DAC_CHANNEL_OUT2) {
+        return (uint16_t)(BOARD_DAC_PERIPH->DOR2 & DAC_DOR2_DACC2DOR);
+    }
+    return 0;
+}
+
+bool dac_get_calibration(dac_channel_t channel, dac_calibration_t *cal)
+{
+    if (cal == NULL || (uint32_t)channel >= DAC_CHANNEL_COUNT) {
+        return false;
+    }
+    
+    *cal = calibration[channel];
+    return true;
+}
+
+bool dac_get_transfer(dac_channel_t channel, dac_calibration_t *cal)
+{
+    if (cal == NULL || (uint32_t)channel >= DAC_CHANNEL_COUNT) {
+        return false;
+    }
+    
+    *cal = transfer[channel];
+    return true;
+}
+
+bool dac_set_vdda_mv(uint32_t millivolts)
+{
+    if (millivolts < DAC_VDDA_MIN_MV || millivolts > DAC_VDDA_MAX_MV) {
+        return false;
+    }
+    
+    /* Same context as the other scale users (main loop) */
+    vdda_mv = millivolts;
+    for (uint32_t ch = 0; ch < DAC_CHANNEL_COUNT; ch++) {
+        dac_transfer_update((dac_channel_t)ch);
+    }
+    return true;
+}
+
+uint32_t dac_get_vdda_mv(void)
+{
+    return vdda_mv;
+}
+
+bool dac_set_calibration(dac_channel_t channel, const dac_calibration_t *cal)
+{
+    if (cal == NULL || (uint32_t)channel >= DAC_CHANNEL_COUNT ||
+        cal->gain_q16 < DAC_CAL_GAIN_MIN || cal->gain_q16 > DAC_CAL_GAIN_MAX ||
+        cal->offset_q16 < -DAC_CAL_OFFSET_MAX || cal->offset_q16 > DAC_CAL_OFFSET_MAX) {
+        return false;
+    }
+    
+    dac_calibration_apply(channel, cal);
+    return true;
+}
+
+bool dac_calibrate_from_points(dac_channel_t channel, uint16_t code_lo, uint32_t mv_lo,
+                               uint16_t code_hi, uint32_t mv_hi)
+{
+    dac_calibration_t cal;
+    int64_t gain;
+    
+    if (code_hi <= code_lo || code_hi > BOARD_DAC_MAX_CODE ||
+        mv_hi <= mv_lo || mv_hi > vdda_mv) {
+        return false;
+    }
+    
+    /* Ideal code of a measurement at the actual VDDA: mV * MAX_CODE / VDDA,
+     * so the stored calibration excludes the supply. Gain maps the ideal
+     * span onto the raw span; offset puts the low point in place */
+    gain = ((int64_t)(code_hi - code_lo) * vdda_mv * 65536 +
+            (int64_t)(mv_hi - mv_lo) * BOARD_DAC_MAX_CODE / 2) /
+           ((int64_t)(mv_hi - mv_lo) * BOARD_DAC_MAX_CODE);
+    cal.gain_q16 = (uint32_t)gain;
+    cal.offset_q16 = (int32_t)(((int64_t)code_lo << 16) -
+                               gain * mv_lo * BOARD_DAC_MAX_CODE / vdda_mv);
+    
+    return dac_set_calibration(channel, &cal);
+}
+
+bool dac_calibration_save(void)
+{
+    uint32_t record[DAC_CALIB_WORDS];
+    
+    record[0] = DAC_CALIB_MAGIC;
+    for (uint32_t ch = 0; ch < DAC_CHANNEL_COUNT; ch++) {
+        record[1U + 2U * ch] = calibration[ch].gain_q16;
+        record[2U + 2U * ch] = (uint32_t)calibration[ch].offset_q16;
+    }
+    record[DAC_CALIB_WORDS - 1U] = dac_calibration_sum(record);
+    
+    return eeprom_write_async(BOARD_EEPROM_DAC_CALIB_OFFSET, record, DAC_CALIB_WORDS);
+}
+
+uint16_t dac_calibrated_code(dac_channel_t channel, uint16_t ideal_code)
+{
+    const dac_calibration_t *cal = &transfer[channel == DAC_CHANNEL_OUT1 ? 0 : 1];
+    
+    return dac_clip_code_q16((int64_t)ideal_code * cal->gain_q16 + cal->offset_q16 + 0x8000);
+}
+
+uint16_t dac_millivolts_to_code(uint32_t millivolts)
+{
+    if (millivolts > BOARD_DAC_VREF_MV) {
+        millivolts = BOARD_DAC_VREF_MV;
+    }
+    
+    return (uint16_t)((millivolts * DAC_CODE_PER_MV_Q16 + 0x8000UL) >> 16);
+}
+
+bool dac_set_voltage_ch1(float voltage_volts)
+{
+    return dac_set_voltage(DAC_CHANNEL_OUT1, voltage_volts);
+}
+
+bool dac_set_voltage_ch2(float voltage_volts)
+{
+    return dac_set_voltage(DAC_CHANNEL_OUT2, voltage_volts);
+}
+
+bool dac_set_voltage(dac_channel_t channel, float voltage_volts)
+{
+    bool ok;
+    
+    if (!dac_initialized) {
+        return false;
+    }
+    
+    /* Clipped in the conversion; the write is the integer path */
+    PROF_BEGIN(PROF_SITE_DAC_SET_VOLTAGE);
+    ok = dac_set_code(channel, dac_calibrated_code(channel, dac_voltage_to_code(voltage_volts)));
+    PROF_END(PROF_SITE_DAC_SET_VOLTAGE);
+    
+    return ok;
 }
 
 uint16_t dac_voltage_to_code(float voltage_volts)
@@ -139,12 +944,15 @@ uint16_t dac_voltage_to_code(float voltage_volts)
     /* Clip voltage to valid range */
     float clipped = dac_clip_voltage(voltage_volts);
     
-    /* Convert to DAC code: code = (voltage / VREF) * MAX_CODE */
-    float normalized = clipped / BOARD_DAC_VREF_VOLTS;
-    float code_float = normalized * (float)BOARD_DAC_MAX_CODE;
+    /* Convert to DAC code: code = voltage * (MAX_CODE / VREF), rounded */
+    float code_float = clipped * DAC_CODE_PER_VOLT + 0.5f;
+    uint16_t code = (uint16_t)code_float;
+    float fraction = code_float - (float)code;
     
-    /* Round to nearest integer */
-    uint16_t code = (uint16_t)(code_float + 0.5f);
+    /* Next to a half code: code = (voltage / VREF) * MAX_CODE, as defined */
+    if (fraction < DAC_CODE_NEAR_HALF || fraction > 1.0f - DAC_CODE_NEAR_HALF) {
+        code = (uint16_t)(clipped / BOARD_DAC_VREF_VOLTS * (float)BOARD_DAC_MAX_CODE + 0.5f);
+    }
     
     /* Ensure code is within valid range (should be, but double-check) */
     if (code > BOARD_DAC_MAX_CODE) {
@@ -14,15 +14,56 @@
  * - Automatic conversion to 12-bit DAC codes
  * - Automatic clipping to valid range (0.0V to VREF)
  * - Support for both DAC channels (OUT1 and OUT2)
+ * - Integer path (dac_set_code(), dac_set_millivolts()): no soft-float.
+ *   The float API wraps it; with -ffunction-sections/--gc-sections the
+ *   float helpers are only linked when called
+ * - Per-channel gain/offset calibration (data EEPROM), folded into the
+ *   millivolt scale at init: dac_set_millivolts() costs the same with it.
+ *   Codes (dac_set_code(), dac_set_dual(), stream samples) are written as
+ *   given; callers fold the calibration into their own scale
+ *   (dac_get_transfer()) or use dac_calibrated_code()
+ * - VDDA tracking (dac_set_vdda_mv()): the measured supply is folded into
+ *   the same scales, so a sagging VDDA does not move the outputs
+ * - Streaming (dac_stream_start()): TIM6 triggers both channels at a fixed
+ *   rate and DMA feeds them from a double buffer; the refill callback runs
+ *   in the DMA interrupt for the half just played. No CPU per sample
+ * - Follower (dac_follow_start()): the stream interpolates between
+ *   successive targets at the stream rate, optionally slew-limited;
+ *   with BOARD_DAC_DITHER_BITS the targets carry fraction bits, noise-
+ *   shaped into the stream (dac_follow_set_fine())
+ * - Playout (dac_playout_start()): the stream plays timestamped samples
+ *   from a short buffer a fixed delay after their timestamps, so late or
+ *   bunched samples leave the output cadence alone
+ * - Register fast path (dac_write_fast(), dac_write_dual_fast()): inline
+ *   data register writes for ISR use, skipped when the code is unchanged
+ * - Latch (BOARD_DAC_LATCH_ENABLE): every software write lands in the data
+ *   registers and converts on the next TIM2 tick, so the outputs move at a
+ *   fixed phase of sampling; dac_get_output_code() shows the old code until
+ *   then
  */
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "board_config.h"
+#include "stm32l0xx_hal.h"  /* For the register fast path */
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define DAC_CAL_GAIN_UNITY   0x10000UL
+#define DAC_CAL_GAIN_MIN     58982UL     /* 0.9: beyond, the board is faulty */
+#define DAC_CAL_GAIN_MAX     72090UL     /* 1.1 */
+#define DAC_CAL_OFFSET_MAX   (200L << 16)  /* +/-200 codes */
+#define DAC_PLAYOUT_DEPTH    32U     /* Samples the playout buffer holds (power of two) */
+#define DAC_VDDA_MIN_MV      1650UL  /* dac_set_vdda_mv() range */
+#define DAC_VDDA_MAX_MV      3600UL
+#define DAC_FINE_MAX         (BOARD_DAC_MAX_CODE << BOARD_DAC_DITHER_BITS)  /* dac_follow_set_fine() */
+
 /* ============================================================================
  * TYPES
  * ============================================================================ */
@@ -35,6 +76,36 @@ typedef enum {
     DAC_CHANNEL_OUT2 = 1   /* DAC1 Channel 2 (PA5) */
 } dac_channel_t;
 
+/**
+ * @brief Channel calibration: code = (ideal_code * gain_q16 + offset_q16) >> 16
+ * 
+ * ideal_code is the code of the ideal 0..VREF transfer.
+ */
+typedef struct {
+    uint32_t gain_q16;   /* DAC_CAL_GAIN_UNITY = 1.0 */
+    int32_t offset_q16;  /* Codes, Q16 */
+} dac_calibration_t;
+
+/**
+ * @brief Playout buffer counters (since dac_playout_start())
+ */
+typedef struct {
+    uint32_t underruns;  /* Times the output got past the newest sample */
+    uint32_t overflows;  /* Samples dropped on a full buffer */
+} dac_playout_stats_t;
+
+/**
+ * @brief Stream refill callback
+ * 
+ * Called from the DMA interrupt (priority 2) with the half buffer that has
+ * just been played; it must be refilled before the other half ends
+ * (BOARD_DAC_STREAM_BLOCK samples). Pack each sample with dac_stream_sample().
+ * 
+ * @param samples Half buffer to fill
+ * @param count Samples in it (BOARD_DAC_STREAM_BLOCK)
+ */
+typedef void (*dac_stream_refill_t)(uint32_t *samples, uint32_t count);
+
 /* ============================================================================
  * FUNCTIONS
  * ============================================================================ */
@@ -49,6 +120,290 @@ typedef enum {
  */
 bool dac_init(void);
 
+/**
+ * @brief Set the DAC code of a channel
+ * 
+ * @param channel DAC channel (DAC_CHANNEL_OUT1 or DAC_CHANNEL_OUT2)
+ * @param code 12-bit DAC code, clipped to BOARD_DAC_MAX_CODE
+ * @return true if successful, false otherwise
+ */
+bool dac_set_code(dac_channel_t channel, uint16_t code);
+
+/**
+ * @brief Set both DAC codes in one write (DHR12RD)
+ * 
+ * Both outputs change on the same cycle, so a logger sampling OUT1 and OUT2
+ * never sees one updated and the other not.
+ * 
+ * @param out1_code 12-bit code for DAC_CHANNEL_OUT1, clipped to BOARD_DAC_MAX_CODE
+ * @param out2_code 12-bit code for DAC_CHANNEL_OUT2, clipped to BOARD_DAC_MAX_CODE
+ * @return true if successful, false otherwise
+ */
+bool dac_set_dual(uint16_t out1_code, uint16_t out2_code);
+
+/**
+ * @brief Set DAC output voltage in millivolts (integer path)
+ * 
+ * Converted with the channel's Q16 scale (calibration folded in at init)
+ * and clipped to 0..BOARD_DAC_VREF_MV.
+ * 
+ * @param channel DAC channel (DAC_CHANNEL_OUT1 or DAC_CHANNEL_OUT2)
+ * @param millivolts Desired output voltage in mV
+ * @return true if successful, false otherwise
+ */
+bool dac_set_millivolts(dac_channel_t channel, uint32_t millivolts);
+
+/**
+ * @brief Code the channel is converting now (DOR register)
+ * 
+ * Whatever wrote it: software, stream or follower. Raw, so calibration
+ * included.
+ * 
+ * @param channel DAC channel (DAC_CHANNEL_OUT1 or DAC_CHANNEL_OUT2)
+ * @return 12-bit DAC code, 0 for an invalid channel
+ */
+uint16_t dac_get_output_code(dac_channel_t channel);
+
+/**
+ * @brief Convert millivolts to DAC code (ideal transfer, integer path)
+ * 
+ * @param millivolts Voltage in mV, clipped to 0..BOARD_DAC_VREF_MV
+ * @return 12-bit DAC code (0 to 4095)
+ */
+uint16_t dac_millivolts_to_code(uint32_t millivolts);
+
+/**
+ * @brief Pack one stream sample (DHR12RD word)
+ * 
+ * @param out1_code 12-bit code for DAC_CHANNEL_OUT1, clipped to BOARD_DAC_MAX_CODE
+ * @param out2_code 12-bit code for DAC_CHANNEL_OUT2, clipped to BOARD_DAC_MAX_CODE
+ * @return Sample for the stream buffer
+ */
+uint32_t dac_stream_sample(uint16_t out1_code, uint16_t out2_code);
+
+/**
+ * @brief Start streaming both outputs at a fixed rate
+ * 
+ * Both halves are filled by the callback before the first trigger. While
+ * the stream runs the DMA owns the outputs: the set functions return false.
+ * Requires BOARD_DAC_STREAM_ENABLE.
+ * 
+ * @param rate_hz Samples per second (up to BOARD_DAC_STREAM_MAX_HZ)
+ * @param refill Fills each half buffer (interrupt context)
+ * @return true if started, false if out of range, already running or not
+ *         built in
+ */
+bool dac_stream_start(uint32_t rate_hz, dac_stream_refill_t refill);
+
+/**
+ * @brief Stop streaming
+ * 
+ * The outputs return to software writes (dac_set_*()).
+ */
+void dac_stream_stop(void);
+
+/**
+ * @brief Check whether a stream is running
+ */
+bool dac_stream_is_running(void);
+
+/**
+ * @brief Refill callback of the running stream
+ * 
+ * @return The dac_stream_start() callback (the follower's or the playout's
+ *         own while they run), NULL if no stream runs
+ */
+dac_stream_refill_t dac_stream_get_refill(void);
+
+/**
+ * @brief Time streamed since boot
+ * 
+ * @return Microseconds (wraps, take differences)
+ */
+uint32_t dac_stream_get_active_us(void);
+
+/**
+ * @brief Smooth the outputs: stream a ramp toward each new target
+ * 
+ * Runs the stream engine at rate_hz. Each dac_follow_set() target is
+ * reached linearly over the interval since the previous target, so a
+ * staircase of samples becomes a piecewise-linear output one sample period
+ * behind. max_step also limits the slew.
+ * 
+ * @param rate_hz Output update rate (up to BOARD_DAC_STREAM_MAX_HZ)
+ * @param max_step Slew limit in codes per update, 0 for none
+ * @return true if started, false if a stream is running or not built in
+ */
+bool dac_follow_start(uint32_t rate_hz, uint16_t max_step);
+
+/**
+ * @brief Set the next follower target
+ * 
+ * Main loop; the DMA interrupt picks it up at the next update.
+ * 
+ * @param out1_code 12-bit code for DAC_CHANNEL_OUT1, clipped to BOARD_DAC_MAX_CODE
+ * @param out2_code 12-bit code for DAC_CHANNEL_OUT2, clipped to BOARD_DAC_MAX_CODE
+ * @return true if set, false if the follower is not running
+ */
+bool dac_follow_set(uint16_t out1_code, uint16_t out2_code);
+
+/**
+ * @brief Set the next follower target with BOARD_DAC_DITHER_BITS fraction bits
+ * 
+ * The follower ramps at that resolution and quantizes each update with
+ * first-order error feedback: the average of the codes it plays is the
+ * target, and the error left by each update is carried into the next, so
+ * the quantization noise sits near the stream rate, above the output
+ * filter. Same as dac_follow_set() with BOARD_DAC_DITHER_BITS 0.
+ * 
+ * @param out1_fine Code << BOARD_DAC_DITHER_BITS for DAC_CHANNEL_OUT1, clipped
+ *                  to DAC_FINE_MAX
+ * @param out2_fine Same for DAC_CHANNEL_OUT2
+ * @return true if set, false if the follower is not running
+ */
+bool dac_follow_set_fine(uint16_t out1_fine, uint16_t out2_fine);
+
+/**
+ * @brief Check whether the follower owns the stream (stopped with
+ *        dac_stream_stop())
+ */
+bool dac_follow_is_active(void);
+
+/**
+ * @brief Play timestamped samples at a fixed delay (jitter buffer)
+ * 
+ * Runs the stream engine at rate_hz. Each update shows the samples as they
+ * were delay_us earlier, linearly interpolated between the two around that
+ * time, so the output keeps the stream cadence however unevenly the
+ * samples arrive. The time is the sampling timebase
+ * (hal_tim2_get_timestamp_us()) read at each refill, which runs up to two
+ * half buffers (2 * BOARD_DAC_STREAM_BLOCK updates) ahead of the output:
+ * delay_us covers that plus the sample latency. Past the newest sample
+ * the output holds it, or with extrapolate carries the last slope on for
+ * one more sample interval, then holds.
+ * 
+ * @param rate_hz Output update rate (up to BOARD_DAC_STREAM_MAX_HZ)
+ * @param delay_us Sample timestamp to output time
+ * @param extrapolate true to extrapolate on an underrun, false to hold
+ * @return true if started, false if a stream is running or not built in
+ */
+bool dac_playout_start(uint32_t rate_hz, uint32_t delay_us, bool extrapolate);
+
+/**
+ * @brief Queue a sample for the playout
+ * 
+ * Main loop. A sample with the timestamp of the newest one replaces its
+ * codes (e.g. an output held outside the mapping).
+ * 
+ * @param timestamp_us Sample timestamp (sampling timebase), not older than
+ *                     the newest one
+ * @param out1_code 12-bit code for DAC_CHANNEL_OUT1, clipped to BOARD_DAC_MAX_CODE
+ * @param out2_code 12-bit code for DAC_CHANNEL_OUT2, clipped to BOARD_DAC_MAX_CODE
+ * @return true if queued, false if the playout is not running, the
+ *         timestamp is out of order or the buffer is full
+ */
+bool dac_playout_push(uint32_t timestamp_us, uint16_t out1_code, uint16_t out2_code);
+
+/**
+ * @brief Check whether the playout owns the stream (stopped with
+ *        dac_stream_stop())
+ */
+bool dac_playout_is_active(void);
+
+/**
+ * @brief Get the playout counters
+ * 
+ * @param stats Receives them
+ */
+void dac_playout_get_stats(dac_playout_stats_t *stats);
+
+/**
+ * @brief Get the calibration of a channel
+ * 
+ * @param channel DAC channel
+ * @param cal Receives gain and offset (unity if none was stored)
+ * @return true if successful, false otherwise
+ */
+bool dac_get_calibration(dac_channel_t channel, dac_calibration_t *cal);
+
+/**
+ * @brief Get the calibration of a channel at the actual VDDA
+ * 
+ * Gain includes BOARD_DAC_VREF_MV / VDDA: fold this, not the stored
+ * calibration, into a per-sample scale, and refold after
+ * dac_set_vdda_mv().
+ * 
+ * @param channel DAC channel
+ * @param cal Receives gain and offset
+ * @return true if successful, false otherwise
+ */
+bool dac_get_transfer(dac_channel_t channel, dac_calibration_t *cal);
+
+/**
+ * @brief Set the actual VDDA (DAC reference)
+ * 
+ * Refolds the millivolt scales and dac_calibrated_code(). Calibration
+ * points taken afterwards are measured against it. Main loop only.
+ * 
+ * @param millivolts VDDA in mV (DAC_VDDA_MIN_MV..DAC_VDDA_MAX_MV)
+ * @return true if set, false if out of range
+ */
+bool dac_set_vdda_mv(uint32_t millivolts);
+
+/**
+ * @brief VDDA the scales are folded for, mV (BOARD_DAC_VREF_MV until set)
+ */
+uint32_t dac_get_vdda_mv(void);
+
+/**
+ * @brief Apply a channel calibration (RAM; see dac_calibration_save())
+ * 
+ * @param channel DAC channel
+ * @param cal Gain within DAC_CAL_GAIN_MIN..MAX, offset within
+ *            +/-DAC_CAL_OFFSET_MAX
+ * @return true if applied, false if out of range
+ */
+bool dac_set_calibration(dac_channel_t channel, const dac_calibration_t *cal);
+
+/**
+ * @brief Calibrate a channel from two measured points
+ * 
+ * The given codes were written raw (uncalibrated) and the output measured.
+ * Gain and offset are those that make both measurements land on their
+ * ideal codes.
+ * 
+ * @param channel DAC channel
+ * @param code_lo Raw code of the low point
+ * @param mv_lo Output measured at code_lo, mV
+ * @param code_hi Raw code of the high point (above code_lo)
+ * @param mv_hi Output measured at code_hi, mV (above mv_lo)
+ * @return true if applied, false if the points give an out-of-range result
+ */
+bool dac_calibrate_from_points(dac_channel_t channel, uint16_t code_lo, uint32_t mv_lo,
+                               uint16_t code_hi, uint32_t mv_hi);
+
+/**
+ * @brief Store both channel calibrations in data EEPROM
+ * 
+ * Queued (eeprom_write_async(), written in the background, the checksum
+ * word last); not from interrupt context.
+ * 
+ * @return true if queued, false if the EEPROM queue is full
+ */
+bool dac_calibration_save(void);
+
+/**
+ * @brief Calibrated code of an ideal code
+ * 
+ * One multiply per call: for a per-sample path, fold dac_get_transfer()
+ * into the caller's scale instead.
+ * 
+ * @param channel DAC channel
+ * @param ideal_code Code of the ideal 0..VREF transfer
+ * @return Code to write, clipped to 0..BOARD_DAC_MAX_CODE
+ */
+uint16_t dac_calibrated_code(dac_channel_t channel, uint16_t ideal_code);
+
 /**
  * @brief Set DAC output voltage for channel 1
  * 
@@ -125,6 +480,74 @@ float dac_get_vref(void);
  */
 uint8_t dac_get_resolution_bits(void);
 
+/* ============================================================================
+ * INLINE FAST PATH
+ * ============================================================================ */
+
+/* Data register of a channel: DHR12R1 feeds DAC_CHANNEL_1 */
+#define DAC_FAST_DHR(channel) \
+    (((channel) == DAC_CHANNEL_OUT1) == (BOARD_DAC1_OUT1_CHANNEL == DAC_CHANNEL_1) ? \
+     &BOARD_DAC_PERIPH->DHR12R1 : &BOARD_DAC_PERIPH->DHR12R2)
+
+/**
+ * @brief Write a DAC code straight to its data register
+ * 
+ * For ISR sample-to-DAC paths: no init check, no HAL call, no lock. The DAC
+ * must have been started by dac_init(). The write is skipped when the
+ * register already holds the code, and while a stream owns the outputs.
+ * Calibration is the caller's (dac_get_transfer()).
+ * 
+ * @param channel DAC channel (DAC_CHANNEL_OUT1 or DAC_CHANNEL_OUT2)
+ * @param code 12-bit DAC code, clipped to BOARD_DAC_MAX_CODE
+ * @return true if the register was written
+ */
+static inline bool dac_write_fast(dac_channel_t channel, uint16_t code)
+{
+    volatile uint32_t *dhr = DAC_FAST_DHR(channel);
+    
+    if (code > BOARD_DAC_MAX_CODE) {
+        code = BOARD_DAC_MAX_CODE;
+    }
+    if (*dhr == code || (BOARD_DAC_PERIPH->CR & DAC_CR_DMAEN2) != 0U) {
+        return false;
+    }
+    
+    *dhr = code;
+    return true;
+}
+
+/**
+ * @brief Write both DAC codes in one DHR12RD store (fast path)
+ * 
+ * Same rules as dac_write_fast(); skipped only when both codes are
+ * unchanged.
+ * 
+ * @param out1_code 12-bit code for DAC_CHANNEL_OUT1, clipped to BOARD_DAC_MAX_CODE
+ * @param out2_code 12-bit code for DAC_CHANNEL_OUT2, clipped to BOARD_DAC_MAX_CODE
+ * @return true if the register was written
+ */
+static inline bool dac_write_dual_fast(uint16_t out1_code, uint16_t out2_code)
+{
+    if (out1_code > BOARD_DAC_MAX_CODE) {
+        out1_code = BOARD_DAC_MAX_CODE;
+    }
+    if (out2_code > BOARD_DAC_MAX_CODE) {
+        out2_code = BOARD_DAC_MAX_CODE;
+    }
+    if ((*DAC_FAST_DHR(DAC_CHANNEL_OUT1) == out1_code && *DAC_FAST_DHR(DAC_CHANNEL_OUT2) == out2_code) ||
+        (BOARD_DAC_PERIPH->CR & DAC_CR_DMAEN2) != 0U) {
+        return false;
+    }
+    
+    /* DHR12RD: channel 1 in the low half, channel 2 in the high half */
+    if (BOARD_DAC1_OUT1_CHANNEL == DAC_CHANNEL_1) {
+        BOARD_DAC_PERIPH->DHR12RD = ((uint32_t)out2_code << 16) | out1_code;
+    } else {
+        BOARD_DAC_PERIPH->DHR12RD = ((uint32_t)out1_code << 16) | out2_code;
+    }
+    return true;
+}
+
 #ifdef __cplusplus
 }
 #endif
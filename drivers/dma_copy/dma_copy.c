@@ -0,0 +1,175 @@
+/**
+ * @file dma_copy.c
+ * @brief Asynchronous memory copies on a DMA channel implementation
+ *
+ * The queue is a ring of BOARD_DMA_COPY_QUEUE descriptors, the head one
+ * on the channel. It changes with interrupts masked (submitters) or from
+ * the channel interrupt, which masks nothing: only it removes entries,
+ * and only the submitters add them. A copy longer than one transfer of
+ * the channel (65535 items) runs as several back to back, continued from
+ * the interrupt.
+ */
+
+#include "dma_copy.h"
+
+#if BOARD_DMA_COPY_ENABLE
+
+#include <string.h>
+#include "stm32l0xx_hal.h"
+#include "hal_atomic.h"
+#include "hal_config.h"
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define DMA_COPY_QUEUE_MASK  (BOARD_DMA_COPY_QUEUE - 1U)
+
+#if BOARD_DMA_COPY_QUEUE == 0U || (BOARD_DMA_COPY_QUEUE & DMA_COPY_QUEUE_MASK) != 0U
+#error "BOARD_DMA_COPY_QUEUE must be a power of 2"
+#endif
+
+#define DMA_COPY_MAX_ITEMS   0xFFFFU  /* CNDTR */
+
+/**
+ * @brief One queued copy
+ */
+typedef struct {
+    uint8_t *dst;
+    const uint8_t *src;
+    uint32_t len;            /* Bytes left for the channel */
+    dma_copy_done_t done;
+    void *ctx;
+} dma_copy_job_t;
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static dma_copy_job_t queue[BOARD_DMA_COPY_QUEUE];
+static uint8_t queue_first = 0;
+static volatile uint8_t queue_count = 0;
+static uint32_t running_bytes = 0;   /* Bytes of the transfer on the channel */
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Put the next part of the head copy on the channel
+ *
+ * For a copy whose ends share their alignment, the CPU moves the bytes
+ * before the first aligned word and after the last one (first part only:
+ * none are left for the others).
+ */
+static void dma_copy_start(dma_copy_job_t *job)
+{
+    uint32_t head = (0U - (uint32_t)job->dst) & 3U;
+    uint32_t items;
+    bool words = false;
+
+    if ((((uint32_t)job->dst ^ (uint32_t)job->src) & 3U) == 0U && job->len >= head + 4U) {
+        uint32_t tail = (job->len - head) & 3U;
+
+        memcpy(job->dst, job->src, head);
+        memcpy(job->dst + job->len - tail, job->src + job->len - tail, tail);
+        job->dst += head;
+        job->src += head;
+        job->len -= head + tail;  /* Later parts: aligned, whole words */
+        words = true;
+    }
+
+    items = words ? job->len / 4U : job->len;
+    if (items > DMA_COPY_MAX_ITEMS) {
+        items = DMA_COPY_MAX_ITEMS;
+    }
+    running_bytes = words ? items * 4U : items;
+    hal_copy_dma_start(job->dst, job->src, items, words);
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+bool dma_copy_init(void)
+{
+    queue_first = 0;
+    queue_count = 0;
+    return hal_copy_dma_init();
+}
+
+bool dma_copy_submit(void *dst, const void *src, uint32_t len, dma_copy_done_t done, void *ctx)
+{
+    dma_copy_job_t *job;
+    uint32_t primask;
+
+    if (dst == NULL || src == NULL) {
+        return false;
+    }
+
+    if (len < BOARD_DMA_COPY_MIN_BYTES || (uint32_t)src < SRAM_BASE) {
+        memcpy(dst, src, len);
+        if (done != NULL) {
+            done(ctx, true);
+        }
+        return true;
+    }
+
+    primask = hal_crit_enter();
+    if (queue_count == BOARD_DMA_COPY_QUEUE) {
+        hal_crit_exit(primask);
+        return false;
+    }
+    job = &queue[(queue_first + queue_count) & DMA_COPY_QUEUE_MASK];
+    job->dst = (uint8_t *)dst;
+    job->src = (const uint8_t *)src;
+    job->len = len;
+    job->done = done;
+    job->ctx = ctx;
+    queue_count++;
+    if (queue_count == 1U) {
+        dma_copy_start(job);
+    }
+    hal_crit_exit(primask);
+    return true;
+}
+
+bool dma_copy_is_idle(void)
+{
+    return queue_count == 0U;
+}
+
+void dma_copy_irq_handler(void)
+{
+    dma_copy_job_t *job;
+    dma_copy_done_t done;
+    void *ctx;
+    bool error;
+
+    if (queue_count == 0U || !hal_copy_dma_irq(&error)) {
+        return;
+    }
+
+    job = &queue[queue_first];
+    job->dst += running_bytes;
+    job->src += running_bytes;
+    job->len -= running_bytes;
+    if (!error && job->len != 0U) {
+        dma_copy_start(job);
+        return;
+    }
+
+    /* Taken off before the completion: it may submit again */
+    done = job->done;
+    ctx = job->ctx;
+    queue_first = (uint8_t)((queue_first + 1U) & DMA_COPY_QUEUE_MASK);
+    queue_count--;
+    if (queue_count != 0U) {
+        dma_copy_start(&queue[queue_first]);
+    }
+    if (done != NULL) {
+        done(ctx, !error);
+    }
+}
+
+#endif /* BOARD_DMA_COPY_ENABLE */
@@ -0,0 +1,89 @@
+#ifndef DMA_COPY_H
+#define DMA_COPY_H
+
+/**
+ * @file dma_copy.h
+ * @brief Asynchronous memory copies on a DMA channel
+ *
+ * dma_copy_submit() queues a copy and returns; the DMA channel
+ * (BOARD_DMA_COPY_CHANNEL) moves it while the core works on or sleeps,
+ * and the completion runs from the channel interrupt as it ends. Copies
+ * run one at a time, in submission order. Where source and destination
+ * share their alignment the channel moves words, the CPU the up to three
+ * bytes either side at the start; otherwise it moves bytes.
+ *
+ * Done at once by memcpy() instead, completion included, ahead of any
+ * queued copy:
+ *   - copies shorter than BOARD_DMA_COPY_MIN_BYTES, where setting up the
+ *     channel costs more than it saves
+ *   - copies from flash, which the DMA cannot read while the core sleeps
+ *     (flash interface clock gated, board_init.c)
+ *
+ * Submit from the main loop or from handlers at or below
+ * BOARD_IRQ_PRIO_DMA_COPY. Source and destination must not overlap, and
+ * stay untouched until the completion. BOARD_DMA_COPY_ENABLE builds.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * TYPES
+ * ============================================================================ */
+
+/**
+ * @brief Copy completion (channel interrupt, or the submitter for a
+ *        copy done at once)
+ *
+ * @param ctx As submitted
+ * @param ok false if the copy ended on a transfer error (destination
+ *           partly written)
+ */
+typedef void (*dma_copy_done_t)(void *ctx, bool ok);
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Set up the channel
+ *
+ * @return true if initialization successful, false otherwise
+ */
+bool dma_copy_init(void);
+
+/**
+ * @brief Queue a copy
+ *
+ * @param dst  Destination
+ * @param src  Source
+ * @param len  Bytes (0 completes at once)
+ * @param done Completion, or NULL (poll dma_copy_is_idle())
+ * @param ctx  Passed to done
+ * @return true if queued or done, false if the queue is full or an
+ *         address is NULL (no completion then)
+ */
+bool dma_copy_submit(void *dst, const void *src, uint32_t len, dma_copy_done_t done, void *ctx);
+
+/**
+ * @brief Check whether every queued copy has completed
+ */
+bool dma_copy_is_idle(void);
+
+/**
+ * @brief Channel interrupt work (call from the DMA1 channel 4-7 vector)
+ *
+ * Completes the copy that ended, then starts the next one.
+ */
+void dma_copy_irq_handler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DMA_COPY_H */
@@ -0,0 +1,370 @@
+/**
+ * @file eeprom.c
+ * @brief STM32L0 data EEPROM driver implementation
+ * 
+ * Reads use the memory-mapped EEPROM directly. Writes go through a ring of
+ * {offset, value} entries: the hardware erases and programs a word in a
+ * single ~3.2ms operation, started by a plain store with PELOCK cleared,
+ * and its end of operation interrupt (EOPIE) takes the entry off and
+ * starts the next, so the controller is never idle while words wait and
+ * no context spins on BSY. PECR stays unlocked while the ring runs and
+ * locks again once it is empty. FIX is left clear: the hardware skips the
+ * erase phase of a word when the new value does not need it.
+ * 
+ * The entry at the tail is the word being written (while `writing`); the
+ * ones after it have not started and take a new value for their offset in
+ * place, so a word queued again moves no earlier. Queue edits and lookups
+ * are a short PRIMASK section per word (the producers are the main loop
+ * and, in RTOS builds, tasks), no longer than a scan of the ring.
+ */
+
+#include "eeprom.h"
+#include "board_config.h"
+#include "stm32l0xx_hal.h"
+#include "hal_atomic.h"
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define EEPROM_QUEUE_WORDS  BOARD_EEPROM_QUEUE_WORDS
+
+#if EEPROM_QUEUE_WORDS == 0U || (EEPROM_QUEUE_WORDS & (EEPROM_QUEUE_WORDS - 1U)) != 0U
+#error "BOARD_EEPROM_QUEUE_WORDS must be a power of two"
+#endif
+
+#define EEPROM_SR_ERRORS  (FLASH_SR_WRPERR | FLASH_SR_PGAERR | FLASH_SR_SIZERR | \
+                           FLASH_SR_OPTVERR | FLASH_SR_RDERR | FLASH_SR_NOTZEROERR | \
+                           FLASH_SR_FWWERR)
+
+/**
+ * @brief One queued word
+ */
+typedef struct {
+    uint32_t offset;
+    uint32_t value;
+} eeprom_entry_t;
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static eeprom_entry_t queue[EEPROM_QUEUE_WORDS];
+static volatile uint32_t queue_head = 0;  /* Queued (producers) */
+static volatile uint32_t queue_tail = 0;  /* Written or skipped (interrupt) */
+static volatile bool writing = false;    /* Entry at the tail in progress */
+static volatile uint32_t claims = 0;     /* Program flash operations holding the queue */
+static volatile bool background = false; /* One of them left to the interrupt to end */
+static volatile bool background_failed = false;
+static eeprom_stats_t stats;
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Check that a word range lies inside the data EEPROM
+ */
+static bool eeprom_range_ok(uint32_t offset, uint32_t count)
+{
+    if ((offset & 0x3U) != 0U || offset > EEPROM_SIZE_BYTES) {
+        return false;
+    }
+    
+    return count <= (EEPROM_SIZE_BYTES - offset) / 4U;
+}
+
+static volatile uint32_t *eeprom_word(uint32_t offset)
+{
+    return (volatile uint32_t *)(DATA_EEPROM_BASE + offset);
+}
+
+/**
+ * @brief Value a word will hold once the queue is written (interrupts masked)
+ */
+static uint32_t eeprom_peek(uint32_t offset)
+{
+    for (uint32_t i = queue_head; i != queue_tail; i--) {
+        const eeprom_entry_t *e = &queue[(i - 1U) % EEPROM_QUEUE_WORDS];
+        
+        if (e->offset == offset) {
+            return e->value;
+        }
+    }
+    return *eeprom_word(offset);
+}
+
+/**
+ * @brief Start the oldest word that still needs writing, or stop the ring
+ * 
+ * Interrupt context, or interrupts masked with no word in progress.
+ */
+static void eeprom_start_next(void)
+{
+    while (claims == 0U && queue_tail != queue_head) {
+        const eeprom_entry_t *e = &queue[queue_tail % EEPROM_QUEUE_WORDS];
+        
+        if (*eeprom_word(e->offset) == e->value) {
+            stats.skipped++;
+            queue_tail++;
+            continue;
+        }
+        
+        if ((FLASH->PECR & FLASH_PECR_PELOCK) != 0U) {
+            FLASH->PEKEYR = FLASH_PEKEY1;
+            FLASH->PEKEYR = FLASH_PEKEY2;
+        }
+        FLASH->PECR |= FLASH_PECR_EOPIE | FLASH_PECR_ERRIE;
+        writing = true;
+        *eeprom_word(e->offset) = e->value;
+        return;
+    }
+    
+    FLASH->PECR &= ~(FLASH_PECR_EOPIE | FLASH_PECR_ERRIE);
+    if (claims == 0U) {
+        FLASH->PECR |= FLASH_PECR_PELOCK;
+    }
+}
+
+/**
+ * @brief Queue one word
+ * 
+ * @return false if the queue is full
+ */
+static bool eeprom_queue_word(uint32_t offset, uint32_t value)
+{
+    uint32_t primask;
+    uint32_t first;
+    uint32_t i;
+    bool queued = true;
+    
+    primask = hal_crit_enter();
+    
+    /* A word not started yet takes the new value where it is */
+    first = writing ? queue_tail + 1U : queue_tail;
+    for (i = queue_head; i != first; i--) {
+        if (queue[(i - 1U) % EEPROM_QUEUE_WORDS].offset == offset) {
+            break;
+        }
+    }
+    
+    if (i != first) {
+        queue[(i - 1U) % EEPROM_QUEUE_WORDS].value = value;
+        stats.coalesced++;
+    } else if (eeprom_peek(offset) == value) {
+        stats.skipped++;
+    } else if (queue_head - queue_tail >= EEPROM_QUEUE_WORDS) {
+        queued = false;
+    } else {
+        queue[queue_head % EEPROM_QUEUE_WORDS].offset = offset;
+        queue[queue_head % EEPROM_QUEUE_WORDS].value = value;
+        queue_head++;
+        if (!writing) {
+            eeprom_start_next();
+        }
+    }
+    
+    hal_crit_exit(primask);
+    return queued;
+}
+
+/**
+ * @brief One pass of a blocking wait on the queue
+ * 
+ * A caller at or above BOARD_IRQ_PRIO_EEPROM (a job with BOARD_PURE_ISR)
+ * holds the flash interrupt off: its request stays pending, and is taken
+ * here instead. Masked, so it cannot also be taken as an interrupt.
+ */
+static void eeprom_wait_step(void)
+{
+    uint32_t primask = hal_crit_enter();
+    
+    if (NVIC_GetPendingIRQ(FLASH_IRQn) != 0U) {
+        eeprom_irq_handler();
+        NVIC_ClearPendingIRQ(FLASH_IRQn);  /* Flags cleared: the line is low now */
+    }
+    hal_crit_exit(primask);
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+bool eeprom_init(void)
+{
+    queue_head = 0;
+    queue_tail = 0;
+    writing = false;
+    claims = 0;
+    stats = (eeprom_stats_t){0};
+    
+    FLASH->SR = FLASH_SR_EOP | EEPROM_SR_ERRORS;
+    HAL_NVIC_SetPriority(FLASH_IRQn, BOARD_IRQ_PRIO_EEPROM, 0);
+    HAL_NVIC_EnableIRQ(FLASH_IRQn);
+    
+    return true;
+}
+
+bool eeprom_read_words(uint32_t offset, uint32_t *words, uint32_t count)
+{
+    uint32_t primask;
+    
+    if (words == NULL || !eeprom_range_ok(offset, count)) {
+        return false;
+    }
+    
+    for (uint32_t i = 0; i < count; i++) {
+        if (queue_head == queue_tail) {
+            words[i] = *eeprom_word(offset + i * 4U);
+            continue;
+        }
+        primask = hal_crit_enter();
+        words[i] = eeprom_peek(offset + i * 4U);
+        hal_crit_exit(primask);
+    }
+    
+    return true;
+}
+
+bool eeprom_write_async(uint32_t offset, const uint32_t *words, uint32_t count)
+{
+    if (words == NULL || !eeprom_range_ok(offset, count)) {
+        return false;
+    }
+    
+    for (uint32_t i = 0; i < count; i++) {
+        if (!eeprom_queue_word(offset + i * 4U, words[i])) {
+            stats.dropped += count - i;
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+uint32_t eeprom_write_room(void)
+{
+    return EEPROM_QUEUE_WORDS - (queue_head - queue_tail);
+}
+
+bool eeprom_write_words(uint32_t offset, const uint32_t *words, uint32_t count)
+{
+    if (words == NULL || !eeprom_range_ok(offset, count)) {
+        return false;
+    }
+    
+    for (uint32_t i = 0; i < count; i++) {
+        while (!eeprom_queue_word(offset + i * 4U, words[i])) {
+            /* Full: the interrupt frees an entry every ~3.2ms */
+            eeprom_wait_step();
+        }
+    }
+    eeprom_flush();
+    
+    /* A failed word keeps its old value */
+    for (uint32_t i = 0; i < count; i++) {
+        if (*eeprom_word(offset + i * 4U) != words[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void eeprom_flush(void)
+{
+    while (queue_tail != queue_head) {
+        eeprom_wait_step();
+    }
+}
+
+void eeprom_claim(void)
+{
+    uint32_t primask = hal_crit_enter();
+    
+    claims++;
+    hal_crit_exit(primask);
+    
+    while (writing || background) {
+        eeprom_wait_step();
+    }
+}
+
+void eeprom_release(void)
+{
+    uint32_t primask = hal_crit_enter();
+    
+    if (claims > 0U) {
+        claims--;
+    }
+    if (claims == 0U && !writing) {
+        eeprom_start_next();
+    }
+    hal_crit_exit(primask);
+}
+
+void eeprom_release_at_eop(void)
+{
+    uint32_t primask = hal_crit_enter();
+    
+    background_failed = false;
+    background = true;
+    FLASH->PECR |= FLASH_PECR_EOPIE | FLASH_PECR_ERRIE;
+    hal_crit_exit(primask);
+}
+
+bool eeprom_background_busy(bool *failed)
+{
+    if (background) {
+        return true;
+    }
+    if (failed != NULL) {
+        *failed = background_failed;
+    }
+    return false;
+}
+
+void eeprom_get_stats(eeprom_stats_t *stats_out)
+{
+    uint32_t primask;
+    
+    if (stats_out == NULL) {
+        return;
+    }
+    
+    primask = hal_crit_enter();
+    *stats_out = stats;
+    hal_crit_exit(primask);
+}
+
+void eeprom_irq_handler(void)
+{
+    uint32_t sr = FLASH->SR;
+    
+    FLASH->SR = sr & (FLASH_SR_EOP | EEPROM_SR_ERRORS);
+    if ((sr & FLASH_SR_BSY) != 0U) {
+        return;
+    }
+    
+    if (background) {
+        background_failed = (sr & EEPROM_SR_ERRORS) != 0U;
+        background = false;
+        FLASH->PECR &= ~(FLASH_PECR_ERASE | FLASH_PECR_PROG | FLASH_PECR_FPRG);
+        if (claims > 0U) {
+            claims--;
+        }
+        eeprom_start_next();
+        return;
+    }
+    if (!writing) {
+        return;
+    }
+    
+    if ((sr & EEPROM_SR_ERRORS) != 0U) {
+        stats.failed++;
+    } else {
+        stats.written++;
+    }
+    writing = false;
+    queue_tail++;
+    eeprom_start_next();
+}
@@ -0,0 +1,164 @@
+#ifndef EEPROM_H
+#define EEPROM_H
+
+/**
+ * @file eeprom.h
+ * @brief STM32L0 data EEPROM driver
+ * 
+ * Word-granular access to the 6 KB on-chip data EEPROM (two banks,
+ * DATA_EEPROM_BASE .. DATA_EEPROM_BANK2_END). Offsets are relative to
+ * DATA_EEPROM_BASE and must be word aligned.
+ * 
+ * Features:
+ * - Reads straight from the memory-mapped EEPROM (no bus transaction),
+ *   with the words still queued for it in their place
+ * - Queued word writes (~3.2ms each in the background): the end of
+ *   operation interrupt starts the next word, so a write costs the caller
+ *   a few stores. Words that already hold the requested value are
+ *   skipped, and a word queued again before it is written only changes
+ *   its value (wear and time saved)
+ * - Blocking writes for the callers that check what they wrote
+ * 
+ * Queue and reads from the main loop only (the host task in RTOS builds).
+ * The program flash users (flash_log.h, fw_update.h) share the controller:
+ * they hold the queue with eeprom_claim() around each erase or program,
+ * or hand the claim to the end of operation interrupt for an erase left
+ * running in the background (eeprom_release_at_eop()).
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define EEPROM_SIZE_BYTES       (6U * 1024U)  /* Bank 1 + bank 2 */
+
+/**
+ * @brief Write queue counters (since boot)
+ */
+typedef struct {
+    uint32_t written;     /* Words programmed */
+    uint32_t skipped;     /* Already held the value */
+    uint32_t coalesced;   /* Queued again before being written */
+    uint32_t failed;      /* Program errors (word lost) */
+    uint32_t dropped;     /* Queue full */
+} eeprom_stats_t;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Empty the write queue and enable the flash interface interrupt
+ * 
+ * @return true if initialization successful, false otherwise
+ */
+bool eeprom_init(void);
+
+/**
+ * @brief Read words from data EEPROM
+ * 
+ * Queued words read as queued.
+ * 
+ * @param offset Byte offset from DATA_EEPROM_BASE (word aligned)
+ * @param words Destination buffer
+ * @param count Number of 32-bit words to read
+ * @return true if the range is valid, false otherwise
+ */
+bool eeprom_read_words(uint32_t offset, uint32_t *words, uint32_t count);
+
+/**
+ * @brief Queue words for the data EEPROM (returns at once)
+ * 
+ * Written in the order queued (here lowest offset first), except that a
+ * word still waiting from an earlier call takes the new value in its
+ * place: a caller that needs one word to land after another queues them
+ * one call each and does not rewrite the later one.
+ * 
+ * @param offset Byte offset from DATA_EEPROM_BASE (word aligned)
+ * @param words Source buffer (copied)
+ * @param count Number of 32-bit words to write
+ * @return true if every word was queued (or needs no write), false if the
+ *         range is invalid or the queue is full (the rest is dropped)
+ */
+bool eeprom_write_async(uint32_t offset, const uint32_t *words, uint32_t count);
+
+/**
+ * @brief Free entries in the write queue
+ */
+uint32_t eeprom_write_room(void);
+
+/**
+ * @brief Write words to data EEPROM (blocking)
+ * 
+ * Queues them and waits until the queue is written: for a caller that
+ * reads the words back. Must not be called from interrupt context.
+ * 
+ * @param offset Byte offset from DATA_EEPROM_BASE (word aligned)
+ * @param words Source buffer
+ * @param count Number of 32-bit words to write
+ * @return true if all words were written, false otherwise
+ */
+bool eeprom_write_words(uint32_t offset, const uint32_t *words, uint32_t count);
+
+/**
+ * @brief Wait until every queued word is written
+ * 
+ * Before a reset. Must not be called from interrupt context.
+ */
+void eeprom_flush(void);
+
+/**
+ * @brief Hold the queue for a program flash operation
+ * 
+ * Waits for the word being written, then starts no other until
+ * eeprom_release(). Nests.
+ */
+void eeprom_claim(void);
+
+/**
+ * @brief Let the queue run again
+ */
+void eeprom_release(void);
+
+/**
+ * @brief Release the claim when the program flash operation just started ends
+ * 
+ * For an erase started without waiting for it, with the claim held and the
+ * controller unlocked: the end of operation interrupt clears the operation
+ * bits, releases the claim and restarts the queue (locking the controller
+ * once it is empty). eeprom_claim() waits for it; queued words follow it.
+ */
+void eeprom_release_at_eop(void);
+
+/**
+ * @brief Whether the operation handed to eeprom_release_at_eop() still runs
+ * 
+ * @param failed Set to whether it ended with an error flag (may be NULL)
+ * @return true while it runs
+ */
+bool eeprom_background_busy(bool *failed);
+
+/**
+ * @brief Read the write queue counters
+ * 
+ * @param stats Filled with the current counters
+ */
+void eeprom_get_stats(eeprom_stats_t *stats);
+
+/**
+ * @brief Flash interface interrupt work (call from FLASH_IRQHandler)
+ */
+void eeprom_irq_handler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EEPROM_H */
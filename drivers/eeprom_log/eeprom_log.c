@@ -0,0 +1,191 @@
+/**
+ * @file eeprom_log.c
+ * @brief Append-only record ring in the data EEPROM implementation
+ * 
+ * The queue is single producer (eeprom_log_append()), single consumer
+ * (eeprom_log_poll()): free-running indices, each written by one side
+ * only, after the entry it covers.
+ */
+
+#include "eeprom_log.h"
+
+#if BOARD_EEPROM_LOG_ENABLE
+
+#include <stddef.h>
+#include "eeprom.h"
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define EEPROM_LOG_SLOT_WORDS  (2U + EEPROM_LOG_DATA_WORDS)
+#define EEPROM_LOG_SLOT_BYTES  (EEPROM_LOG_SLOT_WORDS * 4U)
+#define EEPROM_LOG_SLOTS       ((EEPROM_SIZE_BYTES - BOARD_EEPROM_LOG_OFFSET) / EEPROM_LOG_SLOT_BYTES)
+
+#if (BOARD_EEPROM_LOG_OFFSET & 0x3U) != 0U || BOARD_EEPROM_LOG_OFFSET >= EEPROM_SIZE_BYTES
+#error "BOARD_EEPROM_LOG_OFFSET must be word aligned and inside the data EEPROM"
+#endif
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static eeprom_log_record_t queue[BOARD_EEPROM_LOG_QUEUE_DEPTH];
+static volatile uint32_t queue_head = 0;  /* Appended (producer) */
+static volatile uint32_t queue_tail = 0;  /* Written or dropped (consumer) */
+
+static volatile uint32_t newest_seq = 0;
+static volatile uint32_t dropped = 0;  /* Queue full (producer) */
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static uint32_t eeprom_log_slot_offset(uint32_t seq)
+{
+    return BOARD_EEPROM_LOG_OFFSET + ((seq - 1U) % EEPROM_LOG_SLOTS) * EEPROM_LOG_SLOT_BYTES;
+}
+
+/**
+ * @brief Seq word of a slot (0 if unreadable)
+ */
+static uint32_t eeprom_log_slot_seq(uint32_t slot)
+{
+    uint32_t seq = 0;
+    
+    (void)eeprom_read_words(BOARD_EEPROM_LOG_OFFSET + slot * EEPROM_LOG_SLOT_BYTES, &seq, 1U);
+    return seq;
+}
+
+/**
+ * @brief Slot check: a mix of every other word, so a slot holding words of
+ *        two records does not pass
+ */
+static uint16_t eeprom_log_check(uint32_t seq, uint16_t type, const uint32_t *data)
+{
+    uint32_t x = (seq ^ 0x474F4C45UL) * 0x9E3779B1UL;  /* "ELOG" */
+    
+    x = (x ^ type) * 0x9E3779B1UL;
+    for (uint32_t i = 0; i < EEPROM_LOG_DATA_WORDS; i++) {
+        x = (x ^ data[i]) * 0x9E3779B1UL;
+    }
+    return (uint16_t)((x >> 16) ^ x);
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+bool eeprom_log_init(void)
+{
+    uint32_t first = eeprom_log_slot_seq(0U);
+    uint32_t lo = 0;
+    uint32_t hi = EEPROM_LOG_SLOTS;
+    
+    queue_head = 0;
+    queue_tail = 0;
+    dropped = 0;
+    
+    /* Empty, or slot 0 holds something that is not a record of this ring
+     * (another layout): start again at seq 1 */
+    if (first == 0U || (first - 1U) % EEPROM_LOG_SLOTS != 0U) {
+        newest_seq = 0;
+        return true;
+    }
+    
+    /* Largest slot still counting up from slot 0 holds the newest */
+    while (hi - lo > 1U) {
+        uint32_t mid = lo + (hi - lo) / 2U;
+        
+        if (eeprom_log_slot_seq(mid) == first + mid) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    newest_seq = first + lo;
+    return true;
+}
+
+bool eeprom_log_append(uint16_t type, uint32_t a, uint32_t b, uint32_t c)
+{
+    uint32_t head = queue_head;
+    eeprom_log_record_t *entry;
+    
+    if (head - queue_tail >= BOARD_EEPROM_LOG_QUEUE_DEPTH) {
+        dropped++;
+        return false;
+    }
+    
+    entry = &queue[head % BOARD_EEPROM_LOG_QUEUE_DEPTH];
+    entry->type = type;
+    entry->data[0] = a;
+    entry->data[1] = b;
+    entry->data[2] = c;
+    queue_head = head + 1U;
+    return true;
+}
+
+void eeprom_log_poll(void)
+{
+    uint32_t words[EEPROM_LOG_SLOT_WORDS];
+    
+    /* The room check keeps a record from being cut in two */
+    while (queue_tail != queue_head && eeprom_write_room() >= EEPROM_LOG_SLOT_WORDS) {
+        const eeprom_log_record_t *entry = &queue[queue_tail % BOARD_EEPROM_LOG_QUEUE_DEPTH];
+        uint32_t seq = newest_seq + 1U;
+        uint32_t offset = eeprom_log_slot_offset(seq);
+        
+        words[0] = seq;
+        words[1] = (uint32_t)entry->type |
+                   ((uint32_t)eeprom_log_check(seq, entry->type, entry->data) << 16);
+        for (uint32_t i = 0; i < EEPROM_LOG_DATA_WORDS; i++) {
+            words[2U + i] = entry->data[i];
+        }
+        
+        /* Back to front: the seq word last commits the record */
+        for (uint32_t i = EEPROM_LOG_SLOT_WORDS; i > 0U; i--) {
+            (void)eeprom_write_async(offset + (i - 1U) * 4U, &words[i - 1U], 1U);
+        }
+        newest_seq = seq;
+        queue_tail++;
+    }
+}
+
+bool eeprom_log_read(uint32_t seq, eeprom_log_record_t *record)
+{
+    uint32_t words[EEPROM_LOG_SLOT_WORDS];
+    uint32_t newest = newest_seq;
+    
+    if (record == NULL || seq == 0U || seq > newest || newest - seq >= EEPROM_LOG_SLOTS) {
+        return false;
+    }
+    if (!eeprom_read_words(eeprom_log_slot_offset(seq), words, EEPROM_LOG_SLOT_WORDS)) {
+        return false;
+    }
+    
+    /* Being rewritten for a later lap, or a write cut off */
+    if (words[0] != seq ||
+        (uint16_t)(words[1] >> 16) != eeprom_log_check(seq, (uint16_t)words[1], &words[2])) {
+        return false;
+    }
+    
+    record->seq = seq;
+    record->type = (uint16_t)words[1];
+    for (uint32_t i = 0; i < EEPROM_LOG_DATA_WORDS; i++) {
+        record->data[i] = words[2U + i];
+    }
+    return true;
+}
+
+uint32_t eeprom_log_get_newest(void)
+{
+    return newest_seq;
+}
+
+uint32_t eeprom_log_get_dropped(void)
+{
+    return dropped;
+}
+
+#endif /* BOARD_EEPROM_LOG_ENABLE */
@@ -0,0 +1,113 @@
+#ifndef EEPROM_LOG_H
+#define EEPROM_LOG_H
+
+/**
+ * @file eeprom_log.h
+ * @brief Append-only record ring in the data EEPROM
+ * 
+ * Small records (a type and three words) kept across power cycles in the
+ * data EEPROM from BOARD_EEPROM_LOG_OFFSET to its end. Every record has a
+ * sequence number, and record seq always lives in slot (seq - 1) % slots:
+ * the ring is written strictly in order, each slot once per lap, so wear
+ * is spread evenly over the region.
+ * 
+ * Slot (5 words, little-endian):
+ *   0   seq      uint32, 1.. (0 = never written: erased EEPROM reads 0)
+ *   4   type     uint16, caller-defined
+ *   6   check    uint16, over seq, type and data
+ *   8   data     uint32 x3
+ * The slot is written back to front, seq last: a write cut off by a power
+ * loss leaves the slot's old seq with a check that no longer matches, so
+ * the record is lost but the ring stays in order. At init the newest
+ * record is found by binary search over the seq words (slots 0..n of the
+ * current lap count up from slot 0, the rest hold the previous lap or 0).
+ * 
+ * Appends are queued in RAM; eeprom_log_poll() hands whole records to the
+ * EEPROM write queue (eeprom.h) while it has room, one word per queue
+ * call so that the seq word stays last, and the words are written from
+ * the flash interrupt. One context appends, one polls (they may differ).
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+#define EEPROM_LOG_DATA_WORDS  3U
+
+/**
+ * @brief One record
+ */
+typedef struct {
+    uint32_t seq;
+    uint16_t type;
+    uint32_t data[EEPROM_LOG_DATA_WORDS];
+} eeprom_log_record_t;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Find the newest record (binary search, no writes)
+ * 
+ * @return true if initialization successful, false otherwise
+ */
+bool eeprom_log_init(void);
+
+/**
+ * @brief Queue a record for writing
+ * 
+ * @param type Record type
+ * @param a    Data word 0
+ * @param b    Data word 1
+ * @param c    Data word 2
+ * @return true if queued, false if the queue is full (record dropped)
+ */
+bool eeprom_log_append(uint16_t type, uint32_t a, uint32_t b, uint32_t c);
+
+/**
+ * @brief Pass queued records to the EEPROM write queue (returns at once)
+ * 
+ * Not from interrupt context.
+ */
+void eeprom_log_poll(void);
+
+/**
+ * @brief Read a record by sequence number
+ * 
+ * @param seq    Sequence number (1..eeprom_log_get_newest())
+ * @param record Filled with the record
+ * @return true if found, false if not written yet, overwritten by a
+ *         later lap or damaged
+ */
+bool eeprom_log_read(uint32_t seq, eeprom_log_record_t *record);
+
+/**
+ * @brief Sequence number of the newest record written (or queued for it)
+ * 
+ * @return Sequence number, 0 if the ring is empty
+ */
+uint32_t eeprom_log_get_newest(void);
+
+/**
+ * @brief Records dropped on a full queue (since boot)
+ * 
+ * A failed word write shows in eeprom_get_stats() instead.
+ * 
+ * @return Number of records lost
+ */
+uint32_t eeprom_log_get_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EEPROM_LOG_H */
@@ -0,0 +1,160 @@
+/**
+ * @file fault.c
+ * @brief HardFault and fatal error capture implementation
+ *
+ * The capture runs with the rest of the firmware in an unknown state: it
+ * only reads memory (the exception frame after a range check, the sampler
+ * state, the trace ring), writes the .noinit record and resets. A magic
+ * word and a check word over the record tell a kept record from the RAM
+ * contents after power-up.
+ */
+
+#include "fault.h"
+
+#if BOARD_FAULT_CAPTURE_ENABLE
+
+#include <string.h>
+#include "stm32l0xx_hal.h"
+#include "sensor_sampling.h"
+#include "timebase.h"
+#include "trace.h"
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define FAULT_MAGIC  0xFA017ED5UL
+
+#if FAULT_TRACE_RECORDS > 8U
+#error "BOARD_FAULT_TRACE_RECORDS must be 0 .. 8"
+#endif
+
+/**
+ * @brief Record as kept across the reset
+ */
+typedef struct {
+    uint32_t magic;
+    fault_record_t record;
+    uint32_t check;
+} fault_noinit_t;
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+/* Neither copied nor zeroed by Reset_Handler (linker.ld) */
+static fault_noinit_t fault_kept NOINIT;
+
+/* Last boot's record, for the whole run */
+static fault_record_t fault_last;
+
+extern uint32_t _estack[];
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Check word of the kept record
+ */
+static uint32_t fault_check(const fault_noinit_t *kept)
+{
+    const uint32_t *word = (const uint32_t *)&kept->record;
+    uint32_t check = kept->magic;
+
+    for (uint32_t i = 0; i < sizeof(kept->record) / sizeof(uint32_t); i++) {
+        check = ((check << 5) | (check >> 27)) ^ word[i];
+    }
+    return ~check;
+}
+
+/**
+ * @brief Fill the fields common to both kinds, seal the record and reset
+ */
+static void __attribute__((noreturn)) fault_seal(uint8_t kind)
+{
+    fault_record_t *record = &fault_kept.record;
+
+    record->version = FAULT_VERSION;
+    record->kind = kind;
+    record->sensor_state = sensor_sampling_get_state();
+    record->time_us = timebase_now_us();
+#if FAULT_TRACE_RECORDS != 0U
+    record->trace_count = (uint8_t)trace_copy_last(record->trace, FAULT_TRACE_RECORDS);
+#else
+    record->trace_count = 0;
+#endif
+    fault_kept.magic = FAULT_MAGIC;
+    fault_kept.check = fault_check(&fault_kept);
+
+    NVIC_SystemReset();
+    while (1) {
+    }
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+void fault_init(void)
+{
+    if (fault_kept.magic == FAULT_MAGIC && fault_kept.check == fault_check(&fault_kept) &&
+        fault_kept.record.version == FAULT_VERSION) {
+        fault_last = fault_kept.record;
+    } else {
+        memset(&fault_last, 0, sizeof(fault_last));
+        fault_last.version = FAULT_VERSION;
+    }
+    fault_kept.magic = 0;  /* Reported once */
+}
+
+const fault_record_t *fault_get_last(void)
+{
+    return &fault_last;
+}
+
+const uint8_t *fault_take_frame(uint16_t *len)
+{
+    *len = (uint16_t)sizeof(fault_last);
+    return (const uint8_t *)&fault_last;
+}
+
+void fault_capture(const uint32_t *frame, uint32_t exc_return)
+{
+    fault_record_t *record = &fault_kept.record;
+
+    __disable_irq();
+
+    /* A fault from a stack overflow leaves the frame outside RAM: keep the
+     * pointer only */
+    if ((uint32_t)frame >= SRAM_BASE &&
+        (uint32_t)frame <= (uint32_t)_estack - sizeof(record->regs) &&
+        ((uint32_t)frame & 3U) == 0U) {
+        for (uint32_t i = 0; i < FAULT_REGS; i++) {
+            record->regs[i] = frame[i];
+        }
+    } else {
+        for (uint32_t i = 0; i < FAULT_REGS; i++) {
+            record->regs[i] = 0;
+        }
+    }
+    record->code = exc_return;
+    record->where = (uint32_t)frame;
+    fault_seal(FAULT_KIND_HARDFAULT);
+}
+
+void fault_capture_error(uint32_t error_code, uint32_t caller)
+{
+    fault_record_t *record = &fault_kept.record;
+
+    __disable_irq();
+
+    for (uint32_t i = 0; i < FAULT_REGS; i++) {
+        record->regs[i] = 0;
+    }
+    record->code = error_code;
+    record->where = caller;
+    fault_seal(FAULT_KIND_ERROR);
+}
+
+#endif /* BOARD_FAULT_CAPTURE_ENABLE */
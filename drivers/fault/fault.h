@@ -0,0 +1,129 @@
+#ifndef FAULT_H
+#define FAULT_H
+
+/**
+ * @file fault.h
+ * @brief HardFault and fatal error capture across a warm reset
+ *
+ * A HardFault (or main_error_handler()) fills one record in .noinit RAM,
+ * which the startup code neither copies nor zeroes, and resets at once:
+ * the device is sampling again after a normal warm boot, and the record
+ * is still there for that boot to report. fault_init() takes it over and
+ * invalidates it, so each record is reported once; a power cycle loses it
+ * (the check word fails).
+ *
+ * Record, little-endian (the frame of fault_get_last()):
+ *   0  uint8   version (FAULT_VERSION)
+ *   1  uint8   kind (FAULT_KIND_*), 0 no fault before this boot
+ *   2  uint8   sampler state at the fault (sensor_sampling.c)
+ *   3  uint8   trace records saved
+ *   4  uint32  r0, r1, r2, r3, r12, lr, pc, xpsr as stacked (HARDFAULT;
+ *              0 when the stack pointer was outside RAM)
+ *   36 uint32  EXC_RETURN (HARDFAULT), error code (ERROR)
+ *   40 uint32  stack pointer at the fault (HARDFAULT), caller (ERROR)
+ *   44 uint32  timebase_now_us() at the fault
+ *   48 16 x    the newest FAULT_TRACE_RECORDS trace records, oldest first,
+ *              in wire order (trace.h), BOARD_TRACE_ENABLE builds
+ * The pc and lr go into the EEPROM log as well (APP_ELOG_FAULT).
+ *
+ * Built only with BOARD_FAULT_CAPTURE_ENABLE: otherwise HardFault_Handler
+ * stays the startup file's loop.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+#define FAULT_VERSION        1U
+#define FAULT_KIND_NONE      0U
+#define FAULT_KIND_HARDFAULT 1U
+#define FAULT_KIND_ERROR     2U  /* main_error_handler() */
+
+#define FAULT_REGS           8U  /* Exception frame words */
+#define FAULT_REG_LR         5U
+#define FAULT_REG_PC         6U
+#define FAULT_REG_XPSR       7U
+
+#if BOARD_TRACE_ENABLE
+#define FAULT_TRACE_RECORDS  BOARD_FAULT_TRACE_RECORDS
+#else
+#define FAULT_TRACE_RECORDS  0U
+#endif
+
+/* ============================================================================
+ * TYPES
+ * ============================================================================ */
+
+/**
+ * @brief Fault record (layout above)
+ */
+typedef struct {
+    uint8_t version;
+    uint8_t kind;
+    uint8_t sensor_state;
+    uint8_t trace_count;
+    uint32_t regs[FAULT_REGS];  /* Stacked: r0, r1, r2, r3, r12, lr, pc, xpsr */
+    uint32_t code;     /* EXC_RETURN, or the error code */
+    uint32_t where;    /* Stack pointer, or the caller */
+    uint32_t time_us;
+#if FAULT_TRACE_RECORDS != 0U
+    uint8_t trace[FAULT_TRACE_RECORDS * 16U];
+#endif
+} fault_record_t;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Take over the record of the previous boot, if any
+ *
+ * Call once, early in main(); nothing is cleared before.
+ */
+void fault_init(void);
+
+/**
+ * @brief Record left by the previous boot
+ *
+ * @return The record (kind FAULT_KIND_NONE if the previous boot ended
+ *         without a fault), valid for the whole run
+ */
+const fault_record_t *fault_get_last(void);
+
+/**
+ * @brief Record as a stream frame (i2c_slave_set_stream())
+ *
+ * @param len Receives the record length in bytes
+ * @return Record bytes
+ */
+const uint8_t *fault_take_frame(uint16_t *len);
+
+/**
+ * @brief Capture a HardFault and reset (HardFault_Handler)
+ *
+ * @param frame Exception frame on the stack in use at the fault
+ * @param exc_return LR at handler entry
+ */
+void fault_capture(const uint32_t *frame, uint32_t exc_return) __attribute__((noreturn));
+
+/**
+ * @brief Capture a fatal error and reset (main_error_handler())
+ *
+ * @param error_code Code passed to main_error_handler()
+ * @param caller Return address into the caller
+ */
+void fault_capture_error(uint32_t error_code, uint32_t caller) __attribute__((noreturn));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FAULT_H */
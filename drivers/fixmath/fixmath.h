@@ -0,0 +1,175 @@
+#ifndef FIXMATH_H
+#define FIXMATH_H
+
+/**
+ * @file fixmath.h
+ * @brief 64-bit products and shifts without the runtime library calls
+ *
+ * Cortex-M0+ has MULS (32x32 -> low 32, one cycle on the STM32L0) and no
+ * long multiply, so GCC turns a widening (int64_t)a * b into a call to
+ * __aeabi_lmul, a full 64x64 product, and a shift of an int64_t by a
+ * count not known at compile time into __aeabi_lasr. Here the product is
+ * four MULS of 16-bit halves and the shift two or three 32-bit shifts,
+ * inline, with no word of the 64x64 case computed only to be thrown away.
+ * Results are exactly those of the C expression each function names; a
+ * product is taken mod 2^64 like the C one, which the callers keep from
+ * overflowing anyway.
+ *
+ * Other cores (and host builds) have a long multiply: the plain C
+ * expression is used there.
+ *
+ * Any context, no state.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+#if defined(__ARM_ARCH_6M__)
+/**
+ * @brief Add x << 16 to the 64-bit value hi:lo (x signed for a signed product)
+ */
+static inline void fixmath_add_shl16(uint32_t *lo, uint32_t *hi, uint32_t x, uint32_t x_hi)
+{
+    uint32_t t = x << 16;
+
+    *lo += t;
+    *hi += x_hi + (*lo < t);
+}
+#endif
+
+/**
+ * @brief (uint64_t)a * b
+ */
+static inline uint64_t fixmath_umull(uint32_t a, uint32_t b)
+{
+#if defined(__ARM_ARCH_6M__)
+    uint32_t al = a & 0xFFFFU;
+    uint32_t ah = a >> 16;
+    uint32_t bl = b & 0xFFFFU;
+    uint32_t bh = b >> 16;
+    uint32_t mid1 = al * bh;
+    uint32_t mid2 = ah * bl;
+    uint32_t lo = al * bl;
+    uint32_t hi = ah * bh;
+
+    fixmath_add_shl16(&lo, &hi, mid1, mid1 >> 16);
+    fixmath_add_shl16(&lo, &hi, mid2, mid2 >> 16);
+    return ((uint64_t)hi << 32) | lo;
+#else
+    return (uint64_t)a * b;
+#endif
+}
+
+/**
+ * @brief (int64_t)a * b
+ *
+ * Signed high halves, unsigned low ones: every partial product fits in an
+ * int32_t, so no sign correction is left for the end.
+ */
+static inline int64_t fixmath_smull(int32_t a, int32_t b)
+{
+#if defined(__ARM_ARCH_6M__)
+    uint32_t al = (uint32_t)a & 0xFFFFU;
+    int32_t ah = a >> 16;
+    uint32_t bl = (uint32_t)b & 0xFFFFU;
+    int32_t bh = b >> 16;
+    int32_t mid1 = (int32_t)al * bh;
+    int32_t mid2 = ah * (int32_t)bl;
+    uint32_t lo = al * bl;
+    uint32_t hi = (uint32_t)(ah * bh);
+
+    fixmath_add_shl16(&lo, &hi, (uint32_t)mid1, (uint32_t)(mid1 >> 16));
+    fixmath_add_shl16(&lo, &hi, (uint32_t)mid2, (uint32_t)(mid2 >> 16));
+    return (int64_t)(((uint64_t)hi << 32) | lo);
+#else
+    return (int64_t)a * b;
+#endif
+}
+
+/**
+ * @brief acc + (int64_t)a * b
+ */
+static inline int64_t fixmath_smlal(int64_t acc, int32_t a, int32_t b)
+{
+    return acc + fixmath_smull(a, b);
+}
+
+/**
+ * @brief acc - (int64_t)a * b
+ */
+static inline int64_t fixmath_smlsl(int64_t acc, int32_t a, int32_t b)
+{
+    return acc - fixmath_smull(a, b);
+}
+
+/**
+ * @brief a * b, low 64 bits (one long and one short multiply)
+ */
+static inline uint64_t fixmath_mul_u64_u32(uint64_t a, uint32_t b)
+{
+#if defined(__ARM_ARCH_6M__)
+    return fixmath_umull((uint32_t)a, b) + ((uint64_t)((uint32_t)(a >> 32) * b) << 32);
+#else
+    return a * b;
+#endif
+}
+
+/**
+ * @brief a * b, low 64 bits, for a signed a (same bits as the unsigned product)
+ */
+static inline int64_t fixmath_mul_s64_u32(int64_t a, uint32_t b)
+{
+    return (int64_t)fixmath_mul_u64_u32((uint64_t)a, b);
+}
+
+/**
+ * @brief x >> n: arithmetic, rounding towards minus infinity
+ *
+ * @param n 0..63
+ */
+static inline int64_t fixmath_asr64(int64_t x, uint32_t n)
+{
+#if defined(__ARM_ARCH_6M__)
+    uint32_t lo = (uint32_t)x;
+    int32_t hi = (int32_t)(x >> 32);  /* A move: no shift is emitted */
+
+    if (n >= 32U) {
+        lo = (uint32_t)(hi >> (n - 32U));
+        hi >>= 31;
+    } else if (n != 0U) {
+        lo = (lo >> n) | ((uint32_t)hi << (32U - n));
+        hi >>= n;
+    }
+    return (int64_t)(((uint64_t)(uint32_t)hi << 32) | lo);
+#else
+    return x >> n;
+#endif
+}
+
+/**
+ * @brief x / 2^n: rounding towards zero like C '/'
+ *
+ * Negative values are biased by 2^n - 1 before the arithmetic shift.
+ *
+ * @param n 0..62
+ */
+static inline int64_t fixmath_div_pow2(int64_t x, uint32_t n)
+{
+    uint64_t bias = (n >= 32U) ? (((uint64_t)((1UL << (n - 32U)) - 1U) << 32) | 0xFFFFFFFFUL)
+                               : (uint64_t)((1UL << n) - 1U);
+
+    return fixmath_asr64((int64_t)((uint64_t)x + (bias & (uint64_t)(x >> 63))), n);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FIXMATH_H */
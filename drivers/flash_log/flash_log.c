@@ -0,0 +1,747 @@
+/**
+ * @file flash_log.c
+ * @brief Burst sample capture into program flash implementation
+ * 
+ * Buffers: samples fill halves[fill]; a full half page is queued and fill
+ * moves on. flash_log_poll() takes one step: program the oldest queued
+ * half page once its page is erased, else erase the next page. While a
+ * capture runs, pages are erased up to BOARD_FLASH_LOG_ERASE_AHEAD ahead
+ * of the one being filled, so a burst finds them ready. With the
+ * brown-out save built, one page is kept erased ahead while idle too.
+ * 
+ * An erase runs in the background: the step that starts it returns at
+ * once, and the steps after it only check the controller until it is done
+ * (program and the next erase wait for it). Its end of operation interrupt
+ * clears the operation and lets the EEPROM queue run again
+ * (eeprom_release_at_eop()), so a blocking EEPROM write never waits on the
+ * main loop. The region is in bank 2 and the firmware, vectors and
+ * .ramfunc in bank 1 and SRAM, so nothing but a read of the region waits
+ * on it.
+ * 
+ * The emergency flush runs from the PVD interrupt, above the main loop:
+ * it may find a flash operation started but not finished, and a buffer
+ * half filled. It waits for the flash and clears the operation bits
+ * first, and skips a half page that reads programmed already (interrupted
+ * after its program).
+ * 
+ * Replay (BOARD_FLASH_LOG_REPLAY) only reads the region: it finds the
+ * newest raw page, walks back to the first page of its capture and steps
+ * through the records in seq order.
+ */
+
+#include "flash_log.h"
+
+#if BOARD_FLASH_LOG_ENABLE
+
+#include <string.h>
+#include "stm32l0xx_hal.h"
+#include "board_init.h"  /* For board_delay_ms() */
+#include "eeprom.h"
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define FLASH_LOG_PAGE_BYTES    128U
+#define FLASH_LOG_HALF_WORDS    16U   /* One HAL_FLASHEx_HalfPageProgram() */
+#define FLASH_LOG_HEADER_WORDS  4U
+#define FLASH_LOG_SAMPLE_WORDS  4U
+#define FLASH_LOG_PAD           0xFFFFFFFFUL
+#define FLASH_LOG_PROM_WORDS    7U
+
+#if BOARD_PVD_SAVE_ENABLE
+#define FLASH_LOG_IDLE_AHEAD    1U    /* For the snapshot page */
+#if FLASH_LOG_HEADER_WORDS + FLASH_LOG_SNAPSHOT_WORDS != FLASH_LOG_HALF_WORDS
+#error "A snapshot fills the first half page"
+#endif
+#else
+#define FLASH_LOG_IDLE_AHEAD    0U
+#endif
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+/* Region (linker.ld) */
+extern uint32_t _sflash_log[];
+extern uint32_t _eflash_log[];
+
+static uint32_t halves[BOARD_FLASH_LOG_HALVES][FLASH_LOG_HALF_WORDS];
+static uint32_t half_seq[BOARD_FLASH_LOG_HALVES];   /* Page of each buffer */
+static bool half_second[BOARD_FLASH_LOG_HALVES];    /* Second half of that page */
+static uint32_t fill = 0;         /* Buffer being filled */
+static uint32_t fill_words = 0;   /* Words in it, 0 = not started */
+static uint32_t tail = 0;         /* Oldest queued buffer */
+static uint32_t queued = 0;
+static bool fill_second = false;  /* Next buffer is the second half of page started_seq */
+
+static uint32_t page_count = 0;
+static uint32_t started_seq = 0;  /* Newest page with a buffer filled for it */
+static uint32_t erased_seq = 0;   /* Pages up to this one are erased, not yet programmed */
+static bool erasing = false;      /* Erase of page erased_seq still running */
+
+static flash_log_stats_t stats;
+static uint16_t raw_prom[FLASH_LOG_PROM_WORDS];  /* Of the raw trace running */
+#if BOARD_PVD_SAVE_ENABLE
+static uint32_t emergency_lost = 0;  /* Half pages dropped by the flush */
+#endif
+
+#if BOARD_FLASH_LOG_REPLAY
+/* Replay position: record replay_slot of page replay_seq, 0 = none */
+static uint32_t replay_first = 0;    /* First page of the trace, 0 = no trace */
+static uint32_t replay_capture = 0;
+static uint32_t replay_seq = 0;
+static uint32_t replay_slot = 0;     /* 1..FLASH_LOG_PAGE_RECORDS */
+static uint8_t replay_cmd = 0;       /* Last command */
+static bool replay_d2 = false;       /* Last conversion was D2 */
+#endif
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static uint32_t flash_log_region_pages(void)
+{
+    return ((uint32_t)_eflash_log - (uint32_t)_sflash_log) / FLASH_LOG_PAGE_BYTES;
+}
+
+static uint32_t flash_log_page_addr(uint32_t seq)
+{
+    return (uint32_t)_sflash_log + ((seq - 1U) % page_count) * FLASH_LOG_PAGE_BYTES;
+}
+
+/**
+ * @brief Page seq of a slot (0 if erased or not a page of this log)
+ */
+static uint32_t flash_log_slot_seq(uint32_t slot)
+{
+    const volatile uint32_t *page = (const volatile uint32_t *)
+        ((uint32_t)_sflash_log + slot * FLASH_LOG_PAGE_BYTES);
+    
+    return (page[0] == FLASH_LOG_MAGIC || page[0] == FLASH_LOG_MAGIC_RAW ||
+            page[0] == FLASH_LOG_MAGIC_SNAP) ? page[1] : 0U;
+}
+
+/**
+ * @brief Queue the buffer being filled (padded), move to the next
+ */
+static void flash_log_queue_fill(void)
+{
+    for (uint32_t i = fill_words; i < FLASH_LOG_HALF_WORDS; i++) {
+        halves[fill][i] = FLASH_LOG_PAD;
+    }
+    queued++;
+    fill = (fill + 1U) % BOARD_FLASH_LOG_HALVES;
+    fill_words = 0;
+    fill_second = !fill_second;
+}
+
+/**
+ * @brief Next free slot of the buffer being filled, starting the page
+ *        (header, and the PROM slot of a raw page) when due
+ * 
+ * @return FLASH_LOG_SAMPLE_WORDS words to fill, NULL if every buffer is
+ *         queued (the sample is dropped)
+ */
+static uint32_t *flash_log_slot(void)
+{
+    uint32_t *half = halves[fill];
+    
+    if (queued == BOARD_FLASH_LOG_HALVES) {
+        stats.dropped++;
+        return NULL;
+    }
+    
+    if (fill_words == 0U) {
+        if (!fill_second) {
+            half[0] = stats.raw ? FLASH_LOG_MAGIC_RAW : FLASH_LOG_MAGIC;
+            half[1] = ++started_seq;
+            half[2] = stats.capture;
+            half[3] = stats.dropped;
+            fill_words = FLASH_LOG_HEADER_WORDS;
+            if (stats.raw) {
+                for (uint32_t i = 0; i < FLASH_LOG_SAMPLE_WORDS; i++) {
+                    uint32_t hi = (2U * i + 1U < FLASH_LOG_PROM_WORDS) ? raw_prom[2U * i + 1U]
+                                                                       : 0xFFFFU;
+                    half[fill_words + i] = raw_prom[2U * i] | (hi << 16);
+                }
+                fill_words += FLASH_LOG_SAMPLE_WORDS;
+            }
+            stats.pages++;
+        }
+        half_seq[fill] = started_seq;
+        half_second[fill] = fill_second;
+    }
+    
+    return &half[fill_words];
+}
+
+/**
+ * @brief The slot from flash_log_slot() is filled
+ */
+static void flash_log_slot_done(void)
+{
+    fill_words += FLASH_LOG_SAMPLE_WORDS;
+    stats.samples++;
+    
+    if (fill_words == FLASH_LOG_HALF_WORDS) {
+        flash_log_queue_fill();
+    }
+}
+
+static bool flash_log_program(uint32_t addr, uint32_t *words)
+{
+    bool ok;
+    
+    eeprom_claim();
+    if (HAL_FLASH_Unlock() != HAL_OK) {
+        eeprom_release();
+        return false;
+    }
+    ok = HAL_FLASHEx_HalfPageProgram(addr, words) == HAL_OK;
+    HAL_FLASH_Lock();
+    eeprom_release();
+    return ok;
+}
+
+/**
+ * @brief Start a page erase and return (the flash interrupt ends it)
+ */
+static bool flash_log_erase_start(uint32_t addr)
+{
+    eeprom_claim();
+    if (HAL_FLASH_Unlock() != HAL_OK) {
+        eeprom_release();
+        return false;
+    }
+    
+    /* HAL_FLASHEx_Erase() without its wait: ERASE + PROG, then a word write */
+    SET_BIT(FLASH->PECR, FLASH_PECR_ERASE | FLASH_PECR_PROG);
+    *(volatile uint32_t *)addr = 0U;
+    erasing = true;
+    eeprom_release_at_eop();
+    return true;
+}
+
+/**
+ * @brief Account for a background erase that has ended
+ * 
+ * @return false while it still runs
+ */
+static bool flash_log_erase_done(void)
+{
+    bool failed;
+    
+    if (!erasing) {
+        return true;
+    }
+    if (eeprom_background_busy(&failed)) {
+        return false;
+    }
+    
+    erasing = false;
+    if (failed) {
+        stats.errors++;  /* Its programs fail in turn */
+    }
+    return true;
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+bool flash_log_init(void)
+{
+    uint32_t first = 0;
+    uint32_t lo = 0;
+    uint32_t hi;
+    
+    page_count = flash_log_region_pages();
+    if (page_count <= BOARD_FLASH_LOG_ERASE_AHEAD) {
+        return false;
+    }
+    
+    memset(&stats, 0, sizeof(stats));
+    fill = 0;
+    fill_words = 0;
+    tail = 0;
+    queued = 0;
+    hi = page_count;
+    
+    /* Slots at the start may be erased ahead of a wrapped ring: the ring
+     * counts up from the first written one */
+    while (lo <= BOARD_FLASH_LOG_ERASE_AHEAD && (first = flash_log_slot_seq(lo)) == 0U) {
+        lo++;
+    }
+    if (first != 0U && first > lo && (first - 1U) % page_count == lo) {
+        first -= lo;
+        while (hi - lo > 1U) {
+            uint32_t mid = lo + (hi - lo) / 2U;
+            
+            if (flash_log_slot_seq(mid) == first + mid) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        stats.newest_page = first + lo;
+        stats.capture = ((const volatile uint32_t *)flash_log_page_addr(stats.newest_page))[2];
+    }
+    /* else empty, or not a region of this log: start again at seq 1 */
+    
+    started_seq = stats.newest_page;
+    erased_seq = stats.newest_page;  /* Nothing ahead known to be erased */
+    return true;
+}
+
+bool flash_log_start(void)
+{
+    /* A replay reads the region: no erase may run ahead over the trace */
+    if (stats.running || BOARD_FLASH_LOG_REPLAY) {
+        return false;
+    }
+    
+    stats.raw = false;
+    stats.capture++;
+    stats.pages = 0;
+    stats.samples = 0;
+    stats.dropped = 0;
+    fill_second = false;  /* A capture starts on a page of its own */
+    stats.running = true;
+    return true;
+}
+
+bool flash_log_start_raw(const uint16_t *prom)
+{
+    if (prom == NULL || !flash_log_start()) {
+        return false;
+    }
+    
+    for (uint32_t i = 0; i < FLASH_LOG_PROM_WORDS; i++) {
+        raw_prom[i] = prom[i];
+    }
+    stats.raw = true;
+    return true;
+}
+
+bool flash_log_stop(void)
+{
+    uint32_t errors;
+    
+    if (!stats.running) {
+        return false;
+    }
+    
+    stats.running = false;
+    if (fill_words != 0U) {
+        flash_log_queue_fill();
+    }
+    
+    /* Every step programs, erases or waits for an erase: bounded by the buffers */
+    errors = stats.errors;
+    while (queued != 0U) {
+        flash_log_poll();
+    }
+    return stats.errors == errors;
+}
+
+void flash_log_push(const sensor_data_t *sample)
+{
+    uint32_t *slot;
+    
+    if (!stats.running || stats.raw || (slot = flash_log_slot()) == NULL) {
+        return;
+    }
+    
+    memcpy(slot, sample, SENSOR_RECORD_BYTES);  /* The record, as the sampler wrote it */
+    flash_log_slot_done();
+}
+
+void flash_log_push_raw(const sensor_raw_record_t *record)
+{
+    uint32_t *slot;
+    
+    if (!stats.running || !stats.raw || (slot = flash_log_slot()) == NULL) {
+        return;
+    }
+    
+    slot[0] = record->timestamp_us;
+    slot[1] = record->sequence;
+    slot[2] = record->pressure_adc;
+    slot[3] = record->temperature_adc;
+    flash_log_slot_done();
+}
+
+void flash_log_poll(void)
+{
+    if (!flash_log_erase_done()) {
+        return;
+    }
+    
+    if (queued != 0U && half_seq[tail] <= erased_seq) {
+        uint32_t addr = flash_log_page_addr(half_seq[tail]) +
+                        (half_second[tail] ? FLASH_LOG_PAGE_BYTES / 2U : 0U);
+        
+        if (flash_log_program(addr, halves[tail])) {
+            stats.newest_page = half_seq[tail];
+        } else {
+            stats.errors++;  /* Half page lost */
+        }
+        tail = (tail + 1U) % BOARD_FLASH_LOG_HALVES;
+        queued--;
+        return;
+    }
+    
+    /* Page the oldest buffer waits for, or the next one ahead */
+    if ((queued != 0U) ||
+        (stats.running && erased_seq < started_seq + BOARD_FLASH_LOG_ERASE_AHEAD) ||
+        (erased_seq < started_seq + FLASH_LOG_IDLE_AHEAD)) {
+        erased_seq++;
+        if (!flash_log_erase_start(flash_log_page_addr(erased_seq))) {
+            stats.errors++;  /* Its programs fail in turn */
+        }
+    }
+}
+
+void flash_log_get_stats(flash_log_stats_t *stats_out)
+{
+    *stats_out = stats;
+}
+
+uint32_t flash_log_image_bytes(void)
+{
+    uint32_t newest = stats.newest_page;
+    
+    return ((newest < page_count) ? newest : page_count) * FLASH_LOG_PAGE_BYTES;
+}
+
+void flash_log_read_image(uint32_t offset, uint8_t *buf, uint32_t len)
+{
+    uint32_t newest = stats.newest_page;
+    uint32_t pages = (newest < page_count) ? newest : page_count;
+    
+    while (len != 0U) {
+        uint32_t index = offset / FLASH_LOG_PAGE_BYTES;
+        uint32_t in_page = offset % FLASH_LOG_PAGE_BYTES;
+        uint32_t chunk = FLASH_LOG_PAGE_BYTES - in_page;
+        
+        if (chunk > len) {
+            chunk = len;
+        }
+        if (index < pages) {
+            /* Image page index is page seq newest - pages + 1 + index */
+            memcpy(buf, (const uint8_t *)flash_log_page_addr(newest - pages + 1U + index) + in_page,
+                   chunk);
+        } else {
+            memset(buf, 0, chunk);
+        }
+        buf += chunk;
+        offset += chunk;
+        len -= chunk;
+    }
+}
+
+#if BOARD_PVD_SAVE_ENABLE
+
+/* ============================================================================
+ * BROWN-OUT SAVE
+ * ============================================================================ */
+
+/**
+ * @brief Whether a half page reads erased
+ */
+static bool flash_log_half_erased(uint32_t addr)
+{
+    const volatile uint32_t *words = (const volatile uint32_t *)addr;
+    
+    for (uint32_t i = 0; i < FLASH_LOG_HALF_WORDS; i++) {
+        if (words[i] != 0U) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Half-page program over whatever the main loop left running
+ */
+static bool flash_log_emergency_program(uint32_t addr, uint32_t *words)
+{
+    while ((FLASH->SR & FLASH_SR_BSY) != 0U) {
+    }
+    if (HAL_FLASH_Unlock() != HAL_OK) {
+        return false;
+    }
+    CLEAR_BIT(FLASH->PECR, FLASH_PECR_ERASE | FLASH_PECR_PROG | FLASH_PECR_FPRG);
+    return HAL_FLASHEx_HalfPageProgram(addr, words) == HAL_OK;
+}
+
+uint32_t flash_log_emergency_flush(uint32_t max_halves)
+{
+    uint32_t programs = 0;
+    
+    stats.running = false;
+    if (fill_words != 0U && queued < BOARD_FLASH_LOG_HALVES) {
+        flash_log_queue_fill();
+    }
+    
+    /* Oldest first, so the pages on flash stay consecutive */
+    while (queued != 0U && programs < max_halves && half_seq[tail] <= erased_seq) {
+        uint32_t addr = flash_log_page_addr(half_seq[tail]) +
+                        (half_second[tail] ? FLASH_LOG_PAGE_BYTES / 2U : 0U);
+        
+        /* One that reads programmed had its program finish before the edge */
+        if (flash_log_half_erased(addr)) {
+            if (!flash_log_emergency_program(addr, halves[tail])) {
+                break;
+            }
+            programs++;
+        }
+        stats.newest_page = half_seq[tail];
+        tail = (tail + 1U) % BOARD_FLASH_LOG_HALVES;
+        queued--;
+    }
+    
+    emergency_lost = queued;
+    queued = 0;
+    fill = tail;
+    fill_words = 0;
+    return emergency_lost;
+}
+
+bool flash_log_emergency_snapshot(const uint32_t *words)
+{
+    uint32_t half[FLASH_LOG_HALF_WORDS];
+    uint32_t seq = stats.newest_page + 1U;
+    uint32_t addr = flash_log_page_addr(seq);
+    
+    if (words == NULL || seq > erased_seq || !flash_log_half_erased(addr)) {
+        return false;
+    }
+    
+    half[0] = FLASH_LOG_MAGIC_SNAP;
+    half[1] = seq;
+    half[2] = stats.capture;
+    half[3] = emergency_lost;
+    for (uint32_t i = 0; i < FLASH_LOG_SNAPSHOT_WORDS; i++) {
+        half[FLASH_LOG_HEADER_WORDS + i] = words[i];
+    }
+    if (!flash_log_emergency_program(addr, half)) {
+        return false;
+    }
+    stats.newest_page = seq;
+    started_seq = seq;
+    return true;
+}
+
+#endif /* BOARD_PVD_SAVE_ENABLE */
+
+#if BOARD_FLASH_LOG_REPLAY
+
+/* ============================================================================
+ * REPLAY TRANSPORT
+ * ============================================================================ */
+
+/**
+ * @brief Page seq of the trace being replayed (NULL if not one of its pages)
+ */
+static const volatile uint32_t *flash_log_replay_page(uint32_t seq)
+{
+    const volatile uint32_t *page;
+    
+    if (seq == 0U) {
+        return NULL;
+    }
+    page = (const volatile uint32_t *)((uint32_t)_sflash_log +
+                                       ((seq - 1U) % flash_log_region_pages()) *
+                                       FLASH_LOG_PAGE_BYTES);
+    return (page[0] == FLASH_LOG_MAGIC_RAW && page[1] == seq && page[2] == replay_capture)
+           ? page : NULL;
+}
+
+/**
+ * @brief Record at the replay position (NULL before the first and past the last)
+ */
+static const volatile uint32_t *flash_log_replay_record(void)
+{
+    const volatile uint32_t *page = flash_log_replay_page(replay_seq);
+    
+    if (page == NULL || replay_slot == 0U) {
+        return NULL;
+    }
+    return page + (replay_slot + 1U) * FLASH_LOG_SAMPLE_WORDS;
+}
+
+/**
+ * @brief Find the newest raw trace and go back to before its first record
+ */
+static void flash_log_replay_rewind(void)
+{
+    uint32_t pages = flash_log_region_pages();
+    uint32_t newest = 0;
+    
+    for (uint32_t slot = 0; slot < pages; slot++) {
+        const volatile uint32_t *page = (const volatile uint32_t *)
+            ((uint32_t)_sflash_log + slot * FLASH_LOG_PAGE_BYTES);
+        
+        if (page[0] == FLASH_LOG_MAGIC_RAW && page[1] > newest) {
+            newest = page[1];
+            replay_capture = page[2];
+        }
+    }
+    
+    /* Pages of a capture are consecutive: walk back to its first one */
+    replay_first = newest;
+    while (replay_first > 1U && newest - replay_first + 1U < pages &&
+           flash_log_replay_page(replay_first - 1U) != NULL) {
+        replay_first--;
+    }
+    replay_seq = replay_first;
+    replay_slot = 0;
+}
+
+/**
+ * @brief Move to the next record holding a pair
+ * 
+ * An unused slot (0xFF padding, or a second half never programmed) ends
+ * its page; a missing page ends the trace.
+ * 
+ * @return true if there is one
+ */
+static bool flash_log_replay_next(void)
+{
+    const volatile uint32_t *record;
+    
+    while (flash_log_replay_page(replay_seq) != NULL) {
+        if (++replay_slot > FLASH_LOG_PAGE_RECORDS) {
+            replay_seq++;
+            replay_slot = 0;
+            continue;
+        }
+        record = flash_log_replay_record();
+        if (record[2] != 0U && record[2] != FLASH_LOG_PAD) {
+            return true;
+        }
+        replay_slot = FLASH_LOG_PAGE_RECORDS;  /* Rest of the page unused */
+    }
+    replay_slot = 0;
+    return false;
+}
+
+static ms583730ba01_err_t flash_log_replay_write_cmd(void *ctx, uint8_t cmd)
+{
+    (void)ctx;
+    
+    if (cmd == MS5837_RESET) {
+        flash_log_replay_rewind();
+    } else if (cmd >= MS5837_CONVERT_D1_256 && cmd <= MS5837_CONVERT_D1_8192) {
+        if (!flash_log_replay_next()) {
+            return E_MS58370BA01_COM_ERR;  /* End of the trace */
+        }
+        replay_d2 = false;
+    } else if (cmd >= MS5837_CONVERT_D2_256 && cmd <= MS5837_CONVERT_D2_8192) {
+        replay_d2 = true;
+    } else if (cmd != MS5837_ADC_READ &&
+               (cmd < MS5837_PROM_READ_BASE || cmd > MS5837_PROM_READ_BASE + 14U)) {
+        return E_MS58370BA01_CONFIG_ERR;
+    }
+    
+    replay_cmd = cmd;
+    return E_MS58370BA01_SUCCESS;
+}
+
+static ms583730ba01_err_t flash_log_replay_read_data(void *ctx, uint8_t *buf, uint32_t n)
+{
+    const volatile uint32_t *page = flash_log_replay_page(replay_first);
+    const volatile uint32_t *record = flash_log_replay_record();
+    
+    (void)ctx;
+    
+    if (buf == NULL) {
+        return E_MS58370BA01_NULLPTR_ERR;
+    }
+    
+    if (replay_cmd == MS5837_ADC_READ && n == MS5837_ADC_BYTES && record != NULL) {
+        uint32_t adc = record[replay_d2 ? 3U : 2U];
+        
+        buf[0] = (uint8_t)(adc >> 16);
+        buf[1] = (uint8_t)(adc >> 8);
+        buf[2] = (uint8_t)adc;
+        return E_MS58370BA01_SUCCESS;
+    }
+    if (replay_cmd >= MS5837_PROM_READ_BASE && n == 2U && page != NULL) {
+        uint32_t index = (replay_cmd - MS5837_PROM_READ_BASE) / 2U;
+        uint16_t word = (uint16_t)(page[FLASH_LOG_HEADER_WORDS + index / 2U] >> (16U * (index & 1U)));
+        
+        buf[0] = (uint8_t)(word >> 8);
+        buf[1] = (uint8_t)word;
+        return E_MS58370BA01_SUCCESS;
+    }
+    return E_MS58370BA01_COM_ERR;
+}
+
+static void flash_log_replay_delay(uint16_t ms)
+{
+    board_delay_ms(ms);  /* Also from a handler at the SysTick level (BOARD_PURE_ISR) */
+}
+
+static ms583730ba01_err_t flash_log_replay_write_cmd_start(void *ctx, uint8_t cmd,
+                                                           ms583730ba01_done_cb_t done, void *done_ctx)
+{
+    ms583730ba01_err_t result = flash_log_replay_write_cmd(ctx, cmd);
+    
+    if (result == E_MS58370BA01_SUCCESS && done != NULL) {
+        done(done_ctx, result);
+    }
+    return result;
+}
+
+static ms583730ba01_err_t flash_log_replay_read_data_start(void *ctx, uint8_t *buf, uint32_t n,
+                                                           ms583730ba01_done_cb_t done, void *done_ctx)
+{
+    ms583730ba01_err_t result = flash_log_replay_read_data(ctx, buf, n);
+    
+    if (result == E_MS58370BA01_SUCCESS && done != NULL) {
+        done(done_ctx, result);
+    }
+    return result;
+}
+
+static ms583730ba01_err_t flash_log_replay_write_read(void *ctx, uint8_t cmd, uint8_t *buf, uint32_t n)
+{
+    ms583730ba01_err_t result = flash_log_replay_write_cmd(ctx, cmd);
+    
+    return (result == E_MS58370BA01_SUCCESS) ? flash_log_replay_read_data(ctx, buf, n) : result;
+}
+
+static ms583730ba01_err_t flash_log_replay_write_read_start(void *ctx, uint8_t cmd, uint8_t *buf,
+                                                            uint32_t n, ms583730ba01_done_cb_t done,
+                                                            void *done_ctx)
+{
+    ms583730ba01_err_t result = flash_log_replay_write_read(ctx, cmd, buf, n);
+    
+    if (result == E_MS58370BA01_SUCCESS && done != NULL) {
+        done(done_ctx, result);
+    }
+    return result;
+}
+
+ms583730ba01_h flash_log_replay_handle(void)
+{
+    ms583730ba01_h handle = {
+        .ctx = NULL,
+        .write_cmd = flash_log_replay_write_cmd,
+        .read_data = flash_log_replay_read_data,
+        .delay = flash_log_replay_delay,
+        .write_cmd_start = flash_log_replay_write_cmd_start,
+        .read_data_start = flash_log_replay_read_data_start,
+        .write_read = flash_log_replay_write_read,
+        .write_read_start = flash_log_replay_write_read_start
+    };
+    
+    return handle;
+}
+
+#endif /* BOARD_FLASH_LOG_REPLAY */
+
+#endif /* BOARD_FLASH_LOG_ENABLE */
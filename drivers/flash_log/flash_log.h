@@ -0,0 +1,223 @@
+#ifndef FLASH_LOG_H
+#define FLASH_LOG_H
+
+/**
+ * @file flash_log.h
+ * @brief Burst sample capture into program flash (half-page programming)
+ * 
+ * Samples go to the FLASH_LOG region of linker.ld (the top 64 KB, end of
+ * bank 2) as a ring of 128-byte pages, each programmed as two half pages
+ * with HAL_FLASHEx_HalfPageProgram() (16 words per ~3.2ms operation, run
+ * from SRAM). Pages are erased ahead of the write pointer, one operation
+ * per flash_log_poll(), which the main loop calls after taking the new
+ * samples. A page costs one erase and two programs, ~10ms for 7 samples
+ * (~700 samples/s); word programming would take ~100ms.
+ * 
+ * Page (128 bytes, little-endian; erased flash reads 0):
+ *   0   magic    uint32, FLASH_LOG_MAGIC
+ *   4   seq      uint32, page sequence number, 1.. across captures; page
+ *                seq lives at page (seq - 1) % pages of the region
+ *   8   capture  uint32, capture number (flash_log_start())
+ *   12  dropped  uint32, samples dropped since the capture started
+ *   16  samples  7 x 16-byte sample records (sensor_sampling.h), as in
+ *         usb_stream.h:
+ *         timestamp_us uint32, sequence uint32, pressure int32, temperature int32
+ * Samples 0..2 share the first half page with the header. The last half
+ * page of a capture is padded with 0xFF; a page never written past its
+ * first half reads 0 in the second. At init the newest page is found by
+ * binary search over the seq words; the oldest pages are erased as the
+ * ring wraps. Read it out over SWD (st-flash read capture.bin 0x08020000 65536).
+ * 
+ * The log image (flash_log_read_image()) is the region in seq order: the
+ * newest min(newest seq, pages of the region) pages, oldest first, as
+ * the USB mass-storage view (usb_disk.h) serves it as LOG.BIN.
+ * 
+ * Raw trace (flash_log_start_raw()): pages with magic FLASH_LOG_MAGIC_RAW
+ * hold the ADC pairs ahead of compensation instead, for replay on the
+ * bench. Same header, then
+ *   16  prom     C0..C6 uint16 (8 x uint16, the last 0xFFFF)
+ *   32  records  6 x 16 bytes:
+ *         timestamp_us uint32, sequence uint32, D1 uint32, D2 uint32
+ * With BOARD_FLASH_LOG_REPLAY the sampler reads the newest raw trace
+ * through flash_log_replay_handle(), one record per D1 conversion at the
+ * live sampling rate, and fails (bring-up retry) at the end of the trace.
+ * 
+ * Brown-out snapshot (BOARD_PVD_SAVE_ENABLE): a page with magic
+ * FLASH_LOG_MAGIC_SNAP follows the last page the emergency flush
+ * programmed. Header as above except
+ *   12  lost     uint32, half pages the flush had to drop
+ *   16  words    FLASH_LOG_SNAPSHOT_WORDS x uint32, written by the caller
+ * in the first half page; the second stays erased. The page after the
+ * newest is kept erased while idle as well, so there is always one ready.
+ * 
+ * A program blocks the caller for ~3.2ms, after the data EEPROM word in
+ * progress if there is one (eeprom_claim()); interrupts stay enabled
+ * except while the 16 words are loaded. An erase only starts in its
+ * flash_log_poll() and is checked by the next ones, with EEPROM writes
+ * held until its end of operation interrupt. Neither stalls code outside
+ * the region (read while write: bank 1 and SRAM), so the sampling tick
+ * and the I2C1 interrupt run through both. Main loop only (the host task
+ * in RTOS builds). Built only with BOARD_FLASH_LOG_ENABLE.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board_config.h"
+#include "sensor_sampling.h"
+#if BOARD_FLASH_LOG_REPLAY
+#include "ms58.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+#define FLASH_LOG_MAGIC         0x50414346UL  /* "FCAP" */
+#define FLASH_LOG_MAGIC_RAW     0x57415246UL  /* "FRAW" */
+#define FLASH_LOG_MAGIC_SNAP    0x504E5346UL  /* "FSNP" */
+#define FLASH_LOG_PAGE_SAMPLES  7U
+#define FLASH_LOG_PAGE_RECORDS  6U            /* Raw pages */
+#define FLASH_LOG_SNAPSHOT_WORDS  12U         /* Snapshot pages */
+
+/**
+ * @brief Capture counters (since flash_log_start())
+ */
+typedef struct {
+    bool running;
+    bool raw;                  /* Capture of raw pairs (flash_log_start_raw()) */
+    uint32_t capture;          /* Capture number, 0 = none yet */
+    uint32_t newest_page;      /* Seq of the newest page programmed, 0 = empty */
+    uint32_t pages;            /* Pages started */
+    uint32_t samples;          /* Samples captured */
+    uint32_t dropped;          /* Samples lost to the buffers full */
+    uint32_t errors;           /* Erase or program failures */
+} flash_log_stats_t;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Find the newest page of the region (binary search, no writes)
+ * 
+ * @return true if initialization successful, false otherwise
+ */
+bool flash_log_init(void);
+
+/**
+ * @brief Start a capture on the page after the newest
+ * 
+ * @return true if started, false if already running
+ */
+bool flash_log_start(void);
+
+/**
+ * @brief Start a raw trace on the page after the newest
+ * 
+ * @param prom PROM coefficients C0..C6 of the sensor, stored on every page
+ * @return true if started, false if already running (or replaying)
+ */
+bool flash_log_start_raw(const uint16_t *prom);
+
+/**
+ * @brief Stop the capture: program what is buffered (blocking)
+ * 
+ * @return true if every buffered sample reached the flash
+ */
+bool flash_log_stop(void);
+
+/**
+ * @brief Capture one sample (buffered, never waits on the flash)
+ * 
+ * @param sample Sample read from the sampling ring (ignored by a raw trace)
+ */
+void flash_log_push(const sensor_data_t *sample);
+
+/**
+ * @brief Capture one raw pair (buffered, ignored unless a raw trace runs)
+ * 
+ * @param record Pair read from sensor_sampling_read_raw()
+ */
+void flash_log_push_raw(const sensor_raw_record_t *record);
+
+/**
+ * @brief One erase or half-page program, if due: call after each batch of
+ *        flash_log_push()
+ */
+void flash_log_poll(void);
+
+/**
+ * @brief Read the capture counters
+ * 
+ * @param stats Filled with the current counters
+ */
+void flash_log_get_stats(flash_log_stats_t *stats);
+
+/**
+ * @brief Size of the log image
+ * 
+ * @return Bytes, a multiple of the 128-byte page
+ */
+uint32_t flash_log_image_bytes(void);
+
+/**
+ * @brief Read part of the log image, straight from the flash
+ * 
+ * Any context (the USB interrupt): it only reads. Bytes past the image
+ * read 0, as do pages erased ahead of a wrapped ring. A read while the
+ * main loop programs or erases waits for it (~3.2ms), and a capture
+ * running moves the image on under a reader.
+ * 
+ * @param offset First byte, from the oldest page
+ * @param buf Receives len bytes
+ */
+void flash_log_read_image(uint32_t offset, uint8_t *buf, uint32_t len);
+
+#if BOARD_PVD_SAVE_ENABLE
+/**
+ * @brief Program what is buffered, within a bound (brown-out)
+ * 
+ * Stops the capture, queues the partial half page and programs the queued
+ * ones oldest first, up to max_halves and only into pages already erased;
+ * the rest is dropped. Waits for an erase or program the main loop had
+ * running first. The main loop must not resume afterwards: its flash
+ * operation may have been cut short.
+ * 
+ * @param max_halves Half-page programs allowed
+ * @return Half pages dropped
+ */
+uint32_t flash_log_emergency_flush(uint32_t max_halves);
+
+/**
+ * @brief Program the snapshot page after the newest (one half-page program)
+ * 
+ * @param words FLASH_LOG_SNAPSHOT_WORDS words
+ * @return false if that page is not erased, or the program failed
+ */
+bool flash_log_emergency_snapshot(const uint32_t *words);
+#endif
+
+#if BOARD_FLASH_LOG_REPLAY
+/**
+ * @brief Sensor transport replaying the newest raw trace
+ * 
+ * Answers the MS5837 commands from the flash: reset rewinds to the first
+ * record, PROM reads return the stored coefficients, a D1 conversion moves
+ * to the next record (COM_ERR past the last one) and the ADC read returns
+ * its D1 or D2. Completions are called at once, from the caller's context.
+ * Timestamps are live: the trace keeps its values, not its timing.
+ * 
+ * @return Driver handle (async transport included)
+ */
+ms583730ba01_h flash_log_replay_handle(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FLASH_LOG_H */
@@ -0,0 +1,261 @@
+/**
+ * @file fw_update.c
+ * @brief Firmware update into the inactive flash bank implementation
+ * 
+ * One page buffer: the word that completes it (or the last image word)
+ * marks it due, and fw_update_poll() takes it through erase, first half
+ * and second half, one operation per call. A partial last page is padded
+ * with 0 (the erased value), outside the image and its CRC.
+ * 
+ * The check reads the bank back through the CRC unit (a CRC-32 job, DMA
+ * from flash), so it covers the programming as well as the transfer.
+ */
+
+#include "fw_update.h"
+
+#if BOARD_FW_UPDATE_ENABLE
+
+#include <stddef.h>
+#include "stm32l0xx_hal.h"
+#include "crc.h"
+#include "eeprom.h"
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define FW_UPDATE_TARGET      (FLASH_BASE + FW_UPDATE_BANK_BYTES)  /* Inactive bank, as mapped */
+#define FW_UPDATE_PAGE_BYTES  128U
+#define FW_UPDATE_HALF_WORDS  16U   /* One HAL_FLASHEx_HalfPageProgram() */
+#define FW_UPDATE_RAM_BYTES   0x5000UL  /* 20 KB, highest initial stack pointer */
+
+/* Page steps */
+#define FW_UPDATE_STEP_ERASE   0U
+#define FW_UPDATE_STEP_FIRST   1U
+#define FW_UPDATE_STEP_SECOND  2U
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static fw_update_state_t state = FW_UPDATE_IDLE;
+static uint32_t page_buf[FW_UPDATE_PAGE_WORDS];
+static uint32_t buf_words = 0;
+static bool page_due = false;
+static uint32_t page_step = FW_UPDATE_STEP_ERASE;
+static uint32_t page = 0;          /* Page of the image the buffer holds */
+static uint32_t image_words = 0;
+static uint32_t received = 0;      /* Image words, then the CRC */
+static uint32_t expected_crc = 0;
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static bool fw_update_erase(uint32_t addr)
+{
+    FLASH_EraseInitTypeDef erase = {0};
+    uint32_t page_error = 0;
+    bool ok;
+    
+    erase.TypeErase = FLASH_TYPEERASE_PAGES;
+    erase.PageAddress = addr;
+    erase.NbPages = 1U;
+    
+    eeprom_claim();
+    if (HAL_FLASH_Unlock() != HAL_OK) {
+        eeprom_release();
+        return false;
+    }
+    ok = HAL_FLASHEx_Erase(&erase, &page_error) == HAL_OK;
+    HAL_FLASH_Lock();
+    eeprom_release();
+    return ok;
+}
+
+static bool fw_update_program(uint32_t addr, uint32_t *words)
+{
+    bool ok;
+    
+    eeprom_claim();
+    if (HAL_FLASH_Unlock() != HAL_OK) {
+        eeprom_release();
+        return false;
+    }
+    ok = HAL_FLASHEx_HalfPageProgram(addr, words) == HAL_OK;
+    HAL_FLASH_Lock();
+    eeprom_release();
+    return ok;
+}
+
+/**
+ * @brief Mark the buffer due, padded to a page
+ */
+static void fw_update_page_due(void)
+{
+    for (uint32_t i = buf_words; i < FW_UPDATE_PAGE_WORDS; i++) {
+        page_buf[i] = 0U;
+    }
+    page_step = FW_UPDATE_STEP_ERASE;
+    page_due = true;
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+bool fw_update_init(void)
+{
+    fw_update_abort();
+    return true;
+}
+
+bool fw_update_begin(uint32_t size_bytes)
+{
+    if (size_bytes == 0U || (size_bytes & 3U) != 0U || size_bytes > FW_UPDATE_BANK_BYTES) {
+        return false;
+    }
+    
+    fw_update_abort();
+    image_words = size_bytes / 4U;
+    state = FW_UPDATE_RECEIVING;
+    return true;
+}
+
+void fw_update_abort(void)
+{
+    state = FW_UPDATE_IDLE;
+    buf_words = 0;
+    page_due = false;
+    page = 0;
+    image_words = 0;
+    received = 0;
+}
+
+bool fw_update_push(uint32_t word)
+{
+    if (state != FW_UPDATE_RECEIVING || received > image_words) {
+        return false;
+    }
+    if (received == image_words) {
+        expected_crc = word;
+        received++;
+        return true;
+    }
+    if (page_due) {
+        state = FW_UPDATE_FAILED;  /* The master did not wait for the page */
+        return false;
+    }
+    
+    page_buf[buf_words++] = word;
+    received++;
+    if (buf_words == FW_UPDATE_PAGE_WORDS || received == image_words) {
+        fw_update_page_due();
+    }
+    return true;
+}
+
+void fw_update_poll(void)
+{
+    uint32_t addr = FW_UPDATE_TARGET + page * FW_UPDATE_PAGE_BYTES;
+    bool ok;
+    
+    if (state != FW_UPDATE_RECEIVING || !page_due) {
+        return;
+    }
+    
+    switch (page_step) {
+    case FW_UPDATE_STEP_ERASE:
+        ok = fw_update_erase(addr);
+        break;
+    case FW_UPDATE_STEP_FIRST:
+        ok = fw_update_program(addr, &page_buf[0]);
+        break;
+    default:
+        ok = fw_update_program(addr + FW_UPDATE_PAGE_BYTES / 2U, &page_buf[FW_UPDATE_HALF_WORDS]);
+        break;
+    }
+    if (!ok) {
+        state = FW_UPDATE_FAILED;
+        return;
+    }
+    
+    if (++page_step > FW_UPDATE_STEP_SECOND) {
+        page_due = false;
+        buf_words = 0;
+        page++;
+    }
+}
+
+bool fw_update_verify(void)
+{
+    const volatile uint32_t *image = (const volatile uint32_t *)FW_UPDATE_TARGET;
+    uint32_t crc = 0;
+    
+    /* Every page of a complete image takes three operations at most */
+    while (state == FW_UPDATE_RECEIVING && page_due) {
+        fw_update_poll();
+    }
+    if (state != FW_UPDATE_RECEIVING || received != image_words + 1U) {
+        return false;
+    }
+    
+    /* Initial stack pointer in RAM, reset handler (Thumb) in the image */
+    if (image[0] < SRAM_BASE || image[0] > SRAM_BASE + FW_UPDATE_RAM_BYTES ||
+        image[1] < FLASH_BASE || image[1] >= FLASH_BASE + image_words * 4U || (image[1] & 1U) == 0U) {
+        state = FW_UPDATE_FAILED;
+        return false;
+    }
+    
+    if (!crc32_start((const void *)FW_UPDATE_TARGET, image_words, &crc)) {
+        state = FW_UPDATE_FAILED;
+        return false;
+    }
+    while (!crc32_poll()) {
+    }
+    state = (crc == expected_crc) ? FW_UPDATE_VERIFIED : FW_UPDATE_FAILED;
+    return state == FW_UPDATE_VERIFIED;
+}
+
+bool fw_update_swap(void)
+{
+    FLASH_AdvOBProgramInitTypeDef ob = {0};
+    
+    if (state != FW_UPDATE_VERIFIED) {
+        return false;
+    }
+    
+    ob.OptionType = OPTIONBYTE_BOOTCONFIG;
+    ob.BootConfig = (fw_update_get_active_bank() == 1U) ? OB_BOOT_BANK2 : OB_BOOT_BANK1;
+    
+    /* Queued EEPROM words first: the launch resets */
+    eeprom_flush();
+    eeprom_claim();
+    if (HAL_FLASH_Unlock() != HAL_OK || HAL_FLASH_OB_Unlock() != HAL_OK) {
+        HAL_FLASH_Lock();
+        eeprom_release();
+        return false;
+    }
+    if (HAL_FLASHEx_AdvOBProgram(&ob) != HAL_OK) {
+        HAL_FLASH_OB_Lock();
+        HAL_FLASH_Lock();
+        eeprom_release();
+        return false;
+    }
+    
+    /* Option byte reload: a system reset into the other bank */
+    (void)HAL_FLASH_OB_Launch();
+    return false;
+}
+
+fw_update_state_t fw_update_get_state(void)
+{
+    return state;
+}
+
+uint32_t fw_update_get_active_bank(void)
+{
+    return ((SYSCFG->CFGR1 & SYSCFG_CFGR1_UFB) != 0U) ? 2U : 1U;
+}
+
+#endif /* BOARD_FW_UPDATE_ENABLE */
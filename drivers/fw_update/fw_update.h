@@ -0,0 +1,124 @@
+#ifndef FW_UPDATE_H
+#define FW_UPDATE_H
+
+/**
+ * @file fw_update.h
+ * @brief Firmware update into the inactive flash bank, then a bank swap
+ * 
+ * The L072 flash is two 96 KB banks. The running image is in the bank
+ * mapped at 0x08000000; the other one is mapped at 0x08018000 and takes
+ * the new image while the firmware keeps sampling (read while write: the
+ * program and erase stalls do not touch the running bank). Once the image
+ * is in and its CRC-32 checks, the swap toggles the BFB2 option bit and
+ * reloads the option bytes (a reset): the boot code then maps the new
+ * bank at 0x08000000 (SYSCFG UFB) and starts it. Every image is linked at
+ * 0x08000000 and fits one bank, so the same binary runs from either.
+ * 
+ * The master streams the image through HOST_CMD_FW_DATA, one word a
+ * command, then the zlib CRC-32 of the image as one extra word. Words
+ * gather into a page buffer; a full page is erased and programmed as two
+ * half pages (HAL_FLASHEx_HalfPageProgram(), run from SRAM), one
+ * operation per fw_update_poll(), ~3.2 ms each (3.94 ms max). Words that
+ * arrive while a page is still being written are lost and fail the
+ * update: the master sends a page (32 words) and waits 12 ms before the
+ * next, or reads the command result.
+ * 
+ * Main loop only. Built with BOARD_FW_UPDATE_ENABLE (make USE_FW_UPDATE=1).
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+#define FW_UPDATE_BANK_BYTES  0x18000UL  /* 96 KB, largest image */
+#define FW_UPDATE_PAGE_WORDS  32U        /* Words per page the master sends before waiting */
+
+/**
+ * @brief Update state
+ */
+typedef enum {
+    FW_UPDATE_IDLE = 0,
+    FW_UPDATE_RECEIVING,   /* Begun: words going to the inactive bank */
+    FW_UPDATE_VERIFIED,    /* Image in and checked, ready to swap */
+    FW_UPDATE_FAILED       /* Word lost, erase/program failed or check failed */
+} fw_update_state_t;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Start idle
+ * 
+ * @return true if initialization successful, false otherwise
+ */
+bool fw_update_init(void);
+
+/**
+ * @brief Begin an update (drops one in progress)
+ * 
+ * @param size_bytes Image size, a multiple of 4, up to FW_UPDATE_BANK_BYTES
+ * @return true if begun, false if the size is out of range
+ */
+bool fw_update_begin(uint32_t size_bytes);
+
+/**
+ * @brief Drop the update in progress (the inactive bank is left as it is)
+ */
+void fw_update_abort(void);
+
+/**
+ * @brief Take the next image word, then the CRC-32 after the last one
+ * 
+ * @param word Little-endian, as in the binary
+ * @return false if no update is receiving, it has all its words, or the
+ *         page buffer was still being written (the update fails)
+ */
+bool fw_update_push(uint32_t word);
+
+/**
+ * @brief One erase or half-page program, if a page is due
+ */
+void fw_update_poll(void);
+
+/**
+ * @brief Finish writing and check the image (blocking, a few ms)
+ * 
+ * The vector table must point into RAM and an image linked at 0x08000000,
+ * and the CRC-32 of the bank, read back, must match the word sent.
+ * 
+ * @return true if the image is ready to swap to
+ */
+bool fw_update_verify(void);
+
+/**
+ * @brief Boot the verified image: toggles BFB2 and resets
+ * 
+ * @return false if no verified image, or the option bytes did not
+ *         program (returns only then)
+ */
+bool fw_update_swap(void);
+
+/**
+ * @brief Current state
+ */
+fw_update_state_t fw_update_get_state(void);
+
+/**
+ * @brief Bank the running image was started from (1 or 2)
+ */
+uint32_t fw_update_get_active_bank(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FW_UPDATE_H */
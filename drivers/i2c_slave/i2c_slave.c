@@ -2,38 +2,82 @@
  * @file i2c_slave.c
  * @brief I2C slave driver implementation
  * 
- * This module implements interrupt-based I2C slave functionality for
- * receiving and transmitting 32-bit values.
+ * This module implements an interrupt-based I2C register-map slave: a byte
+ * addressed register image with a register pointer and auto-increment.
  */
 
 /*
     Related files:
         drivers/i2c_slave/i2c_slave.h — API with function declarations
         drivers/i2c_slave/i2c_slave.c — Interrupt-based I2C slave driver
-        src/main.c — Added I2C1 interrupt handlers
+        src/main.c — I2C1_IRQHandler (single I2C1 vector on STM32L0)
         hal/hal_config.c — Enabled I2C1 interrupts
-        app/app.c — Integrated I2C slave with application
+        app/app.c — Defines the register layout and keeps it up to date
     
     Features:
-        Receive 32-bit value: Master can write 4 bytes (32-bit value) to slave
-        Reply with 32-bit value: Master can read 4 bytes (32-bit value) from slave
-        Interrupt-based: Uses HAL I2C interrupt callbacks
-        Callback support: Optional callbacks for RX/TX events
-        Automatic integration: TX value updated with latest pressure reading
+        Register pointer: first byte of every master write
+        Auto-increment: reads and writes of any length walk the map
+        Coherent reads: the image is triple-buffered. Each update is
+            published with one index swap and a read is pointed at the
+            image current at address match, so one read transaction
+            returns fields that belong together, with no copy in the ISR
+        Live block: a few bytes (i2c_slave_set_live()) published by
+            the sampler bottom half itself, double-buffered with an
+            index swap and copied into the frame of each read at
+            address match, so a read shows the newest sample without
+            waiting for the main loop
+        Write windows: only the ranges set by i2c_slave_set_write_window()
+            are writable by the master; other bytes are ignored
+        Callback support: optional callbacks for RX/TX events
+        Statistics: reads, writes, NACKs, errors, overruns, re-arms and
+            address-match-to-end latency (i2c_slave_get_stats())
+        Stream registers: a read at a register set by
+            i2c_slave_set_stream() sends a frame from the application
+            (FIFO burst, performance bank) instead of the register image
+        Sink register: a write starting at the register set by
+            i2c_slave_set_sink() goes to the application as received,
+            not into the image, for bulk uploads
+        DMA (BOARD_I2C1_SLAVE_DMA): whole frames move by DMA, so a transfer
+            costs the address match and the completion interrupt only
+        LL ISR (BOARD_I2C1_SLAVE_LL): ADDR/TXIS/RXNE/NACKF/STOPF handled
+            directly with stm32l0xx_ll_i2c; 0 falls back to the HAL slave
+            state machine (HAL_I2C_Slave_Seq_* and its callbacks)
+        Alias address (BOARD_I2C1_SLAVE_ADDR2, OA2 with its mask): reads
+            start at the register set by i2c_slave_set_alias() instead
+            of the pointer; writes to it are dropped
+        General call (BOARD_I2C1_GENERAL_CALL, LL with stretching): a
+            write to 0x00 takes its first byte by RXNE (also in DMA
+            builds) and passes it to the GC callback at once
+        No-stretch (BOARD_I2C1_SLAVE_NOSTRETCH, LL + DMA only): SCL is
+            never held. The response to the next read is preloaded at
+            STOP (TXDR primed, TX DMA armed) and refreshed on every
+            update while the bus is idle; the RX DMA stays armed. The TX
+            callback still runs at address match
+        SMBus (BOARD_I2C1_SMBUS, LL with stretching only): block read and
+            block write framing with hardware PEC (PECEN, PECBYTE) under
+            slave byte control, and the SCL-low timeout (TIMEOUTR, set up
+            by hal_i2c1_init()). A block write's byte count is taken at
+            the reload (TCR) stop before the data and PEC are accepted
+        Load limit (BOARD_I2C1_LOAD_BUDGET_PCT): handler time summed per
+            window; past the budget the own addresses go off until the
+            window ends (timebase deadline), so further transactions are
+            NACKed at the address
     
     How it works:
     Master Write (Master → Slave):
         Master addresses slave (0x10) with write
-        Master sends 4 bytes (32-bit value, little-endian)
-        Slave receives and converts to uint32_t
-        Value available via i2c_slave_get_received_value() or RX callback
+        Byte 0 sets the register pointer, bytes 1.. are stored from there
+        At STOP (or repeated START) the bytes are committed and the RX
+        callback reports the register and length written
     Master Read (Slave → Master):
-        Master addresses slave (0x10) with read
-        Slave sends latest pressure value (updated in app_main_loop())
-        Master receives 4 bytes (32-bit value, little-endian)
+        Master addresses slave (0x10) with read (usually after a repeated
+        START following a 1-byte pointer write)
+        Slave sends the snapshot from the register pointer onwards until
+        the master NACKs. Reads do not move the stored pointer, so a master
+        that never writes always reads from register 0
     
     Current integration:
-        TX value: Automatically set to latest pressure reading in app_main_loop()
+        Register layout: app.h (APP_REG_*), updated in app_main_loop()
         Initialization: Done in main_init_drivers() and main_init_app()
         Interrupts: Properly configured and enabled
 
@@ -41,7 +85,51 @@
 
 #include "i2c_slave.h"
 #include "board_config.h"
+#include "hal_config.h"  /* For hal_tim2_get_timestamp_us(), hal_irq_mask() */
+#include "prof.h"
+#include "trace.h"
+#include "probe.h"
+#include "timebase.h"
 #include "stm32l0xx_hal.h"
+#include "hal_atomic.h"
+#include <string.h>
+#if BOARD_I2C1_SLAVE_LL
+#include "stm32l0xx_ll_i2c.h"
+#endif
+
+#if BOARD_I2C1_SLAVE_NOSTRETCH && !(BOARD_I2C1_SLAVE_LL && BOARD_I2C1_SLAVE_DMA)
+#error "BOARD_I2C1_SLAVE_NOSTRETCH needs BOARD_I2C1_SLAVE_LL and BOARD_I2C1_SLAVE_DMA"
+#endif
+
+/* RM0377: wakeup from STOP needs clock stretching */
+#if BOARD_I2C1_SLAVE_NOSTRETCH && BOARD_I2C1_WAKEUP_STOP
+#error "BOARD_I2C1_WAKEUP_STOP needs clock stretching (BOARD_I2C1_SLAVE_NOSTRETCH 0)"
+#endif
+
+/* The preloaded response cannot depend on the address matched */
+#if BOARD_I2C1_SLAVE_NOSTRETCH && BOARD_I2C1_SLAVE_ADDR2
+#error "BOARD_I2C1_SLAVE_ADDR2 needs clock stretching (BOARD_I2C1_SLAVE_NOSTRETCH 0)"
+#endif
+
+/* Byte interrupt on the general call write: LL ISR, armed at address match */
+#if BOARD_I2C1_GENERAL_CALL && !(BOARD_I2C1_SLAVE_LL && !BOARD_I2C1_SLAVE_NOSTRETCH && !BOARD_I2C1_SMBUS)
+#error "BOARD_I2C1_GENERAL_CALL needs BOARD_I2C1_SLAVE_LL, clock stretching and no BOARD_I2C1_SMBUS"
+#endif
+
+/* Slave byte control holds SCL between count reloads */
+#if BOARD_I2C1_SMBUS && !(BOARD_I2C1_SLAVE_LL && !BOARD_I2C1_SLAVE_NOSTRETCH)
+#error "BOARD_I2C1_SMBUS needs BOARD_I2C1_SLAVE_LL and clock stretching (BOARD_I2C1_SLAVE_NOSTRETCH 0)"
+#endif
+
+#if BOARD_I2C1_SMBUS && (BOARD_I2C1_SMBUS_BLOCK_MAX == 0 || BOARD_I2C1_SMBUS_BLOCK_MAX > 255)
+#error "BOARD_I2C1_SMBUS_BLOCK_MAX must be 1..255"
+#endif
+
+#if BOARD_I2C1_SMBUS
+#define I2C_SLAVE_RX_FRAMING  2U  /* Byte count and PEC of a block write */
+#else
+#define I2C_SLAVE_RX_FRAMING  0U
+#endif
 
 /* ============================================================================
  * PRIVATE VARIABLES
@@ -51,19 +139,68 @@ static I2C_HandleTypeDef *i2c_slave_handle = NULL;
 static bool i2c_slave_initialized = false;
 static bool i2c_slave_started = false;
 
-/* Receive buffer for 32-bit value (4 bytes) */
-static uint8_t rx_buffer[4] = {0};
-static uint32_t rx_value = 0;
-static bool rx_value_ready = false;
+/* Register images: one published (read by the next master read), one
+ * possibly still being sent, one the application builds the next update in */
+#define I2C_SLAVE_REG_FRAMES  3U
+static uint8_t reg_frames[I2C_SLAVE_REG_FRAMES][I2C_SLAVE_REG_MAP_SIZE];
+static volatile uint8_t published_frame = 0;  /* Written by the producer only */
+static volatile uint8_t tx_frame = 0;         /* Frame of the last master read */
+
+/* Live block: two copies, one published, one the producer writes next.
+ * The consumers copy it out with interrupts masked, so the producer never
+ * overtakes a copy */
+static uint8_t live_frames[2][I2C_SLAVE_LIVE_MAX];
+static volatile uint8_t live_published = 0;  /* Written by the producer only */
+static volatile uint8_t live_offset = 0;
+static volatile uint8_t live_size = 0;       /* 0: no overlay */
 
-/* Transmit buffer for 32-bit value (4 bytes) */
-static uint8_t tx_buffer[4] = {0};
-static uint32_t tx_value = 0;
-static bool tx_value_set = false;
+/* Master-written bytes (write window only), re-applied to every update */
+static uint8_t host_regs[I2C_SLAVE_REG_MAP_SIZE];
+static uint8_t reg_pointer = 0;
+static uint8_t alias_reg = 0;      /* Start of reads at the second own address */
+static bool rx_dropped = false;    /* Write in flight is to the alias or a general call: ignored */
+static bool rx_general_call = false;  /* Write in flight is a general call */
+static bool gc_code_taken = false;    /* Its first byte has been passed on */
+static uint8_t write_offset[I2C_SLAVE_WRITE_WINDOWS];  /* Master-writable windows */
+static uint8_t write_size[I2C_SLAVE_WRITE_WINDOWS];
+
+/* Master write in flight: pointer byte + data (SMBus: count and PEC too) */
+static uint8_t rx_buffer[1U + I2C_SLAVE_RX_FRAMING + I2C_SLAVE_REG_MAP_SIZE];
 
 /* Callbacks */
 static i2c_slave_rx_callback_t rx_callback = NULL;
 static i2c_slave_tx_callback_t tx_callback = NULL;
+static i2c_slave_stream_cb_t stream_callbacks[I2C_SLAVE_STREAMS];
+static i2c_slave_gc_callback_t gc_callback = NULL;
+static uint8_t stream_regs[I2C_SLAVE_STREAMS];
+static i2c_slave_sink_cb_t sink_callback = NULL;
+static uint8_t sink_reg = 0;
+static bool tx_is_stream = false;  /* Last read frame came from the stream at tx_reg */
+static uint8_t tx_reg = 0;         /* Register the last read frame starts at */
+
+/* Statistics; latency from address match, summed for the mean */
+static i2c_slave_stats_t stats;
+static uint64_t latency_sum_us = 0;
+static uint32_t latency_count = 0;
+static uint32_t transfer_start_us = 0;
+static bool transfer_timed = false;
+static uint32_t write_match_us = 0;  /* Address match of the last master write */
+static uint32_t read_match_us = 0;   /* Address match of the last master read */
+static uint32_t poll_start_us = 0;   /* Of the first read of the newest poll */
+static uint32_t polls = 0;
+
+#if BOARD_I2C1_LOAD_BUDGET_PCT != 0
+#define I2C_SLAVE_LOAD_BUDGET_US  (BOARD_I2C1_LOAD_WINDOW_US * BOARD_I2C1_LOAD_BUDGET_PCT / 100U)
+
+/* Load limit: handler time of the window opened at load_window_us */
+static uint32_t load_window_us = 0;
+static uint32_t load_busy_us = 0;
+static uint32_t load_last_us = 0;   /* Sum of the last full window */
+static uint32_t load_peak_us = 0;
+static uint32_t throttle_start_us = 0;
+static volatile bool throttled = false;  /* Own addresses off */
+static timebase_deadline_t throttle_end;
+#endif
 
 /* State tracking */
 static enum {
@@ -77,27 +214,873 @@ static enum {
  * ============================================================================ */
 
 /**
- * @brief Convert 32-bit value to 4-byte array (little-endian)
+ * @brief Check that [offset, offset + len) lies inside the register map
+ */
+static bool i2c_slave_range_ok(uint8_t offset, uint32_t len)
+{
+    return (uint32_t)offset + len <= I2C_SLAVE_REG_MAP_SIZE;
+}
+
+/**
+ * @brief Check that a register is inside a write window
+ */
+static bool i2c_slave_writable(uint8_t reg)
+{
+    for (uint32_t w = 0; w < I2C_SLAVE_WRITE_WINDOWS; w++) {
+        if (reg >= write_offset[w] && reg - write_offset[w] < write_size[w]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Copy the published live block into a frame about to be sent
+ * 
+ * The frame is the published one: the producer of the image never writes
+ * it, and no read of it is in flight.
+ */
+static void i2c_slave_live_apply(uint8_t frame)
+{
+    uint32_t primask;
+    
+    if (live_size == 0U) {
+        return;
+    }
+    
+    primask = hal_crit_enter();
+    memcpy(&reg_frames[frame][live_offset], live_frames[live_published], live_size);
+    hal_crit_exit(primask);
+}
+
+/**
+ * @brief End the timed transaction, if any
  */
-static void uint32_to_bytes(uint32_t value, uint8_t *bytes)
+static void i2c_slave_stats_end(void)
 {
-    bytes[0] = (uint8_t)(value & 0xFF);
-    bytes[1] = (uint8_t)((value >> 8) & 0xFF);
-    bytes[2] = (uint8_t)((value >> 16) & 0xFF);
-    bytes[3] = (uint8_t)((value >> 24) & 0xFF);
+    uint32_t us;
+    
+    if (!transfer_timed) {
+        return;
+    }
+    transfer_timed = false;
+    PROBE_BUS(PROBE_ID_SLAVE_END);
+    
+    us = hal_tim2_get_timestamp_us() - transfer_start_us;
+    if (us < stats.latency_min_us) {
+        stats.latency_min_us = us;
+    }
+    if (us > stats.latency_max_us) {
+        stats.latency_max_us = us;
+    }
+    latency_sum_us += us;
+    latency_count++;
 }
 
 /**
- * @brief Convert 4-byte array to 32-bit value (little-endian)
+ * @brief Address match: count and time a new transaction
+ * 
+ * A repeated START ends the previous one.
  */
-static uint32_t bytes_to_uint32(const uint8_t *bytes)
+static void i2c_slave_stats_begin(bool is_read)
 {
-    return ((uint32_t)bytes[0]) |
-           ((uint32_t)bytes[1] << 8) |
-           ((uint32_t)bytes[2] << 16) |
-           ((uint32_t)bytes[3] << 24);
+    i2c_slave_stats_end();
+    PROBE_BUS(is_read ? PROBE_ID_SLAVE_READ : PROBE_ID_SLAVE_WRITE);
+    transfer_start_us = hal_tim2_get_timestamp_us();
+    transfer_timed = true;
+    if (is_read) {
+        stats.reads++;
+        if (polls == 0U || transfer_start_us - read_match_us >= I2C_SLAVE_READ_GROUP_US) {
+            poll_start_us = transfer_start_us;
+            polls++;
+        }
+        read_match_us = transfer_start_us;
+    } else {
+        stats.writes++;
+        write_match_us = transfer_start_us;
+    }
 }
 
+#if BOARD_I2C1_LOAD_BUDGET_PCT != 0
+/**
+ * @brief Own addresses (and the general call) on or off
+ * 
+ * Off, the peripheral NACKs every address; a transfer already past its
+ * address match is not affected.
+ */
+static void i2c_slave_addresses_enable(I2C_TypeDef *i2c, bool enable)
+{
+    if (enable) {
+        i2c->OAR1 |= I2C_OAR1_OA1EN;
+#if BOARD_I2C1_SLAVE_ADDR2
+        i2c->OAR2 |= I2C_OAR2_OA2EN;
+#endif
+#if BOARD_I2C1_GENERAL_CALL
+        i2c->CR1 |= I2C_CR1_GCEN;
+#endif
+    } else {
+        i2c->OAR1 &= ~I2C_OAR1_OA1EN;
+#if BOARD_I2C1_SLAVE_ADDR2
+        i2c->OAR2 &= ~I2C_OAR2_OA2EN;
+#endif
+#if BOARD_I2C1_GENERAL_CALL
+        i2c->CR1 &= ~I2C_CR1_GCEN;
+#endif
+    }
+}
+
+/**
+ * @brief End of a throttled window (TIM21 interrupt): answer again
+ */
+static void i2c_slave_throttle_end(void *context)
+{
+    uint32_t masked = hal_irq_mask(HAL_IRQ_LINES_I2C1);
+    
+    (void)context;
+    stats.throttled_us += timebase_now_us() - throttle_start_us;
+    throttled = false;
+    i2c_slave_addresses_enable(i2c_slave_handle->Instance, true);
+    hal_irq_unmask(masked);
+}
+
+/**
+ * @brief Charge a handler pass to its window, throttle past the budget
+ * 
+ * A pass at least a window after the one that opened it closes it. The
+ * next pass after a throttled window comes after its deadline, so it
+ * always opens a new one.
+ * 
+ * @param entry_us timebase_now_us() at handler entry
+ */
+static RAMFUNC void i2c_slave_load_account(uint32_t entry_us)
+{
+    uint32_t span_us = (uint16_t)(timebase_count() - (uint16_t)entry_us);
+    uint32_t age_us = entry_us - load_window_us;
+    
+    if (age_us >= BOARD_I2C1_LOAD_WINDOW_US) {
+        /* Passes a window or more apart: the last full window was empty */
+        load_last_us = (age_us < 2U * BOARD_I2C1_LOAD_WINDOW_US) ? load_busy_us : 0U;
+        load_window_us = entry_us;
+        load_busy_us = 0;
+    }
+    load_busy_us += span_us;
+    if (load_busy_us > load_peak_us) {
+        load_peak_us = load_busy_us;
+    }
+    
+    if (load_busy_us > I2C_SLAVE_LOAD_BUDGET_US && !throttled) {
+        throttled = true;
+        stats.throttles++;
+        throttle_start_us = entry_us + span_us;
+        i2c_slave_addresses_enable(i2c_slave_handle->Instance, false);
+        TRACE(TRACE_I2C_SLAVE_THROTTLE, load_busy_us, stats.throttles);
+        (void)timebase_deadline_at(&throttle_end, load_window_us + BOARD_I2C1_LOAD_WINDOW_US,
+                                   i2c_slave_throttle_end, NULL);
+    }
+}
+
+/**
+ * @brief Window load in 0.01 % of the window
+ */
+static uint16_t i2c_slave_load_centipct(uint32_t busy_us)
+{
+    uint32_t centipct = busy_us * 10000U / BOARD_I2C1_LOAD_WINDOW_US;
+    
+    return (uint16_t)((centipct > 10000U) ? 10000U : centipct);
+}
+#endif
+
+#if BOARD_I2C1_SCL_TIMEOUT_MS != 0
+/**
+ * @brief Free the bus after an SCL-low timeout: software reset (PE)
+ * 
+ * PE cleared drops the transfer logic and releases SCL and SDA; the
+ * configuration (timing, own addresses, TIMEOUTR, interrupt enables) is
+ * kept. PE read back low covers the three APB clocks it must stay low
+ * (RM0377).
+ */
+static void i2c_slave_bus_reset(I2C_TypeDef *i2c)
+{
+    i2c->CR1 &= ~I2C_CR1_PE;
+    while (i2c->CR1 & I2C_CR1_PE) {
+    }
+    i2c->CR1 |= I2C_CR1_PE;
+    stats.bus_resets++;
+}
+#endif
+
+/**
+ * @brief Commit the master write in flight
+ * 
+ * Called once the master has stopped sending (STOP, repeated START or a
+ * full buffer). Bytes outside the write window are dropped.
+ * 
+ * @param received Bytes received, pointer byte included
+ */
+static void i2c_slave_finish_write(uint32_t received)
+{
+    uint8_t start;
+    uint8_t count = 0;
+    
+    i2c_slave_state = I2C_SLAVE_STATE_IDLE;
+    
+    if (rx_dropped || received == 0U || !i2c_slave_range_ok(rx_buffer[0], 1U)) {
+        return;  /* Alias write, empty write or pointer out of range: ignored */
+    }
+    
+    reg_pointer = rx_buffer[0];
+    start = reg_pointer;
+    
+    if (start == sink_reg && sink_callback != NULL) {
+        if (received > 1U) {
+            sink_callback(&rx_buffer[1], received - 1U);
+        }
+        return;
+    }
+    
+    for (uint32_t i = 1; i < received && (uint32_t)start + i - 1U < I2C_SLAVE_REG_MAP_SIZE; i++) {
+        uint8_t reg = (uint8_t)(start + i - 1U);
+        
+        if (i2c_slave_writable(reg)) {
+            /* Published frame is not being sent: reads and writes do not
+             * overlap on the bus */
+            host_regs[reg] = rx_buffer[i];
+            reg_frames[published_frame][reg] = rx_buffer[i];
+            count++;
+        }
+    }
+    
+    /* Pointer-only writes just select the register for the next read */
+    if (count > 0U && rx_callback != NULL) {
+        rx_callback(start, count);
+    }
+}
+
+/**
+ * @brief Address match: whether the alias (OA2) was addressed
+ * 
+ * @param match_code Matched address, 7 bits shifted left (ADDCODE << 1)
+ */
+static bool i2c_slave_is_alias(uint32_t match_code)
+{
+#if BOARD_I2C1_SLAVE_ADDR2
+    return match_code != i2c_slave_handle->Init.OwnAddress1;
+#else
+    (void)match_code;
+    return false;
+#endif
+}
+
+/**
+ * @brief Pick the data for a master read
+ * 
+ * Called at address match. The producer leaves the returned frame alone
+ * until the next read picks another one.
+ * 
+ * @param start Register the read starts at (pointer, or alias register)
+ * @param len Receives the number of bytes available
+ * @return Bytes to send
+ */
+static uint8_t *i2c_slave_read_frame(uint8_t start, uint16_t *len)
+{
+    tx_reg = start;
+#if !BOARD_I2C1_SLAVE_NOSTRETCH
+    /* No-stretch: called when the preloaded frame is actually read */
+    if (tx_callback != NULL) {
+        tx_callback(start);
+    }
+#endif
+    
+    /* Stream register: the whole frame in one transaction */
+    for (uint32_t i = 0; i < I2C_SLAVE_STREAMS; i++) {
+        if (stream_callbacks[i] != NULL && start == stream_regs[i]) {
+            uint16_t frame_len = 0;
+            const uint8_t *frame = stream_callbacks[i](&frame_len);
+            
+            if (frame != NULL && frame_len > 0U) {
+                tx_is_stream = true;
+                *len = frame_len;
+                /* Transfers take a non-const pointer; TX only reads it */
+                return (uint8_t *)frame;
+            }
+            break;
+        }
+    }
+    
+    /* Published frame from the pointer to the end; the master NACKs the
+     * last byte it wants and the rest is never sent */
+    tx_is_stream = false;
+    tx_frame = published_frame;
+    i2c_slave_live_apply(tx_frame);
+    *len = (uint16_t)(I2C_SLAVE_REG_MAP_SIZE - start);
+    return &reg_frames[tx_frame][start];
+}
+
+#if BOARD_I2C1_SLAVE_LL
+/* ============================================================================
+ * LL TRANSPORT (register-level ISR)
+ * ============================================================================ */
+
+#if !BOARD_I2C1_SLAVE_DMA
+/* Byte transfer in flight (RXNE/TXIS path) */
+static const uint8_t *ll_tx_data = NULL;
+static uint16_t ll_tx_len = 0;
+static uint16_t ll_tx_index = 0;
+static uint16_t ll_rx_index = 0;
+#endif
+
+#if BOARD_I2C1_SMBUS
+/* Block write in flight: which byte the next reload (TCR) stop follows */
+static enum {
+    SMBUS_PHASE_COMMAND,   /* Command (register pointer) byte */
+    SMBUS_PHASE_COUNT,     /* Byte count */
+    SMBUS_PHASE_DATA,      /* Data and PEC loaded, checked by the peripheral */
+    SMBUS_PHASE_REJECTED   /* Count out of range, next byte NACKed */
+} smbus_phase = SMBUS_PHASE_COMMAND;
+static uint8_t smbus_count = 0;
+#endif
+
+#if BOARD_I2C1_SLAVE_DMA
+/**
+ * @brief (Re)start a DMA channel on a new buffer
+ * 
+ * Channel mode and request mapping are set once by HAL_DMA_Init() in
+ * HAL_I2C_MspInit(); completion is seen as STOPF, so no DMA interrupt.
+ */
+static void i2c_slave_ll_dma_start(DMA_Channel_TypeDef *channel, volatile uint32_t *periph,
+                                   uint8_t *mem, uint16_t len)
+{
+    channel->CCR &= ~DMA_CCR_EN;
+    channel->CPAR = (uint32_t)periph;
+    channel->CMAR = (uint32_t)mem;
+    channel->CNDTR = len;
+    channel->CCR |= DMA_CCR_EN;
+}
+#endif
+
+/**
+ * @brief Stop the transfer in flight (DMA requests and channels)
+ */
+static void i2c_slave_ll_stop_transfer(I2C_TypeDef *i2c)
+{
+#if BOARD_I2C1_GENERAL_CALL && BOARD_I2C1_SLAVE_DMA
+    if (rx_general_call) {
+        LL_I2C_DisableIT_RX(i2c);
+    }
+#endif
+    rx_general_call = false;
+#if BOARD_I2C1_SLAVE_DMA
+    LL_I2C_DisableDMAReq_TX(i2c);
+    LL_I2C_DisableDMAReq_RX(i2c);
+    i2c_slave_handle->hdmatx->Instance->CCR &= ~DMA_CCR_EN;
+    i2c_slave_handle->hdmarx->Instance->CCR &= ~DMA_CCR_EN;
+#else
+    (void)i2c;
+#endif
+}
+
+/**
+ * @brief General call byte (RXNE): the first one goes to the handler
+ */
+static void i2c_slave_ll_general_call(uint8_t byte)
+{
+    if (!gc_code_taken) {
+        gc_code_taken = true;
+        if (gc_callback != NULL) {
+            gc_callback(byte);
+        }
+    }
+}
+
+/**
+ * @brief Bytes of the master write in flight received so far
+ */
+static uint32_t i2c_slave_rx_count(void)
+{
+#if BOARD_I2C1_SLAVE_DMA
+    /* CNDTR keeps its value once the channel is disabled */
+    return sizeof(rx_buffer) - i2c_slave_handle->hdmarx->Instance->CNDTR;
+#else
+    return ll_rx_index;
+#endif
+}
+
+#if BOARD_I2C1_SMBUS
+/**
+ * @brief Block write: stop after the command byte
+ * 
+ * With slave byte control the peripheral ACKs NBYTES bytes, then holds
+ * SCL with TCR set until the next count is loaded (RELOAD).
+ */
+static void i2c_slave_smbus_arm_write(I2C_TypeDef *i2c)
+{
+    smbus_phase = SMBUS_PHASE_COMMAND;
+    MODIFY_REG(i2c->CR2, I2C_CR2_NBYTES | I2C_CR2_PECBYTE,
+               (1UL << I2C_CR2_NBYTES_Pos) | I2C_CR2_RELOAD);
+}
+
+/**
+ * @brief Block write reload stop (TCR): load the next count
+ * 
+ * After the command byte, one more for the byte count; after the count,
+ * the data bytes and the PEC byte, which the peripheral compares (PECERR
+ * and a NACK on a mismatch). A count that does not fit the map is NACKed.
+ * The received byte is in rx_buffer already: RXNE is taken first in the
+ * byte build, and the DMA moves it long before the interrupt runs.
+ */
+static void i2c_slave_smbus_on_reload(I2C_TypeDef *i2c)
+{
+    uint8_t count;
+    
+    if (smbus_phase == SMBUS_PHASE_COMMAND) {
+        smbus_phase = SMBUS_PHASE_COUNT;
+        LL_I2C_SetTransferSize(i2c, 1U);
+        return;
+    }
+    
+    count = (i2c_slave_rx_count() >= 2U) ? rx_buffer[1] : 0U;
+    if (smbus_phase != SMBUS_PHASE_COUNT || count == 0U || !i2c_slave_range_ok(0U, count)) {
+        smbus_phase = SMBUS_PHASE_REJECTED;
+        LL_I2C_AcknowledgeNextData(i2c, LL_I2C_NACK);
+        MODIFY_REG(i2c->CR2, I2C_CR2_NBYTES | I2C_CR2_RELOAD, 1UL << I2C_CR2_NBYTES_Pos);
+        return;
+    }
+    
+    smbus_phase = SMBUS_PHASE_DATA;
+    smbus_count = count;
+    MODIFY_REG(i2c->CR2, I2C_CR2_NBYTES | I2C_CR2_RELOAD,
+               (((uint32_t)count + 1U) << I2C_CR2_NBYTES_Pos) | I2C_CR2_PECBYTE);
+}
+
+/**
+ * @brief Block read: count byte first, PEC after the data
+ * 
+ * Called with TXE flushed; the count goes to TXDR before SCL is released
+ * and the data follows it from the start of the buffer.
+ * 
+ * @return Data bytes to send
+ */
+static uint16_t i2c_slave_smbus_arm_read(I2C_TypeDef *i2c, uint16_t len)
+{
+    uint16_t max = tx_is_stream ? 255U : BOARD_I2C1_SMBUS_BLOCK_MAX;
+    
+    if (len > max) {
+        len = max;
+    }
+    MODIFY_REG(i2c->CR2, I2C_CR2_NBYTES | I2C_CR2_RELOAD,
+               (((uint32_t)len + 2U) << I2C_CR2_NBYTES_Pos) | I2C_CR2_PECBYTE);
+    LL_I2C_TransmitData8(i2c, (uint8_t)len);
+    return len;
+}
+#endif /* BOARD_I2C1_SMBUS */
+
+/**
+ * @brief Commit the master write in flight (LL transports)
+ * 
+ * SMBus: [command][count][data][PEC] is committed as [pointer][data] once
+ * the PEC byte is in (a mismatch has dropped the write already); a command
+ * byte alone sets the pointer, and anything else is dropped.
+ */
+static void i2c_slave_ll_finish_write(void)
+{
+#if BOARD_I2C1_SMBUS
+    uint32_t received = i2c_slave_rx_count();
+    
+    if (smbus_phase == SMBUS_PHASE_DATA && received == (uint32_t)smbus_count + 3U) {
+        memmove(&rx_buffer[1], &rx_buffer[2], smbus_count);
+        i2c_slave_finish_write(1U + (uint32_t)smbus_count);
+    } else if (smbus_phase == SMBUS_PHASE_COUNT && received == 1U) {
+        i2c_slave_finish_write(1U);
+    } else {
+        i2c_slave_state = I2C_SLAVE_STATE_IDLE;
+    }
+#else
+    i2c_slave_finish_write(i2c_slave_rx_count());
+#endif
+}
+
+#if BOARD_I2C1_SLAVE_NOSTRETCH
+/**
+ * @brief Arm both directions of the next transaction
+ * 
+ * Without clock stretching the first byte of a read leaves right after the
+ * address ACK, before the ADDR interrupt can run, so it has to be in TXDR
+ * already. The rest follows by DMA on TXIS. A master write lands in the RX
+ * channel, armed here as well.
+ * 
+ * @param consumed false if the last transaction was not a read: a stream
+ *                 frame still preloaded for the same pointer is kept, since
+ *                 taking a new one would drop its samples
+ */
+static void i2c_slave_ll_preload(I2C_TypeDef *i2c, bool consumed)
+{
+    uint16_t len;
+    uint8_t *data;
+    
+    if (!consumed && tx_is_stream && reg_pointer == tx_reg) {
+        i2c_slave_ll_dma_start(i2c_slave_handle->hdmarx->Instance, &i2c->RXDR,
+                               rx_buffer, sizeof(rx_buffer));
+        return;
+    }
+    
+    data = i2c_slave_read_frame(reg_pointer, &len);
+    i2c_slave_ll_stop_transfer(i2c);
+    LL_I2C_ClearFlag_TXE(i2c);  /* Flush the byte preloaded last time */
+    LL_I2C_TransmitData8(i2c, data[0]);
+    if (len > 1U) {
+        i2c_slave_ll_dma_start(i2c_slave_handle->hdmatx->Instance, &i2c->TXDR, &data[1],
+                               (uint16_t)(len - 1U));
+        LL_I2C_EnableDMAReq_TX(i2c);
+    }
+    i2c_slave_ll_dma_start(i2c_slave_handle->hdmarx->Instance, &i2c->RXDR,
+                           rx_buffer, sizeof(rx_buffer));
+    LL_I2C_EnableDMAReq_RX(i2c);
+}
+
+/**
+ * @brief Address match (no-stretch): both directions are already armed
+ * 
+ * Runs while the first byte is on the bus, so it only tracks the state.
+ * A read after a repeated START sends the preloaded frame, i.e. from the
+ * pointer in place before this transaction.
+ */
+static void i2c_slave_ll_on_addr(I2C_TypeDef *i2c)
+{
+    if (i2c_slave_state == I2C_SLAVE_STATE_RX) {
+        i2c_slave_ll_finish_write();
+    }
+    
+    i2c_slave_stats_begin(LL_I2C_GetTransferDirection(i2c) == LL_I2C_DIRECTION_READ);
+    if (LL_I2C_GetTransferDirection(i2c) == LL_I2C_DIRECTION_WRITE) {
+        if (i2c_slave_state != I2C_SLAVE_STATE_IDLE) {
+            /* Write after write or read: restart the RX count */
+            i2c_slave_ll_dma_start(i2c_slave_handle->hdmarx->Instance, &i2c->RXDR,
+                                   rx_buffer, sizeof(rx_buffer));
+        }
+        i2c_slave_state = I2C_SLAVE_STATE_RX;
+    } else {
+        i2c_slave_state = I2C_SLAVE_STATE_TX;
+        if (tx_callback != NULL) {
+            tx_callback(tx_reg);
+        }
+    }
+    
+    LL_I2C_ClearFlag_ADDR(i2c);
+}
+#else
+/**
+ * @brief Address match: end the previous transfer, arm the new one
+ */
+static void i2c_slave_ll_on_addr(I2C_TypeDef *i2c)
+{
+    bool alias;
+    
+    /* Repeated START after a write: the pointer (and data) are complete */
+    if (i2c_slave_state == I2C_SLAVE_STATE_RX) {
+        i2c_slave_ll_finish_write();
+    }
+    i2c_slave_ll_stop_transfer(i2c);
+    i2c_slave_stats_begin(LL_I2C_GetTransferDirection(i2c) == LL_I2C_DIRECTION_READ);
+    alias = i2c_slave_is_alias(LL_I2C_GetAddressMatchCode(i2c));
+    
+    if (LL_I2C_GetTransferDirection(i2c) == LL_I2C_DIRECTION_WRITE) {
+        /* Master wants to write: pointer byte, then data */
+        i2c_slave_state = I2C_SLAVE_STATE_RX;
+        rx_dropped = alias;
+#if BOARD_I2C1_GENERAL_CALL
+        rx_general_call = (LL_I2C_GetAddressMatchCode(i2c) == 0U);
+#endif
+        if (rx_general_call) {
+            /* Broadcast: by byte interrupt, nothing for the map */
+            rx_dropped = true;
+            gc_code_taken = false;
+#if BOARD_I2C1_SLAVE_DMA
+            LL_I2C_EnableIT_RX(i2c);
+#endif
+        } else {
+#if BOARD_I2C1_SLAVE_DMA
+            i2c_slave_ll_dma_start(i2c_slave_handle->hdmarx->Instance, &i2c->RXDR,
+                                   rx_buffer, sizeof(rx_buffer));
+            LL_I2C_EnableDMAReq_RX(i2c);
+#else
+            ll_rx_index = 0;
+#endif
+        }
+#if BOARD_I2C1_SMBUS
+        i2c_slave_smbus_arm_write(i2c);
+#endif
+    } else {
+        /* Master wants to read */
+        uint16_t len;
+        uint8_t *data = i2c_slave_read_frame(alias ? alias_reg : reg_pointer, &len);
+        
+        i2c_slave_state = I2C_SLAVE_STATE_TX;
+        LL_I2C_ClearFlag_TXE(i2c);  /* Flush a byte left from the last read */
+#if BOARD_I2C1_SMBUS
+        len = i2c_slave_smbus_arm_read(i2c, len);
+#endif
+#if BOARD_I2C1_SLAVE_DMA
+        i2c_slave_ll_dma_start(i2c_slave_handle->hdmatx->Instance, &i2c->TXDR, data, len);
+        LL_I2C_EnableDMAReq_TX(i2c);
+#else
+        ll_tx_data = data;
+        ll_tx_len = len;
+        ll_tx_index = 0;
+#endif
+    }
+    
+    /* Releases SCL: the transfer starts */
+    LL_I2C_ClearFlag_ADDR(i2c);
+}
+#endif /* BOARD_I2C1_SLAVE_NOSTRETCH */
+
+/* Error flags that drop the transfer in flight */
+#if BOARD_I2C1_SMBUS
+#define I2C_SLAVE_LL_ERRORS  (I2C_ISR_BERR | I2C_ISR_ARLO | I2C_ISR_OVR | I2C_ISR_PECERR | I2C_ISR_TIMEOUT)
+#elif BOARD_I2C1_SCL_TIMEOUT_MS != 0
+#define I2C_SLAVE_LL_ERRORS  (I2C_ISR_BERR | I2C_ISR_ARLO | I2C_ISR_OVR | I2C_ISR_TIMEOUT)
+#else
+#define I2C_SLAVE_LL_ERRORS  (I2C_ISR_BERR | I2C_ISR_ARLO | I2C_ISR_OVR)
+#endif
+
+/**
+ * @brief I2C1 slave ISR
+ * 
+ * Flags are taken in bus order: a byte received before a repeated START
+ * or STOP is stored before the transfer is ended.
+ */
+static RAMFUNC void i2c_slave_ll_irq(I2C_TypeDef *i2c)
+{
+    uint32_t isr = i2c->ISR;
+    
+    /* Bus error, arbitration loss (SMBus-style contention), overrun, SCL
+     * held low past the timeout, and in SMBus builds a PEC mismatch: drop
+     * the transfer in flight */
+    if (isr & I2C_SLAVE_LL_ERRORS) {
+        if (isr & (I2C_ISR_BERR | I2C_ISR_ARLO | I2C_ISR_PECERR | I2C_ISR_TIMEOUT)) {
+            stats.errors++;
+        }
+        if (isr & I2C_ISR_OVR) {
+            stats.overruns++;
+        }
+#if BOARD_I2C1_SMBUS
+        if (isr & I2C_ISR_PECERR) {
+            stats.pec_errors++;
+        }
+        LL_I2C_ClearSMBusFlag_PECERR(i2c);
+#endif
+#if BOARD_I2C1_SCL_TIMEOUT_MS != 0
+        if (isr & I2C_ISR_TIMEOUT) {
+            stats.timeouts++;
+        }
+        LL_I2C_ClearSMBusFlag_TIMEOUT(i2c);
+#endif
+        TRACE(TRACE_I2C_SLAVE_ERROR, isr & I2C_SLAVE_LL_ERRORS, i2c_slave_state);
+        stats.rearms++;
+        i2c_slave_stats_end();
+        LL_I2C_ClearFlag_BERR(i2c);
+        LL_I2C_ClearFlag_ARLO(i2c);
+        LL_I2C_ClearFlag_OVR(i2c);
+        i2c_slave_ll_stop_transfer(i2c);
+#if BOARD_I2C1_SCL_TIMEOUT_MS != 0
+        if (isr & I2C_ISR_TIMEOUT) {
+            i2c_slave_bus_reset(i2c);  /* Also drops a byte left in TXDR */
+        }
+#endif
+        i2c_slave_state = I2C_SLAVE_STATE_IDLE;
+#if BOARD_I2C1_SLAVE_NOSTRETCH
+        i2c_slave_ll_preload(i2c, true);
+#endif
+    }
+    
+#if !BOARD_I2C1_SLAVE_DMA || BOARD_I2C1_GENERAL_CALL
+    /* Every write byte, or general call bytes only in DMA builds */
+    if (isr & I2C_ISR_RXNE) {
+        uint8_t byte = LL_I2C_ReceiveData8(i2c);
+        
+        if (rx_general_call) {
+            i2c_slave_ll_general_call(byte);
+        }
+#if !BOARD_I2C1_SLAVE_DMA
+        else if (ll_rx_index < sizeof(rx_buffer)) {
+            rx_buffer[ll_rx_index++] = byte;
+        }
+#endif
+    }
+#endif
+    
+#if BOARD_I2C1_SMBUS
+    if (isr & I2C_ISR_TCR) {
+        i2c_slave_smbus_on_reload(i2c);
+    }
+#endif
+    
+    if (isr & I2C_ISR_ADDR) {
+        i2c_slave_ll_on_addr(i2c);
+    }
+    
+#if !BOARD_I2C1_SLAVE_DMA
+    if (isr & I2C_ISR_TXIS) {
+        /* Past the end: idle-high filler, the master should have NACKed */
+        LL_I2C_TransmitData8(i2c, (ll_tx_index < ll_tx_len) ? ll_tx_data[ll_tx_index++] : 0xFFU);
+    }
+#endif
+    
+    /* Master NACKed the last byte it wanted: normal end of a read */
+    if (isr & I2C_ISR_NACKF) {
+        LL_I2C_ClearFlag_NACK(i2c);
+        stats.nacks++;
+    }
+    
+    if (isr & I2C_ISR_STOPF) {
+#if BOARD_I2C1_SLAVE_NOSTRETCH
+        bool consumed = (i2c_slave_state == I2C_SLAVE_STATE_TX);
+#endif
+        
+        LL_I2C_ClearFlag_STOP(i2c);
+        if (i2c_slave_state == I2C_SLAVE_STATE_RX) {
+            i2c_slave_ll_finish_write();
+        }
+        i2c_slave_stats_end();
+        i2c_slave_state = I2C_SLAVE_STATE_IDLE;
+#if BOARD_I2C1_SLAVE_NOSTRETCH
+        /* From the pointer just written, if any */
+        i2c_slave_ll_preload(i2c, consumed);
+#else
+        i2c_slave_ll_stop_transfer(i2c);
+        LL_I2C_ClearFlag_TXE(i2c);  /* Drop the byte preloaded past the NACK */
+#endif
+    }
+}
+
+/**
+ * @brief Slave interrupt sources handled by i2c_slave_ll_irq()
+ */
+static void i2c_slave_ll_enable_it(I2C_TypeDef *i2c, bool enable)
+{
+    uint32_t mask = I2C_CR1_ADDRIE | I2C_CR1_NACKIE | I2C_CR1_STOPIE | I2C_CR1_ERRIE;
+    
+#if !BOARD_I2C1_SLAVE_DMA
+    mask |= I2C_CR1_RXIE | I2C_CR1_TXIE;
+#endif
+#if BOARD_I2C1_SMBUS
+    mask |= I2C_CR1_TCIE;  /* Block write reload stops */
+#endif
+    
+    if (enable) {
+        i2c->CR1 |= mask;
+    } else {
+        i2c->CR1 &= ~mask;
+    }
+}
+
+#if BOARD_I2C1_SLAVE_NOSTRETCH
+/**
+ * @brief Re-preload after an update, if no transaction can be affected
+ * 
+ * Called with interrupts masked. Skipped while the bus is busy (the
+ * previous preload was coherent and still is) and for a stream frame,
+ * which was taken from the application and must not be taken twice.
+ * An address phase starting after the BUSY check takes 9 SCL cycles,
+ * far longer than the rewrite.
+ */
+static void i2c_slave_ll_refresh(void)
+{
+    if (!i2c_slave_started || i2c_slave_state != I2C_SLAVE_STATE_IDLE || tx_is_stream ||
+        LL_I2C_IsActiveFlag_BUSY(i2c_slave_handle->Instance)) {
+        return;
+    }
+    
+    i2c_slave_ll_preload(i2c_slave_handle->Instance, true);
+}
+#endif
+
+#else /* !BOARD_I2C1_SLAVE_LL */
+/* ============================================================================
+ * HAL TRANSPORT (fallback)
+ * ============================================================================ */
+
+/**
+ * @brief Bytes of the master write in flight received so far
+ */
+static uint32_t i2c_slave_rx_count(const I2C_HandleTypeDef *hi2c)
+{
+#if BOARD_I2C1_SLAVE_DMA
+    /* HAL does not advance pBuffPtr under DMA; the channel counts down.
+     * CNDTR keeps its value once the channel is stopped or aborted */
+    return sizeof(rx_buffer) - __HAL_DMA_GET_COUNTER(hi2c->hdmarx);
+#else
+    return (uint32_t)(hi2c->pBuffPtr - rx_buffer);
+#endif
+}
+
+/**
+ * @brief Arm the receive of a master write
+ */
+static void i2c_slave_arm_rx(I2C_HandleTypeDef *hi2c)
+{
+#if BOARD_I2C1_SLAVE_DMA
+    HAL_I2C_Slave_Seq_Receive_DMA(hi2c, rx_buffer, sizeof(rx_buffer), I2C_FIRST_AND_LAST_FRAME);
+#else
+    HAL_I2C_Slave_Seq_Receive_IT(hi2c, rx_buffer, sizeof(rx_buffer), I2C_FIRST_AND_LAST_FRAME);
+#endif
+}
+
+/**
+ * @brief Arm the transmit of a master read
+ */
+static void i2c_slave_arm_tx(I2C_HandleTypeDef *hi2c, uint8_t *data, uint16_t len)
+{
+#if BOARD_I2C1_SLAVE_DMA
+    HAL_I2C_Slave_Seq_Transmit_DMA(hi2c, data, len, I2C_FIRST_AND_LAST_FRAME);
+#else
+    HAL_I2C_Slave_Seq_Transmit_IT(hi2c, data, len, I2C_FIRST_AND_LAST_FRAME);
+#endif
+}
+
+#if BOARD_I2C1_SCL_TIMEOUT_MS != 0
+/**
+ * @brief SCL-low timeout: drop the transfer, free the bus, listen again
+ * 
+ * HAL handles TIMEOUT in its SMBus driver only: left alone, the flag keeps
+ * the error interrupt pending. The transfer in flight is dropped as on a
+ * bus error and the handle set back to READY by hand, as HAL_I2C_Init()
+ * leaves it, so listen can be armed again.
+ */
+static void i2c_slave_hal_timeout(I2C_HandleTypeDef *hi2c)
+{
+    __HAL_I2C_CLEAR_FLAG(hi2c, I2C_FLAG_TIMEOUT);
+    stats.timeouts++;
+    stats.errors++;
+    TRACE(TRACE_I2C_SLAVE_ERROR, I2C_ISR_TIMEOUT, i2c_slave_state);
+    i2c_slave_stats_end();
+    i2c_slave_state = I2C_SLAVE_STATE_IDLE;
+    
+    __HAL_I2C_DISABLE_IT(hi2c, I2C_IT_ERRI | I2C_IT_TCI | I2C_IT_STOPI | I2C_IT_NACKI |
+                               I2C_IT_ADDRI | I2C_IT_RXI | I2C_IT_TXI);
+    hi2c->Instance->CR1 &= ~(I2C_CR1_TXDMAEN | I2C_CR1_RXDMAEN);
+#if BOARD_I2C1_SLAVE_DMA
+    (void)HAL_DMA_Abort(hi2c->hdmatx);
+    (void)HAL_DMA_Abort(hi2c->hdmarx);
+#endif
+    i2c_slave_bus_reset(hi2c->Instance);
+    
+    hi2c->State = HAL_I2C_STATE_READY;
+    hi2c->Mode = HAL_I2C_MODE_NONE;
+    hi2c->PreviousState = 0U;
+    hi2c->XferISR = NULL;
+    hi2c->XferCount = 0U;
+    hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+    __HAL_UNLOCK(hi2c);
+    
+    if (i2c_slave_started) {
+        stats.rearms++;
+        (void)HAL_I2C_EnableListen_IT(hi2c);
+    }
+}
+#endif
+#endif /* BOARD_I2C1_SLAVE_LL */
+
 /* ============================================================================
  * PUBLIC FUNCTIONS
  * ============================================================================ */
@@ -115,12 +1098,52 @@ bool i2c_slave_init(I2C_HandleTypeDef *hi2c, uint8_t slave_addr)
         return false;  /* Address mismatch */
     }
     
+#if BOARD_I2C1_SLAVE_DMA
+    /* DMA channels are linked by HAL_I2C_MspInit() */
+    if (i2c_slave_handle->hdmatx == NULL || i2c_slave_handle->hdmarx == NULL) {
+        return false;
+    }
+#endif
+    
     /* Initialize state */
     i2c_slave_state = I2C_SLAVE_STATE_IDLE;
-    rx_value_ready = false;
-    tx_value_set = false;
+    reg_pointer = 0;
+    alias_reg = 0;
+    rx_dropped = false;
+    memset(write_offset, 0, sizeof(write_offset));
+    memset(write_size, 0, sizeof(write_size));
+    memset(reg_frames, 0, sizeof(reg_frames));
+    memset(host_regs, 0, sizeof(host_regs));
+    published_frame = 0;
+    tx_frame = 0;
+    memset(live_frames, 0, sizeof(live_frames));
+    live_published = 0;
+    live_offset = 0;
+    live_size = 0;
     rx_callback = NULL;
     tx_callback = NULL;
+    memset(stream_callbacks, 0, sizeof(stream_callbacks));
+    sink_callback = NULL;
+    sink_reg = 0;
+    gc_callback = NULL;
+    rx_general_call = false;
+    tx_is_stream = false;
+    stats = (i2c_slave_stats_t){0};
+    stats.latency_min_us = UINT32_MAX;
+    latency_sum_us = 0;
+    latency_count = 0;
+    transfer_timed = false;
+#if BOARD_I2C1_LOAD_BUDGET_PCT != 0
+    timebase_deadline_cancel(&throttle_end);
+    if (throttled) {
+        i2c_slave_addresses_enable(hi2c->Instance, true);
+        throttled = false;
+    }
+    load_window_us = timebase_now_us() - BOARD_I2C1_LOAD_WINDOW_US;
+    load_busy_us = 0;
+    load_last_us = 0;
+    load_peak_us = 0;
+#endif
     
     i2c_slave_initialized = true;
     return true;
@@ -136,9 +1159,17 @@ bool i2c_slave_start(void)
         return true;  /* Already started */
     }
     
-    /* Prepare receive buffer */
-    rx_value_ready = false;
-    
+#if BOARD_I2C1_SLAVE_LL
+    /* Own address is enabled by HAL_I2C_Init(); just take the interrupts */
+    i2c_slave_state = I2C_SLAVE_STATE_IDLE;
+#if BOARD_I2C1_SLAVE_NOSTRETCH
+    tx_is_stream = false;
+    i2c_slave_ll_preload(i2c_slave_handle->Instance, true);
+#endif
+    i2c_slave_ll_enable_it(i2c_slave_handle->Instance, true);
+    i2c_slave_started = true;
+    return true;
+#else
     /* Start listening for address match (receive mode) */
     HAL_StatusTypeDef status = HAL_I2C_EnableListen_IT(i2c_slave_handle);
     
@@ -149,6 +1180,7 @@ bool i2c_slave_start(void)
     }
     
     return false;
+#endif
 }
 
 bool i2c_slave_stop(void)
@@ -157,7 +1189,12 @@ bool i2c_slave_stop(void)
         return true;  /* Already stopped */
     }
     
+#if BOARD_I2C1_SLAVE_LL
+    i2c_slave_ll_enable_it(i2c_slave_handle->Instance, false);
+    i2c_slave_ll_stop_transfer(i2c_slave_handle->Instance);
+#else
     HAL_I2C_DisableListen_IT(i2c_slave_handle);
+#endif
     i2c_slave_started = false;
     i2c_slave_state = I2C_SLAVE_STATE_IDLE;
     
@@ -174,39 +1211,272 @@ void i2c_slave_register_tx_callback(i2c_slave_tx_callback_t callback)
     tx_callback = callback;
 }
 
-bool i2c_slave_get_received_value(uint32_t *value)
+bool i2c_slave_set_write_window(uint8_t window, uint8_t offset, uint8_t size)
+{
+    uint32_t masked;
+    
+    if (window >= I2C_SLAVE_WRITE_WINDOWS || !i2c_slave_range_ok(offset, size)) {
+        return false;
+    }
+    
+    masked = hal_irq_mask(HAL_IRQ_LINES_I2C1);
+    write_offset[window] = offset;
+    write_size[window] = size;
+    hal_irq_unmask(masked);
+    
+    return true;
+}
+
+bool i2c_slave_set_stream(uint8_t reg, i2c_slave_stream_cb_t callback)
+{
+    uint32_t masked;
+    uint32_t slot = I2C_SLAVE_STREAMS;
+    
+    if (!i2c_slave_range_ok(reg, 1U)) {
+        return false;
+    }
+    
+    /* The slot of reg, else the first free one */
+    for (uint32_t i = 0; i < I2C_SLAVE_STREAMS; i++) {
+        if (stream_callbacks[i] != NULL && stream_regs[i] == reg) {
+            slot = i;
+            break;
+        }
+        if (stream_callbacks[i] == NULL && slot == I2C_SLAVE_STREAMS) {
+            slot = i;
+        }
+    }
+    if (slot == I2C_SLAVE_STREAMS) {
+        return false;
+    }
+    
+    masked = hal_irq_mask(HAL_IRQ_LINES_I2C1);
+    stream_regs[slot] = reg;
+    stream_callbacks[slot] = callback;
+    hal_irq_unmask(masked);
+    
+    return true;
+}
+
+bool i2c_slave_set_sink(uint8_t reg, i2c_slave_sink_cb_t callback)
+{
+    uint32_t masked;
+    
+    if (!i2c_slave_range_ok(reg, 1U)) {
+        return false;
+    }
+    
+    masked = hal_irq_mask(HAL_IRQ_LINES_I2C1);
+    sink_reg = reg;
+    sink_callback = callback;
+    hal_irq_unmask(masked);
+    return true;
+}
+
+bool i2c_slave_set_alias(uint8_t reg)
 {
-    if (value == NULL) {
+    if (!i2c_slave_range_ok(reg, 1U)) {
         return false;
     }
     
-    if (rx_value_ready) {
-        *value = rx_value;
-        rx_value_ready = false;  /* Clear flag after reading */
+    alias_reg = reg;  /* One byte: read whole by the address ISR */
+    return true;
+}
+
+void i2c_slave_register_gc_callback(i2c_slave_gc_callback_t callback)
+{
+    gc_callback = callback;
+}
+
+bool i2c_slave_write_regs(uint8_t offset, const uint8_t *data, uint8_t len)
+{
+    uint8_t current;
+    uint8_t next;
+    uint32_t masked;
+    
+    if (data == NULL || !i2c_slave_range_ok(offset, len)) {
+        return false;
+    }
+    
+    /* Build the update in the frame that is neither published nor being
+     * sent. The address ISR only ever moves tx_frame to the published
+     * frame, so the choice stays valid while it runs */
+    current = published_frame;
+    next = 0;
+    while (next == current || next == tx_frame) {
+        next++;
+    }
+    
+    memcpy(reg_frames[next], reg_frames[current], I2C_SLAVE_REG_MAP_SIZE);
+    memcpy(&reg_frames[next][offset], data, len);
+    
+    /* I2C1 masked only for the window re-apply and the swap: a master write
+     * committed during the copy is not lost */
+    masked = hal_irq_mask(HAL_IRQ_LINES_I2C1);
+    for (uint32_t w = 0; w < I2C_SLAVE_WRITE_WINDOWS; w++) {
+        for (uint32_t i = write_offset[w]; i < (uint32_t)write_offset[w] + write_size[w]; i++) {
+            reg_frames[next][i] = host_regs[i];
+        }
+    }
+    published_frame = next;
+#if BOARD_I2C1_SLAVE_NOSTRETCH
+    i2c_slave_ll_refresh();
+#endif
+    hal_irq_unmask(masked);
+    
+    return true;
+}
+
+bool i2c_slave_set_live(uint8_t offset, uint8_t size)
+{
+    uint32_t masked;
+    
+    if (size > I2C_SLAVE_LIVE_MAX || !i2c_slave_range_ok(offset, size)) {
+        return false;
+    }
+    
+    masked = hal_irq_mask(HAL_IRQ_LINES_I2C1);
+    live_offset = offset;
+    live_size = size;
+#if BOARD_I2C1_SLAVE_NOSTRETCH
+    i2c_slave_ll_refresh();
+#endif
+    hal_irq_unmask(masked);
+    
+    return true;
+}
+
+bool i2c_slave_write_live(const uint8_t *data, uint8_t len)
+{
+    uint8_t next = live_published ^ 1U;
+#if BOARD_I2C1_SLAVE_NOSTRETCH
+    uint32_t masked;
+#endif
+    
+    if (data == NULL || len > I2C_SLAVE_LIVE_MAX) {
+        return false;
+    }
+    
+    /* The consumers only ever copy the published one, masked */
+    memcpy(live_frames[next], data, len);
+    __DMB();  /* Copy complete before it is published */
+    live_published = next;
+    
+#if BOARD_I2C1_SLAVE_NOSTRETCH
+    masked = hal_irq_mask(HAL_IRQ_LINES_I2C1);
+    i2c_slave_ll_refresh();
+    hal_irq_unmask(masked);
+#endif
+    
+    return true;
+}
+
+bool i2c_slave_read_regs(uint8_t offset, uint8_t *data, uint8_t len)
+{
+    uint32_t masked;
+    
+    if (data == NULL || !i2c_slave_range_ok(offset, len)) {
+        return false;
+    }
+    
+    /* I2C1 masked: a master write is committed all at once */
+    masked = hal_irq_mask(HAL_IRQ_LINES_I2C1);
+    memcpy(data, &reg_frames[published_frame][offset], len);
+    hal_irq_unmask(masked);
+    
+    return true;
+}
+
+bool i2c_slave_is_idle(void)
+{
+    if (i2c_slave_handle == NULL) {
         return true;
     }
     
-    return false;
+#if BOARD_I2C1_LOAD_BUDGET_PCT != 0
+    if (throttled) {
+        return false;
+    }
+#endif
+    return i2c_slave_state == I2C_SLAVE_STATE_IDLE &&
+           (i2c_slave_handle->Instance->ISR & I2C_ISR_BUSY) == 0U;
+}
+
+uint32_t i2c_slave_get_write_time_us(void)
+{
+    return write_match_us;
 }
 
-void i2c_slave_set_tx_value(uint32_t value)
+uint32_t i2c_slave_get_read_poll(uint32_t *start_us)
 {
-    tx_value = value;
-    tx_value_set = true;
-    uint32_to_bytes(tx_value, tx_buffer);
+    uint32_t primask = hal_crit_enter();
+    uint32_t count = polls;
+    
+    if (start_us != NULL) {
+        *start_us = poll_start_us;
+    }
+    hal_crit_exit(primask);
+    return count;
 }
 
-void i2c_slave_irq_handler(void)
+bool i2c_slave_get_stats(i2c_slave_stats_t *out)
+{
+    uint32_t masked;
+    
+    if (out == NULL) {
+        return false;
+    }
+    
+    masked = hal_irq_mask(HAL_IRQ_LINES_I2C1);
+    *out = stats;
+    out->latency_mean_us = (latency_count > 0U) ? (uint32_t)(latency_sum_us / latency_count) : 0U;
+#if BOARD_I2C1_LOAD_BUDGET_PCT != 0
+    out->load_centipct = i2c_slave_load_centipct(load_last_us);
+    out->load_peak_centipct = i2c_slave_load_centipct(load_peak_us);
+#endif
+    hal_irq_unmask(masked);
+    
+    if (out->latency_min_us == UINT32_MAX) {
+        out->latency_min_us = 0;
+    }
+    
+    return true;
+}
+
+RAMFUNC void i2c_slave_irq_handler(void)
 {
     if (i2c_slave_handle == NULL) {
         return;
     }
     
-    /* Let HAL process the interrupt */
-    HAL_I2C_EV_IRQHandler(i2c_slave_handle);
-    HAL_I2C_ER_IRQHandler(i2c_slave_handle);
+    PROF_BEGIN(PROF_SITE_I2C_SLAVE_IRQ);
+#if BOARD_I2C1_LOAD_BUDGET_PCT != 0
+    uint32_t entry_us = timebase_now_us();
+#endif
+#if BOARD_I2C1_SLAVE_LL
+    i2c_slave_ll_irq(i2c_slave_handle->Instance);
+#else
+#if BOARD_I2C1_SCL_TIMEOUT_MS != 0
+    if (i2c_slave_handle->Instance->ISR & I2C_ISR_TIMEOUT) {
+        i2c_slave_hal_timeout(i2c_slave_handle);
+    } else
+#endif
+    {
+        /* Let HAL process the interrupt; events and errors share the vector,
+         * so the error handler only runs when an error flag is set */
+        HAL_I2C_EV_IRQHandler(i2c_slave_handle);
+        if (i2c_slave_handle->Instance->ISR & (I2C_ISR_BERR | I2C_ISR_ARLO | I2C_ISR_OVR)) {
+            HAL_I2C_ER_IRQHandler(i2c_slave_handle);
+        }
+    }
+#endif
+#if BOARD_I2C1_LOAD_BUDGET_PCT != 0
+    i2c_slave_load_account(entry_us);
+#endif
+    PROF_END(PROF_SITE_I2C_SLAVE_IRQ);
 }
 
+#if !BOARD_I2C1_SLAVE_LL
 /* ============================================================================
  * HAL CALLBACKS (Called by HAL from interrupt context)
  * ============================================================================ */
@@ -218,49 +1488,38 @@ void i2c_slave_irq_handler(void)
  */
 void HAL_I2C_AddrCallback(I2C_HandleTypeDef *hi2c, uint8_t TransferDirection, uint16_t AddrMatchCode)
 {
-    (void)AddrMatchCode;  /* Unused */
-    
     if (hi2c != i2c_slave_handle) {
         return;  /* Not our I2C peripheral */
     }
     
+    /* Repeated START after a write: the pointer (and data) are complete */
+    if (i2c_slave_state == I2C_SLAVE_STATE_RX) {
+        i2c_slave_finish_write(i2c_slave_rx_count(hi2c));
+    }
+    
+    i2c_slave_stats_begin(TransferDirection == I2C_DIRECTION_RECEIVE);
+    
     if (TransferDirection == I2C_DIRECTION_TRANSMIT) {
-        /* Master wants to write (send data to us) */
+        /* Master wants to write: pointer byte, then data. The length is
+         * unknown, so the transfer ends at STOP / repeated START */
         i2c_slave_state = I2C_SLAVE_STATE_RX;
-        
-        /* Prepare to receive 4 bytes */
-        rx_value_ready = false;
-        HAL_I2C_Slave_Seq_Receive_IT(hi2c, rx_buffer, 4, I2C_FIRST_AND_LAST_FRAME);
+        rx_dropped = i2c_slave_is_alias(AddrMatchCode);
+        i2c_slave_arm_rx(hi2c);
     }
     else if (TransferDirection == I2C_DIRECTION_RECEIVE) {
-        /* Master wants to read (get data from us) */
-        i2c_slave_state = I2C_SLAVE_STATE_TX;
+        uint16_t len;
+        uint8_t *data = i2c_slave_read_frame(i2c_slave_is_alias(AddrMatchCode) ? alias_reg : reg_pointer,
+                                             &len);
         
-        /* Get value to transmit */
-        if (tx_callback != NULL) {
-            tx_value = tx_callback();
-            tx_value_set = true;
-        }
-        
-        if (tx_value_set) {
-            uint32_to_bytes(tx_value, tx_buffer);
-        } else {
-            /* Default: send zeros if no value set */
-            tx_buffer[0] = 0;
-            tx_buffer[1] = 0;
-            tx_buffer[2] = 0;
-            tx_buffer[3] = 0;
-        }
-        
-        /* Prepare to transmit 4 bytes */
-        HAL_I2C_Slave_Seq_Transmit_IT(hi2c, tx_buffer, 4, I2C_FIRST_AND_LAST_FRAME);
+        i2c_slave_state = I2C_SLAVE_STATE_TX;
+        i2c_slave_arm_tx(hi2c, data, len);
     }
 }
 
 /**
  * @brief I2C slave receive complete callback
  * 
- * Called when data reception is complete.
+ * Called when the receive buffer is full (write covering the whole map).
  */
 void HAL_I2C_SlaveRxCpltCallback(I2C_HandleTypeDef *hi2c)
 {
@@ -268,18 +1527,9 @@ void HAL_I2C_SlaveRxCpltCallback(I2C_HandleTypeDef *hi2c)
         return;
     }
     
-    /* Convert received bytes to 32-bit value */
-    rx_value = bytes_to_uint32(rx_buffer);
-    rx_value_ready = true;
-    
-    /* Call user callback if registered */
-    if (rx_callback != NULL) {
-        rx_callback(rx_value);
+    if (i2c_slave_state == I2C_SLAVE_STATE_RX) {
+        i2c_slave_finish_write(sizeof(rx_buffer));
     }
-    
-    /* Re-enable listening for next transaction */
-    i2c_slave_state = I2C_SLAVE_STATE_IDLE;
-    HAL_I2C_EnableListen_IT(hi2c);
 }
 
 /**
@@ -293,30 +1543,56 @@ void HAL_I2C_SlaveTxCpltCallback(I2C_HandleTypeDef *hi2c)
         return;
     }
     
-    /* Re-enable listening for next transaction */
     i2c_slave_state = I2C_SLAVE_STATE_IDLE;
-    HAL_I2C_EnableListen_IT(hi2c);
 }
 
 /**
  * @brief I2C error callback
  * 
- * Called when an I2C error occurs.
+ * Called (via HAL_I2C_ErrorCallback() in main.c) when an I2C error occurs.
+ * A master ending a transfer early also lands here: STOP before the write
+ * buffer is full, or NACK before the end of the map on a read. Both are
+ * reported as AF and are the normal end of a variable-length transfer.
  */
-void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
+void i2c_slave_error_callback(I2C_HandleTypeDef *hi2c)
 {
     if (hi2c != i2c_slave_handle) {
         return;
     }
     
-    /* Clear error flags and re-enable listening */
     uint32_t error = HAL_I2C_GetError(hi2c);
-    (void)error;  /* Can be used for error handling if needed */
     
+    /* DMA of the previous direction aborted by a repeated START: the
+     * write was already committed and the new transfer is running */
+    if (error == HAL_I2C_ERROR_NONE) {
+        return;
+    }
+    
+    if (i2c_slave_state == I2C_SLAVE_STATE_RX && error == HAL_I2C_ERROR_AF) {
+        i2c_slave_finish_write(i2c_slave_rx_count(hi2c));
+    }
+    if (i2c_slave_state == I2C_SLAVE_STATE_TX && error == HAL_I2C_ERROR_AF) {
+        stats.nacks++;
+    }
+    if (error & (HAL_I2C_ERROR_BERR | HAL_I2C_ERROR_ARLO)) {
+        stats.errors++;
+    }
+    if (error & HAL_I2C_ERROR_OVR) {
+        stats.overruns++;
+    }
+    if (error != HAL_I2C_ERROR_AF) {
+        TRACE(TRACE_I2C_SLAVE_ERROR, error, i2c_slave_state);
+    }
+    i2c_slave_stats_end();
+    
+    /* Bus errors drop the write in flight */
     i2c_slave_state = I2C_SLAVE_STATE_IDLE;
     
     /* Re-enable listening */
     if (i2c_slave_started) {
+        if (error != HAL_I2C_ERROR_AF) {
+            stats.rearms++;
+        }
         HAL_I2C_EnableListen_IT(hi2c);
     }
 }
@@ -332,9 +1608,29 @@ void HAL_I2C_ListenCpltCallback(I2C_HandleTypeDef *hi2c)
         return;
     }
     
+    if (i2c_slave_state == I2C_SLAVE_STATE_RX) {
+        i2c_slave_finish_write(i2c_slave_rx_count(hi2c));
+    }
+    i2c_slave_stats_end();
+    i2c_slave_state = I2C_SLAVE_STATE_IDLE;
+    
     /* Re-enable listening for next transaction */
     if (i2c_slave_started) {
         HAL_I2C_EnableListen_IT(hi2c);
     }
 }
+#endif /* !BOARD_I2C1_SLAVE_LL */
 
+#if BOARD_I2C1_SLAVE_LL
+/**
+ * @brief I2C error callback (LL ISR)
+ * 
+ * HAL never runs a transfer on the slave handle: errors are handled in
+ * i2c_slave_ll_irq(). Kept so HAL_I2C_ErrorCallback() dispatch is the same
+ * in both builds.
+ */
+void i2c_slave_error_callback(I2C_HandleTypeDef *hi2c)
+{
+    (void)hi2c;
+}
+#endif
@@ -3,13 +3,66 @@
 
 /**
  * @file i2c_slave.h
- * @brief I2C slave driver for receiving and transmitting 32-bit values
+ * @brief I2C register-map slave driver
  * 
- * This module implements I2C slave functionality to:
- * - Receive a 32-bit value from an external I2C master (write operation)
- * - Reply with a 32-bit value when requested by the master (read operation)
+ * This module implements I2C slave functionality around a byte-addressed
+ * register image of I2C_SLAVE_REG_MAP_SIZE bytes:
+ * - Master write: first byte sets the register pointer, following bytes
+ *   are stored from there (auto-increment), inside the write window only
+ * - Master read: bytes from the register pointer onwards (auto-increment)
+ *   until the master NACKs, from the image published at address match
  * 
- * The implementation uses interrupt-based handling for efficient operation.
+ * The register layout is owned by the application; multi-byte fields are
+ * little-endian by convention. The implementation is interrupt-based.
+ * 
+ * With BOARD_I2C1_SLAVE_NOSTRETCH the slave never holds SCL. A read is
+ * answered from a response preloaded at the previous STOP and refreshed by
+ * each i2c_slave_write_regs() while the bus is idle: a read after a
+ * repeated START starts at the pointer set by an earlier transaction. The
+ * TX callback still runs at address match; the stream callback runs at
+ * preload (interrupt context, or i2c_slave_write_regs() with interrupts
+ * masked).
+ * 
+ * With BOARD_I2C1_SLAVE_ADDR2 the slave also answers a second address (or
+ * a masked range of them): an alias endpoint that reads from a fixed
+ * register (i2c_slave_set_alias()), so the master's most frequent read
+ * needs no pointer write. The alias is read-only: writes to it are ACKed
+ * and dropped, and the register pointer of the main address is left alone.
+ * 
+ * With BOARD_I2C1_GENERAL_CALL a write to the general call address (0x00)
+ * hands its first byte to the GC callback as it arrives, so one broadcast
+ * reaches every board in the same bus cycle.
+ * 
+ * With BOARD_I2C1_SMBUS the same map is reached by SMBus block transfers,
+ * with a PEC byte computed and checked by the peripheral:
+ * - Block write: [command][count][count data bytes][PEC]; the command is
+ *   the register pointer. A PEC mismatch NACKs the PEC byte and drops the
+ *   write; a command byte alone (send byte) just sets the pointer
+ * - Block read: [count][data][PEC] from the pointer, count up to
+ *   BOARD_I2C1_SMBUS_BLOCK_MAX for the register image and the whole frame
+ *   for a stream register
+ * 
+ * In any build, SCL held low for BOARD_I2C1_SCL_TIMEOUT_MS (a master
+ * stalled mid-transfer; BOARD_I2C1_SMBUS_TIMEOUT_MS in SMBus builds) raises
+ * the peripheral's TIMEOUT: the transfer in flight is dropped, the
+ * peripheral reset (PE cleared and set) to release SCL and SDA, and the
+ * slave listens again from the interrupt, a few ms after the stall instead
+ * of at the watchdog reset. Each one counts in timeouts and bus_resets.
+ * 
+ * With BOARD_I2C1_LOAD_BUDGET_PCT the handler time (entry to exit, with
+ * any preemption) is summed over windows of BOARD_I2C1_LOAD_WINDOW_US,
+ * opened by the first pass after the previous one ended. A window whose
+ * sum passes the budget clears the own addresses (OA1EN, OA2EN, and GCEN
+ * in general call builds) up to its end, where a timebase deadline sets
+ * them again: the master's transactions meanwhile are NACKed at the
+ * address and cost no interrupt, while one already past its address
+ * match completes as usual. The address phase is the only point where
+ * the slave can refuse a transaction without holding SCL, so whole
+ * transactions are refused rather than single registers, and the slave
+ * never stretches longer than one handler pass. However the master
+ * drives the bus, the slave takes at most the budget of each window plus
+ * one pass from the sampling tick. Refusals count in throttles and
+ * throttled_us.
  */
 
 #include <stdint.h>
@@ -20,6 +73,17 @@
 extern "C" {
 #endif
 
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define I2C_SLAVE_REG_MAP_SIZE  256U  /* Register image size in bytes */
+#define I2C_SLAVE_WRITE_WINDOWS 2U    /* Master-writable ranges (i2c_slave_set_write_window()) */
+#define I2C_SLAVE_LIVE_MAX      16U   /* Largest live block (i2c_slave_set_live()) */
+#define I2C_SLAVE_STREAMS       4U    /* Stream registers (i2c_slave_set_stream()) */
+#define I2C_SLAVE_SINK_MAX      I2C_SLAVE_REG_MAP_SIZE  /* Largest write to the sink register */
+#define I2C_SLAVE_READ_GROUP_US 2000U /* Reads closer than this to the last one: same poll */
+
 /* ============================================================================
  * TYPES
  * ============================================================================ */
@@ -27,20 +91,82 @@ extern "C" {
 /**
  * @brief I2C slave callback function type
  * 
- * Called when a 32-bit value is received from the master.
+ * Called (interrupt context) when a master write has changed registers.
+ * 
+ * @param reg First register written
+ * @param len Number of registers written (inside the write window)
+ */
+typedef void (*i2c_slave_rx_callback_t)(uint8_t reg, uint8_t len);
+
+/**
+ * @brief I2C slave callback function type for read requests
+ * 
+ * Called (interrupt context) at address match of a master read. Keep it
+ * short, and do not update registers from it: i2c_slave_write_regs()
+ * has a single producer context.
+ * 
+ * @param reg Register the read starts at
+ */
+typedef void (*i2c_slave_tx_callback_t)(uint8_t reg);
+
+/**
+ * @brief Stream register source
+ * 
+ * Called (interrupt context) at address match of a master read starting
+ * at its stream register. Returns the frame to send in place of the
+ * register image; it must stay untouched until the next call.
+ * 
+ * @param len Receives the frame length in bytes
+ * @return Frame bytes, or NULL to send the register image instead
+ */
+typedef const uint8_t *(*i2c_slave_stream_cb_t)(uint16_t *len);
+
+/**
+ * @brief Sink register consumer
+ * 
+ * Called (interrupt context) at the end of a master write starting at the
+ * sink register, with the bytes after the pointer as received (by DMA in
+ * DMA builds). They stay valid for the call only. Keep it short.
  * 
- * @param received_value The 32-bit value received from master
+ * @param data Bytes written
+ * @param len Their number, 1..I2C_SLAVE_SINK_MAX
  */
-typedef void (*i2c_slave_rx_callback_t)(uint32_t received_value);
+typedef void (*i2c_slave_sink_cb_t)(const uint8_t *data, uint32_t len);
 
 /**
- * @brief I2C slave callback function type for providing data to send
+ * @brief General call handler
  * 
- * Called when master requests data. Should return the 32-bit value to send.
+ * Called (interrupt context) as the first byte of a general call write is
+ * received, the same bus cycle on every slave of the bus. Keep it short.
  * 
- * @return 32-bit value to send to master
+ * @param code First byte after the general call address
  */
-typedef uint32_t (*i2c_slave_tx_callback_t)(void);
+typedef void (*i2c_slave_gc_callback_t)(uint8_t code);
+
+/**
+ * @brief Slave transaction statistics (since i2c_slave_init())
+ * 
+ * A transaction runs from address match to STOP, repeated START or error.
+ * Latency is measured with hal_tim2_get_timestamp_us().
+ */
+typedef struct {
+    uint32_t reads;            /* Master read transactions */
+    uint32_t writes;           /* Master write transactions (pointer-only included) */
+    uint32_t nacks;            /* Reads ended by the master's NACK */
+    uint32_t errors;           /* Bus errors and arbitration losses (PEC errors and timeouts too) */
+    uint32_t overruns;         /* Overruns / underruns (OVR) */
+    uint32_t pec_errors;       /* SMBus block writes dropped on a PEC mismatch */
+    uint32_t timeouts;         /* SCL held low past BOARD_I2C1_SCL_TIMEOUT_MS */
+    uint32_t rearms;           /* Slave re-armed after a failed transaction */
+    uint32_t bus_resets;       /* Peripheral reset (PE) to free the bus after a timeout */
+    uint32_t latency_min_us;   /* Address match to end of transaction */
+    uint32_t latency_max_us;
+    uint32_t latency_mean_us;  /* 0 until a transaction has completed */
+    uint32_t throttles;        /* Windows that passed BOARD_I2C1_LOAD_BUDGET_PCT */
+    uint32_t throttled_us;     /* Time the own addresses were off (wraps) */
+    uint16_t load_centipct;    /* Handler time over the last full window, 0.01 % */
+    uint16_t load_peak_centipct;  /* Highest window since i2c_slave_init() */
+} i2c_slave_stats_t;
 
 /* ============================================================================
  * FUNCTIONS
@@ -80,43 +206,189 @@ bool i2c_slave_stop(void);
 /**
  * @brief Register callback for received data
  * 
- * Registers a callback function that will be called when a 32-bit value
- * is received from the master.
+ * Registers a callback function that will be called when a master write
+ * has changed registers. Pointer-only writes do not call it.
  * 
  * @param callback Function to call when data is received (NULL to disable)
  */
 void i2c_slave_register_rx_callback(i2c_slave_rx_callback_t callback);
 
 /**
- * @brief Register callback for data to transmit
+ * @brief Register callback for read requests
  * 
- * Registers a callback function that will be called when the master requests
- * data. The callback should return the 32-bit value to send.
+ * Registers a callback function that will be called when the master starts
+ * a read.
  * 
  * @param callback Function to call when data is requested (NULL to disable)
  */
 void i2c_slave_register_tx_callback(i2c_slave_tx_callback_t callback);
 
 /**
- * @brief Get last received value
+ * @brief Set one master-writable register window
+ * 
+ * Master writes outside every [offset, offset + size) are ignored.
+ * Default: no writable register.
+ * 
+ * @param window Window index, below I2C_SLAVE_WRITE_WINDOWS
+ * @param offset First writable register
+ * @param size Number of writable registers (0 for none)
+ * @return true if the window fits in the map, false otherwise
+ */
+bool i2c_slave_set_write_window(uint8_t window, uint8_t offset, uint8_t size);
+
+/**
+ * @brief Attach a stream source to a register
+ * 
+ * A master read starting at reg sends the frame returned by the callback
+ * (e.g. a FIFO burst) instead of the register image. Reads starting
+ * anywhere else are not affected. Up to I2C_SLAVE_STREAMS registers have
+ * one each; attaching to a register that has one replaces it.
+ * 
+ * @param reg Register the stream is read at
+ * @param callback Frame source (NULL to detach the one of reg)
+ * @return true if successful, false if reg is outside the map or every
+ *         stream is taken
+ */
+bool i2c_slave_set_stream(uint8_t reg, i2c_slave_stream_cb_t callback);
+
+/**
+ * @brief Attach the sink to a register
+ * 
+ * A master write starting at reg hands its bytes to the callback instead
+ * of the register image and the RX callback: bulk data (e.g. a waveform
+ * table) moves in writes of up to I2C_SLAVE_SINK_MAX bytes without taking
+ * map space. The pointer is set as by any write; reads at reg are not
+ * affected. One sink; attaching replaces it.
+ * 
+ * @param reg Register the sink is written at
+ * @param callback Consumer (NULL to detach)
+ * @return true if successful, false if reg is outside the map
+ */
+bool i2c_slave_set_sink(uint8_t reg, i2c_slave_sink_cb_t callback);
+
+/**
+ * @brief Set the register reads at the second own address start at
  * 
- * Returns the most recently received 32-bit value from the master.
- * This is a non-blocking function.
+ * A read at the alias address sends the published image from reg onwards
+ * (or the stream frame, if reg is a stream register), as a read at the
+ * main address with the pointer at reg would. Only BOARD_I2C1_SLAVE_ADDR2
+ * builds answer it; the default is register 0.
  * 
- * @param value Pointer to store the received value
- * @return true if a new value was received, false otherwise
+ * @param reg Register alias reads start at
+ * @return true if reg is inside the map, false otherwise
  */
-bool i2c_slave_get_received_value(uint32_t *value);
+bool i2c_slave_set_alias(uint8_t reg);
 
 /**
- * @brief Set value to transmit
+ * @brief Register the general call handler
  * 
- * Sets the 32-bit value that will be sent when the master requests data.
- * This is an alternative to using the TX callback.
+ * Only BOARD_I2C1_GENERAL_CALL builds ACK the general call address. Its
+ * writes never reach the register map or move the pointer; bytes after
+ * the first are ignored.
  * 
- * @param value 32-bit value to send on next read request
+ * @param callback Handler (NULL to ignore general calls)
  */
-void i2c_slave_set_tx_value(uint32_t value);
+void i2c_slave_register_gc_callback(i2c_slave_gc_callback_t callback);
+
+/**
+ * @brief Update registers
+ * 
+ * Publishes a new register image with these bytes changed. Coherent
+ * against master reads: a read returns the image current at its address
+ * match, either all old or all new bytes, and a read in progress is never
+ * modified. Call from one context only (the main loop); each call copies
+ * the image once, so update related fields in one call.
+ * 
+ * @param offset First register
+ * @param data Bytes to store
+ * @param len Number of bytes
+ * @return true on success, false if the range does not fit in the map
+ */
+bool i2c_slave_write_regs(uint8_t offset, const uint8_t *data, uint8_t len);
+
+/**
+ * @brief Place the live block
+ * 
+ * A range of the map published by i2c_slave_write_live() from an
+ * interrupt instead of i2c_slave_write_regs(). The published live bytes
+ * are copied into the image at the address match of every read (at the
+ * preload with BOARD_I2C1_SLAVE_NOSTRETCH), over what the main loop stored
+ * there. Size 0 turns the overlay off: reads show the image again, and the
+ * live bytes are kept for when it is turned back on. Main loop only.
+ * 
+ * @param offset First register
+ * @param size Bytes, up to I2C_SLAVE_LIVE_MAX (0: off)
+ * @return true on success, false if the range does not fit
+ */
+bool i2c_slave_set_live(uint8_t offset, uint8_t size);
+
+/**
+ * @brief Publish the live block
+ * 
+ * Lock-free: the bytes go to the copy no reader takes, and one index store
+ * publishes them, so a read returns one whole update, never a mix. One
+ * producer, below the I2C1 priority (the sampler bottom half); it never
+ * waits on the slave and the slave never waits on it.
+ * 
+ * @param data Bytes of the block
+ * @param len Number of bytes, the size given to i2c_slave_set_live()
+ * @return true on success, false if data is NULL or len too large
+ */
+bool i2c_slave_write_live(const uint8_t *data, uint8_t len);
+
+/**
+ * @brief Read registers
+ * 
+ * Copies len bytes out of the register image, e.g. values the master
+ * has written.
+ * 
+ * @param offset First register
+ * @param data Receives the bytes
+ * @param len Number of bytes
+ * @return true on success, false if the range does not fit in the map
+ */
+bool i2c_slave_read_regs(uint8_t offset, uint8_t *data, uint8_t len);
+
+/**
+ * @brief No transaction in flight and the bus is free
+ * 
+ * The MCU may enter STOP only then: past the address match, the transfer
+ * needs the system clocks (DMA, interrupts). Not idle while the load
+ * limit holds the addresses off: the timebase that ends it halts in STOP.
+ */
+bool i2c_slave_is_idle(void);
+
+/**
+ * @brief Address match time of the last master write
+ * 
+ * Taken at the start of the address match handler, so a master time
+ * written with the same transaction pairs with it (time_sync.h). Inside
+ * the RX callback it is the write being committed.
+ * 
+ * @return hal_tim2_get_timestamp_us() at address match
+ */
+uint32_t i2c_slave_get_write_time_us(void);
+
+/**
+ * @brief Address match time of the last master poll
+ * 
+ * A poll is a run of reads each starting within I2C_SLAVE_READ_GROUP_US
+ * of the one before (registers read one transaction each); its time is
+ * that of the first read. Any context.
+ * 
+ * @param start_us Receives hal_tim2_get_timestamp_us() at the address
+ *                 match of the first read of the newest poll
+ * @return Polls since boot (wraps), 0 if none yet
+ */
+uint32_t i2c_slave_get_read_poll(uint32_t *start_us);
+
+/**
+ * @brief Snapshot of the transaction statistics
+ * 
+ * @param stats Receives the counters (taken with interrupts masked)
+ * @return true on success, false if stats is NULL
+ */
+bool i2c_slave_get_stats(i2c_slave_stats_t *stats);
 
 /**
  * @brief I2C slave interrupt handler
@@ -128,6 +400,17 @@ void i2c_slave_set_tx_value(uint32_t value);
  */
 void i2c_slave_irq_handler(void);
 
+/**
+ * @brief I2C slave error hook
+ * 
+ * Must be called from HAL_I2C_ErrorCallback(). HAL provides a single error
+ * callback for all I2C peripherals, so it is dispatched in main.c.
+ * Ignores handles other than the slave's.
+ * 
+ * @param hi2c I2C handle reported by HAL
+ */
+void i2c_slave_error_callback(I2C_HandleTypeDef *hi2c);
+
 #ifdef __cplusplus
 }
 #endif
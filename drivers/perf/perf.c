@@ -0,0 +1,157 @@
+/**
+ * @file perf.c
+ * @brief Interrupt execution times and CPU idle time implementation
+ *
+ * The entry time travels in the local PERF_ISR_BEGIN() declares, with
+ * bit 16 set when that entry ended a sleep span: only such a handler
+ * starts the next span at its exit, and only if the core sleeps again
+ * from there (sleep-on-exit). Handlers of several priorities share the
+ * counters, so the updates are masked; the common path (core awake, no
+ * new maximum) is a compare and a few cycles with interrupts off.
+ */
+
+#include "perf.h"
+
+#if BOARD_PERF_ENABLE
+
+#include "stm32l0xx_hal.h"  /* For SCB */
+#include "hal_atomic.h"
+#include "timebase.h"
+
+#include <stddef.h>
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define PERF_ENTRY_WOKE  0x10000UL  /* Entry ended a sleep span */
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static volatile bool asleep = false;
+static uint32_t sleep_us = 0;  /* Start of the current sleep span */
+static uint32_t idle_us = 0;
+static uint16_t wcet_us[PERF_ISR_COUNT];
+static uint16_t wake_min_us = UINT16_MAX;
+static uint16_t wake_max_us = 0;
+static uint32_t wakes = 0;
+static uint32_t stop_us = 0;
+static uint32_t stops = 0;
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+uint32_t perf_isr_enter(void)
+{
+    uint32_t entry = timebase_count();
+
+    if (asleep) {
+        uint32_t primask = hal_crit_enter();
+
+        if (asleep) {
+            idle_us += timebase_now_us() - sleep_us;
+            asleep = false;
+            entry |= PERF_ENTRY_WOKE;
+        }
+        hal_crit_exit(primask);
+    }
+    return entry;
+}
+
+void perf_isr_exit(perf_isr_t src, uint32_t entry)
+{
+    uint16_t span = (uint16_t)(timebase_count() - (uint16_t)entry);
+    uint32_t primask;
+
+    if ((uint32_t)src >= PERF_ISR_COUNT) {
+        return;
+    }
+
+    primask = hal_crit_enter();
+    if (span > wcet_us[src]) {
+        wcet_us[src] = span;
+    }
+    /* Back to sleep from here: the next span starts now */
+    if ((entry & PERF_ENTRY_WOKE) != 0U && (SCB->SCR & SCB_SCR_SLEEPONEXIT_Msk) != 0U) {
+        sleep_us = timebase_now_us();
+        asleep = true;
+    }
+    hal_crit_exit(primask);
+}
+
+void perf_sleep(void)
+{
+    uint32_t primask = hal_crit_enter();
+
+    sleep_us = timebase_now_us();
+    asleep = true;
+    hal_crit_exit(primask);
+}
+
+void perf_wake(uint32_t entry, uint32_t latency_us)
+{
+    uint16_t latency = (latency_us > UINT16_MAX) ? UINT16_MAX : (uint16_t)latency_us;
+    uint32_t primask;
+
+    if ((entry & PERF_ENTRY_WOKE) == 0U) {
+        return;
+    }
+
+    primask = hal_crit_enter();
+    if (latency < wake_min_us) {
+        wake_min_us = latency;
+    }
+    if (latency > wake_max_us) {
+        wake_max_us = latency;
+    }
+    wakes++;
+    hal_crit_exit(primask);
+}
+
+void perf_stop(uint32_t span_us)
+{
+    uint32_t primask = hal_crit_enter();
+
+    stop_us += span_us;
+    stops++;
+    hal_crit_exit(primask);
+}
+
+void perf_get_stats(perf_stats_t *stats)
+{
+    uint32_t primask;
+
+    if (stats == NULL) {
+        return;
+    }
+
+    primask = hal_crit_enter();
+    stats->idle_us = idle_us;
+    for (uint32_t i = 0; i < PERF_ISR_COUNT; i++) {
+        stats->wcet_us[i] = wcet_us[i];
+    }
+    stats->wake_min_us = (wakes != 0U) ? wake_min_us : 0U;
+    stats->wake_max_us = wake_max_us;
+    stats->wakes = wakes;
+    stats->stop_us = stop_us;
+    stats->stops = stops;
+    hal_crit_exit(primask);
+}
+
+void perf_clear_wcet(void)
+{
+    uint32_t primask = hal_crit_enter();
+
+    for (uint32_t i = 0; i < PERF_ISR_COUNT; i++) {
+        wcet_us[i] = 0;
+    }
+    wake_min_us = UINT16_MAX;
+    wake_max_us = 0;
+    wakes = 0;
+    hal_crit_exit(primask);
+}
+
+#endif /* BOARD_PERF_ENABLE */
@@ -0,0 +1,154 @@
+#ifndef PERF_H
+#define PERF_H
+
+/**
+ * @file perf.h
+ * @brief Interrupt execution times and CPU idle time, always on
+ *
+ * Each interrupt handler in src/main.c is bracketed by PERF_ISR_BEGIN()/
+ * PERF_ISR_END() for its source: the span is timed on the low half of the
+ * microsecond timebase (timebase_count()) and the longest one per source
+ * kept. Idle time is the time the core sleeps: PERF_SLEEP() stamps the
+ * WFI of the main loop (or the RTOS idle hook) and the first handler that
+ * runs after it takes the span up to its entry; a handler that woke the
+ * core and leaves with sleep-on-exit set stamps its exit the same way.
+ * Wake-ups by an interrupt not bracketed count as busy up to the next
+ * PERF_SLEEP(). A handler that knows when its event happened reports the
+ * time from there to its entry with PERF_WAKE(); kept only when that
+ * entry woke the core, it is the wake-up latency of the power profile
+ * (BOARD_POWER_PROFILE).
+ *
+ * Unlike the profiler (prof.h) this needs no timers of its own and stays
+ * in every build (BOARD_PERF_ENABLE): a pass costs two register reads and
+ * a short masked update. Times include preemption by higher-priority
+ * interrupts. The timebase halts in STOP, which counts as neither: STOP
+ * spans are added by PERF_STOP(), timed on a clock that runs through it.
+ *
+ * The same brackets are the handler probe points (probe.h,
+ * PROBE_GROUP_ISR), built with or without BOARD_PERF_ENABLE.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board_config.h"
+#include "probe.h"  /* For PROBE_ISR_ENTER()/PROBE_ISR_EXIT() */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * TYPES
+ * ============================================================================ */
+
+/**
+ * @brief Timed interrupt sources (index of perf_stats_t.wcet_us)
+ */
+typedef enum {
+    PERF_ISR_TICK = 0,    /* Sampling tick and conversion compare (TIM2/LPTIM1), sync input */
+    PERF_ISR_SENSOR_BUS,  /* I2C2, I2C3 (sensor transfers) */
+    PERF_ISR_SLAVE,       /* I2C1 and its DMA channels (master transactions) */
+    PERF_ISR_BOTTOM,      /* PendSV (compensation and fan-out) */
+    PERF_ISR_TIMEBASE,    /* TIM21 (deadline callbacks) */
+    PERF_ISR_DMA,         /* ADC scan, DAC stream, trace, UART stream and copy DMA, USART2 */
+    PERF_ISR_FLASH,       /* Data EEPROM queue */
+    PERF_ISR_OTHER,       /* USB, COMP2 alarm, RTC wakeup */
+    PERF_ISR_APP,         /* Main loop work in BOARD_APP_IRQn (BOARD_PURE_ISR) */
+    PERF_ISR_COUNT
+} perf_isr_t;
+
+/**
+ * @brief Counters (since boot)
+ */
+typedef struct {
+    uint32_t idle_us;                  /* Time asleep (wraps, take differences) */
+    uint16_t wcet_us[PERF_ISR_COUNT];  /* Longest handler per source (spans under 65.5 ms) */
+    uint16_t wake_min_us;              /* Shortest wake-up latency (0: none measured) */
+    uint16_t wake_max_us;              /* Longest */
+    uint32_t wakes;                    /* Wake-ups measured */
+    uint32_t stop_us;                  /* Time in STOP that was timed (wraps) */
+    uint32_t stops;                    /* STOP entries, timed or not */
+} perf_stats_t;
+
+/* ============================================================================
+ * MACROS
+ * ============================================================================ */
+
+#if BOARD_PERF_ENABLE
+/** Start timing a handler (declares a local, once per source and scope) */
+#define PERF_ISR_BEGIN(src)  uint32_t perf_entry_##src = perf_isr_enter(); PROBE_ISR_ENTER(src)
+/** Stop timing it and record the pass */
+#define PERF_ISR_END(src)    PROBE_ISR_EXIT(src); perf_isr_exit((src), perf_entry_##src)
+/** Start a sleep span (masked, right before WFI) */
+#define PERF_SLEEP()         perf_sleep()
+/** Time since the event, us, if the entry of the same scope woke the core */
+#define PERF_WAKE(src, us)   perf_wake(perf_entry_##src, (us))
+/** Back from STOP after us (0: not timed) */
+#define PERF_STOP(us)        perf_stop(us)
+#else
+#define PERF_ISR_BEGIN(src)  PROBE_ISR_ENTER(src)
+#define PERF_ISR_END(src)    PROBE_ISR_EXIT(src)
+#define PERF_SLEEP()         ((void)0)
+#define PERF_WAKE(src, us)   ((void)0)
+#define PERF_STOP(us)        ((void)0)
+#endif
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Handler entry (PERF_ISR_BEGIN())
+ *
+ * Ends a sleep span if the core was asleep.
+ *
+ * @return Entry time, with the wake-up flagged
+ */
+uint32_t perf_isr_enter(void);
+
+/**
+ * @brief Handler exit (PERF_ISR_END())
+ *
+ * @param src Source of the handler
+ * @param entry perf_isr_enter() of the same pass
+ */
+void perf_isr_exit(perf_isr_t src, uint32_t entry);
+
+/**
+ * @brief Core about to sleep (thread mode, right before WFI)
+ */
+void perf_sleep(void);
+
+/**
+ * @brief Wake-up latency of a handler (PERF_WAKE())
+ *
+ * @param entry perf_isr_enter() of the same pass (ignored unless it woke the core)
+ * @param latency_us Time from the event that woke it to the handler
+ */
+void perf_wake(uint32_t entry, uint32_t latency_us);
+
+/**
+ * @brief Core back from STOP (thread mode, interrupts masked)
+ *
+ * @param stop_us Time in STOP, 0 if no clock ran through it
+ */
+void perf_stop(uint32_t stop_us);
+
+/**
+ * @brief Get the counters
+ *
+ * @param stats Receives them (one consistent snapshot)
+ */
+void perf_get_stats(perf_stats_t *stats);
+
+/**
+ * @brief Start the longest handler times and the wake-up latencies over
+ *        (benchmark windows, bench.h)
+ */
+void perf_clear_wcet(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERF_H */
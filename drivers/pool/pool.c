@@ -0,0 +1,117 @@
+/**
+ * @file pool.c
+ * @brief Fixed-block memory pools implementation
+ * 
+ * Pools are shared between the main loop and handlers at several
+ * priorities, so the free list and counters are only touched masked. Each
+ * masked section is a pointer swap and two counter updates.
+ */
+
+#include "pool.h"
+#include "hal_atomic.h"
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+bool pool_init(pool_t *pool, uint32_t *storage, uint32_t block_size, uint32_t count)
+{
+    uint32_t primask;
+    uint32_t stride;
+    pool_block_t *free_list = NULL;
+    
+    if (pool == NULL || storage == NULL || count == 0U || count > UINT16_MAX) {
+        return false;
+    }
+    
+    stride = POOL_BLOCK_WORDS(block_size) * 4U;
+    
+    /* Link from the last block, so allocation starts at the first */
+    for (uint32_t i = count; i > 0U; i--) {
+        pool_block_t *block = (pool_block_t *)((uint8_t *)storage + (i - 1U) * stride);
+        
+        block->next = free_list;
+        free_list = block;
+    }
+    
+    primask = hal_crit_enter();
+    pool->free_list = free_list;
+    pool->base = (uint8_t *)storage;
+    pool->stride = stride;
+    pool->count = (uint16_t)count;
+    pool->used = 0;
+    pool->high_water = 0;
+    pool->failures = 0;
+    hal_crit_exit(primask);
+    
+    return true;
+}
+
+void *pool_alloc(pool_t *pool)
+{
+    pool_block_t *block;
+    uint32_t primask;
+    
+    if (pool == NULL) {
+        return NULL;
+    }
+    
+    primask = hal_crit_enter();
+    block = pool->free_list;
+    if (block != NULL) {
+        pool->free_list = block->next;
+        pool->used++;
+        if (pool->used > pool->high_water) {
+            pool->high_water = pool->used;
+        }
+    } else {
+        pool->failures++;
+    }
+    hal_crit_exit(primask);
+    
+    return block;
+}
+
+bool pool_free(pool_t *pool, void *block)
+{
+    pool_block_t *b = (pool_block_t *)block;
+    uint32_t offset;
+    uint32_t primask;
+    
+    if (pool == NULL || block == NULL || (uint8_t *)block < pool->base) {
+        return false;
+    }
+    
+    /* Must be the start of one of this pool's blocks */
+    offset = (uint32_t)((uint8_t *)block - pool->base);
+    if (offset >= (uint32_t)pool->count * pool->stride || (offset % pool->stride) != 0U) {
+        return false;
+    }
+    
+    primask = hal_crit_enter();
+    b->next = pool->free_list;
+    pool->free_list = b;
+    pool->used--;
+    hal_crit_exit(primask);
+    
+    return true;
+}
+
+bool pool_get_stats(const pool_t *pool, pool_stats_t *stats)
+{
+    uint32_t primask;
+    
+    if (pool == NULL || stats == NULL) {
+        return false;
+    }
+    
+    primask = hal_crit_enter();
+    stats->block_size = pool->stride;
+    stats->count = pool->count;
+    stats->used = pool->used;
+    stats->high_water = pool->high_water;
+    stats->failures = pool->failures;
+    hal_crit_exit(primask);
+    
+    return true;
+}
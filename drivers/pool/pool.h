@@ -0,0 +1,122 @@
+#ifndef POOL_H
+#define POOL_H
+
+/**
+ * @file pool.h
+ * @brief Fixed-block memory pools
+ * 
+ * A pool is a compile-time sized array of equal blocks in .bss, handed out
+ * and returned in O(1) through a free list threaded through the free
+ * blocks themselves. No fragmentation, no heap: a subsystem takes a block,
+ * fills it and passes the pointer on (zero-copy); whoever is done with it
+ * returns it.
+ * 
+ * Alloc and free are safe from any context, interrupts included: each is
+ * a few instructions under PRIMASK.
+ * 
+ * Usage:
+ *     POOL_STORAGE(frame_storage, 64U, 4U);
+ *     static pool_t frame_pool;
+ *     pool_init(&frame_pool, frame_storage, 64U, 4U);
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * MACROS
+ * ============================================================================ */
+
+/** Words per block: rounded up, and large enough for the free list link */
+#define POOL_BLOCK_WORDS(block_size) \
+    ((((block_size) + 3U) / 4U) > 0U ? (((block_size) + 3U) / 4U) : 1U)
+
+/** Declare word-aligned storage for count blocks of block_size bytes */
+#define POOL_STORAGE(name, block_size, count) \
+    static uint32_t name[(count) * POOL_BLOCK_WORDS(block_size)]
+
+/* ============================================================================
+ * TYPES
+ * ============================================================================ */
+
+/**
+ * @brief Free block (link stored in the block itself)
+ */
+typedef struct pool_block {
+    struct pool_block *next;
+} pool_block_t;
+
+/**
+ * @brief Pool (members private, use the functions)
+ */
+typedef struct {
+    pool_block_t *free_list;
+    uint8_t *base;
+    uint32_t stride;      /* Block size rounded to words, bytes */
+    uint16_t count;
+    uint16_t used;
+    uint16_t high_water;
+    uint32_t failures;
+} pool_t;
+
+/**
+ * @brief Pool statistics
+ */
+typedef struct {
+    uint32_t block_size;  /* Usable bytes per block (word-rounded) */
+    uint16_t count;       /* Blocks in the pool */
+    uint16_t used;        /* Blocks currently allocated */
+    uint16_t high_water;  /* Most blocks allocated at once since init */
+    uint32_t failures;    /* Allocations refused (pool empty) */
+} pool_stats_t;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Initialize a pool over its storage (all blocks free)
+ * 
+ * @param pool Pool to initialize
+ * @param storage Storage from POOL_STORAGE() with the same sizes
+ * @param block_size Bytes per block
+ * @param count Number of blocks (1..65535)
+ * @return true on success, false on bad parameters
+ */
+bool pool_init(pool_t *pool, uint32_t *storage, uint32_t block_size, uint32_t count);
+
+/**
+ * @brief Take a block
+ * 
+ * @param pool Pool
+ * @return Word-aligned block, or NULL if the pool is empty (counted)
+ */
+void *pool_alloc(pool_t *pool);
+
+/**
+ * @brief Return a block
+ * 
+ * @param pool Pool the block came from
+ * @param block Block from pool_alloc()
+ * @return true on success, false if block does not belong to the pool
+ */
+bool pool_free(pool_t *pool, void *block);
+
+/**
+ * @brief Get a consistent copy of the pool statistics
+ * 
+ * @param pool Pool
+ * @param stats Receives the statistics
+ * @return true on success, false on NULL arguments
+ */
+bool pool_get_stats(const pool_t *pool, pool_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* POOL_H */
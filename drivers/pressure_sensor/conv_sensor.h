@@ -0,0 +1,60 @@
+#ifndef CONV_SENSOR_H
+#define CONV_SENSOR_H
+
+/**
+ * @file conv_sensor.h
+ * @brief Conversion sensor interface driven by the sampling scheduler
+ *
+ * A conversion sensor measures a primary channel (pressure) and a
+ * secondary one (temperature) by command, wait and read: start a
+ * conversion at an oversampling level, wait its conversion time, read the
+ * raw result, then compensate a pair of raw results into the two outputs.
+ * app/sensor_sampling.c drives the cycle of any sensor through this table
+ * (sequential, pipelined and exact-timed modes, raw and sample rings), so
+ * another I2C sensor only supplies its operations. Bring-up (reset and
+ * calibration read) stays with the driver of each sensor.
+ *
+ * Every operation starts one asynchronous transfer on the transport and
+ * returns; `done` is called from the bus interrupt once it has finished.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ms58.h"  /* Transport handle, error codes, completion callback */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CONV_SENSOR_MAX_RESULT_BYTES  4U
+
+/**
+ * @brief Operations and timing of one sensor type
+ */
+typedef struct {
+    uint8_t osr_count;             /* Oversampling levels, 0 = fastest */
+    uint8_t result_bytes;          /* Raw result size, CONV_SENSOR_MAX_RESULT_BYTES at most */
+    const uint16_t *conv_time_us;  /* Worst-case conversion time per level (both channels) */
+
+    /* Start a conversion of the primary (true) or secondary channel */
+    ms583730ba01_err_t (*start)(const ms583730ba01_h *h, bool primary, uint8_t osr,
+                                ms583730ba01_done_cb_t done);
+    /* Command that precedes the result read (NULL if the result is read directly) */
+    ms583730ba01_err_t (*request)(const ms583730ba01_h *h, ms583730ba01_done_cb_t done);
+    /* Clock out result_bytes of the finished conversion */
+    ms583730ba01_err_t (*fetch)(const ms583730ba01_h *h, uint8_t *buf, ms583730ba01_done_cb_t done);
+    /* Raw result from the bytes read */
+    uint32_t (*decode)(const uint8_t *buf);
+    /* Outputs from a primary/secondary raw pair (interrupt context, no checks) */
+    void (*compensate)(const void *calib, uint32_t primary, uint32_t secondary,
+                       int32_t *pressure, int32_t *temperature);
+} conv_sensor_t;
+
+/* MS5837: D1 pressure, D2 temperature, OSR 256..8192, calib is ms5837_calib_t */
+extern const conv_sensor_t ms5837_conv_sensor;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONV_SENSOR_H */
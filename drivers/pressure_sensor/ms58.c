@@ -1,5 +1,8 @@
 #include "ms58.h"
+#include "conv_sensor.h"
 #include "ms58_regs.h"
+#include "board_config.h"  /* For RAMFUNC */
+#include "fixmath.h"       /* 32x32->64 products without __aeabi_lmul */
 #include <stdint.h>
 #include <limits.h>  /* For INT32_MAX, INT32_MIN */
 #include <stddef.h>  /* For NULL */
@@ -7,7 +10,7 @@
 
 // Reset the sensor
 ms583730ba01_err_t ms5837_reset(const ms583730ba01_h *h) {
-    ms583730ba01_err_t result = h->write_cmd(MS5837_RESET);
+    ms583730ba01_err_t result = h->write_cmd(h->ctx, MS5837_RESET);
     if (result != E_MS58370BA01_SUCCESS) {
         return result;  // Return if write failed
     }
@@ -16,34 +19,94 @@ ms583730ba01_err_t ms5837_reset(const ms583730ba01_h *h) {
 }
 
 //CRC-4 calculation function (based on the datasheet)
+// The CRC covers C0..C6 with the CRC nibble itself (C0[15:12]) masked out
+uint8_t ms5837_crc4(const uint16_t *calibration_data) {
+    uint16_t n_rem = 0;
 
+    for (int cnt = 0; cnt < 16; cnt++) {
+        uint16_t word = (cnt >> 1) < 7 ? calibration_data[cnt >> 1] : 0;  // C7 = 0
 
+        if ((cnt >> 1) == 0) {
+            word &= 0x0FFF;
+        }
+        n_rem ^= (cnt & 1) ? (word & 0x00FF) : (word >> 8);
+
+        for (int n_bit = 8; n_bit > 0; n_bit--) {
+            if (n_rem & 0x8000) {
+                n_rem = (uint16_t)((n_rem << 1) ^ 0x3000);
+            } else {
+                n_rem = (uint16_t)(n_rem << 1);
+            }
+        }
+    }
+    return (uint8_t)((n_rem >> 12) & 0x000F);
+}
+
+// Check the CRC-4 stored in the top nibble of C0
+bool ms5837_prom_crc_ok(const uint16_t *calibration_data) {
+    return ms5837_crc4(calibration_data) == (calibration_data[0] >> 12);
+}
+
+// Reject a part whose ID names the other variant; IDs not listed are
+// let through, the factory field is not documented in full
+bool ms5837_prom_variant_ok(const uint16_t *calibration_data) {
+    uint16_t id = MS5837_PROM_VARIANT(calibration_data[0]);
+
+#if BOARD_SENSOR_VARIANT == BOARD_SENSOR_VARIANT_30BA
+    return id != MS5837_ID_02BA01 && id != MS5837_ID_02BA21;
+#else
+    return id != MS5837_ID_30BA26;
+#endif
+}
+
+// Send a read command and read its reply: one transaction with a repeated
+// START if the transport has it, else a write and a read
+static ms583730ba01_err_t ms5837_command_read(const ms583730ba01_h *h, uint8_t cmd,
+                                              uint8_t *buf, uint32_t n) {
+    ms583730ba01_err_t result;
+
+    if (h->write_read != NULL) {
+        return h->write_read(h->ctx, cmd, buf, n);
+    }
+
+    result = h->write_cmd(h->ctx, cmd);
+    if (result != E_MS58370BA01_SUCCESS) {
+        return result;
+    }
+    return h->read_data(h->ctx, buf, n);
+}
+
+// Read one 16-bit PROM word
+ms583730ba01_err_t ms5837_read_prom_word(const ms583730ba01_h *h, uint8_t index, uint16_t *word) {
+    uint8_t data[2];
+    ms583730ba01_err_t result;
+
+    result = ms5837_command_read(h, MS5837_PROM_READ_BASE + (index * 2), data, 2);
+    if (result != E_MS58370BA01_SUCCESS) {
+        return result;
+    }
+
+    *word = (uint16_t)((data[0] << 8) | data[1]);
+    return E_MS58370BA01_SUCCESS;
+}
 
 // Read calibration data from PROM with CRC check
 ms583730ba01_err_t ms5837_read_prom(const ms583730ba01_h *h, uint16_t *calibration_data) {
-    uint8_t cmd;
-    uint8_t data[2];
     ms583730ba01_err_t result;
 
     for (int i = 0; i < 7; i++) {
-        cmd = MS5837_PROM_READ_BASE + (i * 2);
         //printk("Sending command 0x%X for coefficient %d\n", cmd, i);
-
-        result = h->write_cmd(cmd);
-        if (result != E_MS58370BA01_SUCCESS) {
-            //printk("Failed to send PROM read command for coefficient %d, error: %d\n", i, result);
-            return result;
-        }
-
-        result = h->read_data(data, 2);
+        result = ms5837_read_prom_word(h, (uint8_t)i, &calibration_data[i]);
         if (result != E_MS58370BA01_SUCCESS) {
             //printk("Failed to read PROM data for coefficient %d, error: %d\n", i, result);
             return result;
         }
-
-        calibration_data[i] = (data[0] << 8) | data[1];
         //printk("Coefficient C%d: %u\n", i, calibration_data[i]);
     }
+
+    if (!ms5837_prom_crc_ok(calibration_data)) {
+        return E_MS58370BA01_CRC_ERR;  // Corrupted coefficients: do not use
+    }
     return E_MS58370BA01_SUCCESS;
 }
 
@@ -53,37 +116,122 @@ ms583730ba01_err_t ms5837_read_prom(const ms583730ba01_h *h, uint16_t *calibrati
 
 // ADC read function
 ms583730ba01_err_t ms5837_read_adc(const ms583730ba01_h *h, uint32_t *data) {
-    uint8_t adc_data[3];
+    uint8_t adc_data[MS5837_ADC_BYTES];
     ms583730ba01_err_t result;
 
-    // Send ADC read command
-    result = h->write_cmd(MS5837_ADC_READ);
-    if (result != E_MS58370BA01_SUCCESS) {
-        return result;  // Return if write failed
-    }
-
-    // Read 3 bytes of ADC data
-    result = h->read_data(adc_data, 3);
+    // Send ADC read command, read 3 bytes of ADC data
+    result = ms5837_command_read(h, MS5837_ADC_READ, adc_data, MS5837_ADC_BYTES);
     if (result != E_MS58370BA01_SUCCESS) {
-        return result;  // Return if read failed
+        return result;  // Return if the transfer failed
     }
 
-    *data = ((uint32_t)adc_data[0] << 16) | ((uint32_t)adc_data[1] << 8) | adc_data[2];
+    *data = ms5837_adc_from_bytes(adc_data);
     return E_MS58370BA01_SUCCESS;
 }
 
 // Start conversion (pressure or temperature)
 ms583730ba01_err_t ms5837_start_conversion(const ms583730ba01_h *h, uint8_t cmd) {
-    return h->write_cmd(cmd);  // Send conversion command
+    return h->write_cmd(h->ctx, cmd);  // Send conversion command
+}
+
+// Assemble the 24-bit ADC result (MSB first)
+uint32_t ms5837_adc_from_bytes(const uint8_t *adc_buf) {
+    return ((uint32_t)adc_buf[0] << 16) | ((uint32_t)adc_buf[1] << 8) | adc_buf[2];
+}
+
+// Start conversion without blocking on the bus
+ms583730ba01_err_t ms5837_start_conversion_async(const ms583730ba01_h *h, uint8_t cmd,
+                                                 ms583730ba01_done_cb_t done) {
+    if (h->write_cmd_start == NULL) {
+        return E_MS58370BA01_CONFIG_ERR;  // Transport has no async support
+    }
+    return h->write_cmd_start(h->ctx, cmd, done, h->done_ctx);
+}
+
+// Send ADC read command without blocking on the bus
+ms583730ba01_err_t ms5837_request_adc_async(const ms583730ba01_h *h, ms583730ba01_done_cb_t done) {
+    if (h->write_cmd_start == NULL) {
+        return E_MS58370BA01_CONFIG_ERR;
+    }
+    return h->write_cmd_start(h->ctx, MS5837_ADC_READ, done, h->done_ctx);
+}
+
+// Receive ADC result bytes without blocking on the bus
+ms583730ba01_err_t ms5837_fetch_adc_async(const ms583730ba01_h *h, uint8_t *adc_buf,
+                                          ms583730ba01_done_cb_t done) {
+    if (h->read_data_start == NULL) {
+        return E_MS58370BA01_CONFIG_ERR;
+    }
+    if (adc_buf == NULL) {
+        return E_MS58370BA01_NULLPTR_ERR;
+    }
+    return h->read_data_start(h->ctx, adc_buf, MS5837_ADC_BYTES, done, h->done_ctx);
+}
+
+// Send ADC read command and receive the result in one transfer, without blocking
+ms583730ba01_err_t ms5837_read_adc_async(const ms583730ba01_h *h, uint8_t *adc_buf,
+                                         ms583730ba01_done_cb_t done) {
+    if (h->write_read_start == NULL) {
+        return E_MS58370BA01_CONFIG_ERR;
+    }
+    if (adc_buf == NULL) {
+        return E_MS58370BA01_NULLPTR_ERR;
+    }
+    return h->write_read_start(h->ctx, MS5837_ADC_READ, adc_buf, MS5837_ADC_BYTES, done, h->done_ctx);
+}
+
+// Send reset command without blocking on the bus (caller waits MS5837_RESET_TIME_US)
+ms583730ba01_err_t ms5837_reset_async(const ms583730ba01_h *h, ms583730ba01_done_cb_t done) {
+    if (h->write_cmd_start == NULL) {
+        return E_MS58370BA01_CONFIG_ERR;
+    }
+    return h->write_cmd_start(h->ctx, MS5837_RESET, done, h->done_ctx);
+}
+
+// Send PROM read command without blocking on the bus
+ms583730ba01_err_t ms5837_request_prom_async(const ms583730ba01_h *h, uint8_t index,
+                                             ms583730ba01_done_cb_t done) {
+    if (h->write_cmd_start == NULL) {
+        return E_MS58370BA01_CONFIG_ERR;
+    }
+    if (index >= 7) {
+        return E_MS58370BA01_CONFIG_ERR;
+    }
+    return h->write_cmd_start(h->ctx, MS5837_PROM_READ_BASE + (index * 2), done, h->done_ctx);
+}
+
+// Receive PROM word bytes without blocking on the bus
+ms583730ba01_err_t ms5837_fetch_prom_async(const ms583730ba01_h *h, uint8_t *prom_buf,
+                                           ms583730ba01_done_cb_t done) {
+    if (h->read_data_start == NULL) {
+        return E_MS58370BA01_CONFIG_ERR;
+    }
+    if (prom_buf == NULL) {
+        return E_MS58370BA01_NULLPTR_ERR;
+    }
+    return h->read_data_start(h->ctx, prom_buf, 2, done, h->done_ctx);
+}
+
+// Send PROM read command and receive the word in one transfer, without blocking
+ms583730ba01_err_t ms5837_read_prom_async(const ms583730ba01_h *h, uint8_t index, uint8_t *prom_buf,
+                                          ms583730ba01_done_cb_t done) {
+    if (h->write_read_start == NULL) {
+        return E_MS58370BA01_CONFIG_ERR;
+    }
+    if (index >= 7) {
+        return E_MS58370BA01_CONFIG_ERR;
+    }
+    if (prom_buf == NULL) {
+        return E_MS58370BA01_NULLPTR_ERR;
+    }
+    return h->write_read_start(h->ctx, MS5837_PROM_READ_BASE + (index * 2), prom_buf, 2, done, h->done_ctx);
 }
 
 ms583730ba01_err_t ms5837_read_temperature_and_pressure(
-    const ms583730ba01_h *h, uint16_t *calibration_data, int32_t *pressure, int32_t *temperature,
+    const ms583730ba01_h *h, const ms5837_calib_t *calib, int32_t *pressure, int32_t *temperature,
     int osr_d1, int osr_d2, uint16_t delay_d1, uint16_t delay_d2
 ) {
     uint32_t D1 = 0, D2 = 0;  // Raw ADC values
-    int32_t dT;               // Temperature difference
-    int64_t OFF, SENS, P;     // Intermediate calculations
     ms583730ba01_err_t result;
 
     // 1) Start pressure conversion (D1) with the specified oversampling ratio
@@ -112,88 +260,227 @@ ms583730ba01_err_t ms5837_read_temperature_and_pressure(
         return result;
     }
 
-    // 5) Calculate dT (difference between actual and reference temperature)
-    dT = (int32_t)D2 - ((int32_t)calibration_data[5] * 256);  // C5 * 2^8
-
-    // 6) Calculate temperature (TEMP)
-    *temperature = 2000 + ((int64_t)dT * calibration_data[6]) / 8388608;  // C6 / 2^23
-
-    // 7) Calculate OFF (Offset at actual temperature)
-    OFF = ((int64_t)calibration_data[2] * 131072)  // C2 * 2^17
-        + (((int64_t)calibration_data[4] * dT) / 64);  // C4 * dT / 2^6
-
-    // 8) Calculate SENS (Sensitivity at actual temperature)
-    SENS = ((int64_t)calibration_data[1] * 65536)  // C1 * 2^16
-         + (((int64_t)calibration_data[3] * dT) / 128);  // C3 * dT / 2^7
-
-    // 9) Calculate pressure (P)
-    P = ((((int64_t)D1 * SENS) / 2097152) - OFF) / 32768;  // (D1 * SENS / 2^21 - OFF) / 2^15
-    
-    // Overflow protection: Clamp pressure to int32_t range before casting
-    if (P > INT32_MAX) {
-        *pressure = INT32_MAX;
-    } else if (P < INT32_MIN) {
-        *pressure = INT32_MIN;
-    } else {
-        *pressure = (int32_t)P;  // Convert to mbar (pressure in 0.01 mbar resolution)
-    }
-    
-    // Overflow protection: Clamp temperature to int32_t range (shouldn't overflow, but safe)
-    // Note: *temperature is int32_t, so it can't be < INT32_MIN, only check upper bound
-    if (*temperature > INT32_MAX) {
-        *temperature = INT32_MAX;
-    }
-
-    return E_MS58370BA01_SUCCESS;
+    // 5) Compensate
+    return ms5837_calculate_pressure_temperature(calib, D1, D2, pressure, temperature);
 }
 
 // Calculate pressure and temperature from ADC values (calculation only)
 ms583730ba01_err_t ms5837_calculate_pressure_temperature(
-    const uint16_t *calibration_data,
+    const ms5837_calib_t *calib,
     uint32_t d1_pressure,
     uint32_t d2_temperature,
     int32_t *pressure,
     int32_t *temperature
 ) {
-    if (calibration_data == NULL || pressure == NULL || temperature == NULL) {
+    if (calib == NULL || pressure == NULL || temperature == NULL) {
         return E_MS58370BA01_NULLPTR_ERR;
     }
     
-    int32_t dT;               // Temperature difference
-    int64_t OFF, SENS, P;     // Intermediate calculations
-    
-    // Calculate dT (difference between actual and reference temperature)
-    dT = (int32_t)d2_temperature - ((int32_t)calibration_data[5] * 256);  // C5 * 2^8
-    
-    // Calculate temperature (TEMP)
-    *temperature = 2000 + ((int64_t)dT * calibration_data[6]) / 8388608;  // C6 / 2^23
-    
-    // Calculate OFF (Offset at actual temperature)
-    OFF = ((int64_t)calibration_data[2] * 131072)  // C2 * 2^17
-        + (((int64_t)calibration_data[4] * dT) / 64);  // C4 * dT / 2^6
-    
-    // Calculate SENS (Sensitivity at actual temperature)
-    SENS = ((int64_t)calibration_data[1] * 65536)  // C1 * 2^16
-         + (((int64_t)calibration_data[3] * dT) / 128);  // C3 * dT / 2^7
-    
-    // Calculate pressure (P)
-    P = ((((int64_t)d1_pressure * SENS) / 2097152) - OFF) / 32768;  // (D1 * SENS / 2^21 - OFF) / 2^15
-    
+    ms5837_compensate(calib, d1_pressure, d2_temperature, pressure, temperature);
+    return E_MS58370BA01_SUCCESS;
+}
+
+// Compensation constants of the variant built (datasheet first order):
+//   OFF  = C2 * 2^OFF_SHIFT + C4 * dT / 2^TCO_SHIFT
+//   SENS = C1 * 2^SENS_SHIFT + C3 * dT / 2^TCS_SHIFT
+//   P    = (D1 * SENS / 2^21 - OFF) / 2^P_SHIFT, times P_SCALE to 0.01 mbar
+#if BOARD_SENSOR_VARIANT == BOARD_SENSOR_VARIANT_30BA
+#define MS5837_OFF_SHIFT    16
+#define MS5837_SENS_SHIFT   15
+#define MS5837_TCO_SHIFT    7
+#define MS5837_TCS_SHIFT    8
+#define MS5837_P_SHIFT      13
+#define MS5837_P_SCALE      10
+#else
+#define MS5837_OFF_SHIFT    17
+#define MS5837_SENS_SHIFT   16
+#define MS5837_TCO_SHIFT    6
+#define MS5837_TCS_SHIFT    7
+#define MS5837_P_SHIFT      15
+#define MS5837_P_SCALE      1
+#endif
+
+// Read the PROM and build the calibration context in one go
+ms583730ba01_err_t ms5837_load_calibration(const ms583730ba01_h *h, ms5837_calib_t *calib) {
+    uint16_t calibration_data[7];
+    ms583730ba01_err_t result = ms5837_read_prom(h, calibration_data);
+
+    if (result != E_MS58370BA01_SUCCESS) {
+        return result;
+    }
+    return ms5837_calib_prepare(calibration_data, calib);
+}
+
+// Precompute the shifted calibration terms (once, at load time)
+ms583730ba01_err_t ms5837_calib_prepare(const uint16_t *calibration_data, ms5837_calib_t *calib) {
+    if (calibration_data == NULL || calib == NULL) {
+        return E_MS58370BA01_NULLPTR_ERR;
+    }
+    if (!ms5837_prom_variant_ok(calibration_data)) {
+        return E_MS58370BA01_CONFIG_ERR;  // Built for the other variant
+    }
+
+    calib->sens_base = (int64_t)calibration_data[1] << MS5837_SENS_SHIFT;
+    calib->off_base = (int64_t)calibration_data[2] << MS5837_OFF_SHIFT;
+    calib->t_ref = (int32_t)calibration_data[5] << 8;       // C5 * 2^8
+    calib->c3 = calibration_data[3];
+    calib->c4 = calibration_data[4];
+    calib->c6 = calibration_data[6];
+    calib->second_order = false;
+
+    return E_MS58370BA01_SUCCESS;
+}
+
+void ms5837_calib_set_second_order(ms5837_calib_t *calib, bool enable) {
+    if (calib != NULL) {
+        calib->second_order = enable;
+    }
+}
+
+// Temperature-dependent terms of one D2 value, shared by every D1 paired with it
+typedef struct {
+    int32_t temp;   // TEMP (0.01°C), second-order corrected if enabled
+    int64_t off;    // OFF
+    int64_t sens;   // SENS
+} ms5837_temp_terms_t;
+
+#if BOARD_SENSOR_VARIANT == BOARD_SENSOR_VARIANT_30BA
+// Second order (30BA datasheet), ranges by first-order TEMP:
+//   >= 20°C: Ti = 2*dT^2/2^37, OFFi = (TEMP-2000)^2/2^4, SENSi = 0
+//   <  20°C: Ti = 3*dT^2/2^33, OFFi = 3*(TEMP-2000)^2/2, SENSi = 5*(TEMP-2000)^2/2^3
+//   < -15°C: plus OFFi += 7*(TEMP+1500)^2, SENSi += 4*(TEMP+1500)^2
+// Squares are non-negative, so plain shifts round the same as '/'.
+// The range selects are masks instead of branches
+static inline void ms5837_second_order(int32_t dT, int32_t *TEMP, int64_t *OFF, int64_t *SENS) {
+    int32_t t = *TEMP - 2000;
+    int32_t u = *TEMP + 1500;
+    int64_t low = (int64_t)(t >> 31);       // All ones if TEMP < 2000, else 0
+    int64_t very_low = (int64_t)(u >> 31);  // All ones if TEMP < -1500, else 0
+    int64_t d2 = fixmath_smull(dT, dT);
+    int64_t t2 = fixmath_smull(t, t);
+    int64_t u2 = fixmath_smull(u, u);
+
+    *TEMP -= (int32_t)((((d2 * 3) >> 33) & low) | (((d2 * 2) >> 37) & ~low));
+    *OFF -= (((t2 * 3) >> 1) & low) | ((t2 >> 4) & ~low);
+    *OFF -= (u2 * 7) & very_low;
+    *SENS -= ((t2 * 5) >> 3) & low;
+    *SENS -= (u2 * 4) & very_low;
+}
+#else
+// Second order (02BA datasheet), low temperature only (TEMP < 20°C):
+// Ti = 11*dT^2/2^35, OFFi = 31*(TEMP-2000)^2/2^3, SENSi = 63*(TEMP-2000)^2/2^5
+// Squares are non-negative, so plain shifts round the same as '/'.
+// The range select is a mask instead of a branch
+static inline void ms5837_second_order(int32_t dT, int32_t *TEMP, int64_t *OFF, int64_t *SENS) {
+    int32_t t = *TEMP - 2000;
+    int64_t low = (int64_t)(t >> 31);  // All ones if TEMP < 2000, else 0
+    int64_t t2 = fixmath_smull(t, t);
+
+    *TEMP -= (int32_t)(((fixmath_smull(dT, dT) * 11) >> 35) & low);
+    *OFF -= ((t2 * 31) >> 3) & low;
+    *SENS -= ((t2 * 63) >> 5) & low;
+}
+#endif
+
+// First-order temperature stage (datasheet): divisions by 2^n done as shifts
+// (fixmath_div_pow2(), rounding towards zero like C '/'), optional
+// second-order correction
+static inline void ms5837_temp_stage(const ms5837_calib_t *calib, uint32_t d2_temperature,
+                                     ms5837_temp_terms_t *terms) {
+    // dT fits in 25 bits (D2 and C5*2^8 are 24-bit), so the products here are
+    // 32x32->64 (fixmath_smull()); D1*SENS in the pressure stage is 64x32
+    int32_t dT = (int32_t)d2_temperature - calib->t_ref;
+    int32_t TEMP = 2000 + (int32_t)fixmath_div_pow2(fixmath_smull(dT, calib->c6), 23);
+    int64_t OFF = calib->off_base + fixmath_div_pow2(fixmath_smull(calib->c4, dT), MS5837_TCO_SHIFT);
+    int64_t SENS = calib->sens_base + fixmath_div_pow2(fixmath_smull(calib->c3, dT), MS5837_TCS_SHIFT);
+
+    if (calib->second_order) {
+        ms5837_second_order(dT, &TEMP, &OFF, &SENS);
+    }
+
+    terms->temp = TEMP;
+    terms->off = OFF;
+    terms->sens = SENS;
+}
+
+// Pressure stage: one 32x64 multiply and two shifts per D1 (and a constant
+// scale for the 30BA)
+static inline int32_t ms5837_pressure_stage(const ms5837_temp_terms_t *terms, uint32_t d1_pressure) {
+    int64_t P = fixmath_div_pow2(fixmath_div_pow2(fixmath_mul_s64_u32(terms->sens, d1_pressure), 21) -
+                                 terms->off, MS5837_P_SHIFT) * MS5837_P_SCALE;
+
     // Overflow protection: Clamp pressure to int32_t range before casting
     if (P > INT32_MAX) {
-        *pressure = INT32_MAX;
+        return INT32_MAX;
     } else if (P < INT32_MIN) {
-        *pressure = INT32_MIN;
-    } else {
-        *pressure = (int32_t)P;  // Convert to mbar (pressure in 0.01 mbar resolution)
+        return INT32_MIN;
     }
-    
-    // Overflow protection: Clamp temperature to int32_t range (shouldn't overflow, but safe)
-    // Note: *temperature is int32_t, so it can't be < INT32_MIN, only check upper bound
-    if (*temperature > INT32_MAX) {
-        *temperature = INT32_MAX;
+    return (int32_t)P;
+}
+
+RAMFUNC void ms5837_compensate(const ms5837_calib_t *calib, uint32_t d1_pressure, uint32_t d2_temperature,
+                               int32_t *pressure, int32_t *temperature) {
+    ms5837_temp_terms_t terms;
+
+    ms5837_temp_stage(calib, d2_temperature, &terms);
+    *temperature = terms.temp;
+    *pressure = ms5837_pressure_stage(&terms, d1_pressure);
+}
+
+// Batched compensation: checks once per call, temperature stage only when D2 changes
+ms583730ba01_err_t ms5837_compensate_batch(const ms5837_calib_t *calib, const uint32_t *d1,
+                                           const uint32_t *d2, int32_t *pressure,
+                                           int32_t *temperature, uint32_t n) {
+    ms5837_temp_terms_t terms;
+    uint32_t last_d2;
+
+    if (n == 0) {
+        return E_MS58370BA01_SUCCESS;
     }
-    
+    if (calib == NULL || d1 == NULL || d2 == NULL || pressure == NULL || temperature == NULL) {
+        return E_MS58370BA01_NULLPTR_ERR;
+    }
+
+    last_d2 = d2[0];
+    ms5837_temp_stage(calib, last_d2, &terms);
+
+    for (uint32_t i = 0; i < n; i++) {
+        if (d2[i] != last_d2) {
+            last_d2 = d2[i];
+            ms5837_temp_stage(calib, last_d2, &terms);
+        }
+        temperature[i] = terms.temp;
+        pressure[i] = ms5837_pressure_stage(&terms, d1[i]);
+    }
+
     return E_MS58370BA01_SUCCESS;
 }
 
+// Conversion sensor operations (conv_sensor.h): commands step by 2 per OSR
+static const uint16_t ms5837_conv_time_us[] = {
+    MS5837_CONV_TIME_US_256, MS5837_CONV_TIME_US_512, MS5837_CONV_TIME_US_1024,
+    MS5837_CONV_TIME_US_2048, MS5837_CONV_TIME_US_4096, MS5837_CONV_TIME_US_8192
+};
+
+static ms583730ba01_err_t ms5837_conv_start(const ms583730ba01_h *h, bool primary, uint8_t osr,
+                                            ms583730ba01_done_cb_t done) {
+    uint8_t cmd = primary ? MS5837_CONVERT_D1_256 : MS5837_CONVERT_D2_256;
+
+    return ms5837_start_conversion_async(h, (uint8_t)(cmd + 2U * osr), done);
+}
+
+static RAMFUNC void ms5837_conv_compensate(const void *calib, uint32_t primary, uint32_t secondary,
+                                           int32_t *pressure, int32_t *temperature) {
+    ms5837_compensate((const ms5837_calib_t *)calib, primary, secondary, pressure, temperature);
+}
+
+const conv_sensor_t ms5837_conv_sensor = {
+    .osr_count = (uint8_t)(sizeof(ms5837_conv_time_us) / sizeof(ms5837_conv_time_us[0])),
+    .result_bytes = MS5837_ADC_BYTES,
+    .conv_time_us = ms5837_conv_time_us,
+    .start = ms5837_conv_start,
+    .request = NULL,  /* Command and result in one transfer */
+    .fetch = ms5837_read_adc_async,
+    .decode = ms5837_adc_from_bytes,
+    .compensate = ms5837_conv_compensate,
+};
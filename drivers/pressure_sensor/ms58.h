@@ -15,35 +15,194 @@ typedef enum {
     E_MS58370BA01_COM_ERR = (1 << 1),     //!< Communication error
     E_MS58370BA01_CONFIG_ERR = (1 << 2),  //!< Configuration error
     E_MS58370BA01_ERR = (1 << 3),         //!< Other error
+    E_MS58370BA01_BUSY_ERR = (1 << 4),    //!< Transport busy (async transfer in flight)
+    E_MS58370BA01_CRC_ERR = (1 << 5),     //!< PROM CRC-4 mismatch
 } ms583730ba01_err_t;
 
 #define MS5837_ADDR               0x76  // I2C address of the MS5837 sensor
 
-// Function pointer structure for I2C communication
+// Completion callback for asynchronous transfers (called from interrupt
+// context), with the `done_ctx` of the handle that started the transfer
+typedef void (*ms583730ba01_done_cb_t)(void *ctx, ms583730ba01_err_t result);
+
+// Function pointer structure for I2C communication. `ctx` is passed back to
+// every transport call unchanged (bus handle, device address, ...), so one
+// transport implementation can serve several sensor instances. `done_ctx`
+// belongs to the user of the handle (its sampler instance): the async calls
+// hand it to the transport, which passes it to `done`
 typedef struct {
-    ms583730ba01_err_t (*write_cmd)(uint8_t cmd);
-    ms583730ba01_err_t (*read_data)(uint8_t *buf, uint32_t n);
+    void *ctx;
+    void *done_ctx;
+    ms583730ba01_err_t (*write_cmd)(void *ctx, uint8_t cmd);
+    ms583730ba01_err_t (*read_data)(void *ctx, uint8_t *buf, uint32_t n);
     void (*delay)(uint16_t ms);
+    // Optional non-blocking transport: start the transfer and return at once,
+    // `done` is called when the bus transfer has finished (NULL if unsupported)
+    ms583730ba01_err_t (*write_cmd_start)(void *ctx, uint8_t cmd, ms583730ba01_done_cb_t done,
+                                          void *done_ctx);
+    ms583730ba01_err_t (*read_data_start)(void *ctx, uint8_t *buf, uint32_t n,
+                                          ms583730ba01_done_cb_t done, void *done_ctx);
+    // Optional combined transfer: send `cmd`, then read `n` bytes after a
+    // repeated START, one START/address/STOP less than write_cmd + read_data
+    // (NULL if unsupported: the blocking reads fall back to the two calls)
+    ms583730ba01_err_t (*write_read)(void *ctx, uint8_t cmd, uint8_t *buf, uint32_t n);
+    ms583730ba01_err_t (*write_read_start)(void *ctx, uint8_t cmd, uint8_t *buf, uint32_t n,
+                                           ms583730ba01_done_cb_t done, void *done_ctx);
 } ms583730ba01_h;
 
+#define MS5837_ADC_BYTES          3     // ADC result size in bytes
+
+// Variant ID in PROM word 0, bits [11:5]
+#define MS5837_PROM_VARIANT(c0)   (((c0) >> 5) & 0x7F)
+#define MS5837_ID_02BA01          0x00
+#define MS5837_ID_02BA21          0x15
+#define MS5837_ID_30BA26          0x1A
+
+// Calibration context: terms precomputed once from the PROM coefficients,
+// so the per-sample compensation needs no shifts of C1/C2/C5 and no
+// divisions. One per sensor instance (36 bytes)
+typedef struct {
+    int64_t sens_base;   // C1 * 2^15 (30BA) or 2^16 (02BA)
+    int64_t off_base;    // C2 * 2^16 (30BA) or 2^17 (02BA)
+    int32_t t_ref;       // C5 * 2^8
+    int32_t c3;          // TCS
+    int32_t c4;          // TCO
+    int32_t c6;          // TEMPSENS
+    bool second_order;   // Apply low-temperature second-order correction
+} ms5837_calib_t;
+
 // Function prototypes
  //delay is platform specific and must be implemented same as i2c read/write
 ms583730ba01_err_t ms5837_reset(const ms583730ba01_h *h);
-ms583730ba01_err_t ms5837_read_prom(const ms583730ba01_h *h, uint16_t *calibration_data);
+ms583730ba01_err_t ms5837_read_prom(const ms583730ba01_h *h, uint16_t *calibration_data);  // CRC-4 checked
+ms583730ba01_err_t ms5837_read_prom_word(const ms583730ba01_h *h, uint8_t index, uint16_t *word);
+uint8_t ms5837_crc4(const uint16_t *calibration_data);          // CRC-4 over C0..C6 (datasheet)
+bool ms5837_prom_crc_ok(const uint16_t *calibration_data);      // CRC-4 matches C0[15:12]
+bool ms5837_prom_variant_ok(const uint16_t *calibration_data);  // C0 ID not the other variant
 ms583730ba01_err_t ms5837_start_conversion(const ms583730ba01_h *h, uint8_t cmd);
 ms583730ba01_err_t ms5837_read_adc(const ms583730ba01_h *h, uint32_t *data);
 ms583730ba01_err_t ms5837_read_temperature_and_pressure(
-    const ms583730ba01_h *h, uint16_t *calibration_data, int32_t *pressure, int32_t *temperature,
+    const ms583730ba01_h *h, const ms5837_calib_t *calib, int32_t *pressure, int32_t *temperature,
     int osr_d1, int osr_d2, uint16_t delay_d1, uint16_t delay_d2
 );
 
+/**
+ * @brief Start a conversion without waiting for the bus transfer
+ * 
+ * @param h Driver handle (must provide write_cmd_start)
+ * @param cmd Conversion command (MS5837_CONVERT_Dx_yyy)
+ * @param done Called from interrupt context once the command has been sent
+ * @return ms583730ba01_err_t Error code for starting the transfer
+ */
+ms583730ba01_err_t ms5837_start_conversion_async(const ms583730ba01_h *h, uint8_t cmd,
+                                                 ms583730ba01_done_cb_t done);
+
+/**
+ * @brief Send the ADC read command without waiting for the bus transfer
+ * 
+ * First half of an asynchronous ADC read. When `done` reports success,
+ * call ms5837_fetch_adc_async() to clock out the result bytes.
+ * 
+ * @param h Driver handle (must provide write_cmd_start)
+ * @param done Called from interrupt context once the command has been sent
+ * @return ms583730ba01_err_t Error code for starting the transfer
+ */
+ms583730ba01_err_t ms5837_request_adc_async(const ms583730ba01_h *h, ms583730ba01_done_cb_t done);
+
+/**
+ * @brief Receive the ADC result bytes without waiting for the bus transfer
+ * 
+ * Second half of an asynchronous ADC read. The buffer must stay valid until
+ * `done` is called; convert it with ms5837_adc_from_bytes().
+ * 
+ * @param h Driver handle (must provide read_data_start)
+ * @param adc_buf Buffer of MS5837_ADC_BYTES bytes
+ * @param done Called from interrupt context once the bytes have been received
+ * @return ms583730ba01_err_t Error code for starting the transfer
+ */
+ms583730ba01_err_t ms5837_fetch_adc_async(const ms583730ba01_h *h, uint8_t *adc_buf,
+                                          ms583730ba01_done_cb_t done);
+
+/**
+ * @brief Read the ADC result in one transfer without waiting for the bus
+ * 
+ * Sends the ADC read command and clocks out the result after a repeated
+ * START. The buffer must stay valid until `done` is called; convert it
+ * with ms5837_adc_from_bytes().
+ * 
+ * @param h Driver handle (must provide write_read_start)
+ * @param adc_buf Buffer of MS5837_ADC_BYTES bytes
+ * @param done Called from interrupt context once the bytes have been received
+ * @return ms583730ba01_err_t Error code for starting the transfer
+ */
+ms583730ba01_err_t ms5837_read_adc_async(const ms583730ba01_h *h, uint8_t *adc_buf,
+                                         ms583730ba01_done_cb_t done);
+
+/**
+ * @brief Send the reset command without waiting for the bus transfer
+ * 
+ * The sensor reloads its PROM after the command: wait at least
+ * MS5837_RESET_TIME_US after `done` before the next command.
+ * 
+ * @param h Driver handle (must provide write_cmd_start)
+ * @param done Called from interrupt context once the command has been sent
+ * @return ms583730ba01_err_t Error code for starting the transfer
+ */
+ms583730ba01_err_t ms5837_reset_async(const ms583730ba01_h *h, ms583730ba01_done_cb_t done);
+
+/**
+ * @brief Send a PROM read command without waiting for the bus transfer
+ * 
+ * First half of an asynchronous PROM word read; follow with
+ * ms5837_fetch_prom_async().
+ * 
+ * @param h Driver handle (must provide write_cmd_start)
+ * @param index PROM word index (0..6)
+ * @param done Called from interrupt context once the command has been sent
+ * @return ms583730ba01_err_t Error code for starting the transfer
+ */
+ms583730ba01_err_t ms5837_request_prom_async(const ms583730ba01_h *h, uint8_t index,
+                                             ms583730ba01_done_cb_t done);
+
+/**
+ * @brief Receive a PROM word without waiting for the bus transfer
+ * 
+ * @param h Driver handle (must provide read_data_start)
+ * @param prom_buf Buffer of 2 bytes (MSB first), valid until `done`
+ * @param done Called from interrupt context once the bytes have been received
+ * @return ms583730ba01_err_t Error code for starting the transfer
+ */
+ms583730ba01_err_t ms5837_fetch_prom_async(const ms583730ba01_h *h, uint8_t *prom_buf,
+                                           ms583730ba01_done_cb_t done);
+
+/**
+ * @brief Read a PROM word in one transfer without waiting for the bus
+ * 
+ * @param h Driver handle (must provide write_read_start)
+ * @param index PROM word index (0..6)
+ * @param prom_buf Buffer of 2 bytes (MSB first), valid until `done`
+ * @param done Called from interrupt context once the bytes have been received
+ * @return ms583730ba01_err_t Error code for starting the transfer
+ */
+ms583730ba01_err_t ms5837_read_prom_async(const ms583730ba01_h *h, uint8_t index, uint8_t *prom_buf,
+                                          ms583730ba01_done_cb_t done);
+
+/**
+ * @brief Convert raw ADC result bytes (MSB first) to a 24-bit value
+ * 
+ * @param adc_buf Buffer of MS5837_ADC_BYTES bytes
+ * @return uint32_t Raw D1/D2 value
+ */
+uint32_t ms5837_adc_from_bytes(const uint8_t *adc_buf);
+
 /**
  * @brief Calculate pressure and temperature from ADC values
  * 
  * This function performs the calculation only, using pre-read ADC values.
- * Use this when you've already read D1 and D2 separately.
+ * Use this when you've already read D1 and D2 separately. Same as
+ * ms5837_compensate() with argument checks.
  * 
- * @param calibration_data Calibration coefficients from PROM (7 values)
+ * @param calib Calibration context from ms5837_load_calibration()
  * @param d1_pressure Raw pressure ADC value (D1)
  * @param d2_temperature Raw temperature ADC value (D2)
  * @param pressure Calculated pressure output (0.01 mbar resolution)
@@ -51,11 +210,85 @@ ms583730ba01_err_t ms5837_read_temperature_and_pressure(
  * @return ms583730ba01_err_t Error code
  */
 ms583730ba01_err_t ms5837_calculate_pressure_temperature(
-    const uint16_t *calibration_data,
+    const ms5837_calib_t *calib,
     uint32_t d1_pressure,
     uint32_t d2_temperature,
     int32_t *pressure,
     int32_t *temperature
 );
 
+/**
+ * @brief Enable or disable second-order temperature compensation
+ * 
+ * @param calib Calibration context
+ * @param enable true to correct readings below 20°C (datasheet 2nd order)
+ */
+void ms5837_calib_set_second_order(ms5837_calib_t *calib, bool enable);
+
+/**
+ * @brief Read the PROM and build the calibration context
+ * 
+ * @param h Driver handle
+ * @param calib Calibration context to fill
+ * @return ms583730ba01_err_t Error code
+ */
+ms583730ba01_err_t ms5837_load_calibration(const ms583730ba01_h *h, ms5837_calib_t *calib);
+
+/**
+ * @brief Precompute calibration terms from raw PROM coefficients
+ * 
+ * Terms are shifted for the variant built (BOARD_SENSOR_VARIANT).
+ * 
+ * @param calibration_data Calibration coefficients from PROM (7 values)
+ * @param calib Calibration context to fill
+ * @return ms583730ba01_err_t Error code, E_MS58370BA01_CONFIG_ERR if the
+ *         variant ID in C0 names the other variant
+ */
+ms583730ba01_err_t ms5837_calib_prepare(const uint16_t *calibration_data, ms5837_calib_t *calib);
+
+/**
+ * @brief Fixed-cost compensation
+ * 
+ * Every datasheet division by 2^n is an arithmetic shift with truncation
+ * towards zero (bit-exact with C '/'), and the only 64-bit operations are
+ * multiplies. Meant for interrupt context: no argument checks, all
+ * pointers must be valid.
+ * 
+ * The kernel of the variant built (BOARD_SENSOR_VARIANT) is the only one
+ * compiled: 30BA results (0.1 mbar native) are scaled to 0.01 mbar.
+ * 
+ * With calib->second_order set, the datasheet second-order correction
+ * (Ti/OFFi/SENSi) is applied branch-free, the temperature ranges selected
+ * by masks: 3 extra multiplies (02BA, below 20°C only) or 5 (30BA, above
+ * 20°C, below and below -15°C).
+ * 
+ * @param calib Calibration context from ms5837_calib_prepare()
+ * @param d1_pressure Raw pressure ADC value (D1)
+ * @param d2_temperature Raw temperature ADC value (D2)
+ * @param pressure Calculated pressure output (0.01 mbar resolution)
+ * @param temperature Calculated temperature output (0.01°C resolution)
+ */
+void ms5837_compensate(const ms5837_calib_t *calib, uint32_t d1_pressure, uint32_t d2_temperature,
+                       int32_t *pressure, int32_t *temperature);
+
+/**
+ * @brief Compensate an array of raw D1/D2 pairs
+ * 
+ * Same results as ms5837_compensate() on every pair. Arguments are checked
+ * once per call, and the temperature stage (dT, TEMP, OFF, SENS and the
+ * second-order terms) only runs when D2 differs from the previous pair, so
+ * buffers from temperature-decimated capture cost one multiply per sample.
+ * 
+ * @param calib Calibration context from ms5837_calib_prepare()
+ * @param d1 Raw pressure ADC values (n entries)
+ * @param d2 Raw temperature ADC values (n entries)
+ * @param pressure Pressure outputs (n entries, 0.01 mbar resolution)
+ * @param temperature Temperature outputs (n entries, 0.01°C resolution)
+ * @param n Number of pairs
+ * @return ms583730ba01_err_t Error code
+ */
+ms583730ba01_err_t ms5837_compensate_batch(const ms5837_calib_t *calib, const uint32_t *d1,
+                                           const uint32_t *d2, int32_t *pressure,
+                                           int32_t *temperature, uint32_t n);
+
 #endif // MS5837_H
@@ -5,36 +5,226 @@
  * This file provides platform-specific I2C communication functions that
  * bridge STM32 HAL to the portable MS5837 driver. This allows the ms58.c
  * driver to remain platform-independent.
+ *
+ * Every handle carries an ms58_hal_dev_t context (I2C peripheral + device
+ * address), so any number of sensors on any I2C master share this code.
+ *
+ * Two transports are provided per device:
+ * - Blocking (write_cmd/read_data/write_read): used during initialization
+ * - Interrupt-driven (write_cmd_start/read_data_start): used by the sampling
+ *   state machine so the TIM2 ISR only starts a transfer and returns. One
+ *   transfer is on the wire per bus; transfers started meanwhile wait in
+ *   the bus queue and the bus interrupt starts each one as the previous
+ *   completes. Completion is reported from that bus's I2C interrupt. With
+ *   BOARD_LL_HOTPATH the transfer is driven
+ *   from the I2C registers (ms58_hal_ll_irq_handler()) rather than the
+ *   HAL IT state machine; the handle state and error code are kept as
+ *   HAL would, so the blocking transports and bus recovery see no
+ *   difference.
+ *
+ * The same transports reach the TCA9548 mux (ms58_hal_mux_select*()), which
+ * routes the bus to one of up to 8 sensors sharing the MS5837 address.
+ *
+ * write_read sends a read command and clocks out its reply after a
+ * repeated START (HAL_I2C_Mem_Read() with the command as an 8-bit memory
+ * address), one START, address byte and STOP less per ADC or PROM read.
+ *
+ * ms58_hal_submit() queues a chain of transfers at once (mux select, ADC
+ * read, next conversion) with one completion at its end, so a multi-probe
+ * scan keeps the bus busy from interrupt to interrupt with no callback in
+ * between. Chain ends complete in queue order.
+ *
+ * The time each bus has asynchronous transfers on the wire, from the
+ * first one on an idle bus to the queue running dry, is kept on the
+ * microsecond timebase (ms58_hal_get_active_us()). With
+ * BOARD_SENSOR_BUS_CLOCK_GATE the bus clock follows the same span: gated
+ * when the queue runs dry, restored when a transfer is queued on the idle
+ * bus and before every blocking transfer.
  */
 
-#include "ms58.h"
+#include "ms58_hal_wrapper.h"
 #include "ms58_regs.h"
 #include "board_config.h"
 #include "board_init.h"
+#include "probe.h"
+#include "prof.h"
+#include "timebase.h"
 #include "stm32l0xx_hal.h"
+#include "hal_atomic.h"
+#include "hal_config.h"  /* For hal_i2c_bus_clock() */
+#if BOARD_LL_HOTPATH
+#include "stm32l0xx_ll_i2c.h"
+#endif
 
-/* External I2C handle for pressure sensor */
-extern I2C_HandleTypeDef hi2c2;
+/* ============================================================================
+ * Asynchronous Transfer State
+ * ============================================================================ */
+
+/* I2C peripherals that can carry sensors at the same time */
+#define MS58_HAL_MAX_BUSES      2U
+
+#define MS58_HAL_QUEUE_MASK     (MS58_HAL_QUEUE_DEPTH - 1U)
+
+#if (MS58_HAL_QUEUE_DEPTH & MS58_HAL_QUEUE_MASK) != 0U
+#error "MS58_HAL_QUEUE_DEPTH must be a power of 2"
+#endif
+
+/**
+ * @brief One asynchronous transfer slot per I2C peripheral
+ * 
+ * Devices on the same bus share the slot, so only one transfer is on the
+ * wire per bus whichever instance started it; the others wait in queue.
+ * The queue changes with interrupts masked (submitters) or from the bus
+ * interrupt (the engine).
+ */
+struct ms58_hal_bus {
+    I2C_HandleTypeDef *hi2c;                 /* NULL while the slot is unused */
+    volatile bool busy;                      /* cur is on the wire */
+    ms58_hal_xfer_t cur;                     /* cur.cmd must outlive the IT transfer */
+    ms58_hal_xfer_t queue[MS58_HAL_QUEUE_DEPTH];  /* Waiting, queue_first starts next */
+    uint8_t queue_first;
+    volatile uint8_t queue_count;
+    bool active;                             /* Transfers on the wire since active_since_us */
+    uint32_t active_since_us;
+    uint32_t active_us;                      /* Before that (wraps) */
+#if BOARD_LL_HOTPATH
+    uint8_t *buf;                            /* Next byte to send / receive */
+    uint32_t remaining;                      /* Bytes left of the transfer */
+    uint32_t restart_n;                      /* Bytes to read after the repeated START */
+    uint8_t addr;                            /* Device of the transfer */
+#endif
+};
+
+#if BOARD_LL_HOTPATH
+/* Interrupts of a register-level transfer (one vector on STM32L0) */
+#define MS58_HAL_LL_IT  (I2C_CR1_TXIE | I2C_CR1_RXIE | I2C_CR1_STOPIE | \
+                         I2C_CR1_TCIE | I2C_CR1_NACKIE | I2C_CR1_ERRIE)
+/* NBYTES is 8 bits; AUTOEND needs the whole transfer in one go */
+#define MS58_HAL_LL_MAX_BYTES  255U
+#endif
+
+static ms58_hal_bus_t buses[MS58_HAL_MAX_BUSES];
+
+/**
+ * @brief Find (or claim) the transfer slot of an I2C peripheral
+ * 
+ * @param hi2c I2C handle
+ * @param claim true to take a free slot if the bus has none yet
+ * @return Slot, or NULL if not found / no slot left
+ */
+static ms58_hal_bus_t *ms58_hal_bus_lookup(I2C_HandleTypeDef *hi2c, bool claim)
+{
+    for (uint32_t i = 0; i < MS58_HAL_MAX_BUSES; i++) {
+        if (buses[i].hi2c == hi2c) {
+            return &buses[i];
+        }
+    }
+    
+    if (!claim) {
+        return NULL;
+    }
+    
+    for (uint32_t i = 0; i < MS58_HAL_MAX_BUSES; i++) {
+        if (buses[i].hi2c == NULL) {
+            buses[i].hi2c = hi2c;
+            buses[i].busy = false;
+            buses[i].queue_count = 0;
+            return &buses[i];
+        }
+    }
+    
+    return NULL;
+}
+
+#if BOARD_LL_HOTPATH
+/**
+ * @brief Start a register-level transfer (START, address, n bytes, STOP)
+ * 
+ * The handle goes BUSY_TX / BUSY_RX as with the HAL IT functions, so a
+ * HAL call on the bus in the meantime returns HAL_BUSY. With
+ * bus->restart_n set the write ends without STOP, and the interrupt
+ * handler reads restart_n bytes into bus->cur.buf after a repeated START.
+ * 
+ * @param bus Transfer slot of the bus (done already set)
+ * @param addr 7-bit device address
+ * @param buf Bytes to send / receive buffer
+ * @param n Number of bytes (1 .. MS58_HAL_LL_MAX_BYTES)
+ * @param read true for a master read
+ * @return true if started
+ */
+static bool ms58_hal_ll_start(ms58_hal_bus_t *bus, uint8_t addr, uint8_t *buf,
+                              uint32_t n, bool read)
+{
+    I2C_HandleTypeDef *hi2c = bus->hi2c;
+    I2C_TypeDef *i2c = hi2c->Instance;
+    
+    if (n == 0U || n > MS58_HAL_LL_MAX_BYTES ||
+        hi2c->State != HAL_I2C_STATE_READY || LL_I2C_IsActiveFlag_BUSY(i2c)) {
+        return false;
+    }
+    
+    bus->buf = buf;
+    bus->remaining = n;
+    bus->addr = addr;
+    hi2c->State = read ? HAL_I2C_STATE_BUSY_RX : HAL_I2C_STATE_BUSY_TX;
+    hi2c->Mode = HAL_I2C_MODE_MASTER;
+    hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+    
+    LL_I2C_ClearFlag_STOP(i2c);
+    LL_I2C_ClearFlag_NACK(i2c);
+    SET_BIT(i2c->CR1, MS58_HAL_LL_IT);
+    LL_I2C_HandleTransfer(i2c, (uint32_t)addr << 1, LL_I2C_ADDRSLAVE_7BIT, n,
+                          (bus->restart_n != 0U) ? LL_I2C_MODE_SOFTEND : LL_I2C_MODE_AUTOEND,
+                          read ? LL_I2C_GENERATE_START_READ : LL_I2C_GENERATE_START_WRITE);
+    
+    return true;
+}
+#endif
 
 /* ============================================================================
  * I2C Communication Functions (Platform-Specific)
  * ============================================================================ */
 
+/**
+ * @brief Restore or gate the clock of a bus (BOARD_SENSOR_BUS_CLOCK_GATE)
+ * 
+ * Gated only with no transfer on the wire. The restore is timed at
+ * PROF_SITE_BUS_UNGATE.
+ */
+static void ms58_hal_clock(I2C_HandleTypeDef *hi2c, bool on)
+{
+#if BOARD_SENSOR_BUS_CLOCK_GATE
+    if (on) {
+        PROF_BEGIN(PROF_SITE_BUS_UNGATE);
+        hal_i2c_bus_clock(hi2c, true);
+        PROF_END(PROF_SITE_BUS_UNGATE);
+    } else {
+        hal_i2c_bus_clock(hi2c, false);
+    }
+#else
+    (void)hi2c;
+    (void)on;
+#endif
+}
+
 /**
  * @brief Write command to MS5837 sensor via I2C
  * 
  * Platform-specific implementation using STM32 HAL.
  * 
+ * @param ctx Device context (ms58_hal_dev_t)
  * @param cmd Command byte to send
  * @return ms583730ba01_err_t Error code
  */
-static ms583730ba01_err_t ms58_hal_write_cmd(uint8_t cmd)
+static ms583730ba01_err_t ms58_hal_write_cmd(void *ctx, uint8_t cmd)
 {
+    const ms58_hal_dev_t *dev = (const ms58_hal_dev_t *)ctx;
     HAL_StatusTypeDef status;
     
     /* MS5837 uses write-only commands (no data) */
-    status = HAL_I2C_Master_Transmit(&hi2c2, 
-                                     (BOARD_I2C2_SENSOR_ADDR << 1),
+    ms58_hal_clock(dev->bus->hi2c, true);
+    status = HAL_I2C_Master_Transmit(dev->bus->hi2c, 
+                                     (uint16_t)(dev->addr << 1),
                                      &cmd, 
                                      1, 
                                      HAL_MAX_DELAY);
@@ -46,27 +236,56 @@ static ms583730ba01_err_t ms58_hal_write_cmd(uint8_t cmd)
     }
 }
 
+/**
+ * @brief Send a read command and read its reply after a repeated START
+ * 
+ * @param ctx Device context (ms58_hal_dev_t)
+ * @param cmd Command byte to send
+ * @param buf Buffer to store read data
+ * @param n Number of bytes to read
+ * @return ms583730ba01_err_t Error code
+ */
+static ms583730ba01_err_t ms58_hal_write_read(void *ctx, uint8_t cmd, uint8_t *buf, uint32_t n)
+{
+    const ms58_hal_dev_t *dev = (const ms58_hal_dev_t *)ctx;
+    
+    if (buf == NULL) {
+        return E_MS58370BA01_NULLPTR_ERR;
+    }
+    
+    ms58_hal_clock(dev->bus->hi2c, true);
+    if (HAL_I2C_Mem_Read(dev->bus->hi2c, (uint16_t)(dev->addr << 1), cmd, I2C_MEMADD_SIZE_8BIT,
+                         buf, (uint16_t)n, HAL_MAX_DELAY) != HAL_OK) {
+        return E_MS58370BA01_COM_ERR;
+    }
+    
+    return E_MS58370BA01_SUCCESS;
+}
+
 /**
  * @brief Read data from MS5837 sensor via I2C
  * 
  * Platform-specific implementation using STM32 HAL.
  * 
+ * @param ctx Device context (ms58_hal_dev_t)
  * @param buf Buffer to store read data
  * @param n Number of bytes to read
  * @return ms583730ba01_err_t Error code
  */
-static ms583730ba01_err_t ms58_hal_read_data(uint8_t *buf, uint32_t n)
+static ms583730ba01_err_t ms58_hal_read_data(void *ctx, uint8_t *buf, uint32_t n)
 {
+    const ms58_hal_dev_t *dev = (const ms58_hal_dev_t *)ctx;
     HAL_StatusTypeDef status;
     
     if (buf == NULL) {
         return E_MS58370BA01_NULLPTR_ERR;
     }
     
-    status = HAL_I2C_Master_Receive(&hi2c2,
-                                    (BOARD_I2C2_SENSOR_ADDR << 1),
+    ms58_hal_clock(dev->bus->hi2c, true);
+    status = HAL_I2C_Master_Receive(dev->bus->hi2c,
+                                    (uint16_t)(dev->addr << 1),
                                     buf,
-                                    n,
+                                    (uint16_t)n,
                                     HAL_MAX_DELAY);
     
     if (status == HAL_OK) {
@@ -76,6 +295,284 @@ static ms583730ba01_err_t ms58_hal_read_data(uint8_t *buf, uint32_t n)
     }
 }
 
+/**
+ * @brief Start or end an active span of a bus (masked or bus interrupt)
+ */
+static void ms58_hal_set_active(ms58_hal_bus_t *bus, bool active)
+{
+    if (active == bus->active) {
+        return;
+    }
+    if (active) {
+        bus->active_since_us = timebase_now_us();
+    } else {
+        bus->active_us += timebase_now_us() - bus->active_since_us;
+    }
+    bus->active = active;
+}
+
+/**
+ * @brief Put the transfer in bus->cur on the wire
+ * 
+ * @return true if started
+ */
+static bool ms58_hal_bus_start(ms58_hal_bus_t *bus)
+{
+    ms58_hal_xfer_t *x = &bus->cur;
+    bool read = (x->buf != NULL);
+    
+#if BOARD_LL_HOTPATH
+    if (read && x->cmd_first) {
+        bus->restart_n = x->n;
+        return ms58_hal_ll_start(bus, x->addr, &x->cmd, 1U, false);
+    }
+    bus->restart_n = 0;
+    return ms58_hal_ll_start(bus, x->addr, read ? x->buf : &x->cmd, read ? x->n : 1U, read);
+#else
+    if (read && x->cmd_first) {
+        return HAL_I2C_Mem_Read_IT(bus->hi2c, (uint16_t)(x->addr << 1), x->cmd,
+                                   I2C_MEMADD_SIZE_8BIT, x->buf, x->n) == HAL_OK;
+    }
+    if (read) {
+        return HAL_I2C_Master_Receive_IT(bus->hi2c, (uint16_t)(x->addr << 1),
+                                         x->buf, x->n) == HAL_OK;
+    }
+    return HAL_I2C_Master_Transmit_IT(bus->hi2c, (uint16_t)(x->addr << 1),
+                                      &x->cmd, 1) == HAL_OK;
+#endif
+}
+
+/**
+ * @brief Drop the rest of the chain whose transfer just failed
+ * 
+ * Leaves the completion of that chain (its last descriptor) in bus->cur.
+ */
+static void ms58_hal_drop_chain(ms58_hal_bus_t *bus)
+{
+    while (bus->queue_count != 0U) {
+        const ms58_hal_xfer_t *xfer = &bus->queue[bus->queue_first];
+        
+        bus->cur.done = xfer->done;
+        bus->cur.done_ctx = xfer->done_ctx;
+        bus->queue_first = (uint8_t)((bus->queue_first + 1U) & MS58_HAL_QUEUE_MASK);
+        bus->queue_count--;
+        if (bus->cur.done != NULL) {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Start the next queued transfer of an idle bus
+ * 
+ * Bus interrupt context. A transfer that cannot be started fails its whole
+ * chain with E_MS58370BA01_COM_ERR, and the one after it is tried.
+ */
+static void ms58_hal_kick(ms58_hal_bus_t *bus)
+{
+    while (!bus->busy && bus->queue_count != 0U) {
+        bus->cur = bus->queue[bus->queue_first];
+        bus->queue_first = (uint8_t)((bus->queue_first + 1U) & MS58_HAL_QUEUE_MASK);
+        bus->queue_count--;
+        
+        bus->busy = true;
+        if (ms58_hal_bus_start(bus)) {
+            PROBE_BUS(PROBE_ID_SENSOR_XFER);
+            return;
+        }
+        bus->busy = false;
+        
+        if (bus->cur.done == NULL) {
+            ms58_hal_drop_chain(bus);
+        }
+        if (bus->cur.done != NULL) {
+            bus->cur.done(bus->cur.done_ctx, E_MS58370BA01_COM_ERR);
+        }
+    }
+    ms58_hal_set_active(bus, bus->busy);
+}
+
+/**
+ * @brief Queue a chain of transfers on a bus
+ * 
+ * Starts the first one right away if the bus is idle; its start failing
+ * is returned here, with no completion. Urgent chains go ahead of every
+ * waiting chain, though not into the middle of the chain on the wire.
+ * 
+ * @param bus Transfer slot of the bus
+ * @param chain Descriptors, last one with a completion
+ * @param count Number of descriptors
+ * @param urgent true to queue ahead of waiting chains
+ * @return ms583730ba01_err_t Error code for queueing the chain
+ */
+static ms583730ba01_err_t ms58_hal_queue(ms58_hal_bus_t *bus, const ms58_hal_xfer_t *chain,
+                                         uint32_t count, bool urgent)
+{
+    uint32_t primask;
+    uint32_t pos;
+    
+    if (chain == NULL) {
+        return E_MS58370BA01_NULLPTR_ERR;
+    }
+    if (count == 0U || count > MS58_HAL_QUEUE_DEPTH || chain[count - 1U].done == NULL) {
+        return E_MS58370BA01_CONFIG_ERR;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        if (chain[i].buf != NULL && chain[i].n == 0U) {
+            return E_MS58370BA01_CONFIG_ERR;
+        }
+    }
+    
+    primask = hal_crit_enter();
+    
+    if (!bus->busy && bus->queue_count == 0U) {
+        bus->cur = chain[0];
+        bus->busy = true;
+        ms58_hal_clock(bus->hi2c, true);
+        if (!ms58_hal_bus_start(bus)) {
+            bus->busy = false;
+            hal_crit_exit(primask);
+            return E_MS58370BA01_COM_ERR;
+        }
+        PROBE_BUS(PROBE_ID_SENSOR_XFER);
+        ms58_hal_set_active(bus, true);
+        chain++;
+        count--;
+    } else if (MS58_HAL_QUEUE_DEPTH - bus->queue_count < count) {
+        hal_crit_exit(primask);
+        return E_MS58370BA01_BUSY_ERR;
+    }
+    
+    /* Behind the chain on the wire (urgent) or behind everything */
+    pos = bus->queue_count;
+    if (urgent) {
+        pos = 0;
+        if (bus->busy && bus->cur.done == NULL) {
+            while (pos < bus->queue_count &&
+                   bus->queue[(bus->queue_first + pos++) & MS58_HAL_QUEUE_MASK].done == NULL) {
+            }
+        }
+    }
+    for (uint32_t i = bus->queue_count; i > pos; i--) {
+        bus->queue[(bus->queue_first + i - 1U + count) & MS58_HAL_QUEUE_MASK] =
+            bus->queue[(bus->queue_first + i - 1U) & MS58_HAL_QUEUE_MASK];
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        bus->queue[(bus->queue_first + pos + i) & MS58_HAL_QUEUE_MASK] = chain[i];
+    }
+    bus->queue_count = (uint8_t)(bus->queue_count + count);
+    
+    hal_crit_exit(primask);
+    return E_MS58370BA01_SUCCESS;
+}
+
+/**
+ * @brief Start a non-blocking command write to MS5837
+ * 
+ * Uses interrupt-driven HAL transfer; `done` runs from the I2C interrupt
+ * when the byte has been acknowledged (or the transfer failed).
+ * 
+ * @param ctx Device context (ms58_hal_dev_t)
+ * @param cmd Command byte to send
+ * @param done Completion callback
+ * @param done_ctx Passed to done
+ * @return ms583730ba01_err_t Error code for starting the transfer
+ */
+static ms583730ba01_err_t ms58_hal_write_cmd_start(void *ctx, uint8_t cmd,
+                                                   ms583730ba01_done_cb_t done, void *done_ctx)
+{
+    const ms58_hal_dev_t *dev = (const ms58_hal_dev_t *)ctx;
+    ms58_hal_xfer_t xfer = { .addr = dev->addr, .cmd = cmd, .done = done, .done_ctx = done_ctx };
+    
+    return ms58_hal_queue(dev->bus, &xfer, 1U, false);
+}
+
+/**
+ * @brief Start a non-blocking data read from MS5837
+ * 
+ * @param ctx Device context (ms58_hal_dev_t)
+ * @param buf Buffer to store read data (must stay valid until `done`)
+ * @param n Number of bytes to read (1..255)
+ * @param done Completion callback
+ * @param done_ctx Passed to done
+ * @return ms583730ba01_err_t Error code for starting the transfer
+ */
+static ms583730ba01_err_t ms58_hal_read_data_start(void *ctx, uint8_t *buf, uint32_t n,
+                                                   ms583730ba01_done_cb_t done, void *done_ctx)
+{
+    const ms58_hal_dev_t *dev = (const ms58_hal_dev_t *)ctx;
+    ms58_hal_xfer_t xfer = { .addr = dev->addr, .buf = buf, .n = (uint8_t)n,
+                             .done = done, .done_ctx = done_ctx };
+    
+    if (buf == NULL) {
+        return E_MS58370BA01_NULLPTR_ERR;
+    }
+    if (n == 0U || n > UINT8_MAX) {
+        return E_MS58370BA01_COM_ERR;
+    }
+    
+    return ms58_hal_queue(dev->bus, &xfer, 1U, false);
+}
+
+/**
+ * @brief Start a non-blocking read command and reply read (repeated START)
+ * 
+ * @param ctx Device context (ms58_hal_dev_t)
+ * @param cmd Command byte to send
+ * @param buf Buffer to store read data (must stay valid until `done`)
+ * @param n Number of bytes to read (1..255)
+ * @param done Completion callback
+ * @param done_ctx Passed to done
+ * @return ms583730ba01_err_t Error code for starting the transfer
+ */
+static ms583730ba01_err_t ms58_hal_write_read_start(void *ctx, uint8_t cmd, uint8_t *buf,
+                                                    uint32_t n, ms583730ba01_done_cb_t done,
+                                                    void *done_ctx)
+{
+    const ms58_hal_dev_t *dev = (const ms58_hal_dev_t *)ctx;
+    ms58_hal_xfer_t xfer = { .addr = dev->addr, .cmd = cmd, .cmd_first = true,
+                             .buf = buf, .n = (uint8_t)n, .done = done, .done_ctx = done_ctx };
+    
+    if (buf == NULL) {
+        return E_MS58370BA01_NULLPTR_ERR;
+    }
+    if (n == 0U || n > UINT8_MAX) {
+        return E_MS58370BA01_COM_ERR;
+    }
+    
+    return ms58_hal_queue(dev->bus, &xfer, 1U, false);
+}
+
+/**
+ * @brief Finish the transfer on the wire of a bus and notify its owner
+ * 
+ * The chain's completion runs before the next queued transfer starts, so
+ * completions keep queue order; a callback chaining a transfer on an idle
+ * bus starts it at once.
+ */
+static void ms58_hal_async_finish(I2C_HandleTypeDef *hi2c, ms583730ba01_err_t result)
+{
+    ms58_hal_bus_t *bus = ms58_hal_bus_lookup(hi2c, false);
+    
+    if (bus == NULL || !bus->busy) {
+        return;  /* Not a sensor bus, or the transfer was aborted */
+    }
+    
+    PROBE_BUS((result == E_MS58370BA01_SUCCESS) ? PROBE_ID_SENSOR_DONE : PROBE_ID_SENSOR_FAIL);
+    bus->busy = false;
+    if (bus->cur.done == NULL && result != E_MS58370BA01_SUCCESS) {
+        ms58_hal_drop_chain(bus);
+    }
+    
+    if (bus->cur.done != NULL) {
+        bus->cur.done(bus->cur.done_ctx, result);
+    }
+    ms58_hal_kick(bus);
+    if (!bus->busy) {
+        ms58_hal_clock(hi2c, false);  /* Last STOP is out: the bus idles */
+    }
+}
+
 /**
  * @brief Delay function using board delay
  * 
@@ -90,22 +587,230 @@ static void ms58_hal_delay(uint16_t ms)
  * Driver Handle Initialization
  * ============================================================================ */
 
-/**
- * @brief Get initialized MS5837 driver handle
- * 
- * Returns a handle structure with function pointers for I2C communication.
- * This handle can be used with all ms58.c driver functions.
- * 
- * @return ms583730ba01_h Initialized driver handle
- */
-ms583730ba01_h ms58_get_hal_handle(void)
+ms583730ba01_h ms58_get_hal_handle(ms58_hal_dev_t *dev, I2C_HandleTypeDef *hi2c, uint8_t addr)
 {
     ms583730ba01_h handle = {
+        .ctx = dev,
         .write_cmd = ms58_hal_write_cmd,
         .read_data = ms58_hal_read_data,
-        .delay = ms58_hal_delay
+        .delay = ms58_hal_delay,
+        .write_cmd_start = ms58_hal_write_cmd_start,
+        .read_data_start = ms58_hal_read_data_start,
+        .write_read = ms58_hal_write_read,
+        .write_read_start = ms58_hal_write_read_start
     };
     
+    dev->bus = ms58_hal_bus_lookup(hi2c, true);
+    dev->addr = addr;
+    
+    /* No slot left for another bus: the handle can't talk to anything */
+    if (dev->bus == NULL) {
+        ms583730ba01_h none = {0};
+        return none;
+    }
+    
     return handle;
 }
 
+/* ============================================================================
+ * TCA9548 I2C Mux
+ * ============================================================================ */
+
+ms583730ba01_err_t ms58_hal_mux_select(I2C_HandleTypeDef *hi2c, uint8_t mux_addr,
+                                       uint8_t channel_mask)
+{
+    ms58_hal_bus_t *bus = ms58_hal_bus_lookup(hi2c, true);
+    
+    if (bus == NULL) {
+        return E_MS58370BA01_CONFIG_ERR;
+    }
+    
+    if (bus->busy || bus->queue_count != 0U) {
+        return E_MS58370BA01_BUSY_ERR;
+    }
+    
+    /* Control register is the only register: one data byte, no address */
+    ms58_hal_clock(hi2c, true);
+    if (HAL_I2C_Master_Transmit(hi2c,
+                                (uint16_t)(mux_addr << 1),
+                                &channel_mask,
+                                1,
+                                HAL_MAX_DELAY) != HAL_OK) {
+        return E_MS58370BA01_COM_ERR;
+    }
+    
+    return E_MS58370BA01_SUCCESS;
+}
+
+ms583730ba01_err_t ms58_hal_mux_select_start(I2C_HandleTypeDef *hi2c, uint8_t mux_addr,
+                                             uint8_t channel_mask, ms583730ba01_done_cb_t done,
+                                             void *done_ctx)
+{
+    ms58_hal_bus_t *bus = ms58_hal_bus_lookup(hi2c, true);
+    ms58_hal_xfer_t xfer = { .addr = mux_addr, .cmd = channel_mask, .done = done,
+                             .done_ctx = done_ctx };
+    
+    if (bus == NULL) {
+        return E_MS58370BA01_CONFIG_ERR;
+    }
+    
+    return ms58_hal_queue(bus, &xfer, 1U, false);
+}
+
+ms583730ba01_err_t ms58_hal_submit(I2C_HandleTypeDef *hi2c, const ms58_hal_xfer_t *chain,
+                                   uint32_t count, bool urgent)
+{
+    ms58_hal_bus_t *bus = ms58_hal_bus_lookup(hi2c, true);
+    
+    if (bus == NULL) {
+        return E_MS58370BA01_CONFIG_ERR;
+    }
+    
+    return ms58_hal_queue(bus, chain, count, urgent);
+}
+
+void ms58_hal_abort(I2C_HandleTypeDef *hi2c)
+{
+    ms58_hal_bus_t *bus = ms58_hal_bus_lookup(hi2c, false);
+    
+    if (bus != NULL) {
+        /* A late completion is then ignored */
+        bus->busy = false;
+        bus->queue_count = 0;
+        ms58_hal_set_active(bus, false);
+    }
+}
+
+uint32_t ms58_hal_get_active_us(I2C_HandleTypeDef *hi2c)
+{
+    ms58_hal_bus_t *bus = ms58_hal_bus_lookup(hi2c, false);
+    uint32_t primask;
+    uint32_t active_us;
+    
+    if (bus == NULL) {
+        return 0;
+    }
+    
+    primask = hal_crit_enter();
+    active_us = bus->active_us;
+    if (bus->active) {
+        active_us += timebase_now_us() - bus->active_since_us;
+    }
+    hal_crit_exit(primask);
+    return active_us;
+}
+
+void ms58_hal_error_callback(I2C_HandleTypeDef *hi2c)
+{
+    /* Ignored unless a sensor instance uses this bus */
+    ms58_hal_async_finish(hi2c, E_MS58370BA01_COM_ERR);
+}
+
+#if BOARD_LL_HOTPATH
+RAMFUNC void ms58_hal_ll_irq_handler(I2C_HandleTypeDef *hi2c)
+{
+    I2C_TypeDef *i2c = hi2c->Instance;
+    ms58_hal_bus_t *bus = ms58_hal_bus_lookup(hi2c, false);
+    uint32_t isr = i2c->ISR;
+    bool finished = false;
+    
+    if (bus == NULL || hi2c->State == HAL_I2C_STATE_READY) {
+        CLEAR_BIT(i2c->CR1, MS58_HAL_LL_IT);  /* Nothing of ours in flight */
+        return;
+    }
+    
+    /* Bus error or lost arbitration: the peripheral releases the bus, no
+     * STOP follows. Reported like HAL does, for hal_i2c2_bus_fault() */
+    if ((isr & (I2C_ISR_BERR | I2C_ISR_ARLO | I2C_ISR_OVR)) != 0U) {
+        if ((isr & I2C_ISR_BERR) != 0U) {
+            hi2c->ErrorCode |= HAL_I2C_ERROR_BERR;
+        }
+        if ((isr & I2C_ISR_ARLO) != 0U) {
+            hi2c->ErrorCode |= HAL_I2C_ERROR_ARLO;
+        }
+        if ((isr & I2C_ISR_OVR) != 0U) {
+            hi2c->ErrorCode |= HAL_I2C_ERROR_OVR;
+        }
+        WRITE_REG(i2c->ICR, I2C_ICR_BERRCF | I2C_ICR_ARLOCF | I2C_ICR_OVRCF);
+        finished = true;
+    }
+    
+    /* NACK: AUTOEND sends the STOP, the transfer ends at STOPF. The
+     * command phase of a repeated-START read has no AUTOEND: STOP here */
+    if ((isr & I2C_ISR_NACKF) != 0U) {
+        LL_I2C_ClearFlag_NACK(i2c);
+        hi2c->ErrorCode |= HAL_I2C_ERROR_AF;
+        if (bus->restart_n != 0U) {
+            bus->restart_n = 0;
+            LL_I2C_GenerateStopCondition(i2c);
+        }
+    }
+    
+    if ((isr & I2C_ISR_TXIS) != 0U && bus->remaining != 0U) {
+        LL_I2C_TransmitData8(i2c, *bus->buf++);
+        bus->remaining--;
+    }
+    
+    /* Command sent without STOP: repeated START into the read */
+    if ((isr & I2C_ISR_TC) != 0U && bus->restart_n != 0U) {
+        bus->buf = bus->cur.buf;
+        bus->remaining = bus->restart_n;
+        bus->restart_n = 0;
+        hi2c->State = HAL_I2C_STATE_BUSY_RX;
+        LL_I2C_HandleTransfer(i2c, (uint32_t)bus->addr << 1, LL_I2C_ADDRSLAVE_7BIT,
+                              bus->remaining, LL_I2C_MODE_AUTOEND, LL_I2C_GENERATE_START_READ);
+    }
+    
+    if ((isr & I2C_ISR_RXNE) != 0U) {
+        uint8_t byte = LL_I2C_ReceiveData8(i2c);
+        
+        if (bus->remaining != 0U) {
+            *bus->buf++ = byte;
+            bus->remaining--;
+        }
+    }
+    
+    if ((isr & I2C_ISR_STOPF) != 0U) {
+        LL_I2C_ClearFlag_STOP(i2c);
+        finished = true;
+    }
+    
+    if (finished) {
+        CLEAR_BIT(i2c->CR1, MS58_HAL_LL_IT);
+        CLEAR_REG(i2c->CR2);
+        hi2c->State = HAL_I2C_STATE_READY;
+        hi2c->Mode = HAL_I2C_MODE_NONE;
+        ms58_hal_async_finish(hi2c, (hi2c->ErrorCode == HAL_I2C_ERROR_NONE && bus->remaining == 0U) ?
+                                    E_MS58370BA01_SUCCESS : E_MS58370BA01_COM_ERR);
+    }
+}
+#endif
+
+/* ============================================================================
+ * HAL CALLBACKS (Called by HAL from I2C2 interrupt context)
+ * ============================================================================ */
+
+/**
+ * @brief I2C master transmit complete callback
+ */
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    ms58_hal_async_finish(hi2c, E_MS58370BA01_SUCCESS);
+}
+
+/**
+ * @brief I2C master receive complete callback
+ */
+void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    ms58_hal_async_finish(hi2c, E_MS58370BA01_SUCCESS);
+}
+
+/**
+ * @brief I2C memory read complete callback (repeated-START reads)
+ */
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    ms58_hal_async_finish(hi2c, E_MS58370BA01_SUCCESS);
+}
+
@@ -7,20 +7,150 @@
  */
 
 #include "ms58.h"
+#include "stm32l0xx_hal.h"  /* For I2C_HandleTypeDef */
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* Asynchronous transfer slot of one I2C peripheral (private to the wrapper) */
+typedef struct ms58_hal_bus ms58_hal_bus_t;
+
+/* Transfers waiting per bus behind the one on the wire (power of 2) */
+#define MS58_HAL_QUEUE_DEPTH  8U
+
+/**
+ * @brief One queued bus transfer: a single-byte write, a read, or both
+ */
+typedef struct {
+    uint8_t addr;                 /* 7-bit device address (sensor or mux) */
+    uint8_t cmd;                  /* Byte to write (buf == NULL, or cmd_first) */
+    bool cmd_first;               /* Read: write cmd, then read after a repeated START */
+    uint8_t *buf;                 /* Read buffer, valid until the chain completes; NULL: write */
+    uint8_t n;                    /* Bytes to read (1..255) */
+    ms583730ba01_done_cb_t done;  /* Completion of the chain; NULL links to the next descriptor */
+    void *done_ctx;               /* Passed to done */
+} ms58_hal_xfer_t;
+
+/**
+ * @brief Transport context of one sensor instance (handle ctx)
+ * 
+ * Filled by ms58_get_hal_handle(); storage belongs to the caller and must
+ * outlive the handle.
+ */
+typedef struct {
+    ms58_hal_bus_t *bus;  /* I2C peripheral the sensor sits on */
+    uint8_t addr;         /* 7-bit sensor address */
+} ms58_hal_dev_t;
+
 /**
  * @brief Get initialized MS5837 driver handle for STM32 HAL
  * 
  * Returns a handle structure with function pointers configured for
  * STM32 HAL I2C communication. Use this handle with all ms58.c driver functions.
+ * Sensors on the same bus share its async transfer queue; up to two
+ * I2C peripherals can carry sensors.
+ * 
+ * @param dev Context storage for this instance (referenced by the handle)
+ * @param hi2c I2C master the sensor is connected to
+ * @param addr 7-bit sensor address (BOARD_I2C2_SENSOR_ADDR on this board)
+ * @return ms583730ba01_h Initialized driver handle (all-NULL if no bus slot is left)
+ */
+ms583730ba01_h ms58_get_hal_handle(ms58_hal_dev_t *dev, I2C_HandleTypeDef *hi2c, uint8_t addr);
+
+/**
+ * @brief Route the sensor bus through TCA9548 mux channels (blocking)
+ * 
+ * @param hi2c I2C master the mux is connected to
+ * @param mux_addr 7-bit mux address (BOARD_I2Cx_MUX_ADDR)
+ * @param channel_mask Bit n enables mux channel n (0 disconnects all)
+ * @return ms583730ba01_err_t Error code (BUSY if async transfers are in flight or queued)
+ */
+ms583730ba01_err_t ms58_hal_mux_select(I2C_HandleTypeDef *hi2c, uint8_t mux_addr,
+                                       uint8_t channel_mask);
+
+/**
+ * @brief Route the sensor bus through TCA9548 mux channels (non-blocking)
+ * 
+ * Queued behind the bus's other transfers, like its sensor transports.
+ * 
+ * @param hi2c I2C master the mux is connected to
+ * @param mux_addr 7-bit mux address (BOARD_I2Cx_MUX_ADDR)
+ * @param channel_mask Bit n enables mux channel n (0 disconnects all)
+ * @param done Called from the bus interrupt context once the byte is sent
+ * @param done_ctx Passed to done
+ * @return ms583730ba01_err_t Error code for starting the transfer
+ */
+ms583730ba01_err_t ms58_hal_mux_select_start(I2C_HandleTypeDef *hi2c, uint8_t mux_addr,
+                                             uint8_t channel_mask, ms583730ba01_done_cb_t done,
+                                             void *done_ctx);
+
+/**
+ * @brief Queue a chain of transfers, run back to back from the bus interrupt
+ * 
+ * Descriptors up to the first with a completion form one chain: they run
+ * in order with no callback in between, and a failed transfer skips the
+ * rest of its chain, whose completion then gets E_MS58370BA01_COM_ERR.
+ * Chains complete in the order they are queued (urgent ones excepted).
+ * Transfer timeouts stay with the owner of the bus (ms58_hal_abort()).
+ * 
+ * @param hi2c I2C master of the devices
+ * @param chain Descriptors (copied), the last one with a completion
+ * @param count Number of descriptors (1..MS58_HAL_QUEUE_DEPTH)
+ * @param urgent true to run ahead of the chains waiting (not ahead of the
+ *               rest of the chain on the wire)
+ * @return ms583730ba01_err_t Error code (BUSY if the queue has no room;
+ *         the first transfer failing to start on an idle bus is reported
+ *         here, with no completion)
+ */
+ms583730ba01_err_t ms58_hal_submit(I2C_HandleTypeDef *hi2c, const ms58_hal_xfer_t *chain,
+                                   uint32_t count, bool urgent);
+
+/**
+ * @brief Drop the asynchronous transfers in flight and queued on a bus
+ * 
+ * Their completion callbacks are not called. For transfers that never
+ * completed (stuck bus); must run at the bus interrupt priority or with
+ * it masked. The peripheral itself is left to the caller (hal_i2c2_recover()).
+ * 
+ * @param hi2c I2C handle of the bus
+ */
+void ms58_hal_abort(I2C_HandleTypeDef *hi2c);
+
+/**
+ * @brief Time a bus has had asynchronous transfers on the wire
+ * 
+ * From the first transfer started on an idle bus to the last one of its
+ * queue completing; the blocking transports are not counted.
+ * 
+ * @param hi2c I2C handle of the bus
+ * @return Microseconds since boot (wraps, take differences), 0 for a bus
+ *         no sensor instance uses
+ */
+uint32_t ms58_hal_get_active_us(I2C_HandleTypeDef *hi2c);
+
+/**
+ * @brief I2C error hook for the sensor bus
+ * 
+ * Must be called from HAL_I2C_ErrorCallback(). Completes the asynchronous
+ * transfer in flight on that bus with E_MS58370BA01_COM_ERR. Ignores I2C
+ * handles no sensor instance uses.
+ * 
+ * @param hi2c I2C handle reported by HAL
+ */
+void ms58_hal_error_callback(I2C_HandleTypeDef *hi2c);
+
+/**
+ * @brief Register-level I2C interrupt handler of a sensor bus
+ * 
+ * BOARD_LL_HOTPATH only: replaces HAL_I2C_EV_IRQHandler() and
+ * HAL_I2C_ER_IRQHandler() in the bus vector. Moves the bytes of the
+ * asynchronous transfer in flight and completes it at STOP (or on a bus
+ * error), with E_MS58370BA01_COM_ERR after a NACK or error.
  * 
- * @return ms583730ba01_h Initialized driver handle
+ * @param hi2c I2C handle of the bus
  */
-ms583730ba01_h ms58_get_hal_handle(void);
+void ms58_hal_ll_irq_handler(I2C_HandleTypeDef *hi2c);
 
 #ifdef __cplusplus
 }
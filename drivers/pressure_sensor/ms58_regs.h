@@ -26,6 +26,25 @@
 #define MS5837_CONVERT_D1_8192 	0x4A//I2C Command: Request D1 Conversion @ OCR=8192 (max)
 #define MS5837_CONVERT_D2_8192 	0x5A//I2C Command: Request D2 Conversion @ OCR=8192 (max)
 
+// Maximum conversion times per OSR in microseconds (datasheet, same for D1 and D2).
+// Read earlier, the ADC returns 0; app/conv_tune.h measures each unit at boot
+// and the sampler waits that instead (these cap it)
+#define MS5837_CONV_TIME_US_256     560
+#define MS5837_CONV_TIME_US_512     1100
+#define MS5837_CONV_TIME_US_1024    2170
+#define MS5837_CONV_TIME_US_2048    4320
+#define MS5837_CONV_TIME_US_4096    8610
+#define MS5837_CONV_TIME_US_8192    17200
+
+// Conversion time of an OSR index, 0 (256) .. 5 (8192): constant, usable in #if
+#define MS5837_CONV_TIME_US(osr) \
+    ((osr) == 0 ? MS5837_CONV_TIME_US_256 : (osr) == 1 ? MS5837_CONV_TIME_US_512 : \
+     (osr) == 2 ? MS5837_CONV_TIME_US_1024 : (osr) == 3 ? MS5837_CONV_TIME_US_2048 : \
+     (osr) == 4 ? MS5837_CONV_TIME_US_4096 : MS5837_CONV_TIME_US_8192)
+
+// Reload time after the reset command (datasheet minimum 2.8ms)
+#define MS5837_RESET_TIME_US        2800
+
 #define TCA9548_ADDR				0x74
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
@@ -0,0 +1,110 @@
+/**
+ * @file probe.c
+ * @brief Hot-path timing probes implementation
+ *
+ * The ring overwrites its oldest record: the write index only grows, and
+ * its low bits pick the slot. Points run at every priority, so the slot
+ * claim and the store are one masked section; the timestamp is taken
+ * before it, so a point preempted there can land a few microseconds out
+ * of order, which the decoder sorts back.
+ */
+
+#include "probe.h"
+
+#if BOARD_PROBE_ENABLE
+
+#include "stm32l0xx_hal.h"  /* For GPIO init */
+#include "hal_atomic.h"
+#include "timebase.h"
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define PROBE_RING_RECORDS  (1UL << BOARD_PROBE_RING_LOG2)
+#define PROBE_RING_MASK     (PROBE_RING_RECORDS - 1UL)
+#define PROBE_TIME_MASK     0x00FFFFFFUL
+
+#if BOARD_PROBE_RING_LOG2 < 4 || BOARD_PROBE_RING_LOG2 > 12
+#error "BOARD_PROBE_RING_LOG2 must be 4 .. 12 (16 .. 4096 records)"
+#endif
+
+/**
+ * @brief Frame as sent (probe.h)
+ */
+typedef struct {
+    uint8_t version;
+    uint8_t size_log2;
+    volatile uint8_t frozen;
+    uint8_t reserved;
+    uint32_t written;
+    uint32_t ring[PROBE_RING_RECORDS];
+} probe_frame_t;
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static probe_frame_t probe_frame = {
+    .version = PROBE_VERSION,
+    .size_log2 = BOARD_PROBE_RING_LOG2,
+    .frozen = 1U,  /* Until probe_init() */
+};
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+void probe_init(void)
+{
+#if BOARD_PROBE_PINS
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+    
+    /* Push-pull, fastest edges: the scope sees the BSRR store */
+    BOARD_PROBE_PORT_CLK_ENABLE();
+    BOARD_PROBE_PORT->BSRR = (PROBE_PIN0_MASK | PROBE_PIN1_MASK) << 16;
+    GPIO_InitStruct.Pin = PROBE_PIN0_MASK | PROBE_PIN1_MASK;
+    GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+    HAL_GPIO_Init(BOARD_PROBE_PORT, &GPIO_InitStruct);
+#endif
+    probe_resume();
+}
+
+void probe_record(uint32_t id)
+{
+    uint32_t record = (id << 24) | (timebase_now_us() & PROBE_TIME_MASK);
+    uint32_t primask;
+    
+    if (probe_frame.frozen != 0U) {
+        return;
+    }
+    
+    primask = hal_crit_enter();
+    probe_frame.ring[probe_frame.written & PROBE_RING_MASK] = record;
+    probe_frame.written++;
+    hal_crit_exit(primask);
+}
+
+void probe_freeze(void)
+{
+    probe_frame.frozen = 1U;
+}
+
+void probe_resume(void)
+{
+    uint32_t primask = hal_crit_enter();
+    
+    probe_frame.written = 0;
+    probe_frame.frozen = 0U;
+    hal_crit_exit(primask);
+}
+
+const uint8_t *probe_dump(uint16_t *len)
+{
+    *len = (uint16_t)sizeof(probe_frame);
+    return (const uint8_t *)&probe_frame;
+}
+
+#endif /* BOARD_PROBE_ENABLE */
@@ -0,0 +1,172 @@
+#ifndef PROBE_H
+#define PROBE_H
+
+/**
+ * @file probe.h
+ * @brief Hot-path timing probes: a RAM event ring and GPIO probe pins
+ *
+ * The M0+ has no ITM/SWO: this is the logic-analyzer view instead. A probe
+ * point stores one 32-bit record, its ID and the microsecond timestamp,
+ * into a RAM ring that always holds the newest 2^BOARD_PROBE_RING_LOG2;
+ * with BOARD_PROBE_PINS each of two spare pins also follows one chosen
+ * span (a handler, a bus transfer) by one BSRR store at either end.
+ * Points come in groups, selected at build time (BOARD_PROBE_GROUPS):
+ *   PROBE_GROUP_ISR    entry and exit of every handler bracketed by
+ *                      PERF_ISR_BEGIN()/PERF_ISR_END(), by perf_isr_t
+ *   PROBE_GROUP_STATE  sampler state found by each sampling step, on change
+ *   PROBE_GROUP_BUS    sensor bus transfer start and end, slave
+ *                      transaction address match and end
+ * A group left out compiles away; BOARD_PROBE_ENABLE 0 takes all of them.
+ *
+ * Record: [31:24] ID (probe_id_t), [23:0] timebase_now_us() modulo 2^24
+ * (16.7 s; consecutive records closer than that unwrap exactly).
+ *
+ * The ring is read whole: probe_freeze() stops recording, probe_dump()
+ * returns the frame below for any transport to send (the I2C stream
+ * register APP_REG_PROBE, or the probe_frame variable over SWD), and
+ * probe_resume() starts over empty. Frame, little-endian:
+ *   0  uint8   version (PROBE_VERSION)
+ *   1  uint8   log2 of the ring size, records
+ *   2  uint8   1 frozen
+ *   3  uint8   reserved
+ *   4  uint32  records written since the last resume; the oldest of the
+ *              ring is at written mod size once it has wrapped
+ *   8  uint32  ring[size]
+ * tools/probe_decode.py prints it as a timeline or writes a VCD file.
+ *
+ * A point costs a timebase read and a masked store (about 30 cycles),
+ * from any context.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board_config.h"
+#include "stm32l0xx.h"  /* For the probe pin BSRR */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+#define PROBE_VERSION        1U
+
+#define PROBE_GROUP_ISR      0x01U
+#define PROBE_GROUP_STATE    0x02U
+#define PROBE_GROUP_BUS      0x04U
+
+/**
+ * @brief Record IDs
+ *
+ * tools/probe_decode.py reads the names and bases from here: keep one
+ * entry per line.
+ */
+typedef enum {
+    PROBE_ID_ISR_ENTER = 0x00,     /* + perf_isr_t: handler entry */
+    PROBE_ID_ISR_EXIT = 0x10,      /* + perf_isr_t: handler exit */
+    PROBE_ID_SENSOR_STATE = 0x20,  /* + sensor state: found by a sampling step */
+    PROBE_ID_SENSOR_XFER = 0x40,   /* Sensor bus transfer started */
+    PROBE_ID_SENSOR_DONE = 0x41,   /* Sensor bus transfer done */
+    PROBE_ID_SENSOR_FAIL = 0x42,   /* Sensor bus transfer failed */
+    PROBE_ID_SLAVE_READ = 0x48,    /* Slave address match, master read */
+    PROBE_ID_SLAVE_WRITE = 0x49,   /* Slave address match, master write */
+    PROBE_ID_SLAVE_END = 0x4A      /* Slave transaction ended */
+} probe_id_t;
+
+#define PROBE_PIN0_MASK  (1UL << BOARD_PROBE_PIN0)
+#define PROBE_PIN1_MASK  (1UL << BOARD_PROBE_PIN1)
+
+/* ============================================================================
+ * MACROS
+ * ============================================================================ */
+
+#if BOARD_PROBE_ENABLE && (BOARD_PROBE_GROUPS & PROBE_GROUP_ISR)
+/** Handler entry (from PERF_ISR_BEGIN()); pin 0 rises for BOARD_PROBE_PIN0_ISR */
+#define PROBE_ISR_ENTER(src)  do { \
+        PROBE_PIN_SET((src) == BOARD_PROBE_PIN0_ISR, PROBE_PIN0_MASK); \
+        probe_record((uint32_t)PROBE_ID_ISR_ENTER + (uint32_t)(src)); \
+    } while (0)
+/** Handler exit (from PERF_ISR_END()) */
+#define PROBE_ISR_EXIT(src)  do { \
+        probe_record((uint32_t)PROBE_ID_ISR_EXIT + (uint32_t)(src)); \
+        PROBE_PIN_SET((src) == BOARD_PROBE_PIN0_ISR, PROBE_PIN0_MASK << 16); \
+    } while (0)
+#else
+#define PROBE_ISR_ENTER(src)  ((void)0)
+#define PROBE_ISR_EXIT(src)   ((void)0)
+#endif
+
+#if BOARD_PROBE_ENABLE && (BOARD_PROBE_GROUPS & PROBE_GROUP_STATE)
+/** State machine point: record an ID computed at run time */
+#define PROBE_STATE(id)  probe_record((uint32_t)(id))
+#else
+#define PROBE_STATE(id)  ((void)0)
+#endif
+
+#if BOARD_PROBE_ENABLE && (BOARD_PROBE_GROUPS & PROBE_GROUP_BUS)
+/** Bus point; pin 1 follows the sensor bus transfers */
+#define PROBE_BUS(id)  do { \
+        PROBE_PIN_SET((id) == PROBE_ID_SENSOR_XFER, PROBE_PIN1_MASK); \
+        PROBE_PIN_SET((id) != PROBE_ID_SENSOR_XFER && (id) <= PROBE_ID_SENSOR_FAIL, \
+                      PROBE_PIN1_MASK << 16); \
+        probe_record((uint32_t)(id)); \
+    } while (0)
+#else
+#define PROBE_BUS(id)  ((void)0)
+#endif
+
+/* One BSRR store; the condition is a constant at every site */
+#if BOARD_PROBE_ENABLE && BOARD_PROBE_PINS
+#define PROBE_PIN_SET(cond, bsrr)  do { \
+        if (cond) { BOARD_PROBE_PORT->BSRR = (bsrr); } \
+    } while (0)
+#else
+#define PROBE_PIN_SET(cond, bsrr)  ((void)0)
+#endif
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Start recording with an empty ring (and the probe pins low)
+ *
+ * Call after the timebase is up; points before are dropped.
+ */
+void probe_init(void);
+
+/**
+ * @brief Record one point (use the PROBE_* macros)
+ *
+ * @param id probe_id_t, base plus offset
+ */
+void probe_record(uint32_t id);
+
+/**
+ * @brief Stop recording: the ring keeps what it holds for probe_dump()
+ */
+void probe_freeze(void);
+
+/**
+ * @brief Empty the ring and record again
+ */
+void probe_resume(void);
+
+/**
+ * @brief Get the frame
+ *
+ * Callable from an interrupt (the I2C1 address callback). Gives the ring
+ * as it is: freeze first for a consistent one.
+ *
+ * @param len Receives the frame length in bytes
+ * @return Frame bytes (probe.h)
+ */
+const uint8_t *probe_dump(uint16_t *len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PROBE_H */
@@ -0,0 +1,124 @@
+/**
+ * @file prof.c
+ * @brief On-target execution time profiling implementation
+ * 
+ * Sites run at several interrupt priorities (I2C1 preempts TIM2), so a
+ * record is masked: the update of one site never interleaves with
+ * another pass of the same site or with a snapshot.
+ */
+
+#include "prof.h"
+
+#if BOARD_PROF_ENABLE
+
+#include "hal_config.h"
+#include "hal_atomic.h"
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define PROF_OVERHEAD_RUNS  8U  /* Empty passes timed for the overhead (minimum kept) */
+
+/**
+ * @brief Site accumulator
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+} prof_acc_t;
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static prof_acc_t sites[PROF_SITE_COUNT];
+static uint32_t overhead = 0;  /* Cycles of an empty begin/end pair */
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+void prof_init(void)
+{
+    hal_cycles_init();
+    prof_reset();
+    
+    overhead = UINT32_MAX;
+    for (uint32_t i = 0; i < PROF_OVERHEAD_RUNS; i++) {
+        uint32_t start = prof_now();
+        uint32_t cycles = prof_now() - start;
+        
+        if (cycles < overhead) {
+            overhead = cycles;
+        }
+    }
+}
+
+uint32_t prof_now(void)
+{
+    return hal_cycles_read();
+}
+
+void prof_record(prof_site_t site, uint32_t start)
+{
+    uint32_t cycles = prof_now() - start;
+    prof_acc_t *acc;
+    uint32_t primask;
+    
+    if ((uint32_t)site >= PROF_SITE_COUNT) {
+        return;
+    }
+    
+    cycles = (cycles > overhead) ? (cycles - overhead) : 0U;
+    acc = &sites[site];
+    
+    primask = hal_crit_enter();
+    if (acc->count == 0U || cycles < acc->min) {
+        acc->min = cycles;
+    }
+    if (cycles > acc->max) {
+        acc->max = cycles;
+    }
+    acc->total += cycles;
+    acc->count++;
+    hal_crit_exit(primask);
+}
+
+bool prof_get_stats(prof_site_t site, prof_stats_t *stats)
+{
+    prof_acc_t acc;
+    uint32_t primask;
+    
+    if ((uint32_t)site >= PROF_SITE_COUNT || stats == NULL) {
+        return false;
+    }
+    
+    primask = hal_crit_enter();
+    acc = sites[site];
+    hal_crit_exit(primask);
+    
+    stats->count = acc.count;
+    stats->min = acc.min;
+    stats->max = acc.max;
+    stats->mean = (acc.count != 0U) ? (uint32_t)(acc.total / acc.count) : 0U;
+    
+    return true;
+}
+
+void prof_reset(void)
+{
+    uint32_t primask = hal_crit_enter();
+    
+    for (uint32_t i = 0; i < PROF_SITE_COUNT; i++) {
+        sites[i].count = 0;
+        sites[i].min = 0;
+        sites[i].max = 0;
+        sites[i].total = 0;
+    }
+    hal_crit_exit(primask);
+}
+
+#endif /* BOARD_PROF_ENABLE */
@@ -0,0 +1,117 @@
+#ifndef PROF_H
+#define PROF_H
+
+/**
+ * @file prof.h
+ * @brief On-target execution time profiling
+ * 
+ * A site is a code section bracketed by PROF_BEGIN()/PROF_END(). Each pass
+ * is timed in SYSCLK cycles on the TIM22/TIM3 cycle counter
+ * (hal_cycles_read()) and folded into the site's count, min, max and total.
+ * The master reads one site at a time through the APP_REG_PROF_* window,
+ * selected by HOST_CMD_PROF.
+ * 
+ * Built only with BOARD_PROF_ENABLE: otherwise the macros expand to nothing
+ * and the sites cost no code or time.
+ * 
+ * Times include preemption by higher-priority interrupts and exclude the
+ * cost of the two counter reads. The counter halts in STOP mode.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * TYPES
+ * ============================================================================ */
+
+/**
+ * @brief Profiled sites (HOST_CMD_PROF selector)
+ */
+typedef enum {
+    PROF_SITE_SAMPLING_TICK = 0,  /* sensor_sampling_timer_isr() */
+    PROF_SITE_COMPENSATE,         /* ms5837_compensate() (second-order compensation) */
+    PROF_SITE_DAC_SET_VOLTAGE,    /* dac_set_voltage() */
+    PROF_SITE_I2C_SLAVE_IRQ,      /* i2c_slave_irq_handler(), slave callbacks included */
+    PROF_SITE_DAC_DIRECT,         /* Compensation to DAC store, direct path (masked) */
+    PROF_SITE_IIR,                /* sensor_iir_push() (one IIR filter channel) */
+    PROF_SITE_TRACKER,            /* tracker_update() (alpha-beta tracker) */
+    PROF_SITE_BUS_UNGATE,         /* Sensor bus clock restore (BOARD_SENSOR_BUS_CLOCK_GATE) */
+    PROF_SITE_COUNT
+} prof_site_t;
+
+/**
+ * @brief Site statistics (SYSCLK cycles)
+ */
+typedef struct {
+    uint32_t count;  /* Passes since boot or the last reset */
+    uint32_t min;    /* 0 while count is 0 */
+    uint32_t max;
+    uint32_t mean;
+} prof_stats_t;
+
+/* ============================================================================
+ * MACROS
+ * ============================================================================ */
+
+#if BOARD_PROF_ENABLE
+/** Start timing a site (declares a local, once per site and scope) */
+#define PROF_BEGIN(site)  uint32_t prof_start_##site = prof_now()
+/** Stop timing a site and record the pass */
+#define PROF_END(site)    prof_record((site), prof_start_##site)
+#else
+#define PROF_BEGIN(site)  ((void)0)
+#define PROF_END(site)    ((void)0)
+#endif
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Start the cycle counter and clear the statistics
+ * 
+ * Measures the cost of a begin/end pair, taken off every pass. Call after
+ * the clock is configured.
+ */
+void prof_init(void);
+
+/**
+ * @brief Current cycle count (PROF_BEGIN())
+ */
+uint32_t prof_now(void);
+
+/**
+ * @brief Record a pass of a site (PROF_END())
+ * 
+ * Safe from any context.
+ * 
+ * @param site Profiled site
+ * @param start prof_now() at the start of the pass
+ */
+void prof_record(prof_site_t site, uint32_t start);
+
+/**
+ * @brief Get the statistics of a site
+ * 
+ * @param site Profiled site
+ * @param stats Receives the statistics (one consistent snapshot)
+ * @return true on success, false if the site is out of range
+ */
+bool prof_get_stats(prof_site_t site, prof_stats_t *stats);
+
+/**
+ * @brief Clear the statistics of every site
+ */
+void prof_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PROF_H */
@@ -0,0 +1,78 @@
+/**
+ * @file pwm_out.c
+ * @brief PWM analog outputs implementation
+ *
+ * The timers are set up by hal_pwm_out_init(); here the outputs are the
+ * compare registers of the rows, nothing else. A duty past the period
+ * (CCR > ARR) holds the pin high, so BOARD_DAC_MAX_CODE is a steady VDD
+ * with the period BOARD_DAC_MAX_CODE - 1 counts.
+ */
+
+#include "pwm_out.h"
+
+#if BOARD_PWM_OUT_ENABLE
+
+#include "hal_config.h"
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define PWM_OUT_ROW_CCR(timer, channel, port, pin, af, map)  &(timer)->CCR##channel,
+
+/* ============================================================================
+ * PUBLIC VARIABLES
+ * ============================================================================ */
+
+volatile uint32_t *const pwm_out_ccr[PWM_OUT_COUNT] = {
+    BOARD_PWM_OUTPUTS(PWM_OUT_ROW_CCR)
+};
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+bool pwm_out_init(void)
+{
+    return hal_pwm_out_init();
+}
+
+bool pwm_out_set_code(uint32_t out, uint16_t code)
+{
+    if (out >= PWM_OUT_COUNT) {
+        return false;
+    }
+
+    pwm_out_write_fast(out, (code > BOARD_DAC_MAX_CODE) ? (uint16_t)BOARD_DAC_MAX_CODE : code);
+    return true;
+}
+
+bool pwm_out_set_millivolts(uint32_t out, uint32_t millivolts)
+{
+    uint32_t vdd_mv = dac_get_vdda_mv();
+
+    if (millivolts > vdd_mv) {
+        millivolts = vdd_mv;
+    }
+    return pwm_out_set_code(out, (uint16_t)((millivolts * BOARD_DAC_MAX_CODE + vdd_mv / 2U) / vdd_mv));
+}
+
+uint16_t pwm_out_get_code(uint32_t out)
+{
+    return (out < PWM_OUT_COUNT) ? (uint16_t)*pwm_out_ccr[out] : 0U;
+}
+
+bool pwm_out_get_transfer(dac_calibration_t *cal)
+{
+    uint32_t vdd_mv = dac_get_vdda_mv();
+
+    if (cal == NULL) {
+        return false;
+    }
+
+    cal->gain_q16 = ((BOARD_DAC_VREF_MV << 16) + vdd_mv / 2U) / vdd_mv;
+    cal->offset_q16 = 0;
+    return true;
+}
+
+#endif /* BOARD_PWM_OUT_ENABLE */
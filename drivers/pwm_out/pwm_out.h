@@ -0,0 +1,106 @@
+#ifndef PWM_OUT_H
+#define PWM_OUT_H
+
+/**
+ * @file pwm_out.h
+ * @brief PWM analog outputs on the timer channels
+ *
+ * Each row of BOARD_PWM_OUTPUTS is a timer channel in PWM mode 1 whose pin
+ * goes through an RC filter on the board. The counter runs at SYSCLK with
+ * a period of BOARD_DAC_MAX_CODE counts, so the compare value is the code
+ * of the DAC API: 0 is 0 V, BOARD_DAC_MAX_CODE is VDD, and the filtered
+ * output moves by VDD / BOARD_DAC_MAX_CODE per code like a DAC output.
+ *
+ * The compare registers are preloaded: a write takes effect at the next
+ * counter update, so no period is cut short or doubled, and costs one
+ * register store (pwm_out_write_fast()). Outputs are numbered in row
+ * order.
+ *
+ * Built only with BOARD_PWM_OUT_ENABLE.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board_config.h"
+#include "stm32l0xx_hal.h"  /* For the register fast path */
+#include "dac.h"            /* dac_calibration_t */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define PWM_OUT_ROW_COUNT(timer, channel, port, pin, af, map)  + 1U
+#define PWM_OUT_COUNT  (0U BOARD_PWM_OUTPUTS(PWM_OUT_ROW_COUNT))
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/* Compare register of each output, in row order */
+extern volatile uint32_t *const pwm_out_ccr[];
+
+/**
+ * @brief Initialize the PWM outputs (hal_pwm_out_init()), all at code 0
+ *
+ * @return true if initialization successful, false otherwise
+ */
+bool pwm_out_init(void);
+
+/**
+ * @brief Set the code of one output
+ *
+ * @param out Output index (row order)
+ * @param code 0..BOARD_DAC_MAX_CODE (clipped)
+ * @return true if set, false if there is no such output
+ */
+bool pwm_out_set_code(uint32_t out, uint16_t code);
+
+/**
+ * @brief Set one output in millivolts, at the VDDA the DAC is folded for
+ *
+ * @param out Output index (row order)
+ * @param millivolts Output voltage (clipped to VDD)
+ * @return true if set, false if there is no such output
+ */
+bool pwm_out_set_millivolts(uint32_t out, uint32_t millivolts);
+
+/**
+ * @brief Code of one output (the preloaded one, before its update)
+ *
+ * @param out Output index (row order)
+ * @return Code, 0 if there is no such output
+ */
+uint16_t pwm_out_get_code(uint32_t out);
+
+/**
+ * @brief Transfer of the outputs, in the dac_get_transfer() form
+ *
+ * Ideal code (0..VREF) to compare value: BOARD_DAC_VREF_MV / VDDA, no
+ * offset. The pins run from VDD, taken equal to VDDA on this board. Fold
+ * it again after dac_set_vdda_mv().
+ *
+ * @param cal Receives gain and offset
+ * @return true if successful, false otherwise
+ */
+bool pwm_out_get_transfer(dac_calibration_t *cal);
+
+/**
+ * @brief Register fast path: one preloaded compare store, any context
+ *
+ * @param out Output index, below PWM_OUT_COUNT (not checked)
+ * @param code 0..BOARD_DAC_MAX_CODE (not checked)
+ */
+static inline void pwm_out_write_fast(uint32_t out, uint16_t code)
+{
+    *pwm_out_ccr[out] = code;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PWM_OUT_H */
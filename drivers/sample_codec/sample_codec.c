@@ -0,0 +1,84 @@
+/**
+ * @file sample_codec.c
+ * @brief Delta/varint sample codec implementation
+ * 
+ * Differences are taken in uint32 arithmetic, so wrapping counters and
+ * full-range jumps still round-trip; the decoder adds them back modulo
+ * 2^32.
+ */
+
+#include "sample_codec.h"
+#include <string.h>
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static uint32_t sample_codec_zigzag(uint32_t diff)
+{
+    return (diff << 1) ^ (uint32_t)((int32_t)diff >> 31);
+}
+
+static uint32_t sample_codec_put_varint(uint8_t *dst, uint32_t value)
+{
+    uint32_t n = 0;
+    
+    while (value >= 0x80U) {
+        dst[n++] = (uint8_t)(value | 0x80U);
+        value >>= 7;
+    }
+    dst[n++] = (uint8_t)value;
+    return n;
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+void sample_codec_reset(sample_codec_t *codec)
+{
+    codec->since_key = 0;
+}
+
+uint32_t sample_codec_encode(sample_codec_t *codec, const sensor_data_t *sample, uint8_t *dst)
+{
+    uint32_t interval = sample->timestamp_us - codec->timestamp_us;
+    uint32_t gap = sample->sequence - codec->sequence - 1U;
+    uint32_t n = 0;
+    
+    /* Delta only against a known sample, with a gap the tag can carry */
+    if (codec->since_key != 0U && codec->since_key < BOARD_SAMPLE_CODEC_KEYFRAME_INTERVAL &&
+        gap < 0x80000000UL) {
+        uint8_t delta[4U * 5U];  /* Four varints of up to 5 bytes */
+        
+        n = sample_codec_put_varint(delta, gap << 1);
+        n += sample_codec_put_varint(&delta[n], sample_codec_zigzag(interval - codec->interval_us));
+        n += sample_codec_put_varint(&delta[n], sample_codec_zigzag((uint32_t)sample->pressure -
+                                                                    (uint32_t)codec->pressure));
+        n += sample_codec_put_varint(&delta[n], sample_codec_zigzag((uint32_t)sample->temperature -
+                                                                    (uint32_t)codec->temperature));
+        if (n < SAMPLE_CODEC_MAX_BYTES) {
+            for (uint32_t i = 0; i < n; i++) {
+                dst[i] = delta[i];
+            }
+            codec->interval_us = interval;
+            codec->since_key++;
+        } else {
+            n = 0;
+        }
+    }
+    
+    if (n == 0U) {
+        dst[0] = SAMPLE_CODEC_TAG_KEYFRAME;
+        memcpy(&dst[1], sample, SENSOR_RECORD_BYTES);  /* The sample record */
+        n = SAMPLE_CODEC_MAX_BYTES;
+        codec->interval_us = 0;
+        codec->since_key = 1U;
+    }
+    
+    codec->timestamp_us = sample->timestamp_us;
+    codec->sequence = sample->sequence;
+    codec->pressure = sample->pressure;
+    codec->temperature = sample->temperature;
+    return n;
+}
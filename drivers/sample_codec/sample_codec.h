@@ -0,0 +1,86 @@
+#ifndef SAMPLE_CODEC_H
+#define SAMPLE_CODEC_H
+
+/**
+ * @file sample_codec.h
+ * @brief Delta/varint sample codec for the FIFO, USB stream and SD log
+ * 
+ * Pressure and temperature move by a few counts per sample and the
+ * timestamp by the tick period plus jitter, so a sample is sent as small
+ * differences against the previous one, each zig-zag mapped to unsigned
+ * and packed as a varint (7 bits per byte, least significant first, bit 7
+ * set on every byte but the last). A typical sample takes 4-5 bytes
+ * instead of 16.
+ * 
+ * Encoded sample:
+ *   keyframe  tag 0x01, then the sample record (sensor_sampling.h):
+ *             timestamp_us uint32, sequence uint32, pressure int32,
+ *             temperature int32 (17 bytes, little-endian)
+ *   delta     tag varint((sequence - previous - 1) << 1), then
+ *             varint zigzag((timestamp - previous) - previous interval),
+ *             varint zigzag(pressure - previous),
+ *             varint zigzag(temperature - previous)
+ * The previous interval is 0 after a keyframe. A keyframe is sent for
+ * the first sample after sample_codec_reset(), every
+ * BOARD_SAMPLE_CODEC_KEYFRAME_INTERVAL samples, and whenever a delta would
+ * not be shorter. A decoder that joins mid-stream skips to the next
+ * keyframe; tools/sample_decode.py decodes every transport.
+ * 
+ * Transports carry it when built with BOARD_SAMPLE_CODEC_ENABLE, each
+ * container (FIFO frame, SD sector) starting with a keyframe.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board_config.h"
+#include "sensor_sampling.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+#define SAMPLE_CODEC_TAG_KEYFRAME  0x01U
+#define SAMPLE_CODEC_MAX_BYTES     17U  /* Keyframe: the longest encoding */
+
+/**
+ * @brief Encoder state: the previous sample of one stream
+ */
+typedef struct {
+    uint32_t timestamp_us;
+    uint32_t sequence;
+    int32_t pressure;
+    int32_t temperature;
+    uint32_t interval_us;  /* Previous timestamp difference */
+    uint32_t since_key;    /* Samples since the last keyframe, 0 = none yet */
+} sample_codec_t;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Start again: the next sample is a keyframe
+ * 
+ * @param codec Encoder state
+ */
+void sample_codec_reset(sample_codec_t *codec);
+
+/**
+ * @brief Encode one sample
+ * 
+ * @param codec  Encoder state, updated
+ * @param sample Sample to encode
+ * @param dst    At least SAMPLE_CODEC_MAX_BYTES bytes
+ * @return Bytes written (1..SAMPLE_CODEC_MAX_BYTES)
+ */
+uint32_t sample_codec_encode(sample_codec_t *codec, const sensor_data_t *sample, uint8_t *dst);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SAMPLE_CODEC_H */
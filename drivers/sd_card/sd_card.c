@@ -0,0 +1,400 @@
+/**
+ * @file sd_card.c
+ * @brief SD card block device (SPI mode) implementation
+ *
+ * Commands follow the simplified SD physical layer spec, SPI mode: CRC is
+ * only sent where the card checks it (CMD0, CMD8). Blocking waits are
+ * bounded on board_get_uptime_us(), which keeps counting without the HAL
+ * tick.
+ */
+
+#include "sd_card.h"
+#include "board_config.h"
+
+#if BOARD_SD_LOG_ENABLE
+
+#include "hal_config.h"
+#include "board_init.h"
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define SD_CMD0    0U   /* GO_IDLE_STATE */
+#define SD_CMD8    8U   /* SEND_IF_COND */
+#define SD_CMD16   16U  /* SET_BLOCKLEN */
+#define SD_CMD17   17U  /* READ_SINGLE_BLOCK */
+#define SD_CMD24   24U  /* WRITE_BLOCK */
+#define SD_CMD25   25U  /* WRITE_MULTIPLE_BLOCK */
+#define SD_CMD55   55U  /* APP_CMD */
+#define SD_CMD58   58U  /* READ_OCR */
+#define SD_ACMD    0x80U
+#define SD_ACMD23  (SD_ACMD | 23U)  /* SET_WR_BLK_ERASE_COUNT */
+#define SD_ACMD41  (SD_ACMD | 41U)  /* SD_SEND_OP_COND */
+
+#define SD_R1_IDLE           0x01U
+#define SD_TOKEN_SINGLE      0xFEU  /* Start block: reads, CMD24 */
+#define SD_TOKEN_MULTI       0xFCU  /* Start block: CMD25 */
+#define SD_TOKEN_STOP        0xFDU  /* End of CMD25 */
+#define SD_DATA_ACCEPTED     0x05U  /* Data response, low 5 bits */
+
+#define SD_INIT_TIMEOUT_US   1000000U  /* ACMD41 until out of idle */
+#define SD_READ_TIMEOUT_US   100000U   /* Start token of a read */
+#define SD_BUSY_TIMEOUT_US   500000U   /* Programming (SDXC worst case) */
+
+/**
+ * @brief Multi-block write steps
+ */
+typedef enum {
+    SD_STREAM_CLOSED = 0,
+    SD_STREAM_READY,
+    SD_STREAM_DATA,       /* Sector on the DMA */
+    SD_STREAM_PROGRAM,    /* Card busy programming it */
+    SD_STREAM_FAILED
+} sd_stream_step_t;
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static bool card_ready = false;
+static bool block_addressing = false;  /* SDHC/SDXC: sector numbers, else bytes */
+static sd_stream_step_t stream = SD_STREAM_CLOSED;
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Wait until the card releases the data line (0xFF)
+ */
+static bool sd_card_wait_ready(uint32_t timeout_us)
+{
+    uint32_t start = board_get_uptime_us();
+
+    while (hal_sd_spi_xfer(0xFFU) != 0xFFU) {
+        if (board_get_uptime_us() - start > timeout_us) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void sd_card_deselect(void)
+{
+    hal_sd_spi_select(false);
+    (void)hal_sd_spi_xfer(0xFFU);  /* The card releases MISO on the next clock */
+}
+
+static bool sd_card_select(void)
+{
+    hal_sd_spi_select(true);
+    (void)hal_sd_spi_xfer(0xFFU);
+    if (!sd_card_wait_ready(SD_BUSY_TIMEOUT_US)) {
+        sd_card_deselect();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Send a command (card selected), return R1 (bit 7 set: no answer)
+ */
+static uint8_t sd_card_command(uint8_t cmd, uint32_t arg)
+{
+    uint8_t crc = 0x01U;  /* Stop bit only: CRC off in SPI mode */
+    uint8_t r1;
+
+    if ((cmd & SD_ACMD) != 0U) {
+        cmd &= (uint8_t)~SD_ACMD;
+        r1 = sd_card_command(SD_CMD55, 0);
+        if (r1 > SD_R1_IDLE) {
+            return r1;
+        }
+    }
+
+    if (cmd == SD_CMD0) {
+        crc = 0x95U;
+    } else if (cmd == SD_CMD8) {
+        crc = 0x87U;
+    }
+
+    (void)hal_sd_spi_xfer((uint8_t)(0x40U | cmd));
+    (void)hal_sd_spi_xfer((uint8_t)(arg >> 24));
+    (void)hal_sd_spi_xfer((uint8_t)(arg >> 16));
+    (void)hal_sd_spi_xfer((uint8_t)(arg >> 8));
+    (void)hal_sd_spi_xfer((uint8_t)arg);
+    (void)hal_sd_spi_xfer(crc);
+
+    /* R1 within 8 bytes (NCR) */
+    for (uint32_t i = 0; i < 8U; i++) {
+        r1 = hal_sd_spi_xfer(0xFFU);
+        if ((r1 & 0x80U) == 0U) {
+            break;
+        }
+    }
+    return r1;
+}
+
+static uint32_t sd_card_address(uint32_t sector)
+{
+    return block_addressing ? sector : sector * SD_CARD_SECTOR_BYTES;
+}
+
+/**
+ * @brief Send one data block after its token, return the data response
+ */
+static bool sd_card_send_block(uint8_t token, const uint8_t *data)
+{
+    (void)hal_sd_spi_xfer(token);
+    for (uint32_t i = 0; i < SD_CARD_SECTOR_BYTES; i++) {
+        (void)hal_sd_spi_xfer(data[i]);
+    }
+    (void)hal_sd_spi_xfer(0xFFU);  /* CRC, not checked */
+    (void)hal_sd_spi_xfer(0xFFU);
+    return (hal_sd_spi_xfer(0xFFU) & 0x1FU) == SD_DATA_ACCEPTED;
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+bool sd_card_init(void)
+{
+    card_ready = false;
+    stream = SD_STREAM_CLOSED;
+    return hal_sd_spi_init();
+}
+
+bool sd_card_start(void)
+{
+    uint32_t start;
+    uint32_t arg = 0;
+    uint8_t ocr[4];
+    uint8_t r1 = 0xFFU;
+
+    if (stream != SD_STREAM_CLOSED) {
+        return false;
+    }
+    card_ready = false;
+    block_addressing = false;
+    hal_sd_spi_set_fast(false);
+
+    /* At least 74 clocks with CS high: the card enters SPI mode at CMD0 */
+    hal_sd_spi_select(false);
+    for (uint32_t i = 0; i < 10U; i++) {
+        (void)hal_sd_spi_xfer(0xFFU);
+    }
+
+    hal_sd_spi_select(true);
+    for (uint32_t i = 0; i < 4U && r1 != SD_R1_IDLE; i++) {
+        r1 = sd_card_command(SD_CMD0, 0);
+    }
+    if (r1 != SD_R1_IDLE) {
+        sd_card_deselect();
+        return false;  /* Empty slot */
+    }
+
+    /* Version 2 cards echo the check pattern and may be high capacity */
+    if (sd_card_command(SD_CMD8, 0x1AAU) == SD_R1_IDLE) {
+        for (uint32_t i = 0; i < 4U; i++) {
+            ocr[i] = hal_sd_spi_xfer(0xFFU);
+        }
+        if (ocr[2] != 0x01U || ocr[3] != 0xAAU) {
+            sd_card_deselect();
+            return false;  /* Voltage range not supported */
+        }
+        arg = 1UL << 30;  /* HCS */
+    }
+
+    start = board_get_uptime_us();
+    do {
+        r1 = sd_card_command(SD_ACMD41, arg);
+        if (board_get_uptime_us() - start > SD_INIT_TIMEOUT_US) {
+            sd_card_deselect();
+            return false;
+        }
+    } while (r1 != 0U);
+
+    if (arg != 0U) {
+        if (sd_card_command(SD_CMD58, 0) != 0U) {
+            sd_card_deselect();
+            return false;
+        }
+        for (uint32_t i = 0; i < 4U; i++) {
+            ocr[i] = hal_sd_spi_xfer(0xFFU);
+        }
+        block_addressing = (ocr[0] & 0x40U) != 0U;  /* CCS */
+    }
+    if (!block_addressing && sd_card_command(SD_CMD16, SD_CARD_SECTOR_BYTES) != 0U) {
+        sd_card_deselect();
+        return false;
+    }
+
+    sd_card_deselect();
+    hal_sd_spi_set_fast(true);
+    card_ready = true;
+    return true;
+}
+
+bool sd_card_is_ready(void)
+{
+    return card_ready;
+}
+
+bool sd_card_read(uint32_t sector, uint8_t *data, uint32_t count)
+{
+    uint32_t start;
+    uint8_t token;
+
+    if (!card_ready || stream != SD_STREAM_CLOSED) {
+        return false;
+    }
+
+    for (uint32_t n = 0; n < count; n++) {
+        if (!sd_card_select()) {
+            return false;
+        }
+        if (sd_card_command(SD_CMD17, sd_card_address(sector + n)) != 0U) {
+            sd_card_deselect();
+            return false;
+        }
+
+        start = board_get_uptime_us();
+        do {
+            token = hal_sd_spi_xfer(0xFFU);
+        } while (token == 0xFFU && board_get_uptime_us() - start <= SD_READ_TIMEOUT_US);
+        if (token != SD_TOKEN_SINGLE) {
+            sd_card_deselect();
+            return false;
+        }
+
+        for (uint32_t i = 0; i < SD_CARD_SECTOR_BYTES; i++) {
+            data[i] = hal_sd_spi_xfer(0xFFU);
+        }
+        (void)hal_sd_spi_xfer(0xFFU);  /* CRC, not checked */
+        (void)hal_sd_spi_xfer(0xFFU);
+        sd_card_deselect();
+        data += SD_CARD_SECTOR_BYTES;
+    }
+    return true;
+}
+
+bool sd_card_write(uint32_t sector, const uint8_t *data, uint32_t count)
+{
+    bool ok;
+
+    if (!card_ready || stream != SD_STREAM_CLOSED) {
+        return false;
+    }
+
+    for (uint32_t n = 0; n < count; n++) {
+        if (!sd_card_select()) {
+            return false;
+        }
+        ok = sd_card_command(SD_CMD24, sd_card_address(sector + n)) == 0U &&
+             sd_card_send_block(SD_TOKEN_SINGLE, data) &&
+             sd_card_wait_ready(SD_BUSY_TIMEOUT_US);
+        sd_card_deselect();
+        if (!ok) {
+            return false;
+        }
+        data += SD_CARD_SECTOR_BYTES;
+    }
+    return true;
+}
+
+bool sd_card_stream_begin(uint32_t sector, uint32_t count)
+{
+    if (!card_ready || stream != SD_STREAM_CLOSED || !sd_card_select()) {
+        return false;
+    }
+
+    /* Pre-erase lets the card program the run without per-block erases;
+     * a card that refuses it still takes the write */
+    if (count != 0U) {
+        (void)sd_card_command(SD_ACMD23, count);
+    }
+    if (sd_card_command(SD_CMD25, sd_card_address(sector)) != 0U) {
+        sd_card_deselect();
+        return false;
+    }
+
+    /* The card stays selected until sd_card_stream_end() */
+    stream = SD_STREAM_READY;
+    return true;
+}
+
+bool sd_card_stream_put(const uint8_t *data)
+{
+    if (stream != SD_STREAM_READY) {
+        return false;
+    }
+
+    (void)hal_sd_spi_xfer(SD_TOKEN_MULTI);
+    hal_sd_spi_tx_start(data, SD_CARD_SECTOR_BYTES);
+    stream = SD_STREAM_DATA;
+    return true;
+}
+
+sd_card_stream_t sd_card_stream_poll(void)
+{
+    switch (stream) {
+    case SD_STREAM_DATA:
+        if (!hal_sd_spi_tx_done()) {
+            return SD_CARD_STREAM_BUSY;
+        }
+        (void)hal_sd_spi_xfer(0xFFU);  /* CRC, not checked */
+        (void)hal_sd_spi_xfer(0xFFU);
+        if ((hal_sd_spi_xfer(0xFFU) & 0x1FU) != SD_DATA_ACCEPTED) {
+            stream = SD_STREAM_FAILED;
+            return SD_CARD_STREAM_ERROR;
+        }
+        stream = SD_STREAM_PROGRAM;
+        return SD_CARD_STREAM_BUSY;  /* Programming takes far longer than a byte */
+
+    case SD_STREAM_PROGRAM:
+        /* One byte per call: the card holds MISO low while busy */
+        if (hal_sd_spi_xfer(0xFFU) != 0xFFU) {
+            return SD_CARD_STREAM_BUSY;
+        }
+        stream = SD_STREAM_READY;
+        return SD_CARD_STREAM_READY;
+
+    case SD_STREAM_READY:
+        return SD_CARD_STREAM_READY;
+
+    default:
+        return SD_CARD_STREAM_ERROR;
+    }
+}
+
+bool sd_card_stream_end(void)
+{
+    bool ok;
+
+    if (stream == SD_STREAM_CLOSED) {
+        return false;
+    }
+
+    while (stream == SD_STREAM_DATA) {
+        (void)sd_card_stream_poll();
+    }
+    ok = (stream != SD_STREAM_FAILED) && sd_card_wait_ready(SD_BUSY_TIMEOUT_US);
+
+    /* Stop token, then the card is busy once more finishing the write */
+    (void)hal_sd_spi_xfer(SD_TOKEN_STOP);
+    (void)hal_sd_spi_xfer(0xFFU);
+    ok = sd_card_wait_ready(SD_BUSY_TIMEOUT_US) && ok;
+    sd_card_deselect();
+
+    stream = SD_STREAM_CLOSED;
+    return ok;
+}
+
+bool sd_card_is_idle(void)
+{
+    return stream != SD_STREAM_DATA;
+}
+
+#endif /* BOARD_SD_LOG_ENABLE */
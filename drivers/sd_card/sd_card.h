@@ -0,0 +1,134 @@
+#ifndef SD_CARD_H
+#define SD_CARD_H
+
+/**
+ * @file sd_card.h
+ * @brief SD card block device in SPI mode (SDSC, SDHC/SDXC)
+ *
+ * Blocking sector read and write for the file system, plus a streamed
+ * multi-block write (CMD25) for the logger: the card stays selected and
+ * in the write between sectors, each sector goes out by DMA and the card's
+ * programming busy is polled, so a sector costs the main loop a few byte
+ * exchanges. Nothing else may use the card while a stream is open.
+ *
+ * Sectors are 512 bytes, addressed by number for every card type.
+ * Built only with BOARD_SD_LOG_ENABLE (make USE_SD_LOG=1).
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+#define SD_CARD_SECTOR_BYTES  512U
+
+/**
+ * @brief State of an open multi-block write
+ */
+typedef enum {
+    SD_CARD_STREAM_READY = 0,  /* Next sector may be put */
+    SD_CARD_STREAM_BUSY,       /* Sector on the bus or being programmed */
+    SD_CARD_STREAM_ERROR       /* Sector rejected: end the stream */
+} sd_card_stream_t;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Configure the bus (hal_sd_spi_init()), no card access yet
+ *
+ * @return true if initialization successful, false otherwise
+ */
+bool sd_card_init(void);
+
+/**
+ * @brief Identify and initialize the card in the slot (blocking, up to ~1 s)
+ *
+ * Leaves the bus at the data rate.
+ *
+ * @return true if a card answered and is ready, false otherwise
+ */
+bool sd_card_start(void);
+
+/**
+ * @brief Card identified by the last sd_card_start()
+ *
+ * @return true if the card is ready
+ */
+bool sd_card_is_ready(void);
+
+/**
+ * @brief Read sectors (blocking)
+ *
+ * @param sector First sector
+ * @param data   count * SD_CARD_SECTOR_BYTES bytes
+ * @param count  Number of sectors
+ * @return true on success
+ */
+bool sd_card_read(uint32_t sector, uint8_t *data, uint32_t count);
+
+/**
+ * @brief Write sectors (blocking, until programmed)
+ *
+ * @param sector First sector
+ * @param data   count * SD_CARD_SECTOR_BYTES bytes
+ * @param count  Number of sectors
+ * @return true on success
+ */
+bool sd_card_write(uint32_t sector, const uint8_t *data, uint32_t count);
+
+/**
+ * @brief Open a multi-block write
+ *
+ * @param sector First sector
+ * @param count  Sectors about to be written, for pre-erase (0 = unknown)
+ * @return true if the card accepted the write
+ */
+bool sd_card_stream_begin(uint32_t sector, uint32_t count);
+
+/**
+ * @brief Start sending the next sector of the stream
+ *
+ * Only when sd_card_stream_poll() returned SD_CARD_STREAM_READY.
+ *
+ * @param data SD_CARD_SECTOR_BYTES bytes, untouched until the stream is
+ *             ready again
+ * @return true if started
+ */
+bool sd_card_stream_put(const uint8_t *data);
+
+/**
+ * @brief Advance the stream: a few byte exchanges at most, never waits
+ *
+ * @return Stream state
+ */
+sd_card_stream_t sd_card_stream_poll(void);
+
+/**
+ * @brief Wait for the last sector and close the stream (blocking)
+ *
+ * @return true if every sector put was accepted and programmed
+ */
+bool sd_card_stream_end(void);
+
+/**
+ * @brief No DMA on the bus
+ *
+ * STOP halts SPI2 and the DMA: STOP builds wait for this.
+ *
+ * @return true unless a sector is being sent
+ */
+bool sd_card_is_idle(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SD_CARD_H */
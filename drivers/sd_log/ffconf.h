@@ -0,0 +1,72 @@
+#ifndef FFCONF_H
+#define FFCONF_H
+
+/**
+ * @file ffconf.h
+ * @brief FatFs R0.12c configuration (BOARD_SD_LOG_ENABLE builds)
+ *
+ * Included by the vendored FatFs under this name. One volume (the SD
+ * card), 8.3 names, no heap, no RTOS locking: every call comes from the
+ * main loop (the host task in RTOS builds). _FS_TINY keeps one sector
+ * buffer per volume instead of one per file; the logger writes its data
+ * sectors itself, so only FAT and directory sectors go through it.
+ * f_expand() (_USE_EXPAND) pre-allocates the log file in one contiguous run.
+ */
+
+#define _FFCONF 68300  /* Revision ID, must match ff.h */
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+#define _FS_READONLY    0
+#define _FS_MINIMIZE    0
+#define _USE_STRFUNC    0
+#define _USE_FIND       0
+#define _USE_MKFS       0
+#define _USE_FASTSEEK   0
+#define _USE_EXPAND     1
+#define _USE_CHMOD      0
+#define _USE_LABEL      0
+#define _USE_FORWARD    0
+
+/* ============================================================================
+ * NAMESPACE AND LOCALE
+ * ============================================================================ */
+
+#define _CODE_PAGE      437
+#define _USE_LFN        0
+#define _MAX_LFN        255
+#define _LFN_UNICODE    0
+#define _STRF_ENCODE    3
+#define _FS_RPATH       0
+
+/* ============================================================================
+ * DRIVE AND VOLUME
+ * ============================================================================ */
+
+#define _VOLUMES        1
+#define _STR_VOLUME_ID  0
+#define _VOLUME_STRS    "SD"
+#define _MULTI_PARTITION 0
+#define _MIN_SS         512
+#define _MAX_SS         512
+#define _USE_TRIM       0
+#define _FS_NOFSINFO    0
+
+/* ============================================================================
+ * SYSTEM
+ * ============================================================================ */
+
+#define _FS_TINY        1
+#define _FS_EXFAT       0
+#define _FS_NORTC       1  /* No calendar: every file gets the date below */
+#define _NORTC_MON      1
+#define _NORTC_MDAY     1
+#define _NORTC_YEAR     2024
+#define _FS_LOCK        0
+#define _FS_REENTRANT   0
+#define _FS_TIMEOUT     1000
+#define _SYNC_t         void *
+
+#endif /* FFCONF_H */
@@ -0,0 +1,387 @@
+/**
+ * @file sd_log.c
+ * @brief SD card sample logger implementation
+ *
+ * FatFs only creates, pre-allocates and finally truncates the file; its
+ * data sectors are written here by sector number (the file is contiguous,
+ * so sector n of the file is first_sector + n). FatFs never caches a data
+ * sector of the file (_FS_TINY, no f_write), so nothing goes stale.
+ *
+ * Buffers: samples fill sectors[fill]; a full sector is queued and fill
+ * moves to the other buffer. With both queued (the card slower than the
+ * samples for a while) new samples are dropped and counted.
+ *
+ * With BOARD_CRC_FRAMING_ENABLE a queued sector gets a CRC-32 job
+ * (crc.h): the DMA channel feeds it to the CRC unit while the card is
+ * still busy with the one before, and the result is in place by the time
+ * the sector is put.
+ */
+
+#include "sd_log.h"
+
+#if BOARD_SD_LOG_ENABLE
+
+#include <stddef.h>
+#include <string.h>
+#include "ff.h"
+#include "ff_gen_drv.h"
+#include "sd_card.h"
+#include "board_init.h"
+#include "trace.h"
+#if BOARD_SAMPLE_CODEC_ENABLE
+#include "sample_codec.h"
+#endif
+#if BOARD_CRC_FRAMING_ENABLE
+#include "crc.h"
+#endif
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define SD_LOG_FILE_SECTORS  ((BOARD_SD_LOG_FILE_MB * 1024UL * 1024UL) / SD_CARD_SECTOR_BYTES)
+#define SD_LOG_FILE_MAX      99999UL  /* LOGnnnnn.BIN */
+#define SD_LOG_FLUSH_TIMEOUT_US  1000000U  /* Buffered sectors at stop */
+#define SD_LOG_PAYLOAD_BYTES  (SD_CARD_SECTOR_BYTES - 16U - SD_LOG_CRC_BYTES)
+
+#if BOARD_SD_LOG_FILE_MB < 1U || BOARD_SD_LOG_FILE_MB > 4095U
+#error "BOARD_SD_LOG_FILE_MB must be 1..4095 (FAT32 file size)"
+#endif
+
+/**
+ * @brief One sector, in file order: 16 + 31 x 16 = 512 bytes, or
+ *        16 + 492 (30 x 16 and padding) + 4 with a CRC
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t index;
+    uint32_t dropped;
+    uint32_t count;
+    struct {
+        uint8_t bytes[SD_LOG_PAYLOAD_BYTES];  /* Sample records, or encoded */
+    } payload;
+#if BOARD_CRC_FRAMING_ENABLE
+    uint32_t crc;  /* CRC-32 of the 508 bytes before it */
+#endif
+} sd_log_sector_t;
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static FATFS fs;
+static FIL file;
+static char fs_path[4];  /* Logical drive of the card, from FATFS_LinkDriver() */
+static char file_name[] = "LOG00000.BIN";
+
+static sd_log_sector_t sectors[2];
+static uint32_t fill = 0;          /* Buffer being filled */
+static uint32_t fill_count = 0;    /* Samples in it, 0 = not started */
+static uint32_t fill_bytes = 0;    /* Their payload bytes */
+#if BOARD_SAMPLE_CODEC_ENABLE
+static sample_codec_t codec;       /* Restarts with every sector */
+#endif
+static uint32_t queued = 0;        /* Full buffers, oldest first: 0..2 */
+static bool in_flight = false;     /* Oldest queued buffer on the card */
+static uint32_t first_sector = 0;  /* Card sector of file sector 0 */
+static uint32_t next_index = 0;    /* File sector of the next buffer to fill */
+
+static sd_log_stats_t stats;
+
+/* ============================================================================
+ * DISK I/O (FatFs driver, ff_gen_drv.h)
+ * ============================================================================ */
+
+static DSTATUS sd_log_disk_initialize(BYTE lun)
+{
+    (void)lun;
+    return sd_card_is_ready() ? 0 : STA_NOINIT;
+}
+
+static DSTATUS sd_log_disk_status(BYTE lun)
+{
+    (void)lun;
+    return sd_card_is_ready() ? 0 : STA_NOINIT;
+}
+
+static DRESULT sd_log_disk_read(BYTE lun, BYTE *buff, DWORD sector, UINT count)
+{
+    (void)lun;
+    return sd_card_read(sector, buff, count) ? RES_OK : RES_ERROR;
+}
+
+static DRESULT sd_log_disk_write(BYTE lun, const BYTE *buff, DWORD sector, UINT count)
+{
+    (void)lun;
+    return sd_card_write(sector, buff, count) ? RES_OK : RES_ERROR;
+}
+
+static DRESULT sd_log_disk_ioctl(BYTE lun, BYTE cmd, void *buff)
+{
+    (void)lun;
+    (void)buff;
+
+    /* Writes are programmed before they return: nothing to sync */
+    return (cmd == CTRL_SYNC) ? RES_OK : RES_PARERR;
+}
+
+static const Diskio_drvTypeDef sd_log_disk = {
+    sd_log_disk_initialize,
+    sd_log_disk_status,
+    sd_log_disk_read,
+    sd_log_disk_write,
+    sd_log_disk_ioctl
+};
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Queue the buffer being filled, move to the other
+ */
+static void sd_log_queue_fill(void)
+{
+    sd_log_sector_t *sector = &sectors[fill];
+
+    sector->count = fill_count;
+    if (fill_bytes < sizeof(sector->payload.bytes)) {
+        memset(&sector->payload.bytes[fill_bytes], 0xFF, sizeof(sector->payload.bytes) - fill_bytes);
+    }
+#if BOARD_CRC_FRAMING_ENABLE
+    (void)crc32_start(sector, offsetof(sd_log_sector_t, crc) / 4U, &sector->crc);
+#endif
+    queued++;
+    fill ^= 1U;
+    fill_count = 0;
+    fill_bytes = 0;
+}
+
+/**
+ * @brief Retire the sector the card finished, put the next queued one
+ *
+ * @return Stream state after the step
+ */
+static sd_card_stream_t sd_log_service(void)
+{
+    sd_card_stream_t state = sd_card_stream_poll();
+
+    if (state != SD_CARD_STREAM_READY) {
+        return state;
+    }
+
+    if (in_flight) {
+        in_flight = false;
+        queued--;
+        stats.sectors_written++;
+    }
+    if (queued != 0U) {
+        /* Oldest: the other buffer, or this one once both are queued */
+        uint32_t oldest = (queued == 2U) ? fill : (fill ^ 1U);
+
+#if BOARD_CRC_FRAMING_ENABLE
+        if (!crc32_poll()) {
+            return SD_CARD_STREAM_BUSY;  /* Its CRC still being fed */
+        }
+#endif
+
+        in_flight = sd_card_stream_put((const uint8_t *)&sectors[oldest]);
+        return in_flight ? SD_CARD_STREAM_BUSY : SD_CARD_STREAM_ERROR;
+    }
+    return SD_CARD_STREAM_READY;
+}
+
+/**
+ * @brief Create the next free LOGnnnnn.BIN, open for writing
+ */
+static bool sd_log_create_file(void)
+{
+    static uint32_t next_number = 0;
+    FILINFO info;
+
+    for (uint32_t number = next_number; number <= SD_LOG_FILE_MAX; number++) {
+        uint32_t digits = number;
+
+        for (uint32_t i = 7U; i >= 3U; i--) {
+            file_name[i] = (char)('0' + digits % 10U);
+            digits /= 10U;
+        }
+        if (f_stat(file_name, &info) != FR_NO_FILE) {
+            continue;
+        }
+        if (f_open(&file, file_name, FA_CREATE_NEW | FA_WRITE) != FR_OK) {
+            return false;
+        }
+        stats.file_number = number;
+        next_number = number + 1U;
+        return true;
+    }
+    return false;
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+bool sd_log_init(void)
+{
+    memset(&stats, 0, sizeof(stats));
+    if (!sd_card_init()) {
+        return false;
+    }
+    return FATFS_LinkDriver(&sd_log_disk, fs_path) == 0U;
+}
+
+bool sd_log_start(void)
+{
+    if (stats.state != SD_LOG_STATE_IDLE) {
+        return false;
+    }
+    if (!sd_card_start() || f_mount(&fs, fs_path, 1) != FR_OK) {
+        return false;
+    }
+
+    if (!sd_log_create_file()) {
+        (void)f_mount(NULL, fs_path, 0);
+        return false;
+    }
+
+    /* One contiguous run, recorded in the directory now: a power loss
+     * leaves a file of full size with the sectors written so far */
+    if (f_expand(&file, (FSIZE_t)SD_LOG_FILE_SECTORS * SD_CARD_SECTOR_BYTES, 1) != FR_OK ||
+        f_sync(&file) != FR_OK) {
+        (void)f_close(&file);
+        (void)f_unlink(file_name);  /* No contiguous run left: no empty file either */
+        (void)f_mount(NULL, fs_path, 0);
+        return false;
+    }
+    first_sector = fs.database + (file.obj.sclust - 2U) * fs.csize;
+
+    if (!sd_card_stream_begin(first_sector, SD_LOG_FILE_SECTORS)) {
+        (void)f_close(&file);
+        (void)f_mount(NULL, fs_path, 0);
+        return false;
+    }
+
+    fill = 0;
+    fill_count = 0;
+    fill_bytes = 0;
+    queued = 0;
+    in_flight = false;
+    next_index = 0;
+    stats.sectors_written = 0;
+    stats.samples = 0;
+    stats.dropped = 0;
+    stats.state = SD_LOG_STATE_RUNNING;
+    TRACE(TRACE_SD_LOG, stats.state, stats.file_number);
+    return true;
+}
+
+bool sd_log_stop(void)
+{
+    bool ok;
+
+    if (stats.state == SD_LOG_STATE_IDLE) {
+        return false;
+    }
+
+    if (stats.state == SD_LOG_STATE_RUNNING) {
+        uint32_t start = board_get_uptime_us();
+
+        /* Partial sector out too, then everything queued */
+        if (fill_count != 0U) {
+            sd_log_queue_fill();
+        }
+        while (queued != 0U && sd_log_service() != SD_CARD_STREAM_ERROR &&
+               board_get_uptime_us() - start <= SD_LOG_FLUSH_TIMEOUT_US) {
+        }
+    }
+    ok = sd_card_stream_end() && queued == 0U;
+
+    /* Keep only what was written; before this the size is the whole run */
+    ok = f_lseek(&file, (FSIZE_t)stats.sectors_written * SD_CARD_SECTOR_BYTES) == FR_OK &&
+         f_truncate(&file) == FR_OK && ok;
+    ok = f_close(&file) == FR_OK && ok;
+    (void)f_mount(NULL, fs_path, 0);
+
+    stats.state = SD_LOG_STATE_IDLE;
+    TRACE(TRACE_SD_LOG, stats.state, stats.sectors_written);
+    return ok;
+}
+
+void sd_log_push(const sensor_data_t *sample)
+{
+    sd_log_sector_t *sector = &sectors[fill];
+    if (stats.state != SD_LOG_STATE_RUNNING) {
+        return;
+    }
+
+    /* Both buffers waiting for the card, or the file full */
+    if (queued == 2U || (fill_count == 0U && next_index == SD_LOG_FILE_SECTORS)) {
+        stats.dropped++;
+        return;
+    }
+
+    if (fill_count == 0U) {
+        sector->magic = BOARD_SAMPLE_CODEC_ENABLE ? SD_LOG_MAGIC_CODEC : SD_LOG_MAGIC;
+        sector->index = next_index++;
+        sector->dropped = stats.dropped;
+#if BOARD_SAMPLE_CODEC_ENABLE
+        sample_codec_reset(&codec);
+#endif
+    }
+
+#if BOARD_SAMPLE_CODEC_ENABLE
+    fill_bytes += sample_codec_encode(&codec, sample, &sector->payload.bytes[fill_bytes]);
+    fill_count++;
+    stats.samples++;
+
+    if (sizeof(sector->payload.bytes) - fill_bytes < SAMPLE_CODEC_MAX_BYTES) {
+        sd_log_queue_fill();
+    }
+#else
+    /* The record, as the sampler wrote it */
+    memcpy(&sector->payload.bytes[fill_bytes], sample, SENSOR_RECORD_BYTES);
+    fill_bytes += SENSOR_RECORD_BYTES;
+    stats.samples++;
+
+    if (++fill_count == SD_LOG_SECTOR_SAMPLES) {
+        sd_log_queue_fill();
+    }
+#endif
+}
+
+void sd_log_poll(void)
+{
+    if (stats.state != SD_LOG_STATE_RUNNING) {
+        return;
+    }
+
+    if (sd_log_service() == SD_CARD_STREAM_ERROR) {
+        stats.state = SD_LOG_STATE_ERROR;
+        TRACE(TRACE_SD_LOG, stats.state, stats.sectors_written);
+        return;
+    }
+
+    /* Last sector of the run programmed: close the file */
+    if (stats.sectors_written == SD_LOG_FILE_SECTORS) {
+        (void)sd_log_stop();
+    }
+}
+
+bool sd_log_is_idle(void)
+{
+#if BOARD_CRC_FRAMING_ENABLE
+    if (!crc32_poll()) {
+        return false;
+    }
+#endif
+    return sd_card_is_idle();
+}
+
+void sd_log_get_stats(sd_log_stats_t *stats_out)
+{
+    *stats_out = stats;
+}
+
+#endif /* BOARD_SD_LOG_ENABLE */
@@ -0,0 +1,144 @@
+#ifndef SD_LOG_H
+#define SD_LOG_H
+
+/**
+ * @file sd_log.h
+ * @brief Sample logger to a FatFs file on the SD card
+ *
+ * A log is one file, LOGnnnnn.BIN in the root directory, pre-allocated
+ * with f_expand() to BOARD_SD_LOG_FILE_MB in one contiguous cluster run.
+ * From then on the file system is left alone: samples fill 512-byte
+ * sectors in two buffers, and each full sector goes to the card by DMA
+ * within one open multi-block write while the other buffer fills. FAT and
+ * directory are only written again when the log stops, which truncates the
+ * file to the sectors written.
+ *
+ * Sector (one per 31 samples, little-endian):
+ *   0   magic    uint32, SD_LOG_MAGIC
+ *   4   index    uint32, sector number within the file
+ *   8   dropped  uint32, samples dropped since the log started
+ *   12  count    uint32, samples in this sector (1..31, the last may be short)
+ *   16  samples  31 x 16-byte sample records (sensor_sampling.h), as in
+ *         usb_stream.h: timestamp_us uint32, sequence uint32, pressure
+ *         int32, temperature int32
+ * With BOARD_SAMPLE_CODEC_ENABLE the magic is SD_LOG_MAGIC_CODEC and the
+ * 496 bytes after the header hold count samples encoded by sample_codec.h
+ * (up to ~120), starting with a keyframe; the rest is 0xFF.
+ * With BOARD_CRC_FRAMING_ENABLE the last 4 bytes of every sector are a
+ * CRC-32 (crc.h) of the 508 before them: 30 samples per sector (the 12
+ * bytes after them 0xFF), or 492 bytes of encoded samples.
+ * A file cut off by a power loss keeps its full pre-allocated size: the
+ * log ends at the first sector whose magic or index does not match.
+ *
+ * Main loop only (the host task in RTOS builds). Built only with
+ * BOARD_SD_LOG_ENABLE (make USE_SD_LOG=1).
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board_config.h"
+#include "sensor_sampling.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+#define SD_LOG_MAGIC           0x474F4C53UL  /* "SLOG" */
+#define SD_LOG_MAGIC_CODEC     0x5A4F4C53UL  /* "SLOZ": samples encoded */
+#if BOARD_CRC_FRAMING_ENABLE
+#define SD_LOG_CRC_BYTES       4U
+#define SD_LOG_SECTOR_SAMPLES  30U
+#else
+#define SD_LOG_CRC_BYTES       0U
+#define SD_LOG_SECTOR_SAMPLES  31U
+#endif
+
+/**
+ * @brief Logger state
+ */
+typedef enum {
+    SD_LOG_STATE_IDLE = 0,   /* No file open */
+    SD_LOG_STATE_RUNNING,    /* Samples going to the file */
+    SD_LOG_STATE_ERROR       /* Card rejected a sector: stop to close the file */
+} sd_log_state_t;
+
+/**
+ * @brief Logger counters (since sd_log_start())
+ */
+typedef struct {
+    sd_log_state_t state;
+    uint32_t file_number;      /* nnnnn of LOGnnnnn.BIN */
+    uint32_t sectors_written;
+    uint32_t samples;          /* Samples logged */
+    uint32_t dropped;          /* Samples lost to both buffers full */
+} sd_log_stats_t;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Configure the card bus and register the card with FatFs
+ *
+ * No card access: a missing card is not an error here.
+ *
+ * @return true if initialization successful, false otherwise
+ */
+bool sd_log_init(void);
+
+/**
+ * @brief Start a log in the next free LOGnnnnn.BIN (blocking)
+ *
+ * Card identification, mount, file creation and pre-allocation: up to a
+ * few hundred milliseconds on a large card.
+ *
+ * @return true if the log is running, false if no card, no space or
+ *         already running
+ */
+bool sd_log_start(void);
+
+/**
+ * @brief Stop the log: write what is buffered and close the file (blocking)
+ *
+ * @return true if the file was closed with every sector written
+ */
+bool sd_log_stop(void);
+
+/**
+ * @brief Log one sample (buffered, never waits on the card)
+ *
+ * @param sample Sample read from the sampling ring
+ */
+void sd_log_push(const sensor_data_t *sample);
+
+/**
+ * @brief Advance the card writes: call after each batch of sd_log_push()
+ *
+ * Starts the next full sector when the card is ready; stops the log once
+ * the file is full.
+ */
+void sd_log_poll(void);
+
+/**
+ * @brief No DMA on the card bus
+ *
+ * @return true unless a sector is being sent (STOP would halt it)
+ */
+bool sd_log_is_idle(void);
+
+/**
+ * @brief Read the logger counters
+ *
+ * @param stats Filled with the current counters
+ */
+void sd_log_get_stats(sd_log_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SD_LOG_H */
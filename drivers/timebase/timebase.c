@@ -0,0 +1,312 @@
+/**
+ * @file timebase.c
+ * @brief Free-running microsecond timebase with one-shot deadlines implementation
+ * 
+ * The high half is the wrap count, the low half the TIM21 counter; a wrap
+ * flagged but not counted yet (read from a context that holds off the
+ * interrupt) is told by the count being in the low half of its range.
+ * CC2 compares the low half of the earliest deadline, so only a deadline
+ * less than one wrap away is armed on it; a later one is looked at again
+ * on each wrap. A deadline at or past the current time pends the interrupt
+ * instead of waiting for a compare that has gone by.
+ * 
+ * CC1 belongs to the sleeping waits: its interrupt is enabled only while
+ * one runs, and SEVONPEND lets the pending request wake WFE even where
+ * the interrupt itself is held off.
+ *
+ * Without the RTOS (whose kernel tick it is, rtos_tasks.c) the HAL tick
+ * comes from here too: HAL_InitTick() leaves SysTick stopped, so no
+ * 1 kHz interrupt wakes the main loop, and HAL_GetTick() counts whole
+ * milliseconds of the timebase from where the last call left off.
+ */
+
+#include "timebase.h"
+#include "board_config.h"
+#include "board_init.h"   /* For board_get_apb2_freq() */
+#include "stm32l0xx_hal.h"
+#include "hal_atomic.h"
+
+#include <stddef.h>
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define TIMEBASE_FREQ_HZ   1000000UL
+#define TIMEBASE_CHUNK_US  0x8000UL   /* Half the counter range: unambiguous wrapped difference */
+#define TIMEBASE_SR_FLAGS  (TIM_SR_UIF | TIM_SR_CC1IF | TIM_SR_CC2IF)
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static volatile uint32_t wraps = 0;
+static timebase_deadline_t *volatile head = NULL;  /* Earliest first */
+
+#if !BOARD_RTOS_ENABLE
+static uint32_t hal_tick_ms = 0;
+static uint32_t hal_tick_us = 0;  /* Timebase at hal_tick_ms */
+#endif
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Update DIER against the interrupt's own updates
+ */
+static void timebase_dier(uint32_t set, uint32_t clear)
+{
+    uint32_t primask = hal_crit_enter();
+    
+    TIM21->DIER = (TIM21->DIER & ~clear) | set;
+    hal_crit_exit(primask);
+}
+
+/**
+ * @brief Arm CC2 for the earliest deadline (interrupts masked)
+ */
+static void timebase_arm_next(void)
+{
+    const timebase_deadline_t *d = head;
+    uint32_t left;
+    
+    if (d == NULL) {
+        TIM21->DIER &= ~TIM_DIER_CC2IE;
+        return;
+    }
+    
+    left = d->at_us - timebase_now_us();
+    if ((int32_t)left > 0 && left <= 0xFFFFU) {
+        TIM21->CCR2 = (uint16_t)d->at_us;
+        TIM21->SR = ~TIM_SR_CC2IF;
+        TIM21->DIER |= TIM_DIER_CC2IE;
+        left = d->at_us - timebase_now_us();  /* The match may have gone by meanwhile */
+    } else {
+        TIM21->DIER &= ~TIM_DIER_CC2IE;
+    }
+    
+    if ((int32_t)left <= 0) {
+        NVIC_SetPendingIRQ(TIM21_IRQn);
+    }
+}
+
+/**
+ * @brief Take a deadline off the list (interrupts masked)
+ */
+static void timebase_unlink(timebase_deadline_t *deadline)
+{
+    timebase_deadline_t *volatile *link = &head;
+    
+    if (!deadline->armed) {
+        return;
+    }
+    while (*link != NULL && *link != deadline) {
+        link = &(*link)->next;
+    }
+    if (*link == deadline) {
+        *link = deadline->next;
+    }
+    deadline->armed = false;
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+void timebase_init(void)
+{
+    __HAL_RCC_TIM21_CLK_ENABLE();
+    
+    TIM21->CR1 = 0;
+    TIM21->PSC = (board_get_apb2_freq() / TIMEBASE_FREQ_HZ) - 1U;
+    TIM21->ARR = 0xFFFFU;
+    TIM21->EGR = TIM_EGR_UG;  /* Load the prescaler now */
+    TIM21->SR = 0;
+    TIM21->DIER = TIM_DIER_UIE;
+    wraps = 0;
+    head = NULL;
+    
+    SCB->SCR |= SCB_SCR_SEVONPEND_Msk;
+    HAL_NVIC_SetPriority(TIM21_IRQn, BOARD_IRQ_PRIO_TIM21, 0);
+    HAL_NVIC_EnableIRQ(TIM21_IRQn);
+    TIM21->CR1 = TIM_CR1_CEN;
+}
+
+uint32_t timebase_now_us(void)
+{
+    uint32_t primask;
+    uint32_t high;
+    uint32_t count;
+    
+    primask = hal_crit_enter();
+    high = wraps;
+    count = TIM21->CNT;
+    if ((TIM21->SR & TIM_SR_UIF) != 0U && count < 0x8000U) {
+        high++;
+    }
+    hal_crit_exit(primask);
+    
+    return (high << 16) | count;
+}
+
+uint16_t timebase_count(void)
+{
+    return (uint16_t)TIM21->CNT;
+}
+
+void timebase_delay_us(uint32_t us)
+{
+    while (us > 0U) {
+        uint32_t chunk = (us > TIMEBASE_CHUNK_US) ? TIMEBASE_CHUNK_US : us;
+        uint16_t start = (uint16_t)TIM21->CNT;
+        
+        while ((uint16_t)((uint16_t)TIM21->CNT - start) <= chunk) {
+        }
+        us -= chunk;
+    }
+}
+
+void timebase_sleep_us(uint32_t us)
+{
+    while (us > 0U) {
+        uint32_t chunk = (us > TIMEBASE_CHUNK_US) ? TIMEBASE_CHUNK_US : us;
+        uint16_t start = (uint16_t)TIM21->CNT;
+        
+        /* Clear a stale request first: SEVONPEND only signals a new one */
+        TIM21->CCR1 = (uint16_t)(start + chunk + 1U);
+        TIM21->SR = ~TIM_SR_CC1IF;
+        NVIC_ClearPendingIRQ(TIM21_IRQn);
+        timebase_dier(TIM_DIER_CC1IE, 0U);
+        
+        while ((uint16_t)((uint16_t)TIM21->CNT - start) <= chunk) {
+            __WFE();  /* Any event or interrupt wakes it: re-check */
+        }
+        
+        us -= chunk;
+    }
+    timebase_dier(0U, TIM_DIER_CC1IE);
+}
+
+bool timebase_deadline_at(timebase_deadline_t *deadline, uint32_t at_us,
+                          timebase_callback_t callback, void *context)
+{
+    timebase_deadline_t *volatile *link = &head;
+    uint32_t primask;
+    
+    if (deadline == NULL || callback == NULL) {
+        return false;
+    }
+    
+    primask = hal_crit_enter();
+    timebase_unlink(deadline);
+    deadline->at_us = at_us;
+    deadline->callback = callback;
+    deadline->context = context;
+    
+    /* After the ones due at the same time or earlier */
+    while (*link != NULL && (int32_t)((*link)->at_us - at_us) <= 0) {
+        link = &(*link)->next;
+    }
+    deadline->next = *link;
+    *link = deadline;
+    deadline->armed = true;
+    
+    if (head == deadline) {
+        timebase_arm_next();
+    }
+    hal_crit_exit(primask);
+    return true;
+}
+
+bool timebase_deadline_in(timebase_deadline_t *deadline, uint32_t delay_us,
+                          timebase_callback_t callback, void *context)
+{
+    return timebase_deadline_at(deadline, timebase_now_us() + delay_us, callback, context);
+}
+
+void timebase_deadline_cancel(timebase_deadline_t *deadline)
+{
+    uint32_t primask;
+    bool first;
+    
+    if (deadline == NULL) {
+        return;
+    }
+    
+    primask = hal_crit_enter();
+    first = (head == deadline);
+    timebase_unlink(deadline);
+    if (first) {
+        timebase_arm_next();
+    }
+    hal_crit_exit(primask);
+}
+
+void timebase_irq_handler(void)
+{
+    uint32_t sr = TIM21->SR;
+    
+    /* rc_w0 flags: only the ones read are cleared. CC1 is a sleeping
+     * wait's compare, woken by this entry */
+    TIM21->SR = ~(sr & TIMEBASE_SR_FLAGS);
+    if ((sr & TIM_SR_UIF) != 0U) {
+        wraps++;
+    }
+    
+    for (;;) {
+        uint32_t primask;
+        timebase_deadline_t *d;
+        
+        primask = hal_crit_enter();
+        d = head;
+        if (d != NULL && (int32_t)(d->at_us - timebase_now_us()) <= 0) {
+            head = d->next;
+            d->armed = false;
+        } else {
+            d = NULL;
+            timebase_arm_next();
+        }
+        hal_crit_exit(primask);
+        
+        if (d == NULL) {
+            break;
+        }
+        d->callback(d->context);
+    }
+}
+
+#if !BOARD_RTOS_ENABLE
+/* ============================================================================
+ * HAL TICK
+ * ============================================================================ */
+
+HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority)
+{
+    /* HAL_Init() and every clock change call this: SysTick stays off */
+    (void)TickPriority;
+    SysTick->CTRL = 0;
+    return HAL_OK;
+}
+
+uint32_t HAL_GetTick(void)
+{
+    uint32_t primask;
+    uint32_t elapsed;
+    uint32_t tick;
+    
+    /* Any context: the HAL polls it from handlers too. Calls more than a
+     * timebase wrap apart lose the wraps, which no HAL timeout spans */
+    primask = hal_crit_enter();
+    elapsed = timebase_now_us() - hal_tick_us;
+    if (elapsed >= 1000U) {
+        uint32_t ms = elapsed / 1000U;
+        
+        hal_tick_ms += ms;
+        hal_tick_us += ms * 1000U;
+    }
+    tick = hal_tick_ms;
+    hal_crit_exit(primask);
+    return tick;
+}
+#endif
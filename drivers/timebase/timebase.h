@@ -0,0 +1,124 @@
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+/**
+ * @file timebase.h
+ * @brief Free-running microsecond timebase with one-shot deadlines
+ * 
+ * TIM21 counts at 1 MHz from PCLK2 over its 16-bit range and its update
+ * interrupt extends it to 32 bits (wraps after ~71.6 minutes): one source
+ * for boot timing, timeouts, the board delays and short deadlines,
+ * started by board_init_clock() and independent of the sampling tick.
+ * Deadlines are one-shot callbacks at an absolute time, kept in a list
+ * sorted by time; the earliest one is armed on TIM21 CC2 and its callback
+ * runs from the TIM21 interrupt (BOARD_IRQ_PRIO_TIM21), within a
+ * microsecond or two of its time plus the interrupt entry. Callbacks keep
+ * to a few stores and may start deadlines again.
+ * 
+ * It is also the HAL tick (HAL_GetTick()) in builds without the RTOS,
+ * with SysTick left off. The counter halts in STOP. The sample timestamps
+ * stay with the sampling timebase (hal_tim2_get_timestamp_us()), and the
+ * profiler with its cycle counter (prof.h).
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+/**
+ * @brief Deadline callback (TIM21 interrupt context)
+ */
+typedef void (*timebase_callback_t)(void *context);
+
+/**
+ * @brief One deadline (storage owned by the caller, untouched while armed)
+ */
+typedef struct timebase_deadline {
+    struct timebase_deadline *next;
+    uint32_t at_us;
+    timebase_callback_t callback;
+    void *context;
+    volatile bool armed;
+} timebase_deadline_t;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Start TIM21 at 1 MHz and enable its interrupt
+ * 
+ * Called by board_init_clock() once the clock tree is set.
+ */
+void timebase_init(void);
+
+/**
+ * @brief Microseconds since timebase_init()
+ * 
+ * Any context; coherent across a wrap not yet counted.
+ */
+uint32_t timebase_now_us(void);
+
+/**
+ * @brief Low 16 bits of the timebase (one register read)
+ * 
+ * For spans under 65 ms taken as a wrapped difference, where
+ * timebase_now_us() costs too much (interrupt entry and exit times).
+ */
+uint16_t timebase_count(void);
+
+/**
+ * @brief Spin for at least us microseconds (at most one more, plus the call)
+ */
+void timebase_delay_us(uint32_t us);
+
+/**
+ * @brief Wait for at least us microseconds in WFE
+ * 
+ * The CC1 compare wakes the core (SEVONPEND, also from a context that
+ * masks the TIM21 interrupt); other interrupts are served meanwhile.
+ */
+void timebase_sleep_us(uint32_t us);
+
+/**
+ * @brief Arm a deadline (re-arms one already armed)
+ * 
+ * A time already past runs the callback from the interrupt at once.
+ * 
+ * @param deadline Caller storage
+ * @param at_us Absolute time (timebase_now_us()), within 2^31 us
+ * @param callback Called once, from the TIM21 interrupt
+ * @param context Passed to the callback
+ * @return true if armed, false on a NULL argument
+ */
+bool timebase_deadline_at(timebase_deadline_t *deadline, uint32_t at_us,
+                          timebase_callback_t callback, void *context);
+
+/**
+ * @brief Arm a deadline delay_us from now
+ */
+bool timebase_deadline_in(timebase_deadline_t *deadline, uint32_t delay_us,
+                          timebase_callback_t callback, void *context);
+
+/**
+ * @brief Disarm a deadline (no effect if it has run or was never armed)
+ */
+void timebase_deadline_cancel(timebase_deadline_t *deadline);
+
+/**
+ * @brief TIM21 interrupt work (call from TIM21_IRQHandler)
+ */
+void timebase_irq_handler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIMEBASE_H */
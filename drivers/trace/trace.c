@@ -0,0 +1,154 @@
+/**
+ * @file trace.c
+ * @brief Deferred-format binary trace implementation
+ *
+ * Sites run at every interrupt priority, so the push is masked: the slot,
+ * the sequence number and the decision to start the DMA are one step.
+ * The DMA sends the oldest records as one contiguous run (up to the end of
+ * the ring) and frees them when it completes, so a record is never
+ * overwritten while it is on the wire.
+ */
+
+#include "trace.h"
+
+#if BOARD_TRACE_ENABLE
+
+#include "hal_config.h"
+#include "stm32l0xx_hal.h"
+#include "hal_atomic.h"
+#include <string.h>
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define TRACE_RING_MASK  (BOARD_TRACE_RING_RECORDS - 1U)
+
+#if (BOARD_TRACE_RING_RECORDS & TRACE_RING_MASK) != 0U || BOARD_TRACE_RING_RECORDS < 2U
+#error "BOARD_TRACE_RING_RECORDS must be a power of two"
+#endif
+
+/**
+ * @brief One record, in wire order (trace.h)
+ */
+typedef struct {
+    uint8_t sync;
+    uint8_t id;
+    uint16_t seq;
+    uint32_t timestamp_us;
+    uint32_t a;
+    uint32_t b;
+} trace_record_t;
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static trace_record_t ring[BOARD_TRACE_RING_RECORDS];
+static uint32_t head = 0;      /* Next free slot */
+static uint32_t tail = 0;      /* Oldest record not sent yet */
+static uint32_t in_flight = 0; /* Records on the DMA, from tail */
+static uint16_t seq = 0;
+static bool started = false;
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Send the oldest run of records, if any (masked)
+ */
+static void trace_tx_next(void)
+{
+    uint32_t index = tail & TRACE_RING_MASK;
+    uint32_t count = head - tail;
+
+    if (count > BOARD_TRACE_RING_RECORDS - index) {
+        count = BOARD_TRACE_RING_RECORDS - index;  /* Rest after the wrap */
+    }
+    in_flight = count;
+    if (count != 0U) {
+        hal_trace_tx_start(&ring[index], count * sizeof(trace_record_t));
+    }
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+bool trace_init(void)
+{
+    if (!hal_trace_init()) {
+        return false;
+    }
+
+    head = 0;
+    tail = 0;
+    in_flight = 0;
+    started = true;
+    return true;
+}
+
+void trace_write(trace_id_t id, uint32_t a, uint32_t b)
+{
+    uint32_t timestamp_us = hal_tim2_get_timestamp_us();
+    trace_record_t *record;
+    uint32_t primask = hal_crit_enter();
+
+    seq++;
+    if (!started || head - tail >= BOARD_TRACE_RING_RECORDS) {
+        hal_crit_exit(primask);
+        return;  /* Dropped: the sequence gap tells the decoder */
+    }
+
+    record = &ring[head & TRACE_RING_MASK];
+    record->sync = TRACE_SYNC;
+    record->id = (uint8_t)id;
+    record->seq = seq;
+    record->timestamp_us = timestamp_us;
+    record->a = a;
+    record->b = b;
+    head++;
+
+    if (in_flight == 0U) {
+        trace_tx_next();
+    }
+    hal_crit_exit(primask);
+}
+
+void trace_dma_irq_handler(void)
+{
+    uint32_t primask;
+
+    if (!hal_trace_tx_done()) {
+        return;
+    }
+
+    primask = hal_crit_enter();
+    tail += in_flight;
+    trace_tx_next();
+    hal_crit_exit(primask);
+}
+
+bool trace_is_idle(void)
+{
+    return head == tail && hal_trace_tx_idle();
+}
+
+uint32_t trace_copy_last(uint8_t *out, uint32_t max_records)
+{
+    uint32_t count = (head < BOARD_TRACE_RING_RECORDS) ? head : BOARD_TRACE_RING_RECORDS;
+
+    if (count > max_records) {
+        count = max_records;
+    }
+    /* Only pushes advance head, so a record behind it stays whole until
+     * the ring wraps onto it */
+    for (uint32_t i = 0; i < count; i++) {
+        memcpy(&out[i * sizeof(trace_record_t)],
+               &ring[(head - count + i) & TRACE_RING_MASK], sizeof(trace_record_t));
+    }
+    return count;
+}
+
+#endif /* BOARD_TRACE_ENABLE */
@@ -0,0 +1,124 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+/**
+ * @file trace.h
+ * @brief Deferred-format binary trace over LPUART1
+ *
+ * A site is a TRACE(id, a, b) call: the ID, the microsecond timestamp and
+ * two integer arguments go into a RAM ring as one 16-byte record, and DMA
+ * sends the ring over LPUART1 TX in the background. Nothing is formatted
+ * on the target; tools/trace_decode.py reads the format string of each ID
+ * from the comments of trace_id_t below and prints the records.
+ *
+ * Record on the wire (little-endian):
+ *   0  sync   TRACE_SYNC
+ *   1  id     trace_id_t
+ *   2  seq    uint16, one per TRACE() call: a gap counts dropped records
+ *   4  time   uint32, hal_tim2_get_timestamp_us()
+ *   8  a      uint32
+ *   12 b      uint32
+ *
+ * Callable from any context. A push is a short masked section (tens of
+ * cycles); with the ring full the record is dropped, never waited for.
+ * Built only with BOARD_TRACE_ENABLE: otherwise TRACE() expands to nothing.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * TYPES
+ * ============================================================================ */
+
+#define TRACE_SYNC  0xA5U  /* First byte of every record */
+
+/**
+ * @brief Trace IDs, each with the format of its two arguments
+ *
+ * Keep one entry per line with the format as a string in the comment:
+ * tools/trace_decode.py parses them from here.
+ */
+typedef enum {
+    TRACE_BOOT = 0,           /* "boot: drivers up at %u us, app at %u us" */
+    TRACE_I2C_SLAVE_ERROR,    /* "i2c1 slave error 0x%x in state %u" */
+    TRACE_HOST_COMMAND,       /* "host command %u -> result %u" */
+    TRACE_SENSOR_STATUS,      /* "sensor status %u (was %u)" */
+    TRACE_DAC_FAULT,          /* "dac fault mask 0x%x (was 0x%x)" */
+    TRACE_SD_LOG,             /* "sd log state %u, file/sectors %u" */
+    TRACE_FAULT,              /* "fault before boot: kind %u at 0x%x" */
+    TRACE_BENCH_ROW,          /* "bench step %u: %u centi-Hz" */
+    TRACE_I2C_SLAVE_THROTTLE, /* "i2c1 slave throttled at %u us in the window, %u times" */
+    TRACE_ID_COUNT
+} trace_id_t;
+
+/* ============================================================================
+ * MACROS
+ * ============================================================================ */
+
+#if BOARD_TRACE_ENABLE
+/** Record a trace point with two integer arguments */
+#define TRACE(id, a, b)  trace_write((id), (uint32_t)(a), (uint32_t)(b))
+#else
+#define TRACE(id, a, b)  ((void)0)
+#endif
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Start the trace output (LPUART1, DMA) with an empty ring
+ *
+ * Records pushed before are dropped. Call after the clock is configured.
+ *
+ * @return true if initialization successful, false otherwise
+ */
+bool trace_init(void);
+
+/**
+ * @brief Push one record (use TRACE())
+ *
+ * @param id Trace ID
+ * @param a  First argument
+ * @param b  Second argument
+ */
+void trace_write(trace_id_t id, uint32_t a, uint32_t b);
+
+/**
+ * @brief DMA transfer complete: send what was pushed meanwhile
+ *
+ * Call from the BOARD_TRACE_DMA_IRQn handler.
+ */
+void trace_dma_irq_handler(void);
+
+/**
+ * @brief Nothing queued or on the wire
+ *
+ * STOP halts LPUART1 and the DMA: STOP builds wait for this.
+ *
+ * @return true if the ring is empty and the last byte is out
+ */
+bool trace_is_idle(void);
+
+/**
+ * @brief Copy the newest records, sent or not, oldest first
+ *
+ * For the fault handler (fault.h): reads the ring unmasked.
+ *
+ * @param out Receives the records in wire order, 16 bytes each
+ * @param max_records Records out has room for
+ * @return Records copied
+ */
+uint32_t trace_copy_last(uint8_t *out, uint32_t max_records);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRACE_H */
@@ -0,0 +1,386 @@
+/**
+ * @file uart_stream.c
+ * @brief COBS-framed UART sample stream implementation
+ *
+ * A block holds the frame one byte in, so the encoder runs in place: each
+ * zero becomes the length of the run before it, the first length going
+ * into the spare byte, and a frame under 255 bytes needs no other code
+ * byte. Samples are never copied again once in a block.
+ *
+ * TX as in the USB stream: the main loop fills a block and moves it to
+ * the send queue under the UART interrupt mask; the DMA interrupt frees
+ * the block on the wire and starts the next. RX: the USART2 and DMA
+ * interrupts (one priority, so never nested) decode the new bytes of the
+ * circular buffer into command slots; the main loop checks the CRC, the
+ * CRC unit being its own.
+ */
+
+#include "uart_stream.h"
+
+#if BOARD_UART_STREAM_ENABLE
+
+#include <stddef.h>
+#include <string.h>
+#include "pool.h"
+#include "crc.h"
+#include "hal_config.h"
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define UART_STREAM_BLOCK_BYTES  (UART_STREAM_FRAME_MAX + 2U)  /* Code byte, frame, delimiter */
+#define UART_STREAM_SLOTS        4U                            /* Commands awaiting the CRC check */
+#define UART_STREAM_SLOT_MASK    (UART_STREAM_SLOTS - 1U)
+
+#if BOARD_UART_STREAM_BLOCK_SAMPLES < 1U || \
+    UART_STREAM_HEADER_BYTES + BOARD_UART_STREAM_BLOCK_SAMPLES * UART_STREAM_SAMPLE_BYTES + \
+    UART_STREAM_CRC_BYTES > UART_STREAM_FRAME_MAX
+#error "BOARD_UART_STREAM_BLOCK_SAMPLES must give a frame of 254 bytes at most"
+#endif
+
+/**
+ * @brief Command frame as decoded, awaiting the CRC check
+ */
+typedef struct {
+    uint8_t bytes[UART_STREAM_COMMAND_BYTES];
+    uint32_t timestamp_us;
+} uart_stream_slot_t;
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+POOL_STORAGE(block_storage, UART_STREAM_BLOCK_BYTES, BOARD_UART_STREAM_BLOCKS);
+static pool_t block_pool;
+
+static uint8_t *filling = NULL;             /* Main loop only, frame from byte 1 */
+static uint16_t filling_len = 0;            /* Frame bytes in it */
+static uint8_t *queue[BOARD_UART_STREAM_BLOCKS];
+static uint16_t queue_bytes[BOARD_UART_STREAM_BLOCKS];  /* Encoded length of each */
+static volatile uint32_t queue_head = 0;    /* Next free entry */
+static volatile uint32_t queue_tail = 0;    /* Oldest block, on the wire if sending */
+static volatile bool sending = false;
+static uint16_t frame_seq = 0;
+static bool started = false;
+
+/* RX, UART interrupts */
+static uint8_t rx_buffer[BOARD_UART_STREAM_RX_BYTES];
+static uint32_t rx_pos = 0;                 /* Next byte to decode */
+static uint8_t rx_frame[UART_STREAM_COMMAND_BYTES];
+static uint32_t rx_len = 0;                 /* Decoded bytes of the frame so far */
+static uint32_t rx_run = 0;                 /* Bytes left in the current COBS run */
+static bool rx_zero = false;                /* A zero follows the current run */
+static bool rx_long = false;                /* Frame longer than a command */
+static uart_stream_rx_callback_t rx_callback = NULL;
+
+static uart_stream_slot_t slots[UART_STREAM_SLOTS];
+static volatile uint32_t slot_head = 0;     /* Written by the UART interrupts */
+static volatile uint32_t slot_tail = 0;     /* Written by the main loop */
+
+static uint32_t frames = 0;
+static uint32_t dropped = 0;
+static uint32_t commands = 0;
+static uint32_t crc_errors = 0;
+static volatile uint32_t length_errors = 0;
+static volatile uint32_t rx_overruns = 0;
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static void uart_stream_put_u16(uint8_t *dst, uint16_t value)
+{
+    dst[0] = (uint8_t)(value & 0xFF);
+    dst[1] = (uint8_t)((value >> 8) & 0xFF);
+}
+
+/**
+ * @brief COBS-encode a frame in place and terminate it
+ *
+ * @param block Block with the frame from byte 1
+ * @param len Frame bytes (UART_STREAM_FRAME_MAX at most: one run)
+ * @return Bytes on the wire, delimiter included
+ */
+static uint16_t uart_stream_cobs_encode(uint8_t *block, uint32_t len)
+{
+    uint32_t code_at = 0;
+
+    for (uint32_t i = 1; i <= len; i++) {
+        if (block[i] == 0U) {
+            block[code_at] = (uint8_t)(i - code_at);
+            code_at = i;
+        }
+    }
+    block[code_at] = (uint8_t)(len + 1U - code_at);
+    block[len + 1U] = 0U;
+    return (uint16_t)(len + 2U);
+}
+
+/**
+ * @brief Start the oldest queued block, if idle (DMA interrupt or masked)
+ */
+static void uart_stream_tx_next(void)
+{
+    if (sending || queue_head == queue_tail) {
+        return;
+    }
+
+    hal_uart_stream_tx_start(queue[queue_tail % BOARD_UART_STREAM_BLOCKS],
+                             queue_bytes[queue_tail % BOARD_UART_STREAM_BLOCKS]);
+    sending = true;
+}
+
+/**
+ * @brief Take a block for a new frame and write its header (main loop)
+ *
+ * @return The block, NULL with every block queued
+ */
+static uint8_t *uart_stream_frame_begin(uint8_t type)
+{
+    uint8_t *block = (uint8_t *)pool_alloc(&block_pool);
+
+    if (block == NULL) {
+        return NULL;
+    }
+    block[1] = type;
+    block[2] = 0;
+    uart_stream_put_u16(&block[3], frame_seq++);
+    return block;
+}
+
+/**
+ * @brief Close a frame and move it to the send queue (main loop)
+ *
+ * @param block Block from uart_stream_frame_begin()
+ * @param len Frame bytes before the CRC
+ */
+static void uart_stream_enqueue(uint8_t *block, uint32_t len)
+{
+    uint16_t bytes;
+    uint32_t masked;
+
+    uart_stream_put_u16(&block[1U + len], crc16_update(CRC16_INIT, &block[1], len));
+    bytes = uart_stream_cobs_encode(block, len + UART_STREAM_CRC_BYTES);
+
+    masked = hal_irq_mask(HAL_IRQ_LINES_UART_STREAM);
+
+    /* A block always fits: the queue has one entry per pool block */
+    queue[queue_head % BOARD_UART_STREAM_BLOCKS] = block;
+    queue_bytes[queue_head % BOARD_UART_STREAM_BLOCKS] = bytes;
+    queue_head++;
+    uart_stream_tx_next();
+    hal_irq_unmask(masked);
+    frames++;
+}
+
+/**
+ * @brief Decode one received byte (UART interrupts)
+ *
+ * @return true if it completed a command frame
+ */
+static bool uart_stream_rx_byte(uint8_t byte)
+{
+    bool queued = false;
+
+    if (byte == 0U) {
+        /* Delimiter: an empty frame (a leading flush) is not an error */
+        if (rx_len == UART_STREAM_COMMAND_BYTES && rx_run == 0U && !rx_long) {
+            if (slot_head - slot_tail < UART_STREAM_SLOTS) {
+                uart_stream_slot_t *slot = &slots[slot_head & UART_STREAM_SLOT_MASK];
+
+                for (uint32_t i = 0; i < UART_STREAM_COMMAND_BYTES; i++) {
+                    slot->bytes[i] = rx_frame[i];
+                }
+                slot->timestamp_us = hal_tim2_get_timestamp_us();
+                slot_head++;  /* Publish once the slot is complete */
+                queued = true;
+            } else {
+                rx_overruns++;
+            }
+        } else if (rx_len != 0U || rx_run != 0U || rx_long) {
+            length_errors++;
+        }
+        rx_len = 0;
+        rx_run = 0;
+        rx_zero = false;
+        rx_long = false;
+        return queued;
+    }
+
+    if (rx_run == 0U) {
+        /* Code byte: the zero the last run ended in, then a new run */
+        if (rx_zero) {
+            if (rx_len < UART_STREAM_COMMAND_BYTES) {
+                rx_frame[rx_len++] = 0U;
+            } else {
+                rx_long = true;
+            }
+        }
+        rx_run = byte - 1U;
+        rx_zero = byte != 0xFFU;
+        return false;
+    }
+
+    if (rx_len < UART_STREAM_COMMAND_BYTES) {
+        rx_frame[rx_len++] = byte;
+    } else {
+        rx_long = true;
+    }
+    rx_run--;
+    return false;
+}
+
+/**
+ * @brief Decode everything the RX DMA wrote since the last call
+ */
+static void uart_stream_rx_drain(void)
+{
+    uint32_t pos = hal_uart_stream_rx_pos();
+    bool queued = false;
+
+    while (rx_pos != pos) {
+        queued = uart_stream_rx_byte(rx_buffer[rx_pos]) || queued;
+        rx_pos = (rx_pos + 1U) % BOARD_UART_STREAM_RX_BYTES;
+    }
+    if (queued && rx_callback != NULL) {
+        rx_callback();
+    }
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+bool uart_stream_init(void)
+{
+    if (!pool_init(&block_pool, block_storage, UART_STREAM_BLOCK_BYTES,
+                   BOARD_UART_STREAM_BLOCKS)) {
+        return false;
+    }
+
+    rx_pos = 0;
+    if (!hal_uart_stream_init(rx_buffer)) {
+        return false;
+    }
+
+    started = true;
+    return true;
+}
+
+void uart_stream_register_rx_callback(uart_stream_rx_callback_t callback)
+{
+    rx_callback = callback;
+}
+
+void uart_stream_push(const sensor_data_t *sample)
+{
+    uint8_t *slot;
+
+    if (!started) {
+        return;
+    }
+
+    if (filling == NULL) {
+        filling = uart_stream_frame_begin(UART_STREAM_TYPE_SAMPLES);
+        if (filling == NULL) {
+            dropped++;
+            return;  /* Every block queued: the sequence gap tells the host */
+        }
+        filling_len = UART_STREAM_HEADER_BYTES;
+    }
+
+    slot = &filling[1U + filling_len];
+    memcpy(slot, sample, SENSOR_RECORD_BYTES);  /* The record, as the sampler wrote it */
+    filling_len += UART_STREAM_SAMPLE_BYTES;
+    filling[2]++;
+
+    /* A full frame goes at once; a partial one only rides an idle line */
+    if (filling[2] == BOARD_UART_STREAM_BLOCK_SAMPLES || !sending) {
+        uart_stream_enqueue(filling, filling_len);
+        filling = NULL;
+    }
+}
+
+bool uart_stream_send_result(uint8_t result, uint8_t count)
+{
+    uint8_t *block;
+
+    if (!started) {
+        return false;
+    }
+
+    block = uart_stream_frame_begin(UART_STREAM_TYPE_RESULT);
+    if (block == NULL) {
+        dropped++;
+        return false;
+    }
+    block[2] = count;
+    block[1U + UART_STREAM_HEADER_BYTES] = result;
+    uart_stream_enqueue(block, UART_STREAM_HEADER_BYTES + 1U);
+    return true;
+}
+
+bool uart_stream_get_command(uart_stream_command_t *command)
+{
+    if (command == NULL) {
+        return false;
+    }
+
+    while (slot_tail != slot_head) {
+        const uart_stream_slot_t *slot = &slots[slot_tail & UART_STREAM_SLOT_MASK];
+        const uint8_t *b = slot->bytes;
+        bool ok;
+
+        command->argument = (uint32_t)b[0] | ((uint32_t)b[1] << 8) |
+                            ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+        command->opcode = b[4];
+        command->crc = (uint16_t)(b[5] | (b[6] << 8));
+        command->timestamp_us = slot->timestamp_us;
+        ok = crc16_update(CRC16_INIT, b, 5U) == command->crc;
+        slot_tail++;  /* Slot free once read */
+
+        if (ok) {
+            commands++;
+            return true;
+        }
+        crc_errors++;
+    }
+    return false;
+}
+
+void uart_stream_irq_handler(void)
+{
+    uart_stream_rx_drain();
+}
+
+void uart_stream_dma_irq_handler(void)
+{
+    if (hal_uart_stream_tx_done()) {
+        (void)pool_free(&block_pool, queue[queue_tail % BOARD_UART_STREAM_BLOCKS]);
+        queue_tail++;
+        sending = false;
+        uart_stream_tx_next();
+    }
+    uart_stream_rx_drain();
+}
+
+bool uart_stream_is_active(void)
+{
+    return started;
+}
+
+void uart_stream_get_stats(uart_stream_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+
+    stats->frames = frames;
+    stats->dropped = dropped;
+    stats->commands = commands;
+    stats->rx_errors = crc_errors + length_errors;
+    stats->rx_overruns = rx_overruns;
+}
+
+#endif /* BOARD_UART_STREAM_ENABLE */
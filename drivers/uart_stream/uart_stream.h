@@ -0,0 +1,170 @@
+#ifndef UART_STREAM_H
+#define UART_STREAM_H
+
+/**
+ * @file uart_stream.h
+ * @brief Sensor samples and master commands over USART2, COBS-framed
+ *
+ * The wire form of the USB stream for boards without USB: every sample
+ * the application reads goes into a pool block, and the block goes out by
+ * DMA as one frame, at up to 2 Mbaud, with no interrupt per byte. While
+ * one frame is on the wire the next one fills (one sample per frame on an
+ * idle line, full frames under load). Frames are COBS-encoded, so a 0x00
+ * byte only ever ends a frame: a reader that lost bytes resynchronizes on
+ * the next delimiter.
+ *
+ * Frame before encoding (little-endian):
+ *   0  type      UART_STREAM_TYPE_*
+ *   1  count     samples (SAMPLES), commands answered (RESULT)
+ *   2  seq       uint16, one per frame sent (samples dropped on a full
+ *                pool show as gaps in their sequence numbers)
+ *   4  payload
+ *        SAMPLES  count x 16-byte sample records, as in the USB stream
+ *                 (usb_stream.h)
+ *        RESULT   uint8 host_command_result_t of the last command run
+ *   .. crc       uint16, CRC-16 (crc.h) of the bytes before it
+ * then encoded as one COBS run (frames stay under 255 bytes) plus the
+ * 0x00 delimiter. tools/sample_decode.py decodes it.
+ *
+ * Commands in the other direction, one frame each, encoded the same way:
+ *   0  argument  uint32
+ *   4  opcode    host_command_opcode_t
+ *   5  crc       uint16, CRC-16 of the five bytes before it
+ * the bytes of the command registers (APP_REG_CMD_*). RX runs in a
+ * circular DMA buffer, drained when the line goes idle after a frame or a
+ * half buffer fills; the main loop checks the CRC and queues the command
+ * with the I2C ones. A frame of any other length or a failed CRC is
+ * counted and dropped.
+ *
+ * Built only with BOARD_UART_STREAM_ENABLE.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board_config.h"
+#include "sensor_sampling.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+#define UART_STREAM_TYPE_SAMPLES  0x01U
+#define UART_STREAM_TYPE_RESULT   0x02U
+#define UART_STREAM_HEADER_BYTES  4U
+#define UART_STREAM_SAMPLE_BYTES  SENSOR_RECORD_BYTES
+#define UART_STREAM_CRC_BYTES     2U
+#define UART_STREAM_FRAME_MAX     254U  /* Bytes before encoding: one COBS run */
+#define UART_STREAM_COMMAND_BYTES 7U
+
+/**
+ * @brief Command received (CRC checked)
+ */
+typedef struct {
+    uint8_t opcode;
+    uint32_t argument;
+    uint16_t crc;           /* As received, for host_command_push() */
+    uint32_t timestamp_us;  /* hal_tim2_get_timestamp_us() when its frame was drained */
+} uart_stream_command_t;
+
+/**
+ * @brief Counters (since boot)
+ */
+typedef struct {
+    uint32_t frames;        /* Frames sent */
+    uint32_t dropped;       /* Samples and results dropped on a full pool */
+    uint32_t commands;      /* Commands received */
+    uint32_t rx_errors;     /* Frames of a wrong length or CRC */
+    uint32_t rx_overruns;   /* Commands dropped on a full queue */
+} uart_stream_stats_t;
+
+/**
+ * @brief Command frame queued (interrupt context)
+ */
+typedef void (*uart_stream_rx_callback_t)(void);
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Start USART2, its DMA channels and the block pool
+ *
+ * Call after the clock is configured.
+ *
+ * @return true if initialization successful, false otherwise
+ */
+bool uart_stream_init(void);
+
+/**
+ * @brief Set the function called when a command frame arrives
+ *
+ * @param callback Called from the UART interrupt (NULL: none)
+ */
+void uart_stream_register_rx_callback(uart_stream_rx_callback_t callback);
+
+/**
+ * @brief Queue one sample (main loop only)
+ *
+ * Returns at once: the sample is dropped when every block is queued.
+ *
+ * @param sample Sample read from the sampling ring
+ */
+void uart_stream_push(const sensor_data_t *sample);
+
+/**
+ * @brief Send a result frame (main loop only)
+ *
+ * @param result Result of the last command run
+ * @param count Commands run since the previous result frame
+ * @return true if queued
+ */
+bool uart_stream_send_result(uint8_t result, uint8_t count);
+
+/**
+ * @brief Take the next received command (main loop only)
+ *
+ * Frames failing the CRC are counted and skipped.
+ *
+ * @param command Receives it
+ * @return true if one was taken
+ */
+bool uart_stream_get_command(uart_stream_command_t *command);
+
+/**
+ * @brief USART2 interrupt work (IDLE line), call from USART2_IRQHandler
+ */
+void uart_stream_irq_handler(void);
+
+/**
+ * @brief DMA interrupt work: TX done, RX half/full buffer
+ *
+ * Call from the BOARD_UART_STREAM_DMA_IRQn handler.
+ */
+void uart_stream_dma_irq_handler(void);
+
+/**
+ * @brief UART stream running
+ *
+ * STOP halts USART2 and the DMA, so STOP builds stay in SLEEP while this
+ * is true.
+ *
+ * @return true once uart_stream_init() succeeded
+ */
+bool uart_stream_is_active(void);
+
+/**
+ * @brief Get the counters
+ *
+ * @param stats Receives them
+ */
+void uart_stream_get_stats(uart_stream_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UART_STREAM_H */
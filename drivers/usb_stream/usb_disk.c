@@ -0,0 +1,265 @@
+/**
+ * @file usb_disk.c
+ * @brief Read-only FAT12 view of the flash capture log
+ *
+ * The boot sector and the FAT are the same on every read but for the
+ * chain length; the directory gives the file size of the moment. Data
+ * sectors are copied from the flash into the class's sector buffer, the
+ * only copy from the log page to the endpoint packet memory: the vendored
+ * SCSI layer transmits from that buffer.
+ */
+
+#include "usb_disk.h"
+
+#if BOARD_USB_STREAM_ENABLE && BOARD_USB_STREAM_CLASS == BOARD_USB_CLASS_MSC
+
+#include <string.h>
+#include "stm32l0xx_hal.h"
+#include "flash_log.h"
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define USB_DISK_FAT_SECTOR     1U   /* First copy, the second follows */
+#define USB_DISK_ROOT_SECTOR    3U
+#define USB_DISK_ROOT_ENTRIES   16U  /* One sector */
+#define USB_DISK_MEDIA          0xF8U
+#define USB_DISK_CLUSTER_EOC    0xFFFU
+#define USB_DISK_ATTR_READ_ONLY 0x01U
+#define USB_DISK_ATTR_VOLUME_ID 0x08U
+#define USB_DISK_DATE           (((2024U - 1980U) << 9) | (1U << 5) | 1U)  /* 2024-01-01 */
+#define USB_DISK_INQUIRY_BYTES  36U
+
+/* Two reserved entries, then one per data cluster, 12 bits each, in one sector */
+#if ((USB_DISK_DATA_SECTORS + 2U) * 3U + 1U) / 2U > USB_DISK_SECTOR_BYTES
+#error "BOARD_USB_DISK_LOG_BYTES is too large for a one-sector FAT"
+#endif
+#if BOARD_USB_DISK_LOG_BYTES % USB_DISK_SECTOR_BYTES != 0U
+#error "BOARD_USB_DISK_LOG_BYTES must be a multiple of 512"
+#endif
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+/* BPB: the first 62 bytes of the boot sector, volume ID patched in */
+static const uint8_t boot_sector[62] = {
+    0xEB, 0x3C, 0x90,                          /* Jump */
+    'S', 'E', 'N', 'S', 'L', 'O', 'G', ' ',    /* OEM name */
+    LOBYTE(USB_DISK_SECTOR_BYTES), HIBYTE(USB_DISK_SECTOR_BYTES),
+    1,                                         /* Sectors per cluster */
+    1, 0,                                      /* Reserved sectors */
+    2,                                         /* FATs */
+    USB_DISK_ROOT_ENTRIES, 0,
+    LOBYTE(USB_DISK_SECTORS), HIBYTE(USB_DISK_SECTORS),
+    USB_DISK_MEDIA,
+    1, 0,                                      /* Sectors per FAT */
+    1, 0,                                      /* Sectors per track */
+    1, 0,                                      /* Heads */
+    0, 0, 0, 0,                                /* Hidden sectors */
+    0, 0, 0, 0,                                /* Total sectors (32-bit) */
+    0x80,                                      /* Drive number */
+    0,
+    0x29,                                      /* Extended boot signature */
+    0, 0, 0, 0,                                /* Volume ID */
+    'S', 'E', 'N', 'S', 'O', 'R', ' ', 'L', 'O', 'G', ' ',
+    'F', 'A', 'T', '1', '2', ' ', ' ', ' '
+};
+
+static const uint8_t label_entry[11] = {
+    'S', 'E', 'N', 'S', 'O', 'R', ' ', 'L', 'O', 'G', ' '
+};
+
+static const uint8_t file_entry[11] = {
+    'L', 'O', 'G', ' ', ' ', ' ', ' ', ' ', 'B', 'I', 'N'
+};
+
+static const uint8_t inquiry[USB_DISK_INQUIRY_BYTES] = {
+    0x00,                                      /* Direct-access device */
+    0x80,                                      /* Removable */
+    0x02,                                      /* SPC-2 */
+    0x02,
+    USB_DISK_INQUIRY_BYTES - 5U,
+    0x00, 0x00, 0x00,
+    'S', 'T', 'M', ' ', ' ', ' ', ' ', ' ',
+    'S', 'e', 'n', 's', 'o', 'r', ' ', 'l', 'o', 'g', ' ', ' ', ' ', ' ', ' ', ' ',
+    '1', '.', '0', '0'
+};
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static void usb_disk_put16(uint8_t *buf, uint16_t value)
+{
+    buf[0] = (uint8_t)(value & 0xFFU);
+    buf[1] = (uint8_t)(value >> 8);
+}
+
+static void usb_disk_put32(uint8_t *buf, uint32_t value)
+{
+    usb_disk_put16(buf, (uint16_t)(value & 0xFFFFU));
+    usb_disk_put16(buf + 2, (uint16_t)(value >> 16));
+}
+
+/**
+ * @brief LOG.BIN length, clamped to the data area
+ */
+static uint32_t usb_disk_file_bytes(void)
+{
+    uint32_t bytes = flash_log_image_bytes();
+
+    return (bytes > BOARD_USB_DISK_LOG_BYTES) ? BOARD_USB_DISK_LOG_BYTES : bytes;
+}
+
+static void usb_disk_boot(uint8_t *buf)
+{
+    memcpy(buf, boot_sector, sizeof(boot_sector));
+    /* A volume ID of the device: hosts tell two boards apart by it */
+    usb_disk_put32(&buf[39], *(const uint32_t *)UID_BASE ^ *(const uint32_t *)(UID_BASE + 0x14U));
+    buf[510] = 0x55;
+    buf[511] = 0xAA;
+}
+
+static void usb_disk_fat_entry(uint8_t *fat, uint32_t n, uint16_t value)
+{
+    uint32_t at = n * 3U / 2U;
+
+    if ((n & 1U) == 0U) {
+        fat[at] = (uint8_t)(value & 0xFFU);
+        fat[at + 1U] = (uint8_t)((fat[at + 1U] & 0xF0U) | ((value >> 8) & 0x0FU));
+    } else {
+        fat[at] = (uint8_t)((fat[at] & 0x0FU) | ((value << 4) & 0xF0U));
+        fat[at + 1U] = (uint8_t)(value >> 4);
+    }
+}
+
+static void usb_disk_fat(uint8_t *buf)
+{
+    uint32_t clusters = (usb_disk_file_bytes() + USB_DISK_SECTOR_BYTES - 1U) / USB_DISK_SECTOR_BYTES;
+
+    usb_disk_fat_entry(buf, 0, 0xF00U | USB_DISK_MEDIA);
+    usb_disk_fat_entry(buf, 1, USB_DISK_CLUSTER_EOC);
+    for (uint32_t i = 0; i < clusters; i++) {
+        usb_disk_fat_entry(buf, 2U + i,
+                           (i + 1U == clusters) ? USB_DISK_CLUSTER_EOC : (uint16_t)(3U + i));
+    }
+}
+
+static void usb_disk_root(uint8_t *buf)
+{
+    uint8_t *file = &buf[32];
+    uint32_t bytes = usb_disk_file_bytes();
+
+    memcpy(buf, label_entry, sizeof(label_entry));
+    buf[11] = USB_DISK_ATTR_VOLUME_ID;
+    usb_disk_put16(&buf[24], USB_DISK_DATE);
+
+    memcpy(file, file_entry, sizeof(file_entry));
+    file[11] = USB_DISK_ATTR_READ_ONLY;
+    usb_disk_put16(&file[16], USB_DISK_DATE);  /* Created */
+    usb_disk_put16(&file[18], USB_DISK_DATE);  /* Accessed */
+    usb_disk_put16(&file[24], USB_DISK_DATE);  /* Written */
+    usb_disk_put16(&file[26], (bytes != 0U) ? 2U : 0U);
+    usb_disk_put32(&file[28], bytes);
+}
+
+/**
+ * @brief Make up one sector
+ */
+static void usb_disk_sector(uint32_t sector, uint8_t *buf)
+{
+    if (sector >= USB_DISK_DATA_START) {
+        flash_log_read_image((sector - USB_DISK_DATA_START) * USB_DISK_SECTOR_BYTES, buf,
+                             USB_DISK_SECTOR_BYTES);
+        return;
+    }
+
+    memset(buf, 0, USB_DISK_SECTOR_BYTES);
+    if (sector == 0U) {
+        usb_disk_boot(buf);
+    } else if (sector < USB_DISK_ROOT_SECTOR) {
+        usb_disk_fat(buf);
+    } else {
+        usb_disk_root(buf);
+    }
+}
+
+/* ============================================================================
+ * STORAGE INTERFACE (USB interrupt)
+ * ============================================================================ */
+
+static int8_t usb_disk_init(uint8_t lun)
+{
+    (void)lun;
+    return 0;
+}
+
+static int8_t usb_disk_get_capacity(uint8_t lun, uint32_t *block_num, uint16_t *block_size)
+{
+    (void)lun;
+    *block_num = USB_DISK_SECTORS;
+    *block_size = USB_DISK_SECTOR_BYTES;
+    return 0;
+}
+
+static int8_t usb_disk_is_ready(uint8_t lun)
+{
+    (void)lun;
+    return 0;
+}
+
+static int8_t usb_disk_is_write_protected(uint8_t lun)
+{
+    (void)lun;
+    return 1;
+}
+
+static int8_t usb_disk_read(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len)
+{
+    (void)lun;
+    if (blk_addr + blk_len > USB_DISK_SECTORS) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < blk_len; i++) {
+        usb_disk_sector(blk_addr + i, &buf[i * USB_DISK_SECTOR_BYTES]);
+    }
+    return 0;
+}
+
+static int8_t usb_disk_write(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len)
+{
+    (void)lun;
+    (void)buf;
+    (void)blk_addr;
+    (void)blk_len;
+    return -1;
+}
+
+static int8_t usb_disk_get_max_lun(void)
+{
+    return 0;
+}
+
+static USBD_StorageTypeDef usb_disk_fops = {
+    usb_disk_init,
+    usb_disk_get_capacity,
+    usb_disk_is_ready,
+    usb_disk_is_write_protected,
+    usb_disk_read,
+    usb_disk_write,
+    usb_disk_get_max_lun,
+    (int8_t *)(uintptr_t)inquiry
+};
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+USBD_StorageTypeDef *usb_disk_storage(void)
+{
+    return &usb_disk_fops;
+}
+
+#endif /* BOARD_USB_STREAM_ENABLE && BOARD_USB_STREAM_CLASS == BOARD_USB_CLASS_MSC */
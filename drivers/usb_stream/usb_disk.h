@@ -0,0 +1,60 @@
+#ifndef USB_DISK_H
+#define USB_DISK_H
+
+/**
+ * @file usb_disk.h
+ * @brief The flash capture log as a read-only USB mass-storage volume
+ *
+ * With BOARD_USB_STREAM_CLASS BOARD_USB_CLASS_MSC (make USB_CLASS=MSC) the
+ * USB device is a disk instead of a sample stream: a FAT12 volume holding
+ * one read-only file, LOG.BIN, the flash log image (flash_log.h) at full
+ * USB FS speed, with any OS and no tool. Nothing of the volume is stored:
+ * every sector is made up when the host reads it.
+ *
+ * Volume (512-byte sectors, one per cluster):
+ *   0      boot sector
+ *   1, 2   FAT12, two copies: LOG.BIN in one contiguous chain
+ *   3      root directory: volume label, LOG.BIN
+ *   4..    data: LOG.BIN from cluster 2, read straight from the flash
+ * The size is fixed (USB_DISK_DATA_SECTORS of data); LOG.BIN is as long
+ * as the image when the host reads the directory. Hosts cache the
+ * directory: re-plug to see a capture taken since. Writes fail (write
+ * protected).
+ *
+ * USB interrupt only, through the storage callbacks. Built with
+ * BOARD_USB_STREAM_ENABLE and the MSC class.
+ */
+
+#include <stdint.h>
+#include "board_config.h"
+#include "usbd_msc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+#define USB_DISK_SECTOR_BYTES   512U
+#define USB_DISK_DATA_START     4U   /* First data sector (cluster 2) */
+#define USB_DISK_DATA_SECTORS   (BOARD_USB_DISK_LOG_BYTES / USB_DISK_SECTOR_BYTES)
+#define USB_DISK_SECTORS        (USB_DISK_DATA_START + USB_DISK_DATA_SECTORS)
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Storage callbacks for USBD_MSC_RegisterStorage()
+ *
+ * @return The callbacks of the volume
+ */
+USBD_StorageTypeDef *usb_disk_storage(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USB_DISK_H */
@@ -0,0 +1,591 @@
+/**
+ * @file usb_stream.c
+ * @brief USB CDC sample stream implementation
+ *
+ * The main loop owns the block being filled; a filled block moves to the
+ * send queue under the USB interrupt mask, and the USB interrupt owns the
+ * queue from there: it starts the oldest block, and when the transfer
+ * (with its ZLP, if any) completes it returns the block to the pool and
+ * starts the next. Samples are never copied again once in a block.
+ *
+ * The HID class keeps a single report instead, rewritten under the USB
+ * interrupt mask: the PCD HAL copies it into packet memory when the
+ * transfer starts, so the next sample can overwrite it at once, and the
+ * report the host polls is never older than one poll interval.
+ *
+ * The MSC class streams nothing: the device serves the flash log as a
+ * disk (usb_disk.c), and only the descriptors and start-up are here.
+ */
+
+#include "usb_stream.h"
+
+#if BOARD_USB_STREAM_ENABLE
+
+#include <stddef.h>
+#include <string.h>
+#include "usbd_core.h"
+#include "usbd_ctlreq.h"
+#include "usbd_conf.h"
+#include "hal_config.h"
+#if USB_STREAM_HID
+#include "usbd_customhid.h"
+#elif USB_STREAM_MSC
+#include "usbd_msc.h"
+#include "usb_disk.h"
+#else
+#include "usbd_cdc.h"
+#include "pool.h"
+#endif
+#if BOARD_SAMPLE_CODEC_ENABLE && USB_STREAM_CDC
+#include "sample_codec.h"
+#endif
+#if BOARD_CRC_FRAMING_ENABLE && USB_STREAM_CDC
+#include "crc.h"
+#endif
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#if USB_STREAM_HID
+#if CUSTOM_HID_EPIN_SIZE != USB_STREAM_HID_REPORT_BYTES || \
+    USBD_CUSTOM_HID_REPORT_DESC_SIZE != USB_STREAM_HID_DESC_BYTES
+#error "usbd_conf.h HID sizes must match the report"
+#endif
+#elif USB_STREAM_CDC && (USB_STREAM_BLOCK_SAMPLES < 1U || USB_STREAM_BLOCK_SAMPLES > 255U)
+#error "BOARD_USB_STREAM_BLOCK_BYTES must hold 1..255 samples"
+#endif
+
+#define USB_STREAM_LANGID          0x0409U  /* English (US) */
+#define USB_STREAM_SERIAL_CHARS    24U      /* 96-bit UID in hex */
+
+#if USB_STREAM_HID
+#define USB_STREAM_DEVICE_CLASS    0x00U    /* Class in the interface descriptor */
+#define USB_STREAM_DEVICE_SUBCLASS 0x00U
+#define USB_STREAM_FUNCTION        "HID"
+#elif USB_STREAM_MSC
+#define USB_STREAM_DEVICE_CLASS    0x00U
+#define USB_STREAM_DEVICE_SUBCLASS 0x00U
+#define USB_STREAM_FUNCTION        "MSC"
+#else
+#define USB_STREAM_DEVICE_CLASS    0x02U    /* CDC */
+#define USB_STREAM_DEVICE_SUBCLASS 0x02U
+#define USB_STREAM_FUNCTION        "CDC"
+#endif
+
+#if USB_STREAM_HID
+/**
+ * @brief The input report, in wire order
+ */
+typedef struct {
+    uint8_t sync;
+    uint8_t samples;        /* Pushed since the previous report (saturated) */
+    uint16_t seq;
+    uint8_t record[SENSOR_RECORD_BYTES];
+    uint8_t quality;
+    uint8_t reserved;
+    uint16_t error_count;
+} usb_stream_report_t;
+#elif USB_STREAM_CDC
+/**
+ * @brief One block, in wire order: also the transfer buffer
+ */
+typedef struct {
+    uint8_t sync;
+    uint8_t count;
+    uint16_t seq;
+    struct {
+        uint8_t bytes[USB_STREAM_PAYLOAD_BYTES + USB_STREAM_CRC_BYTES];  /* Records or encoded, CRC */
+    } payload;
+} usb_stream_block_t;
+#endif
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static USBD_HandleTypeDef usb_device;
+static bool started = false;
+
+#if USB_STREAM_HID
+/* Vendor page: one input report of USB_STREAM_HID_REPORT_BYTES opaque bytes */
+__ALIGN_BEGIN static uint8_t report_desc[USB_STREAM_HID_DESC_BYTES] __ALIGN_END = {
+    0x06, 0x00, 0xFF,                     /* Usage Page (Vendor 0xFF00) */
+    0x09, 0x01,                           /* Usage (1) */
+    0xA1, 0x01,                           /* Collection (Application) */
+    0x09, 0x02,                           /*   Usage (2) */
+    0x15, 0x00,                           /*   Logical Minimum (0) */
+    0x26, 0xFF, 0x00,                     /*   Logical Maximum (255) */
+    0x75, 0x08,                           /*   Report Size (8) */
+    0x95, USB_STREAM_HID_REPORT_BYTES,    /*   Report Count */
+    0x81, 0x02,                           /*   Input (Data, Variable, Absolute) */
+    0xC0                                  /* End Collection */
+};
+
+__ALIGN_BEGIN static usb_stream_report_t report __ALIGN_END;  /* Under the USB mask */
+static bool report_pending = false;          /* Holds a sample not sent yet */
+static volatile bool sending = false;        /* A report is armed on the endpoint */
+#elif USB_STREAM_CDC
+POOL_STORAGE(block_storage, sizeof(usb_stream_block_t), BOARD_USB_STREAM_BLOCKS);
+static pool_t block_pool;
+
+static usb_stream_block_t *filling = NULL;  /* Main loop only */
+static uint16_t filling_used = 0;            /* Payload bytes in it */
+static usb_stream_block_t *queue[BOARD_USB_STREAM_BLOCKS];
+static uint16_t queue_bytes[BOARD_USB_STREAM_BLOCKS];  /* Transfer length of each */
+static volatile uint32_t queue_head = 0;    /* Next free entry */
+static volatile uint32_t queue_tail = 0;    /* Oldest block, on the wire if sending */
+static volatile bool sending = false;
+static volatile bool port_open = false;     /* Host set DTR */
+static uint16_t block_seq = 0;
+#if BOARD_SAMPLE_CODEC_ENABLE
+static sample_codec_t codec;                 /* Main loop only */
+#endif
+
+/* Host buffer for CDC OUT data (nothing is expected, it is discarded) */
+static uint8_t rx_buffer[CDC_DATA_FS_MAX_PACKET_SIZE];
+
+/* Line coding echoed back to the host: the rate means nothing on USB */
+static uint8_t line_coding[7] = { 0x00, 0xC2, 0x01, 0x00, 0x00, 0x00, 0x08 };  /* 115200 8N1 */
+#endif
+
+__ALIGN_BEGIN static uint8_t string_desc[USBD_MAX_STR_DESC_SIZ] __ALIGN_END;
+
+__ALIGN_BEGIN static uint8_t device_desc[USB_LEN_DEV_DESC] __ALIGN_END = {
+    USB_LEN_DEV_DESC,
+    USB_DESC_TYPE_DEVICE,
+    0x00, 0x02,                           /* bcdUSB 2.00 */
+    USB_STREAM_DEVICE_CLASS,
+    USB_STREAM_DEVICE_SUBCLASS,
+    0x00,                                 /* bDeviceProtocol */
+    USB_MAX_EP0_SIZE,
+    LOBYTE(BOARD_USB_VID), HIBYTE(BOARD_USB_VID),
+    LOBYTE(BOARD_USB_PID), HIBYTE(BOARD_USB_PID),
+    0x00, 0x01,                           /* bcdDevice 1.00 */
+    USBD_IDX_MFC_STR,
+    USBD_IDX_PRODUCT_STR,
+    USBD_IDX_SERIAL_STR,
+    USBD_MAX_NUM_CONFIGURATION
+};
+
+__ALIGN_BEGIN static uint8_t langid_desc[USB_LEN_LANGID_STR_DESC] __ALIGN_END = {
+    USB_LEN_LANGID_STR_DESC,
+    USB_DESC_TYPE_STRING,
+    LOBYTE(USB_STREAM_LANGID), HIBYTE(USB_STREAM_LANGID)
+};
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+#if USB_STREAM_HID
+/**
+ * @brief Arm the report if it holds a new sample and the endpoint is free
+ *
+ * USB interrupt, or main loop with it masked.
+ */
+static void usb_stream_report_next(void)
+{
+    if (sending || !report_pending || usb_device.dev_state != USBD_STATE_CONFIGURED) {
+        return;
+    }
+
+    if (USBD_CUSTOM_HID_SendReport(&usb_device, (uint8_t *)&report, sizeof(report)) == USBD_OK) {
+        sending = true;
+        report_pending = false;
+        report.samples = 0;
+        report.seq++;
+    }
+}
+
+/* ============================================================================
+ * HID INTERFACE (USB interrupt)
+ * ============================================================================ */
+
+static int8_t usb_stream_hid_init(void)
+{
+    sending = false;
+    return (int8_t)USBD_OK;
+}
+
+static int8_t usb_stream_hid_deinit(void)
+{
+    /* Reset or unplug: the endpoint is closed, nothing will complete */
+    sending = false;
+    return (int8_t)USBD_OK;
+}
+
+static int8_t usb_stream_hid_out_event(uint8_t event_idx, uint8_t state)
+{
+    /* No output report is declared: anything the host sends is dropped */
+    (void)event_idx;
+    (void)state;
+    return (int8_t)USBD_OK;
+}
+
+static USBD_CUSTOM_HID_ItfTypeDef usb_stream_hid_fops = {
+    report_desc,
+    usb_stream_hid_init,
+    usb_stream_hid_deinit,
+    usb_stream_hid_out_event
+};
+
+#elif USB_STREAM_CDC
+/**
+ * @brief Start the oldest queued block, if idle (USB interrupt or masked)
+ */
+static void usb_stream_tx_next(void)
+{
+    usb_stream_block_t *block;
+
+    if (sending || queue_head == queue_tail) {
+        return;
+    }
+
+    block = queue[queue_tail % BOARD_USB_STREAM_BLOCKS];
+    (void)USBD_CDC_SetTxBuffer(&usb_device, (uint8_t *)block,
+                               queue_bytes[queue_tail % BOARD_USB_STREAM_BLOCKS]);
+    if (USBD_CDC_TransmitPacket(&usb_device) == USBD_OK) {
+        sending = true;
+    }
+}
+
+/**
+ * @brief Return every queued block to the pool (USB interrupt)
+ *
+ * @param with_sending Also the block on the wire (endpoint closed)
+ */
+static void usb_stream_flush(bool with_sending)
+{
+    uint32_t keep = (sending && !with_sending) ? 1U : 0U;
+
+    while (queue_head - queue_tail > keep) {
+        queue_head--;
+        (void)pool_free(&block_pool, queue[queue_head % BOARD_USB_STREAM_BLOCKS]);
+    }
+    if (with_sending) {
+        sending = false;
+    }
+}
+
+/**
+ * @brief Move the filled block to the send queue (main loop)
+ */
+static void usb_stream_enqueue(void)
+{
+    uint32_t masked;
+#if BOARD_CRC_FRAMING_ENABLE
+    uint16_t crc = crc16_update(CRC16_INIT, filling, USB_STREAM_HEADER_BYTES + filling_used);
+
+    filling->payload.bytes[filling_used] = (uint8_t)(crc & 0xFF);
+    filling->payload.bytes[filling_used + 1U] = (uint8_t)((crc >> 8) & 0xFF);
+    filling_used += USB_STREAM_CRC_BYTES;
+#endif
+
+    masked = hal_irq_mask(HAL_IRQ_LINES_USB);
+
+    /* A block always fits: the queue has one entry per pool block */
+    queue[queue_head % BOARD_USB_STREAM_BLOCKS] = filling;
+    queue_bytes[queue_head % BOARD_USB_STREAM_BLOCKS] =
+        (uint16_t)(USB_STREAM_HEADER_BYTES + filling_used);
+    queue_head++;
+    filling = NULL;
+    usb_stream_tx_next();
+    hal_irq_unmask(masked);
+}
+
+/* ============================================================================
+ * CDC INTERFACE (USB interrupt)
+ * ============================================================================ */
+
+static int8_t usb_stream_cdc_init(void)
+{
+    (void)USBD_CDC_SetRxBuffer(&usb_device, rx_buffer);
+    return (int8_t)USBD_OK;
+}
+
+static int8_t usb_stream_cdc_deinit(void)
+{
+    /* Reset or unplug: the endpoints are closed, nothing will complete */
+    port_open = false;
+    usb_stream_flush(true);
+    return (int8_t)USBD_OK;
+}
+
+static int8_t usb_stream_cdc_control(uint8_t cmd, uint8_t *pbuf, uint16_t length)
+{
+    switch (cmd) {
+    case CDC_SET_LINE_CODING:
+        if (length >= sizeof(line_coding)) {
+            memcpy(line_coding, pbuf, sizeof(line_coding));
+        }
+        break;
+
+    case CDC_GET_LINE_CODING:
+        if (length >= sizeof(line_coding)) {
+            memcpy(pbuf, line_coding, sizeof(line_coding));
+        }
+        break;
+
+    case CDC_SET_CONTROL_LINE_STATE:
+        /* No data stage: pbuf is the setup request, DTR is wValue bit 0 */
+        port_open = (((USBD_SetupReqTypedef *)(void *)pbuf)->wValue & 0x0001U) != 0U;
+        if (!port_open) {
+            usb_stream_flush(false);
+        }
+        break;
+
+    default:
+        break;
+    }
+    return (int8_t)USBD_OK;
+}
+
+static int8_t usb_stream_cdc_receive(uint8_t *buf, uint32_t *length)
+{
+    (void)buf;
+    (void)length;
+    (void)USBD_CDC_ReceivePacket(&usb_device);
+    return (int8_t)USBD_OK;
+}
+
+static USBD_CDC_ItfTypeDef usb_stream_cdc_fops = {
+    usb_stream_cdc_init,
+    usb_stream_cdc_deinit,
+    usb_stream_cdc_control,
+    usb_stream_cdc_receive
+};
+#endif /* USB_STREAM_HID */
+
+/* ============================================================================
+ * DESCRIPTORS (USB interrupt)
+ * ============================================================================ */
+
+static uint8_t *usb_stream_device_desc(USBD_SpeedTypeDef speed, uint16_t *length)
+{
+    (void)speed;
+    *length = sizeof(device_desc);
+    return device_desc;
+}
+
+static uint8_t *usb_stream_langid_desc(USBD_SpeedTypeDef speed, uint16_t *length)
+{
+    (void)speed;
+    *length = sizeof(langid_desc);
+    return langid_desc;
+}
+
+static uint8_t *usb_stream_string(const char *text, uint16_t *length)
+{
+    USBD_GetString((uint8_t *)(uintptr_t)text, string_desc, length);
+    return string_desc;
+}
+
+static uint8_t *usb_stream_manufacturer_desc(USBD_SpeedTypeDef speed, uint16_t *length)
+{
+    (void)speed;
+    return usb_stream_string("STMicroelectronics", length);
+}
+
+static uint8_t *usb_stream_product_desc(USBD_SpeedTypeDef speed, uint16_t *length)
+{
+    (void)speed;
+    return usb_stream_string("Sensor sample stream", length);
+}
+
+static uint8_t *usb_stream_serial_desc(USBD_SpeedTypeDef speed, uint16_t *length)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    char serial[USB_STREAM_SERIAL_CHARS + 1U];
+    const uint32_t uid[3] = {
+        *(const uint32_t *)UID_BASE,
+        *(const uint32_t *)(UID_BASE + 0x04U),
+        *(const uint32_t *)(UID_BASE + 0x14U)
+    };
+
+    (void)speed;
+    for (uint32_t i = 0; i < USB_STREAM_SERIAL_CHARS; i++) {
+        serial[i] = hex[(uid[i / 8U] >> (28U - 4U * (i % 8U))) & 0xFU];
+    }
+    serial[USB_STREAM_SERIAL_CHARS] = '\0';
+    return usb_stream_string(serial, length);
+}
+
+static uint8_t *usb_stream_config_desc(USBD_SpeedTypeDef speed, uint16_t *length)
+{
+    (void)speed;
+    return usb_stream_string(USB_STREAM_FUNCTION " config", length);
+}
+
+static uint8_t *usb_stream_interface_desc(USBD_SpeedTypeDef speed, uint16_t *length)
+{
+    (void)speed;
+    return usb_stream_string(USB_STREAM_FUNCTION " interface", length);
+}
+
+static USBD_DescriptorsTypeDef usb_stream_desc = {
+    usb_stream_device_desc,
+    usb_stream_langid_desc,
+    usb_stream_manufacturer_desc,
+    usb_stream_product_desc,
+    usb_stream_serial_desc,
+    usb_stream_config_desc,
+    usb_stream_interface_desc
+};
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+#if USB_STREAM_HID
+bool usb_stream_init(void)
+{
+    memset(&report, 0, sizeof(report));
+    report.sync = USB_STREAM_SYNC_HID;
+
+    if (USBD_Init(&usb_device, &usb_stream_desc, 0) != USBD_OK ||
+        USBD_RegisterClass(&usb_device, &USBD_CUSTOM_HID) != USBD_OK ||
+        USBD_CUSTOM_HID_RegisterInterface(&usb_device, &usb_stream_hid_fops) != USBD_OK ||
+        USBD_Start(&usb_device) != USBD_OK) {
+        return false;
+    }
+
+    started = true;
+    return true;
+}
+
+void usb_stream_push(const sensor_data_t *sample)
+{
+    uint32_t masked = hal_irq_mask(HAL_IRQ_LINES_USB);
+
+    memcpy(report.record, sample, SENSOR_RECORD_BYTES);
+    report.quality = sample->quality;
+    report.error_count = sample->error_count;
+    if (report.samples < UINT8_MAX) {
+        report.samples++;
+    }
+    report_pending = true;
+    usb_stream_report_next();
+    hal_irq_unmask(masked);
+}
+
+#elif USB_STREAM_MSC
+bool usb_stream_init(void)
+{
+    if (USBD_Init(&usb_device, &usb_stream_desc, 0) != USBD_OK ||
+        USBD_RegisterClass(&usb_device, &USBD_MSC) != USBD_OK ||
+        USBD_MSC_RegisterStorage(&usb_device, usb_disk_storage()) != USBD_OK ||
+        USBD_Start(&usb_device) != USBD_OK) {
+        return false;
+    }
+
+    started = true;
+    return true;
+}
+
+void usb_stream_push(const sensor_data_t *sample)
+{
+    (void)sample;  /* The disk serves the flash log instead */
+}
+
+#else
+bool usb_stream_init(void)
+{
+    if (!pool_init(&block_pool, block_storage, sizeof(usb_stream_block_t),
+                   BOARD_USB_STREAM_BLOCKS)) {
+        return false;
+    }
+
+    if (USBD_Init(&usb_device, &usb_stream_desc, 0) != USBD_OK ||
+        USBD_RegisterClass(&usb_device, &USBD_CDC) != USBD_OK ||
+        USBD_CDC_RegisterInterface(&usb_device, &usb_stream_cdc_fops) != USBD_OK ||
+        USBD_Start(&usb_device) != USBD_OK) {
+        return false;
+    }
+
+    started = true;
+    return true;
+}
+
+void usb_stream_push(const sensor_data_t *sample)
+{
+    bool full;
+
+    if (!port_open) {
+        if (filling != NULL) {
+            (void)pool_free(&block_pool, filling);
+            filling = NULL;
+        }
+#if BOARD_SAMPLE_CODEC_ENABLE
+        sample_codec_reset(&codec);  /* The host starts on a keyframe */
+#endif
+        return;
+    }
+
+    if (filling == NULL) {
+        filling = (usb_stream_block_t *)pool_alloc(&block_pool);
+        if (filling == NULL) {
+            return;  /* Every block queued: the sequence gap tells the host */
+        }
+        filling->sync = BOARD_SAMPLE_CODEC_ENABLE ? USB_STREAM_SYNC_CODEC : USB_STREAM_SYNC;
+        filling->count = 0;
+        filling->seq = block_seq++;
+        filling_used = 0;
+    }
+
+#if BOARD_SAMPLE_CODEC_ENABLE
+    filling_used += (uint16_t)sample_codec_encode(&codec, sample, &filling->payload.bytes[filling_used]);
+    filling->count++;
+    full = USB_STREAM_PAYLOAD_BYTES - filling_used < SAMPLE_CODEC_MAX_BYTES ||
+           filling->count == UINT8_MAX;
+#else
+    /* The record, as the sampler wrote it */
+    memcpy(&filling->payload.bytes[filling_used], sample, SENSOR_RECORD_BYTES);
+    filling->count++;
+    filling_used += USB_STREAM_SAMPLE_BYTES;
+    full = filling->count == USB_STREAM_BLOCK_SAMPLES;
+#endif
+
+    /* A full block goes at once; a partial one only rides an idle endpoint */
+    if (full || !sending) {
+        usb_stream_enqueue();
+    }
+}
+
+#endif /* USB_STREAM_HID */
+
+void usb_stream_irq_handler(void)
+{
+    usbd_ll_irq_handler();
+}
+
+#if USB_STREAM_HID
+void usb_stream_data_in_callback(void)
+{
+    /* The host took the report: arm the newer one, if a sample came since */
+    sending = false;
+    usb_stream_report_next();
+}
+#elif USB_STREAM_CDC
+void usb_stream_data_in_callback(void)
+{
+    USBD_CDC_HandleTypeDef *cdc = (USBD_CDC_HandleTypeDef *)usb_device.pClassData;
+
+    /* Still busy: the class sent the ZLP that ends a multiple-of-64 block */
+    if (cdc == NULL || cdc->TxState != 0U || !sending) {
+        return;
+    }
+
+    (void)pool_free(&block_pool, queue[queue_tail % BOARD_USB_STREAM_BLOCKS]);
+    queue_tail++;
+    sending = false;
+    usb_stream_tx_next();
+}
+#endif
+
+bool usb_stream_is_active(void)
+{
+    return started;
+}
+
+#endif /* BOARD_USB_STREAM_ENABLE */
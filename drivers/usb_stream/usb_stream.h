@@ -0,0 +1,150 @@
+#ifndef USB_STREAM_H
+#define USB_STREAM_H
+
+/**
+ * @file usb_stream.h
+ * @brief Sensor samples to a PC over USB CDC (virtual COM port) or HID
+ *
+ * Every sample the application reads is copied once into a pool block;
+ * the block itself is the bulk IN transfer buffer, sent in 64-byte packets
+ * through the double-buffered data endpoint. While one block is on the
+ * wire the next one fills, so the batch size follows the host: one sample
+ * per transfer when the link is idle, full blocks under load. Nothing is
+ * sent until the host opens the port (DTR set); closing it drops whatever
+ * is queued.
+ *
+ * Block on the wire (little-endian):
+ *   0  sync      USB_STREAM_SYNC
+ *   1  count     samples in the block, 1..USB_STREAM_BLOCK_SAMPLES
+ *   2  seq       uint16, one per block
+ *   4  samples   count x 16-byte sample records (sensor_sampling.h):
+ *        0  timestamp_us  uint32
+ *        4  sequence      uint32, gaps are samples dropped on a full pool
+ *        8  pressure      int32, 0.01 mbar
+ *        12 temperature   int32, 0.01 degC
+ * With BOARD_SAMPLE_CODEC_ENABLE the sync is USB_STREAM_SYNC_CODEC and
+ * the count samples are encoded by sample_codec.h instead, the encoder
+ * running across blocks from the port opening (blocks are never lost
+ * while it is open), up to ~4x the samples per block.
+ * With BOARD_CRC_FRAMING_ENABLE every block ends in a CRC-16 (crc.h,
+ * little-endian) of the bytes before it, header included: a reader that
+ * lost bytes in a full host buffer resynchronizes on the next good block.
+ *
+ * With BOARD_USB_STREAM_CLASS BOARD_USB_CLASS_HID (make USB_CLASS=HID)
+ * the device is a vendor-defined HID instead, which every host drives
+ * without a driver (hidraw, hidapi). The bulk stream is throughput first:
+ * a block waits for the host to get round to it. Here a 1 ms interrupt
+ * endpoint carries only the latest sample in one fixed report, so the
+ * host reads a sample at most one poll interval old, at a guaranteed
+ * 1 ms rate, for closed-loop use. A report goes out once per new sample
+ * (the HID "report on change" idle rate): samples pushed while one is on
+ * the endpoint overwrite the next, and are counted in it.
+ *
+ * Report on the wire (USB_STREAM_HID_REPORT_BYTES, little-endian, no
+ * report ID):
+ *   0  sync        USB_STREAM_SYNC_HID
+ *   1  samples     uint8, pushed since the previous report (saturated):
+ *                  over 1 the others were superseded, not queued
+ *   2  seq         uint16, one per report: gaps are reports the host missed
+ *   4  record      16-byte sample record, as above
+ *   20 quality     SENSOR_QUALITY_* of the sample
+ *   21 reserved    0
+ *   22 error_count uint16, aborted cycles since boot (wraps)
+ * The codec and CRC framing do not apply: a report is one USB packet,
+ * CRC-checked by the bus.
+ *
+ * With BOARD_USB_CLASS_MSC (make USB_CLASS=MSC) nothing is streamed: the
+ * device is a read-only disk holding the flash log (usb_disk.h), and
+ * usb_stream_push() drops every sample.
+ *
+ * Built only with BOARD_USB_STREAM_ENABLE (make USE_USB_STREAM=1).
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board_config.h"
+#include "sensor_sampling.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEFINITIONS
+ * ============================================================================ */
+
+#define USB_STREAM_SYNC           0x5AU  /* First byte of every block */
+#define USB_STREAM_SYNC_CODEC     0x5BU  /* Same, samples encoded */
+#define USB_STREAM_SYNC_HID       0x5CU  /* First byte of every HID report */
+
+#define USB_STREAM_CDC            (BOARD_USB_STREAM_CLASS == BOARD_USB_CLASS_CDC)
+#define USB_STREAM_HID            (BOARD_USB_STREAM_CLASS == BOARD_USB_CLASS_HID)
+#define USB_STREAM_MSC            (BOARD_USB_STREAM_CLASS == BOARD_USB_CLASS_MSC)
+#define USB_STREAM_HID_REPORT_BYTES  24U
+#define USB_STREAM_HID_DESC_BYTES    21U  /* Report descriptor */
+
+#define USB_STREAM_HEADER_BYTES   4U
+#define USB_STREAM_SAMPLE_BYTES   SENSOR_RECORD_BYTES
+#if BOARD_CRC_FRAMING_ENABLE
+#define USB_STREAM_CRC_BYTES      2U
+#else
+#define USB_STREAM_CRC_BYTES      0U
+#endif
+#define USB_STREAM_BLOCK_SAMPLES  \
+    ((BOARD_USB_STREAM_BLOCK_BYTES - USB_STREAM_HEADER_BYTES - USB_STREAM_CRC_BYTES) / \
+     USB_STREAM_SAMPLE_BYTES)
+#define USB_STREAM_PAYLOAD_BYTES  (USB_STREAM_BLOCK_SAMPLES * USB_STREAM_SAMPLE_BYTES)
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Start the USB device (CDC, HID or MSC function) and the block pool
+ *
+ * Call after the clock is configured; enumeration then runs from the USB
+ * interrupt.
+ *
+ * @return true if initialization successful, false otherwise
+ */
+bool usb_stream_init(void);
+
+/**
+ * @brief Queue one sample for the host (main loop only)
+ *
+ * Returns at once: the sample is dropped when the port is closed or every
+ * block is queued. HID: the sample becomes the next report.
+ *
+ * @param sample Sample read from the sampling ring
+ */
+void usb_stream_push(const sensor_data_t *sample);
+
+/**
+ * @brief USB interrupt work, call from USB_IRQHandler
+ */
+void usb_stream_irq_handler(void);
+
+/**
+ * @brief Data IN transfer done (usbd_conf.c, USB interrupt)
+ *
+ * Frees the block that was on the wire and starts the next queued one;
+ * HID: arms the report if a sample came since the last one. Not called
+ * (nor built) with MSC, whose class runs its own endpoints.
+ */
+void usb_stream_data_in_callback(void);
+
+/**
+ * @brief USB device running
+ *
+ * STOP halts HSI48 and the USB peripheral, so STOP builds stay in SLEEP
+ * while this is true.
+ *
+ * @return true once usb_stream_init() succeeded
+ */
+bool usb_stream_is_active(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USB_STREAM_H */
@@ -0,0 +1,355 @@
+/**
+ * @file usbd_conf.c
+ * @brief USB device library low-level glue (USB FS peripheral, PCD HAL)
+ *
+ * Maps the USBD_LL_*() calls of the device library onto the PCD HAL and
+ * the PCD callbacks back onto the library. Packet memory (1 KB PMA):
+ *
+ *   0x000  buffer table (3 endpoints)
+ *   0x018  EP0 OUT, 64 bytes
+ *   0x058  EP0 IN, 64 bytes
+ *   0x098  EP1 OUT (CDC data from the host), 64 bytes
+ *   0x0D8  EP2 IN (CDC notifications), 8 bytes
+ *   0x0E0  EP1 IN (CDC data to the host), 2 x 64 bytes double-buffered
+ *
+ * The data IN endpoint is double-buffered: while the host reads one
+ * packet the PCD HAL writes the next one of the transfer into the other
+ * half, so a multi-packet block goes out back to back.
+ *
+ * HID (BOARD_USB_CLASS_HID), two endpoints:
+ *
+ *   0x000  buffer table (2 endpoints)
+ *   0x018  EP0 OUT, 64 bytes
+ *   0x058  EP0 IN, 64 bytes
+ *   0x098  EP1 OUT (HID, unused), 64 bytes
+ *   0x0D8  EP1 IN (HID reports), 64 bytes
+ *
+ * A report is one packet, so the report endpoint needs no second buffer.
+ *
+ * MSC (BOARD_USB_CLASS_MSC), the bulk pair of the disk:
+ *
+ *   0x000  buffer table (2 endpoints)
+ *   0x018  EP0 OUT, 64 bytes
+ *   0x058  EP0 IN, 64 bytes
+ *   0x098  EP1 OUT (commands), 64 bytes
+ *   0x0E0  EP1 IN (sectors), 2 x 64 bytes double-buffered
+ *
+ * The sector endpoint is double-buffered like the CDC data one, so a
+ * 512-byte sector goes out back to back.
+ */
+
+#include "usbd_conf.h"
+#include "board_config.h"
+
+#if BOARD_USB_STREAM_ENABLE
+
+#include "usbd_core.h"
+#include "usb_stream.h"
+#if USB_STREAM_HID
+#include "usbd_customhid.h"
+#elif USB_STREAM_MSC
+#include "usbd_msc.h"
+#else
+#include "usbd_cdc.h"
+#endif
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define USBD_PMA_EP0_OUT   0x018U
+#define USBD_PMA_EP0_IN    0x058U
+#define USBD_PMA_DATA_OUT  0x098U
+#define USBD_PMA_CMD_IN    0x0D8U
+#define USBD_PMA_DATA_IN0  0x0E0U
+#define USBD_PMA_DATA_IN1  0x120U
+#define USBD_PMA_REPORT_IN 0x0D8U
+
+#if USB_STREAM_HID
+#define USBD_STREAM_IN_EP  CUSTOM_HID_EPIN_ADDR
+#elif USB_STREAM_CDC
+#define USBD_STREAM_IN_EP  CDC_IN_EP
+#endif
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static PCD_HandleTypeDef hpcd_usb;
+
+/* Class data: the only block the library allocates */
+#if USB_STREAM_HID
+static uint32_t usbd_class_block[(sizeof(USBD_CUSTOM_HID_HandleTypeDef) + 3U) / 4U];
+#elif USB_STREAM_MSC
+static uint32_t usbd_class_block[(sizeof(USBD_MSC_BOT_HandleTypeDef) + 3U) / 4U];
+#else
+static uint32_t usbd_class_block[(sizeof(USBD_CDC_HandleTypeDef) + 3U) / 4U];
+#endif
+
+/* ============================================================================
+ * MEMORY
+ * ============================================================================ */
+
+void *usbd_static_malloc(uint32_t size)
+{
+    return (size <= sizeof(usbd_class_block)) ? usbd_class_block : NULL;
+}
+
+void usbd_static_free(void *block)
+{
+    (void)block;
+}
+
+/* ============================================================================
+ * PCD MSP AND INTERRUPT
+ * ============================================================================ */
+
+void HAL_PCD_MspInit(PCD_HandleTypeDef *hpcd)
+{
+    RCC_OscInitTypeDef osc_config = {0};
+    RCC_PeriphCLKInitTypeDef clk_config = {0};
+    RCC_CRSInitTypeDef crs_config = {0};
+
+    (void)hpcd;
+
+    /* HSI48 needs the VREFINT buffer, then CRS trims it on the host SOF */
+    __HAL_RCC_SYSCFG_CLK_ENABLE();
+    SET_BIT(SYSCFG->CFGR3, SYSCFG_CFGR3_ENREF_HSI48);
+    osc_config.OscillatorType = RCC_OSCILLATORTYPE_HSI48;
+    osc_config.HSI48State = RCC_HSI48_ON;
+    osc_config.PLL.PLLState = RCC_PLL_NONE;
+    (void)HAL_RCC_OscConfig(&osc_config);
+
+    clk_config.PeriphClockSelection = RCC_PERIPHCLK_USB;
+    clk_config.UsbClockSelection = RCC_USBCLKSOURCE_HSI48;
+    (void)HAL_RCCEx_PeriphCLKConfig(&clk_config);
+
+    __HAL_RCC_CRS_CLK_ENABLE();
+    crs_config.Prescaler = RCC_CRS_SYNC_DIV1;
+    crs_config.Source = RCC_CRS_SYNC_SOURCE_USB;
+    crs_config.Polarity = RCC_CRS_SYNC_POLARITY_RISING;
+    crs_config.ReloadValue = __HAL_RCC_CRS_RELOADVALUE_CALCULATE(48000000U, 1000U);
+    crs_config.ErrorLimitValue = RCC_CRS_ERRORLIMIT_DEFAULT;
+    crs_config.HSI48CalibrationValue = RCC_CRS_HSI48CALIBRATION_DEFAULT;
+    HAL_RCCEx_CRSConfig(&crs_config);
+
+    /* PA11/PA12 are taken over by the transceiver, no GPIO setup */
+    __HAL_RCC_USB_CLK_ENABLE();
+    HAL_NVIC_SetPriority(USB_IRQn, BOARD_IRQ_PRIO_USB, 0);
+    HAL_NVIC_EnableIRQ(USB_IRQn);
+}
+
+void HAL_PCD_MspDeInit(PCD_HandleTypeDef *hpcd)
+{
+    (void)hpcd;
+    HAL_NVIC_DisableIRQ(USB_IRQn);
+    __HAL_RCC_USB_CLK_DISABLE();
+}
+
+void usbd_ll_irq_handler(void)
+{
+    HAL_PCD_IRQHandler(&hpcd_usb);
+}
+
+/* ============================================================================
+ * PCD CALLBACKS (interrupt context)
+ * ============================================================================ */
+
+void HAL_PCD_SetupStageCallback(PCD_HandleTypeDef *hpcd)
+{
+    USBD_LL_SetupStage((USBD_HandleTypeDef *)hpcd->pData, (uint8_t *)hpcd->Setup);
+}
+
+void HAL_PCD_DataOutStageCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum)
+{
+    USBD_LL_DataOutStage((USBD_HandleTypeDef *)hpcd->pData, epnum, hpcd->OUT_ep[epnum].xfer_buff);
+}
+
+void HAL_PCD_DataInStageCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum)
+{
+    USBD_LL_DataInStage((USBD_HandleTypeDef *)hpcd->pData, epnum, hpcd->IN_ep[epnum].xfer_buff);
+
+#if !USB_STREAM_MSC
+    /* The class has taken the completion: the stream can queue the next block */
+    if (epnum == (USBD_STREAM_IN_EP & 0x7FU)) {
+        usb_stream_data_in_callback();
+    }
+#endif
+}
+
+void HAL_PCD_SOFCallback(PCD_HandleTypeDef *hpcd)
+{
+    USBD_LL_SOF((USBD_HandleTypeDef *)hpcd->pData);
+}
+
+void HAL_PCD_ResetCallback(PCD_HandleTypeDef *hpcd)
+{
+    USBD_LL_SetSpeed((USBD_HandleTypeDef *)hpcd->pData, USBD_SPEED_FULL);
+    USBD_LL_Reset((USBD_HandleTypeDef *)hpcd->pData);
+}
+
+void HAL_PCD_SuspendCallback(PCD_HandleTypeDef *hpcd)
+{
+    USBD_LL_Suspend((USBD_HandleTypeDef *)hpcd->pData);
+}
+
+void HAL_PCD_ResumeCallback(PCD_HandleTypeDef *hpcd)
+{
+    USBD_LL_Resume((USBD_HandleTypeDef *)hpcd->pData);
+}
+
+void HAL_PCD_ISOOUTIncompleteCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum)
+{
+    USBD_LL_IsoOUTIncomplete((USBD_HandleTypeDef *)hpcd->pData, epnum);
+}
+
+void HAL_PCD_ISOINIncompleteCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum)
+{
+    USBD_LL_IsoINIncomplete((USBD_HandleTypeDef *)hpcd->pData, epnum);
+}
+
+void HAL_PCD_ConnectCallback(PCD_HandleTypeDef *hpcd)
+{
+    USBD_LL_DevConnected((USBD_HandleTypeDef *)hpcd->pData);
+}
+
+void HAL_PCD_DisconnectCallback(PCD_HandleTypeDef *hpcd)
+{
+    USBD_LL_DevDisconnected((USBD_HandleTypeDef *)hpcd->pData);
+}
+
+/* ============================================================================
+ * LOW-LEVEL DRIVER INTERFACE
+ * ============================================================================ */
+
+/**
+ * @brief PCD HAL status as a library status
+ */
+static USBD_StatusTypeDef usbd_status(HAL_StatusTypeDef status)
+{
+    switch (status) {
+    case HAL_OK:
+        return USBD_OK;
+    case HAL_BUSY:
+        return USBD_BUSY;
+    default:
+        return USBD_FAIL;
+    }
+}
+
+USBD_StatusTypeDef USBD_LL_Init(USBD_HandleTypeDef *pdev)
+{
+    hpcd_usb.pData = pdev;
+    pdev->pData = &hpcd_usb;
+
+    hpcd_usb.Instance = USB;
+    hpcd_usb.Init.dev_endpoints = 8;
+    hpcd_usb.Init.speed = PCD_SPEED_FULL;
+    hpcd_usb.Init.ep0_mps = USB_MAX_EP0_SIZE;
+    hpcd_usb.Init.phy_itface = PCD_PHY_EMBEDDED;
+    hpcd_usb.Init.Sof_enable = DISABLE;
+    hpcd_usb.Init.low_power_enable = DISABLE;
+    hpcd_usb.Init.lpm_enable = DISABLE;
+    hpcd_usb.Init.battery_charging_enable = DISABLE;
+    if (HAL_PCD_Init(&hpcd_usb) != HAL_OK) {
+        return USBD_FAIL;
+    }
+
+    (void)HAL_PCDEx_PMAConfig(&hpcd_usb, 0x00U, PCD_SNG_BUF, USBD_PMA_EP0_OUT);
+    (void)HAL_PCDEx_PMAConfig(&hpcd_usb, 0x80U, PCD_SNG_BUF, USBD_PMA_EP0_IN);
+#if USB_STREAM_HID
+    (void)HAL_PCDEx_PMAConfig(&hpcd_usb, CUSTOM_HID_EPOUT_ADDR, PCD_SNG_BUF, USBD_PMA_DATA_OUT);
+    (void)HAL_PCDEx_PMAConfig(&hpcd_usb, CUSTOM_HID_EPIN_ADDR, PCD_SNG_BUF, USBD_PMA_REPORT_IN);
+#elif USB_STREAM_MSC
+    (void)HAL_PCDEx_PMAConfig(&hpcd_usb, MSC_EPOUT_ADDR, PCD_SNG_BUF, USBD_PMA_DATA_OUT);
+    (void)HAL_PCDEx_PMAConfig(&hpcd_usb, MSC_EPIN_ADDR, PCD_DBL_BUF,
+                              USBD_PMA_DATA_IN0 | (USBD_PMA_DATA_IN1 << 16));
+#else
+    (void)HAL_PCDEx_PMAConfig(&hpcd_usb, CDC_OUT_EP, PCD_SNG_BUF, USBD_PMA_DATA_OUT);
+    (void)HAL_PCDEx_PMAConfig(&hpcd_usb, CDC_CMD_EP, PCD_SNG_BUF, USBD_PMA_CMD_IN);
+    (void)HAL_PCDEx_PMAConfig(&hpcd_usb, CDC_IN_EP, PCD_DBL_BUF,
+                              USBD_PMA_DATA_IN0 | (USBD_PMA_DATA_IN1 << 16));
+#endif
+
+    return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_DeInit(USBD_HandleTypeDef *pdev)
+{
+    return usbd_status(HAL_PCD_DeInit((PCD_HandleTypeDef *)pdev->pData));
+}
+
+USBD_StatusTypeDef USBD_LL_Start(USBD_HandleTypeDef *pdev)
+{
+    return usbd_status(HAL_PCD_Start((PCD_HandleTypeDef *)pdev->pData));
+}
+
+USBD_StatusTypeDef USBD_LL_Stop(USBD_HandleTypeDef *pdev)
+{
+    return usbd_status(HAL_PCD_Stop((PCD_HandleTypeDef *)pdev->pData));
+}
+
+USBD_StatusTypeDef USBD_LL_OpenEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr,
+                                  uint8_t ep_type, uint16_t ep_mps)
+{
+    return usbd_status(HAL_PCD_EP_Open((PCD_HandleTypeDef *)pdev->pData, ep_addr, ep_mps, ep_type));
+}
+
+USBD_StatusTypeDef USBD_LL_CloseEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+    return usbd_status(HAL_PCD_EP_Close((PCD_HandleTypeDef *)pdev->pData, ep_addr));
+}
+
+USBD_StatusTypeDef USBD_LL_FlushEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+    return usbd_status(HAL_PCD_EP_Flush((PCD_HandleTypeDef *)pdev->pData, ep_addr));
+}
+
+USBD_StatusTypeDef USBD_LL_StallEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+    return usbd_status(HAL_PCD_EP_SetStall((PCD_HandleTypeDef *)pdev->pData, ep_addr));
+}
+
+USBD_StatusTypeDef USBD_LL_ClearStallEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+    return usbd_status(HAL_PCD_EP_ClrStall((PCD_HandleTypeDef *)pdev->pData, ep_addr));
+}
+
+uint8_t USBD_LL_IsStallEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+    PCD_HandleTypeDef *hpcd = (PCD_HandleTypeDef *)pdev->pData;
+
+    if ((ep_addr & 0x80U) != 0U) {
+        return hpcd->IN_ep[ep_addr & 0x7FU].is_stall;
+    }
+    return hpcd->OUT_ep[ep_addr & 0x7FU].is_stall;
+}
+
+USBD_StatusTypeDef USBD_LL_SetUSBAddress(USBD_HandleTypeDef *pdev, uint8_t dev_addr)
+{
+    return usbd_status(HAL_PCD_SetAddress((PCD_HandleTypeDef *)pdev->pData, dev_addr));
+}
+
+USBD_StatusTypeDef USBD_LL_Transmit(USBD_HandleTypeDef *pdev, uint8_t ep_addr,
+                                    uint8_t *pbuf, uint16_t size)
+{
+    return usbd_status(HAL_PCD_EP_Transmit((PCD_HandleTypeDef *)pdev->pData, ep_addr, pbuf, size));
+}
+
+USBD_StatusTypeDef USBD_LL_PrepareReceive(USBD_HandleTypeDef *pdev, uint8_t ep_addr,
+                                          uint8_t *pbuf, uint16_t size)
+{
+    return usbd_status(HAL_PCD_EP_Receive((PCD_HandleTypeDef *)pdev->pData, ep_addr, pbuf, size));
+}
+
+uint32_t USBD_LL_GetRxDataSize(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+    return HAL_PCD_EP_GetRxCount((PCD_HandleTypeDef *)pdev->pData, ep_addr);
+}
+
+void USBD_LL_Delay(uint32_t delay)
+{
+    HAL_Delay(delay);
+}
+
+#endif /* BOARD_USB_STREAM_ENABLE */
@@ -0,0 +1,75 @@
+#ifndef USBD_CONF_H
+#define USBD_CONF_H
+
+/**
+ * @file usbd_conf.h
+ * @brief USB device library configuration (BOARD_USB_STREAM_ENABLE builds)
+ *
+ * Included by the vendored STM32_USB_Device_Library under this name. One
+ * CDC, HID or MSC function at full speed, no debug output, and the class data
+ * comes from a static block instead of the heap (usbd_static_malloc()).
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "stm32l0xx_hal.h"
+#include "board_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * DEVICE
+ * ============================================================================ */
+
+#define USBD_MAX_NUM_INTERFACES        1U
+#define USBD_MAX_NUM_CONFIGURATION     1U
+#define USBD_MAX_STR_DESC_SIZ          64U
+#define USBD_SUPPORT_USER_STRING_DESC  0U
+#define USBD_SELF_POWERED              1U
+#define USBD_DEBUG_LEVEL               0U
+#define USBD_LPM_ENABLED               0U
+
+/* CustomHID class (BOARD_USB_CLASS_HID): one report per 1 ms frame, the
+ * sizes of usb_stream.h (checked there) */
+#define CUSTOM_HID_FS_BINTERVAL             0x01U
+#define CUSTOM_HID_EPIN_SIZE                24U
+#define USBD_CUSTOM_HID_REPORT_DESC_SIZE    21U
+
+/* ============================================================================
+ * MEMORY AND LOGGING
+ * ============================================================================ */
+
+#define USBD_malloc  usbd_static_malloc
+#define USBD_free    usbd_static_free
+#define USBD_memset  memset
+#define USBD_memcpy  memcpy
+
+#define USBD_UsrLog(...)  do {} while (0)
+#define USBD_ErrLog(...)  do {} while (0)
+#define USBD_DbgLog(...)  do {} while (0)
+
+/**
+ * @brief Class data block (one class, allocated once per configuration)
+ *
+ * @param size Bytes requested, at most the size of the class data
+ * @return The static block, NULL if too large
+ */
+void *usbd_static_malloc(uint32_t size);
+
+/**
+ * @brief Release the class data block (nothing to do)
+ */
+void usbd_static_free(void *block);
+
+/**
+ * @brief USB interrupt work (PCD HAL), called by usb_stream_irq_handler()
+ */
+void usbd_ll_irq_handler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USBD_CONF_H */
@@ -0,0 +1,176 @@
+#ifndef HAL_ATOMIC_H
+#define HAL_ATOMIC_H
+
+/**
+ * @file hal_atomic.h
+ * @brief Critical sections, single-word atomics and seqlocks (Cortex-M0+)
+ *
+ * The M0+ has no LDREX/STREX: an aligned word load or store is atomic, a
+ * read-modify-write is not. Every primitive here is built on PRIMASK, a
+ * few cycles each:
+ *   - hal_crit_enter()/hal_crit_exit(): all interrupts off, nesting by the
+ *     PRIMASK saved on entry (an inner exit does not re-enable them). For
+ *     sections shared with one interrupt only, hal_irq_mask() keeps the
+ *     others running.
+ *   - hal_atomic_*(): read-modify-write of one shared word, for flags set
+ *     by one context and taken by another, or counters bumped from more
+ *     than one.
+ *   - hal_seq_*(): a seqlock for a snapshot struct with one writer (an
+ *     interrupt or the bottom half) and readers that may be preempted by
+ *     it: the writer never waits, a reader retries a torn copy. The count
+ *     is odd while a write is in progress.
+ * Each call is a compiler barrier (the CMSIS PRIMASK intrinsics clobber
+ * memory) and the seqlock ones a __DMB(), so no shared access is moved
+ * across them.
+ *
+ * Any context.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32l0xx_hal.h"  /* For __get_PRIMASK(), __disable_irq(), __DMB() */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * CRITICAL SECTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Disable all interrupts (nesting)
+ *
+ * @return PRIMASK before, for hal_crit_exit()
+ */
+static inline uint32_t hal_crit_enter(void)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    return primask;
+}
+
+/**
+ * @brief Restore the interrupt state of the matching hal_crit_enter()
+ *
+ * @param saved Value returned by hal_crit_enter()
+ */
+static inline void hal_crit_exit(uint32_t saved)
+{
+    __set_PRIMASK(saved);
+}
+
+/* ============================================================================
+ * SINGLE-WORD ATOMICS
+ * ============================================================================ */
+
+/**
+ * @brief *word |= bits
+ *
+ * @return Value before
+ */
+static inline uint32_t hal_atomic_or(volatile uint32_t *word, uint32_t bits)
+{
+    uint32_t primask = hal_crit_enter();
+    uint32_t old = *word;
+
+    *word = old | bits;
+    hal_crit_exit(primask);
+    return old;
+}
+
+/**
+ * @brief *word &= ~bits
+ *
+ * @return Value before
+ */
+static inline uint32_t hal_atomic_clear(volatile uint32_t *word, uint32_t bits)
+{
+    uint32_t primask = hal_crit_enter();
+    uint32_t old = *word;
+
+    *word = old & ~bits;
+    hal_crit_exit(primask);
+    return old;
+}
+
+/**
+ * @brief Take the word and leave 0 (exchange)
+ *
+ * @return Value before
+ */
+static inline uint32_t hal_atomic_take(volatile uint32_t *word)
+{
+    uint32_t primask = hal_crit_enter();
+    uint32_t old = *word;
+
+    *word = 0;
+    hal_crit_exit(primask);
+    return old;
+}
+
+/**
+ * @brief *word += delta (wraps)
+ *
+ * @return Value after
+ */
+static inline uint32_t hal_atomic_add(volatile uint32_t *word, uint32_t delta)
+{
+    uint32_t primask = hal_crit_enter();
+    uint32_t value = *word + delta;
+
+    *word = value;
+    hal_crit_exit(primask);
+    return value;
+}
+
+/* ============================================================================
+ * SEQLOCK
+ * ============================================================================ */
+
+/**
+ * @brief Writer: start changing the snapshot (count goes odd)
+ */
+static inline void hal_seq_write_begin(volatile uint32_t *seq)
+{
+    *seq = *seq + 1U;
+    __DMB();
+}
+
+/**
+ * @brief Writer: snapshot complete (count goes even)
+ */
+static inline void hal_seq_write_end(volatile uint32_t *seq)
+{
+    __DMB();
+    *seq = *seq + 1U;
+}
+
+/**
+ * @brief Reader: count before copying the snapshot
+ */
+static inline uint32_t hal_seq_read_begin(const volatile uint32_t *seq)
+{
+    uint32_t start = *seq;
+
+    __DMB();
+    return start;
+}
+
+/**
+ * @brief Reader: true if the copy may be torn and must be taken again
+ *
+ * @param start hal_seq_read_begin() before the copy
+ */
+static inline bool hal_seq_read_retry(const volatile uint32_t *seq, uint32_t start)
+{
+    __DMB();
+    return (start & 1U) != 0U || *seq != start;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_ATOMIC_H */
@@ -3,161 +3,2901 @@
  * @brief HAL peripheral configuration implementation
  * 
  * This file implements HAL peripheral initialization for STM32L0.
- * I2C2 initialization for pressure sensor (100kHz)
- * I2C1 initialization for I2C slave
- * TIM2 initialization for 2ms interrupt (500Hz)
- * DAC1 initialization
+ * I2C timing profiles (standard / fast / fast-plus) from the APB1 clock
+ * I2C2 initialization for pressure sensor
+ * I2C1 initialization for I2C slave (optional DMA on DMA1 channels 2/3)
+ * INTR_MCU data-ready output
+ * TIM2 initialization for 2ms interrupt (500Hz) and CH1 conversion scheduler,
+ * or the same timebase on LPTIM1 (LSI, keeps counting in STOP)
+ * DAC1 initialization, TIM6 + DMA streaming timebase, optional TIM2 latch
+ * ADC1 background scan by DMA (DAC readback, VREFINT for VDDA tracking)
+ * COMP2 analog watchdog against a DAC threshold
+ * Clock scaling: HCLK divider with TIM2/TIM21 and I2C timings following it
  * HAL MSP callbacks for GPIO configuration
  * Uses board_config.h macros throughout
  */
 
 #include "hal_config.h"
+#include "hal_atomic.h"
 #include "board_config.h"
 #include "board_init.h"
+#if BOARD_ADC_SCAN_PERIOD_MS != 0
+#include "stm32l0xx_ll_adc.h"  /* For VREFINT_CAL_ADDR / VREFINT_CAL_VREF */
+#endif
+
+/* Timer counters are integer divisions of the bus clock in every profile */
+#if (BOARD_APB1_FREQ_HZ % BOARD_TIM2_COUNTER_HZ) != 0
+#error "BOARD_TIM2_COUNTER_HZ does not divide the APB1 clock"
+#endif
+#if BOARD_CLOCK_SCALE_ENABLE
+#if BOARD_CLOCK_SCALE_DIV == 2U
+#define HAL_CLOCK_SCALE_HPRE  RCC_SYSCLK_DIV2
+#elif BOARD_CLOCK_SCALE_DIV == 4U
+#define HAL_CLOCK_SCALE_HPRE  RCC_SYSCLK_DIV4
+#elif BOARD_CLOCK_SCALE_DIV == 8U
+#define HAL_CLOCK_SCALE_HPRE  RCC_SYSCLK_DIV8
+#elif BOARD_CLOCK_SCALE_DIV == 16U
+#define HAL_CLOCK_SCALE_HPRE  RCC_SYSCLK_DIV16
+#else
+#error "BOARD_CLOCK_SCALE_DIV must be 2, 4, 8 or 16"
+#endif
+#if ((BOARD_APB1_FREQ_HZ / BOARD_CLOCK_SCALE_DIV) % BOARD_TIM2_COUNTER_HZ) != 0
+#error "BOARD_TIM2_COUNTER_HZ does not divide the scaled APB1 clock (BOARD_CLOCK_SCALE_DIV)"
+#endif
+#endif
+/* Timestamps count whole microseconds; the boot rate is an exact 16-bit
+ * period and the ceiling for every later rate */
+#if (BOARD_TIM2_COUNTER_HZ % 1000000UL) != 0
+#error "BOARD_TIM2_COUNTER_HZ must be a multiple of 1 MHz"
+#endif
+#if BOARD_TIM2_FREQ_HZ == 0 || (BOARD_TIM2_COUNTER_HZ % BOARD_TIM2_FREQ_HZ) != 0 || \
+    (BOARD_TIM2_COUNTER_HZ / BOARD_TIM2_FREQ_HZ) > 0x10000UL
+#error "BOARD_TIM2_FREQ_HZ is not an exact 16-bit period of BOARD_TIM2_COUNTER_HZ"
+#endif
+#if BOARD_TIMEBASE == BOARD_TIMEBASE_LPTIM1 && \
+    (BOARD_LPTIM1_FREQ_HZ == 0 || BOARD_LPTIM1_FREQ_HZ > BOARD_TIM2_FREQ_HZ)
+#error "BOARD_LPTIM1_FREQ_HZ must be 1 to BOARD_TIM2_FREQ_HZ"
+#endif
+#if BOARD_I2C3_MUX_CHANNELS != 0
+/* Ports are pointer constants, out of reach of #if */
+_Static_assert(!BOARD_INTR_MCU_ENABLE ||
+               ((BOARD_INTR_MCU_PORT != BOARD_I2C3_SCL_PORT || BOARD_INTR_MCU_PIN != BOARD_I2C3_SCL_PIN) &&
+                (BOARD_INTR_MCU_PORT != BOARD_I2C3_SDA_PORT || BOARD_INTR_MCU_PIN != BOARD_I2C3_SDA_PIN)),
+               "INTR_MCU is on an I2C3 pin: move it (BOARD_INTR_MCU_PORT/PIN) or disable it");
+_Static_assert(!BOARD_COMP_ALARM_ENABLE ||
+               ((BOARD_COMP_ALARM_IN_PORT != BOARD_I2C3_SCL_PORT || BOARD_COMP_ALARM_IN_PIN != BOARD_I2C3_SCL_PIN) &&
+                (BOARD_COMP_ALARM_IN_PORT != BOARD_I2C3_SDA_PORT || BOARD_COMP_ALARM_IN_PIN != BOARD_I2C3_SDA_PIN)),
+               "The comparator alarm input is on an I2C3 pin");
+#endif
+#if BOARD_LOG_PERIOD_S > 3600U
+#error "BOARD_LOG_PERIOD_S must be 0 (off) or 1 to 3600"
+#endif
+#if BOARD_DAC_STREAM_ENABLE && (BOARD_APB1_FREQ_HZ % BOARD_DAC_STREAM_COUNTER_HZ) != 0
+#error "BOARD_DAC_STREAM_COUNTER_HZ does not divide the APB1 clock"
+#endif
 
 /* HAL peripheral handles - defined in main.c */
 extern I2C_HandleTypeDef hi2c1;
 extern I2C_HandleTypeDef hi2c2;
+#if BOARD_I2C3_MUX_CHANNELS != 0
+extern I2C_HandleTypeDef hi2c3;
+#endif
 extern DAC_HandleTypeDef hdac1;
 extern TIM_HandleTypeDef htim2;
 
+#if BOARD_I2C1_SLAVE_DMA
+/* I2C1 slave DMA channels, linked to hi2c1 in HAL_I2C_MspInit() */
+static DMA_HandleTypeDef hdma_i2c1_tx;
+static DMA_HandleTypeDef hdma_i2c1_rx;
+#endif
+
+#if BOARD_ADC_SCAN_PERIOD_MS != 0
+/* ADC1: one scan per trigger (TIM22 TRGO or the main loop), moved by circular
+ * DMA; the transfer-complete callback keeps a copy for the main loop. Inputs
+ * below; the ADC converts, and the DMA stores, them in channel-number order */
+#define HAL_ADC_SCAN_OUT1     0U
+#define HAL_ADC_SCAN_OUT2     1U
+#define HAL_ADC_SCAN_VREFINT  2U
+#define HAL_ADC_SCAN_TEMP     3U
+#if BOARD_ADC_SUPPLY_ENABLE
+#define HAL_ADC_SCAN_SUPPLY   4U
+#define HAL_ADC_SCAN_COUNT    5U
+#else
+#define HAL_ADC_SCAN_COUNT    4U
+#endif
+static ADC_HandleTypeDef hadc1;
+static DMA_HandleTypeDef hdma_adc1;
+static uint16_t adc_scan_buffer[HAL_ADC_SCAN_COUNT];  /* DMA target, channel order */
+static uint16_t adc_scan_result[HAL_ADC_SCAN_COUNT];  /* Newest complete scan, by input */
+static uint8_t adc_scan_slot[HAL_ADC_SCAN_COUNT];     /* Buffer index of each input */
+static volatile uint32_t adc_scan_done = 0;           /* Scans completed */
+static uint32_t adc_scan_taken = 0;                   /* Scans collected */
+#endif
+
+#if BOARD_COMP_ALARM_ENABLE
+/* COMP2: alarm input against the DAC threshold output, EXTI line 22 */
+static COMP_HandleTypeDef hcomp2;
+#endif
+
+#if BOARD_DAC_STREAM_ENABLE
+/* DAC stream trigger timer and DMA channel, linked to hdac1 in hal_dac1_init() */
+static TIM_HandleTypeDef htim6;
+static DMA_HandleTypeDef hdma_dac1;
+#endif
+
+#if BOARD_TRACE_ENABLE
+/* Trace output: LPUART1 TX fed by DMA, started by hal_trace_tx_start() */
+static DMA_HandleTypeDef hdma_trace;
+#endif
+
+#if BOARD_UART_STREAM_ENABLE
+/* UART stream: USART2 TX from pool blocks, RX into a circular buffer */
+static DMA_HandleTypeDef hdma_uart_tx;
+static DMA_HandleTypeDef hdma_uart_rx;
+#endif
+
+#if BOARD_SD_LOG_ENABLE
+/* SD card sector sends: SPI2 TX fed by DMA, polled by hal_sd_spi_tx_done() */
+static DMA_HandleTypeDef hdma_sd_tx;
+#endif
+
+#if BOARD_CRC_FRAMING_ENABLE
+/* CRC-32 jobs: memory to CRC_DR, polled by hal_crc_dma_done() */
+static DMA_HandleTypeDef hdma_crc;
+#endif
+
+#if BOARD_DMA_COPY_ENABLE
+/* Memory-to-memory copies (dma_copy.h), completed in the channel interrupt */
+static DMA_HandleTypeDef hdma_copy;
+#endif
+
+#if BOARD_IWDG_ENABLE
+/* Independent watchdog: started once, refreshed by hal_iwdg_refresh() */
+static IWDG_HandleTypeDef hiwdg;
+
+/* Reload (LSI / 256) rounded up to give at least BOARD_IWDG_TIMEOUT_MS on
+ * the fastest LSI */
+#define HAL_IWDG_RELOAD  ((BOARD_IWDG_TIMEOUT_MS * BOARD_LSI_MAX_HZ + 255999UL) / 256000UL)
+#if HAL_IWDG_RELOAD > 0xFFFUL
+#error "BOARD_IWDG_TIMEOUT_MS too long for the 12-bit IWDG reload at BOARD_LSI_MAX_HZ"
+#endif
+#endif
+
+/* ============================================================================
+ * I2C Timing Profiles
+ * ============================================================================ */
+
+/**
+ * @brief Target times of one speed profile, in ns
+ * 
+ * RM0377 reference settings (table "timing settings for fI2CCLK = 16 MHz"),
+ * kept as times so they convert to any kernel clock. The slowest kernel
+ * clock meets tI2CCLK < (tLOW - tfilters) / 4 (RM0377) with the longest
+ * analog filter delay (260 ns) for standard and fast mode, the shortest
+ * (50 ns) for fast-plus, which RM0377 also sets at 16 MHz.
+ */
+typedef struct {
+    uint16_t scl_low_ns;   /* tSCLL */
+    uint16_t scl_high_ns;  /* tSCLH */
+    uint16_t sdadel_ns;    /* Data hold after SCL falls */
+    uint16_t scldel_ns;    /* Data setup before SCL rises */
+    uint16_t min_clk_khz;  /* Slowest kernel clock */
+} hal_i2c_profile_t;
+
+static const hal_i2c_profile_t i2c_profiles[HAL_I2C_SPEED_COUNT] = {
+    { 5000, 4000, 500, 1250, 1000 },  /* Standard, 100 kHz */
+    { 1250,  500, 250,  500, 4000 },  /* Fast, 400 kHz */
+    {  312,  187,   0,  187, 9000 },  /* Fast-plus, 1 MHz */
+};
+
+/**
+ * @brief Kernel clock periods (of PRESC+1 clocks) covering a time, rounded up
+ */
+static uint32_t hal_i2c_counts(uint32_t ns, uint32_t clk_khz, uint32_t presc)
+{
+    uint32_t div = 1000000UL * (presc + 1U);
+    
+    return (ns * clk_khz + div - 1U) / div;
+}
+
+uint32_t hal_i2c_timing(hal_i2c_speed_t speed, uint32_t i2cclk_hz)
+{
+    const hal_i2c_profile_t *profile;
+    uint32_t clk_khz = i2cclk_hz / 1000U;
+    
+    if (speed >= HAL_I2C_SPEED_COUNT || clk_khz == 0U || clk_khz > 64000U) {
+        return 0;  /* Also keeps ns * kHz within 32 bits */
+    }
+    profile = &i2c_profiles[speed];
+    if (clk_khz < profile->min_clk_khz) {
+        return 0;  /* Kernel clock too slow for this speed */
+    }
+    
+    for (uint32_t presc = 0; presc < 16U; presc++) {
+        uint32_t scll = hal_i2c_counts(profile->scl_low_ns, clk_khz, presc);
+        uint32_t sclh = hal_i2c_counts(profile->scl_high_ns, clk_khz, presc);
+        uint32_t scldel = hal_i2c_counts(profile->scldel_ns, clk_khz, presc);
+        uint32_t sdadel = hal_i2c_counts(profile->sdadel_ns, clk_khz, presc);
+        
+        /* SCLL, SCLH and SCLDEL count from 1, SDADEL from 0 */
+        if (scll == 0U || sclh == 0U || scldel == 0U) {
+            return 0;  /* Kernel clock too slow for this speed */
+        }
+        if (scll <= 256U && sclh <= 256U && scldel <= 16U && sdadel <= 15U) {
+            return (presc << 28) | ((scldel - 1U) << 20) | (sdadel << 16) |
+                   ((sclh - 1U) << 8) | (scll - 1U);
+        }
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief Enable Fm+ pin drive if the profile needs it
+ */
+static void hal_i2c_config_fast_plus(hal_i2c_speed_t speed, uint32_t fmp)
+{
+    __HAL_RCC_SYSCFG_CLK_ENABLE();
+    
+    if (speed == HAL_I2C_SPEED_FAST_PLUS) {
+        HAL_I2CEx_EnableFastModePlus(fmp);
+    } else {
+        HAL_I2CEx_DisableFastModePlus(fmp);
+    }
+}
+
+/**
+ * @brief Set up an I2C master for sensors, completions at the tick priority
+ * 
+ * Same priority as TIM2 so transfer completions never preempt the
+ * sampling tick (and vice versa).
+ */
+static bool hal_i2c_sensor_bus_init(I2C_HandleTypeDef *hi2c, I2C_TypeDef *periph,
+                                    hal_i2c_speed_t speed, uint32_t fmp,
+                                    IRQn_Type irqn, uint32_t priority)
+{
+    hi2c->Instance = periph;
+    hi2c->Init.Timing = hal_i2c_timing(speed, board_get_apb1_freq());
+    hi2c->Init.OwnAddress1 = 0;
+    hi2c->Init.AddressingMode = I2C_ADDRESSINGMODE_7BIT;
+    hi2c->Init.DualAddressMode = I2C_DUALADDRESS_DISABLE;
+    hi2c->Init.OwnAddress2 = 0;
+    hi2c->Init.OwnAddress2Masks = I2C_OA2_NOMASK;
+    hi2c->Init.GeneralCallMode = I2C_GENERALCALL_DISABLE;
+    hi2c->Init.NoStretchMode = I2C_NOSTRETCH_DISABLE;
+    
+    if (hi2c->Init.Timing == 0U) {
+        return false;
+    }
+    hal_i2c_config_fast_plus(speed, fmp);
+    
+    /* A re-init (new speed) skips MspInit: the bus may be gated */
+    hal_i2c_bus_clock(hi2c, true);
+    if (HAL_I2C_Init(hi2c) != HAL_OK) {
+        return false;
+    }
+    
+    /* Configure I2C analog filter */
+    if (HAL_I2CEx_ConfigAnalogFilter(hi2c, I2C_ANALOGFILTER_ENABLE) != HAL_OK) {
+        return false;
+    }
+    
+    /* Interrupt for the asynchronous sensor transport */
+    HAL_NVIC_SetPriority(irqn, priority, 0);
+    HAL_NVIC_EnableIRQ(irqn);
+    
+    return true;
+}
+
+/* ============================================================================
+ * I2C2 Configuration (Pressure Sensor)
+ * ============================================================================ */
+
+/* Profile of the next init: BOARD_I2C2_SPEED until the tuner picks one */
+static hal_i2c_speed_t i2c2_speed = BOARD_I2C2_SPEED;
+
+bool hal_i2c2_init(void)
+{
+    return hal_i2c_sensor_bus_init(&hi2c2, BOARD_I2C2_PERIPH, i2c2_speed,
+                                   I2C_FASTMODEPLUS_I2C2, I2C2_IRQn, BOARD_IRQ_PRIO_I2C2);
+}
+
+void hal_i2c2_set_speed(hal_i2c_speed_t speed)
+{
+    if (speed < HAL_I2C_SPEED_COUNT) {
+        i2c2_speed = speed;
+    }
+}
+
+hal_i2c_speed_t hal_i2c2_get_speed(void)
+{
+    return i2c2_speed;
+}
+
+#if BOARD_I2C3_MUX_CHANNELS != 0
+/* ============================================================================
+ * I2C3 Configuration (Second Probe Bus)
+ * ============================================================================ */
+
+static hal_i2c_speed_t i2c3_speed = BOARD_I2C3_SPEED;
+
+bool hal_i2c3_init(void)
+{
+    return hal_i2c_sensor_bus_init(&hi2c3, BOARD_I2C3_PERIPH, i2c3_speed,
+                                   I2C_FASTMODEPLUS_I2C3, I2C3_IRQn, BOARD_IRQ_PRIO_I2C3);
+}
+
+void hal_i2c3_set_speed(hal_i2c_speed_t speed)
+{
+    if (speed < HAL_I2C_SPEED_COUNT) {
+        i2c3_speed = speed;
+    }
+}
+
+hal_i2c_speed_t hal_i2c3_get_speed(void)
+{
+    return i2c3_speed;
+}
+#endif
+
+/* Half an SCL period of the manual recovery clock (~100kHz, any slave copes) */
+#define HAL_I2C2_RECOVERY_HALF_US   5U
+
+/* HAL error codes that mean the bus itself (not the addressed device) failed */
+#define HAL_I2C2_BUS_ERRORS         (HAL_I2C_ERROR_BERR | HAL_I2C_ERROR_ARLO | HAL_I2C_ERROR_TIMEOUT)
+
+void hal_i2c_bus_clock(I2C_HandleTypeDef *hi2c, bool on)
+{
+    uint32_t bit;
+    
+    if (hi2c->Instance == BOARD_I2C2_PERIPH) {
+        bit = RCC_APB1ENR_I2C2EN;
+#if BOARD_I2C3_MUX_CHANNELS != 0
+    } else if (hi2c->Instance == BOARD_I2C3_PERIPH) {
+        bit = RCC_APB1ENR_I2C3EN;
+#endif
+    } else {
+        return;
+    }
+    
+    /* APB1ENR is shared with every other APB1 peripheral */
+    if (on) {
+        (void)hal_atomic_or(&RCC->APB1ENR, bit);
+        (void)RCC->APB1ENR;  /* Clock running before the next register access */
+    } else {
+        (void)hal_atomic_clear(&RCC->APB1ENR, bit);
+    }
+}
+
+bool hal_i2c2_bus_fault(void)
+{
+    if ((HAL_I2C_GetError(&hi2c2) & HAL_I2C2_BUS_ERRORS) != 0U) {
+        return true;
+    }
+    
+    /* The flag reads 0 while gated (BOARD_SENSOR_BUS_CLOCK_GATE) */
+    hal_i2c_bus_clock(&hi2c2, true);
+    
+    /* BUSY with no transfer of ours in flight: a slave holds the bus */
+    return HAL_I2C_GetState(&hi2c2) == HAL_I2C_STATE_READY &&
+           __HAL_I2C_GET_FLAG(&hi2c2, I2C_FLAG_BUSY);
+}
+
+bool hal_i2c2_nacked(void)
+{
+    uint32_t error = HAL_I2C_GetError(&hi2c2);
+    
+    return (error & HAL_I2C_ERROR_AF) != 0U && (error & HAL_I2C2_BUS_ERRORS) == 0U;
+}
+
+bool hal_i2c2_is_idle(void)
+{
+    return HAL_I2C_GetState(&hi2c2) == HAL_I2C_STATE_READY;
+}
+
+bool hal_i2c2_recover(void)
+{
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+    uint16_t scl = (uint16_t)(1UL << BOARD_I2C2_SCL_PIN);
+    uint16_t sda = (uint16_t)(1UL << BOARD_I2C2_SDA_PIN);
+    
+    /* Releases the pins from the peripheral (MspDeInit) */
+    (void)HAL_I2C_DeInit(&hi2c2);
+    
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+    HAL_GPIO_WritePin(BOARD_I2C2_SCL_PORT, scl | sda, GPIO_PIN_SET);
+    GPIO_InitStruct.Pin = scl | sda;
+    GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_OD;
+    GPIO_InitStruct.Pull = GPIO_PULLUP;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_MEDIUM;
+    HAL_GPIO_Init(BOARD_I2C2_SCL_PORT, &GPIO_InitStruct);
+    
+    /* Up to nine clocks let a slave stuck mid-byte finish it and release SDA */
+    for (uint32_t i = 0; i < 9U &&
+         HAL_GPIO_ReadPin(BOARD_I2C2_SDA_PORT, sda) == GPIO_PIN_RESET; i++) {
+        HAL_GPIO_WritePin(BOARD_I2C2_SCL_PORT, scl, GPIO_PIN_RESET);
+        board_delay_us(HAL_I2C2_RECOVERY_HALF_US);
+        HAL_GPIO_WritePin(BOARD_I2C2_SCL_PORT, scl, GPIO_PIN_SET);
+        board_delay_us(HAL_I2C2_RECOVERY_HALF_US);
+    }
+    
+    /* STOP condition: SDA rises while SCL is high */
+    HAL_GPIO_WritePin(BOARD_I2C2_SCL_PORT, scl, GPIO_PIN_RESET);
+    HAL_GPIO_WritePin(BOARD_I2C2_SDA_PORT, sda, GPIO_PIN_RESET);
+    board_delay_us(HAL_I2C2_RECOVERY_HALF_US);
+    HAL_GPIO_WritePin(BOARD_I2C2_SCL_PORT, scl, GPIO_PIN_SET);
+    board_delay_us(HAL_I2C2_RECOVERY_HALF_US);
+    HAL_GPIO_WritePin(BOARD_I2C2_SDA_PORT, sda, GPIO_PIN_SET);
+    board_delay_us(HAL_I2C2_RECOVERY_HALF_US);
+    
+    if (HAL_GPIO_ReadPin(BOARD_I2C2_SDA_PORT, sda) == GPIO_PIN_RESET ||
+        HAL_GPIO_ReadPin(BOARD_I2C2_SCL_PORT, scl) == GPIO_PIN_RESET) {
+        return false;  /* Still held low: retried on the next tick */
+    }
+    
+    /* Back to alternate function (MspInit) with a clean peripheral */
+    return hal_i2c2_init();
+}
+
+/* ============================================================================
+ * I2C1 Configuration (I2C Slave)
+ * ============================================================================ */
+
+#if BOARD_I2C1_SCL_TIMEOUT_MS != 0
+/**
+ * @brief SCL-low timeout: a bus held low this long raises TIMEOUT
+ * 
+ * TIMEOUTA counts 2048 kernel clocks per step (12 bits, about 260 ms at
+ * 32 MHz). The timeout bits only take with PE cleared; the slave driver
+ * frees the bus when it fires (i2c_slave.h).
+ */
+static void hal_i2c1_config_timeout(uint32_t kernel_hz)
+{
+    I2C_TypeDef *i2c = BOARD_I2C1_PERIPH;
+    uint32_t steps = (kernel_hz / 1000U) * BOARD_I2C1_SCL_TIMEOUT_MS / 2048U;
+    
+    if (steps == 0U) {
+        steps = 1U;
+    }
+    if (steps > 4096U) {
+        steps = 4096U;
+    }
+    
+    i2c->CR1 &= ~I2C_CR1_PE;
+    i2c->TIMEOUTR = 0;
+    i2c->TIMEOUTR = (steps - 1U) | I2C_TIMEOUTR_TIMOUTEN;  /* TIDLE 0: SCL low */
+    i2c->CR1 |= I2C_CR1_PE;
+}
+#endif
+
+#if BOARD_I2C1_SMBUS
+/**
+ * @brief SMBus personality: slave byte control and PEC (PE cleared)
+ */
+static void hal_i2c1_config_smbus(void)
+{
+    I2C_TypeDef *i2c = BOARD_I2C1_PERIPH;
+    
+    i2c->CR1 &= ~I2C_CR1_PE;
+    i2c->CR1 |= I2C_CR1_SBC | I2C_CR1_PECEN;
+    i2c->CR1 |= I2C_CR1_PE;
+}
+#endif
+
+bool hal_i2c1_init(uint8_t slave_addr)
+{
+    uint32_t kernel_hz = board_get_apb1_freq();
+    
+#if BOARD_I2C1_WAKEUP_STOP || BOARD_CLOCK_SCALE_ENABLE
+    /* Address recognition in STOP needs HSI as the kernel clock; the core
+     * also wakes up on HSI so the transfer runs at the same clock. With
+     * clock scaling HSI keeps the slave timing off the divided PCLK1 */
+    RCC_PeriphCLKInitTypeDef clk_config = {0};
+    
+    clk_config.PeriphClockSelection = RCC_PERIPHCLK_I2C1;
+    clk_config.I2c1ClockSelection = RCC_I2C1CLKSOURCE_HSI;
+    if (HAL_RCCEx_PeriphCLKConfig(&clk_config) != HAL_OK) {
+        return false;
+    }
+#if BOARD_I2C1_WAKEUP_STOP
+    __HAL_RCC_WAKEUPSTOP_CLK_CONFIG(RCC_STOP_WAKEUPCLOCK_HSI);
+#endif
+    kernel_hz = BOARD_HSI_FREQ_HZ;
+#endif
+    
+    hi2c1.Instance = BOARD_I2C1_PERIPH;
+    hi2c1.Init.Timing = hal_i2c_timing(BOARD_I2C1_SPEED, kernel_hz);
+    hi2c1.Init.OwnAddress1 = ((uint32_t)slave_addr << 1);  /* 7-bit address shifted */
+    hi2c1.Init.AddressingMode = I2C_ADDRESSINGMODE_7BIT;
+    hi2c1.Init.DualAddressMode = (BOARD_I2C1_SLAVE_ADDR2 != 0) ? I2C_DUALADDRESS_ENABLE : I2C_DUALADDRESS_DISABLE;
+    hi2c1.Init.OwnAddress2 = ((uint32_t)BOARD_I2C1_SLAVE_ADDR2 << 1);  /* Alias endpoint (i2c_slave_set_alias()) */
+    hi2c1.Init.OwnAddress2Masks = BOARD_I2C1_SLAVE_ADDR2_MASK;
+    hi2c1.Init.GeneralCallMode = BOARD_I2C1_GENERAL_CALL ? I2C_GENERALCALL_ENABLE : I2C_GENERALCALL_DISABLE;
+    hi2c1.Init.NoStretchMode = BOARD_I2C1_SLAVE_NOSTRETCH ? I2C_NOSTRETCH_ENABLE : I2C_NOSTRETCH_DISABLE;
+    
+    if (hi2c1.Init.Timing == 0U) {
+        return false;
+    }
+    hal_i2c_config_fast_plus(BOARD_I2C1_SPEED, I2C_FASTMODEPLUS_I2C1);
+    
+    if (HAL_I2C_Init(&hi2c1) != HAL_OK) {
+        return false;
+    }
+    
+    /* Configure I2C analog filter */
+    if (HAL_I2CEx_ConfigAnalogFilter(&hi2c1, I2C_ANALOGFILTER_ENABLE) != HAL_OK) {
+        return false;
+    }
+    
+#if BOARD_I2C1_WAKEUP_STOP
+    /* Address match wakes the MCU from STOP (WUPEN) */
+    if (HAL_I2CEx_EnableWakeUp(&hi2c1) != HAL_OK) {
+        return false;
+    }
+#endif
+    
+#if BOARD_I2C1_SCL_TIMEOUT_MS != 0
+    hal_i2c1_config_timeout(kernel_hz);
+#endif
+#if BOARD_I2C1_SMBUS
+    hal_i2c1_config_smbus();
+#endif
+    
+    /* Enable I2C1 interrupts for slave mode */
+    /* Note: STM32L0 uses single I2C1_IRQn for both event and error interrupts */
+    HAL_NVIC_SetPriority(I2C1_IRQn, BOARD_IRQ_PRIO_I2C1, 0);
+    HAL_NVIC_EnableIRQ(I2C1_IRQn);
+    
+    return true;
+}
+
+/* ============================================================================
+ * INTR_MCU (Data-Ready Output to the I2C Master)
+ * ============================================================================ */
+
+#define HAL_INTR_MCU_PIN            ((uint16_t)(1UL << BOARD_INTR_MCU_PIN))
+#define HAL_INTR_MCU_LEVEL(asserted) \
+    (((asserted) != (BOARD_INTR_MCU_ACTIVE_LOW != 0)) ? GPIO_PIN_SET : GPIO_PIN_RESET)
+
+bool hal_intr_mcu_init(void)
+{
+#if BOARD_INTR_MCU_ENABLE
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+    
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    /* Level set before the pin is driven: no glitch at boot */
+    HAL_GPIO_WritePin(BOARD_INTR_MCU_PORT, HAL_INTR_MCU_PIN, HAL_INTR_MCU_LEVEL(false));
+    GPIO_InitStruct.Pin = HAL_INTR_MCU_PIN;
+    GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+    HAL_GPIO_Init(BOARD_INTR_MCU_PORT, &GPIO_InitStruct);
+#endif
+    return true;
+}
+
+void hal_intr_mcu_set(bool asserted)
+{
+#if BOARD_INTR_MCU_ENABLE
+    /* BSRR/BRR write: atomic, no read-modify-write against other pins */
+    HAL_GPIO_WritePin(BOARD_INTR_MCU_PORT, HAL_INTR_MCU_PIN, HAL_INTR_MCU_LEVEL(asserted));
+#else
+    (void)asserted;
+#endif
+}
+
+#if BOARD_TIMEBASE == BOARD_TIMEBASE_TIM2
+/* ============================================================================
+ * TIM2 Configuration (2ms Sampling Timer + Conversion Scheduler)
+ * ============================================================================ */
+/*
+    System clock: 16 MHz HSI
+    TIM2 prescaler: 16 (counter clock = 1 MHz, 1 us resolution)
+    TIM2 period: 2000 counts (2ms period = 500 Hz)
+    Update interrupt triggers every 2ms to advance the sensor reading state machine
+    CH1 output compare (timing mode) is a one-shot that fires when a sensor
+    conversion is complete, see hal_tim2_schedule_us()
+*/
+
+/* One-shot CH1 schedule: whole periods still to elapse, then compare value */
+static volatile uint32_t tim2_schedule_periods = 0;
+static volatile uint32_t tim2_schedule_ccr = 0;
+static volatile bool tim2_schedule_waiting = false;
+
+/* Counter counts accumulated over completed TIM2 periods (timestamp base) */
+static volatile uint32_t tim2_elapsed_counts = 0;
+
+/* Period of the flagged update already in tim2_elapsed_counts
+ * (hal_tim2_count_update()), until hal_tim2_schedule_update() */
+static volatile bool tim2_update_counted = false;
+
+/* Period (ARR + 1) preloaded for the next update event, 0 = none */
+static volatile uint32_t tim2_pending_period = 0;
+
+/* Period to preload once a trimmed one starts (hal_tim2_trim_period()), 0 = none */
+static volatile uint32_t tim2_restore_period = 0;
+
+/**
+ * @brief Arm TIM2 CH1 compare interrupt at the given counter value
+ *
+ * A match only fires when the counter equals the compare value: a target
+ * the counter went past before the CCR write (late caller, or a wrap
+ * since it read the counter) would wait a whole period. The counter is
+ * read again after the write, and such a target is fired by hand.
+ *
+ * @param ccr  Target in the current period
+ * @param from Counter value the target was taken from (0 at an update)
+ */
+static void hal_tim2_arm_compare(uint32_t ccr, uint32_t from)
+{
+    uint32_t cnt;
+    
+    __HAL_TIM_SET_COMPARE(&htim2, TIM_CHANNEL_1, ccr);
+    __HAL_TIM_CLEAR_FLAG(&htim2, TIM_FLAG_CC1);
+    __HAL_TIM_ENABLE_IT(&htim2, TIM_IT_CC1);
+    
+    /* Passed, or wrapped past the end of the period: fire right away */
+    cnt = __HAL_TIM_GET_COUNTER(&htim2);
+    if (cnt >= ccr || cnt < from) {
+        htim2.Instance->EGR = TIM_EGR_CC1G;
+    }
+}
+
+bool hal_tim2_init(void)
+{
+    TIM_OC_InitTypeDef oc_config = {0};
+#if BOARD_DAC_LATCH_ENABLE
+    TIM_MasterConfigTypeDef master_config = {0};
+#endif
+    
+    /* For STM32L0: If APB prescaler = 1, timer clock = APB clock (no multiplier)
+     *              If APB prescaler > 1, timer clock = APB clock * 2
+     * Since we use prescaler = 1, timer clock = APB1 clock = 16MHz */
+    /* Counter runs at BOARD_TIM2_COUNTER_HZ (1 MHz) so compare values are in us.
+     * Period in counts = counter_freq / sample_freq = 1,000,000 / 500 = 2000 */
+    uint32_t prescaler = (board_get_apb1_freq() / BOARD_TIM2_COUNTER_HZ) - 1;
+    uint32_t period = (BOARD_TIM2_COUNTER_HZ / BOARD_TIM2_FREQ_HZ) - 1;
+    
+    htim2.Instance = BOARD_TIM2_PERIPH;
+    htim2.Init.Prescaler = prescaler;
+    htim2.Init.CounterMode = TIM_COUNTERMODE_UP;
+    htim2.Init.Period = period;
+    htim2.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    /* Rate changes land on an update event, never mid-period */
+    htim2.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
+    
+    if (HAL_TIM_Base_Init(&htim2) != HAL_OK) {
+        return false;
+    }
+    
+    /* CH1 output compare in timing mode (no pin) for conversion scheduling */
+    if (HAL_TIM_OC_Init(&htim2) != HAL_OK) {
+        return false;
+    }
+    
+#if BOARD_DAC_LATCH_ENABLE
+    /* TRGO on update: the DAC converts its data registers on every tick */
+    master_config.MasterOutputTrigger = TIM_TRGO_UPDATE;
+    master_config.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+    if (HAL_TIMEx_MasterConfigSynchronization(&htim2, &master_config) != HAL_OK) {
+        return false;
+    }
+#endif
+    
+    oc_config.OCMode = TIM_OCMODE_TIMING;
+    oc_config.Pulse = 0;
+    oc_config.OCPolarity = TIM_OCPOLARITY_HIGH;
+    oc_config.OCFastMode = TIM_OCFAST_DISABLE;
+    if (HAL_TIM_OC_ConfigChannel(&htim2, &oc_config, TIM_CHANNEL_1) != HAL_OK) {
+        return false;
+    }
+    
+    /* Configure TIM2 interrupt */
+    HAL_NVIC_SetPriority(TIM2_IRQn, BOARD_IRQ_PRIO_TIMEBASE, 0);
+    HAL_NVIC_EnableIRQ(TIM2_IRQn);
+    
+    return true;
+}
+
+bool hal_tim2_start(void)
+{
+    return (HAL_TIM_Base_Start_IT(&htim2) == HAL_OK);
+}
+
+bool hal_tim2_stop(void)
+{
+    hal_tim2_schedule_cancel();
+    return (HAL_TIM_Base_Stop_IT(&htim2) == HAL_OK);
+}
+
+bool hal_tim2_is_running(void)
+{
+    return (htim2.Instance != NULL) && ((htim2.Instance->CR1 & TIM_CR1_CEN) != 0U);
+}
+
+bool hal_tim2_tick_pending(void)
+{
+    return __HAL_TIM_GET_FLAG(&htim2, TIM_FLAG_UPDATE) != RESET;
+}
+
+bool hal_tim2_schedule_us(uint32_t delay_us)
+{
+    uint32_t period = htim2.Init.Period + 1U;
+    uint32_t primask;
+    uint32_t cnt;
+    uint32_t target;
+    
+    /* Counter read to CCR write not preempted: at most the few cycles of a
+     * wrap in between, which hal_tim2_arm_compare() catches */
+    primask = hal_crit_enter();
+    if (tim2_schedule_waiting || (htim2.Instance->DIER & TIM_IT_CC1) != 0U) {
+        hal_crit_exit(primask);
+        return false;  /* One-shot already armed */
+    }
+    
+    cnt = __HAL_TIM_GET_COUNTER(&htim2);
+    target = cnt + delay_us * (BOARD_TIM2_COUNTER_HZ / 1000000UL);
+    tim2_schedule_periods = target / period;
+    tim2_schedule_ccr = target % period;
+    
+    if (tim2_schedule_periods == 0U) {
+        hal_tim2_arm_compare(tim2_schedule_ccr, cnt);
+    } else {
+        /* Longer than the remaining period: armed from hal_tim2_schedule_update() */
+        tim2_schedule_waiting = true;
+    }
+    hal_crit_exit(primask);
+    
+    return true;
+}
+
+void hal_tim2_schedule_cancel(void)
+{
+    tim2_schedule_waiting = false;
+    __HAL_TIM_DISABLE_IT(&htim2, TIM_IT_CC1);
+}
+
+void hal_tim2_count_update(void)
+{
+    uint32_t primask = hal_crit_enter();
+    
+    if (!tim2_update_counted && __HAL_TIM_GET_FLAG(&htim2, TIM_FLAG_UPDATE) != RESET &&
+        __HAL_TIM_GET_IT_SOURCE(&htim2, TIM_IT_UPDATE) != RESET) {
+        tim2_elapsed_counts += htim2.Init.Period + 1U;
+        tim2_update_counted = true;
+    }
+    hal_crit_exit(primask);
+}
+
+void hal_tim2_schedule_update(void)
+{
+    if (!tim2_update_counted) {
+        tim2_elapsed_counts += htim2.Init.Period + 1U;
+    }
+    tim2_update_counted = false;
+    
+    /* Rate change: the preloaded ARR took effect at this update event, so
+     * the period that ended was counted with the old one */
+    if (tim2_pending_period != 0U) {
+        htim2.Init.Period = tim2_pending_period - 1U;
+        tim2_pending_period = 0;
+        
+        /* Trimmed period just started: the rate is back after it */
+        if (tim2_restore_period != 0U) {
+            htim2.Instance->ARR = tim2_restore_period - 1U;
+            tim2_pending_period = tim2_restore_period;
+            tim2_restore_period = 0;
+        }
+    }
+    
+    if (!tim2_schedule_waiting) {
+        return;
+    }
+    
+    if (--tim2_schedule_periods == 0U) {
+        tim2_schedule_waiting = false;
+        hal_tim2_arm_compare(tim2_schedule_ccr, 0U);
+    }
+}
+
+bool hal_tim2_set_rate_hz(uint32_t rate_hz)
+{
+    uint32_t period;
+    uint32_t primask;
+    
+    /* Tick-based conversion delays are sized for BOARD_TIM2_FREQ_HZ: only
+     * slower ticks keep them valid. TIM2 is a 16-bit counter */
+    if (rate_hz == 0U || rate_hz > BOARD_TIM2_FREQ_HZ) {
+        return false;
+    }
+    
+    /* Nearest period: never below the BOARD_TIM2_FREQ_HZ one */
+    period = (BOARD_TIM2_COUNTER_HZ + rate_hz / 2U) / rate_hz;
+    if (period > 0x10000UL) {
+        return false;
+    }
+    
+    /* Preload and note it together: the update ISR that sees the note is
+     * the one at which the new ARR took effect */
+    primask = hal_crit_enter();
+    htim2.Instance->ARR = period - 1U;  /* Init.Period keeps the running one */
+    tim2_pending_period = period;
+    tim2_restore_period = 0;            /* A trim not started yet is dropped */
+    hal_crit_exit(primask);
+    return true;
+}
+
+uint32_t hal_tim2_get_rate_hz(void)
+{
+    uint32_t period = (tim2_restore_period != 0U) ? tim2_restore_period :
+                      (tim2_pending_period != 0U) ? tim2_pending_period : htim2.Init.Period + 1U;
+    
+    return (BOARD_TIM2_COUNTER_HZ + period / 2U) / period;
+}
+
+uint32_t hal_tim2_get_timestamp_us(void)
+{
+    uint32_t primask;
+    uint32_t base;
+    uint32_t cnt;
+    
+    /* Base, counter and flag of one instant: the update handler cannot
+     * run in between, and it counts the period as the flag is seen */
+    primask = hal_crit_enter();
+    cnt = __HAL_TIM_GET_COUNTER(&htim2);
+    base = tim2_elapsed_counts;
+    
+    /* Wrapped, possibly after the first read: the counter again, and the
+     * period if the handler has not counted it yet (caller is at the same
+     * or higher priority) */
+    if (__HAL_TIM_GET_FLAG(&htim2, TIM_FLAG_UPDATE) != RESET) {
+        cnt = __HAL_TIM_GET_COUNTER(&htim2);
+        if (!tim2_update_counted) {
+            cnt += htim2.Init.Period + 1U;
+        }
+    }
+    hal_crit_exit(primask);
+    
+    return (base + cnt) / (BOARD_TIM2_COUNTER_HZ / 1000000UL);
+}
+
+uint32_t hal_tim2_get_next_tick_us(void)
+{
+    uint32_t primask;
+    uint32_t base;
+    uint32_t end;
+    
+    primask = hal_crit_enter();
+    base = tim2_elapsed_counts;
+    end = htim2.Init.Period + 1U;
+    
+    /* Wrapped, update interrupt not run yet: the period after that one,
+     * at the ARR it preloaded (the one that ended is in the base once
+     * counted) */
+    if (__HAL_TIM_GET_FLAG(&htim2, TIM_FLAG_UPDATE) != RESET) {
+        end = (tim2_update_counted ? 0U : end) + htim2.Instance->ARR + 1U;
+    }
+    hal_crit_exit(primask);
+    
+    return (base + end) / (BOARD_TIM2_COUNTER_HZ / 1000000UL);
+}
+
+bool hal_tim2_advance_us(uint32_t us)
+{
+    if (hal_tim2_is_running()) {
+        return false;
+    }
+    
+    tim2_elapsed_counts += us * (BOARD_TIM2_COUNTER_HZ / 1000000UL);
+    return true;
+}
+
+bool hal_tim2_restart_period(void)
+{
+    uint32_t period = htim2.Init.Period + 1U;
+    uint32_t primask;
+    uint32_t cnt;
+    uint32_t remaining = 0;
+    bool scheduled;
+    
+    if (!hal_tim2_is_running()) {
+        return false;
+    }
+    
+    primask = hal_crit_enter();
+    if (__HAL_TIM_GET_FLAG(&htim2, TIM_FLAG_UPDATE) != RESET) {
+        /* Wrapped already: the tick is due now, which is the phase wanted */
+        hal_crit_exit(primask);
+        return true;
+    }
+    
+    /* Counts left on the one-shot, from now */
+    cnt = __HAL_TIM_GET_COUNTER(&htim2);
+    scheduled = tim2_schedule_waiting || (htim2.Instance->DIER & TIM_IT_CC1) != 0U;
+    if (tim2_schedule_waiting) {
+        remaining = tim2_schedule_periods * period + tim2_schedule_ccr - cnt;
+    } else if (scheduled && __HAL_TIM_GET_COMPARE(&htim2, TIM_CHANNEL_1) > cnt) {
+        remaining = __HAL_TIM_GET_COMPARE(&htim2, TIM_CHANNEL_1) - cnt;
+    }
+    
+    /* The counts of the cut period go to the timestamp base */
+    htim2.Instance->CNT = 0;
+    tim2_elapsed_counts += cnt;
+    
+    if (scheduled && __HAL_TIM_GET_FLAG(&htim2, TIM_FLAG_CC1) == RESET) {
+        tim2_schedule_periods = remaining / period;
+        tim2_schedule_ccr = remaining % period;
+        tim2_schedule_waiting = tim2_schedule_periods != 0U;
+        if (!tim2_schedule_waiting) {
+            hal_tim2_arm_compare(tim2_schedule_ccr, 0U);
+        }
+    }
+    hal_crit_exit(primask);
+    return true;
+}
+
+bool hal_tim2_trim_period(int32_t counts)
+{
+    uint32_t period = htim2.Init.Period + 1U;
+    int32_t trimmed = (int32_t)period + counts;
+    uint32_t primask;
+    bool ok = false;
+    
+    if (!hal_tim2_is_running() || 2 * trimmed <= (int32_t)period || 2 * trimmed >= 3 * (int32_t)period ||
+        trimmed > 0x10000L) {
+        return false;
+    }
+    
+    /* Same preload as a rate change, undone by the update that applies it.
+     * Not with the update pending: the preload would land one period late */
+    primask = hal_crit_enter();
+    if (tim2_pending_period == 0U && __HAL_TIM_GET_FLAG(&htim2, TIM_FLAG_UPDATE) == RESET) {
+        htim2.Instance->ARR = (uint32_t)trimmed - 1U;
+        tim2_pending_period = (uint32_t)trimmed;
+        tim2_restore_period = period;
+        ok = true;
+    }
+    hal_crit_exit(primask);
+    return ok;
+}
+
+uint32_t hal_tim2_get_idle_us(void)
+{
+    uint32_t primask;
+    uint32_t cnt;
+    uint32_t idle;
+    
+    if (!hal_tim2_is_running()) {
+        return UINT32_MAX;
+    }
+    
+    primask = hal_crit_enter();
+    cnt = __HAL_TIM_GET_COUNTER(&htim2);
+    if (__HAL_TIM_GET_FLAG(&htim2, TIM_FLAG_UPDATE) != RESET ||
+        ((htim2.Instance->DIER & TIM_IT_CC1) != 0U && __HAL_TIM_GET_FLAG(&htim2, TIM_FLAG_CC1) != RESET)) {
+        idle = 0;  /* Due already */
+    } else {
+        idle = htim2.Init.Period + 1U - cnt;
+        
+        /* A one-shot waiting for a later period comes after the tick */
+        if ((htim2.Instance->DIER & TIM_IT_CC1) != 0U &&
+            __HAL_TIM_GET_COMPARE(&htim2, TIM_CHANNEL_1) > cnt &&
+            __HAL_TIM_GET_COMPARE(&htim2, TIM_CHANNEL_1) - cnt < idle) {
+            idle = __HAL_TIM_GET_COMPARE(&htim2, TIM_CHANNEL_1) - cnt;
+        }
+    }
+    hal_crit_exit(primask);
+    
+    return idle / (BOARD_TIM2_COUNTER_HZ / 1000000UL);
+}
+
+#if BOARD_CLOCK_SCALE_ENABLE
+/* ============================================================================
+ * Clock Scaling (HCLK Divider, TIM2/TIM21 and I2C Timings)
+ * ============================================================================ */
+
+/**
+ * @brief Load the TIMINGR of an idle sensor bus (PE off while it changes)
+ * 
+ * The bus clock may be gated between transfers: on for the writes, then
+ * left as it was.
+ */
+static void hal_i2c_retime(I2C_HandleTypeDef *hi2c, uint32_t enable_bit, uint32_t timing)
+{
+    bool gated = (RCC->APB1ENR & enable_bit) == 0U;
+    
+    hal_i2c_bus_clock(hi2c, true);
+    CLEAR_BIT(hi2c->Instance->CR1, I2C_CR1_PE);
+    hi2c->Instance->TIMINGR = timing;
+    SET_BIT(hi2c->Instance->CR1, I2C_CR1_PE);
+    hi2c->Init.Timing = timing;
+    if (gated) {
+        hal_i2c_bus_clock(hi2c, false);
+    }
+}
+
+/**
+ * @brief Whether an I2C master is out of transfers and the bus free
+ */
+static bool hal_i2c_quiet(I2C_HandleTypeDef *hi2c, uint32_t enable_bit)
+{
+    if (HAL_I2C_GetState(hi2c) != HAL_I2C_STATE_READY) {
+        return false;
+    }
+    /* Gated: no flag to read, and no transfer either */
+    return (RCC->APB1ENR & enable_bit) == 0U || !__HAL_I2C_GET_FLAG(hi2c, I2C_FLAG_BUSY);
+}
+
+bool hal_clock_scale_set(bool low)
+{
+    uint32_t hclk = low ? BOARD_SYSCLK_FREQ_HZ / BOARD_CLOCK_SCALE_DIV : BOARD_SYSCLK_FREQ_HZ;
+    uint32_t hpre = low ? HAL_CLOCK_SCALE_HPRE : RCC_SYSCLK_DIV1;
+    uint32_t tim2_psc = hclk / BOARD_TIM2_COUNTER_HZ - 1U;
+    uint32_t tim21_psc = hclk / 1000000UL - 1U;
+    uint32_t i2c2_timing = hal_i2c_timing(i2c2_speed, hclk);
+#if BOARD_I2C3_MUX_CHANNELS != 0
+    uint32_t i2c3_timing = hal_i2c_timing(i2c3_speed, hclk);
+#endif
+    TIM_TypeDef *tim2 = htim2.Instance;
+    uint32_t primask;
+    uint32_t cnt2;
+    uint32_t cnt21;
+    
+    if (board_get_sysclk_freq() == hclk) {
+        return true;
+    }
+    
+    /* TIMINGR changes with the buses idle, and only to a timing they can
+     * run at */
+    if (i2c2_timing == 0U || !hal_i2c_quiet(&hi2c2, RCC_APB1ENR_I2C2EN)) {
+        return false;
+    }
+#if BOARD_I2C3_MUX_CHANNELS != 0
+    if (i2c3_timing == 0U || !hal_i2c_quiet(&hi2c3, RCC_APB1ENR_I2C3EN)) {
+        return false;
+    }
+#endif
+    
+    primask = hal_crit_enter();
+    
+    /* The reload below also loads ARR and meets a compare at 0: not with a
+     * rate change or trim preloaded, nor a one-shot due at the start of a
+     * period. TIM6 is prescaled at init only: no switch while it runs */
+    if (tim2_pending_period != 0U ||
+        ((tim2->DIER & TIM_IT_CC1) != 0U && tim2->CCR1 == 0U) ||
+        ((TIM21->DIER & TIM_DIER_CC1IE) != 0U && TIM21->CCR1 == 0U)
+#if BOARD_DAC_STREAM_ENABLE
+        || (htim6.Instance->CR1 & TIM_CR1_CEN) != 0U
+#endif
+        ) {
+        hal_crit_exit(primask);
+        return false;
+    }
+    
+    /* Just after a TIM2 count: the prescaler restarts a few cycles into
+     * the count instead of anywhere in it. Update events from the reloads
+     * are kept out of the wrap counts (URS) */
+    tim2->CR1 |= TIM_CR1_URS;
+    TIM21->CR1 |= TIM_CR1_URS;
+    tim2->PSC = tim2_psc;
+    TIM21->PSC = tim21_psc;
+    cnt2 = tim2->CNT;
+    while ((tim2->CR1 & TIM_CR1_CEN) != 0U && tim2->CNT == cnt2) {
+        /* Wait for the count edge */
+    }
+    
+    /* Back to back: the clock between the two writes is the only one the
+     * counters see with the old prescalers */
+    cnt2 = tim2->CNT;
+    cnt21 = TIM21->CNT;
+    MODIFY_REG(RCC->CFGR, RCC_CFGR_HPRE, hpre);
+    tim2->EGR = TIM_EGR_UG;
+    TIM21->EGR = TIM_EGR_UG;
+    tim2->CNT = cnt2;
+    TIM21->CNT = cnt21;
+    tim2->CR1 &= ~TIM_CR1_URS;
+    TIM21->CR1 &= ~TIM_CR1_URS;
+    htim2.Init.Prescaler = tim2_psc;
+    board_clock_set_hclk(hclk);
+    
+    hal_i2c_retime(&hi2c2, RCC_APB1ENR_I2C2EN, i2c2_timing);
+#if BOARD_I2C3_MUX_CHANNELS != 0
+    hal_i2c_retime(&hi2c3, RCC_APB1ENR_I2C3EN, i2c3_timing);
+#endif
+    hal_crit_exit(primask);
+    
+    return true;
+}
+#endif /* BOARD_CLOCK_SCALE_ENABLE */
+
+#else /* BOARD_TIMEBASE == BOARD_TIMEBASE_LPTIM1 */
+
+/* ============================================================================
+ * LPTIM1 Configuration (STOP-capable Sampling Timer + Conversion Scheduler)
+ * ============================================================================ */
+/*
+    Kernel clock: LSI (26-56 kHz over parts and temperature), measured
+    against HSI at init; counts are converted to microseconds with it
+    ARR match: tick at the sampling rate (BOARD_LPTIM1_FREQ_HZ at start)
+    CMP match: one-shot conversion scheduler, see hal_tim2_schedule_us()
+    Both keep counting in STOP and wake the core through EXTI line 29.
+    IER may only be written while LPTIM1 is disabled, so both interrupts stay
+    enabled and hal_lptim1_irq_handler() drops compare matches nobody armed.
+    ARR and CMP writes take a few kernel clocks to land (ARROK/CMPOK).
+*/
+
+/* Ticks ahead a compare is armed at least: the CMP write must land before
+ * the counter gets there */
+#define HAL_LPTIM1_MIN_LEAD  4U
+
+static LPTIM_HandleTypeDef hlptim1;
+
+/* Measured kernel clock and microseconds per count (Q8) */
+static uint32_t lptim1_clock_hz = 0;
+static uint32_t lptim1_us_q8 = 0;
+
+/* Counts per tick (ARR + 1), and the new one applied at the next tick (0 = none) */
+static volatile uint32_t lptim1_period = 0;
+static volatile uint32_t lptim1_pending_period = 0;
+static volatile bool lptim1_running = false;
+
+/* One-shot CMP schedule: whole periods still to elapse, then compare value */
+static volatile uint32_t lptim1_schedule_periods = 0;
+static volatile uint32_t lptim1_schedule_cmp = 0;
+static volatile bool lptim1_schedule_waiting = false;
+static volatile bool lptim1_schedule_armed = false;
+
+/* Microseconds over completed periods (timestamp base), and the Q8 remainder */
+static volatile uint32_t lptim1_elapsed_us = 0;
+static uint32_t lptim1_elapsed_frac = 0;
+
+/* A CMP / ARR write may still be landing */
+static bool lptim1_cmp_written = false;
+static bool lptim1_arr_written = false;
+
+/**
+ * @brief Read the counter (kernel clock asynchronous to APB: read until stable)
+ */
+static uint32_t hal_lptim1_read_counter(void)
+{
+    uint32_t first;
+    uint32_t second = hlptim1.Instance->CNT;
+    
+    do {
+        first = second;
+        second = hlptim1.Instance->CNT;
+    } while (first != second);
+    
+    return second;
+}
+
+/**
+ * @brief Write CMP once the previous write has landed
+ */
+static void hal_lptim1_write_compare(uint32_t cmp)
+{
+    if (lptim1_cmp_written) {
+        while (!__HAL_LPTIM_GET_FLAG(&hlptim1, LPTIM_FLAG_CMPOK)) {
+            /* A few kernel clocks at most */
+        }
+    }
+    __HAL_LPTIM_CLEAR_FLAG(&hlptim1, LPTIM_FLAG_CMPOK);
+    __HAL_LPTIM_COMPARE_SET(&hlptim1, cmp);
+    lptim1_cmp_written = true;
+}
+
+/**
+ * @brief Write ARR once the previous write has landed
+ */
+static void hal_lptim1_write_autoreload(uint32_t arr)
+{
+    if (lptim1_arr_written) {
+        while (!__HAL_LPTIM_GET_FLAG(&hlptim1, LPTIM_FLAG_ARROK)) {
+            /* A few kernel clocks at most */
+        }
+    }
+    __HAL_LPTIM_CLEAR_FLAG(&hlptim1, LPTIM_FLAG_ARROK);
+    __HAL_LPTIM_AUTORELOAD_SET(&hlptim1, arr);
+    lptim1_arr_written = true;
+}
+
+/**
+ * @brief Enable LPTIM1 (counter from 0) with the given period
+ */
+static void hal_lptim1_enable(uint32_t period)
+{
+    __HAL_LPTIM_ENABLE(&hlptim1);
+    __HAL_LPTIM_CLEAR_FLAG(&hlptim1, LPTIM_FLAG_ARRM | LPTIM_FLAG_CMPM);
+    lptim1_cmp_written = false;
+    lptim1_arr_written = false;
+    hal_lptim1_write_autoreload(period - 1U);
+    hal_lptim1_write_compare(0);
+    __HAL_LPTIM_START_CONTINUOUS(&hlptim1);
+}
+
+/**
+ * @brief Counts covering a delay, rounded up (32-bit safe up to ~70 s)
+ */
+static uint32_t hal_lptim1_counts(uint32_t delay_us)
+{
+    uint32_t ms = delay_us / 1000U;
+    uint32_t us = delay_us % 1000U;
+    
+    return (ms * lptim1_clock_hz + 999U) / 1000U +
+           (us * lptim1_clock_hz + 999999UL) / 1000000UL;
+}
+
+/**
+ * @brief Counts per tick at a rate, 0 if out of range
+ */
+static uint32_t hal_lptim1_period(uint32_t rate_hz)
+{
+    uint32_t period;
+    
+    /* Tick-based conversion delays are sized for BOARD_TIM2_FREQ_HZ: only
+     * slower ticks keep them valid. LPTIM1 is a 16-bit counter */
+    if (rate_hz == 0U || rate_hz > BOARD_TIM2_FREQ_HZ) {
+        return 0;
+    }
+    
+    period = (lptim1_clock_hz + rate_hz / 2U) / rate_hz;
+    if (period < 4U * HAL_LPTIM1_MIN_LEAD || period > 0x10000UL) {
+        return 0;
+    }
+    
+    return period;
+}
+
+/**
+ * @brief Arm the CMP match at the given counter value
+ */
+static void hal_lptim1_arm_compare(uint32_t cmp)
+{
+    hal_lptim1_write_compare(cmp);
+    lptim1_schedule_armed = true;
+}
+
+bool hal_tim2_init(void)
+{
+    RCC_OscInitTypeDef osc_config = {0};
+    RCC_PeriphCLKInitTypeDef clk_config = {0};
+    uint32_t start;
+    uint32_t counts;
+    
+    /* LSI keeps running in STOP */
+    osc_config.OscillatorType = RCC_OSCILLATORTYPE_LSI;
+    osc_config.LSIState = RCC_LSI_ON;
+    osc_config.PLL.PLLState = RCC_PLL_NONE;
+    if (HAL_RCC_OscConfig(&osc_config) != HAL_OK) {
+        return false;
+    }
+    
+    clk_config.PeriphClockSelection = RCC_PERIPHCLK_LPTIM1;
+    clk_config.LptimClockSelection = RCC_LPTIM1CLKSOURCE_LSI;
+    if (HAL_RCCEx_PeriphCLKConfig(&clk_config) != HAL_OK) {
+        return false;
+    }
+    __HAL_RCC_LPTIM1_CLK_ENABLE();
+    
+    hlptim1.Instance = LPTIM1;
+    hlptim1.Init.Clock.Source = LPTIM_CLOCKSOURCE_APBCLOCK_LPOSC;
+    hlptim1.Init.Clock.Prescaler = LPTIM_PRESCALER_DIV1;
+    hlptim1.Init.Trigger.Source = LPTIM_TRIGSOURCE_SOFTWARE;
+    hlptim1.Init.OutputPolarity = LPTIM_OUTPUTPOLARITY_HIGH;
+    hlptim1.Init.UpdateMode = LPTIM_UPDATE_IMMEDIATE;
+    hlptim1.Init.CounterSource = LPTIM_COUNTERSOURCE_INTERNAL;
+    if (HAL_LPTIM_Init(&hlptim1) != HAL_OK) {
+        return false;
+    }
+    
+    /* Tick and compare interrupts: set while disabled, kept for good */
+    __HAL_LPTIM_ENABLE_IT(&hlptim1, LPTIM_IT_ARRM | LPTIM_IT_CMPM);
+    
+    /* Measure LSI against the HSI-clocked delay timer, free-running over
+     * the whole 16-bit range meanwhile */
+    hal_lptim1_enable(0x10000UL);
+    start = hal_lptim1_read_counter();
+    board_delay_us(BOARD_LPTIM1_LSI_CAL_MS * 1000U);
+    counts = (hal_lptim1_read_counter() - start) & 0xFFFFU;
+    __HAL_LPTIM_DISABLE(&hlptim1);
+    
+    lptim1_clock_hz = counts * 1000U / BOARD_LPTIM1_LSI_CAL_MS;
+    if (lptim1_clock_hz < BOARD_LSI_MIN_HZ || lptim1_clock_hz > BOARD_LSI_MAX_HZ) {
+        return false;
+    }
+    lptim1_us_q8 = ((1000000UL << 8) + lptim1_clock_hz / 2U) / lptim1_clock_hz;
+    
+    lptim1_period = hal_lptim1_period(BOARD_LPTIM1_FREQ_HZ);
+    if (lptim1_period == 0U) {
+        return false;
+    }
+    
+    /* Wakes the core from STOP on either match */
+    __HAL_LPTIM_WAKEUPTIMER_EXTI_ENABLE_IT();
+    HAL_NVIC_ClearPendingIRQ(LPTIM1_IRQn);  /* Matches of the measurement */
+    HAL_NVIC_SetPriority(LPTIM1_IRQn, BOARD_IRQ_PRIO_TIMEBASE, 0);
+    HAL_NVIC_EnableIRQ(LPTIM1_IRQn);
+    
+    return true;
+}
+
+bool hal_tim2_start(void)
+{
+    if (lptim1_period == 0U || lptim1_running) {
+        return false;
+    }
+    
+    hal_lptim1_enable(lptim1_period);
+    lptim1_running = true;
+    return true;
+}
+
+bool hal_tim2_stop(void)
+{
+    uint32_t cnt;
+    
+    hal_tim2_schedule_cancel();
+    if (!lptim1_running) {
+        return true;
+    }
+    
+    /* Disabling clears the counter: keep the timestamp where it stopped */
+    cnt = hal_lptim1_read_counter();
+    __HAL_LPTIM_DISABLE(&hlptim1);
+    lptim1_running = false;
+    lptim1_elapsed_us += (cnt * lptim1_us_q8) >> 8;
+    
+    return true;
+}
+
+bool hal_tim2_is_running(void)
+{
+    return lptim1_running;
+}
+
+bool hal_tim2_tick_pending(void)
+{
+    return (hlptim1.Instance->ISR & LPTIM_FLAG_ARRM) != 0U;
+}
+
+bool hal_tim2_schedule_us(uint32_t delay_us)
+{
+    uint32_t period = lptim1_period;
+    uint32_t counts = hal_lptim1_counts(delay_us);
+    uint32_t target;
+    
+    if (lptim1_schedule_waiting || lptim1_schedule_armed) {
+        return false;  /* One-shot already armed */
+    }
+    
+    if (counts < HAL_LPTIM1_MIN_LEAD) {
+        counts = HAL_LPTIM1_MIN_LEAD;
+    }
+    target = hal_lptim1_read_counter() + counts;
+    
+    lptim1_schedule_periods = target / period;
+    lptim1_schedule_cmp = target % period;
+    if (lptim1_schedule_cmp > period - 2U) {
+        /* CMP must stay below ARR: first counts of the next period instead */
+        lptim1_schedule_periods++;
+        lptim1_schedule_cmp = 0;
+    }
+    if (lptim1_schedule_periods != 0U && lptim1_schedule_cmp < HAL_LPTIM1_MIN_LEAD) {
+        /* Armed from the tick: leave the write time to land */
+        lptim1_schedule_cmp = HAL_LPTIM1_MIN_LEAD;
+    }
+    
+    if (lptim1_schedule_periods == 0U) {
+        hal_lptim1_arm_compare(lptim1_schedule_cmp);
+    } else {
+        /* Longer than the remaining period: armed from hal_tim2_schedule_update() */
+        lptim1_schedule_waiting = true;
+    }
+    
+    return true;
+}
+
+void hal_tim2_schedule_cancel(void)
+{
+    lptim1_schedule_waiting = false;
+    lptim1_schedule_armed = false;
+}
+
+void hal_tim2_schedule_update(void)
+{
+    /* The timestamp base was advanced by hal_lptim1_irq_handler() */
+    
+    /* Rate change: the counter is at the top or has just wrapped, and the
+     * new ARR lands a few counts later, above the counter either way */
+    if (lptim1_pending_period != 0U) {
+        lptim1_period = lptim1_pending_period;
+        hal_lptim1_write_autoreload(lptim1_period - 1U);
+        lptim1_pending_period = 0;
+    }
+    
+    if (!lptim1_schedule_waiting) {
+        return;
+    }
+    
+    if (--lptim1_schedule_periods == 0U) {
+        lptim1_schedule_waiting = false;
+        /* Computed for the old period if the rate changed meanwhile */
+        if (lptim1_schedule_cmp > lptim1_period - 2U) {
+            lptim1_schedule_cmp = lptim1_period - 2U;
+        }
+        hal_lptim1_arm_compare(lptim1_schedule_cmp);
+    }
+}
+
+bool hal_tim2_set_rate_hz(uint32_t rate_hz)
+{
+    uint32_t period = hal_lptim1_period(rate_hz);
+    
+    if (period == 0U) {
+        return false;
+    }
+    
+    lptim1_pending_period = period;
+    return true;
+}
+
+uint32_t hal_tim2_get_rate_hz(void)
+{
+    uint32_t period = (lptim1_pending_period != 0U) ? lptim1_pending_period : lptim1_period;
+    
+    return (period != 0U) ? (lptim1_clock_hz + period / 2U) / period : 0U;
+}
+
+uint32_t hal_tim2_get_timestamp_us(void)
+{
+    uint32_t base;
+    uint32_t cnt;
+    
+    do {
+        base = lptim1_elapsed_us;
+        cnt = lptim1_running ? hal_lptim1_read_counter() : 0U;
+        
+        if (__HAL_LPTIM_GET_FLAG(&hlptim1, LPTIM_FLAG_ARRM)) {
+            /* Tick not counted yet (caller is at the same or higher
+             * priority): past the top means the counter wrapped */
+            if (cnt < lptim1_period - 1U) {
+                cnt += lptim1_period;
+            }
+        } else if (cnt == lptim1_period - 1U && lptim1_running) {
+            /* ARR match is flagged as the counter reaches the top, so the
+             * tick was just counted: the wrap is one count away */
+            cnt = 0;
+        }
+    } while (base != lptim1_elapsed_us);  /* Tick counted meanwhile: retry */
+    
+    return base + ((cnt * lptim1_us_q8) >> 8);
+}
+
+uint32_t hal_tim2_get_next_tick_us(void)
+{
+    uint32_t base;
+    uint32_t periods;
+    
+    do {
+        base = lptim1_elapsed_us;
+        periods = __HAL_LPTIM_GET_FLAG(&hlptim1, LPTIM_FLAG_ARRM) ? 2U : 1U;
+    } while (base != lptim1_elapsed_us);
+    
+    return base + ((periods * lptim1_period * lptim1_us_q8 + lptim1_elapsed_frac) >> 8);
+}
+
+bool hal_tim2_advance_us(uint32_t us)
+{
+    if (lptim1_running) {
+        return false;
+    }
+    
+    lptim1_elapsed_us += us;
+    return true;
+}
+
+bool hal_tim2_restart_period(void)
+{
+    /* LPTIM1 CNT is read-only: the phase can only be set by a restart */
+    return false;
+}
+
+bool hal_tim2_trim_period(int32_t counts)
+{
+    /* An ARR write lands a few counts after the match (see
+     * hal_tim2_schedule_update()): no single period can be trimmed */
+    (void)counts;
+    return false;
+}
+
+bool hal_lptim1_wake_within_us(uint32_t us)
+{
+    uint32_t counts = hal_lptim1_counts(us);
+    uint32_t cnt;
+    
+    if (!lptim1_running) {
+        return false;
+    }
+    
+    cnt = hal_lptim1_read_counter();
+    if ((hlptim1.Instance->ISR & (LPTIM_FLAG_ARRM | LPTIM_FLAG_CMPM)) != 0U ||
+        lptim1_period - 1U - cnt <= counts) {
+        return true;  /* Pending match, or the tick comes first */
+    }
+    if (lptim1_schedule_armed) {
+        return hlptim1.Instance->CMP > cnt && hlptim1.Instance->CMP - cnt <= counts;
+    }
+    
+    /* Free compare: a bare match (dropped by the handler) within the period */
+    if (counts < HAL_LPTIM1_MIN_LEAD) {
+        counts = HAL_LPTIM1_MIN_LEAD;
+    }
+    if (cnt + counts > lptim1_period - 2U) {
+        return true;  /* Tick within the lead anyway */
+    }
+    hal_lptim1_write_compare(cnt + counts);
+    return true;
+}
+
+void hal_lptim1_irq_handler(void)
+{
+    uint32_t isr = hlptim1.Instance->ISR;
+    
+    if ((isr & LPTIM_FLAG_ARRM) != 0U) {
+        uint32_t primask;
+        uint32_t us_q8;
+        
+        /* Count the period and clear its flag as one step for timestamp
+         * readers preempting this handler */
+        primask = hal_crit_enter();
+        us_q8 = lptim1_period * lptim1_us_q8 + lptim1_elapsed_frac;
+        lptim1_elapsed_us += us_q8 >> 8;
+        lptim1_elapsed_frac = us_q8 & 0xFFU;
+        __HAL_LPTIM_CLEAR_FLAG(&hlptim1, LPTIM_FLAG_ARRM);
+        hal_crit_exit(primask);
+        
+        HAL_LPTIM_AutoReloadMatchCallback(&hlptim1);
+    }
+    
+    if ((isr & LPTIM_FLAG_CMPM) != 0U) {
+        __HAL_LPTIM_CLEAR_FLAG(&hlptim1, LPTIM_FLAG_CMPM);
+        if (lptim1_schedule_armed) {
+            lptim1_schedule_armed = false;
+            HAL_LPTIM_CompareMatchCallback(&hlptim1);
+        }
+    }
+}
+#endif /* BOARD_TIMEBASE */
+
+/* ============================================================================
+ * I2C1 Slave DMA
+ * ============================================================================ */
+
+#if BOARD_I2C1_SLAVE_DMA
+/**
+ * @brief Configure one I2C1 DMA channel (byte wide, memory increment)
+ */
+static bool hal_i2c1_dma_channel_init(DMA_HandleTypeDef *hdma, DMA_Channel_TypeDef *channel,
+                                      uint32_t direction)
+{
+    hdma->Instance = channel;
+    hdma->Init.Request = BOARD_I2C1_DMA_REQUEST;
+    hdma->Init.Direction = direction;
+    hdma->Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma->Init.MemInc = DMA_MINC_ENABLE;
+    hdma->Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma->Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma->Init.Mode = DMA_NORMAL;
+    hdma->Init.Priority = DMA_PRIORITY_HIGH;
+    
+    return HAL_DMA_Init(hdma) == HAL_OK;
+}
+
+void hal_i2c1_dma_irq_handler(void)
+{
+    HAL_DMA_IRQHandler(&hdma_i2c1_tx);
+    HAL_DMA_IRQHandler(&hdma_i2c1_rx);
+}
+#endif
+
+/* ============================================================================
+ * PendSV (Bottom Half)
+ * ============================================================================ */
+
+void hal_pendsv_init(void)
+{
+    /* Lowest level: below every top half */
+    HAL_NVIC_SetPriority(PendSV_IRQn, BOARD_IRQ_PRIO_BOTTOM, 0);
+}
+
+void hal_pendsv_trigger(void)
+{
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+}
+
+uint32_t hal_irq_mask(uint32_t lines)
+{
+    uint32_t saved = NVIC->ISER[0] & lines;
+    
+    NVIC->ICER[0] = lines;
+    /* The write must reach the NVIC before the protected accesses */
+    __DSB();
+    __ISB();
+    
+    return saved;
+}
+
+void hal_irq_unmask(uint32_t saved)
+{
+    NVIC->ISER[0] = saved;
+}
+
+/* ============================================================================
+ * Vector Table in RAM
+ * ============================================================================ */
+
+#if BOARD_RAM_VECTORS_ENABLE
+/* VTOR takes the table at a multiple of its size rounded up to a power of
+ * two: 48 words, 256 bytes. NOLOAD (linker.ld): filled here, not at reset */
+static hal_isr_t ram_vectors[HAL_VECTOR_COUNT]
+    __attribute__((section(".ram_vector"), aligned(256)));
+
+extern const hal_isr_t g_pfnVectors[HAL_VECTOR_COUNT];
+
+void hal_vectors_init(void)
+{
+    for (uint32_t i = 0; i < HAL_VECTOR_COUNT; i++) {
+        ram_vectors[i] = g_pfnVectors[i];
+    }
+    /* Table written before the core fetches from it */
+    __DSB();
+    SCB->VTOR = (uint32_t)(uintptr_t)ram_vectors;
+    __DSB();
+    __ISB();
+}
+
+void hal_vectors_set(IRQn_Type irq, hal_isr_t handler)
+{
+    /* One word store: the line sees the old handler or the new one */
+    ram_vectors[HAL_VECTOR_IRQ0 + (uint32_t)irq] = handler;
+    __DSB();
+}
+#else
+void hal_vectors_init(void)
+{
+}
+
+void hal_vectors_set(IRQn_Type irq, hal_isr_t handler)
+{
+    (void)irq;
+    (void)handler;
+}
+#endif
+
+/* ============================================================================
+ * DAC1 Configuration
+ * ============================================================================ */
+
+/* Trigger of software writes: converted at once, or latched on the tick */
+#if BOARD_DAC_LATCH_ENABLE
+#define HAL_DAC1_WRITE_TRIGGER  DAC_TRIGGER_T2_TRGO
+#else
+#define HAL_DAC1_WRITE_TRIGGER  DAC_TRIGGER_NONE
+#endif
+
+/**
+ * @brief Configure both DAC channels with one trigger source
+ */
+static bool hal_dac1_config_channels(uint32_t trigger)
+{
+    DAC_ChannelConfTypeDef sConfig = {0};
+    
+    sConfig.DAC_Trigger = trigger;
+    sConfig.DAC_OutputBuffer = DAC_OUTPUTBUFFER_ENABLE;
+    if (HAL_DAC_ConfigChannel(&hdac1, &sConfig, BOARD_DAC1_OUT1_CHANNEL) != HAL_OK) {
+        return false;
+    }
+    
+    return HAL_DAC_ConfigChannel(&hdac1, &sConfig, BOARD_DAC1_OUT2_CHANNEL) == HAL_OK;
+}
+
+#if BOARD_DAC_STREAM_ENABLE
+/**
+ * @brief TIM6 (TRGO on update) and the DMA channel feeding DHR12RD
+ */
+static bool hal_dac1_stream_init(void)
+{
+    TIM_MasterConfigTypeDef master_config = {0};
+    
+    htim6.Instance = BOARD_DAC_STREAM_TIM_PERIPH;
+    htim6.Init.Prescaler = (board_get_apb1_freq() / BOARD_DAC_STREAM_COUNTER_HZ) - 1;
+    htim6.Init.CounterMode = TIM_COUNTERMODE_UP;
+    htim6.Init.Period = 0xFFFF;  /* Set by hal_dac1_stream_timer_start() */
+    htim6.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+    if (HAL_TIM_Base_Init(&htim6) != HAL_OK) {
+        return false;
+    }
+    
+    master_config.MasterOutputTrigger = TIM_TRGO_UPDATE;
+    master_config.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+    if (HAL_TIMEx_MasterConfigSynchronization(&htim6, &master_config) != HAL_OK) {
+        return false;
+    }
+    
+    /* One word per sample into DHR12RD, wrapping over both half buffers */
+    __HAL_RCC_DMA1_CLK_ENABLE();
+    hdma_dac1.Instance = BOARD_DAC_STREAM_DMA_CHANNEL;
+    hdma_dac1.Init.Request = BOARD_DAC_STREAM_DMA_REQUEST;
+    hdma_dac1.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma_dac1.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_dac1.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_dac1.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+    hdma_dac1.Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+    hdma_dac1.Init.Mode = DMA_CIRCULAR;
+    hdma_dac1.Init.Priority = DMA_PRIORITY_MEDIUM;
+    if (HAL_DMA_Init(&hdma_dac1) != HAL_OK) {
+        return false;
+    }
+    __HAL_LINKDMA(&hdac1, DMA_Handle2, hdma_dac1);
+    
+    /* Below I2C1: a refill has half a buffer of samples to complete */
+    HAL_NVIC_SetPriority(BOARD_DAC_STREAM_DMA_IRQn, BOARD_IRQ_PRIO_DAC_DMA, 0);
+    HAL_NVIC_EnableIRQ(BOARD_DAC_STREAM_DMA_IRQn);
+    
+    return true;
+}
+#endif
+
+bool hal_dac1_init(void)
+{
+    hdac1.Instance = BOARD_DAC_PERIPH;
+    if (HAL_DAC_Init(&hdac1) != HAL_OK) {
+        return false;
+    }
+    
+    /* Software writes take effect at once (or at the next tick with the
+     * latch); streaming switches to TIM6 */
+    if (!hal_dac1_config_channels(HAL_DAC1_WRITE_TRIGGER)) {
+        return false;
+    }
+    
+#if BOARD_DAC_STREAM_ENABLE
+    if (!hal_dac1_stream_init()) {
+        return false;
+    }
+#endif
+    
+    return true;
+}
+
+bool hal_dac1_set_trigger(bool timed)
+{
+    /* TSEL/TEN are only changed with the channels disabled */
+    if (HAL_DAC_Stop(&hdac1, BOARD_DAC1_OUT1_CHANNEL) != HAL_OK ||
+        HAL_DAC_Stop(&hdac1, BOARD_DAC1_OUT2_CHANNEL) != HAL_OK) {
+        return false;
+    }
+    
+    if (!hal_dac1_config_channels(timed ? DAC_TRIGGER_T6_TRGO : HAL_DAC1_WRITE_TRIGGER)) {
+        return false;
+    }
+    
+    return HAL_DAC_Start(&hdac1, BOARD_DAC1_OUT1_CHANNEL) == HAL_OK &&
+           HAL_DAC_Start(&hdac1, BOARD_DAC1_OUT2_CHANNEL) == HAL_OK;
+}
+
+#if BOARD_DAC_STREAM_ENABLE
+bool hal_dac1_stream_timer_start(uint32_t rate_hz)
+{
+    uint32_t period;
+    
+    if (rate_hz == 0U || rate_hz > BOARD_DAC_STREAM_MAX_HZ) {
+        return false;
+    }
+    
+    period = BOARD_DAC_STREAM_COUNTER_HZ / rate_hz;
+    if (period > 0x10000UL) {
+        return false;
+    }
+    
+    __HAL_TIM_SET_AUTORELOAD(&htim6, period - 1U);
+    __HAL_TIM_SET_COUNTER(&htim6, 0);
+    return HAL_TIM_Base_Start(&htim6) == HAL_OK;
+}
+
+void hal_dac1_stream_timer_stop(void)
+{
+    HAL_TIM_Base_Stop(&htim6);
+}
+
+void hal_dac1_dma_irq_handler(void)
+{
+    HAL_DMA_IRQHandler(&hdma_dac1);
+}
+#endif
+
+/* ============================================================================
+ * ADC1 Background Scan (DAC Readback, VDDA, Temperature, Supply)
+ * ============================================================================ */
+
+#if BOARD_ADC_SCAN_PERIOD_MS != 0
+bool hal_adc_scan_init(void)
+{
+    static const uint32_t channels[HAL_ADC_SCAN_COUNT] = {
+        BOARD_DAC1_OUT1_ADC_CHANNEL, BOARD_DAC1_OUT2_ADC_CHANNEL, ADC_CHANNEL_VREFINT,
+        ADC_CHANNEL_TEMPSENSOR,
+#if BOARD_ADC_SUPPLY_ENABLE
+        BOARD_ADC_SUPPLY_CHANNEL,
+#endif
+    };
+    ADC_ChannelConfTypeDef sConfig = {0};
+    uint32_t selected = 0;
+    
+    /* 8 MHz in either clock profile (PCLK/2 or PCLK/4); 160.5 cycles = 20 us
+     * per conversion, above the VREFINT and sensor minimum sampling times and
+     * light on the DAC output buffers. 16 conversions per channel summed and
+     * shifted back to 12 bits by the oversampler: ~1.5 ms a scan, one DMA
+     * request per channel. Auto-off: powered only while converting */
+    hadc1.Instance = BOARD_ADC_PERIPH;
+    hadc1.Init.ClockPrescaler = (board_get_apb1_freq() > 16000000UL) ? ADC_CLOCK_SYNC_PCLK_DIV4 :
+                                                                      ADC_CLOCK_SYNC_PCLK_DIV2;
+    hadc1.Init.Resolution = ADC_RESOLUTION_12B;
+    hadc1.Init.DataAlign = ADC_DATAALIGN_RIGHT;
+    hadc1.Init.ScanConvMode = ADC_SCAN_DIRECTION_FORWARD;
+    hadc1.Init.EOCSelection = ADC_EOC_SEQ_CONV;
+    hadc1.Init.LowPowerAutoWait = DISABLE;
+    hadc1.Init.LowPowerAutoPowerOff = ENABLE;
+    hadc1.Init.ContinuousConvMode = DISABLE;
+    hadc1.Init.DiscontinuousConvMode = DISABLE;
+#if BOARD_ADC_SCAN_TIM22
+    hadc1.Init.ExternalTrigConv = ADC_EXTERNALTRIGCONV_T22_TRGO;
+    hadc1.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_RISING;
+#else
+    hadc1.Init.ExternalTrigConv = ADC_SOFTWARE_START;
+    hadc1.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_NONE;
+#endif
+    hadc1.Init.DMAContinuousRequests = ENABLE;  /* Circular: armed once, every scan lands */
+    hadc1.Init.Overrun = ADC_OVR_DATA_OVERWRITTEN;
+    hadc1.Init.LowPowerFrequencyMode = DISABLE;
+    hadc1.Init.SamplingTime = ADC_SAMPLETIME_160CYCLES_5;
+    hadc1.Init.OversamplingMode = ENABLE;
+    hadc1.Init.Oversample.Ratio = ADC_OVERSAMPLING_RATIO_16;
+    hadc1.Init.Oversample.RightBitShift = ADC_RIGHTBITSHIFT_4;
+    hadc1.Init.Oversample.TriggeredMode = ADC_TRIGGEREDMODE_SINGLE_TRIGGER;
+    if (HAL_ADC_Init(&hadc1) != HAL_OK) {
+        return false;
+    }
+    
+    if (HAL_ADCEx_Calibration_Start(&hadc1, ADC_SINGLE_ENDED) != HAL_OK) {
+        return false;
+    }
+    
+    sConfig.Rank = ADC_RANK_CHANNEL_NUMBER;
+    for (uint32_t i = 0; i < HAL_ADC_SCAN_COUNT; i++) {
+        sConfig.Channel = channels[i];
+        if (HAL_ADC_ConfigChannel(&hadc1, &sConfig) != HAL_OK) {
+            return false;
+        }
+        selected |= channels[i] & ADC_CHANNEL_MASK;
+    }
+    
+    /* Each result lands after those of the lower channel numbers */
+    for (uint32_t i = 0; i < HAL_ADC_SCAN_COUNT; i++) {
+        uint32_t below = selected & ((channels[i] & ADC_CHANNEL_MASK) - 1U);
+        uint8_t slot = 0;
+        
+        for (; below != 0U; below &= below - 1U) {
+            slot++;
+        }
+        adc_scan_slot[i] = slot;
+    }
+    
+    if (HAL_ADCEx_EnableVREFINT() != HAL_OK || HAL_ADCEx_EnableVREFINTTempSensor() != HAL_OK) {
+        return false;
+    }
+    
+    /* Armed once: a software start runs the first scan now, TIM22 otherwise */
+    if (hadc1.DMA_Handle == NULL ||
+        HAL_ADC_Start_DMA(&hadc1, (uint32_t *)adc_scan_buffer, HAL_ADC_SCAN_COUNT) != HAL_OK) {
+        return false;
+    }
+    /* ADC1 shares its vector with the COMP2 alarm, which has no overrun
+     * handling; the DMA keeps up with a conversion per 20 us anyway */
+    __HAL_ADC_DISABLE_IT(&hadc1, ADC_IT_OVR);
+    
+#if BOARD_ADC_SCAN_TIM22
+    /* TRGO on update, one per BOARD_ADC_SCAN_PERIOD_MS */
+    __HAL_RCC_TIM22_CLK_ENABLE();
+    TIM22->CR1 = 0;
+    TIM22->PSC = (board_get_apb2_freq() / BOARD_ADC_SCAN_TIM22_HZ) - 1U;
+    TIM22->ARR = (BOARD_ADC_SCAN_PERIOD_MS * BOARD_ADC_SCAN_TIM22_HZ / 1000U) - 1U;
+    TIM22->CR2 = TIM_TRGO_UPDATE;
+    TIM22->EGR = TIM_EGR_UG;  /* Load PSC; the update flag is not used */
+    TIM22->CNT = 0;
+    TIM22->CR1 = TIM_CR1_CEN;
+#endif
+    return true;
+}
+
+bool hal_adc_scan_start(void)
+{
+#if BOARD_ADC_SCAN_TIM22
+    return false;
+#else
+    /* ADSTART clears itself at the end of each software-started scan */
+    if ((hadc1.Instance->CR & ADC_CR_ADSTART) != 0U) {
+        return false;
+    }
+    hadc1.Instance->CR |= ADC_CR_ADSTART;
+    return true;
+#endif
+}
+
+bool hal_adc_scan_is_busy(void)
+{
+    /* Part of a scan moved: the rest is still converting */
+    return hdma_adc1.Instance != NULL && hdma_adc1.Instance->CNDTR != HAL_ADC_SCAN_COUNT;
+}
+
+bool hal_adc_scan_read(hal_adc_scan_t *scan)
+{
+    uint16_t raw[HAL_ADC_SCAN_COUNT];
+    uint32_t primask;
+    uint32_t done = adc_scan_done;
+    uint32_t vrefint;
+    int32_t ts_3v0;
+    int32_t ts_span;
+    
+    if (done == adc_scan_taken) {
+        return false;
+    }
+    
+    primask = hal_crit_enter();
+    done = adc_scan_done;
+    for (uint32_t i = 0; i < HAL_ADC_SCAN_COUNT; i++) {
+        raw[i] = adc_scan_result[i];
+    }
+    hal_crit_exit(primask);
+    adc_scan_taken = done;
+    
+    vrefint = raw[HAL_ADC_SCAN_VREFINT];
+    if (vrefint == 0U) {
+        return false;
+    }
+    
+    /* VREFINT_CAL was taken at VDDA = 3.0 V: VDDA = 3000 * CAL / raw */
+    scan->vdda_mv = (VREFINT_CAL_VREF * (uint32_t)(*VREFINT_CAL_ADDR) + vrefint / 2U) / vrefint;
+    scan->dac_out[0] = raw[HAL_ADC_SCAN_OUT1];
+    scan->dac_out[1] = raw[HAL_ADC_SCAN_OUT2];
+    
+    /* TS_CAL1/TS_CAL2 at 30 and 130 degC, VDDA = 3.0 V: rescale the reading
+     * to 3.0 V (in raw * mV) and interpolate, 0.01 degC */
+    ts_3v0 = (int32_t)(raw[HAL_ADC_SCAN_TEMP] * scan->vdda_mv) -
+             (int32_t)(*TEMPSENSOR_CAL1_ADDR) * (int32_t)TEMPSENSOR_CAL_VREFANALOG;
+    ts_span = ((int32_t)(*TEMPSENSOR_CAL2_ADDR) - (int32_t)(*TEMPSENSOR_CAL1_ADDR)) *
+              (int32_t)(TEMPSENSOR_CAL_VREFANALOG / 100U);
+    scan->temp_centi = (ts_span > 0) ?
+        (int32_t)TEMPSENSOR_CAL1_TEMP * 100 +
+            ts_3v0 * (int32_t)(TEMPSENSOR_CAL2_TEMP - TEMPSENSOR_CAL1_TEMP) / ts_span : 0;
+    
+#if BOARD_ADC_SUPPLY_ENABLE
+    scan->supply_mv = raw[HAL_ADC_SCAN_SUPPLY] * scan->vdda_mv / 4095U *
+                      BOARD_ADC_SUPPLY_DIVIDER_X100 / 100U;
+#else
+    scan->supply_mv = 0;
+#endif
+    return true;
+}
+
+/**
+ * @brief Scan moved (DMA transfer complete, circular: every scan)
+ */
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
+{
+    if (hadc->Instance != BOARD_ADC_PERIPH) {
+        return;
+    }
+    
+    /* Lowest priority: a reader masks around its copy */
+    for (uint32_t i = 0; i < HAL_ADC_SCAN_COUNT; i++) {
+        adc_scan_result[i] = adc_scan_buffer[adc_scan_slot[i]];
+    }
+    adc_scan_done++;
+}
+
+void hal_adc_dma_irq_handler(void)
+{
+    HAL_DMA_IRQHandler(&hdma_adc1);
+}
+#endif
+
+/* ============================================================================
+ * COMP2 Analog Watchdog
+ * ============================================================================ */
+
+#if BOARD_COMP_ALARM_ENABLE
+bool hal_comp_alarm_init(void)
+{
+    /* Medium speed (~1 us propagation); output high while the input is
+     * above the threshold, rising edge on EXTI line 22 */
+    hcomp2.Instance = BOARD_COMP_PERIPH;
+    hcomp2.Init.WindowMode = COMP_WINDOWMODE_DISABLE;
+    hcomp2.Init.Mode = COMP_POWERMODE_MEDIUMSPEED;
+    hcomp2.Init.NonInvertingInput = COMP_INPUT_PLUS_IO2;
+    hcomp2.Init.InvertingInput = (BOARD_COMP_ALARM_DAC_OUT == 0) ? COMP_INPUT_MINUS_DAC1_CH1 :
+                                                                  COMP_INPUT_MINUS_DAC1_CH2;
+    hcomp2.Init.OutputPol = COMP_OUTPUTPOL_NONINVERTED;
+    hcomp2.Init.LPTIMConnection = COMP_LPTIMCONNECTION_DISABLED;
+    hcomp2.Init.TriggerMode = COMP_TRIGGERMODE_IT_RISING;
+    if (HAL_COMP_Init(&hcomp2) != HAL_OK) {
+        return false;
+    }
+    
+    /* The output pin follows from here; the interrupt waits for arming */
+    if (HAL_COMP_Start(&hcomp2) != HAL_OK) {
+        return false;
+    }
+    hal_comp_alarm_disarm();
+    
+    /* Above I2C1: the handler only latches the alarm */
+    HAL_NVIC_SetPriority(ADC1_COMP_IRQn, BOARD_IRQ_PRIO_COMP, 0);
+    HAL_NVIC_EnableIRQ(ADC1_COMP_IRQn);
+    
+    return true;
+}
+
+void hal_comp_alarm_arm(void)
+{
+    /* An edge from before arming (or a stale one) does not count */
+    __HAL_COMP_COMP2_EXTI_CLEAR_FLAG();
+    __HAL_COMP_COMP2_EXTI_ENABLE_IT();
+}
+
+void hal_comp_alarm_disarm(void)
+{
+    __HAL_COMP_COMP2_EXTI_DISABLE_IT();
+}
+
+bool hal_comp_alarm_get_output(void)
+{
+    return HAL_COMP_GetOutputLevel(&hcomp2) == COMP_OUTPUT_LEVEL_HIGH;
+}
+
+void hal_comp_alarm_irq_handler(void)
+{
+    HAL_COMP_IRQHandler(&hcomp2);
+}
+#endif
+
+/* ============================================================================
+ * External Sync Input
+ * ============================================================================ */
+
+#if BOARD_SYNC_IN_ENABLE
+#define HAL_SYNC_IN_LINE  (1UL << BOARD_SYNC_IN_PIN)
+
+bool hal_sync_in_init(void)
+{
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+    
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+    GPIO_InitStruct.Pin = HAL_SYNC_IN_LINE;
+    GPIO_InitStruct.Mode = BOARD_SYNC_IN_RISING ? GPIO_MODE_IT_RISING : GPIO_MODE_IT_FALLING;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+    HAL_GPIO_Init(BOARD_SYNC_IN_PORT, &GPIO_InitStruct);
+    hal_sync_in_enable(false);
+    
+    HAL_NVIC_SetPriority(EXTI0_1_IRQn, BOARD_IRQ_PRIO_TIMEBASE, 0);
+    HAL_NVIC_EnableIRQ(EXTI0_1_IRQn);
+    return true;
+}
+
+void hal_sync_in_enable(bool enable)
+{
+    uint32_t primask;
+    
+    /* IMR is shared with the other EXTI lines */
+    primask = hal_crit_enter();
+    EXTI->PR = HAL_SYNC_IN_LINE;
+    if (enable) {
+        EXTI->IMR |= HAL_SYNC_IN_LINE;
+    } else {
+        EXTI->IMR &= ~HAL_SYNC_IN_LINE;
+    }
+    hal_crit_exit(primask);
+}
+
+void hal_sync_in_clear(void)
+{
+    EXTI->PR = HAL_SYNC_IN_LINE;  /* Write 1 to clear */
+}
+#endif
+
+/* ============================================================================
+ * Power Voltage Detector (Brown-out Save)
+ * ============================================================================ */
+
+#if BOARD_PVD_SAVE_ENABLE
+bool hal_pvd_init(void)
+{
+    PWR_PVDTypeDef pvd = {0};
+    
+    /* PVD output rises as VDD falls through the level: EXTI line 16 */
+    __HAL_RCC_PWR_CLK_ENABLE();
+    pvd.PVDLevel = BOARD_PVD_LEVEL;
+    pvd.Mode = PWR_PVD_MODE_IT_RISING;
+    HAL_PWR_ConfigPVD(&pvd);
+    __HAL_PWR_PVD_EXTI_CLEAR_FLAG();
+    HAL_PWR_EnablePVD();
+    
+    HAL_NVIC_SetPriority(PVD_IRQn, BOARD_IRQ_PRIO_PVD, 0);
+    HAL_NVIC_EnableIRQ(PVD_IRQn);
+    return true;
+}
+
+void hal_pvd_clear(void)
+{
+    __HAL_PWR_PVD_EXTI_CLEAR_FLAG();
+}
+
+bool hal_pvd_is_low(void)
+{
+    return __HAL_PWR_GET_FLAG(PWR_FLAG_PVDO) != 0U;
+}
+#endif
+
+/* ============================================================================
+ * RTC Wakeup (Low-Rate Logging)
+ * ============================================================================ */
+/*
+    RTCCLK: LSI, measured against HSI at init on the subsecond counter
+    (asynchronous prescaler bypassed, shadow registers bypassed)
+    ck_spre: LSI / 128 / (PREDIV_S + 1), PREDIV_S from the measurement, so
+    one wakeup clock is a second to within one PREDIV_S step (~0.4%)
+    Wakeup timer: every period_s ck_spre cycles, EXTI line 20 (wakes STOP)
+*/
+
+#if BOARD_LOG_PERIOD_S != 0
+#define HAL_RTC_ASYNCH_PREDIV  127U
+#define HAL_RTC_SYNCH_MAX      0x7FFFU
+
+static RTC_HandleTypeDef hrtc;
+
+/**
+ * @brief Read the subsecond down-counter (shadow registers bypassed)
+ */
+static uint32_t hal_rtc_read_ssr(void)
+{
+    uint32_t ssr;
+    
+    /* Read asynchronously to the RTC clock: take two equal reads */
+    do {
+        ssr = hrtc.Instance->SSR;
+    } while (ssr != hrtc.Instance->SSR);
+    
+    return ssr;
+}
+
+bool hal_rtc_wakeup_init(uint32_t period_s)
+{
+    RCC_OscInitTypeDef osc_config = {0};
+    RCC_PeriphCLKInitTypeDef clk_config = {0};
+    uint32_t start;
+    uint32_t counts;
+    uint32_t lsi_hz;
+    
+    if (period_s == 0U || period_s > 0x10000UL) {
+        return false;
+    }
+    
+    /* LSI keeps running in STOP */
+    osc_config.OscillatorType = RCC_OSCILLATORTYPE_LSI;
+    osc_config.LSIState = RCC_LSI_ON;
+    osc_config.PLL.PLLState = RCC_PLL_NONE;
+    if (HAL_RCC_OscConfig(&osc_config) != HAL_OK) {
+        return false;
+    }
+    
+    clk_config.PeriphClockSelection = RCC_PERIPHCLK_RTC;
+    clk_config.RTCClockSelection = RCC_RTCCLKSOURCE_LSI;
+    if (HAL_RCCEx_PeriphCLKConfig(&clk_config) != HAL_OK) {
+        return false;
+    }
+    __HAL_RCC_RTC_ENABLE();
+    
+    /* Subsecond counter at the LSI rate for the measurement */
+    hrtc.Instance = RTC;
+    hrtc.Init.HourFormat = RTC_HOURFORMAT_24;
+    hrtc.Init.AsynchPrediv = 0;
+    hrtc.Init.SynchPrediv = HAL_RTC_SYNCH_MAX;
+    hrtc.Init.OutPut = RTC_OUTPUT_DISABLE;
+    hrtc.Init.OutPutRemap = RTC_OUTPUT_REMAP_NONE;
+    hrtc.Init.OutPutPolarity = RTC_OUTPUT_POLARITY_HIGH;
+    hrtc.Init.OutPutType = RTC_OUTPUT_TYPE_OPENDRAIN;
+    if (HAL_RTC_Init(&hrtc) != HAL_OK ||
+        HAL_RTCEx_EnableBypassShadow(&hrtc) != HAL_OK) {
+        return false;
+    }
+    
+    /* Down-counter over a 32768-count cycle, ~1800 counts in the window:
+     * the wrapped difference covers a reload */
+    start = hal_rtc_read_ssr();
+    board_delay_us(BOARD_LOG_LSI_CAL_MS * 1000U);
+    counts = (start - hal_rtc_read_ssr()) & HAL_RTC_SYNCH_MAX;
+    
+    lsi_hz = counts * 1000U / BOARD_LOG_LSI_CAL_MS;
+    if (lsi_hz < BOARD_LSI_MIN_HZ || lsi_hz > BOARD_LSI_MAX_HZ) {
+        return false;
+    }
+    
+    /* 1 Hz ck_spre from the measured clock */
+    hrtc.Init.AsynchPrediv = HAL_RTC_ASYNCH_PREDIV;
+    hrtc.Init.SynchPrediv = (lsi_hz + (HAL_RTC_ASYNCH_PREDIV + 1U) / 2U) /
+                            (HAL_RTC_ASYNCH_PREDIV + 1U) - 1U;
+    if (HAL_RTCEx_DisableBypassShadow(&hrtc) != HAL_OK ||
+        HAL_RTC_Init(&hrtc) != HAL_OK) {
+        return false;
+    }
+    
+    if (HAL_RTCEx_SetWakeUpTimer_IT(&hrtc, period_s - 1U, RTC_WAKEUPCLOCK_CK_SPRE_16BITS) != HAL_OK) {
+        return false;
+    }
+    
+    HAL_NVIC_SetPriority(RTC_IRQn, BOARD_IRQ_PRIO_TIMEBASE, 0);
+    HAL_NVIC_EnableIRQ(RTC_IRQn);
+    
+    return true;
+}
+
+void hal_rtc_irq_handler(void)
+{
+    HAL_RTCEx_WakeUpTimerIRQHandler(&hrtc);
+}
+#endif
+
+/* ============================================================================
+ * LSE Counter (HSI Trimming Reference)
+ * ============================================================================ */
+/*
+    LSE: 32.768 kHz crystal, started without waiting (up to 2 s to settle)
+    LPTIM1: kernel clock LSE, free-running over the 16-bit range (wraps
+    every 2 s), no interrupt; read against the HSI timebases
+*/
+
+#if BOARD_CLOCK_TRIM_ENABLE && BOARD_LSE_FITTED
+static bool lse_counting = false;
+
+void hal_lse_enable(void)
+{
+    /* LSE sits in the backup domain */
+    __HAL_RCC_PWR_CLK_ENABLE();
+    HAL_PWR_EnableBkUpAccess();
+    __HAL_RCC_LSE_CONFIG(RCC_LSE_ON);
+}
+
+bool hal_lse_counter_init(void)
+{
+    if (lse_counting) {
+        return true;
+    }
+    if (__HAL_RCC_GET_FLAG(RCC_FLAG_LSERDY) == RESET) {
+        return false;
+    }
+    
+    __HAL_RCC_LPTIM1_CONFIG(RCC_LPTIM1CLKSOURCE_LSE);
+    __HAL_RCC_LPTIM1_CLK_ENABLE();
+    LPTIM1->CFGR = 0;  /* Internal clock, no prescaler, software start */
+    LPTIM1->CR = LPTIM_CR_ENABLE;
+    LPTIM1->ARR = 0xFFFFU;  /* Written once enabled */
+    LPTIM1->CR = LPTIM_CR_ENABLE | LPTIM_CR_CNTSTRT;
+    lse_counting = true;
+    return true;
+}
+
+uint16_t hal_lse_count(void)
+{
+    uint32_t first;
+    uint32_t second = LPTIM1->CNT;
+    
+    /* Counter on an asynchronous clock: take two equal reads */
+    do {
+        first = second;
+        second = LPTIM1->CNT;
+    } while (first != second);
+    
+    return (uint16_t)second;
+}
+#endif
+
 /* ============================================================================
- * I2C2 Configuration (Pressure Sensor)
+ * Cycle Counter (TIM22 + TIM3, Profiling)
  * ============================================================================ */
 
-bool hal_i2c2_init(void)
+#if BOARD_PROF_ENABLE
+/* A read this close after the TIM22 wrap may see TIM3 before it took the
+ * trigger (resynchronised on the slave clock): read again */
+#define HAL_CYCLES_WRAP_GUARD  8U
+
+void hal_cycles_init(void)
+{
+    __HAL_RCC_TIM22_CLK_ENABLE();
+    __HAL_RCC_TIM3_CLK_ENABLE();
+    
+    /* High half: external clock mode 1 on the TIM22 update */
+    TIM3->CR1 = 0;
+    TIM3->PSC = 0;
+    TIM3->ARR = 0xFFFFU;
+    TIM3->SMCR = BOARD_PROF_TIM3_ITR | TIM_SLAVEMODE_EXTERNAL1;
+    TIM3->CNT = 0;
+    TIM3->CR1 = TIM_CR1_CEN;
+    
+    /* Low half: one count per PCLK2 cycle, TRGO on update */
+    TIM22->CR1 = 0;
+    TIM22->PSC = 0;
+    TIM22->ARR = 0xFFFFU;
+    TIM22->CR2 = TIM_TRGO_UPDATE;
+    TIM22->CNT = 0;
+    TIM22->CR1 = TIM_CR1_CEN;
+}
+
+uint32_t hal_cycles_read(void)
+{
+    uint32_t high;
+    uint32_t low;
+    
+    do {
+        high = TIM3->CNT;
+        low = TIM22->CNT;
+    } while (high != TIM3->CNT || low < HAL_CYCLES_WRAP_GUARD);
+    
+    return (high << 16) | low;
+}
+#endif
+
+/* ============================================================================
+ * PWM Analog Outputs (TIM2/TIM3/TIM22)
+ * ============================================================================ */
+
+#if BOARD_PWM_OUT_ENABLE
+/**
+ * @brief One timer for the PWM rows: SYSCLK counter, period BOARD_DAC_MAX_CODE
+ *
+ * Channels are set up by the rows before the counter starts.
+ */
+static void hal_pwm_out_timer(TIM_TypeDef *tim)
+{
+    tim->CR1 = TIM_CR1_ARPE;
+    tim->PSC = 0;
+    tim->ARR = BOARD_DAC_MAX_CODE - 1U;
+}
+
+/**
+ * @brief One PWM row: channel in PWM mode 1 with compare preload, pin on its AF
+ */
+static void hal_pwm_out_channel(TIM_TypeDef *tim, uint32_t channel, GPIO_TypeDef *port,
+                                uint32_t pin, uint32_t af)
+{
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+    volatile uint32_t *ccmr = (channel <= 2U) ? &tim->CCMR1 : &tim->CCMR2;
+    uint32_t shift = ((channel - 1U) & 1U) * 8U;
+
+    *ccmr = (*ccmr & ~(0xFFUL << shift)) |
+            ((TIM_CCMR1_OC1M_2 | TIM_CCMR1_OC1M_1 | TIM_CCMR1_OC1PE) << shift);
+    tim->CCER |= TIM_CCER_CC1E << (4U * (channel - 1U));
+
+    GPIO_InitStruct.Pin = (1UL << pin);
+    GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;  /* Into an RC filter: slow edges */
+    GPIO_InitStruct.Alternate = af;
+    HAL_GPIO_Init(port, &GPIO_InitStruct);
+}
+
+#define HAL_PWM_OUT_ROW(timer, channel, port, pin, af, map) \
+    hal_pwm_out_channel(timer, channel, port, pin, af);
+
+bool hal_pwm_out_init(void)
+{
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+#if BOARD_PWM_OUT_TIM2
+    __HAL_RCC_TIM2_CLK_ENABLE();
+    hal_pwm_out_timer(TIM2);
+#endif
+#if BOARD_PWM_OUT_TIM3
+    __HAL_RCC_TIM3_CLK_ENABLE();
+    hal_pwm_out_timer(TIM3);
+#endif
+#if BOARD_PWM_OUT_TIM22
+    __HAL_RCC_TIM22_CLK_ENABLE();
+    hal_pwm_out_timer(TIM22);
+#endif
+
+    /* Compare values start at 0 (reset): every output low */
+    BOARD_PWM_OUTPUTS(HAL_PWM_OUT_ROW)
+
+    /* Load ARR and the compare preloads, then count */
+#if BOARD_PWM_OUT_TIM2
+    TIM2->EGR = TIM_EGR_UG;
+    TIM2->CR1 |= TIM_CR1_CEN;
+#endif
+#if BOARD_PWM_OUT_TIM3
+    TIM3->EGR = TIM_EGR_UG;
+    TIM3->CR1 |= TIM_CR1_CEN;
+#endif
+#if BOARD_PWM_OUT_TIM22
+    TIM22->EGR = TIM_EGR_UG;
+    TIM22->CR1 |= TIM_CR1_CEN;
+#endif
+    return true;
+}
+#endif
+
+/* ============================================================================
+ * Trace Output (LPUART1 TX + DMA)
+ * ============================================================================ */
+
+#if BOARD_TRACE_ENABLE
+/* LPUART: baud = 256 * fck / BRR, BRR from 0x300 */
+#define HAL_TRACE_BRR  ((256UL * HSI_VALUE + BOARD_TRACE_BAUD / 2U) / BOARD_TRACE_BAUD)
+
+#if HAL_TRACE_BRR < 0x300UL || HAL_TRACE_BRR > 0xFFFFFUL
+#error "BOARD_TRACE_BAUD out of the LPUART1 range on HSI16"
+#endif
+
+bool hal_trace_init(void)
 {
-    hi2c2.Instance = BOARD_I2C2_PERIPH;
-    hi2c2.Init.Timing = 0x00303D5B;  /* 100kHz I2C speed for STM32L0 @ 16MHz */
-    hi2c2.Init.OwnAddress1 = 0;
-    hi2c2.Init.AddressingMode = I2C_ADDRESSINGMODE_7BIT;
-    hi2c2.Init.DualAddressMode = I2C_DUALADDRESS_DISABLE;
-    hi2c2.Init.OwnAddress2 = 0;
-    hi2c2.Init.OwnAddress2Masks = I2C_OA2_NOMASK;
-    hi2c2.Init.GeneralCallMode = I2C_GENERALCALL_DISABLE;
-    hi2c2.Init.NoStretchMode = I2C_NOSTRETCH_DISABLE;
+    GPIO_InitTypeDef gpio = {0};
+    
+    /* HSI16 kernel clock: the baud rate does not follow the clock profile */
+    __HAL_RCC_LPUART1_CONFIG(RCC_LPUART1CLKSOURCE_HSI);
+    __HAL_RCC_LPUART1_CLK_ENABLE();
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    
+    gpio.Pin = (1U << BOARD_TRACE_TX_PIN);
+    gpio.Mode = GPIO_MODE_AF_PP;
+    gpio.Pull = GPIO_NOPULL;
+    gpio.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+    gpio.Alternate = BOARD_TRACE_TX_AF;
+    HAL_GPIO_Init(BOARD_TRACE_TX_PORT, &gpio);
     
-    if (HAL_I2C_Init(&hi2c2) != HAL_OK) {
+    /* 8N1, transmitter only, TX requests to DMA */
+    LPUART1->CR1 = 0;
+    LPUART1->BRR = HAL_TRACE_BRR;
+    LPUART1->CR3 = USART_CR3_DMAT;
+    LPUART1->CR1 = USART_CR1_TE | USART_CR1_UE;
+    
+    __HAL_RCC_DMA1_CLK_ENABLE();
+    hdma_trace.Instance = BOARD_TRACE_DMA_CHANNEL;
+    hdma_trace.Init.Request = BOARD_TRACE_DMA_REQUEST;
+    hdma_trace.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma_trace.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_trace.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_trace.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_trace.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_trace.Init.Mode = DMA_NORMAL;
+    hdma_trace.Init.Priority = DMA_PRIORITY_LOW;
+    if (HAL_DMA_Init(&hdma_trace) != HAL_OK) {
         return false;
     }
+    hdma_trace.Instance->CPAR = (uint32_t)&LPUART1->TDR;
+    __HAL_DMA_ENABLE_IT(&hdma_trace, DMA_IT_TC);
     
-    /* Configure I2C analog filter */
-    if (HAL_I2CEx_ConfigAnalogFilter(&hi2c2, I2C_ANALOGFILTER_ENABLE) != HAL_OK) {
+    HAL_NVIC_SetPriority(BOARD_TRACE_DMA_IRQn, BOARD_IRQ_PRIO_TRACE_DMA, 0);
+    HAL_NVIC_EnableIRQ(BOARD_TRACE_DMA_IRQn);
+    
+    return true;
+}
+
+void hal_trace_tx_start(const void *data, uint32_t len)
+{
+    /* Register writes only: called masked from trace sites */
+    __HAL_DMA_DISABLE(&hdma_trace);
+    hdma_trace.Instance->CMAR = (uint32_t)data;
+    hdma_trace.Instance->CNDTR = len;
+    __HAL_DMA_ENABLE(&hdma_trace);
+}
+
+bool hal_trace_tx_done(void)
+{
+    uint32_t flag = __HAL_DMA_GET_TC_FLAG_INDEX(&hdma_trace);
+    
+    if (__HAL_DMA_GET_FLAG(&hdma_trace, flag) == 0U) {
         return false;
     }
-    
+    __HAL_DMA_CLEAR_FLAG(&hdma_trace, flag);
+    __HAL_DMA_DISABLE(&hdma_trace);
     return true;
 }
 
+bool hal_trace_tx_idle(void)
+{
+    /* Last byte out of the shift register too */
+    return (LPUART1->ISR & USART_ISR_TC) != 0U;
+}
+#endif
+
 /* ============================================================================
- * I2C1 Configuration (I2C Slave)
+ * UART Stream (USART2 TX + RX DMA)
  * ============================================================================ */
 
-bool hal_i2c1_init(void)
+#if BOARD_UART_STREAM_ENABLE
+/* Oversampling 8: USARTDIV = 2 * fck / baud, BRR[2:0] = USARTDIV[3:1] */
+#define HAL_UART_STREAM_DIV  ((2UL * HSI_VALUE + BOARD_UART_STREAM_BAUD / 2U) / BOARD_UART_STREAM_BAUD)
+#define HAL_UART_STREAM_BRR  ((HAL_UART_STREAM_DIV & 0xFFF0UL) | ((HAL_UART_STREAM_DIV & 0x000FUL) >> 1))
+
+#if HAL_UART_STREAM_DIV < 16UL || HAL_UART_STREAM_DIV > 0xFFFFUL
+#error "BOARD_UART_STREAM_BAUD out of the USART2 range on HSI16"
+#endif
+
+static bool hal_uart_stream_dma_init(DMA_HandleTypeDef *hdma, DMA_Channel_TypeDef *channel,
+                                     uint32_t direction, uint32_t mode)
 {
-    hi2c1.Instance = BOARD_I2C1_PERIPH;
-    hi2c1.Init.Timing = 0x00303D5B;  /* 100kHz I2C speed for STM32L0 @ 16MHz */
-    hi2c1.Init.OwnAddress1 = (BOARD_I2C1_SLAVE_ADDR << 1);  /* 7-bit address shifted */
-    hi2c1.Init.AddressingMode = I2C_ADDRESSINGMODE_7BIT;
-    hi2c1.Init.DualAddressMode = I2C_DUALADDRESS_DISABLE;
-    hi2c1.Init.OwnAddress2 = 0;
-    hi2c1.Init.OwnAddress2Masks = I2C_OA2_NOMASK;
-    hi2c1.Init.GeneralCallMode = I2C_GENERALCALL_DISABLE;
-    hi2c1.Init.NoStretchMode = I2C_NOSTRETCH_DISABLE;
+    hdma->Instance = channel;
+    hdma->Init.Request = BOARD_UART_STREAM_DMA_REQUEST;
+    hdma->Init.Direction = direction;
+    hdma->Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma->Init.MemInc = DMA_MINC_ENABLE;
+    hdma->Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma->Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma->Init.Mode = mode;
+    hdma->Init.Priority = DMA_PRIORITY_LOW;
+    return HAL_DMA_Init(hdma) == HAL_OK;
+}
+
+bool hal_uart_stream_init(uint8_t *rx_buffer)
+{
+    GPIO_InitTypeDef gpio = {0};
     
-    if (HAL_I2C_Init(&hi2c1) != HAL_OK) {
+    if (rx_buffer == NULL) {
         return false;
     }
     
-    /* Configure I2C analog filter */
-    if (HAL_I2CEx_ConfigAnalogFilter(&hi2c1, I2C_ANALOGFILTER_ENABLE) != HAL_OK) {
+    /* HSI16 kernel clock: the baud rate does not follow the clock profile */
+    __HAL_RCC_USART2_CONFIG(RCC_USART2CLKSOURCE_HSI);
+    __HAL_RCC_USART2_CLK_ENABLE();
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    
+    gpio.Pin = (1U << BOARD_UART_STREAM_TX_PIN) | (1U << BOARD_UART_STREAM_RX_PIN);
+    gpio.Mode = GPIO_MODE_AF_PP;
+    gpio.Pull = GPIO_PULLUP;  /* RX idles high with nothing connected */
+    gpio.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+    gpio.Alternate = BOARD_UART_STREAM_AF;
+    HAL_GPIO_Init(BOARD_UART_STREAM_PORT, &gpio);
+    
+    __HAL_RCC_DMA1_CLK_ENABLE();
+    if (!hal_uart_stream_dma_init(&hdma_uart_tx, BOARD_UART_STREAM_TX_DMA_CHANNEL,
+                                  DMA_MEMORY_TO_PERIPH, DMA_NORMAL) ||
+        !hal_uart_stream_dma_init(&hdma_uart_rx, BOARD_UART_STREAM_RX_DMA_CHANNEL,
+                                  DMA_PERIPH_TO_MEMORY, DMA_CIRCULAR)) {
         return false;
     }
+    hdma_uart_tx.Instance->CPAR = (uint32_t)&USART2->TDR;
+    __HAL_DMA_ENABLE_IT(&hdma_uart_tx, DMA_IT_TC);
+    hdma_uart_rx.Instance->CPAR = (uint32_t)&USART2->RDR;
+    hdma_uart_rx.Instance->CMAR = (uint32_t)rx_buffer;
+    hdma_uart_rx.Instance->CNDTR = BOARD_UART_STREAM_RX_BYTES;
+    __HAL_DMA_ENABLE_IT(&hdma_uart_rx, DMA_IT_HT | DMA_IT_TC);
+    __HAL_DMA_ENABLE(&hdma_uart_rx);
     
-    /* Enable I2C1 interrupts for slave mode */
-    /* Note: STM32L0 uses single I2C1_IRQn for both event and error interrupts */
-    HAL_NVIC_SetPriority(I2C1_IRQn, 1, 0);
-    HAL_NVIC_EnableIRQ(I2C1_IRQn);
+    /* 8N1, both directions by DMA, IDLE line interrupt. Overrun detection
+     * off: a byte lost to a stalled DMA fails its frame's CRC instead of
+     * stopping reception */
+    USART2->CR1 = 0;
+    USART2->BRR = HAL_UART_STREAM_BRR;
+    USART2->CR3 = USART_CR3_DMAT | USART_CR3_DMAR | USART_CR3_OVRDIS;
+    USART2->CR1 = USART_CR1_OVER8 | USART_CR1_IDLEIE | USART_CR1_TE | USART_CR1_RE | USART_CR1_UE;
+    
+    HAL_NVIC_SetPriority(USART2_IRQn, BOARD_IRQ_PRIO_UART_STREAM, 0);
+    HAL_NVIC_EnableIRQ(USART2_IRQn);
+    HAL_NVIC_SetPriority(BOARD_UART_STREAM_DMA_IRQn, BOARD_IRQ_PRIO_UART_STREAM, 0);
+    HAL_NVIC_EnableIRQ(BOARD_UART_STREAM_DMA_IRQn);
     
     return true;
 }
 
+void hal_uart_stream_tx_start(const void *data, uint32_t len)
+{
+    __HAL_DMA_DISABLE(&hdma_uart_tx);
+    hdma_uart_tx.Instance->CMAR = (uint32_t)data;
+    hdma_uart_tx.Instance->CNDTR = len;
+    __HAL_DMA_ENABLE(&hdma_uart_tx);
+}
+
+bool hal_uart_stream_tx_done(void)
+{
+    uint32_t flag = __HAL_DMA_GET_TC_FLAG_INDEX(&hdma_uart_tx);
+    
+    if (__HAL_DMA_GET_FLAG(&hdma_uart_tx, flag) == 0U) {
+        return false;
+    }
+    __HAL_DMA_CLEAR_FLAG(&hdma_uart_tx, flag);
+    __HAL_DMA_DISABLE(&hdma_uart_tx);
+    return true;
+}
+
+bool hal_uart_stream_tx_idle(void)
+{
+    return (USART2->ISR & USART_ISR_TC) != 0U;
+}
+
+uint32_t hal_uart_stream_rx_pos(void)
+{
+    USART2->ICR = USART_ICR_IDLECF;
+    __HAL_DMA_CLEAR_FLAG(&hdma_uart_rx, __HAL_DMA_GET_HT_FLAG_INDEX(&hdma_uart_rx) |
+                                        __HAL_DMA_GET_TC_FLAG_INDEX(&hdma_uart_rx));
+    return BOARD_UART_STREAM_RX_BYTES - hdma_uart_rx.Instance->CNDTR;
+}
+#endif
+
 /* ============================================================================
- * TIM2 Configuration (2ms Sampling Timer)
+ * SD Card Bus (SPI2 + TX DMA)
  * ============================================================================ */
-/*
-    System clock: 16 MHz HSI
-    TIM2 prescaler: 1600 (timer clock = 10 kHz)
-    TIM2 period: 20 counts (2ms period = 500 Hz)
-    Interrupt triggers every 2ms to advance the sensor reading state machine
-*/
-bool hal_tim2_init(void)
+
+#if BOARD_SD_LOG_ENABLE
+/**
+ * @brief SPI BR field for the highest SCK at or below hz
+ */
+static uint32_t hal_sd_spi_br(uint32_t hz)
 {
-    /* For STM32L0: If APB prescaler = 1, timer clock = APB clock (no multiplier)
-     *              If APB prescaler > 1, timer clock = APB clock * 2
-     * Since we use prescaler = 1, timer clock = APB1 clock = 16MHz */
-    /* Target: 2ms period = 0.002s, so frequency = 500 Hz
-     * Timer period in counts = timer_freq / target_freq
-     * For 16MHz and 500Hz: period = 16,000,000 / 500 = 32,000 counts
-     * Use prescaler to reduce timer clock for easier calculation */
-    uint32_t prescaler = 1600 - 1;  /* Divide 16MHz by 1600 = 10kHz timer clock */
-    uint32_t period = 20 - 1;        /* 20 counts at 10kHz = 2ms period */
+    uint32_t pclk = board_get_apb1_freq();
+    uint32_t br = 0;
     
-    htim2.Instance = BOARD_TIM2_PERIPH;
-    htim2.Init.Prescaler = prescaler;
-    htim2.Init.CounterMode = TIM_COUNTERMODE_UP;
-    htim2.Init.Period = period;
-    htim2.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
-    htim2.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+    /* SCK = PCLK1 / 2^(BR + 1) */
+    while (br < 7U && (pclk >> (br + 1U)) > hz) {
+        br++;
+    }
+    return br << SPI_CR1_BR_Pos;
+}
+
+bool hal_sd_spi_init(void)
+{
+    GPIO_InitTypeDef gpio = {0};
     
-    if (HAL_TIM_Base_Init(&htim2) != HAL_OK) {
+    __HAL_RCC_SPI2_CLK_ENABLE();
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+    
+    /* CS first, released: the card must not see the bus set up */
+    HAL_GPIO_WritePin(BOARD_SD_CS_PORT, (1U << BOARD_SD_CS_PIN), GPIO_PIN_SET);
+    gpio.Pin = (1U << BOARD_SD_CS_PIN);
+    gpio.Mode = GPIO_MODE_OUTPUT_PP;
+    gpio.Pull = GPIO_NOPULL;
+    gpio.Speed = GPIO_SPEED_FREQ_HIGH;
+    HAL_GPIO_Init(BOARD_SD_CS_PORT, &gpio);
+    
+    /* MISO pulled up: an absent card reads as 0xFF (idle), not noise */
+    gpio.Pin = (1U << BOARD_SD_SCK_PIN) | (1U << BOARD_SD_MOSI_PIN);
+    gpio.Mode = GPIO_MODE_AF_PP;
+    gpio.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+    gpio.Alternate = BOARD_SD_SPI_AF;
+    HAL_GPIO_Init(BOARD_SD_SPI_PORT, &gpio);
+    gpio.Pin = (1U << BOARD_SD_MISO_PIN);
+    gpio.Pull = GPIO_PULLUP;
+    HAL_GPIO_Init(BOARD_SD_SPI_PORT, &gpio);
+    
+    /* Master, mode 0, 8-bit, software NSS */
+    BOARD_SD_SPI->CR1 = 0;
+    BOARD_SD_SPI->CR2 = 0;
+    BOARD_SD_SPI->CR1 = SPI_CR1_MSTR | SPI_CR1_SSM | SPI_CR1_SSI |
+                        hal_sd_spi_br(BOARD_SD_SPI_INIT_HZ) | SPI_CR1_SPE;
+    
+    __HAL_RCC_DMA1_CLK_ENABLE();
+    hdma_sd_tx.Instance = BOARD_SD_DMA_TX_CHANNEL;
+    hdma_sd_tx.Init.Request = BOARD_SD_DMA_TX_REQUEST;
+    hdma_sd_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma_sd_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_sd_tx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_sd_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_sd_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_sd_tx.Init.Mode = DMA_NORMAL;
+    hdma_sd_tx.Init.Priority = DMA_PRIORITY_LOW;
+    if (HAL_DMA_Init(&hdma_sd_tx) != HAL_OK) {
         return false;
     }
-    
-    /* Configure TIM2 interrupt */
-    HAL_NVIC_SetPriority(TIM2_IRQn, 2, 0);
-    HAL_NVIC_EnableIRQ(TIM2_IRQn);
+    hdma_sd_tx.Instance->CPAR = (uint32_t)&BOARD_SD_SPI->DR;
     
     return true;
 }
 
-bool hal_tim2_start(void)
+void hal_sd_spi_set_fast(bool fast)
 {
-    return (HAL_TIM_Base_Start_IT(&htim2) == HAL_OK);
+    uint32_t br = hal_sd_spi_br(fast ? BOARD_SD_SPI_HZ : BOARD_SD_SPI_INIT_HZ);
+    
+    /* BR may only change with the SPI disabled (and idle) */
+    while ((BOARD_SD_SPI->SR & SPI_SR_BSY) != 0U) {
+    }
+    BOARD_SD_SPI->CR1 &= ~SPI_CR1_SPE;
+    BOARD_SD_SPI->CR1 = (BOARD_SD_SPI->CR1 & ~SPI_CR1_BR) | br;
+    BOARD_SD_SPI->CR1 |= SPI_CR1_SPE;
 }
 
-bool hal_tim2_stop(void)
+void hal_sd_spi_select(bool selected)
 {
-    return (HAL_TIM_Base_Stop_IT(&htim2) == HAL_OK);
+    HAL_GPIO_WritePin(BOARD_SD_CS_PORT, (1U << BOARD_SD_CS_PIN),
+                      selected ? GPIO_PIN_RESET : GPIO_PIN_SET);
 }
 
-/* ============================================================================
- * DAC1 Configuration
- * ============================================================================ */
+uint8_t hal_sd_spi_xfer(uint8_t tx)
+{
+    while ((BOARD_SD_SPI->SR & SPI_SR_TXE) == 0U) {
+    }
+    *(__IO uint8_t *)&BOARD_SD_SPI->DR = tx;
+    while ((BOARD_SD_SPI->SR & SPI_SR_RXNE) == 0U) {
+    }
+    return *(__IO uint8_t *)&BOARD_SD_SPI->DR;
+}
 
-bool hal_dac1_init(void)
+void hal_sd_spi_tx_start(const void *data, uint32_t len)
 {
-    DAC_ChannelConfTypeDef sConfig = {0};
+    __HAL_DMA_DISABLE(&hdma_sd_tx);
+    __HAL_DMA_CLEAR_FLAG(&hdma_sd_tx, __HAL_DMA_GET_TC_FLAG_INDEX(&hdma_sd_tx));
+    hdma_sd_tx.Instance->CMAR = (uint32_t)data;
+    hdma_sd_tx.Instance->CNDTR = len;
+    __HAL_DMA_ENABLE(&hdma_sd_tx);
+    BOARD_SD_SPI->CR2 |= SPI_CR2_TXDMAEN;
+}
+
+bool hal_sd_spi_tx_done(void)
+{
+    uint32_t flag = __HAL_DMA_GET_TC_FLAG_INDEX(&hdma_sd_tx);
     
-    hdac1.Instance = BOARD_DAC_PERIPH;
-    if (HAL_DAC_Init(&hdac1) != HAL_OK) {
+    if (__HAL_DMA_GET_FLAG(&hdma_sd_tx, flag) == 0U ||
+        (BOARD_SD_SPI->SR & (SPI_SR_TXE | SPI_SR_BSY)) != SPI_SR_TXE) {
         return false;
     }
+    __HAL_DMA_CLEAR_FLAG(&hdma_sd_tx, flag);
+    __HAL_DMA_DISABLE(&hdma_sd_tx);
+    BOARD_SD_SPI->CR2 &= ~SPI_CR2_TXDMAEN;
     
-    /* Configure DAC channel 1 */
-    sConfig.DAC_Trigger = DAC_TRIGGER_NONE;
-    sConfig.DAC_OutputBuffer = DAC_OUTPUTBUFFER_ENABLE;
-    if (HAL_DAC_ConfigChannel(&hdac1, &sConfig, BOARD_DAC1_OUT1_CHANNEL) != HAL_OK) {
+    /* Nothing read the bytes that came back: drop the last one and the
+     * overrun it left (DR then SR) */
+    (void)*(__IO uint8_t *)&BOARD_SD_SPI->DR;
+    (void)BOARD_SD_SPI->SR;
+    return true;
+}
+#endif
+
+/* ============================================================================
+ * CRC Feed (memory-to-memory DMA)
+ * ============================================================================ */
+
+#if BOARD_CRC_FRAMING_ENABLE
+bool hal_crc_dma_init(void)
+{
+    /* Memory to memory: the source is the "peripheral" side (incremented),
+     * CRC_DR the fixed "memory" side */
+    __HAL_RCC_DMA1_CLK_ENABLE();
+    hdma_crc.Instance = BOARD_CRC_DMA_CHANNEL;
+    hdma_crc.Init.Request = DMA_REQUEST_0;
+    hdma_crc.Init.Direction = DMA_MEMORY_TO_MEMORY;
+    hdma_crc.Init.PeriphInc = DMA_PINC_ENABLE;
+    hdma_crc.Init.MemInc = DMA_MINC_DISABLE;
+    hdma_crc.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+    hdma_crc.Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+    hdma_crc.Init.Mode = DMA_NORMAL;
+    hdma_crc.Init.Priority = DMA_PRIORITY_LOW;
+    if (HAL_DMA_Init(&hdma_crc) != HAL_OK) {
         return false;
     }
+    hdma_crc.Instance->CMAR = (uint32_t)&CRC->DR;
+    
+    return true;
+}
+
+void hal_crc_dma_start(const void *data, uint32_t words)
+{
+    __HAL_DMA_DISABLE(&hdma_crc);
+    __HAL_DMA_CLEAR_FLAG(&hdma_crc, __HAL_DMA_GET_TC_FLAG_INDEX(&hdma_crc) |
+                                    __HAL_DMA_GET_TE_FLAG_INDEX(&hdma_crc));
+    hdma_crc.Instance->CPAR = (uint32_t)data;
+    hdma_crc.Instance->CNDTR = words;
+    __HAL_DMA_ENABLE(&hdma_crc);
+}
+
+bool hal_crc_dma_done(void)
+{
+    uint32_t flags = __HAL_DMA_GET_TC_FLAG_INDEX(&hdma_crc) | __HAL_DMA_GET_TE_FLAG_INDEX(&hdma_crc);
     
-    /* Configure DAC channel 2 */
-    if (HAL_DAC_ConfigChannel(&hdac1, &sConfig, BOARD_DAC1_OUT2_CHANNEL) != HAL_OK) {
+    /* An error ends the feed too: the CRC is then wrong, and the frame fails
+     * its check at the host */
+    if (__HAL_DMA_GET_FLAG(&hdma_crc, flags) == 0U) {
         return false;
     }
+    __HAL_DMA_CLEAR_FLAG(&hdma_crc, flags);
+    __HAL_DMA_DISABLE(&hdma_crc);
+    return true;
+}
+#endif
+
+/* ============================================================================
+ * Memory Copy (memory-to-memory DMA)
+ * ============================================================================ */
+
+#if BOARD_DMA_COPY_ENABLE
+bool hal_copy_dma_init(void)
+{
+    /* Memory to memory: the source is the "peripheral" side, both sides
+     * incremented; the width is set per copy */
+    __HAL_RCC_DMA1_CLK_ENABLE();
+    hdma_copy.Instance = BOARD_DMA_COPY_CHANNEL;
+    hdma_copy.Init.Request = DMA_REQUEST_0;
+    hdma_copy.Init.Direction = DMA_MEMORY_TO_MEMORY;
+    hdma_copy.Init.PeriphInc = DMA_PINC_ENABLE;
+    hdma_copy.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_copy.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_copy.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_copy.Init.Mode = DMA_NORMAL;
+    hdma_copy.Init.Priority = DMA_PRIORITY_LOW;
+    if (HAL_DMA_Init(&hdma_copy) != HAL_OK) {
+        return false;
+    }
+    
+    HAL_NVIC_SetPriority(BOARD_DMA_COPY_IRQn, BOARD_IRQ_PRIO_DMA_COPY, 0);
+    HAL_NVIC_EnableIRQ(BOARD_DMA_COPY_IRQn);
+    return true;
+}
+
+void hal_copy_dma_start(void *dst, const void *src, uint32_t items, bool words)
+{
+    DMA_Channel_TypeDef *ch = hdma_copy.Instance;
+    uint32_t ccr;
+    
+    __HAL_DMA_DISABLE(&hdma_copy);
+    __HAL_DMA_CLEAR_FLAG(&hdma_copy, __HAL_DMA_GET_TC_FLAG_INDEX(&hdma_copy) |
+                                     __HAL_DMA_GET_TE_FLAG_INDEX(&hdma_copy));
+    ccr = ch->CCR & ~(DMA_CCR_PSIZE | DMA_CCR_MSIZE);
+    if (words) {
+        ccr |= DMA_CCR_PSIZE_1 | DMA_CCR_MSIZE_1;
+    }
+    ch->CCR = ccr | DMA_CCR_TCIE | DMA_CCR_TEIE;
+    ch->CPAR = (uint32_t)src;
+    ch->CMAR = (uint32_t)dst;
+    ch->CNDTR = items;
+    __HAL_DMA_ENABLE(&hdma_copy);
+}
+
+bool hal_copy_dma_irq(bool *error)
+{
+    uint32_t tc = __HAL_DMA_GET_TC_FLAG_INDEX(&hdma_copy);
+    uint32_t te = __HAL_DMA_GET_TE_FLAG_INDEX(&hdma_copy);
     
+    /* Shared vector: the other channels' flags are left to their owners */
+    if (__HAL_DMA_GET_FLAG(&hdma_copy, tc | te) == 0U) {
+        return false;
+    }
+    *error = __HAL_DMA_GET_FLAG(&hdma_copy, te) != 0U;
+    __HAL_DMA_CLEAR_FLAG(&hdma_copy, tc | te);
+    __HAL_DMA_DISABLE(&hdma_copy);
     return true;
 }
+#endif
+
+/* ============================================================================
+ * Independent Watchdog
+ * ============================================================================ */
+
+#if BOARD_IWDG_ENABLE
+bool hal_iwdg_init(void)
+{
+    /* A debugger halt must not end in a reset */
+    __HAL_RCC_DBGMCU_CLK_ENABLE();
+    __HAL_DBGMCU_FREEZE_IWDG();
+    
+    /* Starts the watchdog (and LSI with it): from here on it cannot be
+     * stopped short of a reset */
+    hiwdg.Instance = IWDG;
+    hiwdg.Init.Prescaler = IWDG_PRESCALER_256;
+    hiwdg.Init.Reload = HAL_IWDG_RELOAD;
+    hiwdg.Init.Window = IWDG_WINDOW_DISABLE;
+    return HAL_IWDG_Init(&hiwdg) == HAL_OK;
+}
+
+void hal_iwdg_refresh(void)
+{
+    __HAL_IWDG_RELOAD_COUNTER(&hiwdg);
+}
+#endif
 
 /* ============================================================================
  * HAL Callbacks (Required by HAL)
@@ -182,6 +2922,26 @@ void HAL_I2C_MspInit(I2C_HandleTypeDef* hi2c)
         GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_MEDIUM;
         GPIO_InitStruct.Alternate = BOARD_I2C1_SCL_AF;
         HAL_GPIO_Init(BOARD_I2C1_SCL_PORT, &GPIO_InitStruct);
+        
+#if BOARD_I2C1_SLAVE_DMA
+        /* Slave frames by DMA: one interrupt at address match, one at the end.
+         * HAL_I2C_Init() has no return path for MSP errors: a channel that
+         * fails to init stays unlinked and the slave driver reports it */
+        __HAL_RCC_DMA1_CLK_ENABLE();
+        if (hal_i2c1_dma_channel_init(&hdma_i2c1_tx, BOARD_I2C1_DMA_TX_CHANNEL, DMA_MEMORY_TO_PERIPH)) {
+            __HAL_LINKDMA(hi2c, hdmatx, hdma_i2c1_tx);
+        }
+        if (hal_i2c1_dma_channel_init(&hdma_i2c1_rx, BOARD_I2C1_DMA_RX_CHANNEL, DMA_PERIPH_TO_MEMORY)) {
+            __HAL_LINKDMA(hi2c, hdmarx, hdma_i2c1_rx);
+        }
+        
+#if !BOARD_I2C1_SLAVE_LL
+        /* Same priority as I2C1: completion must not be delayed by TIM2.
+         * The LL slave ISR sees completion as STOPF and needs no DMA IRQ */
+        HAL_NVIC_SetPriority(BOARD_I2C1_DMA_IRQn, BOARD_IRQ_PRIO_I2C1, 0);
+        HAL_NVIC_EnableIRQ(BOARD_I2C1_DMA_IRQn);
+#endif
+#endif
     }
     else if (hi2c->Instance == BOARD_I2C2_PERIPH) {
         /* I2C2 clock enable */
@@ -196,6 +2956,28 @@ void HAL_I2C_MspInit(I2C_HandleTypeDef* hi2c)
         GPIO_InitStruct.Alternate = BOARD_I2C2_SCL_AF;
         HAL_GPIO_Init(BOARD_I2C2_SCL_PORT, &GPIO_InitStruct);
     }
+#if BOARD_I2C3_MUX_CHANNELS != 0
+    else if (hi2c->Instance == BOARD_I2C3_PERIPH) {
+        __HAL_RCC_I2C3_CLK_ENABLE();
+#if BOARD_MCU_PACKAGE == 64
+        __HAL_RCC_GPIOC_CLK_ENABLE();
+#else
+        __HAL_RCC_GPIOA_CLK_ENABLE();
+        __HAL_RCC_GPIOB_CLK_ENABLE();
+#endif
+        
+        /* I2C3 GPIO Configuration: PA8/PC0 -> SCL, PB4/PC1 -> SDA */
+        GPIO_InitStruct.Pin = (1UL << BOARD_I2C3_SCL_PIN);
+        GPIO_InitStruct.Mode = GPIO_MODE_AF_OD;
+        GPIO_InitStruct.Pull = GPIO_PULLUP;
+        GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_MEDIUM;
+        GPIO_InitStruct.Alternate = BOARD_I2C3_SCL_AF;
+        HAL_GPIO_Init(BOARD_I2C3_SCL_PORT, &GPIO_InitStruct);
+        GPIO_InitStruct.Pin = (1UL << BOARD_I2C3_SDA_PIN);
+        GPIO_InitStruct.Alternate = BOARD_I2C3_SDA_AF;
+        HAL_GPIO_Init(BOARD_I2C3_SDA_PORT, &GPIO_InitStruct);
+    }
+#endif
 }
 
 void HAL_I2C_MspDeInit(I2C_HandleTypeDef* hi2c)
@@ -203,11 +2985,25 @@ void HAL_I2C_MspDeInit(I2C_HandleTypeDef* hi2c)
     if (hi2c->Instance == BOARD_I2C1_PERIPH) {
         __HAL_RCC_I2C1_CLK_DISABLE();
         HAL_GPIO_DeInit(BOARD_I2C1_SCL_PORT, (1UL << BOARD_I2C1_SCL_PIN) | (1UL << BOARD_I2C1_SDA_PIN));
+#if BOARD_I2C1_SLAVE_DMA
+        HAL_NVIC_DisableIRQ(BOARD_I2C1_DMA_IRQn);
+        HAL_DMA_DeInit(&hdma_i2c1_tx);
+        HAL_DMA_DeInit(&hdma_i2c1_rx);
+        hi2c->hdmatx = NULL;
+        hi2c->hdmarx = NULL;
+#endif
     }
     else if (hi2c->Instance == BOARD_I2C2_PERIPH) {
         __HAL_RCC_I2C2_CLK_DISABLE();
         HAL_GPIO_DeInit(BOARD_I2C2_SCL_PORT, (1UL << BOARD_I2C2_SCL_PIN) | (1UL << BOARD_I2C2_SDA_PIN));
     }
+#if BOARD_I2C3_MUX_CHANNELS != 0
+    else if (hi2c->Instance == BOARD_I2C3_PERIPH) {
+        __HAL_RCC_I2C3_CLK_DISABLE();
+        HAL_GPIO_DeInit(BOARD_I2C3_SCL_PORT, (1UL << BOARD_I2C3_SCL_PIN));
+        HAL_GPIO_DeInit(BOARD_I2C3_SDA_PORT, (1UL << BOARD_I2C3_SDA_PIN));
+    }
+#endif
 }
 
 /**
@@ -218,6 +3014,11 @@ void HAL_TIM_Base_MspInit(TIM_HandleTypeDef* htim_base)
     if (htim_base->Instance == BOARD_TIM2_PERIPH) {
         __HAL_RCC_TIM2_CLK_ENABLE();
     }
+#if BOARD_DAC_STREAM_ENABLE
+    else if (htim_base->Instance == BOARD_DAC_STREAM_TIM_PERIPH) {
+        __HAL_RCC_TIM6_CLK_ENABLE();
+    }
+#endif
 }
 
 void HAL_TIM_Base_MspDeInit(TIM_HandleTypeDef* htim_base)
@@ -225,7 +3026,115 @@ void HAL_TIM_Base_MspDeInit(TIM_HandleTypeDef* htim_base)
     if (htim_base->Instance == BOARD_TIM2_PERIPH) {
         __HAL_RCC_TIM2_CLK_DISABLE();
     }
+#if BOARD_DAC_STREAM_ENABLE
+    else if (htim_base->Instance == BOARD_DAC_STREAM_TIM_PERIPH) {
+        __HAL_RCC_TIM6_CLK_DISABLE();
+    }
+#endif
+}
+
+#if BOARD_ADC_SCAN_PERIOD_MS != 0
+/**
+ * @brief ADC MSP Initialization callback
+ * 
+ * The DAC pins are already analog (HAL_DAC_MspInit()); the scan adds its
+ * DMA channel and the supply input pin. HAL_ADC_Init() has no return path
+ * for MSP errors: a channel that fails to init stays unlinked and
+ * hal_adc_scan_init() fails.
+ */
+void HAL_ADC_MspInit(ADC_HandleTypeDef* hadc)
+{
+    if (hadc->Instance == BOARD_ADC_PERIPH) {
+#if BOARD_ADC_SUPPLY_ENABLE
+        GPIO_InitTypeDef GPIO_InitStruct = {0};
+        
+#endif
+        __HAL_RCC_ADC1_CLK_ENABLE();
+        __HAL_RCC_SYSCFG_CLK_ENABLE();  /* VREFINT and sensor buffers (SYSCFG_CFGR3) */
+        __HAL_RCC_DMA1_CLK_ENABLE();
+        
+#if BOARD_ADC_SUPPLY_ENABLE
+        /* Supply divider tap -> analog */
+        __HAL_RCC_GPIOA_CLK_ENABLE();
+        GPIO_InitStruct.Pin = (1UL << BOARD_ADC_SUPPLY_PIN);
+        GPIO_InitStruct.Mode = GPIO_MODE_ANALOG;
+        GPIO_InitStruct.Pull = GPIO_NOPULL;
+        HAL_GPIO_Init(BOARD_ADC_SUPPLY_PORT, &GPIO_InitStruct);
+        
+#endif
+        /* Halfword results into the scan buffer, wrapping at every scan */
+        hdma_adc1.Instance = BOARD_ADC_DMA_CHANNEL;
+        hdma_adc1.Init.Request = BOARD_ADC_DMA_REQUEST;
+        hdma_adc1.Init.Direction = DMA_PERIPH_TO_MEMORY;
+        hdma_adc1.Init.PeriphInc = DMA_PINC_DISABLE;
+        hdma_adc1.Init.MemInc = DMA_MINC_ENABLE;
+        hdma_adc1.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+        hdma_adc1.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+        hdma_adc1.Init.Mode = DMA_CIRCULAR;
+        hdma_adc1.Init.Priority = DMA_PRIORITY_LOW;
+        if (HAL_DMA_Init(&hdma_adc1) == HAL_OK) {
+            __HAL_LINKDMA(hadc, DMA_Handle, hdma_adc1);
+        }
+        
+        /* Background work: lowest priority, with PendSV */
+        HAL_NVIC_SetPriority(BOARD_ADC_DMA_IRQn, BOARD_IRQ_PRIO_BOTTOM, 0);
+        HAL_NVIC_EnableIRQ(BOARD_ADC_DMA_IRQn);
+    }
+}
+
+void HAL_ADC_MspDeInit(ADC_HandleTypeDef* hadc)
+{
+    if (hadc->Instance == BOARD_ADC_PERIPH) {
+        HAL_NVIC_DisableIRQ(BOARD_ADC_DMA_IRQn);
+        HAL_DMA_DeInit(&hdma_adc1);
+        hadc->DMA_Handle = NULL;
+        __HAL_RCC_ADC1_CLK_DISABLE();
+    }
+}
+#endif
+
+#if BOARD_COMP_ALARM_ENABLE
+/**
+ * @brief COMP MSP Initialization callback
+ * 
+ * HAL_COMP_Init() enables the SYSCFG clock itself.
+ */
+void HAL_COMP_MspInit(COMP_HandleTypeDef* hcomp)
+{
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+    
+    if (hcomp->Instance == BOARD_COMP_PERIPH) {
+        __HAL_RCC_GPIOB_CLK_ENABLE();
+        
+        /* COMP2 GPIO Configuration: PB4 -> INP (analog) */
+        GPIO_InitStruct.Pin = (1UL << BOARD_COMP_ALARM_IN_PIN);
+        GPIO_InitStruct.Mode = GPIO_MODE_ANALOG;
+        GPIO_InitStruct.Pull = GPIO_NOPULL;
+        HAL_GPIO_Init(BOARD_COMP_ALARM_IN_PORT, &GPIO_InitStruct);
+        
+#if BOARD_COMP_ALARM_OUT_ENABLE
+        /* PA7 -> COMP2_OUT: the alarm line needs no CPU at all */
+        __HAL_RCC_GPIOA_CLK_ENABLE();
+        GPIO_InitStruct.Pin = (1UL << BOARD_COMP_ALARM_OUT_PIN);
+        GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+        GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_HIGH;
+        GPIO_InitStruct.Alternate = BOARD_COMP_ALARM_OUT_AF;
+        HAL_GPIO_Init(BOARD_COMP_ALARM_OUT_PORT, &GPIO_InitStruct);
+#endif
+    }
+}
+
+void HAL_COMP_MspDeInit(COMP_HandleTypeDef* hcomp)
+{
+    if (hcomp->Instance == BOARD_COMP_PERIPH) {
+        HAL_NVIC_DisableIRQ(ADC1_COMP_IRQn);
+        HAL_GPIO_DeInit(BOARD_COMP_ALARM_IN_PORT, (1UL << BOARD_COMP_ALARM_IN_PIN));
+#if BOARD_COMP_ALARM_OUT_ENABLE
+        HAL_GPIO_DeInit(BOARD_COMP_ALARM_OUT_PORT, (1UL << BOARD_COMP_ALARM_OUT_PIN));
+#endif
+    }
 }
+#endif
 
 /**
  * @brief DAC MSP Initialization callback
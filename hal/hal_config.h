@@ -6,7 +6,7 @@
  * @brief HAL peripheral configuration and initialization
  * 
  * This file provides HAL peripheral initialization functions for STM32L0.
- * These functions configure I2C, DAC, and Timer peripherals using STM32 HAL.
+ * These functions configure I2C, DAC, ADC, COMP, and Timer peripherals using STM32 HAL.
  */
 
 #include <stdint.h>
@@ -20,36 +20,288 @@ extern "C" {
 /* Forward declarations */
 extern I2C_HandleTypeDef hi2c1;
 extern I2C_HandleTypeDef hi2c2;
+extern I2C_HandleTypeDef hi2c3;  /* Multi-probe rigs with BOARD_I2C3_MUX_CHANNELS */
 extern DAC_HandleTypeDef hdac1;
 extern TIM_HandleTypeDef htim2;
 
+/**
+ * @brief Result of one ADC background scan
+ */
+typedef struct {
+    uint32_t vdda_mv;     /* From VREFINT and its factory calibration */
+    uint16_t dac_out[2];  /* DAC pins by dac_channel_t, raw (ratiometric to VDDA, like DAC codes) */
+    int32_t temp_centi;   /* MCU die temperature, 0.01 degC (TS_CAL1/TS_CAL2) */
+    uint32_t supply_mv;   /* Supply input through its divider, mV (0: BOARD_ADC_SUPPLY_ENABLE off) */
+} hal_adc_scan_t;
+
+/**
+ * @brief I2C bus speed profile
+ */
+typedef enum {
+    HAL_I2C_SPEED_STANDARD = 0,  /* 100 kHz */
+    HAL_I2C_SPEED_FAST,          /* 400 kHz */
+    HAL_I2C_SPEED_FAST_PLUS,     /* 1 MHz (Fm+ drive enabled on the pins) */
+    HAL_I2C_SPEED_COUNT
+} hal_i2c_speed_t;
+
+/**
+ * @brief Compute the TIMINGR value of a speed profile
+ * 
+ * SCL low/high, data setup and hold times follow the RM0377 reference
+ * settings, converted to the given kernel clock; the smallest prescaler
+ * that fits every field is used.
+ * 
+ * @param speed Speed profile
+ * @param i2cclk_hz I2C kernel clock in Hz (APB1 on this board)
+ * @return TIMINGR value, or 0 if the clock is too slow (below the RM0377
+ *         floor of the speed) or too fast for the profile
+ */
+uint32_t hal_i2c_timing(hal_i2c_speed_t speed, uint32_t i2cclk_hz);
+
 /**
  * @brief Initialize I2C2 peripheral for pressure sensor
  * 
  * Configures I2C2 with appropriate speed and settings for MS583730BA01 sensor.
+ * Bus speed: BOARD_I2C2_SPEED, or the profile of hal_i2c2_set_speed().
+ * Also reprograms a running peripheral (no deinit needed).
  * 
  * @return true if initialization successful, false otherwise
  */
 bool hal_i2c2_init(void);
 
+/**
+ * @brief Select the I2C2 speed profile
+ * 
+ * Takes effect on the next hal_i2c2_init() or hal_i2c2_recover().
+ * 
+ * @param speed Speed profile (out of range: ignored)
+ */
+void hal_i2c2_set_speed(hal_i2c_speed_t speed);
+
+/**
+ * @brief I2C2 speed profile of the next (or last) init
+ */
+hal_i2c_speed_t hal_i2c2_get_speed(void);
+
+/**
+ * @brief Initialize I2C3, the second probe bus (BOARD_I2C3_MUX_CHANNELS)
+ * 
+ * Bus speed: BOARD_I2C3_SPEED, or the profile of hal_i2c3_set_speed();
+ * completions at the I2C2 priority.
+ * 
+ * @return true if initialization successful, false otherwise
+ */
+bool hal_i2c3_init(void);
+
+/**
+ * @brief Select the I2C3 speed profile, for the next hal_i2c3_init()
+ * 
+ * @param speed Speed profile (out of range: ignored)
+ */
+void hal_i2c3_set_speed(hal_i2c_speed_t speed);
+
+/**
+ * @brief I2C3 speed profile of the next (or last) init
+ */
+hal_i2c_speed_t hal_i2c3_get_speed(void);
+
+/**
+ * @brief Gate or restore the clock of a sensor bus (I2C2, I2C3)
+ * 
+ * The peripheral keeps its configuration while gated; its registers read
+ * as 0 and writes are lost, so only gate an idle bus. Any context.
+ * 
+ * @param hi2c Sensor bus handle (other handles: ignored)
+ * @param on true to restore the clock, false to gate it
+ */
+void hal_i2c_bus_clock(I2C_HandleTypeDef *hi2c, bool on);
+
+/**
+ * @brief Check whether I2C2 needs a bus recovery
+ * 
+ * @return true after a bus error, arbitration loss or timeout, or while the
+ *         bus is busy with no transfer in flight (line held low)
+ */
+bool hal_i2c2_bus_fault(void);
+
+/**
+ * @brief Check whether the last I2C2 transfer failed on a NACK alone
+ * 
+ * @return true if the addressed device did not acknowledge and the bus
+ *         itself reported no fault (no recovery needed)
+ */
+bool hal_i2c2_nacked(void);
+
+/**
+ * @brief No I2C2 transfer in flight
+ * 
+ * I2C2 has no wakeup from STOP: a transfer must end before STOP is entered.
+ */
+bool hal_i2c2_is_idle(void);
+
+/**
+ * @brief Recover a stuck I2C2 bus and re-initialize the peripheral
+ * 
+ * Takes SCL/SDA over as GPIO, clocks out up to nine SCL pulses until the
+ * slave releases SDA, sends a STOP and runs hal_i2c2_init() again. Any
+ * transfer in flight is lost. Blocks for ~100us.
+ * 
+ * @return true if both lines are released and I2C2 is ready again
+ */
+bool hal_i2c2_recover(void);
+
 /**
  * @brief Initialize I2C1 peripheral for I2C slave
  * 
- * Configures I2C1 as a slave device with the configured address.
+ * Configures I2C1 as a slave device with the given address.
+ * Bus speed: BOARD_I2C1_SPEED. With BOARD_I2C1_WAKEUP_STOP the kernel
+ * clock is HSI and an address match wakes the MCU from STOP.
+ * 
+ * @param slave_addr 7-bit own address (BOARD_I2C1_SLAVE_ADDR unless
+ *                   configured, config.h)
+ * @return true if initialization successful, false otherwise
+ */
+bool hal_i2c1_init(uint8_t slave_addr);
+
+/**
+ * @brief I2C1 slave DMA interrupt handler
+ * 
+ * Must be called from DMA1_Channel2_3_IRQHandler(). Only available when
+ * BOARD_I2C1_SLAVE_DMA is set; the DMA channels are set up and linked to
+ * hi2c1 by HAL_I2C_MspInit().
+ */
+void hal_i2c1_dma_irq_handler(void);
+
+/**
+ * @brief Initialize the INTR_MCU data-ready output (deasserted)
+ * 
+ * No-op when BOARD_INTR_MCU_ENABLE is 0.
  * 
  * @return true if initialization successful, false otherwise
  */
-bool hal_i2c1_init(void);
+bool hal_intr_mcu_init(void);
+
+/**
+ * @brief Drive the INTR_MCU data-ready output
+ * 
+ * Polarity from BOARD_INTR_MCU_ACTIVE_LOW. Safe from any context.
+ * 
+ * @param asserted true: data ready
+ */
+void hal_intr_mcu_set(bool asserted);
 
 /**
  * @brief Initialize TIM2 for 2ms interrupt-based sampling
  * 
  * Configures TIM2 to generate interrupts at approximately 2ms intervals (500 Hz).
+ * With BOARD_TIMEBASE_LPTIM1 the hal_tim2_*() timebase runs on LPTIM1 from
+ * LSI instead (measured against HSI here, ticks at BOARD_LPTIM1_FREQ_HZ):
+ * same API, resolution one LSI period (~27 us), and it keeps counting in
+ * STOP. Ticks then arrive through HAL_LPTIM_AutoReloadMatchCallback() and
+ * the one-shot through HAL_LPTIM_CompareMatchCallback().
  * 
  * @return true if initialization successful, false otherwise
  */
 bool hal_tim2_init(void);
 
+/**
+ * @brief LPTIM1 interrupt work (call from LPTIM1_IRQHandler)
+ * 
+ * Advances the timestamp base on the ARR match, then runs the callbacks;
+ * compare matches with no one-shot armed are dropped. Requires
+ * BOARD_TIMEBASE_LPTIM1.
+ */
+void hal_lptim1_irq_handler(void);
+
+/**
+ * @brief Make sure LPTIM1 wakes the core within a delay
+ * 
+ * True if the next tick or the armed one-shot comes first; with the
+ * one-shot free, the compare is set to the delay instead (a match nobody
+ * armed, dropped by hal_lptim1_irq_handler()). Call with interrupts masked,
+ * just before STOP. Requires BOARD_TIMEBASE_LPTIM1.
+ * 
+ * @param us Longest acceptable sleep in microseconds
+ * @return true if a wake-up is due within us, false if the timebase is
+ *         stopped or the armed one-shot comes later
+ */
+bool hal_lptim1_wake_within_us(uint32_t us);
+
+/**
+ * @brief Configure PendSV as the lowest-priority bottom half
+ * 
+ * Interrupt handlers pend PendSV (hal_pendsv_trigger()) to defer work that
+ * must not run at their own priority. PendSV_Handler() lives in main.c.
+ */
+void hal_pendsv_init(void);
+
+/**
+ * @brief Pend the PendSV bottom half
+ * 
+ * Safe from any context; PendSV runs once all higher-priority handlers
+ * have returned.
+ */
+void hal_pendsv_trigger(void);
+
+/* NVIC lines of the I2C1 slave (event/error and its DMA channels) */
+#define HAL_IRQ_LINES_I2C1  ((1UL << I2C1_IRQn) | (1UL << BOARD_I2C1_DMA_IRQn))
+
+/* NVIC lines of the sampling timebase (whichever of the two is built) */
+#define HAL_IRQ_LINES_TIMEBASE  ((1UL << TIM2_IRQn) | (1UL << LPTIM1_IRQn))
+
+/* NVIC line of the USB device (usb_stream.c) */
+#define HAL_IRQ_LINES_USB  (1UL << USB_IRQn)
+
+/* NVIC lines of the UART stream (USART2 and its DMA vector, uart_stream.c) */
+#define HAL_IRQ_LINES_UART_STREAM  ((1UL << USART2_IRQn) | (1UL << BOARD_UART_STREAM_DMA_IRQn))
+
+/**
+ * @brief Mask only the given NVIC lines
+ * 
+ * The M0+ stand-in for BASEPRI: a critical section against one consumer
+ * (e.g. the I2C1 slave) that leaves every other handler, above or below it,
+ * running. Interrupts arriving meanwhile stay pending. Nests, and is safe
+ * from any context; system exceptions (PendSV, SysTick) are not masked.
+ * 
+ * @param lines Bit mask of IRQ numbers (HAL_IRQ_LINES_*)
+ * @return Lines that were enabled, for hal_irq_unmask()
+ */
+uint32_t hal_irq_mask(uint32_t lines);
+
+/**
+ * @brief Re-enable the lines masked by hal_irq_mask()
+ * 
+ * @param saved Value returned by the matching hal_irq_mask()
+ */
+void hal_irq_unmask(uint32_t saved);
+
+/* Vector table: 16 system entries (stack pointer first), then IRQ 0..31 */
+#define HAL_VECTOR_IRQ0   16U
+#define HAL_VECTOR_COUNT  (HAL_VECTOR_IRQ0 + 32U)
+
+typedef void (*hal_isr_t)(void);
+
+/**
+ * @brief Move the vector table to RAM (BOARD_RAM_VECTORS_ENABLE)
+ * 
+ * Copies the flash table (startup file) and points VTOR at the copy, from
+ * then on what hal_vectors_set() changes. Called first in main(), before
+ * any interrupt is enabled. Without BOARD_RAM_VECTORS_ENABLE a no-op.
+ */
+void hal_vectors_init(void);
+
+/**
+ * @brief Install the handler of one interrupt line
+ * 
+ * Takes effect from the next entry into the line; one already running
+ * finishes in the old handler. Safe from any context. Without
+ * BOARD_RAM_VECTORS_ENABLE a no-op: the flash table stays.
+ * 
+ * @param irq Interrupt line (IRQn_Type, not a system exception)
+ * @param handler Handler to run for it
+ */
+void hal_vectors_set(IRQn_Type irq, hal_isr_t handler);
+
 /**
  * @brief Initialize DAC1 peripheral
  * 
@@ -59,6 +311,175 @@ bool hal_tim2_init(void);
  */
 bool hal_dac1_init(void);
 
+/**
+ * @brief Initialize the PWM analog outputs (BOARD_PWM_OUTPUTS)
+ * 
+ * Each enabled timer (BOARD_PWM_OUT_TIMx) counts SYSCLK with a period of
+ * BOARD_DAC_MAX_CODE counts; each row is a channel in PWM mode 1 with the
+ * compare preloaded, its pin on the alternate function. All outputs
+ * start low. Requires BOARD_PWM_OUT_ENABLE.
+ * 
+ * @return true if initialization successful, false otherwise
+ */
+bool hal_pwm_out_init(void);
+
+/**
+ * @brief Initialize ADC1 for the background scan
+ * 
+ * Calibrates the ADC, selects both DAC pins, VREFINT, the temperature
+ * sensor and the supply input (BOARD_ADC_SUPPLY_ENABLE), 16x hardware
+ * oversampling per channel, and arms the circular DMA. With
+ * BOARD_ADC_SCAN_TIM22 it also starts TIM22, whose TRGO starts a scan
+ * every BOARD_ADC_SCAN_PERIOD_MS with no CPU involved. Requires
+ * BOARD_ADC_SCAN_PERIOD_MS != 0.
+ * 
+ * @return true if initialization successful, false otherwise
+ */
+bool hal_adc_scan_init(void);
+
+/**
+ * @brief Start one scan (~1.5 ms, results moved by DMA)
+ * 
+ * Only without BOARD_ADC_SCAN_TIM22 (the profiler owns TIM22): the TIM22
+ * trigger starts them otherwise.
+ * 
+ * @return true if started, false if a scan is still converting
+ */
+bool hal_adc_scan_start(void);
+
+/**
+ * @brief Scan in progress (the ADC halts in STOP)
+ */
+bool hal_adc_scan_is_busy(void);
+
+/**
+ * @brief Collect the newest finished scan
+ * 
+ * VDDA from the factory VREFINT_CAL and the temperature from TS_CAL1/
+ * TS_CAL2 (all taken at VDDA = 3.0 V). Each scan is collected once.
+ * 
+ * @param scan Receives the results
+ * @return true if a scan finished since the last call
+ */
+bool hal_adc_scan_read(hal_adc_scan_t *scan);
+
+/**
+ * @brief ADC DMA channel interrupt work (call from DMA1_Channel1_IRQHandler)
+ */
+void hal_adc_dma_irq_handler(void);
+
+/**
+ * @brief Initialize COMP2 as the analog watchdog
+ * 
+ * Alarm input (BOARD_COMP_ALARM_IN_PIN) against the DAC output
+ * BOARD_COMP_ALARM_DAC_OUT, output on BOARD_COMP_ALARM_OUT_PIN when
+ * enabled. The comparator runs from here; its interrupt starts disarmed.
+ * Requires BOARD_COMP_ALARM_ENABLE.
+ * 
+ * @return true if initialization successful, false otherwise
+ */
+bool hal_comp_alarm_init(void);
+
+/**
+ * @brief Set up the external sync input (BOARD_SYNC_IN_ENABLE), disabled
+ * 
+ * EXTI edge interrupt at the timebase priority: the sampler step it runs
+ * shares its context with the tick and the sensor bus completions.
+ * 
+ * @return true on success
+ */
+bool hal_sync_in_init(void);
+
+/**
+ * @brief Take sync edges or not (an edge from before is dropped)
+ */
+void hal_sync_in_enable(bool enable);
+
+/**
+ * @brief Acknowledge a sync edge (call first thing from the EXTI vector)
+ */
+void hal_sync_in_clear(void);
+
+/**
+ * @brief Set up the PVD interrupt (BOARD_PVD_SAVE_ENABLE)
+ * 
+ * VDD falling through BOARD_PVD_LEVEL, at BOARD_IRQ_PRIO_PVD.
+ * 
+ * @return true on success
+ */
+bool hal_pvd_init(void);
+
+/**
+ * @brief Acknowledge the PVD edge (call first thing from the PVD vector)
+ */
+void hal_pvd_clear(void);
+
+/**
+ * @brief Whether VDD is below BOARD_PVD_LEVEL now
+ */
+bool hal_pvd_is_low(void);
+
+/**
+ * @brief Enable the alarm interrupt (next rising edge of the output)
+ * 
+ * Clears a pending edge first.
+ */
+void hal_comp_alarm_arm(void);
+
+/**
+ * @brief Disable the alarm interrupt (comparator and output pin keep running)
+ * 
+ * Safe from the alarm callback: the comparator has no hysteresis, so the
+ * callback disarms to take one interrupt per crossing.
+ */
+void hal_comp_alarm_disarm(void);
+
+/**
+ * @brief Current comparator output
+ * 
+ * @return true while the alarm input is above the threshold
+ */
+bool hal_comp_alarm_get_output(void);
+
+/**
+ * @brief COMP2 interrupt work (call from ADC1_COMP_IRQHandler)
+ * 
+ * Calls HAL_COMP_TriggerCallback() on a rising edge.
+ */
+void hal_comp_alarm_irq_handler(void);
+
+/**
+ * @brief Select the DAC conversion trigger of both channels
+ * 
+ * The channels are briefly disabled while the trigger changes.
+ * 
+ * @param timed true: TIM6 TRGO (streaming), false: software writes (none,
+ *              or TIM2 TRGO with BOARD_DAC_LATCH_ENABLE)
+ * @return true if successful, false otherwise
+ */
+bool hal_dac1_set_trigger(bool timed);
+
+/**
+ * @brief Start TIM6 as the DAC stream trigger
+ * 
+ * Requires BOARD_DAC_STREAM_ENABLE.
+ * 
+ * @param rate_hz Samples per second (BOARD_DAC_STREAM_COUNTER_HZ / 65536 up to
+ *                BOARD_DAC_STREAM_MAX_HZ)
+ * @return true if started, false if out of range
+ */
+bool hal_dac1_stream_timer_start(uint32_t rate_hz);
+
+/**
+ * @brief Stop the DAC stream trigger
+ */
+void hal_dac1_stream_timer_stop(void);
+
+/**
+ * @brief DAC stream DMA channel interrupt (call from the DMA vector)
+ */
+void hal_dac1_dma_irq_handler(void);
+
 /**
  * @brief Start TIM2 to begin generating interrupts
  * 
@@ -73,6 +494,432 @@ bool hal_tim2_start(void);
  */
 bool hal_tim2_stop(void);
 
+/**
+ * @brief TIM2 counting (sampling timebase in use)
+ * 
+ * TIM2 is clocked from APB1 and halts in STOP mode, so STOP is only
+ * entered while this is false. LPTIM1 keeps counting in STOP.
+ */
+bool hal_tim2_is_running(void);
+
+/**
+ * @brief Next tick already due
+ * 
+ * Called at the end of the tick handler: the update flag of the tick being
+ * handled was cleared on entry, so a set flag means the next tick elapsed
+ * before the handler returned (deadline missed).
+ */
+bool hal_tim2_tick_pending(void);
+
+/**
+ * @brief Schedule a one-shot TIM2 CH1 compare event
+ * 
+ * Fires HAL_TIM_OC_DelayElapsedCallback() (TIM2, channel 1) once the given
+ * delay has elapsed, independently of the 2ms update tick. Delays longer
+ * than the tick period are supported. Only one event can be pending.
+ * 
+ * @param delay_us Delay in microseconds from now
+ * @return true if scheduled, false if an event is already pending
+ */
+bool hal_tim2_schedule_us(uint32_t delay_us);
+
+/**
+ * @brief Cancel the pending one-shot compare event (also used to disarm it
+ *        once it has fired)
+ */
+void hal_tim2_schedule_cancel(void);
+
+/**
+ * @brief Count a flagged update event into the timestamp base
+ * 
+ * Called first thing in the TIM2 handler, before its update flag is
+ * cleared (by the LL path or HAL_TIM_IRQHandler()): a timestamp read
+ * preempting the handler then sees the period either in the base or
+ * still flagged, never in neither. No-op with the update not flagged or
+ * not enabled. TIM2 timebase only.
+ */
+void hal_tim2_count_update(void);
+
+/**
+ * @brief Advance a pending long schedule and the timestamp base
+ * 
+ * Must be called from the TIM2 update (period elapsed) callback. The base
+ * is only advanced here if hal_tim2_count_update() did not already.
+ */
+void hal_tim2_schedule_update(void);
+
+/**
+ * @brief Change the tick (update event) rate
+ * 
+ * The counter keeps its clock (1 us counts for the timestamp); the period
+ * nearest to the rate goes to the preloaded ARR and takes effect at the
+ * next update event, so no tick is shortened and the timestamp stays
+ * continuous. Only rates up to BOARD_TIM2_FREQ_HZ are accepted: the
+ * sampler's tick-based conversion delays are sized for it.
+ * 
+ * @param rate_hz New tick rate (BOARD_TIM2_COUNTER_HZ / 65536 up to
+ *                BOARD_TIM2_FREQ_HZ)
+ * @return true if accepted, false if out of range
+ */
+bool hal_tim2_set_rate_hz(uint32_t rate_hz);
+
+/**
+ * @brief Tick rate in effect, or pending for the next update event
+ * 
+ * @return Rate in Hz, rounded (periods are whole counts)
+ */
+uint32_t hal_tim2_get_rate_hz(void);
+
+/**
+ * @brief Free-running 32-bit microsecond timestamp
+ * 
+ * TIM2 counter extended to 32 bits by counting update events. Wraps after
+ * ~71.6 minutes; callable from thread and interrupt context. Does not
+ * advance while TIM2 is stopped.
+ * 
+ * @return Microseconds since TIM2 was started
+ */
+uint32_t hal_tim2_get_timestamp_us(void);
+
+/**
+ * @brief Timestamp the next update event (tick) is due at
+ * 
+ * Same scale as hal_tim2_get_timestamp_us(); any context.
+ * 
+ * @return Microseconds since TIM2 was started
+ */
+uint32_t hal_tim2_get_next_tick_us(void);
+
+/**
+ * @brief Time until the next TIM2 interrupt: the tick or an armed one-shot
+ * 
+ * Any context. BOARD_TIMEBASE_TIM2 builds.
+ * 
+ * @return Microseconds, 0 if one is due already, UINT32_MAX with TIM2
+ *         stopped
+ */
+uint32_t hal_tim2_get_idle_us(void);
+
+/**
+ * @brief Divide HCLK by BOARD_CLOCK_SCALE_DIV, or back to the profile clock
+ * 
+ * Sets the AHB prescaler with TIM2 and TIM21 re-prescaled to their count
+ * in the same few cycles (counters kept, synchronised to a TIM2 count)
+ * and the I2C2/I2C3 TIMINGR recomputed with hal_i2c_timing() for the new
+ * PCLK1; board_get_sysclk_freq() and the bus getters follow. Any context,
+ * interrupts masked for the switch. BOARD_CLOCK_SCALE_ENABLE builds.
+ * 
+ * @param low true for the divided clock
+ * @return true if the clock is the one asked for, false if not switched:
+ *         a sensor transfer in flight or the bus held, the speed profile
+ *         too fast for the divided clock, a TIM2 rate change or trim
+ *         preloaded, a compare due at 0 or the DAC stream running
+ */
+bool hal_clock_scale_set(bool low);
+
+/**
+ * @brief Move the stopped timestamp forward
+ * 
+ * Accounts for time spent with the timebase stopped (low-rate logging), so
+ * timestamps keep following wall time across STOP.
+ * 
+ * @param us Microseconds to add
+ * @return true on success, false if the timebase is running
+ */
+bool hal_tim2_advance_us(uint32_t us);
+
+/**
+ * @brief Start the tick period over from now
+ * 
+ * The next tick comes one full period later; the timestamp stays
+ * continuous and a pending one-shot keeps its due time. Callable from
+ * interrupt context (synchronized sampling across boards).
+ * 
+ * @return true if done, false if the timebase is stopped or is LPTIM1
+ *         (counter not writable)
+ */
+bool hal_tim2_restart_period(void);
+
+/**
+ * @brief Lengthen or shorten the next tick period, once
+ * 
+ * The period starting at the next tick is trimmed by counts, the ones
+ * after it are back to the rate: every later tick moves by counts. The
+ * timestamp stays continuous. Any context.
+ * 
+ * @param counts Timer counts to add (negative: shorten), within half a
+ *               period
+ * @return true if set, false if out of range, the timebase is stopped or
+ *         is LPTIM1, a rate change or trim is pending or the tick is due
+ */
+bool hal_tim2_trim_period(int32_t counts);
+
+/**
+ * @brief Start the RTC wakeup timer
+ * 
+ * Clocks the RTC from LSI (measured against HSI here) and fires
+ * HAL_RTCEx_WakeUpTimerEventCallback() every period_s seconds, through STOP
+ * (EXTI line 20). Requires BOARD_LOG_PERIOD_S != 0.
+ * 
+ * @param period_s Wakeup period, 1 .. 65536 s
+ * @return true on success, false if out of range or LSI is off its spread
+ */
+bool hal_rtc_wakeup_init(uint32_t period_s);
+
+/**
+ * @brief Process the RTC interrupt (call from RTC_IRQHandler())
+ */
+void hal_rtc_irq_handler(void);
+
+/**
+ * @brief Start the LSE oscillator
+ * 
+ * Returns at once; the crystal takes up to 2 s to settle. Requires
+ * BOARD_CLOCK_TRIM_ENABLE and BOARD_LSE_FITTED.
+ */
+void hal_lse_enable(void);
+
+/**
+ * @brief Start counting LSE on LPTIM1 once it is ready
+ * 
+ * Call again until it succeeds; LPTIM1 is reserved for it afterwards.
+ * 
+ * @return true if counting, false while LSE is not ready
+ */
+bool hal_lse_counter_init(void);
+
+/**
+ * @brief Read the LSE count
+ * 
+ * Free-running 16 bits, wraps every 2 s: read more often than that.
+ * 
+ * @return LSE cycles since hal_lse_counter_init() (mod 2^16)
+ */
+uint16_t hal_lse_count(void);
+
+/**
+ * @brief Start the cycle counter
+ * 
+ * TIM22 counts PCLK2 (= SYSCLK) cycles and clocks TIM3 on every wrap, so
+ * the pair is one 32-bit counter (wraps after ~268 s at 16 MHz). Both timers
+ * are reserved for it. Requires BOARD_PROF_ENABLE.
+ */
+void hal_cycles_init(void);
+
+/**
+ * @brief Read the cycle counter
+ * 
+ * Consistent across the TIM22 wrap; callable from any context. Costs a few
+ * dozen cycles, taken back out by the profiler (prof.h).
+ * 
+ * @return SYSCLK cycles since hal_cycles_init()
+ */
+uint32_t hal_cycles_read(void);
+
+/**
+ * @brief Configure the trace output: LPUART1 TX and its DMA channel
+ * 
+ * 8N1 at BOARD_TRACE_BAUD from HSI16, so the rate holds in every clock
+ * profile. The DMA transfer complete interrupt calls trace_dma_irq_handler()
+ * (BOARD_TRACE_DMA_IRQn). Requires BOARD_TRACE_ENABLE.
+ * 
+ * @return true if initialization successful, false otherwise
+ */
+bool hal_trace_init(void);
+
+/**
+ * @brief Send a buffer over the trace output
+ * 
+ * Starts the DMA channel; the previous transfer must be done. A few
+ * register writes, callable from any context.
+ * 
+ * @param data Bytes to send, untouched until the transfer is done
+ * @param len  Number of bytes (1 to 65535)
+ */
+void hal_trace_tx_start(const void *data, uint32_t len);
+
+/**
+ * @brief Acknowledge the end of a trace transfer
+ * 
+ * Call from the DMA interrupt: clears the transfer complete flag.
+ * 
+ * @return true if the transfer started last is done
+ */
+bool hal_trace_tx_done(void);
+
+/**
+ * @brief Nothing left in the LPUART1 transmitter
+ * 
+ * @return true once the last byte is on the wire (STOP would cut it)
+ */
+bool hal_trace_tx_idle(void);
+
+/**
+ * @brief Configure the UART stream: USART2, its TX and RX DMA channels
+ * 
+ * 8N1 at BOARD_UART_STREAM_BAUD from HSI16 (oversampling 8), so the rate
+ * holds in every clock profile. RX runs at once into the circular buffer;
+ * its half/full transfer and the IDLE line interrupt, like the TX transfer
+ * complete, call into uart_stream.c (USART2_IRQn, BOARD_UART_STREAM_DMA_IRQn).
+ * Requires BOARD_UART_STREAM_ENABLE.
+ * 
+ * @param rx_buffer Circular RX buffer, BOARD_UART_STREAM_RX_BYTES
+ * @return true if initialization successful, false otherwise
+ */
+bool hal_uart_stream_init(uint8_t *rx_buffer);
+
+/**
+ * @brief Send a buffer over the UART stream
+ * 
+ * Starts the TX DMA channel; the previous transfer must be done.
+ * 
+ * @param data Bytes to send, untouched until the transfer is done
+ * @param len  Number of bytes (1 to 65535)
+ */
+void hal_uart_stream_tx_start(const void *data, uint32_t len);
+
+/**
+ * @brief Acknowledge the end of a UART stream transfer
+ * 
+ * Call from the DMA interrupt: clears the transfer complete flag.
+ * 
+ * @return true if the transfer started last is done
+ */
+bool hal_uart_stream_tx_done(void);
+
+/**
+ * @brief Nothing left in the USART2 transmitter
+ * 
+ * @return true once the last byte is on the wire
+ */
+bool hal_uart_stream_tx_idle(void);
+
+/**
+ * @brief Acknowledge the RX events and get the DMA write position
+ * 
+ * Clears the IDLE flag and the RX half/full transfer flags first, so a
+ * byte arriving after the call raises them again.
+ * 
+ * @return Index in the circular buffer the next byte goes to
+ */
+uint32_t hal_uart_stream_rx_pos(void);
+
+/**
+ * @brief Configure the SD card bus: SPI2 master (mode 0), CS and TX DMA
+ * 
+ * Starts at BOARD_SD_SPI_INIT_HZ with CS released. Requires
+ * BOARD_SD_LOG_ENABLE.
+ * 
+ * @return true if initialization successful, false otherwise
+ */
+bool hal_sd_spi_init(void);
+
+/**
+ * @brief Switch the SD card bus between the identification and data rates
+ * 
+ * @param fast true for BOARD_SD_SPI_HZ, false for BOARD_SD_SPI_INIT_HZ
+ *             (highest PCLK1 prescale at or below each)
+ */
+void hal_sd_spi_set_fast(bool fast);
+
+/**
+ * @brief Drive the SD card chip select
+ * 
+ * @param selected true to assert (low)
+ */
+void hal_sd_spi_select(bool selected);
+
+/**
+ * @brief Exchange one byte on the SD card bus (blocking)
+ * 
+ * @param tx Byte to send (0xFF to only read)
+ * @return Byte received
+ */
+uint8_t hal_sd_spi_xfer(uint8_t tx);
+
+/**
+ * @brief Send a buffer on the SD card bus by DMA, received bytes dropped
+ * 
+ * @param data Bytes to send, untouched until hal_sd_spi_tx_done()
+ * @param len  Number of bytes (1 to 65535)
+ */
+void hal_sd_spi_tx_start(const void *data, uint32_t len);
+
+/**
+ * @brief Poll the end of a DMA send
+ * 
+ * @return true once the last byte is off the bus (the bus is free again)
+ */
+bool hal_sd_spi_tx_done(void);
+
+/**
+ * @brief Configure the CRC feed: a memory-to-memory DMA channel writing
+ *        words to CRC_DR
+ * 
+ * BOARD_CRC_DMA_CHANNEL, polled (no interrupt). Requires
+ * BOARD_CRC_FRAMING_ENABLE.
+ * 
+ * @return true if initialization successful, false otherwise
+ */
+bool hal_crc_dma_init(void);
+
+/**
+ * @brief Feed words to the CRC unit by DMA
+ * 
+ * @param data  Words to feed, untouched until hal_crc_dma_done()
+ * @param words Number of words (1 to 65535)
+ */
+void hal_crc_dma_start(const void *data, uint32_t words);
+
+/**
+ * @brief Poll the end of a CRC feed
+ * 
+ * @return true once the last word is in the CRC unit (the channel is free)
+ */
+bool hal_crc_dma_done(void);
+
+/**
+ * @brief Configure the copy channel: memory-to-memory DMA
+ * 
+ * BOARD_DMA_COPY_CHANNEL, transfer complete and error interrupts on
+ * BOARD_DMA_COPY_IRQn. Requires BOARD_DMA_COPY_ENABLE.
+ * 
+ * @return true if initialization successful, false otherwise
+ */
+bool hal_copy_dma_init(void);
+
+/**
+ * @brief Start one copy on the channel
+ * 
+ * @param dst   Destination, untouched by the CPU until it completes
+ * @param src   Source, unchanged until it completes
+ * @param items Number of items (1 to 65535)
+ * @param words true: 32-bit items (both addresses word-aligned), false: bytes
+ */
+void hal_copy_dma_start(void *dst, const void *src, uint32_t items, bool words);
+
+/**
+ * @brief Take the end of a copy (from the channel interrupt)
+ * 
+ * @param error Receives true if the copy ended on a transfer error
+ * @return true if the copy on the channel ended (the channel is free)
+ */
+bool hal_copy_dma_irq(bool *error);
+
+/**
+ * @brief Start the independent watchdog (BOARD_IWDG_TIMEOUT_MS)
+ * 
+ * Cannot be stopped again. Requires BOARD_IWDG_ENABLE.
+ * 
+ * @return true if initialization successful, false otherwise
+ */
+bool hal_iwdg_init(void);
+
+/**
+ * @brief Reload the independent watchdog counter
+ */
+void hal_iwdg_refresh(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -42,7 +42,9 @@ extern "C" {
   * @{
   */
 #define CUSTOM_HID_EPIN_ADDR                 0x81U
+#ifndef CUSTOM_HID_EPIN_SIZE
 #define CUSTOM_HID_EPIN_SIZE                 0x02U
+#endif /* CUSTOM_HID_EPIN_SIZE */
 
 #define CUSTOM_HID_EPOUT_ADDR                0x01U
 #define CUSTOM_HID_EPOUT_SIZE                0x02U
@@ -25,16 +25,41 @@
 /* ########################## Module Selection ############################## */
 /**
   * @brief This is the list of modules to be used in the HAL driver 
+  *
+  * Follows the feature switches of board_config.h (and so the profile):
+  * a module no enabled feature uses is left out, its source in the
+  * Makefile link set compiles to an empty object, and a stray call to it
+  * fails to compile instead of linking in dead driver code.
   */
+#include "board_config.h"
+
 #define HAL_MODULE_ENABLED  
+#if BOARD_ADC_SCAN_PERIOD_MS != 0
+#define HAL_ADC_MODULE_ENABLED   /* Background scan */
+#endif
+#if BOARD_COMP_ALARM_ENABLE
+#define HAL_COMP_MODULE_ENABLED  /* Analog watchdog */
+#endif
 #define HAL_CORTEX_MODULE_ENABLED
 #define HAL_DAC_MODULE_ENABLED   
 #define HAL_DMA_MODULE_ENABLED
-#define HAL_FLASH_MODULE_ENABLED
+#define HAL_FLASH_MODULE_ENABLED /* Data EEPROM, option bytes */
 #define HAL_GPIO_MODULE_ENABLED
 #define HAL_I2C_MODULE_ENABLED
+#if BOARD_IWDG_ENABLE
+#define HAL_IWDG_MODULE_ENABLED
+#endif
+#if BOARD_TIMEBASE == BOARD_TIMEBASE_LPTIM1
+#define HAL_LPTIM_MODULE_ENABLED /* Sampling timebase in STOP */
+#endif
+#if BOARD_USB_STREAM_ENABLE
+#define HAL_PCD_MODULE_ENABLED   /* USB stream (USE_USB_STREAM=1 links the sources) */
+#endif
 #define HAL_PWR_MODULE_ENABLED  
 #define HAL_RCC_MODULE_ENABLED 
+#if BOARD_LOG_PERIOD_S != 0
+#define HAL_RTC_MODULE_ENABLED   /* Low-rate logging wakeup */
+#endif
 #define HAL_TIM_MODULE_ENABLED
 
 /* ########################## Oscillator Values adaptation ####################*/
@@ -105,6 +130,8 @@
 /* ################## Register callback feature configuration ############### */
 #define USE_HAL_DAC_REGISTER_CALLBACKS        0U
 #define USE_HAL_I2C_REGISTER_CALLBACKS        0U
+#define USE_HAL_LPTIM_REGISTER_CALLBACKS      0U
+#define USE_HAL_RTC_REGISTER_CALLBACKS        0U
 #define USE_HAL_TIM_REGISTER_CALLBACKS        0U
 
 /* ################## SPI peripheral configuration ########################## */
@@ -135,14 +162,38 @@
  #include "stm32l0xx_hal_i2c.h"
 #endif /* HAL_I2C_MODULE_ENABLED */
 
+#ifdef HAL_IWDG_MODULE_ENABLED
+ #include "stm32l0xx_hal_iwdg.h"
+#endif /* HAL_IWDG_MODULE_ENABLED */
+
+#ifdef HAL_LPTIM_MODULE_ENABLED
+ #include "stm32l0xx_hal_lptim.h"
+#endif /* HAL_LPTIM_MODULE_ENABLED */
+
+#ifdef HAL_PCD_MODULE_ENABLED
+ #include "stm32l0xx_hal_pcd.h"
+#endif /* HAL_PCD_MODULE_ENABLED */
+
 #ifdef HAL_PWR_MODULE_ENABLED
  #include "stm32l0xx_hal_pwr.h"
 #endif /* HAL_PWR_MODULE_ENABLED */
 
+#ifdef HAL_RTC_MODULE_ENABLED
+ #include "stm32l0xx_hal_rtc.h"
+#endif /* HAL_RTC_MODULE_ENABLED */
+
 #ifdef HAL_TIM_MODULE_ENABLED
  #include "stm32l0xx_hal_tim.h"
 #endif /* HAL_TIM_MODULE_ENABLED */
 
+#ifdef HAL_ADC_MODULE_ENABLED
+  #include "stm32l0xx_hal_adc.h"
+#endif /* HAL_ADC_MODULE_ENABLED */
+
+#ifdef HAL_COMP_MODULE_ENABLED
+  #include "stm32l0xx_hal_comp.h"
+#endif /* HAL_COMP_MODULE_ENABLED */
+
 #ifdef HAL_DAC_MODULE_ENABLED
   #include "stm32l0xx_hal_dac.h"
 #endif /* HAL_DAC_MODULE_ENABLED */
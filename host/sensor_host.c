@@ -0,0 +1,343 @@
+/**
+ * @file sensor_host.c
+ * @brief Master-side library implementation
+ *
+ * Every access is one transaction on the transport: the register pointer
+ * (and, for a command, the bytes behind it) written, then read back after
+ * a repeated START. Buffers are on the stack, the largest the FIFO frame
+ * (518 bytes).
+ */
+
+#include "sensor_host.h"
+#include <string.h>
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define SENSOR_HOST_SNAPSHOT_BYTES  0x18U  /* 0x00..0x17 */
+#define SENSOR_HOST_CMD_BYTES       5U     /* Argument, opcode */
+#define SENSOR_HOST_CRC_BYTES       2U
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static uint32_t sensor_host_get32(const uint8_t *buf)
+{
+    return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) |
+           ((uint32_t)buf[3] << 24);
+}
+
+static uint16_t sensor_host_get16(const uint8_t *buf)
+{
+    return (uint16_t)(buf[0] | (buf[1] << 8));
+}
+
+static void sensor_host_put32(uint8_t *buf, uint32_t value)
+{
+    buf[0] = (uint8_t)(value & 0xFFU);
+    buf[1] = (uint8_t)((value >> 8) & 0xFFU);
+    buf[2] = (uint8_t)((value >> 16) & 0xFFU);
+    buf[3] = (uint8_t)(value >> 24);
+}
+
+static int sensor_host_transfer(sensor_host_t *dev, const uint8_t *wr, size_t wlen, uint8_t *rd,
+                                size_t rlen)
+{
+    const sensor_host_transport_t *bus = dev->bus;
+
+    if (bus->write_read(bus->ctx, dev->addr, wr, wlen, rd, rlen) != 0) {
+        return SENSOR_HOST_ERR_BUS;
+    }
+    return SENSOR_HOST_OK;
+}
+
+static uint32_t sensor_host_unzigzag(uint32_t value)
+{
+    return (value >> 1) ^ (uint32_t)-(int32_t)(value & 1U);
+}
+
+/**
+ * @brief Read a varint
+ *
+ * @return Bytes taken, 0 if truncated (or longer than 5 bytes)
+ */
+static size_t sensor_host_varint(const uint8_t *data, size_t len, uint32_t *value)
+{
+    uint32_t result = 0;
+
+    for (size_t i = 0; i < len && i < 5U; i++) {
+        result |= (uint32_t)(data[i] & 0x7FU) << (7U * i);
+        if ((data[i] & 0x80U) == 0U) {
+            *value = result;
+            return i + 1U;
+        }
+    }
+    return 0;
+}
+
+static void sensor_host_get_record(const uint8_t *buf, sensor_host_sample_t *sample)
+{
+    sample->timestamp_us = sensor_host_get32(&buf[0]);
+    sample->sequence = sensor_host_get32(&buf[4]);
+    sample->pressure = (int32_t)sensor_host_get32(&buf[8]);
+    sample->temperature = (int32_t)sensor_host_get32(&buf[12]);
+}
+
+/**
+ * @brief Count the samples missing before this one
+ */
+static void sensor_host_track_sequence(sensor_host_t *dev, const sensor_host_sample_t *sample)
+{
+    if (dev->have_sequence) {
+        dev->gaps += sample->sequence - dev->next_sequence;
+    }
+    dev->next_sequence = sample->sequence + 1U;
+    dev->have_sequence = true;
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+void sensor_host_init(sensor_host_t *dev, const sensor_host_transport_t *bus, uint8_t addr,
+                      uint8_t flags)
+{
+    memset(dev, 0, sizeof(*dev));
+    dev->bus = bus;
+    dev->addr = addr;
+    dev->flags = flags;
+    dev->fifo_slack = 2U;
+    dev->command_wait_us = 5000U;
+}
+
+int sensor_host_read(sensor_host_t *dev, uint8_t reg, uint8_t *buf, size_t len)
+{
+    return sensor_host_transfer(dev, &reg, 1U, buf, len);
+}
+
+int sensor_host_read_u32(sensor_host_t *dev, uint8_t reg, uint32_t *value)
+{
+    uint8_t buf[4];
+    int ret = sensor_host_read(dev, reg, buf, sizeof(buf));
+
+    if (ret == SENSOR_HOST_OK) {
+        *value = sensor_host_get32(buf);
+    }
+    return ret;
+}
+
+int sensor_host_snapshot(sensor_host_t *dev, sensor_host_snapshot_t *snapshot)
+{
+    uint8_t buf[SENSOR_HOST_SNAPSHOT_BYTES];
+    int ret = sensor_host_read(dev, SENSOR_HOST_REG_PRESSURE, buf, sizeof(buf));
+
+    if (ret != SENSOR_HOST_OK) {
+        return ret;
+    }
+    snapshot->pressure = (int32_t)sensor_host_get32(&buf[SENSOR_HOST_REG_PRESSURE]);
+    snapshot->temperature = (int32_t)sensor_host_get32(&buf[SENSOR_HOST_REG_TEMPERATURE]);
+    snapshot->timestamp_us = sensor_host_get32(&buf[SENSOR_HOST_REG_TIMESTAMP]);
+    snapshot->sequence = sensor_host_get32(&buf[SENSOR_HOST_REG_SEQUENCE]);
+    snapshot->status = buf[SENSOR_HOST_REG_STATUS];
+    snapshot->fifo_level = buf[SENSOR_HOST_REG_FIFO_LEVEL];
+    snapshot->cmd_status = buf[SENSOR_HOST_REG_CMD_STATUS];
+    snapshot->alarm = buf[SENSOR_HOST_REG_ALARM];
+    snapshot->fifo_overflows = sensor_host_get32(&buf[SENSOR_HOST_REG_FIFO_OVERFLOWS]);
+    return SENSOR_HOST_OK;
+}
+
+int sensor_host_fifo_drain(sensor_host_t *dev, sensor_host_sample_t *samples, size_t max,
+                           int level, size_t *count)
+{
+    uint8_t frame[SENSOR_HOST_FIFO_FRAME_BYTES];
+    uint8_t reg = SENSOR_HOST_REG_FIFO;
+    bool crc = (dev->flags & SENSOR_HOST_CRC_FRAMING) != 0U;
+    size_t len;
+    size_t payload;
+    size_t pos = SENSOR_HOST_FIFO_HEADER_BYTES;
+    uint8_t n;
+    int ret;
+
+    *count = 0;
+    if (level < 0) {
+        uint8_t value;
+
+        ret = sensor_host_read(dev, SENSOR_HOST_REG_FIFO_LEVEL, &value, 1U);
+        if (ret != SENSOR_HOST_OK) {
+            return ret;
+        }
+        level = value;
+    }
+
+    /* Worst case per sample: a record, or a keyframe */
+    len = SENSOR_HOST_FIFO_HEADER_BYTES + ((size_t)level + dev->fifo_slack) * SENSOR_HOST_CODEC_MAX_BYTES +
+          SENSOR_HOST_CRC_BYTES;
+    if (len > sizeof(frame)) {
+        len = sizeof(frame);
+    }
+    ret = sensor_host_transfer(dev, &reg, 1U, frame, len);
+    if (ret != SENSOR_HOST_OK) {
+        return ret;
+    }
+
+    n = frame[0];
+    if (n == 0U) {
+        return SENSOR_HOST_OK;
+    }
+    if (frame[1] == SENSOR_HOST_FIFO_FORMAT_CODEC) {
+        payload = sensor_host_get16(&frame[2]);
+    } else if (frame[1] == SENSOR_HOST_FIFO_FORMAT_RECORD) {
+        payload = (size_t)n * SENSOR_HOST_RECORD_BYTES;
+    } else {
+        return SENSOR_HOST_ERR_FRAME;
+    }
+    if (pos + payload + (crc ? SENSOR_HOST_CRC_BYTES : 0U) > len) {
+        return SENSOR_HOST_ERR_FRAME;  /* Taken by the slave, not all read */
+    }
+
+    if (crc) {
+        /* Over the payload, then the header */
+        uint16_t check = sensor_host_crc16(0xFFFFU, &frame[pos], payload);
+
+        check = sensor_host_crc16(check, frame, SENSOR_HOST_FIFO_HEADER_BYTES);
+        if (check != sensor_host_get16(&frame[pos + payload])) {
+            return SENSOR_HOST_ERR_CRC;
+        }
+    }
+
+    if (frame[1] == SENSOR_HOST_FIFO_FORMAT_RECORD) {
+        for (uint8_t i = 0; i < n && *count < max; i++) {
+            sensor_host_get_record(&frame[pos], &samples[*count]);
+            sensor_host_track_sequence(dev, &samples[*count]);
+            pos += SENSOR_HOST_RECORD_BYTES;
+            (*count)++;
+        }
+        return SENSOR_HOST_OK;
+    }
+
+    /* Every codec frame starts with a keyframe */
+    {
+        sensor_host_codec_t codec;
+        size_t end = pos + payload;
+
+        sensor_host_codec_reset(&codec);
+        for (uint8_t i = 0; i < n && *count < max; i++) {
+            size_t used = sensor_host_codec_decode(&codec, &frame[pos], end - pos, &samples[*count]);
+
+            if (used == 0U || !codec.have_key) {
+                return SENSOR_HOST_ERR_FRAME;
+            }
+            sensor_host_track_sequence(dev, &samples[*count]);
+            pos += used;
+            (*count)++;
+        }
+    }
+    return SENSOR_HOST_OK;
+}
+
+int sensor_host_command(sensor_host_t *dev, uint8_t opcode, uint32_t arg, uint8_t *result)
+{
+    const sensor_host_transport_t *bus = dev->bus;
+    uint8_t buf[1U + SENSOR_HOST_CMD_BYTES + SENSOR_HOST_CRC_BYTES];
+    size_t len = 1U + SENSOR_HOST_CMD_BYTES;
+    int ret;
+
+    buf[0] = SENSOR_HOST_REG_CMD_ARG;
+    sensor_host_put32(&buf[1], arg);
+    buf[5] = opcode;
+    if ((dev->flags & SENSOR_HOST_CRC_FRAMING) != 0U) {
+        uint16_t crc = sensor_host_crc16(0xFFFFU, &buf[1], SENSOR_HOST_CMD_BYTES);
+
+        buf[6] = (uint8_t)(crc & 0xFFU);
+        buf[7] = (uint8_t)(crc >> 8);
+        len += SENSOR_HOST_CRC_BYTES;
+    }
+
+    ret = sensor_host_transfer(dev, buf, len, NULL, 0U);
+    if (ret != SENSOR_HOST_OK || result == NULL) {
+        return ret;
+    }
+
+    *result = SENSOR_HOST_RESULT_NONE;
+    if (bus->delay_us == NULL) {
+        return SENSOR_HOST_OK;
+    }
+    bus->delay_us(bus->ctx, dev->command_wait_us);
+    return sensor_host_read(dev, SENSOR_HOST_REG_CMD_STATUS, result, 1U);
+}
+
+int sensor_host_time_sync(sensor_host_t *dev, uint8_t *state)
+{
+    uint8_t result;
+    int ret;
+
+    if (dev->bus->now_us == NULL) {
+        return SENSOR_HOST_ERR_ARG;
+    }
+    ret = sensor_host_command(dev, SENSOR_HOST_CMD_TIME_SYNC, dev->bus->now_us(dev->bus->ctx),
+                              (state != NULL) ? &result : NULL);
+    if (ret != SENSOR_HOST_OK || state == NULL) {
+        return ret;
+    }
+    return sensor_host_read(dev, SENSOR_HOST_REG_SYNC_STATE, state, 1U);
+}
+
+void sensor_host_codec_reset(sensor_host_codec_t *codec)
+{
+    memset(codec, 0, sizeof(*codec));
+}
+
+size_t sensor_host_codec_decode(sensor_host_codec_t *codec, const uint8_t *data, size_t len,
+                                sensor_host_sample_t *sample)
+{
+    uint32_t field[4];  /* Tag, interval residual, d_pressure, d_temperature */
+    size_t pos = 0;
+
+    if (len == 0U) {
+        return 0;
+    }
+    if (data[0] == SENSOR_HOST_CODEC_TAG_KEYFRAME) {
+        if (len < SENSOR_HOST_CODEC_MAX_BYTES) {
+            return 0;
+        }
+        sensor_host_get_record(&data[1], &codec->previous);
+        codec->interval_us = 0;
+        codec->have_key = true;
+        *sample = codec->previous;
+        return SENSOR_HOST_CODEC_MAX_BYTES;
+    }
+
+    for (size_t i = 0; i < 4U; i++) {
+        size_t used = sensor_host_varint(&data[pos], len - pos, &field[i]);
+
+        if (used == 0U) {
+            return 0;
+        }
+        pos += used;
+    }
+    if (!codec->have_key) {
+        return pos;  /* Joined mid-stream: wait for a keyframe */
+    }
+
+    codec->interval_us += sensor_host_unzigzag(field[1]);
+    codec->previous.timestamp_us += codec->interval_us;
+    codec->previous.sequence += (field[0] >> 1) + 1U;
+    codec->previous.pressure = (int32_t)((uint32_t)codec->previous.pressure + sensor_host_unzigzag(field[2]));
+    codec->previous.temperature =
+        (int32_t)((uint32_t)codec->previous.temperature + sensor_host_unzigzag(field[3]));
+    *sample = codec->previous;
+    return pos;
+}
+
+uint16_t sensor_host_crc16(uint16_t crc, const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)((uint16_t)data[i] << 8);
+        for (uint8_t bit = 0; bit < 8U; bit++) {
+            crc = (uint16_t)(((crc & 0x8000U) != 0U) ? (((uint32_t)crc << 1) ^ 0x1021U) : ((uint32_t)crc << 1));
+        }
+    }
+    return crc;
+}
@@ -0,0 +1,430 @@
+#ifndef SENSOR_HOST_H
+#define SENSOR_HOST_H
+
+/**
+ * @file sensor_host.h
+ * @brief Master-side library for the sensor board's I2C slave
+ *
+ * Portable C99 for the master (Linux, an RTOS, another MCU): nothing here
+ * includes the firmware, whose register map (app/app.h), commands
+ * (app/host_command.h), FIFO frame (app/host_fifo.h) and sample codec
+ * (drivers/sample_codec/sample_codec.h) it mirrors byte for byte. The bus
+ * is the caller's: one callback does a write, then optionally a repeated
+ * START and a read, in one transaction (sensor_host_transport_t;
+ * sensor_host_linux.c has one for i2c-dev).
+ *
+ * The access patterns are the cheap ones the slave is built for:
+ *   - snapshot: the newest sample with its status and FIFO level in one
+ *     24-byte read at 0x00, all from the same register update
+ *   - FIFO drain: the level from the snapshot (or 0x11) sizes one burst
+ *     read at 0x30 that takes up to 32 samples, decoded from records or
+ *     the delta/varint codec and CRC-checked in CRC framing builds,
+ *     sequence gaps counted
+ *   - commands: argument and opcode (and CRC) in one write, the result
+ *     read back from 0x12
+ *   - time sync: the master clock read right before the HOST_CMD_TIME_SYNC
+ *     write, after which the slave's timestamps are in master time
+ * instead of a 4-byte read per value.
+ *
+ * Plain I2C register-pointer builds only: SMBus builds (BOARD_I2C1_SMBUS)
+ * need block reads, which i2c-dev style write-then-read does not do.
+ * No allocation, no globals: one sensor_host_t per board, not thread-safe.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * REGISTER MAP
+ * ============================================================================ */
+
+/* Byte offsets in the I2C slave register image (app/app.h APP_REG_*);
+ * multi-byte fields are little-endian */
+#define SENSOR_HOST_REG_PRESSURE      0x00U  /* int32, 0.01 mbar (0x80000000 while warming up) */
+#define SENSOR_HOST_REG_TEMPERATURE   0x04U  /* int32, 0.01 degC */
+#define SENSOR_HOST_REG_TIMESTAMP     0x08U  /* uint32, us timestamp of the sample */
+#define SENSOR_HOST_REG_SEQUENCE      0x0CU  /* uint32, sample sequence number */
+#define SENSOR_HOST_REG_STATUS        0x10U  /* uint8, sensor_status_t */
+#define SENSOR_HOST_REG_FIFO_LEVEL    0x11U  /* uint8, samples waiting for the next FIFO burst */
+#define SENSOR_HOST_REG_CMD_STATUS    0x12U  /* uint8, host_command_result_t of the last command */
+#define SENSOR_HOST_REG_ALARM         0x13U  /* uint8, SENSOR_HOST_ALARM_* flags (0 if not built) */
+#define SENSOR_HOST_REG_FIFO_OVERFLOWS 0x14U /* uint32, samples dropped on a full FIFO */
+#define SENSOR_HOST_REG_DAC_FAULT     0x18U  /* uint8, bit n = DAC output n fails readback (dac_channel_t) */
+#define SENSOR_HOST_REG_BURST_STATE   0x19U  /* uint8, burst_state_t (0 if not built) */
+#define SENSOR_HOST_REG_BURST_COUNT   0x1AU  /* uint16, samples in the capture ring, or left to drain */
+#define SENSOR_HOST_REG_DAC_READBACK  0x1CU  /* uint16 x2, last readback of OUT1, OUT2 (raw ADC codes) */
+#define SENSOR_HOST_REG_CMD_ARG       0x20U  /* uint32, command argument (written by the master) */
+#define SENSOR_HOST_REG_CMD_OPCODE    0x24U  /* uint8, command opcode: writing it queues the command */
+/* CRC framing builds: the command ends in this check (SENSOR_HOST_CRC_FRAMING) */
+#define SENSOR_HOST_REG_CMD_CRC       0x25U  /* uint16, CRC-16 (sensor_host_crc16()) of the 5 bytes at SENSOR_HOST_REG_CMD_ARG */
+#define SENSOR_HOST_REG_SYNC_STATE    0x27U  /* uint8, time_sync_state_t (0x08 and FIFO timestamps in master time unless 0) */
+#define SENSOR_HOST_REG_EVENT_ACTIVE  0x28U  /* uint8, bit n = event detector n active (event_detect.h) */
+#define SENSOR_HOST_REG_EVENT_PENDING 0x29U  /* uint8, event records waiting */
+#define SENSOR_HOST_REG_EVENT_OLDEST  0x2AU  /* uint8, oldest record: [3:0] detector, bit 7 entered */
+#define SENSOR_HOST_REG_EVENT_DROPPED 0x2BU  /* uint8, records lost on a full queue (saturated) */
+#define SENSOR_HOST_REG_EVENT_SEQ     0x2CU  /* uint32, sample sequence number of the oldest record */
+#define SENSOR_HOST_REG_FIFO          0x30U  /* Stream: FIFO burst (host_fifo.h) */
+#define SENSOR_HOST_REG_PERF          0x31U  /* Stream: performance counter bank (perf_bank.h) */
+#define SENSOR_HOST_REG_WAVE          0x31U  /* Sink: waveform table chunks, written (SENSOR_HOST_CMD_DAC_WAVE) */
+#define SENSOR_HOST_REG_PROBE         0x32U  /* Stream: probe ring (probe.h), BOARD_PROBE_ENABLE only */
+#define SENSOR_HOST_REG_BENCH         0x32U  /* Stream: benchmark table (bench.h), BOARD_BENCH_ENABLE only */
+#define SENSOR_HOST_REG_FAULT         0x33U  /* Stream: fault record of the previous boot (fault.h) */
+/* Latency window (latency.h), stage and bucket selected by HOST_CMD_LATENCY;
+ * read from 0x34 (reads from 0x30 to 0x33 are streams); 0 if not built */
+#define SENSOR_HOST_REG_LAT_STAGE     0x34U  /* uint8, latency_stage_t shown */
+#define SENSOR_HOST_REG_LAT_BUCKET    0x35U  /* uint8, bucket shown */
+#define SENSOR_HOST_REG_LAT_P50       0x36U  /* uint8, bucket of the stage's median */
+#define SENSOR_HOST_REG_LAT_P99       0x37U  /* uint8, bucket of its 99th percentile */
+#define SENSOR_HOST_REG_LAT_COUNT     0x38U  /* uint32, samples in the bucket shown */
+#define SENSOR_HOST_REG_LAT_TOTAL     0x3CU  /* uint32, samples through the stage */
+/* I2C slave statistics (i2c_slave_stats_t order), uint32 each */
+#define SENSOR_HOST_REG_I2C_READS     0x40U
+#define SENSOR_HOST_REG_I2C_WRITES    0x44U
+#define SENSOR_HOST_REG_I2C_NACKS     0x48U
+#define SENSOR_HOST_REG_I2C_ERRORS    0x4CU
+#define SENSOR_HOST_REG_I2C_OVERRUNS  0x50U
+#define SENSOR_HOST_REG_I2C_REARMS    0x54U
+#define SENSOR_HOST_REG_I2C_LAT_MIN   0x58U  /* us, address match to end of transaction */
+#define SENSOR_HOST_REG_I2C_LAT_MAX   0x5CU
+#define SENSOR_HOST_REG_I2C_LAT_MEAN  0x60U
+#define SENSOR_HOST_REG_ALARM_COUNT   0x64U  /* uint32, analog watchdog trips */
+#define SENSOR_HOST_REG_ALARM_TIME    0x68U  /* uint32, us timestamp of the last trip */
+/* Profiling window (prof.h), site selected by HOST_CMD_PROF; 0 if not built */
+#define SENSOR_HOST_REG_PROF_SITE     0x6CU  /* uint8, prof_site_t shown below */
+/* Sensor bus speeds (bus_tune.h): [1:0] hal_i2c_speed_t, [6] lowered after
+ * bus errors, [7] tuned; 0 if not built */
+#define SENSOR_HOST_REG_I2C2_SPEED    0x6DU
+#define SENSOR_HOST_REG_I2C3_SPEED    0x6EU
+#define SENSOR_HOST_REG_I2C_RESETS    0x6FU  /* uint8, slave bus resets after an SCL-low timeout (saturated) */
+#define SENSOR_HOST_REG_PROF_COUNT    0x70U  /* uint32, passes */
+#define SENSOR_HOST_REG_PROF_MIN      0x74U  /* uint32, SYSCLK cycles */
+#define SENSOR_HOST_REG_PROF_MAX      0x78U
+#define SENSOR_HOST_REG_PROF_MEAN     0x7CU
+/* Boot report, us since the clock was configured (app_boot_times_t order) */
+#define SENSOR_HOST_REG_BOOT_BOARD    0x80U  /* board_init() done */
+#define SENSOR_HOST_REG_BOOT_DRIVERS  0x84U  /* Peripherals and drivers initialized */
+#define SENSOR_HOST_REG_BOOT_APP      0x88U  /* Application initialized, sampling started */
+#define SENSOR_HOST_REG_BOOT_SAMPLE   0x8CU  /* First valid sample published (0 until then) */
+/* Sampling tick deadline (sensor_tick_stats_t) */
+#define SENSOR_HOST_REG_TICK_OVERRUNS 0x90U  /* uint32, ticks still running when the next was due */
+#define SENSOR_HOST_REG_TICK_MAX      0x94U  /* uint32, us, longest tick handler */
+#define SENSOR_HOST_REG_TICK_MAX_STATE 0x98U /* uint8, sampler state of that tick */
+/* Sampling cadence (sensor_jitter_stats_t) */
+#define SENSOR_HOST_REG_JITTER_PEAK   0x99U  /* uint8, us, largest |interval - mean| (saturated) */
+#define SENSOR_HOST_REG_JITTER_STDDEV 0x9AU  /* uint16, 0.1 us, running interval deviation (saturated) */
+#define SENSOR_HOST_REG_TICK_PERIOD   0x9CU  /* uint32, us, current tick period (the deadline) */
+/* Stack high-water mark (board_stack_poll()) */
+#define SENSOR_HOST_REG_STACK_PEAK    0xA0U  /* uint32, bytes, deepest stack use seen */
+#define SENSOR_HOST_REG_STACK_FREE    0xA4U  /* uint32, bytes, painted stack never touched */
+/* EEPROM record ring (eeprom_log.h): the record picked by HOST_CMD_EVENT_LOG */
+#define SENSOR_HOST_REG_ELOG_NEWEST   0xA8U  /* uint32, sequence number of the newest record (0 = none) */
+#define SENSOR_HOST_REG_ELOG_SEQ      0xACU  /* uint32, sequence number of the record shown (0 = none) */
+#define SENSOR_HOST_REG_ELOG_TYPE     0xB0U  /* uint8, SENSOR_HOST_ELOG_* */
+/* Quality of the sample at SENSOR_HOST_REG_PRESSURE (sensor_data_t) */
+#define SENSOR_HOST_REG_QUALITY       0xB1U  /* uint8, SENSOR_QUALITY_* */
+#define SENSOR_HOST_REG_ERROR_COUNT   0xB2U  /* uint16, aborted cycles since boot (wraps) */
+#define SENSOR_HOST_REG_ELOG_DATA     0xB4U  /* uint32 x3, per SENSOR_HOST_ELOG_* */
+/* Summary statistics of the last completed window (sample_stats.h) */
+#define SENSOR_HOST_REG_STATS_WINDOW  0xC0U  /* uint32, samples per window (0 = off) */
+#define SENSOR_HOST_REG_STATS_SEQ     0xC4U  /* uint32, windows completed (0 = none yet) */
+#define SENSOR_HOST_REG_STATS_END     0xC8U  /* uint32, us timestamp of the window's last sample */
+#define SENSOR_HOST_REG_STATS_P_MIN   0xCCU  /* int32, 0.01 mbar */
+#define SENSOR_HOST_REG_STATS_P_MAX   0xD0U
+#define SENSOR_HOST_REG_STATS_P_MEAN  0xD4U
+#define SENSOR_HOST_REG_STATS_P_VAR   0xD8U  /* uint32, (0.01 mbar)^2, saturated */
+#define SENSOR_HOST_REG_STATS_T_MIN   0xDCU  /* int32, 0.01 degC */
+#define SENSOR_HOST_REG_STATS_T_MAX   0xE0U
+#define SENSOR_HOST_REG_STATS_T_MEAN  0xE4U
+#define SENSOR_HOST_REG_STATS_T_VAR   0xE8U  /* uint32, (0.01 degC)^2, saturated */
+#define SENSOR_HOST_REG_DERIVED       0xECU  /* int32, mm over the reference (derived.h) */
+#define SENSOR_HOST_REG_TRACK_PRESSURE 0xF0U /* int32, 0.01 mbar, alpha-beta tracked (tracker.h) */
+#define SENSOR_HOST_REG_TRACK_RATE    0xF4U  /* int32, 0.01 Pa/s */
+#define SENSOR_HOST_REG_PRESSURE_UNIT 0xF8U  /* int32, pressure in the app_pressure_unit_t selected */
+/* Bytes 0x00.. published by the application in one update; the driver keeps
+ * the master-written command bytes inside it */
+#define SENSOR_HOST_REG_BLOCK_SIZE 0xFCU
+/* Master DAC setpoint (SENSOR_HOST_CMD_DAC_SETPOINT 1), master-written */
+#define SENSOR_HOST_REG_DAC_SET_OUT1 0xFCU  /* uint16, OUT1 code */
+#define SENSOR_HOST_REG_DAC_SET_OUT2 0xFEU  /* uint16, OUT2 code; a write reaching 0xFF applies both */
+#define SENSOR_HOST_REG_DAC_SET_SIZE 4U
+
+/* SENSOR_HOST_REG_ALARM flags */
+#define SENSOR_HOST_ALARM_ARMED       0x01U  /* Threshold set */
+#define SENSOR_HOST_ALARM_TRIPPED     0x02U  /* Crossed since armed (latched) */
+#define SENSOR_HOST_ALARM_ABOVE       0x04U  /* Input above the threshold now */
+
+/* EEPROM record types (SENSOR_HOST_REG_ELOG_TYPE) and their data words */
+#define SENSOR_HOST_ELOG_BOOT         1U  /* RCC_CSR reset flags [31:24], -, - */
+#define SENSOR_HOST_ELOG_STATS        2U  /* Pressure min, max, mean over the window (int32, 0.01 mbar) */
+#define SENSOR_HOST_ELOG_ERRORS       3U  /* Sampler errors, sampler timeouts, I2C slave bus errors (since boot) */
+#define SENSOR_HOST_ELOG_ALARM        4U  /* Trip count, trip timestamp (us), threshold (mV) */
+#define SENSOR_HOST_ELOG_FAULT        5U  /* Fault before this boot: pc (error code), lr (caller),
+                                           * [31:24] kind, [23:16] sampler state, [5:0] exception number */
+
+/* ============================================================================
+ * COMMANDS, RESULTS, FRAMES
+ * ============================================================================ */
+
+/* Opcodes (app/host_command.h host_command_opcode_t) */
+#define SENSOR_HOST_CMD_NOP            0x00U
+#define SENSOR_HOST_CMD_SET_OSR        0x01U
+#define SENSOR_HOST_CMD_SET_RATE       0x02U
+#define SENSOR_HOST_CMD_SET_FILTER     0x03U
+#define SENSOR_HOST_CMD_SET_DAC_MAP    0x04U
+#define SENSOR_HOST_CMD_DAC_STREAM     0x05U
+#define SENSOR_HOST_CMD_DAC_CAL        0x06U
+#define SENSOR_HOST_CMD_SET_ALARM      0x07U
+#define SENSOR_HOST_CMD_PROF           0x08U
+#define SENSOR_HOST_CMD_SD_LOG         0x09U
+#define SENSOR_HOST_CMD_EVENT_LOG      0x0AU
+#define SENSOR_HOST_CMD_FLASH_CAPTURE  0x0BU
+#define SENSOR_HOST_CMD_CONFIG         0x0CU
+#define SENSOR_HOST_CMD_STATS_WINDOW   0x0DU
+#define SENSOR_HOST_CMD_DERIVED        0x0EU
+#define SENSOR_HOST_CMD_EVENT_SET      0x0FU
+#define SENSOR_HOST_CMD_EVENT_ACK      0x10U
+#define SENSOR_HOST_CMD_PRESSURE_UNIT  0x11U
+#define SENSOR_HOST_CMD_OUTPUT_RATE    0x12U
+#define SENSOR_HOST_CMD_LATENCY        0x13U
+#define SENSOR_HOST_CMD_BURST          0x14U
+#define SENSOR_HOST_CMD_BURST_ARM      0x15U
+#define SENSOR_HOST_CMD_TIME_SYNC      0x16U
+#define SENSOR_HOST_CMD_SYNC_IN        0x17U
+#define SENSOR_HOST_CMD_FW_UPDATE      0x18U
+#define SENSOR_HOST_CMD_FW_DATA        0x19U
+#define SENSOR_HOST_CMD_PROBE          0x1AU
+#define SENSOR_HOST_CMD_STALE          0x1BU
+#define SENSOR_HOST_CMD_BENCH          0x1CU
+#define SENSOR_HOST_CMD_DAC_SETPOINT   0x1DU
+#define SENSOR_HOST_CMD_DAC_WAVE       0x1EU
+#define SENSOR_HOST_CMD_POLL_ALIGN     0x1FU
+
+/* SENSOR_HOST_REG_CMD_STATUS (host_command_result_t) */
+#define SENSOR_HOST_RESULT_OK            0U
+#define SENSOR_HOST_RESULT_BAD_OPCODE    1U  /* Unknown, or not in this build */
+#define SENSOR_HOST_RESULT_BAD_ARGUMENT  2U
+#define SENSOR_HOST_RESULT_FAILED        3U
+#define SENSOR_HOST_RESULT_BAD_CRC       4U
+#define SENSOR_HOST_RESULT_NONE          0xFFU
+
+/* SENSOR_HOST_REG_STATUS (sensor_status_t) */
+#define SENSOR_HOST_STATUS_IDLE        0U
+#define SENSOR_HOST_STATUS_WARMING_UP  1U
+#define SENSOR_HOST_STATUS_RUNNING     2U
+#define SENSOR_HOST_STATUS_ERROR       3U
+#define SENSOR_HOST_STATUS_STALE       4U
+
+/* SENSOR_HOST_REG_SYNC_STATE (time_sync_state_t) */
+#define SENSOR_HOST_SYNC_NONE          0U
+#define SENSOR_HOST_SYNC_OFFSET        1U
+#define SENSOR_HOST_SYNC_LOCKED        2U
+
+#define SENSOR_HOST_PRESSURE_WARMING   ((int32_t)INT32_MIN)  /* At 0x00 before the first sample */
+
+/* FIFO burst frame (host_fifo.h) */
+#define SENSOR_HOST_FIFO_HEADER_BYTES  4U
+#define SENSOR_HOST_RECORD_BYTES       16U
+#define SENSOR_HOST_FIFO_DEPTH         32U   /* Records per frame (codec frames: same bytes, more samples) */
+#define SENSOR_HOST_FIFO_FRAME_BYTES   (SENSOR_HOST_FIFO_HEADER_BYTES + \
+                                        SENSOR_HOST_FIFO_DEPTH * SENSOR_HOST_RECORD_BYTES + 2U)
+#define SENSOR_HOST_FIFO_FORMAT_CODEC  0x01U
+#define SENSOR_HOST_FIFO_FORMAT_RECORD 0x02U
+
+#define SENSOR_HOST_CODEC_TAG_KEYFRAME 0x01U
+#define SENSOR_HOST_CODEC_MAX_BYTES    17U   /* A keyframe */
+
+/* sensor_host_t flags: how the slave was built */
+#define SENSOR_HOST_CRC_FRAMING        0x01U  /* BOARD_CRC_FRAMING_ENABLE */
+
+/* Return codes */
+#define SENSOR_HOST_OK                 0
+#define SENSOR_HOST_ERR_BUS            (-1)  /* The transport failed */
+#define SENSOR_HOST_ERR_CRC            (-2)  /* A frame failed its CRC: its samples are lost */
+#define SENSOR_HOST_ERR_FRAME          (-3)  /* Malformed frame, or longer than the read */
+#define SENSOR_HOST_ERR_ARG            (-4)
+
+/* ============================================================================
+ * TYPES
+ * ============================================================================ */
+
+/**
+ * @brief The master's I2C bus
+ *
+ * write_read: write wlen bytes to the slave, then (rlen != 0) a repeated
+ * START and read rlen bytes, in one transaction; 0 on success. now_us,
+ * optional: the master clock in us (low 32 bits), for the time sync.
+ * delay_us, optional: wait, for command results.
+ */
+typedef struct {
+    int (*write_read)(void *ctx, uint8_t addr, const uint8_t *wr, size_t wlen,
+                      uint8_t *rd, size_t rlen);
+    uint32_t (*now_us)(void *ctx);
+    void (*delay_us)(void *ctx, uint32_t us);
+    void *ctx;
+} sensor_host_transport_t;
+
+/**
+ * @brief One sample (the 16-byte sample record, sensor_sampling.h)
+ */
+typedef struct {
+    uint32_t timestamp_us;
+    uint32_t sequence;
+    int32_t pressure;     /* 0.01 mbar */
+    int32_t temperature;  /* 0.01 degC */
+} sensor_host_sample_t;
+
+/**
+ * @brief Codec decoder state: the previous sample of one stream
+ */
+typedef struct {
+    sensor_host_sample_t previous;
+    uint32_t interval_us;  /* Previous timestamp difference */
+    bool have_key;         /* A keyframe seen since the reset */
+} sensor_host_codec_t;
+
+/**
+ * @brief Registers 0x00..0x17, from one register update
+ */
+typedef struct {
+    int32_t pressure;         /* SENSOR_HOST_PRESSURE_WARMING before the first sample */
+    int32_t temperature;
+    uint32_t timestamp_us;    /* Master time once the time sync is past NONE */
+    uint32_t sequence;
+    uint8_t status;           /* SENSOR_HOST_STATUS_* */
+    uint8_t fifo_level;       /* Samples waiting in the FIFO frame */
+    uint8_t cmd_status;       /* SENSOR_HOST_RESULT_* of the last command */
+    uint8_t alarm;            /* SENSOR_HOST_ALARM_* */
+    uint32_t fifo_overflows;
+} sensor_host_snapshot_t;
+
+/**
+ * @brief One slave board
+ */
+typedef struct {
+    const sensor_host_transport_t *bus;
+    uint8_t addr;                 /* 7-bit slave address (0x10 by default) */
+    uint8_t flags;                /* SENSOR_HOST_CRC_FRAMING */
+    uint8_t fifo_slack;           /* Samples read beyond the level (see drain) */
+    uint32_t command_wait_us;     /* Delay before reading a command result */
+    bool have_sequence;
+    uint32_t next_sequence;       /* Expected in the next FIFO sample */
+    uint32_t gaps;                /* Samples missing from the FIFO stream (overflows, lost frames) */
+} sensor_host_t;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Set up a board
+ *
+ * fifo_slack 2 and a command wait of 5 ms (one main-loop pass at the
+ * 500 Hz default, with margin); change them in the struct as needed.
+ *
+ * @param dev   Board state
+ * @param bus   Transport, kept by pointer
+ * @param addr  7-bit slave address
+ * @param flags SENSOR_HOST_CRC_FRAMING if the slave is built with it
+ */
+void sensor_host_init(sensor_host_t *dev, const sensor_host_transport_t *bus, uint8_t addr,
+                      uint8_t flags);
+
+/**
+ * @brief Read len bytes from reg in one transaction (pointer write, read)
+ *
+ * @return SENSOR_HOST_OK or SENSOR_HOST_ERR_BUS
+ */
+int sensor_host_read(sensor_host_t *dev, uint8_t reg, uint8_t *buf, size_t len);
+
+/**
+ * @brief Read a little-endian uint32 register
+ */
+int sensor_host_read_u32(sensor_host_t *dev, uint8_t reg, uint32_t *value);
+
+/**
+ * @brief Read the newest sample and the status registers in one read
+ *
+ * Enough when only the latest value matters; its FIFO level sizes the
+ * next sensor_host_fifo_drain().
+ */
+int sensor_host_snapshot(sensor_host_t *dev, sensor_host_snapshot_t *snapshot);
+
+/**
+ * @brief Take the FIFO frame in one burst read and decode it
+ *
+ * The slave hands over its whole frame at address match and forgets it,
+ * so the read must cover every sample in it: it is sized for level +
+ * fifo_slack samples (worst-case codec size), level coming from the last
+ * snapshot, or a 1-byte read of 0x11 if level is negative, and capped
+ * at SENSOR_HOST_FIFO_FRAME_BYTES. Samples that
+ * arrive between the two reads beyond the slack make the frame longer
+ * than the read: SENSOR_HOST_ERR_FRAME, and they are lost (counted in
+ * gaps through the sequence numbers). A frame with more samples than max
+ * is decoded up to max, the rest lost the same way.
+ *
+ * @param samples Receives the samples, oldest first
+ * @param max     Room in samples
+ * @param level   Samples waiting (sensor_host_snapshot_t fifo_level), or -1
+ * @param count   Receives the samples decoded
+ * @return SENSOR_HOST_OK, or an error (count still valid)
+ */
+int sensor_host_fifo_drain(sensor_host_t *dev, sensor_host_sample_t *samples, size_t max,
+                           int level, size_t *count);
+
+/**
+ * @brief Send a command, then read its result
+ *
+ * One write: argument, opcode and, with SENSOR_HOST_CRC_FRAMING, the
+ * CRC-16. The main loop runs it on its next pass: the result is read
+ * command_wait_us later, if the transport can wait (else result is
+ * SENSOR_HOST_RESULT_NONE and the caller reads 0x12 itself).
+ *
+ * @param result Receives SENSOR_HOST_RESULT_* (may be NULL)
+ */
+int sensor_host_command(sensor_host_t *dev, uint8_t opcode, uint32_t arg, uint8_t *result);
+
+/**
+ * @brief One time-sync exchange: HOST_CMD_TIME_SYNC with the master clock
+ *
+ * The clock is read (transport now_us) right before the write, which the
+ * slave pairs with its timebase at address match. A few exchanges at
+ * least 100 ms apart lock the drift; repeat every few seconds.
+ *
+ * @param state Receives SENSOR_HOST_SYNC_* after the exchange (may be NULL)
+ */
+int sensor_host_time_sync(sensor_host_t *dev, uint8_t *state);
+
+/**
+ * @brief Start a codec stream again (the next sample must be a keyframe)
+ */
+void sensor_host_codec_reset(sensor_host_codec_t *codec);
+
+/**
+ * @brief Decode one codec sample (FIFO frame, USB block, SD sector)
+ *
+ * @param data   Encoded bytes
+ * @param len    Bytes available from data
+ * @param sample Receives the sample; unchanged for a delta before the
+ *               first keyframe (a stream joined mid-way)
+ * @return Bytes taken (0: truncated), the sample valid only if have_key
+ */
+size_t sensor_host_codec_decode(sensor_host_codec_t *codec, const uint8_t *data, size_t len,
+                                sensor_host_sample_t *sample);
+
+/**
+ * @brief CRC-16/CCITT-FALSE, as the slave's commands and frames
+ *
+ * @param crc 0xFFFF for the first bytes
+ */
+uint16_t sensor_host_crc16(uint16_t crc, const uint8_t *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SENSOR_HOST_H */
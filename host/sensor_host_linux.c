@@ -0,0 +1,87 @@
+/**
+ * @file sensor_host_linux.c
+ * @brief sensor_host transport over Linux i2c-dev implementation
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sensor_host_linux.h"
+#include <fcntl.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static int sensor_host_linux_fd(void *ctx)
+{
+    return (int)(intptr_t)ctx;
+}
+
+static int sensor_host_linux_write_read(void *ctx, uint8_t addr, const uint8_t *wr, size_t wlen,
+                                        uint8_t *rd, size_t rlen)
+{
+    struct i2c_msg msgs[2];
+    struct i2c_rdwr_ioctl_data xfer;
+
+    msgs[0].addr = addr;
+    msgs[0].flags = 0;
+    msgs[0].len = (uint16_t)wlen;
+    msgs[0].buf = (uint8_t *)(uintptr_t)wr;
+    msgs[1].addr = addr;
+    msgs[1].flags = I2C_M_RD;
+    msgs[1].len = (uint16_t)rlen;
+    msgs[1].buf = rd;
+
+    xfer.msgs = msgs;
+    xfer.nmsgs = (rlen != 0U) ? 2U : 1U;
+    return (ioctl(sensor_host_linux_fd(ctx), I2C_RDWR, &xfer) < 0) ? -1 : 0;
+}
+
+static uint32_t sensor_host_linux_now_us(void *ctx)
+{
+    struct timespec now;
+
+    (void)ctx;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * 1000000U + (uint64_t)now.tv_nsec / 1000U);
+}
+
+static void sensor_host_linux_delay_us(void *ctx, uint32_t us)
+{
+    struct timespec wait;
+
+    (void)ctx;
+    wait.tv_sec = us / 1000000U;
+    wait.tv_nsec = (long)(us % 1000000U) * 1000L;
+    nanosleep(&wait, NULL);
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+int sensor_host_linux_open(sensor_host_transport_t *bus, const char *path)
+{
+    int fd = open(path, O_RDWR);
+
+    if (fd < 0) {
+        return -1;
+    }
+    bus->write_read = sensor_host_linux_write_read;
+    bus->now_us = sensor_host_linux_now_us;
+    bus->delay_us = sensor_host_linux_delay_us;
+    bus->ctx = (void *)(intptr_t)fd;
+    return fd;
+}
+
+void sensor_host_linux_close(sensor_host_transport_t *bus)
+{
+    close(sensor_host_linux_fd(bus->ctx));
+    bus->ctx = (void *)(intptr_t)-1;
+}
@@ -0,0 +1,38 @@
+#ifndef SENSOR_HOST_LINUX_H
+#define SENSOR_HOST_LINUX_H
+
+/**
+ * @file sensor_host_linux.h
+ * @brief sensor_host transport over Linux i2c-dev
+ *
+ * One I2C_RDWR ioctl per access: the pointer write and the read in one
+ * transaction with a repeated START, as the slave needs for its FIFO and
+ * stream registers. The adapter must do 518-byte reads (most do; some
+ * SMBus-only controllers do not). now_us is CLOCK_MONOTONIC.
+ */
+
+#include "sensor_host.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Open an adapter and fill in a transport for it
+ *
+ * @param bus  Receives the transport (its ctx is the descriptor)
+ * @param path Adapter, e.g. "/dev/i2c-1"
+ * @return The descriptor, or -1 (errno set)
+ */
+int sensor_host_linux_open(sensor_host_transport_t *bus, const char *path);
+
+/**
+ * @brief Close the adapter of a transport from sensor_host_linux_open()
+ */
+void sensor_host_linux_close(sensor_host_transport_t *bus);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SENSOR_HOST_LINUX_H */
@@ -0,0 +1,97 @@
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+/**
+ * @file FreeRTOSConfig.h
+ * @brief FreeRTOS kernel configuration (BOARD_RTOS_ENABLE builds)
+ *
+ * Static allocation only: no heap_x.c is linked, every task, stack and
+ * the idle task come from rtos_tasks.c. Task notifications are the only
+ * IPC; no software timers, queues or mutexes are created.
+ *
+ * The ARM_CM0 port masks every interrupt (PRIMASK) in its critical
+ * sections, so FromISR calls are legal at any priority and the kernel
+ * adds its (short) critical sections to the latency of every handler.
+ * SysTick, PendSV and SVC belong to the kernel.
+ *
+ * With BOARD_RTOS_TICKLESS the idle task calls
+ * rtos_suppress_ticks_and_sleep() instead of the port's SysTick-only
+ * version: STOP with LPTIM1 as the wake-up timer.
+ */
+
+#include <stdint.h>
+#include "board_config.h"
+
+extern uint32_t SystemCoreClock;
+
+/* ============================================================================
+ * KERNEL
+ * ============================================================================ */
+
+#define configUSE_PREEMPTION                    1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION 0  /* No CLZ on the M0+ */
+#define configUSE_TICKLESS_IDLE                 (BOARD_RTOS_TICKLESS ? 2 : 0)  /* 2: own hook */
+#define configCPU_CLOCK_HZ                      (SystemCoreClock)
+#define configTICK_RATE_HZ                      ((TickType_t)1000)  /* Also the HAL tick */
+#define configMAX_PRIORITIES                    4   /* idle, background, host, sampler */
+#define configMINIMAL_STACK_SIZE                ((uint16_t)64)  /* Words: idle task */
+#define configMAX_TASK_NAME_LEN                 8
+#define configUSE_16_BIT_TICKS                  0
+#define configIDLE_SHOULD_YIELD                 1
+#define configUSE_TASK_NOTIFICATIONS            1
+#define configUSE_MUTEXES                       0
+#define configUSE_RECURSIVE_MUTEXES             0
+#define configUSE_COUNTING_SEMAPHORES           0
+#define configQUEUE_REGISTRY_SIZE               0
+#define configUSE_TIME_SLICING                  0   /* One task per priority */
+
+/* ============================================================================
+ * MEMORY
+ * ============================================================================ */
+
+#define configSUPPORT_STATIC_ALLOCATION         1
+#define configSUPPORT_DYNAMIC_ALLOCATION        0
+
+/* ============================================================================
+ * HOOKS AND CHECKS
+ * ============================================================================ */
+
+#define configUSE_IDLE_HOOK                     1   /* WFI until the next interrupt */
+#define configUSE_TICK_HOOK                     0
+#define configUSE_MALLOC_FAILED_HOOK            0
+#define configCHECK_FOR_STACK_OVERFLOW          2   /* Stack end pattern checked at switch */
+#define configUSE_TRACE_FACILITY                0
+#define configGENERATE_RUN_TIME_STATS           0
+#define configUSE_CO_ROUTINES                   0
+#define configUSE_TIMERS                        0
+
+#if BOARD_RTOS_TICKLESS
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP   2   /* Ticks: shorter idles WFI in the hook */
+void rtos_suppress_ticks_and_sleep(uint32_t expected_idle_ticks);
+#define portSUPPRESS_TICKS_AND_SLEEP(x)  rtos_suppress_ticks_and_sleep(x)
+#endif
+
+#define configASSERT(x)  if ((x) == 0) { taskDISABLE_INTERRUPTS(); for (;;); }
+
+/* ============================================================================
+ * API
+ * ============================================================================ */
+
+#define INCLUDE_vTaskPrioritySet                0
+#define INCLUDE_uxTaskPriorityGet               0
+#define INCLUDE_vTaskDelete                     0
+#define INCLUDE_vTaskSuspend                    BOARD_RTOS_TICKLESS  /* Required by tickless idle */
+#define INCLUDE_vTaskDelayUntil                 1
+#define INCLUDE_vTaskDelay                      1
+#define INCLUDE_xTaskGetSchedulerState          1
+#define INCLUDE_uxTaskGetStackHighWaterMark     1
+
+/* ============================================================================
+ * PORT HANDLERS (CMSIS names in the vector table)
+ * ============================================================================ */
+
+#define vPortSVCHandler     SVC_Handler
+#define xPortPendSVHandler  PendSV_Handler
+#define xPortSysTickHandler SysTick_Handler
+
+#endif /* FREERTOS_CONFIG_H */
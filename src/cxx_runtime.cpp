@@ -0,0 +1,61 @@
+/**
+ * @file cxx_runtime.cpp
+ * @brief Minimal freestanding C++ runtime
+ *
+ * C++ builds with -fno-exceptions -fno-rtti -fno-threadsafe-statics
+ * (CXXFLAGS) and links with -nostdlib, so there is no libstdc++ or
+ * libsupc++: these are the few symbols compiled C++ still refers to.
+ * Objects are static (constructed by __libc_init_array()) or on the stack;
+ * there is no heap, so operator new is not provided and operator delete
+ * only exists for virtual destructors, which never delete from here.
+ */
+
+#include <stddef.h>
+#include "main.h"
+
+/* main_error_handler() code for a runtime fault */
+#define CXX_RUNTIME_ERROR  5U
+
+extern "C" {
+
+/* Handle of this image for __cxa_atexit() */
+void *__dso_handle = nullptr;
+
+/**
+ * @brief Register a static destructor
+ *
+ * The firmware never exits, so destructors are not kept (and cost no RAM).
+ */
+int __cxa_atexit(void (*destructor)(void *), void *arg, void *dso)
+{
+    (void)destructor;
+    (void)arg;
+    (void)dso;
+    return 0;
+}
+
+/**
+ * @brief Pure virtual function called (object used during construction or
+ *        destruction)
+ */
+void __cxa_pure_virtual(void)
+{
+    main_error_handler(CXX_RUNTIME_ERROR);
+}
+
+}  /* extern "C" */
+
+/* Deleting destructors of classes with a virtual destructor refer to these;
+ * nothing is ever allocated, so reaching one is a fault */
+void operator delete(void *ptr) noexcept
+{
+    (void)ptr;
+    main_error_handler(CXX_RUNTIME_ERROR);
+}
+
+void operator delete(void *ptr, size_t size) noexcept
+{
+    (void)ptr;
+    (void)size;
+    main_error_handler(CXX_RUNTIME_ERROR);
+}
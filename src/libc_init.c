@@ -1,10 +1,34 @@
 /**
  * @file libc_init.c
  * @brief Minimal __libc_init_array implementation
+ *
+ * Called by Reset_Handler after SystemInit() and before main(): runs the
+ * .preinit_array then the .init_array entries (linker.ld), i.e. C
+ * __attribute__((constructor)) functions and C++ static constructors, in
+ * link order. HAL_Init() has not run yet, so constructors must not touch
+ * peripherals. Destructors (.fini_array) never run: main() does not return.
  */
 
+#include <stddef.h>
+
+typedef void (*libc_init_fn_t)(void);
+
+/* Defined by linker.ld */
+extern libc_init_fn_t __preinit_array_start[];
+extern libc_init_fn_t __preinit_array_end[];
+extern libc_init_fn_t __init_array_start[];
+extern libc_init_fn_t __init_array_end[];
+
 void __libc_init_array(void)
 {
-    /* Empty implementation - no constructors to call in embedded system */
+    size_t count = (size_t)(__preinit_array_end - __preinit_array_start);
+    
+    for (size_t i = 0; i < count; i++) {
+        __preinit_array_start[i]();
+    }
+    
+    count = (size_t)(__init_array_end - __init_array_start);
+    for (size_t i = 0; i < count; i++) {
+        __init_array_start[i]();
+    }
 }
-
@@ -14,6 +14,7 @@
  * Start timer and sensor sampling
  * TIM2 interrupt handler (TIM2_IRQHandler)
  * HAL callback (HAL_TIM_PeriodElapsedCallback) to trigger sensor sampling
+ * (LPTIM1_IRQHandler and the LPTIM callbacks with BOARD_TIMEBASE_LPTIM1)
  */
 
 #include "main.h"
@@ -24,15 +25,63 @@
 
 /* Application includes */
 #include "app.h"
+#include "config.h"
 #include "sensor_sampling.h"
+#include "sensor_array.h"
 
 /* Driver includes */
 #include "ms58.h"
+#include "ms58_hal_wrapper.h"
 #include "i2c_slave.h"
 #include "dac.h"
+#include "prof.h"
+#include "perf.h"
+#include "trace.h"
+#include "probe.h"
+#include "fault.h"
+#include "warm_restart.h"
+#include "bus_tune.h"
+#include "self_test.h"
+#include "conv_tune.h"
+#include "clock_trim.h"
+#include "energy.h"
+#include "clock_scale.h"
+#include "eeprom.h"
+#include "timebase.h"
+#if BOARD_USB_STREAM_ENABLE
+#include "usb_stream.h"
+#endif
+#if BOARD_UART_STREAM_ENABLE
+#include "uart_stream.h"
+#endif
+#if BOARD_SD_LOG_ENABLE
+#include "sd_log.h"
+#endif
+#if BOARD_EEPROM_LOG_ENABLE
+#include "eeprom_log.h"
+#endif
+#if BOARD_FLASH_LOG_ENABLE
+#include "flash_log.h"
+#endif
+#if BOARD_FW_UPDATE_ENABLE
+#include "fw_update.h"
+#endif
+#include "crc.h"
+#if BOARD_DMA_COPY_ENABLE
+#include "dma_copy.h"
+#endif
+#if BOARD_PWM_OUT_ENABLE
+#include "pwm_out.h"
+#endif
+#if BOARD_RTOS_ENABLE
+#include "rtos_tasks.h"
+#endif
 
 /* STM32 HAL includes */
 #include "stm32l0xx_hal.h"
+#if BOARD_LL_HOTPATH && BOARD_TIMEBASE == BOARD_TIMEBASE_TIM2
+#include "stm32l0xx_ll_tim.h"
+#endif
 
 /* ============================================================================
  * GLOBAL VARIABLES
@@ -41,6 +90,9 @@
 /* HAL peripheral handles - these should be initialized by HAL config */
 I2C_HandleTypeDef hi2c1;  /* I2C1 for I2C slave */
 I2C_HandleTypeDef hi2c2;  /* I2C2 for pressure sensor */
+#if BOARD_I2C3_MUX_CHANNELS != 0
+I2C_HandleTypeDef hi2c3;  /* I2C3 for the second probe bus */
+#endif
 DAC_HandleTypeDef hdac1;  /* DAC1 for analog outputs */
 TIM_HandleTypeDef htim2;  /* TIM2 for 2ms sampling timer */
 
@@ -48,6 +100,85 @@ TIM_HandleTypeDef htim2;  /* TIM2 for 2ms sampling timer */
  * PRIVATE FUNCTIONS
  * ============================================================================ */
 
+#if BOARD_I2C1_WAKEUP_STOP
+/**
+ * @brief Nothing running that STOP would halt
+ * 
+ * TIM2, TIM6 (DAC stream), I2C2, the ADC and DMA all stop with the core clock;
+ * LPTIM1, the RTC, COMP2 and I2C1 address recognition keep going.
+ */
+static bool main_stop_allowed(void)
+{
+#if BOARD_TIMEBASE == BOARD_TIMEBASE_TIM2
+    if (hal_tim2_is_running()) {
+        return false;
+    }
+#endif
+#if BOARD_ADC_SCAN_PERIOD_MS != 0
+    if (hal_adc_scan_is_busy()) {
+        return false;
+    }
+#endif
+#if BOARD_TRACE_ENABLE
+    if (!trace_is_idle()) {
+        return false;
+    }
+#endif
+#if BOARD_USB_STREAM_ENABLE
+    if (usb_stream_is_active()) {
+        return false;
+    }
+#endif
+#if BOARD_UART_STREAM_ENABLE
+    if (uart_stream_is_active()) {
+        return false;
+    }
+#endif
+#if BOARD_SD_LOG_ENABLE
+    if (!sd_log_is_idle()) {
+        return false;
+    }
+#endif
+#if BOARD_DMA_COPY_ENABLE
+    if (!dma_copy_is_idle()) {
+        return false;
+    }
+#endif
+#if BOARD_I2C3_MUX_CHANNELS != 0
+    if (HAL_I2C_GetState(&hi2c3) != HAL_I2C_STATE_READY) {
+        return false;  /* No wakeup from STOP either */
+    }
+#endif
+    return !dac_stream_is_running() && hal_i2c2_is_idle();
+}
+
+/**
+ * @brief STOP until an I2C1 address match, the LPTIM1 timebase (or another
+ *        wakeup line); call with interrupts masked
+ */
+static void main_enter_stop(void)
+{
+#if BOARD_TIMEBASE == BOARD_TIMEBASE_LPTIM1
+    /* The one clock here that counts through STOP, when it runs */
+    bool timed = hal_tim2_is_running();
+    uint32_t start_us = hal_tim2_get_timestamp_us();
+#endif
+    
+    HAL_PWR_DisableSleepOnExit();
+    HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+#if BOARD_TIMEBASE == BOARD_TIMEBASE_LPTIM1
+    PERF_STOP(timed ? hal_tim2_get_timestamp_us() - start_us : 0U);
+#else
+    PERF_STOP(0U);
+#endif
+    /* Woken on HSI, interrupts still masked: the profile clock is back
+     * before the address match handler runs */
+    if (!board_clock_resume()) {
+        main_error_handler(4);
+    }
+}
+#endif
+
 /**
  * @brief Initialize HAL peripherals
  * 
@@ -58,7 +189,9 @@ static void main_init_hal(void)
 {
     /* HAL initialization is typically done via HAL_Init() which:
      * - Configures Flash prefetch, Instruction cache, Data cache
-     * - Sets up SysTick for HAL_Delay()
+     * - Calls HAL_InitTick(), which leaves SysTick off: HAL_GetTick()
+     *   runs on the microsecond timebase (timebase.c), or is the kernel
+     *   tick with BOARD_RTOS_ENABLE
      * - Configures NVIC priority grouping
      */
     HAL_Init();
@@ -74,18 +207,93 @@ static void main_init_hal(void)
  */
 static bool main_init_drivers(void)
 {
+    uint8_t slave_addr;
+    
+#if BOARD_PROF_ENABLE
+    /* Cycle counter first: the profiled interrupts start below */
+    prof_init();
+#endif
+    
+#if BOARD_TRACE_ENABLE
+    /* Trace output next, for the sites of the drivers started below */
+    if (!trace_init()) {
+        return false;
+    }
+#endif
+    
+#if BOARD_PROBE_ENABLE
+    /* Probe ring and pins: the timebase runs (board_init()) */
+    probe_init();
+#endif
+    
+    /* Data EEPROM write queue: before anything that stores to it */
+    if (!eeprom_init()) {
+        return false;
+    }
+    
+    /* CRC unit (and its DMA feed): the configuration check, then frames */
+    if (!crc_init()) {
+        return false;
+    }
+    
+#if BOARD_DMA_COPY_ENABLE
+    /* Copy channel, for the bulk moves of everything started below */
+    if (!dma_copy_init()) {
+        return false;
+    }
+#endif
+    
+    /* Stored configuration, checked in place: the slave address is needed
+     * now, the rest is applied in app_init() */
+    config_init();
+    slave_addr = (config_get() != NULL) ? config_get()->slave_addr : (uint8_t)BOARD_I2C1_SLAVE_ADDR;
+    
     /* Initialize I2C2 for pressure sensor */
     if (!hal_i2c2_init()) {
         return false;
     }
+#if BOARD_I2C3_MUX_CHANNELS != 0
+    if (!hal_i2c3_init()) {
+        return false;
+    }
+#endif
+    
+#if BOARD_I2C_TUNE_ENABLE
+    /* Fastest stable speed per sensor bus; a bus where nothing passes
+     * stays at BOARD_I2Cx_SPEED and bring-up reports the sensor */
+    (void)bus_tune_init();
+#endif
+    
+#if BOARD_SELF_TEST_ENABLE
+    /* Probes present, transaction and compensation times, at the speeds
+     * just chosen (reported in the performance bank) */
+    self_test_init();
+#endif
+    
+#if BOARD_CONV_TUNE_ENABLE
+    /* Shortest reliable conversion time per OSR of this sensor; one that
+     * fails keeps the datasheet time */
+    (void)conv_tune_init();
+#endif
+    
+#if BOARD_SENSOR_EARLY_RESET && BOARD_SENSOR_MUX_CHANNELS == 0
+    /* Sensor reload (2.8 ms) runs while the rest is set up; if the command
+     * cannot go out, bring-up sends it again */
+    (void)sensor_sampling_reset_early();
+#endif
     
     /* Initialize I2C1 for I2C slave */
-    if (!hal_i2c1_init()) {
+    if (!hal_i2c1_init(slave_addr)) {
         return false;
     }
     
     /* Initialize I2C slave driver */
-    if (!i2c_slave_init(&hi2c1, BOARD_I2C1_SLAVE_ADDR)) {
+    if (!i2c_slave_init(&hi2c1, slave_addr)) {
+        return false;
+    }
+    
+    /* Data-ready line to the master, deasserted until the first sample */
+    if (!hal_intr_mcu_init()) {
         return false;
     }
     
@@ -94,6 +302,9 @@ static bool main_init_drivers(void)
         return false;
     }
     
+    /* PendSV: low-priority bottom half for sample compensation */
+    hal_pendsv_init();
+    
     /* Initialize DAC1 */
     if (!hal_dac1_init()) {
         return false;
@@ -104,6 +315,94 @@ static bool main_init_drivers(void)
         return false;
     }
     
+#if BOARD_PWM_OUT_ENABLE
+    /* PWM analog outputs, low until the first sample */
+    if (!pwm_out_init()) {
+        return false;
+    }
+#endif
+    
+#if BOARD_EEPROM_LOG_ENABLE
+    /* EEPROM record ring: newest record found, appends queue from here on */
+    if (!eeprom_log_init()) {
+        return false;
+    }
+#endif
+    
+#if BOARD_COMP_ALARM_ENABLE
+    /* COMP2 against the DAC threshold output (after the DAC: its input) */
+    if (!hal_comp_alarm_init()) {
+        return false;
+    }
+#endif
+    
+#if BOARD_SYNC_IN_ENABLE
+    /* External sync input, idle until HOST_CMD_SYNC_IN selects it */
+    if (!hal_sync_in_init()) {
+        return false;
+    }
+#endif
+    
+#if BOARD_ADC_SCAN_PERIOD_MS != 0
+    /* ADC1 scan of the DAC pins, VREFINT, temperature and supply (after the DAC: its outputs) */
+    if (!hal_adc_scan_init()) {
+        return false;
+    }
+#endif
+    
+#if BOARD_LOG_PERIOD_S != 0
+    /* RTC wakeup, the logging period (through STOP) */
+    if (!hal_rtc_wakeup_init(BOARD_LOG_PERIOD_S)) {
+        return false;
+    }
+#endif
+    
+#if BOARD_SD_LOG_ENABLE
+    /* SD card logger: an empty slot is not an error, the log then waits
+     * for HOST_CMD_SD_LOG */
+    if (!sd_log_init()) {
+        return false;
+    }
+#if BOARD_SD_LOG_AUTOSTART
+    (void)sd_log_start();
+#endif
+#endif
+    
+#if BOARD_FLASH_LOG_ENABLE
+    /* Flash capture: newest page found, waits for HOST_CMD_FLASH_CAPTURE */
+    if (!flash_log_init()) {
+        return false;
+    }
+#endif
+    
+#if BOARD_FW_UPDATE_ENABLE
+    /* Firmware update: idle until HOST_CMD_FW_UPDATE begins one */
+    if (!fw_update_init()) {
+        return false;
+    }
+#endif
+    
+#if BOARD_PVD_SAVE_ENABLE
+    /* Brown-out save (after the flash log: it flushes it) */
+    if (!hal_pvd_init()) {
+        return false;
+    }
+#endif
+    
+#if BOARD_UART_STREAM_ENABLE
+    /* UART stream: receiving commands from here on */
+    if (!uart_stream_init()) {
+        return false;
+    }
+#endif
+    
+#if BOARD_USB_STREAM_ENABLE
+    /* USB device last: enumeration runs from its interrupt from here on */
+    if (!usb_stream_init()) {
+        return false;
+    }
+#endif
+    
     return true;
 }
 
@@ -119,20 +418,42 @@ static bool main_init_app(void)
         return false;
     }
     
+    /* Start I2C slave listening first: the master gets a warming-up status
+     * while the sensor is brought up by the sampling state machine */
+    if (!i2c_slave_start()) {
+        return false;
+    }
+    
     /* Start sensor sampling */
+#if BOARD_SENSOR_MUX_CHANNELS != 0
+    if (!sensor_array_start()) {
+        return false;
+    }
+#elif BOARD_LOG_PERIOD_S != 0
+    /* Low-rate logging: bring-up and a first sample, then one per wakeup */
+    if (!sensor_sampling_start_single()) {
+        return false;
+    }
+#else
     if (!sensor_sampling_start()) {
         return false;
     }
+#endif
     
     /* Start timer to trigger sensor sampling interrupts */
     if (!hal_tim2_start()) {
         return false;
     }
     
-    /* Start I2C slave listening */
-    if (!i2c_slave_start()) {
-        return false;
-    }
+#if BOARD_CLOCK_TRIM_ENABLE
+    /* HSI measured against the sampling timebase from here on */
+    clock_trim_init();
+#endif
+    
+#if BOARD_ENERGY_ENABLE
+    /* Residency counted from here */
+    energy_init();
+#endif
     
     return true;
 }
@@ -143,22 +464,57 @@ static bool main_init_app(void)
 
 void main_error_handler(uint32_t error_code)
 {
-    /* Error handling implementation */
-    /* For now, enter infinite loop */
+    /* Warm restart: the boot is tens of milliseconds (cached sensor PROM,
+     * calibrations in EEPROM), the EEPROM boot record keeps the reset
+     * cause (SFTRSTF here, IWDGRSTF for a watchdog reset) */
+#if BOARD_FAULT_CAPTURE_ENABLE
+    /* With the code and the caller kept for the next boot */
+    fault_capture_error(error_code, (uint32_t)__builtin_return_address(0));
+#else
     (void)error_code;
     
-    while (1) {
-        /* Error state - could blink LED, send error message, etc. */
-        HAL_Delay(1000);
+    __disable_irq();
+    NVIC_SystemReset();
+#endif
+}
+
+#if BOARD_I2C1_WAKEUP_STOP
+bool main_stop_if_idle(void)
+{
+    if (!i2c_slave_is_idle() || !main_stop_allowed()) {
+        return false;
     }
+    
+    main_enter_stop();
+    return true;
 }
+#endif
 
 int main(void)
 {
+    app_boot_times_t boot_times = {0};
+    
     /* ========================================================================
      * INITIALIZATION SEQUENCE
      * ======================================================================== */
     
+#if BOARD_FAULT_CAPTURE_ENABLE
+    /* 0. Take over the fault record of the previous boot before anything
+     *    can fault again */
+    fault_init();
+#endif
+#if BOARD_WARM_RESTART_ENABLE
+    /* Warm or cold: decided before the drivers keep state in .noinit */
+    warm_restart_init();
+#endif
+    
+#if BOARD_RAM_VECTORS_ENABLE
+    /* Vectors to RAM before the first interrupt is enabled, on the boot
+     * modes' handlers */
+    hal_vectors_init();
+    main_route_vectors();
+#endif
+    
     /* 1. Initialize HAL */
     main_init_hal(); // Either to be autogenerated or completely removed 
     
@@ -166,6 +522,14 @@ int main(void)
     if (!board_init()) {
         main_error_handler(1);
     }
+    boot_times.board_us = board_get_uptime_us();
+    
+#if BOARD_IWDG_ENABLE
+    /* Watchdog from here on: a bring-up that hangs resets too */
+    if (!hal_iwdg_init()) {
+        main_error_handler(1);
+    }
+#endif
     
     /* 3. Initialize HAL peripherals (I2C, DAC, TIM configurations) */
     /* Note: HAL MSP callbacks in hal_config.c handle GPIO configuration */
@@ -174,11 +538,36 @@ int main(void)
     if (!main_init_drivers()) {
         main_error_handler(2);
     }
+    boot_times.drivers_us = board_get_uptime_us();
     
     /* 5. Initialize application */
     if (!main_init_app()) {
         main_error_handler(3);
     }
+    boot_times.app_us = board_get_uptime_us();
+    app_set_boot_times(&boot_times);
+    TRACE(TRACE_BOOT, boot_times.drivers_us, boot_times.app_us);
+    
+#if BOARD_RTOS_ENABLE
+    /* The tasks take over the loop below; returns only on failure */
+    if (!rtos_start()) {
+        main_error_handler(6);
+    }
+#endif
+    
+#if BOARD_PURE_ISR
+    /* Everything from here on runs in handlers, the main loop work in
+     * BOARD_APP_IRQn: the core sleeps again straight from the last one.
+     * Pended once for the events raised during init */
+    HAL_NVIC_SetPriority(BOARD_APP_IRQn, BOARD_IRQ_PRIO_APP, 0);
+    HAL_NVIC_EnableIRQ(BOARD_APP_IRQn);
+    NVIC_SetPendingIRQ(BOARD_APP_IRQn);
+    HAL_PWR_EnableSleepOnExit();
+    while (1) {
+        PERF_SLEEP();
+        HAL_PWR_EnterSLEEPMode(PWR_MAINREGULATOR_ON, PWR_SLEEPENTRY_WFI);
+    }
+#endif
     
     /* ========================================================================
      * MAIN APPLICATION LOOP
@@ -189,11 +578,36 @@ int main(void)
         /* The actual work is done in interrupt handlers and 
          * application callbacks */
         
-        /* Call application main loop function */
+        /* Call application main loop function (only flagged work), at
+         * the profile clock */
+        CLOCK_SCALE_BOOST();
         app_main_loop();
         
-        /* Enter low-power mode if no work to do */
-        HAL_PWR_EnterSLEEPMode(PWR_MAINREGULATOR_ON, PWR_SLEEPENTRY_WFI);
+        /* Enter low-power mode if no work to do. Masked, so an event raised
+         * after the check still wakes WFI. With sleep-on-exit the core goes
+         * back to sleep after each interrupt (ticks, transfers) until one
+         * raises an app event, which cancels it */
+        __disable_irq();
+        if (!app_events_pending()) {
+            CLOCK_SCALE_IDLE();
+#if BOARD_I2C1_WAKEUP_STOP
+            if (!i2c_slave_is_idle()) {
+                /* Transfer in flight: back here after each interrupt, so
+                 * STOP is entered as soon as it ends */
+                HAL_PWR_DisableSleepOnExit();
+                PERF_SLEEP();
+                HAL_PWR_EnterSLEEPMode(PWR_MAINREGULATOR_ON, PWR_SLEEPENTRY_WFI);
+            } else if (main_stop_allowed()) {
+                main_enter_stop();
+            } else
+#endif
+            {
+                HAL_PWR_EnableSleepOnExit();
+                PERF_SLEEP();
+                HAL_PWR_EnterSLEEPMode(PWR_MAINREGULATOR_ON, PWR_SLEEPENTRY_WFI);
+            }
+        }
+        __enable_irq();
     }
     
     /* Should never reach here */
@@ -204,16 +618,158 @@ int main(void)
  * INTERRUPT HANDLERS
  * ============================================================================ */
 
+#if BOARD_FAULT_CAPTURE_ENABLE
+/**
+ * @brief HardFault handler
+ * 
+ * Passes the exception frame, on the stack EXC_RETURN bit 2 names (PSP
+ * for RTOS tasks), to fault_capture(), which keeps it and resets. Naked:
+ * no push of its own onto a stack that may have just overflowed.
+ */
+__attribute__((naked)) void HardFault_Handler(void)
+{
+    __asm volatile(
+        "movs r0, #4          \n"
+        "mov  r1, lr          \n"
+        "tst  r0, r1          \n"
+        "beq  1f              \n"
+        "mrs  r0, psp         \n"
+        "b    2f              \n"
+        "1:                   \n"
+        "mrs  r0, msp         \n"
+        "2:                   \n"
+        "ldr  r2, =fault_capture \n"
+        "bx   r2              \n"
+        ".ltorg               \n"
+    );
+}
+#endif
+
+#if BOARD_TIMEBASE == BOARD_TIMEBASE_TIM2
+/**
+ * @brief TIM2 update: sampling tick (every 2ms at the boot rate)
+ */
+static void main_tim2_tick(void)
+{
+    hal_tim2_schedule_update();
+    PROF_BEGIN(PROF_SITE_SAMPLING_TICK);
+    sensor_sampling_timer_isr();
+    PROF_END(PROF_SITE_SAMPLING_TICK);
+    sensor_array_timer_isr();  /* No-op unless the mux rig is running */
+}
+
+/**
+ * @brief TIM2 CH1 compare: the one-shot scheduled through
+ *        hal_tim2_schedule_us() (sensor conversion complete)
+ */
+static void main_tim2_compare(void)
+{
+    hal_tim2_schedule_cancel();  /* One-shot */
+    sensor_sampling_conversion_isr();
+}
+
+#if BOARD_RAM_VECTORS_ENABLE
+/**
+ * @brief TIM2 handler body for one mode, folded at each constant call site
+ * 
+ * @param sampler Sampler step on the update (tick-driven, not the sync input)
+ * @param array Mux array scan on the update (sensor_array_start())
+ */
+static inline __attribute__((always_inline)) void main_tim2_irq(bool sampler, bool array)
+{
+    TIM_TypeDef *tim = BOARD_TIM2_PERIPH;
+    
+    PERF_ISR_BEGIN(PERF_ISR_TICK);
+    CLOCK_SCALE_BOOST();
+#if BOARD_PERF_ENABLE
+    if ((tim->SR & TIM_SR_UIF) != 0U) {
+        PERF_WAKE(PERF_ISR_TICK, tim->CNT);
+    }
+#endif
+    hal_tim2_count_update();  /* Before the flag is cleared */
+    if (LL_TIM_IsActiveFlag_CC1(tim) && LL_TIM_IsEnabledIT_CC1(tim)) {
+        LL_TIM_ClearFlag_CC1(tim);
+        main_tim2_compare();
+    }
+    if (LL_TIM_IsActiveFlag_UPDATE(tim) && LL_TIM_IsEnabledIT_UPDATE(tim)) {
+        LL_TIM_ClearFlag_UPDATE(tim);
+        hal_tim2_schedule_update();
+        if (sampler) {
+            PROF_BEGIN(PROF_SITE_SAMPLING_TICK);
+            sensor_sampling_timer_isr();
+            PROF_END(PROF_SITE_SAMPLING_TICK);
+        }
+        if (array) {
+            sensor_array_timer_isr();
+        }
+    }
+    PERF_ISR_END(PERF_ISR_TICK);
+}
+
+/* The other three modes; TIM2_IRQHandler() below is the boot one (tick
+ * sampling, array stopped) */
+static void main_tim2_irq_array(void)
+{
+    main_tim2_irq(true, true);
+}
+
+static void main_tim2_irq_sync(void)
+{
+    main_tim2_irq(false, false);
+}
+
+static void main_tim2_irq_sync_array(void)
+{
+    main_tim2_irq(false, true);
+}
+#endif
+
 /**
  * @brief TIM2 interrupt handler
  * 
  * This interrupt is triggered every 2ms to sample the pressure sensor.
  * The actual sensor reading is handled by the sensor_sampling module
  * using a state machine.
+ * 
+ * With BOARD_LL_HOTPATH only the two enabled sources are checked (CH1
+ * compare first, then update, as HAL_TIM_IRQHandler() orders them) instead
+ * of every TIM flag.
+ *
+ * The counter restarts from 0 at the update and counts microseconds, so on
+ * a tick that woke the core it is the wake-up latency (perf.h).
+ * 
+ * With BOARD_RAM_VECTORS_ENABLE the tick-sampling handler only: the other
+ * modes run their own (main_route_vectors()).
  */
 void TIM2_IRQHandler(void)
 {
+#if BOARD_RAM_VECTORS_ENABLE
+    main_tim2_irq(true, false);
+#else
+    PERF_ISR_BEGIN(PERF_ISR_TICK);
+    CLOCK_SCALE_BOOST();
+#if BOARD_PERF_ENABLE
+    if ((BOARD_TIM2_PERIPH->SR & TIM_SR_UIF) != 0U) {
+        PERF_WAKE(PERF_ISR_TICK, BOARD_TIM2_PERIPH->CNT);
+    }
+#endif
+    hal_tim2_count_update();  /* Before the flag is cleared */
+#if BOARD_LL_HOTPATH
+    TIM_TypeDef *tim = BOARD_TIM2_PERIPH;
+    
+    if (LL_TIM_IsActiveFlag_CC1(tim) && LL_TIM_IsEnabledIT_CC1(tim)) {
+        LL_TIM_ClearFlag_CC1(tim);
+        main_tim2_compare();
+    }
+    if (LL_TIM_IsActiveFlag_UPDATE(tim) && LL_TIM_IsEnabledIT_UPDATE(tim)) {
+        LL_TIM_ClearFlag_UPDATE(tim);
+        main_tim2_tick();
+    }
+#else
     HAL_TIM_IRQHandler(&htim2);
+#endif
+    PERF_ISR_END(PERF_ISR_TICK);
+#endif /* BOARD_RAM_VECTORS_ENABLE */
 }
 
 /**
@@ -225,30 +781,426 @@ void TIM2_IRQHandler(void)
 void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
 {
     if (htim->Instance == BOARD_TIM2_PERIPH) {
-        sensor_sampling_timer_isr();
+        main_tim2_tick();
     }
 }
 
+/**
+ * @brief TIM2 output compare callback
+ * 
+ * Called by HAL when the one-shot CH1 compare scheduled through
+ * hal_tim2_schedule_us() fires (sensor conversion complete).
+ */
+void HAL_TIM_OC_DelayElapsedCallback(TIM_HandleTypeDef *htim)
+{
+    if (htim->Instance == BOARD_TIM2_PERIPH &&
+        htim->Channel == HAL_TIM_ACTIVE_CHANNEL_1) {
+        main_tim2_compare();
+    }
+}
+
+#else /* BOARD_TIMEBASE == BOARD_TIMEBASE_LPTIM1 */
+
+/**
+ * @brief LPTIM1 interrupt handler (sampling timebase, also wakes from STOP)
+ */
+void LPTIM1_IRQHandler(void)
+{
+    PERF_ISR_BEGIN(PERF_ISR_TICK);
+    hal_lptim1_irq_handler();
+    PERF_ISR_END(PERF_ISR_TICK);
+}
+
+/**
+ * @brief LPTIM1 autoreload match callback (tick)
+ */
+void HAL_LPTIM_AutoReloadMatchCallback(LPTIM_HandleTypeDef *hlptim)
+{
+    (void)hlptim;
+    hal_tim2_schedule_update();
+    PROF_BEGIN(PROF_SITE_SAMPLING_TICK);
+    sensor_sampling_timer_isr();
+    PROF_END(PROF_SITE_SAMPLING_TICK);
+    sensor_array_timer_isr();  /* No-op unless the mux rig is running */
+}
+
+/**
+ * @brief LPTIM1 compare match callback
+ * 
+ * Called when the one-shot scheduled through hal_tim2_schedule_us() fires
+ * (sensor conversion complete).
+ */
+void HAL_LPTIM_CompareMatchCallback(LPTIM_HandleTypeDef *hlptim)
+{
+    (void)hlptim;
+    hal_tim2_schedule_cancel();  /* One-shot */
+    sensor_sampling_conversion_isr();
+}
+#endif
+
+#if !BOARD_RTOS_ENABLE
+/**
+ * @brief PendSV handler (bottom half)
+ * 
+ * Lowest priority. Pended by the sampling ISRs once raw D1/D2 are captured;
+ * runs compensation and fan-out outside TIM2/I2C2 priority. RTOS builds
+ * give PendSV to the kernel and run the bottom half in the sampler task.
+ */
+void PendSV_Handler(void)
+{
+    PERF_ISR_BEGIN(PERF_ISR_BOTTOM);
+    sensor_sampling_bottom_half();
+    PERF_ISR_END(PERF_ISR_BOTTOM);
+}
+#endif
+
 /* ============================================================================
- * I2C1 INTERRUPT HANDLERS (I2C Slave)
+ * I2C2 INTERRUPT HANDLER (Pressure Sensor)
  * ============================================================================ */
 
 /**
- * @brief I2C1 event interrupt handler
+ * @brief I2C2 interrupt handler
  * 
- * Handles I2C1 event interrupts for slave mode operation.
+ * Drives the asynchronous sensor transfers started by the sampling
+ * state machine. STM32L0 has one vector for I2C2 events and errors.
  */
-void I2C1_EV_IRQHandler(void)
+void I2C2_IRQHandler(void)
 {
-    i2c_slave_irq_handler();
+    PERF_ISR_BEGIN(PERF_ISR_SENSOR_BUS);
+#if BOARD_LL_HOTPATH
+    ms58_hal_ll_irq_handler(&hi2c2);
+#else
+    HAL_I2C_EV_IRQHandler(&hi2c2);
+    HAL_I2C_ER_IRQHandler(&hi2c2);
+#endif
+    PERF_ISR_END(PERF_ISR_SENSOR_BUS);
+}
+
+#if BOARD_I2C3_MUX_CHANNELS != 0
+/**
+ * @brief I2C3 interrupt handler (second probe bus, same transport as I2C2)
+ */
+void I2C3_IRQHandler(void)
+{
+    PERF_ISR_BEGIN(PERF_ISR_SENSOR_BUS);
+#if BOARD_LL_HOTPATH
+    ms58_hal_ll_irq_handler(&hi2c3);
+#else
+    HAL_I2C_EV_IRQHandler(&hi2c3);
+    HAL_I2C_ER_IRQHandler(&hi2c3);
+#endif
+    PERF_ISR_END(PERF_ISR_SENSOR_BUS);
 }
+#endif
+
+/**
+ * @brief I2C error callback
+ * 
+ * HAL has a single error callback shared by all I2C peripherals,
+ * so it is routed here to the driver owning the handle.
+ */
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
+{
+    if (hi2c->Instance == BOARD_I2C1_PERIPH) {
+        i2c_slave_error_callback(hi2c);
+    } else if (hi2c->Instance == BOARD_I2C2_PERIPH || hi2c->Instance == BOARD_I2C3_PERIPH) {
+        ms58_hal_error_callback(hi2c);
+    }
+}
+
+/* ============================================================================
+ * I2C1 INTERRUPT HANDLER (I2C Slave)
+ * ============================================================================ */
 
 /**
- * @brief I2C1 error interrupt handler
+ * @brief I2C1 interrupt handler
  * 
- * Handles I2C1 error interrupts for slave mode operation.
+ * STM32L0 has one vector for I2C1 events and errors (I2C1_IRQHandler in
+ * startup_stm32l072xx.s).
  */
-void I2C1_ER_IRQHandler(void)
+void I2C1_IRQHandler(void)
 {
+    PERF_ISR_BEGIN(PERF_ISR_SLAVE);
+    CLOCK_SCALE_BOOST();  /* Slave transfers at the profile clock */
     i2c_slave_irq_handler();
+    PERF_ISR_END(PERF_ISR_SLAVE);
+}
+
+#if BOARD_I2C1_SLAVE_DMA && !BOARD_I2C1_SLAVE_LL
+/**
+ * @brief DMA1 channel 2/3 interrupt handler
+ * 
+ * Completion of I2C1 slave TX (channel 2) and RX (channel 3) frames.
+ */
+void DMA1_Channel2_3_IRQHandler(void)
+{
+    PERF_ISR_BEGIN(PERF_ISR_SLAVE);
+    hal_i2c1_dma_irq_handler();
+    PERF_ISR_END(PERF_ISR_SLAVE);
+}
+#endif
+
+#if BOARD_ADC_SCAN_PERIOD_MS != 0
+/**
+ * @brief DMA1 channel 1 interrupt handler
+ * 
+ * ADC background scan complete: the main loop collects it.
+ */
+void DMA1_Channel1_IRQHandler(void)
+{
+    PERF_ISR_BEGIN(PERF_ISR_DMA);
+    hal_adc_dma_irq_handler();
+    PERF_ISR_END(PERF_ISR_DMA);
+}
+#endif
+
+#if BOARD_DAC_STREAM_ENABLE || BOARD_TRACE_ENABLE || BOARD_UART_STREAM_ENABLE || BOARD_DMA_COPY_ENABLE
+/**
+ * @brief DMA1 channel 4/5/6/7 interrupt handler
+ * 
+ * DAC stream half/full transfer (channel 4): refills the played half.
+ * Trace output transfer complete (channel 7): sends the next records.
+ * UART stream RX half/full buffer (channel 5), TX complete (channel 7).
+ * Memory copy complete (channel 6): completes it, starts the next one.
+ */
+void DMA1_Channel4_5_6_7_IRQHandler(void)
+{
+    PERF_ISR_BEGIN(PERF_ISR_DMA);
+#if BOARD_DAC_STREAM_ENABLE
+    hal_dac1_dma_irq_handler();
+#endif
+#if BOARD_TRACE_ENABLE
+    trace_dma_irq_handler();
+#endif
+#if BOARD_UART_STREAM_ENABLE
+    uart_stream_dma_irq_handler();
+#endif
+#if BOARD_DMA_COPY_ENABLE
+    dma_copy_irq_handler();
+#endif
+    PERF_ISR_END(PERF_ISR_DMA);
+}
+#endif
+
+#if BOARD_UART_STREAM_ENABLE
+/**
+ * @brief USART2 interrupt handler
+ * 
+ * UART stream RX line idle after a frame: decodes what the DMA wrote.
+ */
+void USART2_IRQHandler(void)
+{
+    PERF_ISR_BEGIN(PERF_ISR_DMA);
+    uart_stream_irq_handler();
+    PERF_ISR_END(PERF_ISR_DMA);
+}
+#endif
+
+#if BOARD_USB_STREAM_ENABLE
+/* ============================================================================
+ * USB INTERRUPT HANDLER (Sample Stream)
+ * ============================================================================ */
+
+/**
+ * @brief USB interrupt handler
+ * 
+ * Enumeration, CDC requests and data IN completions of the sample stream.
+ */
+void USB_IRQHandler(void)
+{
+    PERF_ISR_BEGIN(PERF_ISR_OTHER);
+    usb_stream_irq_handler();
+    PERF_ISR_END(PERF_ISR_OTHER);
+}
+#endif
+
+#if BOARD_COMP_ALARM_ENABLE
+/* ============================================================================
+ * COMP2 INTERRUPT HANDLER (Analog Watchdog)
+ * ============================================================================ */
+
+/**
+ * @brief ADC1/COMP interrupt handler
+ * 
+ * COMP2 output rising edge (EXTI line 22). ADC1 is polled and raises none.
+ */
+void ADC1_COMP_IRQHandler(void)
+{
+    PERF_ISR_BEGIN(PERF_ISR_OTHER);
+    hal_comp_alarm_irq_handler();
+    PERF_ISR_END(PERF_ISR_OTHER);
+}
+
+/**
+ * @brief COMP trigger callback
+ * 
+ * Called by HAL on the armed comparator edge.
+ */
+void HAL_COMP_TriggerCallback(COMP_HandleTypeDef *hcomp)
+{
+    if (hcomp->Instance == BOARD_COMP_PERIPH) {
+        app_alarm_isr();
+    }
+}
+#endif
+
+#if BOARD_SYNC_IN_ENABLE
+/* ============================================================================
+ * EXTI INTERRUPT HANDLER (External Sync Input)
+ * ============================================================================ */
+
+/**
+ * @brief EXTI lines 0-1: sync input edge
+ * 
+ * Stamped before anything else, then the sampler step it replaces the
+ * tick with. No HAL dispatch on this path.
+ */
+void EXTI0_1_IRQHandler(void)
+{
+    uint32_t edge_us = hal_tim2_get_timestamp_us();
+    PERF_ISR_BEGIN(PERF_ISR_TICK);
+    
+    hal_sync_in_clear();
+    sensor_sampling_sync_isr(edge_us);
+    PERF_ISR_END(PERF_ISR_TICK);
+}
+
+#if BOARD_RAM_VECTORS_ENABLE
+/**
+ * @brief EXTI lines 0-1 while the sync input is not selected
+ * 
+ * Only an edge latched as the input was being switched off gets here.
+ */
+static void main_exti0_1_idle(void)
+{
+    hal_sync_in_clear();
+}
+#endif
+#endif
+
+#if BOARD_RAM_VECTORS_ENABLE
+/* ============================================================================
+ * VECTOR ROUTING (Vector Table in RAM)
+ * ============================================================================ */
+
+void main_route_vectors(void)
+{
+    static const hal_isr_t tim2[2][2] = {
+        { TIM2_IRQHandler,    main_tim2_irq_array },
+        { main_tim2_irq_sync, main_tim2_irq_sync_array },
+    };
+    bool external = sensor_sampling_get_sync_input();
+    
+    hal_vectors_set(TIM2_IRQn, tim2[external ? 1 : 0][sensor_array_is_running() ? 1 : 0]);
+#if BOARD_SYNC_IN_ENABLE
+    hal_vectors_set(EXTI0_1_IRQn, external ? EXTI0_1_IRQHandler : main_exti0_1_idle);
+#endif
+}
+#endif
+
+/* ============================================================================
+ * FLASH INTERRUPT HANDLER (Data EEPROM Queue)
+ * ============================================================================ */
+
+/**
+ * @brief Flash interface interrupt handler
+ * 
+ * End of a data EEPROM word (EOP or an error): the next queued word
+ * starts here.
+ */
+void FLASH_IRQHandler(void)
+{
+    PERF_ISR_BEGIN(PERF_ISR_FLASH);
+    eeprom_irq_handler();
+    PERF_ISR_END(PERF_ISR_FLASH);
+}
+
+#if BOARD_PURE_ISR
+/* ============================================================================
+ * APPLICATION INTERRUPT HANDLER (BOARD_PURE_ISR)
+ * ============================================================================ */
+
+/**
+ * @brief Main loop work (BOARD_APP_IRQn, pended by event_flags_set())
+ * 
+ * One pass of the flagged work; a flag raised meanwhile pends it again.
+ */
+void TSC_IRQHandler(void)
+{
+    PERF_ISR_BEGIN(PERF_ISR_APP);
+    CLOCK_SCALE_BOOST();
+    app_main_loop();
+    CLOCK_SCALE_IDLE();
+    PERF_ISR_END(PERF_ISR_APP);
+}
+#endif
+
+/* ============================================================================
+ * TIM21 INTERRUPT HANDLER (Microsecond Timebase)
+ * ============================================================================ */
+
+/**
+ * @brief TIM21 interrupt handler
+ * 
+ * Counter wrap, deadline compare or sleeping-wait compare: the due
+ * deadline callbacks run here.
+ */
+void TIM21_IRQHandler(void)
+{
+    PERF_ISR_BEGIN(PERF_ISR_TIMEBASE);
+    timebase_irq_handler();
+    PERF_ISR_END(PERF_ISR_TIMEBASE);
+}
+
+#if BOARD_PVD_SAVE_ENABLE
+/* ============================================================================
+ * PVD INTERRUPT HANDLER (Brown-out Save)
+ * ============================================================================ */
+
+/**
+ * @brief PVD through EXTI line 16: VDD fell through BOARD_PVD_LEVEL
+ * 
+ * Saves, then stays here: the main loop may have had a flash operation
+ * cut short. Either the supply goes (BOR), or it comes back and the board
+ * restarts clean.
+ */
+void PVD_IRQHandler(void)
+{
+    hal_pvd_clear();
+    app_power_fail_isr();
+    
+    while (hal_pvd_is_low()) {
+    }
+    __disable_irq();
+    NVIC_SystemReset();
+}
+#endif
+
+#if BOARD_LOG_PERIOD_S != 0
+/* ============================================================================
+ * RTC INTERRUPT HANDLER (Low-Rate Logging)
+ * ============================================================================ */
+
+/**
+ * @brief RTC interrupt handler
+ * 
+ * Wakeup timer (EXTI line 20), also wakes the core from STOP.
+ */
+void RTC_IRQHandler(void)
+{
+    PERF_ISR_BEGIN(PERF_ISR_OTHER);
+    hal_rtc_irq_handler();
+    PERF_ISR_END(PERF_ISR_OTHER);
+}
+
+/**
+ * @brief RTC wakeup timer callback
+ * 
+ * Called by HAL every BOARD_LOG_PERIOD_S seconds.
+ */
+void HAL_RTCEx_WakeUpTimerEventCallback(RTC_HandleTypeDef *hrtc)
+{
+    (void)hrtc;
+    app_log_wakeup_isr();
 }
+#endif
@@ -2,6 +2,7 @@
 #define MAIN_H
 
 #include <stdint.h>
+#include <stdbool.h>
 /**
  * @file main.h
  * @brief Main application entry point and initialization
@@ -32,13 +33,34 @@ int main(void);
 /**
  * @brief Error handler for fatal errors
  * 
- * Called when a critical error occurs. This function should handle
- * the error appropriately (e.g., enter error state, blink LED, etc.)
+ * Called when a critical error occurs: resets the MCU at once (warm
+ * restart). Does not return.
  * 
  * @param error_code Error code indicating the type of error
  */
 void main_error_handler(uint32_t error_code);
 
+/**
+ * @brief Enter STOP if no transfer, conversion or stream would be halted
+ * 
+ * The super-loop's STOP path, for the RTOS tickless idle. Call with
+ * interrupts masked; returns once woken, on the profile clock. Only built
+ * with BOARD_I2C1_WAKEUP_STOP.
+ * 
+ * @return true if the core was in STOP, false if STOP was not allowed
+ */
+bool main_stop_if_idle(void);
+
+/**
+ * @brief Install the handlers of the modes now set (vector table in RAM)
+ * 
+ * Each mode of the sampling tick (tick-driven or sync input, mux array
+ * running or not) and of the sync input has a handler of its own: the
+ * sampler and the array call this after changing mode, so no handler tests
+ * the mode. Thread context. Only built with BOARD_RAM_VECTORS_ENABLE.
+ */
+void main_route_vectors(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,120 @@
+/**
+ * @file memcpy.c
+ * @brief Minimal memcpy / memmove implementations for embedded systems
+ *
+ * Needed with -nostdlib: GCC calls memcpy for struct copies (sensor_data_t,
+ * the stats snapshots) and HAL init structs. When source and destination
+ * share their alignment, bytes go up to a word boundary and the middle is
+ * copied four words per pass (one LDM / STM pair on Thumb-1); otherwise
+ * Cortex-M0+ (no unaligned word access) copies bytes.
+ *
+ * Built with RUNTIME_CFLAGS (Makefile): the byte loops must not be turned
+ * back into a memcpy call.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+void *memcpy(void *dst, const void *src, size_t n)
+{
+    unsigned char *d = (unsigned char *)dst;
+    const unsigned char *s = (const unsigned char *)src;
+    
+    if ((((uintptr_t)d ^ (uintptr_t)s) & 3U) == 0U) {
+        uint32_t *wd;
+        const uint32_t *ws;
+        
+        /* Head: up to 3 bytes to a word boundary (same for both) */
+        while (n > 0U && ((uintptr_t)d & 3U) != 0U) {
+            *d++ = *s++;
+            n--;
+        }
+        
+        wd = (uint32_t *)d;
+        ws = (const uint32_t *)s;
+        while (n >= 16U) {
+            /* All loads before the stores: one LDM and one STM */
+            uint32_t w0 = ws[0];
+            uint32_t w1 = ws[1];
+            uint32_t w2 = ws[2];
+            uint32_t w3 = ws[3];
+            
+            wd[0] = w0;
+            wd[1] = w1;
+            wd[2] = w2;
+            wd[3] = w3;
+            wd += 4;
+            ws += 4;
+            n -= 16U;
+        }
+        while (n >= 4U) {
+            *wd++ = *ws++;
+            n -= 4U;
+        }
+        d = (unsigned char *)wd;
+        s = (const unsigned char *)ws;
+    }
+    
+    /* Tail, or everything when the alignments differ */
+    while (n--) {
+        *d++ = *s++;
+    }
+    return dst;
+}
+
+void *memmove(void *dst, const void *src, size_t n)
+{
+    unsigned char *d = (unsigned char *)dst;
+    const unsigned char *s = (const unsigned char *)src;
+    
+    /* Destination below the source, or no overlap: a forward copy never
+     * overwrites bytes it has yet to read */
+    if ((uintptr_t)d <= (uintptr_t)s || (uintptr_t)d >= (uintptr_t)s + n) {
+        return memcpy(dst, src, n);
+    }
+    
+    /* Overlapping with the destination above: copy from the end */
+    d += n;
+    s += n;
+    if ((((uintptr_t)d ^ (uintptr_t)s) & 3U) == 0U) {
+        uint32_t *wd;
+        const uint32_t *ws;
+        
+        while (n > 0U && ((uintptr_t)d & 3U) != 0U) {
+            *--d = *--s;
+            n--;
+        }
+        
+        wd = (uint32_t *)d;
+        ws = (const uint32_t *)s;
+        while (n >= 16U) {
+            uint32_t w0;
+            uint32_t w1;
+            uint32_t w2;
+            uint32_t w3;
+            
+            ws -= 4;
+            wd -= 4;
+            w0 = ws[0];
+            w1 = ws[1];
+            w2 = ws[2];
+            w3 = ws[3];
+            wd[0] = w0;
+            wd[1] = w1;
+            wd[2] = w2;
+            wd[3] = w3;
+            n -= 16U;
+        }
+        while (n >= 4U) {
+            *--wd = *--ws;
+            n -= 4U;
+        }
+        d = (unsigned char *)wd;
+        s = (const unsigned char *)ws;
+    }
+    
+    while (n--) {
+        *--d = *--s;
+    }
+    return dst;
+}
@@ -1,16 +1,51 @@
 /**
  * @file memset.c
  * @brief Minimal memset implementation for embedded systems
+ *
+ * The build links with -nostdlib, so this is the only memset: GCC also
+ * calls it for zeroed structs and arrays. Cortex-M0+ has no unaligned word
+ * access, so bytes go up to a word boundary, words (four per pass, one STM)
+ * fill the middle, and bytes finish the tail.
+ *
+ * Built with RUNTIME_CFLAGS (Makefile): the byte loops must not be turned
+ * back into a memset call.
  */
 
 #include <stddef.h>
+#include <stdint.h>
 
 void *memset(void *s, int c, size_t n)
 {
     unsigned char *p = (unsigned char *)s;
+    
+    /* Head: up to 3 bytes to a word boundary */
+    while (n > 0U && ((uintptr_t)p & 3U) != 0U) {
+        *p++ = (unsigned char)c;
+        n--;
+    }
+    
+    if (n >= 4U) {
+        uint32_t *w = (uint32_t *)p;
+        uint32_t word = (uint32_t)(unsigned char)c * 0x01010101UL;
+        
+        while (n >= 16U) {
+            w[0] = word;
+            w[1] = word;
+            w[2] = word;
+            w[3] = word;
+            w += 4;
+            n -= 16U;
+        }
+        while (n >= 4U) {
+            *w++ = word;
+            n -= 4U;
+        }
+        p = (unsigned char *)w;
+    }
+    
+    /* Tail */
     while (n--) {
         *p++ = (unsigned char)c;
     }
     return s;
 }
-
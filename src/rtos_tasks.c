@@ -0,0 +1,262 @@
+/**
+ * @file rtos_tasks.c
+ * @brief FreeRTOS execution model (BOARD_RTOS_ENABLE builds)
+ *
+ * Tasks, stacks and the idle task are static. Priorities follow the
+ * deadlines: the sampler task only has to finish one captured pair before
+ * the capture ring fills up (SENSOR_RAW_RING_SIZE ticks), the host task
+ * answers the master, the background task has no deadline at all.
+ *
+ * The HAL tick is the kernel tick: HAL_InitTick() leaves SysTick alone
+ * (the kernel starts it with the scheduler) and HAL_GetTick() returns the
+ * tick count, 0 until then.
+ *
+ * Tickless idle (BOARD_RTOS_TICKLESS): with every task blocked for at
+ * least configEXPECTED_IDLE_TIME_BEFORE_SLEEP ticks, the idle task stops
+ * SysTick and enters STOP, woken by the LPTIM1 timebase (next sampling
+ * tick, conversion one-shot or a compare set to the kernel deadline) or
+ * an I2C1 address match. The time slept is measured on the LPTIM1
+ * timestamp and stepped into the tick count.
+ */
+
+#include "rtos_tasks.h"
+#include "main.h"
+#include "app.h"
+#include "sensor_sampling.h"
+#include "board_config.h"
+#include "hal_config.h"
+#include "perf.h"
+#include "stm32l0xx_hal.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+/* Above the idle task (tskIDLE_PRIORITY = 0) */
+#define RTOS_PRIO_BACKGROUND  1U
+#define RTOS_PRIO_HOST        2U
+#define RTOS_PRIO_SAMPLER     3U
+
+#if RTOS_PRIO_SAMPLER >= configMAX_PRIORITIES
+#error "configMAX_PRIORITIES too small for the sampler task"
+#endif
+
+#define RTOS_ERROR  6U  /* main_error_handler() code: kernel start, stack overflow */
+#define RTOS_TICK_US  (1000000UL / configTICK_RATE_HZ)
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static StaticTask_t sampler_tcb;
+static StaticTask_t host_tcb;
+static StaticTask_t background_tcb;
+static StaticTask_t idle_tcb;
+
+static StackType_t sampler_stack[BOARD_RTOS_SAMPLER_STACK_WORDS];
+static StackType_t host_stack[BOARD_RTOS_HOST_STACK_WORDS];
+static StackType_t background_stack[BOARD_RTOS_BACKGROUND_STACK_WORDS];
+static StackType_t idle_stack[configMINIMAL_STACK_SIZE];
+
+/* NULL until created: notifications before rtos_start() are dropped */
+static TaskHandle_t sampler_task = NULL;
+static TaskHandle_t host_task = NULL;
+
+#if BOARD_RTOS_TICKLESS
+static uint32_t tickless_carry_us = 0;  /* Slept time short of a whole tick */
+#endif
+
+/* ============================================================================
+ * TASKS
+ * ============================================================================ */
+
+/**
+ * @brief Sampler task: compensation and publish of the captured pairs
+ */
+static void rtos_sampler_task(void *argument)
+{
+    (void)argument;
+
+    for (;;) {
+        /* Drains the capture ring, so one wake-up may cover several pairs */
+        sensor_sampling_bottom_half();
+        (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+/**
+ * @brief Host task: the event-driven part of the super-loop
+ */
+static void rtos_host_task(void *argument)
+{
+    (void)argument;
+
+    for (;;) {
+        app_main_loop();
+
+        /* An event raised after the check leaves the notification set */
+        if (!app_events_pending()) {
+            (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+    }
+}
+
+/**
+ * @brief Background task: slow work with no deadline
+ */
+static void rtos_background_task(void *argument)
+{
+    TickType_t last_wake = xTaskGetTickCount();
+
+    (void)argument;
+
+    for (;;) {
+        app_background_poll();
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(BOARD_RTOS_BACKGROUND_PERIOD_MS));
+    }
+}
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+bool rtos_start(void)
+{
+    sampler_task = xTaskCreateStatic(rtos_sampler_task, "sampler", BOARD_RTOS_SAMPLER_STACK_WORDS,
+                                     NULL, RTOS_PRIO_SAMPLER, sampler_stack, &sampler_tcb);
+    host_task = xTaskCreateStatic(rtos_host_task, "host", BOARD_RTOS_HOST_STACK_WORDS,
+                                  NULL, RTOS_PRIO_HOST, host_stack, &host_tcb);
+    (void)xTaskCreateStatic(rtos_background_task, "bg", BOARD_RTOS_BACKGROUND_STACK_WORDS,
+                            NULL, RTOS_PRIO_BACKGROUND, background_stack, &background_tcb);
+
+    if (sampler_task == NULL || host_task == NULL) {
+        return false;
+    }
+
+    vTaskStartScheduler();
+
+    return false;  /* Only if the idle task could not be created */
+}
+
+void rtos_sampler_notify(void)
+{
+    BaseType_t woken = pdFALSE;
+
+    if (sampler_task == NULL) {
+        return;
+    }
+
+    vTaskNotifyGiveFromISR(sampler_task, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+void rtos_host_notify(void)
+{
+    BaseType_t woken = pdFALSE;
+
+    if (host_task == NULL) {
+        return;
+    }
+
+    if (__get_IPSR() != 0U) {
+        vTaskNotifyGiveFromISR(host_task, &woken);
+        portYIELD_FROM_ISR(woken);
+    } else {
+        (void)xTaskNotifyGive(host_task);
+    }
+}
+
+#if BOARD_RTOS_TICKLESS
+void rtos_suppress_ticks_and_sleep(uint32_t expected_idle_ticks)
+{
+    uint32_t load = SysTick->LOAD + 1U;
+    uint32_t start_us;
+    uint32_t slept_us;
+    TickType_t ticks;
+    
+    /* Masked: wake-up interrupts run after the tick count is corrected */
+    __disable_irq();
+    if (eTaskConfirmSleepModeStatus() == eAbortSleep ||
+        !hal_lptim1_wake_within_us(expected_idle_ticks * RTOS_TICK_US)) {
+        __enable_irq();
+        return;
+    }
+    
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+    start_us = hal_tim2_get_timestamp_us();
+    /* Part of the current tick already counted down */
+    slept_us = (load - SysTick->VAL) / (load / RTOS_TICK_US);
+    
+    /* A tick due meanwhile is counted by its own interrupt */
+    if ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0U || !main_stop_if_idle()) {
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+        __enable_irq();
+        return;
+    }
+    
+    slept_us += hal_tim2_get_timestamp_us() - start_us + tickless_carry_us;
+    ticks = slept_us / RTOS_TICK_US;
+    if (ticks >= expected_idle_ticks) {
+        /* Woken by the deadline compare (or late, LPTIM1 resolution): the
+         * last tick goes through the tick interrupt, which unblocks the task */
+        ticks = expected_idle_ticks - 1U;
+        tickless_carry_us = 0;
+        SCB->ICSR = SCB_ICSR_PENDSTSET_Msk;
+    } else {
+        tickless_carry_us = slept_us - ticks * RTOS_TICK_US;
+    }
+    vTaskStepTick(ticks);
+    
+    /* A fresh tick from here */
+    SysTick->VAL = 0;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    __enable_irq();
+}
+#endif
+
+/* ============================================================================
+ * KERNEL HOOKS
+ * ============================================================================ */
+
+void vApplicationGetIdleTaskMemory(StaticTask_t **tcb, StackType_t **stack, uint32_t *stack_words)
+{
+    *tcb = &idle_tcb;
+    *stack = idle_stack;
+    *stack_words = configMINIMAL_STACK_SIZE;
+}
+
+void vApplicationIdleHook(void)
+{
+    /* Nothing ready: sleep until the next interrupt (at latest the tick).
+     * Masked, so the wake-up handler sees the sleep stamped */
+    __disable_irq();
+    PERF_SLEEP();
+    __WFI();
+    __enable_irq();
+}
+
+void vApplicationStackOverflowHook(TaskHandle_t task, char *name)
+{
+    (void)task;
+    (void)name;
+    main_error_handler(RTOS_ERROR);
+}
+
+/* ============================================================================
+ * HAL TICK
+ * ============================================================================ */
+
+HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority)
+{
+    /* SysTick is the kernel tick, configured by vTaskStartScheduler() */
+    (void)TickPriority;
+    return HAL_OK;
+}
+
+uint32_t HAL_GetTick(void)
+{
+    return (uint32_t)xTaskGetTickCount();
+}
@@ -0,0 +1,66 @@
+#ifndef RTOS_TASKS_H
+#define RTOS_TASKS_H
+
+/**
+ * @file rtos_tasks.h
+ * @brief FreeRTOS execution model (BOARD_RTOS_ENABLE builds)
+ *
+ * The sampling state machine keeps running in the TIM2/I2C2 handlers, so
+ * the bus timing never waits for a task. What ran in PendSV and in the
+ * super-loop runs in three statically allocated tasks instead:
+ * - sampler (highest): compensation, filter and publish of each captured
+ *   pair (sensor_sampling_bottom_half()), woken by a task notification
+ *   from the capture in the timer/I2C2 handler
+ * - host: the slave protocol side of app_main_loop() (commands, register
+ *   map, FIFO, DAC outputs), woken by every app event
+ * - background (lowest): slow work every BOARD_RTOS_BACKGROUND_PERIOD_MS
+ *   (app_background_poll(): ADC scan, calibration cache and EEPROM ring
+ *   writes), preempted by the other two
+ *
+ * Every interrupt still preempts every task; the idle task sleeps (WFI,
+ * or STOP with tickless idle, BOARD_RTOS_TICKLESS).
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Create the tasks and start the scheduler
+ *
+ * Call once, after the drivers and the application are initialized.
+ * Interrupts stay masked from the first task creation until the first
+ * task runs (FreeRTOS); notifications raised before that are picked up
+ * by the first run of each task.
+ *
+ * @return false if the scheduler could not start (does not return otherwise)
+ */
+bool rtos_start(void);
+
+/**
+ * @brief Wake the sampler task
+ *
+ * Called by the sampler capture from interrupt context. No-op before
+ * rtos_start().
+ */
+void rtos_sampler_notify(void);
+
+/**
+ * @brief Wake the host task
+ *
+ * Safe from interrupt and task context. No-op before rtos_start().
+ */
+void rtos_host_notify(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RTOS_TASKS_H */
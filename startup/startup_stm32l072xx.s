@@ -44,6 +44,10 @@ defined in linker script */
 .word  _sbss
 /* end address for the .bss section. defined in linker script */
 .word  _ebss
+/* load, start and end addresses of the .ramfunc section. defined in linker script */
+.word  _siramfunc
+.word  _sramfunc
+.word  _eramfunc
 
     .section  .text.Reset_Handler
   .weak  Reset_Handler
@@ -52,6 +56,19 @@ Reset_Handler:
    ldr   r0, =_estack
    mov   sp, r0          /* set stack pointer */
 
+/* Paint the stack for the high-water scan (pattern = BOARD_STACK_PAINT) */
+  ldr r1, =_sstack
+  ldr r2, =0xA5A5A5A5
+  b LoopPaintStack
+
+PaintStack:
+  str  r2, [r1]
+  adds r1, r1, #4
+
+LoopPaintStack:
+  cmp r1, r0
+  bcc PaintStack
+
 /* Copy the data segment initializers from flash to SRAM */
   ldr r0, =_sdata
   ldr r1, =_edata
@@ -68,6 +85,23 @@ LoopCopyDataInit:
   adds r4, r0, r3
   cmp r4, r1
   bcc CopyDataInit
+
+/* Copy the RAM-resident code from flash to SRAM */
+  ldr r0, =_sramfunc
+  ldr r1, =_eramfunc
+  ldr r2, =_siramfunc
+  movs r3, #0
+  b LoopCopyRamfunc
+
+CopyRamfunc:
+  ldr r4, [r2, r3]
+  str r4, [r0, r3]
+  adds r3, r3, #4
+
+LoopCopyRamfunc:
+  adds r4, r0, r3
+  cmp r4, r1
+  bcc CopyRamfunc
   
 /* Zero fill the bss segment. */
   ldr r2, =_sbss
@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+"""
+Cycle and footprint regression check (make bench).
+
+Compares one benchmark run with the baseline stored for the same build
+profile:
+  - the estimated cycles per call of every emu-bench case (the --json
+    output of tools/emu_bench.py), failing on a case that got slower by
+    more than --tolerance percent
+  - flash and RAM of the firmware build from its size report
+    (build/<project>.size, read as tools/footprint_check.py does), failing
+    on growth beyond --footprint-tolerance bytes
+
+A case new to the run or gone from it is listed, not failed: the
+baseline only judges the cases both have. --update records the run as
+the baseline of its profile instead.
+"""
+
+import argparse
+import json
+import os
+import sys
+
+from footprint_check import read_report, totals
+
+
+def delta(new, old):
+    return "%+.1f%%" % ((new - old) * 100.0 / old) if old and new != old else "="
+
+
+def compare(current, baseline, tolerance, footprint_tolerance):
+    """Print the differences; True if within the tolerances."""
+    ok = True
+    print("%-22s %11s %11s %8s" % ("case (cycles/call)", "baseline", "current", "delta"))
+    for label, cycles in current["cases"].items():
+        old = baseline["cases"].get(label)
+        if old is None:
+            print("%-22s %11s %11.1f %8s" % (label, "-", cycles, "new"))
+            continue
+        slower = cycles > old * (1.0 + tolerance / 100.0)
+        ok = ok and not slower
+        print("%-22s %11.1f %11.1f %8s%s" % (label, old, cycles, delta(cycles, old),
+                                            "  SLOWER" if slower else ""))
+    for label in sorted(set(baseline["cases"]) - set(current["cases"])):
+        print("%-22s %11.1f %11s %8s" % (label, baseline["cases"][label], "-", "gone"))
+
+    print()
+    for name in ("flash", "ram"):
+        new, old = current[name], baseline[name]
+        grown = new - old > footprint_tolerance
+        ok = ok and not grown
+        print("%-22s %11d %11d %8s%s" % ("RAM" if name == "ram" else name, old, new,
+                                         "%+d" % (new - old) if new != old else "=",
+                                         "  GREW" if grown else ""))
+
+    print("\n%s (tolerance %g%% cycles, %d bytes)" % (
+        "OK" if ok else "BENCHMARK REGRESSION", tolerance, footprint_tolerance))
+    return ok
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("cases", help="Per-case figures (build/emu_bench/emu_bench.json)")
+    parser.add_argument("report", help="Size report of the firmware build (build/<project>.size)")
+    parser.add_argument("--baseline", default="tools/bench_baseline.json",
+                        help="Baseline file, one entry per build profile")
+    parser.add_argument("--tolerance", type=float, default=0.0,
+                        help="Cycles per call a case may add, in percent")
+    parser.add_argument("--footprint-tolerance", type=int, default=0,
+                        help="Growth in bytes accepted for flash and RAM")
+    parser.add_argument("--update", action="store_true",
+                        help="Store the run as the baseline of its profile")
+    args = parser.parse_args()
+
+    with open(args.cases) as figures:
+        cases = {label: case["cycles"] for label, case in json.load(figures).items()}
+    if not cases:
+        sys.exit("No cases in %s (expected tools/emu_bench.py --json output)" % args.cases)
+    profile, sections, _ = read_report(args.report)
+    if not sections:
+        sys.exit("No sections in %s (expected 'size -A -x' output)" % args.report)
+    profile = profile or "perf"
+    flash, ram = totals(sections)
+    current = {"cases": cases, "flash": flash, "ram": ram}
+
+    baselines = {}
+    if os.path.exists(args.baseline):
+        with open(args.baseline) as stored:
+            baselines = json.load(stored)
+
+    if args.update:
+        baselines[profile] = current
+        with open(args.baseline, "w") as stored:
+            json.dump(baselines, stored, indent=2, sort_keys=True)
+            stored.write("\n")
+        print("Baseline '%s': %d cases, flash %d, RAM %d bytes -> %s"
+              % (profile, len(cases), flash, ram, args.baseline))
+        return
+
+    if profile not in baselines:
+        sys.exit("No '%s' baseline in %s (make bench-baseline PROFILE=%s)"
+                 % (profile, args.baseline, profile))
+    print("Profile: %s" % profile)
+    if not compare(current, baselines[profile], args.tolerance, args.footprint_tolerance):
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+"""
+Depth and altitude tables for the derived-quantity stage (app/derived.c).
+
+Each table samples a height in mm at absolute pressures base + i * 2^shift
+(0.01 mbar units); the firmware interpolates linearly between entries and
+reports table(p) - table(reference):
+  fresh water, sea water   hydrostatic depth, rho g h = p (increasing)
+  air                      ISA barometric altitude, 44330.8 m (1 - (p / 1013.25)^0.190263)
+
+  derived_lut.py            print the tables as C initialisers
+  derived_lut.py --check    worst interpolation error of each table
+"""
+
+import argparse
+import sys
+
+G = 9.80665
+
+# name: (base, shift, entries, height in mm at p in 0.01 mbar)
+TABLES = {
+    "fresh": (0, 19, 2, lambda p: p * 1000.0 / (997.0 * G)),
+    "sea": (0, 19, 2, lambda p: p * 1000.0 / (1025.0 * G)),
+    "air": (30000, 9, 177, lambda p: 44330.8e3 * (1.0 - (p / 101325.0) ** 0.190263)),
+}
+
+
+def entries(name):
+    base, shift, count, height = TABLES[name]
+    return [round(height(base + (i << shift))) for i in range(count)]
+
+
+def interpolate(name, table, p):
+    base, shift, count, _ = TABLES[name]
+    offset = min(max(p - base, 0), ((count - 1) << shift) - 1)
+    i = offset >> shift
+    frac = offset & ((1 << shift) - 1)
+    return table[i] + (((table[i + 1] - table[i]) * frac) >> shift)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("--check", action="store_true", help="report interpolation errors")
+    args = parser.parse_args()
+
+    for name in TABLES:
+        table = entries(name)
+        base, shift, count, height = TABLES[name]
+        if args.check:
+            top = base + ((count - 1) << shift)
+            error = max(abs(interpolate(name, table, p) - height(p)) for p in range(base, top, 7))
+            print("%-6s %d .. %d (0.01 mbar): worst error %.1f mm" % (name, base, top, error))
+            continue
+        print("/* %s: p = %d + i * %d */" % (name, base, 1 << shift))
+        for i in range(0, count, 6):
+            print("    " + ", ".join("%d" % v for v in table[i:i + 6]) + ",")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,289 @@
+#!/usr/bin/env python3
+"""
+Cortex-M0+ kernel benchmark under an emulator (make emu-bench).
+
+Runs the benchmark image (tools/emu_bench/emu_bench.c, built from the
+firmware objects of the kernels) instruction by instruction under Unicorn
+(pip install unicorn) and reports, per case:
+  - instructions per call, charged to the function each one is in, so
+    compiler helpers (__aeabi_lmul, __aeabi_ldivmod, the soft-float
+    routines) show next to the kernel that called them
+  - an estimate of the cycles per call from the M0+ instruction timings:
+    loads and stores 2, LDM/STM/PUSH/POP 1+N (POP with pc 3+N), BL 3,
+    BX/BLX and B 2, a conditional branch 2 taken and 1 not, MSR/MRS and
+    barriers 3-4, everything else 1 (the STM32L0 has the single-cycle
+    multiplier). No flash wait states: at 32 MHz the prefetch hides most
+    of the one the L0 has, so hardware runs a few percent slower.
+
+The cases and their order come from the image itself (its cases[] table),
+split at its emu_bench_mark() calls. The emulator models the instruction
+set, not the pipeline: counts are exact, cycles approximate.
+
+The image also checks its fixmath cases against the plain C ones after
+the timed runs (emu_bench_mismatches); a difference fails the run, as
+does a set-up call of the image that failed (emu_bench_setup_errors).
+
+--json writes the per-call figures of every case as well, for
+tools/bench_check.py (make bench) to compare with a stored baseline.
+"""
+
+import argparse
+import bisect
+import json
+import struct
+import sys
+from collections import defaultdict
+
+FLASH_BASE = 0x08000000
+FLASH_SIZE = 192 * 1024
+RAM_BASE = 0x20000000
+RAM_SIZE = 20 * 1024
+INSTRUCTION_LIMIT = 50000000
+FUNCTIONS_SHOWN = 4
+CASE_PREFIX = "emu_bench_"
+RUNNER_FUNCTIONS = ("emu_bench_reset", "emu_bench_mark")  # Loop around the cases, not counted
+
+PT_LOAD = 1
+SHT_SYMTAB = 2
+STT_OBJECT = 1
+STT_FUNC = 2
+
+
+class Elf:
+    """The loadable segments and symbols of a little-endian ELF32 image."""
+
+    def __init__(self, path):
+        with open(path, "rb") as elf_file:
+            self.data = elf_file.read()
+        if self.data[:4] != b"\x7fELF" or self.data[4] != 1 or self.data[5] != 1:
+            raise ValueError("%s: not a little-endian ELF32 image" % path)
+        (self.phoff, self.shoff, _, _, self.phentsize, self.phnum, self.shentsize,
+         self.shnum, _) = struct.unpack_from("<IIIHHHHHH", self.data, 28)
+        self.functions = {}  # name: (start, size), thumb bit cleared
+        self.objects = {}
+        self.read_symbols()
+
+    def segments(self):
+        """(load address, bytes) of every PT_LOAD segment."""
+        for i in range(self.phnum):
+            p_type, p_offset, _, p_paddr, p_filesz = struct.unpack_from(
+                "<IIIII", self.data, self.phoff + i * self.phentsize)
+            if p_type == PT_LOAD and p_filesz:
+                yield p_paddr, self.data[p_offset:p_offset + p_filesz]
+
+    def section(self, index):
+        return struct.unpack_from("<IIIIIIIIII", self.data, self.shoff + index * self.shentsize)
+
+    def read_symbols(self):
+        for i in range(self.shnum):
+            _, sh_type, _, _, sh_offset, sh_size, sh_link, _, _, sh_entsize = self.section(i)
+            if sh_type != SHT_SYMTAB:
+                continue
+            strtab = self.section(sh_link)
+            names = self.data[strtab[4]:strtab[4] + strtab[5]]
+            for pos in range(sh_offset, sh_offset + sh_size, sh_entsize):
+                st_name, st_value, st_size, st_info, _, st_shndx = struct.unpack_from(
+                    "<IIIBBH", self.data, pos)
+                if st_shndx == 0:
+                    continue
+                name = names[st_name:names.index(b"\0", st_name)].decode()
+                if st_info & 0xF == STT_FUNC:
+                    self.functions[name] = (st_value & ~1, st_size)
+                elif st_info & 0xF == STT_OBJECT:
+                    self.objects[name] = (st_value, st_size)
+
+
+class FunctionIndex:
+    """Address -> name of the function containing it."""
+
+    def __init__(self, functions):
+        spans = sorted((start, size, name) for name, (start, size) in functions.items())
+        self.starts = [span[0] for span in spans]
+        self.spans = spans
+        self.cache = {}
+
+    def lookup(self, address):
+        name = self.cache.get(address)
+        if name is None:
+            i = bisect.bisect_right(self.starts, address) - 1
+            name = "?"
+            if i >= 0:
+                start, size, candidate = self.spans[i]
+                if address < start + max(size, 2):
+                    name = candidate
+            self.cache[address] = name
+        return name
+
+
+def cycles(first, second):
+    """M0+ cycles of one instruction, not counting a taken conditional branch.
+
+    Returns (cycles, is conditional branch).
+    """
+    if (first & 0xF800) in (0xE800, 0xF000, 0xF800):  # 32-bit
+        if (second & 0xD000) == 0xD000:
+            return 3, False  # BL
+        if (first & 0xFFF0) == 0xF380:
+            return 4, False  # MSR
+        if first == 0xF3BF:
+            return 4, False  # DSB, DMB, ISB
+        return 3, False  # MRS
+    if (first & 0xFE00) == 0xBC00:  # POP
+        n = bin(first & 0x1FF).count("1")
+        return (3 + n) if first & 0x100 else (1 + n), False
+    if (first & 0xFE00) == 0xB400:  # PUSH (bit 8: lr)
+        return 1 + bin(first & 0x1FF).count("1"), False
+    if (first & 0xF000) == 0xC000:  # LDM, STM
+        return 1 + bin(first & 0xFF).count("1"), False
+    if (first & 0xF000) in (0x5000, 0x6000, 0x7000, 0x8000, 0x9000) or (first & 0xF800) == 0x4800:
+        return 2, False  # LDR, STR (all forms)
+    if (first & 0xF000) == 0xD000 and (first & 0x0F00) < 0x0E00:
+        return 1, True  # B<cond>
+    if (first & 0xF800) == 0xE000 or (first & 0xFF00) == 0x4700:
+        return 2, False  # B, BX, BLX
+    if (first & 0xFF00) in (0x4400, 0x4600) and (first & 0x87) == 0x87:
+        return 2, False  # ADD pc, MOV pc
+    return 1, False
+
+
+class Counter:
+    """Instruction and cycle counts per case and function."""
+
+    def __init__(self, index, mark, entries, r0):
+        self.index = index
+        self.mark = mark
+        self.entries = entries  # Case function address: case
+        self.r0 = r0
+        self.calls = defaultdict(int)
+        self.case = None
+        self.instructions = defaultdict(lambda: defaultdict(int))  # case: function: count
+        self.cycles = defaultdict(lambda: defaultdict(int))
+        self.timing = {}
+        self.pending_branch = None  # (address after a conditional branch, its function)
+        self.count = 0
+
+    def hook(self, uc, address, size, _):
+        self.count += 1
+        if self.pending_branch is not None:
+            after, function = self.pending_branch
+            if address != after:
+                self.cycles[self.case][function] += 1  # Taken
+            self.pending_branch = None
+        if address == self.mark:
+            self.case = uc.reg_read(self.r0)
+        elif address in self.entries:
+            self.calls[self.entries[address]] += 1
+        if self.case is None:
+            return
+
+        timing = self.timing.get(address)
+        if timing is None:
+            first, second = struct.unpack("<HH", bytes(uc.mem_read(address, 4)))
+            timing = cycles(first, second)
+            self.timing[address] = timing
+        function = self.index.lookup(address)
+        self.instructions[self.case][function] += 1
+        self.cycles[self.case][function] += timing[0]
+        if timing[1]:
+            self.pending_branch = (address + size, function)
+
+
+def run(elf):
+    try:
+        from unicorn import Uc, UC_ARCH_ARM, UC_MODE_THUMB, UC_MODE_MCLASS, UC_HOOK_CODE
+        from unicorn import arm_const
+    except ImportError:
+        sys.exit("tools/emu_bench.py needs Unicorn: pip install unicorn")
+
+    for needed in ("emu_bench_mark", "emu_bench_done"):
+        if needed not in elf.functions:
+            sys.exit("%s missing: not an emu_bench image" % needed)
+
+    uc = Uc(UC_ARCH_ARM, UC_MODE_THUMB | UC_MODE_MCLASS)
+    model = getattr(arm_const, "UC_CPU_ARM_CORTEX_M0", None)
+    if model is not None and hasattr(uc, "ctl_set_cpu_model"):
+        uc.ctl_set_cpu_model(model)  # ARMv6-M: what the M0+ decodes
+    uc.mem_map(FLASH_BASE, FLASH_SIZE)
+    uc.mem_map(RAM_BASE, RAM_SIZE)
+    for address, data in elf.segments():
+        uc.mem_write(address, data)
+
+    index = FunctionIndex(elf.functions)
+
+    # Cases from cases[] (in flash): pointers to the case functions, in order
+    start, size = elf.objects["cases"]
+    pointers = [pointer & ~1 for pointer in
+                struct.unpack("<%dI" % (size // 4), bytes(uc.mem_read(start, size)))]
+    names = [index.lookup(pointer) for pointer in pointers]
+
+    sp, reset = struct.unpack("<II", bytes(uc.mem_read(FLASH_BASE, 8)))
+    uc.reg_write(arm_const.UC_ARM_REG_SP, sp)
+    counter = Counter(index, elf.functions["emu_bench_mark"][0],
+                      {pointer: n for n, pointer in enumerate(pointers)}, arm_const.UC_ARM_REG_R0)
+    uc.hook_add(UC_HOOK_CODE, counter.hook)
+    uc.emu_start(reset | 1, elf.functions["emu_bench_done"][0], count=INSTRUCTION_LIMIT)
+    if counter.count >= INSTRUCTION_LIMIT:
+        sys.exit("Stopped after %d instructions: the image did not finish" % INSTRUCTION_LIMIT)
+    mismatches, setup_errors = (
+        struct.unpack("<I", bytes(uc.mem_read(elf.objects[name][0], 4)))[0]
+        for name in ("emu_bench_mismatches", "emu_bench_setup_errors"))
+    return names, counter, mismatches, setup_errors
+
+
+def figures(names, counter):
+    """Per case: (label, calls, instructions per call, cycles per call,
+    {function: instructions per call})."""
+    result = []
+    for n, name in enumerate(names):
+        calls = max(counter.calls.get(n, 0), 1)
+        functions = {function: count / calls
+                     for function, count in counter.instructions[n].items()
+                     if function not in RUNNER_FUNCTIONS}
+        spent = sum(count for function, count in counter.cycles[n].items()
+                    if function not in RUNNER_FUNCTIONS)
+        label = name[len(CASE_PREFIX):] if name.startswith(CASE_PREFIX) else name
+        result.append((label, counter.calls.get(n, 0), sum(functions.values()),
+                       spent / calls, functions))
+    return result
+
+
+def report(cases):
+    print("%-22s %6s %10s %11s  %s" % ("case", "calls", "instr/call", "cycles/call",
+                                       "functions (instructions per call)"))
+    for label, calls, instructions, spent, functions in cases:
+        shown = sorted(((count, function) for function, count in functions.items()),
+                       reverse=True)[:FUNCTIONS_SHOWN]
+        print("%-22s %6d %10.1f %11.1f  %s" % (
+            label, calls, instructions, spent,
+            ", ".join("%s %.1f" % (function, count) for count, function in shown)))
+
+
+def export(cases, path):
+    with open(path, "w") as out:
+        json.dump({label: {"calls": calls, "instructions": round(instructions, 1),
+                           "cycles": round(spent, 1)}
+                   for label, calls, instructions, spent, _ in cases},
+                  out, indent=2, sort_keys=True)
+        out.write("\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("elf", help="Benchmark image (build/emu_bench/emu_bench.elf)")
+    parser.add_argument("--json", help="Also write the per-call figures of each case here")
+    args = parser.parse_args()
+
+    names, counter, mismatches, setup_errors = run(Elf(args.elf))
+    cases = figures(names, counter)
+    report(cases)
+    if args.json:
+        export(cases, args.json)
+    if setup_errors:
+        print("%d set-up calls of the image failed (calibration, DAC, pool)" % setup_errors)
+    if mismatches:
+        print("%d fixmath results differ from the plain C expressions" % mismatches)
+    return 1 if setup_errors or mismatches else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
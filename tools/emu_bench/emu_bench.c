@@ -0,0 +1,542 @@
+/**
+ * @file emu_bench.c
+ * @brief Kernel benchmark image for the Cortex-M0+ emulator (make emu-bench)
+ *
+ * Linked from the firmware objects of the kernels it calls (the same
+ * sources, flags and per-file optimization levels, without LTO so each
+ * keeps its symbol) and nothing else: no startup file, no HAL, no clock
+ * or peripheral set-up. The reset handler copies .ramfunc and .data,
+ * clears .bss, then runs every case EMU_BENCH_ITERATIONS times and parks
+ * in emu_bench_done(). tools/emu_bench.py runs it under the emulator,
+ * splits the instruction trace at the emu_bench_mark() calls and charges
+ * each instruction to the function it is in.
+ *
+ * A case is the kernel call loop only; inputs vary per iteration so no
+ * branch is always taken the same way, and results go to a volatile sink.
+ * A new case is a function added to cases[]: the emulator reads the table,
+ * and names the case after the function.
+ *
+ * The fixmath cases come in pairs with the plain C expression they stand
+ * for (compiled for the M0+: __aeabi_lmul, __aeabi_lasr, __aeabi_ldivmod).
+ * After the timed runs, each pair is re-run in lockstep on the same inputs
+ * and every result compared; emu_bench_mismatches counts the differences
+ * and tools/emu_bench.py fails if it is not 0. It fails as well on
+ * emu_bench_setup_errors, the set-up calls that refused their inputs:
+ * a case timed on a calibration never loaded measures nothing.
+ *
+ * The host FIFO cases (the I2C1 burst frames) link host_fifo.c and
+ * time_sync.c; the I2C1 mask and the warm boot check are stubbed below,
+ * as the NVIC and the reset flags are not there.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "board_config.h"
+#include "ms58.h"
+#include "dac.h"
+#include "pool.h"
+#include "sample_codec.h"
+#include "fixmath.h"
+#include "tracker.h"
+#include "host_fifo.h"
+#include "hal_config.h"
+#include "warm_restart.h"
+#include "ms58_original.h"
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define EMU_BENCH_ITERATIONS  64U
+#define EMU_BENCH_BATCH       8U     /* Pairs per ms5837_compensate_batch() */
+#define EMU_BENCH_COPY_BYTES  256U
+
+#define EMU_BENCH_NOINLINE    __attribute__((noinline, used))
+
+/* Q2.30 second-order section, fc = fs / 8 (SENSOR_IIR presets) */
+#define EMU_BENCH_IIR_B0      104830566L
+#define EMU_BENCH_IIR_B1      209661133L
+#define EMU_BENCH_IIR_A1      (-1012333500L)
+#define EMU_BENCH_IIR_A2      357913941L
+
+typedef void (*emu_bench_case_t)(uint32_t i);
+
+/* A fixmath case and the plain C one that must give the same result */
+typedef struct {
+    emu_bench_case_t fixmath;
+    emu_bench_case_t generic;
+} emu_bench_pair_t;
+
+/* Biquad state, inputs and outputs Q8 (as sensor_iir_push()) */
+typedef struct {
+    int32_t x1;
+    int32_t x2;
+    int32_t y1;
+    int32_t y2;
+} emu_bench_iir_t;
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+/* Datasheet example coefficients and conversions, C0 the ID of the
+ * variant built (ms5837_prom_variant_ok()) */
+#if BOARD_SENSOR_VARIANT == BOARD_SENSOR_VARIANT_30BA
+#define EMU_BENCH_C0  ((uint16_t)(MS5837_ID_30BA26 << 5))
+#else
+#define EMU_BENCH_C0  ((uint16_t)(MS5837_ID_02BA21 << 5))
+#endif
+static const uint16_t prom[8] = { EMU_BENCH_C0, 34982, 36352, 20328, 22354, 26646, 26146, 0 };
+static const dac_calibration_t dac_cal = { 66191UL, 3L << 16 };  /* Gain 1.01, offset +3 codes */
+#define EMU_BENCH_D1  4958179UL
+#define EMU_BENCH_D2  6815414UL
+
+static ms5837_calib_t calib;
+static ms5837_calib_t calib_second;
+static uint32_t batch_d1[EMU_BENCH_BATCH];
+static uint32_t batch_d2[EMU_BENCH_BATCH];
+static int32_t batch_p[EMU_BENCH_BATCH];
+static int32_t batch_t[EMU_BENCH_BATCH];
+
+static uint32_t copy_src[EMU_BENCH_COPY_BYTES / 4U + 1U];
+static uint32_t copy_dst[EMU_BENCH_COPY_BYTES / 4U + 1U];
+
+POOL_STORAGE(pool_storage, sizeof(sensor_data_t), 4U);
+static pool_t pool;
+
+static sample_codec_t codec;
+static uint8_t codec_out[SAMPLE_CODEC_MAX_BYTES];
+
+static emu_bench_iir_t iir_fixmath;
+static emu_bench_iir_t iir_generic;
+
+static volatile uint32_t sink;
+static volatile int64_t result;  /* Of the paired cases */
+
+/* Paired results that differed (read by tools/emu_bench.py) */
+volatile uint32_t emu_bench_mismatches;
+
+/* Set-up calls that failed (read by tools/emu_bench.py) */
+volatile uint32_t emu_bench_setup_errors;
+
+/* ============================================================================
+ * INPUTS
+ * ============================================================================ */
+
+/**
+ * @brief 32-bit operand i: the edges first, then spread over the range
+ */
+static uint32_t emu_bench_operand(uint32_t i)
+{
+    static const uint32_t edges[] = {
+        0, 1, 0xFFFFFFFFUL, 0x80000000UL, 0x7FFFFFFFUL, 0x0000FFFFUL, 0xFFFF0000UL, 0x00010000UL
+    };
+
+    return (i < sizeof(edges) / sizeof(edges[0])) ? edges[i] : i * 2654435761UL;
+}
+
+static int64_t emu_bench_operand64(uint32_t i)
+{
+    return (int64_t)(((uint64_t)emu_bench_operand(i) << 32) | emu_bench_operand(i ^ 0x15U));
+}
+
+/* ============================================================================
+ * CASES
+ * ============================================================================ */
+
+static EMU_BENCH_NOINLINE void emu_bench_compensate(uint32_t i)
+{
+    int32_t p;
+    int32_t t;
+
+    ms5837_compensate(&calib, EMU_BENCH_D1 + i * 97U, EMU_BENCH_D2 + i * 31U, &p, &t);
+    sink = (uint32_t)(p ^ t);
+}
+
+/* The first code (ms58_original.c) on the same inputs: the cost of the
+ * 64-bit '/' the shifts replaced */
+static EMU_BENCH_NOINLINE void emu_bench_compensate_original(uint32_t i)
+{
+    int32_t p;
+    int32_t t;
+
+    (void)ms58_original_calculate(prom, EMU_BENCH_D1 + i * 97U, EMU_BENCH_D2 + i * 31U, &p, &t);
+    sink = (uint32_t)(p ^ t);
+}
+
+static EMU_BENCH_NOINLINE void emu_bench_compensate_second(uint32_t i)
+{
+    int32_t p;
+    int32_t t;
+
+    /* Below 20 degC from i = 32: the low-temperature terms as well */
+    ms5837_compensate(&calib_second, EMU_BENCH_D1 + i * 97U, EMU_BENCH_D2 - i * 20000U, &p, &t);
+    sink = (uint32_t)(p ^ t);
+}
+
+static EMU_BENCH_NOINLINE void emu_bench_compensate_batch(uint32_t i)
+{
+    for (uint32_t k = 0; k < EMU_BENCH_BATCH; k++) {
+        batch_d1[k] = EMU_BENCH_D1 + (i * EMU_BENCH_BATCH + k) * 97U;
+        batch_d2[k] = EMU_BENCH_D2 + (i & ~3U) * 31U;  /* Temperature decimated by 4 */
+    }
+    (void)ms5837_compensate_batch(&calib, batch_d1, batch_d2, batch_p, batch_t, EMU_BENCH_BATCH);
+    sink = (uint32_t)batch_p[EMU_BENCH_BATCH - 1U];
+}
+
+static EMU_BENCH_NOINLINE void emu_bench_smull(uint32_t i)
+{
+    result = fixmath_smull((int32_t)emu_bench_operand(i), (int32_t)emu_bench_operand(i + 3U));
+}
+
+static EMU_BENCH_NOINLINE void emu_bench_smull_generic(uint32_t i)
+{
+    result = (int64_t)(int32_t)emu_bench_operand(i) * (int32_t)emu_bench_operand(i + 3U);
+}
+
+/* Run-time count, as the moving average's */
+static EMU_BENCH_NOINLINE void emu_bench_asr64(uint32_t i)
+{
+    result = fixmath_asr64(emu_bench_operand64(i), i & 63U);
+}
+
+static EMU_BENCH_NOINLINE void emu_bench_asr64_generic(uint32_t i)
+{
+    result = emu_bench_operand64(i) >> (i & 63U);
+}
+
+static EMU_BENCH_NOINLINE void emu_bench_div_pow2(uint32_t i)
+{
+    result = fixmath_div_pow2(emu_bench_operand64(i), i % 63U);
+}
+
+static EMU_BENCH_NOINLINE void emu_bench_div_pow2_generic(uint32_t i)
+{
+    result = emu_bench_operand64(i) / ((int64_t)1 << (i % 63U));
+}
+
+/* The sensor_iir_push() arithmetic: five MACs in 64 bits, rounded, saturated */
+static EMU_BENCH_NOINLINE void emu_bench_iir(uint32_t i)
+{
+    emu_bench_iir_t *s = &iir_fixmath;
+    int32_t x = (101325 + (int32_t)(i * 2654435761UL >> 24)) * 256;  /* Noisy pressure, Q8 */
+    int64_t acc;
+    int64_t y;
+
+    acc = fixmath_smull(EMU_BENCH_IIR_B0, x);
+    acc = fixmath_smlal(acc, EMU_BENCH_IIR_B1, s->x1);
+    acc = fixmath_smlal(acc, EMU_BENCH_IIR_B0, s->x2);
+    acc = fixmath_smlsl(acc, EMU_BENCH_IIR_A1, s->y1);
+    acc = fixmath_smlsl(acc, EMU_BENCH_IIR_A2, s->y2);
+    y = (acc + (1LL << 29)) >> 30;
+    y = (y > INT32_MAX) ? INT32_MAX : (y < INT32_MIN) ? INT32_MIN : y;
+    s->x2 = s->x1;
+    s->x1 = x;
+    s->y2 = s->y1;
+    s->y1 = (int32_t)y;
+    result = y;
+}
+
+static EMU_BENCH_NOINLINE void emu_bench_iir_generic(uint32_t i)
+{
+    emu_bench_iir_t *s = &iir_generic;
+    int32_t x = (101325 + (int32_t)(i * 2654435761UL >> 24)) * 256;
+    int64_t acc;
+    int64_t y;
+
+    acc = (int64_t)EMU_BENCH_IIR_B0 * x + (int64_t)EMU_BENCH_IIR_B1 * s->x1 +
+          (int64_t)EMU_BENCH_IIR_B0 * s->x2 - (int64_t)EMU_BENCH_IIR_A1 * s->y1 -
+          (int64_t)EMU_BENCH_IIR_A2 * s->y2;
+    y = (acc + (1LL << 29)) >> 30;
+    y = (y > INT32_MAX) ? INT32_MAX : (y < INT32_MIN) ? INT32_MIN : y;
+    s->x2 = s->x1;
+    s->x1 = x;
+    s->y2 = s->y1;
+    s->y1 = (int32_t)y;
+    result = y;
+}
+
+/* 500 Hz samples, a 15 us jitter and a pressure ramp with noise */
+static EMU_BENCH_NOINLINE void emu_bench_tracker(uint32_t i)
+{
+    sensor_data_t sample;
+    tracker_output_t out;
+
+    memset(&sample, 0, sizeof(sample));
+    sample.timestamp_us = 2000U * (i + 1U) + (i * 7U) % 15U;
+    sample.sequence = i;
+    sample.pressure = 101325 + (int32_t)(i * 3U) + (int32_t)(i * 2654435761UL >> 29) - 4;
+    sample.valid = true;
+    tracker_update(&sample);
+    (void)tracker_get(&out);
+    sink = (uint32_t)out.rate;
+}
+
+static EMU_BENCH_NOINLINE void emu_bench_dac_mv(uint32_t i)
+{
+    sink = dac_millivolts_to_code(i * 53U);
+}
+
+static EMU_BENCH_NOINLINE void emu_bench_dac_calibrated(uint32_t i)
+{
+    sink = dac_calibrated_code(DAC_CHANNEL_OUT1, (uint16_t)(i * 64U));
+}
+
+static EMU_BENCH_NOINLINE void emu_bench_dac_float(uint32_t i)
+{
+    sink = dac_voltage_to_code((float)i * 0.053f);
+}
+
+static EMU_BENCH_NOINLINE void emu_bench_memcpy_aligned(uint32_t i)
+{
+    memcpy(copy_dst, copy_src, EMU_BENCH_COPY_BYTES - (i & 3U) * 4U);
+    sink = copy_dst[0];
+}
+
+static EMU_BENCH_NOINLINE void emu_bench_memcpy_unaligned(uint32_t i)
+{
+    memcpy((uint8_t *)copy_dst + 1, (const uint8_t *)copy_src + 2, EMU_BENCH_COPY_BYTES - (i & 3U));
+    sink = copy_dst[1];
+}
+
+/* Same misalignment on both sides (1..3 head bytes) and a 0..7 byte tail */
+static EMU_BENCH_NOINLINE void emu_bench_memcpy_head_tail(uint32_t i)
+{
+    uint32_t head = 1U + i % 3U;
+
+    memcpy((uint8_t *)copy_dst + head, (const uint8_t *)copy_src + head,
+           EMU_BENCH_COPY_BYTES - 8U + (i & 7U));
+    sink = copy_dst[1];
+}
+
+/* A sample struct copy, the size GCC calls memcpy for most */
+static EMU_BENCH_NOINLINE void emu_bench_memcpy_sample(uint32_t i)
+{
+    memcpy(copy_dst, &copy_src[i & 1U], sizeof(sensor_data_t));
+    sink = copy_dst[0];
+}
+
+/* Destination one word above the source: the backward copy */
+static EMU_BENCH_NOINLINE void emu_bench_memmove_overlap(uint32_t i)
+{
+    memmove(&copy_dst[1], copy_dst, EMU_BENCH_COPY_BYTES - 4U - (i & 3U));
+    sink = copy_dst[2];
+}
+
+static EMU_BENCH_NOINLINE void emu_bench_memset(uint32_t i)
+{
+    memset((uint8_t *)copy_dst + (i & 3U), (int)i, EMU_BENCH_COPY_BYTES - 4U);
+    sink = copy_dst[1];
+}
+
+/* 1..3 head bytes and a 0..7 byte tail around a short word run */
+static EMU_BENCH_NOINLINE void emu_bench_memset_head_tail(uint32_t i)
+{
+    memset((uint8_t *)copy_dst + 1U + i % 3U, (int)i, 64U + (i & 7U));
+    sink = copy_dst[1];
+}
+
+static EMU_BENCH_NOINLINE void emu_bench_pool(uint32_t i)
+{
+    void *a = pool_alloc(&pool);
+    void *b = pool_alloc(&pool);
+
+    (void)pool_free(&pool, (i & 1U) ? a : b);
+    (void)pool_free(&pool, (i & 1U) ? b : a);
+    sink = (uint32_t)(uintptr_t)a;
+}
+
+/* A sample appended per call; a full frame is taken first, as the master
+ * polling once per HOST_FIFO_DEPTH samples */
+static EMU_BENCH_NOINLINE void emu_bench_fifo_push(uint32_t i)
+{
+    uint16_t len;
+    sensor_data_t sample;
+
+    if (!host_fifo_has_room()) {
+        (void)host_fifo_take_frame(&len);
+    }
+    memset(&sample, 0, sizeof(sample));
+    sample.timestamp_us = i * 2000U;
+    sample.sequence = i;
+    sample.pressure = 101325 + (int32_t)(i & 15U);
+    sample.valid = true;
+    sink = host_fifo_push(&sample);
+}
+
+/* The master polling every sample: one appended, the frame taken in the
+ * address callback */
+static EMU_BENCH_NOINLINE void emu_bench_fifo_take(uint32_t i)
+{
+    uint16_t len;
+    sensor_data_t sample;
+
+    memset(&sample, 0, sizeof(sample));
+    sample.timestamp_us = i * 2000U;
+    sample.sequence = i;
+    sample.valid = true;
+    (void)host_fifo_push(&sample);
+    sink = (uint32_t)(uintptr_t)host_fifo_take_frame(&len) + len;
+}
+
+static EMU_BENCH_NOINLINE void emu_bench_codec(uint32_t i)
+{
+    sensor_data_t sample;
+
+    memset(&sample, 0, sizeof(sample));
+    sample.timestamp_us = i * 2000U + (i & 3U);
+    sample.sequence = i + (i >> 4);  /* A gap every 16 */
+    sample.pressure = 101325 + (int32_t)(i * 7U % 23U) - 11;
+    sample.temperature = 2100 + (int32_t)(i & 7U);
+    sink = sample_codec_encode(&codec, &sample, codec_out);
+}
+
+/* Run in this order, reported under the function names */
+static const emu_bench_case_t cases[] = {
+    emu_bench_compensate,
+    emu_bench_compensate_original,
+    emu_bench_compensate_second,
+    emu_bench_compensate_batch,
+    emu_bench_smull,
+    emu_bench_smull_generic,
+    emu_bench_asr64,
+    emu_bench_asr64_generic,
+    emu_bench_div_pow2,
+    emu_bench_div_pow2_generic,
+    emu_bench_iir,
+    emu_bench_iir_generic,
+    emu_bench_tracker,
+    emu_bench_dac_mv,
+    emu_bench_dac_calibrated,
+    emu_bench_dac_float,
+    emu_bench_memcpy_aligned,
+    emu_bench_memcpy_unaligned,
+    emu_bench_memcpy_head_tail,
+    emu_bench_memcpy_sample,
+    emu_bench_memmove_overlap,
+    emu_bench_memset,
+    emu_bench_memset_head_tail,
+    emu_bench_pool,
+    emu_bench_codec,
+    emu_bench_fifo_push,
+    emu_bench_fifo_take,
+};
+
+/* Checked after the timed runs */
+static const emu_bench_pair_t pairs[] = {
+    { emu_bench_smull, emu_bench_smull_generic },
+    { emu_bench_asr64, emu_bench_asr64_generic },
+    { emu_bench_div_pow2, emu_bench_div_pow2_generic },
+    { emu_bench_iir, emu_bench_iir_generic },
+};
+
+/* ============================================================================
+ * FIRMWARE STUBS
+ * ============================================================================ */
+
+/* No interrupt ever runs, so there is nothing to mask */
+uint32_t hal_irq_mask(uint32_t lines)
+{
+    return lines;
+}
+
+void hal_irq_unmask(uint32_t saved)
+{
+    (void)saved;
+}
+
+bool warm_restart_is_warm(void)
+{
+    return false;
+}
+
+/* ============================================================================
+ * RUNNER
+ * ============================================================================ */
+
+extern uint32_t _estack;
+extern uint32_t _siramfunc, _sramfunc, _eramfunc;
+extern uint32_t _sidata, _sdata, _edata;
+extern uint32_t _sbss, _ebss;
+
+void emu_bench_reset(void);
+
+/* SP and reset vector only: nothing here takes an exception */
+__attribute__((section(".isr_vector"), used))
+static const uintptr_t emu_bench_vectors[2] = {
+    (uintptr_t)&_estack,
+    (uintptr_t)emu_bench_reset
+};
+
+/**
+ * @brief Case boundary: the emulator starts counting case n here
+ *
+ * @param n Case index, or the case count once all have run
+ */
+EMU_BENCH_NOINLINE void emu_bench_mark(uint32_t n)
+{
+    __asm volatile ("" : : "r" (n) : "memory");
+}
+
+EMU_BENCH_NOINLINE void emu_bench_done(void)
+{
+    for (;;) {
+    }
+}
+
+static void emu_bench_copy(uint32_t *dst, const uint32_t *src, const uint32_t *end)
+{
+    while (dst < end) {
+        *dst++ = *src++;
+    }
+}
+
+void emu_bench_reset(void)
+{
+    emu_bench_copy(&_sramfunc, &_siramfunc, &_eramfunc);
+    emu_bench_copy(&_sdata, &_sidata, &_edata);
+    for (uint32_t *p = &_sbss; p < &_ebss; p++) {
+        *p = 0;
+    }
+
+    if (ms5837_calib_prepare(prom, &calib) != E_MS58370BA01_SUCCESS) {
+        emu_bench_setup_errors++;
+    }
+    calib_second = calib;
+    ms5837_calib_set_second_order(&calib_second, true);
+    if (!dac_set_calibration(DAC_CHANNEL_OUT1, &dac_cal)) {
+        emu_bench_setup_errors++;
+    }
+    for (uint32_t k = 0; k < sizeof(copy_src) / sizeof(copy_src[0]); k++) {
+        copy_src[k] = k * 0x01010101UL;
+    }
+    if (!pool_init(&pool, pool_storage, sizeof(sensor_data_t), 4U)) {
+        emu_bench_setup_errors++;
+    }
+    sample_codec_reset(&codec);
+    host_fifo_init();
+
+    for (uint32_t n = 0; n < sizeof(cases) / sizeof(cases[0]); n++) {
+        emu_bench_mark(n);
+        for (uint32_t i = 0; i < EMU_BENCH_ITERATIONS; i++) {
+            cases[n](i);
+        }
+    }
+    emu_bench_mark(sizeof(cases) / sizeof(cases[0]));
+
+    /* Not counted: past the last mark */
+    for (uint32_t n = 0; n < sizeof(pairs) / sizeof(pairs[0]); n++) {
+        for (uint32_t i = 0; i < EMU_BENCH_ITERATIONS; i++) {
+            int64_t expected;
+
+            pairs[n].generic(i);
+            expected = result;
+            pairs[n].fixmath(i);
+            if (result != expected) {
+                emu_bench_mismatches++;
+            }
+        }
+    }
+    emu_bench_done();
+}
@@ -0,0 +1,58 @@
+/**
+ * @file ms58_original.c
+ * @brief The MS5837 compensation as first written (reference, tools only)
+ *
+ * Verbatim from 9eeb74e but for the name.
+ */
+
+#include <stddef.h>
+#include "ms58_original.h"
+
+ms583730ba01_err_t ms58_original_calculate(
+    const uint16_t *calibration_data,
+    uint32_t d1_pressure,
+    uint32_t d2_temperature,
+    int32_t *pressure,
+    int32_t *temperature
+) {
+    if (calibration_data == NULL || pressure == NULL || temperature == NULL) {
+        return E_MS58370BA01_NULLPTR_ERR;
+    }
+    
+    int32_t dT;               // Temperature difference
+    int64_t OFF, SENS, P;     // Intermediate calculations
+    
+    // Calculate dT (difference between actual and reference temperature)
+    dT = (int32_t)d2_temperature - ((int32_t)calibration_data[5] * 256);  // C5 * 2^8
+    
+    // Calculate temperature (TEMP)
+    *temperature = 2000 + ((int64_t)dT * calibration_data[6]) / 8388608;  // C6 / 2^23
+    
+    // Calculate OFF (Offset at actual temperature)
+    OFF = ((int64_t)calibration_data[2] * 131072)  // C2 * 2^17
+        + (((int64_t)calibration_data[4] * dT) / 64);  // C4 * dT / 2^6
+    
+    // Calculate SENS (Sensitivity at actual temperature)
+    SENS = ((int64_t)calibration_data[1] * 65536)  // C1 * 2^16
+         + (((int64_t)calibration_data[3] * dT) / 128);  // C3 * dT / 2^7
+    
+    // Calculate pressure (P)
+    P = ((((int64_t)d1_pressure * SENS) / 2097152) - OFF) / 32768;  // (D1 * SENS / 2^21 - OFF) / 2^15
+    
+    // Overflow protection: Clamp pressure to int32_t range before casting
+    if (P > INT32_MAX) {
+        *pressure = INT32_MAX;
+    } else if (P < INT32_MIN) {
+        *pressure = INT32_MIN;
+    } else {
+        *pressure = (int32_t)P;  // Convert to mbar (pressure in 0.01 mbar resolution)
+    }
+    
+    // Overflow protection: Clamp temperature to int32_t range (shouldn't overflow, but safe)
+    // Note: *temperature is int32_t, so it can't be < INT32_MIN, only check upper bound
+    if (*temperature > INT32_MAX) {
+        *temperature = INT32_MAX;
+    }
+    
+    return E_MS58370BA01_SUCCESS;
+}
@@ -0,0 +1,33 @@
+/**
+ * @file ms58_original.h
+ * @brief The MS5837 compensation as first written (reference, tools only)
+ *
+ * ms5837_calculate_pressure_temperature() of 9eeb74e, before the
+ * precomputed terms and the shifts: 64-bit products and C '/' straight
+ * from the datasheet. It has the 02BA first-order formulas (C2*2^17,
+ * C4/2^6, C1*2^16, C3/2^7, /2^15) whatever the part, so it is the
+ * reference of the 02BA build. make host-test checks ms5837_compensate()
+ * against it; make emu-bench counts its cycles next to the current code.
+ */
+
+#ifndef MS58_ORIGINAL_H
+#define MS58_ORIGINAL_H
+
+#include <stdint.h>
+#include "ms58.h"
+
+/**
+ * @brief First-order compensation, original code
+ *
+ * @param calibration_data PROM words C0..C7
+ * @param d1_pressure D1
+ * @param d2_temperature D2
+ * @param pressure Receives P (clamped to int32_t)
+ * @param temperature Receives TEMP, 0.01 degC
+ * @return E_MS58370BA01_SUCCESS, or E_MS58370BA01_NULLPTR_ERR
+ */
+ms583730ba01_err_t ms58_original_calculate(const uint16_t *calibration_data, uint32_t d1_pressure,
+                                           uint32_t d2_temperature, int32_t *pressure,
+                                           int32_t *temperature);
+
+#endif /* MS58_ORIGINAL_H */
@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""
+Flash/RAM footprint regression check (make footprint).
+
+Reads the size report of a build (build/<project>.size: 'size -A -x' of the
+ELF followed by the largest symbols from 'nm --size-sort') and compares it
+with the baseline stored for the same build profile:
+  - flash: sections linked in flash plus the load images of .data and
+    .ramfunc
+  - RAM: sections linked in SRAM (.ramfunc, .data, .bss, heap and stack)
+  - per section, and the symbols that grew most
+
+Exits non-zero when flash or RAM grew by more than --tolerance bytes.
+--update records the current report as the baseline of its profile instead.
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+FLASH_BASE = 0x08000000
+RAM_BASE = 0x20000000
+FLASH_LOADED = (".data", ".ramfunc")  # Linked in SRAM, copied from flash
+DEBUG_PREFIXES = (".debug", ".comment", ".ARM.attributes")
+SYMBOLS_SHOWN = 10
+
+SECTION_RE = re.compile(r"^(\.\S+)\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)\s*$")
+SYMBOL_RE = re.compile(r"^[0-9a-fA-F]+\s+([0-9a-fA-F]+)\s+\w\s+(.+)$")
+
+
+def read_report(path):
+    """Profile, {section: (size, addr)} and {symbol: size} of a size report."""
+    profile = None
+    sections = {}
+    symbols = {}
+    with open(path) as report:
+        for line in report:
+            line = line.rstrip()
+            if line.startswith("Profile:"):
+                profile = line.split(":", 1)[1].strip()
+                continue
+            match = SECTION_RE.match(line)
+            if match:
+                name, size, addr = match.groups()
+                if not name.startswith(DEBUG_PREFIXES):
+                    sections[name] = (int(size, 16), int(addr, 16))
+                continue
+            match = SYMBOL_RE.match(line)
+            if match:
+                size, name = match.groups()
+                symbols[name] = max(symbols.get(name, 0), int(size, 16))
+    return profile, sections, symbols
+
+
+def totals(sections):
+    """(flash, ram) bytes of a section table."""
+    flash = ram = 0
+    for name, (size, addr) in sections.items():
+        if addr & 0xFF000000 == FLASH_BASE:
+            flash += size
+        elif addr & 0xFF000000 == RAM_BASE:
+            ram += size
+            if name in FLASH_LOADED:
+                flash += size
+    return flash, ram
+
+
+def delta(new, old):
+    return "%+d" % (new - old) if new != old else "="
+
+
+def compare(current, baseline, tolerance):
+    """Print the differences; True if within the tolerance."""
+    flash, ram = current["flash"], current["ram"]
+    print("%-24s %10s %10s %8s" % ("", "baseline", "current", "delta"))
+    print("%-24s %10d %10d %8s" % ("flash", baseline["flash"], flash,
+                                   delta(flash, baseline["flash"])))
+    print("%-24s %10d %10d %8s" % ("RAM", baseline["ram"], ram,
+                                   delta(ram, baseline["ram"])))
+
+    print("\nSections:")
+    for name in sorted(set(current["sections"]) | set(baseline["sections"])):
+        new = current["sections"].get(name, 0)
+        old = baseline["sections"].get(name, 0)
+        if new != old:
+            print("  %-22s %10d %10d %8s" % (name, old, new, delta(new, old)))
+
+    growth = []
+    for name, new in current["symbols"].items():
+        old = baseline["symbols"].get(name, 0)
+        if new > old:
+            growth.append((new - old, name, old, new))
+    if growth:
+        print("\nLargest symbol growth (of the %d largest symbols):" % len(current["symbols"]))
+        for _, name, old, new in sorted(growth, reverse=True)[:SYMBOLS_SHOWN]:
+            print("  %-40s %6d -> %6d" % (name, old, new))
+
+    ok = (flash - baseline["flash"] <= tolerance and
+          ram - baseline["ram"] <= tolerance)
+    print("\n%s (tolerance %d bytes)" % ("OK" if ok else "FOOTPRINT REGRESSION", tolerance))
+    return ok
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("report", help="Size report of the build (build/<project>.size)")
+    parser.add_argument("--baseline", default="tools/footprint_baseline.json",
+                        help="Baseline file, one entry per build profile")
+    parser.add_argument("--tolerance", type=int, default=0,
+                        help="Growth in bytes accepted for flash and RAM")
+    parser.add_argument("--update", action="store_true",
+                        help="Store the report as the baseline of its profile")
+    args = parser.parse_args()
+
+    profile, sections, symbols = read_report(args.report)
+    if not sections:
+        sys.exit("No sections in %s (expected 'size -A -x' output)" % args.report)
+    profile = profile or "perf"
+    flash, ram = totals(sections)
+    current = {
+        "flash": flash,
+        "ram": ram,
+        "sections": {name: size for name, (size, _) in sections.items()},
+        "symbols": symbols,
+    }
+
+    baselines = {}
+    if os.path.exists(args.baseline):
+        with open(args.baseline) as stored:
+            baselines = json.load(stored)
+
+    if args.update:
+        baselines[profile] = current
+        with open(args.baseline, "w") as stored:
+            json.dump(baselines, stored, indent=2, sort_keys=True)
+            stored.write("\n")
+        print("Baseline '%s': flash %d, RAM %d bytes -> %s" % (profile, flash, ram, args.baseline))
+        return
+
+    if profile not in baselines:
+        sys.exit("No '%s' baseline in %s (make footprint-baseline PROFILE=%s)"
+                 % (profile, args.baseline, profile))
+    print("Profile: %s" % profile)
+    if not compare(current, baselines[profile], args.tolerance):
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+"""
+HAL link set check (make hal-usage).
+
+Reads the linker map of a build (build/<project>.map, linked with
+--gc-sections and compiled with -ffunction-sections -fdata-sections) and
+reports, per HAL driver object:
+  - the code and data bytes kept in the image, and those --gc-sections
+    discarded
+  - the largest functions kept
+
+Exits non-zero when an object has code but none of it kept: its module is
+enabled in hal/stm32l0xx_hal_conf.h with no enabled feature calling it, so
+the module switch there (or the Makefile link set) is out of step with
+board_config.h. Objects of disabled modules compile empty and pass.
+"""
+
+import argparse
+import re
+import sys
+from collections import defaultdict
+
+HAL_MARK = "STM32L0xx_HAL_Driver"
+SECTION_PREFIXES = (".text", ".rodata", ".data", ".bss", ".ramfunc")
+FUNCTIONS_SHOWN = 3
+
+# " .text.name  0xaddr  0xsize  object", or the name alone with the rest on
+# the next line when it is long
+ONE_LINE_RE = re.compile(r"^ (\.\S+)\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)\s+(\S+\.o)\s*$")
+NAME_RE = re.compile(r"^ (\.\S+)\s*$")
+REST_RE = re.compile(r"^\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)\s+(\S+\.o)\s*$")
+
+
+def read_map(path):
+    """{object: {"kept": bytes, "discarded": bytes, "functions": {name: size}}}."""
+    objects = defaultdict(lambda: {"kept": 0, "discarded": 0, "functions": {}})
+    part = None
+    pending = None
+    with open(path) as map_file:
+        for line in map_file:
+            line = line.rstrip("\n")
+            if line.startswith("Discarded input sections"):
+                part = "discarded"
+                continue
+            if line.startswith("Linker script and memory map"):
+                part = "kept"
+                continue
+            if part is None:
+                continue
+
+            match = ONE_LINE_RE.match(line)
+            if match:
+                name, _, size, obj = match.groups()
+                pending = None
+            else:
+                match = REST_RE.match(line) if pending else None
+                if match is None:
+                    match = NAME_RE.match(line)
+                    pending = match.group(1) if match else None
+                    continue
+                name = pending
+                _, size, obj = match.groups()
+                pending = None
+
+            if not name.startswith(SECTION_PREFIXES):
+                continue
+            size = int(size, 16)
+            entry = objects[obj]
+            entry[part] += size
+            if part == "kept" and name.startswith(".text.") and size:
+                entry["functions"][name[len(".text."):]] = size
+    return objects
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("map", help="Linker map of the build (build/<project>.map)")
+    parser.add_argument("--all", action="store_true",
+                        help="Report every object, not only the HAL drivers")
+    args = parser.parse_args()
+
+    objects = read_map(args.map)
+    if not objects:
+        sys.exit("No input sections in %s (expected a GNU ld map)" % args.map)
+
+    rows = [(obj, entry) for obj, entry in objects.items()
+            if args.all or HAL_MARK in obj]
+    rows.sort(key=lambda row: -row[1]["kept"])
+
+    unused = []
+    kept_total = discarded_total = 0
+    print("%-32s %8s %10s  %s" % ("object", "kept", "discarded", "largest kept"))
+    for obj, entry in rows:
+        name = obj.rsplit("/", 1)[-1]
+        largest = sorted(entry["functions"].items(), key=lambda f: -f[1])[:FUNCTIONS_SHOWN]
+        print("%-32s %8d %10d  %s" % (name, entry["kept"], entry["discarded"],
+                                      ", ".join("%s %d" % f for f in largest)))
+        kept_total += entry["kept"]
+        discarded_total += entry["discarded"]
+        if entry["kept"] == 0 and entry["discarded"] > 0 and HAL_MARK in obj:
+            unused.append(name)
+    print("%-32s %8d %10d" % ("total", kept_total, discarded_total))
+
+    if unused:
+        print("\nLinked with nothing kept (module enabled, no caller): %s" % ", ".join(unused))
+        print("HAL LINK SET MISMATCH")
+        return 1
+    print("\nOK")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
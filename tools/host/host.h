@@ -0,0 +1,157 @@
+/**
+ * @file host.h
+ * @brief Host harness of the sampling pipeline (make host-test)
+ *
+ * The firmware sources of the pipeline (ms58.c, sensor_sampling.c, dac.c,
+ * the tracker, statistics and latency modules) built natively against a
+ * virtual clock and a mock MS5837 on the ms583730ba01_h transport.
+ *
+ * Virtual time only moves in host_run_us(), from one event to the next:
+ * the TIM2 tick (sensor_sampling_timer_isr()), the exact-mode compare
+ * (sensor_sampling_conversion_isr()) and the end of a sensor bus transfer
+ * (its completion). Each event runs to completion as its handler would,
+ * and a bottom half it pended runs right after it, as PendSV does once
+ * the handlers have returned. A handler takes no virtual time unless it
+ * blocks (host_busy_us()): then the events due meanwhile run once it has
+ * returned, late, and ticks that elapsed more than once are lost as the
+ * TIM2 update flag loses them.
+ */
+
+#ifndef HOST_H
+#define HOST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "board_config.h"
+#include "ms58.h"
+
+/* ============================================================================
+ * MOCK SENSOR
+ * ============================================================================ */
+
+#define HOST_SENSOR_OSR_COUNT  6U
+
+/* Datasheet example conversions (with the example coefficients of
+ * host_sensor_defaults()) */
+#define HOST_DATASHEET_D1      4958179UL
+#define HOST_DATASHEET_D2      6815414UL
+
+/* C0 of the example: ID of the variant built (ms5837_prom_variant_ok()) */
+#if BOARD_SENSOR_VARIANT == BOARD_SENSOR_VARIANT_30BA
+#define HOST_SENSOR_C0         ((uint16_t)(MS5837_ID_30BA26 << 5))
+#else
+#define HOST_SENSOR_C0         ((uint16_t)(MS5837_ID_02BA21 << 5))
+#endif
+
+/**
+ * @brief Behaviour of the mock MS5837
+ *
+ * Conversions take conv_us, the sensor's own time: the sampler waits its
+ * datasheet maximum (or the tuned time), so a slow part reads early. A
+ * fault draw per transfer (seeded, repeatable) can end it in a bus error
+ * or a NACK instead.
+ */
+typedef struct {
+    uint16_t prom[8];                          /* C0..C6 (CRC-4 filled in by host_reset()) */
+    uint32_t d1;                               /* Result of the next pressure conversion */
+    uint32_t d1_noise;                         /* Plus 0..d1_noise, uniform (0: constant) */
+    uint32_t d2;                               /* Result of the next temperature conversion */
+    uint16_t conv_us[HOST_SENSOR_OSR_COUNT];   /* Conversion time per OSR */
+    uint32_t bus_hz;                           /* SCL rate of the transfer time model */
+    bool early_nack;                           /* ADC read of a running conversion: NACK (false: reads 0) */
+    uint32_t nack_ppm;                         /* Transfers NACKed, per million */
+    uint32_t bus_error_ppm;                    /* Transfers ending in a bus error, per million */
+    uint32_t seed;                             /* Fault draws (0: 1) */
+    uint32_t recover_us;                       /* CPU time hal_i2c2_recover() blocks for (0: none) */
+} host_sensor_config_t;
+
+/**
+ * @brief What the mock saw
+ */
+typedef struct {
+    uint32_t transfers;      /* Completed bus transfers */
+    uint32_t conversions;    /* Conversion commands (D1 and D2) */
+    uint32_t adc_reads;      /* ADC reads */
+    uint32_t early_reads;    /* ADC reads before the conversion ended */
+    uint32_t zero_reads;     /* ADC reads answered with 0 (early or repeated) */
+    uint32_t prom_reads;     /* PROM word reads */
+    uint32_t resets;         /* Reset commands */
+    uint32_t nacks;          /* Transfers NACKed (drawn or early reads) */
+    uint32_t bus_errors;     /* Transfers ended by a bus error (drawn or bus held) */
+    uint32_t recoveries;     /* hal_i2c2_recover() calls */
+    uint32_t inits;          /* hal_i2c2_init() calls */
+    uint32_t busy_us;        /* Bus time of all the transfers */
+} host_sensor_stats_t;
+
+/* ============================================================================
+ * HARNESS
+ * ============================================================================ */
+
+/**
+ * @brief Time 0, TIM2 at BOARD_TIM2_FREQ_HZ, the mock idle with the config
+ *
+ * @param config Mock behaviour, copied (NULL: datasheet coefficients,
+ *               conversion times and 400 kHz)
+ */
+void host_reset(const host_sensor_config_t *config);
+
+/**
+ * @brief Default mock behaviour: datasheet example coefficients and
+ *        conversion results, maximum conversion times, 400 kHz, early
+ *        ADC reads NACKed and no drawn faults
+ */
+void host_sensor_defaults(host_sensor_config_t *config);
+
+/**
+ * @brief Mock behaviour in effect, changed in place between runs
+ */
+host_sensor_config_t *host_sensor_config(void);
+
+/**
+ * @brief Counters of the mock since host_reset()
+ */
+void host_sensor_get_stats(host_sensor_stats_t *stats);
+
+/**
+ * @brief Conversion time per OSR the boot calibration hands the sampler,
+ *        changed in place before sensor_sampling_init() (host_reset():
+ *        the datasheet times)
+ */
+uint16_t *host_conv_tune_us(void);
+
+/**
+ * @brief Run the events due in the next duration_us of virtual time
+ */
+void host_run_us(uint32_t duration_us);
+
+/**
+ * @brief The handler running blocks the CPU for duration_us
+ */
+void host_busy_us(uint32_t duration_us);
+
+/**
+ * @brief Virtual time since host_reset()
+ */
+uint32_t host_now_us(void);
+
+/**
+ * @brief Wall-clock nanoseconds (for the throughput figures)
+ */
+uint64_t host_wall_ns(void);
+
+/**
+ * @brief Host time spent in sensor_sampling_bottom_half() and its runs
+ */
+uint64_t host_bottom_half_ns(void);
+uint32_t host_bottom_half_runs(void);
+
+/* ============================================================================
+ * BETWEEN THE HARNESS FILES
+ * ============================================================================ */
+
+/* Mock sensor (host_sensor.c) as seen by the event loop (host_hal.c) */
+void host_sensor_reset(const host_sensor_config_t *config);
+bool host_sensor_next_event(uint32_t *at_us);
+void host_sensor_event(void);
+
+#endif /* HOST_H */
@@ -0,0 +1,125 @@
+/**
+ * @file host_fixmath.c
+ * @brief fixmath.h Cortex-M0+ paths against the C expressions (make host-test)
+ *
+ * Built with -D__ARM_ARCH_6M__, so fixmath.h takes the partial-product
+ * and split-shift code the firmware runs; each result is compared with
+ * the plain 64-bit C expression the function names, over the edge
+ * operands (0, +-1, the 16- and 32-bit limits) crossed with each other
+ * and then random ones. Every fixmath caller (the compensation, the IIR,
+ * the jitter variance, the moving average, the tracker) gets its 64-bit
+ * arithmetic only through these, so they match the generic build as well.
+ *
+ * Exits non-zero if any result differs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "fixmath.h"
+
+#if !defined(__ARM_ARCH_6M__)
+#error "host_fixmath.c checks the Cortex-M0+ paths: build with -D__ARM_ARCH_6M__"
+#endif
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define HOST_FIXMATH_RANDOM   20000000U
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static const uint32_t edges[] = {
+    0, 1, 2, 0xFFFFFFFFUL, 0xFFFFFFFEUL, 0x7FFFFFFFUL, 0x80000000UL, 0x80000001UL,
+    0x0000FFFFUL, 0x00010000UL, 0xFFFF0000UL, 0xFFFF8000UL, 0x00007FFFUL, 0x00008000UL
+};
+
+#define HOST_FIXMATH_EDGES  (sizeof(edges) / sizeof(edges[0]))
+
+static uint64_t rng_state = 0x2545F4914F6CDD1DULL;
+static uint32_t mismatches = 0;
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static uint64_t host_fixmath_rand(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static void host_fixmath_expect(const char *name, uint64_t got, uint64_t expected, uint64_t a, uint64_t b)
+{
+    if (got != expected && mismatches++ < 8U) {
+        printf("  %s(%#llx, %#llx): %#llx, expected %#llx\n", name, (unsigned long long)a,
+               (unsigned long long)b, (unsigned long long)got, (unsigned long long)expected);
+    }
+}
+
+/**
+ * @brief Every function on one operand pair (a and b 32-bit, x 64-bit)
+ */
+static void host_fixmath_check(uint32_t a, uint32_t b, uint64_t x)
+{
+    uint32_t n = b & 63U;
+    /* Accumulator within +-2^61, so acc +- a product cannot overflow (the
+     * callers keep it so; overflow is undefined in both forms) */
+    int64_t acc = (int64_t)x >> 2;
+
+    host_fixmath_expect("umull", fixmath_umull(a, b), (uint64_t)a * b, a, b);
+    host_fixmath_expect("smull", (uint64_t)fixmath_smull((int32_t)a, (int32_t)b),
+                        (uint64_t)((int64_t)(int32_t)a * (int32_t)b), a, b);
+    host_fixmath_expect("smlal", (uint64_t)fixmath_smlal(acc, (int32_t)a, (int32_t)b),
+                        (uint64_t)(acc + (int64_t)(int32_t)a * (int32_t)b), a, b);
+    host_fixmath_expect("smlsl", (uint64_t)fixmath_smlsl(acc, (int32_t)a, (int32_t)b),
+                        (uint64_t)(acc - (int64_t)(int32_t)a * (int32_t)b), a, b);
+    host_fixmath_expect("mul_u64_u32", fixmath_mul_u64_u32(x, b), x * b, x, b);
+    host_fixmath_expect("mul_s64_u32", (uint64_t)fixmath_mul_s64_u32((int64_t)x, b), x * b, x, b);
+    host_fixmath_expect("asr64", (uint64_t)fixmath_asr64((int64_t)x, n), (uint64_t)((int64_t)x >> n), x, n);
+    if (n <= 62U) {
+        host_fixmath_expect("div_pow2", (uint64_t)fixmath_div_pow2((int64_t)x, n),
+                            (uint64_t)((int64_t)x / ((int64_t)1 << n)), x, n);
+    }
+}
+
+/* ============================================================================
+ * MAIN
+ * ============================================================================ */
+
+int main(void)
+{
+    uint32_t pairs = 0;
+
+    printf("fixmath (Cortex-M0+ paths)\n");
+    for (uint32_t i = 0; i < HOST_FIXMATH_EDGES; i++) {
+        for (uint32_t j = 0; j < HOST_FIXMATH_EDGES; j++) {
+            for (uint32_t k = 0; k < HOST_FIXMATH_EDGES; k++) {
+                uint64_t x = ((uint64_t)edges[i] << 32) | edges[k];
+
+                /* Every shift count with these operands */
+                for (uint32_t n = 0; n < 64U; n++) {
+                    host_fixmath_check(edges[j], (edges[i] & ~63UL) | n, x);
+                    pairs++;
+                }
+            }
+        }
+    }
+    for (uint32_t i = 0; i < HOST_FIXMATH_RANDOM; i++) {
+        uint64_t r = host_fixmath_rand();
+
+        host_fixmath_check((uint32_t)r, (uint32_t)(r >> 32), host_fixmath_rand());
+        pairs++;
+    }
+
+    if (mismatches != 0U) {
+        printf("%u of %u operand sets differ\n", (unsigned)mismatches, (unsigned)pairs);
+        return EXIT_FAILURE;
+    }
+    printf("  %u operand sets, all equal\n", (unsigned)pairs);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,345 @@
+/**
+ * @file host_hal.c
+ * @brief Virtual clock and the HAL/board hooks of the pipeline (host build)
+ *
+ * TIM2 is a tick period and a one-shot compare in virtual microseconds,
+ * the timestamp is virtual time itself. The EEPROM holds nothing (every
+ * bring-up reads the PROM from the sensor) and writes to it are dropped,
+ * the DAC hardware calls succeed and do nothing, and a warm boot never
+ * happens. The boot calibration (conv_tune.h) gives the times of
+ * host_conv_tune_us(), the datasheet ones unless a check changes them.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+#include "host.h"
+#include "board_config.h"
+#include "hal_config.h"
+#include "eeprom.h"
+#include "timebase.h"
+#include "board_init.h"
+#include "bus_tune.h"
+#include "conv_tune.h"
+#include "warm_restart.h"
+#include "ms58.h"
+#include "conv_sensor.h"
+#include "sensor_sampling.h"
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static uint32_t now_us = 0;
+
+/* Calibrated conversion times the sampler takes (conv_tune_get_us()) */
+static uint16_t conv_tune_us[HOST_SENSOR_OSR_COUNT];
+
+/* TIM2 */
+static uint32_t tick_period_us = 0;
+static uint32_t next_tick_us = 0;
+static bool compare_armed = false;
+static uint32_t compare_us = 0;
+
+/* PendSV */
+static bool pendsv_pending = false;
+static uint64_t bottom_half_ns = 0;
+static uint32_t bottom_half_runs = 0;
+
+/* Handle storage of the firmware globals the pipeline references */
+I2C_HandleTypeDef hi2c2;
+DAC_HandleTypeDef hdac1;
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static bool host_due(uint32_t at_us, uint32_t end_us)
+{
+    return (int32_t)(end_us - at_us) >= 0;
+}
+
+/**
+ * @brief PendSV once the handler has returned
+ */
+static void host_pendsv(void)
+{
+    while (pendsv_pending) {
+        uint64_t start = host_wall_ns();
+
+        pendsv_pending = false;
+        sensor_sampling_bottom_half();
+        bottom_half_ns += host_wall_ns() - start;
+        bottom_half_runs++;
+    }
+}
+
+/* ============================================================================
+ * HARNESS
+ * ============================================================================ */
+
+void host_reset(const host_sensor_config_t *config)
+{
+    now_us = 0;
+    tick_period_us = 1000000UL / BOARD_TIM2_FREQ_HZ;
+    next_tick_us = tick_period_us;
+    compare_armed = false;
+    pendsv_pending = false;
+    bottom_half_ns = 0;
+    bottom_half_runs = 0;
+    for (uint32_t i = 0; i < HOST_SENSOR_OSR_COUNT; i++) {
+        conv_tune_us[i] = ms5837_conv_sensor.conv_time_us[i];
+    }
+    host_sensor_reset(config);
+}
+
+uint16_t *host_conv_tune_us(void)
+{
+    return conv_tune_us;
+}
+
+void host_run_us(uint32_t duration_us)
+{
+    uint32_t end_us = now_us + duration_us;
+
+    for (;;) {
+        uint32_t xfer_us;
+        bool xfer = host_sensor_next_event(&xfer_us);
+        uint32_t at = next_tick_us;
+        int kind = 0;  /* 0 tick, 1 compare, 2 transfer end */
+
+        /* Earliest first; at the same time the transfer end goes first
+         * (I2C2 has the higher priority) */
+        if (compare_armed && (int32_t)(compare_us - at) <= 0) {
+            at = compare_us;
+            kind = 1;
+        }
+        if (xfer && (int32_t)(xfer_us - at) <= 0) {
+            at = xfer_us;
+            kind = 2;
+        }
+        if (!host_due(at, end_us)) {
+            break;
+        }
+
+        /* Due while a handler blocked: runs once it has returned */
+        if (host_due(at, now_us)) {
+            at = now_us;
+        }
+        now_us = at;
+        if (kind == 2) {
+            host_sensor_event();
+        } else if (kind == 1) {
+            compare_armed = false;
+            sensor_sampling_conversion_isr();
+        } else {
+            /* One update flag: the ticks that elapsed meanwhile are lost */
+            do {
+                next_tick_us += tick_period_us;
+            } while (host_due(next_tick_us, now_us));
+            sensor_sampling_timer_isr();
+        }
+        host_pendsv();
+        sensor_sampling_poll();  /* Main loop between the handlers */
+    }
+    if (host_due(now_us, end_us)) {
+        now_us = end_us;
+    }
+}
+
+void host_busy_us(uint32_t duration_us)
+{
+    now_us += duration_us;
+}
+
+uint32_t host_now_us(void)
+{
+    return now_us;
+}
+
+uint64_t host_wall_ns(void)
+{
+    struct timespec ts;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t host_bottom_half_ns(void)
+{
+    return bottom_half_ns;
+}
+
+uint32_t host_bottom_half_runs(void)
+{
+    return bottom_half_runs;
+}
+
+/* ============================================================================
+ * HAL (hal_config.h)
+ * ============================================================================ */
+
+bool hal_tim2_tick_pending(void)
+{
+    return host_due(next_tick_us, now_us);  /* The handler blocked past the next tick */
+}
+
+bool hal_tim2_schedule_us(uint32_t delay_us)
+{
+    if (compare_armed) {
+        return false;
+    }
+    compare_armed = true;
+    compare_us = now_us + delay_us;
+    return true;
+}
+
+bool hal_tim2_set_rate_hz(uint32_t rate_hz)
+{
+    if (rate_hz == 0U || rate_hz > BOARD_TIM2_FREQ_HZ ||
+        BOARD_TIM2_COUNTER_HZ / rate_hz > 65536UL) {
+        return false;
+    }
+    /* Takes effect at the next update event */
+    tick_period_us = (uint32_t)((BOARD_TIM2_COUNTER_HZ + rate_hz / 2U) / rate_hz);
+    return true;
+}
+
+uint32_t hal_tim2_get_rate_hz(void)
+{
+    return (uint32_t)((BOARD_TIM2_COUNTER_HZ + tick_period_us / 2U) / tick_period_us);
+}
+
+uint32_t hal_tim2_get_timestamp_us(void)
+{
+    return now_us;
+}
+
+bool hal_tim2_restart_period(void)
+{
+    next_tick_us = now_us + tick_period_us;
+    return true;
+}
+
+bool hal_tim2_trim_period(int32_t counts)
+{
+    if (counts > (int32_t)(tick_period_us / 2U) || counts < -(int32_t)(tick_period_us / 2U)) {
+        return false;
+    }
+    next_tick_us += (uint32_t)counts;
+    return true;
+}
+
+void hal_pendsv_trigger(void)
+{
+    pendsv_pending = true;
+}
+
+uint32_t hal_irq_mask(uint32_t lines)
+{
+    return lines;
+}
+
+void hal_irq_unmask(uint32_t saved)
+{
+    (void)saved;
+}
+
+bool hal_dac1_set_trigger(bool timed)
+{
+    (void)timed;
+    return true;
+}
+
+bool hal_dac1_stream_timer_start(uint32_t rate_hz)
+{
+    (void)rate_hz;
+    return true;
+}
+
+void hal_dac1_stream_timer_stop(void)
+{
+}
+
+/* ============================================================================
+ * STM32 HAL DAC/DMA (dac.c)
+ * ============================================================================ */
+
+HAL_StatusTypeDef HAL_DAC_Start(DAC_HandleTypeDef *hdac, uint32_t Channel)
+{
+    (void)hdac;
+    (void)Channel;
+    return HAL_OK;
+}
+
+uint32_t HAL_DAC_GetValue(DAC_HandleTypeDef *hdac, uint32_t Channel)
+{
+    (void)hdac;
+    (void)Channel;
+    return 0;
+}
+
+HAL_StatusTypeDef HAL_DMA_Start_IT(DMA_HandleTypeDef *hdma, uint32_t SrcAddress,
+                                   uint32_t DstAddress, uint32_t DataLength)
+{
+    (void)hdma;
+    (void)SrcAddress;
+    (void)DstAddress;
+    (void)DataLength;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_Abort(DMA_HandleTypeDef *hdma)
+{
+    (void)hdma;
+    return HAL_OK;
+}
+
+/* ============================================================================
+ * BOARD AND DRIVERS
+ * ============================================================================ */
+
+uint32_t board_get_uptime_us(void)
+{
+    return now_us;
+}
+
+uint32_t timebase_now_us(void)
+{
+    return now_us;
+}
+
+uint16_t timebase_count(void)
+{
+    return (uint16_t)now_us;
+}
+
+bool eeprom_read_words(uint32_t offset, uint32_t *words, uint32_t count)
+{
+    (void)offset;
+    (void)words;
+    (void)count;
+    return false;
+}
+
+bool eeprom_write_async(uint32_t offset, const uint32_t *words, uint32_t count)
+{
+    (void)offset;
+    (void)words;
+    (void)count;
+    return true;
+}
+
+bool warm_restart_is_warm(void)
+{
+    return false;
+}
+
+void bus_tune_on_bus_error(void)
+{
+}
+
+uint16_t conv_tune_get_us(uint8_t osr)
+{
+    return (osr < HOST_SENSOR_OSR_COUNT) ? conv_tune_us[osr] : 0U;
+}
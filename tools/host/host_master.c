@@ -0,0 +1,593 @@
+/**
+ * @file host_master.c
+ * @brief Host checks of the master-side library against the firmware
+ *        (make host-test)
+ *
+ * host/sensor_host.c talks to a fake slave whose FIFO stream is the
+ * firmware's own host_fifo.c (and, in codec builds, sample_codec.c),
+ * built once per frame format (Makefile HOST_MASTER_CFLAGS_*): records
+ * without CRC, and codec frames with CRC framing. Samples pushed on the
+ * firmware side must come out of sensor_host_fifo_drain() as pushed,
+ * the samples lost to overflows or a short read counted as gaps. The
+ * rest of the register image is plain bytes the checks set, with the
+ * offsets, opcodes and codes of sensor_host.h asserted against the
+ * firmware headers at compile time.
+ *
+ * Exits non-zero if any check failed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "board_config.h"
+#include "hal_config.h"
+#include "app.h"
+#include "host_command.h"
+#include "host_fifo.h"
+#include "time_sync.h"
+#include "crc.h"
+#include "sample_codec.h"
+#include "sensor_host.h"
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define HOST_MASTER_ADDR       0x10U
+#define HOST_MASTER_ROUNDS     2000U
+#define HOST_MASTER_MAX        255U   /* Samples a codec frame can count */
+#define HOST_MASTER_SYNC_US    123456789UL
+#define HOST_MASTER_CMD_LAST   (APP_REG_CMD_ARG + APP_REG_CMD_SIZE - 1U)  /* Queues the command */
+
+#define HOST_CHECK(cond, ...) do {            \
+        if (!(cond)) {                        \
+            failures++;                       \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__);              \
+            printf("\n");                     \
+        }                                     \
+    } while (0)
+
+/* sensor_host.h mirrors the firmware byte for byte */
+#define HOST_MASTER_SAME(host, fw)  _Static_assert((host) == (fw), #host " is not " #fw)
+
+HOST_MASTER_SAME(SENSOR_HOST_REG_PRESSURE, APP_REG_PRESSURE);
+HOST_MASTER_SAME(SENSOR_HOST_REG_TEMPERATURE, APP_REG_TEMPERATURE);
+HOST_MASTER_SAME(SENSOR_HOST_REG_TIMESTAMP, APP_REG_TIMESTAMP);
+HOST_MASTER_SAME(SENSOR_HOST_REG_SEQUENCE, APP_REG_SEQUENCE);
+HOST_MASTER_SAME(SENSOR_HOST_REG_STATUS, APP_REG_STATUS);
+HOST_MASTER_SAME(SENSOR_HOST_REG_FIFO_LEVEL, APP_REG_FIFO_LEVEL);
+HOST_MASTER_SAME(SENSOR_HOST_REG_CMD_STATUS, APP_REG_CMD_STATUS);
+HOST_MASTER_SAME(SENSOR_HOST_REG_ALARM, APP_REG_ALARM);
+HOST_MASTER_SAME(SENSOR_HOST_REG_FIFO_OVERFLOWS, APP_REG_FIFO_OVERFLOWS);
+HOST_MASTER_SAME(SENSOR_HOST_REG_DAC_FAULT, APP_REG_DAC_FAULT);
+HOST_MASTER_SAME(SENSOR_HOST_REG_BURST_STATE, APP_REG_BURST_STATE);
+HOST_MASTER_SAME(SENSOR_HOST_REG_BURST_COUNT, APP_REG_BURST_COUNT);
+HOST_MASTER_SAME(SENSOR_HOST_REG_DAC_READBACK, APP_REG_DAC_READBACK);
+HOST_MASTER_SAME(SENSOR_HOST_REG_CMD_ARG, APP_REG_CMD_ARG);
+HOST_MASTER_SAME(SENSOR_HOST_REG_CMD_OPCODE, APP_REG_CMD_OPCODE);
+#if BOARD_CRC_FRAMING_ENABLE
+HOST_MASTER_SAME(SENSOR_HOST_REG_CMD_CRC, APP_REG_CMD_CRC);
+#endif
+HOST_MASTER_SAME(SENSOR_HOST_REG_SYNC_STATE, APP_REG_SYNC_STATE);
+HOST_MASTER_SAME(SENSOR_HOST_REG_EVENT_ACTIVE, APP_REG_EVENT_ACTIVE);
+HOST_MASTER_SAME(SENSOR_HOST_REG_EVENT_PENDING, APP_REG_EVENT_PENDING);
+HOST_MASTER_SAME(SENSOR_HOST_REG_EVENT_OLDEST, APP_REG_EVENT_OLDEST);
+HOST_MASTER_SAME(SENSOR_HOST_REG_EVENT_DROPPED, APP_REG_EVENT_DROPPED);
+HOST_MASTER_SAME(SENSOR_HOST_REG_EVENT_SEQ, APP_REG_EVENT_SEQ);
+HOST_MASTER_SAME(SENSOR_HOST_REG_FIFO, APP_REG_FIFO);
+HOST_MASTER_SAME(SENSOR_HOST_REG_PERF, APP_REG_PERF);
+HOST_MASTER_SAME(SENSOR_HOST_REG_WAVE, APP_REG_WAVE);
+HOST_MASTER_SAME(SENSOR_HOST_REG_PROBE, APP_REG_PROBE);
+HOST_MASTER_SAME(SENSOR_HOST_REG_BENCH, APP_REG_BENCH);
+HOST_MASTER_SAME(SENSOR_HOST_REG_FAULT, APP_REG_FAULT);
+HOST_MASTER_SAME(SENSOR_HOST_REG_LAT_STAGE, APP_REG_LAT_STAGE);
+HOST_MASTER_SAME(SENSOR_HOST_REG_LAT_BUCKET, APP_REG_LAT_BUCKET);
+HOST_MASTER_SAME(SENSOR_HOST_REG_LAT_P50, APP_REG_LAT_P50);
+HOST_MASTER_SAME(SENSOR_HOST_REG_LAT_P99, APP_REG_LAT_P99);
+HOST_MASTER_SAME(SENSOR_HOST_REG_LAT_COUNT, APP_REG_LAT_COUNT);
+HOST_MASTER_SAME(SENSOR_HOST_REG_LAT_TOTAL, APP_REG_LAT_TOTAL);
+HOST_MASTER_SAME(SENSOR_HOST_REG_I2C_READS, APP_REG_I2C_READS);
+HOST_MASTER_SAME(SENSOR_HOST_REG_I2C_WRITES, APP_REG_I2C_WRITES);
+HOST_MASTER_SAME(SENSOR_HOST_REG_I2C_NACKS, APP_REG_I2C_NACKS);
+HOST_MASTER_SAME(SENSOR_HOST_REG_I2C_ERRORS, APP_REG_I2C_ERRORS);
+HOST_MASTER_SAME(SENSOR_HOST_REG_I2C_OVERRUNS, APP_REG_I2C_OVERRUNS);
+HOST_MASTER_SAME(SENSOR_HOST_REG_I2C_REARMS, APP_REG_I2C_REARMS);
+HOST_MASTER_SAME(SENSOR_HOST_REG_I2C_LAT_MIN, APP_REG_I2C_LAT_MIN);
+HOST_MASTER_SAME(SENSOR_HOST_REG_I2C_LAT_MAX, APP_REG_I2C_LAT_MAX);
+HOST_MASTER_SAME(SENSOR_HOST_REG_I2C_LAT_MEAN, APP_REG_I2C_LAT_MEAN);
+HOST_MASTER_SAME(SENSOR_HOST_REG_ALARM_COUNT, APP_REG_ALARM_COUNT);
+HOST_MASTER_SAME(SENSOR_HOST_REG_ALARM_TIME, APP_REG_ALARM_TIME);
+HOST_MASTER_SAME(SENSOR_HOST_REG_PROF_SITE, APP_REG_PROF_SITE);
+HOST_MASTER_SAME(SENSOR_HOST_REG_I2C2_SPEED, APP_REG_I2C2_SPEED);
+HOST_MASTER_SAME(SENSOR_HOST_REG_I2C3_SPEED, APP_REG_I2C3_SPEED);
+HOST_MASTER_SAME(SENSOR_HOST_REG_I2C_RESETS, APP_REG_I2C_RESETS);
+HOST_MASTER_SAME(SENSOR_HOST_REG_PROF_COUNT, APP_REG_PROF_COUNT);
+HOST_MASTER_SAME(SENSOR_HOST_REG_PROF_MIN, APP_REG_PROF_MIN);
+HOST_MASTER_SAME(SENSOR_HOST_REG_PROF_MAX, APP_REG_PROF_MAX);
+HOST_MASTER_SAME(SENSOR_HOST_REG_PROF_MEAN, APP_REG_PROF_MEAN);
+HOST_MASTER_SAME(SENSOR_HOST_REG_BOOT_BOARD, APP_REG_BOOT_BOARD);
+HOST_MASTER_SAME(SENSOR_HOST_REG_BOOT_DRIVERS, APP_REG_BOOT_DRIVERS);
+HOST_MASTER_SAME(SENSOR_HOST_REG_BOOT_APP, APP_REG_BOOT_APP);
+HOST_MASTER_SAME(SENSOR_HOST_REG_BOOT_SAMPLE, APP_REG_BOOT_SAMPLE);
+HOST_MASTER_SAME(SENSOR_HOST_REG_TICK_OVERRUNS, APP_REG_TICK_OVERRUNS);
+HOST_MASTER_SAME(SENSOR_HOST_REG_TICK_MAX, APP_REG_TICK_MAX);
+HOST_MASTER_SAME(SENSOR_HOST_REG_TICK_MAX_STATE, APP_REG_TICK_MAX_STATE);
+HOST_MASTER_SAME(SENSOR_HOST_REG_JITTER_PEAK, APP_REG_JITTER_PEAK);
+HOST_MASTER_SAME(SENSOR_HOST_REG_JITTER_STDDEV, APP_REG_JITTER_STDDEV);
+HOST_MASTER_SAME(SENSOR_HOST_REG_TICK_PERIOD, APP_REG_TICK_PERIOD);
+HOST_MASTER_SAME(SENSOR_HOST_REG_STACK_PEAK, APP_REG_STACK_PEAK);
+HOST_MASTER_SAME(SENSOR_HOST_REG_STACK_FREE, APP_REG_STACK_FREE);
+HOST_MASTER_SAME(SENSOR_HOST_REG_ELOG_NEWEST, APP_REG_ELOG_NEWEST);
+HOST_MASTER_SAME(SENSOR_HOST_REG_ELOG_SEQ, APP_REG_ELOG_SEQ);
+HOST_MASTER_SAME(SENSOR_HOST_REG_ELOG_TYPE, APP_REG_ELOG_TYPE);
+HOST_MASTER_SAME(SENSOR_HOST_REG_QUALITY, APP_REG_QUALITY);
+HOST_MASTER_SAME(SENSOR_HOST_REG_ERROR_COUNT, APP_REG_ERROR_COUNT);
+HOST_MASTER_SAME(SENSOR_HOST_REG_ELOG_DATA, APP_REG_ELOG_DATA);
+HOST_MASTER_SAME(SENSOR_HOST_REG_STATS_WINDOW, APP_REG_STATS_WINDOW);
+HOST_MASTER_SAME(SENSOR_HOST_REG_STATS_SEQ, APP_REG_STATS_SEQ);
+HOST_MASTER_SAME(SENSOR_HOST_REG_STATS_END, APP_REG_STATS_END);
+HOST_MASTER_SAME(SENSOR_HOST_REG_STATS_P_MIN, APP_REG_STATS_P_MIN);
+HOST_MASTER_SAME(SENSOR_HOST_REG_STATS_P_MAX, APP_REG_STATS_P_MAX);
+HOST_MASTER_SAME(SENSOR_HOST_REG_STATS_P_MEAN, APP_REG_STATS_P_MEAN);
+HOST_MASTER_SAME(SENSOR_HOST_REG_STATS_P_VAR, APP_REG_STATS_P_VAR);
+HOST_MASTER_SAME(SENSOR_HOST_REG_STATS_T_MIN, APP_REG_STATS_T_MIN);
+HOST_MASTER_SAME(SENSOR_HOST_REG_STATS_T_MAX, APP_REG_STATS_T_MAX);
+HOST_MASTER_SAME(SENSOR_HOST_REG_STATS_T_MEAN, APP_REG_STATS_T_MEAN);
+HOST_MASTER_SAME(SENSOR_HOST_REG_STATS_T_VAR, APP_REG_STATS_T_VAR);
+HOST_MASTER_SAME(SENSOR_HOST_REG_DERIVED, APP_REG_DERIVED);
+HOST_MASTER_SAME(SENSOR_HOST_REG_TRACK_PRESSURE, APP_REG_TRACK_PRESSURE);
+HOST_MASTER_SAME(SENSOR_HOST_REG_TRACK_RATE, APP_REG_TRACK_RATE);
+HOST_MASTER_SAME(SENSOR_HOST_REG_PRESSURE_UNIT, APP_REG_PRESSURE_UNIT);
+HOST_MASTER_SAME(SENSOR_HOST_REG_BLOCK_SIZE, APP_REG_BLOCK_SIZE);
+HOST_MASTER_SAME(SENSOR_HOST_REG_DAC_SET_OUT1, APP_REG_DAC_SET_OUT1);
+HOST_MASTER_SAME(SENSOR_HOST_REG_DAC_SET_OUT2, APP_REG_DAC_SET_OUT2);
+HOST_MASTER_SAME(SENSOR_HOST_REG_DAC_SET_SIZE, APP_REG_DAC_SET_SIZE);
+
+HOST_MASTER_SAME(SENSOR_HOST_ALARM_ARMED, APP_ALARM_ARMED);
+HOST_MASTER_SAME(SENSOR_HOST_ALARM_TRIPPED, APP_ALARM_TRIPPED);
+HOST_MASTER_SAME(SENSOR_HOST_ALARM_ABOVE, APP_ALARM_ABOVE);
+HOST_MASTER_SAME(SENSOR_HOST_ELOG_BOOT, APP_ELOG_BOOT);
+HOST_MASTER_SAME(SENSOR_HOST_ELOG_STATS, APP_ELOG_STATS);
+HOST_MASTER_SAME(SENSOR_HOST_ELOG_ERRORS, APP_ELOG_ERRORS);
+HOST_MASTER_SAME(SENSOR_HOST_ELOG_ALARM, APP_ELOG_ALARM);
+HOST_MASTER_SAME(SENSOR_HOST_ELOG_FAULT, APP_ELOG_FAULT);
+
+HOST_MASTER_SAME(SENSOR_HOST_CMD_NOP, HOST_CMD_NOP);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_SET_OSR, HOST_CMD_SET_OSR);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_SET_RATE, HOST_CMD_SET_RATE);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_SET_FILTER, HOST_CMD_SET_FILTER);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_SET_DAC_MAP, HOST_CMD_SET_DAC_MAP);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_DAC_STREAM, HOST_CMD_DAC_STREAM);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_DAC_CAL, HOST_CMD_DAC_CAL);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_SET_ALARM, HOST_CMD_SET_ALARM);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_PROF, HOST_CMD_PROF);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_SD_LOG, HOST_CMD_SD_LOG);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_EVENT_LOG, HOST_CMD_EVENT_LOG);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_FLASH_CAPTURE, HOST_CMD_FLASH_CAPTURE);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_CONFIG, HOST_CMD_CONFIG);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_STATS_WINDOW, HOST_CMD_STATS_WINDOW);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_DERIVED, HOST_CMD_DERIVED);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_EVENT_SET, HOST_CMD_EVENT_SET);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_EVENT_ACK, HOST_CMD_EVENT_ACK);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_PRESSURE_UNIT, HOST_CMD_PRESSURE_UNIT);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_OUTPUT_RATE, HOST_CMD_OUTPUT_RATE);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_LATENCY, HOST_CMD_LATENCY);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_BURST, HOST_CMD_BURST);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_BURST_ARM, HOST_CMD_BURST_ARM);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_TIME_SYNC, HOST_CMD_TIME_SYNC);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_SYNC_IN, HOST_CMD_SYNC_IN);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_FW_UPDATE, HOST_CMD_FW_UPDATE);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_FW_DATA, HOST_CMD_FW_DATA);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_PROBE, HOST_CMD_PROBE);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_STALE, HOST_CMD_STALE);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_BENCH, HOST_CMD_BENCH);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_DAC_SETPOINT, HOST_CMD_DAC_SETPOINT);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_DAC_WAVE, HOST_CMD_DAC_WAVE);
+HOST_MASTER_SAME(SENSOR_HOST_CMD_POLL_ALIGN, HOST_CMD_POLL_ALIGN);
+
+HOST_MASTER_SAME(SENSOR_HOST_RESULT_OK, HOST_CMD_RESULT_OK);
+HOST_MASTER_SAME(SENSOR_HOST_RESULT_BAD_OPCODE, HOST_CMD_RESULT_BAD_OPCODE);
+HOST_MASTER_SAME(SENSOR_HOST_RESULT_BAD_ARGUMENT, HOST_CMD_RESULT_BAD_ARGUMENT);
+HOST_MASTER_SAME(SENSOR_HOST_RESULT_FAILED, HOST_CMD_RESULT_FAILED);
+HOST_MASTER_SAME(SENSOR_HOST_RESULT_BAD_CRC, HOST_CMD_RESULT_BAD_CRC);
+HOST_MASTER_SAME(SENSOR_HOST_RESULT_NONE, HOST_CMD_RESULT_NONE);
+HOST_MASTER_SAME(SENSOR_HOST_STATUS_IDLE, SENSOR_STATUS_IDLE);
+HOST_MASTER_SAME(SENSOR_HOST_STATUS_WARMING_UP, SENSOR_STATUS_WARMING_UP);
+HOST_MASTER_SAME(SENSOR_HOST_STATUS_RUNNING, SENSOR_STATUS_RUNNING);
+HOST_MASTER_SAME(SENSOR_HOST_STATUS_ERROR, SENSOR_STATUS_ERROR);
+HOST_MASTER_SAME(SENSOR_HOST_STATUS_STALE, SENSOR_STATUS_STALE);
+HOST_MASTER_SAME(SENSOR_HOST_SYNC_NONE, TIME_SYNC_NONE);
+HOST_MASTER_SAME(SENSOR_HOST_SYNC_OFFSET, TIME_SYNC_OFFSET);
+HOST_MASTER_SAME(SENSOR_HOST_SYNC_LOCKED, TIME_SYNC_LOCKED);
+
+HOST_MASTER_SAME(SENSOR_HOST_FIFO_HEADER_BYTES, HOST_FIFO_HEADER_SIZE);
+HOST_MASTER_SAME(SENSOR_HOST_RECORD_BYTES, HOST_FIFO_SAMPLE_SIZE);
+HOST_MASTER_SAME(SENSOR_HOST_FIFO_DEPTH, HOST_FIFO_DEPTH);
+HOST_MASTER_SAME(SENSOR_HOST_FIFO_FORMAT_CODEC, HOST_FIFO_FORMAT_CODEC);
+HOST_MASTER_SAME(SENSOR_HOST_FIFO_FORMAT_RECORD, HOST_FIFO_FORMAT_RECORD);
+HOST_MASTER_SAME(SENSOR_HOST_CODEC_TAG_KEYFRAME, SAMPLE_CODEC_TAG_KEYFRAME);
+HOST_MASTER_SAME(SENSOR_HOST_CODEC_MAX_BYTES, SAMPLE_CODEC_MAX_BYTES);
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static uint32_t failures = 0;
+static uint32_t rng_state = 4242U;
+
+/* Fake slave */
+static uint8_t regs[256];        /* Register image */
+static bool bus_down = false;    /* Every transfer fails */
+static bool corrupt = false;     /* Next FIFO frame: one payload bit flipped */
+static uint32_t delays = 0;      /* delay_us() calls */
+static uint32_t overflows_seen = 0;
+
+static sensor_host_sample_t pushed[HOST_MASTER_MAX * 2U];
+static size_t pushed_count = 0;
+
+/* ============================================================================
+ * FIRMWARE STUBS
+ * ============================================================================ */
+
+uint32_t hal_irq_mask(uint32_t lines)
+{
+    (void)lines;
+    return 0;
+}
+
+void hal_irq_unmask(uint32_t saved)
+{
+    (void)saved;
+}
+
+bool warm_restart_is_warm(void)
+{
+    return false;
+}
+
+/* The CRC peripheral as crc.c sets it up: CRC-16, polynomial 0x1021, no
+ * reflection */
+uint16_t crc16_update(uint16_t crc, const void *data, uint32_t len)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+
+    while (len-- > 0U) {
+        crc ^= (uint16_t)(*bytes++ << 8);
+        for (uint32_t bit = 0; bit < 8U; bit++) {
+            crc = (uint16_t)((crc & 0x8000U) ? (((uint32_t)crc << 1) ^ 0x1021U) : ((uint32_t)crc << 1));
+        }
+    }
+    return crc;
+}
+
+/* ============================================================================
+ * FAKE SLAVE (sensor_host_transport_t)
+ * ============================================================================ */
+
+static uint32_t host_master_rand(void)
+{
+    rng_state = rng_state * 1664525UL + 1013904223UL;
+    return rng_state;
+}
+
+static void host_master_put32(uint8_t reg, uint32_t value)
+{
+    regs[reg] = (uint8_t)value;
+    regs[reg + 1U] = (uint8_t)(value >> 8);
+    regs[reg + 2U] = (uint8_t)(value >> 16);
+    regs[reg + 3U] = (uint8_t)(value >> 24);
+}
+
+static uint32_t host_master_get32(uint8_t reg)
+{
+    return (uint32_t)regs[reg] | ((uint32_t)regs[reg + 1U] << 8) |
+           ((uint32_t)regs[reg + 2U] << 16) | ((uint32_t)regs[reg + 3U] << 24);
+}
+
+/**
+ * @brief A write reaching the last command byte (the opcode, or the CRC
+ *        with CRC framing): result at 0x12, as host_command.c checks and
+ *        reports it
+ */
+static void host_master_command(void)
+{
+    uint8_t result = HOST_CMD_RESULT_OK;
+
+#if BOARD_CRC_FRAMING_ENABLE
+    uint16_t crc = (uint16_t)(regs[APP_REG_CMD_CRC] | (regs[APP_REG_CMD_CRC + 1U] << 8));
+
+    if (crc16_update(CRC16_INIT, &regs[APP_REG_CMD_ARG], 5U) != crc) {
+        result = HOST_CMD_RESULT_BAD_CRC;
+    }
+#endif
+    regs[APP_REG_CMD_STATUS] = result;
+}
+
+static int host_master_write_read(void *ctx, uint8_t addr, const uint8_t *wr, size_t wlen,
+                                  uint8_t *rd, size_t rlen)
+{
+    uint8_t reg;
+
+    (void)ctx;
+    if (bus_down || addr != HOST_MASTER_ADDR || wlen == 0U || wr[0] + wlen - 1U > sizeof(regs)) {
+        return -1;
+    }
+    reg = wr[0];
+    memcpy(&regs[reg], &wr[1], wlen - 1U);
+    if (reg <= HOST_MASTER_CMD_LAST && reg + wlen - 1U > HOST_MASTER_CMD_LAST) {
+        host_master_command();
+    }
+    if (rlen == 0U) {
+        return 0;
+    }
+
+    if (reg == APP_REG_FIFO) {
+        /* The whole frame is handed over at address match; past its end
+         * the slave sends 0xFF */
+        uint16_t len;
+        const uint8_t *frame = host_fifo_take_frame(&len);
+
+        memset(rd, 0xFF, rlen);
+        memcpy(rd, frame, (len < rlen) ? len : rlen);
+        if (corrupt && len > HOST_FIFO_HEADER_SIZE && rlen > HOST_FIFO_HEADER_SIZE) {
+            rd[HOST_FIFO_HEADER_SIZE] ^= 0x10U;
+        }
+        corrupt = false;
+        return 0;
+    }
+    regs[APP_REG_FIFO_LEVEL] = host_fifo_get_level();
+    if (reg + rlen > sizeof(regs)) {
+        return -1;
+    }
+    memcpy(rd, &regs[reg], rlen);
+    return 0;
+}
+
+static uint32_t host_master_now_us(void *ctx)
+{
+    (void)ctx;
+    return HOST_MASTER_SYNC_US;
+}
+
+static void host_master_delay_us(void *ctx, uint32_t us)
+{
+    (void)ctx;
+    (void)us;
+    delays++;
+}
+
+static const sensor_host_transport_t host_master_bus = {
+    .write_read = host_master_write_read,
+    .now_us = host_master_now_us,
+    .delay_us = host_master_delay_us,
+    .ctx = NULL,
+};
+
+static uint8_t host_master_flags(void)
+{
+    return BOARD_CRC_FRAMING_ENABLE ? SENSOR_HOST_CRC_FRAMING : 0U;
+}
+
+/* ============================================================================
+ * CHECKS
+ * ============================================================================ */
+
+/**
+ * @brief CRC-16/CCITT-FALSE check value, and the stand-in of the peripheral
+ */
+static void host_test_crc(void)
+{
+    static const uint8_t check[] = "123456789";
+
+    HOST_CHECK(sensor_host_crc16(0xFFFFU, check, 9U) == 0x29B1U, "sensor_host_crc16: 0x%04X",
+               (unsigned)sensor_host_crc16(0xFFFFU, check, 9U));
+    HOST_CHECK(crc16_update(CRC16_INIT, check, 9U) == 0x29B1U, "crc16_update stand-in: 0x%04X",
+               (unsigned)crc16_update(CRC16_INIT, check, 9U));
+}
+
+static void host_test_snapshot(void)
+{
+    sensor_host_t dev;
+    sensor_host_snapshot_t snap;
+
+    memset(regs, 0, sizeof(regs));
+    host_fifo_init();
+    host_master_put32(APP_REG_PRESSURE, (uint32_t)-101325);
+    host_master_put32(APP_REG_TEMPERATURE, 2150U);
+    host_master_put32(APP_REG_TIMESTAMP, 0xCAFEF00DUL);
+    host_master_put32(APP_REG_SEQUENCE, 0x01020304UL);
+    regs[APP_REG_STATUS] = SENSOR_STATUS_RUNNING;
+    regs[APP_REG_CMD_STATUS] = HOST_CMD_RESULT_FAILED;
+    regs[APP_REG_ALARM] = APP_ALARM_ARMED | APP_ALARM_ABOVE;
+    host_master_put32(APP_REG_FIFO_OVERFLOWS, 77U);
+
+    sensor_host_init(&dev, &host_master_bus, HOST_MASTER_ADDR, host_master_flags());
+    HOST_CHECK(sensor_host_snapshot(&dev, &snap) == SENSOR_HOST_OK, "snapshot: transfer");
+    HOST_CHECK(snap.pressure == -101325 && snap.temperature == 2150 &&
+               snap.timestamp_us == 0xCAFEF00DUL && snap.sequence == 0x01020304UL &&
+               snap.status == SENSOR_HOST_STATUS_RUNNING && snap.fifo_level == 0U &&
+               snap.cmd_status == SENSOR_HOST_RESULT_FAILED &&
+               snap.alarm == (SENSOR_HOST_ALARM_ARMED | SENSOR_HOST_ALARM_ABOVE) &&
+               snap.fifo_overflows == 77U,
+               "snapshot: %d %d %08X %08X status %u level %u cmd %u alarm %u overflows %u",
+               (int)snap.pressure, (int)snap.temperature, (unsigned)snap.timestamp_us,
+               (unsigned)snap.sequence, (unsigned)snap.status, (unsigned)snap.fifo_level,
+               (unsigned)snap.cmd_status, (unsigned)snap.alarm, (unsigned)snap.fifo_overflows);
+
+    bus_down = true;
+    HOST_CHECK(sensor_host_snapshot(&dev, &snap) == SENSOR_HOST_ERR_BUS, "snapshot: bus error not reported");
+    bus_down = false;
+}
+
+/**
+ * @brief Push n samples on the firmware side: steady steps with now and
+ *        then a jump the codec cannot take as a delta
+ */
+static void host_master_push(uint32_t n, sensor_data_t *next)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t r = host_master_rand();
+
+        next->sequence += 1U + ((r & 0xF000U) == 0U ? 3U : 0U);  /* Sampler drops */
+        next->timestamp_us += 2000U + (r & 7U);
+        next->pressure += (int32_t)((r >> 8) & 0x3FU) - 32;
+        next->temperature += (int32_t)((r >> 16) & 3U) - 1;
+        if ((r >> 24) == 0U) {
+            next->pressure ^= 0x40000000L;
+        }
+        if (host_fifo_push(next)) {
+            pushed[pushed_count].timestamp_us = next->timestamp_us;
+            pushed[pushed_count].sequence = next->sequence;
+            pushed[pushed_count].pressure = next->pressure;
+            pushed[pushed_count].temperature = next->temperature;
+            pushed_count++;
+        } else {
+            overflows_seen++;
+        }
+    }
+}
+
+/**
+ * @brief Random fills, drained with the level read (or taken from 0x11),
+ *        every sample compared with the one pushed
+ */
+static void host_test_drain(void)
+{
+    sensor_host_t dev;
+    sensor_host_sample_t got[HOST_MASTER_MAX];
+    sensor_data_t next = { .timestamp_us = 0xFFFF0000UL, .sequence = 0xFFFFFFF0UL,
+                           .pressure = 101325, .temperature = 2000, .valid = true };
+    uint32_t wrong = 0;
+    uint32_t failed = 0;
+    uint32_t samples = 0;
+    uint32_t first = 0;
+    uint32_t last = 0;
+    uint32_t drops;
+
+    host_fifo_init();
+    sensor_host_init(&dev, &host_master_bus, HOST_MASTER_ADDR, host_master_flags());
+    for (uint32_t round = 0; round < HOST_MASTER_ROUNDS; round++) {
+        uint32_t n = host_master_rand() % (HOST_MASTER_MAX / 2U);
+        int level;
+        size_t count;
+        int ret;
+
+        pushed_count = 0;
+        host_master_push(n, &next);
+        level = (round & 1U) ? -1 : (int)host_fifo_get_level();
+        ret = sensor_host_fifo_drain(&dev, got, HOST_MASTER_MAX, level, &count);
+        failed += ret != SENSOR_HOST_OK;
+        wrong += count != pushed_count;
+        for (size_t i = 0; i < count && i < pushed_count; i++) {
+            wrong += memcmp(&got[i], &pushed[i], sizeof(got[i])) != 0;
+        }
+        if (samples == 0U && count != 0U) {
+            first = got[0].sequence;
+        }
+        if (count != 0U) {
+            last = got[count - 1U].sequence;
+        }
+        samples += (uint32_t)count;
+    }
+    /* Every sequence step over 1 is a gap: the sampler's drops and the
+     * samples the full frame refused */
+    drops = last - first + 1U - samples;
+    HOST_CHECK(failed == 0U, "drain: %u of %u drains failed", (unsigned)failed, (unsigned)HOST_MASTER_ROUNDS);
+    HOST_CHECK(wrong == 0U, "drain: %u samples or counts differ from those pushed", (unsigned)wrong);
+    HOST_CHECK(dev.gaps == drops && overflows_seen != 0U,
+               "drain: %u gaps counted, %u missing (%u overflows)", (unsigned)dev.gaps, (unsigned)drops,
+               (unsigned)overflows_seen);
+    printf("  %-8s %u samples, %u overflows\n", BOARD_SAMPLE_CODEC_ENABLE ? "codec" : "records",
+           (unsigned)samples, (unsigned)overflows_seen);
+
+    /* Read shorter than the frame: taken by the slave, reported, lost */
+    pushed_count = 0;
+    host_master_push(HOST_FIFO_DEPTH / 2U, &next);
+    {
+        size_t count;
+        uint32_t gaps = dev.gaps;
+        uint32_t lost = (uint32_t)pushed_count;
+
+        HOST_CHECK(sensor_host_fifo_drain(&dev, got, HOST_MASTER_MAX, 0, &count) == SENSOR_HOST_ERR_FRAME &&
+                   count == 0U && host_fifo_get_level() == 0U, "drain: short read not reported");
+        pushed_count = 0;
+        host_master_push(1U, &next);
+        HOST_CHECK(sensor_host_fifo_drain(&dev, got, HOST_MASTER_MAX, -1, &count) == SENSOR_HOST_OK &&
+                   count == 1U && dev.gaps - gaps >= lost,
+                   "drain after a short read: %u samples, %u gaps for %u lost", (unsigned)count,
+                   (unsigned)(dev.gaps - gaps), (unsigned)lost);
+    }
+
+#if BOARD_CRC_FRAMING_ENABLE
+    /* One bit flipped on the bus: the frame refused whole */
+    pushed_count = 0;
+    host_master_push(3U, &next);
+    corrupt = true;
+    {
+        size_t count;
+
+        HOST_CHECK(sensor_host_fifo_drain(&dev, got, HOST_MASTER_MAX, -1, &count) == SENSOR_HOST_ERR_CRC &&
+                   count == 0U, "drain: corrupted frame not refused");
+    }
+#endif
+}
+
+static void host_test_command(void)
+{
+    sensor_host_transport_t no_wait = host_master_bus;
+    sensor_host_t dev;
+    uint8_t result = 0;
+    uint8_t state = 0;
+
+    memset(regs, 0, sizeof(regs));
+    sensor_host_init(&dev, &host_master_bus, HOST_MASTER_ADDR, host_master_flags());
+    delays = 0;
+    HOST_CHECK(sensor_host_command(&dev, SENSOR_HOST_CMD_SET_RATE, 0x12345678UL, &result) == SENSOR_HOST_OK &&
+               result == SENSOR_HOST_RESULT_OK && delays == 1U,
+               "command: result %u after %u waits", (unsigned)result, (unsigned)delays);
+    HOST_CHECK(host_master_get32(APP_REG_CMD_ARG) == 0x12345678UL && regs[APP_REG_CMD_OPCODE] == HOST_CMD_SET_RATE,
+               "command: arg %08X opcode 0x%02X written", (unsigned)host_master_get32(APP_REG_CMD_ARG),
+               (unsigned)regs[APP_REG_CMD_OPCODE]);
+
+    /* Without a wait the result is left to the caller */
+    no_wait.delay_us = NULL;
+    dev.bus = &no_wait;
+    HOST_CHECK(sensor_host_command(&dev, SENSOR_HOST_CMD_NOP, 0, &result) == SENSOR_HOST_OK &&
+               result == SENSOR_HOST_RESULT_NONE, "command without a wait: result %u", (unsigned)result);
+
+    /* The master clock goes out as the argument */
+    dev.bus = &host_master_bus;
+    regs[APP_REG_SYNC_STATE] = TIME_SYNC_OFFSET;
+    HOST_CHECK(sensor_host_time_sync(&dev, &state) == SENSOR_HOST_OK && state == SENSOR_HOST_SYNC_OFFSET &&
+               host_master_get32(APP_REG_CMD_ARG) == HOST_MASTER_SYNC_US &&
+               regs[APP_REG_CMD_OPCODE] == HOST_CMD_TIME_SYNC && regs[APP_REG_CMD_STATUS] == HOST_CMD_RESULT_OK,
+               "time sync: state %u, arg %u opcode 0x%02X result %u", (unsigned)state,
+               (unsigned)host_master_get32(APP_REG_CMD_ARG), (unsigned)regs[APP_REG_CMD_OPCODE],
+               (unsigned)regs[APP_REG_CMD_STATUS]);
+
+    bus_down = true;
+    HOST_CHECK(sensor_host_command(&dev, SENSOR_HOST_CMD_NOP, 0, &result) == SENSOR_HOST_ERR_BUS,
+               "command: bus error not reported");
+    bus_down = false;
+}
+
+/* ============================================================================
+ * MAIN
+ * ============================================================================ */
+
+int main(void)
+{
+    printf("master library (%s)\n", BOARD_SAMPLE_CODEC_ENABLE ? "codec frames, CRC framing" : "records");
+    host_test_crc();
+    host_test_snapshot();
+    host_test_drain();
+    host_test_command();
+
+    if (failures != 0U) {
+        printf("%u check(s) failed\n", (unsigned)failures);
+        return EXIT_FAILURE;
+    }
+    printf("  all checks passed\n");
+    return EXIT_SUCCESS;
+}
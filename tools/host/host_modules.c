@@ -0,0 +1,331 @@
+/**
+ * @file host_modules.c
+ * @brief Host checks of the self-contained firmware modules (make host-test)
+ *
+ * Each module is built as the firmware builds it, with its feature
+ * switched on (Makefile HOST_MODULES_CFLAGS), against the HAL calls it
+ * makes stubbed below: a cycle counter that moves only when read or told
+ * to, and a microsecond timebase set by the test. The probe ring is built
+ * without its pins (BOARD_PROBE_PINS 0: GPIO registers are not there).
+ * Modules without a feature switch (the block pools) are built as
+ * they are. The checks drive the module through its public functions and
+ * compare what it reports with what was done.
+ *
+ * Exits non-zero if any check failed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "board_config.h"
+#include "hal_config.h"
+#include "prof.h"
+#include "pool.h"
+#include "probe.h"
+#include "timebase.h"
+
+#if !BOARD_PROF_ENABLE || !BOARD_PROBE_ENABLE
+#error "host_modules.c checks the enabled modules: build with HOST_MODULES_CFLAGS"
+#endif
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define HOST_MODULES_READ_CYCLES  7U  /* Cost of one hal_cycles_read() */
+#define HOST_POOL_BLOCK_SIZE      13U /* Not a word multiple: stride 16 */
+#define HOST_POOL_COUNT           6U
+#define HOST_POOL_RANDOM_OPS      200000U
+
+#define HOST_CHECK(cond, ...) do {            \
+        if (!(cond)) {                        \
+            failures++;                       \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__);              \
+            printf("\n");                     \
+        }                                     \
+    } while (0)
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static uint32_t failures = 0;
+static uint32_t cycles_now = 0;
+static uint32_t timebase_us = 0;
+static uint32_t rng_state = 12345U;
+
+POOL_STORAGE(pool_storage, HOST_POOL_BLOCK_SIZE, HOST_POOL_COUNT);
+POOL_STORAGE(other_storage, HOST_POOL_BLOCK_SIZE, 1U);
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static uint32_t host_modules_rand(void)
+{
+    rng_state = rng_state * 1664525UL + 1013904223UL;
+    return rng_state;
+}
+
+/* ============================================================================
+ * HAL STUBS
+ * ============================================================================ */
+
+void hal_cycles_init(void)
+{
+}
+
+uint32_t hal_cycles_read(void)
+{
+    uint32_t now = cycles_now;
+
+    cycles_now += HOST_MODULES_READ_CYCLES;
+    return now;
+}
+
+uint32_t timebase_now_us(void)
+{
+    return timebase_us;
+}
+
+/* ============================================================================
+ * PROFILING (prof.c)
+ * ============================================================================ */
+
+/**
+ * @brief One PROF_BEGIN()/PROF_END() pass of a site, taking work cycles
+ */
+static void host_prof_pass(uint32_t work)
+{
+    PROF_BEGIN(PROF_SITE_COMPENSATE);
+    cycles_now += work;
+    PROF_END(PROF_SITE_COMPENSATE);
+}
+
+static void host_test_prof(void)
+{
+    prof_stats_t stats;
+
+    prof_init();
+    HOST_CHECK(prof_get_stats(PROF_SITE_COMPENSATE, &stats) && stats.count == 0U &&
+               stats.min == 0U && stats.max == 0U && stats.mean == 0U, "prof: not cleared by init");
+
+    /* The cost of the counter reads comes off every pass */
+    host_prof_pass(100);
+    host_prof_pass(40);
+    host_prof_pass(250);
+    HOST_CHECK(prof_get_stats(PROF_SITE_COMPENSATE, &stats), "prof: get_stats");
+    HOST_CHECK(stats.count == 3U && stats.min == 40U && stats.max == 250U && stats.mean == 130U,
+               "prof: count %u min %u max %u mean %u, expected 3 40 250 130", (unsigned)stats.count,
+               (unsigned)stats.min, (unsigned)stats.max, (unsigned)stats.mean);
+
+    /* Across the counter wrap */
+    cycles_now = UINT32_MAX - 20U;
+    host_prof_pass(64);
+    HOST_CHECK(prof_get_stats(PROF_SITE_COMPENSATE, &stats) && stats.count == 4U && stats.max == 250U &&
+               stats.mean == (100U + 40U + 250U + 64U) / 4U, "prof: pass across the wrap, mean %u",
+               (unsigned)stats.mean);
+
+    /* A pass shorter than the read overhead counts as 0, not as ~2^32 */
+    prof_record(PROF_SITE_COMPENSATE, cycles_now);
+    HOST_CHECK(prof_get_stats(PROF_SITE_COMPENSATE, &stats) && stats.count == 5U && stats.min == 0U &&
+               stats.max == 250U, "prof: short pass min %u max %u", (unsigned)stats.min,
+               (unsigned)stats.max);
+
+    /* Sites are separate; out of range is refused */
+    HOST_CHECK(prof_get_stats(PROF_SITE_SAMPLING_TICK, &stats) && stats.count == 0U,
+               "prof: pass recorded on another site");
+    prof_record(PROF_SITE_COUNT, 0);
+    HOST_CHECK(!prof_get_stats(PROF_SITE_COUNT, &stats), "prof: site out of range accepted");
+    HOST_CHECK(!prof_get_stats(PROF_SITE_COMPENSATE, NULL), "prof: NULL stats accepted");
+
+    prof_reset();
+    HOST_CHECK(prof_get_stats(PROF_SITE_COMPENSATE, &stats) && stats.count == 0U && stats.max == 0U,
+               "prof: not cleared by reset");
+}
+
+/* ============================================================================
+ * BLOCK POOLS (pool.c)
+ * ============================================================================ */
+
+static bool host_pool_stats_are(const pool_t *pool, uint16_t used, uint16_t high_water, uint32_t refused)
+{
+    pool_stats_t stats;
+
+    return pool_get_stats(pool, &stats) && stats.block_size == 16U && stats.count == HOST_POOL_COUNT &&
+           stats.used == used && stats.high_water == high_water && stats.failures == refused;
+}
+
+static void host_test_pool(void)
+{
+    pool_t pool;
+    uint8_t *blocks[HOST_POOL_COUNT];
+    uint8_t *held[HOST_POOL_COUNT];
+    uint32_t held_count = 0;
+    uint16_t high_water = 0;
+    uint32_t refused = 0;
+    uint32_t bad = 0;
+
+    HOST_CHECK(!pool_init(NULL, pool_storage, HOST_POOL_BLOCK_SIZE, HOST_POOL_COUNT) &&
+               !pool_init(&pool, NULL, HOST_POOL_BLOCK_SIZE, HOST_POOL_COUNT) &&
+               !pool_init(&pool, pool_storage, HOST_POOL_BLOCK_SIZE, 0) &&
+               !pool_init(&pool, pool_storage, HOST_POOL_BLOCK_SIZE, UINT16_MAX + 1UL),
+               "pool: bad init parameters accepted");
+    HOST_CHECK(pool_init(&pool, pool_storage, HOST_POOL_BLOCK_SIZE, HOST_POOL_COUNT), "pool: init");
+    HOST_CHECK(host_pool_stats_are(&pool, 0, 0, 0), "pool: stats after init");
+
+    /* First to last, word-aligned, a whole stride each */
+    for (uint32_t i = 0; i < HOST_POOL_COUNT; i++) {
+        blocks[i] = pool_alloc(&pool);
+        HOST_CHECK(blocks[i] == (uint8_t *)pool_storage + i * 16U, "pool: block %u at offset %ld",
+                   (unsigned)i, (long)(blocks[i] - (uint8_t *)pool_storage));
+        if (blocks[i] != NULL) {
+            memset(blocks[i], (int)i, 16U);
+        }
+    }
+    HOST_CHECK(pool_alloc(&pool) == NULL && host_pool_stats_are(&pool, HOST_POOL_COUNT, HOST_POOL_COUNT, 1U),
+               "pool: empty pool handed a block out or did not count it");
+    for (uint32_t i = 0; i < HOST_POOL_COUNT; i++) {
+        for (uint32_t k = 0; k < 16U && blocks[i] != NULL; k++) {
+            bad += (blocks[i][k] != (uint8_t)i);
+        }
+    }
+    HOST_CHECK(bad == 0U, "pool: %u bytes overwritten by a neighbouring block", (unsigned)bad);
+
+    /* Not a block of this pool: refused, nothing changed */
+    HOST_CHECK(!pool_free(&pool, NULL) && !pool_free(&pool, other_storage) &&
+               !pool_free(&pool, blocks[1] + 4) && !pool_free(&pool, blocks[HOST_POOL_COUNT - 1U] + 16) &&
+               !pool_free(NULL, blocks[0]),
+               "pool: foreign block accepted");
+    HOST_CHECK(host_pool_stats_are(&pool, HOST_POOL_COUNT, HOST_POOL_COUNT, 1U), "pool: refused free counted");
+
+    /* Last freed, first handed out */
+    HOST_CHECK(pool_free(&pool, blocks[2]) && pool_free(&pool, blocks[4]), "pool: free");
+    HOST_CHECK(pool_alloc(&pool) == blocks[4] && pool_alloc(&pool) == blocks[2] && pool_alloc(&pool) == NULL,
+               "pool: not LIFO");
+    for (uint32_t i = 0; i < HOST_POOL_COUNT; i++) {
+        HOST_CHECK(pool_free(&pool, blocks[i]), "pool: free block %u", (unsigned)i);
+    }
+    HOST_CHECK(host_pool_stats_are(&pool, 0, HOST_POOL_COUNT, 2U), "pool: stats after freeing all");
+
+    /* Random traffic against a model: every block out at most once, and
+     * the counters as the model counts them */
+    (void)pool_init(&pool, pool_storage, HOST_POOL_BLOCK_SIZE, HOST_POOL_COUNT);
+    bad = 0;
+    for (uint32_t op = 0; op < HOST_POOL_RANDOM_OPS; op++) {
+        uint32_t r = host_modules_rand() >> 16;
+
+        if ((r & 1U) != 0U || held_count == 0U) {
+            uint8_t *block = pool_alloc(&pool);
+
+            if (held_count == HOST_POOL_COUNT) {
+                bad += (block != NULL);
+                refused++;
+                continue;
+            }
+            for (uint32_t k = 0; k < held_count; k++) {
+                bad += (held[k] == block);
+            }
+            bad += (block == NULL);
+            held[held_count++] = block;
+            if (held_count > high_water) {
+                high_water = (uint16_t)held_count;
+            }
+        } else {
+            uint32_t k = (r >> 1) % held_count;
+
+            bad += !pool_free(&pool, held[k]);
+            held[k] = held[--held_count];
+        }
+    }
+    HOST_CHECK(bad == 0U, "pool: %u wrong results in %u random operations", (unsigned)bad,
+               (unsigned)HOST_POOL_RANDOM_OPS);
+    HOST_CHECK(host_pool_stats_are(&pool, (uint16_t)held_count, high_water, refused),
+               "pool: stats after the random operations");
+}
+
+/* ============================================================================
+ * TIMING PROBES (probe.c)
+ * ============================================================================ */
+
+/**
+ * @brief Frame record n (probe.h layout, little-endian)
+ */
+static uint32_t host_probe_word(const uint8_t *frame, uint32_t offset)
+{
+    return (uint32_t)frame[offset] | ((uint32_t)frame[offset + 1U] << 8) |
+           ((uint32_t)frame[offset + 2U] << 16) | ((uint32_t)frame[offset + 3U] << 24);
+}
+
+static void host_test_probe(void)
+{
+    const uint32_t size = 1UL << BOARD_PROBE_RING_LOG2;
+    const uint32_t total = 2U * size + 3U;
+    const uint8_t *frame;
+    uint16_t len;
+    uint32_t bad = 0;
+
+    /* Frozen until init: a point before it is dropped */
+    probe_record(PROBE_ID_SLAVE_END);
+    probe_init();
+    frame = probe_dump(&len);
+    HOST_CHECK(len == 8U + 4U * size, "probe: frame of %u bytes, expected %u", (unsigned)len,
+               (unsigned)(8U + 4U * size));
+    HOST_CHECK(frame[0] == PROBE_VERSION && frame[1] == BOARD_PROBE_RING_LOG2 && frame[2] == 0U &&
+               host_probe_word(frame, 4) == 0U && host_probe_word(frame, 8) == 0U,
+               "probe: header after init %u %u %u written %u", frame[0], frame[1], frame[2],
+               (unsigned)host_probe_word(frame, 4));
+
+    /* ID in [31:24], the timestamp modulo 2^24 below it */
+    timebase_us = 0x01FFFFFEUL;
+    PROBE_BUS(PROBE_ID_SENSOR_XFER);
+    timebase_us += 5U;
+    PROBE_STATE(PROBE_ID_SENSOR_STATE + 3U);
+    HOST_CHECK(host_probe_word(frame, 4) == 2U && host_probe_word(frame, 8) == 0x40FFFFFEUL &&
+               host_probe_word(frame, 12) == 0x23000003UL,
+               "probe: written %u, records %08x %08x", (unsigned)host_probe_word(frame, 4),
+               (unsigned)host_probe_word(frame, 8), (unsigned)host_probe_word(frame, 12));
+
+    /* Past two wraps: the newest size records, the oldest at written mod size */
+    probe_resume();
+    for (uint32_t i = 0; i < total; i++) {
+        timebase_us = i * 10U;
+        probe_record(PROBE_ID_ISR_ENTER + (i & 15U));
+    }
+    HOST_CHECK(host_probe_word(frame, 4) == total, "probe: written %u, expected %u",
+               (unsigned)host_probe_word(frame, 4), (unsigned)total);
+    for (uint32_t k = 0; k < size; k++) {
+        uint32_t i = total - size + k;  /* k-th oldest still held */
+        uint32_t slot = (total + k) % size;
+
+        bad += host_probe_word(frame, 8U + 4U * slot) != (((i & 15U) << 24) | (i * 10U));
+    }
+    HOST_CHECK(bad == 0U, "probe: %u of %u ring records wrong after the wrap", (unsigned)bad, (unsigned)size);
+
+    /* Frozen: the ring holds still for the dump */
+    probe_freeze();
+    probe_record(PROBE_ID_SLAVE_READ);
+    HOST_CHECK(frame[2] == 1U && host_probe_word(frame, 4) == total, "probe: recorded while frozen");
+    probe_resume();
+    HOST_CHECK(frame[2] == 0U && host_probe_word(frame, 4) == 0U, "probe: resume did not empty the ring");
+}
+
+/* ============================================================================
+ * MAIN
+ * ============================================================================ */
+
+int main(void)
+{
+    printf("modules\n");
+    host_test_prof();
+    host_test_pool();
+    host_test_probe();
+
+    if (failures != 0U) {
+        printf("%u check(s) failed\n", (unsigned)failures);
+        return EXIT_FAILURE;
+    }
+    printf("  all checks passed\n");
+    return EXIT_SUCCESS;
+}
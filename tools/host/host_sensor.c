@@ -0,0 +1,431 @@
+/**
+ * @file host_sensor.c
+ * @brief Mock MS5837 behind the ms583730ba01_h transport (host build)
+ *
+ * Stands in for ms58_hal_wrapper.c: ms58_get_hal_handle() hands the
+ * sampler a transport whose async calls queue one transfer on the virtual
+ * bus. The transfer ends after its bit time at config.bus_hz, and only
+ * then does the sensor act on it (reset, conversion start, ADC or PROM
+ * read) and the completion run, as from the I2C2 interrupt.
+ *
+ * Faults are drawn per transfer from their own generator, so one seed
+ * gives one run: a bus error (the bus stays faulted, hal_i2c2_bus_fault(),
+ * until hal_i2c2_recover()) or a NACK of the address (hal_i2c2_nacked()).
+ * An ADC read of a conversion still running is NACKed too, or reads 0.
+ *
+ * The blocking calls act at once with no bus time: they are there for the
+ * handle to be complete (the sampler only checks write_cmd).
+ *
+ * hal_i2c2_init() sets config.bus_hz to the rate of the speed profile
+ * last set (400 kHz after host_reset()), as a re-init does on the part.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "host.h"
+#include "board_config.h"
+#include "ms58.h"
+#include "ms58_regs.h"
+#include "ms58_hal_wrapper.h"
+#include "hal_config.h"
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define HOST_SENSOR_BYTE_BITS   9U   /* 8 data bits and the acknowledge */
+#define HOST_SENSOR_FRAME_BITS  2U   /* START and STOP (or repeated START) */
+
+/* SCL rate per hal_i2c_speed_t */
+static const uint32_t host_sensor_speed_hz[HAL_I2C_SPEED_COUNT] = { 100000UL, 400000UL, 1000000UL };
+
+/* Datasheet example: C0 carries the variant ID (the CRC-4 is filled in) */
+static const uint16_t host_sensor_datasheet_prom[8] = {
+    HOST_SENSOR_C0, 34982, 36352, 20328, 22354, 26646, 26146, 0
+};
+
+/**
+ * @brief One transfer on the virtual bus
+ */
+typedef struct {
+    bool pending;
+    uint32_t done_us;              /* Virtual time the STOP goes out */
+    bool has_cmd;                  /* Command byte written first */
+    uint8_t cmd;
+    uint8_t *buf;                  /* Read data, NULL for a write only */
+    uint32_t n;
+    ms583730ba01_done_cb_t done;
+    void *done_ctx;
+} host_sensor_xfer_t;
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static host_sensor_config_t config;
+static host_sensor_stats_t stats;
+static host_sensor_xfer_t xfer;
+
+/* Sensor side */
+static uint8_t last_cmd = MS5837_ADC_READ;  /* Addressed by the next read */
+static bool converting = false;
+static uint32_t conv_end_us = 0;
+static uint32_t conv_result = 0;
+static bool result_ready = false;
+static uint32_t noise_state = 1U;
+
+/* Bus side */
+static uint32_t fault_state = 1U;
+static bool bus_fault = false;  /* Until hal_i2c2_recover() */
+static bool nacked = false;     /* Last transfer, NACK alone */
+static hal_i2c_speed_t speed = HAL_I2C_SPEED_FAST;  /* Of the next hal_i2c2_init() */
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Bus time of a transfer: address byte, command, repeated START
+ *        and address, n data bytes
+ */
+static uint32_t host_sensor_xfer_us(bool has_cmd, uint32_t n)
+{
+    uint32_t bits = HOST_SENSOR_FRAME_BITS + HOST_SENSOR_BYTE_BITS;
+
+    if (has_cmd) {
+        bits += HOST_SENSOR_BYTE_BITS;
+    }
+    if (n != 0U) {
+        bits += (has_cmd ? HOST_SENSOR_FRAME_BITS / 2U + HOST_SENSOR_BYTE_BITS : 0U) +
+                n * HOST_SENSOR_BYTE_BITS;
+    }
+    return (uint32_t)(((uint64_t)bits * 1000000ULL + config.bus_hz - 1U) / config.bus_hz);
+}
+
+/**
+ * @brief Sensor acting on a command byte
+ */
+static void host_sensor_command(uint8_t cmd)
+{
+    uint32_t now = host_now_us();
+
+    last_cmd = cmd;
+    if (cmd == MS5837_RESET) {
+        stats.resets++;
+        converting = false;
+        result_ready = false;
+    } else if (cmd >= MS5837_CONVERT_D1_256 && cmd <= MS5837_CONVERT_D2_8192 && (cmd & 1U) == 0U) {
+        uint32_t osr = (uint32_t)(cmd & 0x0FU) / 2U;
+
+        if (osr < HOST_SENSOR_OSR_COUNT) {
+            stats.conversions++;
+            converting = true;
+            result_ready = false;
+            conv_end_us = now + config.conv_us[osr];
+            conv_result = config.d2;
+            if (cmd < MS5837_CONVERT_D2_256) {
+                noise_state = noise_state * 1664525UL + 1013904223UL;
+                conv_result = config.d1 +
+                              ((config.d1_noise != 0U) ? (noise_state >> 8) % (config.d1_noise + 1U) : 0U);
+            }
+        }
+    }
+}
+
+/**
+ * @brief One fault draw of probability ppm / 10^6
+ */
+static bool host_sensor_fault(uint32_t ppm)
+{
+    if (ppm == 0U) {
+        return false;
+    }
+    fault_state = fault_state * 1664525UL + 1013904223UL;
+    return (fault_state >> 8) % 1000000UL < ppm;
+}
+
+/**
+ * @brief Sensor answering a read of n bytes after the last command
+ *
+ * @param at_us When the read address went out (the sensor answers it)
+ * @return false if the sensor NACKed the read (conversion running)
+ */
+static bool host_sensor_read(uint8_t *buf, uint32_t n, uint32_t at_us)
+{
+    uint32_t value = 0;
+
+    memset(buf, 0, n);
+    if (last_cmd == MS5837_ADC_READ) {
+        stats.adc_reads++;
+        if (converting && (int32_t)(at_us - conv_end_us) >= 0) {
+            converting = false;
+            result_ready = true;
+        }
+        if (converting) {
+            stats.early_reads++;
+            if (config.early_nack) {
+                return false;
+            }
+        } else if (result_ready) {
+            value = conv_result;
+            result_ready = false;  /* Read once: the sensor gives 0 after */
+        }
+        if (value == 0U) {
+            stats.zero_reads++;
+        }
+        for (uint32_t i = 0; i < n && i < 4U; i++) {
+            buf[i] = (uint8_t)(value >> (8U * (n - 1U - i)));
+        }
+    } else if ((last_cmd & 0xF0U) == MS5837_PROM_READ_BASE) {
+        uint32_t index = (uint32_t)(last_cmd & 0x0FU) / 2U;
+
+        stats.prom_reads++;
+        value = config.prom[index & 7U];
+        if (n >= 2U) {
+            buf[0] = (uint8_t)(value >> 8);
+            buf[1] = (uint8_t)value;
+        }
+    }
+    return true;
+}
+
+static ms583730ba01_err_t host_sensor_queue(bool has_cmd, uint8_t cmd, uint8_t *buf, uint32_t n,
+                                            ms583730ba01_done_cb_t done, void *done_ctx)
+{
+    if (xfer.pending) {
+        return E_MS58370BA01_BUSY_ERR;
+    }
+
+    xfer.pending = true;
+    xfer.has_cmd = has_cmd;
+    xfer.cmd = cmd;
+    xfer.buf = buf;
+    xfer.n = n;
+    xfer.done = done;
+    xfer.done_ctx = done_ctx;
+    xfer.done_us = host_now_us() + host_sensor_xfer_us(has_cmd, n);
+    nacked = false;
+    return E_MS58370BA01_SUCCESS;
+}
+
+static ms583730ba01_err_t host_sensor_write_cmd(void *ctx, uint8_t cmd)
+{
+    (void)ctx;
+    host_sensor_command(cmd);
+    return E_MS58370BA01_SUCCESS;
+}
+
+static ms583730ba01_err_t host_sensor_read_data(void *ctx, uint8_t *buf, uint32_t n)
+{
+    (void)ctx;
+    return host_sensor_read(buf, n, host_now_us()) ? E_MS58370BA01_SUCCESS : E_MS58370BA01_COM_ERR;
+}
+
+static ms583730ba01_err_t host_sensor_write_read(void *ctx, uint8_t cmd, uint8_t *buf, uint32_t n)
+{
+    (void)ctx;
+    host_sensor_command(cmd);
+    return host_sensor_read(buf, n, host_now_us()) ? E_MS58370BA01_SUCCESS : E_MS58370BA01_COM_ERR;
+}
+
+static void host_sensor_delay(uint16_t ms)
+{
+    (void)ms;
+}
+
+static ms583730ba01_err_t host_sensor_write_cmd_start(void *ctx, uint8_t cmd,
+                                                      ms583730ba01_done_cb_t done, void *done_ctx)
+{
+    (void)ctx;
+    return host_sensor_queue(true, cmd, NULL, 0, done, done_ctx);
+}
+
+static ms583730ba01_err_t host_sensor_read_data_start(void *ctx, uint8_t *buf, uint32_t n,
+                                                      ms583730ba01_done_cb_t done, void *done_ctx)
+{
+    (void)ctx;
+    return host_sensor_queue(false, 0, buf, n, done, done_ctx);
+}
+
+static ms583730ba01_err_t host_sensor_write_read_start(void *ctx, uint8_t cmd, uint8_t *buf,
+                                                       uint32_t n, ms583730ba01_done_cb_t done,
+                                                       void *done_ctx)
+{
+    (void)ctx;
+    return host_sensor_queue(true, cmd, buf, n, done, done_ctx);
+}
+
+/* ============================================================================
+ * HARNESS INTERFACE
+ * ============================================================================ */
+
+void host_sensor_defaults(host_sensor_config_t *cfg)
+{
+    static const uint16_t conv_us[HOST_SENSOR_OSR_COUNT] = {
+        MS5837_CONV_TIME_US_256, MS5837_CONV_TIME_US_512, MS5837_CONV_TIME_US_1024,
+        MS5837_CONV_TIME_US_2048, MS5837_CONV_TIME_US_4096, MS5837_CONV_TIME_US_8192
+    };
+
+    memset(cfg, 0, sizeof(*cfg));
+    memcpy(cfg->prom, host_sensor_datasheet_prom, sizeof(cfg->prom));
+    cfg->d1 = HOST_DATASHEET_D1;
+    cfg->d2 = HOST_DATASHEET_D2;
+    memcpy(cfg->conv_us, conv_us, sizeof(cfg->conv_us));
+    cfg->bus_hz = 400000UL;
+    cfg->early_nack = true;
+}
+
+host_sensor_config_t *host_sensor_config(void)
+{
+    return &config;
+}
+
+void host_sensor_get_stats(host_sensor_stats_t *out)
+{
+    *out = stats;
+}
+
+void host_sensor_reset(const host_sensor_config_t *cfg)
+{
+    if (cfg != NULL) {
+        config = *cfg;
+    } else {
+        host_sensor_defaults(&config);
+    }
+    /* CRC-4 in C0[15:12], as the sampler's bring-up checks it */
+    config.prom[0] = (uint16_t)((config.prom[0] & 0x0FFFU) | ((uint16_t)ms5837_crc4(config.prom) << 12));
+
+    memset(&stats, 0, sizeof(stats));
+    memset(&xfer, 0, sizeof(xfer));
+    last_cmd = MS5837_ADC_READ;
+    converting = false;
+    result_ready = false;
+    noise_state = 1U;
+    fault_state = (config.seed != 0U) ? config.seed : 1U;
+    bus_fault = false;
+    nacked = false;
+    speed = HAL_I2C_SPEED_FAST;
+}
+
+bool host_sensor_next_event(uint32_t *at_us)
+{
+    if (!xfer.pending) {
+        return false;
+    }
+    *at_us = xfer.done_us;
+    return true;
+}
+
+void host_sensor_event(void)
+{
+    host_sensor_xfer_t done = xfer;
+    ms583730ba01_err_t result = E_MS58370BA01_COM_ERR;
+
+    /* Free before the completion, which may chain the next transfer */
+    xfer.pending = false;
+    stats.transfers++;
+    stats.busy_us += host_sensor_xfer_us(done.has_cmd, done.n);
+
+    if (bus_fault || host_sensor_fault(config.bus_error_ppm)) {
+        /* Never reached the sensor; the bus stays held */
+        bus_fault = true;
+        stats.bus_errors++;
+    } else if (host_sensor_fault(config.nack_ppm)) {
+        nacked = true;
+        stats.nacks++;
+    } else {
+        if (done.has_cmd) {
+            host_sensor_command(done.cmd);
+        }
+        /* The read address goes out n data bytes before the STOP */
+        uint32_t read_at_us = done.done_us -
+            (uint32_t)(((uint64_t)done.n * HOST_SENSOR_BYTE_BITS * 1000000ULL) / config.bus_hz);
+
+        if (done.buf == NULL || host_sensor_read(done.buf, done.n, read_at_us)) {
+            result = E_MS58370BA01_SUCCESS;
+        } else {
+            nacked = true;
+            stats.nacks++;
+        }
+    }
+    if (done.done != NULL) {
+        done.done(done.done_ctx, result);
+    }
+}
+
+/* ============================================================================
+ * TRANSPORT (ms58_hal_wrapper.h)
+ * ============================================================================ */
+
+ms583730ba01_h ms58_get_hal_handle(ms58_hal_dev_t *dev, I2C_HandleTypeDef *hi2c, uint8_t addr)
+{
+    ms583730ba01_h handle = {
+        .ctx = dev,
+        .done_ctx = NULL,
+        .write_cmd = host_sensor_write_cmd,
+        .read_data = host_sensor_read_data,
+        .delay = host_sensor_delay,
+        .write_cmd_start = host_sensor_write_cmd_start,
+        .read_data_start = host_sensor_read_data_start,
+        .write_read = host_sensor_write_read,
+        .write_read_start = host_sensor_write_read_start,
+    };
+
+    (void)hi2c;
+    dev->bus = NULL;
+    dev->addr = addr;
+    return handle;
+}
+
+void ms58_hal_abort(I2C_HandleTypeDef *hi2c)
+{
+    (void)hi2c;
+    xfer.pending = false;
+}
+
+bool hal_i2c2_bus_fault(void)
+{
+    return bus_fault;
+}
+
+bool hal_i2c2_nacked(void)
+{
+    return nacked && !bus_fault;
+}
+
+bool hal_i2c2_recover(void)
+{
+    stats.recoveries++;
+    host_busy_us(config.recover_us);  /* Bit-banged clocks and re-init */
+    xfer.pending = false;
+    bus_fault = false;
+    nacked = false;
+    return true;
+}
+
+bool hal_i2c2_init(void)
+{
+    stats.inits++;
+    config.bus_hz = host_sensor_speed_hz[speed];
+    xfer.pending = false;
+    bus_fault = false;
+    nacked = false;
+    return true;
+}
+
+void hal_i2c2_set_speed(hal_i2c_speed_t profile)
+{
+    if ((uint32_t)profile < HAL_I2C_SPEED_COUNT) {
+        speed = profile;
+    }
+}
+
+hal_i2c_speed_t hal_i2c2_get_speed(void)
+{
+    return speed;
+}
+
+bool hal_i2c2_is_idle(void)
+{
+    return !xfer.pending;
+}
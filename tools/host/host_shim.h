@@ -0,0 +1,56 @@
+/**
+ * @file host_shim.h
+ * @brief CMSIS core stand-in for the host build (make host-test)
+ *
+ * Force-included ahead of every source (-include): defines the guard of
+ * cmsis_gcc.h so the device header takes these instead of the Cortex-M
+ * inline assembly. Interrupt masking is a no-op: the host harness runs
+ * every handler to completion, one at a time, so nothing can preempt.
+ */
+
+#ifndef HOST_SHIM_H
+#define HOST_SHIM_H
+
+#define __CMSIS_GCC_H
+
+#include <stdint.h>
+
+#define __ASM                   __asm
+#define __INLINE                inline
+#define __STATIC_INLINE         static inline
+#define __STATIC_FORCEINLINE    static inline
+#define __NO_RETURN             __attribute__((__noreturn__))
+#define __USED                  __attribute__((used))
+#define __WEAK                  __attribute__((weak))
+#define __PACKED                __attribute__((packed, aligned(1)))
+#define __PACKED_STRUCT         struct __attribute__((packed, aligned(1)))
+#define __ALIGNED(x)            __attribute__((aligned(x)))
+#define __RESTRICT              __restrict
+#define __COMPILER_BARRIER()    __asm volatile ("" ::: "memory")
+
+static inline void __enable_irq(void) {}
+static inline void __disable_irq(void) {}
+static inline uint32_t __get_PRIMASK(void) { return 0; }
+static inline void __set_PRIMASK(uint32_t primask) { (void)primask; }
+static inline uint32_t __get_IPSR(void) { return 0; }
+static inline uint32_t __get_MSP(void) { return 0; }
+static inline uint32_t __get_PSP(void) { return 0; }
+static inline uint32_t __get_CONTROL(void) { return 0; }
+static inline void __set_MSP(uint32_t msp) { (void)msp; }
+
+static inline void __DSB(void) { __COMPILER_BARRIER(); }
+static inline void __DMB(void) { __COMPILER_BARRIER(); }
+static inline void __ISB(void) { __COMPILER_BARRIER(); }
+static inline void __NOP(void) {}
+static inline void __WFI(void) {}
+static inline void __WFE(void) {}
+static inline void __SEV(void) {}
+#define __BKPT(value)           ((void)(value))
+
+static inline uint32_t __REV(uint32_t value) { return __builtin_bswap32(value); }
+static inline uint32_t __REV16(uint32_t value)
+{
+    return ((value >> 8) & 0x00FF00FFUL) | ((value << 8) & 0xFF00FF00UL);
+}
+
+#endif /* HOST_SHIM_H */
@@ -0,0 +1,317 @@
+/**
+ * @file host_sim.c
+ * @brief Sampler simulation on the host harness (make host-sim)
+ *
+ * Runs the sampler against the mock MS5837 on the virtual clock and
+ * reports, per scenario, the published rate against the tick rate, the
+ * latency from the start of the pressure conversion to the publish (its
+ * spread measured at the callback, the bucket percentiles of the
+ * LATENCY_STAGE_COMPENSATED histogram), the jitter statistics, what the
+ * sampler counted as errors and what the mock saw on the bus.
+ *
+ * With no arguments, a fixed table: every mode with the part on time,
+ * faster and slower than the datasheet maximum the sampler waits (early
+ * reads NACKed, or answered with 0 as a real part does), a calibrated
+ * time shorter than the part needs (its conversions finish late), a long
+ * pressure OSR, a slow bus, then drawn NACKs and bus errors. With arguments, the
+ * one scenario they give (-h lists them).
+ *
+ * Virtual time only: the figures are the firmware's timing logic against
+ * the modelled sensor and bus, not host speed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "host.h"
+#include "board_config.h"
+#include "ms58.h"
+#include "latency.h"
+#include "sensor_sampling.h"
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define HOST_SIM_BRINGUP_US    50000UL   /* Reset, PROM and first cycle */
+
+typedef struct {
+    const char *name;
+    sensor_sampling_mode_t mode;
+    uint32_t rate_hz;           /* Tick rate (0: boot default) */
+    sensor_osr_t pressure_osr;
+    sensor_osr_t temperature_osr;
+    uint32_t seconds;
+    uint32_t conv_pct;          /* Sensor conversion time, % of the datasheet maximum */
+    uint32_t tune_pct;          /* Time the boot calibration gave the sampler, % likewise */
+    uint32_t nack_ppm;
+    uint32_t bus_error_ppm;
+    uint32_t bus_khz;
+    bool early_nack;
+    uint32_t seed;
+} host_sim_scenario_t;
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+static const char *const mode_names[] = { "sequential", "pipelined", "exact" };
+
+static const host_sim_scenario_t scenarios[] = {
+    /* name        mode                rate OSR P            OSR T           s conv% tune%   NACK   bus  kHz  early seed */
+    { "on time",   SENSOR_MODE_SEQUENTIAL, 0, SENSOR_OSR_256,  SENSOR_OSR_256, 2,  100,  100,     0,    0, 400, true,  1 },
+    { "on time",   SENSOR_MODE_PIPELINED,  0, SENSOR_OSR_256,  SENSOR_OSR_256, 2,  100,  100,     0,    0, 400, true,  1 },
+    { "on time",   SENSOR_MODE_EXACT,      0, SENSOR_OSR_256,  SENSOR_OSR_256, 2,  100,  100,     0,    0, 400, true,  1 },
+    { "fast part", SENSOR_MODE_PIPELINED,  0, SENSOR_OSR_256,  SENSOR_OSR_256, 2,   90,  100,     0,    0, 400, true,  1 },
+    { "slow part", SENSOR_MODE_PIPELINED,  0, SENSOR_OSR_256,  SENSOR_OSR_256, 2,  110,  100,     0,    0, 400, true,  1 },
+    { "slow part", SENSOR_MODE_EXACT,      0, SENSOR_OSR_256,  SENSOR_OSR_256, 2,  110,  100,     0,    0, 400, true,  1 },
+    { "slower",    SENSOR_MODE_EXACT,      0, SENSOR_OSR_256,  SENSOR_OSR_256, 2,  120,  100,     0,    0, 400, true,  1 },
+    { "slower, 0", SENSOR_MODE_EXACT,      0, SENSOR_OSR_256,  SENSOR_OSR_256, 2,  120,  100,     0,    0, 400, false, 1 },
+    { "tuned, 0",  SENSOR_MODE_EXACT,      0, SENSOR_OSR_256,  SENSOR_OSR_256, 2,  100,   80,     0,    0, 400, false, 1 },
+    { "tuned, 0",  SENSOR_MODE_PIPELINED,  0, SENSOR_OSR_4096, SENSOR_OSR_256, 2,  100,   80,     0,    0, 400, false, 1 },
+    { "OSR 4096",  SENSOR_MODE_PIPELINED,  0, SENSOR_OSR_4096, SENSOR_OSR_256, 2,  100,  100,     0,    0, 400, true,  1 },
+    { "100 kHz",   SENSOR_MODE_PIPELINED,  0, SENSOR_OSR_256,  SENSOR_OSR_256, 2,  100,  100,     0,    0, 100, true,  1 },
+    { "NACK 1%",   SENSOR_MODE_PIPELINED,  0, SENSOR_OSR_256,  SENSOR_OSR_256, 2,  100,  100, 10000,    0, 400, true,  1 },
+    { "NACK 1%",   SENSOR_MODE_EXACT,      0, SENSOR_OSR_256,  SENSOR_OSR_256, 2,  100,  100, 10000,    0, 400, true,  1 },
+    { "bus 0.1%",  SENSOR_MODE_PIPELINED,  0, SENSOR_OSR_256,  SENSOR_OSR_256, 2,  100,  100,     0, 1000, 400, true,  1 },
+    { "bus 0.1%",  SENSOR_MODE_SEQUENTIAL, 0, SENSOR_OSR_256,  SENSOR_OSR_256, 2,  100,  100,     0, 1000, 400, true,  1 },
+};
+
+/* Publish-side latency of the run */
+static uint32_t published = 0;
+static uint32_t lat_min_us = 0;
+static uint32_t lat_max_us = 0;
+static uint64_t lat_sum_us = 0;
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static void host_sim_on_publish(const sensor_data_t *sample)
+{
+    uint32_t us = host_now_us() - sample->timestamp_us;
+
+    if (published == 0U || us < lat_min_us) {
+        lat_min_us = us;
+    }
+    if (us > lat_max_us) {
+        lat_max_us = us;
+    }
+    lat_sum_us += us;
+    published++;
+}
+
+/**
+ * @brief Stop the sampler and let the transfer in flight end
+ */
+static void host_sim_stop(void)
+{
+    for (uint32_t i = 0; i < 100U && !sensor_sampling_is_idle(); i++) {
+        (void)sensor_sampling_stop();
+        host_run_us(1000);
+    }
+}
+
+/**
+ * @brief Upper bound of a latency bucket, us
+ */
+static uint32_t host_sim_bucket_us(uint8_t bucket)
+{
+    return (bucket + 1U < LATENCY_BUCKETS) ? (1UL << (bucket + 1U)) : UINT32_MAX;
+}
+
+static void host_sim_print_bucket(const char *name, const latency_hist_t *hist, uint32_t percent)
+{
+    uint32_t us = host_sim_bucket_us(latency_percentile(hist, percent));
+
+    if (us == UINT32_MAX) {
+        printf(" %s >%lu", name, (unsigned long)(1UL << (LATENCY_BUCKETS - 1U)));
+    } else {
+        printf(" %s <%lu", name, (unsigned long)us);
+    }
+}
+
+/**
+ * @brief Run one scenario from reset and print its report
+ *
+ * @return false if the sampler could not be set up as asked
+ */
+static bool host_sim_run(const host_sim_scenario_t *sc)
+{
+    static const uint16_t conv_max_us[HOST_SENSOR_OSR_COUNT] = {
+        MS5837_CONV_TIME_US_256, MS5837_CONV_TIME_US_512, MS5837_CONV_TIME_US_1024,
+        MS5837_CONV_TIME_US_2048, MS5837_CONV_TIME_US_4096, MS5837_CONV_TIME_US_8192
+    };
+    host_sensor_config_t *cfg;
+    sensor_error_stats_t err0, err;
+    sensor_jitter_stats_t jitter;
+    host_sensor_stats_t mock;
+    latency_hist_t hist;
+    uint32_t start_us, elapsed_us, rate_hz, target, widened;
+
+    host_sim_stop();
+    host_reset(NULL);
+    cfg = host_sensor_config();
+    for (uint32_t i = 0; i < HOST_SENSOR_OSR_COUNT; i++) {
+        cfg->conv_us[i] = (uint16_t)((conv_max_us[i] * sc->conv_pct + 50U) / 100U);
+        host_conv_tune_us()[i] = (uint16_t)((conv_max_us[i] * sc->tune_pct + 50U) / 100U);
+    }
+    cfg->bus_hz = sc->bus_khz * 1000UL;
+    cfg->early_nack = sc->early_nack;
+    cfg->seed = sc->seed;
+    /* Bring-up clean: the faults only hit the sampling cycles */
+    cfg->nack_ppm = 0;
+    cfg->bus_error_ppm = 0;
+    /* Widened levels from the start: the bring-up cycles count */
+    sensor_sampling_get_error_stats(&err0);
+    widened = err0.conv_widened;
+
+    if (!sensor_sampling_init() ||
+        !sensor_sampling_set_mode(sc->mode) ||
+        !sensor_sampling_set_profile(sc->pressure_osr, sc->temperature_osr) ||
+        !sensor_sampling_set_rate_hz((sc->rate_hz != 0U) ? sc->rate_hz : BOARD_TIM2_FREQ_HZ)) {
+        printf("%-10s %-10s: mode, OSR or rate rejected\n", sc->name, mode_names[sc->mode]);
+        return false;
+    }
+    sensor_sampling_register_publish_callback(host_sim_on_publish);
+    if (!sensor_sampling_start()) {
+        printf("%-10s %-10s: start failed\n", sc->name, mode_names[sc->mode]);
+        sensor_sampling_register_publish_callback(NULL);
+        return false;
+    }
+    host_run_us(HOST_SIM_BRINGUP_US);
+
+    cfg->nack_ppm = sc->nack_ppm;
+    cfg->bus_error_ppm = sc->bus_error_ppm;
+    published = 0;
+    lat_min_us = 0;
+    lat_max_us = 0;
+    lat_sum_us = 0;
+    latency_reset();
+    sensor_sampling_reset_jitter();
+    sensor_sampling_get_error_stats(&err0);
+    host_sensor_get_stats(&mock);
+    start_us = mock.busy_us;
+
+    host_run_us(sc->seconds * 1000000UL);
+    elapsed_us = sc->seconds * 1000000UL;
+
+    sensor_sampling_get_error_stats(&err);
+    sensor_sampling_get_jitter_stats(&jitter);
+    host_sensor_get_stats(&mock);
+    (void)latency_get(LATENCY_STAGE_COMPENSATED, &hist);
+    rate_hz = sensor_sampling_get_rate_hz();
+    target = (sc->mode == SENSOR_MODE_PIPELINED) ? rate_hz / 2U : rate_hz;
+
+    printf("%-10s %-10s OSR %4u/%-4u %3u Hz tick %3u%% conv %3u%% tuned %3u kHz\n", sc->name,
+           mode_names[sc->mode], 256U << sc->pressure_osr, 256U << sc->temperature_osr,
+           (unsigned)rate_hz, (unsigned)sc->conv_pct, (unsigned)sc->tune_pct,
+           (unsigned)sc->bus_khz);
+    printf("  throughput %6.1f samples/s (tick bound %u)  bus busy %4.1f%%  status %d\n",
+           (double)published / (double)sc->seconds, (unsigned)target,
+           100.0 * (double)(mock.busy_us - start_us) / (double)elapsed_us,
+           (int)sensor_sampling_get_status());
+    if (published != 0U) {
+        printf("  latency    min %u mean %.1f max %u us;", (unsigned)lat_min_us,
+               (double)lat_sum_us / (double)published, (unsigned)lat_max_us);
+        host_sim_print_bucket("p50", &hist, 50U);
+        host_sim_print_bucket("p99", &hist, 99U);
+        printf(" us\n");
+    }
+    printf("  jitter     min %u max %u mean %u us, stddev %u ns, peak %u us\n",
+           (unsigned)jitter.min_us, (unsigned)jitter.max_us, (unsigned)jitter.mean_us,
+           (unsigned)jitter.stddev_ns, (unsigned)jitter.peak_us);
+    printf("  sampler    errors %u retries %u timeouts %u recoveries %u (failed %u) backoffs %u\n",
+           (unsigned)(err.errors - err0.errors), (unsigned)(err.read_retries - err0.read_retries),
+           (unsigned)(err.timeouts - err0.timeouts),
+           (unsigned)(err.bus_recoveries - err0.bus_recoveries),
+           (unsigned)(err.recovery_failures - err0.recovery_failures),
+           (unsigned)(err.backoffs - err0.backoffs));
+    printf("  late reads %u (levels widened %u)\n", (unsigned)(err.late_reads - err0.late_reads),
+           (unsigned)(err.conv_widened - widened));
+    printf("  mock       transfers %u early reads %u zero results %u NACKs %u bus errors %u"
+           " recoveries %u\n", (unsigned)mock.transfers, (unsigned)mock.early_reads,
+           (unsigned)mock.zero_reads, (unsigned)mock.nacks, (unsigned)mock.bus_errors,
+           (unsigned)mock.recoveries);
+
+    sensor_sampling_register_publish_callback(NULL);
+    return true;
+}
+
+static void host_sim_usage(const char *argv0)
+{
+    printf("usage: %s [-m sequential|pipelined|exact] [-r tick Hz] [-p OSR] [-t OSR]\n"
+           "       [-s seconds] [-c conversion %% of datasheet max] [-w calibrated wait %%]\n"
+           "       [-n NACK ppm] [-e bus error ppm] [-b bus kHz] [-z] [-S seed]\n"
+           "  -z: early ADC reads return 0 instead of a NACK\n"
+           "  no arguments: the built-in scenario table\n", argv0);
+}
+
+static bool host_sim_osr(const char *arg, sensor_osr_t *osr)
+{
+    unsigned long value = strtoul(arg, NULL, 10);
+
+    for (uint32_t i = 0; i < SENSOR_OSR_COUNT; i++) {
+        if (value == (256UL << i)) {
+            *osr = (sensor_osr_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* ============================================================================
+ * MAIN
+ * ============================================================================ */
+
+int main(int argc, char **argv)
+{
+    host_sim_scenario_t sc = scenarios[1];
+    bool ok = true;
+    int opt;
+
+    printf("sampler simulation (%s)\n",
+           (BOARD_SENSOR_VARIANT == BOARD_SENSOR_VARIANT_30BA) ? "30BA" : "02BA");
+    if (argc < 2) {
+        for (uint32_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+            ok = host_sim_run(&scenarios[i]) && ok;
+        }
+        return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    sc.name = "custom";
+    while ((opt = getopt(argc, argv, "m:r:p:t:s:c:w:n:e:b:zS:h")) != -1) {
+        switch (opt) {
+        case 'm':
+            for (sc.mode = SENSOR_MODE_SEQUENTIAL; (uint32_t)sc.mode < 3U; sc.mode++) {
+                if (strcmp(optarg, mode_names[sc.mode]) == 0) {
+                    break;
+                }
+            }
+            ok = (uint32_t)sc.mode < 3U;
+            break;
+        case 'r': sc.rate_hz = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'p': ok = host_sim_osr(optarg, &sc.pressure_osr); break;
+        case 't': ok = host_sim_osr(optarg, &sc.temperature_osr); break;
+        case 's': sc.seconds = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'c': sc.conv_pct = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'w': sc.tune_pct = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'n': sc.nack_ppm = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'e': sc.bus_error_ppm = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'b': sc.bus_khz = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'z': sc.early_nack = false; break;
+        case 'S': sc.seed = (uint32_t)strtoul(optarg, NULL, 10); break;
+        default: ok = false; break;
+        }
+        if (!ok) {
+            break;
+        }
+    }
+    if (!ok || optind != argc || sc.seconds == 0U || sc.seconds > 4000U || sc.bus_khz == 0U ||
+        sc.conv_pct == 0U || sc.conv_pct > 300U || sc.tune_pct == 0U || sc.tune_pct > 100U) {
+        host_sim_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    return host_sim_run(&sc) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
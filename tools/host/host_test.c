@@ -0,0 +1,978 @@
+/**
+ * @file host_test.c
+ * @brief Host tests and throughput figures of the pipeline (make host-test)
+ *
+ * Golden vectors of the compensation (the variant built, first and second
+ * order), the variant ID check of the PROM, a sweep of ms5837_compensate() and ms5837_compensate_batch()
+ * against the datasheet formulas in plain 64-bit arithmetic (and, in the
+ * 02BA build, against the original code, ms58_original.c), the DAC
+ * conversions against their exact definitions, the firmware mem* against
+ * the host C library, and the sampler run on the virtual clock
+ * (host_hal.c) with the mock sensor (host_sensor.c) in each mode, every
+ * published sample checked, conversions read before they ended (a
+ * calibrated time too short, a slow part), its tick overrun detection
+ * with a bus recovery that blocks past the tick, and the benchmark sweep (bench.c,
+ * windows shortened) polled as the main loop does. Then host nanoseconds
+ * per call of the compensation and per sample of the bottom half, unfiltered and
+ * with the median and the IIR filter: a regression figure for the
+ * arithmetic, not the M0+ cost (make emu-bench counts cycles).
+ *
+ * Exits non-zero if any check failed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+#include "board_config.h"
+#include "ms58.h"
+#include "dac.h"
+#include "hal_config.h"
+#include "tracker.h"
+#include "sensor_sampling.h"
+#include "bench.h"
+#include "ms58_original.h"
+
+/* ============================================================================
+ * PRIVATE DEFINITIONS
+ * ============================================================================ */
+
+#define HOST_TEST_SWEEP         200000U
+#define HOST_TEST_ORIGINAL_PROMS 64U       /* Datasheet set, then random C1..C6 */
+#define HOST_TEST_MEM_BYTES     320U       /* mem* buffers: offsets 0..7, lengths to 300 */
+#define HOST_TEST_MEM_GUARD     0xA5U
+#define HOST_TEST_BENCH_CALLS   2000000U
+#define HOST_TEST_BENCH_BATCH   16U
+#define HOST_TEST_RUN_US        1000000UL   /* Sampling run per mode */
+#define HOST_TEST_BRINGUP_US    50000UL     /* Reset, PROM and first cycle */
+#define HOST_TEST_BENCH_RUN_US  60000000UL  /* Bottom-half figure */
+#define HOST_TEST_POLL_US       1000UL      /* Main loop of the benchmark sweep */
+#define HOST_TEST_SWEEP_US      (BENCH_STEPS * (BOARD_BENCH_SETTLE_MS + BOARD_BENCH_DWELL_MS + 10UL) * 1000UL)
+#define HOST_TEST_RATE_SLACK    500U        /* centi-Hz: a sample more or less in the window */
+
+#define HOST_CHECK(cond, ...) do {            \
+        if (!(cond)) {                        \
+            failures++;                       \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__);              \
+            printf("\n");                     \
+        }                                     \
+    } while (0)
+
+/* src/memcpy.c and src/memset.c, renamed (Makefile HOST_RUNTIME_CFLAGS) */
+void *fw_memcpy(void *dst, const void *src, size_t n);
+void *fw_memmove(void *dst, const void *src, size_t n);
+void *fw_memset(void *s, int c, size_t n);
+
+typedef struct {
+    uint32_t d1;
+    uint32_t d2;
+    int32_t pressure;     /* 0.01 mbar */
+    int32_t temperature;  /* 0.01 degC */
+} host_test_vector_t;
+
+/* ============================================================================
+ * PRIVATE VARIABLES
+ * ============================================================================ */
+
+/* Datasheet example coefficients (host_sensor_defaults()) */
+static const uint16_t prom[8] = { HOST_SENSOR_C0, 34982, 36352, 20328, 22354, 26646, 26146, 0 };
+
+/*
+ * Golden outputs of the variant built, from the datasheet formulas with C
+ * '/' (truncation towards zero). The first row is the datasheet example:
+ * it prints TEMP 1981 (rounded down), the formula truncates dT * C6 / 2^23
+ * = -18.58 to -18, hence 1982.
+ */
+#if BOARD_SENSOR_VARIANT == BOARD_SENSOR_VARIANT_30BA
+static const host_test_vector_t golden_first[] = {
+    { 4958179UL, 6815414UL, 399980, 1982 },
+    { 4958179UL, 8388607UL, 425130, 6884 },
+    { 2000000UL, 6815414UL, -1572980, 1982 },
+    { 8000000UL, 7500000UL, 2535920, 4115 },
+    { 4958179UL, 6000000UL, 386940, -560 },
+    { 5500000UL, 5000000UL, 686860, -3676 },
+    { 1000000UL, 3000000UL, -1602890, -9910 },
+    { 16000000UL, 16777215UL, 13007690, 33030 },
+};
+static const host_test_vector_t golden_second[] = {
+    { 4958179UL, 6815414UL, 399980, 1982 },
+    { 4958179UL, 8388607UL, 426950, 6849 },
+    { 2000000UL, 6815414UL, -1572980, 1982 },
+    { 8000000UL, 7500000UL, 2536260, 4109 },
+    { 4958179UL, 6000000UL, 387120, -795 },
+    { 5500000UL, 5000000UL, 661220, -4834 },
+    { 1000000UL, 3000000UL, -955080, -15010 },
+    { 16000000UL, 16777215UL, 13081150, 31588 },
+};
+#else
+static const host_test_vector_t golden_first[] = {
+    { 4958179UL, 6815414UL, 19999, 1982 },
+    { 4958179UL, 8388607UL, 21256, 6884 },
+    { 2000000UL, 6815414UL, -78649, 1982 },
+    { 8000000UL, 7500000UL, 126796, 4115 },
+    { 4958179UL, 6000000UL, 19347, -560 },
+    { 5500000UL, 5000000UL, 34343, -3676 },
+    { 1000000UL, 3000000UL, -80144, -9910 },
+    { 16000000UL, 16777215UL, 650384, 33030 },
+};
+static const host_test_vector_t golden_second[] = {
+    { 4958179UL, 6815414UL, 19999, 1982 },
+    { 4958179UL, 8388607UL, 21256, 6884 },
+    { 2000000UL, 6815414UL, -78649, 1982 },
+    { 8000000UL, 7500000UL, 126796, 4115 },
+    { 4958179UL, 6000000UL, 19191, -775 },
+    { 5500000UL, 5000000UL, 33076, -4738 },
+    { 1000000UL, 3000000UL, -67434, -14585 },
+    { 16000000UL, 16777215UL, 650384, 33030 },
+};
+#endif
+
+#define HOST_TEST_VECTORS  (sizeof(golden_first) / sizeof(golden_first[0]))
+
+static uint32_t failures = 0;
+static uint32_t rng_state = 1U;
+
+/* Sampler run: what the publish callback saw */
+static uint32_t published = 0;
+static uint32_t published_wrong = 0;
+static uint32_t published_gaps = 0;
+static uint32_t last_sequence = 0;
+static int32_t expect_pressure = 0;
+static int32_t expect_temperature = 0;
+static bool bringup = true;  /* Next run starts from the sensor reset */
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+static uint32_t host_test_rand(void)
+{
+    rng_state = rng_state * 1664525UL + 1013904223UL;
+    return rng_state;
+}
+
+/**
+ * @brief Datasheet compensation, 64-bit with C '/', no precomputed terms
+ */
+static void host_test_reference(bool second_order, uint32_t d1, uint32_t d2,
+                                int32_t *pressure, int32_t *temperature)
+{
+    int64_t dT = (int64_t)d2 - (int64_t)prom[5] * 256;
+    int64_t temp = 2000 + dT * prom[6] / 8388608;
+    int64_t off_i = 0;
+    int64_t sens_i = 0;
+    int64_t temp_i = 0;
+    int64_t off;
+    int64_t sens;
+    int64_t p;
+
+#if BOARD_SENSOR_VARIANT == BOARD_SENSOR_VARIANT_30BA
+    off = (int64_t)prom[2] * 65536 + (int64_t)prom[4] * dT / 128;
+    sens = (int64_t)prom[1] * 32768 + (int64_t)prom[3] * dT / 256;
+    if (second_order) {
+        if (temp < 2000) {
+            temp_i = 3 * dT * dT / 8589934592LL;
+            off_i = 3 * (temp - 2000) * (temp - 2000) / 2;
+            sens_i = 5 * (temp - 2000) * (temp - 2000) / 8;
+            if (temp < -1500) {
+                off_i += 7 * (temp + 1500) * (temp + 1500);
+                sens_i += 4 * (temp + 1500) * (temp + 1500);
+            }
+        } else {
+            temp_i = 2 * dT * dT / 137438953472LL;
+            off_i = (temp - 2000) * (temp - 2000) / 16;
+        }
+    }
+    p = (((int64_t)d1 * (sens - sens_i) / 2097152 - (off - off_i)) / 8192) * 10;
+#else
+    off = (int64_t)prom[2] * 131072 + (int64_t)prom[4] * dT / 64;
+    sens = (int64_t)prom[1] * 65536 + (int64_t)prom[3] * dT / 128;
+    if (second_order && temp < 2000) {
+        temp_i = 11 * dT * dT / 34359738368LL;
+        off_i = 31 * (temp - 2000) * (temp - 2000) / 8;
+        sens_i = 63 * (temp - 2000) * (temp - 2000) / 32;
+    }
+    p = ((int64_t)d1 * (sens - sens_i) / 2097152 - (off - off_i)) / 32768;
+#endif
+
+    *pressure = (p > INT32_MAX) ? INT32_MAX : (p < INT32_MIN) ? INT32_MIN : (int32_t)p;
+    *temperature = (int32_t)(temp - temp_i);
+}
+
+static void host_test_golden(void)
+{
+    ms5837_calib_t calib;
+    int32_t p;
+    int32_t t;
+
+    HOST_CHECK(ms5837_calib_prepare(prom, &calib) == E_MS58370BA01_SUCCESS, "calib_prepare");
+    for (uint32_t order = 0; order < 2U; order++) {
+        const host_test_vector_t *golden = order ? golden_second : golden_first;
+
+        ms5837_calib_set_second_order(&calib, order != 0U);
+        for (uint32_t i = 0; i < HOST_TEST_VECTORS; i++) {
+            ms5837_compensate(&calib, golden[i].d1, golden[i].d2, &p, &t);
+            HOST_CHECK(p == golden[i].pressure && t == golden[i].temperature,
+                       "golden order %u D1 %u D2 %u: %d %d, expected %d %d", (unsigned)order + 1U,
+                       (unsigned)golden[i].d1, (unsigned)golden[i].d2, (int)p, (int)t,
+                       (int)golden[i].pressure, (int)golden[i].temperature);
+            host_test_reference(order != 0U, golden[i].d1, golden[i].d2, &p, &t);
+            HOST_CHECK(p == golden[i].pressure && t == golden[i].temperature,
+                       "reference order %u row %u", (unsigned)order + 1U, (unsigned)i);
+        }
+    }
+}
+
+/**
+ * @brief C0 variant ID: the other variant's parts refused, the IDs not
+ *        listed let through
+ */
+static void host_test_variant(void)
+{
+    static const struct {
+        uint16_t id;
+        bool ok;
+    } ids[] = {
+        { MS5837_ID_02BA01, BOARD_SENSOR_VARIANT != BOARD_SENSOR_VARIANT_30BA },
+        { MS5837_ID_02BA21, BOARD_SENSOR_VARIANT != BOARD_SENSOR_VARIANT_30BA },
+        { MS5837_ID_30BA26, BOARD_SENSOR_VARIANT == BOARD_SENSOR_VARIANT_30BA },
+        { 0x7FU, true },
+    };
+    uint16_t words[8];
+    ms5837_calib_t calib;
+
+    memcpy(words, prom, sizeof(words));
+    for (uint32_t i = 0; i < sizeof(ids) / sizeof(ids[0]); i++) {
+        ms583730ba01_err_t result;
+
+        /* The CRC-4 and the factory bits around the ID left as they are */
+        words[0] = (uint16_t)((prom[0] & ~(0x7FU << 5)) | (ids[i].id << 5));
+        result = ms5837_calib_prepare(words, &calib);
+        HOST_CHECK(ms5837_prom_variant_ok(words) == ids[i].ok &&
+                   result == (ids[i].ok ? E_MS58370BA01_SUCCESS : E_MS58370BA01_CONFIG_ERR),
+                   "variant ID 0x%02X: calib_prepare %d, expected %s", (unsigned)ids[i].id,
+                   (int)result, ids[i].ok ? "accepted" : "E_MS58370BA01_CONFIG_ERR");
+    }
+}
+
+static void host_test_sweep(void)
+{
+    ms5837_calib_t calib;
+    uint32_t d1[HOST_TEST_BENCH_BATCH];
+    uint32_t d2[HOST_TEST_BENCH_BATCH];
+    int32_t bp[HOST_TEST_BENCH_BATCH];
+    int32_t bt[HOST_TEST_BENCH_BATCH];
+    uint32_t mismatches = 0;
+
+    (void)ms5837_calib_prepare(prom, &calib);
+    for (uint32_t order = 0; order < 2U; order++) {
+        ms5837_calib_set_second_order(&calib, order != 0U);
+        for (uint32_t n = 0; n < HOST_TEST_SWEEP / HOST_TEST_BENCH_BATCH; n++) {
+            /* Full 24-bit ADC range, D2 repeated in pairs (decimated capture) */
+            for (uint32_t k = 0; k < HOST_TEST_BENCH_BATCH; k++) {
+                d1[k] = host_test_rand() >> 8;
+                d2[k] = ((k & 1U) != 0U) ? d2[k - 1U] : host_test_rand() >> 8;
+            }
+            (void)ms5837_compensate_batch(&calib, d1, d2, bp, bt, HOST_TEST_BENCH_BATCH);
+            for (uint32_t k = 0; k < HOST_TEST_BENCH_BATCH; k++) {
+                int32_t p;
+                int32_t t;
+                int32_t rp;
+                int32_t rt;
+
+                ms5837_compensate(&calib, d1[k], d2[k], &p, &t);
+                host_test_reference(order != 0U, d1[k], d2[k], &rp, &rt);
+                if (p != rp || t != rt || bp[k] != rp || bt[k] != rt) {
+                    if (mismatches++ < 4U) {
+                        printf("  D1 %u D2 %u order %u: %d %d batch %d %d reference %d %d\n",
+                               (unsigned)d1[k], (unsigned)d2[k], (unsigned)order + 1U, (int)p, (int)t,
+                               (int)bp[k], (int)bt[k], (int)rp, (int)rt);
+                    }
+                }
+            }
+        }
+    }
+    HOST_CHECK(mismatches == 0U, "compensation sweep: %u of %u pairs differ from the datasheet formulas",
+               (unsigned)mismatches, (unsigned)(2U * HOST_TEST_SWEEP));
+}
+
+#if BOARD_SENSOR_VARIANT == BOARD_SENSOR_VARIANT_02BA
+/**
+ * @brief First-order compensation against the original function
+ *        (ms58_original.c, 02BA formulas): the datasheet coefficients,
+ *        then random ones, full 24-bit D1 and D2
+ */
+static void host_test_original_sweep(void)
+{
+    uint16_t words[8];
+    ms5837_calib_t calib;
+    uint32_t mismatches = 0;
+
+    memcpy(words, prom, sizeof(words));
+    for (uint32_t set = 0; set < HOST_TEST_ORIGINAL_PROMS; set++) {
+        HOST_CHECK(ms5837_calib_prepare(words, &calib) == E_MS58370BA01_SUCCESS, "calib_prepare set %u",
+                   (unsigned)set);
+        for (uint32_t n = 0; n < HOST_TEST_SWEEP / HOST_TEST_ORIGINAL_PROMS; n++) {
+            uint32_t d1 = host_test_rand() >> 8;
+            uint32_t d2 = host_test_rand() >> 8;
+            int32_t p;
+            int32_t t;
+            int32_t op;
+            int32_t ot;
+
+            ms5837_compensate(&calib, d1, d2, &p, &t);
+            (void)ms58_original_calculate(words, d1, d2, &op, &ot);
+            if ((p != op || t != ot) && mismatches++ < 4U) {
+                printf("  C1..C6 %u %u %u %u %u %u D1 %u D2 %u: %d %d, original %d %d\n",
+                       (unsigned)words[1], (unsigned)words[2], (unsigned)words[3], (unsigned)words[4],
+                       (unsigned)words[5], (unsigned)words[6], (unsigned)d1, (unsigned)d2, (int)p,
+                       (int)t, (int)op, (int)ot);
+            }
+        }
+        for (uint32_t i = 1; i < 7U; i++) {
+            words[i] = (uint16_t)(host_test_rand() >> 16);
+        }
+    }
+    HOST_CHECK(mismatches == 0U, "original sweep: %u pairs differ from 9eeb74e", (unsigned)mismatches);
+}
+#endif
+
+/**
+ * @brief Lengths of the mem* checks: every one to 67 (every head, word
+ *        and tail combination), then around the four-word passes
+ */
+static uint32_t host_test_mem_len(uint32_t k)
+{
+    static const uint16_t longer[] = { 127, 128, 129, 255, 256, 257, 300 };
+
+    return (k < 68U) ? k : longer[k - 68U];
+}
+
+#define HOST_TEST_MEM_LENS  (68U + 7U)
+
+/**
+ * @brief Firmware memcpy, memmove and memset against the host C library:
+ *        every source and destination offset 0..7, overlaps both ways,
+ *        the bytes around the destination untouched
+ */
+static void host_test_mem(void)
+{
+    static uint32_t src_words[HOST_TEST_MEM_BYTES / 4U];
+    static uint32_t fw_words[HOST_TEST_MEM_BYTES / 4U];
+    static uint32_t ref_words[HOST_TEST_MEM_BYTES / 4U];
+    uint8_t *src = (uint8_t *)src_words;
+    uint8_t *fw = (uint8_t *)fw_words;
+    uint8_t *ref = (uint8_t *)ref_words;
+    uint32_t wrong[3] = { 0, 0, 0 };
+
+    for (uint32_t i = 0; i < HOST_TEST_MEM_BYTES; i++) {
+        src[i] = (uint8_t)(host_test_rand() >> 24);
+    }
+    for (uint32_t k = 0; k < HOST_TEST_MEM_LENS; k++) {
+        uint32_t n = host_test_mem_len(k);
+
+        for (uint32_t so = 0; so < 8U; so++) {
+            for (uint32_t d_o = 0; d_o < 8U; d_o++) {
+                memset(fw, HOST_TEST_MEM_GUARD, HOST_TEST_MEM_BYTES);
+                memset(ref, HOST_TEST_MEM_GUARD, HOST_TEST_MEM_BYTES);
+                if (fw_memcpy(fw + d_o, src + so, n) != fw + d_o) {
+                    wrong[0]++;
+                }
+                memcpy(ref + d_o, src + so, n);
+                if (memcmp(fw, ref, HOST_TEST_MEM_BYTES) != 0) {
+                    wrong[0]++;
+                }
+
+                /* Overlapping, destination above and below (offsets 0..7
+                 * apart within one buffer) */
+                memcpy(fw, src, HOST_TEST_MEM_BYTES);
+                memcpy(ref, src, HOST_TEST_MEM_BYTES);
+                if (n + 8U <= HOST_TEST_MEM_BYTES) {
+                    if (fw_memmove(fw + d_o, fw + so, n) != fw + d_o) {
+                        wrong[1]++;
+                    }
+                    memmove(ref + d_o, ref + so, n);
+                    if (memcmp(fw, ref, HOST_TEST_MEM_BYTES) != 0) {
+                        wrong[1]++;
+                    }
+                }
+            }
+
+            /* so as the destination offset; the value's high bits dropped */
+            memset(fw, HOST_TEST_MEM_GUARD, HOST_TEST_MEM_BYTES);
+            memset(ref, HOST_TEST_MEM_GUARD, HOST_TEST_MEM_BYTES);
+            if (fw_memset(fw + so, 0x15A + (int)k, n) != fw + so) {
+                wrong[2]++;
+            }
+            memset(ref + so, 0x15A + (int)k, n);
+            if (memcmp(fw, ref, HOST_TEST_MEM_BYTES) != 0) {
+                wrong[2]++;
+            }
+        }
+    }
+    HOST_CHECK(wrong[0] == 0U, "memcpy: %u of %u copies differ from libc", (unsigned)wrong[0],
+               (unsigned)(HOST_TEST_MEM_LENS * 64U));
+    HOST_CHECK(wrong[1] == 0U, "memmove: %u overlapping moves differ from libc", (unsigned)wrong[1]);
+    HOST_CHECK(wrong[2] == 0U, "memset: %u fills differ from libc", (unsigned)wrong[2]);
+}
+
+static void host_test_dac(void)
+{
+    const dac_calibration_t cal = { 66191UL, 3L << 16 };  /* Gain 1.01, offset +3 codes */
+    uint32_t mv_wrong = 0;
+    uint32_t cal_wrong = 0;
+    uint32_t volt_wrong = 0;
+
+    /* Integer path: within half a code of mV * MAX_CODE / VREF_MV, plus
+     * 1/64 for the Q16 scale (rounded, 0.011 codes at full scale): the
+     * nearest code except next to a tie */
+    for (uint32_t mv = 0; mv <= BOARD_DAC_VREF_MV + 100U; mv++) {
+        int64_t clipped = (mv > BOARD_DAC_VREF_MV) ? BOARD_DAC_VREF_MV : mv;
+        int64_t error = (int64_t)dac_millivolts_to_code(mv) * BOARD_DAC_VREF_MV -
+                        clipped * BOARD_DAC_MAX_CODE;
+
+        if (64 * ((error < 0) ? -error : error) > 33 * (int64_t)BOARD_DAC_VREF_MV) {
+            mv_wrong++;
+        }
+    }
+    HOST_CHECK(mv_wrong == 0U, "dac_millivolts_to_code: %u of %u codes off the nearest",
+               (unsigned)mv_wrong, (unsigned)(BOARD_DAC_VREF_MV + 101U));
+
+    /* Calibrated: nearest code to ideal * gain + offset, clipped */
+    HOST_CHECK(dac_set_calibration(DAC_CHANNEL_OUT1, &cal), "dac_set_calibration");
+    for (uint32_t code = 0; code <= BOARD_DAC_MAX_CODE; code++) {
+        double exact = (double)code * cal.gain_q16 / 65536.0 + (double)cal.offset_q16 / 65536.0;
+        int64_t nearest = (int64_t)(exact + 0.5);
+
+        if (nearest > (int64_t)BOARD_DAC_MAX_CODE) {
+            nearest = BOARD_DAC_MAX_CODE;
+        }
+        if (dac_calibrated_code(DAC_CHANNEL_OUT1, (uint16_t)code) != (uint16_t)nearest) {
+            cal_wrong++;
+        }
+    }
+    HOST_CHECK(cal_wrong == 0U, "dac_calibrated_code: %u codes off", (unsigned)cal_wrong);
+
+    /* Float path: the reciprocal multiply bit-exact with the divide it
+     * replaced, code = (voltage / VREF) * MAX_CODE rounded, over every
+     * float in 0..VREF (positive floats order as their bit patterns) */
+    for (uint32_t bits = 0;; bits++) {
+        float v;
+        uint16_t exact;
+
+        memcpy(&v, &bits, sizeof(v));
+        if (v > BOARD_DAC_VREF_VOLTS) {
+            break;
+        }
+        exact = (uint16_t)(v / BOARD_DAC_VREF_VOLTS * (float)BOARD_DAC_MAX_CODE + 0.5f);
+        if (dac_voltage_to_code(v) != exact && volt_wrong++ < 4U) {
+            printf("  %.9g V: code %u, divide %u\n", (double)v, (unsigned)dac_voltage_to_code(v),
+                   (unsigned)exact);
+        }
+    }
+    HOST_CHECK(volt_wrong == 0U, "dac_voltage_to_code: %u floats differ from the divide", (unsigned)volt_wrong);
+    HOST_CHECK(dac_voltage_to_code(-1.0f) == 0U && dac_voltage_to_code(5.0f) == BOARD_DAC_MAX_CODE,
+               "dac_voltage_to_code clipping");
+}
+
+static void host_test_on_publish(const sensor_data_t *sample)
+{
+    if (published != 0U && sample->sequence != last_sequence + 1U) {
+        published_gaps++;
+    }
+    last_sequence = sample->sequence;
+    if (!sample->valid || sample->pressure != expect_pressure ||
+        sample->temperature != expect_temperature) {
+        published_wrong++;
+    }
+    published++;
+}
+
+/**
+ * @brief Stop the sampler and let the transfer in flight end
+ */
+static void host_test_stop(void)
+{
+    for (uint32_t i = 0; i < 100U && !sensor_sampling_is_idle(); i++) {
+        (void)sensor_sampling_stop();
+        host_run_us(1000);
+    }
+}
+
+/**
+ * @brief Sampler from reset (bring-up included) for HOST_TEST_RUN_US
+ *
+ * @param slow_us Added to every conversion of the mock: a slow part, whose
+ *                early ADC reads are NACKed and must be retried (0: none)
+ * @return Samples published after the bring-up window
+ */
+static uint32_t host_test_run(sensor_sampling_mode_t mode, bool second_order, uint32_t d2,
+                              uint16_t slow_us)
+{
+    sensor_error_stats_t errors;
+    sensor_tick_stats_t ticks;
+    host_sensor_stats_t mock;
+    uint32_t count, retries, overruns;
+
+    host_test_stop();
+    host_reset(NULL);
+    host_sensor_config()->d2 = d2;
+    for (uint32_t i = 0; i < HOST_SENSOR_OSR_COUNT; i++) {
+        host_sensor_config()->conv_us[i] += slow_us;
+    }
+    host_test_reference(second_order, HOST_DATASHEET_D1, d2, &expect_pressure, &expect_temperature);
+
+    HOST_CHECK(sensor_sampling_init(), "sensor_sampling_init");
+    HOST_CHECK(sensor_sampling_set_mode(mode), "sensor_sampling_set_mode %d", (int)mode);
+    sensor_sampling_set_second_order(second_order);
+    sensor_sampling_register_publish_callback(host_test_on_publish);
+    HOST_CHECK(sensor_sampling_start(), "sensor_sampling_start");
+
+    host_run_us(HOST_TEST_BRINGUP_US);
+    HOST_CHECK(sensor_sampling_get_status() == SENSOR_STATUS_RUNNING, "mode %d: not running after %u us",
+               (int)mode, (unsigned)HOST_TEST_BRINGUP_US);
+    published = 0;
+    published_wrong = 0;
+    published_gaps = 0;
+    sensor_sampling_get_error_stats(&errors);
+    count = errors.errors;
+    retries = errors.read_retries;
+    sensor_sampling_get_tick_stats(&ticks);
+    overruns = ticks.overruns;
+
+    host_run_us(HOST_TEST_RUN_US);
+    sensor_sampling_get_error_stats(&errors);
+    sensor_sampling_get_tick_stats(&ticks);
+    host_sensor_get_stats(&mock);
+
+    HOST_CHECK(published > 0U, "mode %d: nothing published", (int)mode);
+    HOST_CHECK(published_wrong == 0U, "mode %d: %u of %u samples not %d %d", (int)mode,
+               (unsigned)published_wrong, (unsigned)published, (int)expect_pressure,
+               (int)expect_temperature);
+    HOST_CHECK(published_gaps == 0U, "mode %d: %u sequence gaps", (int)mode, (unsigned)published_gaps);
+    HOST_CHECK(errors.errors == count, "mode %d: %u aborted cycles", (int)mode,
+               (unsigned)(errors.errors - count));
+    HOST_CHECK(ticks.overruns == overruns, "mode %d: %u tick overruns", (int)mode,
+               (unsigned)(ticks.overruns - overruns));
+    if (slow_us == 0U) {
+        HOST_CHECK(mock.early_reads == 0U, "mode %d: %u ADC reads before the conversion ended",
+                   (int)mode, (unsigned)mock.early_reads);
+    } else {
+        HOST_CHECK(errors.read_retries - retries >= published && mock.nacks == mock.early_reads,
+                   "mode %d: %u retries for %u samples, %u NACKs of %u early reads", (int)mode,
+                   (unsigned)(errors.read_retries - retries), (unsigned)published,
+                   (unsigned)mock.nacks, (unsigned)mock.early_reads);
+    }
+    /* Bring-up once: the calibration is kept across restarts */
+    HOST_CHECK(mock.prom_reads == (bringup ? 7U : 0U) && mock.resets == (bringup ? 1U : 0U),
+               "mode %d: %u resets %u PROM reads", (int)mode, (unsigned)mock.resets,
+               (unsigned)mock.prom_reads);
+    bringup = false;
+
+    sensor_sampling_register_publish_callback(NULL);
+    return published;
+}
+
+static void host_test_sampler(void)
+{
+    static const char *const names[] = { "sequential", "pipelined", "exact" };
+    /* Below 20 degC: the second-order terms change the result */
+    const uint32_t cold_d2 = 6000000UL;
+    uint32_t rate[3];
+
+    for (uint32_t mode = 0; mode < 3U; mode++) {
+        rate[mode] = host_test_run((sensor_sampling_mode_t)mode, false, HOST_DATASHEET_D2, 0);
+        printf("  %-10s %4u samples/s\n", names[mode], (unsigned)rate[mode]);
+    }
+    (void)host_test_run(SENSOR_MODE_PIPELINED, true, cold_d2, 0);
+    /* Exact mode reads at the datasheet maximum: a slower part is NACKed
+     * once per read and the retry gets the result */
+    HOST_CHECK(host_test_run(SENSOR_MODE_EXACT, false, HOST_DATASHEET_D2, 150) == rate[SENSOR_MODE_EXACT],
+               "exact, slow part: lost samples");
+
+    /* Boot profile row: the pipelined cycle is two ticks */
+    HOST_CHECK(rate[SENSOR_MODE_PIPELINED] == BOARD_TIM2_FREQ_HZ / 2U,
+               "pipelined: %u samples/s, expected %u", (unsigned)rate[SENSOR_MODE_PIPELINED],
+               (unsigned)(BOARD_TIM2_FREQ_HZ / 2U));
+    HOST_CHECK(rate[SENSOR_MODE_SEQUENTIAL] < rate[SENSOR_MODE_PIPELINED],
+               "sequential not slower than pipelined");
+}
+
+/**
+ * @brief Conversions ending after the sampler's wait, their early reads
+ *        answered with 0 as the MS5837 does
+ *
+ * A calibrated time too short (conv_tune.h) widens its level to the
+ * datasheet time after BOARD_SENSOR_LATE_WIDEN_AFTER reads of 0; a part
+ * slower than the datasheet is read again in every conversion. Either
+ * way each read of 0 is read again later and none is published.
+ */
+static void host_test_late(void)
+{
+    static const struct {
+        const char *name;
+        sensor_sampling_mode_t mode;
+        sensor_osr_t pressure_osr;
+        uint32_t conv_pct;   /* Part, % of the datasheet time */
+        uint32_t tune_pct;   /* Calibrated wait, % likewise */
+        uint32_t widened;    /* Levels expected back on the datasheet time */
+    } cases[] = {
+        { "exact, tuned short",     SENSOR_MODE_EXACT,     SENSOR_OSR_256,  100U, 80U,  1U },
+        { "pipelined, tuned short", SENSOR_MODE_PIPELINED, SENSOR_OSR_4096, 100U, 80U,  1U },
+        { "exact, slow part",       SENSOR_MODE_EXACT,     SENSOR_OSR_256,  120U, 100U, 0U },
+    };
+
+    for (uint32_t n = 0; n < sizeof(cases) / sizeof(cases[0]); n++) {
+        host_sensor_config_t *cfg;
+        sensor_error_stats_t before;
+        sensor_error_stats_t errors;
+        host_sensor_stats_t mock;
+        uint32_t late, widened;
+
+        host_test_stop();
+        host_reset(NULL);
+        cfg = host_sensor_config();
+        cfg->early_nack = false;
+        for (uint32_t i = 0; i < HOST_SENSOR_OSR_COUNT; i++) {
+            host_conv_tune_us()[i] = (uint16_t)(cfg->conv_us[i] * cases[n].tune_pct / 100U);
+            cfg->conv_us[i] = (uint16_t)(cfg->conv_us[i] * cases[n].conv_pct / 100U);
+        }
+        host_test_reference(false, HOST_DATASHEET_D1, HOST_DATASHEET_D2, &expect_pressure,
+                            &expect_temperature);
+        sensor_sampling_get_error_stats(&before);  /* Counters are since boot */
+
+        HOST_CHECK(sensor_sampling_init(), "late: sensor_sampling_init");
+        (void)sensor_sampling_set_mode(cases[n].mode);
+        (void)sensor_sampling_set_profile(cases[n].pressure_osr, SENSOR_OSR_256);
+        sensor_sampling_set_second_order(false);
+        sensor_sampling_register_publish_callback(host_test_on_publish);
+        published = 0;
+        published_wrong = 0;
+        published_gaps = 0;
+        (void)sensor_sampling_start();
+        host_run_us(HOST_TEST_RUN_US);
+        sensor_sampling_register_publish_callback(NULL);
+
+        sensor_sampling_get_error_stats(&errors);
+        host_sensor_get_stats(&mock);
+        late = errors.late_reads - before.late_reads;
+        widened = errors.conv_widened - before.conv_widened;
+
+        HOST_CHECK(published > 0U && published_wrong == 0U && published_gaps == 0U,
+                   "late, %s: %u of %u samples not %d %d, %u gaps", cases[n].name,
+                   (unsigned)published_wrong, (unsigned)published, (int)expect_pressure,
+                   (int)expect_temperature, (unsigned)published_gaps);
+        HOST_CHECK(errors.errors == before.errors && late == mock.zero_reads && late != 0U,
+                   "late, %s: %u aborted cycles, %u late reads of %u reads of 0", cases[n].name,
+                   (unsigned)(errors.errors - before.errors), (unsigned)late,
+                   (unsigned)mock.zero_reads);
+        HOST_CHECK(widened == cases[n].widened &&
+                   (widened == 0U ? late >= published : late == widened * BOARD_SENSOR_LATE_WIDEN_AFTER),
+                   "late, %s: %u levels widened after %u late reads (%u samples)", cases[n].name,
+                   (unsigned)widened, (unsigned)late, (unsigned)published);
+    }
+    (void)sensor_sampling_set_profile((sensor_osr_t)BOARD_SAMPLING_P_OSR, (sensor_osr_t)BOARD_SAMPLING_T_OSR);
+}
+
+/**
+ * @brief Tick deadline: bus errors whose recovery blocks the tick handler
+ *        for recover_us, shorter and then longer than the tick period
+ */
+static void host_test_overrun(void)
+{
+    uint32_t period_us = 1000000UL / BOARD_TIM2_FREQ_HZ;
+
+    for (uint32_t late = 0; late < 2U; late++) {
+        uint32_t recover_us = late ? period_us + period_us / 4U : period_us / 2U;
+        sensor_tick_stats_t before;
+        sensor_tick_stats_t ticks;
+        host_sensor_stats_t mock;
+        uint32_t error_state = SENSOR_TICK_STATE_COUNT - 1U;  /* Last (sensor_tick_stats_t) */
+
+        host_test_stop();
+        host_reset(NULL);
+        host_sensor_config()->bus_error_ppm = 20000U;
+        host_sensor_config()->recover_us = recover_us;
+        host_sensor_config()->seed = 7U;
+        (void)sensor_sampling_init();
+        (void)sensor_sampling_set_mode(SENSOR_MODE_PIPELINED);
+        (void)sensor_sampling_start();
+        sensor_sampling_get_tick_stats(&before);  /* Counters are since boot */
+        host_run_us(HOST_TEST_RUN_US);
+        sensor_sampling_get_tick_stats(&ticks);
+        host_sensor_get_stats(&mock);
+        ticks.ticks -= before.ticks;
+        ticks.overruns -= before.overruns;
+
+        HOST_CHECK(mock.recoveries > 0U, "overrun: no bus recovery in %u us", (unsigned)HOST_TEST_RUN_US);
+        HOST_CHECK(ticks.overruns == (late ? mock.recoveries : 0U),
+                   "overrun: recovery %u us of a %u us tick: %u overruns, %u recoveries",
+                   (unsigned)recover_us, (unsigned)period_us, (unsigned)ticks.overruns,
+                   (unsigned)mock.recoveries);
+        HOST_CHECK(ticks.wcet_us[error_state] == recover_us && ticks.max_us == recover_us &&
+                   ticks.max_state == error_state,
+                   "overrun: longest tick %u us in state %u (error state %u us), expected %u us",
+                   (unsigned)ticks.max_us, (unsigned)ticks.max_state,
+                   (unsigned)ticks.wcet_us[error_state], (unsigned)recover_us);
+        /* Blocked for less than two periods the next tick runs late, on the
+         * pending flag, and none is lost: the grid is kept */
+        HOST_CHECK(ticks.ticks == HOST_TEST_RUN_US / period_us,
+                   "overrun: %u ticks, %u overruns in %u periods", (unsigned)ticks.ticks,
+                   (unsigned)ticks.overruns, (unsigned)(HOST_TEST_RUN_US / period_us));
+    }
+}
+
+/**
+ * @brief Poll the benchmark sweep until it ends (or the time it may take)
+ *
+ * @param rows Stop it once this many rows are done (BENCH_STEPS: not)
+ */
+static bench_state_t host_test_sweep_run(uint32_t rows)
+{
+    const bench_header_t *header;
+    uint16_t len;
+
+    for (uint32_t t = 0; t < HOST_TEST_SWEEP_US && bench_get_state() == BENCH_RUNNING;
+         t += HOST_TEST_POLL_US) {
+        header = (const bench_header_t *)bench_take(&len);
+        if (header->rows >= rows) {
+            bench_stop();
+        }
+        host_run_us(HOST_TEST_POLL_US);
+        bench_poll(host_now_us());
+    }
+    return bench_get_state();
+}
+
+/**
+ * @brief Sampler settings bench_start() saves are the ones set before
+ */
+static void host_test_bench_restored(const char *when, uint32_t rate_hz)
+{
+    sensor_osr_t pressure_osr, temperature_osr;
+
+    sensor_sampling_get_profile(&pressure_osr, &temperature_osr);
+    HOST_CHECK(sensor_sampling_get_rate_hz() == rate_hz &&
+               sensor_sampling_get_mode() == SENSOR_MODE_SEQUENTIAL &&
+               pressure_osr == SENSOR_OSR_1024 && temperature_osr == SENSOR_OSR_512 &&
+               hal_i2c2_get_speed() == HAL_I2C_SPEED_FAST &&
+               host_sensor_config()->bus_hz == 400000UL,
+               "bench %s: %u Hz, mode %d, OSR %d/%d, speed %d (%u Hz) not restored", when,
+               (unsigned)sensor_sampling_get_rate_hz(), (int)sensor_sampling_get_mode(),
+               (int)pressure_osr, (int)temperature_osr, (int)hal_i2c2_get_speed(),
+               (unsigned)host_sensor_config()->bus_hz);
+}
+
+/**
+ * @brief On-target benchmark: each step in order, measured at the bus
+ *        speed it names, and the settings in force before set again once
+ *        it ends or is stopped
+ */
+static void host_test_bench(void)
+{
+    const uint32_t rate_hz = BOARD_TIM2_FREQ_HZ / 4U;
+    const bench_header_t *header;
+    const bench_row_t *rows;
+    host_sensor_stats_t mock;
+    uint32_t measured = 0;
+    uint32_t wrong = 0;
+    uint32_t slower = 0;
+    uint16_t len;
+
+    host_test_stop();
+    host_reset(NULL);
+    (void)sensor_sampling_init();
+    HOST_CHECK(sensor_sampling_set_mode(SENSOR_MODE_SEQUENTIAL) &&
+               sensor_sampling_set_profile(SENSOR_OSR_1024, SENSOR_OSR_512) &&
+               sensor_sampling_set_rate_hz(rate_hz), "bench: settings before");
+    (void)sensor_sampling_start();
+    host_run_us(HOST_TEST_BRINGUP_US);
+
+    HOST_CHECK(bench_start() && !bench_start(), "bench_start: not once");
+    HOST_CHECK(host_test_sweep_run(BENCH_STEPS) == BENCH_DONE, "bench: state %d after %u us",
+               (int)bench_get_state(), (unsigned)HOST_TEST_SWEEP_US);
+
+    header = (const bench_header_t *)bench_take(&len);
+    rows = (const bench_row_t *)(header + 1);
+    HOST_CHECK(len == sizeof(bench_header_t) + BENCH_STEPS * sizeof(bench_row_t) &&
+               header->version == BENCH_VERSION && header->state == BENCH_DONE &&
+               header->rows == BENCH_STEPS && header->steps == BENCH_STEPS &&
+               header->dwell_ms == BOARD_BENCH_DWELL_MS,
+               "bench_take: %u bytes, version %u state %u rows %u of %u, dwell %u ms", (unsigned)len,
+               (unsigned)header->version, (unsigned)header->state, (unsigned)header->rows,
+               (unsigned)header->steps, (unsigned)header->dwell_ms);
+    for (uint32_t i = 0; i < BENCH_STEPS; i++) {
+        const bench_row_t *row = &rows[i];
+
+        /* OSR fastest, then mode, then speed */
+        if (row->osr != i % BENCH_OSRS || row->mode != (i / BENCH_OSRS) % BENCH_MODES ||
+            row->speed != i / (BENCH_OSRS * BENCH_MODES) ||
+            ((row->flags & BENCH_ROW_REFUSED) != 0U) != (row->rate_centihz == 0U) ||
+            row->rate_centihz > BOARD_TIM2_FREQ_HZ * 100U + HOST_TEST_RATE_SLACK ||
+            row->errors != 0U || row->overruns != 0U) {
+            wrong++;
+        }
+        if ((row->flags & BENCH_ROW_REFUSED) == 0U) {
+            measured++;
+        }
+        /* A faster bus never costs throughput */
+        if (i >= BENCH_OSRS * BENCH_MODES && row->rate_centihz + HOST_TEST_RATE_SLACK <
+            rows[i - BENCH_OSRS * BENCH_MODES].rate_centihz) {
+            slower++;
+        }
+    }
+    printf("  bench      %u of %u steps measured\n", (unsigned)measured, (unsigned)BENCH_STEPS);
+    HOST_CHECK(wrong == 0U, "bench: %u rows out of order, off the tick rate or with errors", (unsigned)wrong);
+    HOST_CHECK(slower == 0U, "bench: %u rows slower on the faster bus", (unsigned)slower);
+    /* The mock takes every combination */
+    HOST_CHECK(measured == BENCH_STEPS, "bench: %u steps refused", (unsigned)(BENCH_STEPS - measured));
+    /* One re-init per speed, one more back to the speed before */
+    host_sensor_get_stats(&mock);
+    HOST_CHECK(mock.inits == BENCH_SPEEDS + 1U, "bench: %u I2C2 re-inits", (unsigned)mock.inits);
+    host_test_bench_restored("done", rate_hz);
+
+    /* Stopped part way: the rows done kept, the settings back */
+    HOST_CHECK(bench_start(), "bench_start after done");
+    HOST_CHECK(host_test_sweep_run(3) == BENCH_STOPPED, "bench_stop: state %d", (int)bench_get_state());
+    header = (const bench_header_t *)bench_take(&len);
+    HOST_CHECK(header->state == BENCH_STOPPED && header->rows == 3U &&
+               len == sizeof(bench_header_t) + 3U * sizeof(bench_row_t),
+               "bench_take after stop: state %u, %u rows, %u bytes", (unsigned)header->state,
+               (unsigned)header->rows, (unsigned)len);
+    host_test_bench_restored("stopped", rate_hz);
+}
+
+static void host_bench_compensate(void)
+{
+    ms5837_calib_t calib;
+    uint32_t d1[HOST_TEST_BENCH_BATCH];
+    uint32_t d2[HOST_TEST_BENCH_BATCH];
+    int32_t bp[HOST_TEST_BENCH_BATCH];
+    int32_t bt[HOST_TEST_BENCH_BATCH];
+    volatile int32_t sink = 0;
+    uint64_t start;
+    uint64_t single_ns;
+    uint64_t batch_ns;
+
+    (void)ms5837_calib_prepare(prom, &calib);
+    ms5837_calib_set_second_order(&calib, true);
+
+    start = host_wall_ns();
+    for (uint32_t i = 0; i < HOST_TEST_BENCH_CALLS; i++) {
+        int32_t p;
+        int32_t t;
+
+        ms5837_compensate(&calib, HOST_DATASHEET_D1 + i * 97U, HOST_DATASHEET_D2 - (i & 0xFFFFU) * 31U, &p, &t);
+        sink = p ^ t;
+    }
+    single_ns = host_wall_ns() - start;
+
+    start = host_wall_ns();
+    for (uint32_t i = 0; i < HOST_TEST_BENCH_CALLS / HOST_TEST_BENCH_BATCH; i++) {
+        for (uint32_t k = 0; k < HOST_TEST_BENCH_BATCH; k++) {
+            d1[k] = HOST_DATASHEET_D1 + (i * HOST_TEST_BENCH_BATCH + k) * 97U;
+            d2[k] = HOST_DATASHEET_D2 - (i & 0xFFFFU) * 31U;  /* Temperature decimated */
+        }
+        (void)ms5837_compensate_batch(&calib, d1, d2, bp, bt, HOST_TEST_BENCH_BATCH);
+        sink = bp[HOST_TEST_BENCH_BATCH - 1U];
+    }
+    batch_ns = host_wall_ns() - start;
+    (void)sink;
+
+    printf("  %-26s %8.1f ns %8.2f M/s\n", "ms5837_compensate",
+           (double)single_ns / HOST_TEST_BENCH_CALLS, HOST_TEST_BENCH_CALLS * 1000.0 / (double)single_ns);
+    printf("  %-26s %8.1f ns %8.2f M/s\n", "ms5837_compensate_batch",
+           (double)batch_ns / HOST_TEST_BENCH_CALLS, HOST_TEST_BENCH_CALLS * 1000.0 / (double)batch_ns);
+}
+
+static void host_bench_tracker(void)
+{
+    sensor_data_t sample;
+    uint64_t start;
+    uint64_t ns;
+
+    memset(&sample, 0, sizeof(sample));
+    sample.valid = true;
+    start = host_wall_ns();
+    for (uint32_t i = 0; i < HOST_TEST_BENCH_CALLS; i++) {
+        sample.timestamp_us = i * 2000U;
+        sample.sequence = i;
+        sample.pressure = 101325 + (int32_t)(i * 7U % 23U);
+        tracker_update(&sample);
+    }
+    ns = host_wall_ns() - start;
+    printf("  %-26s %8.1f ns %8.2f M/s\n", "tracker_update",
+           (double)ns / HOST_TEST_BENCH_CALLS, HOST_TEST_BENCH_CALLS * 1000.0 / (double)ns);
+}
+
+/**
+ * @brief Bottom half per sample: compensation, median, filter, tracker,
+ *        statistics and publication
+ */
+static void host_bench_bottom_half(const char *name, sensor_filter_mode_t mode, uint8_t log2,
+                                   uint8_t median)
+{
+    uint64_t ns;
+    uint32_t runs;
+
+    host_test_stop();
+    host_reset(NULL);
+    host_sensor_config()->d1_noise = 2000U;  /* Every filter stage does work */
+    (void)sensor_sampling_init();
+    (void)sensor_sampling_set_mode(SENSOR_MODE_PIPELINED);
+    HOST_CHECK(sensor_sampling_set_filter(mode, log2, log2), "set_filter %s", name);
+    HOST_CHECK(sensor_sampling_set_median(median), "set_median %s", name);
+    (void)sensor_sampling_start();
+    host_run_us(HOST_TEST_BRINGUP_US);
+
+    ns = host_bottom_half_ns();
+    runs = host_bottom_half_runs();
+    host_run_us(HOST_TEST_BENCH_RUN_US);
+    ns = host_bottom_half_ns() - ns;
+    runs = host_bottom_half_runs() - runs;
+    HOST_CHECK(runs > 0U, "bottom half %s never ran", name);
+    if (runs > 0U) {
+        printf("  %-26s %8.1f ns %8.2f M/s\n", name, (double)ns / runs, runs * 1000.0 / (double)ns);
+    }
+
+    (void)sensor_sampling_set_filter(SENSOR_FILTER_NONE, 0, 0);
+    (void)sensor_sampling_set_median(0);
+}
+
+/* ============================================================================
+ * MAIN
+ * ============================================================================ */
+
+int main(void)
+{
+    printf("compensation (%s)\n", (BOARD_SENSOR_VARIANT == BOARD_SENSOR_VARIANT_30BA) ? "30BA" : "02BA");
+    host_test_golden();
+    host_test_variant();
+    host_test_sweep();
+#if BOARD_SENSOR_VARIANT == BOARD_SENSOR_VARIANT_02BA
+    host_test_original_sweep();
+#endif
+    printf("dac\n");
+    host_test_dac();
+    printf("mem*\n");
+    host_test_mem();
+    printf("sampler\n");
+    host_test_sampler();
+    host_test_late();
+    host_test_overrun();
+    host_test_bench();
+
+    printf("throughput (host, per call or sample)\n");
+    host_bench_compensate();
+    host_bench_tracker();
+    host_bench_bottom_half("bottom half, unfiltered", SENSOR_FILTER_NONE, 0, 0);
+    host_bench_bottom_half("bottom half, median 5+IIR", SENSOR_FILTER_IIR, 2, 5);
+
+    if (failures != 0U) {
+        printf("%u check(s) failed\n", (unsigned)failures);
+        return EXIT_FAILURE;
+    }
+    printf("all checks passed\n");
+    return EXIT_SUCCESS;
+}
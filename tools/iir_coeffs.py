@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+"""
+IIR low-pass coefficients for the sampler filter stage (SENSOR_FILTER_IIR).
+
+Designs Butterworth low-pass sections with the bilinear transform and prints
+them as sensor_iir_coeffs_t initialisers: b0, b1, b2, a1, a2 in Q2.30
+(1.0 = 1 << 30), for
+  y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]
+b1 absorbs the rounding so the DC gain is exactly 1 in fixed point: a
+constant input comes out unchanged, with no offset.
+
+  iir_coeffs.py --order 2 --cutoff 0.01     one section, fc / fs = 0.01
+  iir_coeffs.py --presets                   the sensor_iir_presets[] table
+
+Custom sections go to sensor_sampling_set_iir_coeffs().
+"""
+
+import argparse
+import math
+import sys
+
+ONE = 1 << 30
+
+# fc / fs of the built-in presets (SENSOR_IIR_PRESET_*), second order then
+# first order
+PRESET_CUTOFFS = [1.0 / (1 << (k + 2)) for k in range(6)]
+
+
+def design(order, cutoff):
+    """Floating point (b0, b1, b2, a1, a2), cutoff = fc / fs."""
+    if not 0.0 < cutoff < 0.5:
+        raise ValueError("cutoff must be between 0 and 0.5 of the sample rate")
+    k = math.tan(math.pi * cutoff)
+    if order == 1:
+        norm = 1.0 / (1.0 + k)
+        return (k * norm, k * norm, 0.0, (k - 1.0) * norm, 0.0)
+    if order == 2:
+        norm = 1.0 / (1.0 + math.sqrt(2.0) * k + k * k)
+        b0 = k * k * norm
+        return (b0, 2.0 * b0, b0, 2.0 * (k * k - 1.0) * norm,
+                (1.0 - math.sqrt(2.0) * k + k * k) * norm)
+    raise ValueError("order must be 1 or 2")
+
+
+def quantise(coeffs):
+    """Q2.30 integers with unity DC gain."""
+    b0, _, b2, a1, a2 = [round(c * ONE) for c in coeffs]
+    b1 = ONE + a1 + a2 - b0 - b2
+    return (b0, b1, b2, a1, a2)
+
+
+def initialiser(order, cutoff):
+    values = ", ".join("%d" % v for v in quantise(design(order, cutoff)))
+    return "{ %s },  /* Order %d, fc = fs / %g */" % (values, order, 1.0 / cutoff)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("--order", type=int, default=2, choices=(1, 2))
+    parser.add_argument("--cutoff", type=float, help="fc / fs (0 .. 0.5)")
+    parser.add_argument("--presets", action="store_true",
+                        help="print the built-in preset table")
+    args = parser.parse_args()
+
+    if args.presets:
+        for order in (2, 1):
+            for cutoff in PRESET_CUTOFFS:
+                print("    " + initialiser(order, cutoff))
+        return 0
+    if args.cutoff is None:
+        parser.error("--cutoff or --presets is needed")
+    try:
+        print(initialiser(args.order, args.cutoff))
+    except ValueError as error:
+        parser.error(str(error))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,191 @@
+#!/usr/bin/env python3
+"""
+Probe ring decoder (drivers/probe/probe.h, BOARD_PROBE_ENABLE builds).
+
+Reads one probe frame: the bytes of a read at APP_REG_PROBE after
+HOST_CMD_PROBE froze the ring, or of the probe_frame variable dumped over
+SWD (e.g. gdb "dump binary value probe.bin probe_frame"), from a file or
+stdin ('-'). Prints the records oldest first, one line each:
+  <time us> <+delta us> <name>
+with the 24-bit timestamps unwrapped, the names taken from probe_id_t of
+probe.h, perf_isr_t of perf.h and the sampler states of
+sensor_sampling.c. With --vcd it also writes a VCD file for a waveform
+viewer: one wire per handler source (high inside it), the sensor bus
+transfer, the slave transaction, and the sampler state as a vector.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+HEADER = struct.Struct("<BBBBI")
+TIME_MASK = 0xFFFFFF
+ENUM_RE = re.compile(r"^\s*([A-Z][A-Z0-9_]*)\s*(?:=\s*(0x[0-9a-fA-F]+|\d+))?\s*,?\s*(?:/\*.*)?$")
+
+
+def read_enum(path, typedef):
+    """{value: name} of the enum typedef in a C source."""
+    names = {}
+    lines = []
+    with open(path) as source:
+        for line in source:
+            if line.startswith("typedef enum"):
+                lines = []
+            elif line.startswith("}") and typedef in line:
+                break
+            else:
+                lines.append(line)
+        else:
+            sys.exit("No %s in %s" % (typedef, path))
+    next_value = 0
+    for line in lines:
+        match = ENUM_RE.match(line)
+        if match:
+            name, value = match.groups()
+            if value is not None:
+                next_value = int(value, 0)
+            names[next_value] = name
+            next_value += 1
+    return names
+
+
+class Names:
+    def __init__(self, args):
+        self.ids = read_enum(args.header, "probe_id_t")
+        self.isrs = read_enum(args.perf_header, "perf_isr_t")
+        self.states = read_enum(args.states, "sensor_state_t")
+        self.base = {name: value for value, name in self.ids.items()}
+
+    def split(self, ident):
+        """(kind, detail) of a record ID: kind is the probe_id_t name."""
+        for kind, count in (("PROBE_ID_ISR_ENTER", 16), ("PROBE_ID_ISR_EXIT", 16),
+                            ("PROBE_ID_SENSOR_STATE", 32)):
+            base = self.base[kind]
+            if base <= ident < base + count:
+                return kind, ident - base
+        return self.ids.get(ident, "0x%02X" % ident), None
+
+    def text(self, ident):
+        kind, detail = self.split(ident)
+        if kind == "PROBE_ID_SENSOR_STATE":
+            return "state " + self.states.get(detail, str(detail))
+        if detail is not None:
+            return "%s %s" % ("enter" if kind == "PROBE_ID_ISR_ENTER" else "exit",
+                              self.isrs.get(detail, str(detail)))
+        return kind.replace("PROBE_ID_", "").lower()
+
+
+def read_frame(data):
+    """(frozen, written, ring size, records oldest first) of a frame."""
+    if len(data) < HEADER.size:
+        sys.exit("Frame too short (%d bytes)" % len(data))
+    version, size_log2, frozen, _, written = HEADER.unpack_from(data)
+    if version != 1:
+        sys.exit("Unknown frame version %d" % version)
+    size = 1 << size_log2
+    if len(data) < HEADER.size + 4 * size:
+        sys.exit("Frame of %d bytes, expected %d" % (len(data), HEADER.size + 4 * size))
+    ring = struct.unpack_from("<%dI" % size, data, HEADER.size)
+    if written <= size:
+        records = ring[:written]
+    else:
+        first = written % size
+        records = ring[first:] + ring[:first]
+    return frozen, written, size, records
+
+
+def unwrap(records):
+    """[(time us, id)] with the 24-bit timestamps made continuous, in time order."""
+    events = []
+    now = None
+    for record in records:
+        stamp = record & TIME_MASK
+        if now is None:
+            now = stamp
+        else:
+            # Records can be a few us out of order (probe.c): take the
+            # nearest time to the previous one, either side
+            delta = (stamp - now) & TIME_MASK
+            if delta >= 1 << 23:
+                delta -= 1 << 24
+            now += delta
+        events.append((now, record >> 24))
+    events.sort(key=lambda event: event[0])
+    return events
+
+
+def write_vcd(path, events, names):
+    wires = [("isr_" + name.replace("PERF_ISR_", "").lower(), value)
+             for value, name in sorted(names.isrs.items()) if name != "PERF_ISR_COUNT"]
+    codes = {}
+    with open(path, "w") as vcd:
+        vcd.write("$timescale 1us $end\n$scope module probe $end\n")
+        for index, (wire, _) in enumerate(wires):
+            codes[wire] = chr(ord("!") + index)
+            vcd.write("$var wire 1 %s %s $end\n" % (codes[wire], wire))
+        for wire in ("sensor_bus", "slave"):
+            codes[wire] = chr(ord("!") + len(codes))
+            vcd.write("$var wire 1 %s %s $end\n" % (codes[wire], wire))
+        codes["state"] = chr(ord("!") + len(codes))
+        vcd.write("$var reg 5 %s sensor_state $end\n" % codes["state"])
+        vcd.write("$upscope $end\n$enddefinitions $end\n$dumpvars\n")
+        for wire in codes:
+            vcd.write(("bx %s\n" if wire == "state" else "0%s\n") % codes[wire])
+        vcd.write("$end\n")
+
+        origin = events[0][0] if events else 0
+        isr_wires = {value: wire for wire, value in wires}
+        for time_us, ident in events:
+            kind, detail = names.split(ident)
+            change = None
+            if kind in ("PROBE_ID_ISR_ENTER", "PROBE_ID_ISR_EXIT") and detail in isr_wires:
+                change = "%d%s" % (kind == "PROBE_ID_ISR_ENTER", codes[isr_wires[detail]])
+            elif kind == "PROBE_ID_SENSOR_STATE":
+                change = "b%s %s" % (format(detail, "b"), codes["state"])
+            elif kind == "PROBE_ID_SENSOR_XFER":
+                change = "1" + codes["sensor_bus"]
+            elif kind in ("PROBE_ID_SENSOR_DONE", "PROBE_ID_SENSOR_FAIL"):
+                change = "0" + codes["sensor_bus"]
+            elif kind in ("PROBE_ID_SLAVE_READ", "PROBE_ID_SLAVE_WRITE"):
+                change = "1" + codes["slave"]
+            elif kind == "PROBE_ID_SLAVE_END":
+                change = "0" + codes["slave"]
+            if change is not None:
+                vcd.write("#%d\n%s\n" % (time_us - origin, change))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("input", help="Frame file, '-' for stdin")
+    parser.add_argument("--header", default="drivers/probe/probe.h",
+                        help="probe.h of the firmware that produced the frame")
+    parser.add_argument("--perf-header", default="drivers/perf/perf.h",
+                        help="perf.h for the handler source names")
+    parser.add_argument("--states", default="app/sensor_sampling.c",
+                        help="Source of the sampler state names")
+    parser.add_argument("--vcd", help="Also write a VCD file")
+    args = parser.parse_args()
+
+    names = Names(args)
+    if args.input == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.input, "rb") as stream:
+            data = stream.read()
+
+    frozen, written, size, records = read_frame(data)
+    events = unwrap(records)
+    print("-- %d records written, %d shown (ring of %d)%s"
+          % (written, len(events), size, "" if frozen else ", not frozen: may be torn"))
+    origin = events[0][0] if events else 0
+    previous = origin
+    for time_us, ident in events:
+        print("%10d %+7d %s" % (time_us - origin, time_us - previous, names.text(ident)))
+        previous = time_us
+    if args.vcd:
+        write_vcd(args.vcd, events, names)
+
+
+if __name__ == "__main__":
+    main()
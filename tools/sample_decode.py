@@ -0,0 +1,376 @@
+#!/usr/bin/env python3
+"""
+Sample decoder for the FIFO burst, USB stream, UART stream and SD log formats.
+
+Decodes both layouts of each transport: the fixed 16-byte samples and the
+delta/varint codec of drivers/sample_codec/sample_codec.h
+(BOARD_SAMPLE_CODEC_ENABLE builds), and prints one line per sample:
+  <timestamp us> <sequence> <pressure mbar> <temperature degC>
+Sequence gaps (samples dropped on the device) are reported inline.
+With --crc (BOARD_CRC_FRAMING_ENABLE builds) the CRC of every frame is
+checked and a frame that fails it is reported and skipped.
+
+  usb  the CDC stream: a capture file, the virtual COM port (raw mode,
+       stty -F /dev/ttyACM0 raw) or stdin ('-')   (usb_stream.h)
+  hid  the HID reports (USB_CLASS=HID): the hidraw device or a capture of
+       its reads; the latest sample only, so sequence gaps are samples
+       superseded, and report gaps are polls missed   (usb_stream.h)
+  uart the COBS-framed UART stream, always CRC-checked: a capture file,
+       the serial port (raw mode at BOARD_UART_STREAM_BAUD) or stdin;
+       --command OPCODE ARG first sends one command frame (uart_stream.h)
+  sd   a LOGnnnnn.BIN file from the card          (sd_log.h)
+  fifo burst frames as hex, one frame per line    (host_fifo.h)
+"""
+
+import argparse
+import binascii
+import struct
+import sys
+import zlib
+
+KEYFRAME = 0x01
+KEYFRAME_BODY = struct.Struct("<IIii")
+RAW_SAMPLE = struct.Struct("<IIii")       # Sample record, every transport
+FIFO_RAW_SAMPLE = struct.Struct("<iiII")  # Older FIFO format 0: pressure, temperature, timestamp, sequence
+
+USB_SYNC = 0x5A
+USB_SYNC_CODEC = 0x5B
+USB_HEADER = struct.Struct("<BBH")
+USB_SYNC_HID = 0x5C
+HID_REPORT = struct.Struct("<BBH16sBBH")
+
+SD_SECTOR = 512
+SD_HEADER = struct.Struct("<IIII")
+SD_MAGIC = 0x474F4C53
+SD_MAGIC_CODEC = 0x5A4F4C53
+
+UART_TYPE_SAMPLES = 0x01
+UART_TYPE_RESULT = 0x02
+UART_HEADER = struct.Struct("<BBH")
+UART_COMMAND = struct.Struct("<IB")
+
+FIFO_HEADER = struct.Struct("<BBH")
+FIFO_FORMAT_RAW = 0x00
+FIFO_FORMAT_CODEC = 0x01
+FIFO_FORMAT_RECORD = 0x02
+
+CRC16 = struct.Struct("<H")
+CRC32 = struct.Struct("<I")
+SD_CRC_OFFSET = SD_SECTOR - CRC32.size
+
+
+class Truncated(Exception):
+    """Encoded samples ran past the end of the data."""
+
+
+def to_int32(value):
+    value &= 0xFFFFFFFF
+    return value - 0x100000000 if value & 0x80000000 else value
+
+
+def unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE, as drivers/crc/crc.h."""
+    return binascii.crc_hqx(data, 0xFFFF)
+
+
+class Decoder:
+    """Decoder state: the previous sample of one stream (sample_codec_t)."""
+
+    def __init__(self):
+        self.sample = None
+        self.interval = 0
+
+    def reset(self):
+        self.sample = None
+
+    def varint(self, data, pos):
+        value = 0
+        shift = 0
+        while True:
+            if pos >= len(data):
+                raise Truncated()
+            byte = data[pos]
+            pos += 1
+            value |= (byte & 0x7F) << shift
+            if not byte & 0x80:
+                return value, pos
+            shift += 7
+
+    def decode(self, data, pos):
+        """(sample or None before the first keyframe, next position)."""
+        if pos >= len(data):
+            raise Truncated()
+        if data[pos] == KEYFRAME:
+            if pos + 1 + KEYFRAME_BODY.size > len(data):
+                raise Truncated()
+            self.sample = KEYFRAME_BODY.unpack_from(data, pos + 1)
+            self.interval = 0
+            return self.sample, pos + 1 + KEYFRAME_BODY.size
+
+        tag, pos = self.varint(data, pos)
+        residual, pos = self.varint(data, pos)
+        d_pressure, pos = self.varint(data, pos)
+        d_temperature, pos = self.varint(data, pos)
+        if self.sample is None:
+            return None, pos  # Joined mid-stream: wait for a keyframe
+        timestamp, sequence, pressure, temperature = self.sample
+        self.interval = (self.interval + unzigzag(residual)) & 0xFFFFFFFF
+        self.sample = ((timestamp + self.interval) & 0xFFFFFFFF,
+                       (sequence + (tag >> 1) + 1) & 0xFFFFFFFF,
+                       to_int32(pressure + unzigzag(d_pressure)),
+                       to_int32(temperature + unzigzag(d_temperature)))
+        return self.sample, pos
+
+
+class Printer:
+    def __init__(self, out):
+        self.out = out
+        self.last_sequence = None
+
+    def sample(self, timestamp, sequence, pressure, temperature):
+        if self.last_sequence is not None and sequence != (self.last_sequence + 1) & 0xFFFFFFFF:
+            self.out.write("-- %d samples dropped\n" % ((sequence - self.last_sequence - 1) & 0xFFFFFFFF))
+        self.last_sequence = sequence
+        self.out.write("%10d %10d %10.2f %7.2f\n" % (timestamp, sequence, pressure / 100.0,
+                                                    temperature / 100.0))
+
+    def note(self, text):
+        self.out.write("-- %s\n" % text)
+
+
+def decode_usb(stream, printer, check):
+    buffer = b""
+    decoder = Decoder()
+    while True:
+        chunk = stream.read(256)
+        if not chunk:
+            break
+        buffer += chunk
+        while len(buffer) >= USB_HEADER.size:
+            sync, count, _ = USB_HEADER.unpack_from(buffer)
+            if sync not in (USB_SYNC, USB_SYNC_CODEC) or count == 0:
+                skip = 1
+                while skip < len(buffer) and buffer[skip] not in (USB_SYNC, USB_SYNC_CODEC):
+                    skip += 1
+                printer.note("skipped %d bytes" % skip)
+                buffer = buffer[skip:]
+                decoder.reset()
+                continue
+            pos = USB_HEADER.size
+            samples = []
+            saved = (decoder.sample, decoder.interval)
+            try:
+                for _ in range(count):
+                    if sync == USB_SYNC:
+                        if pos + RAW_SAMPLE.size > len(buffer):
+                            raise Truncated()
+                        samples.append(RAW_SAMPLE.unpack_from(buffer, pos))
+                        pos += RAW_SAMPLE.size
+                    else:
+                        sample, pos = decoder.decode(buffer, pos)
+                        samples.append(sample)
+                if check:
+                    if pos + CRC16.size > len(buffer):
+                        raise Truncated()
+                    good = crc16(buffer[:pos]) == CRC16.unpack_from(buffer, pos)[0]
+                    pos += CRC16.size
+            except Truncated:
+                # Rest of the block still to come: decode it again then
+                decoder.sample, decoder.interval = saved
+                break
+            if check and not good:
+                # Not a block after all, or damaged: look for the next sync
+                printer.note("block failed its CRC")
+                buffer = buffer[1:]
+                decoder.reset()
+                continue
+            for sample in samples:
+                if sample is not None:
+                    printer.sample(*sample)
+            buffer = buffer[pos:]
+        printer.out.flush()
+
+
+def decode_hid(stream, printer):
+    last_seq = None
+    while True:
+        report = stream.read(HID_REPORT.size)
+        if len(report) < HID_REPORT.size:
+            break
+        sync, _, seq, record, _, _, _ = HID_REPORT.unpack(report)
+        if sync != USB_SYNC_HID:
+            printer.note("not a sample report")
+            continue
+        if last_seq is not None and seq != (last_seq + 1) & 0xFFFF:
+            printer.note("%d reports missed" % ((seq - last_seq - 1) & 0xFFFF))
+        last_seq = seq
+        # Superseded samples are not drops: no gap note for them
+        printer.last_sequence = None
+        printer.sample(*RAW_SAMPLE.unpack(record))
+        printer.out.flush()
+
+
+def cobs_decode(data):
+    out = bytearray()
+    pos = 0
+    while pos < len(data):
+        code = data[pos]
+        if code == 0 or pos + code > len(data):
+            return None
+        out += data[pos + 1:pos + code]
+        pos += code
+        if code != 0xFF and pos < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def cobs_encode(data):
+    out = bytearray()
+    run = bytearray()
+    for byte in data:
+        if byte == 0:
+            out += bytes([len(run) + 1]) + run
+            run = bytearray()
+        else:
+            run.append(byte)
+            if len(run) == 0xFE:
+                out += b"\xff" + run
+                run = bytearray()
+    out += bytes([len(run) + 1]) + run
+    return bytes(out) + b"\x00"
+
+
+def encode_command(opcode, argument):
+    """One command frame, as uart_stream.h reads it."""
+    body = UART_COMMAND.pack(argument & 0xFFFFFFFF, opcode)
+    return cobs_encode(body + CRC16.pack(crc16(body)))
+
+
+def decode_uart(stream, printer, check):
+    buffer = b""
+    while True:
+        chunk = stream.read(256)
+        if not chunk:
+            break
+        buffer += chunk
+        frames = buffer.split(b"\x00")
+        buffer = frames.pop()  # Rest of a frame still to come
+        for encoded in frames:
+            if not encoded:
+                continue
+            frame = cobs_decode(encoded)
+            if frame is None or len(frame) < UART_HEADER.size + CRC16.size or \
+                    crc16(frame[:-CRC16.size]) != CRC16.unpack_from(frame, len(frame) - CRC16.size)[0]:
+                printer.note("frame failed its CRC")
+                continue
+            kind, count, _ = UART_HEADER.unpack_from(frame)
+            body = frame[UART_HEADER.size:-CRC16.size]
+            if kind == UART_TYPE_SAMPLES and len(body) == count * RAW_SAMPLE.size:
+                for i in range(count):
+                    printer.sample(*RAW_SAMPLE.unpack_from(body, i * RAW_SAMPLE.size))
+            elif kind == UART_TYPE_RESULT and body:
+                printer.note("%d commands, last result %d" % (count, body[0]))
+            else:
+                printer.note("unknown frame type %d" % kind)
+        printer.out.flush()
+
+
+def decode_sd(stream, printer, check):
+    index = 0
+    while True:
+        sector = stream.read(SD_SECTOR)
+        if len(sector) < SD_SECTOR:
+            break
+        magic, sector_index, dropped, count = SD_HEADER.unpack_from(sector)
+        if magic not in (SD_MAGIC, SD_MAGIC_CODEC) or sector_index != index:
+            break  # End of the log (the rest of the pre-allocated file)
+        index += 1
+        if check and zlib.crc32(sector[:SD_CRC_OFFSET]) != CRC32.unpack_from(sector, SD_CRC_OFFSET)[0]:
+            printer.note("sector %d failed its CRC" % sector_index)
+            continue
+        pos = SD_HEADER.size
+        decoder = Decoder()
+        try:
+            for _ in range(count):
+                if magic == SD_MAGIC:
+                    sample = RAW_SAMPLE.unpack_from(sector, pos)
+                    pos += RAW_SAMPLE.size
+                else:
+                    sample, pos = decoder.decode(sector, pos)
+                printer.sample(*sample)
+        except (Truncated, struct.error, TypeError):
+            printer.note("sector %d damaged" % sector_index)
+    printer.note("%d sectors" % index)
+
+
+def decode_fifo(lines, printer, check):
+    for line in lines:
+        frame = bytes.fromhex(line.strip())
+        if len(frame) < FIFO_HEADER.size:
+            continue
+        count, fmt, _ = FIFO_HEADER.unpack_from(frame)
+        pos = FIFO_HEADER.size
+        if check and count != 0:
+            # Over the payload, then the header
+            end = len(frame) - CRC16.size
+            if end < pos or crc16(frame[pos:end] + frame[:pos]) != CRC16.unpack_from(frame, end)[0]:
+                printer.note("frame failed its CRC")
+                continue
+        decoder = Decoder()
+        try:
+            for _ in range(count):
+                if fmt == FIFO_FORMAT_CODEC:
+                    sample, pos = decoder.decode(frame, pos)
+                elif fmt == FIFO_FORMAT_RAW:
+                    pressure, temperature, timestamp, sequence = FIFO_RAW_SAMPLE.unpack_from(frame, pos)
+                    sample = (timestamp, sequence, pressure, temperature)
+                    pos += FIFO_RAW_SAMPLE.size
+                else:
+                    sample = RAW_SAMPLE.unpack_from(frame, pos)
+                    pos += RAW_SAMPLE.size
+                printer.sample(*sample)
+        except (Truncated, struct.error, TypeError):
+            printer.note("frame truncated")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("transport", choices=("usb", "hid", "uart", "sd", "fifo"))
+    parser.add_argument("input", help="Capture file, raw serial device or '-' for stdin")
+    parser.add_argument("--crc", action="store_true",
+                        help="Frames carry a CRC (BOARD_CRC_FRAMING_ENABLE)")
+    parser.add_argument("--command", nargs=2, type=lambda text: int(text, 0),
+                        metavar=("OPCODE", "ARG"), help="uart: send this command first")
+    args = parser.parse_args()
+
+    printer = Printer(sys.stdout)
+    if args.transport == "uart":
+        if args.input == "-":
+            decode_uart(sys.stdin.buffer, printer, True)
+            return
+        with open(args.input, "r+b" if args.command else "rb", buffering=0) as stream:
+            if args.command:
+                stream.write(b"\x00" + encode_command(*args.command))
+            decode_uart(stream, printer, True)
+    elif args.transport == "hid":
+        with open(args.input, "rb", buffering=0) if args.input != "-" else sys.stdin.buffer as stream:
+            decode_hid(stream, printer)
+    elif args.transport == "fifo":
+        source = sys.stdin if args.input == "-" else open(args.input)
+        decode_fifo(source, printer, args.crc)
+    elif args.input == "-":
+        (decode_usb if args.transport == "usb" else decode_sd)(sys.stdin.buffer, printer, args.crc)
+    else:
+        with open(args.input, "rb", buffering=0) as stream:
+            (decode_usb if args.transport == "usb" else decode_sd)(stream, printer, args.crc)
+
+
+if __name__ == "__main__":
+    try:
+        main()
+    except KeyboardInterrupt:
+        pass
@@ -0,0 +1,280 @@
+#!/usr/bin/env python3
+"""
+Static stack and RAM budget report (make stack).
+
+Reads the GCC call graphs (-fcallgraph-info=su, one .ci per object) and the
+linker map of a non-LTO build, then prints:
+  - worst-case stack depth of main and of every interrupt handler, from the
+    per-function frames along the deepest call chain
+  - worst case with every priority level nested on top of main (one handler
+    per level, plus the 32-byte exception frame the M0+ pushes for each)
+  - RAM per output section and per module, and what is left for the stack
+
+Interrupt levels come from BOARD_IRQ_PRIO_* in board/board_config.h; the
+handler -> level table below mirrors the HAL_NVIC_SetPriority() calls in
+hal/hal_config.c. Calls through function pointers are not followed: chains
+containing one are marked '+indirect' and are lower bounds.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+# Handler -> BOARD_IRQ_PRIO_<name> (hal/hal_config.c)
+HANDLER_LEVELS = {
+    "ADC1_COMP_IRQHandler": "COMP",
+    "I2C1_IRQHandler": "I2C1",
+    "DMA1_Channel2_3_IRQHandler": "I2C1",
+    "TIM2_IRQHandler": "TIMEBASE",
+    "LPTIM1_IRQHandler": "TIMEBASE",
+    "RTC_IRQHandler": "TIMEBASE",
+    "I2C2_IRQHandler": "I2C2",
+    "DMA1_Channel4_5_6_7_IRQHandler": "DAC_DMA",
+    "PendSV_Handler": "BOTTOM",
+    "DMA1_Channel1_IRQHandler": "BOTTOM",
+    "SysTick_Handler": "BOTTOM",
+}
+
+EXCEPTION_FRAME = 32  # r0-r3, r12, lr, pc, xPSR (no FPU on the M0+)
+RAM_SECTIONS = (".ramfunc", ".data", ".bss", "._user_heap_stack")
+
+NODE_RE = re.compile(r'node: \{ title: "([^"]+)" label: "([^"]*)"(.*)\}')
+EDGE_RE = re.compile(r'edge: \{ sourcename: "([^"]+)" targetname: "([^"]+)"')
+STACK_RE = re.compile(r'\\n(\d+) bytes \(([\w,]+)\)')
+
+
+def read_levels(config_path):
+    """BOARD_IRQ_PRIO_* values, following macros defined as other macros"""
+    raw = {}
+    with open(config_path) as f:
+        for line in f:
+            m = re.match(r'#define\s+BOARD_IRQ_PRIO_(\w+)\s+(\w+)', line)
+            if m:
+                raw[m.group(1)] = m.group(2)
+
+    def value(name, depth=0):
+        v = raw[name]
+        if v.startswith("BOARD_IRQ_PRIO_") and depth < 8:
+            return value(v[len("BOARD_IRQ_PRIO_"):], depth + 1)
+        return int(v.rstrip("uUlL"), 0)
+
+    return {name: value(name) for name in raw}
+
+
+def read_call_graph(build_dir):
+    """Frames {name: [(bytes, qualifier, file)]}, edges {name: set(callees)}"""
+    frames = {}
+    edges = {}
+    for root, _, files in os.walk(build_dir):
+        for name in files:
+            if not name.endswith(".ci"):
+                continue
+            with open(os.path.join(root, name)) as f:
+                for line in f:
+                    m = NODE_RE.match(line)
+                    if m:
+                        s = STACK_RE.search(m.group(2))
+                        if s:
+                            frames.setdefault(m.group(1), []).append(
+                                (int(s.group(1)), s.group(2), name))
+                        continue
+                    m = EDGE_RE.match(line)
+                    if m:
+                        edges.setdefault(m.group(1), set()).add(m.group(2))
+    return frames, edges
+
+
+class Analyzer:
+    def __init__(self, frames, edges):
+        self.frames = frames
+        self.edges = edges
+        self.memo = {}
+        self.unknown = set()
+
+    def frame(self, name):
+        """Own frame; a name defined in several files (weak HAL callbacks,
+        statics) takes the largest"""
+        if name not in self.frames:
+            return 0, True
+        entries = self.frames[name]
+        size = max(e[0] for e in entries)
+        bounded = all(e[1] != "dynamic" for e in entries)  # "dynamic,bounded" is fine
+        return size, bounded
+
+    def depth(self, name, stack=()):
+        """(bytes, chain, flags) of the deepest chain from name"""
+        if name in self.memo:
+            return self.memo[name]
+        if name in stack:
+            return 0, [name + " (recursion)"], {"recursion"}
+        if name == "__indirect_call":
+            return 0, [], {"indirect"}
+
+        own, bounded = self.frame(name)
+        flags = set()
+        if name not in self.frames:
+            self.unknown.add(name)
+            flags.add("unknown")
+        elif not bounded:
+            flags.add("dynamic")
+
+        best, best_chain = 0, []
+        for callee in sorted(self.edges.get(name, ())):
+            d, chain, f = self.depth(callee, stack + (name,))
+            flags |= f
+            if d > best:
+                best, best_chain = d, chain
+        result = (own + best, [name] + best_chain, flags)
+        self.memo[name] = result
+        return result
+
+
+def fmt_flags(flags):
+    shown = [f for f in ("indirect", "dynamic", "recursion") if f in flags]
+    return " +" + " +".join(shown) if shown else ""
+
+
+def report_stack(analyzer, levels):
+    print("Stack, worst-case chain per entry point (bytes)")
+    main_bytes, chain, flags = analyzer.depth("main")
+    print("  %-32s %6d%s" % ("main (thread)", main_bytes, fmt_flags(flags)))
+    print("      " + " -> ".join(chain))
+
+    per_level = {}
+    for handler, level_name in sorted(HANDLER_LEVELS.items()):
+        if handler not in analyzer.frames:
+            continue
+        level = levels.get(level_name)
+        d, chain, flags = analyzer.depth(handler)
+        print("  %-32s %6d%s  (level %s %s)" % (handler, d, fmt_flags(flags), level, level_name))
+        print("      " + " -> ".join(chain))
+        if level is not None and d > per_level.get(level, (0, ""))[0]:
+            per_level[level] = (d, handler)
+
+    total = main_bytes
+    print("\nNested worst case (main + deepest handler per level + exception frames)")
+    print("  %-32s %6d" % ("main", main_bytes))
+    for level in sorted(per_level, reverse=True):
+        d, handler = per_level[level]
+        total += d + EXCEPTION_FRAME
+        print("  %-32s %6d  (+%d frame)" % ("level %d: %s" % (level, handler), d, EXCEPTION_FRAME))
+    print("  %-32s %6d" % ("total", total))
+    return total
+
+
+def read_map(map_path):
+    """RAM origin/length, stack/heap reserves, per-section and per-module use"""
+    ram = None
+    symbols = {}
+    sections = {}
+    modules = {}
+    current = None
+    pending = None
+
+    with open(map_path) as f:
+        lines = f.read().splitlines()
+
+    for line in lines:
+        m = re.match(r'^RAM\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)', line)
+        if m and ram is None:
+            ram = (int(m.group(1), 16), int(m.group(2), 16))
+            continue
+        m = re.search(r'0x([0-9a-fA-F]+)\s+(_Min_Stack_Size|_Min_Heap_Size|_end|_estack)\s*=', line)
+        if m:
+            symbols[m.group(2)] = int(m.group(1), 16)
+        m = re.match(r'^(\.\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)', line)
+        if m:
+            current = m.group(1) if m.group(1) in RAM_SECTIONS else None
+            if current:
+                sections[current] = int(m.group(3), 16)
+            pending = None
+            continue
+        if re.match(r'^\S', line):
+            current = None
+            continue
+        if current is None:
+            continue
+
+        # Input sections: " .bss.name  0xaddr  0xsize  object" (long names
+        # put the address on the next line)
+        m = re.match(r'^ (\S+)\s+0x[0-9a-fA-F]+\s+0x([0-9a-fA-F]+)\s+(\S+)$', line)
+        if m is None and pending is not None:
+            m2 = re.match(r'^\s+0x[0-9a-fA-F]+\s+0x([0-9a-fA-F]+)\s+(\S+)$', line)
+            if m2:
+                size, obj = int(m2.group(1), 16), m2.group(2)
+                modules.setdefault(obj, {}).setdefault(current, 0)
+                modules[obj][current] += size
+            pending = None
+            continue
+        if m:
+            if m.group(1) != "*fill*":
+                size, obj = int(m.group(2), 16), m.group(3)
+                modules.setdefault(obj, {}).setdefault(current, 0)
+                modules[obj][current] += size
+            pending = None
+            continue
+        m = re.match(r'^ (\.\S+|COMMON)$', line)
+        pending = m.group(1) if m else None
+
+    return ram, symbols, sections, modules
+
+
+def report_ram(map_path, stack_needed):
+    ram, symbols, sections, modules = read_map(map_path)
+    if ram is None:
+        print("\nRAM region not found in %s" % map_path)
+        return
+
+    print("\nRAM per section (bytes)")
+    for name in RAM_SECTIONS:
+        if name in sections:
+            print("  %-32s %6d" % (name, sections[name]))
+
+    print("\nRAM per module (bytes, .ramfunc + .data + .bss)")
+    rows = sorted(((sum(v.values()), obj) for obj, v in modules.items()
+                   if "._user_heap_stack" not in v), reverse=True)
+    for total, obj in rows:
+        if total:
+            print("  %-48s %6d" % (os.path.relpath(obj) if os.path.exists(obj) else obj, total))
+
+    origin, length = ram
+    used = sum(sections.get(s, 0) for s in (".ramfunc", ".data", ".bss"))
+    heap = symbols.get("_Min_Heap_Size", 0)
+    reserve = symbols.get("_Min_Stack_Size", 0)
+    left = length - used - heap
+    print("\nRAM summary (bytes)")
+    print("  %-32s %6d" % ("RAM", length))
+    print("  %-32s %6d" % ("static data (.ramfunc .data .bss)", used))
+    print("  %-32s %6d" % ("heap reserve (_Min_Heap_Size)", heap))
+    print("  %-32s %6d" % ("left for the stack", left))
+    print("  %-32s %6d" % ("stack reserve (_Min_Stack_Size)", reserve))
+    print("  %-32s %6d" % ("worst-case stack (above)", stack_needed))
+    if stack_needed > reserve:
+        print("  WARNING: worst case exceeds _Min_Stack_Size")
+    print("  %-32s %6d" % ("free after the worst case", left - stack_needed))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("build_dir", help="Build directory with the .ci files")
+    parser.add_argument("--map", help="Linker map of the same build")
+    parser.add_argument("--config", default="board/board_config.h",
+                        help="Board config with BOARD_IRQ_PRIO_*")
+    args = parser.parse_args()
+
+    frames, edges = read_call_graph(args.build_dir)
+    if not frames:
+        sys.exit("No .ci files under %s (build with -fcallgraph-info=su)" % args.build_dir)
+
+    analyzer = Analyzer(frames, edges)
+    total = report_stack(analyzer, read_levels(args.config))
+    if analyzer.unknown:
+        print("\nNo frame information (assembly, libgcc; counted as 0):")
+        print("  " + " ".join(sorted(analyzer.unknown)))
+    if args.map:
+        report_ram(args.map, total)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+"""
+Binary trace decoder (drivers/trace/trace.h, BOARD_TRACE_ENABLE builds).
+
+Reads the LPUART1 trace stream from a capture file, a serial device set to
+raw mode at BOARD_TRACE_BAUD (stty -F /dev/ttyUSB0 1000000 raw) or stdin
+('-'), and prints one line per record:
+  <time us> <seq> <text>
+The text is the format string of the record's ID, taken from the trace_id_t
+comments of trace.h, with the two arguments filled in (%d/%i signed,
+%u/%x unsigned). Sequence gaps (records dropped on a full ring) and bytes
+skipped to find the next record are reported inline.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+RECORD = struct.Struct("<BBHIII")
+ENTRY_RE = re.compile(r"^\s*(TRACE_\w+)\s*(?:=\s*(\d+))?\s*,\s*/\*\s*\"(.*)\"\s*\*/")
+SYNC_RE = re.compile(r"#define\s+TRACE_SYNC\s+0x([0-9a-fA-F]+)")
+CONVERSION_RE = re.compile(r"%[-+ 0#]*\d*([diuxX])")
+
+
+def read_formats(header):
+    """(sync byte, {id: format}) from trace.h."""
+    sync = None
+    formats = {}
+    next_id = 0
+    with open(header) as source:
+        for line in source:
+            match = SYNC_RE.search(line)
+            if match:
+                sync = int(match.group(1), 16)
+                continue
+            match = ENTRY_RE.match(line)
+            if match:
+                name, value, fmt = match.groups()
+                if value is not None:
+                    next_id = int(value)
+                formats[next_id] = fmt
+                next_id += 1
+    if sync is None or not formats:
+        sys.exit("No TRACE_SYNC or trace_id_t formats in %s" % header)
+    return sync, formats
+
+
+def render(fmt, a, b):
+    """The format with a and b in place of its first two conversions."""
+    args = iter((a, b))
+
+    def convert(match):
+        value = next(args, 0)
+        conversion = match.group(0)
+        if match.group(1) in "di":
+            if value >= 0x80000000:
+                value -= 0x100000000
+            conversion = conversion[:-1] + "d"
+        return conversion % value
+
+    return CONVERSION_RE.sub(convert, fmt)
+
+
+def decode(stream, sync, formats, out):
+    buffer = b""
+    last_seq = None
+    while True:
+        chunk = stream.read(RECORD.size)
+        if not chunk:
+            break
+        buffer += chunk
+        while len(buffer) >= RECORD.size:
+            # A record starts with the sync byte and carries a known ID
+            if buffer[0] != sync or buffer[1] not in formats:
+                skip = buffer.find(bytes([sync]), 1)
+                skip = len(buffer) if skip < 0 else skip
+                out.write("-- skipped %d bytes\n" % skip)
+                buffer = buffer[skip:]
+                continue
+            _, ident, seq, time_us, a, b = RECORD.unpack_from(buffer)
+            buffer = buffer[RECORD.size:]
+            if last_seq is not None and seq != (last_seq + 1) & 0xFFFF:
+                out.write("-- %d records dropped\n" % ((seq - last_seq - 1) & 0xFFFF))
+            last_seq = seq
+            out.write("%10d %5d %s\n" % (time_us, seq, render(formats[ident], a, b)))
+        out.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("input", help="Capture file or raw serial device, '-' for stdin")
+    parser.add_argument("--header", default="drivers/trace/trace.h",
+                        help="trace.h of the firmware that produced the stream")
+    args = parser.parse_args()
+
+    sync, formats = read_formats(args.header)
+    if args.input == "-":
+        decode(sys.stdin.buffer, sync, formats, sys.stdout)
+    else:
+        with open(args.input, "rb", buffering=0) as stream:
+            decode(stream, sync, formats, sys.stdout)
+
+
+if __name__ == "__main__":
+    try:
+        main()
+    except KeyboardInterrupt:
+        pass